@@ -40,6 +40,9 @@ set(VKB_SYMLINKS OFF CACHE BOOL "Enable create symlink folders for every applica
 set(VKB_VALIDATION_LAYERS OFF CACHE BOOL "Enable validation layers for every application.")
 set(VKB_BUILD_SAMPLES ON CACHE BOOL "Enable generation and building of Vulkan best practice samples.")
 set(VKB_BUILD_TESTS OFF CACHE BOOL "Enable generation and building of Vulkan best practice tests.")
+set(VKB_PRECOMPILE_SHADERS OFF CACHE BOOL "Enable the target precompiling the shaders to SPIR-V.")
+set(VKB_HASH_BENCHMARK OFF CACHE BOOL "Enable the microbenchmark of the resource cache key hashing.")
+set(VKB_FRAMEWORK_BENCHMARK OFF CACHE BOOL "Enable the microbenchmarks of the framework hot paths.")
 
 set(CMAKE_RUNTIME_OUTPUT_DIRECTORY "bin/${CMAKE_BUILD_TYPE}/${TARGET_ARCH}")
 set(CMAKE_LIBRARY_OUTPUT_DIRECTORY "lib/${CMAKE_BUILD_TYPE}/${TARGET_ARCH}")
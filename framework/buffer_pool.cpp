@@ -20,6 +20,7 @@
 
 #include "buffer_pool.h"
 
+#include <algorithm>
 #include <cstddef>
 
 #include "common/error.h"
@@ -29,7 +30,7 @@
 namespace vkb
 {
 BufferBlock::BufferBlock(Device &device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage) :
-    buffer{device, size, usage, memory_usage}
+    buffer{device, size, usage, memory_usage, VMA_ALLOCATION_CREATE_MAPPED_BIT}
 {
 	if (usage == VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
 	{
@@ -39,6 +40,11 @@ BufferBlock::BufferBlock(Device &device, VkDeviceSize size, VkBufferUsageFlags u
 	{
 		alignment = device.get_properties().limits.minStorageBufferOffsetAlignment;
 	}
+	else if (usage == (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT))
+	{
+		// Readback buffers are written by shaders or by copies, which may need the alignment of the largest texels
+		alignment = std::max<VkDeviceSize>(device.get_properties().limits.minStorageBufferOffsetAlignment, 16);
+	}
 	else if (usage == VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT)
 	{
 		alignment = device.get_properties().limits.minTexelBufferOffsetAlignment;
@@ -52,8 +58,6 @@ BufferBlock::BufferBlock(Device &device, VkDeviceSize size, VkBufferUsageFlags u
 	{
 		throw std::runtime_error("Usage not recognised");
 	}
-
-	buffer.map();
 }
 
 BufferAllocation BufferBlock::allocate(const uint32_t allocate_size)
@@ -78,9 +82,30 @@ VkDeviceSize BufferBlock::get_size() const
 	return buffer.get_size();
 }
 
+VkDeviceSize BufferBlock::get_used_size() const
+{
+	return offset;
+}
+
+void BufferBlock::flush()
+{
+	if (offset > flushed_offset)
+	{
+		buffer.flush(flushed_offset, offset - flushed_offset);
+	}
+
+	flushed_offset = offset;
+}
+
+void BufferBlock::invalidate()
+{
+	buffer.invalidate();
+}
+
 void BufferBlock::reset()
 {
-	offset = 0;
+	offset         = 0;
+	flushed_offset = 0;
 }
 
 BufferPool::BufferPool(Device &device, VkDeviceSize block_size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage) :
@@ -115,6 +140,23 @@ BufferBlock &BufferPool::request_buffer_block(const VkDeviceSize minimum_size)
 	return *block.get();
 }
 
+void BufferPool::flush()
+{
+	// Inactive blocks have nothing left to flush
+	for (auto &buffer_block : buffer_blocks)
+	{
+		buffer_block->flush();
+	}
+}
+
+void BufferPool::invalidate()
+{
+	for (auto &buffer_block : buffer_blocks)
+	{
+		buffer_block->invalidate();
+	}
+}
+
 void BufferPool::reset()
 {
 	for (auto &buffer_block : buffer_blocks)
@@ -125,6 +167,80 @@ void BufferPool::reset()
 	active_buffer_block_count = 0;
 }
 
+size_t BufferPool::get_block_count() const
+{
+	return buffer_blocks.size();
+}
+
+void BufferPool::set_adaptive_block_size(bool enabled)
+{
+	adaptive_block_size = enabled;
+	window_reset_count  = 0;
+	high_water_mark     = 0;
+}
+
+bool BufferPool::adapt_block_size()
+{
+	if (!adaptive_block_size)
+	{
+		return false;
+	}
+
+	VkDeviceSize used_size = 0;
+
+	for (uint32_t i = 0; i < active_buffer_block_count; i++)
+	{
+		used_size += buffer_blocks[i]->get_used_size();
+	}
+
+	high_water_mark = std::max(high_water_mark, used_size);
+
+	if (++window_reset_count < ADAPTIVE_WINDOW)
+	{
+		return false;
+	}
+
+	// A quarter of headroom absorbs the frames slightly heavier than the window
+	VkDeviceSize target_size = high_water_mark + high_water_mark / 4;
+	target_size              = std::max(ADAPTIVE_BLOCK_GRANULARITY, (target_size + ADAPTIVE_BLOCK_GRANULARITY - 1) / ADAPTIVE_BLOCK_GRANULARITY * ADAPTIVE_BLOCK_GRANULARITY);
+
+	window_reset_count = 0;
+	high_water_mark    = 0;
+
+	bool coalesce = buffer_blocks.size() > 1;
+	bool shrink   = target_size < block_size / 2;
+
+	if (!coalesce && !shrink)
+	{
+		return false;
+	}
+
+	LOGD("Resizing buffer pool blocks ({}) from {} to {} bytes, {} blocks released", usage, block_size, target_size, buffer_blocks.size());
+
+	block_size = target_size;
+
+	if (buffer_blocks.empty())
+	{
+		return false;
+	}
+
+	// The next frame creates a single block of the new size
+	buffer_blocks.clear();
+	active_buffer_block_count = 0;
+
+	return true;
+}
+
+VkDeviceSize BufferPool::get_block_size() const
+{
+	return block_size;
+}
+
+VkDeviceSize BufferPool::get_high_water_mark() const
+{
+	return high_water_mark;
+}
+
 BufferAllocation::BufferAllocation(core::Buffer &buffer, VkDeviceSize size, VkDeviceSize offset) :
     buffer{&buffer},
     size{size},
@@ -133,12 +249,27 @@ BufferAllocation::BufferAllocation(core::Buffer &buffer, VkDeviceSize size, VkDe
 }
 
 void BufferAllocation::update(const std::vector<uint8_t> &data, uint32_t offset)
+{
+	update(data.data(), data.size(), offset);
+}
+
+void BufferAllocation::update(const uint8_t *data, size_t data_size, uint32_t offset)
 {
 	assert(buffer && "Invalid buffer pointer");
 
-	if (offset + data.size() <= size)
+	if (offset + data_size <= size)
 	{
-		buffer->update(data, static_cast<size_t>(base_offset) + offset);
+		if (buffer->get_data())
+		{
+			// Flushed along with the rest of the block
+			std::copy(data, data + data_size, map_data(offset));
+
+			buffer->get_device().add_uploaded_bytes(data_size);
+		}
+		else
+		{
+			buffer->update(data, data_size, static_cast<size_t>(base_offset) + offset);
+		}
 	}
 	else
 	{
@@ -146,6 +277,21 @@ void BufferAllocation::update(const std::vector<uint8_t> &data, uint32_t offset)
 	}
 }
 
+uint8_t *BufferAllocation::map_data(uint32_t offset)
+{
+	assert(buffer && "Invalid buffer pointer");
+	assert(buffer->get_data() && "Buffer must be persistently mapped");
+
+	return buffer->map() + base_offset + offset;
+}
+
+void BufferAllocation::flush()
+{
+	assert(buffer && "Invalid buffer pointer");
+
+	buffer->flush(base_offset, size);
+}
+
 bool BufferAllocation::empty() const
 {
 	return size == 0 || buffer == nullptr;
@@ -48,14 +48,43 @@ class BufferAllocation
 
 	void update(const std::vector<uint8_t> &data, uint32_t offset = 0);
 
+	/**
+	 * @brief Copies data to the allocation without any intermediate copy
+	 *        If the buffer is persistently mapped, like the blocks of a BufferPool, the data is not flushed
+	 * @param data Pointer to the data to copy
+	 * @param size Size in bytes of the data
+	 * @param offset Offset in bytes from the start of the allocation
+	 */
+	void update(const uint8_t *data, size_t size, uint32_t offset = 0);
+
 	template <class T>
 	void update(const T &value, uint32_t offset = 0)
 	{
-		update(std::vector<uint8_t>{reinterpret_cast<const uint8_t *>(&value),
-		                            reinterpret_cast<const uint8_t *>(&value) + sizeof(T)},
-		       offset);
+		update(reinterpret_cast<const uint8_t *>(&value), sizeof(T), offset);
 	}
 
+	/**
+	 * @brief Gives direct access to the memory of the allocation, to write data in place
+	 *        The underlying buffer must be persistently mapped, like the blocks of a BufferPool
+	 * @param count Number of elements of type T to access
+	 * @param offset Offset in bytes from the start of the allocation
+	 * @return Pointer to the first element
+	 */
+	template <class T>
+	T *map(size_t count = 1, uint32_t offset = 0)
+	{
+		assert(offset + count * sizeof(T) <= size && "Mapped range is out of the allocation");
+
+		return reinterpret_cast<T *>(map_data(offset));
+	}
+
+	/**
+	 * @brief Flushes the memory of the allocation after writing it
+	 *        The blocks of a BufferPool are flushed at once before the frame is submitted, so this is only
+	 *        needed when writing an allocation from a block flushed already, such as one kept across frames
+	 */
+	void flush();
+
 	bool empty() const;
 
 	VkDeviceSize get_size() const;
@@ -65,6 +94,8 @@ class BufferAllocation
 	core::Buffer &get_buffer();
 
   private:
+	uint8_t *map_data(uint32_t offset);
+
 	core::Buffer *buffer{nullptr};
 
 	VkDeviceSize base_offset{0};
@@ -74,6 +105,8 @@ class BufferAllocation
 
 /**
  * @brief Helper class which handles multiple allocation from the same underlying Vulkan buffer.
+ *        The buffer is mapped for the lifetime of the block, and the range allocated since the
+ *        last flush is flushed at once, instead of once per allocation.
  */
 class BufferBlock
 {
@@ -87,6 +120,21 @@ class BufferBlock
 
 	VkDeviceSize get_size() const;
 
+	/**
+	 * @return Size in bytes allocated from the block since its last reset, alignment padding included
+	 */
+	VkDeviceSize get_used_size() const;
+
+	/**
+	 * @brief Flushes the range allocated since the last flush, if the memory is not HOST_COHERENT
+	 */
+	void flush();
+
+	/**
+	 * @brief Invalidates the memory of the block, if it is not HOST_COHERENT, before reading what the device wrote
+	 */
+	void invalidate();
+
 	void reset();
 
   private:
@@ -97,6 +145,9 @@ class BufferBlock
 
 	// Current offset, it increases on every allocation
 	VkDeviceSize offset{0};
+
+	// End of the range flushed already
+	VkDeviceSize flushed_offset{0};
 };
 
 /**
@@ -105,8 +156,8 @@ class BufferBlock
  *
  * BufferPool is a linear allocator for buffer chunks, it gives you a view of the size you want.
  * A BufferBlock is the corresponding VkBuffer and you can get smaller offsets inside it.
- * Since a shader cannot specify dynamic UBOs, it has to be done from the code
- * (set_resource_dynamic).
+ * Since a shader cannot specify dynamic UBOs, it has to be done from the code: uniform buffers
+ * are made dynamic by the DescriptorSetLayout, storage buffers with set_resource_dynamic.
  *
  * When a new frame starts, buffer blocks are returned: the offset is reset and contents are
  * overwritten. The minimum allocation size is 256 kb, if you ask for more you get a dedicated
@@ -114,16 +165,62 @@ class BufferBlock
  *
  * We re-use descriptor sets: we only need one for the corresponding buffer infos (and we only
  * have one VkBuffer per BufferBlock), then it is bound and we use dynamic offsets.
+ *
+ * With an adaptive block size, the pool records the high-water mark of the bytes allocated between
+ * two resets. At the end of each window of ADAPTIVE_WINDOW resets, a pool which overflowed into
+ * several blocks, or which used less than half of its block, replaces its blocks by a single one
+ * sized from the high-water mark, so that each frame allocates from one buffer.
  */
 class BufferPool
 {
   public:
+	/// Resets of an adaptive pool over which the high-water mark is measured before resizing its blocks
+	static constexpr uint32_t ADAPTIVE_WINDOW{120};
+
+	/// Smallest block size of an adaptive pool, the block sizes are multiples of it
+	static constexpr VkDeviceSize ADAPTIVE_BLOCK_GRANULARITY{64 * 1024};
+
 	BufferPool(Device &device, VkDeviceSize block_size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage = VMA_MEMORY_USAGE_CPU_TO_GPU);
 
 	BufferBlock &request_buffer_block(VkDeviceSize minimum_size);
 
+	/**
+	 * @brief Flushes the ranges allocated from the blocks since the last flush
+	 */
+	void flush();
+
+	/**
+	 * @brief Invalidates the memory of the blocks, before reading what the device wrote
+	 */
+	void invalidate();
+
 	void reset();
 
+	/**
+	 * @return Number of blocks the pool created, active or not
+	 */
+	size_t get_block_count() const;
+
+	/**
+	 * @brief Enables resizing the blocks from the high-water mark of the allocations, see adapt_block_size()
+	 */
+	void set_adaptive_block_size(bool enabled);
+
+	/**
+	 * @brief Records the bytes allocated since the last reset, and at the end of a window resizes the blocks if needed
+	 *        It must be called before reset(), once the device no longer uses the blocks, and does nothing
+	 *        if the block size is not adaptive.
+	 * @return True if the blocks were destroyed, the descriptor sets referencing them must not be used anymore
+	 */
+	bool adapt_block_size();
+
+	VkDeviceSize get_block_size() const;
+
+	/**
+	 * @return Largest number of bytes allocated between two resets in the current window
+	 */
+	VkDeviceSize get_high_water_mark() const;
+
   private:
 	Device &device;
 
@@ -139,5 +236,12 @@ class BufferPool
 
 	/// Numbers of active blocks from the start of buffer_blocks
 	uint32_t active_buffer_block_count{0};
+
+	bool adaptive_block_size{false};
+
+	/// Resets recorded in the current window
+	uint32_t window_reset_count{0};
+
+	VkDeviceSize high_water_mark{0};
 };
 }        // namespace vkb
@@ -0,0 +1,246 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "bounds_kernels.h"
+
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	include <emmintrin.h>
+#	define VKB_BOUNDS_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#	include <arm_neon.h>
+#	define VKB_BOUNDS_NEON
+#endif
+
+namespace vkb
+{
+namespace
+{
+#if defined(VKB_BOUNDS_SSE)
+using Vector4 = __m128;
+
+inline Vector4 load_vector(const float *value)
+{
+	return _mm_loadu_ps(value);
+}
+
+inline Vector4 splat(float value)
+{
+	return _mm_set1_ps(value);
+}
+
+inline Vector4 multiply_add(Vector4 a, Vector4 b, Vector4 c)
+{
+	return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+
+inline Vector4 absolute(Vector4 value)
+{
+	return _mm_andnot_ps(_mm_set1_ps(-0.0f), value);
+}
+
+inline Vector4 add(Vector4 a, Vector4 b)
+{
+	return _mm_add_ps(a, b);
+}
+
+inline Vector4 subtract(Vector4 a, Vector4 b)
+{
+	return _mm_sub_ps(a, b);
+}
+
+inline Vector4 minimum(Vector4 a, Vector4 b)
+{
+	return _mm_min_ps(a, b);
+}
+
+inline Vector4 maximum(Vector4 a, Vector4 b)
+{
+	return _mm_max_ps(a, b);
+}
+
+inline glm::vec3 store_vec3(Vector4 value)
+{
+	alignas(16) float lanes[4];
+	_mm_store_ps(lanes, value);
+	return glm::vec3{lanes[0], lanes[1], lanes[2]};
+}
+#elif defined(VKB_BOUNDS_NEON)
+using Vector4 = float32x4_t;
+
+inline Vector4 load_vector(const float *value)
+{
+	return vld1q_f32(value);
+}
+
+inline Vector4 splat(float value)
+{
+	return vdupq_n_f32(value);
+}
+
+inline Vector4 multiply_add(Vector4 a, Vector4 b, Vector4 c)
+{
+	return vmlaq_f32(c, a, b);
+}
+
+inline Vector4 absolute(Vector4 value)
+{
+	return vabsq_f32(value);
+}
+
+inline Vector4 add(Vector4 a, Vector4 b)
+{
+	return vaddq_f32(a, b);
+}
+
+inline Vector4 subtract(Vector4 a, Vector4 b)
+{
+	return vsubq_f32(a, b);
+}
+
+inline Vector4 minimum(Vector4 a, Vector4 b)
+{
+	return vminq_f32(a, b);
+}
+
+inline Vector4 maximum(Vector4 a, Vector4 b)
+{
+	return vmaxq_f32(a, b);
+}
+
+inline glm::vec3 store_vec3(Vector4 value)
+{
+	float lanes[4];
+	vst1q_f32(lanes, value);
+	return glm::vec3{lanes[0], lanes[1], lanes[2]};
+}
+#endif
+
+inline glm::vec3 load_position(const uint8_t *position_data, uint32_t stride, uint32_t index)
+{
+	glm::vec3 position;
+	std::memcpy(&position, position_data + static_cast<size_t>(index) * stride, sizeof(glm::vec3));
+	return position;
+}
+
+inline uint32_t read_index(const uint8_t *index_data, VkIndexType index_type, uint32_t index)
+{
+	return index_type == VK_INDEX_TYPE_UINT32 ?
+	           reinterpret_cast<const uint32_t *>(index_data)[index] :
+	           reinterpret_cast<const uint16_t *>(index_data)[index];
+}
+}        // namespace
+
+void transform_bounds(const glm::vec3 &min, const glm::vec3 &max, const glm::mat4 *transforms, size_t count, glm::vec3 *out_min, glm::vec3 *out_max)
+{
+	const glm::vec3 center = (min + max) * 0.5f;
+	const glm::vec3 extent = (max - min) * 0.5f;
+
+#if defined(VKB_BOUNDS_SSE) || defined(VKB_BOUNDS_NEON)
+	const Vector4 center_x = splat(center.x);
+	const Vector4 center_y = splat(center.y);
+	const Vector4 center_z = splat(center.z);
+	const Vector4 extent_x = splat(extent.x);
+	const Vector4 extent_y = splat(extent.y);
+	const Vector4 extent_z = splat(extent.z);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		// The columns of a glm matrix are contiguous
+		const float *matrix = &transforms[i][0][0];
+
+		Vector4 column_0 = load_vector(matrix);
+		Vector4 column_1 = load_vector(matrix + 4);
+		Vector4 column_2 = load_vector(matrix + 8);
+		Vector4 column_3 = load_vector(matrix + 12);
+
+		Vector4 world_center = multiply_add(column_0, center_x, multiply_add(column_1, center_y, multiply_add(column_2, center_z, column_3)));
+		Vector4 world_extent = multiply_add(absolute(column_0), extent_x, multiply_add(absolute(column_1), extent_y, multiply_add(absolute(column_2), extent_z, splat(0.0f))));
+
+		out_min[i] = store_vec3(subtract(world_center, world_extent));
+		out_max[i] = store_vec3(add(world_center, world_extent));
+	}
+#else
+	for (size_t i = 0; i < count; ++i)
+	{
+		const glm::mat3 rotation{transforms[i]};
+
+		glm::vec3 world_center = glm::vec3{transforms[i] * glm::vec4{center, 1.0f}};
+		glm::vec3 world_extent = glm::abs(rotation[0]) * extent.x + glm::abs(rotation[1]) * extent.y + glm::abs(rotation[2]) * extent.z;
+
+		out_min[i] = world_center - world_extent;
+		out_max[i] = world_center + world_extent;
+	}
+#endif
+}
+
+void grow_position_bounds(const uint8_t *position_data, uint32_t stride, uint32_t vertex_count, const uint8_t *index_data, uint32_t index_count, VkIndexType index_type,
+                          glm::vec3 &min, glm::vec3 &max)
+{
+	if (stride == 0)
+	{
+		stride = sizeof(glm::vec3);
+	}
+
+	bool     indexed = index_data && index_count > 0;
+	uint32_t count   = indexed ? index_count : vertex_count;
+
+#if defined(VKB_BOUNDS_SSE) || defined(VKB_BOUNDS_NEON)
+	Vector4 batch_min = splat(std::numeric_limits<float>::max());
+	Vector4 batch_max = splat(std::numeric_limits<float>::lowest());
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		uint32_t vertex = indexed ? read_index(index_data, index_type, i) : i;
+
+		// Loading four floats reads past the position, which stays within the vertex data except for
+		// the last vertex of a tightly packed buffer
+		if (stride >= 4 * sizeof(float) || vertex + 1 < vertex_count)
+		{
+			Vector4 position = load_vector(reinterpret_cast<const float *>(position_data + static_cast<size_t>(vertex) * stride));
+
+			batch_min = minimum(batch_min, position);
+			batch_max = maximum(batch_max, position);
+		}
+		else
+		{
+			glm::vec3 position = load_position(position_data, stride, vertex);
+
+			min = glm::min(min, position);
+			max = glm::max(max, position);
+		}
+	}
+
+	// The fourth lane holds whatever follows the positions, and is dropped
+	min = glm::min(min, store_vec3(batch_min));
+	max = glm::max(max, store_vec3(batch_max));
+#else
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		glm::vec3 position = load_position(position_data, stride, indexed ? read_index(index_data, index_type, i) : i);
+
+		min = glm::min(min, position);
+		max = glm::max(max, position);
+	}
+#endif
+}
+}        // namespace vkb
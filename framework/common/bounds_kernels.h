@@ -0,0 +1,64 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "common/vk_common.h"
+
+namespace vkb
+{
+/**
+ * @brief Transforms a local bounding box by a batch of matrices, giving the world bounds of each instance
+ *
+ * Uses the method of Arvo: the center is transformed as a point, and the half extent by the absolute value
+ * of the upper 3x3 matrix, which gives the same box as transforming the 8 corners at a fraction of the cost.
+ * The matrices are processed with SSE or NEON where available.
+ * @param min Minimum position of the local bounding box
+ * @param max Maximum position of the local bounding box
+ * @param transforms Affine matrices, one per instance
+ * @param count Number of matrices
+ * @param out_min Minimum positions of the transformed boxes, one per matrix
+ * @param out_max Maximum positions of the transformed boxes, one per matrix
+ */
+void transform_bounds(const glm::vec3 &min, const glm::vec3 &max, const glm::mat4 *transforms, size_t count, glm::vec3 *out_min, glm::vec3 *out_max);
+
+/**
+ * @brief Grows a bounding box to contain vertex positions in host memory, with SSE or NEON where available
+ * @param position_data Vertex positions, stored as three floats
+ * @param stride Distance in bytes between two positions, zero if tightly packed
+ * @param vertex_count Number of vertices
+ * @param index_data Index data, or nullptr to read every vertex
+ * @param index_count Number of indices
+ * @param index_type Type of the indices
+ * @param min Minimum position of the box, updated in place
+ * @param max Maximum position of the box, updated in place
+ */
+void grow_position_bounds(const uint8_t *position_data, uint32_t stride, uint32_t vertex_count, const uint8_t *index_data, uint32_t index_count, VkIndexType index_type,
+                          glm::vec3 &min, glm::vec3 &max);
+}        // namespace vkb
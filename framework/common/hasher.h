@@ -0,0 +1,128 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace vkb
+{
+/**
+ * @brief Streaming 64-bit hasher for the resource cache keys
+ *
+ * Values are absorbed in 8 byte lanes with the round and avalanche of xxHash64, so plain structs
+ * are hashed in bulk rather than field by field. Absorbing the same values in the same calls
+ * always gives the same hash, but splitting data differently across calls doesn't.
+ */
+class Hasher
+{
+  public:
+	explicit Hasher(uint64_t seed = 0) :
+	    state{seed + PRIME_5}
+	{}
+
+	/**
+	 * @brief Absorbs raw bytes
+	 */
+	Hasher &data(const void *data, size_t size)
+	{
+		auto bytes = static_cast<const uint8_t *>(data);
+
+		length += size;
+
+		for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), bytes += sizeof(uint64_t))
+		{
+			uint64_t lane;
+			std::memcpy(&lane, bytes, sizeof(lane));
+			round(lane);
+		}
+
+		if (size > 0)
+		{
+			uint64_t lane{0};
+			std::memcpy(&lane, bytes, size);
+			round(lane);
+		}
+
+		return *this;
+	}
+
+	/**
+	 * @brief Absorbs the bytes of a value, which must not have padding as it would be hashed too
+	 */
+	template <class T>
+	Hasher &pod(const T &value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+		return data(&value, sizeof(T));
+	}
+
+	Hasher &u64(uint64_t value)
+	{
+		length += sizeof(value);
+		round(value);
+		return *this;
+	}
+
+	/**
+	 * @return The hash of the values absorbed so far
+	 */
+	uint64_t get() const
+	{
+		uint64_t hash = state ^ length;
+
+		hash ^= hash >> 33;
+		hash *= PRIME_2;
+		hash ^= hash >> 29;
+		hash *= PRIME_3;
+		hash ^= hash >> 32;
+
+		return hash;
+	}
+
+  private:
+	static constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+	static constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+	static constexpr uint64_t PRIME_3 = 0x165667B19E3779F9ULL;
+	static constexpr uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ULL;
+	static constexpr uint64_t PRIME_5 = 0x27D4EB2F165667C5ULL;
+
+	uint64_t state;
+
+	uint64_t length{0};
+
+	static uint64_t rotate_left(uint64_t value, uint32_t bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	void round(uint64_t lane)
+	{
+		lane *= PRIME_2;
+		lane = rotate_left(lane, 31);
+		lane *= PRIME_1;
+
+		state ^= lane;
+		state = rotate_left(state, 27) * PRIME_1 + PRIME_4;
+	}
+};
+}        // namespace vkb
@@ -37,6 +37,10 @@
 #include <unordered_set>
 #include <vector>
 
+#if defined(_MSC_VER)
+#	include <intrin.h>
+#endif
+
 #include "common/error.h"
 
 VKBP_DISABLE_WARNINGS()
@@ -210,4 +214,23 @@ uint32_t to_u32(T value)
 	return static_cast<uint32_t>(value);
 }
 
+/**
+ * @brief Helper function to iterate the set bits of a mask, lowest first,
+ *        clearing them with mask &= mask - 1
+ * @param mask A non-zero bit mask
+ * @return The index of the lowest set bit of the mask
+ */
+inline uint32_t lowest_bit_index(uint32_t mask)
+{
+	assert(mask != 0 && "The mask must have a bit set");
+
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<uint32_t>(index);
+#else
+	return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+}
+
 }        // namespace vkb
@@ -28,7 +28,39 @@
 
 #define __FILENAME__ (static_cast<const char *>(__FILE__) + ROOT_PATH_SIZE)
 
-#define LOGI(...) spdlog::info(__VA_ARGS__);
-#define LOGW(...) spdlog::warn(__VA_ARGS__);
+#define VKB_LOG_LEVEL_DEBUG 0
+#define VKB_LOG_LEVEL_INFO 1
+#define VKB_LOG_LEVEL_WARNING 2
+#define VKB_LOG_LEVEL_ERROR 3
+
+// Messages below VKB_LOG_LEVEL are compiled out, release builds strip the debug messages by default
+#ifndef VKB_LOG_LEVEL
+#	if !defined(NDEBUG) || defined(DEBUG) || defined(_DEBUG)
+#		define VKB_LOG_LEVEL VKB_LOG_LEVEL_DEBUG
+#	else
+#		define VKB_LOG_LEVEL VKB_LOG_LEVEL_INFO
+#	endif
+#endif
+
+// The arguments of a stripped message are not evaluated, but still count as used
+#define LOG_STRIPPED(...) static_cast<void>(sizeof(fmt::format(__VA_ARGS__)));
+
+#if VKB_LOG_LEVEL <= VKB_LOG_LEVEL_INFO
+#	define LOGI(...) spdlog::info(__VA_ARGS__);
+#else
+#	define LOGI(...) LOG_STRIPPED(__VA_ARGS__)
+#endif
+
+#if VKB_LOG_LEVEL <= VKB_LOG_LEVEL_WARNING
+#	define LOGW(...) spdlog::warn(__VA_ARGS__);
+#else
+#	define LOGW(...) LOG_STRIPPED(__VA_ARGS__)
+#endif
+
 #define LOGE(...) spdlog::error("[{}:{}] {}", __FILENAME__, __LINE__, fmt::format(__VA_ARGS__));
-#define LOGD(...) spdlog::debug(__VA_ARGS__);
+
+#if VKB_LOG_LEVEL <= VKB_LOG_LEVEL_DEBUG
+#	define LOGD(...) spdlog::debug(__VA_ARGS__);
+#else
+#	define LOGD(...) LOG_STRIPPED(__VA_ARGS__)
+#endif
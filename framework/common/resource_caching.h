@@ -25,10 +25,12 @@
 #include "core/descriptor_set_layout.h"
 #include "core/framebuffer.h"
 #include "core/pipeline.h"
+#include "core/sampler.h"
 #include "rendering/pipeline_state.h"
 #include "rendering/render_target.h"
 #include "resource_record.h"
 
+#include "common/hasher.h"
 #include "common/helpers.h"
 
 namespace std
@@ -105,7 +107,7 @@ struct hash<vkb::PipelineLayout>
 	{
 		std::size_t result = 0;
 
-		vkb::hash_combine(result, pipeline_layout.get_handle());
+		vkb::hash_combine(result, pipeline_layout.get_id());
 
 		return result;
 	}
@@ -118,7 +120,7 @@ struct hash<vkb::RenderPass>
 	{
 		std::size_t result = 0;
 
-		vkb::hash_combine(result, render_pass.get_handle());
+		vkb::hash_combine(result, render_pass.get_id());
 
 		return result;
 	}
@@ -133,6 +135,7 @@ struct hash<vkb::Attachment>
 
 		vkb::hash_combine(result, static_cast<std::underlying_type<VkFormat>::type>(attachment.format));
 		vkb::hash_combine(result, static_cast<std::underlying_type<VkSampleCountFlagBits>::type>(attachment.samples));
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkImageLayout>::type>(attachment.initial_layout));
 
 		return result;
 	}
@@ -169,6 +172,14 @@ struct hash<vkb::SubpassInfo>
 			vkb::hash_combine(result, input_attachment);
 		}
 
+		for (uint32_t resolve_attachment : subpass_info.color_resolve_attachments)
+		{
+			vkb::hash_combine(result, resolve_attachment);
+		}
+
+		vkb::hash_combine(result, subpass_info.view_mask);
+		vkb::hash_combine(result, subpass_info.rasterization_order_access);
+
 		return result;
 	}
 };
@@ -180,12 +191,12 @@ struct hash<vkb::SpecializationConstantState>
 	{
 		std::size_t result = 0;
 
-		for (auto constants : specialization_constant_state.get_specialization_constant_state())
+		for (const auto &constant : specialization_constant_state)
 		{
-			vkb::hash_combine(result, constants.first);
-			for (const auto data : constants.second)
+			vkb::hash_combine(result, constant.constant_id);
+			for (uint32_t i = 0; i < constant.size; ++i)
 			{
-				vkb::hash_combine(result, data);
+				vkb::hash_combine(result, constant.data[i]);
 			}
 		}
 
@@ -211,6 +222,7 @@ struct hash<vkb::ShaderResource>
 		vkb::hash_combine(result, shader_resource.set);
 		vkb::hash_combine(result, shader_resource.binding);
 		vkb::hash_combine(result, static_cast<std::underlying_type<vkb::ShaderResourceType>::type>(shader_resource.type));
+		vkb::hash_combine(result, shader_resource.push);
 
 		return result;
 	}
@@ -221,13 +233,9 @@ struct hash<VkDescriptorBufferInfo>
 {
 	std::size_t operator()(const VkDescriptorBufferInfo &descriptor_buffer_info) const
 	{
-		std::size_t result = 0;
+		static_assert(sizeof(VkDescriptorBufferInfo) == 3 * sizeof(uint64_t), "VkDescriptorBufferInfo must not have padding");
 
-		vkb::hash_combine(result, descriptor_buffer_info.buffer);
-		vkb::hash_combine(result, descriptor_buffer_info.range);
-		vkb::hash_combine(result, descriptor_buffer_info.offset);
-
-		return result;
+		return static_cast<std::size_t>(vkb::Hasher{}.pod(descriptor_buffer_info).get());
 	}
 };
 
@@ -236,13 +244,14 @@ struct hash<VkDescriptorImageInfo>
 {
 	std::size_t operator()(const VkDescriptorImageInfo &descriptor_image_info) const
 	{
-		std::size_t result = 0;
+		// Hashed by field, the layout is followed by padding
+		vkb::Hasher hasher;
 
-		vkb::hash_combine(result, descriptor_image_info.imageView);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkImageLayout>::type>(descriptor_image_info.imageLayout));
-		vkb::hash_combine(result, descriptor_image_info.sampler);
+		hasher.pod(descriptor_image_info.sampler);
+		hasher.pod(descriptor_image_info.imageView);
+		hasher.u64(static_cast<uint64_t>(descriptor_image_info.imageLayout));
 
-		return result;
+		return static_cast<std::size_t>(hasher.get());
 	}
 };
 
@@ -251,14 +260,9 @@ struct hash<VkVertexInputAttributeDescription>
 {
 	std::size_t operator()(const VkVertexInputAttributeDescription &vertex_attrib) const
 	{
-		std::size_t result = 0;
-
-		vkb::hash_combine(result, vertex_attrib.binding);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkFormat>::type>(vertex_attrib.format));
-		vkb::hash_combine(result, vertex_attrib.location);
-		vkb::hash_combine(result, vertex_attrib.offset);
+		static_assert(sizeof(VkVertexInputAttributeDescription) == 4 * sizeof(uint32_t), "VkVertexInputAttributeDescription must not have padding");
 
-		return result;
+		return static_cast<std::size_t>(vkb::Hasher{}.pod(vertex_attrib).get());
 	}
 };
 
@@ -267,13 +271,9 @@ struct hash<VkVertexInputBindingDescription>
 {
 	std::size_t operator()(const VkVertexInputBindingDescription &vertex_binding) const
 	{
-		std::size_t result = 0;
+		static_assert(sizeof(VkVertexInputBindingDescription) == 3 * sizeof(uint32_t), "VkVertexInputBindingDescription must not have padding");
 
-		vkb::hash_combine(result, vertex_binding.binding);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkVertexInputRate>::type>(vertex_binding.inputRate));
-		vkb::hash_combine(result, vertex_binding.stride);
-
-		return result;
+		return static_cast<std::size_t>(vkb::Hasher{}.pod(vertex_binding).get());
 	}
 };
 
@@ -282,14 +282,38 @@ struct hash<vkb::StencilOpState>
 {
 	std::size_t operator()(const vkb::StencilOpState &stencil) const
 	{
-		std::size_t result = 0;
+		static_assert(sizeof(vkb::StencilOpState) == 4 * sizeof(uint32_t), "StencilOpState must not have padding");
 
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkCompareOp>::type>(stencil.compare_op));
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkStencilOp>::type>(stencil.depth_fail_op));
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkStencilOp>::type>(stencil.fail_op));
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkStencilOp>::type>(stencil.pass_op));
+		return static_cast<std::size_t>(vkb::Hasher{}.pod(stencil).get());
+	}
+};
 
-		return result;
+template <>
+struct hash<VkSamplerCreateInfo>
+{
+	std::size_t operator()(const VkSamplerCreateInfo &sampler_info) const
+	{
+		// Hashed by field, skipping the structure type and the chain, which cached samplers do not use
+		vkb::Hasher hasher;
+
+		hasher.pod(sampler_info.flags);
+		hasher.pod(sampler_info.magFilter);
+		hasher.pod(sampler_info.minFilter);
+		hasher.pod(sampler_info.mipmapMode);
+		hasher.pod(sampler_info.addressModeU);
+		hasher.pod(sampler_info.addressModeV);
+		hasher.pod(sampler_info.addressModeW);
+		hasher.pod(sampler_info.mipLodBias);
+		hasher.pod(sampler_info.anisotropyEnable);
+		hasher.pod(sampler_info.maxAnisotropy);
+		hasher.pod(sampler_info.compareEnable);
+		hasher.pod(sampler_info.compareOp);
+		hasher.pod(sampler_info.minLod);
+		hasher.pod(sampler_info.maxLod);
+		hasher.pod(sampler_info.borderColor);
+		hasher.pod(sampler_info.unnormalizedCoordinates);
+
+		return static_cast<std::size_t>(hasher.get());
 	}
 };
 
@@ -298,12 +322,9 @@ struct hash<VkExtent2D>
 {
 	size_t operator()(const VkExtent2D &extent) const
 	{
-		size_t result = 0;
-
-		vkb::hash_combine(result, extent.width);
-		vkb::hash_combine(result, extent.height);
+		static_assert(sizeof(VkExtent2D) == 2 * sizeof(uint32_t), "VkExtent2D must not have padding");
 
-		return result;
+		return static_cast<size_t>(vkb::Hasher{}.pod(extent).get());
 	}
 };
 
@@ -312,12 +333,9 @@ struct hash<VkOffset2D>
 {
 	size_t operator()(const VkOffset2D &offset) const
 	{
-		size_t result = 0;
-
-		vkb::hash_combine(result, offset.x);
-		vkb::hash_combine(result, offset.y);
+		static_assert(sizeof(VkOffset2D) == 2 * sizeof(uint32_t), "VkOffset2D must not have padding");
 
-		return result;
+		return static_cast<size_t>(vkb::Hasher{}.pod(offset).get());
 	}
 };
 
@@ -326,12 +344,9 @@ struct hash<VkRect2D>
 {
 	size_t operator()(const VkRect2D &rect) const
 	{
-		size_t result = 0;
-
-		vkb::hash_combine(result, rect.extent);
-		vkb::hash_combine(result, rect.offset);
+		static_assert(sizeof(VkRect2D) == 4 * sizeof(uint32_t), "VkRect2D must not have padding");
 
-		return result;
+		return static_cast<size_t>(vkb::Hasher{}.pod(rect).get());
 	}
 };
 
@@ -340,16 +355,9 @@ struct hash<VkViewport>
 {
 	size_t operator()(const VkViewport &viewport) const
 	{
-		size_t result = 0;
-
-		vkb::hash_combine(result, viewport.width);
-		vkb::hash_combine(result, viewport.height);
-		vkb::hash_combine(result, viewport.maxDepth);
-		vkb::hash_combine(result, viewport.minDepth);
-		vkb::hash_combine(result, viewport.x);
-		vkb::hash_combine(result, viewport.y);
+		static_assert(sizeof(VkViewport) == 6 * sizeof(uint32_t), "VkViewport must not have padding");
 
-		return result;
+		return static_cast<size_t>(vkb::Hasher{}.pod(viewport).get());
 	}
 };
 
@@ -358,18 +366,9 @@ struct hash<vkb::ColorBlendAttachmentState>
 {
 	std::size_t operator()(const vkb::ColorBlendAttachmentState &color_blend_attachment) const
 	{
-		std::size_t result = 0;
+		static_assert(sizeof(vkb::ColorBlendAttachmentState) == 8 * sizeof(uint32_t), "ColorBlendAttachmentState must not have padding");
 
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkBlendOp>::type>(color_blend_attachment.alpha_blend_op));
-		vkb::hash_combine(result, color_blend_attachment.blend_enable);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkBlendOp>::type>(color_blend_attachment.color_blend_op));
-		vkb::hash_combine(result, color_blend_attachment.color_write_mask);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkBlendFactor>::type>(color_blend_attachment.dst_alpha_blend_factor));
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkBlendFactor>::type>(color_blend_attachment.dst_color_blend_factor));
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkBlendFactor>::type>(color_blend_attachment.src_alpha_blend_factor));
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkBlendFactor>::type>(color_blend_attachment.src_color_blend_factor));
-
-		return result;
+		return static_cast<std::size_t>(vkb::Hasher{}.pod(color_blend_attachment).get());
 	}
 };
 
@@ -382,7 +381,7 @@ struct hash<vkb::RenderTarget>
 
 		for (auto &view : render_target.get_views())
 		{
-			vkb::hash_combine(result, view.get_handle());
+			vkb::hash_combine(result, view.get_id());
 		}
 
 		return result;
@@ -390,83 +389,99 @@ struct hash<vkb::RenderTarget>
 };
 
 template <>
-struct hash<vkb::PipelineState>
+struct hash<vkb::VertexInputState>
 {
-	std::size_t operator()(const vkb::PipelineState &pipeline_state) const
+	std::size_t operator()(const vkb::VertexInputState &vertex_input_state) const
 	{
-		std::size_t result = 0;
+		vkb::Hasher hasher;
 
-		vkb::hash_combine(result, pipeline_state.get_pipeline_layout().get_handle());
+		hasher.u64(vertex_input_state.attributes.size());
+		hasher.data(vertex_input_state.attributes.data(), vertex_input_state.attributes.size() * sizeof(VkVertexInputAttributeDescription));
 
-		// For graphics only
-		if (auto render_pass = pipeline_state.get_render_pass())
-		{
-			vkb::hash_combine(result, render_pass->get_handle());
-		}
+		hasher.u64(vertex_input_state.bindings.size());
+		hasher.data(vertex_input_state.bindings.data(), vertex_input_state.bindings.size() * sizeof(VkVertexInputBindingDescription));
 
-		vkb::hash_combine(result, pipeline_state.get_specialization_constant_state());
+		return static_cast<std::size_t>(hasher.get());
+	}
+};
 
-		vkb::hash_combine(result, pipeline_state.get_subpass_index());
+template <>
+struct hash<vkb::InputAssemblyState>
+{
+	std::size_t operator()(const vkb::InputAssemblyState &input_assembly_state) const
+	{
+		static_assert(sizeof(vkb::InputAssemblyState) == 2 * sizeof(uint32_t), "InputAssemblyState must not have padding");
 
-		for (auto stage : pipeline_state.get_pipeline_layout().get_shader_program().get_shader_modules())
-		{
-			vkb::hash_combine(result, stage->get_id());
-		}
+		return static_cast<std::size_t>(vkb::Hasher{}.pod(input_assembly_state).get());
+	}
+};
 
-		// VkPipelineVertexInputStateCreateInfo
-		for (auto &attribute : pipeline_state.get_vertex_input_state().attributes)
-		{
-			vkb::hash_combine(result, attribute);
-		}
+template <>
+struct hash<vkb::RasterizationState>
+{
+	std::size_t operator()(const vkb::RasterizationState &rasterization_state) const
+	{
+		static_assert(sizeof(vkb::RasterizationState) == 6 * sizeof(uint32_t), "RasterizationState must not have padding");
 
-		for (auto &binding : pipeline_state.get_vertex_input_state().bindings)
-		{
-			vkb::hash_combine(result, binding);
-		}
+		return static_cast<std::size_t>(vkb::Hasher{}.pod(rasterization_state).get());
+	}
+};
 
-		// VkPipelineInputAssemblyStateCreateInfo
-		vkb::hash_combine(result, pipeline_state.get_input_assembly_state().primitive_restart_enable);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkPrimitiveTopology>::type>(pipeline_state.get_input_assembly_state().topology));
-
-		//VkPipelineViewportStateCreateInfo
-		vkb::hash_combine(result, pipeline_state.get_viewport_state().viewport_count);
-		vkb::hash_combine(result, pipeline_state.get_viewport_state().scissor_count);
-
-		// VkPipelineRasterizationStateCreateInfo
-		vkb::hash_combine(result, pipeline_state.get_rasterization_state().cull_mode);
-		vkb::hash_combine(result, pipeline_state.get_rasterization_state().depth_bias_enable);
-		vkb::hash_combine(result, pipeline_state.get_rasterization_state().depth_clamp_enable);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkFrontFace>::type>(pipeline_state.get_rasterization_state().front_face));
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkPolygonMode>::type>(pipeline_state.get_rasterization_state().polygon_mode));
-		vkb::hash_combine(result, pipeline_state.get_rasterization_state().rasterizer_discard_enable);
-
-		// VkPipelineMultisampleStateCreateInfo
-		vkb::hash_combine(result, pipeline_state.get_multisample_state().alpha_to_coverage_enable);
-		vkb::hash_combine(result, pipeline_state.get_multisample_state().alpha_to_one_enable);
-		vkb::hash_combine(result, pipeline_state.get_multisample_state().min_sample_shading);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkSampleCountFlagBits>::type>(pipeline_state.get_multisample_state().rasterization_samples));
-		vkb::hash_combine(result, pipeline_state.get_multisample_state().sample_shading_enable);
-		vkb::hash_combine(result, pipeline_state.get_multisample_state().sample_mask);
-
-		// VkPipelineDepthStencilStateCreateInfo
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().back);
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().depth_bounds_test_enable);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkCompareOp>::type>(pipeline_state.get_depth_stencil_state().depth_compare_op));
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().depth_test_enable);
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().depth_write_enable);
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().front);
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().stencil_test_enable);
-
-		// VkPipelineColorBlendStateCreateInfo
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkLogicOp>::type>(pipeline_state.get_color_blend_state().logic_op));
-		vkb::hash_combine(result, pipeline_state.get_color_blend_state().logic_op_enable);
-
-		for (auto &attachment : pipeline_state.get_color_blend_state().attachments)
-		{
-			vkb::hash_combine(result, attachment);
-		}
+template <>
+struct hash<vkb::ViewportState>
+{
+	std::size_t operator()(const vkb::ViewportState &viewport_state) const
+	{
+		static_assert(sizeof(vkb::ViewportState) == 2 * sizeof(uint32_t), "ViewportState must not have padding");
 
-		return result;
+		return static_cast<std::size_t>(vkb::Hasher{}.pod(viewport_state).get());
+	}
+};
+
+template <>
+struct hash<vkb::MultisampleState>
+{
+	std::size_t operator()(const vkb::MultisampleState &multisample_state) const
+	{
+		static_assert(sizeof(vkb::MultisampleState) == 6 * sizeof(uint32_t), "MultisampleState must not have padding");
+
+		return static_cast<std::size_t>(vkb::Hasher{}.pod(multisample_state).get());
+	}
+};
+
+template <>
+struct hash<vkb::DepthStencilState>
+{
+	std::size_t operator()(const vkb::DepthStencilState &depth_stencil_state) const
+	{
+		static_assert(sizeof(vkb::DepthStencilState) == 13 * sizeof(uint32_t), "DepthStencilState must not have padding");
+
+		return static_cast<std::size_t>(vkb::Hasher{}.pod(depth_stencil_state).get());
+	}
+};
+
+template <>
+struct hash<vkb::ColorBlendState>
+{
+	std::size_t operator()(const vkb::ColorBlendState &color_blend_state) const
+	{
+		vkb::Hasher hasher;
+
+		hasher.pod(color_blend_state.logic_op_enable);
+		hasher.pod(color_blend_state.logic_op);
+		hasher.data(color_blend_state.attachments.data(), color_blend_state.attachments.size() * sizeof(vkb::ColorBlendAttachmentState));
+
+		return static_cast<std::size_t>(hasher.get());
+	}
+};
+
+template <>
+struct hash<vkb::PipelineState>
+{
+	std::size_t operator()(const vkb::PipelineState &pipeline_state) const
+	{
+		// Combined from the hashes of the sub-states, which are kept up to date by the pipeline state
+		return pipeline_state.get_hash();
 	}
 };
 }        // namespace std
@@ -554,16 +569,20 @@ inline void hash_param<std::map<uint32_t, std::map<uint32_t, VkDescriptorBufferI
     size_t &                                                              seed,
     const std::map<uint32_t, std::map<uint32_t, VkDescriptorBufferInfo>> &value)
 {
+	Hasher hasher;
+
 	for (auto &binding_set : value)
 	{
-		hash_combine(seed, binding_set.first);
+		hasher.u64(binding_set.first);
 
 		for (auto &binding_element : binding_set.second)
 		{
-			hash_combine(seed, binding_element.first);
-			hash_combine(seed, binding_element.second);
+			hasher.u64(binding_element.first);
+			hasher.pod(binding_element.second);
 		}
 	}
+
+	hash_combine(seed, hasher.get());
 }
 
 template <>
@@ -571,16 +590,24 @@ inline void hash_param<std::map<uint32_t, std::map<uint32_t, VkDescriptorImageIn
     size_t &                                                             seed,
     const std::map<uint32_t, std::map<uint32_t, VkDescriptorImageInfo>> &value)
 {
+	Hasher hasher;
+
 	for (auto &binding_set : value)
 	{
-		hash_combine(seed, binding_set.first);
+		hasher.u64(binding_set.first);
 
 		for (auto &binding_element : binding_set.second)
 		{
-			hash_combine(seed, binding_element.first);
-			hash_combine(seed, binding_element.second);
+			auto &image_info = binding_element.second;
+
+			hasher.u64(binding_element.first);
+			hasher.pod(image_info.sampler);
+			hasher.pod(image_info.imageView);
+			hasher.u64(static_cast<uint64_t>(image_info.imageLayout));
 		}
 	}
+
+	hash_combine(seed, hasher.get());
 }
 
 template <typename T, typename... Args>
@@ -659,6 +686,46 @@ struct RecordHelper<GraphicsPipeline, A...>
 		recorder.set_graphics_pipeline(index, graphics_pipeline);
 	}
 };
+
+/// Descriptor set layouts, compute pipelines and samplers are not referred to by other entries of the stream
+template <class... A>
+struct RecordHelper<DescriptorSetLayout, A...>
+{
+	size_t record(ResourceRecord &recorder, A &... args)
+	{
+		return recorder.register_descriptor_set_layout(args...);
+	}
+
+	void index(ResourceRecord & /*recorder*/, size_t /*index*/, DescriptorSetLayout & /*descriptor_set_layout*/)
+	{
+	}
+};
+
+template <class... A>
+struct RecordHelper<ComputePipeline, A...>
+{
+	size_t record(ResourceRecord &recorder, A &... args)
+	{
+		return recorder.register_compute_pipeline(args...);
+	}
+
+	void index(ResourceRecord & /*recorder*/, size_t /*index*/, ComputePipeline & /*compute_pipeline*/)
+	{
+	}
+};
+
+template <class... A>
+struct RecordHelper<core::Sampler, A...>
+{
+	size_t record(ResourceRecord &recorder, A &... args)
+	{
+		return recorder.register_sampler(args...);
+	}
+
+	void index(ResourceRecord & /*recorder*/, size_t /*index*/, core::Sampler & /*sampler*/)
+	{
+	}
+};
 }        // namespace
 
 template <class T, class... A>
@@ -0,0 +1,115 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief A fixed size queue without locks, for one thread pushing and another thread popping
+ *
+ * The indices increase monotonically and are wrapped on access, the queue is full
+ * once the producer is a whole capacity ahead of the consumer.
+ */
+template <typename T>
+class SpscRingBuffer
+{
+  public:
+	/**
+	 * @param capacity Maximum number of elements, which must be a power of two
+	 */
+	explicit SpscRingBuffer(size_t capacity) :
+	    elements(capacity)
+	{
+		assert(capacity > 0 && (capacity & (capacity - 1)) == 0 && "Capacity must be a power of two");
+	}
+
+	SpscRingBuffer(const SpscRingBuffer &) = delete;
+
+	SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+	/**
+	 * @brief Called by the producer thread only
+	 * @return False if the queue is full, in which case the element is not moved from
+	 */
+	bool push(T &&element)
+	{
+		auto current_tail = tail.load(std::memory_order_relaxed);
+
+		if (current_tail - head.load(std::memory_order_acquire) == elements.size())
+		{
+			return false;
+		}
+
+		elements[current_tail & (elements.size() - 1)] = std::move(element);
+
+		tail.store(current_tail + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	/**
+	 * @brief Called by the producer thread only
+	 * @return True if the next push would fail
+	 */
+	bool full() const
+	{
+		return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire) == elements.size();
+	}
+
+	/**
+	 * @brief Called by the consumer thread only
+	 * @return False if the queue is empty
+	 */
+	bool pop(T &element)
+	{
+		auto current_head = head.load(std::memory_order_relaxed);
+
+		if (current_head == tail.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		element = std::move(elements[current_head & (elements.size() - 1)]);
+
+		head.store(current_head + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	size_t capacity() const
+	{
+		return elements.size();
+	}
+
+  private:
+	std::vector<T> elements;
+
+	/// Index of the next element to pop, written by the consumer
+	std::atomic<size_t> head{0};
+
+	/// Index of the next element to push, written by the producer
+	std::atomic<size_t> tail{0};
+};
+}        // namespace vkb
@@ -20,9 +20,12 @@
 
 #include "utils.h"
 
+#include <algorithm>
+#include <memory>
 #include <queue>
 #include <stdexcept>
 
+#include "core/device.h"
 #include "core/pipeline_layout.h"
 #include "core/shader_module.h"
 #include "scene_graph/components/image.h"
@@ -51,167 +54,77 @@ std::string get_extension(const std::string &uri)
 	return uri.substr(dot_pos + 1);
 }
 
-void screenshot(RenderContext &render_context, const std::string &filename)
+namespace
+{
+/**
+ * @brief Writes the pixels of a frame to file, as RGB with an opaque alpha
+ */
+void write_screenshot(std::vector<uint8_t> &pixels, VkFormat format, const VkExtent2D &extent, const std::string &filename)
 {
-	VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
-
-	// We want the last completed frame since we don't want to be reading from an incomplete framebuffer
-	auto &frame          = render_context.get_last_rendered_frame();
-	auto &src_image_view = frame.get_render_target().get_views().at(0);
-
-	auto width  = render_context.get_surface_extent().width;
-	auto height = render_context.get_surface_extent().height;
-
-	core::Image dst_image{render_context.get_device(),
-	                      VkExtent3D{width, height, 1},
-	                      format,
-	                      VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-	                      VMA_MEMORY_USAGE_GPU_TO_CPU,
-	                      VK_SAMPLE_COUNT_1_BIT,
-	                      1, 1,
-	                      VK_IMAGE_TILING_LINEAR};
-
-	core::ImageView dst_image_view{dst_image, VK_IMAGE_VIEW_TYPE_2D};
-
-	const auto &queue = render_context.get_device().get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
-
-	auto &cmd_buf = render_context.get_device().request_command_buffer();
-
-	cmd_buf.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-
-	// Enable destination image to be written to
-	{
-		ImageMemoryBarrier memory_barrier{};
-		memory_barrier.src_access_mask = 0;
-		memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
-		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
-
-		cmd_buf.image_memory_barrier(dst_image_view, memory_barrier);
-	}
-
-	// Enable framebuffer image view to be read from
-	{
-		ImageMemoryBarrier memory_barrier{};
-		memory_barrier.old_layout     = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-		memory_barrier.new_layout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-		memory_barrier.src_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		memory_barrier.dst_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
-
-		cmd_buf.image_memory_barrier(src_image_view, memory_barrier);
-	}
-
-	bool swizzle = false;
-
 	// Check if framebuffer images are in a BGR format
 	auto bgr_formats = {VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_B8G8R8A8_SNORM};
-	swizzle          = std::find(bgr_formats.begin(), bgr_formats.end(), src_image_view.get_format()) != bgr_formats.end();
+	bool swizzle     = std::find(bgr_formats.begin(), bgr_formats.end(), format) != bgr_formats.end();
 
-	// Copy framebuffer image memory
-	VkImageCopy image_copy_region{};
-	image_copy_region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	image_copy_region.srcSubresource.layerCount = 1;
-	image_copy_region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	image_copy_region.dstSubresource.layerCount = 1;
-	image_copy_region.extent.width              = width;
-	image_copy_region.extent.height             = height;
-	image_copy_region.extent.depth              = 1;
-
-	cmd_buf.copy_image(src_image_view.get_image(), dst_image, {image_copy_region});
-
-	// Enable destination image to map image memory
+	// Replace the A component with 255 (remove transparency)
+	// If swapchain format is BGR, swapping the R and B components
+	for (size_t i = 0; i < pixels.size(); i += 4)
 	{
-		ImageMemoryBarrier memory_barrier{};
-		memory_barrier.old_layout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		memory_barrier.new_layout     = VK_IMAGE_LAYOUT_GENERAL;
-		memory_barrier.src_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		memory_barrier.dst_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
-
-		cmd_buf.image_memory_barrier(dst_image_view, memory_barrier);
-	}
+		uint8_t *pixel = pixels.data() + i;
 
-	// Revert back the framebuffer image view from transfer to present
-	{
-		ImageMemoryBarrier memory_barrier{};
-		memory_barrier.old_layout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-		memory_barrier.new_layout     = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-		memory_barrier.src_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		memory_barrier.dst_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		if (swizzle)
+		{
+			std::swap(pixel[0], pixel[2]);
+		}
 
-		cmd_buf.image_memory_barrier(src_image_view, memory_barrier);
+		pixel[3] = 255;
 	}
 
-	cmd_buf.end();
-
-	queue.submit(cmd_buf, frame.request_fence());
-
-	queue.wait_idle();
-
-	auto raw_data = dst_image.map();
-
-	// Android requires the sub resource to be queried while the memory is mapped
-	VkImageSubresource  subresource{VK_IMAGE_ASPECT_COLOR_BIT};
-	VkSubresourceLayout subresource_layout;
-	vkGetImageSubresourceLayout(render_context.get_device().get_handle(), dst_image.get_handle(), &subresource, &subresource_layout);
+	vkb::fs::write_image(pixels.data(),
+	                     filename,
+	                     extent.width,
+	                     extent.height,
+	                     4,
+	                     extent.width * 4);
+}
+}        // namespace
 
-	raw_data += subresource_layout.offset;
+void screenshot(RenderContext &render_context, const std::string &filename)
+{
+	auto &job_system = render_context.get_device().get_job_system();
 
-	// Creates a pointer to the address of the first byte past the offset of the image data
-	// Replace the A component with 255 (remove transparency)
-	// If swapchain format is BGR, swapping the R and B components
-	uint8_t *data = raw_data;
-	if (swizzle)
-	{
-		for (size_t i = 0; i < height; ++i)
+	render_context.request_readback([&job_system, filename](const ReadbackFrame &frame) {
+		if (get_bits_per_pixel(frame.format) != 32)
 		{
-			// Gets the first pixel of the first row of the image (a pixel is 4 bytes)
-			unsigned int *pixel = (unsigned int *) data;
+			LOGE("Can't take a screenshot of a {} image", convert_format_to_string(frame.format));
+			return;
+		}
 
-			// Iterate over each pixel, swapping R and B components and writing the max value for alpha
-			for (size_t j = 0; j < width; ++j)
-			{
-				auto temp                = *((uint8_t *) pixel + 2);
-				*((uint8_t *) pixel + 2) = *((uint8_t *) pixel);
-				*((uint8_t *) pixel)     = temp;
-				*((uint8_t *) pixel + 3) = 255;
+		// The pixels are only valid during the callback
+		auto pixels = std::make_shared<std::vector<uint8_t>>(frame.data, frame.data + frame.size);
 
-				// Get next pixel
-				pixel++;
-			}
-			// Pointer arithmetic to get the first byte in the next row of pixels
-			data += subresource_layout.rowPitch;
-		}
-	}
-	else
-	{
-		for (size_t i = 0; i < height; ++i)
-		{
-			// Gets the first pixel of the first row of the image (a pixel is 4 bytes)
-			unsigned int *pixel = (unsigned int *) data;
+		auto format = frame.format;
+		auto extent = frame.extent;
 
-			// Iterate over each pixel, writing the max value for alpha
-			for (size_t j = 0; j < width; ++j)
-			{
-				*((uint8_t *) pixel + 3) = 255;
+		// Encoding the image takes far longer than a frame, so it is left to a worker
+		job_system.push(JobPriority::Background, [pixels, format, extent, filename](size_t) {
+			write_screenshot(*pixels, format, extent, filename);
+		});
+	});
+}
 
-				// Get next pixel
-				pixel++;
-			}
-			// Pointer arithmetic to get the first byte in the next row of pixels
-			data += subresource_layout.rowPitch;
+void screenshot_blocking(RenderContext &render_context, const std::string &filename)
+{
+	render_context.readback_last_frame([&filename](const ReadbackFrame &frame) {
+		if (get_bits_per_pixel(frame.format) != 32)
+		{
+			LOGE("Can't take a screenshot of a {} image", convert_format_to_string(frame.format));
+			return;
 		}
-	}
 
-	vkb::fs::write_image(raw_data,
-	                     filename,
-	                     width,
-	                     height,
-	                     4,
-	                     static_cast<uint32_t>(subresource_layout.rowPitch));
+		std::vector<uint8_t> pixels(frame.data, frame.data + frame.size);
 
-	dst_image.unmap();
+		write_screenshot(pixels, frame.format, frame.extent, filename);
+	});
 }        // namespace vkb
 
 namespace
@@ -247,6 +160,60 @@ VkShaderStageFlagBits find_shader_stage(const std::string &ext)
 };
 }        // namespace
 
+void copy_sampled_levels(CommandBuffer &command_buffer, const core::Image &src, uint32_t src_level, const core::Image &dst, uint32_t dst_level, uint32_t level_count)
+{
+	VkImageSubresourceRange src_range{VK_IMAGE_ASPECT_COLOR_BIT, src_level, level_count, 0, 1};
+	VkImageSubresourceRange dst_range{VK_IMAGE_ASPECT_COLOR_BIT, dst_level, level_count, 0, 1};
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		memory_barrier.src_access_mask = 0;
+		memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		command_buffer.image_memory_barrier(src, src_range, memory_barrier);
+	}
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		memory_barrier.src_access_mask = 0;
+		memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		command_buffer.image_memory_barrier(dst, dst_range, memory_barrier);
+	}
+
+	auto &extent = src.get_extent();
+
+	std::vector<VkImageCopy> regions(level_count);
+	for (uint32_t i = 0; i < level_count; ++i)
+	{
+		regions[i].srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, src_level + i, 0, 1};
+		regions[i].dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, dst_level + i, 0, 1};
+		regions[i].extent         = {std::max(1u, extent.width >> (src_level + i)), std::max(1u, extent.height >> (src_level + i)), 1u};
+	}
+
+	command_buffer.copy_image(src, dst, regions);
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+		command_buffer.image_memory_barrier(dst, dst_range, memory_barrier);
+	}
+}
+
 std::string to_snake_case(const std::string &text)
 {
 	std::stringstream result;
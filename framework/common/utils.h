@@ -49,11 +49,28 @@ std::string get_extension(const std::string &uri);
 std::string to_snake_case(const std::string &name);
 
 /**
- * @brief Takes a screenshot of the app by writing the swapchain image to file (slow function)
+ * @brief Takes a screenshot of the app by writing the image of the next frame submitted to file
+ *        The image is read back once the frame completes, a few frames later, and encoded on
+ *        a worker thread, so that the frames are not stalled
  * @param filename The name of the file to save the output to
  */
 void screenshot(RenderContext &render_context, const std::string &filename);
 
+/**
+ * @brief Takes a screenshot of the app by writing the image of the last frame rendered to file, before returning
+ *        It waits for the device to be idle and encodes the image on the calling thread,
+ *        for callers which exit right after, e.g. the system tests
+ * @param filename The name of the file to save the output to
+ */
+void screenshot_blocking(RenderContext &render_context, const std::string &filename);
+
+/**
+ * @brief Records the copy of sampled levels of an image to levels of another one, e.g. to move or shrink a texture
+ *        The source levels must be in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, and are left in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL.
+ *        The destination levels end in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL for fragment shaders
+ */
+void copy_sampled_levels(CommandBuffer &command_buffer, const core::Image &src, uint32_t src_level, const core::Image &dst, uint32_t dst_level, uint32_t level_count);
+
 /**
  * @brief Adds a light to the scene with the specified parameters
  * @param scene The scene to add the light to
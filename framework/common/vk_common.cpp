@@ -20,6 +20,8 @@
 
 #include "vk_common.h"
 
+#include <algorithm>
+
 std::ostream &operator<<(std::ostream &os, const VkResult result)
 {
 #define WRITE_VK_ENUM(r) \
@@ -258,6 +260,41 @@ int32_t get_bits_per_pixel(VkFormat format)
 	}
 }
 
+VkRect2D merge_rects(const VkRect2D &lhs, const VkRect2D &rhs)
+{
+	if (lhs.extent.width == 0 || lhs.extent.height == 0)
+	{
+		return rhs;
+	}
+
+	if (rhs.extent.width == 0 || rhs.extent.height == 0)
+	{
+		return lhs;
+	}
+
+	int32_t min_x = std::min(lhs.offset.x, rhs.offset.x);
+	int32_t min_y = std::min(lhs.offset.y, rhs.offset.y);
+	int32_t max_x = std::max(lhs.offset.x + static_cast<int32_t>(lhs.extent.width), rhs.offset.x + static_cast<int32_t>(rhs.extent.width));
+	int32_t max_y = std::max(lhs.offset.y + static_cast<int32_t>(lhs.extent.height), rhs.offset.y + static_cast<int32_t>(rhs.extent.height));
+
+	return {{min_x, min_y}, {static_cast<uint32_t>(max_x - min_x), static_cast<uint32_t>(max_y - min_y)}};
+}
+
+VkRect2D intersect_rects(const VkRect2D &lhs, const VkRect2D &rhs)
+{
+	int32_t min_x = std::max(lhs.offset.x, rhs.offset.x);
+	int32_t min_y = std::max(lhs.offset.y, rhs.offset.y);
+	int32_t max_x = std::min(lhs.offset.x + static_cast<int32_t>(lhs.extent.width), rhs.offset.x + static_cast<int32_t>(rhs.extent.width));
+	int32_t max_y = std::min(lhs.offset.y + static_cast<int32_t>(lhs.extent.height), rhs.offset.y + static_cast<int32_t>(rhs.extent.height));
+
+	if (max_x <= min_x || max_y <= min_y)
+	{
+		return {};
+	}
+
+	return {{min_x, min_y}, {static_cast<uint32_t>(max_x - min_x), static_cast<uint32_t>(max_y - min_y)}};
+}
+
 const std::string convert_format_to_string(VkFormat format)
 {
 	switch (format)
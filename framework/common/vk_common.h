@@ -80,6 +80,16 @@ int32_t get_bits_per_pixel(VkFormat format);
  */
 const std::string convert_format_to_string(VkFormat format);
 
+/**
+ * @brief Helper function to get the smallest rectangle containing two rectangles, empty rectangles being ignored
+ */
+VkRect2D merge_rects(const VkRect2D &lhs, const VkRect2D &rhs);
+
+/**
+ * @brief Helper function to get the intersection of two rectangles, an empty rectangle if they do not overlap
+ */
+VkRect2D intersect_rects(const VkRect2D &lhs, const VkRect2D &rhs);
+
 /**
  * @brief Image memory barrier structure used to define
  *        memory access for an image view during command recording.
@@ -97,6 +107,11 @@ struct ImageMemoryBarrier
 	VkImageLayout old_layout{VK_IMAGE_LAYOUT_UNDEFINED};
 
 	VkImageLayout new_layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+	/// Queue families releasing and acquiring the image, for an ownership transfer
+	uint32_t old_queue_family{VK_QUEUE_FAMILY_IGNORED};
+
+	uint32_t new_queue_family{VK_QUEUE_FAMILY_IGNORED};
 };
 
 /**
@@ -112,6 +127,11 @@ struct BufferMemoryBarrier
 	VkAccessFlags src_access_mask{0};
 
 	VkAccessFlags dst_access_mask{0};
+
+	/// Queue families releasing and acquiring the buffer, for an ownership transfer
+	uint32_t old_queue_family{VK_QUEUE_FAMILY_IGNORED};
+
+	uint32_t new_queue_family{VK_QUEUE_FAMILY_IGNORED};
 };
 
 /**
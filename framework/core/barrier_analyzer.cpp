@@ -0,0 +1,214 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "barrier_analyzer.h"
+
+#include <unordered_map>
+
+namespace vkb
+{
+namespace
+{
+/// Stages of the graphics pipeline in the order work goes through them
+const VkPipelineStageFlagBits graphics_stages[] = {VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                                   VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                                                   VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                                                   VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                                                   VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT,
+                                                   VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT,
+                                                   VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT,
+                                                   VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+                                                   VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                                                   VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                                                   VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                                   VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT};
+
+const int32_t graphics_stage_count = static_cast<int32_t>(sizeof(graphics_stages) / sizeof(graphics_stages[0]));
+
+const VkPipelineStageFlags all_graphics_stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT;
+
+const VkAccessFlags write_accesses = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                     VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+/**
+ * @return Whether the stages are all part of the graphics pipeline, as the stages of other commands are not ordered with them
+ */
+bool is_graphics_only(VkPipelineStageFlags stage_mask)
+{
+	VkPipelineStageFlags graphics_mask = all_graphics_stages;
+
+	for (auto stage : graphics_stages)
+	{
+		graphics_mask |= stage;
+	}
+
+	return stage_mask != 0 && (stage_mask & ~graphics_mask) == 0;
+}
+
+/**
+ * @return Position of the first graphics stage of the mask, the stages covering the whole pipeline counting as its top
+ */
+int32_t get_first_graphics_stage(VkPipelineStageFlags stage_mask)
+{
+	if (stage_mask & all_graphics_stages)
+	{
+		return 0;
+	}
+
+	for (int32_t i = 0; i < graphics_stage_count; ++i)
+	{
+		if (stage_mask & graphics_stages[i])
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * @return Position of the last graphics stage of the mask, the stages covering the whole pipeline counting as its bottom
+ */
+int32_t get_last_graphics_stage(VkPipelineStageFlags stage_mask)
+{
+	if (stage_mask & all_graphics_stages)
+	{
+		return graphics_stage_count - 1;
+	}
+
+	for (int32_t i = graphics_stage_count - 1; i >= 0; --i)
+	{
+		if (stage_mask & graphics_stages[i])
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+}        // namespace
+
+void BarrierAnalyzer::record_barrier(uint64_t resource, uint64_t range, VkPipelineStageFlags src_stage_mask, VkPipelineStageFlags dst_stage_mask,
+                                     VkAccessFlags src_access_mask, VkAccessFlags dst_access_mask, VkImageLayout old_layout, VkImageLayout new_layout)
+{
+	commands.push_back({resource, dst_stage_mask, true, range, src_stage_mask, src_access_mask, dst_access_mask, old_layout, new_layout});
+}
+
+void BarrierAnalyzer::record_use(uint64_t resource, VkPipelineStageFlags stage_mask)
+{
+	commands.push_back({resource, stage_mask, false, 0, 0, 0, 0, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED});
+}
+
+void BarrierAnalyzer::record_shader_use(uint64_t resource, VkShaderStageFlags shader_stages)
+{
+	VkPipelineStageFlags stage_mask = 0;
+
+	const std::pair<VkShaderStageFlagBits, VkPipelineStageFlagBits> shader_pipeline_stages[] = {
+	    {VK_SHADER_STAGE_VERTEX_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT},
+	    {VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT, VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT},
+	    {VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT, VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT},
+	    {VK_SHADER_STAGE_GEOMETRY_BIT, VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT},
+	    {VK_SHADER_STAGE_FRAGMENT_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT},
+	    {VK_SHADER_STAGE_COMPUTE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT}};
+
+	for (auto &stages : shader_pipeline_stages)
+	{
+		if (shader_stages & stages.first)
+		{
+			stage_mask |= stages.second;
+		}
+	}
+
+	// Stages the analysis does not know about are not ordered, so that the use is not checked
+	if (shader_stages & ~(VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT))
+	{
+		stage_mask |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	}
+
+	record_use(resource, stage_mask);
+}
+
+BarrierAnalyzer::Summary BarrierAnalyzer::analyze()
+{
+	Summary summary;
+
+	// Commands on the same resource, in recording order
+	std::unordered_map<uint64_t, std::vector<const Command *>> resource_commands;
+
+	for (auto &command : commands)
+	{
+		resource_commands[command.resource].push_back(&command);
+	}
+
+	for (auto &resource_it : resource_commands)
+	{
+		auto &resource_list = resource_it.second;
+
+		// Stages using the resource since the previous barrier on it
+		VkPipelineStageFlags uses_before = 0;
+
+		for (size_t i = 0; i < resource_list.size(); ++i)
+		{
+			auto &command = *resource_list[i];
+
+			if (!command.barrier)
+			{
+				uses_before |= command.stage_mask;
+				continue;
+			}
+
+			VkPipelineStageFlags uses_after = 0;
+
+			size_t next = i + 1;
+			for (; next < resource_list.size() && !resource_list[next]->barrier; ++next)
+			{
+				uses_after |= resource_list[next]->stage_mask;
+			}
+
+			bool read_only = (command.src_access_mask & write_accesses) == 0 && (command.dst_access_mask & write_accesses) == 0;
+
+			if ((command.old_layout == command.new_layout && command.src_access_mask != 0 && read_only) ||
+			    (uses_after == 0 && next < resource_list.size() && resource_list[next]->range == command.range))
+			{
+				summary.redundant_barriers++;
+			}
+
+			// Work after the barrier can only start once its destination stages are reached
+			if (is_graphics_only(uses_after) && is_graphics_only(command.stage_mask) &&
+			    get_first_graphics_stage(command.stage_mask) < get_first_graphics_stage(uses_after))
+			{
+				summary.early_destination_barriers++;
+			}
+
+			if (is_graphics_only(uses_before) && is_graphics_only(command.src_stage_mask) &&
+			    get_last_graphics_stage(command.src_stage_mask) > get_last_graphics_stage(uses_before))
+			{
+				summary.late_source_barriers++;
+			}
+
+			uses_before = 0;
+		}
+	}
+
+	commands.clear();
+
+	return summary;
+}
+}        // namespace vkb
@@ -0,0 +1,100 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "common/vk_common.h"
+
+namespace vkb
+{
+/**
+ * @brief Records the barriers of a command buffer and the uses of the resources they target, to flag the
+ *        barriers that synchronize more than the uses around them need. Only the uses recorded in the same
+ *        command buffer are known, so a barrier without any use on one of its sides is not checked on that side
+ */
+class BarrierAnalyzer
+{
+  public:
+	/**
+	 * @brief Number of barriers flagged by an analysis
+	 */
+	struct Summary
+	{
+		/// Barriers blocking earlier stages than the first stages using the resource after them
+		uint32_t early_destination_barriers{0};
+
+		/// Barriers waiting for later stages than the last stages using the resource before them
+		uint32_t late_source_barriers{0};
+
+		/// Barriers between reads in the same layout, or followed by another barrier on the same range without any use
+		uint32_t redundant_barriers{0};
+	};
+
+	/**
+	 * @brief Records a barrier on a resource
+	 * @param resource Handle of the image or buffer, cast with reinterpret_cast<uint64_t>
+	 * @param range Identifies the subresource range or buffer region, so that barriers on other ranges are not merged
+	 */
+	void record_barrier(uint64_t resource, uint64_t range, VkPipelineStageFlags src_stage_mask, VkPipelineStageFlags dst_stage_mask,
+	                    VkAccessFlags src_access_mask, VkAccessFlags dst_access_mask, VkImageLayout old_layout, VkImageLayout new_layout);
+
+	/**
+	 * @brief Records the stages of a command using a resource
+	 */
+	void record_use(uint64_t resource, VkPipelineStageFlags stage_mask);
+
+	/**
+	 * @brief Records the stages of shaders reading or writing a resource through a descriptor
+	 */
+	void record_shader_use(uint64_t resource, VkShaderStageFlags shader_stages);
+
+	/**
+	 * @brief Analyzes the barriers recorded since the last call, and forgets them
+	 */
+	Summary analyze();
+
+  private:
+	struct Command
+	{
+		uint64_t resource;
+
+		/// Pipeline stages of a use, or the destination stages of a barrier
+		VkPipelineStageFlags stage_mask;
+
+		bool barrier;
+
+		uint64_t range;
+
+		VkPipelineStageFlags src_stage_mask;
+
+		VkAccessFlags src_access_mask;
+
+		VkAccessFlags dst_access_mask;
+
+		VkImageLayout old_layout;
+
+		VkImageLayout new_layout;
+	};
+
+	std::vector<Command> commands;
+};
+}        // namespace vkb
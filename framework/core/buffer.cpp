@@ -26,39 +26,71 @@ namespace vkb
 {
 namespace core
 {
-Buffer::Buffer(Device &device, VkDeviceSize size, VkBufferUsageFlags buffer_usage, VmaMemoryUsage memory_usage, VmaAllocationCreateFlags flags) :
+Buffer::Buffer(Device &device, VkDeviceSize size, VkBufferUsageFlags buffer_usage, VmaMemoryUsage memory_usage, VmaAllocationCreateFlags flags,
+               const AllocationHints &hints) :
     device{device},
     size{size}
 {
-	assert(((flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) == 0) && "Buffer memory should be mapped explicitly outside the constructor");
-
 	VkBufferCreateInfo buffer_info{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
 	buffer_info.usage = buffer_usage;
 	buffer_info.size  = size;
 
-	VmaAllocationCreateInfo memory_info{};
-	memory_info.flags = flags;
-	memory_info.usage = memory_usage;
-
-	VmaAllocationInfo alloc_info{};
-	auto              result = vmaCreateBuffer(device.get_memory_allocator(),
-                                  &buffer_info, &memory_info,
-                                  &handle, &memory,
-                                  &alloc_info);
+	auto result = vkCreateBuffer(device.get_handle(), &buffer_info, nullptr, &handle);
 
 	if (result != VK_SUCCESS)
 	{
 		throw VulkanException{result, "Cannot create Buffer"};
 	}
+
+	if (buffer_usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT))
+	{
+		memory_category = MemoryCategory::Geometry;
+	}
+	else if (memory_usage == VMA_MEMORY_USAGE_CPU_ONLY)
+	{
+		memory_category = MemoryCategory::Staging;
+	}
+	else
+	{
+		memory_category = MemoryCategory::BufferPools;
+	}
+
+	VmaAllocationInfo alloc_info{};
+
+	try
+	{
+		memory = device.get_resource_allocator().allocate(handle, memory_usage, flags, hints, memory_category, alloc_info);
+	}
+	catch (const VulkanException &)
+	{
+		vkDestroyBuffer(device.get_handle(), handle, nullptr);
+		throw;
+	}
+
+	allocation_size = alloc_info.size;
+
+	// Mapped for the lifetime of the allocation, which VMA unmaps on destruction
+	if (flags & VMA_ALLOCATION_CREATE_MAPPED_BIT)
+	{
+		mapped_data = static_cast<uint8_t *>(alloc_info.pMappedData);
+	}
+
+	VkMemoryPropertyFlags memory_properties{0};
+	vmaGetMemoryTypeProperties(device.get_memory_allocator(), alloc_info.memoryType, &memory_properties);
+
+	coherent = (memory_properties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
 }
 
 Buffer::Buffer(Buffer &&other) :
     device{other.device},
     handle{other.handle},
     memory{other.memory},
+    memory_category{other.memory_category},
+    allocation_size{other.allocation_size},
     size{other.size},
     mapped_data{other.mapped_data},
-    mapped{other.mapped}
+    mapped{other.mapped},
+    coherent{other.coherent}
 {
 	// Reset other handles to avoid releasing on destruction
 	other.handle      = VK_NULL_HANDLE;
@@ -72,10 +104,16 @@ Buffer::~Buffer()
 	if (handle != VK_NULL_HANDLE && memory != VK_NULL_HANDLE)
 	{
 		unmap();
-		vmaDestroyBuffer(device.get_memory_allocator(), handle, memory);
+		vkDestroyBuffer(device.get_handle(), handle, nullptr);
+		device.get_resource_allocator().free(memory, memory_category);
 	}
 }
 
+Device &Buffer::get_device()
+{
+	return device;
+}
+
 const Device &Buffer::get_device() const
 {
 	return device;
@@ -118,7 +156,27 @@ void Buffer::unmap()
 
 void Buffer::flush()
 {
-	vmaFlushAllocation(device.get_memory_allocator(), memory, 0, size);
+	flush(0, size);
+}
+
+void Buffer::flush(VkDeviceSize offset, VkDeviceSize size)
+{
+	if (coherent)
+	{
+		return;
+	}
+
+	vmaFlushAllocation(device.get_memory_allocator(), memory, offset, size);
+}
+
+bool Buffer::is_coherent() const
+{
+	return coherent;
+}
+
+void Buffer::invalidate()
+{
+	vmaInvalidateAllocation(device.get_memory_allocator(), memory, 0, size);
 }
 
 void Buffer::update(const std::vector<uint8_t> &data, size_t offset)
@@ -128,10 +186,19 @@ void Buffer::update(const std::vector<uint8_t> &data, size_t offset)
 
 void Buffer::update(const uint8_t *src, const size_t size, const size_t offset)
 {
+	// Persistently mapped buffers, such as the blocks of a buffer pool, are written in place
+	bool persistent = mapped_data != nullptr;
+
 	map();
 	std::copy(src, src + size, mapped_data + offset);
-	flush();
-	unmap();        // Workaround for Mac MoltenVK requiring unmapping (https://github.com/KhronosGroup/MoltenVK/issues/175)
+	flush(offset, size);
+
+	device.add_uploaded_bytes(size);
+
+	if (!persistent)
+	{
+		unmap();        // Workaround for Mac MoltenVK requiring unmapping (https://github.com/KhronosGroup/MoltenVK/issues/175)
+	}
 }
 
 }        // namespace core
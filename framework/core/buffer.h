@@ -22,17 +22,24 @@
 
 #include "common/helpers.h"
 #include "common/vk_common.h"
+#include "resource_allocator.h"
 
 namespace vkb
 {
 class Device;
 
+enum class MemoryCategory;
+
 namespace core
 {
 class Buffer
 {
   public:
-	Buffer(Device &device, VkDeviceSize size, VkBufferUsageFlags buffer_usage, VmaMemoryUsage memory_usage, VmaAllocationCreateFlags flags = 0);
+	/**
+	 * @param hints Placement hints of the memory, e.g. dedicated for large streaming pools
+	 */
+	Buffer(Device &device, VkDeviceSize size, VkBufferUsageFlags buffer_usage, VmaMemoryUsage memory_usage, VmaAllocationCreateFlags flags = 0,
+	       const AllocationHints &hints = {});
 
 	Buffer(const Buffer &) = delete;
 
@@ -44,6 +51,8 @@ class Buffer
 
 	Buffer &operator=(Buffer &&) = delete;
 
+	Device &get_device();
+
 	const Device &get_device() const;
 
 	VkBuffer get_handle() const;
@@ -66,6 +75,24 @@ class Buffer
 	 */
 	void flush();
 
+	/**
+	 * @brief Flushes a range of the memory if it is HOST_VISIBLE and not HOST_COHERENT
+	 * @param offset Start of the range in bytes
+	 * @param size Size of the range in bytes
+	 */
+	void flush(VkDeviceSize offset, VkDeviceSize size);
+
+	/**
+	 * @return Whether the memory is HOST_COHERENT, in which case flushing it is not needed
+	 */
+	bool is_coherent() const;
+
+	/**
+	 * @brief Invalidates the memory if it is HOST_VISIBLE and not HOST_COHERENT,
+	 *        so that the host reads what the device wrote
+	 */
+	void invalidate();
+
 	/**
 	 * @return The size of the buffer
 	 */
@@ -73,6 +100,7 @@ class Buffer
 
 	/**
 	 * @brief Updates the content of the buffer
+	 *        A buffer mapped before the call stays mapped, otherwise it is unmapped afterwards
 	 * @param offset Offset from which to start uploading
 	 * @param data Data to upload
 	 */
@@ -98,12 +126,19 @@ class Buffer
 
 	VmaAllocation memory{VK_NULL_HANDLE};
 
+	/// Category the allocation is attributed to in the device memory usage
+	MemoryCategory memory_category{};
+
+	VkDeviceSize allocation_size{0};
+
 	VkDeviceSize size{0};
 
 	uint8_t *mapped_data{nullptr};
 
 	/// Whether it has been mapped with vmaMapMemory
 	bool mapped{false};
+
+	bool coherent{false};
 };
 }        // namespace core
 }        // namespace vkb
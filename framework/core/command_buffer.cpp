@@ -20,15 +20,71 @@
 
 #include "command_buffer.h"
 
+#include <cstring>
+
 #include "command_pool.h"
 #include "common/error.h"
 #include "device.h"
+#include "draw_list_record.h"
 #include "rendering/render_frame.h"
 #include "rendering/shader_program.h"
 #include "rendering/subpass.h"
 
 namespace vkb
 {
+namespace
+{
+/**
+ * @brief Estimates the external memory traffic of the attachments of a render pass, which tile based GPUs
+ *        read from memory when loaded and write back when stored, while cleared and discarded ones stay on tile
+ */
+void add_attachment_traffic(const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, CommandBufferCounters &counters)
+{
+	auto &extent      = render_target.get_extent();
+	auto &attachments = render_target.get_attachments();
+	auto &views       = render_target.get_views();
+
+	for (size_t i = 0; i < attachments.size() && i < load_store_infos.size(); ++i)
+	{
+		uint64_t texel_count = static_cast<uint64_t>(extent.width) * extent.height * views[i].get_subresource_range().layerCount * attachments[i].samples;
+		uint64_t size        = texel_count * to_u32(std::max(get_bits_per_pixel(attachments[i].format), 0)) / 8;
+
+		if (load_store_infos[i].load_op == VK_ATTACHMENT_LOAD_OP_LOAD)
+		{
+			counters.attachment_read_bytes += size;
+		}
+
+		if (load_store_infos[i].store_op == VK_ATTACHMENT_STORE_OP_STORE)
+		{
+			counters.attachment_write_bytes += size;
+		}
+	}
+}
+
+/**
+ * @brief Splits a render area into horizontal bands of equal height, one per GPU of a device group
+ */
+std::vector<VkRect2D> get_split_render_areas(const VkRect2D &render_area, uint32_t device_count)
+{
+	std::vector<VkRect2D> areas(device_count, render_area);
+
+	for (uint32_t i = 0; i < device_count; i++)
+	{
+		uint32_t top    = render_area.extent.height * i / device_count;
+		uint32_t bottom = render_area.extent.height * (i + 1) / device_count;
+
+		areas[i].offset.y      = render_area.offset.y + static_cast<int32_t>(top);
+		areas[i].extent.height = bottom - top;
+	}
+
+	return areas;
+}
+}        // namespace
+
+constexpr uint32_t CommandBuffer::MAX_PUSH_CONSTANT_SIZE;
+constexpr uint32_t CommandBuffer::MAX_VERTEX_BINDINGS;
+constexpr uint32_t CommandBuffer::MAX_VIEWPORTS;
+
 CommandBuffer::CommandBuffer(CommandPool &command_pool, VkCommandBufferLevel level) :
     command_pool{command_pool},
     level{level}
@@ -87,6 +143,11 @@ void CommandBuffer::clear(VkClearAttachment attachment, VkClearRect rect)
 }
 
 VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, CommandBuffer *primary_cmd_buf)
+{
+	return begin(flags, primary_cmd_buf, primary_cmd_buf ? primary_cmd_buf->get_current_subpass_index() : 0);
+}
+
+VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, CommandBuffer *primary_cmd_buf, uint32_t subpass_index)
 {
 	assert(!is_recording() && "Command buffer is already recording, please call end before beginning again");
 
@@ -101,12 +162,28 @@ VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, CommandBuffer *pr
 	pipeline_state.reset();
 	resource_binding_state.reset();
 	descriptor_set_layout_binding_state.clear();
-	stored_push_constants.clear();
+	bound_descriptor_sets.clear();
+	stored_push_constant_size = 0;
+	skipped_draw_count        = 0;
+	pending_pipeline_count    = 0;
+	counters                  = {};
+	invalidate_bound_state();
+
+	pipeline_state.set_extended_dynamic_state(get_device().is_extended_dynamic_state_enabled());
 
 	VkCommandBufferBeginInfo       begin_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
 	VkCommandBufferInheritanceInfo inheritance = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
 	begin_info.flags                           = flags;
 
+	// The commands of a frame only run on the GPUs of the device group rendering it
+	VkDeviceGroupCommandBufferBeginInfoKHR device_group_info{VK_STRUCTURE_TYPE_DEVICE_GROUP_COMMAND_BUFFER_BEGIN_INFO_KHR};
+	auto                                   render_frame = command_pool.get_render_frame();
+	if (level == VK_COMMAND_BUFFER_LEVEL_PRIMARY && render_frame && render_frame->get_device_mask() != 0)
+	{
+		device_group_info.deviceMask = render_frame->get_device_mask();
+		begin_info.pNext             = &device_group_info;
+	}
+
 	if (level == VK_COMMAND_BUFFER_LEVEL_SECONDARY)
 	{
 		assert(primary_cmd_buf && "A primary command buffer pointer must be provided when calling begin from a secondary one");
@@ -114,12 +191,24 @@ VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, CommandBuffer *pr
 		auto render_pass_binding        = primary_cmd_buf->get_current_render_pass();
 		current_render_pass.render_pass = render_pass_binding.render_pass;
 		current_render_pass.framebuffer = render_pass_binding.framebuffer;
+		current_render_pass.render_area = render_pass_binding.render_area;
 
 		inheritance.renderPass  = current_render_pass.render_pass->get_handle();
 		inheritance.framebuffer = current_render_pass.framebuffer->get_handle();
-		inheritance.subpass     = primary_cmd_buf->get_current_subpass_index();
+		inheritance.subpass     = subpass_index;
 
 		begin_info.pInheritanceInfo = &inheritance;
+
+		// Inherit the subpass index and its blend state attachments
+		pipeline_state.set_subpass_index(inheritance.subpass);
+
+		auto blend_state = pipeline_state.get_color_blend_state();
+		blend_state.attachments.resize(current_render_pass.render_pass->get_color_output_count(inheritance.subpass));
+		pipeline_state.set_color_blend_state(blend_state);
+
+		auto multisample_state                  = pipeline_state.get_multisample_state();
+		multisample_state.rasterization_samples = current_render_pass.render_pass->get_sample_count(inheritance.subpass);
+		pipeline_state.set_multisample_state(multisample_state);
 	}
 
 	return vkBeginCommandBuffer(get_handle(), &begin_info);
@@ -136,6 +225,16 @@ VkResult CommandBuffer::end()
 
 	vkEndCommandBuffer(get_handle());
 
+#if defined(VKB_DEBUG)
+	auto barrier_summary = barrier_analyzer.analyze();
+
+	counters.early_destination_barriers += barrier_summary.early_destination_barriers;
+	counters.late_source_barriers += barrier_summary.late_source_barriers;
+	counters.redundant_barriers += barrier_summary.redundant_barriers;
+#endif
+
+	get_device().add_command_buffer_counters(counters);
+
 	state = State::Executable;
 
 	return VK_SUCCESS;
@@ -143,12 +242,6 @@ VkResult CommandBuffer::end()
 
 void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values, const std::vector<std::unique_ptr<Subpass>> &subpasses, VkSubpassContents contents)
 {
-	// Reset state
-	pipeline_state.reset();
-	resource_binding_state.reset();
-	descriptor_set_layout_binding_state.clear();
-
-	// Create render pass
 	assert(subpasses.size() > 0 && "Cannot create a render pass without any subpass");
 	std::vector<SubpassInfo> subpass_infos(subpasses.size());
 	auto                     subpass_info_it = subpass_infos.begin();
@@ -156,30 +249,185 @@ void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const s
 	{
 		subpass_info_it->input_attachments  = subpass->get_input_attachments();
 		subpass_info_it->output_attachments = subpass->get_output_attachments();
+		subpass_info_it->view_mask          = subpass->get_view_mask();
+
+		subpass_info_it->rasterization_order_access = subpass->is_rasterization_order_access();
 
 		++subpass_info_it;
 	}
-	current_render_pass.render_pass = &get_device().get_resource_cache().request_render_pass(render_target.get_attachments(), load_store_infos, subpass_infos);
+
+	// Name the render pass after its subpasses
+	std::string debug_name = "Render pass:";
+#if defined(VKB_DEBUG)
+	if (get_device().is_debug_utils_enabled())
+	{
+		for (auto &subpass : subpasses)
+		{
+			debug_name += " [" + subpass->get_debug_name() + "]";
+		}
+	}
+#endif
+
+	begin_render_pass(render_target, load_store_infos, clear_values, subpass_infos, contents, debug_name);
+}
+
+void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values, const std::vector<SubpassInfo> &render_pass_subpass_infos, VkSubpassContents contents, const std::string &debug_name)
+{
+	if (draw_list_record)
+	{
+		// The layouts of the attachments change from a render pass to the next
+		std::vector<VkImageLayout> initial_layouts;
+		for (auto &attachment : render_target.get_attachments())
+		{
+			initial_layouts.push_back(attachment.initial_layout);
+		}
+
+		draw_list_record->record(DrawListCommand::BeginRenderPass, draw_list_record->get_render_target_index(render_target), initial_layouts,
+		                         load_store_infos, clear_values, render_pass_subpass_infos.size());
+
+		for (auto &subpass_info : render_pass_subpass_infos)
+		{
+			draw_list_record->record_data(subpass_info.input_attachments, subpass_info.output_attachments, subpass_info.view_mask, subpass_info.rasterization_order_access);
+		}
+	}
+
+	// Reset state
+	pipeline_state.reset();
+	resource_binding_state.reset();
+	descriptor_set_layout_binding_state.clear();
+	bound_descriptor_sets.clear();
+
+	// Create render pass
+	assert(render_pass_subpass_infos.size() > 0 && "Cannot create a render pass without any subpass");
+	std::vector<SubpassInfo> subpass_infos = render_pass_subpass_infos;
+
+	std::vector<LoadStoreInfo> render_pass_load_store   = load_store_infos;
+	std::vector<VkClearValue>  render_pass_clear_values = clear_values;
+
+	auto &multisampled_attachments = render_target.get_multisampled_attachments();
+
+	if (std::find_if(multisampled_attachments.begin(), multisampled_attachments.end(), [](uint32_t attachment) { return attachment != VK_ATTACHMENT_UNUSED; }) != multisampled_attachments.end())
+	{
+		render_pass_load_store.resize(render_target.get_attachments().size());
+		render_pass_clear_values.resize(render_target.get_attachments().size());
+
+		std::vector<bool> remapped(multisampled_attachments.size(), false);
+
+		// Subpasses render to the multisampled attachment instead, and the last one writing it resolves it on tile
+		for (auto subpass_info = subpass_infos.rbegin(); subpass_info != subpass_infos.rend(); ++subpass_info)
+		{
+			subpass_info->color_resolve_attachments.resize(subpass_info->output_attachments.size(), VK_ATTACHMENT_UNUSED);
+
+			for (size_t k = 0; k < subpass_info->output_attachments.size(); ++k)
+			{
+				uint32_t o_attachment = subpass_info->output_attachments[k];
+				uint32_t m_attachment = multisampled_attachments[o_attachment];
+
+				if (m_attachment == VK_ATTACHMENT_UNUSED)
+				{
+					continue;
+				}
+
+				subpass_info->output_attachments[k] = m_attachment;
+
+				if (!remapped[o_attachment])
+				{
+					subpass_info->color_resolve_attachments[k] = o_attachment;
+					remapped[o_attachment]                     = true;
+				}
+			}
+
+			for (auto i_attachment : subpass_info->input_attachments)
+			{
+				assert(multisampled_attachments[i_attachment] == VK_ATTACHMENT_UNUSED && "Multisampled attachments cannot be read as input attachments");
+				(void) i_attachment;
+			}
+		}
+
+		// The multisampled attachment is cleared or loaded in place of the resolved one, and never stored
+		for (uint32_t i = 0; i < multisampled_attachments.size(); ++i)
+		{
+			uint32_t m_attachment = multisampled_attachments[i];
+
+			if (m_attachment != VK_ATTACHMENT_UNUSED && remapped[i])
+			{
+				render_pass_load_store[m_attachment].load_op  = render_pass_load_store[i].load_op;
+				render_pass_load_store[m_attachment].store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				render_pass_load_store[i].load_op             = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+
+				render_pass_clear_values[m_attachment] = render_pass_clear_values[i];
+			}
+		}
+	}
+	// The label is closed in end_render_pass
+	begin_debug_label(debug_name);
+
+	current_render_pass.render_pass = &get_device().get_resource_cache().request_render_pass(render_target.get_attachments(), render_pass_load_store, subpass_infos);
+
+	// The multisampled attachments are already remapped, so that only the resolved ones count as stored
+	add_attachment_traffic(render_target, render_pass_load_store, counters);
+
+	for (auto &view : render_target.get_views())
+	{
+		record_resource_use(view.get_image().get_handle(), is_depth_stencil_format(view.get_format()) ?
+		                                                       VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT :
+		                                                       VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+	}
 	current_render_pass.framebuffer = &get_device().get_resource_cache().request_framebuffer(render_target, *current_render_pass.render_pass);
 
 	// Begin render pass
 	VkRenderPassBeginInfo begin_info{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
 	begin_info.renderPass        = current_render_pass.render_pass->get_handle();
 	begin_info.framebuffer       = current_render_pass.framebuffer->get_handle();
-	begin_info.renderArea.extent = render_target.get_extent();
-	begin_info.clearValueCount   = to_u32(clear_values.size());
-	begin_info.pClearValues      = clear_values.data();
+	begin_info.renderArea        = render_target.get_render_area();
+	begin_info.clearValueCount   = to_u32(render_pass_clear_values.size());
+	begin_info.pClearValues      = render_pass_clear_values.data();
+
+	// With split frame rendering, each GPU of the frame renders a band of the render area
+	VkDeviceGroupRenderPassBeginInfoKHR device_group_info{VK_STRUCTURE_TYPE_DEVICE_GROUP_RENDER_PASS_BEGIN_INFO_KHR};
+	std::vector<VkRect2D>               device_render_areas;
+	auto                                render_frame = command_pool.get_render_frame();
+	if (render_frame && render_frame->is_split_frame())
+	{
+		device_render_areas = get_split_render_areas(begin_info.renderArea, get_device().get_device_group_size());
+
+		device_group_info.deviceMask            = render_frame->get_device_mask();
+		device_group_info.deviceRenderAreaCount = to_u32(device_render_areas.size());
+		device_group_info.pDeviceRenderAreas    = device_render_areas.data();
+
+		begin_info.pNext = &device_group_info;
+	}
 
 	vkCmdBeginRenderPass(get_handle(), &begin_info, contents);
 
+	bool render_area_changed = std::memcmp(&current_render_pass.render_area, &begin_info.renderArea, sizeof(VkRect2D)) != 0;
+
+	current_render_pass.render_area = begin_info.renderArea;
+
+	// The scissors set before the render pass began are clamped to its render area
+	if (render_area_changed)
+	{
+		apply_scissors(0, MAX_VIEWPORTS);
+	}
+
 	// Update blend state attachments for first subpass
 	auto blend_state = pipeline_state.get_color_blend_state();
 	blend_state.attachments.resize(current_render_pass.render_pass->get_color_output_count(pipeline_state.get_subpass_index()));
 	pipeline_state.set_color_blend_state(blend_state);
+
+	// Pipelines match the sample count of the subpass attachments
+	auto multisample_state                  = pipeline_state.get_multisample_state();
+	multisample_state.rasterization_samples = current_render_pass.render_pass->get_sample_count(pipeline_state.get_subpass_index());
+	pipeline_state.set_multisample_state(multisample_state);
 }
 
-void CommandBuffer::next_subpass()
+void CommandBuffer::next_subpass(VkSubpassContents contents)
 {
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::NextSubpass);
+	}
+
 	// Increment subpass index
 	pipeline_state.set_subpass_index(pipeline_state.get_subpass_index() + 1);
 
@@ -188,193 +436,640 @@ void CommandBuffer::next_subpass()
 	blend_state.attachments.resize(current_render_pass.render_pass->get_color_output_count(pipeline_state.get_subpass_index()));
 	pipeline_state.set_color_blend_state(blend_state);
 
+	auto multisample_state                  = pipeline_state.get_multisample_state();
+	multisample_state.rasterization_samples = current_render_pass.render_pass->get_sample_count(pipeline_state.get_subpass_index());
+	pipeline_state.set_multisample_state(multisample_state);
+
 	// Reset descriptor sets
 	resource_binding_state.reset();
 	descriptor_set_layout_binding_state.clear();
+	bound_descriptor_sets.clear();
 
 	// Clear stored push constants
-	stored_push_constants.clear();
+	stored_push_constant_size = 0;
 
-	vkCmdNextSubpass(get_handle(), VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdNextSubpass(get_handle(), contents);
 }
 
 void CommandBuffer::execute_commands(CommandBuffer &secondary_command_buffer)
 {
 	vkCmdExecuteCommands(get_handle(), 1, &secondary_command_buffer.get_handle());
+
+	invalidate_bound_state();
 }
 
 void CommandBuffer::execute_commands(std::vector<CommandBuffer *> &secondary_command_buffers)
 {
-	std::vector<VkCommandBuffer> sec_cmd_buf_handles(secondary_command_buffers.size(), VK_NULL_HANDLE);
+	ArenaVector<VkCommandBuffer> sec_cmd_buf_handles(secondary_command_buffers.size(), VK_NULL_HANDLE, get_frame_arena());
 	std::transform(secondary_command_buffers.begin(), secondary_command_buffers.end(), sec_cmd_buf_handles.begin(),
 	               [](const vkb::CommandBuffer *sec_cmd_buf) { return sec_cmd_buf->get_handle(); });
 	vkCmdExecuteCommands(get_handle(), to_u32(sec_cmd_buf_handles.size()), sec_cmd_buf_handles.data());
+
+	invalidate_bound_state();
 }
 
 void CommandBuffer::end_render_pass()
 {
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::EndRenderPass);
+	}
+
 	vkCmdEndRenderPass(get_handle());
+
+	end_debug_label();
 }
 
 void CommandBuffer::bind_pipeline_layout(PipelineLayout &pipeline_layout)
 {
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::BindPipelineLayout, draw_list_record->get_pipeline_layout_index(pipeline_layout));
+	}
+
 	pipeline_state.set_pipeline_layout(pipeline_layout);
 }
 
 void CommandBuffer::set_specialization_constant(uint32_t constant_id, const std::vector<uint8_t> &data)
 {
-	pipeline_state.set_specialization_constant(constant_id, data);
+	set_specialization_constant(constant_id, data.data(), to_u32(data.size()));
+}
+
+void CommandBuffer::set_specialization_constant(uint32_t constant_id, const uint8_t *data, uint32_t size)
+{
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::SetSpecializationConstant, constant_id, std::vector<uint8_t>{data, data + size});
+	}
+
+	pipeline_state.set_specialization_constant(constant_id, data, size);
 }
 
 void CommandBuffer::set_push_constants(const std::vector<uint8_t> &values)
 {
-	stored_push_constants.insert(stored_push_constants.end(), values.begin(), values.end());
+	set_push_constants(values.data(), to_u32(values.size()));
+}
+
+void CommandBuffer::set_push_constants(const uint8_t *data, uint32_t size)
+{
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::SetPushConstants, std::vector<uint8_t>{data, data + size});
+	}
+
+	if (stored_push_constant_size + size > MAX_PUSH_CONSTANT_SIZE)
+	{
+		LOGE("Ignore stored push constants bigger than {} bytes", MAX_PUSH_CONSTANT_SIZE);
+		return;
+	}
+
+	std::copy(data, data + size, stored_push_constants.begin() + stored_push_constant_size);
+
+	stored_push_constant_size += size;
 }
 
 void CommandBuffer::push_constants_accumulated(const std::vector<uint8_t> &values, uint32_t offset)
 {
-	auto accumulated_values = stored_push_constants;
-	accumulated_values.insert(accumulated_values.end(), values.begin(), values.end());
+	push_constants_accumulated(values.data(), to_u32(values.size()), offset);
+}
+
+void CommandBuffer::push_constants_accumulated(const uint8_t *data, uint32_t size, uint32_t offset)
+{
+	if (stored_push_constant_size + size > MAX_PUSH_CONSTANT_SIZE)
+	{
+		LOGE("Ignore push constants bigger than {} bytes", MAX_PUSH_CONSTANT_SIZE);
+		return;
+	}
+
+	// Concatenate the stored and the new values on the stack
+	std::array<uint8_t, MAX_PUSH_CONSTANT_SIZE> accumulated_values;
 
-	push_constants(offset, accumulated_values);
+	std::copy(stored_push_constants.begin(), stored_push_constants.begin() + stored_push_constant_size, accumulated_values.begin());
+	std::copy(data, data + size, accumulated_values.begin() + stored_push_constant_size);
+
+	push_constants(offset, accumulated_values.data(), stored_push_constant_size + size);
 }
 
 void CommandBuffer::push_constants(uint32_t offset, const std::vector<uint8_t> &values)
 {
-	auto accumulated_values = stored_push_constants;
-	accumulated_values.insert(accumulated_values.end(), values.begin(), values.end());
+	push_constants(offset, values.data(), to_u32(values.size()));
+}
+
+void CommandBuffer::push_constants(uint32_t offset, const uint8_t *data, uint32_t size)
+{
+	// Accumulated push constants are written here with the stored values prepended
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::PushConstants, offset, std::vector<uint8_t>{data, data + size});
+	}
 
 	const PipelineLayout &pipeline_layout = pipeline_state.get_pipeline_layout();
 
-	VkShaderStageFlags shader_stage = pipeline_layout.get_push_constant_range_stage(offset, to_u32(values.size()));
+	VkShaderStageFlags shader_stage = pipeline_layout.get_push_constant_range_stage(offset, size);
 
 	if (shader_stage)
 	{
-		vkCmdPushConstants(get_handle(), pipeline_layout.get_handle(), shader_stage, offset, to_u32(values.size()), values.data());
+		vkCmdPushConstants(get_handle(), pipeline_layout.get_handle(), shader_stage, offset, size, data);
 	}
 	else
 	{
-		LOGW("Push constant range [{}, {}] not found", offset, values.size());
+		LOGW("Push constant range [{}, {}] not found", offset, size);
 	}
 }
 
 void CommandBuffer::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element)
 {
+	if (draw_list_record)
+	{
+		draw_list_record->register_buffer_size(buffer.get_handle(), buffer.get_size());
+		draw_list_record->record(DrawListCommand::BindBuffer, draw_list_record->get_buffer_index(buffer.get_handle()), offset, range, set, binding, array_element);
+	}
+
 	resource_binding_state.bind_buffer(buffer, offset, range, set, binding, array_element);
 }
 
 void CommandBuffer::bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t set, uint32_t binding, uint32_t array_element)
 {
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::BindImage, draw_list_record->get_image_view_index(image_view), draw_list_record->get_sampler_index(sampler), set, binding, array_element);
+	}
+
 	resource_binding_state.bind_image(image_view, sampler, set, binding, array_element);
 }
 
 void CommandBuffer::bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element)
 {
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::BindInput, draw_list_record->get_image_view_index(image_view), set, binding, array_element);
+	}
+
 	resource_binding_state.bind_input(image_view, set, binding, array_element);
 }
 
 void CommandBuffer::bind_vertex_buffers(uint32_t first_binding, const std::vector<std::reference_wrapper<const vkb::core::Buffer>> &buffers, const std::vector<VkDeviceSize> &offsets)
 {
-	std::vector<VkBuffer> buffer_handles(buffers.size(), VK_NULL_HANDLE);
+	if (draw_list_record)
+	{
+		for (const core::Buffer &buffer : buffers)
+		{
+			draw_list_record->register_buffer_size(buffer.get_handle(), buffer.get_size());
+		}
+	}
+
+	ArenaVector<VkBuffer> buffer_handles(buffers.size(), VK_NULL_HANDLE, get_frame_arena());
 	std::transform(buffers.begin(), buffers.end(), buffer_handles.begin(),
 	               [](const core::Buffer &buffer) { return buffer.get_handle(); });
-	vkCmdBindVertexBuffers(get_handle(), first_binding, to_u32(buffer_handles.size()), buffer_handles.data(), offsets.data());
+
+	bind_vertex_buffers(first_binding, to_u32(buffer_handles.size()), buffer_handles.data(), offsets.data());
+}
+
+void CommandBuffer::bind_vertex_buffers(uint32_t first_binding, uint32_t binding_count, const VkBuffer *buffers, const VkDeviceSize *offsets)
+{
+	assert(first_binding + binding_count <= MAX_VERTEX_BINDINGS && "Vertex buffer binding out of range");
+
+	if (draw_list_record)
+	{
+		std::vector<uint32_t> buffer_indices(binding_count);
+
+		for (uint32_t i = 0; i < binding_count; ++i)
+		{
+			draw_list_record->bind_vertex_buffer(first_binding + i, buffers[i], offsets[i]);
+
+			buffer_indices[i] = draw_list_record->get_buffer_index(buffers[i]);
+		}
+
+		draw_list_record->record(DrawListCommand::BindVertexBuffers, first_binding, buffer_indices, std::vector<VkDeviceSize>{offsets, offsets + binding_count});
+	}
+
+	// Skip the bind if all the bindings already use the same buffers and offsets
+	bool redundant = true;
+
+	for (uint32_t i = 0; i < binding_count; ++i)
+	{
+		auto binding = std::make_pair(buffers[i], offsets[i]);
+
+		auto &bound = vertex_buffer_bindings[first_binding + i];
+
+		if (bound != binding)
+		{
+			bound     = binding;
+			redundant = false;
+		}
+	}
+
+	if (redundant)
+	{
+		return;
+	}
+
+	for (uint32_t i = 0; i < binding_count; ++i)
+	{
+		record_resource_use(buffers[i], VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+	}
+
+	vkCmdBindVertexBuffers(get_handle(), first_binding, binding_count, buffers, offsets);
+
+	counters.vertex_buffer_binds++;
+}
+
+void CommandBuffer::bind_vertex_buffer(uint32_t binding, const core::Buffer &buffer, VkDeviceSize offset)
+{
+	if (draw_list_record)
+	{
+		draw_list_record->register_buffer_size(buffer.get_handle(), buffer.get_size());
+	}
+
+	VkBuffer handle = buffer.get_handle();
+
+	bind_vertex_buffers(binding, 1, &handle, &offset);
 }
 
 void CommandBuffer::bind_index_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkIndexType index_type)
 {
+	if (draw_list_record)
+	{
+		draw_list_record->register_buffer_size(buffer.get_handle(), buffer.get_size());
+		draw_list_record->record(DrawListCommand::BindIndexBuffer, draw_list_record->get_buffer_index(buffer.get_handle()), offset, index_type);
+	}
+
+	if (index_buffer_binding.buffer == buffer.get_handle() &&
+	    index_buffer_binding.offset == offset &&
+	    index_buffer_binding.index_type == index_type)
+	{
+		return;
+	}
+
+	index_buffer_binding.buffer     = buffer.get_handle();
+	index_buffer_binding.offset     = offset;
+	index_buffer_binding.index_type = index_type;
+
+	record_resource_use(buffer.get_handle(), VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+
 	vkCmdBindIndexBuffer(get_handle(), buffer.get_handle(), offset, index_type);
 }
 
 void CommandBuffer::set_viewport_state(const ViewportState &state_info)
 {
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::SetViewportState, state_info);
+	}
+
 	pipeline_state.set_viewport_state(state_info);
 }
 
 void CommandBuffer::set_vertex_input_state(const VertexInputState &state_info)
 {
+	if (draw_list_record)
+	{
+		draw_list_record->set_vertex_bindings(state_info.bindings);
+		draw_list_record->record(DrawListCommand::SetVertexInputState, state_info.bindings, state_info.attributes);
+	}
+
 	pipeline_state.set_vertex_input_state(state_info);
 }
 
 void CommandBuffer::set_input_assembly_state(const InputAssemblyState &state_info)
 {
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::SetInputAssemblyState, state_info);
+	}
+
 	pipeline_state.set_input_assembly_state(state_info);
 }
 
 void CommandBuffer::set_rasterization_state(const RasterizationState &state_info)
 {
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::SetRasterizationState, state_info);
+	}
+
 	pipeline_state.set_rasterization_state(state_info);
 }
 
 void CommandBuffer::set_multisample_state(const MultisampleState &state_info)
 {
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::SetMultisampleState, state_info);
+	}
+
 	pipeline_state.set_multisample_state(state_info);
 }
 
 void CommandBuffer::set_depth_stencil_state(const DepthStencilState &state_info)
 {
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::SetDepthStencilState, state_info);
+	}
+
 	pipeline_state.set_depth_stencil_state(state_info);
 }
 
 void CommandBuffer::set_color_blend_state(const ColorBlendState &state_info)
 {
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::SetColorBlendState, state_info.logic_op_enable, state_info.logic_op, state_info.attachments);
+	}
+
 	pipeline_state.set_color_blend_state(state_info);
 }
 
 void CommandBuffer::set_viewport(uint32_t first_viewport, const std::vector<VkViewport> &viewports)
 {
-	vkCmdSetViewport(get_handle(), first_viewport, to_u32(viewports.size()), viewports.data());
+	set_viewport(first_viewport, to_u32(viewports.size()), viewports.data());
 }
 
-void CommandBuffer::set_scissor(uint32_t first_scissor, const std::vector<VkRect2D> &scissors)
+void CommandBuffer::set_viewport(uint32_t first_viewport, uint32_t viewport_count, const VkViewport *viewports)
 {
-	vkCmdSetScissor(get_handle(), first_scissor, to_u32(scissors.size()), scissors.data());
+	assert(first_viewport + viewport_count <= MAX_VIEWPORTS && "Viewport out of range");
+
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::SetViewport, first_viewport, std::vector<VkViewport>{viewports, viewports + viewport_count});
+	}
+
+	bool redundant = true;
+
+	for (uint32_t i = 0; i < viewport_count; ++i)
+	{
+		uint32_t bit = 1U << (first_viewport + i);
+
+		auto &viewport = fixed_dynamic_state.viewports[first_viewport + i];
+
+		if (!(fixed_dynamic_state.viewport_mask & bit) || std::memcmp(&viewport, &viewports[i], sizeof(VkViewport)) != 0)
+		{
+			viewport = viewports[i];
+			fixed_dynamic_state.viewport_mask |= bit;
+			redundant = false;
+		}
+	}
+
+	if (!redundant)
+	{
+		vkCmdSetViewport(get_handle(), first_viewport, viewport_count, viewports);
+	}
 }
 
-void CommandBuffer::set_line_width(float line_width)
+void CommandBuffer::set_scissor(uint32_t first_scissor, const std::vector<VkRect2D> &scissors)
 {
-	vkCmdSetLineWidth(get_handle(), line_width);
+	set_scissor(first_scissor, to_u32(scissors.size()), scissors.data());
 }
 
-void CommandBuffer::set_depth_bias(float depth_bias_constant_factor, float depth_bias_clamp, float depth_bias_slope_factor)
+void CommandBuffer::set_scissor(uint32_t first_scissor, uint32_t scissor_count, const VkRect2D *scissors)
 {
-	vkCmdSetDepthBias(get_handle(), depth_bias_constant_factor, depth_bias_clamp, depth_bias_slope_factor);
+	assert(first_scissor + scissor_count <= MAX_VIEWPORTS && "Scissor out of range");
+
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::SetScissor, first_scissor, std::vector<VkRect2D>{scissors, scissors + scissor_count});
+	}
+
+	bool redundant = true;
+
+	for (uint32_t i = 0; i < scissor_count; ++i)
+	{
+		uint32_t bit = 1U << (first_scissor + i);
+
+		auto &scissor = fixed_dynamic_state.scissors[first_scissor + i];
+
+		if (!(fixed_dynamic_state.scissor_mask & bit) || std::memcmp(&scissor, &scissors[i], sizeof(VkRect2D)) != 0)
+		{
+			scissor = scissors[i];
+			fixed_dynamic_state.scissor_mask |= bit;
+			redundant = false;
+		}
+	}
+
+	if (!redundant)
+	{
+		apply_scissors(first_scissor, scissor_count);
+	}
+}
+
+void CommandBuffer::apply_scissors(uint32_t first_scissor, uint32_t scissor_count)
+{
+	std::array<VkRect2D, MAX_VIEWPORTS> scissors;
+
+	uint32_t count = 0;
+
+	for (uint32_t i = first_scissor; i < first_scissor + scissor_count && (fixed_dynamic_state.scissor_mask & (1U << i)); ++i)
+	{
+		scissors[count] = fixed_dynamic_state.scissors[i];
+
+		// Outside of the render area the contents of the attachments would be undefined
+		if (current_render_pass.render_pass)
+		{
+			scissors[count] = intersect_rects(scissors[count], current_render_pass.render_area);
+		}
+
+		++count;
+	}
+
+	if (count > 0)
+	{
+		vkCmdSetScissor(get_handle(), first_scissor, count, scissors.data());
+	}
+}
+
+void CommandBuffer::set_line_width(float line_width)
+{
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::SetLineWidth, line_width);
+	}
+
+	if (fixed_dynamic_state.line_width_set && fixed_dynamic_state.line_width == line_width)
+	{
+		return;
+	}
+
+	fixed_dynamic_state.line_width_set = true;
+	fixed_dynamic_state.line_width     = line_width;
+
+	vkCmdSetLineWidth(get_handle(), line_width);
+}
+
+void CommandBuffer::set_depth_bias(float depth_bias_constant_factor, float depth_bias_clamp, float depth_bias_slope_factor)
+{
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::SetDepthBias, depth_bias_constant_factor, depth_bias_clamp, depth_bias_slope_factor);
+	}
+
+	std::array<float, 3> depth_bias{depth_bias_constant_factor, depth_bias_clamp, depth_bias_slope_factor};
+
+	if (fixed_dynamic_state.depth_bias_set && fixed_dynamic_state.depth_bias == depth_bias)
+	{
+		return;
+	}
+
+	fixed_dynamic_state.depth_bias_set = true;
+	fixed_dynamic_state.depth_bias     = depth_bias;
+
+	vkCmdSetDepthBias(get_handle(), depth_bias_constant_factor, depth_bias_clamp, depth_bias_slope_factor);
 }
 
 void CommandBuffer::set_blend_constants(const std::array<float, 4> &blend_constants)
 {
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::SetBlendConstants, blend_constants);
+	}
+
+	if (fixed_dynamic_state.blend_constants_set && fixed_dynamic_state.blend_constants == blend_constants)
+	{
+		return;
+	}
+
+	fixed_dynamic_state.blend_constants_set = true;
+	fixed_dynamic_state.blend_constants     = blend_constants;
+
 	vkCmdSetBlendConstants(get_handle(), blend_constants.data());
 }
 
 void CommandBuffer::set_depth_bounds(float min_depth_bounds, float max_depth_bounds)
 {
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::SetDepthBounds, min_depth_bounds, max_depth_bounds);
+	}
+
+	std::array<float, 2> depth_bounds{min_depth_bounds, max_depth_bounds};
+
+	if (fixed_dynamic_state.depth_bounds_set && fixed_dynamic_state.depth_bounds == depth_bounds)
+	{
+		return;
+	}
+
+	fixed_dynamic_state.depth_bounds_set = true;
+	fixed_dynamic_state.depth_bounds     = depth_bounds;
+
 	vkCmdSetDepthBounds(get_handle(), min_depth_bounds, max_depth_bounds);
 }
 
+void CommandBuffer::set_fragment_shading_rate(const VkExtent2D &fragment_size)
+{
+	if (draw_list_record)
+	{
+		draw_list_record->record(DrawListCommand::SetFragmentShadingRate, fragment_size);
+	}
+
+	if (!get_device().is_fragment_shading_rate_enabled())
+	{
+		return;
+	}
+
+	VkExtent2D clamped_size{std::min(std::max(fragment_size.width, 1U), 2U), std::min(std::max(fragment_size.height, 1U), 2U)};
+
+	if (fixed_dynamic_state.fragment_size_set && fixed_dynamic_state.fragment_size.width == clamped_size.width && fixed_dynamic_state.fragment_size.height == clamped_size.height)
+	{
+		return;
+	}
+
+	fixed_dynamic_state.fragment_size_set = true;
+	fixed_dynamic_state.fragment_size     = clamped_size;
+
+	// Neither primitive nor attachment rates are used, the rate of the draw is kept
+	VkFragmentShadingRateCombinerOpKHR combiner_ops[2] = {VK_FRAGMENT_SHADING_RATE_COMBINER_OP_KEEP_KHR, VK_FRAGMENT_SHADING_RATE_COMBINER_OP_KEEP_KHR};
+
+	vkCmdSetFragmentShadingRateKHR(get_handle(), &clamped_size, combiner_ops);
+}
+
+bool CommandBuffer::prepare_graphics_pipeline(bool wait)
+{
+	pipeline_state.set_render_pass(*current_render_pass.render_pass);
+
+	if (graphics_pipeline_binding.bound && graphics_pipeline_binding.hash == pipeline_state.get_hash())
+	{
+		return true;
+	}
+
+	auto &resource_cache = get_device().get_resource_cache();
+
+	if (wait)
+	{
+		resource_cache.request_graphics_pipeline(pipeline_state);
+		return true;
+	}
+
+	if (!resource_cache.request_graphics_pipeline_async(pipeline_state))
+	{
+		pending_pipeline_count++;
+		return false;
+	}
+
+	return true;
+}
+
 void CommandBuffer::draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance)
 {
-	flush_pipeline_state(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	if (draw_list_record)
+	{
+		draw_list_record->register_fetched_vertices(first_vertex + vertex_count, first_instance + instance_count);
+		draw_list_record->record(DrawListCommand::Draw, vertex_count, instance_count, first_vertex, first_instance);
+	}
+
+	if (!flush_pipeline_state(VK_PIPELINE_BIND_POINT_GRAPHICS))
+	{
+		skipped_draw_count++;
+		return;
+	}
 
 	flush_descriptor_state(VK_PIPELINE_BIND_POINT_GRAPHICS);
 
+	counters.draw_calls++;
+
 	vkCmdDraw(get_handle(), vertex_count, instance_count, first_vertex, first_instance);
 }
 
 void CommandBuffer::draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance)
 {
-	flush_pipeline_state(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	if (draw_list_record)
+	{
+		draw_list_record->register_fetched_vertices(to_u32(std::max(vertex_offset, 0)) + 1, first_instance + instance_count);
+		draw_list_record->record(DrawListCommand::DrawIndexed, index_count, instance_count, first_index, vertex_offset, first_instance);
+	}
+
+	if (!flush_pipeline_state(VK_PIPELINE_BIND_POINT_GRAPHICS))
+	{
+		skipped_draw_count++;
+		return;
+	}
 
 	flush_descriptor_state(VK_PIPELINE_BIND_POINT_GRAPHICS);
 
+	counters.draw_calls++;
+
 	vkCmdDrawIndexed(get_handle(), index_count, instance_count, first_index, vertex_offset, first_instance);
 }
 
 void CommandBuffer::draw_indexed_indirect(const core::Buffer &buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride)
 {
-	flush_pipeline_state(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	if (draw_list_record)
+	{
+		draw_list_record->register_buffer_size(buffer.get_handle(), buffer.get_size());
+		draw_list_record->record(DrawListCommand::DrawIndexedIndirect, draw_list_record->get_buffer_index(buffer.get_handle()), offset, draw_count, stride);
+	}
+
+	if (!flush_pipeline_state(VK_PIPELINE_BIND_POINT_GRAPHICS))
+	{
+		skipped_draw_count++;
+		return;
+	}
 
 	flush_descriptor_state(VK_PIPELINE_BIND_POINT_GRAPHICS);
 
+	counters.draw_calls++;
+
+	record_resource_use(buffer.get_handle(), VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
+
 	vkCmdDrawIndexedIndirect(get_handle(), buffer.get_handle(), offset, draw_count, stride);
 }
 
@@ -393,55 +1088,124 @@ void CommandBuffer::dispatch_indirect(const core::Buffer &buffer, VkDeviceSize o
 
 	flush_descriptor_state(VK_PIPELINE_BIND_POINT_COMPUTE);
 
+	record_resource_use(buffer.get_handle(), VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
+
 	vkCmdDispatchIndirect(get_handle(), buffer.get_handle(), offset);
 }
 
 void CommandBuffer::update_buffer(const core::Buffer &buffer, VkDeviceSize offset, const std::vector<uint8_t> &data)
 {
+	record_resource_use(buffer.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+
 	vkCmdUpdateBuffer(get_handle(), buffer.get_handle(), offset, data.size(), data.data());
 }
 
-void CommandBuffer::blit_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageBlit> &regions)
+void CommandBuffer::blit_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageBlit> &regions, VkFilter filter)
 {
+	record_resource_use(src_img.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+	record_resource_use(dst_img.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+
 	vkCmdBlitImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
 	               dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	               to_u32(regions.size()), regions.data(), VK_FILTER_NEAREST);
+	               to_u32(regions.size()), regions.data(), filter);
 }
 
 void CommandBuffer::copy_buffer(const core::Buffer &src_buffer, const core::Buffer &dst_buffer, VkDeviceSize size)
 {
+	record_resource_use(src_buffer.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+	record_resource_use(dst_buffer.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+
 	VkBufferCopy copy_region = {};
 	copy_region.size         = size;
 	vkCmdCopyBuffer(get_handle(), src_buffer.get_handle(), dst_buffer.get_handle(), 1, &copy_region);
 }
 
+void CommandBuffer::copy_buffer(const core::Buffer &src_buffer, const core::Buffer &dst_buffer, const std::vector<VkBufferCopy> &regions)
+{
+	record_resource_use(src_buffer.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+	record_resource_use(dst_buffer.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	vkCmdCopyBuffer(get_handle(), src_buffer.get_handle(), dst_buffer.get_handle(), to_u32(regions.size()), regions.data());
+}
+
 void CommandBuffer::copy_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageCopy> &regions)
 {
+	record_resource_use(src_img.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+	record_resource_use(dst_img.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+
 	vkCmdCopyImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
 	               dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 	               to_u32(regions.size()), regions.data());
 }
 
+void CommandBuffer::resolve_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageResolve> &regions)
+{
+	record_resource_use(src_img.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+	record_resource_use(dst_img.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	vkCmdResolveImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	                  dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+	                  to_u32(regions.size()), regions.data());
+}
+
 void CommandBuffer::copy_buffer_to_image(const core::Buffer &buffer, const core::Image &image, const std::vector<VkBufferImageCopy> &regions)
 {
+	record_resource_use(buffer.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+	record_resource_use(image.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+
 	vkCmdCopyBufferToImage(get_handle(), buffer.get_handle(),
 	                       image.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 	                       to_u32(regions.size()), regions.data());
 }
 
+void CommandBuffer::copy_image_to_buffer(const core::Image &image, const core::Buffer &buffer, const std::vector<VkBufferImageCopy> &regions)
+{
+	record_resource_use(image.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+	record_resource_use(buffer.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	vkCmdCopyImageToBuffer(get_handle(), image.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	                       buffer.get_handle(),
+	                       to_u32(regions.size()), regions.data());
+}
+
 void CommandBuffer::image_memory_barrier(const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier)
+{
+	image_memory_barrier(image_view.get_image(), image_view.get_subresource_range(), memory_barrier);
+}
+
+void CommandBuffer::image_memory_barrier(const core::Image &image, const VkImageSubresourceRange &subresource_range, const ImageMemoryBarrier &memory_barrier)
 {
 	VkImageMemoryBarrier image_memory_barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
-	image_memory_barrier.oldLayout        = memory_barrier.old_layout;
-	image_memory_barrier.newLayout        = memory_barrier.new_layout;
-	image_memory_barrier.image            = image_view.get_image().get_handle();
-	image_memory_barrier.subresourceRange = image_view.get_subresource_range();
-	image_memory_barrier.srcAccessMask    = memory_barrier.src_access_mask;
-	image_memory_barrier.dstAccessMask    = memory_barrier.dst_access_mask;
+	image_memory_barrier.oldLayout           = memory_barrier.old_layout;
+	image_memory_barrier.newLayout           = memory_barrier.new_layout;
+	image_memory_barrier.image               = image.get_handle();
+	image_memory_barrier.subresourceRange    = subresource_range;
+	image_memory_barrier.srcAccessMask       = memory_barrier.src_access_mask;
+	image_memory_barrier.dstAccessMask       = memory_barrier.dst_access_mask;
+	image_memory_barrier.srcQueueFamilyIndex = memory_barrier.old_queue_family;
+	image_memory_barrier.dstQueueFamilyIndex = memory_barrier.new_queue_family;
 
 	VkPipelineStageFlags src_stage_mask = memory_barrier.src_stage_mask;
 	VkPipelineStageFlags dst_stage_mask = memory_barrier.dst_stage_mask;
 
+#if defined(VKB_DEBUG)
+	// Ownership transfers synchronize with another queue, whose uses are unknown
+	if (memory_barrier.old_queue_family == memory_barrier.new_queue_family)
+	{
+		size_t range = 0;
+		hash_combine(range, subresource_range.aspectMask);
+		hash_combine(range, subresource_range.baseMipLevel);
+		hash_combine(range, subresource_range.levelCount);
+		hash_combine(range, subresource_range.baseArrayLayer);
+		hash_combine(range, subresource_range.layerCount);
+
+		barrier_analyzer.record_barrier(reinterpret_cast<uint64_t>(image.get_handle()), range, src_stage_mask, dst_stage_mask,
+		                                memory_barrier.src_access_mask, memory_barrier.dst_access_mask, memory_barrier.old_layout, memory_barrier.new_layout);
+	}
+#endif
+
+	counters.pipeline_barriers++;
+
 	vkCmdPipelineBarrier(
 	    get_handle(),
 	    src_stage_mask,
@@ -453,18 +1217,60 @@ void CommandBuffer::image_memory_barrier(const core::ImageView &image_view, cons
 	    &image_memory_barrier);
 }
 
+void CommandBuffer::attachment_feedback_barrier()
+{
+	assert(current_render_pass.render_pass && "Attachment feedback barriers order the draws of a subpass");
+
+	uint32_t subpass_index = pipeline_state.get_subpass_index();
+
+	if (current_render_pass.render_pass->is_rasterization_order_access(subpass_index))
+	{
+		return;
+	}
+
+	VkMemoryBarrier memory_barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+	memory_barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	memory_barrier.dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+
+	// Matches the dependency core::RenderPass adds from the subpass to itself
+	VkDependencyFlags dependency_flags = VK_DEPENDENCY_BY_REGION_BIT;
+	if (current_render_pass.render_pass->get_view_mask(subpass_index) != 0)
+	{
+		dependency_flags |= VK_DEPENDENCY_VIEW_LOCAL_BIT_KHR;
+	}
+
+	vkCmdPipelineBarrier(get_handle(), VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, dependency_flags,
+	                     1, &memory_barrier, 0, nullptr, 0, nullptr);
+}
+
 void CommandBuffer::buffer_memory_barrier(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size, const BufferMemoryBarrier &memory_barrier)
 {
 	VkBufferMemoryBarrier buffer_memory_barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
-	buffer_memory_barrier.srcAccessMask = memory_barrier.src_access_mask;
-	buffer_memory_barrier.dstAccessMask = memory_barrier.dst_access_mask;
-	buffer_memory_barrier.buffer        = buffer.get_handle();
-	buffer_memory_barrier.offset        = offset;
-	buffer_memory_barrier.size          = size;
+	buffer_memory_barrier.srcAccessMask       = memory_barrier.src_access_mask;
+	buffer_memory_barrier.dstAccessMask       = memory_barrier.dst_access_mask;
+	buffer_memory_barrier.buffer              = buffer.get_handle();
+	buffer_memory_barrier.offset              = offset;
+	buffer_memory_barrier.size                = size;
+	buffer_memory_barrier.srcQueueFamilyIndex = memory_barrier.old_queue_family;
+	buffer_memory_barrier.dstQueueFamilyIndex = memory_barrier.new_queue_family;
 
 	VkPipelineStageFlags src_stage_mask = memory_barrier.src_stage_mask;
 	VkPipelineStageFlags dst_stage_mask = memory_barrier.dst_stage_mask;
 
+#if defined(VKB_DEBUG)
+	if (memory_barrier.old_queue_family == memory_barrier.new_queue_family)
+	{
+		size_t range = 0;
+		hash_combine(range, offset);
+		hash_combine(range, size);
+
+		barrier_analyzer.record_barrier(reinterpret_cast<uint64_t>(buffer.get_handle()), range, src_stage_mask, dst_stage_mask,
+		                                memory_barrier.src_access_mask, memory_barrier.dst_access_mask, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED);
+	}
+#endif
+
+	counters.pipeline_barriers++;
+
 	vkCmdPipelineBarrier(
 	    get_handle(),
 	    src_stage_mask,
@@ -475,38 +1281,179 @@ void CommandBuffer::buffer_memory_barrier(const core::Buffer &buffer, VkDeviceSi
 	    0, nullptr);
 }
 
-void CommandBuffer::flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point)
+void CommandBuffer::reset_query_pool(const core::QueryPool &query_pool, uint32_t first_query, uint32_t query_count)
+{
+	vkCmdResetQueryPool(get_handle(), query_pool.get_handle(), first_query, query_count);
+}
+
+void CommandBuffer::begin_query(const core::QueryPool &query_pool, uint32_t query, VkQueryControlFlags flags)
+{
+	vkCmdBeginQuery(get_handle(), query_pool.get_handle(), query, flags);
+}
+
+void CommandBuffer::end_query(const core::QueryPool &query_pool, uint32_t query)
+{
+	vkCmdEndQuery(get_handle(), query_pool.get_handle(), query);
+}
+
+void CommandBuffer::write_timestamp(VkPipelineStageFlagBits pipeline_stage, const core::QueryPool &query_pool, uint32_t query)
+{
+	vkCmdWriteTimestamp(get_handle(), pipeline_stage, query_pool.get_handle(), query);
+}
+
+#if defined(VKB_DEBUG)
+void CommandBuffer::begin_debug_label(const std::string &name)
+{
+	if (get_device().is_debug_utils_enabled())
+	{
+		VkDebugUtilsLabelEXT label{VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT};
+		label.pLabelName = name.c_str();
+
+		vkCmdBeginDebugUtilsLabelEXT(get_handle(), &label);
+	}
+}
+
+void CommandBuffer::end_debug_label()
+{
+	if (get_device().is_debug_utils_enabled())
+	{
+		vkCmdEndDebugUtilsLabelEXT(get_handle());
+	}
+}
+
+void CommandBuffer::insert_debug_label(const std::string &name)
+{
+	if (get_device().is_debug_utils_enabled())
+	{
+		VkDebugUtilsLabelEXT label{VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT};
+		label.pLabelName = name.c_str();
+
+		vkCmdInsertDebugUtilsLabelEXT(get_handle(), &label);
+	}
+}
+#endif
+
+bool CommandBuffer::flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point)
 {
 	// Create a new pipeline only if the graphics state changed
 	if (!pipeline_state.is_dirty())
 	{
-		return;
+		return true;
 	}
 
-	pipeline_state.clear_dirty();
-
 	// Create and bind pipeline
 	if (pipeline_bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS)
 	{
 		pipeline_state.set_render_pass(*current_render_pass.render_pass);
-		auto &pipeline = get_device().get_resource_cache().request_graphics_pipeline(pipeline_state);
 
-		vkCmdBindPipeline(get_handle(),
-		                  pipeline_bind_point,
-		                  pipeline.get_handle());
+		// The state may have changed and then been set back to the one of the bound pipeline
+		auto hash = pipeline_state.get_hash();
+		if (!graphics_pipeline_binding.bound || graphics_pipeline_binding.hash != hash)
+		{
+			auto pipeline = get_device().get_resource_cache().request_graphics_pipeline_async(pipeline_state);
+
+			// Keep the state dirty, so that the next draw requests the pipeline again
+			if (!pipeline)
+			{
+				return false;
+			}
+
+			vkCmdBindPipeline(get_handle(),
+			                  pipeline_bind_point,
+			                  pipeline->get_handle());
+
+			counters.pipeline_binds++;
+
+			graphics_pipeline_binding.bound = true;
+			graphics_pipeline_binding.hash  = hash;
+		}
+
+		if (pipeline_state.is_extended_dynamic_state())
+		{
+			flush_dynamic_state();
+		}
+
+		// The pipelines expect the shading rate to be set, full rate unless a subpass changed it
+		if (!fixed_dynamic_state.fragment_size_set)
+		{
+			set_fragment_shading_rate({1, 1});
+		}
 	}
 	else if (pipeline_bind_point == VK_PIPELINE_BIND_POINT_COMPUTE)
 	{
-		auto &pipeline = get_device().get_resource_cache().request_compute_pipeline(pipeline_state);
+		auto hash = pipeline_state.get_hash();
+		if (!compute_pipeline_binding.bound || compute_pipeline_binding.hash != hash)
+		{
+			auto &pipeline = get_device().get_resource_cache().request_compute_pipeline(pipeline_state);
+
+			vkCmdBindPipeline(get_handle(),
+			                  pipeline_bind_point,
+			                  pipeline.get_handle());
 
-		vkCmdBindPipeline(get_handle(),
-		                  pipeline_bind_point,
-		                  pipeline.get_handle());
+			counters.pipeline_binds++;
+
+			compute_pipeline_binding.bound = true;
+			compute_pipeline_binding.hash  = hash;
+		}
 	}
 	else
 	{
 		throw "Only graphics and compute pipeline bind points are supported now";
 	}
+
+	pipeline_state.clear_dirty();
+
+	return true;
+}
+
+void CommandBuffer::flush_dynamic_state()
+{
+	const auto &rasterization_state = pipeline_state.get_rasterization_state();
+	const auto &depth_stencil_state = pipeline_state.get_depth_stencil_state();
+
+	bool set = dynamic_state_binding.set;
+
+	if (!set || dynamic_state_binding.cull_mode != rasterization_state.cull_mode)
+	{
+		vkCmdSetCullModeEXT(get_handle(), rasterization_state.cull_mode);
+		dynamic_state_binding.cull_mode = rasterization_state.cull_mode;
+	}
+
+	if (!set || dynamic_state_binding.front_face != rasterization_state.front_face)
+	{
+		vkCmdSetFrontFaceEXT(get_handle(), rasterization_state.front_face);
+		dynamic_state_binding.front_face = rasterization_state.front_face;
+	}
+
+	if (!set || dynamic_state_binding.depth_test_enable != depth_stencil_state.depth_test_enable)
+	{
+		vkCmdSetDepthTestEnableEXT(get_handle(), depth_stencil_state.depth_test_enable);
+		dynamic_state_binding.depth_test_enable = depth_stencil_state.depth_test_enable;
+	}
+
+	if (!set || dynamic_state_binding.depth_write_enable != depth_stencil_state.depth_write_enable)
+	{
+		vkCmdSetDepthWriteEnableEXT(get_handle(), depth_stencil_state.depth_write_enable);
+		dynamic_state_binding.depth_write_enable = depth_stencil_state.depth_write_enable;
+	}
+
+	if (!set || dynamic_state_binding.depth_compare_op != depth_stencil_state.depth_compare_op)
+	{
+		vkCmdSetDepthCompareOpEXT(get_handle(), depth_stencil_state.depth_compare_op);
+		dynamic_state_binding.depth_compare_op = depth_stencil_state.depth_compare_op;
+	}
+
+	dynamic_state_binding.set = true;
+}
+
+void CommandBuffer::invalidate_bound_state()
+{
+	vertex_buffer_bindings    = {};
+	index_buffer_binding      = {};
+	graphics_pipeline_binding = {};
+	compute_pipeline_binding  = {};
+	fixed_dynamic_state       = {};
+	dynamic_state_binding     = {};
 }
 
 void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_point)
@@ -517,7 +1464,7 @@ void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_poi
 
 	const auto &shader_program = pipeline_layout.get_shader_program();
 
-	std::unordered_set<uint32_t> update_descriptor_sets;
+	uint32_t update_set_mask{0};
 
 	// Iterate over the shader sets to check if they have already been bound
 	// If they have, add the set so that the command buffer later updates it
@@ -531,7 +1478,7 @@ void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_poi
 		{
 			if (descriptor_set_layout_it->second->get_handle() != pipeline_layout.get_descriptor_set_layout(descriptor_set_id).get_handle())
 			{
-				update_descriptor_sets.emplace(descriptor_set_id);
+				update_set_mask |= 1u << descriptor_set_id;
 			}
 		}
 	}
@@ -549,134 +1496,298 @@ void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_poi
 		}
 	}
 
-	// Check if a descriptor set needs to be created
-	if (resource_binding_state.is_dirty() || !update_descriptor_sets.empty())
+	// Binding a set with a new descriptor set layout disturbs the sets bound after it, which must be bound again,
+	// while the sets before it stay bound, so resources partitioned by update frequency are rebound from the lowest changed set
+	if (update_set_mask != 0)
 	{
-		resource_binding_state.clear_dirty();
+		uint32_t lowest_set_id = lowest_bit_index(update_set_mask);
 
-		// Iterate over all of the resource sets bound by the command buffer
-		for (auto &resource_set_it : resource_binding_state.get_resource_sets())
-		{
-			uint32_t descriptor_set_id = resource_set_it.first;
-			auto &   resource_set      = resource_set_it.second;
+		update_set_mask |= resource_binding_state.get_set_mask() & ~((2u << lowest_set_id) - 1u);
+	}
+
+	// Only the sets whose resources changed, or bound sets with a new descriptor set layout, need to be flushed
+	uint32_t flush_set_mask = resource_binding_state.get_dirty_set_mask() | (update_set_mask & resource_binding_state.get_set_mask());
+
+	// Create or rebind the descriptor sets that need it
+	for (; flush_set_mask != 0; flush_set_mask &= flush_set_mask - 1)
+	{
+		uint32_t descriptor_set_id = lowest_bit_index(flush_set_mask);
+
+		auto &resource_set = resource_binding_state.get_resource_set(descriptor_set_id);
+
+		bool update_set = (update_set_mask & (1u << descriptor_set_id)) != 0;
 
-			// Don't update resource set if it's not in the update list OR its state hasn't changed
-			if (!resource_set.is_dirty() && (update_descriptor_sets.find(descriptor_set_id) == update_descriptor_sets.end()))
+		// Don't update resource set if it's not in the update list OR its state hasn't changed
+		if (!resource_set.is_dirty() && !update_set)
+		{
+			// Buffers moved within the same buffer only need new dynamic offsets for the bound set
+			if (resource_set.is_offset_dirty() && rebind_dynamic_offsets(pipeline_bind_point, descriptor_set_id, resource_set))
 			{
-				continue;
+				resource_binding_state.clear_dirty(descriptor_set_id);
 			}
 
-			// Clear dirty flag for resource set
-			resource_binding_state.clear_dirty(descriptor_set_id);
-
-			// Skip resource set if a descriptor set layout doesn't exist for it
-			if (!pipeline_layout.has_descriptor_set_layout(descriptor_set_id))
+			if (!resource_set.is_offset_dirty())
 			{
 				continue;
 			}
+		}
 
-			auto &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(descriptor_set_id);
+		// Clear dirty flag for resource set
+		resource_binding_state.clear_dirty(descriptor_set_id);
 
-			// Make descriptor set layout bound for current set
-			descriptor_set_layout_binding_state[descriptor_set_id] = &descriptor_set_layout;
+		// Skip resource set if a descriptor set layout doesn't exist for it
+		if (!pipeline_layout.has_descriptor_set_layout(descriptor_set_id))
+		{
+			continue;
+		}
 
-			BindingMap<VkDescriptorBufferInfo> buffer_infos;
-			BindingMap<VkDescriptorImageInfo>  image_infos;
+		auto &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(descriptor_set_id);
 
-			std::vector<uint32_t> dynamic_offsets;
+		// Make descriptor set layout bound for current set
+		descriptor_set_layout_binding_state[descriptor_set_id] = &descriptor_set_layout;
 
-			// Iterate over all resource bindings
-			for (auto &binding_it : resource_set.get_resource_bindings())
-			{
-				auto  binding_index     = binding_it.first;
-				auto &binding_resources = binding_it.second;
+		BindingMap<VkDescriptorBufferInfo> buffer_infos;
+		BindingMap<VkDescriptorImageInfo>  image_infos;
+
+		ArenaVector<uint32_t> dynamic_offsets{get_frame_arena()};
+
+		// Iterate over the bound resource bindings
+		for (uint32_t binding_mask = resource_set.get_binding_mask(); binding_mask != 0; binding_mask &= binding_mask - 1)
+		{
+			uint32_t binding_index = lowest_bit_index(binding_mask);
+
+			auto &binding_resources = resource_set.get_binding(binding_index);
 
-				// Check if binding exists in the pipeline layout
-				if (auto binding_info = descriptor_set_layout.get_layout_binding(binding_index))
+			// Check if binding exists in the pipeline layout
+			if (auto binding_info = descriptor_set_layout.get_layout_binding(binding_index))
+			{
+				// Iterate over all binding resources
+				for (uint32_t array_element = 0; array_element < to_u32(binding_resources.size()); ++array_element)
 				{
-					// Iterate over all binding resources
-					for (auto &element_it : binding_resources)
+					auto &resource_info = binding_resources[array_element];
+
+					// Pointer references
+					auto &buffer     = resource_info.buffer;
+					auto &sampler    = resource_info.sampler;
+					auto &image_view = resource_info.image_view;
+
+					// Get buffer info
+					if (buffer != nullptr && is_buffer_descriptor_type(binding_info->descriptorType))
 					{
-						auto  array_element = element_it.first;
-						auto &resource_info = element_it.second;
+						VkDescriptorBufferInfo buffer_info{};
 
-						// Pointer references
-						auto &buffer     = resource_info.buffer;
-						auto &sampler    = resource_info.sampler;
-						auto &image_view = resource_info.image_view;
+						buffer_info.buffer = resource_info.buffer->get_handle();
+						buffer_info.offset = resource_info.offset;
+						buffer_info.range  = resource_info.range;
 
-						// Get buffer info
-						if (buffer != nullptr && is_buffer_descriptor_type(binding_info->descriptorType))
+						if (is_dynamic_buffer_descriptor_type(binding_info->descriptorType))
 						{
-							VkDescriptorBufferInfo buffer_info{};
+							dynamic_offsets.push_back(to_u32(buffer_info.offset));
 
-							buffer_info.buffer = resource_info.buffer->get_handle();
-							buffer_info.offset = resource_info.offset;
-							buffer_info.range  = resource_info.range;
+							buffer_info.offset = 0;
+						}
 
-							if (is_dynamic_buffer_descriptor_type(binding_info->descriptorType))
-							{
-								dynamic_offsets.push_back(to_u32(buffer_info.offset));
+						buffer_infos[binding_index][array_element] = buffer_info;
 
-								buffer_info.offset = 0;
-							}
+#if defined(VKB_DEBUG)
+						barrier_analyzer.record_shader_use(reinterpret_cast<uint64_t>(buffer_info.buffer), binding_info->stageFlags);
+#endif
+					}
 
-							buffer_infos[binding_index][array_element] = buffer_info;
-						}
+					// Get image info
+					else if (image_view != nullptr || sampler != VK_NULL_HANDLE)
+					{
+						// Can be null for input attachments
+						VkDescriptorImageInfo image_info{};
+						image_info.sampler   = sampler ? sampler->get_handle() : VK_NULL_HANDLE;
+						image_info.imageView = image_view->get_handle();
 
-						// Get image info
-						else if (image_view != nullptr || sampler != VK_NULL_HANDLE)
+						if (image_view != nullptr)
 						{
-							// Can be null for input attachments
-							VkDescriptorImageInfo image_info{};
-							image_info.sampler   = sampler ? sampler->get_handle() : VK_NULL_HANDLE;
-							image_info.imageView = image_view->get_handle();
-
-							if (image_view != nullptr)
+							// Add image layout info based on descriptor type
+							switch (binding_info->descriptorType)
 							{
-								// Add image layout info based on descriptor type
-								switch (binding_info->descriptorType)
-								{
-									case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-									case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
-										if (is_depth_stencil_format(image_view->get_format()))
-										{
-											image_info.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
-										}
-										else
-										{
-											image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-										}
-										break;
-									case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-										image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-										break;
-
-									default:
-										continue;
-								}
+								case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+								case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+									if (is_depth_stencil_format(image_view->get_format()))
+									{
+										image_info.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+									}
+									else
+									{
+										image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+									}
+									break;
+								case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+									image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+									break;
+
+								default:
+									continue;
 							}
+						}
 
-							image_infos[binding_index][array_element] = std::move(image_info);
+#if defined(VKB_DEBUG)
+						if (image_view != nullptr)
+						{
+							barrier_analyzer.record_shader_use(reinterpret_cast<uint64_t>(image_view->get_image().get_handle()), binding_info->stageFlags);
 						}
+#endif
+
+						image_infos[binding_index][array_element] = std::move(image_info);
 					}
 				}
 			}
+		}
+
+		if (descriptor_set_layout.is_push_descriptor())
+		{
+			push_descriptor_set(pipeline_bind_point, descriptor_set_id, buffer_infos, image_infos);
+			continue;
+		}
+
+		auto &descriptor_set = command_pool.get_render_frame()->request_descriptor_set(descriptor_set_layout, buffer_infos, image_infos, command_pool.get_thread_index(),
+		                                                                              command_pool.get_reset_mode() == ResetMode::Persistent);
+
+		VkDescriptorSet descriptor_set_handle = descriptor_set.get_handle();
+
+		bound_descriptor_sets[descriptor_set_id] = descriptor_set_handle;
+
+		// Bind descriptor set
+		vkCmdBindDescriptorSets(get_handle(),
+		                        pipeline_bind_point,
+		                        pipeline_layout.get_handle(),
+		                        descriptor_set_id,
+		                        1, &descriptor_set_handle,
+		                        to_u32(dynamic_offsets.size()),
+		                        dynamic_offsets.data());
+
+		counters.descriptor_set_binds++;
+	}
+}
+
+FrameArena *CommandBuffer::get_frame_arena()
+{
+	auto render_frame = command_pool.get_render_frame();
+
+	return render_frame ? &render_frame->get_arena(command_pool.get_thread_index()) : nullptr;
+}
+
+bool CommandBuffer::rebind_dynamic_offsets(VkPipelineBindPoint pipeline_bind_point, uint32_t descriptor_set_id, const ResourceSet &resource_set)
+{
+	auto bound_set_it = bound_descriptor_sets.find(descriptor_set_id);
+	auto layout_it    = descriptor_set_layout_binding_state.find(descriptor_set_id);
+
+	if (bound_set_it == bound_descriptor_sets.end() || layout_it == descriptor_set_layout_binding_state.end())
+	{
+		return false;
+	}
 
-			auto &descriptor_set = command_pool.get_render_frame()->request_descriptor_set(descriptor_set_layout, buffer_infos, image_infos, command_pool.get_thread_index());
+	auto &descriptor_set_layout = *layout_it->second;
 
-			VkDescriptorSet descriptor_set_handle = descriptor_set.get_handle();
+	ArenaVector<uint32_t> dynamic_offsets{get_frame_arena()};
+
+	for (uint32_t binding_mask = resource_set.get_binding_mask(); binding_mask != 0; binding_mask &= binding_mask - 1)
+	{
+		uint32_t binding_index = lowest_bit_index(binding_mask);
+
+		auto binding_info = descriptor_set_layout.get_layout_binding(binding_index);
+
+		if (!binding_info)
+		{
+			continue;
+		}
+
+		bool dynamic = is_dynamic_buffer_descriptor_type(binding_info->descriptorType);
+
+		// The offset of a static descriptor is part of the descriptor set
+		if (!dynamic)
+		{
+			if (resource_set.get_offset_dirty_mask() & (1u << binding_index))
+			{
+				return false;
+			}
 
-			// Bind descriptor set
-			vkCmdBindDescriptorSets(get_handle(),
-			                        pipeline_bind_point,
-			                        pipeline_layout.get_handle(),
-			                        descriptor_set_id,
-			                        1, &descriptor_set_handle,
-			                        to_u32(dynamic_offsets.size()),
-			                        dynamic_offsets.data());
+			continue;
+		}
+
+		for (auto &resource_info : resource_set.get_binding(binding_index))
+		{
+			if (resource_info.buffer != nullptr)
+			{
+				dynamic_offsets.push_back(to_u32(resource_info.offset));
+			}
 		}
 	}
+
+	vkCmdBindDescriptorSets(get_handle(),
+	                        pipeline_bind_point,
+	                        pipeline_state.get_pipeline_layout().get_handle(),
+	                        descriptor_set_id,
+	                        1, &bound_set_it->second,
+	                        to_u32(dynamic_offsets.size()),
+	                        dynamic_offsets.data());
+
+	counters.descriptor_set_binds++;
+
+	return true;
+}
+
+void CommandBuffer::push_descriptor_set(VkPipelineBindPoint pipeline_bind_point, uint32_t descriptor_set_id,
+                                        const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos)
+{
+	const auto &pipeline_layout       = pipeline_state.get_pipeline_layout();
+	auto &      descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(descriptor_set_id);
+
+	ArenaVector<VkWriteDescriptorSet> write_descriptor_sets{get_frame_arena()};
+
+	for (auto &binding_it : buffer_infos)
+	{
+		auto binding_info = descriptor_set_layout.get_layout_binding(binding_it.first);
+
+		for (auto &element_it : binding_it.second)
+		{
+			VkWriteDescriptorSet write_descriptor_set{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+
+			write_descriptor_set.dstBinding      = binding_it.first;
+			write_descriptor_set.dstArrayElement = element_it.first;
+			write_descriptor_set.descriptorCount = 1;
+			write_descriptor_set.descriptorType  = binding_info->descriptorType;
+			write_descriptor_set.pBufferInfo     = &element_it.second;
+
+			write_descriptor_sets.push_back(write_descriptor_set);
+		}
+	}
+
+	for (auto &binding_it : image_infos)
+	{
+		auto binding_info = descriptor_set_layout.get_layout_binding(binding_it.first);
+
+		for (auto &element_it : binding_it.second)
+		{
+			VkWriteDescriptorSet write_descriptor_set{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+
+			write_descriptor_set.dstBinding      = binding_it.first;
+			write_descriptor_set.dstArrayElement = element_it.first;
+			write_descriptor_set.descriptorCount = 1;
+			write_descriptor_set.descriptorType  = binding_info->descriptorType;
+			write_descriptor_set.pImageInfo      = &element_it.second;
+
+			write_descriptor_sets.push_back(write_descriptor_set);
+		}
+	}
+
+	// A pushed set has no handle to rebind with new dynamic offsets, the next change pushes it again
+	bound_descriptor_sets.erase(descriptor_set_id);
+
+	vkCmdPushDescriptorSetKHR(get_handle(),
+	                          pipeline_bind_point,
+	                          pipeline_layout.get_handle(),
+	                          descriptor_set_id,
+	                          to_u32(write_descriptor_sets.size()),
+	                          write_descriptor_sets.data());
+
+	counters.descriptor_set_binds++;
 }
 
 const CommandBuffer::State CommandBuffer::get_state() const
@@ -694,6 +1805,26 @@ const uint32_t CommandBuffer::get_current_subpass_index() const
 	return pipeline_state.get_subpass_index();
 }
 
+uint32_t CommandBuffer::get_skipped_draw_count() const
+{
+	return skipped_draw_count;
+}
+
+uint32_t CommandBuffer::get_pending_pipeline_count() const
+{
+	return pending_pipeline_count;
+}
+
+void CommandBuffer::set_draw_list_record(DrawListRecord *record)
+{
+	draw_list_record = record;
+}
+
+const CommandBufferCounters &CommandBuffer::get_counters() const
+{
+	return counters;
+}
+
 VkResult CommandBuffer::reset(ResetMode reset_mode)
 {
 	VkResult result = VK_SUCCESS;
@@ -702,7 +1833,7 @@ VkResult CommandBuffer::reset(ResetMode reset_mode)
 
 	state = State::Initial;
 
-	if (reset_mode == ResetMode::ResetIndividually)
+	if (reset_mode == ResetMode::ResetIndividually || reset_mode == ResetMode::Persistent)
 	{
 		result = vkResetCommandBuffer(handle, VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
 	}
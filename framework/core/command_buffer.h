@@ -22,12 +22,16 @@
 
 #include <list>
 
+#include "common/error.h"
 #include "common/helpers.h"
 #include "common/vk_common.h"
+#include "core/barrier_analyzer.h"
 #include "core/buffer.h"
 #include "core/image.h"
 #include "core/image_view.h"
+#include "core/query_pool.h"
 #include "core/sampler.h"
+#include "frame_arena.h"
 #include "rendering/pipeline_state.h"
 #include "rendering/render_target.h"
 #include "resource_binding_state.h"
@@ -36,12 +40,45 @@ namespace vkb
 {
 class CommandPool;
 class DescriptorSet;
+class DrawListRecord;
 class Framebuffer;
 class Pipeline;
 class PipelineLayout;
 class PipelineState;
 class RenderTarget;
 class Subpass;
+struct SubpassInfo;
+
+/**
+ * @brief Number of state changes and draw calls recorded into command buffers,
+ *        and an estimate of the external memory traffic of their render passes
+ */
+struct CommandBufferCounters
+{
+	uint64_t pipeline_binds{0};
+
+	uint64_t descriptor_set_binds{0};
+
+	uint64_t vertex_buffer_binds{0};
+
+	/// Draw commands recorded, an indirect draw counting as one whatever number of draws it reads
+	uint64_t draw_calls{0};
+
+	/// Bytes of the attachments loaded when their render pass begins, as if their formats were uncompressed
+	uint64_t attachment_read_bytes{0};
+
+	/// Bytes of the attachments stored when their render pass ends, as if their formats were uncompressed
+	uint64_t attachment_write_bytes{0};
+
+	uint64_t pipeline_barriers{0};
+
+	/// Barriers flagged by the barrier analyzer of debug builds, see BarrierAnalyzer::Summary
+	uint64_t early_destination_barriers{0};
+
+	uint64_t late_source_barriers{0};
+
+	uint64_t redundant_barriers{0};
+};
 
 /**
  * @brief Helper class to manage and record a command buffer, building and
@@ -55,6 +92,9 @@ class CommandBuffer
 		ResetPool,
 		ResetIndividually,
 		AlwaysAllocate,
+		/// Buffers are reset individually by their owner when re-recorded, resetting their pool leaves them
+		/// untouched so that they can be executed again in later frames
+		Persistent,
 	};
 
 	enum class State
@@ -73,6 +113,9 @@ class CommandBuffer
 		const RenderPass *render_pass;
 
 		const Framebuffer *framebuffer;
+
+		/// Region of the render target rendered to, which the scissors are clamped to
+		VkRect2D render_area;
 	};
 
 	CommandBuffer(CommandPool &command_pool, VkCommandBufferLevel level);
@@ -93,7 +136,14 @@ class CommandBuffer
 
 	bool is_recording() const;
 
-	std::vector<uint8_t> stored_push_constants;
+	/// Size of the push constant storage, the minimum limit guaranteed by Vulkan
+	static constexpr uint32_t MAX_PUSH_CONSTANT_SIZE = 128;
+
+	/// Vertex buffer bindings tracked to skip redundant binds, the minimum limit guaranteed by Vulkan
+	static constexpr uint32_t MAX_VERTEX_BINDINGS = 16;
+
+	/// Viewports and scissors tracked to skip redundant sets, the limit of most multi-viewport devices
+	static constexpr uint32_t MAX_VIEWPORTS = 16;
 
 	/**
 	 * @brief Sets the command buffer so that it is ready for recording
@@ -105,13 +155,30 @@ class CommandBuffer
 	 */
 	VkResult begin(VkCommandBufferUsageFlags flags, CommandBuffer *primary_cmd_buf = nullptr);
 
+	/**
+	 * @brief Sets a secondary command buffer ready for recording a given subpass of the render pass
+	 *        of the primary command buffer, which may not have reached it yet, so that the subpasses
+	 *        of a render pass can be recorded concurrently
+	 * @param flags Usage behavior for the command buffer
+	 * @param primary_cmd_buf Primary command buffer inside the render pass
+	 * @param subpass_index Index of the subpass the commands are executed in
+	 * @return Whether it succeded or not
+	 */
+	VkResult begin(VkCommandBufferUsageFlags flags, CommandBuffer *primary_cmd_buf, uint32_t subpass_index);
+
 	VkResult end();
 
 	void clear(VkClearAttachment info, VkClearRect rect);
 
 	void begin_render_pass(const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values, const std::vector<std::unique_ptr<Subpass>> &subpasses, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 
-	void next_subpass();
+	/**
+	 * @brief Begins a render pass from the attachments of its subpasses, e.g. when replaying a draw list
+	 * @param debug_name Name of the debug label of the render pass
+	 */
+	void begin_render_pass(const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values, const std::vector<SubpassInfo> &subpass_infos, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE, const std::string &debug_name = "Render pass");
+
+	void next_subpass(VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 
 	void execute_commands(CommandBuffer &secondary_command_buffer);
 
@@ -126,6 +193,8 @@ class CommandBuffer
 
 	void set_specialization_constant(uint32_t constant_id, const std::vector<uint8_t> &data);
 
+	void set_specialization_constant(uint32_t constant_id, const uint8_t *data, uint32_t size);
+
 	/**
 	 * @brief Stores additional data which is prepended to the
 	 *        values passed to the push_constants_accumulated() function
@@ -136,24 +205,26 @@ class CommandBuffer
 
 	void set_push_constants(const std::vector<uint8_t> &values);
 
+	void set_push_constants(const uint8_t *data, uint32_t size);
+
 	void push_constants_accumulated(const std::vector<uint8_t> &values, uint32_t offset = 0);
 
+	void push_constants_accumulated(const uint8_t *data, uint32_t size, uint32_t offset = 0);
+
 	template <typename T>
 	void push_constants_accumulated(const T &value, uint32_t offset = 0)
 	{
-		push_constants_accumulated(std::vector<uint8_t>{reinterpret_cast<const uint8_t *>(&value),
-		                                                reinterpret_cast<const uint8_t *>(&value) + sizeof(T)},
-		                           offset);
+		push_constants_accumulated(reinterpret_cast<const uint8_t *>(&value), to_u32(sizeof(T)), offset);
 	}
 
 	void push_constants(uint32_t offset, const std::vector<uint8_t> &values);
 
+	void push_constants(uint32_t offset, const uint8_t *data, uint32_t size);
+
 	template <typename T>
 	void push_constants(uint32_t offset, const T &value)
 	{
-		push_constants(offset,
-		               std::vector<uint8_t>{reinterpret_cast<const uint8_t *>(&value),
-		                                    reinterpret_cast<const uint8_t *>(&value) + sizeof(T)});
+		push_constants(offset, reinterpret_cast<const uint8_t *>(&value), to_u32(sizeof(T)));
 	}
 
 	void bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element);
@@ -164,6 +235,14 @@ class CommandBuffer
 
 	void bind_vertex_buffers(uint32_t first_binding, const std::vector<std::reference_wrapper<const vkb::core::Buffer>> &buffers, const std::vector<VkDeviceSize> &offsets);
 
+	/**
+	 * @brief Binds vertex buffers from arrays of handles and offsets, without allocating
+	 *        The bind is skipped if all the bindings already use the same buffers and offsets.
+	 */
+	void bind_vertex_buffers(uint32_t first_binding, uint32_t binding_count, const VkBuffer *buffers, const VkDeviceSize *offsets);
+
+	void bind_vertex_buffer(uint32_t binding, const core::Buffer &buffer, VkDeviceSize offset);
+
 	void bind_index_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkIndexType index_type);
 
 	void set_viewport_state(const ViewportState &state_info);
@@ -182,8 +261,19 @@ class CommandBuffer
 
 	void set_viewport(uint32_t first_viewport, const std::vector<VkViewport> &viewports);
 
+	/**
+	 * @brief Sets viewports from an array, skipped if they are all already set
+	 */
+	void set_viewport(uint32_t first_viewport, uint32_t viewport_count, const VkViewport *viewports);
+
 	void set_scissor(uint32_t first_scissor, const std::vector<VkRect2D> &scissors);
 
+	/**
+	 * @brief Sets scissors from an array, skipped if they are all already set
+	 *        Inside of a render pass restricted to a region of its render target, they are clamped to it
+	 */
+	void set_scissor(uint32_t first_scissor, uint32_t scissor_count, const VkRect2D *scissors);
+
 	void set_line_width(float line_width);
 
 	void set_depth_bias(float depth_bias_constant_factor, float depth_bias_clamp, float depth_bias_slope_factor);
@@ -192,6 +282,21 @@ class CommandBuffer
 
 	void set_depth_bounds(float min_depth_bounds, float max_depth_bounds);
 
+	/**
+	 * @brief Sets the size of the blocks of pixels shaded by a single fragment shader invocation in the next draws
+	 *        Ignored unless the device enabled fragment shading rates, which fall back to full rate.
+	 *        Sizes are clamped to 2x2, the largest one every implementation supports.
+	 * @param fragment_size Width and height of the blocks, 1x1 for full rate shading
+	 */
+	void set_fragment_shading_rate(const VkExtent2D &fragment_size);
+
+	/**
+	 * @brief Requests the graphics pipeline of the current state ahead of the next draw
+	 * @param wait Whether to compile a missing pipeline on this thread, even with asynchronous compilation
+	 * @return False if the pipeline is still being compiled asynchronously
+	 */
+	bool prepare_graphics_pipeline(bool wait);
+
 	void draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance);
 
 	void draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance);
@@ -204,20 +309,99 @@ class CommandBuffer
 
 	void update_buffer(const core::Buffer &buffer, VkDeviceSize offset, const std::vector<uint8_t> &data);
 
-	void blit_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageBlit> &regions);
+	void blit_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageBlit> &regions, VkFilter filter = VK_FILTER_NEAREST);
 
 	void copy_buffer(const core::Buffer &src_buffer, const core::Buffer &dst_buffer, VkDeviceSize size);
 
+	void copy_buffer(const core::Buffer &src_buffer, const core::Buffer &dst_buffer, const std::vector<VkBufferCopy> &regions);
+
 	void copy_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageCopy> &regions);
 
+	void resolve_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageResolve> &regions);
+
 	void copy_buffer_to_image(const core::Buffer &buffer, const core::Image &image, const std::vector<VkBufferImageCopy> &regions);
 
+	/**
+	 * @brief Copies regions of an image in the VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL layout to a buffer
+	 */
+	void copy_image_to_buffer(const core::Image &image, const core::Buffer &buffer, const std::vector<VkBufferImageCopy> &regions);
+
 	void image_memory_barrier(const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier);
 
+	/**
+	 * @brief Records a barrier on a subset of an image, e.g. a single mip level
+	 */
+	void image_memory_barrier(const core::Image &image, const VkImageSubresourceRange &subresource_range, const ImageMemoryBarrier &memory_barrier);
+
 	void buffer_memory_barrier(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size, const BufferMemoryBarrier &memory_barrier);
 
+	/**
+	 * @brief Makes the color attachment writes of the previous draws of a subpass visible to the input attachment
+	 *        reads of the next draws, in a subpass reading the color attachments it writes. Nothing is recorded
+	 *        if the subpass reads its attachments in rasterization order, as the draws are then already ordered.
+	 */
+	void attachment_feedback_barrier();
+
+	void reset_query_pool(const core::QueryPool &query_pool, uint32_t first_query, uint32_t query_count);
+
+	void begin_query(const core::QueryPool &query_pool, uint32_t query, VkQueryControlFlags flags);
+
+	void end_query(const core::QueryPool &query_pool, uint32_t query);
+
+	void write_timestamp(VkPipelineStageFlagBits pipeline_stage, const core::QueryPool &query_pool, uint32_t query);
+
+	/**
+	 * @brief Opens a labelled region of commands for graphics debuggers and profilers,
+	 *        which must be closed in the same command buffer. Labels are compiled out in release builds
+	 * @param name Name of the region
+	 */
+#if defined(VKB_DEBUG)
+	void begin_debug_label(const std::string &name);
+
+	void end_debug_label();
+
+	/**
+	 * @brief Inserts a single label between the commands
+	 */
+	void insert_debug_label(const std::string &name);
+#else
+	void begin_debug_label(const std::string &)
+	{}
+
+	void end_debug_label()
+	{}
+
+	void insert_debug_label(const std::string &)
+	{}
+#endif
+
 	const State get_state() const;
 
+	/**
+	 * @return Number of draws skipped since the command buffer began, as their pipeline was still compiling
+	 */
+	uint32_t get_skipped_draw_count() const;
+
+	/**
+	 * @return Number of calls to prepare_graphics_pipeline() since the command buffer began that found their pipeline still compiling
+	 */
+	uint32_t get_pending_pipeline_count() const;
+
+	/**
+	 * @return Binds and draw calls recorded since the command buffer began, added to the device counters when it ends
+	 */
+	const CommandBufferCounters &get_counters() const;
+
+	const RenderPassBinding &get_current_render_pass() const;
+
+	/**
+	 * @brief Writes the render passes, binds, state sets and draws recorded from now on into a draw list,
+	 *        until set back to nullptr. The commands of executed secondary command buffers are not written
+	 */
+	void set_draw_list_record(DrawListRecord *record);
+
+	const uint32_t get_current_subpass_index() const;
+
 	/**
 	 * @brief Reset the command buffer to a state where it can be recorded to
 	 * @param reset_mode How to reset the buffer, should match the one used by the pool to allocate it
@@ -233,7 +417,7 @@ class CommandBuffer
 
 	VkCommandBuffer handle{VK_NULL_HANDLE};
 
-	RenderPassBinding current_render_pass;
+	RenderPassBinding current_render_pass{};
 
 	PipelineState pipeline_state;
 
@@ -241,27 +425,150 @@ class CommandBuffer
 
 	std::unordered_map<uint32_t, DescriptorSetLayout *> descriptor_set_layout_binding_state;
 
-	const RenderPassBinding &get_current_render_pass() const;
+	/// Descriptor set last bound for each set index, rebound with new dynamic offsets when only those changed
+	std::unordered_map<uint32_t, VkDescriptorSet> bound_descriptor_sets;
 
-	const uint32_t get_current_subpass_index() const;
+	/// Data prepended to accumulated push constants, stored inline to avoid allocations per draw
+	std::array<uint8_t, MAX_PUSH_CONSTANT_SIZE> stored_push_constants{};
+
+	uint32_t stored_push_constant_size{0};
+
+	/// Buffer and offset last bound to each vertex input binding, to skip redundant binds
+	std::array<std::pair<VkBuffer, VkDeviceSize>, MAX_VERTEX_BINDINGS> vertex_buffer_bindings{};
+
+	struct
+	{
+		VkBuffer     buffer{VK_NULL_HANDLE};
+		VkDeviceSize offset{0};
+		VkIndexType  index_type{VK_INDEX_TYPE_MAX_ENUM};
+	} index_buffer_binding;
+
+	/// Hash of the pipeline state last bound to each bind point, to skip rebinding the same pipeline
+	struct PipelineBinding
+	{
+		bool        bound{false};
+		std::size_t hash{0U};
+	};
+
+	PipelineBinding graphics_pipeline_binding;
+
+	PipelineBinding compute_pipeline_binding;
+
+	uint32_t skipped_draw_count{0};
+
+	uint32_t pending_pipeline_count{0};
+
+	CommandBufferCounters counters;
+
+	DrawListRecord *draw_list_record{nullptr};
+
+	/// Dynamic states last set, to skip redundant sets
+	struct
+	{
+		std::array<VkViewport, MAX_VIEWPORTS> viewports;
+		std::array<VkRect2D, MAX_VIEWPORTS>   scissors;
+
+		/// Bit mask of the viewports and scissors set
+		uint32_t viewport_mask{0};
+		uint32_t scissor_mask{0};
+
+		bool                 line_width_set{false};
+		float                line_width{0.0f};
+		bool                 depth_bias_set{false};
+		std::array<float, 3> depth_bias{};
+		bool                 blend_constants_set{false};
+		std::array<float, 4> blend_constants{};
+		bool                 depth_bounds_set{false};
+		std::array<float, 2> depth_bounds{};
+		bool                 fragment_size_set{false};
+		VkExtent2D           fragment_size{};
+	} fixed_dynamic_state;
+
+	/// Extended dynamic states last set, to only set them again when they change
+	struct
+	{
+		bool            set{false};
+		VkCullModeFlags cull_mode{VK_CULL_MODE_NONE};
+		VkFrontFace     front_face{VK_FRONT_FACE_COUNTER_CLOCKWISE};
+		VkBool32        depth_test_enable{VK_FALSE};
+		VkBool32        depth_write_enable{VK_FALSE};
+		VkCompareOp     depth_compare_op{VK_COMPARE_OP_NEVER};
+	} dynamic_state_binding;
+
+	/**
+	 * @brief Sets the extended dynamic states of the graphics pipeline state that changed since last set
+	 */
+	void flush_dynamic_state();
+
+	/**
+	 * @brief Records the scissors set in a range, clamped to the render area of the current render pass
+	 */
+	void apply_scissors(uint32_t first_scissor, uint32_t scissor_count);
+
+	/**
+	 * @brief Forgets the bound buffers, pipelines and dynamic states, which are undefined
+	 *        when recording begins and after executing secondary command buffers
+	 */
+	void invalidate_bound_state();
 
 	/**
 	 * @brief Flush the piplines state
+	 * @return False if the graphics pipeline is still being compiled asynchronously, in which case the draw is skipped
 	 */
-	void flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point);
+	bool flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point);
 
 	/**
 	 * @brief Flush the descriptor set state
 	 */
 	void flush_descriptor_state(VkPipelineBindPoint pipeline_bind_point);
+
+	/**
+	 * @brief Rebinds the descriptor set last bound at a set index with the current dynamic offsets
+	 * @return False if there is no such set or a buffer moved within a static descriptor,
+	 *         in which case a new descriptor set is needed
+	 */
+	bool rebind_dynamic_offsets(VkPipelineBindPoint pipeline_bind_point, uint32_t descriptor_set_id, const ResourceSet &resource_set);
+
+	/**
+	 * @brief Writes the descriptors of a set created for push descriptors into the command buffer,
+	 *        without allocating a descriptor set from the render frame
+	 */
+	void push_descriptor_set(VkPipelineBindPoint pipeline_bind_point, uint32_t descriptor_set_id,
+	                         const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos);
+
+	/**
+	 * @return The arena of the frame and thread of the command pool, for data local to a command,
+	 *         nullptr if the pool belongs to no frame
+	 */
+	FrameArena *get_frame_arena();
+
+	/**
+	 * @brief Records the stages of a command using a resource for the barrier analyzer of debug builds
+	 * @param handle Handle of the image or buffer
+	 */
+	template <class T>
+	void record_resource_use(T handle, VkPipelineStageFlags stage_mask);
+
+#if defined(VKB_DEBUG)
+	BarrierAnalyzer barrier_analyzer;
+#endif
 };
 
+template <class T>
+inline void CommandBuffer::record_resource_use(T handle, VkPipelineStageFlags stage_mask)
+{
+#if defined(VKB_DEBUG)
+	barrier_analyzer.record_use(reinterpret_cast<uint64_t>(handle), stage_mask);
+#else
+	(void) handle;
+	(void) stage_mask;
+#endif
+}
+
 template <class T>
 inline void CommandBuffer::set_push_constants(const T &data)
 {
-	set_push_constants(
-	    {reinterpret_cast<const uint8_t *>(&data),
-	     reinterpret_cast<const uint8_t *>(&data) + sizeof(T)});
+	set_push_constants(reinterpret_cast<const uint8_t *>(&data), to_u32(sizeof(T)));
 }
 
 template <>
@@ -269,17 +576,13 @@ inline void CommandBuffer::set_push_constants<bool>(const bool &data)
 {
 	uint32_t value = to_u32(data);
 
-	set_push_constants(
-	    {reinterpret_cast<const uint8_t *>(&value),
-	     reinterpret_cast<const uint8_t *>(&value) + sizeof(std::uint32_t)});
+	set_push_constants(reinterpret_cast<const uint8_t *>(&value), to_u32(sizeof(std::uint32_t)));
 }
 
 template <class T>
 inline void CommandBuffer::set_specialization_constant(uint32_t constant_id, const T &data)
 {
-	set_specialization_constant(constant_id,
-	                            {reinterpret_cast<const uint8_t *>(&data),
-	                             reinterpret_cast<const uint8_t *>(&data) + sizeof(T)});
+	set_specialization_constant(constant_id, reinterpret_cast<const uint8_t *>(&data), to_u32(sizeof(T)));
 }
 
 template <>
@@ -287,9 +590,6 @@ inline void CommandBuffer::set_specialization_constant<bool>(std::uint32_t const
 {
 	uint32_t value = to_u32(data);
 
-	set_specialization_constant(
-	    constant_id,
-	    {reinterpret_cast<const uint8_t *>(&value),
-	     reinterpret_cast<const uint8_t *>(&value) + sizeof(std::uint32_t)});
+	set_specialization_constant(constant_id, reinterpret_cast<const uint8_t *>(&value), to_u32(sizeof(std::uint32_t)));
 }
 }        // namespace vkb
@@ -36,6 +36,7 @@ CommandPool::CommandPool(Device &d, uint32_t queue_family_index, RenderFrame *re
 	{
 		case CommandBuffer::ResetMode::ResetIndividually:
 		case CommandBuffer::ResetMode::AlwaysAllocate:
+		case CommandBuffer::ResetMode::Persistent:
 			flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 			break;
 		case CommandBuffer::ResetMode::ResetPool:
@@ -150,6 +151,11 @@ VkResult CommandPool::reset_pool()
 
 			break;
 		}
+		case CommandBuffer::ResetMode::Persistent:
+		{
+			// Persistent command buffers are kept by their owner and reset individually when re-recorded
+			break;
+		}
 		default:
 			throw std::runtime_error("Unknown reset mode for command pools");
 	}
@@ -20,65 +20,79 @@
 
 #include "descriptor_pool.h"
 
+#include <numeric>
+
 #include "common/error.h"
 #include "descriptor_set_layout.h"
 #include "device.h"
 
 namespace vkb
 {
+const uint32_t DescriptorPool::MAX_SETS_PER_POOL;
+
+const uint32_t DescriptorPool::MAX_GROWN_SETS_PER_POOL;
+
+namespace
+{
+inline uint32_t next_power_of_two(uint32_t value)
+{
+	uint32_t result = 1;
+
+	while (result < value)
+	{
+		result <<= 1;
+	}
+
+	return result;
+}
+}        // namespace
+
 DescriptorPool::DescriptorPool(Device &                   device,
                                const DescriptorSetLayout &descriptor_set_layout,
                                uint32_t                   pool_size) :
     device{device},
-    descriptor_set_layout{&descriptor_set_layout}
+    descriptor_set_layout{&descriptor_set_layout},
+    pool_max_sets{pool_size}
 {
-	const auto &bindings = descriptor_set_layout.get_bindings();
-
-	std::map<VkDescriptorType, std::uint32_t> descriptor_type_counts;
+	assert(pool_size > 0 && "Descriptor pool size must be greater than zero");
 
 	// Count each type of descriptor set
-	for (auto &binding : bindings)
+	for (auto &binding : descriptor_set_layout.get_bindings())
 	{
 		descriptor_type_counts[binding.descriptorType] += binding.descriptorCount;
 	}
-
-	// Allocate pool sizes array
-	pool_sizes.resize(descriptor_type_counts.size());
-
-	auto pool_size_it = pool_sizes.begin();
-
-	// Fill pool size for each descriptor type count multiplied by the pool size
-	for (auto &it : descriptor_type_counts)
-	{
-		pool_size_it->type = it.first;
-
-		pool_size_it->descriptorCount = it.second * pool_size;
-
-		++pool_size_it;
-	}
-
-	pool_max_sets = pool_size;
 }
 
 DescriptorPool::~DescriptorPool()
 {
-	// Destroy all descriptor pools
-	for (auto pool : pools)
-	{
-		vkDestroyDescriptorPool(device.get_handle(), pool, nullptr);
-	}
+	destroy_pools();
 }
 
 void DescriptorPool::reset()
 {
-	// Reset all descriptor pools
-	for (auto pool : pools)
+	uint32_t allocated_sets = get_allocated_set_count();
+
+	if (pools.size() > 1)
 	{
-		vkResetDescriptorPool(device.get_handle(), pool, 0);
+		// The last usage did not fit in one pool, replace them with one that does
+		destroy_pools();
+
+		pool_max_sets = std::min(next_power_of_two(allocated_sets), MAX_GROWN_SETS_PER_POOL);
+
+		create_pool(pool_max_sets);
+	}
+	else
+	{
+		// Reset all descriptor pools
+		for (auto pool : pools)
+		{
+			vkResetDescriptorPool(device.get_handle(), pool, 0);
+		}
+
+		// Clear internal tracking of descriptor set allocations
+		std::fill(pool_sets_count.begin(), pool_sets_count.end(), 0);
 	}
 
-	// Clear internal tracking of descriptor set allocations
-	std::fill(pool_sets_count.begin(), pool_sets_count.end(), 0);
 	set_pool_mapping.clear();
 
 	// Reset the pool index from which descriptor sets are allocated
@@ -127,6 +141,8 @@ VkDescriptorSet DescriptorPool::allocate()
 	// Store mapping between the descriptor set and the pool
 	set_pool_mapping.emplace(handle, pool_index);
 
+	device.add_descriptor_set_allocation();
+
 	return handle;
 }
 
@@ -157,38 +173,81 @@ VkResult DescriptorPool::free(VkDescriptorSet descriptor_set)
 	return VK_SUCCESS;
 }
 
-std::uint32_t DescriptorPool::find_available_pool(std::uint32_t search_index)
+uint32_t DescriptorPool::get_allocated_set_count() const
 {
-	// Create a new pool
-	if (pools.size() <= search_index)
+	return std::accumulate(pool_sets_count.begin(), pool_sets_count.end(), 0U);
+}
+
+size_t DescriptorPool::get_pool_count() const
+{
+	return pools.size();
+}
+
+void DescriptorPool::create_pool(uint32_t max_sets)
+{
+	// Fill pool size for each descriptor type count multiplied by the pool size
+	std::vector<VkDescriptorPoolSize> pool_sizes;
+
+	for (auto &it : descriptor_type_counts)
+	{
+		pool_sizes.push_back({it.first, it.second * max_sets});
+	}
+
+	VkDescriptorPoolCreateInfo create_info{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+
+	// Idle descriptor sets are freed individually when evicted from the frame caches
+	create_info.flags         = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+	create_info.poolSizeCount = to_u32(pool_sizes.size());
+	create_info.pPoolSizes    = pool_sizes.data();
+	create_info.maxSets       = max_sets;
+
+	VkDescriptorPool handle = VK_NULL_HANDLE;
+
+	// Create the Vulkan descriptor pool
+	auto result = vkCreateDescriptorPool(device.get_handle(), &create_info, nullptr, &handle);
+
+	if (result != VK_SUCCESS)
 	{
-		VkDescriptorPoolCreateInfo create_info{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+		throw VulkanException{result, "Cannot create DescriptorPool"};
+	}
 
-		// We do not set FREE_DESCRIPTOR_SET_BIT as we do not need to free individual descriptor sets
-		create_info.flags         = 0;
-		create_info.poolSizeCount = to_u32(pool_sizes.size());
-		create_info.pPoolSizes    = pool_sizes.data();
-		create_info.maxSets       = pool_max_sets;
+	// Store internally the Vulkan handle
+	pools.push_back(handle);
 
-		VkDescriptorPool handle = VK_NULL_HANDLE;
+	pools_max_sets.push_back(max_sets);
+
+	// Add set count for the descriptor pool
+	pool_sets_count.push_back(0);
+}
+
+void DescriptorPool::destroy_pools()
+{
+	// Destroy all descriptor pools
+	for (auto pool : pools)
+	{
+		vkDestroyDescriptorPool(device.get_handle(), pool, nullptr);
+	}
 
-		// Create the Vulkan descriptor pool
-		auto result = vkCreateDescriptorPool(device.get_handle(), &create_info, nullptr, &handle);
+	pools.clear();
+	pools_max_sets.clear();
+	pool_sets_count.clear();
+}
 
-		if (result != VK_SUCCESS)
+std::uint32_t DescriptorPool::find_available_pool(std::uint32_t search_index)
+{
+	// Create a new pool, twice as large as the previous one
+	if (pools.size() <= search_index)
+	{
+		if (!pools.empty())
 		{
-			return VK_NULL_HANDLE;
+			pool_max_sets = std::max(pools_max_sets.back(), std::min(pools_max_sets.back() * 2, MAX_GROWN_SETS_PER_POOL));
 		}
 
-		// Store internally the Vulkan handle
-		pools.push_back(handle);
-
-		// Add set count for the descriptor pool
-		pool_sets_count.push_back(0);
+		create_pool(std::max(pool_max_sets, 1U));
 
 		return search_index;
 	}
-	else if (pool_sets_count[search_index] < pool_max_sets)
+	else if (pool_sets_count[search_index] < pools_max_sets[search_index])
 	{
 		return search_index;
 	}
@@ -31,13 +31,18 @@ class Device;
 class DescriptorSetLayout;
 
 /**
- * @brief Manages an array of fixed size VkDescriptorPool and is able to allocate descriptor sets
+ * @brief Manages an array of VkDescriptorPool and is able to allocate descriptor sets.
+ *        Each new pool doubles the capacity of the previous one up to MAX_GROWN_SETS_PER_POOL,
+ *        and on reset the pools are resized to fit the number of sets used since the last reset,
+ *        so that a steady workload ends up served by a single pool.
  */
 class DescriptorPool
 {
   public:
 	static const uint32_t MAX_SETS_PER_POOL = 16;
 
+	static const uint32_t MAX_GROWN_SETS_PER_POOL = 1024;
+
 	DescriptorPool(Device &                   device,
 	               const DescriptorSetLayout &descriptor_set_layout,
 	               uint32_t                   pool_size = MAX_SETS_PER_POOL);
@@ -52,6 +57,10 @@ class DescriptorPool
 
 	DescriptorPool &operator=(DescriptorPool &&) = delete;
 
+	/**
+	 * @brief Resets all the pools. If the sets allocated since the last reset
+	 *        overflowed into several pools, they are replaced by a single pool sized for that usage
+	 */
 	void reset();
 
 	const DescriptorSetLayout &get_descriptor_set_layout() const;
@@ -62,20 +71,33 @@ class DescriptorPool
 
 	VkResult free(VkDescriptorSet descriptor_set);
 
+	/**
+	 * @return The number of descriptor sets currently allocated
+	 */
+	uint32_t get_allocated_set_count() const;
+
+	/**
+	 * @return The number of Vulkan descriptor pools currently created
+	 */
+	size_t get_pool_count() const;
+
   private:
 	Device &device;
 
 	const DescriptorSetLayout *descriptor_set_layout{nullptr};
 
-	// Descriptor pool size
-	std::vector<VkDescriptorPoolSize> pool_sizes;
+	// Descriptor count of each type needed by a single set
+	std::map<VkDescriptorType, uint32_t> descriptor_type_counts;
 
-	// Number of sets to allocate for each pool
+	// Number of sets to allocate for the next pool created
 	uint32_t pool_max_sets{0};
 
 	// Total descriptor pools created
 	std::vector<VkDescriptorPool> pools;
 
+	// Number of sets each pool was created for
+	std::vector<uint32_t> pools_max_sets;
+
 	// Count sets for each pool
 	std::vector<uint32_t> pool_sets_count;
 
@@ -87,5 +109,9 @@ class DescriptorPool
 
 	// Find next pool index or create new pool
 	uint32_t find_available_pool(uint32_t pool_index);
+
+	void create_pool(uint32_t max_sets);
+
+	void destroy_pools();
 };
 }        // namespace vkb
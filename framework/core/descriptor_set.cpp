@@ -20,6 +20,8 @@
 
 #include "descriptor_set.h"
 
+#include <cstring>
+
 #include "common/logging.h"
 #include "descriptor_pool.h"
 #include "descriptor_set_layout.h"
@@ -48,6 +50,11 @@ void DescriptorSet::update(const BindingMap<VkDescriptorBufferInfo> &buffer_info
 	this->buffer_infos = buffer_infos;
 	this->image_infos  = image_infos;
 
+	if (update_with_template(buffer_infos, image_infos))
+	{
+		return;
+	}
+
 	std::vector<VkWriteDescriptorSet> set_updates;
 
 	// Iterate over all buffer bindings
@@ -117,6 +124,61 @@ void DescriptorSet::update(const BindingMap<VkDescriptorBufferInfo> &buffer_info
 	vkUpdateDescriptorSets(device.get_handle(), to_u32(set_updates.size()), set_updates.data(), 0, nullptr);
 }
 
+bool DescriptorSet::update_with_template(const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos)
+{
+	VkDescriptorUpdateTemplateKHR update_template = descriptor_set_layout.get_update_template();
+
+	if (update_template == VK_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	// A template writes every descriptor it describes, so each array element must be provided
+	std::vector<uint8_t> payload(descriptor_set_layout.get_update_template_size());
+
+	auto copy_elements = [&payload](const VkDescriptorUpdateTemplateEntryKHR &entry, const auto &elements) {
+		for (uint32_t array_element = 0; array_element < entry.descriptorCount; ++array_element)
+		{
+			auto it = elements.find(array_element);
+
+			if (it == elements.end())
+			{
+				return false;
+			}
+
+			std::memcpy(payload.data() + entry.offset + array_element * entry.stride, &it->second, sizeof(it->second));
+		}
+
+		return true;
+	};
+
+	for (auto &entry : descriptor_set_layout.get_update_template_entries())
+	{
+		auto image_it = image_infos.find(entry.dstBinding);
+
+		if (image_it != image_infos.end())
+		{
+			if (!copy_elements(entry, image_it->second))
+			{
+				return false;
+			}
+
+			continue;
+		}
+
+		auto buffer_it = buffer_infos.find(entry.dstBinding);
+
+		if (buffer_it == buffer_infos.end() || !copy_elements(entry, buffer_it->second))
+		{
+			return false;
+		}
+	}
+
+	vkUpdateDescriptorSetWithTemplateKHR(device.get_handle(), handle, update_template, payload.data());
+
+	return true;
+}
+
 DescriptorSet::DescriptorSet(DescriptorSet &&other) :
     device{other.device},
     descriptor_set_layout{other.descriptor_set_layout},
@@ -138,6 +200,11 @@ const DescriptorSetLayout &DescriptorSet::get_layout() const
 	return descriptor_set_layout;
 }
 
+DescriptorPool &DescriptorSet::get_descriptor_pool()
+{
+	return descriptor_pool;
+}
+
 BindingMap<VkDescriptorBufferInfo> &DescriptorSet::get_buffer_infos()
 {
 	return buffer_infos;
@@ -58,6 +58,8 @@ class DescriptorSet
 
 	const DescriptorSetLayout &get_layout() const;
 
+	DescriptorPool &get_descriptor_pool();
+
 	VkDescriptorSet get_handle() const;
 
 	BindingMap<VkDescriptorBufferInfo> &get_buffer_infos();
@@ -76,5 +78,13 @@ class DescriptorSet
 	BindingMap<VkDescriptorImageInfo> image_infos;
 
 	VkDescriptorSet handle{VK_NULL_HANDLE};
+
+	/**
+	 * @brief Writes the whole set with the layout's descriptor update template
+	 * @return False if the layout has no template or the bindings do not cover every
+	 *         descriptor of the layout, in which case nothing is written
+	 */
+	bool update_with_template(const BindingMap<VkDescriptorBufferInfo> &buffer_infos,
+	                          const BindingMap<VkDescriptorImageInfo> & image_infos);
 };
 }        // namespace vkb
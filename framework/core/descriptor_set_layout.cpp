@@ -71,24 +71,87 @@ inline VkDescriptorType find_descriptor_type(ShaderResourceType resource_type, b
 			break;
 	}
 }
+
+inline bool has_binding_point(ShaderResourceType resource_type)
+{
+	return resource_type != ShaderResourceType::Input &&
+	       resource_type != ShaderResourceType::Output &&
+	       resource_type != ShaderResourceType::PushConstant &&
+	       resource_type != ShaderResourceType::SpecializationConstant;
+}
+
+inline bool is_image_descriptor(VkDescriptorType descriptor_type)
+{
+	switch (descriptor_type)
+	{
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+			return true;
+		default:
+			return false;
+	}
+}
 }        // namespace
 
 DescriptorSetLayout::DescriptorSetLayout(Device &device, const std::vector<ShaderResource> &resource_set, bool use_dynamic_resources) :
     device{device}
 {
+	const auto &limits = device.get_properties().limits;
+
+	uint32_t dynamic_uniform_buffer_count = 0;
+	uint32_t dynamic_storage_buffer_count = 0;
+
+	if (device.is_push_descriptor_enabled())
+	{
+		uint32_t descriptor_count = 0;
+
+		for (auto &resource : resource_set)
+		{
+			if (has_binding_point(resource.type))
+			{
+				push_descriptor = push_descriptor || resource.push;
+				descriptor_count += resource.array_size;
+			}
+		}
+
+		if (push_descriptor && descriptor_count > device.get_max_push_descriptors())
+		{
+			LOGW("Push descriptors not used for a set of {} descriptors, the limit is {}", descriptor_count, device.get_max_push_descriptors());
+			push_descriptor = false;
+		}
+	}
+
 	for (auto &resource : resource_set)
 	{
 		// Skip shader resources whitout a binding point
-		if (resource.type == ShaderResourceType::Input ||
-		    resource.type == ShaderResourceType::Output ||
-		    resource.type == ShaderResourceType::PushConstant ||
-		    resource.type == ShaderResourceType::SpecializationConstant)
+		if (!has_binding_point(resource.type))
 		{
 			continue;
 		}
 
+		// Uniform buffers are always made dynamic, as they are suballocated from the frame buffer pools:
+		// moving one within the same buffer then only changes its dynamic offset, not the descriptor set.
+		// Push descriptor sets cannot contain dynamic buffers, their offsets are written with the descriptors anyway
+		bool dynamic = false;
+
+		if (!push_descriptor && resource.type == ShaderResourceType::BufferUniform &&
+		    dynamic_uniform_buffer_count + resource.array_size <= limits.maxDescriptorSetUniformBuffersDynamic)
+		{
+			dynamic = true;
+			dynamic_uniform_buffer_count += resource.array_size;
+		}
+		else if (!push_descriptor && resource.type == ShaderResourceType::BufferStorage && (use_dynamic_resources || resource.dynamic) &&
+		         dynamic_storage_buffer_count + resource.array_size <= limits.maxDescriptorSetStorageBuffersDynamic)
+		{
+			dynamic = true;
+			dynamic_storage_buffer_count += resource.array_size;
+		}
+
 		// Convert from ShaderResourceType to VkDescriptorType.
-		auto descriptor_type = find_descriptor_type(resource.type, use_dynamic_resources);
+		auto descriptor_type = find_descriptor_type(resource.type, dynamic);
 
 		// Convert ShaderResource to VkDescriptorSetLayoutBinding
 		VkDescriptorSetLayoutBinding layout_binding{};
@@ -108,6 +171,7 @@ DescriptorSetLayout::DescriptorSetLayout(Device &device, const std::vector<Shade
 
 	VkDescriptorSetLayoutCreateInfo create_info{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
 
+	create_info.flags        = push_descriptor ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0;
 	create_info.bindingCount = to_u32(bindings.size());
 	create_info.pBindings    = bindings.data();
 
@@ -118,6 +182,46 @@ DescriptorSetLayout::DescriptorSetLayout(Device &device, const std::vector<Shade
 	{
 		throw VulkanException{result, "Cannot create DescriptorSetLayout"};
 	}
+
+	// Push descriptors are written from the descriptor infos, a template for them would target the pipeline layout
+	if (device.is_descriptor_update_template_enabled() && !bindings.empty() && !push_descriptor)
+	{
+		create_update_template();
+	}
+}
+
+void DescriptorSetLayout::create_update_template()
+{
+	// Pack the descriptor arrays of every binding one after the other
+	for (auto &binding : bindings)
+	{
+		VkDescriptorUpdateTemplateEntryKHR entry{};
+
+		entry.dstBinding      = binding.binding;
+		entry.dstArrayElement = 0;
+		entry.descriptorCount = binding.descriptorCount;
+		entry.descriptorType  = binding.descriptorType;
+		entry.offset          = update_template_size;
+		entry.stride          = is_image_descriptor(binding.descriptorType) ? sizeof(VkDescriptorImageInfo) : sizeof(VkDescriptorBufferInfo);
+
+		update_template_size += entry.stride * entry.descriptorCount;
+
+		update_template_entries.push_back(entry);
+	}
+
+	VkDescriptorUpdateTemplateCreateInfoKHR create_info{VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR};
+
+	create_info.descriptorUpdateEntryCount = to_u32(update_template_entries.size());
+	create_info.pDescriptorUpdateEntries   = update_template_entries.data();
+	create_info.templateType               = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR;
+	create_info.descriptorSetLayout        = handle;
+
+	VkResult result = vkCreateDescriptorUpdateTemplateKHR(device.get_handle(), &create_info, nullptr, &update_template);
+
+	if (result != VK_SUCCESS)
+	{
+		throw VulkanException{result, "Cannot create DescriptorUpdateTemplate"};
+	}
 }
 
 DescriptorSetLayout::DescriptorSetLayout(DescriptorSetLayout &&other) :
@@ -125,13 +229,23 @@ DescriptorSetLayout::DescriptorSetLayout(DescriptorSetLayout &&other) :
     handle{other.handle},
     bindings{std::move(other.bindings)},
     bindings_lookup{std::move(other.bindings_lookup)},
-    resources_lookup{std::move(other.resources_lookup)}
+    resources_lookup{std::move(other.resources_lookup)},
+    update_template{other.update_template},
+    update_template_entries{std::move(other.update_template_entries)},
+    update_template_size{other.update_template_size},
+    push_descriptor{other.push_descriptor}
 {
-	other.handle = VK_NULL_HANDLE;
+	other.handle          = VK_NULL_HANDLE;
+	other.update_template = VK_NULL_HANDLE;
 }
 
 DescriptorSetLayout::~DescriptorSetLayout()
 {
+	if (update_template != VK_NULL_HANDLE)
+	{
+		vkDestroyDescriptorUpdateTemplateKHR(device.get_handle(), update_template, nullptr);
+	}
+
 	// Destroy descriptor set layout
 	if (handle != VK_NULL_HANDLE)
 	{
@@ -172,4 +286,24 @@ std::unique_ptr<VkDescriptorSetLayoutBinding> DescriptorSetLayout::get_layout_bi
 
 	return get_layout_binding(it->second);
 }
+
+VkDescriptorUpdateTemplateKHR DescriptorSetLayout::get_update_template() const
+{
+	return update_template;
+}
+
+const std::vector<VkDescriptorUpdateTemplateEntryKHR> &DescriptorSetLayout::get_update_template_entries() const
+{
+	return update_template_entries;
+}
+
+size_t DescriptorSetLayout::get_update_template_size() const
+{
+	return update_template_size;
+}
+
+bool DescriptorSetLayout::is_push_descriptor() const
+{
+	return push_descriptor;
+}
 }        // namespace vkb
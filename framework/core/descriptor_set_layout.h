@@ -41,7 +41,11 @@ class DescriptorSetLayout
 	 * @brief Creates a descriptor set layout from a set of resources
 	 * @param device A valid Vulkan device
 	 * @param resource_set A grouping of shader resources belonging to the same set
-	 * @param use_dynamic_resources Whether to set the resources to dynamic (where applicable)
+	 * @param use_dynamic_resources Whether to set the storage buffers to dynamic, uniform buffers
+	 *        are always dynamic within the limits of the device
+	 *
+	 * The layout is created for push descriptors if one of the resources is marked as push, VK_KHR_push_descriptor
+	 * is enabled and the set fits within the push descriptor limit, in which case none of its buffers are dynamic.
 	 */
 	DescriptorSetLayout(Device &device, const std::vector<ShaderResource> &resource_set, bool use_dynamic_resources);
 
@@ -63,6 +67,29 @@ class DescriptorSetLayout
 
 	std::unique_ptr<VkDescriptorSetLayoutBinding> get_layout_binding(const std::string &name) const;
 
+	/**
+	 * @return The descriptor update template covering every binding of the layout,
+	 *         or VK_NULL_HANDLE if VK_KHR_descriptor_update_template is not enabled
+	 */
+	VkDescriptorUpdateTemplateKHR get_update_template() const;
+
+	/**
+	 * @return The template entries, one per binding, describing where each descriptor
+	 *         array lives in the packed update payload
+	 */
+	const std::vector<VkDescriptorUpdateTemplateEntryKHR> &get_update_template_entries() const;
+
+	/**
+	 * @return The size in bytes of the payload expected by the update template
+	 */
+	size_t get_update_template_size() const;
+
+	/**
+	 * @return Whether the layout was created for push descriptors, so that its bindings are written
+	 *         into command buffers with vkCmdPushDescriptorSetKHR instead of allocating descriptor sets
+	 */
+	bool is_push_descriptor() const;
+
   private:
 	Device &device;
 
@@ -73,5 +100,15 @@ class DescriptorSetLayout
 	std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings_lookup;
 
 	std::unordered_map<std::string, uint32_t> resources_lookup;
+
+	VkDescriptorUpdateTemplateKHR update_template{VK_NULL_HANDLE};
+
+	std::vector<VkDescriptorUpdateTemplateEntryKHR> update_template_entries;
+
+	size_t update_template_size{0};
+
+	bool push_descriptor{false};
+
+	void create_update_template();
 };
 }        // namespace vkb
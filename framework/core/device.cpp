@@ -27,8 +27,10 @@ VKBP_ENABLE_WARNINGS()
 
 namespace vkb
 {
-Device::Device(VkPhysicalDevice physical_device, VkSurfaceKHR surface, std::vector<const char *> extensions, VkPhysicalDeviceFeatures requested_features) :
+Device::Device(VkPhysicalDevice physical_device, VkSurfaceKHR surface, std::vector<const char *> extensions, VkPhysicalDeviceFeatures requested_features, bool extended_features, bool debug_utils,
+               const QueueConfiguration &queue_configuration, const std::vector<VkPhysicalDevice> &device_group) :
     physical_device{physical_device},
+    debug_utils_enabled{debug_utils},
     resource_cache{*this}
 {
 	// Check whether ASTC is supported
@@ -38,6 +40,33 @@ Device::Device(VkPhysicalDevice physical_device, VkSurfaceKHR surface, std::vect
 		requested_features.textureCompressionASTC_LDR = VK_TRUE;
 	}
 
+	// Allow bindless textures to index sampler arrays with push constants
+	if (features.shaderSampledImageArrayDynamicIndexing)
+	{
+		requested_features.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+	}
+
+	// Allow counting the work done by the pipeline stages
+	if (features.pipelineStatisticsQuery)
+	{
+		requested_features.pipelineStatisticsQuery = VK_TRUE;
+	}
+
+	// Allow GPU culled meshlets of a draw to be recorded with a single indirect call
+	if (features.multiDrawIndirect)
+	{
+		requested_features.multiDrawIndirect = VK_TRUE;
+	}
+
+	// Allow partially resident images, whose memory is only committed for the texture levels in use
+	if (features.sparseBinding && features.sparseResidencyImage2D)
+	{
+		requested_features.sparseBinding          = VK_TRUE;
+		requested_features.sparseResidencyImage2D = VK_TRUE;
+
+		sparse_residency_enabled = true;
+	}
+
 	// Gpu properties
 	vkGetPhysicalDeviceProperties(physical_device, &properties);
 	LOGI("GPU: {}", properties.deviceName);
@@ -48,6 +77,19 @@ Device::Device(VkPhysicalDevice physical_device, VkSurfaceKHR surface, std::vect
 	std::vector<VkQueueFamilyProperties> queue_family_properties(queue_family_properties_count);
 	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_properties_count, queue_family_properties.data());
 
+	std::vector<VkBool32> present_supported(queue_family_properties_count, VK_FALSE);
+
+	// Only check if surface is valid to allow for headless applications
+	if (surface != VK_NULL_HANDLE)
+	{
+		for (uint32_t queue_family_index = 0U; queue_family_index < queue_family_properties_count; ++queue_family_index)
+		{
+			VK_CHECK(vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, queue_family_index, surface, &present_supported[queue_family_index]));
+		}
+	}
+
+	assign_queue_roles(queue_family_properties, present_supported);
+
 	std::vector<VkDeviceQueueCreateInfo> queue_create_infos(queue_family_properties_count, {VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO});
 	std::vector<std::vector<float>>      queue_priorities(queue_family_properties_count);
 
@@ -64,6 +106,17 @@ Device::Device(VkPhysicalDevice physical_device, VkSurfaceKHR surface, std::vect
 		queue_create_info.pQueuePriorities = queue_priorities[queue_family_index].data();
 	}
 
+	// Within a family, the upload queue yields to the queues of the frame
+	const std::array<float, static_cast<size_t>(QueueRole::Count)> role_priorities{queue_configuration.graphics_priority,
+	                                                                              queue_configuration.compute_priority,
+	                                                                              queue_configuration.transfer_priority};
+
+	// Roles falling back to the graphics queue keep its priority
+	for (size_t role = role_queues.size(); role-- > 0;)
+	{
+		queue_priorities[role_queues[role].first][role_queues[role].second] = role_priorities[role];
+	}
+
 	// Check extensions to enable Vma Dedicated Allocation
 	uint32_t device_extension_count;
 	VK_CHECK(vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &device_extension_count, nullptr));
@@ -84,6 +137,312 @@ Device::Device(VkPhysicalDevice physical_device, VkSurfaceKHR surface, std::vect
 		LOGI("Dedicated Allocation enabled");
 	}
 
+	// Descriptor update templates let descriptor sets be written from a packed payload in one call
+	descriptor_update_template_enabled = std::find_if(std::begin(device_extensions),
+	                                                  std::end(device_extensions),
+	                                                  [](auto &extension) { return std::strcmp(extension.extensionName, "VK_KHR_descriptor_update_template") == 0; }) != std::end(device_extensions);
+
+	if (descriptor_update_template_enabled)
+	{
+		extensions.push_back("VK_KHR_descriptor_update_template");
+		LOGI("Descriptor update templates enabled");
+	}
+
+	// Display timing lets the frame pacing schedule presents on refresh cycles
+	if (surface != VK_NULL_HANDLE)
+	{
+		display_timing_enabled = std::find_if(std::begin(device_extensions),
+		                                      std::end(device_extensions),
+		                                      [](auto &extension) { return std::strcmp(extension.extensionName, "VK_GOOGLE_display_timing") == 0; }) != std::end(device_extensions);
+
+		if (display_timing_enabled)
+		{
+			extensions.push_back("VK_GOOGLE_display_timing");
+			LOGI("Display timing enabled");
+		}
+
+		// Incremental present tells the compositor which regions of a presented image changed
+		incremental_present_enabled = std::find_if(std::begin(device_extensions),
+		                                           std::end(device_extensions),
+		                                           [](auto &extension) { return std::strcmp(extension.extensionName, "VK_KHR_incremental_present") == 0; }) != std::end(device_extensions);
+
+		if (incremental_present_enabled)
+		{
+			extensions.push_back("VK_KHR_incremental_present");
+			LOGI("Incremental present enabled");
+		}
+	}
+
+	// Global priorities schedule the frame work ahead of the uploads and of the other applications
+	global_priority_enabled = std::find_if(std::begin(device_extensions),
+	                                       std::end(device_extensions),
+	                                       [](auto &extension) { return std::strcmp(extension.extensionName, "VK_EXT_global_priority") == 0; }) != std::end(device_extensions);
+
+	std::vector<VkDeviceQueueGlobalPriorityCreateInfoEXT> global_priorities(queue_family_properties_count, {VK_STRUCTURE_TYPE_DEVICE_QUEUE_GLOBAL_PRIORITY_CREATE_INFO_EXT});
+
+	if (global_priority_enabled)
+	{
+		extensions.push_back("VK_EXT_global_priority");
+
+		// The priority applies to a whole family, so only a family used for uploads alone is lowered
+		uint32_t transfer_family = role_queues[static_cast<size_t>(QueueRole::Transfer)].first;
+
+		for (uint32_t queue_family_index = 0U; queue_family_index < queue_family_properties_count; ++queue_family_index)
+		{
+			global_priorities[queue_family_index].globalPriority = VK_QUEUE_GLOBAL_PRIORITY_MEDIUM_EXT;
+		}
+
+		for (size_t role = 0; role < role_queues.size(); ++role)
+		{
+			if (static_cast<QueueRole>(role) != QueueRole::Transfer)
+			{
+				global_priorities[role_queues[role].first].globalPriority = queue_configuration.frame_global_priority;
+			}
+		}
+
+		if (transfer_family != role_queues[static_cast<size_t>(QueueRole::Graphics)].first &&
+		    transfer_family != role_queues[static_cast<size_t>(QueueRole::AsyncCompute)].first)
+		{
+			global_priorities[transfer_family].globalPriority = queue_configuration.transfer_global_priority;
+		}
+
+		for (uint32_t queue_family_index = 0U; queue_family_index < queue_family_properties_count; ++queue_family_index)
+		{
+			queue_create_infos[queue_family_index].pNext = &global_priorities[queue_family_index];
+		}
+	}
+
+	// Timeline semaphores are an extension feature, which must be queried before being enabled
+	VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timeline_semaphore_features{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR};
+
+	bool has_timeline_semaphore = std::find_if(std::begin(device_extensions),
+	                                           std::end(device_extensions),
+	                                           [](auto &extension) { return std::strcmp(extension.extensionName, "VK_KHR_timeline_semaphore") == 0; }) != std::end(device_extensions);
+
+	if (extended_features && has_timeline_semaphore)
+	{
+		VkPhysicalDeviceFeatures2KHR features2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR};
+		features2.pNext = &timeline_semaphore_features;
+
+		vkGetPhysicalDeviceFeatures2KHR(physical_device, &features2);
+
+		if (timeline_semaphore_features.timelineSemaphore)
+		{
+			timeline_semaphore_enabled = true;
+			extensions.push_back("VK_KHR_timeline_semaphore");
+			LOGI("Timeline semaphores enabled");
+		}
+	}
+
+	// The memory budget is reported through the memory properties chain, which requires the extended queries
+	if (extended_features)
+	{
+		memory_budget_enabled = std::find_if(std::begin(device_extensions),
+		                                     std::end(device_extensions),
+		                                     [](auto &extension) { return std::strcmp(extension.extensionName, "VK_EXT_memory_budget") == 0; }) != std::end(device_extensions);
+
+		if (memory_budget_enabled)
+		{
+			extensions.push_back("VK_EXT_memory_budget");
+			LOGI("Memory budget enabled");
+		}
+	}
+
+	// Extended dynamic state lets pipelines differing only by cull mode, front face or depth test states be shared
+	VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extended_dynamic_state_features{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT};
+
+	bool has_extended_dynamic_state = std::find_if(std::begin(device_extensions),
+	                                               std::end(device_extensions),
+	                                               [](auto &extension) { return std::strcmp(extension.extensionName, "VK_EXT_extended_dynamic_state") == 0; }) != std::end(device_extensions);
+
+	if (extended_features && has_extended_dynamic_state)
+	{
+		VkPhysicalDeviceFeatures2KHR features2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR};
+		features2.pNext = &extended_dynamic_state_features;
+
+		vkGetPhysicalDeviceFeatures2KHR(physical_device, &features2);
+
+		if (extended_dynamic_state_features.extendedDynamicState)
+		{
+			extended_dynamic_state_enabled = true;
+			extensions.push_back("VK_EXT_extended_dynamic_state");
+			LOGI("Extended dynamic state enabled");
+		}
+	}
+
+	// Multiview renders every view of a stereo pair in a single pass over the scene
+	VkPhysicalDeviceMultiviewFeaturesKHR multiview_features{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES_KHR};
+
+	bool has_multiview = std::find_if(std::begin(device_extensions),
+	                                  std::end(device_extensions),
+	                                  [](auto &extension) { return std::strcmp(extension.extensionName, "VK_KHR_multiview") == 0; }) != std::end(device_extensions);
+
+	if (extended_features && has_multiview)
+	{
+		VkPhysicalDeviceFeatures2KHR features2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR};
+		features2.pNext = &multiview_features;
+
+		vkGetPhysicalDeviceFeatures2KHR(physical_device, &features2);
+
+		if (multiview_features.multiview)
+		{
+			multiview_enabled = true;
+
+			// Views are only broadcast by vertex shaders
+			multiview_features.multiviewGeometryShader     = VK_FALSE;
+			multiview_features.multiviewTessellationShader = VK_FALSE;
+
+			if (std::find_if(extensions.begin(), extensions.end(), [](const char *extension) { return std::strcmp(extension, "VK_KHR_multiview") == 0; }) == extensions.end())
+			{
+				extensions.push_back("VK_KHR_multiview");
+			}
+
+			LOGI("Multiview enabled");
+		}
+	}
+
+	// Fragment shading rates let distant or low detail draws be shaded once per block of pixels
+	VkPhysicalDeviceFragmentShadingRateFeaturesKHR fragment_shading_rate_features{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_FEATURES_KHR};
+
+	// The extension depends on render pass 2, which itself depends on multiview and maintenance2
+	bool has_fragment_shading_rate = true;
+	for (auto name : {"VK_KHR_fragment_shading_rate", "VK_KHR_create_renderpass2", "VK_KHR_multiview", "VK_KHR_maintenance2"})
+	{
+		has_fragment_shading_rate = has_fragment_shading_rate &&
+		                            std::find_if(std::begin(device_extensions),
+		                                         std::end(device_extensions),
+		                                         [name](auto &extension) { return std::strcmp(extension.extensionName, name) == 0; }) != std::end(device_extensions);
+	}
+
+	if (extended_features && has_fragment_shading_rate)
+	{
+		VkPhysicalDeviceFeatures2KHR features2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR};
+		features2.pNext = &fragment_shading_rate_features;
+
+		vkGetPhysicalDeviceFeatures2KHR(physical_device, &features2);
+
+		if (fragment_shading_rate_features.pipelineFragmentShadingRate)
+		{
+			fragment_shading_rate_enabled = true;
+
+			// Only the rates of the draws are used
+			fragment_shading_rate_features.primitiveFragmentShadingRate  = VK_FALSE;
+			fragment_shading_rate_features.attachmentFragmentShadingRate = VK_FALSE;
+
+			for (auto name : {"VK_KHR_multiview", "VK_KHR_maintenance2", "VK_KHR_create_renderpass2", "VK_KHR_fragment_shading_rate"})
+			{
+				// The sample may have requested the dependencies already
+				if (std::find_if(extensions.begin(), extensions.end(), [name](const char *extension) { return std::strcmp(extension, name) == 0; }) == extensions.end())
+				{
+					extensions.push_back(name);
+				}
+			}
+
+			LOGI("Fragment shading rate enabled");
+		}
+	}
+
+	// Rasterization order access lets fragments read the color attachments they write on tile, as framebuffer fetch
+	VkPhysicalDeviceRasterizationOrderAttachmentAccessFeaturesEXT rasterization_order_features{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RASTERIZATION_ORDER_ATTACHMENT_ACCESS_FEATURES_EXT};
+
+	// The ARM extension came first, both share the same structures and flags
+	const char *rasterization_order_extension = nullptr;
+	for (auto name : {"VK_EXT_rasterization_order_attachment_access", "VK_ARM_rasterization_order_attachment_access"})
+	{
+		if (!rasterization_order_extension &&
+		    std::find_if(std::begin(device_extensions),
+		                 std::end(device_extensions),
+		                 [name](auto &extension) { return std::strcmp(extension.extensionName, name) == 0; }) != std::end(device_extensions))
+		{
+			rasterization_order_extension = name;
+		}
+	}
+
+	if (extended_features && rasterization_order_extension)
+	{
+		VkPhysicalDeviceFeatures2KHR features2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR};
+		features2.pNext = &rasterization_order_features;
+
+		vkGetPhysicalDeviceFeatures2KHR(physical_device, &features2);
+
+		if (rasterization_order_features.rasterizationOrderColorAttachmentAccess)
+		{
+			rasterization_order_attachment_access_enabled = true;
+
+			// Only color attachments are read in rasterization order
+			rasterization_order_features.rasterizationOrderDepthAttachmentAccess   = VK_FALSE;
+			rasterization_order_features.rasterizationOrderStencilAttachmentAccess = VK_FALSE;
+
+			extensions.push_back(rasterization_order_extension);
+			LOGI("Rasterization order attachment access enabled");
+		}
+	}
+
+	// Push descriptors write the bindings changing on every draw into command buffers, without allocating descriptor sets
+	bool has_push_descriptor = std::find_if(std::begin(device_extensions),
+	                                        std::end(device_extensions),
+	                                        [](auto &extension) { return std::strcmp(extension.extensionName, "VK_KHR_push_descriptor") == 0; }) != std::end(device_extensions);
+
+	if (extended_features && has_push_descriptor)
+	{
+		VkPhysicalDevicePushDescriptorPropertiesKHR push_descriptor_properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PUSH_DESCRIPTOR_PROPERTIES_KHR};
+
+		VkPhysicalDeviceProperties2KHR properties2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR};
+		properties2.pNext = &push_descriptor_properties;
+
+		vkGetPhysicalDeviceProperties2KHR(physical_device, &properties2);
+
+		push_descriptor_enabled = true;
+		max_push_descriptors    = push_descriptor_properties.maxPushDescriptors;
+		extensions.push_back("VK_KHR_push_descriptor");
+		LOGI("Push descriptors enabled");
+	}
+
+	// Performance queries read the hardware counters of GPUs which hwcpipe does not support
+	VkPhysicalDevicePerformanceQueryFeaturesKHR performance_query_features{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PERFORMANCE_QUERY_FEATURES_KHR};
+
+	bool has_performance_query = std::find_if(std::begin(device_extensions),
+	                                          std::end(device_extensions),
+	                                          [](auto &extension) { return std::strcmp(extension.extensionName, "VK_KHR_performance_query") == 0; }) != std::end(device_extensions);
+
+	if (extended_features && has_performance_query)
+	{
+		VkPhysicalDeviceFeatures2KHR features2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR};
+		features2.pNext = &performance_query_features;
+
+		vkGetPhysicalDeviceFeatures2KHR(physical_device, &features2);
+
+		if (performance_query_features.performanceCounterQueryPools)
+		{
+			performance_query_enabled = true;
+
+			// A frame uses a single performance query pool
+			performance_query_features.performanceCounterMultipleQueryPools = VK_FALSE;
+
+			extensions.push_back("VK_KHR_performance_query");
+			LOGI("Performance queries enabled");
+		}
+	}
+
+	// Linked GPUs render as a single logical device, each with its own instance of the resources
+	bool has_device_group = std::find_if(std::begin(device_extensions),
+	                                     std::end(device_extensions),
+	                                     [](auto &extension) { return std::strcmp(extension.extensionName, VK_KHR_DEVICE_GROUP_EXTENSION_NAME) == 0; }) != std::end(device_extensions);
+
+	if (device_group.size() > 1 && has_device_group)
+	{
+		assert(std::find(device_group.begin(), device_group.end(), physical_device) != device_group.end() && "The physical device must be part of its device group");
+
+		device_group_gpus = device_group;
+
+		extensions.push_back(VK_KHR_DEVICE_GROUP_EXTENSION_NAME);
+		LOGI("Device group of {} GPUs enabled", device_group_gpus.size());
+	}
+	else if (device_group.size() > 1)
+	{
+		LOGW("Device group disabled, the device does not support {}", VK_KHR_DEVICE_GROUP_EXTENSION_NAME);
+	}
+
 	VkDeviceCreateInfo create_info{VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
 
 	create_info.pQueueCreateInfos       = queue_create_infos.data();
@@ -92,8 +451,78 @@ Device::Device(VkPhysicalDevice physical_device, VkSurfaceKHR surface, std::vect
 	create_info.enabledExtensionCount   = to_u32(extensions.size());
 	create_info.ppEnabledExtensionNames = extensions.data();
 
+	// Chain the structures of the extension features to enable
+	void *enabled_features = nullptr;
+
+	if (timeline_semaphore_enabled)
+	{
+		timeline_semaphore_features.pNext = enabled_features;
+		enabled_features                  = &timeline_semaphore_features;
+	}
+
+	if (extended_dynamic_state_enabled)
+	{
+		extended_dynamic_state_features.pNext = enabled_features;
+		enabled_features                      = &extended_dynamic_state_features;
+	}
+
+	if (multiview_enabled)
+	{
+		multiview_features.pNext = enabled_features;
+		enabled_features         = &multiview_features;
+	}
+
+	if (fragment_shading_rate_enabled)
+	{
+		fragment_shading_rate_features.pNext = enabled_features;
+		enabled_features                     = &fragment_shading_rate_features;
+	}
+
+	if (rasterization_order_attachment_access_enabled)
+	{
+		rasterization_order_features.pNext = enabled_features;
+		enabled_features                   = &rasterization_order_features;
+	}
+
+	if (performance_query_enabled)
+	{
+		performance_query_features.pNext = enabled_features;
+		enabled_features                 = &performance_query_features;
+	}
+
+	VkDeviceGroupDeviceCreateInfoKHR device_group_info{VK_STRUCTURE_TYPE_DEVICE_GROUP_DEVICE_CREATE_INFO_KHR};
+	if (!device_group_gpus.empty())
+	{
+		device_group_info.physicalDeviceCount = to_u32(device_group_gpus.size());
+		device_group_info.pPhysicalDevices    = device_group_gpus.data();
+
+		device_group_info.pNext = enabled_features;
+		enabled_features        = &device_group_info;
+	}
+
+	create_info.pNext = enabled_features;
+
 	VkResult result = vkCreateDevice(physical_device, &create_info, nullptr, &handle);
 
+	if (result == VK_ERROR_NOT_PERMITTED_EXT)
+	{
+		// Priorities above medium may require privileges the application does not have
+		LOGW("Queue global priorities not permitted, creating the device with the default ones");
+
+		for (auto &queue_create_info : queue_create_infos)
+		{
+			queue_create_info.pNext = nullptr;
+		}
+
+		global_priority_enabled = false;
+
+		result = vkCreateDevice(physical_device, &create_info, nullptr, &handle);
+	}
+	else if (result == VK_SUCCESS && global_priority_enabled)
+	{
+		LOGI("Queue global priorities enabled");
+	}
+
 	if (result != VK_SUCCESS)
 	{
 		throw VulkanException{result, "Cannot create device"};
@@ -105,17 +534,19 @@ Device::Device(VkPhysicalDevice physical_device, VkSurfaceKHR surface, std::vect
 	{
 		const VkQueueFamilyProperties &queue_family_property = queue_family_properties[queue_family_index];
 
-		VkBool32 present_supported{VK_FALSE};
-
-		// Only check if surface is valid to allow for headless applications
-		if (surface != VK_NULL_HANDLE)
+		for (uint32_t queue_index = 0U; queue_index < queue_family_property.queueCount; ++queue_index)
 		{
-			VK_CHECK(vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, queue_family_index, surface, &present_supported));
+			queues[queue_family_index].emplace_back(*this, queue_family_index, queue_family_property, present_supported[queue_family_index], queue_index);
 		}
+	}
 
-		for (uint32_t queue_index = 0U; queue_index < queue_family_property.queueCount; ++queue_index)
+	for (auto role : {QueueRole::AsyncCompute, QueueRole::Transfer})
+	{
+		auto &role_queue = get_queue_by_role(role);
+
+		if (&role_queue != &get_queue_by_role(QueueRole::Graphics))
 		{
-			queues[queue_family_index].emplace_back(*this, queue_family_index, queue_family_property, present_supported, queue_index);
+			LOGI("{} queue family: {}, index: {}", role == QueueRole::Transfer ? "Transfer" : "Async compute", role_queue.get_family_index(), role_queue.get_index());
 		}
 	}
 
@@ -157,8 +588,21 @@ Device::Device(VkPhysicalDevice physical_device, VkSurfaceKHR surface, std::vect
 		throw VulkanException{result, "Cannot create allocator"};
 	}
 
+	if (timeline_semaphore_enabled)
+	{
+		for (auto &queues_per_family : queues)
+		{
+			for (auto &queue : queues_per_family)
+			{
+				queue_timelines.emplace(queue.get_handle(), std::make_unique<TimelineSemaphore>(*this));
+			}
+		}
+	}
+
 	command_pool = std::make_unique<CommandPool>(*this, get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, 0).get_family_index());
 	fence_pool   = std::make_unique<FencePool>(*this);
+
+	resource_allocator = std::make_unique<ResourceAllocator>(*this);
 }
 
 Device::~Device()
@@ -167,6 +611,8 @@ Device::~Device()
 
 	command_pool.reset();
 	fence_pool.reset();
+	resource_allocator.reset();
+	queue_timelines.clear();
 
 	if (memory_allocator != VK_NULL_HANDLE)
 	{
@@ -178,6 +624,11 @@ Device::~Device()
 		vmaDestroyAllocator(memory_allocator);
 	}
 
+	if (profiling_lock_acquired)
+	{
+		vkReleaseProfilingLockKHR(handle);
+	}
+
 	if (handle != VK_NULL_HANDLE)
 	{
 		vkDestroyDevice(handle, nullptr);
@@ -239,6 +690,64 @@ const VkFormatProperties Device::get_format_properties(VkFormat format) const
 	return format_properties;
 }
 
+VkFormat Device::choose_attachment_format(const std::vector<VkFormat> &candidates, VkImageUsageFlags usage, uint32_t max_bits_per_pixel) const
+{
+	VkFormatFeatureFlags required_features{0};
+
+	if (usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
+	{
+		required_features |= VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BLEND_BIT;
+	}
+
+	if (usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
+	{
+		required_features |= VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	}
+
+	if (usage & VK_IMAGE_USAGE_SAMPLED_BIT)
+	{
+		required_features |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+	}
+
+	if (usage & VK_IMAGE_USAGE_STORAGE_BIT)
+	{
+		required_features |= VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+	}
+
+	VkFormat smallest_format = VK_FORMAT_UNDEFINED;
+	uint32_t smallest_bits_per_pixel{0};
+
+	for (auto format : candidates)
+	{
+		int32_t bits_per_pixel = get_bits_per_pixel(format);
+
+		if (bits_per_pixel <= 0 || (get_format_properties(format).optimalTilingFeatures & required_features) != required_features)
+		{
+			continue;
+		}
+
+		if (static_cast<uint32_t>(bits_per_pixel) <= max_bits_per_pixel)
+		{
+			return format;
+		}
+
+		if (smallest_format == VK_FORMAT_UNDEFINED || static_cast<uint32_t>(bits_per_pixel) < smallest_bits_per_pixel)
+		{
+			smallest_format         = format;
+			smallest_bits_per_pixel = static_cast<uint32_t>(bits_per_pixel);
+		}
+	}
+
+	if (smallest_format == VK_FORMAT_UNDEFINED)
+	{
+		throw std::runtime_error("No supported attachment format among the candidates");
+	}
+
+	LOGW("No supported attachment format fits {} bits per pixel, using {}", max_bits_per_pixel, convert_format_to_string(smallest_format));
+
+	return smallest_format;
+}
+
 const Queue &Device::get_queue(uint32_t queue_family_index, uint32_t queue_index)
 {
 	return queues[queue_family_index][queue_index];
@@ -262,6 +771,24 @@ const Queue &Device::get_queue_by_flags(VkQueueFlags required_queue_flags, uint3
 	throw std::runtime_error("Queue not found");
 }
 
+const Queue &Device::get_queue_by_flags(VkQueueFlags required_queue_flags, VkQueueFlags excluded_queue_flags, uint32_t queue_index)
+{
+	for (uint32_t queue_family_index = 0U; queue_family_index < queues.size(); ++queue_family_index)
+	{
+		Queue &first_queue = queues[queue_family_index][0];
+
+		VkQueueFlags queue_flags = first_queue.get_properties().queueFlags;
+		uint32_t     queue_count = first_queue.get_properties().queueCount;
+
+		if (((queue_flags & required_queue_flags) == required_queue_flags) && (queue_flags & excluded_queue_flags) == 0 && queue_index < queue_count)
+		{
+			return queues[queue_family_index][queue_index];
+		}
+	}
+
+	throw std::runtime_error("Queue not found");
+}
+
 const Queue &Device::get_queue_by_present(uint32_t queue_index)
 {
 	for (uint32_t queue_family_index = 0U; queue_family_index < queues.size(); ++queue_family_index)
@@ -296,6 +823,74 @@ const Queue &Device::get_suitable_graphics_queue()
 	return get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
 }
 
+const Queue &Device::get_queue_by_role(QueueRole role) const
+{
+	auto &role_queue = role_queues[static_cast<size_t>(role)];
+
+	return queues[role_queue.first][role_queue.second];
+}
+
+void Device::assign_queue_roles(const std::vector<VkQueueFamilyProperties> &queue_family_properties, const std::vector<VkBool32> &present_supported)
+{
+	auto find_family = [&](VkQueueFlags required_queue_flags, VkQueueFlags excluded_queue_flags, bool present) {
+		for (uint32_t queue_family_index = 0U; queue_family_index < to_u32(queue_family_properties.size()); ++queue_family_index)
+		{
+			VkQueueFlags queue_flags = queue_family_properties[queue_family_index].queueFlags;
+
+			if ((queue_flags & required_queue_flags) == required_queue_flags && (queue_flags & excluded_queue_flags) == 0 &&
+			    (!present || present_supported[queue_family_index]) && queue_family_properties[queue_family_index].queueCount > 0)
+			{
+				return static_cast<int32_t>(queue_family_index);
+			}
+		}
+
+		return -1;
+	};
+
+	// The frames are presented from the graphics queue, so it prefers a family supporting present
+	int32_t graphics_family = find_family(VK_QUEUE_GRAPHICS_BIT, 0, true);
+
+	if (graphics_family < 0)
+	{
+		graphics_family = find_family(VK_QUEUE_GRAPHICS_BIT, 0, false);
+	}
+
+	if (graphics_family < 0)
+	{
+		throw std::runtime_error("Queue not found");
+	}
+
+	auto &graphics_queue = role_queues[static_cast<size_t>(QueueRole::Graphics)];
+
+	graphics_queue = {to_u32(graphics_family), 0};
+
+	// Next queue of the graphics family which has no role yet
+	uint32_t next_graphics_index = 1;
+
+	auto assign = [&](QueueRole role, int32_t own_family, VkQueueFlags required_queue_flags) {
+		auto &role_queue = role_queues[static_cast<size_t>(role)];
+
+		if (own_family >= 0)
+		{
+			role_queue = {to_u32(own_family), 0};
+		}
+		else if ((queue_family_properties[graphics_queue.first].queueFlags & required_queue_flags) == required_queue_flags &&
+		         next_graphics_index < queue_family_properties[graphics_queue.first].queueCount)
+		{
+			role_queue = {graphics_queue.first, next_graphics_index++};
+		}
+		else
+		{
+			role_queue = graphics_queue;
+		}
+	};
+
+	assign(QueueRole::AsyncCompute, find_family(VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT, false), VK_QUEUE_COMPUTE_BIT);
+
+	// Graphics and compute families support transfers implicitly
+	assign(QueueRole::Transfer, find_family(VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, false), 0);
+}
+
 CommandBuffer &Device::request_command_buffer()
 {
 	return command_pool->request_command_buffer();
@@ -311,8 +906,277 @@ VkResult Device::wait_idle()
 	return vkDeviceWaitIdle(handle);
 }
 
+bool Device::is_descriptor_update_template_enabled() const
+{
+	return descriptor_update_template_enabled;
+}
+
+bool Device::is_timeline_semaphore_enabled() const
+{
+	return timeline_semaphore_enabled;
+}
+
+bool Device::is_display_timing_enabled() const
+{
+	return display_timing_enabled;
+}
+
+bool Device::is_incremental_present_enabled() const
+{
+	return incremental_present_enabled;
+}
+
+bool Device::is_global_priority_enabled() const
+{
+	return global_priority_enabled;
+}
+
+bool Device::is_debug_utils_enabled() const
+{
+	return debug_utils_enabled;
+}
+
+#if defined(VKB_DEBUG)
+void Device::set_debug_name(VkObjectType object_type, uint64_t object_handle, const std::string &name) const
+{
+	if (!debug_utils_enabled || name.empty())
+	{
+		return;
+	}
+
+	VkDebugUtilsObjectNameInfoEXT name_info{VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT};
+	name_info.objectType   = object_type;
+	name_info.objectHandle = object_handle;
+	name_info.pObjectName  = name.c_str();
+
+	vkSetDebugUtilsObjectNameEXT(handle, &name_info);
+}
+#endif
+
+bool Device::is_memory_budget_enabled() const
+{
+	return memory_budget_enabled;
+}
+
+bool Device::is_extended_dynamic_state_enabled() const
+{
+	return extended_dynamic_state_enabled;
+}
+
+bool Device::is_fragment_shading_rate_enabled() const
+{
+	return fragment_shading_rate_enabled;
+}
+
+bool Device::is_multiview_enabled() const
+{
+	return multiview_enabled;
+}
+
+bool Device::is_rasterization_order_attachment_access_enabled() const
+{
+	return rasterization_order_attachment_access_enabled;
+}
+
+bool Device::is_sparse_residency_enabled() const
+{
+	return sparse_residency_enabled;
+}
+
+bool Device::is_push_descriptor_enabled() const
+{
+	return push_descriptor_enabled;
+}
+
+uint32_t Device::get_max_push_descriptors() const
+{
+	return max_push_descriptors;
+}
+
+bool Device::is_performance_query_enabled() const
+{
+	return performance_query_enabled;
+}
+
+bool Device::is_device_group_enabled() const
+{
+	return !device_group_gpus.empty();
+}
+
+uint32_t Device::get_device_group_size() const
+{
+	return device_group_gpus.empty() ? 1 : to_u32(device_group_gpus.size());
+}
+
+uint32_t Device::get_device_group_mask() const
+{
+	return (1u << get_device_group_size()) - 1;
+}
+
+bool Device::acquire_profiling_lock()
+{
+	if (!performance_query_enabled || profiling_lock_acquired)
+	{
+		return profiling_lock_acquired;
+	}
+
+	VkAcquireProfilingLockInfoKHR info{VK_STRUCTURE_TYPE_ACQUIRE_PROFILING_LOCK_INFO_KHR};
+	info.timeout = UINT64_MAX;
+
+	VkResult result = vkAcquireProfilingLockKHR(handle, &info);
+	if (result != VK_SUCCESS)
+	{
+		LOGW("Failed to acquire the profiling lock: {}", to_string(result));
+		return false;
+	}
+
+	profiling_lock_acquired = true;
+
+	return true;
+}
+
+std::vector<MemoryHeapBudget> Device::get_memory_budget() const
+{
+	std::vector<MemoryHeapBudget> heaps;
+
+	if (memory_budget_enabled)
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT};
+
+		VkPhysicalDeviceMemoryProperties2KHR memory_properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR};
+		memory_properties.pNext = &budget_properties;
+
+		vkGetPhysicalDeviceMemoryProperties2KHR(physical_device, &memory_properties);
+
+		for (uint32_t i = 0; i < memory_properties.memoryProperties.memoryHeapCount; ++i)
+		{
+			auto &heap = memory_properties.memoryProperties.memoryHeaps[i];
+
+			heaps.push_back({heap.size,
+			                 budget_properties.heapUsage[i],
+			                 budget_properties.heapBudget[i],
+			                 (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0});
+		}
+	}
+	else
+	{
+		VkPhysicalDeviceMemoryProperties memory_properties;
+		vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+
+		VmaStats stats;
+		vmaCalculateStats(memory_allocator, &stats);
+
+		for (uint32_t i = 0; i < memory_properties.memoryHeapCount; ++i)
+		{
+			auto &heap = memory_properties.memoryHeaps[i];
+
+			// Blocks are allocated from the heap as a whole, including their unused space
+			heaps.push_back({heap.size,
+			                 stats.memoryHeap[i].usedBytes + stats.memoryHeap[i].unusedBytes,
+			                 heap.size / 10 * 8,
+			                 (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0});
+		}
+	}
+
+	return heaps;
+}
+
+void Device::add_memory_usage(MemoryCategory category, VkDeviceSize size)
+{
+	memory_usage[static_cast<size_t>(category)].fetch_add(size, std::memory_order_relaxed);
+}
+
+void Device::remove_memory_usage(MemoryCategory category, VkDeviceSize size)
+{
+	memory_usage[static_cast<size_t>(category)].fetch_sub(size, std::memory_order_relaxed);
+}
+
+VkDeviceSize Device::get_memory_usage(MemoryCategory category) const
+{
+	return memory_usage[static_cast<size_t>(category)].load(std::memory_order_relaxed);
+}
+
+uint64_t Device::create_resource_id()
+{
+	return next_resource_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Device::add_command_buffer_counters(const CommandBufferCounters &counters)
+{
+	pipeline_binds.fetch_add(counters.pipeline_binds, std::memory_order_relaxed);
+	descriptor_set_binds.fetch_add(counters.descriptor_set_binds, std::memory_order_relaxed);
+	vertex_buffer_binds.fetch_add(counters.vertex_buffer_binds, std::memory_order_relaxed);
+	draw_calls.fetch_add(counters.draw_calls, std::memory_order_relaxed);
+	attachment_read_bytes.fetch_add(counters.attachment_read_bytes, std::memory_order_relaxed);
+	attachment_write_bytes.fetch_add(counters.attachment_write_bytes, std::memory_order_relaxed);
+	pipeline_barriers.fetch_add(counters.pipeline_barriers, std::memory_order_relaxed);
+	early_destination_barriers.fetch_add(counters.early_destination_barriers, std::memory_order_relaxed);
+	late_source_barriers.fetch_add(counters.late_source_barriers, std::memory_order_relaxed);
+	redundant_barriers.fetch_add(counters.redundant_barriers, std::memory_order_relaxed);
+}
+
+CommandBufferCounters Device::get_command_buffer_counters() const
+{
+	CommandBufferCounters counters;
+
+	counters.pipeline_binds             = pipeline_binds.load(std::memory_order_relaxed);
+	counters.descriptor_set_binds       = descriptor_set_binds.load(std::memory_order_relaxed);
+	counters.vertex_buffer_binds        = vertex_buffer_binds.load(std::memory_order_relaxed);
+	counters.draw_calls                 = draw_calls.load(std::memory_order_relaxed);
+	counters.attachment_read_bytes      = attachment_read_bytes.load(std::memory_order_relaxed);
+	counters.attachment_write_bytes     = attachment_write_bytes.load(std::memory_order_relaxed);
+	counters.pipeline_barriers          = pipeline_barriers.load(std::memory_order_relaxed);
+	counters.early_destination_barriers = early_destination_barriers.load(std::memory_order_relaxed);
+	counters.late_source_barriers       = late_source_barriers.load(std::memory_order_relaxed);
+	counters.redundant_barriers         = redundant_barriers.load(std::memory_order_relaxed);
+
+	return counters;
+}
+
+void Device::add_descriptor_set_allocation()
+{
+	descriptor_set_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t Device::get_descriptor_set_allocations() const
+{
+	return descriptor_set_allocations.load(std::memory_order_relaxed);
+}
+
+void Device::add_uploaded_bytes(VkDeviceSize size)
+{
+	uploaded_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+uint64_t Device::get_uploaded_bytes() const
+{
+	return uploaded_bytes.load(std::memory_order_relaxed);
+}
+
+TimelineSemaphore &Device::get_queue_timeline(const Queue &queue)
+{
+	auto it = queue_timelines.find(queue.get_handle());
+
+	if (it == queue_timelines.end())
+	{
+		throw std::runtime_error("Queue has no timeline semaphore, VK_KHR_timeline_semaphore is not enabled");
+	}
+
+	return *it->second;
+}
+
 ResourceCache &Device::get_resource_cache()
 {
 	return resource_cache;
 }
+
+JobSystem &Device::get_job_system()
+{
+	return job_system;
+}
+
+ResourceAllocator &Device::get_resource_allocator()
+{
+	return *resource_allocator;
+}
 }        // namespace vkb
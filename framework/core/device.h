@@ -20,6 +20,10 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+
+#include "common/error.h"
 #include "common/helpers.h"
 #include "common/logging.h"
 #include "common/vk_common.h"
@@ -36,9 +40,12 @@
 #include "core/shader_module.h"
 #include "core/swapchain.h"
 #include "fence_pool.h"
+#include "job_system.h"
 #include "rendering/pipeline_state.h"
 #include "rendering/render_target.h"
+#include "resource_allocator.h"
 #include "resource_cache.h"
+#include "timeline_semaphore.h"
 
 namespace vkb
 {
@@ -49,10 +56,104 @@ struct DriverVersion
 	uint16_t patch;
 };
 
+/**
+ * @brief Kinds of resources the device memory allocated through the framework is attributed to
+ */
+enum class MemoryCategory
+{
+	/// Uniform, storage and other device buffers, mostly allocated by the buffer pools
+	BufferPools,
+
+	/// Sampled images such as the scene textures
+	Textures,
+
+	/// Vertex and index buffers
+	Geometry,
+
+	/// Color, depth and input attachments
+	RenderTargets,
+
+	/// Host only buffers used to upload data
+	Staging,
+
+	Count
+};
+
+/**
+ * @brief Memory usage of this process in a memory heap
+ */
+struct MemoryHeapBudget
+{
+	VkDeviceSize size;
+
+	/// Usage reported by the driver with VK_EXT_memory_budget, otherwise the memory allocated by VMA
+	VkDeviceSize usage;
+
+	/// Budget reported by the driver with VK_EXT_memory_budget, otherwise 80% of the heap size
+	VkDeviceSize budget;
+
+	bool device_local;
+};
+
+/**
+ * @brief Kinds of work the device submits to queues of their own, so they are scheduled independently
+ */
+enum class QueueRole
+{
+	/// Rendering and presentation of the frames
+	Graphics,
+
+	/// Compute work overlapping the graphics work of the frame
+	AsyncCompute,
+
+	/// Background uploads, which must not delay the frame work
+	Transfer,
+
+	Count
+};
+
+/**
+ * @brief Priorities of the queues of each role
+ *
+ * Queue priorities only order the queues of a same family, while the global priorities of
+ * VK_EXT_global_priority order whole families against the other queues of the system.
+ */
+struct QueueConfiguration
+{
+	/// Priority of the graphics queue within its family, between 0 and 1
+	float graphics_priority{1.0f};
+
+	/// Priority of the async compute queue within its family
+	float compute_priority{1.0f};
+
+	/// Priority of the upload queue within its family
+	float transfer_priority{0.0f};
+
+	/// Global priority of the families of the graphics and async compute queues
+	VkQueueGlobalPriorityEXT frame_global_priority{VK_QUEUE_GLOBAL_PRIORITY_HIGH_EXT};
+
+	/// Global priority of the family of the upload queue, if it is not used for frame work
+	VkQueueGlobalPriorityEXT transfer_global_priority{VK_QUEUE_GLOBAL_PRIORITY_LOW_EXT};
+};
+
 class Device
 {
   public:
-	Device(VkPhysicalDevice physical_device, VkSurfaceKHR surface, std::vector<const char *> extensions = {}, VkPhysicalDeviceFeatures features = {});
+	/**
+	 * @brief Creates the logical device
+	 * @param physical_device The GPU
+	 * @param surface Surface to check for present support, can be VK_NULL_HANDLE for headless applications
+	 * @param extensions Device extensions to enable
+	 * @param features Core features to enable
+	 * @param extended_features Whether VK_KHR_get_physical_device_properties2 is enabled on the instance,
+	 *        so that the features of extensions such as VK_KHR_timeline_semaphore can be queried and enabled
+	 * @param debug_utils Whether VK_EXT_debug_utils is enabled on the instance, to name objects and label commands
+	 * @param queue_configuration Priorities of the queues assigned to each role
+	 * @param device_group Linked GPUs to create the device over, including the physical device, see Instance::get_device_group().
+	 *        The device is created over the physical device alone if there are fewer than two or VK_KHR_device_group is not supported.
+	 */
+	Device(VkPhysicalDevice physical_device, VkSurfaceKHR surface, std::vector<const char *> extensions = {}, VkPhysicalDeviceFeatures features = {}, bool extended_features = false, bool debug_utils = false,
+	       const QueueConfiguration &queue_configuration = {}, const std::vector<VkPhysicalDevice> &device_group = {});
 
 	Device(const Device &) = delete;
 
@@ -86,10 +187,208 @@ class Device
 
 	const VkFormatProperties get_format_properties(VkFormat format) const;
 
+	/**
+	 * @brief Chooses the format of an attachment among candidates, checking with get_format_properties()
+	 *        that the device supports the attachment usage with optimal tiling. Color attachments
+	 *        must also support blending, so that any subpass can render to them.
+	 * @param candidates Formats in order of preference
+	 * @param usage Usage of the attachment image
+	 * @param max_bits_per_pixel Bandwidth budget of the attachment, the first supported candidate which fits
+	 *        is chosen, or the smallest supported one if none fits
+	 * @throws std::runtime_error if the device does not support any of the candidates
+	 */
+	VkFormat choose_attachment_format(const std::vector<VkFormat> &candidates, VkImageUsageFlags usage, uint32_t max_bits_per_pixel = ~0U) const;
+
+	/**
+	 * @return Whether VK_KHR_descriptor_update_template was enabled on the device
+	 */
+	bool is_descriptor_update_template_enabled() const;
+
+	/**
+	 * @return Whether VK_KHR_timeline_semaphore was enabled on the device
+	 */
+	bool is_timeline_semaphore_enabled() const;
+
+	/**
+	 * @return Whether VK_GOOGLE_display_timing was enabled on the device
+	 */
+	bool is_display_timing_enabled() const;
+
+	/**
+	 * @return Whether VK_KHR_incremental_present was enabled on the device, so that presents can tell
+	 *         the compositor which regions of the images changed
+	 */
+	bool is_incremental_present_enabled() const;
+
+	/**
+	 * @return Whether the queue families were created with the global priorities of VK_EXT_global_priority
+	 */
+	bool is_global_priority_enabled() const;
+
+	/**
+	 * @return Whether objects can be named and commands labelled with VK_EXT_debug_utils,
+	 *         which is only used in debug builds
+	 */
+	bool is_debug_utils_enabled() const;
+
+	/**
+	 * @brief Names an object in graphics debuggers and profilers, compiled out in release builds
+	 * @param object_type Type of the object
+	 * @param object_handle Handle of the object, cast with reinterpret_cast<uint64_t>
+	 * @param name Name of the object
+	 */
+#if defined(VKB_DEBUG)
+	void set_debug_name(VkObjectType object_type, uint64_t object_handle, const std::string &name) const;
+#else
+	void set_debug_name(VkObjectType, uint64_t, const std::string &) const
+	{}
+#endif
+
+	/**
+	 * @return Whether VK_EXT_memory_budget was enabled on the device
+	 */
+	bool is_memory_budget_enabled() const;
+
+	/**
+	 * @return Whether VK_EXT_extended_dynamic_state was enabled on the device, so that the cull mode,
+	 *         front face and depth test states of the graphics pipelines can be set by command buffers
+	 */
+	bool is_extended_dynamic_state_enabled() const;
+
+	/**
+	 * @return Whether VK_KHR_fragment_shading_rate was enabled on the device with pipeline shading rates,
+	 *         so that command buffers can shade draws at a coarser rate than one invocation per pixel
+	 */
+	bool is_fragment_shading_rate_enabled() const;
+
+	/**
+	 * @return Whether VK_KHR_multiview was enabled on the device, so that subpasses with a view mask
+	 *         render to several layers of their attachments in a single pass
+	 */
+	bool is_multiview_enabled() const;
+
+	/**
+	 * @return Whether VK_EXT_rasterization_order_attachment_access or its ARM equivalent was enabled with color
+	 *         access, so that fragments reading the color attachments of their subpass see the writes of the
+	 *         previous fragments in rasterization order, without barriers between the draws
+	 */
+	bool is_rasterization_order_attachment_access_enabled() const;
+
+	/**
+	 * @return Whether sparse binding and residency of 2D images were enabled on the device, so that images
+	 *         can be created partially resident, binding memory on a queue with VK_QUEUE_SPARSE_BINDING_BIT
+	 */
+	bool is_sparse_residency_enabled() const;
+
+	/**
+	 * @return Whether VK_KHR_push_descriptor was enabled on the device, so that the bindings of a descriptor set
+	 *         layout created for push descriptors are written directly into command buffers
+	 */
+	bool is_push_descriptor_enabled() const;
+
+	/**
+	 * @return The maximum number of descriptors in a push descriptor set layout, 0 if push descriptors are not enabled
+	 */
+	uint32_t get_max_push_descriptors() const;
+
+	/**
+	 * @return Whether VK_KHR_performance_query was enabled on the device with performance counter query pools,
+	 *         so that the hardware counters of the GPU can be read by queries
+	 */
+	bool is_performance_query_enabled() const;
+
+	/**
+	 * @return Whether the device was created over several linked GPUs with VK_KHR_device_group,
+	 *         so that the command buffers, submissions and presents need device masks
+	 */
+	bool is_device_group_enabled() const;
+
+	/**
+	 * @return Number of GPUs the device was created over, their device indices go from 0 to this count
+	 */
+	uint32_t get_device_group_size() const;
+
+	/**
+	 * @return Device mask with the bits of all the GPUs of the device
+	 */
+	uint32_t get_device_group_mask() const;
+
+	/**
+	 * @brief Acquires the profiling lock, which must be held while performance queries are recorded and submitted.
+	 *        It is held until the device is destroyed, acquiring it again does nothing.
+	 * @return Whether the lock is held
+	 */
+	bool acquire_profiling_lock();
+
+	/**
+	 * @brief Queries the memory usage and budget of every memory heap
+	 */
+	std::vector<MemoryHeapBudget> get_memory_budget() const;
+
+	/**
+	 * @brief Attributes an allocation to a category, can be called from any thread
+	 */
+	void add_memory_usage(MemoryCategory category, VkDeviceSize size);
+
+	void remove_memory_usage(MemoryCategory category, VkDeviceSize size);
+
+	/**
+	 * @return The size of the live allocations attributed to a category
+	 */
+	VkDeviceSize get_memory_usage(MemoryCategory category) const;
+
+	/**
+	 * @return A new identifier for a resource, never reused unlike the Vulkan handles of destroyed objects,
+	 *         so that it can key caches safely. Can be called from any thread
+	 */
+	uint64_t create_resource_id();
+
+	/**
+	 * @brief Adds the binds and draw calls recorded into a command buffer to the totals, can be called from any thread
+	 */
+	void add_command_buffer_counters(const CommandBufferCounters &counters);
+
+	/**
+	 * @return The binds and draw calls recorded into all the command buffers of the device so far
+	 */
+	CommandBufferCounters get_command_buffer_counters() const;
+
+	/**
+	 * @brief Counts a descriptor set allocated from a descriptor pool, can be called from any thread
+	 */
+	void add_descriptor_set_allocation();
+
+	/**
+	 * @return The descriptor sets allocated on the device so far
+	 */
+	uint64_t get_descriptor_set_allocations() const;
+
+	/**
+	 * @brief Counts bytes written by the host into buffers, can be called from any thread
+	 */
+	void add_uploaded_bytes(VkDeviceSize size);
+
+	/**
+	 * @return The bytes written by the host into buffers so far
+	 */
+	uint64_t get_uploaded_bytes() const;
+
+	/**
+	 * @return The timeline semaphore signaled by the submissions to a queue which track their progress with it
+	 */
+	TimelineSemaphore &get_queue_timeline(const Queue &queue);
+
 	const Queue &get_queue(uint32_t queue_family_index, uint32_t queue_index);
 
 	const Queue &get_queue_by_flags(VkQueueFlags queue_flags, uint32_t queue_index);
 
+	/**
+	 * @brief Finds a queue whose family supports the required flags but none of the excluded ones,
+	 *        for example a transfer only queue
+	 * @throws std::runtime_error if there is no such queue
+	 */
+	const Queue &get_queue_by_flags(VkQueueFlags queue_flags, VkQueueFlags excluded_queue_flags, uint32_t queue_index);
+
 	const Queue &get_queue_by_present(uint32_t queue_index);
 
 	/**
@@ -97,6 +396,12 @@ class Device
 	 */
 	const Queue &get_suitable_graphics_queue();
 
+	/**
+	 * @brief Returns the queue assigned to a role, preferring a family of its own, then another queue of the
+	 *        graphics family, and finally the graphics queue itself if the device has no other suitable queue
+	 */
+	const Queue &get_queue_by_role(QueueRole role) const;
+
 	/**
 	 * @return The command pool
 	 */
@@ -129,7 +434,22 @@ class Device
 
 	ResourceCache &get_resource_cache();
 
+	/**
+	 * @return The worker threads shared by the loaders, the parallel recording and the pipeline compilation
+	 */
+	JobSystem &get_job_system();
+
+	/**
+	 * @return The allocator of the memory of the buffers and images, following their placement hints
+	 */
+	ResourceAllocator &get_resource_allocator();
+
   private:
+	/**
+	 * @brief Picks the family and index of the queue of each role, before the queues are created with their priorities
+	 */
+	void assign_queue_roles(const std::vector<VkQueueFamilyProperties> &queue_family_properties, const std::vector<VkBool32> &present_supported);
+
 	VkPhysicalDevice physical_device{VK_NULL_HANDLE};
 
 	VkPhysicalDeviceFeatures features{};
@@ -142,14 +462,88 @@ class Device
 
 	VkPhysicalDeviceProperties properties;
 
+	bool descriptor_update_template_enabled{false};
+
+	bool timeline_semaphore_enabled{false};
+
+	bool display_timing_enabled{false};
+
+	bool incremental_present_enabled{false};
+
+	bool memory_budget_enabled{false};
+
+	bool extended_dynamic_state_enabled{false};
+
+	bool fragment_shading_rate_enabled{false};
+
+	bool multiview_enabled{false};
+
+	bool rasterization_order_attachment_access_enabled{false};
+
+	bool sparse_residency_enabled{false};
+
+	bool push_descriptor_enabled{false};
+
+	uint32_t max_push_descriptors{0};
+
+	bool performance_query_enabled{false};
+
+	bool profiling_lock_acquired{false};
+
+	/// Physical devices of the device group, in device index order, empty if the device has a single GPU
+	std::vector<VkPhysicalDevice> device_group_gpus;
+
+	bool debug_utils_enabled{false};
+
+	bool global_priority_enabled{false};
+
+	std::array<std::atomic<VkDeviceSize>, static_cast<size_t>(MemoryCategory::Count)> memory_usage{};
+
+	std::atomic<uint64_t> next_resource_id{1};
+
+	std::atomic<uint64_t> pipeline_binds{0};
+
+	std::atomic<uint64_t> descriptor_set_binds{0};
+
+	std::atomic<uint64_t> vertex_buffer_binds{0};
+
+	std::atomic<uint64_t> draw_calls{0};
+
+	std::atomic<uint64_t> attachment_read_bytes{0};
+
+	std::atomic<uint64_t> attachment_write_bytes{0};
+
+	std::atomic<uint64_t> pipeline_barriers{0};
+
+	std::atomic<uint64_t> early_destination_barriers{0};
+
+	std::atomic<uint64_t> late_source_barriers{0};
+
+	std::atomic<uint64_t> redundant_barriers{0};
+
+	std::atomic<uint64_t> descriptor_set_allocations{0};
+
+	std::atomic<uint64_t> uploaded_bytes{0};
+
+	/// One timeline per queue if timeline semaphores are enabled
+	std::unordered_map<VkQueue, std::unique_ptr<TimelineSemaphore>> queue_timelines;
+
 	std::vector<std::vector<Queue>> queues;
 
+	/// Family and index of the queue of each role
+	std::array<std::pair<uint32_t, uint32_t>, static_cast<size_t>(QueueRole::Count)> role_queues{};
+
 	/// A command pool associated to the primary queue
 	std::unique_ptr<CommandPool> command_pool;
 
 	/// A fence pool associated to the primary queue
 	std::unique_ptr<FencePool> fence_pool;
 
+	std::unique_ptr<ResourceAllocator> resource_allocator;
+
+	/// Declared before the resource cache, which waits for its pipeline compilation jobs when destroyed
+	JobSystem job_system;
+
 	ResourceCache resource_cache;
 };
 }        // namespace vkb
@@ -20,6 +20,8 @@
 
 #include "framebuffer.h"
 
+#include <algorithm>
+
 #include "device.h"
 
 namespace vkb
@@ -29,16 +31,28 @@ VkFramebuffer Framebuffer::get_handle() const
 	return handle;
 }
 
+uint64_t Framebuffer::get_id() const
+{
+	return id;
+}
+
+bool Framebuffer::references_any(const std::vector<core::ImageView> &views) const
+{
+	return std::any_of(views.begin(), views.end(), [this](const core::ImageView &view) {
+		return std::find(attachment_ids.begin(), attachment_ids.end(), view.get_id()) != attachment_ids.end();
+	});
+}
+
 Framebuffer::Framebuffer(Device &device, const RenderTarget &render_target, const RenderPass &render_pass) :
-    device{device}
+    device{device},
+    id{device.create_resource_id()}
 {
 	auto &extent = render_target.get_extent();
 
-	std::vector<VkImageView> attachments;
-
 	for (auto &view : render_target.get_views())
 	{
 		attachments.emplace_back(view.get_handle());
+		attachment_ids.emplace_back(view.get_id());
 	}
 
 	VkFramebufferCreateInfo create_info{VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
@@ -60,7 +74,10 @@ Framebuffer::Framebuffer(Device &device, const RenderTarget &render_target, cons
 
 Framebuffer::Framebuffer(Framebuffer &&other) :
     device{other.device},
-    handle{other.handle}
+    id{other.id},
+    handle{other.handle},
+    attachments{std::move(other.attachments)},
+    attachment_ids{std::move(other.attachment_ids)}
 {
 	other.handle = VK_NULL_HANDLE;
 }
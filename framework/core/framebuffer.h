@@ -46,9 +46,26 @@ class Framebuffer
 
 	VkFramebuffer get_handle() const;
 
+	/**
+	 * @return The identifier of the framebuffer, unique for the lifetime of the device
+	 */
+	uint64_t get_id() const;
+
+	/**
+	 * @return Whether the framebuffer has one of the given views as attachment
+	 */
+	bool references_any(const std::vector<core::ImageView> &views) const;
+
   private:
 	Device &device;
 
+	uint64_t id;
+
 	VkFramebuffer handle{VK_NULL_HANDLE};
+
+	std::vector<VkImageView> attachments;
+
+	/// Identifiers of the attachment views, which unlike their handles can't be reused by new views
+	std::vector<uint64_t> attachment_ids;
 };
 }        // namespace vkb
@@ -20,8 +20,14 @@
 
 #include "image.h"
 
+#include <algorithm>
+#include <mutex>
+#include <set>
+#include <tuple>
+
 #include "device.h"
 #include "image_view.h"
+#include "queue.h"
 
 namespace vkb
 {
@@ -66,26 +72,74 @@ inline VkImageType find_image_type(VkExtent3D extent)
 
 	return result;
 }
+
+/**
+ * @brief Warns once per configuration about attachments which cannot be compressed
+ */
+void check_compression(VkFormat format, VkImageUsageFlags usage, VkImageTiling tiling)
+{
+	// Transient attachments never leave tile memory, there is nothing to compress
+	if (!(usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)) || (usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT))
+	{
+		return;
+	}
+
+	auto blocker = core::get_compression_blocker(usage, tiling);
+
+	if (blocker.empty())
+	{
+		return;
+	}
+
+	static std::mutex                                                       mutex;
+	static std::set<std::tuple<VkFormat, VkImageUsageFlags, VkImageTiling>> reported;
+
+	std::lock_guard<std::mutex> guard{mutex};
+
+	if (reported.emplace(format, usage, tiling).second)
+	{
+		LOGW("Framebuffer compression disabled for {} attachment: {}", convert_format_to_string(format), blocker);
+	}
+}
 }        // namespace
 
 namespace core
 {
-Image::Image(Device &              device,
-             const VkExtent3D &    extent,
-             VkFormat              format,
-             VkImageUsageFlags     image_usage,
-             VmaMemoryUsage        memory_usage,
-             VkSampleCountFlagBits sample_count,
-             const uint32_t        mip_levels,
-             const uint32_t        array_layers,
-             VkImageTiling         tiling) :
+std::string get_compression_blocker(VkImageUsageFlags usage, VkImageTiling tiling)
+{
+	if (tiling == VK_IMAGE_TILING_LINEAR)
+	{
+		return "linear tiling";
+	}
+
+	if (usage & VK_IMAGE_USAGE_STORAGE_BIT)
+	{
+		// Storage images are written at arbitrary texels, which a compressed block layout cannot support
+		return "storage usage";
+	}
+
+	return {};
+}
+
+Image::Image(Device &                 device,
+             const VkExtent3D &       extent,
+             VkFormat                 format,
+             VkImageUsageFlags        image_usage,
+             VmaMemoryUsage           memory_usage,
+             VkSampleCountFlagBits    sample_count,
+             const uint32_t           mip_levels,
+             const uint32_t           array_layers,
+             VkImageTiling            tiling,
+             VmaAllocationCreateFlags allocation_flags,
+             const AllocationHints &  hints) :
     device{device},
     type{find_image_type(extent)},
     extent{extent},
     format{format},
     sample_count{sample_count},
     usage{image_usage},
-    tiling{tiling}
+    tiling{tiling},
+    aliased{!hints.alias_group.empty()}
 {
 	assert(mip_levels > 0 && "Image should have at least one level");
 	assert(array_layers > 0 && "Image should have at least one layer");
@@ -104,23 +158,52 @@ Image::Image(Device &              device,
 	image_info.tiling      = tiling;
 	image_info.usage       = image_usage;
 
-	VmaAllocationCreateInfo memory_info{};
-	memory_info.usage = memory_usage;
+	auto result = vkCreateImage(device.get_handle(), &image_info, nullptr, &handle);
 
-	if (image_usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)
+	if (result != VK_SUCCESS)
 	{
-		memory_info.preferredFlags = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+		throw VulkanException{result, "Cannot create Image"};
 	}
 
-	auto result = vmaCreateImage(device.get_memory_allocator(),
-	                             &image_info, &memory_info,
-	                             &handle, &memory,
-	                             nullptr);
+	check_compression(format, image_usage, tiling);
 
-	if (result != VK_SUCCESS)
+	if (image_usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT))
 	{
-		throw VulkanException{result, "Cannot create Image"};
+		memory_category = MemoryCategory::RenderTargets;
+	}
+	else
+	{
+		memory_category = MemoryCategory::Textures;
 	}
+
+	AllocationHints memory_hints = hints;
+	memory_hints.lazily_allocated |= (image_usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) != 0;
+
+	VmaAllocationInfo alloc_info{};
+
+	try
+	{
+		memory = device.get_resource_allocator().allocate(handle, memory_usage, allocation_flags, memory_hints, memory_category, alloc_info);
+	}
+	catch (const VulkanException &)
+	{
+		vkDestroyImage(device.get_handle(), handle, nullptr);
+		throw;
+	}
+
+	allocation_size = alloc_info.size;
+}
+
+Image::Image(Device &              device,
+             const VkExtent3D &    extent,
+             VkFormat              format,
+             VkImageUsageFlags     image_usage,
+             const std::string &   alias_name,
+             VkSampleCountFlagBits sample_count,
+             uint32_t              array_layers) :
+    Image{device, extent, format, image_usage, VMA_MEMORY_USAGE_GPU_ONLY, sample_count, 1, array_layers, VK_IMAGE_TILING_OPTIMAL, 0, AllocationHints{false, true, alias_name}}
+{
+	assert((image_usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) && "Only transient attachments can alias their memory");
 }
 
 Image::Image(Device &device, VkImage handle, const VkExtent3D &extent, VkFormat format, VkImageUsageFlags image_usage) :
@@ -134,12 +217,112 @@ Image::Image(Device &device, VkImage handle, const VkExtent3D &extent, VkFormat
 {
 	subresource.mipLevel   = 1;
 	subresource.arrayLayer = 1;
+
+	// Swapchain images, whose usage is requested by the application
+	check_compression(format, image_usage, VK_IMAGE_TILING_OPTIMAL);
+}
+
+Image::Image(Device &           device,
+             const VkExtent3D & extent,
+             VkFormat           format,
+             VkImageUsageFlags  image_usage,
+             uint32_t           mip_levels,
+             VkImageCreateFlags create_flags) :
+    device{device},
+    memory_category{MemoryCategory::Textures},
+    type{find_image_type(extent)},
+    extent{extent},
+    format{format},
+    usage{image_usage},
+    sample_count{VK_SAMPLE_COUNT_1_BIT},
+    tiling{VK_IMAGE_TILING_OPTIMAL},
+    sparse{true}
+{
+	assert(mip_levels > 0 && "Image should have at least one level");
+	assert(type == VK_IMAGE_TYPE_2D && "Only 2D images can be partially resident");
+	assert(device.is_sparse_residency_enabled() && "Sparse residency is not enabled on the device");
+
+	subresource.mipLevel   = mip_levels;
+	subresource.arrayLayer = 1;
+
+	VkImageCreateInfo image_info{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+
+	image_info.flags       = create_flags | VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT;
+	image_info.imageType   = type;
+	image_info.format      = format;
+	image_info.extent      = extent;
+	image_info.mipLevels   = mip_levels;
+	image_info.arrayLayers = 1;
+	image_info.samples     = sample_count;
+	image_info.tiling      = tiling;
+	image_info.usage       = image_usage;
+
+	auto result = vkCreateImage(device.get_handle(), &image_info, nullptr, &handle);
+
+	if (result != VK_SUCCESS)
+	{
+		throw VulkanException{result, "Cannot create sparse Image"};
+	}
+
+	vkGetImageMemoryRequirements(device.get_handle(), handle, &sparse_memory_requirements);
+
+	uint32_t requirement_count = 0;
+	vkGetImageSparseMemoryRequirements(device.get_handle(), handle, &requirement_count, nullptr);
+
+	std::vector<VkSparseImageMemoryRequirements> requirements(requirement_count);
+	vkGetImageSparseMemoryRequirements(device.get_handle(), handle, &requirement_count, requirements.data());
+
+	bool has_color = false;
+
+	for (auto &requirement : requirements)
+	{
+		if (requirement.formatProperties.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT)
+		{
+			sparse_image_requirements = requirement;
+			has_color                 = true;
+		}
+		else if (requirement.formatProperties.aspectMask & VK_IMAGE_ASPECT_METADATA_BIT)
+		{
+			metadata_size = requirement.imageMipTailSize;
+
+			metadata = allocate_sparse_memory(metadata_size);
+
+			VmaAllocationInfo info{};
+			vmaGetAllocationInfo(device.get_memory_allocator(), metadata, &info);
+
+			// The metadata stays bound for the lifetime of the image
+			pending_opaque_binds.push_back({requirement.imageMipTailOffset, metadata_size, info.deviceMemory, info.offset, VK_SPARSE_MEMORY_BIND_METADATA_BIT});
+		}
+	}
+
+	if (!has_color)
+	{
+		LOGE("Format {} cannot be partially resident", convert_format_to_string(format));
+
+		if (metadata != VK_NULL_HANDLE)
+		{
+			free_sparse_memory(metadata, metadata_size);
+		}
+
+		vkDestroyImage(device.get_handle(), handle, nullptr);
+		throw VulkanException{VK_ERROR_FORMAT_NOT_SUPPORTED, "Cannot create sparse Image"};
+	}
+
+	tiles.resize(get_mip_tail_level());
+
+	for (uint32_t level = 0; level < tiles.size(); ++level)
+	{
+		auto count = get_tile_count(level);
+		tiles[level].resize(count.width * count.height, VK_NULL_HANDLE);
+	}
 }
 
 Image::Image(Image &&other) :
     device{other.device},
     handle{other.handle},
     memory{other.memory},
+    memory_category{other.memory_category},
+    allocation_size{other.allocation_size},
     type{other.type},
     extent{other.extent},
     format{other.format},
@@ -148,12 +331,25 @@ Image::Image(Image &&other) :
     tiling{other.tiling},
     subresource{other.subresource},
     mapped_data{other.mapped_data},
-    mapped{other.mapped}
+    mapped{other.mapped},
+    aliased{other.aliased},
+    sparse{other.sparse},
+    sparse_memory_requirements{other.sparse_memory_requirements},
+    sparse_image_requirements{other.sparse_image_requirements},
+    tiles{std::move(other.tiles)},
+    mip_tail{other.mip_tail},
+    metadata{other.metadata},
+    metadata_size{other.metadata_size},
+    pending_tile_binds{std::move(other.pending_tile_binds)},
+    pending_opaque_binds{std::move(other.pending_opaque_binds)},
+    pending_frees{std::move(other.pending_frees)}
 {
 	other.handle      = VK_NULL_HANDLE;
 	other.memory      = VK_NULL_HANDLE;
 	other.mapped_data = nullptr;
 	other.mapped      = false;
+	other.mip_tail    = VK_NULL_HANDLE;
+	other.metadata    = VK_NULL_HANDLE;
 
 	// Update image views references to this image to avoid dangling pointers
 	for (auto &view : views)
@@ -164,10 +360,41 @@ Image::Image(Image &&other) :
 
 Image::~Image()
 {
-	if (handle != VK_NULL_HANDLE && memory != VK_NULL_HANDLE)
+	if (handle != VK_NULL_HANDLE && sparse)
+	{
+		vkDestroyImage(device.get_handle(), handle, nullptr);
+
+		for (auto &level_tiles : tiles)
+		{
+			for (auto tile : level_tiles)
+			{
+				if (tile != VK_NULL_HANDLE)
+				{
+					vmaFreeMemory(device.get_memory_allocator(), tile);
+				}
+			}
+		}
+
+		for (auto allocation : {mip_tail, metadata})
+		{
+			if (allocation != VK_NULL_HANDLE)
+			{
+				vmaFreeMemory(device.get_memory_allocator(), allocation);
+			}
+		}
+
+		for (auto &pending_free : pending_frees)
+		{
+			vmaFreeMemory(device.get_memory_allocator(), pending_free.first);
+		}
+
+		device.remove_memory_usage(memory_category, allocation_size);
+	}
+	else if (handle != VK_NULL_HANDLE && memory != VK_NULL_HANDLE)
 	{
 		unmap();
-		vmaDestroyImage(device.get_memory_allocator(), handle, memory);
+		vkDestroyImage(device.get_handle(), handle, nullptr);
+		device.get_resource_allocator().free(memory, memory_category);
 	}
 }
 
@@ -188,6 +415,8 @@ VmaAllocation Image::get_memory() const
 
 uint8_t *Image::map()
 {
+	assert(!sparse && "Partially resident images cannot be mapped");
+
 	if (!mapped_data)
 	{
 		if (tiling != VK_IMAGE_TILING_LINEAR)
@@ -245,10 +474,244 @@ VkImageSubresource Image::get_subresource() const
 	return subresource;
 }
 
+VkDeviceSize Image::get_allocation_size() const
+{
+	return allocation_size;
+}
+
 std::unordered_set<ImageView *> &Image::get_views()
 {
 	return views;
 }
 
+bool Image::is_sparse() const
+{
+	return sparse;
+}
+
+const VkExtent3D &Image::get_tile_extent() const
+{
+	return sparse_image_requirements.formatProperties.imageGranularity;
+}
+
+uint32_t Image::get_mip_tail_level() const
+{
+	return std::min(sparse_image_requirements.imageMipTailFirstLod, subresource.mipLevel);
+}
+
+VkExtent3D Image::get_tile_count(uint32_t level) const
+{
+	auto &tile_extent = get_tile_extent();
+
+	uint32_t width  = std::max(1u, extent.width >> level);
+	uint32_t height = std::max(1u, extent.height >> level);
+
+	return {(width + tile_extent.width - 1) / tile_extent.width, (height + tile_extent.height - 1) / tile_extent.height, 1};
+}
+
+void Image::commit_tile(uint32_t level, const VkOffset2D &tile)
+{
+	assert(sparse && level < get_mip_tail_level() && "Tiles can only be committed to the levels of a sparse image finer than the mip tail");
+
+	auto  count      = get_tile_count(level);
+	auto &allocation = tiles[level][tile.y * count.width + tile.x];
+
+	if (allocation != VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	allocation = allocate_sparse_memory(sparse_memory_requirements.alignment);
+
+	VmaAllocationInfo info{};
+	vmaGetAllocationInfo(device.get_memory_allocator(), allocation, &info);
+
+	auto &tile_extent = get_tile_extent();
+
+	VkSparseImageMemoryBind bind{};
+	bind.subresource  = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0};
+	bind.offset       = {static_cast<int32_t>(tile.x * tile_extent.width), static_cast<int32_t>(tile.y * tile_extent.height), 0};
+	bind.memory       = info.deviceMemory;
+	bind.memoryOffset = info.offset;
+
+	// Tiles on the edges of the level may be partial
+	bind.extent = {std::min(tile_extent.width, std::max(1u, extent.width >> level) - tile.x * tile_extent.width),
+	               std::min(tile_extent.height, std::max(1u, extent.height >> level) - tile.y * tile_extent.height),
+	               1};
+
+	pending_tile_binds.push_back(bind);
+}
+
+void Image::decommit_tile(uint32_t level, const VkOffset2D &tile)
+{
+	assert(sparse && level < get_mip_tail_level() && "Tiles can only be decommitted from the levels of a sparse image finer than the mip tail");
+
+	auto  count      = get_tile_count(level);
+	auto &allocation = tiles[level][tile.y * count.width + tile.x];
+
+	if (allocation == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	auto &tile_extent = get_tile_extent();
+
+	VkSparseImageMemoryBind bind{};
+	bind.subresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0};
+	bind.offset      = {static_cast<int32_t>(tile.x * tile_extent.width), static_cast<int32_t>(tile.y * tile_extent.height), 0};
+	bind.extent      = {std::min(tile_extent.width, std::max(1u, extent.width >> level) - tile.x * tile_extent.width),
+	                    std::min(tile_extent.height, std::max(1u, extent.height >> level) - tile.y * tile_extent.height),
+	                    1};
+
+	pending_tile_binds.push_back(bind);
+	pending_frees.push_back({allocation, sparse_memory_requirements.alignment});
+
+	allocation = VK_NULL_HANDLE;
+}
+
+void Image::commit_level(uint32_t level)
+{
+	assert(sparse && level < subresource.mipLevel && "Level is out of the sparse image");
+
+	if (level < get_mip_tail_level())
+	{
+		auto count = get_tile_count(level);
+
+		for (uint32_t y = 0; y < count.height; ++y)
+		{
+			for (uint32_t x = 0; x < count.width; ++x)
+			{
+				commit_tile(level, {static_cast<int32_t>(x), static_cast<int32_t>(y)});
+			}
+		}
+
+		return;
+	}
+
+	if (mip_tail != VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	mip_tail = allocate_sparse_memory(sparse_image_requirements.imageMipTailSize);
+
+	VmaAllocationInfo info{};
+	vmaGetAllocationInfo(device.get_memory_allocator(), mip_tail, &info);
+
+	pending_opaque_binds.push_back({sparse_image_requirements.imageMipTailOffset, sparse_image_requirements.imageMipTailSize, info.deviceMemory, info.offset, 0});
+}
+
+void Image::decommit_level(uint32_t level)
+{
+	assert(sparse && level < subresource.mipLevel && "Level is out of the sparse image");
+
+	if (level < get_mip_tail_level())
+	{
+		auto count = get_tile_count(level);
+
+		for (uint32_t y = 0; y < count.height; ++y)
+		{
+			for (uint32_t x = 0; x < count.width; ++x)
+			{
+				decommit_tile(level, {static_cast<int32_t>(x), static_cast<int32_t>(y)});
+			}
+		}
+
+		return;
+	}
+
+	if (mip_tail == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	pending_opaque_binds.push_back({sparse_image_requirements.imageMipTailOffset, sparse_image_requirements.imageMipTailSize, VK_NULL_HANDLE, 0, 0});
+	pending_frees.push_back({mip_tail, sparse_image_requirements.imageMipTailSize});
+
+	mip_tail = VK_NULL_HANDLE;
+}
+
+bool Image::is_level_committed(uint32_t level) const
+{
+	assert(sparse && level < subresource.mipLevel && "Level is out of the sparse image");
+
+	if (level >= get_mip_tail_level())
+	{
+		return mip_tail != VK_NULL_HANDLE;
+	}
+
+	return std::find(tiles[level].begin(), tiles[level].end(), VK_NULL_HANDLE) == tiles[level].end();
+}
+
+VkResult Image::bind_sparse_memory(const Queue &queue, VkFence fence)
+{
+	assert(sparse && "Only sparse images bind their memory after creation");
+
+	VkSparseImageMemoryBindInfo image_bind_info{handle, to_u32(pending_tile_binds.size()), pending_tile_binds.data()};
+
+	VkSparseImageOpaqueMemoryBindInfo opaque_bind_info{handle, to_u32(pending_opaque_binds.size()), pending_opaque_binds.data()};
+
+	VkBindSparseInfo bind_info{VK_STRUCTURE_TYPE_BIND_SPARSE_INFO};
+
+	if (!pending_tile_binds.empty())
+	{
+		bind_info.imageBindCount = 1;
+		bind_info.pImageBinds    = &image_bind_info;
+	}
+
+	if (!pending_opaque_binds.empty())
+	{
+		bind_info.imageOpaqueBindCount = 1;
+		bind_info.pImageOpaqueBinds    = &opaque_bind_info;
+	}
+
+	// Without binds the fence is still signaled, once the previous work of the queue completes
+	auto result = queue.bind_sparse(pending_tile_binds.empty() && pending_opaque_binds.empty() ? std::vector<VkBindSparseInfo>{} : std::vector<VkBindSparseInfo>{bind_info}, fence);
+
+	pending_tile_binds.clear();
+	pending_opaque_binds.clear();
+
+	// The unbinds submitted above do not refer to the memory of the decommitted tiles
+	for (auto &pending_free : pending_frees)
+	{
+		free_sparse_memory(pending_free.first, pending_free.second);
+	}
+
+	pending_frees.clear();
+
+	return result;
+}
+
+VmaAllocation Image::allocate_sparse_memory(VkDeviceSize size)
+{
+	VkMemoryRequirements requirements = sparse_memory_requirements;
+	requirements.size                 = size;
+
+	VmaAllocationCreateInfo memory_info{};
+	memory_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+	VmaAllocation allocation{VK_NULL_HANDLE};
+
+	auto result = vmaAllocateMemory(device.get_memory_allocator(), &requirements, &memory_info, &allocation, nullptr);
+
+	if (result != VK_SUCCESS)
+	{
+		throw VulkanException{result, "Cannot allocate sparse Image memory"};
+	}
+
+	allocation_size += size;
+	device.add_memory_usage(memory_category, size);
+
+	return allocation;
+}
+
+void Image::free_sparse_memory(VmaAllocation allocation, VkDeviceSize size)
+{
+	vmaFreeMemory(device.get_memory_allocator(), allocation);
+
+	allocation_size -= size;
+	device.remove_memory_usage(memory_category, size);
+}
+
 }        // namespace core
 }        // namespace vkb
@@ -21,17 +21,37 @@
 #pragma once
 
 #include <unordered_set>
+#include <vector>
 
 #include "common/helpers.h"
 #include "common/vk_common.h"
+#include "resource_allocator.h"
 
 namespace vkb
 {
 class Device;
+class Queue;
+
+enum class MemoryCategory;
 
 namespace core
 {
 class ImageView;
+
+/**
+ * @brief Lossless framebuffer compression (AFBC on Mali, UBWC on Adreno) is silently disabled by some
+ *        image settings, which costs bandwidth on every access to the image
+ * @return Description of the setting disabling compression of an attachment, or an empty string if it can be compressed
+ */
+std::string get_compression_blocker(VkImageUsageFlags usage, VkImageTiling tiling);
+
+/**
+ * @brief An image which wraps a swapchain image or owns its memory
+ *        Attachments created with usage flags or tiling which disable framebuffer compression
+ *        are reported with a warning, so that the flags are only requested when really needed
+ *        Partially resident images own the memory of the tiles committed to them, which is bound
+ *        on a sparse binding queue instead of at creation
+ */
 class Image
 {
   public:
@@ -41,15 +61,45 @@ class Image
 	      VkFormat          format,
 	      VkImageUsageFlags image_usage);
 
+	/**
+	 * @param hints Placement hints of the memory, e.g. dedicated for large render targets or an alias group.
+	 *        Transient attachments always prefer lazily allocated memory
+	 */
+	Image(Device &                 device,
+	      const VkExtent3D &       extent,
+	      VkFormat                 format,
+	      VkImageUsageFlags        image_usage,
+	      VmaMemoryUsage           memory_usage,
+	      VkSampleCountFlagBits    sample_count     = VK_SAMPLE_COUNT_1_BIT,
+	      uint32_t                 mip_levels       = 1,
+	      uint32_t                 array_layers     = 1,
+	      VkImageTiling            tiling           = VK_IMAGE_TILING_OPTIMAL,
+	      VmaAllocationCreateFlags allocation_flags = 0,
+	      const AllocationHints &  hints            = {});
+
+	/**
+	 * @brief Creates a transient attachment in lazily allocated memory, shared with the other images
+	 *        created with the same alias name through the ResourceAllocator of the device
+	 */
 	Image(Device &              device,
 	      const VkExtent3D &    extent,
 	      VkFormat              format,
 	      VkImageUsageFlags     image_usage,
-	      VmaMemoryUsage        memory_usage,
+	      const std::string &   alias_name,
 	      VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT,
-	      uint32_t              mip_levels   = 1,
-	      uint32_t              array_layers = 1,
-	      VkImageTiling         tiling       = VK_IMAGE_TILING_OPTIMAL);
+	      uint32_t              array_layers = 1);
+
+	/**
+	 * @brief Creates a partially resident 2D image, without any memory until tiles are committed to it
+	 *        Requires Device::is_sparse_residency_enabled(), throws if the format cannot be sparse
+	 * @param create_flags Additional creation flags, the sparse binding and residency flags are always added
+	 */
+	Image(Device &           device,
+	      const VkExtent3D & extent,
+	      VkFormat           format,
+	      VkImageUsageFlags  image_usage,
+	      uint32_t           mip_levels,
+	      VkImageCreateFlags create_flags);
 
 	Image(const Image &) = delete;
 
@@ -92,8 +142,70 @@ class Image
 
 	VkImageSubresource get_subresource() const;
 
+	/**
+	 * @return Size in bytes of the memory bound to the image, 0 for images it does not own
+	 */
+	VkDeviceSize get_allocation_size() const;
+
 	std::unordered_set<ImageView *> &get_views();
 
+	/**
+	 * @return Whether the image is partially resident
+	 */
+	bool is_sparse() const;
+
+	/**
+	 * @return Extent in texels of the tiles of a partially resident image
+	 */
+	const VkExtent3D &get_tile_extent() const;
+
+	/**
+	 * @return First level of the mip tail, the coarsest levels which are committed as a whole
+	 *         because they are smaller than a tile, or the level count if there is no mip tail
+	 */
+	uint32_t get_mip_tail_level() const;
+
+	/**
+	 * @return Number of tiles of a level finer than the mip tail, in each dimension
+	 */
+	VkExtent3D get_tile_count(uint32_t level) const;
+
+	/**
+	 * @brief Allocates memory for a tile, bound by the next bind_sparse_memory()
+	 * @param level Level finer than the mip tail
+	 * @param tile Position of the tile in the level, in tiles
+	 */
+	void commit_tile(uint32_t level, const VkOffset2D &tile);
+
+	/**
+	 * @brief Unbinds a tile with the next bind_sparse_memory(), which frees its memory
+	 *        The device must not access the tile any more
+	 */
+	void decommit_tile(uint32_t level, const VkOffset2D &tile);
+
+	/**
+	 * @brief Commits every tile of a level, or the mip tail for its levels
+	 */
+	void commit_level(uint32_t level);
+
+	/**
+	 * @brief Decommits every tile of a level, or the mip tail for its levels
+	 */
+	void decommit_level(uint32_t level);
+
+	/**
+	 * @return Whether every tile of a level is committed, counting the binds not submitted yet
+	 */
+	bool is_level_committed(uint32_t level) const;
+
+	/**
+	 * @brief Submits the binds of the tiles committed and decommitted since the last call
+	 *        The committed tiles may be accessed once the fence has signaled
+	 * @param queue Queue supporting VK_QUEUE_SPARSE_BINDING_BIT
+	 * @param fence Signaled once the binds are applied, even if there is nothing to bind
+	 */
+	VkResult bind_sparse_memory(const Queue &queue, VkFence fence = VK_NULL_HANDLE);
+
   private:
 	Device &device;
 
@@ -101,6 +213,11 @@ class Image
 
 	VmaAllocation memory{VK_NULL_HANDLE};
 
+	/// Category the allocation is attributed to in the device memory usage
+	MemoryCategory memory_category{};
+
+	VkDeviceSize allocation_size{0};
+
 	VkImageType type{};
 
 	VkExtent3D extent{};
@@ -122,6 +239,44 @@ class Image
 
 	/// Whether it was mapped with vmaMapMemory
 	bool mapped{false};
+
+	/// Whether the memory is shared with the other images of an alias group
+	bool aliased{false};
+
+	/**
+	 * @brief Allocates memory for the sparse binds, accounted in the allocation size of the image
+	 */
+	VmaAllocation allocate_sparse_memory(VkDeviceSize size);
+
+	/**
+	 * @brief Frees memory allocated for the sparse binds
+	 */
+	void free_sparse_memory(VmaAllocation allocation, VkDeviceSize size);
+
+	/// Whether the image is partially resident, its memory being bound per tile
+	bool sparse{false};
+
+	/// Requirements of the sparse memory, the alignment is the size of a tile
+	VkMemoryRequirements sparse_memory_requirements{};
+
+	VkSparseImageMemoryRequirements sparse_image_requirements{};
+
+	/// Memory of each tile, for the levels finer than the mip tail, VK_NULL_HANDLE if not committed
+	std::vector<std::vector<VmaAllocation>> tiles;
+
+	VmaAllocation mip_tail{VK_NULL_HANDLE};
+
+	/// Memory of the metadata aspect, if the implementation requires it
+	VmaAllocation metadata{VK_NULL_HANDLE};
+
+	VkDeviceSize metadata_size{0};
+
+	std::vector<VkSparseImageMemoryBind> pending_tile_binds;
+
+	std::vector<VkSparseMemoryBind> pending_opaque_binds;
+
+	/// Memory of the decommitted tiles, freed once their unbinds are submitted
+	std::vector<std::pair<VmaAllocation, VkDeviceSize>> pending_frees;
 };
 }        // namespace core
 }        // namespace vkb
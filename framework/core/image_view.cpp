@@ -27,9 +27,11 @@ namespace vkb
 {
 namespace core
 {
-ImageView::ImageView(Image &img, VkImageViewType view_type, VkFormat format) :
+ImageView::ImageView(Image &img, VkImageViewType view_type, VkFormat format, uint32_t base_mip_level, uint32_t mip_level_count) :
     device{img.get_device()},
+    id{device.create_resource_id()},
     image{&img},
+    view_type{view_type},
     format{format}
 {
 	if (format == VK_FORMAT_UNDEFINED)
@@ -37,7 +39,10 @@ ImageView::ImageView(Image &img, VkImageViewType view_type, VkFormat format) :
 		this->format = format = image->get_format();
 	}
 
-	subresource_range.levelCount = image->get_subresource().mipLevel;
+	assert(base_mip_level < image->get_subresource().mipLevel && base_mip_level + mip_level_count <= image->get_subresource().mipLevel && "View levels are out of the image");
+
+	subresource_range.baseMipLevel = base_mip_level;
+	subresource_range.levelCount   = mip_level_count > 0 ? mip_level_count : image->get_subresource().mipLevel - base_mip_level;
 	subresource_range.layerCount = image->get_subresource().arrayLayer;
 
 	if (is_depth_only_format(format))
@@ -74,8 +79,10 @@ ImageView::ImageView(Image &img, VkImageViewType view_type, VkFormat format) :
 
 ImageView::ImageView(ImageView &&other) :
     device{other.device},
+    id{other.id},
     image{other.image},
     handle{other.handle},
+    view_type{other.view_type},
     format{other.format},
     subresource_range{other.subresource_range}
 {
@@ -111,6 +118,16 @@ VkImageView ImageView::get_handle() const
 	return handle;
 }
 
+uint64_t ImageView::get_id() const
+{
+	return id;
+}
+
+VkImageViewType ImageView::get_view_type() const
+{
+	return view_type;
+}
+
 VkFormat ImageView::get_format() const
 {
 	return format;
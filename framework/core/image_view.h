@@ -31,7 +31,11 @@ namespace core
 class ImageView
 {
   public:
-	ImageView(Image &image, VkImageViewType view_type, VkFormat format = VK_FORMAT_UNDEFINED);
+	/**
+	 * @param base_mip_level First level of the image seen by the view
+	 * @param mip_level_count Number of levels seen by the view, 0 for all the levels from base_mip_level
+	 */
+	ImageView(Image &image, VkImageViewType view_type, VkFormat format = VK_FORMAT_UNDEFINED, uint32_t base_mip_level = 0, uint32_t mip_level_count = 0);
 
 	ImageView(ImageView &) = delete;
 
@@ -53,6 +57,13 @@ class ImageView
 
 	VkImageView get_handle() const;
 
+	/**
+	 * @return The identifier of the view, unique for the lifetime of the device
+	 */
+	uint64_t get_id() const;
+
+	VkImageViewType get_view_type() const;
+
 	VkFormat get_format() const;
 
 	VkImageSubresourceRange get_subresource_range() const;
@@ -62,10 +73,14 @@ class ImageView
   private:
 	Device &device;
 
+	uint64_t id;
+
 	Image *image{};
 
 	VkImageView handle{VK_NULL_HANDLE};
 
+	VkImageViewType view_type{};
+
 	VkFormat format{};
 
 	VkImageSubresourceRange subresource_range{};
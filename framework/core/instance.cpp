@@ -21,6 +21,7 @@
 #include "instance.h"
 
 #include <algorithm>
+#include <cstring>
 
 namespace vkb
 {
@@ -123,6 +124,18 @@ Instance::Instance(const std::string &              application_name,
 	extensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
 #endif
 
+#if defined(VKB_DEBUG)
+	// Label command buffers and name objects for graphics debuggers and profilers, if possible
+	for (auto &available_extension : available_instance_extensions)
+	{
+		if (strcmp(available_extension.extensionName, VK_EXT_DEBUG_UTILS_EXTENSION_NAME) == 0)
+		{
+			LOGI("{} is available, enabling it", VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+			extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+		}
+	}
+#endif
+
 	// Try to enable headless surface extension if it exists
 	if (headless)
 	{
@@ -146,6 +159,30 @@ Instance::Instance(const std::string &              application_name,
 		extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
 	}
 
+	// Enable querying the features of device extensions if possible
+	for (auto &available_extension : available_instance_extensions)
+	{
+		if (strcmp(available_extension.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0)
+		{
+			if (std::find_if(extensions.begin(), extensions.end(),
+			                 [](const char *extension) { return strcmp(extension, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0; }) == extensions.end())
+			{
+				LOGI("{} is available, enabling it", VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+				extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+			}
+		}
+	}
+
+	// Enable creating a logical device over linked GPUs if possible
+	for (auto &available_extension : available_instance_extensions)
+	{
+		if (strcmp(available_extension.extensionName, VK_KHR_DEVICE_GROUP_CREATION_EXTENSION_NAME) == 0)
+		{
+			LOGI("{} is available, enabling it", VK_KHR_DEVICE_GROUP_CREATION_EXTENSION_NAME);
+			extensions.push_back(VK_KHR_DEVICE_GROUP_CREATION_EXTENSION_NAME);
+		}
+	}
+
 	if (!validate_extensions(extensions, available_instance_extensions))
 	{
 		throw std::runtime_error("Required instance extensions are missing.");
@@ -241,27 +278,219 @@ Instance::~Instance()
 	}
 }
 
-VkPhysicalDevice Instance::get_gpu()
+VkPhysicalDevice Instance::get_gpu(VkSurfaceKHR surface, const std::vector<const char *> &required_extensions)
 {
-	// Find a discrete GPU
-	for (auto gpu : gpus)
+	VkPhysicalDevice selected_gpu{VK_NULL_HANDLE};
+	int64_t          selected_score{-1};
+	bool             preferred_found{false};
+
+	for (size_t i = 0; i < gpus.size(); ++i)
 	{
 		VkPhysicalDeviceProperties properties{};
-		vkGetPhysicalDeviceProperties(gpu, &properties);
-		if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+		vkGetPhysicalDeviceProperties(gpus[i], &properties);
+
+		int64_t score = score_gpu(gpus[i], surface, required_extensions);
+
+		LOGI("GPU {}: {}, score {}", i, properties.deviceName, score < 0 ? std::string{"unsuitable"} : std::to_string(score));
+
+		if (score < 0 || preferred_found)
+		{
+			continue;
+		}
+
+		bool preferred = !preferred_gpu.empty() &&
+		                 (preferred_gpu == std::to_string(i) || std::strstr(properties.deviceName, preferred_gpu.c_str()) != nullptr);
+
+		if (preferred || score > selected_score)
+		{
+			selected_gpu    = gpus[i];
+			selected_score  = score;
+			preferred_found = preferred;
+		}
+	}
+
+	if (selected_gpu == VK_NULL_HANDLE)
+	{
+		throw std::runtime_error("Couldn't find a physical device with a graphics queue supporting the required extensions.");
+	}
+
+	if (!preferred_gpu.empty() && !preferred_found)
+	{
+		LOGW("GPU {} not found or not suitable, selecting the GPU with the highest score", preferred_gpu);
+	}
+
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(selected_gpu, &properties);
+
+	if (properties.deviceType != VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+	{
+		LOGW("Couldn't find a suitable discrete physical device, using {}", properties.deviceName);
+	}
+	else
+	{
+		LOGI("Selected GPU: {}", properties.deviceName);
+	}
+
+	return selected_gpu;
+}
+
+void Instance::set_preferred_gpu(const std::string &gpu)
+{
+	preferred_gpu = gpu;
+}
+
+int64_t Instance::score_gpu(VkPhysicalDevice gpu, VkSurfaceKHR surface, const std::vector<const char *> &required_extensions) const
+{
+	uint32_t extension_count{0};
+	VK_CHECK(vkEnumerateDeviceExtensionProperties(gpu, nullptr, &extension_count, nullptr));
+
+	std::vector<VkExtensionProperties> extensions(extension_count);
+	VK_CHECK(vkEnumerateDeviceExtensionProperties(gpu, nullptr, &extension_count, extensions.data()));
+
+	auto is_supported = [&extensions](const char *extension) {
+		return std::find_if(extensions.begin(), extensions.end(),
+		                    [extension](const VkExtensionProperties &properties) { return strcmp(properties.extensionName, extension) == 0; }) != extensions.end();
+	};
+
+	for (auto extension : required_extensions)
+	{
+		if (!is_supported(extension))
+		{
+			return -1;
+		}
+	}
+
+	uint32_t queue_family_count{0};
+	vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queue_family_count, nullptr);
+
+	std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+	vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queue_family_count, queue_families.data());
+
+	bool graphics{false};
+	bool async_compute{false};
+	bool async_transfer{false};
+
+	for (uint32_t i = 0; i < queue_family_count; ++i)
+	{
+		VkQueueFlags flags = queue_families[i].queueFlags;
+
+		if (flags & VK_QUEUE_GRAPHICS_BIT)
+		{
+			VkBool32 present_supported{VK_TRUE};
+
+			if (surface != VK_NULL_HANDLE)
+			{
+				VK_CHECK(vkGetPhysicalDeviceSurfaceSupportKHR(gpu, i, surface, &present_supported));
+			}
+
+			graphics = graphics || present_supported;
+		}
+		else if (flags & VK_QUEUE_COMPUTE_BIT)
+		{
+			async_compute = true;
+		}
+		else if (flags & VK_QUEUE_TRANSFER_BIT)
+		{
+			async_transfer = true;
+		}
+	}
+
+	if (!graphics)
+	{
+		return -1;
+	}
+
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(gpu, &properties);
+
+	// The type dominates, an integrated GPU is only selected if no discrete GPU is suitable
+	int64_t score{0};
+
+	switch (properties.deviceType)
+	{
+		case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+			score += 10000;
+			break;
+		case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+			score += 5000;
+			break;
+		case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+			score += 2500;
+			break;
+		default:
+			break;
+	}
+
+	VkPhysicalDeviceMemoryProperties memory_properties{};
+	vkGetPhysicalDeviceMemoryProperties(gpu, &memory_properties);
+
+	VkDeviceSize local_heap_size{0};
+
+	for (uint32_t i = 0; i < memory_properties.memoryHeapCount; ++i)
+	{
+		if (memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
 		{
-			return gpu;
+			local_heap_size = std::max(local_heap_size, memory_properties.memoryHeaps[i].size);
 		}
 	}
 
-	// Otherwise just pick the first one
-	LOGW("Couldn't find a discrete physical device, using integrated graphics");
-	return gpus.at(0);
+	// 100 per GiB, up to 32 GiB
+	score += static_cast<int64_t>(std::min<VkDeviceSize>(local_heap_size >> 30, 32) * 100);
+
+	if (async_compute)
+	{
+		score += 500;
+	}
+
+	if (async_transfer)
+	{
+		score += 250;
+	}
+
+	if (is_supported(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+	{
+		score += 250;
+	}
+
+	if (is_supported(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+	{
+		score += 250;
+	}
+
+	return score;
 }
 
 bool Instance::is_enabled(const char *extension)
 {
-	return std::find(extensions.begin(), extensions.end(), extension) != extensions.end();
+	return std::find_if(extensions.begin(), extensions.end(),
+	                    [extension](const char *enabled_extension) { return strcmp(enabled_extension, extension) == 0; }) != extensions.end();
+}
+
+std::vector<VkPhysicalDevice> Instance::get_device_group(VkPhysicalDevice gpu)
+{
+	if (!is_enabled(VK_KHR_DEVICE_GROUP_CREATION_EXTENSION_NAME))
+	{
+		return {gpu};
+	}
+
+	uint32_t group_count{0};
+	VK_CHECK(vkEnumeratePhysicalDeviceGroupsKHR(handle, &group_count, nullptr));
+
+	std::vector<VkPhysicalDeviceGroupProperties> groups(group_count, {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GROUP_PROPERTIES});
+	VK_CHECK(vkEnumeratePhysicalDeviceGroupsKHR(handle, &group_count, groups.data()));
+
+	for (auto &group : groups)
+	{
+		auto first = group.physicalDevices;
+		auto last  = group.physicalDevices + group.physicalDeviceCount;
+
+		if (std::find(first, last, gpu) != last)
+		{
+			return {first, last};
+		}
+	}
+
+	return {gpu};
 }
 
 VkInstance Instance::get_handle()
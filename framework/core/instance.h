@@ -58,10 +58,31 @@ class Instance
 	Instance &operator=(Instance &&) = delete;
 
 	/**
-	 * @brief Tries to find the first available discrete GPU
+	 * @brief Selects the physical device with the highest score among those with a graphics queue, presenting
+	 *        to the surface if any and supporting the required extensions. Discrete GPUs score the highest,
+	 *        then the size of the largest device local heap, dedicated compute and transfer queues, and the
+	 *        support of timeline semaphores and descriptor indexing add to the score.
+	 *        The preferred GPU, if set and suitable, is selected over the others.
+	 * @param surface The surface the device presents to, null in headless mode
+	 * @param required_extensions The device extensions the device must support
 	 * @returns A valid physical device
+	 * @throws runtime_error if no physical device is suitable
 	 */
-	VkPhysicalDevice get_gpu();
+	VkPhysicalDevice get_gpu(VkSurfaceKHR surface = VK_NULL_HANDLE, const std::vector<const char *> &required_extensions = {});
+
+	/**
+	 * @brief Sets the GPU selected by get_gpu() if suitable
+	 * @param gpu The index of the physical device in the order they are enumerated, or a part of its name
+	 */
+	void set_preferred_gpu(const std::string &gpu);
+
+	/**
+	 * @brief Finds the linked GPUs a logical device can be created over along with a physical device,
+	 *        see VK_KHR_device_group_creation
+	 * @param gpu A physical device, as returned by get_gpu()
+	 * @return The physical devices of the group of the GPU in their device index order, only the GPU itself if it is not linked
+	 */
+	std::vector<VkPhysicalDevice> get_device_group(VkPhysicalDevice gpu);
 
 	/**
 	 * @brief Checks if the given extension is enabled in the VkInstance
@@ -95,5 +116,13 @@ class Instance
 	 * @brief The physical devices found on the machine
 	 */
 	std::vector<VkPhysicalDevice> gpus;
+
+	/// Index or part of the name of the GPU selected by get_gpu(), empty for the highest score
+	std::string preferred_gpu;
+
+	/**
+	 * @return The score of the physical device, negative if it is not suitable
+	 */
+	int64_t score_gpu(VkPhysicalDevice gpu, VkSurfaceKHR surface, const std::vector<const char *> &required_extensions) const;
 };
 }        // namespace vkb
@@ -91,12 +91,10 @@ ComputePipeline::ComputePipeline(Device &        device,
 	std::vector<uint8_t>                  data{};
 	std::vector<VkSpecializationMapEntry> map_entries{};
 
-	const auto specialization_constant_state = pipeline_state.get_specialization_constant_state().get_specialization_constant_state();
-
-	for (const auto specialization_constant : specialization_constant_state)
+	for (const auto &specialization_constant : pipeline_state.get_specialization_constant_state())
 	{
-		map_entries.push_back({specialization_constant.first, to_u32(data.size()), specialization_constant.second.size()});
-		data.insert(data.end(), specialization_constant.second.begin(), specialization_constant.second.end());
+		map_entries.push_back({specialization_constant.constant_id, to_u32(data.size()), specialization_constant.size});
+		data.insert(data.end(), specialization_constant.data.begin(), specialization_constant.data.begin() + specialization_constant.size);
 	}
 
 	VkSpecializationInfo specialization_info{};
@@ -124,8 +122,10 @@ ComputePipeline::ComputePipeline(Device &        device,
 
 GraphicsPipeline::GraphicsPipeline(Device &        device,
                                    VkPipelineCache pipeline_cache,
-                                   PipelineState & pipeline_state) :
-    Pipeline{device}
+                                   PipelineState & pipeline_state,
+                                   VkPipeline      base_pipeline) :
+    Pipeline{device},
+    derivative_base{base_pipeline == VK_NULL_HANDLE}
 {
 	std::vector<VkShaderModule> shader_modules;
 
@@ -135,12 +135,10 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 	std::vector<uint8_t>                  data{};
 	std::vector<VkSpecializationMapEntry> map_entries{};
 
-	const auto specialization_constant_state = pipeline_state.get_specialization_constant_state().get_specialization_constant_state();
-
-	for (const auto specialization_constant : specialization_constant_state)
+	for (const auto &specialization_constant : pipeline_state.get_specialization_constant_state())
 	{
-		map_entries.push_back({specialization_constant.first, to_u32(data.size()), specialization_constant.second.size()});
-		data.insert(data.end(), specialization_constant.second.begin(), specialization_constant.second.end());
+		map_entries.push_back({specialization_constant.constant_id, to_u32(data.size()), specialization_constant.size});
+		data.insert(data.end(), specialization_constant.data.begin(), specialization_constant.data.begin() + specialization_constant.size);
 	}
 
 	VkSpecializationInfo specialization_info{};
@@ -256,7 +254,13 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 	color_blend_state.blendConstants[2] = 1.0f;
 	color_blend_state.blendConstants[3] = 1.0f;
 
-	std::array<VkDynamicState, 9> dynamic_states{
+	// Pipelines of a subpass reading its color attachments in rasterization order must opt in to the same order
+	if (pipeline_state.get_render_pass()->is_rasterization_order_access(pipeline_state.get_subpass_index()))
+	{
+		color_blend_state.flags = VK_PIPELINE_COLOR_BLEND_STATE_CREATE_RASTERIZATION_ORDER_ATTACHMENT_ACCESS_BIT_EXT;
+	}
+
+	std::vector<VkDynamicState> dynamic_states{
 	    VK_DYNAMIC_STATE_VIEWPORT,
 	    VK_DYNAMIC_STATE_SCISSOR,
 	    VK_DYNAMIC_STATE_LINE_WIDTH,
@@ -268,6 +272,22 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 	    VK_DYNAMIC_STATE_STENCIL_REFERENCE,
 	};
 
+	// Set by the command buffers, as these states are not part of the pipeline hash
+	if (pipeline_state.is_extended_dynamic_state())
+	{
+		dynamic_states.insert(dynamic_states.end(), {VK_DYNAMIC_STATE_CULL_MODE_EXT,
+		                                             VK_DYNAMIC_STATE_FRONT_FACE_EXT,
+		                                             VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT,
+		                                             VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT,
+		                                             VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT});
+	}
+
+	// Set per draw by the command buffers, defaulting to full rate
+	if (device.is_fragment_shading_rate_enabled())
+	{
+		dynamic_states.push_back(VK_DYNAMIC_STATE_FRAGMENT_SHADING_RATE_KHR);
+	}
+
 	VkPipelineDynamicStateCreateInfo dynamic_state{VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
 
 	dynamic_state.pDynamicStates    = dynamic_states.data();
@@ -286,6 +306,17 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 	create_info.renderPass = pipeline_state.get_render_pass()->get_handle();
 	create_info.subpass    = pipeline_state.get_subpass_index();
 
+	if (derivative_base)
+	{
+		create_info.flags = VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
+	}
+	else
+	{
+		create_info.flags              = VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+		create_info.basePipelineHandle = base_pipeline;
+		create_info.basePipelineIndex  = -1;
+	}
+
 	auto result = vkCreateGraphicsPipelines(device.get_handle(), pipeline_cache, 1, &create_info, nullptr, &handle);
 
 	if (result != VK_SUCCESS)
@@ -293,6 +324,19 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 		throw VulkanException{result, "Cannot create GraphicsPipelines"};
 	}
 
+#if defined(VKB_DEBUG)
+	if (device.is_debug_utils_enabled())
+	{
+		// Name the pipeline after its shaders, to tell apart the cached variants in captures
+		std::string name;
+		for (const ShaderModule *shader_module : pipeline_state.get_pipeline_layout().get_shader_program().get_shader_modules())
+		{
+			name += (name.empty() ? "" : " / ") + shader_module->get_debug_name();
+		}
+		device.set_debug_name(VK_OBJECT_TYPE_PIPELINE, reinterpret_cast<uint64_t>(handle), name);
+	}
+#endif
+
 	for (auto shader_module : shader_modules)
 	{
 		vkDestroyShaderModule(device.get_handle(), shader_module, nullptr);
@@ -300,4 +344,9 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 
 	state = pipeline_state;
 }
+
+bool GraphicsPipeline::allows_derivatives() const
+{
+	return derivative_base;
+}
 }        // namespace vkb
@@ -74,8 +74,22 @@ class GraphicsPipeline : public Pipeline
 
 	virtual ~GraphicsPipeline() = default;
 
+	/**
+	 * @brief Creates a graphics pipeline
+	 * @param base_pipeline Pipeline the new one is derived from, sharing its shaders and most of its state.
+	 *                      If null, the pipeline is created as a base allowing derivatives instead
+	 */
 	GraphicsPipeline(Device &        device,
 	                 VkPipelineCache pipeline_cache,
-	                 PipelineState & pipeline_state);
+	                 PipelineState & pipeline_state,
+	                 VkPipeline      base_pipeline = VK_NULL_HANDLE);
+
+	/**
+	 * @return True if other pipelines can be derived from this one
+	 */
+	bool allows_derivatives() const;
+
+  private:
+	bool derivative_base{false};
 };
 }        // namespace vkb
@@ -20,6 +20,8 @@
 
 #include "pipeline_layout.h"
 
+#include <algorithm>
+
 #include "descriptor_set_layout.h"
 #include "device.h"
 #include "pipeline.h"
@@ -29,18 +31,32 @@ namespace vkb
 {
 PipelineLayout::PipelineLayout(Device &device, const std::vector<ShaderModule *> &shader_modules, bool use_dynamic_resources) :
     device{device},
+    id{device.create_resource_id()},
     shader_program{shader_modules}
 {
 	// Create a descriptor set layout for each shader set in the shader program
+	uint32_t set_count{0};
 	for (auto &shader_set_it : shader_program.get_shader_sets())
 	{
 		descriptor_set_layouts.emplace(shader_set_it.first, &device.get_resource_cache().request_descriptor_set_layout(shader_set_it.second, use_dynamic_resources));
+
+		set_count = std::max(set_count, shader_set_it.first + 1);
 	}
 
-	// Collect all the descriptor set layout handles
-	std::vector<VkDescriptorSetLayout> descriptor_set_layout_handles(descriptor_set_layouts.size());
-	std::transform(descriptor_set_layouts.begin(), descriptor_set_layouts.end(), descriptor_set_layout_handles.begin(),
-	               [](auto &descriptor_set_layout_it) { return descriptor_set_layout_it.second->get_handle(); });
+	// Collect all the descriptor set layout handles in set order, the sets a shader
+	// does not use, such as the material set of a depth only shader, get an empty layout
+	std::vector<VkDescriptorSetLayout> descriptor_set_layout_handles(set_count);
+	for (uint32_t set_index = 0; set_index < set_count; ++set_index)
+	{
+		auto set_it = descriptor_set_layouts.find(set_index);
+
+		if (set_it == descriptor_set_layouts.end())
+		{
+			set_it = descriptor_set_layouts.emplace(set_index, &device.get_resource_cache().request_descriptor_set_layout({}, use_dynamic_resources)).first;
+		}
+
+		descriptor_set_layout_handles[set_index] = set_it->second->get_handle();
+	}
 
 	// Collect all the push constant shader resources
 	std::vector<VkPushConstantRange> push_constant_ranges;
@@ -67,6 +83,7 @@ PipelineLayout::PipelineLayout(Device &device, const std::vector<ShaderModule *>
 
 PipelineLayout::PipelineLayout(PipelineLayout &&other) :
     device{other.device},
+    id{other.id},
     handle{other.handle},
     shader_program{std::move(other.shader_program)},
     descriptor_set_layouts{std::move(other.descriptor_set_layouts)}
@@ -88,6 +105,11 @@ VkPipelineLayout PipelineLayout::get_handle() const
 	return handle;
 }
 
+uint64_t PipelineLayout::get_id() const
+{
+	return id;
+}
+
 const ShaderProgram &PipelineLayout::get_shader_program() const
 {
 	return shader_program;
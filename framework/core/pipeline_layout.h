@@ -49,6 +49,11 @@ class PipelineLayout
 
 	VkPipelineLayout get_handle() const;
 
+	/**
+	 * @return The identifier of the pipeline layout, unique for the lifetime of the device
+	 */
+	uint64_t get_id() const;
+
 	const ShaderProgram &get_shader_program() const;
 
 	bool has_descriptor_set_layout(uint32_t set_index) const;
@@ -60,6 +65,8 @@ class PipelineLayout
   private:
 	Device &device;
 
+	uint64_t id;
+
 	VkPipelineLayout handle{VK_NULL_HANDLE};
 
 	ShaderProgram shader_program;
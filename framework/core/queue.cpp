@@ -104,6 +104,13 @@ VkResult Queue::present(const VkPresentInfoKHR &present_info) const
 	return vkQueuePresentKHR(handle, &present_info);
 }        // namespace vkb
 
+VkResult Queue::bind_sparse(const std::vector<VkBindSparseInfo> &bind_infos, VkFence fence) const
+{
+	assert((properties.queueFlags & VK_QUEUE_SPARSE_BINDING_BIT) && "Queue does not support sparse binding");
+
+	return vkQueueBindSparse(handle, to_u32(bind_infos.size()), bind_infos.data(), fence);
+}
+
 VkResult Queue::wait_idle() const
 {
 	return vkQueueWaitIdle(handle);
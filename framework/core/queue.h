@@ -60,6 +60,12 @@ class Queue
 
 	VkResult present(const VkPresentInfoKHR &present_infos) const;
 
+	/**
+	 * @brief Binds or unbinds the memory of sparse resources, the queue must support VK_QUEUE_SPARSE_BINDING_BIT
+	 * @param fence Signaled once the binds are applied, may be VK_NULL_HANDLE
+	 */
+	VkResult bind_sparse(const std::vector<VkBindSparseInfo> &bind_infos, VkFence fence) const;
+
 	VkResult wait_idle() const;
 
   private:
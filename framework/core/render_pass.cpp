@@ -27,17 +27,55 @@
 
 namespace vkb
 {
+namespace
+{
+void hash_attachment_references(std::size_t &seed, const std::vector<VkAttachmentDescription> &attachment_descriptions, const VkAttachmentReference *references, uint32_t count)
+{
+	hash_combine(seed, count);
+
+	for (uint32_t i = 0U; references && i < count; ++i)
+	{
+		// Only the format and sample count of a referenced attachment matter for compatibility
+		if (references[i].attachment == VK_ATTACHMENT_UNUSED)
+		{
+			hash_combine(seed, VK_ATTACHMENT_UNUSED);
+		}
+		else
+		{
+			auto &attachment = attachment_descriptions[references[i].attachment];
+
+			hash_combine(seed, static_cast<uint32_t>(attachment.format));
+			hash_combine(seed, static_cast<uint32_t>(attachment.samples));
+		}
+	}
+}
+}        // namespace
+
 VkRenderPass RenderPass::get_handle() const
 {
 	return handle;
 }
 
+uint64_t RenderPass::get_id() const
+{
+	return id;
+}
+
+std::size_t RenderPass::get_compatibility_hash() const
+{
+	return compatibility_hash;
+}
+
 RenderPass::RenderPass(Device &device, const std::vector<Attachment> &attachments, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<SubpassInfo> &subpasses) :
     device{device},
+    id{device.create_resource_id()},
     subpass_count{std::max<size_t>(1, subpasses.size())},        // At least 1 subpass
     input_attachments{subpass_count},
     color_attachments{subpass_count},
-    depth_stencil_attachments{subpass_count}
+    depth_stencil_attachments{subpass_count},
+    color_resolve_attachments{subpass_count},
+    sample_counts(subpass_count, VK_SAMPLE_COUNT_1_BIT),
+    subpass_flags(subpass_count, 0)
 {
 	uint32_t depth_stencil_attachment{VK_ATTACHMENT_UNUSED};
 
@@ -47,9 +85,10 @@ RenderPass::RenderPass(Device &device, const std::vector<Attachment> &attachment
 	{
 		VkAttachmentDescription attachment{};
 
-		attachment.format      = attachments[i].format;
-		attachment.samples     = attachments[i].samples;
-		attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		attachment.format        = attachments[i].format;
+		attachment.samples       = attachments[i].samples;
+		attachment.initialLayout = attachments[i].initial_layout;
+		attachment.finalLayout   = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
 		if (i < load_store_infos.size())
 		{
@@ -76,21 +115,49 @@ RenderPass::RenderPass(Device &device, const std::vector<Attachment> &attachment
 		auto &subpass = subpasses[i];
 
 		// Fill color/depth attachments references
-		for (auto o_attachment : subpass.output_attachments)
+		for (size_t k = 0; k < subpass.output_attachments.size(); ++k)
 		{
+			auto o_attachment = subpass.output_attachments[k];
+
 			if (o_attachment != depth_stencil_attachment)
 			{
 				color_attachments[i].push_back({o_attachment, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+
+				sample_counts[i] = attachment_descriptions[o_attachment].samples;
+
+				// Resolve attachments are either absent or given for every color attachment
+				uint32_t resolve_attachment = k < subpass.color_resolve_attachments.size() ? subpass.color_resolve_attachments[k] : VK_ATTACHMENT_UNUSED;
+				color_resolve_attachments[i].push_back({resolve_attachment, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
 			}
 		}
 
+		bool resolved = std::find_if(color_resolve_attachments[i].begin(), color_resolve_attachments[i].end(), [](const VkAttachmentReference &reference) { return reference.attachment != VK_ATTACHMENT_UNUSED; }) != color_resolve_attachments[i].end();
+
+		if (!resolved)
+		{
+			color_resolve_attachments[i].clear();
+		}
+
 		// Fill input attachments references
 		for (auto i_attachment : subpass.input_attachments)
 		{
+			auto color_reference = std::find_if(color_attachments[i].begin(), color_attachments[i].end(), [i_attachment](const VkAttachmentReference &reference) { return reference.attachment == i_attachment; });
+
 			if (is_depth_stencil_format(attachment_descriptions[i_attachment].format))
 			{
 				input_attachments[i].push_back({i_attachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL});
 			}
+			else if (color_reference != color_attachments[i].end())
+			{
+				// A color attachment read by the fragments writing it is in the general layout for both uses
+				color_reference->layout = VK_IMAGE_LAYOUT_GENERAL;
+				input_attachments[i].push_back({i_attachment, VK_IMAGE_LAYOUT_GENERAL});
+
+				if (subpass.rasterization_order_access && device.is_rasterization_order_attachment_access_enabled())
+				{
+					subpass_flags[i] = VK_SUBPASS_DESCRIPTION_RASTERIZATION_ORDER_ATTACHMENT_COLOR_ACCESS_BIT_EXT;
+				}
+			}
 			else
 			{
 				input_attachments[i].push_back({i_attachment, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
@@ -100,6 +167,11 @@ RenderPass::RenderPass(Device &device, const std::vector<Attachment> &attachment
 		if (depth_stencil_attachment != VK_ATTACHMENT_UNUSED)
 		{
 			depth_stencil_attachments[i].push_back({depth_stencil_attachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL});
+
+			if (color_attachments[i].empty())
+			{
+				sample_counts[i] = attachment_descriptions[depth_stencil_attachment].samples;
+			}
 		}
 	}
 
@@ -108,6 +180,7 @@ RenderPass::RenderPass(Device &device, const std::vector<Attachment> &attachment
 		auto &subpass = subpasses[i];
 
 		VkSubpassDescription subpass_description{};
+		subpass_description.flags             = subpass_flags[i];
 		subpass_description.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 
 		subpass_description.pInputAttachments    = input_attachments[i].empty() ? nullptr : input_attachments[i].data();
@@ -116,6 +189,8 @@ RenderPass::RenderPass(Device &device, const std::vector<Attachment> &attachment
 		subpass_description.pColorAttachments    = color_attachments[i].empty() ? nullptr : color_attachments[i].data();
 		subpass_description.colorAttachmentCount = to_u32(color_attachments[i].size());
 
+		subpass_description.pResolveAttachments = color_resolve_attachments[i].empty() ? nullptr : color_resolve_attachments[i].data();
+
 		subpass_description.pDepthStencilAttachment = depth_stencil_attachments[i].empty() ? nullptr : depth_stencil_attachments[i].data();
 
 		subpass_descriptions.push_back(subpass_description);
@@ -172,6 +247,16 @@ RenderPass::RenderPass(Device &device, const std::vector<Attachment> &attachment
 			}
 		}
 
+		for (uint32_t k = 0U; subpass.pResolveAttachments && k < subpass.colorAttachmentCount; ++k)
+		{
+			auto reference = subpass.pResolveAttachments[k];
+			// Set it only if not defined yet
+			if (reference.attachment != VK_ATTACHMENT_UNUSED && attachment_descriptions[reference.attachment].initialLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+			{
+				attachment_descriptions[reference.attachment].initialLayout = reference.layout;
+			}
+		}
+
 		if (subpass.pDepthStencilAttachment)
 		{
 			auto reference = *subpass.pDepthStencilAttachment;
@@ -215,27 +300,185 @@ RenderPass::RenderPass(Device &device, const std::vector<Attachment> &attachment
 		}
 	}
 
-	// Set subpass dependencies
-	std::vector<VkSubpassDependency> dependencies(subpass_count - 1);
+	// Attachments which no subpass uses stay in their initial layout, so that their contents are preserved
+	for (uint32_t i = 0U; i < attachment_descriptions.size(); ++i)
+	{
+		auto &attachment = attachment_descriptions[i];
+
+		if (attachment.initialLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+		{
+			continue;
+		}
+
+		auto uses_attachment = [i](const std::vector<VkAttachmentReference> &references) {
+			return std::find_if(references.begin(), references.end(), [i](const VkAttachmentReference &reference) { return reference.attachment == i; }) != references.end();
+		};
+
+		bool used = false;
+
+		for (uint32_t k = 0U; k < subpass_count && !used; ++k)
+		{
+			used = uses_attachment(input_attachments[k]) || uses_attachment(color_attachments[k]) || uses_attachment(depth_stencil_attachments[k]) || uses_attachment(color_resolve_attachments[k]);
+		}
+
+		if (!used)
+		{
+			attachment.finalLayout = attachment.initialLayout;
+		}
+	}
+
+	// Set subpass dependencies, by region as each subpass only accesses the pixel it is shading
+	std::vector<VkSubpassDependency> dependencies;
+
+	auto writes_attachment = [this](size_t subpass, uint32_t attachment) {
+		auto is_attachment = [attachment](const VkAttachmentReference &reference) { return reference.attachment == attachment; };
 
-	if (subpass_count > 1)
+		// Resolves write their attachments as color attachment writes
+		return std::find_if(color_attachments[subpass].begin(), color_attachments[subpass].end(), is_attachment) != color_attachments[subpass].end() ||
+		       std::find_if(color_resolve_attachments[subpass].begin(), color_resolve_attachments[subpass].end(), is_attachment) != color_resolve_attachments[subpass].end();
+	};
+
+	// Without rasterization order access, a subpass reading the color attachments it writes orders its draws
+	// with barriers, which require a dependency of the subpass on itself
+	for (uint32_t i = 0; i < subpasses.size(); ++i)
+	{
+		bool feedback = std::find_if(input_attachments[i].begin(), input_attachments[i].end(), [](const VkAttachmentReference &reference) { return reference.layout == VK_IMAGE_LAYOUT_GENERAL; }) != input_attachments[i].end();
+
+		if (feedback && subpass_flags[i] == 0)
+		{
+			VkSubpassDependency dependency{};
+			dependency.srcSubpass      = i;
+			dependency.dstSubpass      = i;
+			dependency.srcStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			dependency.dstStageMask    = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			dependency.srcAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			dependency.dstAccessMask   = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+			dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+			if (subpasses[i].view_mask != 0)
+			{
+				dependency.dependencyFlags |= VK_DEPENDENCY_VIEW_LOCAL_BIT_KHR;
+			}
+
+			dependencies.push_back(dependency);
+		}
+	}
+
+	for (uint32_t dst = 1; dst < subpass_descriptions.size(); ++dst)
 	{
-		for (uint32_t i = 0; i < dependencies.size(); ++i)
+		for (uint32_t src = 0; src < dst; ++src)
 		{
-			// Transition input attachments from color attachment to shader read
-			dependencies[i].srcSubpass      = i;
-			dependencies[i].dstSubpass      = i + 1;
-			dependencies[i].srcStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-			dependencies[i].dstStageMask    = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-			dependencies[i].srcAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			dependencies[i].dstAccessMask   = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
-			dependencies[i].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+			VkSubpassDependency dependency{};
+			dependency.srcSubpass      = src;
+			dependency.dstSubpass      = dst;
+			dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+			// Each view only reads the layer written for the same view
+			if (subpasses[src].view_mask != 0)
+			{
+				dependency.dependencyFlags |= VK_DEPENDENCY_VIEW_LOCAL_BIT_KHR;
+			}
+
+			bool src_depth = subpass_descriptions[src].pDepthStencilAttachment != nullptr;
+
+			// Transition input attachments from color or depth attachment to shader read
+			for (auto &reference : input_attachments[dst])
+			{
+				if (reference.attachment == depth_stencil_attachment && src_depth)
+				{
+					dependency.srcStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+					dependency.srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+					dependency.dstStageMask |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+					dependency.dstAccessMask |= VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+				}
+				else if (writes_attachment(src, reference.attachment))
+				{
+					dependency.srcStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+					dependency.srcAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+					dependency.dstStageMask |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+					dependency.dstAccessMask |= VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+				}
+			}
+
+			// Order writes to color attachments written by both subpasses
+			for (auto &reference : color_attachments[dst])
+			{
+				if (writes_attachment(src, reference.attachment))
+				{
+					dependency.srcStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+					dependency.srcAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+					dependency.dstStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+					dependency.dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+				}
+			}
+
+			// Order depth tests of both subpasses
+			if (src_depth && subpass_descriptions[dst].pDepthStencilAttachment != nullptr)
+			{
+				dependency.srcStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+				dependency.srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+				dependency.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+				dependency.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			}
+
+			// Consecutive subpasses keep the default dependency even if they share no attachment
+			if (dependency.srcStageMask == 0 && src + 1 == dst)
+			{
+				dependency.srcStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				dependency.dstStageMask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+				dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+				dependency.dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+			}
+
+			if (dependency.srcStageMask != 0)
+			{
+				dependencies.push_back(dependency);
+			}
 		}
 	}
 
+	// Views rendered by every subpass, either all subpasses use multiview or none
+	uint32_t correlation_mask = 0;
+
+	for (auto &subpass : subpasses)
+	{
+		assert((subpass.view_mask == 0) == (subpasses.front().view_mask == 0) && "All subpasses of a render pass must use multiview if one does");
+		assert((subpass.view_mask == 0 || device.is_multiview_enabled()) && "Multiview is not enabled on the device");
+
+		view_masks.push_back(subpass.view_mask);
+
+		// The views are the eyes of a stereo pair, which see almost the same part of the scene
+		correlation_mask |= subpass.view_mask;
+	}
+
+	VkRenderPassMultiviewCreateInfoKHR multiview_info{VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO_KHR};
+
+	multiview_info.subpassCount         = to_u32(view_masks.size());
+	multiview_info.pViewMasks           = view_masks.data();
+	multiview_info.correlationMaskCount = 1;
+	multiview_info.pCorrelationMasks    = &correlation_mask;
+
+	for (size_t i = 0; i < subpass_descriptions.size(); ++i)
+	{
+		auto &subpass_description = subpass_descriptions[i];
+
+		hash_attachment_references(compatibility_hash, attachment_descriptions, subpass_description.pInputAttachments, subpass_description.inputAttachmentCount);
+		hash_attachment_references(compatibility_hash, attachment_descriptions, subpass_description.pColorAttachments, subpass_description.colorAttachmentCount);
+		hash_attachment_references(compatibility_hash, attachment_descriptions, subpass_description.pResolveAttachments, subpass_description.pResolveAttachments ? subpass_description.colorAttachmentCount : 0U);
+		hash_attachment_references(compatibility_hash, attachment_descriptions, subpass_description.pDepthStencilAttachment, subpass_description.pDepthStencilAttachment ? 1U : 0U);
+
+		hash_combine(compatibility_hash, i < view_masks.size() ? view_masks[i] : 0U);
+		hash_combine(compatibility_hash, subpass_description.flags);
+	}
+
 	// Create render pass
 	VkRenderPassCreateInfo create_info{VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
 
+	if (correlation_mask != 0)
+	{
+		create_info.pNext = &multiview_info;
+	}
+
 	create_info.attachmentCount = to_u32(attachment_descriptions.size());
 	create_info.pAttachments    = attachment_descriptions.data();
 	create_info.subpassCount    = to_u32(subpass_count);
@@ -253,11 +496,17 @@ RenderPass::RenderPass(Device &device, const std::vector<Attachment> &attachment
 
 RenderPass::RenderPass(RenderPass &&other) :
     device{other.device},
+    id{other.id},
+    compatibility_hash{other.compatibility_hash},
     handle{other.handle},
     subpass_count{other.subpass_count},
     input_attachments{other.input_attachments},
     color_attachments{other.color_attachments},
-    depth_stencil_attachments{other.depth_stencil_attachments}
+    depth_stencil_attachments{other.depth_stencil_attachments},
+    color_resolve_attachments{other.color_resolve_attachments},
+    sample_counts{other.sample_counts},
+    subpass_flags{other.subpass_flags},
+    view_masks{other.view_masks}
 {
 	other.handle = VK_NULL_HANDLE;
 }
@@ -275,4 +524,19 @@ const uint32_t RenderPass::get_color_output_count(uint32_t subpass_index) const
 {
 	return to_u32(color_attachments[subpass_index].size());
 }
+
+VkSampleCountFlagBits RenderPass::get_sample_count(uint32_t subpass_index) const
+{
+	return sample_counts[subpass_index];
+}
+
+uint32_t RenderPass::get_view_mask(uint32_t subpass_index) const
+{
+	return subpass_index < view_masks.size() ? view_masks[subpass_index] : 0U;
+}
+
+bool RenderPass::is_rasterization_order_access(uint32_t subpass_index) const
+{
+	return (subpass_flags[subpass_index] & VK_SUBPASS_DESCRIPTION_RASTERIZATION_ORDER_ATTACHMENT_COLOR_ACCESS_BIT_EXT) != 0;
+}
 }        // namespace vkb
@@ -33,6 +33,16 @@ struct SubpassInfo
 	std::vector<uint32_t> input_attachments;
 
 	std::vector<uint32_t> output_attachments;
+
+	/// Attachment each color output is resolved to at the end of the subpass, VK_ATTACHMENT_UNUSED if not resolved
+	std::vector<uint32_t> color_resolve_attachments;
+
+	/// Layers of the attachments the subpass renders to in a single pass with multiview, 0 if multiview is not used
+	uint32_t view_mask{0};
+
+	/// Whether the color attachments the subpass also reads as input attachments are read in rasterization order,
+	/// if rasterization order attachment access is enabled on the device
+	bool rasterization_order_access{false};
 };
 
 class RenderPass
@@ -40,6 +50,18 @@ class RenderPass
   public:
 	VkRenderPass get_handle() const;
 
+	/**
+	 * @return The identifier of the render pass, unique for the lifetime of the device
+	 */
+	uint64_t get_id() const;
+
+	/**
+	 * @return A hash of what makes render passes compatible under Vulkan rules: the formats and sample counts
+	 *         of the attachments each subpass references, and the view masks. Load and store operations and
+	 *         layouts are left out, so that pipelines created for a render pass can be used with compatible ones
+	 */
+	std::size_t get_compatibility_hash() const;
+
 	RenderPass(Device &                          device,
 	           const std::vector<Attachment> &   attachemnts,
 	           const std::vector<LoadStoreInfo> &load_store_infos,
@@ -57,9 +79,29 @@ class RenderPass
 
 	const uint32_t get_color_output_count(uint32_t subpass_index) const;
 
+	/**
+	 * @return The sample count of the attachments a subpass renders to
+	 */
+	VkSampleCountFlagBits get_sample_count(uint32_t subpass_index) const;
+
+	/**
+	 * @return Whether the subpass reads its color attachments in rasterization order, in which case
+	 *         its pipelines must be created with rasterization order attachment access
+	 */
+	bool is_rasterization_order_access(uint32_t subpass_index) const;
+
+	/**
+	 * @return The views a subpass renders with multiview, 0 if the render pass does not use multiview
+	 */
+	uint32_t get_view_mask(uint32_t subpass_index) const;
+
   private:
 	Device &device;
 
+	uint64_t id;
+
+	std::size_t compatibility_hash{0};
+
 	VkRenderPass handle{VK_NULL_HANDLE};
 
 	size_t subpass_count;
@@ -70,5 +112,13 @@ class RenderPass
 	std::vector<std::vector<VkAttachmentReference>> color_attachments;
 
 	std::vector<std::vector<VkAttachmentReference>> depth_stencil_attachments;
+
+	std::vector<std::vector<VkAttachmentReference>> color_resolve_attachments;
+
+	std::vector<VkSampleCountFlagBits> sample_counts;
+
+	std::vector<VkSubpassDescriptionFlags> subpass_flags;
+
+	std::vector<uint32_t> view_masks;
 };
 }        // namespace vkb
@@ -20,6 +20,8 @@
 
 #include "shader_module.h"
 
+#include <mutex>
+
 #include "common/logging.h"
 #include "device.h"
 #include "glsl_compiler.h"
@@ -28,10 +30,61 @@
 
 namespace vkb
 {
+namespace
+{
+/**
+ * @brief Processes of all the shader variants, which variants refer to by index
+ *        Processes are never removed, so that the indices stay valid
+ */
+struct ProcessTable
+{
+	struct Process
+	{
+		std::string process;
+
+		size_t hash;
+	};
+
+	std::mutex mutex;
+
+	std::vector<Process> processes;
+
+	std::unordered_map<std::string, uint32_t> indices;
+};
+
+ProcessTable &get_process_table()
+{
+	static ProcessTable table;
+	return table;
+}
+
+/**
+ * @brief Reads the resources reflected by a previous run from the temporary directory
+ * @return Whether a valid cache file was found
+ */
+bool read_reflection_cache(uint64_t key, std::vector<ShaderResource> &resources)
+{
+	std::vector<uint8_t> data;
+
+	try
+	{
+		data = fs::read_temp(SPIRVReflection::get_reflection_filename(key));
+	}
+	catch (std::runtime_error &)
+	{
+		return false;
+	}
+
+	return SPIRVReflection::decode_reflection_file(key, data, resources);
+}
+}        // namespace
+
 ShaderModule::ShaderModule(Device &device, VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant) :
     device{device},
     stage{stage},
-    entry_point{entry_point}
+    entry_point{entry_point},
+    debug_name{glsl_source.get_filename()},
+    variant{shader_variant}
 {
 	// Check if application is passing in GLSL source code to compile to SPIR-V
 	if (glsl_source.get_data().empty())
@@ -60,12 +113,27 @@ ShaderModule::ShaderModule(Device &device, VkShaderStageFlagBits stage, const Sh
 		}
 	}
 
-	SPIRVReflection spirv_reflection;
+	// The resources are keyed by the same hash as the SPIRV, so an unchanged shader is not parsed again
+	uint64_t reflection_key = SPIRVReflection::get_reflection_key(GLSLCompiler::get_spirv_key(stage, glsl_source.get_data(), entry_point, shader_variant), shader_variant);
 
-	// Reflect all shader resouces
-	if (!spirv_reflection.reflect_shader_resources(stage, spirv, resources, shader_variant))
+	if (!read_reflection_cache(reflection_key, resources))
 	{
-		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
+		SPIRVReflection spirv_reflection;
+
+		// Reflect all shader resouces
+		if (!spirv_reflection.reflect_shader_resources(stage, spirv, resources, shader_variant))
+		{
+			throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
+		}
+
+		try
+		{
+			fs::write_temp(SPIRVReflection::encode_reflection_file(reflection_key, resources), SPIRVReflection::get_reflection_filename(reflection_key));
+		}
+		catch (std::runtime_error &ex)
+		{
+			LOGW("Failed to write the reflection cache. {}", ex.what());
+		}
 	}
 
 	// Generate a unique id, determined by source and variant
@@ -78,6 +146,8 @@ ShaderModule::ShaderModule(ShaderModule &&other) :
     id{other.id},
     stage{other.stage},
     entry_point{other.entry_point},
+    debug_name{other.debug_name},
+    variant{other.variant},
     spirv{other.spirv},
     resources{other.resources},
     info_log{other.info_log}
@@ -100,6 +170,11 @@ const std::string &ShaderModule::get_entry_point() const
 	return entry_point;
 }
 
+const std::string &ShaderModule::get_debug_name() const
+{
+	return debug_name;
+}
+
 const std::vector<ShaderResource> &ShaderModule::get_resources() const
 {
 	return resources;
@@ -115,6 +190,42 @@ const std::vector<uint32_t> &ShaderModule::get_binary() const
 	return spirv;
 }
 
+const ShaderVariant &ShaderModule::get_variant() const
+{
+	return variant;
+}
+
+void ShaderModule::set_binary(std::vector<uint32_t> &&binary)
+{
+	spirv = std::move(binary);
+}
+
+bool ShaderModule::has_same_resources(const std::vector<ShaderResource> &other_resources) const
+{
+	if (resources.size() != other_resources.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < resources.size(); ++i)
+	{
+		auto &resource       = resources[i];
+		auto &other_resource = other_resources[i];
+
+		if (resource.type != other_resource.type || resource.set != other_resource.set || resource.binding != other_resource.binding ||
+		    resource.location != other_resource.location || resource.input_attachment_index != other_resource.input_attachment_index ||
+		    resource.vec_size != other_resource.vec_size || resource.columns != other_resource.columns ||
+		    resource.array_size != other_resource.array_size || resource.offset != other_resource.offset ||
+		    resource.size != other_resource.size || resource.constant_id != other_resource.constant_id ||
+		    resource.stages != other_resource.stages || resource.name != other_resource.name)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
 void ShaderModule::set_resource_dynamic(const std::string &resource_name)
 {
 	auto it = std::find_if(resources.begin(), resources.end(), [&resource_name](const ShaderResource &resource) { return resource.name == resource_name; });
@@ -136,11 +247,34 @@ void ShaderModule::set_resource_dynamic(const std::string &resource_name)
 	}
 }
 
-ShaderVariant::ShaderVariant(std::string &&preamble, std::vector<std::string> &&processes) :
-    preamble{std::move(preamble)},
-    processes{std::move(processes)}
+void ShaderModule::set_resource_push(const std::string &resource_name)
+{
+	auto it = std::find_if(resources.begin(), resources.end(), [&resource_name](const ShaderResource &resource) { return resource.name == resource_name; });
+
+	if (it != resources.end())
+	{
+		if (it->type != ShaderResourceType::Input && it->type != ShaderResourceType::Output &&
+		    it->type != ShaderResourceType::PushConstant && it->type != ShaderResourceType::SpecializationConstant)
+		{
+			it->push = true;
+		}
+		else
+		{
+			LOGW("Resource `{}` does not support push descriptors.", resource_name);
+		}
+	}
+	else
+	{
+		LOGW("Resource `{}` not found for shader.", resource_name);
+	}
+}
+
+ShaderVariant::ShaderVariant(const std::vector<std::string> &processes)
 {
-	update_id();
+	for (auto &process : processes)
+	{
+		add_process(std::string{process});
+	}
 }
 
 size_t ShaderVariant::get_id() const
@@ -150,29 +284,35 @@ size_t ShaderVariant::get_id() const
 
 void ShaderVariant::add_define(const std::string &def)
 {
-	processes.push_back("D" + def);
+	add_process("D" + def);
+}
 
-	std::string tmp_def = def;
+void ShaderVariant::add_undefine(const std::string &undef)
+{
+	add_process("U" + undef);
+}
 
-	// The "=" needs to turn into a space
-	size_t pos_equal = tmp_def.find_first_of("=");
-	if (pos_equal != std::string::npos)
-	{
-		tmp_def[pos_equal] = ' ';
-	}
+void ShaderVariant::add_process(std::string &&process)
+{
+	auto &table = get_process_table();
 
-	preamble.append("#define " + tmp_def + "\n");
+	std::lock_guard<std::mutex> lock{table.mutex};
 
-	update_id();
-}
+	auto it = table.indices.find(process);
 
-void ShaderVariant::add_undefine(const std::string &undef)
-{
-	processes.push_back("U" + undef);
+	if (it == table.indices.end())
+	{
+		// Hashed once, when the process is first used by any variant
+		std::hash<std::string> hasher{};
+		size_t                 hash = hasher(process);
+
+		it = table.indices.emplace(process, to_u32(table.processes.size())).first;
+		table.processes.push_back({std::move(process), hash});
+	}
 
-	preamble.append("#undef " + undef + "\n");
+	processes.push_back(it->second);
 
-	update_id();
+	hash_combine(id, table.processes[it->second].hash);
 }
 
 void ShaderVariant::add_runtime_array_size(const std::string &runtime_array_name, size_t size)
@@ -192,14 +332,55 @@ void ShaderVariant::set_runtime_array_sizes(const std::unordered_map<std::string
 	this->runtime_array_sizes = sizes;
 }
 
-const std::string &ShaderVariant::get_preamble() const
+std::string ShaderVariant::get_preamble() const
 {
+	auto &table = get_process_table();
+
+	std::lock_guard<std::mutex> lock{table.mutex};
+
+	std::string preamble;
+
+	for (auto index : processes)
+	{
+		auto &process = table.processes[index].process;
+
+		if (process[0] == 'D')
+		{
+			std::string def = process.substr(1);
+
+			// The "=" needs to turn into a space
+			size_t pos_equal = def.find_first_of("=");
+			if (pos_equal != std::string::npos)
+			{
+				def[pos_equal] = ' ';
+			}
+
+			preamble.append("#define " + def + "\n");
+		}
+		else
+		{
+			preamble.append("#undef " + process.substr(1) + "\n");
+		}
+	}
+
 	return preamble;
 }
 
-const std::vector<std::string> &ShaderVariant::get_processes() const
+std::vector<std::string> ShaderVariant::get_processes() const
 {
-	return processes;
+	auto &table = get_process_table();
+
+	std::lock_guard<std::mutex> lock{table.mutex};
+
+	std::vector<std::string> result;
+	result.reserve(processes.size());
+
+	for (auto index : processes)
+	{
+		result.push_back(table.processes[index].process);
+	}
+
+	return result;
 }
 
 const std::unordered_map<std::string, size_t> &ShaderVariant::get_runtime_array_sizes() const
@@ -209,16 +390,9 @@ const std::unordered_map<std::string, size_t> &ShaderVariant::get_runtime_array_
 
 void ShaderVariant::clear()
 {
-	preamble.clear();
 	processes.clear();
 	runtime_array_sizes.clear();
-	update_id();
-}
-
-void ShaderVariant::update_id()
-{
-	std::hash<std::string> hasher{};
-	id = hasher(preamble);
+	id = 0;
 }
 
 ShaderSource::ShaderSource(std::vector<uint8_t> &&data) :
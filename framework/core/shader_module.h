@@ -74,19 +74,28 @@ struct ShaderResource
 
 	bool dynamic;
 
+	bool push;
+
 	std::string name;
 };
 
 /**
  * @brief Adds support for C style preprocessor macros to glsl shaders
  *        enabling you to define or undefine certain symbols
+ *
+ * The defines and undefines are interned in a table shared by all the variants, so that a variant
+ * only holds their indices and its id is updated as they are added. The preamble passed to the
+ * compiler is only generated when a shader is compiled.
  */
 class ShaderVariant
 {
   public:
 	ShaderVariant() = default;
 
-	ShaderVariant(std::string &&preamble, std::vector<std::string> &&processes);
+	/**
+	 * @brief Creates a variant from processes, as returned by get_processes()
+	 */
+	ShaderVariant(const std::vector<std::string> &processes);
 
 	size_t get_id() const;
 
@@ -112,24 +121,32 @@ class ShaderVariant
 
 	void set_runtime_array_sizes(const std::unordered_map<std::string, size_t> &sizes);
 
-	const std::string &get_preamble() const;
+	/**
+	 * @return The define and undef directives of the variant, in the order they were added
+	 */
+	std::string get_preamble() const;
 
-	const std::vector<std::string> &get_processes() const;
+	/**
+	 * @return The processes of the variant, a define being prefixed with "D" and an undefine with "U"
+	 */
+	std::vector<std::string> get_processes() const;
 
 	const std::unordered_map<std::string, size_t> &get_runtime_array_sizes() const;
 
 	void clear();
 
   private:
-	size_t id;
-
-	std::string preamble;
+	size_t id{0};
 
-	std::vector<std::string> processes;
+	/// Indices of the processes in the table of interned processes, in the order they were added
+	std::vector<uint32_t> processes;
 
 	std::unordered_map<std::string, size_t> runtime_array_sizes;
 
-	void update_id();
+	/**
+	 * @brief Interns a process and updates the id of the variant with it
+	 */
+	void add_process(std::string &&process);
 };
 
 class ShaderSource
@@ -187,14 +204,43 @@ class ShaderModule
 
 	const std::string &get_entry_point() const;
 
+	/**
+	 * @return The filename of the source the module was compiled from
+	 */
+	const std::string &get_debug_name() const;
+
+	/**
+	 * @return The variant the module was compiled with
+	 */
+	const ShaderVariant &get_variant() const;
+
 	const std::vector<ShaderResource> &get_resources() const;
 
 	const std::string &get_info_log() const;
 
 	const std::vector<uint32_t> &get_binary() const;
 
+	/**
+	 * @brief Replaces the code with a recompilation of an edited source, keeping the id of the module
+	 *        The resources of the new code must be those of the previous one, as the layouts created
+	 *        from them are kept. The pipelines created from the previous code are not affected.
+	 */
+	void set_binary(std::vector<uint32_t> &&binary);
+
+	/**
+	 * @return Whether the resources reflected from a recompilation match those of the module,
+	 *         ignoring which ones were made dynamic or pushed
+	 */
+	bool has_same_resources(const std::vector<ShaderResource> &other_resources) const;
+
 	void set_resource_dynamic(const std::string &resource_name);
 
+	/**
+	 * @brief Marks the set of a resource to be written with push descriptors, if VK_KHR_push_descriptor is enabled
+	 *        All the bindings of the set are then pushed, and its buffers are not dynamic
+	 */
+	void set_resource_push(const std::string &resource_name);
+
   private:
 	Device &device;
 
@@ -207,6 +253,10 @@ class ShaderModule
 	/// Name of the main function
 	std::string entry_point;
 
+	std::string debug_name;
+
+	ShaderVariant variant;
+
 	/// Compiled source
 	std::vector<uint32_t> spirv;
 
@@ -283,6 +283,21 @@ Swapchain::Swapchain(Swapchain &                         old_swapchain,
 	create_info.surface      = surface;
 	create_info.oldSwapchain = old_swapchain.get_handle();
 
+	// Each GPU of a device group presents the images it rendered, on its own or along with the others
+	VkDeviceGroupSwapchainCreateInfoKHR device_group_info{VK_STRUCTURE_TYPE_DEVICE_GROUP_SWAPCHAIN_CREATE_INFO_KHR};
+	if (this->device.is_device_group_enabled())
+	{
+		VkDeviceGroupPresentModeFlagsKHR surface_modes{0};
+		VK_CHECK(vkGetDeviceGroupSurfacePresentModesKHR(this->device.get_handle(), surface, &surface_modes));
+
+		device_group_info.modes = surface_modes & (VK_DEVICE_GROUP_PRESENT_MODE_LOCAL_BIT_KHR | VK_DEVICE_GROUP_PRESENT_MODE_LOCAL_MULTI_DEVICE_BIT_KHR);
+
+		if (device_group_info.modes)
+		{
+			create_info.pNext = &device_group_info;
+		}
+	}
+
 	VkResult result = vkCreateSwapchainKHR(this->device.get_handle(), &create_info, nullptr, &handle);
 
 	if (result != VK_SUCCESS)
@@ -301,6 +316,8 @@ Swapchain::Swapchain(Swapchain &                         old_swapchain,
 	this->image_count  = create_info.minImageCount;
 	this->transform    = create_info.preTransform;
 	this->present_mode = create_info.presentMode;
+
+	device_group_present_modes = device_group_info.modes;
 	this->format       = create_info.imageFormat;
 	this->image_usage  = create_info.imageUsage;
 }
@@ -322,7 +339,8 @@ Swapchain::Swapchain(Swapchain &&other) :
     format{other.format},
     image_count{other.image_count},
     transform{other.transform},
-    present_mode{other.present_mode}
+    present_mode{other.present_mode},
+    device_group_present_modes{other.device_group_present_modes}
 {
 	other.handle  = VK_NULL_HANDLE;
 	other.surface = VK_NULL_HANDLE;
@@ -338,8 +356,20 @@ VkSwapchainKHR Swapchain::get_handle() const
 	return handle;
 }
 
-VkResult Swapchain::acquire_next_image(uint32_t &image_index, VkSemaphore image_acquired_semaphore, VkFence fence)
+VkResult Swapchain::acquire_next_image(uint32_t &image_index, VkSemaphore image_acquired_semaphore, VkFence fence, uint32_t device_mask)
 {
+	if (device_mask != 0 && device.is_device_group_enabled())
+	{
+		VkAcquireNextImageInfoKHR acquire_info{VK_STRUCTURE_TYPE_ACQUIRE_NEXT_IMAGE_INFO_KHR};
+		acquire_info.swapchain  = handle;
+		acquire_info.timeout    = std::numeric_limits<uint64_t>::max();
+		acquire_info.semaphore  = image_acquired_semaphore;
+		acquire_info.fence      = fence;
+		acquire_info.deviceMask = device_mask;
+
+		return vkAcquireNextImage2KHR(device.get_handle(), &acquire_info, &image_index);
+	}
+
 	return vkAcquireNextImageKHR(device.get_handle(), handle, std::numeric_limits<uint64_t>::max(), image_acquired_semaphore, fence, &image_index);
 }
 
@@ -377,4 +407,9 @@ VkPresentModeKHR Swapchain::get_present_mode() const
 {
 	return present_mode;
 }
+
+VkDeviceGroupPresentModeFlagsKHR Swapchain::get_device_group_present_modes() const
+{
+	return device_group_present_modes;
+}
 }        // namespace vkb
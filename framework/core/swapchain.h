@@ -92,7 +92,10 @@ class Swapchain
 
 	VkSwapchainKHR get_handle() const;
 
-	VkResult acquire_next_image(uint32_t &image_index, VkSemaphore image_acquired_semaphore, VkFence fence);
+	/**
+	 * @param device_mask GPUs of a device group which may use the image, 0 for the default of the device
+	 */
+	VkResult acquire_next_image(uint32_t &image_index, VkSemaphore image_acquired_semaphore, VkFence fence, uint32_t device_mask = 0);
 
 	const VkExtent2D &get_extent() const;
 
@@ -108,6 +111,11 @@ class Swapchain
 
 	VkPresentModeKHR get_present_mode() const;
 
+	/**
+	 * @return The modes the GPUs of a device group can present the images with, 0 without a device group
+	 */
+	VkDeviceGroupPresentModeFlagsKHR get_device_group_present_modes() const;
+
   private:
 	Device &device;
 
@@ -128,5 +136,7 @@ class Swapchain
 	VkPresentModeKHR present_mode{};
 
 	VkImageUsageFlags image_usage{};
+
+	VkDeviceGroupPresentModeFlagsKHR device_group_present_modes{0};
 };
 }        // namespace vkb
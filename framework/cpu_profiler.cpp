@@ -0,0 +1,181 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "cpu_profiler.h"
+
+#include <iomanip>
+#include <sstream>
+
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+constexpr size_t CpuProfiler::EVENTS_PER_THREAD;
+
+CpuProfiler &CpuProfiler::get()
+{
+	static CpuProfiler profiler;
+	return profiler;
+}
+
+void CpuProfiler::set_enabled(bool enable)
+{
+	enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool CpuProfiler::is_enabled() const
+{
+	return enabled.load(std::memory_order_relaxed);
+}
+
+CpuProfiler::ThreadEvents &CpuProfiler::get_thread_events()
+{
+	thread_local ThreadEvents *thread_events = nullptr;
+
+	if (!thread_events)
+	{
+		std::lock_guard<std::mutex> guard(threads_mutex);
+
+		threads.push_back(std::make_unique<ThreadEvents>());
+
+		thread_events            = threads.back().get();
+		thread_events->thread_id = to_u32(threads.size() - 1);
+		thread_events->events.reserve(EVENTS_PER_THREAD);
+	}
+
+	return *thread_events;
+}
+
+void CpuProfiler::record(const char *name, Clock::time_point begin, Clock::time_point end)
+{
+	auto &thread_events = get_thread_events();
+
+	std::lock_guard<std::mutex> guard(thread_events.mutex);
+
+	if (thread_events.events.size() < EVENTS_PER_THREAD)
+	{
+		thread_events.events.push_back({name, begin, end});
+	}
+	else
+	{
+		thread_events.events[thread_events.next] = {name, begin, end};
+	}
+
+	thread_events.next = (thread_events.next + 1) % EVENTS_PER_THREAD;
+}
+
+void CpuProfiler::record_counter(const std::string &name, Clock::time_point time, double value)
+{
+	std::lock_guard<std::mutex> guard(counters_mutex);
+
+	if (counter_events.size() < EVENTS_PER_THREAD)
+	{
+		counter_events.push_back({name, time, value});
+	}
+	else
+	{
+		counter_events[next_counter] = {name, time, value};
+	}
+
+	next_counter = (next_counter + 1) % EVENTS_PER_THREAD;
+}
+
+void CpuProfiler::write_trace(const std::string &filename)
+{
+	std::stringstream trace;
+
+	// Timestamps are written in microseconds, keeping a nanosecond resolution
+	trace << std::fixed << std::setprecision(3);
+
+	trace << "{\"traceEvents\":[";
+
+	bool first = true;
+
+	auto to_microseconds = [this](Clock::time_point time) {
+		return std::chrono::duration<double, std::micro>(time - start_time).count();
+	};
+
+	std::lock_guard<std::mutex> threads_guard(threads_mutex);
+
+	for (auto &thread_events : threads)
+	{
+		std::lock_guard<std::mutex> guard(thread_events->mutex);
+
+		if (!first)
+		{
+			trace << ",";
+		}
+		first = false;
+
+		trace << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread_events->thread_id
+		      << ",\"args\":{\"name\":\"Thread " << thread_events->thread_id << "\"}}";
+
+		for (auto &event : thread_events->events)
+		{
+			trace << ",{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread_events->thread_id
+			      << ",\"ts\":" << to_microseconds(event.begin)
+			      << ",\"dur\":" << std::chrono::duration<double, std::micro>(event.end - event.begin).count() << "}";
+		}
+	}
+
+	std::lock_guard<std::mutex> counters_guard(counters_mutex);
+
+	for (auto &counter : counter_events)
+	{
+		if (!first)
+		{
+			trace << ",";
+		}
+		first = false;
+
+		trace << "{\"name\":\"" << counter.name << "\",\"ph\":\"C\",\"pid\":0"
+		      << ",\"ts\":" << to_microseconds(counter.time)
+		      << ",\"args\":{\"value\":" << counter.value << "}}";
+	}
+
+	trace << "],\"displayTimeUnit\":\"ms\"}";
+
+	std::string trace_string = trace.str();
+
+	fs::write_temp({trace_string.begin(), trace_string.end()}, filename);
+
+	LOGI("CPU trace written to {}", filename);
+}
+
+CpuProfileScope::CpuProfileScope(const char *name) :
+    name{name},
+    active{CpuProfiler::get().is_enabled()}
+{
+	if (active)
+	{
+		begin = CpuProfiler::Clock::now();
+	}
+}
+
+CpuProfileScope::~CpuProfileScope()
+{
+	if (active)
+	{
+		CpuProfiler::get().record(name, begin, CpuProfiler::Clock::now());
+	}
+}
+}        // namespace vkb
@@ -0,0 +1,168 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief Records the CPU time of nested scopes on every thread, to be exported as a Chrome trace
+ *        which can be opened with chrome://tracing or Perfetto
+ *
+ * Each thread records to a ring buffer of its own, overwriting its oldest scopes when it is full.
+ * Recording is disabled by default, an instrumented scope then only costs the check of a flag.
+ */
+class CpuProfiler
+{
+  public:
+	using Clock = std::chrono::steady_clock;
+
+	/**
+	 * @brief Number of scopes each thread keeps
+	 */
+	static constexpr size_t EVENTS_PER_THREAD = 1 << 16;
+
+	static CpuProfiler &get();
+
+	CpuProfiler(const CpuProfiler &) = delete;
+
+	CpuProfiler(CpuProfiler &&) = delete;
+
+	CpuProfiler &operator=(const CpuProfiler &) = delete;
+
+	CpuProfiler &operator=(CpuProfiler &&) = delete;
+
+	void set_enabled(bool enabled);
+
+	bool is_enabled() const;
+
+	/**
+	 * @brief Records a scope of the calling thread
+	 * @param name Name of the scope, which must outlive the profiler such as a string literal
+	 */
+	void record(const char *name, Clock::time_point begin, Clock::time_point end);
+
+	/**
+	 * @brief Records the value of a counter at a point in time, shown as a graph alongside the scopes
+	 * @param name Name of the counter
+	 */
+	void record_counter(const std::string &name, Clock::time_point time, double value);
+
+	/**
+	 * @brief Writes the recorded scopes of all threads to the temporary storage
+	 *        in the Chrome trace event format
+	 * @param filename The path to the file, relative to the temporary storage directory
+	 */
+	void write_trace(const std::string &filename);
+
+  private:
+	struct Event
+	{
+		const char *name;
+
+		Clock::time_point begin;
+
+		Clock::time_point end;
+	};
+
+	struct ThreadEvents
+	{
+		uint32_t thread_id;
+
+		/// Only contended while the trace is written
+		std::mutex mutex;
+
+		std::vector<Event> events;
+
+		/// Index the next event is written to
+		size_t next{0};
+	};
+
+	struct CounterEvent
+	{
+		std::string name;
+
+		Clock::time_point time;
+
+		double value;
+	};
+
+	CpuProfiler() = default;
+
+	/**
+	 * @return The events of the calling thread, registered on first use
+	 */
+	ThreadEvents &get_thread_events();
+
+	std::atomic<bool> enabled{false};
+
+	Clock::time_point start_time{Clock::now()};
+
+	std::mutex threads_mutex;
+
+	/// Events of every thread that recorded a scope, kept until the end of the program
+	std::vector<std::unique_ptr<ThreadEvents>> threads;
+
+	std::mutex counters_mutex;
+
+	/// Counter values of all threads, overwriting the oldest when full
+	std::vector<CounterEvent> counter_events;
+
+	/// Index the next counter value is written to
+	size_t next_counter{0};
+};
+
+/**
+ * @brief Records the CPU time from its construction to its destruction
+ */
+class CpuProfileScope
+{
+  public:
+	CpuProfileScope(const char *name);
+
+	~CpuProfileScope();
+
+	CpuProfileScope(const CpuProfileScope &) = delete;
+
+	CpuProfileScope &operator=(const CpuProfileScope &) = delete;
+
+  private:
+	const char *name;
+
+	bool active;
+
+	CpuProfiler::Clock::time_point begin;
+};
+}        // namespace vkb
+
+#define VKB_PROFILE_CONCAT_INNER(a, b) a##b
+#define VKB_PROFILE_CONCAT(a, b) VKB_PROFILE_CONCAT_INNER(a, b)
+
+/**
+ * @brief Profiles the CPU time of the rest of the enclosing scope
+ */
+#define VKB_PROFILE_SCOPE(name) vkb::CpuProfileScope VKB_PROFILE_CONCAT(cpu_profile_scope_, __LINE__)(name)
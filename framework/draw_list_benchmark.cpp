@@ -0,0 +1,132 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "draw_list_benchmark.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "common/logging.h"
+#include "platform/filesystem.h"
+#include "platform/platform.h"
+#include "timer.h"
+
+namespace vkb
+{
+DrawListBenchmark::DrawListBenchmark(const std::string &draw_list_path, uint32_t replay_count) :
+    draw_list_path{draw_list_path},
+    replay_count{std::max(replay_count, 1u)}
+{
+}
+
+bool DrawListBenchmark::prepare(Platform &platform)
+{
+	if (!VulkanSample::prepare(platform))
+	{
+		return false;
+	}
+
+	this->platform = &platform;
+
+	auto data = fs::read_temp(draw_list_path);
+
+	if (data.empty())
+	{
+		LOGE("Cannot read draw list {}", draw_list_path);
+		return false;
+	}
+
+	try
+	{
+		replay = std::make_unique<DrawListReplay>(*device, data);
+	}
+	catch (const std::exception &e)
+	{
+		LOGE("Cannot replay draw list {}: {}", draw_list_path, e.what());
+		return false;
+	}
+
+	return true;
+}
+
+void DrawListBenchmark::update(float delta_time)
+{
+	auto &command_buffer = render_context->begin();
+
+	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+	Timer timer;
+	timer.start();
+
+	replay->play(command_buffer);
+
+	record_times.push_back(timer.stop<Timer::Milliseconds>());
+
+	replay_counters = command_buffer.get_counters();
+
+	{
+		// The swapchain image is not rendered to by the draw list, which renders to its own render targets
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout     = VK_IMAGE_LAYOUT_UNDEFINED;
+		memory_barrier.new_layout     = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		memory_barrier.src_stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		memory_barrier.dst_stage_mask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+		command_buffer.image_memory_barrier(render_context->get_active_frame().get_present_render_target().get_views().at(0), memory_barrier);
+	}
+
+	command_buffer.end();
+
+	render_context->submit(command_buffer);
+
+	if (record_times.size() == replay_count)
+	{
+		write_report();
+
+		platform->close();
+	}
+}
+
+void DrawListBenchmark::write_report()
+{
+	// The first replays also create the descriptor sets and framebuffers, the minimum shows the cost of the cached path
+	double sum      = std::accumulate(record_times.begin(), record_times.end(), 0.0);
+	double min_time = *std::min_element(record_times.begin(), record_times.end());
+
+	nlohmann::json report;
+	report["draw_list"]            = draw_list_path;
+	report["replays"]              = replay_count;
+	report["commands"]             = replay->get_command_count();
+	report["time_unit"]            = "ms";
+	report["record_times"]         = record_times;
+	report["mean"]                 = sum / record_times.size();
+	report["min"]                  = min_time;
+	report["draw_calls"]           = replay_counters.draw_calls;
+	report["pipeline_binds"]       = replay_counters.pipeline_binds;
+	report["descriptor_set_binds"] = replay_counters.descriptor_set_binds;
+	report["vertex_buffer_binds"]  = replay_counters.vertex_buffer_binds;
+
+	std::string report_string = report.dump(4);
+	fs::write_temp({report_string.begin(), report_string.end()}, "draw_list_benchmark_report.json");
+
+	LOGI("Replayed {} commands {} times: mean {:.3f} ms, min {:.3f} ms", replay->get_command_count(), replay_count, sum / record_times.size(), min_time);
+	LOGI("Draw list benchmark report written to draw_list_benchmark_report.json");
+}
+}        // namespace vkb
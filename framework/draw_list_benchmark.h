@@ -0,0 +1,70 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "draw_list_replay.h"
+#include "vulkan_sample.h"
+
+namespace vkb
+{
+/**
+ * @brief Replays a draw list captured by a sample, one replay per frame, and reports the CPU time spent recording each replay
+ *
+ * The draw list is read from the temporary directory, see VulkanSample::set_draw_list_capture().
+ * The recording times of the replays, their mean and minimum, and the counters of a replay are written
+ * to draw_list_benchmark_report.json in the temporary directory, then the platform is closed.
+ */
+class DrawListBenchmark : public VulkanSample
+{
+  public:
+	/**
+	 * @param draw_list_path Path of the draw list, relative to the temporary directory
+	 * @param replay_count Number of times the draw list is replayed
+	 */
+	DrawListBenchmark(const std::string &draw_list_path, uint32_t replay_count);
+
+	virtual ~DrawListBenchmark() = default;
+
+	virtual bool prepare(Platform &platform) override;
+
+	virtual void update(float delta_time) override;
+
+  private:
+	std::string draw_list_path;
+
+	uint32_t replay_count;
+
+	Platform *platform{nullptr};
+
+	std::unique_ptr<DrawListReplay> replay;
+
+	/// CPU time spent recording each replay, in milliseconds
+	std::vector<double> record_times;
+
+	CommandBufferCounters replay_counters;
+
+	void write_report();
+};
+}        // namespace vkb
@@ -0,0 +1,182 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "draw_list_record.h"
+
+#include <algorithm>
+
+#include "core/buffer.h"
+#include "core/image_view.h"
+#include "core/sampler.h"
+#include "resource_cache.h"
+
+namespace vkb
+{
+DrawListRecord::DrawListRecord(ResourceCache &resource_cache) :
+    resource_cache{resource_cache}
+{
+}
+
+uint32_t DrawListRecord::get_buffer_index(VkBuffer buffer)
+{
+	auto it = buffer_indices.find(buffer);
+	if (it != buffer_indices.end())
+	{
+		return it->second;
+	}
+
+	uint32_t index = to_u32(buffer_sizes.size());
+
+	buffer_indices.emplace(buffer, index);
+	buffer_sizes.push_back(0);
+
+	return index;
+}
+
+void DrawListRecord::register_buffer_size(VkBuffer buffer, VkDeviceSize size)
+{
+	auto &buffer_size = buffer_sizes[get_buffer_index(buffer)];
+
+	buffer_size = std::max(buffer_size, size);
+}
+
+void DrawListRecord::set_vertex_bindings(const std::vector<VkVertexInputBindingDescription> &bindings)
+{
+	vertex_bindings = bindings;
+}
+
+void DrawListRecord::bind_vertex_buffer(uint32_t binding, VkBuffer buffer, VkDeviceSize offset)
+{
+	bound_vertex_buffers[binding] = std::make_pair(buffer, offset);
+}
+
+void DrawListRecord::register_fetched_vertices(uint32_t vertex_end, uint32_t instance_end)
+{
+	for (auto &binding : vertex_bindings)
+	{
+		auto it = bound_vertex_buffers.find(binding.binding);
+		if (it == bound_vertex_buffers.end())
+		{
+			continue;
+		}
+
+		uint32_t element_end = binding.inputRate == VK_VERTEX_INPUT_RATE_INSTANCE ? instance_end : vertex_end;
+
+		register_buffer_size(it->second.first, it->second.second + static_cast<VkDeviceSize>(element_end) * binding.stride);
+	}
+}
+
+uint32_t DrawListRecord::get_image_view_index(const core::ImageView &image_view)
+{
+	auto it = image_view_indices.find(image_view.get_id());
+	if (it != image_view_indices.end())
+	{
+		return it->second;
+	}
+
+	auto &image             = image_view.get_image();
+	auto  subresource_range = image_view.get_subresource_range();
+
+	DrawListImageView view;
+	view.view_type       = image_view.get_view_type();
+	view.format          = image_view.get_format();
+	view.extent          = image.get_extent();
+	view.samples         = image.get_sample_count();
+	view.usage           = image.get_usage();
+	view.mip_levels      = image.get_subresource().mipLevel;
+	view.array_layers    = image.get_subresource().arrayLayer;
+	view.base_mip_level  = subresource_range.baseMipLevel;
+	view.mip_level_count = subresource_range.levelCount;
+
+	uint32_t index = to_u32(image_views.size());
+
+	image_view_indices.emplace(image_view.get_id(), index);
+	image_views.push_back(view);
+
+	return index;
+}
+
+uint32_t DrawListRecord::get_sampler_index(const core::Sampler &sampler)
+{
+	// Samplers keep no description, they are all replayed with the same settings
+	return sampler_indices.emplace(sampler.get_handle(), to_u32(sampler_indices.size())).first->second;
+}
+
+uint32_t DrawListRecord::get_render_target_index(const RenderTarget &render_target)
+{
+	auto it = render_target_indices.find(&render_target);
+	if (it != render_target_indices.end())
+	{
+		return it->second;
+	}
+
+	uint32_t index = to_u32(render_targets.size());
+
+	render_target_indices.emplace(&render_target, index);
+	render_targets.push_back({render_target.get_extent(), render_target.get_attachments(), render_target.get_multisampled_attachments()});
+
+	auto &views = render_target.get_views();
+
+	for (uint32_t attachment = 0; attachment < views.size(); ++attachment)
+	{
+		// A view sampled before its render target was registered keeps its stand-in image
+		if (image_view_indices.find(views[attachment].get_id()) == image_view_indices.end())
+		{
+			DrawListImageView view;
+			view.render_target = index;
+			view.attachment    = attachment;
+
+			image_view_indices.emplace(views[attachment].get_id(), to_u32(image_views.size()));
+			image_views.push_back(view);
+		}
+	}
+
+	return index;
+}
+
+uint32_t DrawListRecord::get_pipeline_layout_index(const PipelineLayout &pipeline_layout)
+{
+	return to_u32(resource_cache.get_pipeline_layout_index(pipeline_layout));
+}
+
+uint32_t DrawListRecord::get_command_count() const
+{
+	return command_count;
+}
+
+std::vector<uint8_t> DrawListRecord::get_data()
+{
+	std::ostringstream stream;
+
+	write(stream, DRAW_LIST_VERSION, resource_cache.serialize(), buffer_sizes, image_views, to_u32(sampler_indices.size()));
+
+	write(stream, render_targets.size());
+	for (auto &render_target : render_targets)
+	{
+		write(stream, render_target.extent, render_target.attachments, render_target.multisampled_attachments);
+	}
+
+	write(stream, command_count, commands.str());
+
+	std::string str = stream.str();
+
+	return std::vector<uint8_t>{str.begin(), str.end()};
+}
+}        // namespace vkb
@@ -0,0 +1,218 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/render_pass.h"
+#include "rendering/render_target.h"
+
+namespace vkb
+{
+class PipelineLayout;
+class ResourceCache;
+
+namespace core
+{
+class Buffer;
+class ImageView;
+class Sampler;
+}        // namespace core
+
+/// Version of the draw list streams, to be bumped whenever their layout changes
+constexpr uint32_t DRAW_LIST_VERSION = 3;
+
+enum class DrawListCommand : uint8_t
+{
+	BeginRenderPass,
+	NextSubpass,
+	EndRenderPass,
+	BindPipelineLayout,
+	SetSpecializationConstant,
+	SetPushConstants,
+	PushConstants,
+	BindBuffer,
+	BindImage,
+	BindInput,
+	BindVertexBuffers,
+	BindIndexBuffer,
+	SetViewportState,
+	SetVertexInputState,
+	SetInputAssemblyState,
+	SetRasterizationState,
+	SetMultisampleState,
+	SetDepthStencilState,
+	SetColorBlendState,
+	SetViewport,
+	SetScissor,
+	SetLineWidth,
+	SetDepthBias,
+	SetBlendConstants,
+	SetDepthBounds,
+	SetFragmentShadingRate,
+	Draw,
+	DrawIndexed,
+	DrawIndexedIndirect
+};
+
+/**
+ * @brief Where the image view of a draw list comes from: an attachment of one of its render targets,
+ *        or an image replayed with a stand-in of the same description
+ */
+struct DrawListImageView
+{
+	/// Index of the render target of the view, ~0 if the view is not an attachment
+	uint32_t render_target{~0U};
+
+	uint32_t attachment{0};
+
+	VkImageViewType view_type{VK_IMAGE_VIEW_TYPE_2D};
+
+	VkFormat format{VK_FORMAT_UNDEFINED};
+
+	VkExtent3D extent{};
+
+	VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
+
+	VkImageUsageFlags usage{0};
+
+	uint32_t mip_levels{1};
+
+	uint32_t array_layers{1};
+
+	uint32_t base_mip_level{0};
+
+	uint32_t mip_level_count{1};
+};
+
+struct DrawListRenderTarget
+{
+	VkExtent2D extent{};
+
+	std::vector<Attachment> attachments;
+
+	std::vector<uint32_t> multisampled_attachments;
+};
+
+/**
+ * @brief Writes the calls recorded into a command buffer in a memory stream, see CommandBuffer::set_draw_list_record().
+ *        The stream holds the binds, state sets and draws with their arguments, referring to resources by index,
+ *        so that DrawListReplay can issue them again with stand-in resources, on a device without the assets.
+ *        Pipeline layouts are referred to by their index in the stream of the resource cache, serialized along.
+ */
+class DrawListRecord
+{
+  public:
+	DrawListRecord(ResourceCache &resource_cache);
+
+	template <typename... Args>
+	void record(DrawListCommand command, const Args &... args);
+
+	/**
+	 * @brief Writes more arguments of the last command, e.g. the members of the items of an argument array
+	 */
+	template <typename... Args>
+	void record_data(const Args &... args);
+
+	uint32_t get_buffer_index(VkBuffer buffer);
+
+	/**
+	 * @brief Registers the size of a buffer, the stand-in of a buffer being as large as all of its registered sizes
+	 */
+	void register_buffer_size(VkBuffer buffer, VkDeviceSize size);
+
+	/**
+	 * @brief Tracks the vertex buffers bound by handle, whose sizes are only known from the vertices the draws fetch
+	 */
+	void set_vertex_bindings(const std::vector<VkVertexInputBindingDescription> &bindings);
+
+	void bind_vertex_buffer(uint32_t binding, VkBuffer buffer, VkDeviceSize offset);
+
+	/**
+	 * @brief Registers the sizes of the bound vertex buffers fetched by a draw
+	 * @param vertex_end One past the last vertex fetched, the indices of the stand-in index buffers all being zero
+	 * @param instance_end One past the last instance drawn
+	 */
+	void register_fetched_vertices(uint32_t vertex_end, uint32_t instance_end);
+
+	uint32_t get_image_view_index(const core::ImageView &image_view);
+
+	uint32_t get_sampler_index(const core::Sampler &sampler);
+
+	/**
+	 * @brief Registers the render target with its views, which later binds then refer to as its attachments
+	 */
+	uint32_t get_render_target_index(const RenderTarget &render_target);
+
+	uint32_t get_pipeline_layout_index(const PipelineLayout &pipeline_layout);
+
+	uint32_t get_command_count() const;
+
+	/**
+	 * @return The draw list version, the stream of the resource cache, the resources then the commands
+	 */
+	std::vector<uint8_t> get_data();
+
+  private:
+	ResourceCache &resource_cache;
+
+	std::ostringstream commands;
+
+	uint32_t command_count{0};
+
+	std::unordered_map<VkBuffer, uint32_t> buffer_indices;
+
+	std::vector<VkDeviceSize> buffer_sizes;
+
+	std::vector<VkVertexInputBindingDescription> vertex_bindings;
+
+	std::unordered_map<uint32_t, std::pair<VkBuffer, VkDeviceSize>> bound_vertex_buffers;
+
+	/// Keyed by the identifiers of the views, unique for the lifetime of the device
+	std::unordered_map<uint64_t, uint32_t> image_view_indices;
+
+	std::vector<DrawListImageView> image_views;
+
+	std::unordered_map<VkSampler, uint32_t> sampler_indices;
+
+	std::unordered_map<const RenderTarget *, uint32_t> render_target_indices;
+
+	std::vector<DrawListRenderTarget> render_targets;
+};
+
+template <typename... Args>
+inline void DrawListRecord::record(DrawListCommand command, const Args &... args)
+{
+	write(commands, command, args...);
+
+	command_count++;
+}
+
+template <typename... Args>
+inline void DrawListRecord::record_data(const Args &... args)
+{
+	write(commands, args...);
+}
+}        // namespace vkb
@@ -0,0 +1,481 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "draw_list_replay.h"
+
+#include <algorithm>
+
+#include "common/logging.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "fence_pool.h"
+#include "rendering/pipeline_state.h"
+#include "resource_cache.h"
+
+namespace vkb
+{
+namespace
+{
+/// Usage of the stand-in buffers, as a buffer of the draw list may be bound in any of these ways
+constexpr VkBufferUsageFlags STAND_IN_BUFFER_USAGE = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                                                     VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                                     VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+/// Size of the stand-ins of the buffers which no command gave a size to
+constexpr VkDeviceSize MIN_STAND_IN_BUFFER_SIZE = 256;
+}        // namespace
+
+DrawListReplay::DrawListReplay(Device &device, const std::vector<uint8_t> &data) :
+    device{device}
+{
+	std::istringstream stream{std::string{data.begin(), data.end()}};
+
+	uint32_t version{0};
+	read(stream, version);
+
+	if (!stream || version != DRAW_LIST_VERSION)
+	{
+		throw std::runtime_error("The data is not a draw list of version " + std::to_string(DRAW_LIST_VERSION));
+	}
+
+	std::vector<uint8_t>           resource_data;
+	std::vector<VkDeviceSize>      buffer_sizes;
+	std::vector<DrawListImageView> view_infos;
+	uint32_t                       sampler_count{0};
+	size_t                         render_target_count{0};
+
+	read(stream, resource_data, buffer_sizes, view_infos, sampler_count, render_target_count);
+
+	// Creates the shader modules, pipeline layouts, render passes and pipelines the draw list uses
+	resource_record.set_data(resource_data);
+	resource_replay.play(device.get_resource_cache(), resource_record);
+
+	for (auto size : buffer_sizes)
+	{
+		size = std::max(size, MIN_STAND_IN_BUFFER_SIZE);
+
+		auto buffer = std::make_unique<core::Buffer>(device, size, STAND_IN_BUFFER_USAGE, VMA_MEMORY_USAGE_CPU_TO_GPU);
+		buffer->update(std::vector<uint8_t>(static_cast<size_t>(size), 0));
+
+		buffers.push_back(std::move(buffer));
+	}
+
+	for (size_t i = 0; i < render_target_count; ++i)
+	{
+		DrawListRenderTarget info;
+		read(stream, info.extent, info.attachments, info.multisampled_attachments);
+
+		std::vector<core::Image> images;
+		for (auto &attachment : info.attachments)
+		{
+			images.emplace_back(device, VkExtent3D{info.extent.width, info.extent.height, 1}, attachment.format, attachment.usage,
+			                    VMA_MEMORY_USAGE_GPU_ONLY, attachment.samples);
+		}
+
+		auto render_target = std::make_unique<RenderTarget>(std::move(images));
+
+		for (uint32_t attachment = 0; attachment < info.multisampled_attachments.size(); ++attachment)
+		{
+			if (info.multisampled_attachments[attachment] != VK_ATTACHMENT_UNUSED)
+			{
+				render_target->set_multisampled_attachment(attachment, info.multisampled_attachments[attachment]);
+			}
+		}
+
+		render_targets.push_back(std::move(render_target));
+	}
+
+	for (auto &view_info : view_infos)
+	{
+		if (view_info.render_target != ~0U)
+		{
+			image_views.push_back(&render_targets.at(view_info.render_target)->get_views().at(view_info.attachment));
+			continue;
+		}
+
+		// Transient images cannot be sampled, the stand-ins of the views are only sampled
+		VkImageUsageFlags usage = (view_info.usage & ~VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+		auto image = std::make_unique<core::Image>(device, view_info.extent, view_info.format, usage, VMA_MEMORY_USAGE_GPU_ONLY,
+		                                           view_info.samples, view_info.mip_levels, view_info.array_layers);
+
+		auto view = std::make_unique<core::ImageView>(*image, view_info.view_type, view_info.format, view_info.base_mip_level, view_info.mip_level_count);
+
+		image_views.push_back(view.get());
+
+		stand_in_images.push_back(std::move(image));
+		stand_in_views.push_back(std::move(view));
+	}
+
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.magFilter     = VK_FILTER_LINEAR;
+	sampler_info.minFilter     = VK_FILTER_LINEAR;
+	sampler_info.mipmapMode    = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	sampler_info.addressModeU  = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_info.addressModeV  = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_info.addressModeW  = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_info.maxAnisotropy = 1.0f;
+	sampler_info.maxLod        = VK_LOD_CLAMP_NONE;
+
+	for (uint32_t i = 0; i < sampler_count; ++i)
+	{
+		samplers.push_back(std::make_unique<core::Sampler>(device, sampler_info));
+	}
+
+	read(stream, command_count, commands);
+
+	if (!stream)
+	{
+		throw std::runtime_error("The draw list is truncated");
+	}
+
+	prepare_stand_in_images();
+
+	LOGI("Draw list of {} commands: {} buffers, {} render targets, {} stand-in images", command_count, buffers.size(), render_targets.size(), stand_in_images.size());
+}
+
+void DrawListReplay::prepare_stand_in_images()
+{
+	if (stand_in_views.empty())
+	{
+		return;
+	}
+
+	auto &command_buffer = device.request_command_buffer();
+
+	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+	for (auto &view : stand_in_views)
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		memory_barrier.new_layout      = is_depth_stencil_format(view->get_format()) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		memory_barrier.src_access_mask = 0;
+		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+		command_buffer.image_memory_barrier(*view, memory_barrier);
+	}
+
+	command_buffer.end();
+
+	auto &queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+
+	queue.submit(command_buffer, device.request_fence());
+
+	device.get_fence_pool().wait();
+	device.get_fence_pool().reset();
+	device.get_command_pool().reset_pool();
+}
+
+void DrawListReplay::play(CommandBuffer &command_buffer)
+{
+	std::istringstream stream{commands};
+
+	// Kept across the commands, so that reading their arguments reuses the allocations
+	std::vector<VkImageLayout> initial_layouts;
+	std::vector<LoadStoreInfo> load_store_infos;
+	std::vector<VkClearValue>  clear_values;
+	std::vector<SubpassInfo>   subpass_infos;
+	std::vector<uint8_t>       values;
+	std::vector<uint32_t>      buffer_indices;
+	std::vector<VkBuffer>      buffer_handles;
+	std::vector<VkDeviceSize>  offsets;
+	std::vector<VkViewport>    viewports;
+	std::vector<VkRect2D>      scissors;
+	VertexInputState           vertex_input_state;
+	ColorBlendState            color_blend_state;
+
+	for (uint32_t i = 0; i < command_count; ++i)
+	{
+		DrawListCommand command;
+		read(stream, command);
+
+		switch (command)
+		{
+			case DrawListCommand::BeginRenderPass:
+			{
+				uint32_t render_target_index{0};
+				size_t   subpass_count{0};
+				read(stream, render_target_index, initial_layouts, load_store_infos, clear_values, subpass_count);
+
+				subpass_infos.resize(subpass_count);
+				for (auto &subpass_info : subpass_infos)
+				{
+					read(stream, subpass_info.input_attachments, subpass_info.output_attachments, subpass_info.view_mask, subpass_info.rasterization_order_access);
+				}
+
+				auto &render_target = *render_targets.at(render_target_index);
+				for (uint32_t attachment = 0; attachment < initial_layouts.size(); ++attachment)
+				{
+					render_target.set_layout(attachment, initial_layouts[attachment]);
+				}
+
+				command_buffer.begin_render_pass(render_target, load_store_infos, clear_values, subpass_infos);
+				break;
+			}
+			case DrawListCommand::NextSubpass:
+				command_buffer.next_subpass();
+				break;
+			case DrawListCommand::EndRenderPass:
+				command_buffer.end_render_pass();
+				break;
+			case DrawListCommand::BindPipelineLayout:
+			{
+				uint32_t pipeline_layout_index{0};
+				read(stream, pipeline_layout_index);
+
+				command_buffer.bind_pipeline_layout(resource_replay.get_pipeline_layout(pipeline_layout_index));
+				break;
+			}
+			case DrawListCommand::SetSpecializationConstant:
+			{
+				uint32_t constant_id{0};
+				read(stream, constant_id, values);
+
+				command_buffer.set_specialization_constant(constant_id, values);
+				break;
+			}
+			case DrawListCommand::SetPushConstants:
+				read(stream, values);
+
+				command_buffer.set_push_constants(values);
+				break;
+			case DrawListCommand::PushConstants:
+			{
+				uint32_t offset{0};
+				read(stream, offset, values);
+
+				command_buffer.push_constants(offset, values);
+				break;
+			}
+			case DrawListCommand::BindBuffer:
+			{
+				uint32_t     buffer_index{0};
+				VkDeviceSize offset{0};
+				VkDeviceSize range{0};
+				uint32_t     set{0};
+				uint32_t     binding{0};
+				uint32_t     array_element{0};
+				read(stream, buffer_index, offset, range, set, binding, array_element);
+
+				command_buffer.bind_buffer(*buffers.at(buffer_index), offset, range, set, binding, array_element);
+				break;
+			}
+			case DrawListCommand::BindImage:
+			{
+				uint32_t view_index{0};
+				uint32_t sampler_index{0};
+				uint32_t set{0};
+				uint32_t binding{0};
+				uint32_t array_element{0};
+				read(stream, view_index, sampler_index, set, binding, array_element);
+
+				command_buffer.bind_image(*image_views.at(view_index), *samplers.at(sampler_index), set, binding, array_element);
+				break;
+			}
+			case DrawListCommand::BindInput:
+			{
+				uint32_t view_index{0};
+				uint32_t set{0};
+				uint32_t binding{0};
+				uint32_t array_element{0};
+				read(stream, view_index, set, binding, array_element);
+
+				command_buffer.bind_input(*image_views.at(view_index), set, binding, array_element);
+				break;
+			}
+			case DrawListCommand::BindVertexBuffers:
+			{
+				uint32_t first_binding{0};
+				read(stream, first_binding, buffer_indices, offsets);
+
+				buffer_handles.resize(buffer_indices.size());
+				std::transform(buffer_indices.begin(), buffer_indices.end(), buffer_handles.begin(),
+				               [this](uint32_t buffer_index) { return buffers.at(buffer_index)->get_handle(); });
+
+				command_buffer.bind_vertex_buffers(first_binding, to_u32(buffer_handles.size()), buffer_handles.data(), offsets.data());
+				break;
+			}
+			case DrawListCommand::BindIndexBuffer:
+			{
+				uint32_t     buffer_index{0};
+				VkDeviceSize offset{0};
+				VkIndexType  index_type{VK_INDEX_TYPE_UINT16};
+				read(stream, buffer_index, offset, index_type);
+
+				command_buffer.bind_index_buffer(*buffers.at(buffer_index), offset, index_type);
+				break;
+			}
+			case DrawListCommand::SetViewportState:
+			{
+				ViewportState state;
+				read(stream, state);
+
+				command_buffer.set_viewport_state(state);
+				break;
+			}
+			case DrawListCommand::SetVertexInputState:
+				read(stream, vertex_input_state.bindings, vertex_input_state.attributes);
+
+				command_buffer.set_vertex_input_state(vertex_input_state);
+				break;
+			case DrawListCommand::SetInputAssemblyState:
+			{
+				InputAssemblyState state;
+				read(stream, state);
+
+				command_buffer.set_input_assembly_state(state);
+				break;
+			}
+			case DrawListCommand::SetRasterizationState:
+			{
+				RasterizationState state;
+				read(stream, state);
+
+				command_buffer.set_rasterization_state(state);
+				break;
+			}
+			case DrawListCommand::SetMultisampleState:
+			{
+				MultisampleState state;
+				read(stream, state);
+
+				command_buffer.set_multisample_state(state);
+				break;
+			}
+			case DrawListCommand::SetDepthStencilState:
+			{
+				DepthStencilState state;
+				read(stream, state);
+
+				command_buffer.set_depth_stencil_state(state);
+				break;
+			}
+			case DrawListCommand::SetColorBlendState:
+				read(stream, color_blend_state.logic_op_enable, color_blend_state.logic_op, color_blend_state.attachments);
+
+				command_buffer.set_color_blend_state(color_blend_state);
+				break;
+			case DrawListCommand::SetViewport:
+			{
+				uint32_t first_viewport{0};
+				read(stream, first_viewport, viewports);
+
+				command_buffer.set_viewport(first_viewport, viewports);
+				break;
+			}
+			case DrawListCommand::SetScissor:
+			{
+				uint32_t first_scissor{0};
+				read(stream, first_scissor, scissors);
+
+				command_buffer.set_scissor(first_scissor, scissors);
+				break;
+			}
+			case DrawListCommand::SetLineWidth:
+			{
+				float line_width{1.0f};
+				read(stream, line_width);
+
+				command_buffer.set_line_width(line_width);
+				break;
+			}
+			case DrawListCommand::SetDepthBias:
+			{
+				float constant_factor{0.0f};
+				float clamp{0.0f};
+				float slope_factor{0.0f};
+				read(stream, constant_factor, clamp, slope_factor);
+
+				command_buffer.set_depth_bias(constant_factor, clamp, slope_factor);
+				break;
+			}
+			case DrawListCommand::SetBlendConstants:
+			{
+				std::array<float, 4> blend_constants{};
+				read(stream, blend_constants);
+
+				command_buffer.set_blend_constants(blend_constants);
+				break;
+			}
+			case DrawListCommand::SetDepthBounds:
+			{
+				float min_depth_bounds{0.0f};
+				float max_depth_bounds{1.0f};
+				read(stream, min_depth_bounds, max_depth_bounds);
+
+				command_buffer.set_depth_bounds(min_depth_bounds, max_depth_bounds);
+				break;
+			}
+			case DrawListCommand::SetFragmentShadingRate:
+			{
+				VkExtent2D fragment_size{1, 1};
+				read(stream, fragment_size);
+
+				command_buffer.set_fragment_shading_rate(fragment_size);
+				break;
+			}
+			case DrawListCommand::Draw:
+			{
+				uint32_t vertex_count{0};
+				uint32_t instance_count{0};
+				uint32_t first_vertex{0};
+				uint32_t first_instance{0};
+				read(stream, vertex_count, instance_count, first_vertex, first_instance);
+
+				command_buffer.draw(vertex_count, instance_count, first_vertex, first_instance);
+				break;
+			}
+			case DrawListCommand::DrawIndexed:
+			{
+				uint32_t index_count{0};
+				uint32_t instance_count{0};
+				uint32_t first_index{0};
+				int32_t  vertex_offset{0};
+				uint32_t first_instance{0};
+				read(stream, index_count, instance_count, first_index, vertex_offset, first_instance);
+
+				command_buffer.draw_indexed(index_count, instance_count, first_index, vertex_offset, first_instance);
+				break;
+			}
+			case DrawListCommand::DrawIndexedIndirect:
+			{
+				uint32_t     buffer_index{0};
+				VkDeviceSize offset{0};
+				uint32_t     draw_count{0};
+				uint32_t     stride{0};
+				read(stream, buffer_index, offset, draw_count, stride);
+
+				command_buffer.draw_indexed_indirect(*buffers.at(buffer_index), offset, draw_count, stride);
+				break;
+			}
+			default:
+				throw std::runtime_error("Unknown draw list command " + std::to_string(static_cast<uint32_t>(command)));
+		}
+	}
+}
+
+uint32_t DrawListReplay::get_command_count() const
+{
+	return command_count;
+}
+}        // namespace vkb
@@ -0,0 +1,97 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/buffer.h"
+#include "core/image.h"
+#include "core/image_view.h"
+#include "core/sampler.h"
+#include "draw_list_record.h"
+#include "rendering/render_target.h"
+#include "resource_record.h"
+#include "resource_replay.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+
+/**
+ * @brief Reads a draw list written by DrawListRecord and records its commands into command buffers,
+ *        to measure the cost of the state tracking, caching and flushes of CommandBuffer in isolation.
+ *        The pipelines of the draw list are created from the resource cache stream written along,
+ *        and its buffers and images are replaced with zeroed stand-ins of the same sizes and formats.
+ *        As the stand-in index buffers only hold zeros, the draws only fetch their first vertex.
+ */
+class DrawListReplay
+{
+  public:
+	/**
+	 * @brief Creates the pipelines and the stand-in resources of a draw list
+	 * @throws std::runtime_error If the data is not a draw list of the current version
+	 */
+	DrawListReplay(Device &device, const std::vector<uint8_t> &data);
+
+	DrawListReplay(const DrawListReplay &) = delete;
+
+	DrawListReplay &operator=(const DrawListReplay &) = delete;
+
+	/**
+	 * @brief Records the commands of the draw list into a command buffer of a render frame, which must be recording
+	 */
+	void play(CommandBuffer &command_buffer);
+
+	uint32_t get_command_count() const;
+
+  private:
+	Device &device;
+
+	ResourceRecord resource_record;
+
+	ResourceReplay resource_replay;
+
+	std::vector<std::unique_ptr<core::Buffer>> buffers;
+
+	std::vector<std::unique_ptr<RenderTarget>> render_targets;
+
+	std::vector<std::unique_ptr<core::Image>> stand_in_images;
+
+	std::vector<std::unique_ptr<core::ImageView>> stand_in_views;
+
+	/// Views of the draw list, either attachments of the render targets or stand-in views
+	std::vector<const core::ImageView *> image_views;
+
+	std::vector<std::unique_ptr<core::Sampler>> samplers;
+
+	uint32_t command_count{0};
+
+	std::string commands;
+
+	/**
+	 * @brief Transitions the stand-in images to the layout of sampled images
+	 */
+	void prepare_stand_in_images();
+};
+}        // namespace vkb
@@ -0,0 +1,87 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace vkb
+{
+FrameArena::FrameArena(size_t block_size)
+{
+	blocks.push_back({std::make_unique<uint8_t[]>(block_size), block_size});
+
+	capacity = block_size;
+}
+
+void *FrameArena::allocate(size_t size, size_t alignment)
+{
+	assert((alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+
+	while (block_index < blocks.size())
+	{
+		auto &block = blocks[block_index];
+
+		// The data of the blocks is aligned for any type, so aligning the offset is enough
+		size_t aligned_offset = (offset + alignment - 1) & ~(alignment - 1);
+
+		if (aligned_offset + size <= block.size)
+		{
+			offset = aligned_offset + size;
+
+			return block.data.get() + aligned_offset;
+		}
+
+		++block_index;
+		offset = 0;
+	}
+
+	// Grow geometrically, the blocks are merged into one on the next reset
+	size_t block_size = std::max(size + alignment, capacity);
+
+	blocks.push_back({std::make_unique<uint8_t[]>(block_size), block_size});
+
+	capacity += block_size;
+
+	block_index = blocks.size() - 1;
+	offset      = size;
+
+	return blocks.back().data.get();
+}
+
+void FrameArena::reset()
+{
+	if (blocks.size() > 1)
+	{
+		// A single block holding the peak usage, so that the next frames don't allocate
+		blocks.clear();
+		blocks.push_back({std::make_unique<uint8_t[]>(capacity), capacity});
+	}
+
+	block_index = 0;
+	offset      = 0;
+}
+
+size_t FrameArena::get_capacity() const
+{
+	return capacity;
+}
+}        // namespace vkb
@@ -0,0 +1,155 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief Linear allocator for the transient CPU data of a frame
+ *        Allocations bump an offset into a block and are only released all at once by reset(),
+ *        which keeps a single block large enough for the peak usage of the previous frames.
+ *        An arena is not thread safe, each thread of a RenderFrame has one of its own.
+ */
+class FrameArena
+{
+  public:
+	/**
+	 * @brief Size of the first block in bytes
+	 */
+	static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+	FrameArena(size_t block_size = DEFAULT_BLOCK_SIZE);
+
+	FrameArena(const FrameArena &) = delete;
+
+	FrameArena(FrameArena &&) = default;
+
+	FrameArena &operator=(const FrameArena &) = delete;
+
+	FrameArena &operator=(FrameArena &&) = default;
+
+	/**
+	 * @brief Allocates memory which stays valid until the next reset()
+	 * @param size Size in bytes of the allocation
+	 * @param alignment Alignment of the allocation, a power of two
+	 */
+	void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	/**
+	 * @brief Releases all the allocations, nothing allocated from the arena must be used afterwards
+	 */
+	void reset();
+
+	/**
+	 * @return The total size of the blocks of the arena
+	 */
+	size_t get_capacity() const;
+
+  private:
+	struct Block
+	{
+		std::unique_ptr<uint8_t[]> data;
+
+		size_t size{0};
+	};
+
+	std::vector<Block> blocks;
+
+	/// Block allocations are made from, the blocks before it are full
+	size_t block_index{0};
+
+	/// Offset of the next allocation in the current block
+	size_t offset{0};
+
+	size_t capacity{0};
+};
+
+/**
+ * @brief STL allocator drawing from a FrameArena, so that containers of transient frame data don't
+ *        go through the heap. Deallocation is a no-op, the memory is returned when the arena is reset.
+ *        Without an arena, it falls back to the heap.
+ */
+template <class T>
+class ArenaAllocator
+{
+  public:
+	using value_type = T;
+
+	ArenaAllocator(FrameArena *arena = nullptr) noexcept :
+	    arena{arena}
+	{}
+
+	template <class U>
+	ArenaAllocator(const ArenaAllocator<U> &other) noexcept :
+	    arena{other.get_arena()}
+	{}
+
+	T *allocate(size_t count)
+	{
+		if (!arena)
+		{
+			return static_cast<T *>(::operator new(count * sizeof(T)));
+		}
+
+		return static_cast<T *>(arena->allocate(count * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T *pointer, size_t) noexcept
+	{
+		if (!arena)
+		{
+			::operator delete(pointer);
+		}
+	}
+
+	FrameArena *get_arena() const noexcept
+	{
+		return arena;
+	}
+
+  private:
+	FrameArena *arena;
+};
+
+template <class T, class U>
+bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) noexcept
+{
+	return a.get_arena() == b.get_arena();
+}
+
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) noexcept
+{
+	return a.get_arena() != b.get_arena();
+}
+
+/**
+ * @brief Vector of transient frame data allocated from a FrameArena
+ */
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+}        // namespace vkb
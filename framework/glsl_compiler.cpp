@@ -20,6 +20,13 @@
 
 #include "glsl_compiler.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
 VKBP_DISABLE_WARNINGS()
 #include <SPIRV/GLSL.std.450.h>
 #include <SPIRV/GlslangToSpv.h>
@@ -29,10 +36,98 @@ VKBP_DISABLE_WARNINGS()
 #include <glslang/OSDependent/osinclude.h>
 VKBP_ENABLE_WARNINGS()
 
+#include "common/logging.h"
+#include "platform/filesystem.h"
+
 namespace vkb
 {
 namespace
 {
+/// Identifies the SPIRV cache files, increased when their format changes
+constexpr uint32_t SPIRV_CACHE_MAGIC = 0x53505643;        // 'SPVC'
+
+constexpr uint32_t SPIRV_CACHE_VERSION = 2;
+
+constexpr uint32_t SPIRV_MAGIC_NUMBER = 0x07230203;
+
+/// Directory of the shaders folder holding the SPIRV written by the shader_precompiler tool
+const std::string PRECOMPILED_SPIRV_DIRECTORY = "spirv/";
+
+/**
+ * @brief Header of a SPIRV cache file, followed by the SPIRV code
+ */
+struct SpirvCacheHeader
+{
+	uint32_t magic;
+
+	uint32_t version;
+
+	uint64_t key;
+};
+
+/**
+ * @brief FNV-1a hash, used instead of std::hash as the key must be the same across runs and platforms
+ */
+inline void hash_bytes(uint64_t &hash, const void *data, size_t size)
+{
+	auto bytes = reinterpret_cast<const uint8_t *>(data);
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+}
+
+inline void hash_string(uint64_t &hash, const std::string &value)
+{
+	uint64_t size = value.size();
+	hash_bytes(hash, &size, sizeof(size));
+	hash_bytes(hash, value.data(), value.size());
+}
+
+/**
+ * @brief Reads the SPIRV code of a key from a precompiled or cache file
+ * @return Whether a valid file was found
+ */
+bool read_spirv_file(uint64_t key, const std::function<std::vector<uint8_t>(const std::string &)> &read_file, std::vector<std::uint32_t> &spirv)
+{
+	std::vector<uint8_t> data;
+
+	try
+	{
+		data = read_file(GLSLCompiler::get_spirv_filename(key));
+	}
+	catch (std::runtime_error &)
+	{
+		return false;
+	}
+
+	return GLSLCompiler::decode_spirv_file(key, data, spirv);
+}
+
+/**
+ * @brief Initializes glslang the first time it is called, and finalizes it when the process exits
+ *        Initializing it around each compilation would serialize the compilations on its global lock
+ */
+void initialize_glslang()
+{
+	struct GlslangProcess
+	{
+		GlslangProcess()
+		{
+			glslang::InitializeProcess();
+		}
+
+		~GlslangProcess()
+		{
+			glslang::FinalizeProcess();
+		}
+	};
+
+	static GlslangProcess process;
+}
+
 inline EShLanguage FindShaderLanguage(VkShaderStageFlagBits stage)
 {
 	switch (stage)
@@ -61,6 +156,85 @@ inline EShLanguage FindShaderLanguage(VkShaderStageFlagBits stage)
 }
 }        // namespace
 
+uint64_t GLSLCompiler::get_spirv_key(VkShaderStageFlagBits stage, const std::vector<uint8_t> &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant)
+{
+	uint64_t key = 0xcbf29ce484222325ULL;
+
+	uint32_t compiler_version = GLSLANG_PATCH_LEVEL;
+	hash_bytes(key, &compiler_version, sizeof(compiler_version));
+
+	uint32_t stage_value = static_cast<uint32_t>(stage);
+	hash_bytes(key, &stage_value, sizeof(stage_value));
+
+	uint64_t source_size = glsl_source.size();
+	hash_bytes(key, &source_size, sizeof(source_size));
+	hash_bytes(key, glsl_source.data(), glsl_source.size());
+
+	hash_string(key, entry_point);
+
+	// The preamble is generated from the processes, which are sorted as variants add
+	// their defines in the iteration order of unordered containers
+	auto processes = shader_variant.get_processes();
+	std::sort(processes.begin(), processes.end());
+
+	for (auto &process : processes)
+	{
+		hash_string(key, process);
+	}
+
+	return key;
+}
+
+std::string GLSLCompiler::get_spirv_filename(uint64_t key)
+{
+	std::stringstream filename;
+	filename << "spirv_" << std::hex << std::setw(16) << std::setfill('0') << key << ".spv";
+	return filename.str();
+}
+
+std::vector<uint8_t> GLSLCompiler::encode_spirv_file(uint64_t key, const std::vector<std::uint32_t> &spirv)
+{
+	SpirvCacheHeader header{};
+	header.magic   = SPIRV_CACHE_MAGIC;
+	header.version = SPIRV_CACHE_VERSION;
+	header.key     = key;
+
+	std::vector<uint8_t> data(sizeof(header) + spirv.size() * sizeof(std::uint32_t));
+	std::memcpy(data.data(), &header, sizeof(header));
+	std::memcpy(data.data() + sizeof(header), spirv.data(), spirv.size() * sizeof(std::uint32_t));
+
+	return data;
+}
+
+bool GLSLCompiler::decode_spirv_file(uint64_t key, const std::vector<uint8_t> &data, std::vector<std::uint32_t> &spirv)
+{
+	SpirvCacheHeader header{};
+
+	if (data.size() <= sizeof(header) || (data.size() - sizeof(header)) % sizeof(std::uint32_t) != 0)
+	{
+		return false;
+	}
+
+	std::memcpy(&header, data.data(), sizeof(header));
+
+	if (header.magic != SPIRV_CACHE_MAGIC || header.version != SPIRV_CACHE_VERSION || header.key != key)
+	{
+		return false;
+	}
+
+	std::vector<std::uint32_t> code((data.size() - sizeof(header)) / sizeof(std::uint32_t));
+	std::memcpy(code.data(), data.data() + sizeof(header), data.size() - sizeof(header));
+
+	if (code.front() != SPIRV_MAGIC_NUMBER)
+	{
+		return false;
+	}
+
+	spirv = std::move(code);
+
+	return true;
+}
+
 bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
                                     const std::vector<uint8_t> &glsl_source,
                                     const std::string &         entry_point,
@@ -68,8 +242,16 @@ bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
                                     std::vector<std::uint32_t> &spirv,
                                     std::string &               info_log)
 {
-	// Initialize glslang library.
-	glslang::InitializeProcess();
+	uint64_t key = get_spirv_key(stage, glsl_source, entry_point, shader_variant);
+
+	// Look for SPIRV precompiled at build time, then for the one cached by a previous run
+	if (read_spirv_file(key, [](const std::string &filename) { return fs::read_shader(PRECOMPILED_SPIRV_DIRECTORY + filename); }, spirv) ||
+	    read_spirv_file(key, [](const std::string &filename) { return fs::read_temp(filename); }, spirv))
+	{
+		return true;
+	}
+
+	initialize_glslang();
 
 	EShMessages messages = static_cast<EShMessages>(EShMsgDefault | EShMsgVulkanRules | EShMsgSpvRules);
 
@@ -83,7 +265,9 @@ bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
 	shader.setStringsWithLengthsAndNames(&shader_source, nullptr, file_name_list, 1);
 	shader.setEntryPoint(entry_point.c_str());
 	shader.setSourceEntryPoint(entry_point.c_str());
-	shader.setPreamble(shader_variant.get_preamble().c_str());
+	// Only generated for the compilation, the shader keeps a pointer to it
+	std::string preamble = shader_variant.get_preamble();
+	shader.setPreamble(preamble.c_str());
 	shader.addProcesses(shader_variant.get_processes());
 
 	if (!shader.parse(&glslang::DefaultTBuiltInResource, 100, false, messages))
@@ -129,9 +313,36 @@ bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
 
 	info_log += logger.getAllMessages() + "\n";
 
-	// Shutdown glslang library.
-	glslang::FinalizeProcess();
+	try
+	{
+		fs::write_temp(encode_spirv_file(key, spirv), get_spirv_filename(key));
+	}
+	catch (std::runtime_error &ex)
+	{
+		LOGW("Failed to write the SPIRV cache. {}", ex.what());
+	}
 
 	return true;
 }
+
+size_t GLSLCompiler::compile_to_spirv(std::vector<CompileTask> &tasks, JobSystem &job_system, JobPriority priority)
+{
+	std::atomic<size_t> failure_count{0};
+
+	// Each compilation has its own glslang shader and program, so they only share the immutable built-in symbol tables
+	job_system.run_parallel(priority, tasks.size(), job_system.get_thread_count() + 1, [this, &tasks, &failure_count](size_t task_index, size_t) {
+		auto &task = tasks[task_index];
+
+		assert(task.glsl_source && "Shader compile task has no source");
+
+		task.success = compile_to_spirv(task.stage, *task.glsl_source, task.entry_point, task.shader_variant, task.spirv, task.info_log);
+
+		if (!task.success)
+		{
+			failure_count++;
+		}
+	});
+
+	return failure_count;
+}
 }        // namespace vkb
@@ -31,16 +31,43 @@ VKBP_ENABLE_WARNINGS()
 
 #include "common/vk_common.h"
 #include "core/shader_module.h"
+#include "job_system.h"
 
 namespace vkb
 {
 /// Helper class to generate SPIRV code from GLSL source
 /// A very simple version of the glslValidator application
+/// The generated SPIRV is cached in the temporary directory, keyed by the hash of the stage,
+/// source, entry point, variant and glslang version, so that unchanged shaders are not compiled again on the next run.
+/// SPIRV precompiled by the shader_precompiler tool in the spirv folder of the shaders is used first.
+/// glslang is initialized once for the process, so that shaders can be compiled from several threads at once.
 class GLSLCompiler
 {
   public:
 	/**
-	 * @brief Compiles GLSL to SPIRV code
+	 * @brief A shader to compile in a batch, with the results of its compilation
+	 */
+	struct CompileTask
+	{
+		VkShaderStageFlagBits stage{VK_SHADER_STAGE_VERTEX_BIT};
+
+		/// Shared by the variants of a shader, it must outlive the compilation
+		const std::vector<uint8_t> *glsl_source{nullptr};
+
+		std::string entry_point{"main"};
+
+		ShaderVariant shader_variant;
+
+		std::vector<std::uint32_t> spirv;
+
+		std::string info_log;
+
+		bool success{false};
+	};
+
+	/**
+	 * @brief Compiles GLSL to SPIRV code, or reads it from the SPIRV cache
+	 *        Safe to call from several threads at once
 	 * @param stage The Vulkan shader stage flag
 	 * @param glsl_source The GLSL source code to be compiled
 	 * @param entry_point The entrypoint function name of the shader stage
@@ -54,5 +81,38 @@ class GLSLCompiler
 	                      const ShaderVariant &       shader_variant,
 	                      std::vector<std::uint32_t> &spirv,
 	                      std::string &               info_log);
+
+	/**
+	 * @brief Compiles shaders in parallel on the calling thread and the job system workers
+	 * @param tasks The shaders to compile, their SPIRV and log are written back to them
+	 * @param job_system The job system helping with the compilations
+	 * @param priority Priority of the jobs compiling the shaders
+	 * @return The number of shaders which failed to compile
+	 */
+	size_t compile_to_spirv(std::vector<CompileTask> &tasks, JobSystem &job_system, JobPriority priority = JobPriority::Background);
+
+	/**
+	 * @brief Computes the key of the SPIRV generated for a shader, independent of the order the variant defines were added in
+	 */
+	static uint64_t get_spirv_key(VkShaderStageFlagBits       stage,
+	                              const std::vector<uint8_t> &glsl_source,
+	                              const std::string &         entry_point,
+	                              const ShaderVariant &       shader_variant);
+
+	/**
+	 * @return Name of the cache or precompiled file holding the SPIRV of a key
+	 */
+	static std::string get_spirv_filename(uint64_t key);
+
+	/**
+	 * @brief Builds the content of a SPIRV file, made of a header identifying the key followed by the code
+	 */
+	static std::vector<uint8_t> encode_spirv_file(uint64_t key, const std::vector<std::uint32_t> &spirv);
+
+	/**
+	 * @brief Reads the code of a SPIRV file
+	 * @return False if the file is not a valid SPIRV file for the key, in which case spirv is left unchanged
+	 */
+	static bool decode_spirv_file(uint64_t key, const std::vector<uint8_t> &data, std::vector<std::uint32_t> &spirv);
 };
 }        // namespace vkb
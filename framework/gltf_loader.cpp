@@ -21,42 +21,57 @@
 #define TINYGLTF_IMPLEMENTATION
 #include "gltf_loader.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <limits>
 #include <queue>
+#include <unordered_map>
 
 #include "common/error.h"
 
 VKBP_DISABLE_WARNINGS()
 #include "common/glm_common.h"
+#include <glm/gtc/packing.hpp>
 #include <glm/gtc/type_ptr.hpp>
 VKBP_ENABLE_WARNINGS()
 
+#include "common/helpers.h"
 #include "common/logging.h"
 #include "common/utils.h"
 #include "common/vk_common.h"
 #include "core/device.h"
 #include "core/image.h"
+#include "cpu_profiler.h"
+#include "mesh_optimizer.h"
 #include "platform/filesystem.h"
+#include "scene_cache.h"
+#include "scene_graph/components/aabb.h"
 #include "scene_graph/components/camera.h"
+#include "scene_graph/components/geometry_arena.h"
 #include "scene_graph/components/image.h"
 #include "scene_graph/components/image/astc.h"
+#include "scene_graph/components/image/ktx2.h"
 #include "scene_graph/components/light.h"
 #include "scene_graph/components/mesh.h"
 #include "scene_graph/components/pbr_material.h"
 #include "scene_graph/components/perspective_camera.h"
 #include "scene_graph/components/sampler.h"
+#include "scene_graph/components/skin.h"
 #include "scene_graph/components/sub_mesh.h"
 #include "scene_graph/components/texture.h"
 #include "scene_graph/components/transform.h"
 #include "scene_graph/node.h"
 #include "scene_graph/scene.h"
-
-#include <ctpl_stl.h>
+#include "scene_graph/scripts/animation.h"
 
 namespace vkb
 {
 namespace
 {
+/// Size of the buffers the scene geometry is packed into
+constexpr VkDeviceSize GEOMETRY_BLOCK_SIZE = 16 * 1024 * 1024;
+
 inline VkFilter find_min_filter(int min_filter)
 {
 	switch (min_filter)
@@ -278,142 +293,1828 @@ inline std::vector<uint8_t> convert_underlying_data_stride(const std::vector<uin
 	return result;
 }
 
-inline void upload_image_to_gpu(CommandBuffer &command_buffer, core::Buffer &staging_buffer, sg::Image &image)
+/**
+ * @brief Vertex attribute of a glTF primitive, with its data copied out of the glTF buffers
+ */
+struct AttributeData
+{
+	/// Lowercase name of the attribute
+	std::string name;
+
+	sg::VertexAttribute attribute;
+
+	std::vector<uint8_t> data;
+};
+
+/**
+ * @brief Simplified index data of a primitive, see generate_lods()
+ */
+struct PrimitiveLod
+{
+	/// Index data, of the index type of the primitive
+	std::vector<uint8_t> index_data;
+
+	uint32_t vertex_indices{0};
+
+	float error{0.0f};
+};
+
+/**
+ * @brief Vertex cache statistics of the primitives optimized by optimize_mesh()
+ */
+struct MeshOptimizationStats
+{
+	size_t triangle_count{0};
+
+	/// Vertices transformed by a FIFO cache, before and after the optimization
+	float transformed_before{0.0f};
+
+	float transformed_after{0.0f};
+};
+
+/**
+ * @brief Geometry of a glTF primitive, processed on the loading threads
+ */
+struct PrimitiveData
+{
+	std::vector<AttributeData> attributes;
+
+	uint32_t vertices_count{0};
+
+	/// Index data, converted to an index type supported by Vulkan
+	std::vector<uint8_t> index_data;
+
+	VkIndexType index_type{VK_INDEX_TYPE_UINT32};
+
+	uint32_t vertex_indices{0};
+
+	/// Whether the bounds were computed, which requires positions
+	bool has_bounds{false};
+
+	/// Whether the primitive is an indexed triangle list, which can be merged with others, see merge_primitives()
+	bool indexed_triangle_list{false};
+
+	glm::vec3 bounds_min;
+
+	glm::vec3 bounds_max;
+
+	/// Coarser levels of detail, from the finest
+	std::vector<PrimitiveLod> lods;
+
+	MeshOptimizationStats optimization_stats;
+
+	/// Clusters of the triangles of the full detail level, see generate_meshlets()
+	std::vector<sg::Meshlet> meshlets;
+
+	/// Attributes interleaved in the INTERLEAVED_STREAM attribute, without data of their own, see interleave_attributes()
+	std::vector<AttributeData> interleaved_attributes;
+};
+
+/**
+ * @brief Primitives being processed on the job system, indexed like the glTF meshes
+ *        The jobs still pending are waited for when leaving the scope, as they read the model of the loader
+ */
+struct PrimitiveFutures
 {
-	// Clean up the image data, as they are copied in the staging buffer
-	image.clear_data();
+	std::vector<std::vector<std::future<PrimitiveData>>> futures;
 
+	~PrimitiveFutures()
 	{
-		ImageMemoryBarrier memory_barrier{};
-		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
-		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		memory_barrier.src_access_mask = 0;
-		memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_HOST_BIT;
-		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		for (auto &mesh_futures : futures)
+		{
+			for (auto &fut : mesh_futures)
+			{
+				if (fut.valid())
+				{
+					fut.wait();
+				}
+			}
+		}
+	}
+};
+
+/// Largest error of half float positions relative to the extent of their primitive, coarser positions are kept as floats
+constexpr float MAX_POSITION_QUANTIZATION_ERROR = 1.0f / 1024.0f;
+
+/// Largest value a half float represents
+constexpr float MAX_HALF_FLOAT = 65504.0f;
+
+/**
+ * @brief Reads the element of an attribute for a vertex, at the stride of the attribute
+ */
+template <typename T>
+T read_element(const AttributeData &attribute, uint32_t vertex_index)
+{
+	T value;
+	std::memcpy(&value, attribute.data.data() + vertex_index * attribute.attribute.stride, sizeof(T));
+
+	return value;
+}
 
-		command_buffer.image_memory_barrier(image.get_vk_image_view(), memory_barrier);
+/**
+ * @brief Maps a unit vector to the octahedron unfolded over the [-1, 1] square
+ */
+glm::vec2 encode_octahedral(const glm::vec3 &normal)
+{
+	float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+
+	if (length == 0.0f)
+	{
+		return glm::vec2{0.0f};
 	}
 
-	// Create a buffer image copy for every mip level
-	auto &mipmaps = image.get_mipmaps();
+	glm::vec3 n = normal / length;
 
-	std::vector<VkBufferImageCopy> buffer_copy_regions(mipmaps.size());
+	glm::vec2 encoded{n.x, n.y};
 
-	for (size_t i = 0; i < mipmaps.size(); ++i)
+	// The lower hemisphere is folded over the corners of the square
+	if (n.z < 0.0f)
 	{
-		auto &mipmap      = mipmaps[i];
-		auto &copy_region = buffer_copy_regions[i];
+		glm::vec2 signs{encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f};
 
-		copy_region.bufferOffset     = mipmap.offset;
-		copy_region.imageSubresource = image.get_vk_image_view().get_subresource_layers();
-		// Update miplevel
-		copy_region.imageSubresource.mipLevel = mipmap.level;
-		copy_region.imageExtent               = mipmap.extent;
+		encoded = (1.0f - glm::abs(glm::vec2{encoded.y, encoded.x})) * signs;
 	}
 
-	command_buffer.copy_buffer_to_image(staging_buffer, image.get_vk_image(), buffer_copy_regions);
+	return encoded;
+}
 
+/**
+ * @brief Reduces the size of the float attributes of a primitive, once its bounds are known
+ *        Positions are stored as half floats when close enough to their bounds, normals are octahedron
+ *        encoded into two snorm16 and texture coordinates within [0, 1] are stored as unorm16.
+ *        Other attributes and formats are kept as they are.
+ */
+void quantize_attributes(PrimitiveData &primitive)
+{
+	for (auto &attribute : primitive.attributes)
 	{
-		ImageMemoryBarrier memory_barrier{};
-		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		memory_barrier.src_access_mask = 0;
-		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
-		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		std::vector<uint8_t> data;
+
+		if (attribute.name == "position" && attribute.attribute.format == VK_FORMAT_R32G32B32_SFLOAT && primitive.has_bounds)
+		{
+			// The half float error grows with the distance to the origin, while what matters is the size of the primitive
+			glm::vec3 max_abs   = glm::max(glm::abs(primitive.bounds_min), glm::abs(primitive.bounds_max));
+			float     max_value = std::max({max_abs.x, max_abs.y, max_abs.z});
+			float     extent    = glm::length(primitive.bounds_max - primitive.bounds_min);
+
+			if (max_value > MAX_HALF_FLOAT || max_value / 2048.0f > extent * MAX_POSITION_QUANTIZATION_ERROR)
+			{
+				continue;
+			}
 
-		command_buffer.image_memory_barrier(image.get_vk_image_view(), memory_barrier);
+			// Three component half float formats are seldom supported for vertex buffers
+			data.resize(primitive.vertices_count * 4 * sizeof(uint16_t));
+
+			auto positions = reinterpret_cast<uint16_t *>(data.data());
+
+			for (uint32_t i = 0; i < primitive.vertices_count; i++)
+			{
+				auto position = read_element<glm::vec3>(attribute, i);
+
+				positions[i * 4 + 0] = glm::packHalf1x16(position.x);
+				positions[i * 4 + 1] = glm::packHalf1x16(position.y);
+				positions[i * 4 + 2] = glm::packHalf1x16(position.z);
+				positions[i * 4 + 3] = glm::packHalf1x16(1.0f);
+			}
+
+			attribute.attribute.format = VK_FORMAT_R16G16B16A16_SFLOAT;
+			attribute.attribute.stride = 4 * sizeof(uint16_t);
+		}
+		else if (attribute.name == "normal" && attribute.attribute.format == VK_FORMAT_R32G32B32_SFLOAT)
+		{
+			data.resize(primitive.vertices_count * sizeof(uint32_t));
+
+			auto normals = reinterpret_cast<uint32_t *>(data.data());
+
+			for (uint32_t i = 0; i < primitive.vertices_count; i++)
+			{
+				normals[i] = glm::packSnorm2x16(encode_octahedral(read_element<glm::vec3>(attribute, i)));
+			}
+
+			attribute.attribute.format = VK_FORMAT_R16G16_SNORM;
+			attribute.attribute.stride = sizeof(uint32_t);
+		}
+		else if (attribute.name.compare(0, 8, "texcoord") == 0 && attribute.attribute.format == VK_FORMAT_R32G32_SFLOAT)
+		{
+			bool normalized = true;
+
+			for (uint32_t i = 0; i < primitive.vertices_count && normalized; i++)
+			{
+				auto texcoord = read_element<glm::vec2>(attribute, i);
+
+				normalized = glm::all(glm::greaterThanEqual(texcoord, glm::vec2{0.0f})) && glm::all(glm::lessThanEqual(texcoord, glm::vec2{1.0f}));
+			}
+
+			// Repeating texture coordinates are kept as floats
+			if (!normalized)
+			{
+				continue;
+			}
+
+			data.resize(primitive.vertices_count * sizeof(uint32_t));
+
+			auto texcoords = reinterpret_cast<uint32_t *>(data.data());
+
+			for (uint32_t i = 0; i < primitive.vertices_count; i++)
+			{
+				texcoords[i] = glm::packUnorm2x16(read_element<glm::vec2>(attribute, i));
+			}
+
+			attribute.attribute.format = VK_FORMAT_R16G16_UNORM;
+			attribute.attribute.stride = sizeof(uint32_t);
+		}
+		else
+		{
+			continue;
+		}
+
+		attribute.data = std::move(data);
 	}
 }
-}        // namespace
 
-std::unordered_map<std::string, bool> GLTFLoader::supported_extensions = {
-    {KHR_LIGHTS_PUNCTUAL_EXTENSION, false}};
+/// Name of the vertex buffer interleaving all the attributes but the positions
+const char *INTERLEAVED_STREAM = "interleaved";
 
-GLTFLoader::GLTFLoader(Device &device) :
-    device{device}
+/**
+ * @brief Packs the positions tightly into a stream of their own, which depth only passes read alone, and interleaves
+ *        all the other attributes into a single stream, so that the other passes fetch each vertex in one burst.
+ *        The interleaved stream replaces the attributes it holds, which keep their formats in interleaved_attributes.
+ */
+void interleave_attributes(PrimitiveData &primitive)
 {
-}
+	AttributeData stream;
+	stream.name = INTERLEAVED_STREAM;
 
-std::unique_ptr<sg::Scene> GLTFLoader::read_scene_from_file(const std::string &file_name, int scene_index)
-{
-	std::string err;
-	std::string warn;
+	for (auto &attribute : primitive.attributes)
+	{
+		uint32_t element_size = to_u32(std::max(get_bits_per_pixel(attribute.attribute.format), 0)) / 8;
 
-	tinygltf::TinyGLTF gltf_loader;
+		if (attribute.name == "position")
+		{
+			if (element_size != 0 && element_size < attribute.attribute.stride)
+			{
+				std::vector<uint8_t> data(primitive.vertices_count * element_size);
 
-	std::string gltf_file = vkb::fs::path::get(vkb::fs::path::Type::Assets) + file_name;
+				for (uint32_t vertex = 0; vertex < primitive.vertices_count; vertex++)
+				{
+					std::memcpy(data.data() + vertex * element_size, attribute.data.data() + vertex * attribute.attribute.stride, element_size);
+				}
 
-	bool importResult = gltf_loader.LoadASCIIFromFile(&model, &err, &warn, gltf_file.c_str());
+				attribute.data             = std::move(data);
+				attribute.attribute.stride = element_size;
+			}
 
-	if (!importResult)
+			continue;
+		}
+
+		AttributeData interleaved;
+		interleaved.name             = attribute.name;
+		interleaved.attribute.format = attribute.attribute.format;
+		interleaved.attribute.offset = stream.attribute.stride;
+		interleaved.attribute.stream = INTERLEAVED_STREAM;
+
+		// Attributes are aligned to 4 bytes, as fetching them across words is slower on some GPUs
+		stream.attribute.stride += (element_size + 3) & ~3u;
+
+		primitive.interleaved_attributes.push_back(std::move(interleaved));
+	}
+
+	if (primitive.interleaved_attributes.empty())
 	{
-		LOGE("Failed to load gltf file {}.", gltf_file.c_str());
+		return;
+	}
 
-		return nullptr;
+	stream.data.resize(primitive.vertices_count * stream.attribute.stride);
+
+	for (auto &interleaved : primitive.interleaved_attributes)
+	{
+		interleaved.attribute.stride = stream.attribute.stride;
+
+		auto &attribute = *std::find_if(primitive.attributes.begin(), primitive.attributes.end(),
+		                                [&interleaved](const AttributeData &attribute) { return attribute.name == interleaved.name; });
+
+		uint32_t element_size = std::min(to_u32(std::max(get_bits_per_pixel(attribute.attribute.format), 0)) / 8, attribute.attribute.stride);
+
+		for (uint32_t vertex = 0; vertex < primitive.vertices_count && (vertex + 1) * attribute.attribute.stride <= attribute.data.size(); vertex++)
+		{
+			std::memcpy(stream.data.data() + vertex * stream.attribute.stride + interleaved.attribute.offset,
+			            attribute.data.data() + vertex * attribute.attribute.stride, element_size);
+		}
 	}
 
-	if (!err.empty())
+	primitive.attributes.erase(std::remove_if(primitive.attributes.begin(), primitive.attributes.end(),
+	                                          [](const AttributeData &attribute) { return attribute.name != "position"; }),
+	                           primitive.attributes.end());
+
+	primitive.attributes.push_back(std::move(stream));
+}
+
+/**
+ * @brief Reads the index data of a primitive as 32-bit indices, whatever its index type
+ * @return False if an index is out of the range of the vertices
+ */
+bool read_indices(const PrimitiveData &primitive, std::vector<uint32_t> &indices)
+{
+	bool is_uint16 = primitive.index_type == VK_INDEX_TYPE_UINT16;
+
+	indices.resize(primitive.vertex_indices);
+
+	for (size_t i = 0; i < indices.size(); i++)
 	{
-		LOGE("Error loading gltf model: {}.", err.c_str());
+		if (is_uint16)
+		{
+			uint16_t index;
+			std::memcpy(&index, primitive.index_data.data() + i * sizeof(uint16_t), sizeof(uint16_t));
+			indices[i] = index;
+		}
+		else
+		{
+			std::memcpy(&indices[i], primitive.index_data.data() + i * sizeof(uint32_t), sizeof(uint32_t));
+		}
 
-		return nullptr;
+		if (indices[i] >= primitive.vertices_count)
+		{
+			return false;
+		}
 	}
 
-	if (!warn.empty())
+	return true;
+}
+
+/**
+ * @brief Packs 32-bit indices into index data of the given type
+ */
+std::vector<uint8_t> write_indices(const std::vector<uint32_t> &indices, VkIndexType index_type)
+{
+	std::vector<uint8_t> index_data;
+
+	if (index_type == VK_INDEX_TYPE_UINT16)
 	{
-		LOGI("{}", warn.c_str());
+		index_data.resize(indices.size() * sizeof(uint16_t));
+
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			auto index = static_cast<uint16_t>(indices[i]);
+			std::memcpy(index_data.data() + i * sizeof(uint16_t), &index, sizeof(uint16_t));
+		}
+	}
+	else
+	{
+		index_data.resize(indices.size() * sizeof(uint32_t));
+		std::memcpy(index_data.data(), indices.data(), index_data.size());
 	}
 
-	size_t pos = file_name.find_last_of('/');
+	return index_data;
+}
 
-	model_path = file_name.substr(0, pos);
+/**
+ * @brief Reorders the triangles and vertices of an indexed triangle list for the post-transform vertex cache,
+ *        then for overdraw when it has float positions, and finally the vertices in the order of their first use
+ *        All the attributes are permuted along with the vertices, so the vertex count does not change.
+ */
+void optimize_mesh(PrimitiveData &primitive)
+{
+	std::vector<uint32_t> indices;
 
-	if (pos == std::string::npos)
+	if (!read_indices(primitive, indices))
 	{
-		model_path.clear();
+		LOGW("Primitive has out of range indices, skipping mesh optimization");
+		return;
+	}
+
+	auto &stats = primitive.optimization_stats;
+
+	stats.triangle_count     = indices.size() / 3;
+	stats.transformed_before = compute_acmr(indices, primitive.vertices_count) * stats.triangle_count;
+
+	optimize_vertex_cache(indices, primitive.vertices_count);
+
+	auto position_it = std::find_if(primitive.attributes.begin(), primitive.attributes.end(),
+	                                [](const AttributeData &attribute) { return attribute.name == "position"; });
+
+	if (position_it != primitive.attributes.end() && position_it->attribute.format == VK_FORMAT_R32G32B32_SFLOAT)
+	{
+		optimize_overdraw(indices, position_it->data.data(), position_it->attribute.stride, primitive.vertices_count);
 	}
 
-	return std::make_unique<sg::Scene>(load_scene(scene_index));
+	// Every attribute must hold all the vertices to be permuted
+	bool can_remap = std::all_of(primitive.attributes.begin(), primitive.attributes.end(), [&primitive](const AttributeData &attribute) {
+		return attribute.attribute.stride > 0 && attribute.data.size() >= size_t{primitive.vertices_count} * attribute.attribute.stride;
+	});
+
+	if (can_remap)
+	{
+		auto remap = optimize_vertex_fetch(indices, primitive.vertices_count);
+
+		for (auto &attribute : primitive.attributes)
+		{
+			std::vector<uint8_t> data(attribute.data.size());
+
+			size_t stride = attribute.attribute.stride;
+
+			for (uint32_t vertex = 0; vertex < primitive.vertices_count; vertex++)
+			{
+				std::memcpy(data.data() + remap[vertex] * stride, attribute.data.data() + vertex * stride, stride);
+			}
+
+			attribute.data.swap(data);
+		}
+	}
+
+	stats.transformed_after = compute_acmr(indices, primitive.vertices_count) * stats.triangle_count;
+
+	primitive.index_data = write_indices(indices, primitive.index_type);
 }
 
-sg::Scene GLTFLoader::load_scene(int scene_index)
+/**
+ * @brief Splits an indexed triangle list into meshlets of consecutive triangles, with their bounds and normal cones
+ *        A meshlet ends once the next triangle would exceed its vertex or triangle count, so the meshlets follow
+ *        the order left by optimize_mesh() and the index data is not changed.
+ */
+void generate_meshlets(PrimitiveData &primitive)
 {
-	auto scene = sg::Scene();
+	auto position_it = std::find_if(primitive.attributes.begin(), primitive.attributes.end(),
+	                                [](const AttributeData &attribute) { return attribute.name == "position"; });
 
-	scene.set_name("gltf_scene");
+	if (position_it == primitive.attributes.end() || position_it->attribute.format != VK_FORMAT_R32G32B32_SFLOAT)
+	{
+		return;
+	}
 
-	// Check extensions
-	for (auto &used_extension : model.extensionsUsed)
+	std::vector<uint32_t> indices;
+
+	if (!read_indices(primitive, indices))
 	{
-		auto it = supported_extensions.find(used_extension);
+		LOGW("Primitive has out of range indices, skipping meshlet generation");
+		return;
+	}
 
-		// Check if extension isn't supported by the GLTFLoader
-		if (it == supported_extensions.end())
+	// Vertices of the current meshlet, marked with the index of the meshlet
+	std::vector<uint32_t> vertex_meshlets(primitive.vertices_count, std::numeric_limits<uint32_t>::max());
+
+	size_t triangle_count = indices.size() / 3;
+	size_t first_triangle = 0;
+
+	while (first_triangle < triangle_count)
+	{
+		auto     meshlet_index = to_u32(primitive.meshlets.size());
+		uint32_t vertex_count  = 0;
+		size_t   end_triangle  = first_triangle;
+
+		for (; end_triangle < triangle_count && end_triangle - first_triangle < sg::Meshlet::MAX_TRIANGLES; end_triangle++)
 		{
-			// If extension is required then we shouldn't allow the scene to be loaded
-			if (std::find(model.extensionsRequired.begin(), model.extensionsRequired.end(), used_extension) != model.extensionsRequired.end())
+			uint32_t new_vertices = 0;
+
+			for (size_t k = 0; k < 3; k++)
 			{
-				throw std::runtime_error("Cannot load glTF file. Contains a required unsupported extension: " + used_extension);
+				uint32_t index = indices[end_triangle * 3 + k];
+
+				// Repeated vertices of a degenerate triangle are only counted once
+				bool repeated = (k > 0 && index == indices[end_triangle * 3]) || (k > 1 && index == indices[end_triangle * 3 + 1]);
+
+				if (vertex_meshlets[index] != meshlet_index && !repeated)
+				{
+					new_vertices++;
+				}
 			}
-			else
+
+			if (vertex_count + new_vertices > sg::Meshlet::MAX_VERTICES)
 			{
-				// Otherwise, if extension isn't required (but is in the file) then print a warning to the user
-				LOGW("glTF file contains an unsupported extension, unexpected results may occur: {}", used_extension);
+				break;
+			}
+
+			for (size_t k = 0; k < 3; k++)
+			{
+				vertex_meshlets[indices[end_triangle * 3 + k]] = meshlet_index;
 			}
+
+			vertex_count += new_vertices;
 		}
-		else
+
+		glm::vec3 bounds_min{std::numeric_limits<float>::max()};
+		glm::vec3 bounds_max{-std::numeric_limits<float>::max()};
+		glm::vec3 normal_sum{0.0f};
+
+		std::vector<glm::vec3> normals;
+		normals.reserve(end_triangle - first_triangle);
+
+		for (size_t triangle = first_triangle; triangle < end_triangle; triangle++)
 		{
-			// Extension is supported, so enable it
-			LOGI("glTF file contains extension: {}", used_extension);
-			it->second = true;
+			auto p0 = read_element<glm::vec3>(*position_it, indices[triangle * 3]);
+			auto p1 = read_element<glm::vec3>(*position_it, indices[triangle * 3 + 1]);
+			auto p2 = read_element<glm::vec3>(*position_it, indices[triangle * 3 + 2]);
+
+			bounds_min = glm::min(bounds_min, glm::min(p0, glm::min(p1, p2)));
+			bounds_max = glm::max(bounds_max, glm::max(p0, glm::max(p1, p2)));
+
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float     length = glm::length(normal);
+
+			// Degenerate triangles are never rasterized, so they do not widen the cone
+			if (length > 0.0f)
+			{
+				normals.push_back(normal / length);
+				normal_sum += normals.back();
+			}
+		}
+
+		sg::Meshlet meshlet;
+
+		glm::vec3 center = (bounds_min + bounds_max) * 0.5f;
+		float     radius = 0.0f;
+
+		for (size_t i = first_triangle * 3; i < end_triangle * 3; i++)
+		{
+			radius = std::max(radius, glm::length(read_element<glm::vec3>(*position_it, indices[i]) - center));
+		}
+
+		meshlet.bounding_sphere = glm::vec4(center, radius);
+
+		// The cone is only usable if all the normals lie in the hemisphere around its axis
+		float     axis_length = glm::length(normal_sum);
+		glm::vec3 axis        = axis_length > 0.0f ? normal_sum / axis_length : glm::vec3{0.0f, 0.0f, 1.0f};
+		float     min_cosine  = 1.0f;
+
+		for (auto &normal : normals)
+		{
+			min_cosine = std::min(min_cosine, glm::dot(normal, axis));
+		}
+
+		float sine = min_cosine > 0.0f && axis_length > 0.0f ? std::sqrt(1.0f - min_cosine * min_cosine) : 1.0f;
+
+		meshlet.normal_cone = glm::vec4(axis, sine);
+		meshlet.first_index = to_u32(first_triangle * 3);
+		meshlet.index_count = to_u32((end_triangle - first_triangle) * 3);
+
+		primitive.meshlets.push_back(meshlet);
+
+		first_triangle = end_triangle;
+	}
+}
+
+/// Resolutions of the grids clustering the vertices of the generated levels of detail, from the finest
+constexpr uint32_t LOD_GRID_RESOLUTIONS[] = {64, 32, 16, 8};
+
+/// Primitives with fewer triangles are only drawn at full detail
+constexpr uint32_t LOD_MIN_TRIANGLES = 256;
+
+/// Fraction of the triangles of the previous level a generated level must remove to be kept
+constexpr float LOD_MIN_REDUCTION = 0.25f;
+
+/**
+ * @brief Generates coarser index data for an indexed triangle list, by vertex clustering
+ *        The vertices falling in the same cell of a grid over the bounds collapse onto one of them,
+ *        and the triangles which degenerate are dropped. The levels share the vertices of the primitive,
+ *        so it must run before the positions are quantized.
+ */
+void generate_lods(PrimitiveData &primitive, bool optimize)
+{
+	auto position_it = std::find_if(primitive.attributes.begin(), primitive.attributes.end(),
+	                                [](const AttributeData &attribute) { return attribute.name == "position"; });
+
+	if (position_it == primitive.attributes.end() || position_it->attribute.format != VK_FORMAT_R32G32B32_SFLOAT ||
+	    !primitive.has_bounds || primitive.vertex_indices / 3 < LOD_MIN_TRIANGLES)
+	{
+		return;
+	}
+
+	glm::vec3 extent     = primitive.bounds_max - primitive.bounds_min;
+	float     max_extent = std::max({extent.x, extent.y, extent.z});
+
+	if (max_extent <= 0.0f)
+	{
+		return;
+	}
+
+	std::vector<uint32_t> indices;
+
+	if (!read_indices(primitive, indices))
+	{
+		LOGW("Primitive has out of range indices, skipping level of detail generation");
+		return;
+	}
+
+	std::vector<uint32_t>                  remap(primitive.vertices_count);
+	std::unordered_map<uint64_t, uint32_t> cells;
+
+	size_t previous_count = indices.size();
+
+	for (auto resolution : LOD_GRID_RESOLUTIONS)
+	{
+		float cell_size = max_extent / resolution;
+
+		// Vertices collapse onto the first vertex of their cell, so that the level keeps valid attributes
+		cells.clear();
+
+		for (uint32_t vertex = 0; vertex < primitive.vertices_count; vertex++)
+		{
+			auto position = read_element<glm::vec3>(*position_it, vertex);
+
+			// Vertices not referenced by the indices may lie outside of the bounds
+			glm::uvec3 cell{glm::clamp((position - primitive.bounds_min) / cell_size, glm::vec3{0.0f}, glm::vec3{static_cast<float>(resolution - 1)})};
+
+			uint64_t key = (static_cast<uint64_t>(cell.x) << 42) | (static_cast<uint64_t>(cell.y) << 21) | cell.z;
+
+			remap[vertex] = cells.emplace(key, vertex).first->second;
+		}
+
+		std::vector<uint32_t> lod_indices;
+		lod_indices.reserve(previous_count);
+
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			uint32_t a = remap[indices[i]];
+			uint32_t b = remap[indices[i + 1]];
+			uint32_t c = remap[indices[i + 2]];
+
+			// Triangles collapsed into a line or a point are dropped
+			if (a != b && b != c && a != c)
+			{
+				lod_indices.push_back(a);
+				lod_indices.push_back(b);
+				lod_indices.push_back(c);
+			}
+		}
+
+		if (lod_indices.empty())
+		{
+			break;
+		}
+
+		if (lod_indices.size() > previous_count * (1.0f - LOD_MIN_REDUCTION))
+		{
+			continue;
+		}
+
+		previous_count = lod_indices.size();
+
+		PrimitiveLod lod;
+
+		lod.vertex_indices = to_u32(lod_indices.size());
+
+		// A vertex moves at most by the diagonal of its cell
+		lod.error = cell_size * std::sqrt(3.0f);
+
+		if (optimize)
+		{
+			// The vertices are shared with the full detail level, so only the triangles are reordered
+			optimize_vertex_cache(lod_indices, primitive.vertices_count);
+		}
+
+		lod.index_data = write_indices(lod_indices, primitive.index_type);
+
+		primitive.lods.push_back(std::move(lod));
+	}
+}
+
+/**
+ * @return Whether two lists of attributes have the same names and layouts, so that their data can be concatenated
+ */
+bool have_same_layout(const std::vector<AttributeData> &attributes, const std::vector<AttributeData> &other_attributes)
+{
+	return attributes.size() == other_attributes.size() &&
+	       std::equal(attributes.begin(), attributes.end(), other_attributes.begin(), [](const AttributeData &attribute, const AttributeData &other) {
+		       return attribute.name == other.name && attribute.attribute.format == other.attribute.format &&
+		              attribute.attribute.stride == other.attribute.stride && attribute.attribute.offset == other.attribute.offset;
+	       });
+}
+
+/**
+ * @brief Appends the vertices and triangles of a primitive to another one, rebasing its indices after the vertices
+ *        it is appended to. The index type is widened if the merged vertices do not fit the narrower one.
+ * @return False if the primitives cannot be merged: they must be indexed triangle lists with the same attributes,
+ *         without levels of detail, which are simplified for each primitive
+ */
+bool merge_primitives(PrimitiveData &primitive, const PrimitiveData &other)
+{
+	if (!primitive.indexed_triangle_list || !other.indexed_triangle_list || !primitive.lods.empty() || !other.lods.empty() ||
+	    primitive.has_bounds != other.has_bounds || !have_same_layout(primitive.attributes, other.attributes) ||
+	    !have_same_layout(primitive.interleaved_attributes, other.interleaved_attributes))
+	{
+		return false;
+	}
+
+	std::vector<uint32_t> indices;
+	std::vector<uint32_t> other_indices;
+
+	if (!read_indices(primitive, indices) || !read_indices(other, other_indices))
+	{
+		return false;
+	}
+
+	for (auto index : other_indices)
+	{
+		indices.push_back(primitive.vertices_count + index);
+	}
+
+	for (auto meshlet : other.meshlets)
+	{
+		meshlet.first_index += primitive.vertex_indices;
+		primitive.meshlets.push_back(meshlet);
+	}
+
+	for (size_t i = 0; i < primitive.attributes.size(); i++)
+	{
+		auto &data = primitive.attributes[i].data;
+		data.insert(data.end(), other.attributes[i].data.begin(), other.attributes[i].data.end());
+	}
+
+	primitive.vertices_count += other.vertices_count;
+	primitive.vertex_indices += other.vertex_indices;
+
+	// 0xFFFF is left out of 16-bit indices, as the primitive restart value
+	primitive.index_type = primitive.vertices_count <= std::numeric_limits<uint16_t>::max() ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+	primitive.index_data = write_indices(indices, primitive.index_type);
+
+	primitive.bounds_min = glm::min(primitive.bounds_min, other.bounds_min);
+	primitive.bounds_max = glm::max(primitive.bounds_max, other.bounds_max);
+
+	return true;
+}
+
+/**
+ * @brief Copies the vertex and index data of a primitive, and computes its bounds
+ *        It only reads the model, so that primitives are processed concurrently
+ * @param quantize Whether to reduce the size of the vertex attributes, see quantize_attributes()
+ * @param generate_lod Whether to generate levels of detail for triangle lists, see generate_lods()
+ * @param optimize Whether to reorder triangle lists for the vertex cache and overdraw, see optimize_mesh()
+ * @param split_meshlets Whether to split triangle lists into meshlets, see generate_meshlets()
+ * @param interleave Whether to interleave the attributes other than the positions, see interleave_attributes()
+ */
+PrimitiveData parse_primitive_data(const tinygltf::Model &model, const tinygltf::Primitive &gltf_primitive, bool quantize, bool generate_lod, bool optimize, bool split_meshlets,
+                                   bool interleave)
+{
+	PrimitiveData primitive;
+
+	for (auto &attribute : gltf_primitive.attributes)
+	{
+		AttributeData attribute_data;
+
+		attribute_data.name = attribute.first;
+		std::transform(attribute_data.name.begin(), attribute_data.name.end(), attribute_data.name.begin(), ::tolower);
+
+		attribute_data.data             = get_attribute_data(&model, attribute.second);
+		attribute_data.attribute.format = get_attribute_format(&model, attribute.second);
+		attribute_data.attribute.stride = to_u32(get_attribute_stride(&model, attribute.second));
+
+		if (attribute_data.name == "position")
+		{
+			primitive.vertices_count = to_u32(model.accessors.at(attribute.second).count);
+		}
+
+		primitive.attributes.push_back(std::move(attribute_data));
+	}
+
+	// Bounds are computed from the host copy of the data, as the buffers may not be mappable
+	auto position_it = std::find_if(primitive.attributes.begin(), primitive.attributes.end(),
+	                                [](const AttributeData &attribute) { return attribute.name == "position"; });
+
+	sg::AABB bounds;
+
+	if (gltf_primitive.indices >= 0)
+	{
+		primitive.vertex_indices = to_u32(get_attribute_size(&model, gltf_primitive.indices));
+
+		auto format = get_attribute_format(&model, gltf_primitive.indices);
+
+		primitive.index_data = get_attribute_data(&model, gltf_primitive.indices);
+
+		switch (format)
+		{
+			case VK_FORMAT_R8_UINT:
+				// Converts uint8 data into uint16 data, still represented by a uint8 vector
+				primitive.index_data = convert_underlying_data_stride(primitive.index_data, 1, 2);
+				primitive.index_type = VK_INDEX_TYPE_UINT16;
+				break;
+			case VK_FORMAT_R16_UINT:
+				primitive.index_type = VK_INDEX_TYPE_UINT16;
+				break;
+			case VK_FORMAT_R32_UINT:
+				primitive.index_type = VK_INDEX_TYPE_UINT32;
+				break;
+			default:
+				LOGE("gltf primitive has invalid format type");
+				break;
+		}
+
+		// 32-bit indices are narrowed whenever the vertices fit, leaving out 0xFFFF as the primitive restart value
+		std::vector<uint32_t> indices;
+
+		if (primitive.index_type == VK_INDEX_TYPE_UINT32 && primitive.vertices_count <= std::numeric_limits<uint16_t>::max() &&
+		    read_indices(primitive, indices))
+		{
+			primitive.index_data = write_indices(indices, VK_INDEX_TYPE_UINT16);
+			primitive.index_type = VK_INDEX_TYPE_UINT16;
+		}
+
+		if (position_it != primitive.attributes.end())
+		{
+			bounds.update(position_it->data.data(), position_it->attribute.stride, primitive.vertices_count,
+			              primitive.index_data.data(), primitive.vertex_indices, primitive.index_type);
+		}
+	}
+	else
+	{
+		primitive.vertices_count = to_u32(get_attribute_size(&model, gltf_primitive.attributes.at("POSITION")));
+
+		if (position_it != primitive.attributes.end())
+		{
+			bounds.update(position_it->data.data(), position_it->attribute.stride, primitive.vertices_count);
+		}
+	}
+
+	primitive.has_bounds = position_it != primitive.attributes.end();
+	primitive.bounds_min = bounds.get_min();
+	primitive.bounds_max = bounds.get_max();
+
+	bool is_triangle_list = gltf_primitive.mode == TINYGLTF_MODE_TRIANGLES || gltf_primitive.mode == -1;
+
+	primitive.indexed_triangle_list = is_triangle_list && gltf_primitive.indices >= 0;
+
+	if (optimize && is_triangle_list && gltf_primitive.indices >= 0)
+	{
+		optimize_mesh(primitive);
+	}
+
+	if (split_meshlets && is_triangle_list && gltf_primitive.indices >= 0)
+	{
+		generate_meshlets(primitive);
+	}
+
+	if (generate_lod && is_triangle_list && gltf_primitive.indices >= 0)
+	{
+		generate_lods(primitive, optimize);
+	}
+
+	if (quantize)
+	{
+		quantize_attributes(primitive);
+	}
+
+	if (interleave)
+	{
+		interleave_attributes(primitive);
+	}
+
+	return primitive;
+}
+
+/**
+ * @brief Copies the elements of a float accessor, e.g. the keyframes of an animation
+ * @param type Expected glTF type of the elements, matching the size of T
+ * @return False if the accessor does not hold elements of this type
+ */
+template <typename T>
+bool get_float_elements(const tinygltf::Model &model, int accessor_index, int type, std::vector<T> &elements)
+{
+	auto &accessor = model.accessors.at(accessor_index);
+
+	if (accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || accessor.type != type || accessor.bufferView < 0)
+	{
+		return false;
+	}
+
+	auto data   = get_attribute_data(&model, accessor_index);
+	auto stride = get_attribute_stride(&model, accessor_index);
+
+	elements.resize(accessor.count);
+
+	for (size_t i = 0; i < accessor.count; i++)
+	{
+		std::memcpy(&elements[i], data.data() + i * stride, sizeof(T));
+	}
+
+	return true;
+}
+
+/**
+ * @brief Image read back from the scene cache, already in the format sampled by the device
+ */
+class CachedImage : public sg::Image
+{
+  public:
+	CachedImage(const std::string &name, const std::string &uri, VkFormat format, std::vector<uint8_t> &&data, std::vector<sg::Mipmap> &&mipmaps) :
+	    Image{name, std::move(data), std::move(mipmaps)}
+	{
+		set_format(format);
+		set_uri(uri);
+	}
+};
+
+/**
+ * @return Name of the cache file of a scene, relative to the temporary storage directory
+ *         Each combination of the geometry processing options and image variant has its own cache, as the data differs
+ */
+std::string get_scene_cache_file(const std::string &file_name, int scene_index, bool vertex_quantization, bool lod_generation, bool mesh_optimization, bool meshlet_generation,
+                                 bool interleaved_vertices, bool primitive_merging, const std::string &image_variant)
+{
+	std::string name = file_name;
+	std::replace(name.begin(), name.end(), '/', '_');
+
+	std::string variant = std::string{vertex_quantization ? "_quantized" : ""} + (lod_generation ? "_lod" : "") +
+	                      (mesh_optimization ? "_optimized" : "") + (meshlet_generation ? "_meshlets" : "") +
+	                      (interleaved_vertices ? "_interleaved" : "") + (primitive_merging ? "_merged" : "") +
+	                      (image_variant.empty() ? "" : "_" + image_variant);
+
+	return "scene_cache_" + name + "_" + std::to_string(scene_index) + variant + ".data";
+}
+
+/**
+ * @return True if the uri refers to a file, rather than embedding its data
+ */
+bool is_file_uri(const std::string &uri)
+{
+	return !uri.empty() && uri.compare(0, 5, "data:") != 0;
+}
+
+/**
+ * @return Path of the KTX variant of an image in the variant directory next to the glTF file,
+ *         or an empty string if there is none
+ */
+std::string get_image_variant_uri(const std::string &model_path, const std::string &variant, const std::string &uri)
+{
+	std::string variant_uri = model_path + "/" + variant + "/" + uri.substr(0, uri.find_last_of('.')) + ".ktx";
+
+	uint64_t size;
+	int64_t  modification_time;
+	if (!fs::get_file_stamp(fs::path::get(fs::path::Type::Assets) + variant_uri, size, modification_time))
+	{
+		return {};
+	}
+
+	return variant_uri;
+}
+}        // namespace
+
+std::unordered_map<std::string, bool> GLTFLoader::supported_extensions = {
+    {KHR_LIGHTS_PUNCTUAL_EXTENSION, false},
+    {KHR_TEXTURE_BASISU_EXTENSION, false}};
+
+GLTFLoader::GLTFLoader(Device &device) :
+    device{device}
+{
+}
+
+GLTFLoader::~GLTFLoader()
+{
+	// Finish the images being decoded, which use the model and the device
+	for (auto &fut : image_futures)
+	{
+		if (fut.valid())
+		{
+			fut.wait();
+		}
+	}
+}
+
+void GLTFLoader::set_scene_cache_enabled(bool enabled)
+{
+	scene_cache_enabled = enabled;
+}
+
+void GLTFLoader::set_progressive_loading(bool enabled)
+{
+	progressive_loading = enabled;
+}
+
+bool GLTFLoader::update_streaming(CommandBuffer &command_buffer)
+{
+	if (!streaming_upload_manager)
+	{
+		return false;
+	}
+
+	VKB_PROFILE_SCOPE("GLTFLoader::update_streaming");
+
+	// Patch the textures of the images whose upload has completed
+	for (auto it = uploading_images.begin(); it != uploading_images.end();)
+	{
+		if (!streaming_upload_manager->is_complete(it->batch_id))
+		{
+			++it;
+			continue;
+		}
+
+		for (auto texture : streamed_textures.at(it->image_index))
+		{
+			texture->set_image(*it->image);
+		}
+
+		streaming_scene->add_component(std::move(it->image));
+
+		it = uploading_images.erase(it);
+	}
+
+	// Resources released by the transfer queue must be acquired before the frame uses them
+	streaming_upload_manager->acquire(command_buffer);
+
+	// Upload the images decoded since the last call, in a single batch
+	bool uploaded = false;
+
+	for (size_t image_index = 0; image_index < image_futures.size(); image_index++)
+	{
+		auto &fut = image_futures[image_index];
+
+		if (!fut.valid() || fut.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			continue;
+		}
+
+		auto image = fut.get();
+
+		streaming_upload_manager->upload(*image);
+
+		// Clean up the image data, as they are copied in the staging ring
+		release_image_data(*image);
+
+		uploading_images.push_back({image_index, std::move(image), 0});
+		uploaded = true;
+	}
+
+	if (uploaded)
+	{
+		auto batch_id = streaming_upload_manager->submit();
+
+		for (auto &streamed : uploading_images)
+		{
+			if (streamed.batch_id == 0)
+			{
+				streamed.batch_id = batch_id;
+			}
+		}
+	}
+
+	bool decoding = std::any_of(image_futures.begin(), image_futures.end(), [](const std::future<std::unique_ptr<sg::Image>> &fut) {
+		return fut.valid();
+	});
+
+	if (!decoding && uploading_images.empty())
+	{
+		LOGI("Streamed all the images of the scene");
+
+		image_futures.clear();
+		streaming_upload_manager.reset();
+		streaming_scene = nullptr;
+
+		// The glTF images and buffers were only kept for the decoding jobs
+		model = {};
+
+		return false;
+	}
+
+	return true;
+}
+
+std::unique_ptr<sg::Image> GLTFLoader::create_placeholder_image()
+{
+	std::vector<uint8_t>    data{255, 255, 255, 255};
+	std::vector<sg::Mipmap> mipmaps{{0, 0, {1, 1, 1}}};
+
+	auto image = std::make_unique<sg::Image>("placeholder_image", std::move(data), std::move(mipmaps));
+
+	image->create_vk_image(device);
+
+	return image;
+}
+
+void GLTFLoader::set_staged_geometry_upload(bool enabled)
+{
+	staged_geometry_upload = enabled;
+}
+
+void GLTFLoader::set_staging_budget(VkDeviceSize size)
+{
+	staging_budget = size;
+}
+
+void GLTFLoader::set_keep_image_data(bool enabled)
+{
+	keep_image_data = enabled;
+}
+
+void GLTFLoader::add_resident_image(const std::string &name)
+{
+	resident_images.insert(name);
+}
+
+void GLTFLoader::set_vertex_quantization(bool enabled)
+{
+	vertex_quantization = enabled;
+}
+
+void GLTFLoader::set_lod_generation(bool enabled)
+{
+	lod_generation = enabled;
+}
+
+void GLTFLoader::set_mesh_optimization(bool enabled)
+{
+	mesh_optimization = enabled;
+}
+
+void GLTFLoader::set_meshlet_generation(bool enabled)
+{
+	meshlet_generation = enabled;
+}
+
+void GLTFLoader::set_primitive_merging(bool enabled)
+{
+	primitive_merging = enabled;
+}
+
+void GLTFLoader::set_interleaved_vertices(bool enabled)
+{
+	interleaved_vertices = enabled;
+}
+
+void GLTFLoader::set_image_variant(const std::string &variant)
+{
+	image_variant = variant;
+}
+
+std::unique_ptr<sg::Scene> GLTFLoader::read_scene_from_file(const std::string &file_name, int scene_index)
+{
+	VKB_PROFILE_SCOPE("GLTFLoader::read_scene_from_file");
+
+	load_stats = {};
+
+	image_decode_ns    = 0;
+	mip_generation_ns  = 0;
+	mesh_processing_ns = 0;
+
+	Timer total_timer;
+	total_timer.start();
+
+	if (scene_cache_enabled)
+	{
+		try
+		{
+			SceneCacheReader reader{device, get_scene_cache_file(file_name, scene_index, vertex_quantization, lod_generation, mesh_optimization, meshlet_generation, interleaved_vertices, primitive_merging, image_variant)};
+
+			if (reader.is_fresh())
+			{
+				auto scene = std::make_unique<sg::Scene>(load_cached_scene(reader));
+
+				load_stats.total_time = total_timer.stop();
+
+				LOGI("Loaded scene {} from its cache", file_name);
+
+				return scene;
+			}
+		}
+		catch (std::exception &ex)
+		{
+			LOGW("Cannot load the scene cache of {}. {}", file_name, ex.what());
+		}
+	}
+
+	std::string err;
+	std::string warn;
+
+	tinygltf::TinyGLTF gltf_loader;
+
+	std::string gltf_file = vkb::fs::path::get(vkb::fs::path::Type::Assets) + file_name;
+
+	// The file is read separately from the parsing so that the two are measured on their own
+	Timer stage_timer;
+	stage_timer.start();
+
+	std::vector<uint8_t> gltf_data;
+
+	try
+	{
+		gltf_data = fs::read_asset(file_name);
+	}
+	catch (std::exception &ex)
+	{
+		LOGE("Failed to read gltf file {}. {}", gltf_file.c_str(), ex.what());
+
+		return nullptr;
+	}
+
+	load_stats.file_io_time = stage_timer.elapsed();
+	stage_timer.lap();
+
+	std::string base_dir = gltf_file.substr(0, gltf_file.find_last_of('/') + 1);
+
+	bool importResult = gltf_loader.LoadASCIIFromString(&model, &err, &warn, reinterpret_cast<const char *>(gltf_data.data()), to_u32(gltf_data.size()), base_dir);
+
+	load_stats.parse_time = stage_timer.elapsed();
+
+	if (!importResult)
+	{
+		LOGE("Failed to load gltf file {}.", gltf_file.c_str());
+
+		return nullptr;
+	}
+
+	if (!err.empty())
+	{
+		LOGE("Error loading gltf model: {}.", err.c_str());
+
+		return nullptr;
+	}
+
+	if (!warn.empty())
+	{
+		LOGI("{}", warn.c_str());
+	}
+
+	size_t pos = file_name.find_last_of('/');
+
+	model_path = file_name.substr(0, pos);
+
+	if (pos == std::string::npos)
+	{
+		model_path.clear();
+	}
+
+	// Streamed images are not known when the scene is returned, so they cannot be cooked,
+	// and neither can skins nor animations, which the cache does not store
+	if (scene_cache_enabled && !progressive_loading && model.skins.empty() && model.animations.empty())
+	{
+		scene_cache_writer = std::make_unique<SceneCacheWriter>(device);
+	}
+
+	auto scene = std::make_unique<sg::Scene>(load_scene(scene_index));
+
+	if (scene_cache_writer)
+	{
+		write_scene_cache(file_name, scene_index);
+	}
+
+	if (progressive_loading)
+	{
+		// Streamed images are added to the scene once they are uploaded
+		streaming_scene = scene.get();
+	}
+	else
+	{
+		// The scene holds everything it needs, so the host copies of the glTF images and buffers are released
+		model = {};
+	}
+
+	// The mip levels generated while decoding are already counted in the decoding jobs
+	load_stats.mip_generation_time += mip_generation_ns * 1e-9;
+	load_stats.image_decode_time    = (image_decode_ns - std::min<uint64_t>(image_decode_ns, mip_generation_ns)) * 1e-9;
+	load_stats.mesh_processing_time = mesh_processing_ns * 1e-9;
+	load_stats.total_time           = total_timer.stop();
+
+	return scene;
+}
+
+const GLTFLoader::LoadStats &GLTFLoader::get_load_stats() const
+{
+	return load_stats;
+}
+
+void GLTFLoader::add_upload_stats(const UploadManager &upload_manager, double elapsed_time)
+{
+	auto &statistics = upload_manager.get_statistics();
+
+	load_stats.mip_generation_time += statistics.mip_generation_time;
+	load_stats.fence_wait_time += statistics.fence_wait_time;
+	load_stats.upload_time += std::max(0.0, elapsed_time - statistics.mip_generation_time - statistics.fence_wait_time);
+	load_stats.peak_staging_usage = std::max(load_stats.peak_staging_usage, statistics.peak_staging_usage);
+}
+
+void GLTFLoader::release_image_data(sg::Image &image)
+{
+	if (keep_image_data || resident_images.count(image.get_name()) > 0)
+	{
+		load_stats.resident_image_data += image.get_data().size();
+	}
+	else
+	{
+		image.clear_data();
+	}
+}
+
+void GLTFLoader::write_scene_cache(const std::string &file_name, int scene_index)
+{
+	try
+	{
+		scene_cache_writer->add_dependency(file_name);
+
+		for (auto &gltf_buffer : model.buffers)
+		{
+			if (is_file_uri(gltf_buffer.uri))
+			{
+				scene_cache_writer->add_dependency(model_path + "/" + gltf_buffer.uri);
+			}
+		}
+
+		for (auto &gltf_image : model.images)
+		{
+			if (is_file_uri(gltf_image.uri))
+			{
+				scene_cache_writer->add_dependency(model_path + "/" + gltf_image.uri);
+			}
+		}
+
+		scene_cache_writer->save(get_scene_cache_file(file_name, scene_index, vertex_quantization, lod_generation, mesh_optimization, meshlet_generation, interleaved_vertices, primitive_merging, image_variant));
+	}
+	catch (std::exception &ex)
+	{
+		LOGW("Cannot write the scene cache of {}. {}", file_name, ex.what());
+	}
+
+	scene_cache_writer.reset();
+}
+
+void GLTFLoader::write_cached_image(const sg::Image &image)
+{
+	auto &os = scene_cache_writer->get_stream();
+
+	// Levels blitted at upload time are generated again when the cached image is uploaded
+	bool gpu_mipmaps = image.get_mip_level_count() != image.get_mipmaps().size();
+
+	write(os, image.get_name(), image.get_uri(), image.get_format(), image.get_mipmaps(), gpu_mipmaps);
+
+	scene_cache_writer->write_blob(image.get_data());
+}
+
+void GLTFLoader::write_cached_material(const sg::PBRMaterial &material, const std::vector<sg::Texture *> &textures)
+{
+	auto &os = scene_cache_writer->get_stream();
+
+	write(os, material.get_name(), material.base_color_factor, material.metallic_factor, material.roughness_factor,
+	      material.emissive, material.double_sided, material.alpha_cutoff, material.alpha_mode);
+
+	write(os, material.textures.size());
+
+	for (auto &texture : material.textures)
+	{
+		auto texture_index = static_cast<size_t>(std::find(textures.begin(), textures.end(), texture.second) - textures.begin());
+
+		write(os, texture.first, texture_index);
+	}
+}
+
+sg::Scene GLTFLoader::load_cached_scene(SceneCacheReader &reader)
+{
+	auto &is = reader.get_stream();
+
+	auto scene = sg::Scene();
+
+	scene.set_name("gltf_scene");
+
+	// Load lights
+	size_t light_count{0};
+	read(is, light_count);
+
+	std::vector<std::unique_ptr<sg::Light>> light_components;
+
+	for (size_t light_index = 0; light_index < light_count; light_index++)
+	{
+		std::string         name;
+		uint32_t            type{0};
+		sg::LightProperties properties;
+
+		read(is, name, type, properties);
+
+		auto light = std::make_unique<sg::Light>(name);
+		light->set_light_type(static_cast<sg::LightType>(type));
+		light->set_properties(properties);
+
+		light_components.push_back(std::move(light));
+	}
+
+	scene.set_components(std::move(light_components));
+
+	// Load samplers
+	size_t sampler_count{0};
+	read(is, sampler_count);
+
+	std::vector<std::unique_ptr<sg::Sampler>> sampler_components;
+
+	for (size_t sampler_index = 0; sampler_index < sampler_count; sampler_index++)
+	{
+		tinygltf::Sampler gltf_sampler;
+
+		read(is, gltf_sampler.name, gltf_sampler.minFilter, gltf_sampler.magFilter, gltf_sampler.wrapS, gltf_sampler.wrapT, gltf_sampler.wrapR);
+
+		sampler_components.push_back(parse_sampler(gltf_sampler));
+	}
+
+	scene.set_components(std::move(sampler_components));
+
+	// Load images, they are already in the format sampled by the device
+	size_t image_count{0};
+	read(is, image_count);
+
+	std::vector<std::unique_ptr<sg::Image>> image_components;
+
+	UploadManager upload_manager{device, staging_budget};
+
+	// Only the uploads are measured, as they are interleaved with the reading of the cache
+	Timer  upload_timer;
+	double upload_time{0.0};
+
+	for (size_t image_index = 0; image_index < image_count; image_index++)
+	{
+		std::string             name;
+		std::string             uri;
+		VkFormat                format{VK_FORMAT_UNDEFINED};
+		std::vector<sg::Mipmap> mipmaps;
+		bool                    gpu_mipmaps{false};
+
+		read(is, name, uri, format, mipmaps, gpu_mipmaps);
+
+		auto blob = reader.read_blob();
+
+		auto image = std::make_unique<CachedImage>(name, uri, format, std::vector<uint8_t>(blob.first, blob.first + blob.second), std::move(mipmaps));
+
+		if (gpu_mipmaps)
+		{
+			image->request_gpu_mipmaps(device);
+		}
+
+		image->create_vk_image(device);
+
+		upload_timer.start();
+
+		upload_manager.upload(*image);
+
+		upload_time += upload_timer.stop();
+
+		release_image_data(*image);
+
+		image_components.push_back(std::move(image));
+	}
+
+	upload_timer.start();
+
+	upload_manager.flush();
+
+	upload_time += upload_timer.stop();
+
+	scene.set_components(std::move(image_components));
+
+	// Load textures
+	auto images          = scene.get_components<sg::Image>();
+	auto samplers        = scene.get_components<sg::Sampler>();
+	auto default_sampler = create_default_sampler();
+
+	size_t texture_count{0};
+	read(is, texture_count);
+
+	for (size_t texture_index = 0; texture_index < texture_count; texture_index++)
+	{
+		tinygltf::Texture gltf_texture;
+
+		read(is, gltf_texture.name, gltf_texture.source, gltf_texture.sampler);
+
+		auto texture = parse_texture(gltf_texture);
+
+		texture->set_image(*images.at(gltf_texture.source));
+		texture->set_sampler(gltf_texture.sampler >= 0 ? *samplers.at(gltf_texture.sampler) : *default_sampler);
+
+		scene.add_component(std::move(texture));
+	}
+
+	scene.add_component(std::move(default_sampler));
+
+	// Load materials
+	auto textures = scene.get_components<sg::Texture>();
+
+	size_t material_count{0};
+	read(is, material_count);
+
+	for (size_t material_index = 0; material_index < material_count; material_index++)
+	{
+		tinygltf::Material gltf_material;
+		read(is, gltf_material.name);
+
+		auto material = parse_material(gltf_material);
+
+		read(is, material->base_color_factor, material->metallic_factor, material->roughness_factor,
+		     material->emissive, material->double_sided, material->alpha_cutoff, material->alpha_mode);
+
+		size_t material_texture_count{0};
+		read(is, material_texture_count);
+
+		for (size_t i = 0; i < material_texture_count; i++)
+		{
+			std::string tex_name;
+			size_t      texture_index{0};
+
+			read(is, tex_name, texture_index);
+
+			material->textures[tex_name] = textures.at(texture_index);
+		}
+
+		scene.add_component(std::move(material));
+	}
+
+	auto default_material = create_default_material();
+
+	// Load meshes, their data is copied straight from the mapped file
+	auto materials = scene.get_components<sg::PBRMaterial>();
+
+	auto geometry_memory_usage = staged_geometry_upload ? VMA_MEMORY_USAGE_GPU_ONLY : VMA_MEMORY_USAGE_GPU_TO_CPU;
+	auto geometry_arena        = std::make_unique<sg::GeometryArena>(device, GEOMETRY_BLOCK_SIZE, geometry_memory_usage);
+
+	size_t mesh_count{0};
+	read(is, mesh_count);
+
+	for (size_t mesh_index = 0; mesh_index < mesh_count; mesh_index++)
+	{
+		tinygltf::Mesh gltf_mesh;
+		size_t         submesh_count{0};
+
+		read(is, gltf_mesh.name, submesh_count);
+
+		auto mesh = parse_mesh(gltf_mesh);
+
+		for (size_t submesh_index = 0; submesh_index < submesh_count; submesh_index++)
+		{
+			auto submesh = std::make_unique<sg::SubMesh>();
+
+			size_t attribute_count{0};
+			read(is, attribute_count);
+
+			for (size_t attribute_index = 0; attribute_index < attribute_count; attribute_index++)
+			{
+				std::string         attrib_name;
+				sg::VertexAttribute attrib;
+
+				read(is, attrib_name, attrib.format, attrib.stride);
+
+				auto blob = reader.read_blob();
+
+				auto buffer = geometry_arena->allocate_vertices(blob.second);
+				geometry_arena->update(buffer, blob.first, blob.second);
+
+				submesh->vertex_buffers.insert(std::make_pair(attrib_name, std::move(buffer)));
+
+				if (attrib.format != VK_FORMAT_UNDEFINED)
+				{
+					submesh->set_attribute(attrib_name, attrib);
+				}
+			}
+
+			size_t interleaved_count{0};
+			read(is, interleaved_count);
+
+			for (size_t interleaved_index = 0; interleaved_index < interleaved_count; interleaved_index++)
+			{
+				std::string         attrib_name;
+				sg::VertexAttribute attrib;
+
+				read(is, attrib_name, attrib.format, attrib.stride, attrib.offset, attrib.stream);
+
+				submesh->set_attribute(attrib_name, attrib);
+			}
+
+			bool has_indices{false};
+			read(is, has_indices);
+
+			if (has_indices)
+			{
+				read(is, submesh->index_type, submesh->vertex_indices);
+
+				auto blob = reader.read_blob();
+
+				submesh->index_buffer = geometry_arena->allocate_indices(blob.second);
+				geometry_arena->update(submesh->index_buffer, blob.first, blob.second);
+
+				size_t lod_count{0};
+				read(is, lod_count);
+
+				submesh->lods.resize(lod_count);
+
+				for (auto &lod : submesh->lods)
+				{
+					read(is, lod.vertex_indices, lod.error);
+
+					auto lod_blob = reader.read_blob();
+
+					lod.index_buffer = geometry_arena->allocate_indices(lod_blob.second);
+					geometry_arena->update(lod.index_buffer, lod_blob.first, lod_blob.second);
+				}
+
+				size_t meshlet_count{0};
+				read(is, meshlet_count);
+
+				submesh->meshlets.resize(meshlet_count);
+
+				for (auto &meshlet : submesh->meshlets)
+				{
+					read(is, meshlet.bounding_sphere, meshlet.normal_cone, meshlet.first_index, meshlet.index_count);
+				}
+			}
+
+			int       material_index{-1};
+			bool      has_bounds{false};
+			glm::vec3 bounds_min;
+			glm::vec3 bounds_max;
+
+			read(is, submesh->vertices_count, material_index, has_bounds, bounds_min, bounds_max);
+
+			if (material_index < 0)
+			{
+				submesh->set_material(*default_material);
+			}
+			else
+			{
+				submesh->set_material(*materials.at(material_index));
+			}
+
+			if (has_bounds)
+			{
+				mesh->add_submesh(*submesh, sg::AABB{bounds_min, bounds_max});
+			}
+			else
+			{
+				mesh->add_submesh(*submesh);
+			}
+
+			scene.add_component(std::move(submesh));
+		}
+
+		scene.add_component(std::move(mesh));
+	}
+
+	upload_timer.start();
+
+	geometry_arena->flush(upload_manager);
+
+	upload_manager.flush();
+
+	add_upload_stats(upload_manager, upload_time + upload_timer.stop());
+
+	scene.add_component(std::move(geometry_arena));
+
+	scene.add_component(std::move(default_material));
+
+	// Load cameras
+	size_t camera_count{0};
+	read(is, camera_count);
+
+	for (size_t camera_index = 0; camera_index < camera_count; camera_index++)
+	{
+		tinygltf::Camera gltf_camera;
+
+		read(is, gltf_camera.name, gltf_camera.type, gltf_camera.perspective.aspectRatio,
+		     gltf_camera.perspective.yfov, gltf_camera.perspective.znear, gltf_camera.perspective.zfar);
+
+		scene.add_component(parse_camera(gltf_camera));
+	}
+
+	// Load nodes
+	auto meshes  = scene.get_components<sg::Mesh>();
+	auto cameras = scene.get_components<sg::Camera>();
+	auto lights  = scene.get_components<sg::Light>();
+
+	size_t node_count{0};
+	read(is, node_count);
+
+	std::vector<std::unique_ptr<sg::Node>> nodes;
+	std::vector<std::vector<int>>          node_children(node_count);
+
+	for (size_t node_index = 0; node_index < node_count; node_index++)
+	{
+		tinygltf::Node gltf_node;
+		glm::vec3      translation;
+		glm::quat      rotation;
+		glm::vec3      scale;
+		int            light_index{-1};
+
+		read(is, gltf_node.name, translation, rotation, scale, gltf_node.mesh, gltf_node.camera, light_index, node_children[node_index]);
+
+		// The transform is cached decomposed, whether the node had a matrix or not
+		gltf_node.translation = {translation.x, translation.y, translation.z};
+		gltf_node.rotation    = {rotation.x, rotation.y, rotation.z, rotation.w};
+		gltf_node.scale       = {scale.x, scale.y, scale.z};
+
+		auto node = parse_node(gltf_node);
+
+		if (gltf_node.mesh >= 0)
+		{
+			auto mesh = meshes.at(gltf_node.mesh);
+
+			node->set_component(*mesh);
+
+			mesh->add_node(*node);
+		}
+
+		if (gltf_node.camera >= 0)
+		{
+			auto camera = cameras.at(gltf_node.camera);
+
+			node->set_component(*camera);
+
+			camera->set_node(*node);
+		}
+
+		if (light_index >= 0)
+		{
+			auto light = lights.at(light_index);
+
+			node->set_component(*light);
+
+			light->set_node(*node);
+		}
+
+		nodes.push_back(std::move(node));
+	}
+
+	// Load the scene hierarchy
+	std::string      scene_name;
+	std::vector<int> scene_nodes;
+
+	read(is, scene_name, scene_nodes);
+
+	if (!is)
+	{
+		throw std::runtime_error("Scene cache is truncated");
+	}
+
+	auto root_node = std::make_unique<sg::Node>(scene_name);
+
+	std::queue<std::pair<sg::Node &, int>> traverse_nodes;
+
+	for (auto node_index : scene_nodes)
+	{
+		traverse_nodes.push(std::make_pair(std::ref(*root_node), node_index));
+	}
+
+	while (!traverse_nodes.empty())
+	{
+		auto node_it = traverse_nodes.front();
+		traverse_nodes.pop();
+
+		auto &current_node       = *nodes.at(node_it.second);
+		auto &traverse_root_node = node_it.first;
+
+		current_node.set_parent(traverse_root_node);
+		traverse_root_node.add_child(current_node);
+
+		for (auto child_node_index : node_children.at(node_it.second))
+		{
+			traverse_nodes.push(std::make_pair(std::ref(current_node), child_node_index));
+		}
+	}
+
+	scene.set_root_node(*root_node);
+	nodes.push_back(std::move(root_node));
+
+	scene.set_nodes(std::move(nodes));
+
+	add_default_camera_and_light(scene);
+
+	return scene;
+}
+
+sg::Scene GLTFLoader::load_scene(int scene_index)
+{
+	auto scene = sg::Scene();
+
+	scene.set_name("gltf_scene");
+
+	// Check extensions
+	for (auto &used_extension : model.extensionsUsed)
+	{
+		auto it = supported_extensions.find(used_extension);
+
+		// Check if extension isn't supported by the GLTFLoader
+		if (it == supported_extensions.end())
+		{
+			// If extension is required then we shouldn't allow the scene to be loaded
+			if (std::find(model.extensionsRequired.begin(), model.extensionsRequired.end(), used_extension) != model.extensionsRequired.end())
+			{
+				throw std::runtime_error("Cannot load glTF file. Contains a required unsupported extension: " + used_extension);
+			}
+			else
+			{
+				// Otherwise, if extension isn't required (but is in the file) then print a warning to the user
+				LOGW("glTF file contains an unsupported extension, unexpected results may occur: {}", used_extension);
+			}
+		}
+		else
+		{
+			// Extension is supported, so enable it
+			LOGI("glTF file contains extension: {}", used_extension);
+			it->second = true;
+		}
+	}
+
+	// Load lights
+	std::vector<std::unique_ptr<sg::Light>> light_components = parse_khr_lights_punctual();
+
+	if (scene_cache_writer)
+	{
+		auto &os = scene_cache_writer->get_stream();
+
+		write(os, light_components.size());
+
+		for (auto &light : light_components)
+		{
+			write(os, light->get_name(), static_cast<uint32_t>(light->get_light_type()), light->get_properties());
 		}
 	}
 
-	// Load lights
-	std::vector<std::unique_ptr<sg::Light>> light_components = parse_khr_lights_punctual();
-
 	scene.set_components(std::move(light_components));
 
 	// Load samplers
@@ -426,73 +2127,181 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 		sampler_components[sampler_index] = std::move(sampler);
 	}
 
+	if (scene_cache_writer)
+	{
+		auto &os = scene_cache_writer->get_stream();
+
+		write(os, model.samplers.size());
+
+		for (auto &gltf_sampler : model.samplers)
+		{
+			write(os, gltf_sampler.name, gltf_sampler.minFilter, gltf_sampler.magFilter, gltf_sampler.wrapS, gltf_sampler.wrapT, gltf_sampler.wrapR);
+		}
+	}
+
 	scene.set_components(std::move(sampler_components));
 
 	Timer timer;
 	timer.start();
 
-	// Load images
-	auto thread_count = std::thread::hardware_concurrency();
-	thread_count      = thread_count == 0 ? 1 : thread_count;
-	ctpl::thread_pool thread_pool(thread_count);
+	// Load images as background jobs, so that they do not delay the frame jobs when loading progressively
+	auto &job_system = device.get_job_system();
+
+	// Mesh primitives are queued first, as the scene cannot be returned without them,
+	// so that their processing overlaps with the decoding of the images
+	PrimitiveFutures primitive_futures;
+	primitive_futures.futures.resize(model.meshes.size());
+
+	for (size_t mesh_index = 0; mesh_index < model.meshes.size(); mesh_index++)
+	{
+		for (size_t primitive_index = 0; primitive_index < model.meshes[mesh_index].primitives.size(); primitive_index++)
+		{
+			auto fut = job_system.push(
+			    JobPriority::Background,
+			    [this, mesh_index, primitive_index](size_t) {
+				    VKB_PROFILE_SCOPE("GLTFLoader::parse_primitive");
+
+				    Timer timer;
+				    timer.start();
+
+				    auto primitive = parse_primitive_data(model, model.meshes[mesh_index].primitives[primitive_index], vertex_quantization, lod_generation, mesh_optimization, meshlet_generation,
+				                                          interleaved_vertices);
+
+				    mesh_processing_ns += static_cast<uint64_t>(timer.stop<Timer::Nanoseconds>());
+
+				    return primitive;
+			    });
+
+			primitive_futures.futures[mesh_index].push_back(std::move(fut));
+		}
+	}
 
 	auto image_count = to_u32(model.images.size());
 
-	std::vector<std::future<std::unique_ptr<sg::Image>>> image_component_futures;
 	for (size_t image_index = 0; image_index < image_count; image_index++)
 	{
-		auto fut = thread_pool.push(
+		auto fut = job_system.push(
+		    JobPriority::Background,
 		    [this, image_index](size_t) {
+			    VKB_PROFILE_SCOPE("GLTFLoader::parse_image");
+
+			    Timer timer;
+			    timer.start();
+
 			    auto image = parse_image(model.images.at(image_index));
 
+			    image_decode_ns += static_cast<uint64_t>(timer.stop<Timer::Nanoseconds>());
+
 			    LOGI("Loaded gltf image #{} ({})", image_index, model.images.at(image_index).uri.c_str());
 
 			    return image;
 		    });
 
-		image_component_futures.push_back(std::move(fut));
+		image_futures.push_back(std::move(fut));
 	}
 
 	std::vector<std::unique_ptr<sg::Image>> image_components;
-	for (auto &fut : image_component_futures)
+
+	if (progressive_loading)
 	{
-		image_components.push_back(fut.get());
-	}
+		// Images keep loading in the background, textures sample the placeholder until update_streaming() patches them
+		Timer upload_timer;
+		upload_timer.start();
 
-	// Upload images to GPU
-	std::vector<core::Buffer> transient_buffers;
+		streaming_upload_manager = std::make_unique<UploadManager>(device, staging_budget);
 
-	auto &command_buffer = device.request_command_buffer();
+		image_components.push_back(create_placeholder_image());
 
-	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, 0);
+		streaming_upload_manager->upload(*image_components.back());
+		streaming_upload_manager->flush();
 
-	for (size_t image_index = 0; image_index < image_count; image_index++)
+		add_upload_stats(*streaming_upload_manager, upload_timer.stop());
+
+		image_components.back()->clear_data();
+
+		streamed_textures.resize(image_count);
+	}
+	else
 	{
-		auto &image = image_components.at(image_index);
+		image_components.resize(image_count);
+
+		// Images stream through a fixed size ring, so the staging memory is capped by the budget
+		UploadManager upload_manager{device, staging_budget};
 
-		core::Buffer stage_buffer{device,
-		                          image->get_data().size(),
-		                          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		                          VMA_MEMORY_USAGE_CPU_ONLY};
+		Timer  upload_timer;
+		double upload_time{0.0};
 
-		stage_buffer.update(image->get_data());
+		// Each image is uploaded as soon as it is decoded, and the uploads are submitted whenever no other image is
+		// ready, so that the transfer queue copies a batch while the next images are being decoded
+		for (size_t remaining_count = image_count; remaining_count > 0;)
+		{
+			bool uploaded = false;
 
-		upload_image_to_gpu(command_buffer, stage_buffer, *image);
+			for (size_t image_index = 0; image_index < image_count; image_index++)
+			{
+				auto &fut = image_futures[image_index];
 
-		transient_buffers.push_back(std::move(stage_buffer));
-	}
+				if (!fut.valid() || fut.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				{
+					continue;
+				}
+
+				auto &image = image_components[image_index];
+				image       = fut.get();
+
+				upload_timer.start();
+
+				upload_manager.upload(*image);
+
+				upload_time += upload_timer.stop();
+
+				// Clean up the image data, as they are copied in the staging ring, unless the scene cache
+				// still has to store them in order once all of them are decoded
+				if (!scene_cache_writer)
+				{
+					release_image_data(*image);
+				}
+
+				remaining_count--;
+				uploaded = true;
+			}
+
+			if (uploaded)
+			{
+				upload_timer.start();
 
-	command_buffer.end();
+				upload_manager.submit();
 
-	auto &queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+				upload_time += upload_timer.stop();
+			}
+			else
+			{
+				// Wait for the oldest image still decoding, the decoding jobs being started in order
+				auto decoding_image = std::find_if(image_futures.begin(), image_futures.end(), [](const std::future<std::unique_ptr<sg::Image>> &fut) { return fut.valid(); });
+				decoding_image->wait();
+			}
+		}
+
+		image_futures.clear();
+
+		if (scene_cache_writer)
+		{
+			write(scene_cache_writer->get_stream(), image_components.size());
 
-	queue.submit(command_buffer, device.request_fence());
+			for (auto &image : image_components)
+			{
+				write_cached_image(*image);
+
+				release_image_data(*image);
+			}
+		}
 
-	device.get_fence_pool().wait();
-	device.get_fence_pool().reset();
-	device.get_command_pool().reset_pool();
+		upload_timer.start();
 
-	transient_buffers.clear();
+		upload_manager.flush();
+
+		add_upload_stats(upload_manager, upload_time + upload_timer.stop());
+	}
 
 	scene.set_components(std::move(image_components));
 
@@ -505,11 +2314,33 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 	auto samplers        = scene.get_components<sg::Sampler>();
 	auto default_sampler = create_default_sampler();
 
+	if (scene_cache_writer)
+	{
+		write(scene_cache_writer->get_stream(), model.textures.size());
+	}
+
 	for (auto &gltf_texture : model.textures)
 	{
 		auto texture = parse_texture(gltf_texture);
 
-		texture->set_image(*images.at(gltf_texture.source));
+		// Textures compressed with Basis Universal reference their KTX2 image through an extension
+		if (auto extension = get_extension(gltf_texture.extensions, KHR_TEXTURE_BASISU_EXTENSION))
+		{
+			if (extension->Has("source"))
+			{
+				gltf_texture.source = extension->Get("source").Get<int>();
+			}
+		}
+
+		if (progressive_loading)
+		{
+			texture->set_image(*images.at(0));
+			streamed_textures.at(gltf_texture.source).push_back(texture.get());
+		}
+		else
+		{
+			texture->set_image(*images.at(gltf_texture.source));
+		}
 
 		if (gltf_texture.sampler >= 0 && gltf_texture.sampler < static_cast<int>(samplers.size()))
 		{
@@ -519,13 +2350,20 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 		{
 			if (gltf_texture.name.empty())
 			{
-				gltf_texture.name = images.at(gltf_texture.source)->get_name();
+				gltf_texture.name = model.images.at(gltf_texture.source).name;
 			}
 
 			LOGW("Sampler not found for texture {}, possible GLTF error", gltf_texture.name);
 			texture->set_sampler(*default_sampler);
 		}
 
+		if (scene_cache_writer)
+		{
+			bool has_sampler = gltf_texture.sampler >= 0 && gltf_texture.sampler < static_cast<int>(samplers.size());
+
+			write(scene_cache_writer->get_stream(), texture->get_name(), gltf_texture.source, has_sampler ? gltf_texture.sampler : -1);
+		}
+
 		scene.add_component(std::move(texture));
 	}
 
@@ -534,6 +2372,11 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 	// Load materials
 	auto textures = scene.get_components<sg::Texture>();
 
+	if (scene_cache_writer)
+	{
+		write(scene_cache_writer->get_stream(), model.materials.size());
+	}
+
 	for (auto &gltf_material : model.materials)
 	{
 		auto material = parse_material(gltf_material);
@@ -558,6 +2401,11 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 			}
 		}
 
+		if (scene_cache_writer)
+		{
+			write_cached_material(*material, textures);
+		}
+
 		scene.add_component(std::move(material));
 	}
 
@@ -566,92 +2414,177 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 	// Load meshes
 	auto materials = scene.get_components<sg::PBRMaterial>();
 
-	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+	// Geometry of all the meshes is packed into a few shared buffers
+	auto geometry_memory_usage = staged_geometry_upload ? VMA_MEMORY_USAGE_GPU_ONLY : VMA_MEMORY_USAGE_GPU_TO_CPU;
+	auto geometry_arena        = std::make_unique<sg::GeometryArena>(device, GEOMETRY_BLOCK_SIZE, geometry_memory_usage);
+
+	if (scene_cache_writer)
+	{
+		write(scene_cache_writer->get_stream(), model.meshes.size());
+	}
+
+	MeshOptimizationStats optimization_stats;
 
-	for (auto &gltf_mesh : model.meshes)
+	for (size_t mesh_index = 0; mesh_index < model.meshes.size(); mesh_index++)
 	{
+		auto &gltf_mesh = model.meshes[mesh_index];
+
 		auto mesh = parse_mesh(gltf_mesh);
 
-		for (auto &gltf_primitive : gltf_mesh.primitives)
+		// The primitives of the mesh, each with its material
+		std::vector<std::pair<PrimitiveData, int>> primitives;
+
+		for (size_t primitive_index = 0; primitive_index < gltf_mesh.primitives.size(); primitive_index++)
+		{
+			auto primitive = primitive_futures.futures[mesh_index][primitive_index].get();
+			int  material  = gltf_mesh.primitives[primitive_index].material;
+
+			optimization_stats.triangle_count += primitive.optimization_stats.triangle_count;
+			optimization_stats.transformed_before += primitive.optimization_stats.transformed_before;
+			optimization_stats.transformed_after += primitive.optimization_stats.transformed_after;
+
+			// Triangle lists of the same material are packed into one submesh, drawn at once
+			auto merged = primitive_merging && std::any_of(primitives.begin(), primitives.end(), [&](std::pair<PrimitiveData, int> &merged_primitive) {
+				              return merged_primitive.second == material && merge_primitives(merged_primitive.first, primitive);
+			              });
+
+			if (!merged)
+			{
+				primitives.emplace_back(std::move(primitive), material);
+			}
+		}
+
+		if (scene_cache_writer)
 		{
+			write(scene_cache_writer->get_stream(), gltf_mesh.name, primitives.size());
+		}
+
+		for (auto &primitive_it : primitives)
+		{
+			auto &primitive = primitive_it.first;
+			int   material  = primitive_it.second;
+
+			bool indexed = !primitive.index_data.empty();
+
 			auto submesh = std::make_unique<sg::SubMesh>();
 
-			for (auto &attribute : gltf_primitive.attributes)
+			submesh->vertices_count = primitive.vertices_count;
+
+			if (scene_cache_writer)
+			{
+				write(scene_cache_writer->get_stream(), primitive.attributes.size());
+			}
+
+			// Only the suballocations and copies are serial, as the arena packs the data in order
+			for (auto &attribute : primitive.attributes)
 			{
-				std::string attrib_name = attribute.first;
-				std::transform(attrib_name.begin(), attrib_name.end(), attrib_name.begin(), ::tolower);
+				auto buffer = geometry_arena->allocate_vertices(attribute.data.size());
+				geometry_arena->update(buffer, attribute.data);
 
-				auto vertex_data = get_attribute_data(&model, attribute.second);
+				submesh->vertex_buffers.insert(std::make_pair(attribute.name, std::move(buffer)));
 
-				if (attrib_name == "position")
+				// The interleaved stream is only a buffer, its attributes are set on their own
+				if (attribute.attribute.format != VK_FORMAT_UNDEFINED)
 				{
-					submesh->vertices_count = to_u32(model.accessors.at(attribute.second).count);
+					submesh->set_attribute(attribute.name, attribute.attribute);
 				}
 
-				core::Buffer buffer{device,
-				                    vertex_data.size(),
-				                    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-				                    VMA_MEMORY_USAGE_GPU_TO_CPU};
-				buffer.update(vertex_data);
+				if (scene_cache_writer)
+				{
+					write(scene_cache_writer->get_stream(), attribute.name, attribute.attribute.format, attribute.attribute.stride);
+					scene_cache_writer->write_blob(attribute.data);
+				}
+			}
 
-				submesh->vertex_buffers.insert(std::make_pair(attrib_name, std::move(buffer)));
+			if (scene_cache_writer)
+			{
+				write(scene_cache_writer->get_stream(), primitive.interleaved_attributes.size());
+			}
 
-				sg::VertexAttribute attrib;
-				attrib.format = get_attribute_format(&model, attribute.second);
-				attrib.stride = to_u32(get_attribute_stride(&model, attribute.second));
+			for (auto &interleaved : primitive.interleaved_attributes)
+			{
+				submesh->set_attribute(interleaved.name, interleaved.attribute);
 
-				submesh->set_attribute(attrib_name, attrib);
+				if (scene_cache_writer)
+				{
+					write(scene_cache_writer->get_stream(), interleaved.name, interleaved.attribute.format, interleaved.attribute.stride,
+					      interleaved.attribute.offset, interleaved.attribute.stream);
+				}
 			}
 
-			if (gltf_primitive.indices >= 0)
+			if (indexed)
 			{
-				submesh->vertex_indices = to_u32(get_attribute_size(&model, gltf_primitive.indices));
+				submesh->vertex_indices = primitive.vertex_indices;
+				submesh->index_type     = primitive.index_type;
 
-				auto format = get_attribute_format(&model, gltf_primitive.indices);
+				submesh->index_buffer = geometry_arena->allocate_indices(primitive.index_data.size());
 
-				auto vertex_data = get_attribute_data(&model, gltf_primitive.indices);
-				auto index_data  = get_attribute_data(&model, gltf_primitive.indices);
+				geometry_arena->update(submesh->index_buffer, primitive.index_data);
 
-				switch (format)
+				for (auto &primitive_lod : primitive.lods)
 				{
-					case VK_FORMAT_R8_UINT:
-						// Converts uint8 data into uint16 data, still represented by a uint8 vector
-						index_data          = convert_underlying_data_stride(index_data, 1, 2);
-						submesh->index_type = VK_INDEX_TYPE_UINT16;
-						break;
-					case VK_FORMAT_R16_UINT:
-						submesh->index_type = VK_INDEX_TYPE_UINT16;
-						break;
-					case VK_FORMAT_R32_UINT:
-						submesh->index_type = VK_INDEX_TYPE_UINT32;
-						break;
-					default:
-						LOGE("gltf primitive has invalid format type");
-						break;
-				}
+					sg::SubMeshLod lod;
+
+					lod.vertex_indices = primitive_lod.vertex_indices;
+					lod.error          = primitive_lod.error;
+					lod.index_buffer   = geometry_arena->allocate_indices(primitive_lod.index_data.size());
 
-				submesh->index_buffer = std::make_unique<core::Buffer>(device,
-				                                                       index_data.size(),
-				                                                       VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-				                                                       VMA_MEMORY_USAGE_GPU_TO_CPU);
+					geometry_arena->update(lod.index_buffer, primitive_lod.index_data);
+
+					submesh->lods.push_back(std::move(lod));
+				}
 
-				submesh->index_buffer->update(index_data);
+				submesh->meshlets = std::move(primitive.meshlets);
 			}
-			else
+
+			if (scene_cache_writer)
 			{
-				submesh->vertices_count = to_u32(get_attribute_size(&model, gltf_primitive.attributes.at("POSITION")));
+				auto &os = scene_cache_writer->get_stream();
+
+				write(os, indexed);
+
+				if (indexed)
+				{
+					write(os, submesh->index_type, submesh->vertex_indices);
+					scene_cache_writer->write_blob(primitive.index_data);
+
+					write(os, primitive.lods.size());
+
+					for (auto &primitive_lod : primitive.lods)
+					{
+						write(os, primitive_lod.vertex_indices, primitive_lod.error);
+						scene_cache_writer->write_blob(primitive_lod.index_data);
+					}
+
+					write(os, submesh->meshlets.size());
+
+					for (auto &meshlet : submesh->meshlets)
+					{
+						write(os, meshlet.bounding_sphere, meshlet.normal_cone, meshlet.first_index, meshlet.index_count);
+					}
+				}
+
+				write(os, submesh->vertices_count, material, primitive.has_bounds, primitive.bounds_min, primitive.bounds_max);
 			}
 
-			if (gltf_primitive.material < 0)
+			if (material < 0)
 			{
 				submesh->set_material(*default_material);
 			}
 			else
 			{
-				submesh->set_material(*materials.at(gltf_primitive.material));
+				submesh->set_material(*materials.at(material));
 			}
 
-			mesh->add_submesh(*submesh);
+			if (!primitive.has_bounds)
+			{
+				// Nothing to bound, the mesh only warns about the missing positions
+				mesh->add_submesh(*submesh);
+			}
+			else
+			{
+				mesh->add_submesh(*submesh, sg::AABB{primitive.bounds_min, primitive.bounds_max});
+			}
 
 			scene.add_component(std::move(submesh));
 		}
@@ -659,21 +2592,44 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 		scene.add_component(std::move(mesh));
 	}
 
-	command_buffer.end();
+	if (optimization_stats.triangle_count > 0)
+	{
+		auto triangle_count = static_cast<float>(optimization_stats.triangle_count);
+
+		LOGI("Optimized {} triangles, ACMR {:.3f} -> {:.3f}", optimization_stats.triangle_count,
+		     optimization_stats.transformed_before / triangle_count, optimization_stats.transformed_after / triangle_count);
+	}
+
+	// Copy all the geometry to device local memory, if the arena is not host visible
+	Timer upload_timer;
+	upload_timer.start();
 
-	queue.submit(command_buffer, device.request_fence());
+	UploadManager upload_manager{device, staging_budget};
 
-	device.get_fence_pool().wait();
-	device.get_fence_pool().reset();
-	device.get_command_pool().reset_pool();
+	geometry_arena->flush(upload_manager);
 
-	transient_buffers.clear();
+	upload_manager.flush();
+
+	add_upload_stats(upload_manager, upload_timer.stop());
+
+	scene.add_component(std::move(geometry_arena));
 
 	scene.add_component(std::move(default_material));
 
 	// Load cameras
+	if (scene_cache_writer)
+	{
+		write(scene_cache_writer->get_stream(), model.cameras.size());
+	}
+
 	for (auto &gltf_camera : model.cameras)
 	{
+		if (scene_cache_writer)
+		{
+			write(scene_cache_writer->get_stream(), gltf_camera.name, gltf_camera.type, gltf_camera.perspective.aspectRatio,
+			      gltf_camera.perspective.yfov, gltf_camera.perspective.znear, gltf_camera.perspective.zfar);
+		}
+
 		auto camera = parse_camera(gltf_camera);
 		scene.add_component(std::move(camera));
 	}
@@ -683,10 +2639,29 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 
 	std::vector<std::unique_ptr<sg::Node>> nodes;
 
+	if (scene_cache_writer)
+	{
+		write(scene_cache_writer->get_stream(), model.nodes.size());
+	}
+
 	for (auto &gltf_node : model.nodes)
 	{
 		auto node = parse_node(gltf_node);
 
+		if (scene_cache_writer)
+		{
+			auto &transform = node->get_component<sg::Transform>();
+
+			int light_index = -1;
+			if (auto extension = get_extension(gltf_node.extensions, KHR_LIGHTS_PUNCTUAL_EXTENSION))
+			{
+				light_index = extension->Get("light").Get<int>();
+			}
+
+			write(scene_cache_writer->get_stream(), node->get_name(), transform.get_translation(), transform.get_rotation(), transform.get_scale(),
+			      gltf_node.mesh, gltf_node.camera, light_index, gltf_node.children);
+		}
+
 		if (gltf_node.mesh >= 0)
 		{
 			auto mesh = meshes.at(gltf_node.mesh);
@@ -744,6 +2719,11 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 
 	auto root_node = std::make_unique<sg::Node>(gltf_scene->name);
 
+	if (scene_cache_writer)
+	{
+		write(scene_cache_writer->get_stream(), gltf_scene->name, gltf_scene->nodes);
+	}
+
 	for (auto node_index : gltf_scene->nodes)
 	{
 		traverse_nodes.push(std::make_pair(std::ref(*root_node), node_index));
@@ -762,16 +2742,132 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 
 		for (auto child_node_index : model.nodes[node_it.second].children)
 		{
-			traverse_nodes.push(std::make_pair(std::ref(traverse_root_node), child_node_index));
+			traverse_nodes.push(std::make_pair(std::ref(current_node), child_node_index));
 		}
 	}
 
 	scene.set_root_node(*root_node);
+
+	load_skins(scene, nodes);
+
+	load_animations(scene, nodes, *root_node);
+
 	nodes.push_back(std::move(root_node));
 
 	// Store nodes into the scene
 	scene.set_nodes(std::move(nodes));
 
+	add_default_camera_and_light(scene);
+
+	return scene;
+}
+
+void GLTFLoader::load_skins(sg::Scene &scene, const std::vector<std::unique_ptr<sg::Node>> &nodes)
+{
+	std::vector<sg::Skin *> skins;
+
+	for (auto &gltf_skin : model.skins)
+	{
+		std::vector<sg::Node *> joints;
+
+		for (auto joint_index : gltf_skin.joints)
+		{
+			joints.push_back(nodes.at(joint_index).get());
+		}
+
+		// Joints without inverse bind matrices are bound at the origin of the mesh
+		std::vector<glm::mat4> inverse_bind_matrices(joints.size(), glm::mat4{1.0f});
+
+		if (gltf_skin.inverseBindMatrices >= 0 &&
+		    (!get_float_elements(model, gltf_skin.inverseBindMatrices, TINYGLTF_TYPE_MAT4, inverse_bind_matrices) || inverse_bind_matrices.size() != joints.size()))
+		{
+			throw std::runtime_error("Invalid inverse bind matrices in skin " + gltf_skin.name);
+		}
+
+		auto skin = std::make_unique<sg::Skin>(gltf_skin.name, std::move(joints), std::move(inverse_bind_matrices));
+
+		skins.push_back(skin.get());
+
+		scene.add_component(std::move(skin));
+	}
+
+	for (size_t node_index = 0; node_index < model.nodes.size(); node_index++)
+	{
+		if (model.nodes[node_index].skin >= 0)
+		{
+			nodes[node_index]->set_component(*skins.at(model.nodes[node_index].skin));
+		}
+	}
+}
+
+void GLTFLoader::load_animations(sg::Scene &scene, const std::vector<std::unique_ptr<sg::Node>> &nodes, sg::Node &root_node)
+{
+	for (auto &gltf_animation : model.animations)
+	{
+		auto animation = std::make_unique<sg::Animation>(root_node, gltf_animation.name);
+
+		for (auto &gltf_channel : gltf_animation.channels)
+		{
+			auto &gltf_sampler = gltf_animation.samplers.at(gltf_channel.sampler);
+
+			sg::AnimationChannel channel;
+
+			channel.node = nodes.at(gltf_channel.target_node).get();
+
+			if (gltf_sampler.interpolation == "STEP")
+			{
+				channel.interpolation = sg::AnimationInterpolation::Step;
+			}
+			else if (gltf_sampler.interpolation == "CUBICSPLINE")
+			{
+				channel.interpolation = sg::AnimationInterpolation::CubicSpline;
+			}
+
+			bool valid = get_float_elements(model, gltf_sampler.input, TINYGLTF_TYPE_SCALAR, channel.times);
+
+			if (gltf_channel.target_path == "rotation")
+			{
+				channel.target = sg::AnimationTarget::Rotation;
+
+				valid = valid && get_float_elements(model, gltf_sampler.output, TINYGLTF_TYPE_VEC4, channel.values);
+			}
+			else if (gltf_channel.target_path == "translation" || gltf_channel.target_path == "scale")
+			{
+				channel.target = gltf_channel.target_path == "scale" ? sg::AnimationTarget::Scale : sg::AnimationTarget::Translation;
+
+				std::vector<glm::vec3> values;
+
+				valid = valid && get_float_elements(model, gltf_sampler.output, TINYGLTF_TYPE_VEC3, values);
+
+				for (auto &value : values)
+				{
+					channel.values.emplace_back(value, 0.0f);
+				}
+			}
+			else
+			{
+				LOGW("Animation {} targets the unsupported {} property, skipping it", gltf_animation.name, gltf_channel.target_path);
+				continue;
+			}
+
+			size_t values_per_key = channel.interpolation == sg::AnimationInterpolation::CubicSpline ? 3 : 1;
+
+			// Quantized keyframes are not supported
+			if (!valid || channel.times.empty() || channel.values.size() != channel.times.size() * values_per_key)
+			{
+				LOGW("Animation {} has an unsupported channel, skipping it", gltf_animation.name);
+				continue;
+			}
+
+			animation->add_channel(std::move(channel));
+		}
+
+		scene.add_component(std::move(animation));
+	}
+}
+
+void GLTFLoader::add_default_camera_and_light(sg::Scene &scene)
+{
 	// Create node for the default camera
 	auto camera_node = std::make_unique<sg::Node>("default_camera");
 
@@ -788,8 +2884,6 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 		// Add a default light if none are present
 		vkb::add_directional_light(scene, glm::quat({glm::radians(-90.0f), 0.0f, glm::radians(30.0f)}));
 	}
-
-	return scene;
 }
 
 std::unique_ptr<sg::Node> GLTFLoader::parse_node(const tinygltf::Node &gltf_node) const
@@ -942,7 +3036,37 @@ std::unique_ptr<sg::Image> GLTFLoader::parse_image(tinygltf::Image &gltf_image)
 	{
 		// Load image from uri
 		auto image_uri = model_path + "/" + gltf_image.uri;
-		image          = sg::Image::load(gltf_image.name, image_uri);
+
+		if (!image_variant.empty())
+		{
+			auto variant_uri = get_image_variant_uri(model_path, image_variant, gltf_image.uri);
+
+			if (!variant_uri.empty())
+			{
+				image = sg::Image::load(gltf_image.name, variant_uri);
+			}
+
+			// The variant formats are block compressed, which are not decoded on the CPU like ASTC
+			if (image && !sg::is_astc(image->get_format()) && !device.is_image_format_supported(image->get_format()))
+			{
+				LOGW("Format of the {} variant not supported: loading {}", image_variant, image_uri);
+				image.reset();
+			}
+		}
+
+		if (!image)
+		{
+			image = sg::Image::load(gltf_image.name, image_uri);
+		}
+	}
+
+	// Basis Universal images are transcoded to a format sampled by the GPU
+	if (auto ktx2 = dynamic_cast<sg::Ktx2 *>(image.get()))
+	{
+		if (ktx2->needs_transcoding())
+		{
+			ktx2->transcode(device);
+		}
 	}
 
 	// Check whether the format is supported by the GPU
@@ -952,7 +3076,14 @@ std::unique_ptr<sg::Image> GLTFLoader::parse_image(tinygltf::Image &gltf_image)
 		{
 			LOGW("ASTC not supported: decoding {}", image->get_name());
 			image = std::make_unique<sg::Astc>(*image);
-			image->generate_mipmaps();
+
+			// Levels are generated on the CPU if the decoded format cannot be blitted
+			Timer timer;
+			timer.start();
+
+			image->request_gpu_mipmaps(device);
+
+			mip_generation_ns += static_cast<uint64_t>(timer.stop<Timer::Nanoseconds>());
 		}
 	}
 
@@ -985,9 +3116,10 @@ std::unique_ptr<sg::Sampler> GLTFLoader::parse_sampler(const tinygltf::Sampler &
 	sampler_info.borderColor  = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
 	sampler_info.maxLod       = std::numeric_limits<float>::max();
 
-	core::Sampler vk_sampler{device, sampler_info};
+	// Identical samplers of all the scenes loaded on the device are shared
+	auto &vk_sampler = device.get_resource_cache().request_sampler(sampler_info);
 
-	return std::make_unique<sg::Sampler>(name, std::move(vk_sampler));
+	return std::make_unique<sg::Sampler>(name, vk_sampler);
 }
 
 std::unique_ptr<sg::Texture> GLTFLoader::parse_texture(const tinygltf::Texture &gltf_texture) const
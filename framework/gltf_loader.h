@@ -20,8 +20,12 @@
 
 #pragma once
 
+#include <atomic>
+#include <future>
 #include <memory>
 #include <mutex>
+#include <unordered_set>
+#include <vector>
 
 #define TINYGLTF_NO_STB_IMAGE
 #define TINYGLTF_NO_STB_IMAGE_WRITE
@@ -29,12 +33,17 @@
 #include <tiny_gltf.h>
 
 #include "timer.h"
+#include "upload_manager.h"
 
 #define KHR_LIGHTS_PUNCTUAL_EXTENSION "KHR_lights_punctual"
+#define KHR_TEXTURE_BASISU_EXTENSION "KHR_texture_basisu"
 
 namespace vkb
 {
+class CommandBuffer;
 class Device;
+class SceneCacheReader;
+class SceneCacheWriter;
 
 namespace sg
 {
@@ -73,10 +82,156 @@ class GLTFLoader
   public:
 	GLTFLoader(Device &device);
 
-	virtual ~GLTFLoader() = default;
+	virtual ~GLTFLoader();
 
 	std::unique_ptr<sg::Scene> read_scene_from_file(const std::string &file_name, int scene_index = -1);
 
+	/**
+	 * @brief Time spent in each stage of a scene load, in seconds
+	 *        Stages run as jobs are summed over the threads, so they can add up to more than the total.
+	 *        A scene loaded from its cache only splits the upload stages out of the total, and
+	 *        images loaded progressively are only measured until the scene is returned.
+	 */
+	struct LoadStats
+	{
+		/// Reading the glTF file, the buffers it references are read while parsing
+		double file_io_time{0.0};
+
+		double parse_time{0.0};
+
+		/// Reading, decoding and transcoding the images
+		double image_decode_time{0.0};
+
+		/// Generating mip levels on the CPU, the levels blitted by the GPU are part of the upload
+		double mip_generation_time{0.0};
+
+		/// Processing the primitives into the vertex and index data of the submeshes
+		double mesh_processing_time{0.0};
+
+		/// Writing the staging memory and recording the copies, without the fence waits
+		double upload_time{0.0};
+
+		double fence_wait_time{0.0};
+
+		double total_time{0.0};
+
+		/// Most bytes of staging memory in use at once by any of the uploads
+		VkDeviceSize peak_staging_usage{0};
+
+		/// Bytes of image data kept in host memory once uploaded, see set_keep_image_data() and add_resident_image()
+		VkDeviceSize resident_image_data{0};
+	};
+
+	/**
+	 * @return The stage times of the last read_scene_from_file()
+	 */
+	const LoadStats &get_load_stats() const;
+
+	/**
+	 * @brief Sets whether scenes are cooked into a binary cache file, must be called before loading a scene
+	 *        read_scene_from_file then loads the cache of the scene while none of its assets changed,
+	 *        skipping the parsing of the glTF file, the decoding of the images and the processing of the geometry.
+	 *        Otherwise it loads the glTF file and writes its cache, unless images are loaded progressively.
+	 */
+	void set_scene_cache_enabled(bool enabled);
+
+	/**
+	 * @brief Sets whether read_scene_from_file returns before the images are loaded, must be called before loading a scene
+	 *        Images are then decoded in the background, and the textures sample a placeholder until
+	 *        update_streaming() patches in their image. The loader must be kept alive while streaming
+	 */
+	void set_progressive_loading(bool enabled);
+
+	/**
+	 * @brief Uploads the images decoded since the last call, and patches the textures of the uploaded ones
+	 * @param command_buffer Graphics command buffer of the frame, recording the ownership acquires
+	 *        of the uploads before any draw
+	 * @return True while images are still streaming
+	 */
+	bool update_streaming(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Sets how mesh data is uploaded, must be called before loading a scene
+	 * @param enabled If true, vertex and index buffers are device local and filled through
+	 *                a staging buffer, otherwise they are host visible and written directly
+	 */
+	void set_staged_geometry_upload(bool enabled);
+
+	/**
+	 * @brief Sets the size of the staging ring used to upload images and geometry,
+	 *        which caps the staging memory used while loading
+	 * @param size Size of the ring in bytes
+	 */
+	void set_staging_budget(VkDeviceSize size);
+
+	/**
+	 * @brief Sets whether the images keep their data in host memory once uploaded, must be called before loading a scene
+	 * @param enabled If true, the data of the images stays available, such as to process them on the CPU,
+	 *                otherwise it is released as soon as it is copied to the staging ring
+	 */
+	void set_keep_image_data(bool enabled);
+
+	/**
+	 * @brief Keeps the data of an image in host memory once uploaded, while the other images release theirs,
+	 *        must be called before loading a scene
+	 * @param name Name of the glTF image, such as one sampled on the CPU for picking
+	 */
+	void add_resident_image(const std::string &name);
+
+	/**
+	 * @brief Sets whether the vertex attributes are quantized while loading, must be called before loading a scene
+	 *        Positions are stored as half floats, unless too far from the origin for their size,
+	 *        normals are octahedron encoded into two snorm16, and texture coordinates within [0, 1] as unorm16.
+	 *        Submeshes with encoded normals define HAS_OCTAHEDRAL_NORMAL in their shader variant.
+	 */
+	void set_vertex_quantization(bool enabled);
+
+	/**
+	 * @brief Sets whether coarser levels of detail are generated for the indexed triangle lists while loading,
+	 *        must be called before loading a scene. The levels are simplified by vertex clustering, and share
+	 *        the vertex buffers of their submesh. They are stored in the scene cache along with the scene.
+	 */
+	void set_lod_generation(bool enabled);
+
+	/**
+	 * @brief Sets whether the indexed triangle lists are optimized while loading, must be called before loading a scene
+	 *        Triangles are reordered for the post-transform vertex cache and then for overdraw, and vertices in the
+	 *        order they are fetched. The cache miss ratios before and after are logged once the scene is loaded.
+	 */
+	void set_mesh_optimization(bool enabled);
+
+	/**
+	 * @brief Sets whether the indexed triangle lists are split into meshlets while loading, must be called before
+	 *        loading a scene. Meshlets are ranges of consecutive triangles, with bounding spheres and normal cones
+	 *        which GPU driven draws use to cull them on their own. See sg::Meshlet.
+	 */
+	void set_meshlet_generation(bool enabled);
+
+	/**
+	 * @brief Sets whether the vertex attributes are laid out in two streams while loading, must be called before
+	 *        loading a scene. Positions are tightly packed in a buffer of their own, so that depth only passes
+	 *        fetch nothing else, and all the other attributes are interleaved in a single buffer.
+	 *        See sg::VertexAttribute::stream.
+	 */
+	void set_interleaved_vertices(bool enabled);
+
+	/**
+	 * @brief Sets whether the indexed triangle lists of a mesh sharing a material are merged into one submesh while
+	 *        loading, must be called before loading a scene. Their vertices are concatenated and the indices rebased,
+	 *        in 16-bit indices as long as the merged vertices fit, as any primitive whose vertices fit them.
+	 *        Primitives with levels of detail are not merged.
+	 */
+	void set_primitive_merging(bool enabled);
+
+	/**
+	 * @brief Sets the directory holding variants of the images in another format, must be called before loading a scene
+	 *        The directory is relative to the glTF file, and mirrors the paths of its images with KTX files, e.g. the
+	 *        variant of `textures/wall.png` in `astc_6x6` is `astc_6x6/textures/wall.ktx`. Images without a variant,
+	 *        or whose variant format the device cannot sample, are loaded from the glTF file as usual.
+	 * @param variant Name of the directory, or an empty string to load the images of the glTF file
+	 */
+	void set_image_variant(const std::string &variant);
+
   protected:
 	virtual std::unique_ptr<sg::Node> parse_node(const tinygltf::Node &gltf_node) const;
 
@@ -98,6 +253,11 @@ class GLTFLoader
 
 	virtual std::unique_ptr<sg::Camera> create_default_camera();
 
+	/**
+	 * @brief Creates the white 1x1 image textures sample while their own is streamed
+	 */
+	virtual std::unique_ptr<sg::Image> create_placeholder_image();
+
 	/**
 	 * @brief Parses and returns a list of scene graph lights from the KHR_lights_punctual extension
 	 */
@@ -127,7 +287,111 @@ class GLTFLoader
 	/// The extensions that the GLTFLoader can load mapped to whether they should be enabled or not
 	static std::unordered_map<std::string, bool> supported_extensions;
 
+	/// Times of the stages run as jobs, in nanoseconds summed over the threads
+	std::atomic<uint64_t> image_decode_ns{0};
+
+	mutable std::atomic<uint64_t> mip_generation_ns{0};
+
+	std::atomic<uint64_t> mesh_processing_ns{0};
+
+	LoadStats load_stats;
+
+	bool staged_geometry_upload{true};
+
+	VkDeviceSize staging_budget{UploadManager::DEFAULT_STAGING_SIZE};
+
+	bool keep_image_data{false};
+
+	std::unordered_set<std::string> resident_images;
+
+	bool progressive_loading{false};
+
+	bool scene_cache_enabled{false};
+
+	bool vertex_quantization{false};
+
+	bool lod_generation{false};
+
+	bool mesh_optimization{false};
+
+	bool meshlet_generation{false};
+
+	bool interleaved_vertices{false};
+
+	bool primitive_merging{false};
+
+	std::string image_variant;
+
   private:
+	struct StreamedImage
+	{
+		size_t image_index;
+
+		std::unique_ptr<sg::Image> image;
+
+		/// Upload batch of the image, 0 until it is submitted
+		uint64_t batch_id;
+	};
+
 	sg::Scene load_scene(int scene_index = -1);
+
+	/**
+	 * @brief Builds the scene from its cache, in the order load_scene() wrote it
+	 */
+	sg::Scene load_cached_scene(SceneCacheReader &reader);
+
+	/**
+	 * @brief Adds the measurements of an upload manager to the load stats
+	 * @param elapsed_time Time spent uploading with the manager, including its fence waits and mip generation
+	 */
+	void add_upload_stats(const UploadManager &upload_manager, double elapsed_time);
+
+	/**
+	 * @brief Releases the data of an uploaded image, unless it is kept resident, in which case it is counted in the load stats
+	 */
+	void release_image_data(sg::Image &image);
+
+	/**
+	 * @brief Records the assets of the scene in its cache, and writes the cache file
+	 */
+	void write_scene_cache(const std::string &file_name, int scene_index);
+
+	void write_cached_image(const sg::Image &image);
+
+	void write_cached_material(const sg::PBRMaterial &material, const std::vector<sg::Texture *> &textures);
+
+	/**
+	 * @brief Adds the default camera, and a default light if the scene has none
+	 */
+	void add_default_camera_and_light(sg::Scene &scene);
+
+	/**
+	 * @brief Adds the skins of the glTF file, and sets them on the nodes drawing skinned meshes
+	 * @param nodes Nodes of the scene, indexed like the glTF nodes
+	 */
+	void load_skins(sg::Scene &scene, const std::vector<std::unique_ptr<sg::Node>> &nodes);
+
+	/**
+	 * @brief Adds the animations of the glTF file as scripts, which play in a loop
+	 * @param nodes Nodes of the scene, indexed like the glTF nodes
+	 * @param root_node Node the animation scripts are attached to
+	 */
+	void load_animations(sg::Scene &scene, const std::vector<std::unique_ptr<sg::Node>> &nodes, sg::Node &root_node);
+
+	/// Cache written while loading the glTF file, only set in read_scene_from_file
+	std::unique_ptr<SceneCacheWriter> scene_cache_writer;
+
+	/// Images being decoded, indexed like the glTF images, invalid once taken for upload
+	std::vector<std::future<std::unique_ptr<sg::Image>>> image_futures;
+
+	/// Scene the streamed images are added to
+	sg::Scene *streaming_scene{nullptr};
+
+	std::unique_ptr<UploadManager> streaming_upload_manager;
+
+	std::vector<StreamedImage> uploading_images;
+
+	/// Textures using each glTF image, patched once it is uploaded
+	std::vector<std::vector<sg::Texture *>> streamed_textures;
 };
 }        // namespace vkb
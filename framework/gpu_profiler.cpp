@@ -0,0 +1,270 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "gpu_profiler.h"
+
+#include "common/logging.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "stats.h"
+
+namespace vkb
+{
+constexpr uint32_t GpuProfiler::MAX_TIMESTAMPS;
+constexpr uint32_t GpuProfiler::MAX_STATISTICS_SCOPES;
+
+GpuProfiler::GpuProfiler(Device &device) :
+    device{device}
+{
+	if (device.get_features().pipelineStatisticsQuery)
+	{
+		VkQueryPoolCreateInfo info{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+		info.queryType          = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		info.queryCount         = MAX_STATISTICS_SCOPES;
+		info.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+		                          VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+		                          VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+		statistics_query_pool = std::make_unique<core::QueryPool>(device, info);
+	}
+
+	auto &limits = device.get_properties().limits;
+
+	uint32_t valid_bits = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0).get_properties().timestampValidBits;
+
+	supported = limits.timestampComputeAndGraphics && valid_bits > 0;
+
+	if (!supported)
+	{
+		return;
+	}
+
+	timestamp_period = limits.timestampPeriod;
+	timestamp_mask   = valid_bits >= 64 ? ~0ULL : (1ULL << valid_bits) - 1;
+
+	VkQueryPoolCreateInfo info{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+	info.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+	info.queryCount = MAX_TIMESTAMPS;
+
+	query_pool = std::make_unique<core::QueryPool>(device, info);
+}
+
+bool GpuProfiler::is_supported() const
+{
+	return supported;
+}
+
+bool GpuProfiler::is_pipeline_statistics_supported() const
+{
+	return statistics_query_pool != nullptr;
+}
+
+void GpuProfiler::begin_frame(CommandBuffer &command_buffer)
+{
+	if (statistics_query_pool)
+	{
+		command_buffer.reset_query_pool(*statistics_query_pool, 0, MAX_STATISTICS_SCOPES);
+
+		statistics_scopes.clear();
+		statistics_scope_active = false;
+	}
+
+	if (!supported)
+	{
+		return;
+	}
+
+	command_buffer.reset_query_pool(*query_pool, 0, MAX_TIMESTAMPS);
+
+	query_count = 0;
+	scopes.clear();
+
+	begin_scope(command_buffer, StatIndex::gpu_frame_time);
+}
+
+void GpuProfiler::end_frame(CommandBuffer &command_buffer)
+{
+	end_scope(command_buffer, StatIndex::gpu_frame_time);
+}
+
+void GpuProfiler::begin_scope(CommandBuffer &command_buffer, StatIndex index)
+{
+	// Queries are only valid once they were reset by begin_frame()
+	if (!supported || (query_count == 0 && index != StatIndex::gpu_frame_time))
+	{
+		return;
+	}
+
+	if (query_count + 2 > MAX_TIMESTAMPS)
+	{
+		LOGW("Too many GPU profiler scopes in the frame, increase GpuProfiler::MAX_TIMESTAMPS");
+		return;
+	}
+
+	command_buffer.write_timestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, *query_pool, query_count);
+
+	// The end query is reserved so that it is never used by another scope
+	scopes.push_back({index, query_count, query_count + 1, false});
+
+	query_count += 2;
+}
+
+void GpuProfiler::end_scope(CommandBuffer &command_buffer, StatIndex index)
+{
+	for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope)
+	{
+		if (scope->index == index && !scope->ended)
+		{
+			command_buffer.write_timestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, *query_pool, scope->end_query);
+
+			scope->ended = true;
+
+			return;
+		}
+	}
+}
+
+void GpuProfiler::begin_statistics_scope(CommandBuffer &command_buffer, const PipelineStatisticsStats &stats)
+{
+	assert(!statistics_scope_active && "A pipeline statistics scope is already active");
+
+	if (!statistics_query_pool)
+	{
+		return;
+	}
+
+	if (statistics_scopes.size() >= MAX_STATISTICS_SCOPES)
+	{
+		LOGW("Too many pipeline statistics scopes in the frame, increase GpuProfiler::MAX_STATISTICS_SCOPES");
+		return;
+	}
+
+	command_buffer.begin_query(*statistics_query_pool, to_u32(statistics_scopes.size()), 0);
+
+	statistics_scopes.push_back(stats);
+
+	statistics_scope_active = true;
+}
+
+void GpuProfiler::end_statistics_scope(CommandBuffer &command_buffer)
+{
+	if (!statistics_scope_active)
+	{
+		return;
+	}
+
+	command_buffer.end_query(*statistics_query_pool, to_u32(statistics_scopes.size() - 1));
+
+	statistics_scope_active = false;
+}
+
+void GpuProfiler::resolve()
+{
+	resolve_statistics();
+
+	times.clear();
+
+	if (query_count == 0)
+	{
+		return;
+	}
+
+	std::vector<uint64_t> timestamps(query_count);
+
+	// Queries of scopes which were never ended are not available and cannot be waited for
+	VkResult result = query_pool->get_results(0, query_count,
+	                                          timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t),
+	                                          VK_QUERY_RESULT_64_BIT);
+
+	if (result != VK_SUCCESS && result != VK_NOT_READY)
+	{
+		LOGW("Failed to read back the GPU timestamps: {}", to_string(result));
+	}
+	else
+	{
+		for (auto &scope : scopes)
+		{
+			if (!scope.ended)
+			{
+				continue;
+			}
+
+			uint64_t ticks = (timestamps[scope.end_query] - timestamps[scope.begin_query]) & timestamp_mask;
+
+			times[scope.index] += static_cast<float>(ticks) * timestamp_period * 1e-9f;
+		}
+	}
+
+	query_count = 0;
+	scopes.clear();
+}
+
+const std::map<StatIndex, float> &GpuProfiler::get_times() const
+{
+	return times;
+}
+
+const std::map<StatIndex, float> &GpuProfiler::get_statistics() const
+{
+	return statistics;
+}
+
+void GpuProfiler::resolve_statistics()
+{
+	statistics.clear();
+
+	// A scope left active was never ended, its query cannot be available
+	if (statistics_scope_active)
+	{
+		statistics_scopes.pop_back();
+		statistics_scope_active = false;
+	}
+
+	if (statistics_scopes.empty())
+	{
+		return;
+	}
+
+	// The counters are written in the order of their bits: vertex, clipping, fragment
+	std::vector<uint64_t> counts(statistics_scopes.size() * 3);
+
+	VkResult result = statistics_query_pool->get_results(0, to_u32(statistics_scopes.size()),
+	                                                     counts.size() * sizeof(uint64_t), counts.data(), 3 * sizeof(uint64_t),
+	                                                     VK_QUERY_RESULT_64_BIT);
+
+	if (result != VK_SUCCESS)
+	{
+		LOGW("Failed to read back the pipeline statistics: {}", to_string(result));
+	}
+	else
+	{
+		for (size_t i = 0; i < statistics_scopes.size(); ++i)
+		{
+			auto &stats = statistics_scopes[i];
+
+			statistics[stats.vertex_invocations] += static_cast<float>(counts[i * 3]);
+			statistics[stats.clipping_primitives] += static_cast<float>(counts[i * 3 + 1]);
+			statistics[stats.fragment_invocations] += static_cast<float>(counts[i * 3 + 2]);
+		}
+	}
+
+	statistics_scopes.clear();
+}
+}        // namespace vkb
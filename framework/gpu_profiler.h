@@ -0,0 +1,184 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/query_pool.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+enum class StatIndex;
+
+/**
+ * @brief Measures the GPU time of scopes of a frame with timestamp queries
+ *
+ * Each RenderFrame owns a profiler, so the queries of a frame are only read back once the frame
+ * is reused, after its fence was waited for, and reading them never stalls. Scopes are named by
+ * the StatIndex their time is reported as, the times of scopes sharing an index are summed.
+ *
+ * If the device supports pipeline statistics queries, scopes can also count the vertex shader
+ * invocations, the primitives output by clipping and the fragment shader invocations.
+ */
+class GpuProfiler
+{
+  public:
+	/**
+	 * @brief Maximum number of timestamps written in a frame, each scope uses two
+	 */
+	static constexpr uint32_t MAX_TIMESTAMPS = 64;
+
+	/**
+	 * @brief Maximum number of pipeline statistics scopes in a frame
+	 */
+	static constexpr uint32_t MAX_STATISTICS_SCOPES = 8;
+
+	/**
+	 * @brief Stats the counts of a pipeline statistics scope are reported as
+	 */
+	struct PipelineStatisticsStats
+	{
+		StatIndex vertex_invocations;
+
+		StatIndex clipping_primitives;
+
+		StatIndex fragment_invocations;
+	};
+
+	GpuProfiler(Device &device);
+
+	GpuProfiler(const GpuProfiler &) = delete;
+
+	GpuProfiler(GpuProfiler &&) = default;
+
+	GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+	GpuProfiler &operator=(GpuProfiler &&) = delete;
+
+	/**
+	 * @return Whether the graphics queue supports timestamps
+	 */
+	bool is_supported() const;
+
+	/**
+	 * @return Whether the device supports pipeline statistics queries
+	 */
+	bool is_pipeline_statistics_supported() const;
+
+	/**
+	 * @brief Resets the queries of the frame and begins the scope of the whole frame
+	 *        It must be recorded outside of a render pass, before any other scope of the frame
+	 * @param command_buffer The first command buffer submitted in the frame
+	 */
+	void begin_frame(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Ends the scope of the whole frame
+	 * @param command_buffer The last command buffer submitted in the frame
+	 */
+	void end_frame(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Writes the timestamp beginning a scope
+	 *        Inside of a render pass, the subpass must record its commands inline
+	 */
+	void begin_scope(CommandBuffer &command_buffer, StatIndex index);
+
+	/**
+	 * @brief Writes the timestamp ending the most recent scope begun with the same index
+	 */
+	void end_scope(CommandBuffer &command_buffer, StatIndex index);
+
+	/**
+	 * @brief Begins counting the work of the pipeline stages
+	 *        The scope must end in the same subpass, which must record its commands inline.
+	 *        Only one statistics scope may be active at a time.
+	 */
+	void begin_statistics_scope(CommandBuffer &command_buffer, const PipelineStatisticsStats &stats);
+
+	/**
+	 * @brief Ends the active pipeline statistics scope
+	 */
+	void end_statistics_scope(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Reads back the timestamps written in the frame. The work of the frame must be complete.
+	 */
+	void resolve();
+
+	/**
+	 * @return The time in seconds of each scope of the frame when it was last resolved
+	 */
+	const std::map<StatIndex, float> &get_times() const;
+
+	/**
+	 * @return The pipeline statistics of each scope of the frame when it was last resolved
+	 */
+	const std::map<StatIndex, float> &get_statistics() const;
+
+  private:
+	struct Scope
+	{
+		StatIndex index;
+
+		uint32_t begin_query;
+
+		uint32_t end_query;
+
+		bool ended;
+	};
+
+	Device &device;
+
+	bool supported{false};
+
+	/// Nanoseconds per timestamp tick
+	float timestamp_period{1.0f};
+
+	/// Mask of the valid bits of the timestamps written by the graphics queue
+	uint64_t timestamp_mask{0};
+
+	std::unique_ptr<core::QueryPool> query_pool;
+
+	/// Queries written since begin_frame()
+	uint32_t query_count{0};
+
+	std::vector<Scope> scopes;
+
+	std::map<StatIndex, float> times;
+
+	std::unique_ptr<core::QueryPool> statistics_query_pool;
+
+	std::vector<PipelineStatisticsStats> statistics_scopes;
+
+	bool statistics_scope_active{false};
+
+	std::map<StatIndex, float> statistics;
+
+	void resolve_statistics();
+};
+}        // namespace vkb
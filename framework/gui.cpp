@@ -20,6 +20,10 @@
 
 #include "gui.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
 #include <map>
 #include <numeric>
 
@@ -43,7 +47,6 @@ VKBP_ENABLE_WARNINGS()
 #include "platform/filesystem.h"
 #include "rendering/render_context.h"
 #include "timer.h"
-#include "utils/graphs.h"
 #include "vulkan_sample.h"
 
 namespace vkb
@@ -59,6 +62,65 @@ inline void reset_graph_max_value(Gui::StatsView::GraphData &graph_data)
 		graph_data.max_value = 0.0f;
 	}
 }
+
+/**
+ * @brief Hashes the vertices and indices of the draw lists a word at a time, which is cheaper than uploading them
+ */
+uint64_t hash_draw_data(const ImDrawData &draw_data)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	auto hash_words = [&hash](const void *data, size_t size) {
+		auto bytes = reinterpret_cast<const uint8_t *>(data);
+
+		for (size_t offset = 0; offset < size; offset += sizeof(uint64_t))
+		{
+			uint64_t word = 0;
+			std::memcpy(&word, bytes + offset, std::min(sizeof(uint64_t), size - offset));
+
+			hash ^= word;
+			hash *= 0x100000001b3ULL;
+		}
+	};
+
+	for (int n = 0; n < draw_data.CmdListsCount; n++)
+	{
+		const ImDrawList *cmd_list = draw_data.CmdLists[n];
+
+		// The sizes keep the boundaries between the lists in the hash
+		hash_words(&cmd_list->VtxBuffer.Size, sizeof(cmd_list->VtxBuffer.Size));
+		hash_words(&cmd_list->IdxBuffer.Size, sizeof(cmd_list->IdxBuffer.Size));
+		hash_words(cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+		hash_words(cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+	}
+
+	return hash;
+}
+
+/**
+ * @brief Renders the cached gui overlay, the render pass holding only the overlay texture
+ */
+class OverlaySubpass : public Subpass
+{
+  public:
+	OverlaySubpass(RenderContext &render_context, std::function<void(CommandBuffer &)> draw_overlay) :
+	    Subpass{render_context, ShaderSource{"imgui.vert"}, ShaderSource{"imgui.frag"}},
+	    draw_overlay{std::move(draw_overlay)}
+	{
+	}
+
+	void prepare() override
+	{
+	}
+
+	void draw(CommandBuffer &command_buffer) override
+	{
+		draw_overlay(command_buffer);
+	}
+
+  private:
+	std::function<void(CommandBuffer &)> draw_overlay;
+};
 }        // namespace
 
 const double Gui::press_time_ms = 200.0f;
@@ -84,6 +146,8 @@ Gui::Gui(VulkanSample &sample_, const float dpi_factor) :
     sample{sample_},
     dpi_factor{dpi_factor}
 {
+	StartupTimeline::Scope stage{sample.get_startup_timeline(), "GUI and font atlas upload"};
+
 	ImGui::CreateContext();
 
 	ImGuiStyle &style = ImGui::GetStyle();
@@ -217,15 +281,205 @@ void Gui::update(const float delta_time)
 	if (!visible)
 	{
 		ImGui::EndFrame();
+
+		// Where the gui was drawn is uncovered
+		damage     = merge_rects(damage, drawn_area);
+		drawn_area = {};
 		return;
 	}
 
 	// Update imGui
 	ImGuiIO &io  = ImGui::GetIO();
-	io.DeltaTime = delta_time;
+	io.DeltaTime = overlay_refresh_rate > 0.0f ? overlay_delta_time : delta_time;
 
 	// Render to generate draw buffers
 	ImGui::Render();
+
+	overlay_stale = true;
+
+	// The windows may have moved, shrunk or grown, so both their previous and current area change
+	VkRect2D area{};
+
+	ImDrawData *draw_data = ImGui::GetDrawData();
+	for (int32_t i = 0; draw_data && i < draw_data->CmdListsCount; i++)
+	{
+		for (auto &cmd : draw_data->CmdLists[i]->CmdBuffer)
+		{
+			float min_x = std::max(std::floor(cmd.ClipRect.x), 0.0f);
+			float min_y = std::max(std::floor(cmd.ClipRect.y), 0.0f);
+			float max_x = std::min(std::ceil(cmd.ClipRect.z), io.DisplaySize.x);
+			float max_y = std::min(std::ceil(cmd.ClipRect.w), io.DisplaySize.y);
+
+			if (max_x > min_x && max_y > min_y)
+			{
+				area = merge_rects(area, {{static_cast<int32_t>(min_x), static_cast<int32_t>(min_y)},
+				                          {static_cast<uint32_t>(max_x - min_x), static_cast<uint32_t>(max_y - min_y)}});
+			}
+		}
+	}
+
+	damage     = merge_rects(damage, merge_rects(drawn_area, area));
+	drawn_area = area;
+}
+
+VkRect2D Gui::take_damage()
+{
+	VkRect2D result = damage;
+	damage          = {};
+	return result;
+}
+
+void Gui::set_overlay_refresh_rate(float refresh_rate)
+{
+	overlay_refresh_rate = std::max(refresh_rate, 0.0f);
+
+	// Rebuilt on the next frame
+	overlay_elapsed = 0.0f;
+	overlay_input   = true;
+}
+
+float Gui::get_overlay_refresh_rate() const
+{
+	return overlay_refresh_rate;
+}
+
+bool Gui::advance_overlay(float delta_time)
+{
+	if (overlay_refresh_rate <= 0.0f)
+	{
+		return true;
+	}
+
+	overlay_elapsed += delta_time;
+
+	if (!overlay_input && overlay_target && overlay_elapsed < 1.0f / overlay_refresh_rate)
+	{
+		return false;
+	}
+
+	overlay_delta_time = overlay_elapsed;
+	overlay_elapsed    = 0.0f;
+	overlay_input      = false;
+
+	return true;
+}
+
+void Gui::update_overlay_cache(CommandBuffer &command_buffer)
+{
+	// The overlays replaced are destroyed once no frame in flight can sample them
+	for (auto it = retired_overlay_targets.begin(); it != retired_overlay_targets.end();)
+	{
+		if (--it->second == 0)
+		{
+			sample.get_device().get_resource_cache().clear_framebuffers(it->first->get_views());
+			it = retired_overlay_targets.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	if (overlay_refresh_rate <= 0.0f || !visible || !ImGui::GetDrawData())
+	{
+		return;
+	}
+
+	auto &render_context = sample.get_render_context();
+
+	auto &present_view = render_context.get_active_frame().get_present_render_target().get_views().at(0);
+
+	const auto &extent = present_view.get_image().get_extent();
+	VkFormat    format = present_view.get_format();
+
+	if (!overlay_target ||
+	    overlay_target->get_extent().width != extent.width || overlay_target->get_extent().height != extent.height ||
+	    overlay_target->get_views().at(0).get_format() != format)
+	{
+		if (overlay_target)
+		{
+			retired_overlay_targets.emplace_back(std::move(overlay_target), render_context.get_render_frames().size());
+		}
+
+		std::vector<core::Image> images;
+		images.emplace_back(sample.get_device(),
+		                    VkExtent3D{extent.width, extent.height, 1},
+		                    format,
+		                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		                    VMA_MEMORY_USAGE_GPU_ONLY);
+
+		overlay_target = std::make_unique<RenderTarget>(std::move(images));
+
+		if (overlay_subpasses.empty())
+		{
+			overlay_subpasses.push_back(std::make_unique<OverlaySubpass>(render_context, [this](CommandBuffer &command_buffer) {
+				draw_overlay(command_buffer, true);
+			}));
+		}
+
+		overlay_stale = true;
+	}
+
+	if (!overlay_stale)
+	{
+		return;
+	}
+
+	overlay_stale = false;
+
+	auto &overlay_view = overlay_target->get_views().at(0);
+
+	{
+		// Waits for the previous frames to be done compositing the overlay
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		memory_barrier.dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+		command_buffer.image_memory_barrier(overlay_view, memory_barrier);
+	}
+
+	std::vector<LoadStoreInfo> load_store(1);
+	load_store[0].load_op  = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	load_store[0].store_op = VK_ATTACHMENT_STORE_OP_STORE;
+
+	std::vector<VkClearValue> clear_value(1);
+	clear_value[0].color = {{0.0f, 0.0f, 0.0f, 0.0f}};
+
+	command_buffer.begin_debug_label("GUI overlay cache");
+
+	command_buffer.begin_render_pass(*overlay_target, load_store, clear_value, overlay_subpasses);
+
+	VkViewport viewport{};
+	viewport.width    = static_cast<float>(extent.width);
+	viewport.height   = static_cast<float>(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	command_buffer.set_viewport(0, {viewport});
+
+	VkRect2D scissor{};
+	scissor.extent = {extent.width, extent.height};
+	command_buffer.set_scissor(0, {scissor});
+
+	overlay_subpasses[0]->draw(command_buffer);
+
+	command_buffer.end_render_pass();
+
+	command_buffer.end_debug_label();
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+		command_buffer.image_memory_barrier(overlay_view, memory_barrier);
+	}
 }
 
 void Gui::update_buffers(CommandBuffer &command_buffer)
@@ -240,38 +494,51 @@ void Gui::update_buffers(CommandBuffer &command_buffer)
 		return;
 	}
 
-	std::vector<uint8_t> vertex_data(vertex_buffer_size);
-	std::vector<uint8_t> index_data(index_buffer_size);
+	auto &render_context = sample.get_render_context();
 
-	// Upload data
-	ImDrawVert *vtx_dst = (ImDrawVert *) vertex_data.data();
-	ImDrawIdx * idx_dst = (ImDrawIdx *) index_data.data();
+	draw_buffers.resize(render_context.get_render_frames().size());
 
-	for (int n = 0; n < draw_data->CmdListsCount; n++)
+	auto &frame_buffers = draw_buffers[render_context.get_active_frame_index()];
+
+	if (!frame_buffers.vertex_buffer || frame_buffers.vertex_buffer->get_size() < vertex_buffer_size)
 	{
-		const ImDrawList *cmd_list = draw_data->CmdLists[n];
-		memcpy(vtx_dst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
-		memcpy(idx_dst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
-		vtx_dst += cmd_list->VtxBuffer.Size;
-		idx_dst += cmd_list->IdxBuffer.Size;
+		frame_buffers.vertex_buffer  = std::make_unique<core::Buffer>(render_context.get_device(), vertex_buffer_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, VMA_ALLOCATION_CREATE_MAPPED_BIT);
+		frame_buffers.draw_data_hash = 0;
 	}
 
-	auto vertex_allocation = sample.get_render_context().get_active_frame().allocate_buffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertex_buffer_size);
+	if (!frame_buffers.index_buffer || frame_buffers.index_buffer->get_size() < index_buffer_size)
+	{
+		frame_buffers.index_buffer   = std::make_unique<core::Buffer>(render_context.get_device(), index_buffer_size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, VMA_ALLOCATION_CREATE_MAPPED_BIT);
+		frame_buffers.draw_data_hash = 0;
+	}
 
-	vertex_allocation.update(vertex_data);
+	// The stats overlay often draws the same data for several frames, in which case the buffers of the frame already hold it
+	uint64_t draw_data_hash = hash_draw_data(*draw_data);
 
-	std::vector<std::reference_wrapper<const core::Buffer>> buffers;
-	buffers.emplace_back(std::ref(vertex_allocation.get_buffer()));
+	if (frame_buffers.draw_data_hash != draw_data_hash)
+	{
+		// Upload data straight into the mapped buffers
+		ImDrawVert *vtx_dst = reinterpret_cast<ImDrawVert *>(frame_buffers.vertex_buffer->map());
+		ImDrawIdx * idx_dst = reinterpret_cast<ImDrawIdx *>(frame_buffers.index_buffer->map());
 
-	std::vector<VkDeviceSize> offsets{vertex_allocation.get_offset()};
+		for (int n = 0; n < draw_data->CmdListsCount; n++)
+		{
+			const ImDrawList *cmd_list = draw_data->CmdLists[n];
+			memcpy(vtx_dst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+			memcpy(idx_dst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+			vtx_dst += cmd_list->VtxBuffer.Size;
+			idx_dst += cmd_list->IdxBuffer.Size;
+		}
 
-	command_buffer.bind_vertex_buffers(0, buffers, offsets);
+		frame_buffers.vertex_buffer->flush(0, vertex_buffer_size);
+		frame_buffers.index_buffer->flush(0, index_buffer_size);
 
-	auto index_allocation = sample.get_render_context().get_active_frame().allocate_buffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, index_buffer_size);
+		frame_buffers.draw_data_hash = draw_data_hash;
+	}
 
-	index_allocation.update(index_data);
+	command_buffer.bind_vertex_buffer(0, *frame_buffers.vertex_buffer, 0);
 
-	command_buffer.bind_index_buffer(index_allocation.get_buffer(), index_allocation.get_offset(), VK_INDEX_TYPE_UINT16);
+	command_buffer.bind_index_buffer(*frame_buffers.index_buffer, 0, VK_INDEX_TYPE_UINT16);
 }
 
 void Gui::resize(const uint32_t width, const uint32_t height) const
@@ -288,6 +555,67 @@ void Gui::draw(CommandBuffer &command_buffer)
 		return;
 	}
 
+	if (overlay_refresh_rate <= 0.0f)
+	{
+		draw_overlay(command_buffer, false);
+		return;
+	}
+
+	if (!overlay_target)
+	{
+		return;
+	}
+
+	command_buffer.begin_debug_label("GUI");
+
+	// Full screen triangle sampling the cached overlay, as the upscale pass does
+	auto &resource_cache = command_buffer.get_device().get_resource_cache();
+
+	std::vector<ShaderModule *> shader_modules{&resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, ShaderSource{"upscale.vert"}, {}),
+	                                           &resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, ShaderSource{"upscale.frag"}, {})};
+
+	command_buffer.bind_pipeline_layout(resource_cache.request_pipeline_layout(shader_modules, false));
+
+	command_buffer.set_vertex_input_state({});
+
+	// The overlay has premultiplied alpha
+	vkb::ColorBlendAttachmentState color_attachment{};
+	color_attachment.blend_enable           = VK_TRUE;
+	color_attachment.color_write_mask       = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT;
+	color_attachment.src_color_blend_factor = VK_BLEND_FACTOR_ONE;
+	color_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+	vkb::ColorBlendState blend_state{};
+	blend_state.attachments = {color_attachment};
+
+	command_buffer.set_color_blend_state(blend_state);
+
+	vkb::RasterizationState rasterization_state{};
+	rasterization_state.cull_mode = VK_CULL_MODE_NONE;
+	command_buffer.set_rasterization_state(rasterization_state);
+
+	vkb::DepthStencilState depth_state{};
+	depth_state.depth_test_enable  = VK_FALSE;
+	depth_state.depth_write_enable = VK_FALSE;
+	command_buffer.set_depth_stencil_state(depth_state);
+
+	const auto &extent = overlay_target->get_extent();
+
+	VkRect2D scissor{};
+	scissor.extent = extent;
+	command_buffer.set_scissor(0, {scissor});
+
+	command_buffer.bind_image(overlay_target->get_views().at(0), *sampler, 0, 0, 0);
+
+	command_buffer.draw(3, 1, 0, 0);
+
+	command_buffer.end_debug_label();
+}
+
+void Gui::draw_overlay(CommandBuffer &command_buffer, bool cached)
+{
+	command_buffer.begin_debug_label("GUI");
+
 	// Vertex input state
 	VkVertexInputBindingDescription vertex_input_binding{};
 	vertex_input_binding.stride = to_u32(sizeof(ImDrawVert));
@@ -323,6 +651,14 @@ void Gui::draw(CommandBuffer &command_buffer)
 	color_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
 	color_attachment.src_alpha_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
 
+	if (cached)
+	{
+		// The coverage is accumulated in the alpha of the cache, to composite it with premultiplied alpha
+		color_attachment.color_write_mask |= VK_COLOR_COMPONENT_A_BIT;
+		color_attachment.src_alpha_blend_factor = VK_BLEND_FACTOR_ONE;
+		color_attachment.dst_alpha_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	}
+
 	vkb::ColorBlendState blend_state{};
 	blend_state.attachments = {color_attachment};
 
@@ -421,13 +757,15 @@ void Gui::draw(CommandBuffer &command_buffer)
 					}
 				}
 
-				command_buffer.set_scissor(0, {scissor_rect});
+				command_buffer.set_scissor(0, 1, &scissor_rect);
 				command_buffer.draw_indexed(cmd->ElemCount, 1, index_offset, vertex_offset, 0);
 				index_offset += cmd->ElemCount;
 			}
 			vertex_offset += cmd_list->VtxBuffer.Size;
 		}
 	}
+
+	command_buffer.end_debug_label();
 }
 
 Gui::~Gui()
@@ -584,7 +922,7 @@ void Gui::show_debug_window(DebugInfo &debug_info, const ImVec2 &position)
 
 	if (ImGui::Button("Save Debug Graphs"))
 	{
-		if (utils::debug_graphs(sample.get_render_context(), sample.get_scene()))
+		if (sample.save_debug_graphs())
 		{
 			message = "Graphs Saved!";
 		}
@@ -711,6 +1049,9 @@ void Gui::show_options_window(std::function<void()> body, const uint32_t lines)
 
 bool Gui::input_event(const InputEvent &input_event)
 {
+	// The cached overlay is rebuilt right away, so that it stays responsive
+	overlay_input = true;
+
 	auto &io                 = ImGui::GetIO();
 	auto  capture_move_event = false;
 
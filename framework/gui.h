@@ -32,6 +32,8 @@
 #include "debug_info.h"
 #include "platform/filesystem.h"
 #include "platform/input_events.h"
+#include "rendering/render_target.h"
+#include "rendering/subpass.h"
 #include "stats.h"
 
 namespace vkb
@@ -197,7 +199,225 @@ class Gui
 		        {StatIndex::l2_ext_write_bytes,
 		         {/* name = */ "External Write Bytes",
 		          /* format = */ "{:4.1f} MiB/s",
-		          /* scale_factor = */ 1.0f / (1024.0f * 1024.0f)}}};
+		          /* scale_factor = */ 1.0f / (1024.0f * 1024.0f)}},
+		        {StatIndex::culled_draws,
+		         {/* name = */ "Culled Draws",
+		          /* format = */ "{:4.0f}"}},
+		        {StatIndex::occluded_draws,
+		         {/* name = */ "Occluded Draws",
+		          /* format = */ "{:4.0f}"}},
+		        {StatIndex::input_latency,
+		         {/* name = */ "Input Latency",
+		          /* format = */ "{:4.1f} ms",
+		          /* scale_factor = */ 1000.0f}},
+		        {StatIndex::gpu_frame_time,
+		         {/* name = */ "GPU Frame Time",
+		          /* format = */ "{:4.2f} ms",
+		          /* scale_factor = */ 1000.0f}},
+		        {StatIndex::gpu_render_pass_time,
+		         {/* name = */ "GPU Render Pass Time",
+		          /* format = */ "{:4.2f} ms",
+		          /* scale_factor = */ 1000.0f}},
+		        {StatIndex::gpu_subpass_0_time,
+		         {/* name = */ "GPU Subpass 0 Time",
+		          /* format = */ "{:4.2f} ms",
+		          /* scale_factor = */ 1000.0f}},
+		        {StatIndex::gpu_subpass_1_time,
+		         {/* name = */ "GPU Subpass 1 Time",
+		          /* format = */ "{:4.2f} ms",
+		          /* scale_factor = */ 1000.0f}},
+		        {StatIndex::subpass_0_vertex_invocations,
+		         {/* name = */ "Subpass 0 Vertex Invocations",
+		          /* format = */ "{:4.1f} k",
+		          /* scale_factor = */ float(1e-3)}},
+		        {StatIndex::subpass_0_clipping_primitives,
+		         {/* name = */ "Subpass 0 Clipping Primitives",
+		          /* format = */ "{:4.1f} k",
+		          /* scale_factor = */ float(1e-3)}},
+		        {StatIndex::subpass_0_fragment_invocations,
+		         {/* name = */ "Subpass 0 Fragment Invocations",
+		          /* format = */ "{:4.1f} M",
+		          /* scale_factor = */ float(1e-6)}},
+		        {StatIndex::subpass_1_vertex_invocations,
+		         {/* name = */ "Subpass 1 Vertex Invocations",
+		          /* format = */ "{:4.1f} k",
+		          /* scale_factor = */ float(1e-3)}},
+		        {StatIndex::subpass_1_clipping_primitives,
+		         {/* name = */ "Subpass 1 Clipping Primitives",
+		          /* format = */ "{:4.1f} k",
+		          /* scale_factor = */ float(1e-3)}},
+		        {StatIndex::subpass_1_fragment_invocations,
+		         {/* name = */ "Subpass 1 Fragment Invocations",
+		          /* format = */ "{:4.1f} M",
+		          /* scale_factor = */ float(1e-6)}},
+		        {StatIndex::shader_cycles,
+		         {/* name = */ "Shader Cycles",
+		          /* format = */ "{:4.1f} M/s",
+		          /* scale_factor = */ float(1e-6)}},
+		        {StatIndex::shader_arithmetic_cycles,
+		         {/* name = */ "Shader Arithmetic Cycles",
+		          /* format = */ "{:4.1f} M/s",
+		          /* scale_factor = */ float(1e-6)}},
+		        {StatIndex::shader_load_store_cycles,
+		         {/* name = */ "Shader Load/Store Cycles",
+		          /* format = */ "{:4.1f} M/s",
+		          /* scale_factor = */ float(1e-6)}},
+		        {StatIndex::tiler_cycles,
+		         {/* name = */ "Tiler Cycles",
+		          /* format = */ "{:4.1f} M/s",
+		          /* scale_factor = */ float(1e-6)}},
+		        {StatIndex::pixels,
+		         {/* name = */ "Pixels",
+		          /* format = */ "{:4.1f} M/s",
+		          /* scale_factor = */ float(1e-6)}},
+		        {StatIndex::early_z_tests,
+		         {/* name = */ "Early ZS Tested Quads",
+		          /* format = */ "{:4.1f} M/s",
+		          /* scale_factor = */ float(1e-6)}},
+		        {StatIndex::early_z_killed,
+		         {/* name = */ "Early ZS Killed Quads",
+		          /* format = */ "{:4.1f} M/s",
+		          /* scale_factor = */ float(1e-6)}},
+		        {StatIndex::late_z_tests,
+		         {/* name = */ "Late ZS Tested Threads",
+		          /* format = */ "{:4.1f} M/s",
+		          /* scale_factor = */ float(1e-6)}},
+		        {StatIndex::late_z_killed,
+		         {/* name = */ "Late ZS Killed Threads",
+		          /* format = */ "{:4.1f} M/s",
+		          /* scale_factor = */ float(1e-6)}},
+		        {StatIndex::input_primitives,
+		         {/* name = */ "Input Primitives",
+		          /* format = */ "{:4.1f} M/s",
+		          /* scale_factor = */ float(1e-6)}},
+		        {StatIndex::culled_primitives,
+		         {/* name = */ "Culled Primitives",
+		          /* format = */ "{:4.1f} M/s",
+		          /* scale_factor = */ float(1e-6)}},
+		        {StatIndex::visible_primitives,
+		         {/* name = */ "Visible Primitives",
+		          /* format = */ "{:4.1f} M/s",
+		          /* scale_factor = */ float(1e-6)}},
+		        {StatIndex::l2_ext_read_bytes_per_pixel,
+		         {/* name = */ "External Read Bytes per Pixel",
+		          /* format = */ "{:4.2f} B/px"}},
+		        {StatIndex::l2_ext_write_bytes_per_pixel,
+		         {/* name = */ "External Write Bytes per Pixel",
+		          /* format = */ "{:4.2f} B/px"}},
+		        {StatIndex::overdraw,
+		         {/* name = */ "Overdraw",
+		          /* format = */ "{:4.2f}x",
+		          /* scale_factor = */ 4.0f}},
+		        {StatIndex::device_memory_usage,
+		         {/* name = */ "Device Memory Usage",
+		          /* format = */ "{:4.1f} MiB",
+		          /* scale_factor = */ 1.0f / (1024.0f * 1024.0f)}},
+		        {StatIndex::device_memory_budget,
+		         {/* name = */ "Device Memory Budget",
+		          /* format = */ "{:4.1f} MiB",
+		          /* scale_factor = */ 1.0f / (1024.0f * 1024.0f)}},
+		        {StatIndex::memory_buffer_pools,
+		         {/* name = */ "Buffer Pools Memory",
+		          /* format = */ "{:4.1f} MiB",
+		          /* scale_factor = */ 1.0f / (1024.0f * 1024.0f)}},
+		        {StatIndex::memory_textures,
+		         {/* name = */ "Textures Memory",
+		          /* format = */ "{:4.1f} MiB",
+		          /* scale_factor = */ 1.0f / (1024.0f * 1024.0f)}},
+		        {StatIndex::memory_geometry,
+		         {/* name = */ "Geometry Memory",
+		          /* format = */ "{:4.1f} MiB",
+		          /* scale_factor = */ 1.0f / (1024.0f * 1024.0f)}},
+		        {StatIndex::memory_render_targets,
+		         {/* name = */ "Render Targets Memory",
+		          /* format = */ "{:4.1f} MiB",
+		          /* scale_factor = */ 1.0f / (1024.0f * 1024.0f)}},
+		        {StatIndex::memory_staging,
+		         {/* name = */ "Staging Memory",
+		          /* format = */ "{:4.1f} MiB",
+		          /* scale_factor = */ 1.0f / (1024.0f * 1024.0f)}},
+		        {StatIndex::render_scale,
+		         {/* name = */ "Render Scale",
+		          /* format = */ "{:3.0f} %",
+		          /* scale_factor = */ 100.0f}},
+		        {StatIndex::thermal_headroom,
+		         {/* name = */ "Thermal Headroom",
+		          /* format = */ "{:3.0f} %",
+		          /* scale_factor = */ 100.0f}},
+		        {StatIndex::temperature,
+		         {/* name = */ "Temperature",
+		          /* format = */ "{:4.1f} C"}},
+		        {StatIndex::resource_cache_misses,
+		         {/* name = */ "Resource Cache Misses",
+		          /* format = */ "{:4.0f}"}},
+		        {StatIndex::cached_graphics_pipelines,
+		         {/* name = */ "Cached Graphics Pipelines",
+		          /* format = */ "{:4.0f}"}},
+		        {StatIndex::pipeline_binds,
+		         {/* name = */ "Pipeline Binds",
+		          /* format = */ "{:4.0f}"}},
+		        {StatIndex::descriptor_set_binds,
+		         {/* name = */ "Descriptor Set Binds",
+		          /* format = */ "{:4.0f}"}},
+		        {StatIndex::vertex_buffer_binds,
+		         {/* name = */ "Vertex Buffer Binds",
+		          /* format = */ "{:4.0f}"}},
+		        {StatIndex::render_target_bytes_per_pixel,
+		         {/* name = */ "Render Target Size",
+		          /* format = */ "{:4.0f} B/px"}},
+		        {StatIndex::resource_cache_contentions,
+		         {/* name = */ "Resource Cache Contentions",
+		          /* format = */ "{:4.0f}"}},
+		        {StatIndex::cpu_recording_time,
+		         {/* name = */ "CPU Recording Time",
+		          /* format = */ "{:4.2f} ms"}},
+		        {StatIndex::draw_calls,
+		         {/* name = */ "Draw Calls",
+		          /* format = */ "{:4.0f}"}},
+		        {StatIndex::descriptor_set_allocations,
+		         {/* name = */ "Descriptor Set Allocations",
+		          /* format = */ "{:4.0f}"}},
+		        {StatIndex::uploaded_bytes,
+		         {/* name = */ "Uploaded Bytes",
+		          /* format = */ "{:4.1f} KiB",
+		          /* scale_factor = */ 1.0f / 1024.0f}},
+		        {StatIndex::buffer_pool_blocks,
+		         {/* name = */ "Buffer Pool Blocks",
+		          /* format = */ "{:4.0f}"}},
+		        {StatIndex::buffer_pool_high_water,
+		         {/* name = */ "Buffer Pool High-Water Mark",
+		          /* format = */ "{:4.1f} KiB",
+		          /* scale_factor = */ 1.0f / 1024.0f}},
+		        {StatIndex::attachment_read_bytes,
+		         {/* name = */ "Estimated Attachment Reads",
+		          /* format = */ "{:4.1f} MiB/s",
+		          /* scale_factor = */ 1.0f / (1024.0f * 1024.0f)}},
+		        {StatIndex::attachment_write_bytes,
+		         {/* name = */ "Estimated Attachment Writes",
+		          /* format = */ "{:4.1f} MiB/s",
+		          /* scale_factor = */ 1.0f / (1024.0f * 1024.0f)}},
+		        {StatIndex::gpu_busy,
+		         {/* name = */ "GPU Busy",
+		          /* format = */ "{:3.0f} %",
+		          /* scale_factor = */ 100.0f,
+		          /* has_fixed_max = */ true,
+		          /* max_value = */ 100.0f}},
+		        {StatIndex::gpu_idle_time,
+		         {/* name = */ "GPU Idle Time",
+		          /* format = */ "{:4.2f} ms",
+		          /* scale_factor = */ 1000.0f}},
+		        {StatIndex::compute_queue_busy,
+		         {/* name = */ "Compute Queue Busy",
+		          /* format = */ "{:3.0f} %",
+		          /* scale_factor = */ 100.0f,
+		          /* has_fixed_max = */ true,
+		          /* max_value = */ 100.0f}},
+		        {StatIndex::gpu_starved,
+		         {/* name = */ "GPU Starved",
+		          /* format = */ "{:1.0f}",
+		          /* scale_factor = */ 1.0f,
+		          /* has_fixed_max = */ true,
+		          /* max_value = */ 1.0f}}};
 
 		float graph_height{50.0f};
 
@@ -254,11 +474,37 @@ class Gui
 	void update(const float delta_time);
 
 	/**
-	 * @brief Draws the Gui
+	 * @brief Region of the frame, in unrotated pixels, that the updates of the Gui changed since the last call
+	 */
+	VkRect2D take_damage();
+
+	/**
+	 * @brief Draws the Gui, or composites the cached overlay if it is enabled
 	 * @param command_buffer Command buffer to register draw-commands
 	 */
 	void draw(CommandBuffer &command_buffer);
 
+	/**
+	 * @brief Renders the overlay to a cached texture at a limited rate, which is composited with a single
+	 *        full screen triangle on every frame. The overlay is also rebuilt after any input event.
+	 * @param refresh_rate Number of times per second the overlay is rebuilt, 0 to draw it every frame
+	 */
+	void set_overlay_refresh_rate(float refresh_rate);
+
+	float get_overlay_refresh_rate() const;
+
+	/**
+	 * @brief Advances the time of the overlay, to be called every frame
+	 * @param delta_time Time passed since last frame
+	 * @return Whether the overlay is to be built this frame, always true unless the overlay is cached
+	 */
+	bool advance_overlay(float delta_time);
+
+	/**
+	 * @brief Renders the cached overlay if it was rebuilt since, to be called outside of a render pass before draw()
+	 */
+	void update_overlay_cache(CommandBuffer &command_buffer);
+
 	/**
 	 * @brief Shows an overlay top window with app info and maybe stats
 	 * @param app_name Application name
@@ -318,6 +564,12 @@ class Gui
 	 */
 	void update_buffers(CommandBuffer &command_buffer);
 
+	/**
+	 * @brief Records the draws of the ImGui draw data
+	 * @param cached Whether the overlay is drawn to its cache, with premultiplied alpha, or to the frame directly
+	 */
+	void draw_overlay(CommandBuffer &command_buffer, bool cached);
+
 	static const double press_time_ms;
 
 	static const float overlay_alpha;
@@ -342,6 +594,20 @@ class Gui
 
 	PipelineLayout *pipeline_layout{nullptr};
 
+	/// Persistently mapped vertex and index buffers of a render frame
+	struct DrawBuffers
+	{
+		std::unique_ptr<core::Buffer> vertex_buffer;
+
+		std::unique_ptr<core::Buffer> index_buffer;
+
+		/// Hash of the draw data the buffers hold
+		uint64_t draw_data_hash{0};
+	};
+
+	/// Draw buffers of each render frame, rewritten only when the draw data changes
+	std::vector<DrawBuffers> draw_buffers;
+
 	StatsView stats_view;
 
 	DebugView debug_view;
@@ -356,6 +622,34 @@ class Gui
 	bool two_finger_tap = false;
 
 	bool show_graph_file_output = false;
+
+	float overlay_refresh_rate{0.0f};
+
+	/// Time since the overlay was last built
+	float overlay_elapsed{0.0f};
+
+	/// Time passed to ImGui when the overlay is built, the time since it was last built
+	float overlay_delta_time{0.0f};
+
+	/// Whether an input event arrived since the overlay was last built
+	bool overlay_input{false};
+
+	/// Whether the overlay was built since it was last rendered to its cache
+	bool overlay_stale{false};
+
+	/// Cached overlay, in the orientation and format of the images the gui is drawn to
+	std::unique_ptr<RenderTarget> overlay_target;
+
+	/// Replaced cached overlays, with the number of frames they may still be used by
+	std::vector<std::pair<std::unique_ptr<RenderTarget>, size_t>> retired_overlay_targets;
+
+	std::vector<std::unique_ptr<Subpass>> overlay_subpasses;
+
+	/// Area covered by the windows when the Gui was last built
+	VkRect2D drawn_area{};
+
+	/// Area changed by the updates since the damage was last taken
+	VkRect2D damage{};
 };
 
 void Gui::new_frame()
@@ -0,0 +1,336 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "job_system.h"
+
+#include <algorithm>
+#include <bitset>
+
+#include "common/logging.h"
+#include "platform/thread_affinity.h"
+
+namespace vkb
+{
+namespace
+{
+/// Job system of the worker running on this thread, if any
+thread_local JobSystem *current_job_system{nullptr};
+
+thread_local size_t current_worker_index{0};
+
+/**
+ * @brief Tasks of a run_parallel call, shared with the jobs helping the calling thread
+ *        Jobs starting after all the tasks were claimed only find no task left, so they may outlive the call
+ */
+struct ParallelState
+{
+	std::function<void(size_t, size_t)> task;
+
+	size_t task_count{0};
+
+	std::atomic<size_t> next_task{0};
+
+	std::mutex mutex;
+
+	std::condition_variable done;
+
+	size_t done_count{0};
+
+	std::exception_ptr error;
+};
+
+void run_parallel_slot(ParallelState &state, size_t slot)
+{
+	for (size_t task_index = state.next_task++; task_index < state.task_count; task_index = state.next_task++)
+	{
+		std::exception_ptr error;
+
+		try
+		{
+			state.task(task_index, slot);
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+
+		std::lock_guard<std::mutex> lock{state.mutex};
+
+		if (error && !state.error)
+		{
+			state.error = error;
+		}
+
+		if (++state.done_count == state.task_count)
+		{
+			state.done.notify_all();
+		}
+	}
+}
+}        // namespace
+
+JobSystem::JobSystem(uint32_t thread_count)
+{
+	if (thread_count == 0)
+	{
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	for (uint32_t i = 0; i < thread_count; ++i)
+	{
+		workers.push_back(std::make_unique<Worker>());
+	}
+
+	// Workers are started once they all exist, as they steal from each other
+	for (size_t i = 0; i < workers.size(); ++i)
+	{
+		workers[i]->thread = std::thread(&JobSystem::run, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock{wake_mutex};
+		stopping = true;
+	}
+
+	wake.notify_all();
+
+	for (auto &worker : workers)
+	{
+		worker->thread.join();
+	}
+}
+
+uint32_t JobSystem::get_thread_count() const
+{
+	return static_cast<uint32_t>(workers.size());
+}
+
+void JobSystem::run_parallel(JobPriority priority, size_t task_count, size_t slot_count, const std::function<void(size_t, size_t)> &task)
+{
+	if (task_count == 0)
+	{
+		return;
+	}
+
+	auto state        = std::make_shared<ParallelState>();
+	state->task       = task;
+	state->task_count = task_count;
+
+	// Only the workers running jobs of the priority can help
+	size_t worker_count = workers.size();
+	if (background_worker_count > 0)
+	{
+		worker_count = priority == JobPriority::Background ? background_worker_count.load() : workers.size() - background_worker_count;
+	}
+
+	// The calling thread always takes part, even with no slot requested
+	size_t helper_count = std::min({std::max<size_t>(slot_count, 1), task_count, worker_count + 1}) - 1;
+
+	for (size_t slot = 1; slot <= helper_count; ++slot)
+	{
+		enqueue(priority, [state, slot](size_t) { run_parallel_slot(*state, slot); });
+	}
+
+	run_parallel_slot(*state, 0);
+
+	std::unique_lock<std::mutex> lock{state->mutex};
+
+	state->done.wait(lock, [&state]() { return state->done_count == state->task_count; });
+
+	if (state->error)
+	{
+		std::rethrow_exception(state->error);
+	}
+}
+
+bool JobSystem::set_affinity(uint64_t cpu_mask, uint64_t background_cpu_mask)
+{
+	size_t background_count = std::min<size_t>(std::bitset<64>{background_cpu_mask}.count(), workers.size() - 1);
+
+	{
+		std::lock_guard<std::mutex> lock{wake_mutex};
+
+		for (size_t i = 0; i < workers.size(); ++i)
+		{
+			workers[i]->background = i >= workers.size() - background_count;
+		}
+
+		background_worker_count = background_count;
+	}
+
+	// Workers asleep may now accept jobs queued for others
+	wake.notify_all();
+
+	bool result = true;
+
+	for (size_t i = 0; i < workers.size(); ++i)
+	{
+		result = set_thread_affinity(workers[i]->thread, workers[i]->background ? background_cpu_mask : cpu_mask) && result;
+	}
+
+	if (!result)
+	{
+		LOGW("Cannot set the affinity of the job system workers to {:#x} and {:#x}", cpu_mask, background_cpu_mask);
+	}
+
+	return result;
+}
+
+uint32_t JobSystem::get_background_thread_count() const
+{
+	return static_cast<uint32_t>(background_worker_count);
+}
+
+std::vector<int32_t> JobSystem::get_frame_thread_ids() const
+{
+	std::vector<int32_t> thread_ids;
+
+	for (auto &worker : workers)
+	{
+		int32_t thread_id = worker->thread_id;
+
+		if (thread_id != 0 && !worker->background)
+		{
+			thread_ids.push_back(thread_id);
+		}
+	}
+
+	return thread_ids;
+}
+
+void JobSystem::enqueue(JobPriority priority, Job &&job)
+{
+	// Jobs pushed by a worker stay on it, as they often work on the same data
+	size_t worker_index = current_job_system == this ? current_worker_index : next_worker++ % workers.size();
+
+	// Counted before being queued, so that a worker taking it right away never sees a negative count
+	{
+		std::lock_guard<std::mutex> lock{wake_mutex};
+		queued_counts[static_cast<size_t>(priority)]++;
+	}
+
+	{
+		auto &worker = *workers[worker_index];
+
+		std::lock_guard<std::mutex> lock{worker.mutex};
+		worker.queues[static_cast<size_t>(priority)].push_back(std::move(job));
+	}
+
+	// With dedicated workers, the one woken could be unable to take the job
+	if (background_worker_count > 0)
+	{
+		wake.notify_all();
+	}
+	else
+	{
+		wake.notify_one();
+	}
+}
+
+bool JobSystem::pop(size_t worker_index, Job &job, JobPriority &priority)
+{
+	for (auto candidate : {JobPriority::Frame, JobPriority::Background})
+	{
+		if (!accepts(*workers[worker_index], candidate))
+		{
+			continue;
+		}
+
+		for (size_t i = 0; i < workers.size(); ++i)
+		{
+			auto &worker = *workers[(worker_index + i) % workers.size()];
+
+			std::lock_guard<std::mutex> lock{worker.mutex};
+
+			auto &queue = worker.queues[static_cast<size_t>(candidate)];
+
+			if (!queue.empty())
+			{
+				job = std::move(queue.front());
+				queue.pop_front();
+
+				priority = candidate;
+
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool JobSystem::accepts(const Worker &worker, JobPriority priority) const
+{
+	if (background_worker_count == 0)
+	{
+		return true;
+	}
+
+	return worker.background == (priority == JobPriority::Background);
+}
+
+void JobSystem::run(size_t worker_index)
+{
+	current_job_system   = this;
+	current_worker_index = worker_index;
+
+	auto &worker = *workers[worker_index];
+
+	worker.thread_id = get_current_thread_id();
+
+	Job         job;
+	JobPriority priority{JobPriority::Frame};
+
+	while (true)
+	{
+		if (pop(worker_index, job, priority))
+		{
+			{
+				std::lock_guard<std::mutex> lock{wake_mutex};
+				queued_counts[static_cast<size_t>(priority)]--;
+			}
+
+			job(worker_index);
+
+			job = nullptr;
+
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock{wake_mutex};
+
+		auto has_job = [this, &worker]() {
+			return (accepts(worker, JobPriority::Frame) && queued_counts[static_cast<size_t>(JobPriority::Frame)] > 0) ||
+			       (accepts(worker, JobPriority::Background) && queued_counts[static_cast<size_t>(JobPriority::Background)] > 0);
+		};
+
+		// A counted job may not be queued yet, then the worker looks again once woken
+		wake.wait(lock, [this, &has_job]() { return has_job() || stopping; });
+
+		if (stopping && !has_job())
+		{
+			return;
+		}
+	}
+}
+}        // namespace vkb
@@ -0,0 +1,185 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief Priority of a job, workers run all the queued frame jobs before any background job
+ */
+enum class JobPriority
+{
+	/// Work the current frame waits for, e.g. command buffer recording
+	Frame,
+
+	/// Work which may take several frames, e.g. asset loading or pipeline compilation
+	Background,
+
+	Count
+};
+
+/**
+ * @brief Worker threads shared by the whole framework
+ *
+ * Each worker has its own queues, one per priority. Jobs pushed from a worker go to its own queues,
+ * others are spread over the workers, and idle workers steal from the others. A worker takes
+ * the oldest frame job it can find, from its own queue first, before any background job.
+ *
+ * Workers may be dedicated to background jobs, e.g. to run them on the little cores of a big.LITTLE
+ * CPU while the other workers only run frame jobs on the big cores.
+ */
+class JobSystem
+{
+  public:
+	/**
+	 * @param thread_count Number of workers, 0 to use one per hardware thread
+	 */
+	JobSystem(uint32_t thread_count = 0);
+
+	JobSystem(const JobSystem &) = delete;
+
+	JobSystem(JobSystem &&) = delete;
+
+	/**
+	 * @brief Runs the jobs left in the queues, then stops the workers
+	 */
+	~JobSystem();
+
+	JobSystem &operator=(const JobSystem &) = delete;
+
+	JobSystem &operator=(JobSystem &&) = delete;
+
+	uint32_t get_thread_count() const;
+
+	/**
+	 * @brief Queues a job
+	 * @param priority Priority of the job
+	 * @param job Function called with the index of the worker running it
+	 * @return The future result of the job
+	 */
+	template <typename F>
+	auto push(JobPriority priority, F &&job) -> std::future<decltype(job(size_t{}))>
+	{
+		using Result = decltype(job(size_t{}));
+
+		auto task = std::make_shared<std::packaged_task<Result(size_t)>>(std::forward<F>(job));
+
+		auto future = task->get_future();
+
+		enqueue(priority, [task](size_t worker_index) { (*task)(worker_index); });
+
+		return future;
+	}
+
+	/**
+	 * @brief Runs tasks on the calling thread and at most slot_count - 1 workers, returning once they are all done
+	 *        Tasks are claimed in order by the threads taking part, so the caller never waits for a task
+	 *        which is still queued, even when called from a worker or when all the workers are busy.
+	 *        The first exception thrown by a task is rethrown once all of them are done.
+	 * @param priority Priority of the jobs helping the calling thread
+	 * @param task_count Number of tasks
+	 * @param slot_count Maximum number of threads running the tasks
+	 * @param task Function called with the index of a task, and the slot of the thread running it.
+	 *        The slot is lower than slot_count and unique among the threads running concurrently,
+	 *        e.g. to index per thread resources. The calling thread uses slot 0
+	 */
+	void run_parallel(JobPriority priority, size_t task_count, size_t slot_count, const std::function<void(size_t, size_t)> &task);
+
+	/**
+	 * @brief Restricts the workers to sets of CPUs, e.g. to keep the frame jobs on the big cores of a big.LITTLE CPU
+	 * @param cpu_mask Bit mask of the CPUs the workers may run on, 0 to allow all of them
+	 * @param background_cpu_mask Bit mask of the CPUs of the workers dedicated to background jobs, one per CPU
+	 *        leaving at least one worker for frame jobs. 0 for all the workers to run both kinds of jobs
+	 * @return False if the platform does not support it, or a mask was rejected
+	 */
+	bool set_affinity(uint64_t cpu_mask, uint64_t background_cpu_mask = 0);
+
+	/**
+	 * @return The number of workers dedicated to background jobs
+	 */
+	uint32_t get_background_thread_count() const;
+
+	/**
+	 * @return The operating system ids of the started workers running frame jobs, see get_current_thread_id()
+	 */
+	std::vector<int32_t> get_frame_thread_ids() const;
+
+  private:
+	using Job = std::function<void(size_t)>;
+
+	struct Worker
+	{
+		std::thread thread;
+
+		std::mutex mutex;
+
+		std::deque<Job> queues[static_cast<size_t>(JobPriority::Count)];
+
+		/// Whether the worker only runs background jobs, set under wake_mutex
+		std::atomic<bool> background{false};
+
+		/// Operating system id of the thread, 0 until it has started
+		std::atomic<int32_t> thread_id{0};
+	};
+
+	void enqueue(JobPriority priority, Job &&job);
+
+	/**
+	 * @brief Takes the next job for a worker, from its own queues first then from the others
+	 */
+	bool pop(size_t worker_index, Job &job, JobPriority &priority);
+
+	/**
+	 * @return Whether a worker runs jobs of a priority
+	 */
+	bool accepts(const Worker &worker, JobPriority priority) const;
+
+	void run(size_t worker_index);
+
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	/// Worker receiving the next job pushed from outside the workers
+	std::atomic<size_t> next_worker{0};
+
+	/// Workers dedicated to background jobs, the last ones
+	std::atomic<size_t> background_worker_count{0};
+
+	/// Guards queued_counts, stopping and the roles of the workers, for the workers to sleep while there is no job
+	std::mutex wake_mutex;
+
+	std::condition_variable wake;
+
+	size_t queued_counts[static_cast<size_t>(JobPriority::Count)]{};
+
+	bool stopping{false};
+};
+}        // namespace vkb
@@ -0,0 +1,146 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "load_benchmark.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "common/logging.h"
+#include "core/device.h"
+#include "platform/filesystem.h"
+#include "platform/platform.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace
+{
+/// Stage times of the report, in the order the stages first run
+const std::vector<std::pair<const char *, double GLTFLoader::LoadStats::*>> STAGE_TIMES = {
+    {"file_io", &GLTFLoader::LoadStats::file_io_time},
+    {"parse", &GLTFLoader::LoadStats::parse_time},
+    {"image_decode", &GLTFLoader::LoadStats::image_decode_time},
+    {"mip_generation", &GLTFLoader::LoadStats::mip_generation_time},
+    {"mesh_processing", &GLTFLoader::LoadStats::mesh_processing_time},
+    {"upload", &GLTFLoader::LoadStats::upload_time},
+    {"fence_wait", &GLTFLoader::LoadStats::fence_wait_time},
+    {"total", &GLTFLoader::LoadStats::total_time}};
+}        // namespace
+
+LoadBenchmark::LoadBenchmark(const std::string &scene_path, uint32_t load_count) :
+    scene_path{scene_path},
+    load_count{std::max(load_count, 1u)}
+{
+}
+
+bool LoadBenchmark::prepare(Platform &platform)
+{
+	if (!VulkanSample::prepare(platform))
+	{
+		return false;
+	}
+
+	nlohmann::json runs = nlohmann::json::array();
+
+	for (uint32_t load_index = 0; load_index < load_count; ++load_index)
+	{
+		GLTFLoader loader{*device};
+
+		auto loaded_scene = loader.read_scene_from_file(scene_path);
+
+		if (!loaded_scene)
+		{
+			LOGE("Cannot load scene {}", scene_path);
+			return false;
+		}
+
+		// The scene is released before the next load, so that each one starts from the same memory state
+		loaded_scene.reset();
+		device->wait_idle();
+
+		auto &stats = loader.get_load_stats();
+		load_stats.push_back(stats);
+
+		nlohmann::json run;
+		for (auto &stage : STAGE_TIMES)
+		{
+			run[stage.first] = stats.*stage.second;
+		}
+		run["peak_staging_usage"]   = stats.peak_staging_usage;
+		run["resident_image_data"]  = stats.resident_image_data;
+		run["peak_resident_memory"] = platform.get_peak_resident_memory();
+
+		LOGI("Load {}/{} of {}: {:.3f} seconds", load_index + 1, load_count, scene_path, stats.total_time);
+
+		runs.push_back(run);
+	}
+
+	nlohmann::json mean;
+	nlohmann::json min;
+
+	for (auto &stage : STAGE_TIMES)
+	{
+		double sum      = 0.0;
+		double min_time = load_stats.front().*stage.second;
+
+		for (auto &stats : load_stats)
+		{
+			sum += stats.*stage.second;
+			min_time = std::min(min_time, stats.*stage.second);
+		}
+
+		mean[stage.first] = sum / load_stats.size();
+		min[stage.first]  = min_time;
+
+		LOGI("{:16s} mean {:.3f} s, min {:.3f} s", stage.first, sum / load_stats.size(), min_time);
+	}
+
+	VkDeviceSize peak_staging_usage = 0;
+	for (auto &stats : load_stats)
+	{
+		peak_staging_usage = std::max(peak_staging_usage, stats.peak_staging_usage);
+	}
+
+	nlohmann::json report;
+	report["scene"]                = scene_path;
+	report["loads"]                = load_count;
+	report["time_unit"]            = "s";
+	report["runs"]                 = runs;
+	report["mean"]                 = mean;
+	report["min"]                  = min;
+	report["peak_staging_usage"]   = peak_staging_usage;
+	report["peak_resident_memory"] = platform.get_peak_resident_memory();
+
+	std::string report_string = report.dump(4);
+	fs::write_temp({report_string.begin(), report_string.end()}, "load_benchmark_report.json");
+
+	LOGI("Load benchmark report written to load_benchmark_report.json");
+
+	platform.close();
+
+	return true;
+}
+
+void LoadBenchmark::update(float delta_time)
+{
+	// Nothing is rendered, the platform closes once the loads are done
+}
+}        // namespace vkb
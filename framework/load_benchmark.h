@@ -0,0 +1,61 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "gltf_loader.h"
+#include "vulkan_sample.h"
+
+namespace vkb
+{
+/**
+ * @brief Loads a scene a number of times and reports the time spent in each stage of the loads
+ *
+ * Each load uses a new GLTFLoader, and the scene is destroyed before the next load starts.
+ * The stage times of every load, their mean and minimum, the peak staging memory and the peak
+ * resident memory of the process are written to load_benchmark_report.json in the temporary
+ * directory, then the platform is closed.
+ */
+class LoadBenchmark : public VulkanSample
+{
+  public:
+	/**
+	 * @param scene_path Path of the glTF file, relative to the assets
+	 * @param load_count Number of times the scene is loaded
+	 */
+	LoadBenchmark(const std::string &scene_path, uint32_t load_count);
+
+	virtual ~LoadBenchmark() = default;
+
+	virtual bool prepare(Platform &platform) override;
+
+	virtual void update(float delta_time) override;
+
+  private:
+	std::string scene_path;
+
+	uint32_t load_count;
+
+	std::vector<GLTFLoader::LoadStats> load_stats;
+};
+}        // namespace vkb
@@ -0,0 +1,247 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "memory_defragmenter.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "common/error.h"
+#include "common/logging.h"
+#include "common/utils.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "core/image.h"
+#include "core/image_view.h"
+#include "scene_graph/components/image.h"
+#include "scene_graph/scene.h"
+#include "timer.h"
+
+namespace vkb
+{
+MemoryDefragmenter::MemoryDefragmenter(Device &device, uint32_t frames_in_flight, float frame_time_budget, VkDeviceSize frame_byte_budget) :
+    device{device},
+    frames_in_flight{frames_in_flight},
+    frame_time_budget{frame_time_budget},
+    frame_byte_budget{frame_byte_budget}
+{
+}
+
+void MemoryDefragmenter::set_frame_budget(float time_budget, VkDeviceSize byte_budget)
+{
+	frame_time_budget = time_budget;
+	frame_byte_budget = byte_budget;
+}
+
+void MemoryDefragmenter::set_fragmentation_threshold(float threshold)
+{
+	fragmentation_threshold = threshold;
+}
+
+float MemoryDefragmenter::get_fragmentation() const
+{
+	return fragmentation;
+}
+
+void MemoryDefragmenter::update(CommandBuffer &command_buffer, sg::Scene &scene)
+{
+	frame_index++;
+
+	// Release the images no frame in flight samples any more, which frees their block once it is empty
+	retired_images.erase(std::remove_if(retired_images.begin(), retired_images.end(),
+	                                    [this](const RetiredImage &retired) { return retired.release_frame <= frame_index; }),
+	                     retired_images.end());
+
+	if (pass_images.empty())
+	{
+		if (frame_index >= next_check_frame)
+		{
+			next_check_frame = frame_index + CHECK_INTERVAL;
+
+			start_pass(scene);
+		}
+
+		return;
+	}
+
+	Timer timer;
+	timer.start();
+
+	VkDeviceSize moved_size = 0;
+
+	// At least one image is moved per frame, so that images larger than the byte budget are moved too
+	while (!pass_images.empty() && (moved_size == 0 || (moved_size < frame_byte_budget && timer.elapsed<Timer::Milliseconds>() < frame_time_budget)))
+	{
+		auto &image = *pass_images.back();
+		pass_images.pop_back();
+
+		auto size = image.get_vk_image().get_allocation_size();
+
+		if (!move(command_buffer, image))
+		{
+			LOGD("Memory defragmentation: no space left in the other blocks, {} images are not moved", pass_images.size() + 1);
+
+			pass_images.clear();
+			break;
+		}
+
+		moved_size += size;
+	}
+
+	if (pass_images.empty())
+	{
+		pass_block = VK_NULL_HANDLE;
+	}
+}
+
+void MemoryDefragmenter::start_pass(sg::Scene &scene)
+{
+	VmaStats stats;
+	vmaCalculateStats(device.get_memory_allocator(), &stats);
+
+	// A memory type with a single block cannot release any
+	uint32_t memory_type = VK_MAX_MEMORY_TYPES;
+	fragmentation        = 0.0f;
+
+	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i)
+	{
+		auto &type_stats = stats.memoryType[i];
+		auto  block_size = type_stats.usedBytes + type_stats.unusedBytes;
+
+		if (type_stats.blockCount < 2 || block_size == 0)
+		{
+			continue;
+		}
+
+		float type_fragmentation = static_cast<float>(type_stats.unusedBytes) / static_cast<float>(block_size);
+
+		if (type_fragmentation > fragmentation)
+		{
+			fragmentation = type_fragmentation;
+			memory_type   = i;
+		}
+	}
+
+	if (memory_type == VK_MAX_MEMORY_TYPES || fragmentation < fragmentation_threshold)
+	{
+		return;
+	}
+
+	// Size and images of each block of the memory type
+	std::unordered_map<VkDeviceMemory, std::pair<VkDeviceSize, std::vector<sg::Image *>>> blocks;
+
+	for (auto image : scene.get_components<sg::Image>())
+	{
+		auto &vk_image = image->get_vk_image();
+
+		// Partially resident images have no allocation of their own, and only the views of 2D images are swapped
+		if (vk_image.is_sparse() || vk_image.get_memory() == VK_NULL_HANDLE ||
+		    vk_image.get_subresource().arrayLayer != 1 || vk_image.get_extent().depth != 1)
+		{
+			continue;
+		}
+
+		VmaAllocationInfo allocation_info{};
+		vmaGetAllocationInfo(device.get_memory_allocator(), vk_image.get_memory(), &allocation_info);
+
+		if (allocation_info.memoryType == memory_type)
+		{
+			auto &block = blocks[allocation_info.deviceMemory];
+
+			block.first += allocation_info.size;
+			block.second.push_back(image);
+		}
+	}
+
+	// Moving all the images to the block they share would not release anything
+	if (blocks.size() < 2)
+	{
+		return;
+	}
+
+	// The emptiest block is the cheapest to release
+	auto emptiest = std::min_element(blocks.begin(), blocks.end(), [](const std::pair<const VkDeviceMemory, std::pair<VkDeviceSize, std::vector<sg::Image *>>> &a,
+	                                                                  const std::pair<const VkDeviceMemory, std::pair<VkDeviceSize, std::vector<sg::Image *>>> &b) {
+		return a.second.first < b.second.first;
+	});
+
+	pass_block  = emptiest->first;
+	pass_images = std::move(emptiest->second.second);
+
+	LOGI("Memory defragmentation: {:.0f}% of memory type {} is unused, moving {} images out of a block", fragmentation * 100.0f, memory_type, pass_images.size());
+}
+
+bool MemoryDefragmenter::move(CommandBuffer &command_buffer, sg::Image &image)
+{
+	auto &current = image.get_vk_image();
+
+	VmaAllocationInfo allocation_info{};
+
+	// The image may have been replaced since the pass started, e.g. by the texture streamer
+	if (current.is_sparse() || current.get_memory() == VK_NULL_HANDLE)
+	{
+		return true;
+	}
+
+	vmaGetAllocationInfo(device.get_memory_allocator(), current.get_memory(), &allocation_info);
+
+	if (allocation_info.deviceMemory != pass_block)
+	{
+		return true;
+	}
+
+	std::unique_ptr<core::Image> moved;
+
+	try
+	{
+		// Only the free space of the existing blocks is used, the fullest blocks first
+		moved = std::make_unique<core::Image>(device,
+		                                      current.get_extent(),
+		                                      current.get_format(),
+		                                      current.get_usage(),
+		                                      VMA_MEMORY_USAGE_GPU_ONLY,
+		                                      current.get_sample_count(),
+		                                      current.get_subresource().mipLevel,
+		                                      1,
+		                                      current.get_tiling(),
+		                                      VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT);
+	}
+	catch (const VulkanException &)
+	{
+		return false;
+	}
+
+	vmaGetAllocationInfo(device.get_memory_allocator(), moved->get_memory(), &allocation_info);
+
+	// The block being released is the only one with space left
+	if (allocation_info.deviceMemory == pass_block)
+	{
+		return false;
+	}
+
+	copy_sampled_levels(command_buffer, current, 0, *moved, 0, current.get_subresource().mipLevel);
+
+	auto previous = image.replace_vk_image(std::move(moved), image.get_base_mip_level());
+
+	retired_images.push_back({std::move(previous.first), std::move(previous.second), frame_index + frames_in_flight});
+
+	return true;
+}
+}        // namespace vkb
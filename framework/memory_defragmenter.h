@@ -0,0 +1,149 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+
+namespace core
+{
+class Image;
+class ImageView;
+}        // namespace core
+
+namespace sg
+{
+class Image;
+class Scene;
+}        // namespace sg
+
+/**
+ * @brief Compacts the device memory of the scene images over long sessions
+ *
+ * Loading and unloading scenes and evicting texture levels leave holes in the memory blocks of
+ * the allocator, so that new large allocations need new blocks while the old ones stay mostly empty.
+ * Every CHECK_INTERVAL frames the unused part of the blocks of each memory type is measured, and once
+ * it exceeds the fragmentation threshold the images of the emptiest block are moved, a few per
+ * frame, to the free space of the other blocks. The block is released once it no longer holds images.
+ *
+ * Images are moved with a GPU copy recorded before the draws of the frame, and their view is
+ * swapped in the scene. The descriptor sets of the frames are requested from the views of each
+ * frame, so the new view is bound on the next draw and the sets of the old one age out of the
+ * caches. The old image is destroyed once no frame in flight can sample it.
+ */
+class MemoryDefragmenter
+{
+  public:
+	/// Frames between two measures of the fragmentation when no pass is running
+	static constexpr uint32_t CHECK_INTERVAL{300};
+
+	/// Fraction of unused memory in the blocks of a memory type from which a pass starts
+	static constexpr float DEFAULT_FRAGMENTATION_THRESHOLD{0.25f};
+
+	/**
+	 * @param device Device the images are allocated on
+	 * @param frames_in_flight Number of frames which may sample an image after it is moved
+	 * @param frame_time_budget Time in milliseconds each frame may spend recording moves
+	 * @param frame_byte_budget Size in bytes of the images each frame may copy, bounding the GPU time of the moves
+	 */
+	MemoryDefragmenter(Device &device, uint32_t frames_in_flight, float frame_time_budget = 0.5f, VkDeviceSize frame_byte_budget = 16 * 1024 * 1024);
+
+	MemoryDefragmenter(const MemoryDefragmenter &) = delete;
+
+	MemoryDefragmenter(MemoryDefragmenter &&) = delete;
+
+	~MemoryDefragmenter() = default;
+
+	MemoryDefragmenter &operator=(const MemoryDefragmenter &) = delete;
+
+	MemoryDefragmenter &operator=(MemoryDefragmenter &&) = delete;
+
+	void set_frame_budget(float time_budget, VkDeviceSize byte_budget);
+
+	void set_fragmentation_threshold(float threshold);
+
+	/**
+	 * @return Fraction of unused memory in the blocks of the most fragmented memory type, at the last measure
+	 */
+	float get_fragmentation() const;
+
+	/**
+	 * @brief Moves the images of the current pass within the frame budget, to be called once per frame
+	 *        All the images of the scene must have been uploaded and acquired on the graphics queue
+	 * @param command_buffer Graphics command buffer of the frame, recorded before any draw
+	 * @param scene Scene whose images are moved
+	 */
+	void update(CommandBuffer &command_buffer, sg::Scene &scene);
+
+  private:
+	struct RetiredImage
+	{
+		std::unique_ptr<core::Image> image;
+
+		std::unique_ptr<core::ImageView> image_view;
+
+		/// Frame from which no frame in flight samples the image any more
+		uint64_t release_frame;
+	};
+
+	/**
+	 * @brief Measures the fragmentation, and selects the images of the emptiest block of the most fragmented memory type
+	 */
+	void start_pass(sg::Scene &scene);
+
+	/**
+	 * @brief Copies an image to a new allocation in the other blocks, and swaps it in the scene
+	 * @return False if the other blocks have no space left, which ends the pass
+	 */
+	bool move(CommandBuffer &command_buffer, sg::Image &image);
+
+	Device &device;
+
+	uint32_t frames_in_flight;
+
+	float frame_time_budget;
+
+	VkDeviceSize frame_byte_budget;
+
+	float fragmentation_threshold{DEFAULT_FRAGMENTATION_THRESHOLD};
+
+	float fragmentation{0.0f};
+
+	uint64_t frame_index{0};
+
+	uint64_t next_check_frame{0};
+
+	/// Block the images of the current pass are moved out of
+	VkDeviceMemory pass_block{VK_NULL_HANDLE};
+
+	/// Images of the current pass left to move
+	std::vector<sg::Image *> pass_images;
+
+	std::vector<RetiredImage> retired_images;
+};
+}        // namespace vkb
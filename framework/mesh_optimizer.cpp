@@ -0,0 +1,426 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "common/helpers.h"
+
+namespace vkb
+{
+namespace
+{
+/// Size of the LRU cache simulated to score the vertices, larger than the hardware caches on purpose
+constexpr uint32_t SCORING_CACHE_SIZE = 32;
+
+constexpr float CACHE_DECAY_POWER = 1.5f;
+
+/// Score of the vertices of the last triangle, lower than the next ones to avoid strips going back and forth
+constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+
+constexpr float VALENCE_BOOST_SCALE = 2.0f;
+
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+constexpr uint32_t NO_TRIANGLE = std::numeric_limits<uint32_t>::max();
+
+/**
+ * @brief Scores a vertex from its position in the LRU cache and the number of its triangles not emitted yet
+ */
+float score_vertex(int32_t cache_position, uint32_t remaining_valence)
+{
+	if (remaining_valence == 0)
+	{
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+
+	if (cache_position >= 0)
+	{
+		if (cache_position < 3)
+		{
+			score = LAST_TRIANGLE_SCORE;
+		}
+		else
+		{
+			float scaler = 1.0f / (SCORING_CACHE_SIZE - 3);
+			score        = std::pow(1.0f - (cache_position - 3) * scaler, CACHE_DECAY_POWER);
+		}
+	}
+
+	// Vertices with few triangles left are finished first, so that they leave the cache for good
+	score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining_valence), -VALENCE_BOOST_POWER);
+
+	return score;
+}
+
+glm::vec3 read_position(const uint8_t *positions, size_t position_stride, uint32_t index)
+{
+	glm::vec3 position;
+	std::memcpy(&position, positions + index * position_stride, sizeof(glm::vec3));
+
+	return position;
+}
+
+/**
+ * @brief Triangles of a cache optimized list drawn consecutively by optimize_overdraw()
+ */
+struct TriangleCluster
+{
+	size_t first_triangle;
+
+	size_t triangle_count;
+
+	/// How much the cluster faces away from the center of the mesh
+	float sort_key;
+};
+}        // namespace
+
+float compute_acmr(const std::vector<uint32_t> &indices, size_t vertex_count, uint32_t cache_size)
+{
+	size_t triangle_count = indices.size() / 3;
+
+	if (triangle_count == 0)
+	{
+		return 0.0f;
+	}
+
+	// A vertex is still cached if fewer than cache_size vertices were transformed since its own transform
+	std::vector<uint32_t> timestamps(vertex_count, 0);
+	uint32_t              time   = cache_size + 1;
+	size_t                misses = 0;
+
+	for (auto index : indices)
+	{
+		if (time - timestamps[index] > cache_size)
+		{
+			timestamps[index] = time++;
+			misses++;
+		}
+	}
+
+	return static_cast<float>(misses) / static_cast<float>(triangle_count);
+}
+
+void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count)
+{
+	size_t triangle_count = indices.size() / 3;
+
+	if (triangle_count == 0)
+	{
+		return;
+	}
+
+	// Triangles not emitted yet of each vertex, packed in a single array
+	std::vector<uint32_t> valence(vertex_count, 0);
+	for (auto index : indices)
+	{
+		valence[index]++;
+	}
+
+	std::vector<uint32_t> adjacency_offsets(vertex_count + 1, 0);
+	for (size_t vertex = 0; vertex < vertex_count; vertex++)
+	{
+		adjacency_offsets[vertex + 1] = adjacency_offsets[vertex] + valence[vertex];
+	}
+
+	std::vector<uint32_t> adjacency(indices.size());
+	{
+		std::vector<uint32_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			adjacency[fill[indices[i]]++] = to_u32(i / 3);
+		}
+	}
+
+	std::vector<int32_t> cache_positions(vertex_count, -1);
+
+	std::vector<float> vertex_scores(vertex_count);
+	for (size_t vertex = 0; vertex < vertex_count; vertex++)
+	{
+		vertex_scores[vertex] = score_vertex(-1, valence[vertex]);
+	}
+
+	std::vector<float> triangle_scores(triangle_count);
+	for (size_t triangle = 0; triangle < triangle_count; triangle++)
+	{
+		triangle_scores[triangle] = vertex_scores[indices[triangle * 3]] + vertex_scores[indices[triangle * 3 + 1]] + vertex_scores[indices[triangle * 3 + 2]];
+	}
+
+	std::vector<bool> emitted(triangle_count, false);
+
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> new_cache;
+	cache.reserve(SCORING_CACHE_SIZE + 3);
+	new_cache.reserve(SCORING_CACHE_SIZE + 3);
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+
+	uint32_t best_triangle = to_u32(std::max_element(triangle_scores.begin(), triangle_scores.end()) - triangle_scores.begin());
+
+	// Triangles before this one were all emitted
+	size_t next_triangle = 0;
+
+	for (size_t emitted_count = 0; emitted_count < triangle_count; emitted_count++)
+	{
+		if (best_triangle == NO_TRIANGLE)
+		{
+			// No triangle left around the cached vertices, restart from the next triangle not emitted yet
+			while (emitted[next_triangle])
+			{
+				next_triangle++;
+			}
+
+			best_triangle = to_u32(next_triangle);
+		}
+
+		const uint32_t *triangle = &indices[best_triangle * 3];
+
+		output.insert(output.end(), triangle, triangle + 3);
+
+		emitted[best_triangle] = true;
+
+		new_cache.clear();
+
+		for (size_t k = 0; k < 3; k++)
+		{
+			uint32_t vertex = triangle[k];
+
+			// Remove the triangle from the triangles left of its vertices
+			auto begin = adjacency.begin() + adjacency_offsets[vertex];
+			auto end   = begin + valence[vertex];
+			auto it    = std::find(begin, end, best_triangle);
+
+			if (it != end)
+			{
+				std::iter_swap(it, end - 1);
+				valence[vertex]--;
+			}
+
+			// The vertices of the triangle move to the front of the cache
+			if (std::find(new_cache.begin(), new_cache.end(), vertex) == new_cache.end())
+			{
+				new_cache.push_back(vertex);
+			}
+		}
+
+		for (auto vertex : cache)
+		{
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+			{
+				new_cache.push_back(vertex);
+			}
+		}
+
+		// Rescore the cached vertices and those pushed out of the cache, along with their triangles
+		for (size_t i = 0; i < new_cache.size(); i++)
+		{
+			uint32_t vertex = new_cache[i];
+
+			cache_positions[vertex] = i < SCORING_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+
+			float score = score_vertex(cache_positions[vertex], valence[vertex]);
+			float delta = score - vertex_scores[vertex];
+
+			vertex_scores[vertex] = score;
+
+			for (uint32_t j = adjacency_offsets[vertex]; j < adjacency_offsets[vertex] + valence[vertex]; j++)
+			{
+				triangle_scores[adjacency[j]] += delta;
+			}
+		}
+
+		if (new_cache.size() > SCORING_CACHE_SIZE)
+		{
+			new_cache.resize(SCORING_CACHE_SIZE);
+		}
+
+		std::swap(cache, new_cache);
+
+		// The next triangle is the best one around the cached vertices
+		best_triangle    = NO_TRIANGLE;
+		float best_score = -std::numeric_limits<float>::max();
+
+		for (auto vertex : cache)
+		{
+			for (uint32_t j = adjacency_offsets[vertex]; j < adjacency_offsets[vertex] + valence[vertex]; j++)
+			{
+				uint32_t candidate = adjacency[j];
+
+				if (triangle_scores[candidate] > best_score)
+				{
+					best_triangle = candidate;
+					best_score    = triangle_scores[candidate];
+				}
+			}
+		}
+	}
+
+	indices.swap(output);
+}
+
+void optimize_overdraw(std::vector<uint32_t> &indices, const uint8_t *positions, size_t position_stride, size_t vertex_count, float threshold)
+{
+	size_t triangle_count = indices.size() / 3;
+
+	if (triangle_count == 0)
+	{
+		return;
+	}
+
+	float mesh_acmr = compute_acmr(indices, vertex_count);
+
+	// Split the list before the triangles restarting from an empty cache, which costs nothing when drawn in another order
+	std::vector<TriangleCluster> clusters;
+	{
+		std::vector<uint32_t> timestamps(vertex_count, 0);
+		uint32_t              time = DEFAULT_VERTEX_CACHE_SIZE + 1;
+
+		size_t cluster_start  = 0;
+		size_t cluster_misses = 0;
+
+		for (size_t triangle = 0; triangle < triangle_count; triangle++)
+		{
+			uint32_t misses = 0;
+
+			for (size_t k = 0; k < 3; k++)
+			{
+				uint32_t index = indices[triangle * 3 + k];
+
+				if (time - timestamps[index] > DEFAULT_VERTEX_CACHE_SIZE)
+				{
+					timestamps[index] = time++;
+					misses++;
+				}
+			}
+
+			bool within_threshold = cluster_misses <= mesh_acmr * threshold * (triangle - cluster_start);
+
+			if (misses == 3 && triangle > cluster_start && within_threshold)
+			{
+				clusters.push_back({cluster_start, triangle - cluster_start, 0.0f});
+
+				cluster_start  = triangle;
+				cluster_misses = 0;
+			}
+
+			cluster_misses += misses;
+		}
+
+		clusters.push_back({cluster_start, triangle_count - cluster_start, 0.0f});
+	}
+
+	if (clusters.size() == 1)
+	{
+		return;
+	}
+
+	glm::vec3 mesh_centroid{0.0f};
+
+	for (auto index : indices)
+	{
+		mesh_centroid += read_position(positions, position_stride, index);
+	}
+
+	mesh_centroid /= static_cast<float>(indices.size());
+
+	// Clusters facing away from the center are in front of the others from most points of view
+	for (auto &cluster : clusters)
+	{
+		glm::vec3 centroid{0.0f};
+		glm::vec3 normal{0.0f};
+
+		for (size_t triangle = cluster.first_triangle; triangle < cluster.first_triangle + cluster.triangle_count; triangle++)
+		{
+			auto p0 = read_position(positions, position_stride, indices[triangle * 3]);
+			auto p1 = read_position(positions, position_stride, indices[triangle * 3 + 1]);
+			auto p2 = read_position(positions, position_stride, indices[triangle * 3 + 2]);
+
+			centroid += p0 + p1 + p2;
+
+			// Triangles are weighted by their area
+			normal += glm::cross(p1 - p0, p2 - p0);
+		}
+
+		centroid /= static_cast<float>(cluster.triangle_count * 3);
+
+		float normal_length = glm::length(normal);
+
+		cluster.sort_key = normal_length > 0.0f ? glm::dot(centroid - mesh_centroid, normal / normal_length) : 0.0f;
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(),
+	                 [](const TriangleCluster &a, const TriangleCluster &b) { return a.sort_key > b.sort_key; });
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+
+	for (auto &cluster : clusters)
+	{
+		auto first = indices.begin() + cluster.first_triangle * 3;
+
+		output.insert(output.end(), first, first + cluster.triangle_count * 3);
+	}
+
+	indices.swap(output);
+}
+
+std::vector<uint32_t> optimize_vertex_fetch(std::vector<uint32_t> &indices, size_t vertex_count)
+{
+	const uint32_t unused = std::numeric_limits<uint32_t>::max();
+
+	std::vector<uint32_t> remap(vertex_count, unused);
+
+	uint32_t next_vertex = 0;
+
+	for (auto &index : indices)
+	{
+		if (remap[index] == unused)
+		{
+			remap[index] = next_vertex++;
+		}
+
+		index = remap[index];
+	}
+
+	for (auto &new_index : remap)
+	{
+		if (new_index == unused)
+		{
+			new_index = next_vertex++;
+		}
+	}
+
+	return remap;
+}
+}        // namespace vkb
@@ -0,0 +1,74 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief Size of the FIFO post-transform cache the statistics are computed for, a common size on mobile GPUs
+ */
+constexpr uint32_t DEFAULT_VERTEX_CACHE_SIZE = 16;
+
+/**
+ * @brief Computes the average cache miss ratio of an indexed triangle list, the number of vertices
+ *        transformed per triangle by a GPU with a FIFO post-transform cache
+ * @param indices Indices of the triangle list
+ * @param vertex_count Number of vertices the indices refer to
+ * @param cache_size Number of entries of the simulated cache
+ */
+float compute_acmr(const std::vector<uint32_t> &indices, size_t vertex_count, uint32_t cache_size = DEFAULT_VERTEX_CACHE_SIZE);
+
+/**
+ * @brief Reorders the triangles of an indexed triangle list so that they reuse the vertices transformed recently
+ *        Triangles are emitted greedily from the scores of their vertices in a simulated LRU cache,
+ *        following Forsyth's linear-speed vertex cache optimization.
+ * @param indices Indices of the triangle list, reordered in place
+ * @param vertex_count Number of vertices the indices refer to
+ */
+void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count);
+
+/**
+ * @brief Reorders clusters of a cache optimized triangle list so that the triangles facing outwards are
+ *        drawn first, which lets early depth testing reject more of the triangles drawn behind them
+ *        Clusters are split where the vertex cache is flushed, as long as the cache miss ratio of the
+ *        clusters stays within threshold times the one of the whole list.
+ * @param indices Indices of the triangle list, reordered in place
+ * @param positions Float3 positions of the vertices
+ * @param position_stride Stride in bytes of the positions
+ * @param vertex_count Number of vertices the indices refer to
+ * @param threshold Largest increase of the cache miss ratio allowed to reduce overdraw
+ */
+void optimize_overdraw(std::vector<uint32_t> &indices, const uint8_t *positions, size_t position_stride, size_t vertex_count, float threshold = 1.05f);
+
+/**
+ * @brief Computes an order of the vertices matching their first use by the indices, so that vertex fetches
+ *        walk through memory linearly. The indices are rewritten to refer to the new order, and vertices
+ *        not referenced are moved after all the others.
+ * @param indices Indices of the triangle list, remapped in place
+ * @param vertex_count Number of vertices the indices refer to
+ * @return New position of each vertex
+ */
+std::vector<uint32_t> optimize_vertex_fetch(std::vector<uint32_t> &indices, size_t vertex_count);
+}        // namespace vkb
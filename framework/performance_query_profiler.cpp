@@ -0,0 +1,271 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "performance_query_profiler.h"
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+
+#include "common/logging.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "stats.h"
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @brief A counter taken as the closest equivalent of a stat
+ */
+struct CounterMatch
+{
+	StatIndex stat;
+
+	VkPerformanceCounterUnitKHR unit;
+
+	/// Words which must all appear in the name or the category of the counter
+	std::vector<const char *> keywords;
+};
+
+// The specific matches come first, so that a generic match only takes a counter none of them took
+const std::vector<CounterMatch> COUNTER_MATCHES = {
+    {StatIndex::vertex_compute_cycles, VK_PERFORMANCE_COUNTER_UNIT_CYCLES_KHR, {"vertex"}},
+    {StatIndex::fragment_cycles, VK_PERFORMANCE_COUNTER_UNIT_CYCLES_KHR, {"fragment"}},
+    {StatIndex::tiler_cycles, VK_PERFORMANCE_COUNTER_UNIT_CYCLES_KHR, {"tiler"}},
+    {StatIndex::tex_cycles, VK_PERFORMANCE_COUNTER_UNIT_CYCLES_KHR, {"texture"}},
+    {StatIndex::shader_cycles, VK_PERFORMANCE_COUNTER_UNIT_CYCLES_KHR, {"shader"}},
+    {StatIndex::gpu_cycles, VK_PERFORMANCE_COUNTER_UNIT_CYCLES_KHR, {"gpu"}},
+    {StatIndex::gpu_cycles, VK_PERFORMANCE_COUNTER_UNIT_CYCLES_KHR, {}},
+    {StatIndex::l2_ext_read_bytes, VK_PERFORMANCE_COUNTER_UNIT_BYTES_KHR, {"read"}},
+    {StatIndex::l2_ext_write_bytes, VK_PERFORMANCE_COUNTER_UNIT_BYTES_KHR, {"write"}},
+    {StatIndex::input_primitives, VK_PERFORMANCE_COUNTER_UNIT_GENERIC_KHR, {"input", "primitive"}},
+    {StatIndex::culled_primitives, VK_PERFORMANCE_COUNTER_UNIT_GENERIC_KHR, {"cull", "primitive"}},
+    {StatIndex::visible_primitives, VK_PERFORMANCE_COUNTER_UNIT_GENERIC_KHR, {"visible", "primitive"}},
+    {StatIndex::pixels, VK_PERFORMANCE_COUNTER_UNIT_GENERIC_KHR, {"pixel"}},
+    {StatIndex::pixels, VK_PERFORMANCE_COUNTER_UNIT_GENERIC_KHR, {"fragment"}},
+};
+
+std::string to_lower(std::string text)
+{
+	std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return text;
+}
+
+float get_value(const VkPerformanceCounterResultKHR &result, VkPerformanceCounterStorageKHR storage)
+{
+	switch (storage)
+	{
+		case VK_PERFORMANCE_COUNTER_STORAGE_INT32_KHR:
+			return static_cast<float>(result.int32);
+		case VK_PERFORMANCE_COUNTER_STORAGE_INT64_KHR:
+			return static_cast<float>(result.int64);
+		case VK_PERFORMANCE_COUNTER_STORAGE_UINT32_KHR:
+			return static_cast<float>(result.uint32);
+		case VK_PERFORMANCE_COUNTER_STORAGE_UINT64_KHR:
+			return static_cast<float>(result.uint64);
+		case VK_PERFORMANCE_COUNTER_STORAGE_FLOAT32_KHR:
+			return result.float32;
+		case VK_PERFORMANCE_COUNTER_STORAGE_FLOAT64_KHR:
+			return static_cast<float>(result.float64);
+		default:
+			return 0.0f;
+	}
+}
+}        // namespace
+
+PerformanceQueryProfiler::PerformanceQueryProfiler(Device &device) :
+    device{device}
+{
+}
+
+std::set<StatIndex> PerformanceQueryProfiler::enable(const std::set<StatIndex> &stats)
+{
+	counters.clear();
+	query_pool.reset();
+	query_active   = false;
+	query_recorded = false;
+	values.clear();
+
+	if (!device.is_performance_query_enabled() || stats.empty())
+	{
+		return {};
+	}
+
+	uint32_t queue_family_index = device.get_queue_by_role(QueueRole::Graphics).get_family_index();
+
+	uint32_t count = 0;
+	VK_CHECK(vkEnumeratePhysicalDeviceQueueFamilyPerformanceQueryCountersKHR(device.get_physical_device(), queue_family_index, &count, nullptr, nullptr));
+
+	std::vector<VkPerformanceCounterKHR>            available(count, {VK_STRUCTURE_TYPE_PERFORMANCE_COUNTER_KHR});
+	std::vector<VkPerformanceCounterDescriptionKHR> descriptions(count, {VK_STRUCTURE_TYPE_PERFORMANCE_COUNTER_DESCRIPTION_KHR});
+	VK_CHECK(vkEnumeratePhysicalDeviceQueueFamilyPerformanceQueryCountersKHR(device.get_physical_device(), queue_family_index, &count, available.data(), descriptions.data()));
+
+	std::vector<std::string> names(count);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		names[i] = to_lower(std::string{descriptions[i].name} + " " + descriptions[i].category);
+	}
+
+	std::vector<uint32_t> indices;
+	std::set<StatIndex>   matched;
+
+	for (auto &match : COUNTER_MATCHES)
+	{
+		if (!stats.count(match.stat) || matched.count(match.stat))
+		{
+			continue;
+		}
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			// A query of the frame begins and ends outside of the render passes, but a counter of a single command could not be measured by it
+			if (available[i].unit != match.unit || available[i].scope == VK_PERFORMANCE_COUNTER_SCOPE_COMMAND_KHR ||
+			    std::find(indices.begin(), indices.end(), i) != indices.end())
+			{
+				continue;
+			}
+
+			bool found = std::all_of(match.keywords.begin(), match.keywords.end(), [&](const char *keyword) { return names[i].find(keyword) != std::string::npos; });
+			if (found)
+			{
+				indices.push_back(i);
+				counters.push_back({match.stat, available[i].storage});
+				matched.insert(match.stat);
+
+				LOGI("Measuring stat {} with the performance counter {}", static_cast<uint32_t>(match.stat), descriptions[i].name);
+				break;
+			}
+		}
+	}
+
+	VkQueryPoolPerformanceCreateInfoKHR performance_info{VK_STRUCTURE_TYPE_QUERY_POOL_PERFORMANCE_CREATE_INFO_KHR};
+	performance_info.queueFamilyIndex = queue_family_index;
+
+	// Replaying the submissions of a frame for each pass would change what is measured, the last counters are dropped instead
+	while (!indices.empty())
+	{
+		performance_info.counterIndexCount = to_u32(indices.size());
+		performance_info.pCounterIndices   = indices.data();
+
+		uint32_t pass_count = 0;
+		vkGetPhysicalDeviceQueueFamilyPerformanceQueryPassesKHR(device.get_physical_device(), &performance_info, &pass_count);
+
+		if (pass_count <= 1)
+		{
+			break;
+		}
+
+		LOGW("Performance counter for stat {} needs another pass, it is not measured", static_cast<uint32_t>(counters.back().stat));
+		matched.erase(counters.back().stat);
+		indices.pop_back();
+		counters.pop_back();
+	}
+
+	if (indices.empty() || !device.acquire_profiling_lock())
+	{
+		counters.clear();
+		return {};
+	}
+
+	VkQueryPoolCreateInfo info{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+	info.pNext      = &performance_info;
+	info.queryType  = VK_QUERY_TYPE_PERFORMANCE_QUERY_KHR;
+	info.queryCount = 1;
+
+	query_pool = std::make_unique<core::QueryPool>(device, info);
+
+	return matched;
+}
+
+bool PerformanceQueryProfiler::is_enabled() const
+{
+	return query_pool != nullptr;
+}
+
+void PerformanceQueryProfiler::reset(CommandBuffer &command_buffer)
+{
+	if (query_pool)
+	{
+		command_buffer.reset_query_pool(*query_pool, 0, 1);
+	}
+}
+
+void PerformanceQueryProfiler::begin_frame(CommandBuffer &command_buffer)
+{
+	if (!query_pool)
+	{
+		return;
+	}
+
+	command_buffer.begin_query(*query_pool, 0, 0);
+
+	query_active = true;
+}
+
+void PerformanceQueryProfiler::end_frame(CommandBuffer &command_buffer)
+{
+	if (!query_active)
+	{
+		return;
+	}
+
+	command_buffer.end_query(*query_pool, 0);
+
+	query_active   = false;
+	query_recorded = true;
+}
+
+void PerformanceQueryProfiler::resolve()
+{
+	values.clear();
+
+	if (!query_recorded)
+	{
+		return;
+	}
+
+	std::vector<VkPerformanceCounterResultKHR> results(counters.size());
+
+	VkResult result = query_pool->get_results(0, 1,
+	                                          results.size() * sizeof(VkPerformanceCounterResultKHR), results.data(), results.size() * sizeof(VkPerformanceCounterResultKHR),
+	                                          0);
+
+	if (result != VK_SUCCESS)
+	{
+		LOGW("Failed to read back the performance counters: {}", to_string(result));
+	}
+	else
+	{
+		for (size_t i = 0; i < counters.size(); ++i)
+		{
+			values[counters[i].stat] += get_value(results[i], counters[i].storage);
+		}
+	}
+
+	query_recorded = false;
+}
+
+const std::map<StatIndex, float> &PerformanceQueryProfiler::get_values() const
+{
+	return values;
+}
+}        // namespace vkb
@@ -0,0 +1,119 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/query_pool.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+enum class StatIndex;
+
+/**
+ * @brief Reads the hardware counters of the GPU with VK_KHR_performance_query, for the GPUs hwcpipe does not support
+ *
+ * The counters exposed by the driver of the graphics queue family are matched by unit and name to the closest
+ * GPU counter stats. A single query spans the whole primary command buffer of the frame, so only the counters
+ * the device reads in a single pass are used, and not those scoped to single commands. Like the GpuProfiler,
+ * each RenderFrame owns a profiler and reads its query back once the frame is reused.
+ */
+class PerformanceQueryProfiler
+{
+  public:
+	PerformanceQueryProfiler(Device &device);
+
+	PerformanceQueryProfiler(const PerformanceQueryProfiler &) = delete;
+
+	PerformanceQueryProfiler(PerformanceQueryProfiler &&) = default;
+
+	PerformanceQueryProfiler &operator=(const PerformanceQueryProfiler &) = delete;
+
+	PerformanceQueryProfiler &operator=(PerformanceQueryProfiler &&) = delete;
+
+	/**
+	 * @brief Selects the counters closest to the stats and acquires the profiling lock of the device
+	 * @param stats The stats to be measured, replacing those of a previous call
+	 * @return The stats a counter was found for
+	 */
+	std::set<StatIndex> enable(const std::set<StatIndex> &stats);
+
+	/**
+	 * @return Whether counters are measured
+	 */
+	bool is_enabled() const;
+
+	/**
+	 * @brief Resets the query of the frame
+	 * @param command_buffer A command buffer submitted before the one counted, as the query must be its first command
+	 */
+	void reset(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Begins counting, it must be the first command recorded in the primary command buffer of the frame
+	 */
+	void begin_frame(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Ends counting, it must be the last command recorded in the same command buffer
+	 */
+	void end_frame(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Reads back the counters of the frame. The work of the frame must be complete.
+	 */
+	void resolve();
+
+	/**
+	 * @return The value of each counter stat in the frame when it was last resolved, per frame rather than per second
+	 */
+	const std::map<StatIndex, float> &get_values() const;
+
+  private:
+	struct Counter
+	{
+		StatIndex stat;
+
+		VkPerformanceCounterStorageKHR storage;
+	};
+
+	Device &device;
+
+	/// Counters in the order of the indices the query pool was created with
+	std::vector<Counter> counters;
+
+	std::unique_ptr<core::QueryPool> query_pool;
+
+	bool query_active{false};
+
+	/// Whether the query was ended since the frame was last resolved
+	bool query_recorded{false};
+
+	std::map<StatIndex, float> values;
+};
+}        // namespace vkb
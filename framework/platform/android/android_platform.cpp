@@ -21,6 +21,13 @@
 #include "android_platform.h"
 
 #include <chrono>
+#include <cmath>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <time.h>
 #include <unistd.h>
 #include <unordered_map>
 
@@ -37,6 +44,7 @@ VKBP_ENABLE_WARNINGS()
 #include "common/logging.h"
 #include "platform/android/android_window.h"
 #include "platform/input_events.h"
+#include "platform/thread_affinity.h"
 #include "vulkan_sample.h"
 
 extern "C"
@@ -379,13 +387,421 @@ void create_directory(const std::string &path)
 		mkdir(path.c_str(), 0777);
 	}
 }
+
+MappedFile map_file(const std::string &path)
+{
+	int file = open(path.c_str(), O_RDONLY);
+
+	if (file < 0)
+	{
+		throw std::runtime_error("Failed to open file: " + path);
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0)
+	{
+		close(file);
+		throw std::runtime_error("Failed to get the size of file: " + path);
+	}
+
+	auto size = static_cast<size_t>(info.st_size);
+
+	if (size == 0)
+	{
+		close(file);
+		return {};
+	}
+
+	void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+
+	// The mapping keeps its own reference to the file
+	close(file);
+
+	if (data == MAP_FAILED)
+	{
+		throw std::runtime_error("Failed to map file: " + path);
+	}
+
+	return {static_cast<const uint8_t *>(data), size, [data, size]() { munmap(data, size); }};
+}
 }        // namespace fs
 
+namespace
+{
+/// Android returns NaN when the thermal headroom is queried more than once per second
+constexpr std::chrono::seconds THERMAL_HEADROOM_INTERVAL{1};
+
+/// Seconds ahead the thermal headroom is forecast for
+constexpr int THERMAL_HEADROOM_FORECAST{10};
+
+/// Temperatures between which the headroom is estimated from sysfs, throttling being expected at the upper one
+constexpr float SYSFS_IDLE_TEMPERATURE{35.0f};
+
+constexpr float SYSFS_THROTTLING_TEMPERATURE{75.0f};
+
+/**
+ * @brief Reads the temperature of the hottest CPU or GPU thermal zone in sysfs,
+ *        or of the hottest zone if none is named after them
+ * @return The temperature in degrees Celsius, NaN if no zone could be read
+ */
+float read_sysfs_temperature()
+{
+	float max_temperature      = std::numeric_limits<float>::quiet_NaN();
+	float max_core_temperature = std::numeric_limits<float>::quiet_NaN();
+
+	for (uint32_t zone = 0; zone < 64; ++zone)
+	{
+		std::string   zone_path = "/sys/class/thermal/thermal_zone" + std::to_string(zone);
+		std::ifstream temp_file{zone_path + "/temp"};
+
+		// Zones are numbered contiguously
+		if (!temp_file.is_open())
+		{
+			break;
+		}
+
+		long value = 0;
+		if (!(temp_file >> value))
+		{
+			continue;
+		}
+
+		// Most zones report millidegrees, some report degrees
+		float temperature = std::abs(value) > 1000 ? value / 1000.0f : static_cast<float>(value);
+
+		std::string   type;
+		std::ifstream type_file{zone_path + "/type"};
+		type_file >> type;
+
+		if (std::isnan(max_temperature) || temperature > max_temperature)
+		{
+			max_temperature = temperature;
+		}
+
+		bool core = type.find("cpu") != std::string::npos || type.find("gpu") != std::string::npos || type.find("soc") != std::string::npos;
+
+		if (core && (std::isnan(max_core_temperature) || temperature > max_core_temperature))
+		{
+			max_core_temperature = temperature;
+		}
+	}
+
+	return std::isnan(max_core_temperature) ? max_temperature : max_core_temperature;
+}
+}        // namespace
+
+struct AndroidPlatform::ThermalApi
+{
+	using AcquireManager = void *(*) ();
+	using ReleaseManager = void (*)(void *);
+	using GetStatus      = int (*)(void *);
+	using GetHeadroom    = float (*)(void *, int);
+
+	void *library{nullptr};
+
+	void *manager{nullptr};
+
+	ReleaseManager release_manager{nullptr};
+
+	/// Available from Android 11
+	GetStatus get_status{nullptr};
+
+	/// Available from Android 12
+	GetHeadroom get_headroom{nullptr};
+
+	ThermalApi()
+	{
+		library = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+		if (!library)
+		{
+			return;
+		}
+
+		auto acquire_manager = reinterpret_cast<AcquireManager>(dlsym(library, "AThermal_acquireManager"));
+		release_manager      = reinterpret_cast<ReleaseManager>(dlsym(library, "AThermal_releaseManager"));
+		get_status           = reinterpret_cast<GetStatus>(dlsym(library, "AThermal_getCurrentThermalStatus"));
+		get_headroom         = reinterpret_cast<GetHeadroom>(dlsym(library, "AThermal_getThermalHeadroom"));
+
+		if (acquire_manager && release_manager && get_status)
+		{
+			manager = acquire_manager();
+		}
+	}
+
+	~ThermalApi()
+	{
+		if (manager)
+		{
+			release_manager(manager);
+		}
+
+		if (library)
+		{
+			dlclose(library);
+		}
+	}
+};
+
+struct AndroidPlatform::ChoreographerApi
+{
+	using FrameCallbackData = void;
+	using VsyncCallback     = void (*)(const FrameCallbackData *, void *);
+	using FrameCallback64   = void (*)(int64_t, void *);
+	using GetInstance       = void *(*) ();
+	using PostVsyncCallback = void (*)(void *, VsyncCallback, void *);
+	using PostFrameCallback = void (*)(void *, FrameCallback64, void *);
+	using GetTimelineIndex  = size_t (*)(const FrameCallbackData *);
+	using GetDeadline       = int64_t (*)(const FrameCallbackData *, size_t);
+
+	void *library{nullptr};
+
+	void *choreographer{nullptr};
+
+	/// Available from Android 13, gives the deadline of each frame
+	PostVsyncCallback post_vsync_callback{nullptr};
+
+	GetTimelineIndex get_preferred_timeline_index{nullptr};
+
+	GetDeadline get_timeline_deadline{nullptr};
+
+	/// Available from Android 10, the deadline is estimated from the interval between callbacks
+	PostFrameCallback post_frame_callback{nullptr};
+
+	Application *app{nullptr};
+
+	/// Set by the vsync callback, cleared once the frame has been rendered
+	bool frame_due{false};
+
+	int64_t last_frame_time{0};
+
+	ChoreographerApi()
+	{
+		library = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+		if (!library)
+		{
+			return;
+		}
+
+		auto get_instance            = reinterpret_cast<GetInstance>(dlsym(library, "AChoreographer_getInstance"));
+		post_vsync_callback          = reinterpret_cast<PostVsyncCallback>(dlsym(library, "AChoreographer_postVsyncCallback"));
+		get_preferred_timeline_index = reinterpret_cast<GetTimelineIndex>(dlsym(library, "AChoreographerFrameCallbackData_getPreferredFrameTimelineIndex"));
+		get_timeline_deadline        = reinterpret_cast<GetDeadline>(dlsym(library, "AChoreographerFrameCallbackData_getFrameTimelineDeadlineNanos"));
+		post_frame_callback          = reinterpret_cast<PostFrameCallback>(dlsym(library, "AChoreographer_postFrameCallback64"));
+
+		if (!post_vsync_callback || !get_preferred_timeline_index || !get_timeline_deadline)
+		{
+			post_vsync_callback = nullptr;
+		}
+
+		// The Choreographer dispatches its callbacks on the looper of the thread that gets it
+		if (get_instance && (post_vsync_callback || post_frame_callback))
+		{
+			choreographer = get_instance();
+		}
+	}
+
+	~ChoreographerApi()
+	{
+		if (library)
+		{
+			dlclose(library);
+		}
+	}
+
+	/**
+	 * @brief Starts receiving the vsync callbacks, each posting the next one
+	 * @param application The application the frame deadlines are given to
+	 */
+	void start(Application &application)
+	{
+		app = &application;
+		post();
+	}
+
+	void post()
+	{
+		if (post_vsync_callback)
+		{
+			post_vsync_callback(choreographer, on_vsync, this);
+		}
+		else
+		{
+			post_frame_callback(choreographer, on_frame, this);
+		}
+	}
+
+	/**
+	 * @brief Converts a time of CLOCK_MONOTONIC, which the Choreographer uses, to the steady clock
+	 */
+	static std::chrono::steady_clock::time_point to_steady_clock(int64_t monotonic_nanos)
+	{
+		timespec now{};
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		int64_t now_nanos = static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+
+		return std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds{monotonic_nanos - now_nanos});
+	}
+
+	void on_frame_due(int64_t deadline_nanos)
+	{
+		frame_due = true;
+
+		if (deadline_nanos > 0)
+		{
+			app->set_frame_deadline(to_steady_clock(deadline_nanos));
+		}
+
+		post();
+	}
+
+	static void on_vsync(const FrameCallbackData *data, void *user_data)
+	{
+		auto api = reinterpret_cast<ChoreographerApi *>(user_data);
+
+		size_t timeline = api->get_preferred_timeline_index(data);
+
+		api->on_frame_due(api->get_timeline_deadline(data, timeline));
+	}
+
+	static void on_frame(int64_t frame_time_nanos, void *user_data)
+	{
+		auto api = reinterpret_cast<ChoreographerApi *>(user_data);
+
+		// Without frame timelines, the frame is expected to be due by the next vsync
+		int64_t deadline = 0;
+		if (api->last_frame_time != 0)
+		{
+			deadline = frame_time_nanos + (frame_time_nanos - api->last_frame_time);
+		}
+		api->last_frame_time = frame_time_nanos;
+
+		api->on_frame_due(deadline);
+	}
+};
+
+struct AndroidPlatform::PerformanceHintApi
+{
+	using GetManager    = void *(*) ();
+	using CreateSession = void *(*) (void *, const int32_t *, size_t, int64_t);
+	using UpdateTarget  = int (*)(void *, int64_t);
+	using ReportActual  = int (*)(void *, int64_t);
+	using CloseSession  = void (*)(void *);
+
+	void *library{nullptr};
+
+	/// Available from Android 13
+	void *manager{nullptr};
+
+	CreateSession create_session{nullptr};
+
+	UpdateTarget update_target{nullptr};
+
+	ReportActual report_actual{nullptr};
+
+	CloseSession close_session{nullptr};
+
+	void *session{nullptr};
+
+	/// Threads of the session, with the thread running the application first
+	std::vector<int32_t> session_thread_ids;
+
+	int64_t target_nanos{0};
+
+	PerformanceHintApi()
+	{
+		library = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+		if (!library)
+		{
+			return;
+		}
+
+		auto get_manager = reinterpret_cast<GetManager>(dlsym(library, "APerformanceHint_getManager"));
+		create_session   = reinterpret_cast<CreateSession>(dlsym(library, "APerformanceHint_createSession"));
+		update_target    = reinterpret_cast<UpdateTarget>(dlsym(library, "APerformanceHint_updateTargetWorkDuration"));
+		report_actual    = reinterpret_cast<ReportActual>(dlsym(library, "APerformanceHint_reportActualWorkDuration"));
+		close_session    = reinterpret_cast<CloseSession>(dlsym(library, "APerformanceHint_closeSession"));
+
+		if (get_manager && create_session && update_target && report_actual && close_session)
+		{
+			manager = get_manager();
+		}
+	}
+
+	~PerformanceHintApi()
+	{
+		if (session)
+		{
+			close_session(session);
+		}
+
+		if (library)
+		{
+			dlclose(library);
+		}
+	}
+
+	/**
+	 * @brief Reports the CPU work of the last frame, so that the CPU clocks are raised just enough to meet the target
+	 * @param application The application which rendered the frame
+	 * @param thread_id The operating system id of the thread running the application
+	 */
+	void report(Application &application, int32_t thread_id)
+	{
+		auto workload = application.get_frame_workload();
+
+		// Without a target, the frames are expected once per vsync of a 60 Hz display
+		float target_time = workload.target_time > 0.0f ? workload.target_time : 1.0f / 60.0f;
+
+		int64_t target = static_cast<int64_t>(static_cast<double>(target_time) * 1e9);
+
+		std::vector<int32_t> thread_ids{thread_id};
+		thread_ids.insert(thread_ids.end(), workload.thread_ids.begin(), workload.thread_ids.end());
+
+		// The threads of a session are fixed, so it is created again when the job system changes
+		if (!session || thread_ids != session_thread_ids)
+		{
+			if (session)
+			{
+				close_session(session);
+			}
+
+			session = create_session(manager, thread_ids.data(), thread_ids.size(), target);
+			if (!session)
+			{
+				LOGW("Failed to create a performance hint session for {} threads", thread_ids.size());
+				manager = nullptr;
+				return;
+			}
+
+			session_thread_ids = thread_ids;
+			target_nanos       = target;
+		}
+		else if (target != target_nanos)
+		{
+			update_target(session, target);
+			target_nanos = target;
+		}
+
+		if (workload.work_time > 0.0f)
+		{
+			report_actual(session, static_cast<int64_t>(static_cast<double>(workload.work_time) * 1e9));
+		}
+	}
+};
+
 AndroidPlatform::AndroidPlatform(android_app *app) :
-    app{app}
+    app{app},
+    thermal_api{std::make_unique<ThermalApi>()}
 {
+	if (!thermal_api->manager)
+	{
+		LOGI("Android thermal API not available, estimating thermal headroom from sysfs");
+	}
 }
 
+AndroidPlatform::~AndroidPlatform() = default;
+
 bool AndroidPlatform::initialize(std::unique_ptr<Application> &&application)
 {
 	app->onAppCmd                                  = on_app_cmd;
@@ -393,7 +809,34 @@ bool AndroidPlatform::initialize(std::unique_ptr<Application> &&application)
 	app->activity->callbacks->onContentRectChanged = on_content_rect_changed;
 	app->userData                                  = this;
 
-	return Platform::initialize(std::move(application));
+	if (!Platform::initialize(std::move(application)))
+	{
+		return false;
+	}
+
+	performance_hint_api = std::make_unique<PerformanceHintApi>();
+	if (!performance_hint_api->manager)
+	{
+		LOGI("Android performance hint API not available, leaving the CPU clocks to the governor");
+		performance_hint_api.reset();
+	}
+
+	if (active_app->get_options().contains("--choreographer"))
+	{
+		choreographer_api = std::make_unique<ChoreographerApi>();
+
+		if (choreographer_api->choreographer)
+		{
+			choreographer_api->start(*active_app);
+		}
+		else
+		{
+			LOGW("Android Choreographer not available, rendering frames as fast as possible");
+			choreographer_api.reset();
+		}
+	}
+
+	return true;
 }
 
 void AndroidPlatform::create_window()
@@ -411,10 +854,13 @@ void AndroidPlatform::main_loop()
 		int ident;
 		int events;
 
-		while ((ident = ALooper_pollAll(0, nullptr, &events,
-		                                (void **) &source)) >= 0)
+		// Block until the next vsync callback when driven by the Choreographer, which is dispatched by the looper
+		bool wait_for_vsync = choreographer_api && !choreographer_api->frame_due && !window->should_close();
+
+		while ((ident = ALooper_pollOnce(wait_for_vsync ? -1 : 0, nullptr, &events,
+		                                 (void **) &source)) != ALOOPER_POLL_TIMEOUT)
 		{
-			if (source)
+			if (ident >= 0 && source)
 			{
 				source->process(app, source);
 			}
@@ -423,6 +869,13 @@ void AndroidPlatform::main_loop()
 			{
 				break;
 			}
+
+			wait_for_vsync = choreographer_api && !choreographer_api->frame_due && !window->should_close();
+
+			if (ident == ALOOPER_POLL_ERROR || (!wait_for_vsync && ident == ALOOPER_POLL_CALLBACK))
+			{
+				break;
+			}
 		}
 
 		if (app->destroyRequested)
@@ -430,9 +883,19 @@ void AndroidPlatform::main_loop()
 			break;
 		}
 
-		if (!window->should_close())
+		if (!window->should_close() && (!choreographer_api || choreographer_api->frame_due))
 		{
 			run();
+
+			if (performance_hint_api && performance_hint_api->manager && active_app)
+			{
+				performance_hint_api->report(*active_app, get_current_thread_id());
+			}
+
+			if (choreographer_api)
+			{
+				choreographer_api->frame_due = false;
+			}
 		}
 	}
 }
@@ -453,6 +916,53 @@ void AndroidPlatform::terminate(ExitCode code)
 	Platform::terminate(code);
 }
 
+ThermalState AndroidPlatform::get_thermal_state()
+{
+	auto now = std::chrono::steady_clock::now();
+
+	if (now - thermal_state_time < THERMAL_HEADROOM_INTERVAL && thermal_state_time != std::chrono::steady_clock::time_point{})
+	{
+		return thermal_state;
+	}
+
+	thermal_state_time = now;
+	thermal_state      = {};
+
+	thermal_state.temperature = read_sysfs_temperature();
+
+	if (thermal_api->manager)
+	{
+		int status = thermal_api->get_status(thermal_api->manager);
+		if (status >= static_cast<int>(ThermalStatus::None) && status <= static_cast<int>(ThermalStatus::Shutdown))
+		{
+			thermal_state.status = static_cast<ThermalStatus>(status);
+		}
+
+		if (thermal_api->get_headroom)
+		{
+			thermal_state.headroom = thermal_api->get_headroom(thermal_api->manager, THERMAL_HEADROOM_FORECAST);
+		}
+	}
+	else if (!std::isnan(thermal_state.temperature))
+	{
+		thermal_state.headroom = std::max(thermal_state.temperature - SYSFS_IDLE_TEMPERATURE, 0.0f) / (SYSFS_THROTTLING_TEMPERATURE - SYSFS_IDLE_TEMPERATURE);
+	}
+
+	return thermal_state;
+}
+
+size_t AndroidPlatform::get_peak_resident_memory()
+{
+	rusage usage{};
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+	{
+		return 0;
+	}
+
+	// Reported in kilobytes
+	return static_cast<size_t>(usage.ru_maxrss) * 1024;
+}
+
 const char *AndroidPlatform::get_surface_extension()
 {
 	return VK_KHR_ANDROID_SURFACE_EXTENSION_NAME;
@@ -20,6 +20,9 @@
 
 #pragma once
 
+#include <chrono>
+#include <memory>
+
 #include <android_native_app_glue.h>
 
 #include "platform/platform.h"
@@ -31,18 +34,30 @@ class AndroidPlatform : public Platform
   public:
 	AndroidPlatform(android_app *app);
 
-	virtual ~AndroidPlatform() = default;
+	virtual ~AndroidPlatform();
 
 	virtual bool initialize(std::unique_ptr<Application> &&app) override;
 
 	virtual void create_window() override;
 
-	virtual void main_loop() override;
-
 	virtual void terminate(ExitCode code) override;
 
 	virtual const char *get_surface_extension() override;
 
+	/**
+	 * @brief Reads the thermal status and headroom from the thermal API of Android 11 and 12,
+	 *        or estimates the headroom from the temperature sensors in sysfs on older versions
+	 */
+	virtual ThermalState get_thermal_state() override;
+
+	virtual size_t get_peak_resident_memory() override;
+
+	/**
+	 * @brief Drives the frames from the vsync callbacks of the Choreographer if --choreographer
+	 *        is given, otherwise renders as often as the looper is idle
+	 */
+	virtual void main_loop() override;
+
 	/**
 	 * @brief Sends a notification in the task bar
 	 * @param message The message to display
@@ -56,6 +71,26 @@ class AndroidPlatform : public Platform
   private:
 	android_app *app{nullptr};
 
+	/// Functions of the thermal API, loaded from libandroid at runtime as older versions lack them
+	struct ThermalApi;
+
+	std::unique_ptr<ThermalApi> thermal_api;
+
+	/// Last state read, returned when the headroom is queried more often than Android allows
+	ThermalState thermal_state;
+
+	std::chrono::steady_clock::time_point thermal_state_time{};
+
+	/// Functions of the Choreographer, loaded from libandroid at runtime as older versions lack them
+	struct ChoreographerApi;
+
+	std::unique_ptr<ChoreographerApi> choreographer_api;
+
+	/// Functions of the performance hint API, loaded from libandroid at runtime as older versions lack them
+	struct PerformanceHintApi;
+
+	std::unique_ptr<PerformanceHintApi> performance_hint_api;
+
 	std::string log_output;
 
 	virtual std::vector<spdlog::sink_ptr> get_platform_sinks() override;
@@ -20,6 +20,10 @@
 
 #include "application.h"
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
 #include "common/logging.h"
 #include "platform/platform.h"
 
@@ -48,6 +52,8 @@ void Application::step()
 
 	if (benchmark_mode)
 	{
+		benchmark_frame_times.push_back(delta_time);
+
 		// Fix the framerate to 60 FPS for benchmark mode
 		delta_time = 0.01667f;
 	}
@@ -83,6 +89,15 @@ void Application::resize(const uint32_t /*width*/, const uint32_t /*height*/)
 {
 }
 
+void Application::set_frame_deadline(std::chrono::steady_clock::time_point /*deadline*/)
+{
+}
+
+FrameWorkload Application::get_frame_workload()
+{
+	return {};
+}
+
 void Application::input_event(const InputEvent &input_event)
 {
 	if (input_event.get_source() == EventSource::Keyboard)
@@ -132,6 +147,40 @@ const Options &Application::get_options()
 	return options;
 }
 
+void Application::add_benchmark_report(nlohmann::json &report)
+{
+	report["name"] = name;
+
+	if (benchmark_frame_times.empty())
+	{
+		return;
+	}
+
+	std::vector<float> frame_times = benchmark_frame_times;
+	std::sort(frame_times.begin(), frame_times.end());
+
+	// Nearest rank percentiles, in milliseconds
+	auto percentile = [&frame_times](float p) {
+		auto rank = static_cast<size_t>(std::ceil(p * frame_times.size()));
+		return frame_times[std::max<size_t>(rank, 1) - 1] * 1000.0f;
+	};
+
+	float total_time = std::accumulate(frame_times.begin(), frame_times.end(), 0.0f);
+
+	report["frame_time_ms"] = {
+	    {"min", frame_times.front() * 1000.0f},
+	    {"mean", total_time * 1000.0f / frame_times.size()},
+	    {"p50", percentile(0.50f)},
+	    {"p95", percentile(0.95f)},
+	    {"p99", percentile(0.99f)},
+	    {"max", frame_times.back() * 1000.0f}};
+}
+
+void Application::reset_benchmark_frame_times()
+{
+	benchmark_frame_times.clear();
+}
+
 void Application::set_benchmark_mode(bool benchmark_mode_)
 {
 	benchmark_mode = benchmark_mode_;
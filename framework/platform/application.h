@@ -20,7 +20,11 @@
 
 #pragma once
 
+#include <chrono>
 #include <string>
+#include <vector>
+
+#include <json.hpp>
 
 #include "debug_info.h"
 #include "platform/configuration.h"
@@ -32,6 +36,21 @@ namespace vkb
 {
 class Platform;
 
+/**
+ * @brief CPU work of the frames, for the platforms which adjust the CPU clocks to it
+ */
+struct FrameWorkload
+{
+	/// Time in seconds the frames aim for, 0 if unknown
+	float target_time{0.0f};
+
+	/// CPU time in seconds the last frame took, excluding the wait for its pacing, 0 if unknown
+	float work_time{0.0f};
+
+	/// Operating system ids of the threads the frames wait for, other than the thread running the application
+	std::vector<int32_t> thread_ids;
+};
+
 class Application
 {
   public:
@@ -75,6 +94,17 @@ class Application
 	 */
 	virtual void input_event(const InputEvent &input_event);
 
+	/**
+	 * @brief Handles the deadline of the next frame, given by the vsync source driving the frames on platforms which have one
+	 * @param deadline Time by which the next frame must be submitted to be displayed at the next refresh
+	 */
+	virtual void set_frame_deadline(std::chrono::steady_clock::time_point deadline);
+
+	/**
+	 * @return The CPU work of the last frame, queried by the platform after each frame
+	 */
+	virtual FrameWorkload get_frame_workload();
+
 	/**
 	 * @brief Parses the arguments against Application::usage
 	 * @param args The argument list
@@ -101,6 +131,18 @@ class Application
 
 	const Options &get_options();
 
+	/**
+	 * @brief Adds the results of a benchmark run to a report, such as the frame time percentiles
+	 *        Applications can override this to report their own data
+	 * @param report The JSON object written once the benchmark completes
+	 */
+	virtual void add_benchmark_report(nlohmann::json &report);
+
+	/**
+	 * @brief Discards the frame times measured so far, so that the next report covers the following frames only
+	 */
+	void reset_benchmark_frame_times();
+
   protected:
 	float fps{0.0f};
 
@@ -127,5 +169,8 @@ class Application
 
 	// The debug info of the app
 	DebugInfo debug_info{};
+
+	/// Measured time of every frame in benchmark mode, in seconds
+	std::vector<float> benchmark_frame_times;
 };
 }        // namespace vkb
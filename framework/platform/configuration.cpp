@@ -20,6 +20,8 @@
 
 #include "configuration.h"
 
+#include <cassert>
+
 namespace vkb
 {
 BoolSetting::BoolSetting(bool &handle, bool value) :
@@ -106,4 +108,71 @@ void Configuration::insert_setting(uint32_t config_index, std::unique_ptr<Settin
 	configs[config_index][settings.back()->get_type()].push_back(settings.back().get());
 }
 
+void Configuration::add_axis(int &handle, const std::vector<int> &values)
+{
+	std::vector<Setting *> axis;
+
+	for (auto value : values)
+	{
+		settings.push_back(std::make_unique<IntSetting>(handle, value));
+		axis.push_back(settings.back().get());
+	}
+
+	axes.push_back(std::move(axis));
+
+	build_sweep();
+}
+
+void Configuration::add_axis(bool &handle, const std::vector<bool> &values)
+{
+	std::vector<Setting *> axis;
+
+	for (bool value : values)
+	{
+		settings.push_back(std::make_unique<BoolSetting>(handle, value));
+		axis.push_back(settings.back().get());
+	}
+
+	axes.push_back(std::move(axis));
+
+	build_sweep();
+}
+
+void Configuration::build_sweep()
+{
+	configs.clear();
+
+	size_t config_count = 1;
+
+	for (auto &axis : axes)
+	{
+		config_count *= axis.size();
+	}
+
+	for (size_t config_index = 0; config_index < config_count; ++config_index)
+	{
+		size_t remainder = config_index;
+
+		for (auto &axis : axes)
+		{
+			auto setting = axis[remainder % axis.size()];
+			remainder /= axis.size();
+
+			configs[static_cast<uint32_t>(config_index)][setting->get_type()].push_back(setting);
+		}
+	}
+
+	current_configuration = configs.begin();
+}
+
+bool Configuration::empty() const
+{
+	return configs.empty();
+}
+
+uint32_t Configuration::get_current_index() const
+{
+	assert(!configs.empty() && current_configuration != configs.end() && "There is no current configuration");
+	return current_configuration->first;
+}
 }        // namespace vkb
@@ -121,6 +121,29 @@ class Configuration
 	 */
 	void insert_setting(uint32_t config_index, std::unique_ptr<Setting> setting);
 
+	/**
+	 * @brief Adds an axis to sweep, the configurations becoming the cartesian product of all axes
+	 *        The configurations inserted with insert() are replaced.
+	 * @param handle The value set by the axis
+	 * @param values The values taken by the axis
+	 */
+	void add_axis(int &handle, const std::vector<int> &values);
+
+	/**
+	 * @copydoc add_axis(int &, const std::vector<int> &)
+	 */
+	void add_axis(bool &handle, const std::vector<bool> &values = {false, true});
+
+	/**
+	 * @return Whether no setting was inserted
+	 */
+	bool empty() const;
+
+	/**
+	 * @return The index of the current configuration, only valid if not empty and after reset()
+	 */
+	uint32_t get_current_index() const;
+
 	/**
 	 * @brief Inserts a setting into the current configuration
 	 * @param config_index The configuration to insert the setting into
@@ -141,5 +164,13 @@ class Configuration
 	std::vector<std::unique_ptr<Setting>> settings;
 
 	ConfigMap::iterator current_configuration;
+
+	/// Values of each axis, the first axis varying the fastest
+	std::vector<std::vector<Setting *>> axes;
+
+	/**
+	 * @brief Recreates the configurations from the cartesian product of the axes
+	 */
+	void build_sweep();
 };
 }        // namespace vkb
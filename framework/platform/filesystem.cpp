@@ -100,6 +100,20 @@ bool is_directory(const std::string &path)
 	}
 }
 
+bool get_file_stamp(const std::string &path, uint64_t &size, int64_t &modification_time)
+{
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0 || !(info.st_mode & S_IFREG))
+	{
+		return false;
+	}
+
+	size              = static_cast<uint64_t>(info.st_size);
+	modification_time = static_cast<int64_t>(info.st_mtime);
+
+	return true;
+}
+
 void create_path(const std::string &root, const std::string &path)
 {
 	for (auto it = path.begin(); it != path.end(); ++it)
@@ -158,6 +172,77 @@ static void write_binary_file(const std::vector<uint8_t> &data, const std::strin
 	file.close();
 }
 
+MappedFile::MappedFile(const uint8_t *data, size_t size, std::function<void()> &&unmap) :
+    mapped_data{data},
+    mapped_size{size},
+    unmap{std::move(unmap)}
+{
+}
+
+MappedFile::MappedFile(MappedFile &&other) :
+    mapped_data{other.mapped_data},
+    mapped_size{other.mapped_size},
+    unmap{std::move(other.unmap)}
+{
+	other.mapped_data = nullptr;
+	other.mapped_size = 0;
+	other.unmap       = nullptr;
+}
+
+MappedFile::~MappedFile()
+{
+	if (unmap)
+	{
+		unmap();
+	}
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other)
+{
+	if (this != &other)
+	{
+		if (unmap)
+		{
+			unmap();
+		}
+
+		mapped_data = other.mapped_data;
+		mapped_size = other.mapped_size;
+		unmap       = std::move(other.unmap);
+
+		other.mapped_data = nullptr;
+		other.mapped_size = 0;
+		other.unmap       = nullptr;
+	}
+
+	return *this;
+}
+
+const uint8_t *MappedFile::data() const
+{
+	return mapped_data;
+}
+
+size_t MappedFile::size() const
+{
+	return mapped_size;
+}
+
+const uint8_t *MappedFile::begin() const
+{
+	return mapped_data;
+}
+
+const uint8_t *MappedFile::end() const
+{
+	return mapped_data + mapped_size;
+}
+
+MappedFile map_asset(const std::string &filename)
+{
+	return map_file(path::get(path::Type::Assets) + filename);
+}
+
 std::vector<uint8_t> read_asset(const std::string &filename, const uint32_t count)
 {
 	return read_binary_file(path::get(path::Type::Assets) + filename, count);
@@ -23,6 +23,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <fstream>
+#include <functional>
 #include <string>
 #include <sys/stat.h>
 #include <unordered_map>
@@ -72,6 +73,15 @@ const std::string get(const Type type);
  */
 bool is_directory(const std::string &path);
 
+/**
+ * @brief Helper to get the size and last modification time of a file, to tell whether it changed since it was last read
+ * @param path A path to a file
+ * @param size Set to the size of the file in bytes
+ * @param modification_time Set to the time of the last modification of the file, in seconds
+ * @return False if the file could not be found
+ */
+bool get_file_stamp(const std::string &path, uint64_t &size, int64_t &modification_time);
+
 /**
  * @brief Platform specific implementation to create a directory
  * @param path A path to a directory
@@ -85,6 +95,63 @@ void create_directory(const std::string &path);
  */
 void create_path(const std::string &root, const std::string &path);
 
+/**
+ * @brief Read-only view of a file mapped in memory, the file is unmapped when the view is destroyed
+ */
+class MappedFile
+{
+  public:
+	MappedFile() = default;
+
+	/**
+	 * @param data Start of the mapping
+	 * @param size Size of the file in bytes
+	 * @param unmap Function releasing the mapping
+	 */
+	MappedFile(const uint8_t *data, size_t size, std::function<void()> &&unmap);
+
+	MappedFile(const MappedFile &) = delete;
+
+	MappedFile(MappedFile &&other);
+
+	~MappedFile();
+
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	MappedFile &operator=(MappedFile &&other);
+
+	const uint8_t *data() const;
+
+	size_t size() const;
+
+	const uint8_t *begin() const;
+
+	const uint8_t *end() const;
+
+  private:
+	const uint8_t *mapped_data{nullptr};
+
+	size_t mapped_size{0};
+
+	std::function<void()> unmap;
+};
+
+/**
+ * @brief Platform specific implementation to map a file in memory
+ * @param path A path to a file
+ * @throws runtime_error if the file could not be opened or mapped
+ * @return A view of the whole file, empty if the file is empty
+ */
+MappedFile map_file(const std::string &path);
+
+/**
+ * @brief Helper to map an asset file in memory, which loaders can decode from without copying it first
+ *
+ * @param filename The path to the file (relative to the assets directory)
+ * @return A view of the whole file
+ */
+MappedFile map_asset(const std::string &filename);
+
 /**
  * @brief Helper to read an asset file into a byte-array
  *
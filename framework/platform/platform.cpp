@@ -24,13 +24,16 @@
 #include <mutex>
 #include <vector>
 
+#include <spdlog/async.h>
 #include <spdlog/async_logger.h>
 #include <spdlog/details/thread_pool.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/spdlog.h>
 
 #include "common/logging.h"
+#include "cpu_profiler.h"
 #include "platform/filesystem.h"
+#include "platform/thread_affinity.h"
 
 namespace vkb
 {
@@ -40,6 +43,12 @@ std::string Platform::external_storage_directory = "";
 
 std::string Platform::temp_directory = "";
 
+namespace
+{
+/// Messages the logger queues before dropping the oldest ones
+constexpr size_t LOGGER_QUEUE_SIZE = 8192;
+}        // namespace
+
 bool Platform::initialize(std::unique_ptr<Application> &&app)
 {
 	assert(app && "Application is not valid");
@@ -47,7 +56,11 @@ bool Platform::initialize(std::unique_ptr<Application> &&app)
 
 	auto sinks = get_platform_sinks();
 
-	auto logger = std::make_shared<spdlog::logger>("logger", sinks.begin(), sinks.end());
+	// The sinks are written by a background thread, so that a slow sink like logcat never blocks the calling thread.
+	// When the queue is full the oldest messages are dropped instead of waiting for the sinks.
+	spdlog::init_thread_pool(LOGGER_QUEUE_SIZE, 1);
+
+	auto logger = std::make_shared<spdlog::async_logger>("logger", sinks.begin(), sinks.end(), spdlog::thread_pool(), spdlog::async_overflow_policy::overrun_oldest);
 
 #ifdef VKB_DEBUG
 	logger->set_level(spdlog::level::debug);
@@ -56,19 +69,33 @@ bool Platform::initialize(std::unique_ptr<Application> &&app)
 #endif
 
 	logger->set_pattern(LOGGER_FORMAT);
+
+	// Errors often precede a crash, so they are pushed to the sinks right away
+	logger->flush_on(spdlog::level::err);
+
 	spdlog::set_default_logger(logger);
 
 	LOGI("Logger initialized");
 
+	// The thread initializing the platform runs the main loop, which records and submits the frames
+	set_current_thread_role(ThreadRole::Render);
+
 	// Set the app to execute as a benchmark
 	if (active_app->get_options().contains("--benchmark"))
 	{
-		benchmark_mode             = true;
+		// A sweep or a soak runs the benchmark frames for each configuration, the app closes the platform once done
+		benchmark_mode             = !active_app->get_options().contains("--sweep") && !active_app->get_options().contains("--soak");
 		total_benchmark_frames     = active_app->get_options().get_int("--benchmark");
 		remaining_benchmark_frames = total_benchmark_frames;
 		active_app->set_benchmark_mode(true);
 	}
 
+	// Record the CPU scopes, written as a trace when the app terminates
+	if (active_app->get_options().contains("--trace"))
+	{
+		CpuProfiler::get().set_enabled(true);
+	}
+
 	// Set the app as headless
 	active_app->set_headless(active_app->get_options().contains("--headless"));
 
@@ -113,6 +140,18 @@ void Platform::run()
 		{
 			auto time_taken = timer.stop();
 			LOGI("Benchmark completed in {} seconds (ran {} frames, averaged {} fps)", time_taken, total_benchmark_frames, total_benchmark_frames / time_taken);
+
+			nlohmann::json report;
+			report["frames"]      = total_benchmark_frames;
+			report["total_time"]  = time_taken;
+			report["average_fps"] = total_benchmark_frames / time_taken;
+
+			active_app->add_benchmark_report(report);
+
+			std::string report_string = report.dump(4);
+			fs::write_temp({report_string.begin(), report_string.end()}, "benchmark_report.json");
+
+			LOGI("Benchmark report written to benchmark_report.json");
 			close();
 			return;
 		}
@@ -132,10 +171,16 @@ void Platform::terminate(ExitCode code)
 		active_app->finish();
 	}
 
+	if (CpuProfiler::get().is_enabled())
+	{
+		CpuProfiler::get().write_trace("cpu_trace.json");
+	}
+
 	active_app.reset();
 	window.reset();
 
-	spdlog::drop_all();
+	// Writes the queued messages and stops the thread of the logger
+	spdlog::shutdown();
 }
 
 void Platform::close() const
@@ -158,6 +203,16 @@ float Platform::get_dpi_factor() const
 	return 1.0;
 }
 
+ThermalState Platform::get_thermal_state()
+{
+	return {};
+}
+
+size_t Platform::get_peak_resident_memory()
+{
+	return 0;
+}
+
 Application &Platform::get_app() const
 {
 	assert(active_app && "Application is not valid");
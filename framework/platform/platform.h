@@ -28,6 +28,7 @@
 #include "common/vk_common.h"
 #include "platform/application.h"
 #include "platform/filesystem.h"
+#include "platform/thermal.h"
 #include "platform/window.h"
 
 namespace vkb
@@ -96,6 +97,16 @@ class Platform
 	 */
 	virtual float get_dpi_factor() const;
 
+	/**
+	 * @return The thermal state of the device, unknown if the platform does not report it
+	 */
+	virtual ThermalState get_thermal_state();
+
+	/**
+	 * @return The most memory resident for the process since it started in bytes, 0 if the platform does not report it
+	 */
+	virtual size_t get_peak_resident_memory();
+
 	/**
 	 * @return The VkInstance extension name for the platform
 	 */
@@ -0,0 +1,53 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <limits>
+
+namespace vkb
+{
+/**
+ * @brief Thermal status reported by the OS, in order of severity
+ *        The values match the Android thermal status levels
+ */
+enum class ThermalStatus
+{
+	Unknown = -1,
+	None,
+	Light,
+	Moderate,
+	Severe,
+	Critical,
+	Emergency,
+	Shutdown
+};
+
+struct ThermalState
+{
+	ThermalStatus status{ThermalStatus::Unknown};
+
+	/// Forecast fraction of the temperature at which the OS throttles severely, NaN if unavailable
+	float headroom{std::numeric_limits<float>::quiet_NaN()};
+
+	/// Temperature of the hottest sensor in degrees Celsius, NaN if unavailable
+	float temperature{std::numeric_limits<float>::quiet_NaN()};
+};
+}        // namespace vkb
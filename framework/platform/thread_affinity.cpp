@@ -0,0 +1,225 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "thread_affinity.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+#if defined(_WIN32)
+#	ifndef NOMINMAX
+#		define NOMINMAX
+#	endif
+#	include <Windows.h>
+#elif defined(__linux__)
+#	include <pthread.h>
+#	include <sched.h>
+#	include <sys/resource.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
+
+#include "common/logging.h"
+
+namespace vkb
+{
+namespace
+{
+#if defined(__ANDROID__)
+/// Nice value Android gives to the threads drawing the UI, which apps may give to their own threads
+constexpr int RENDER_THREAD_NICE{-4};
+#endif
+
+#if defined(__linux__)
+/// Nice value of background threads, so that they yield to the frame work on the cores they share
+constexpr int BACKGROUND_THREAD_NICE{10};
+
+cpu_set_t to_cpu_set(uint64_t cpu_mask)
+{
+	cpu_set_t cpu_set;
+	CPU_ZERO(&cpu_set);
+
+	for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+	{
+		if (cpu_mask == 0 || (cpu < 64 && (cpu_mask >> cpu) & 1))
+		{
+			CPU_SET(cpu, &cpu_set);
+		}
+	}
+
+	return cpu_set;
+}
+#endif
+
+CpuClusters read_cpu_clusters()
+{
+	CpuClusters clusters;
+
+#if defined(__linux__)
+	uint64_t max_frequency{0};
+	uint64_t min_frequency{0};
+	uint64_t all_mask{0};
+
+	for (uint32_t cpu = 0; cpu < 64; ++cpu)
+	{
+		std::ifstream file{"/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/cpuinfo_max_freq"};
+
+		uint64_t frequency{0};
+
+		if (!(file >> frequency))
+		{
+			continue;
+		}
+
+		if (min_frequency == 0 || frequency < min_frequency)
+		{
+			min_frequency            = frequency;
+			clusters.efficiency_mask = 0;
+		}
+
+		if (frequency == min_frequency)
+		{
+			clusters.efficiency_mask |= uint64_t{1} << cpu;
+		}
+
+		max_frequency = std::max(max_frequency, frequency);
+
+		all_mask |= uint64_t{1} << cpu;
+	}
+
+	// The prime and big clusters of CPUs with three clusters are both performance CPUs
+	clusters.performance_mask = all_mask & ~clusters.efficiency_mask;
+
+	// All the CPUs being alike, there is nothing to choose between
+	if (clusters.performance_mask == 0)
+	{
+		clusters = {};
+	}
+	else
+	{
+		LOGI("CPU clusters: performance {:#x}, efficiency {:#x} ({} to {} MHz)", clusters.performance_mask, clusters.efficiency_mask, min_frequency / 1000, max_frequency / 1000);
+	}
+#endif
+
+	return clusters;
+}
+}        // namespace
+
+const CpuClusters &get_cpu_clusters()
+{
+	static const CpuClusters clusters = read_cpu_clusters();
+
+	return clusters;
+}
+
+uint64_t get_cpu_mask(ThreadRole role)
+{
+	auto &clusters = get_cpu_clusters();
+
+	switch (role)
+	{
+		case ThreadRole::Render:
+		case ThreadRole::Frame:
+			return clusters.performance_mask;
+		case ThreadRole::Background:
+			return clusters.efficiency_mask;
+		default:
+			return 0;
+	}
+}
+
+bool set_thread_affinity(std::thread &thread, uint64_t cpu_mask)
+{
+#if defined(_WIN32)
+	DWORD_PTR mask = cpu_mask == 0 ? static_cast<DWORD_PTR>(-1) : static_cast<DWORD_PTR>(cpu_mask);
+
+	return SetThreadAffinityMask(thread.native_handle(), mask) != 0;
+#elif defined(__linux__)
+	cpu_set_t cpu_set = to_cpu_set(cpu_mask);
+
+#	if defined(__ANDROID__)
+	// Bionic has no pthread_setaffinity_np, the affinity is set through the kernel thread id
+	return sched_setaffinity(pthread_gettid_np(thread.native_handle()), sizeof(cpu_set), &cpu_set) == 0;
+#	else
+	return pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set), &cpu_set) == 0;
+#	endif
+#else
+	(void) thread;
+	(void) cpu_mask;
+	return false;
+#endif
+}
+
+bool set_current_thread_role(ThreadRole role)
+{
+	bool result = true;
+
+#if defined(_WIN32)
+	if (role == ThreadRole::Background)
+	{
+		result = SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL) != 0;
+	}
+#elif defined(__linux__)
+	uint64_t cpu_mask = get_cpu_mask(role);
+
+	if (cpu_mask != 0)
+	{
+		cpu_set_t cpu_set = to_cpu_set(cpu_mask);
+
+		// The nice value and affinity of a thread are set through its kernel thread id, 0 being the calling thread
+		result = sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0;
+	}
+
+	auto thread_id = static_cast<id_t>(syscall(SYS_gettid));
+
+	if (role == ThreadRole::Background)
+	{
+		result = setpriority(PRIO_PROCESS, thread_id, BACKGROUND_THREAD_NICE) == 0 && result;
+	}
+#	if defined(__ANDROID__)
+	else if (role == ThreadRole::Render)
+	{
+		result = setpriority(PRIO_PROCESS, thread_id, RENDER_THREAD_NICE) == 0 && result;
+	}
+#	endif
+#else
+	(void) role;
+#endif
+
+	if (!result)
+	{
+		LOGW("Cannot set the affinity or priority of a thread for its role");
+	}
+
+	return result;
+}
+
+int32_t get_current_thread_id()
+{
+#if defined(_WIN32)
+	return static_cast<int32_t>(GetCurrentThreadId());
+#elif defined(__linux__)
+	return static_cast<int32_t>(syscall(SYS_gettid));
+#else
+	return 0;
+#endif
+}
+}        // namespace vkb
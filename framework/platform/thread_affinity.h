@@ -0,0 +1,86 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <thread>
+
+namespace vkb
+{
+/**
+ * @brief Kind of work a thread does, which decides the CPUs it runs on and its priority
+ */
+enum class ThreadRole
+{
+	/// Thread recording and submitting the frames
+	Render,
+
+	/// Worker the render thread waits for within a frame
+	Frame,
+
+	/// Thread whose work may take several frames or is not latency critical, e.g. asset loading or counter sampling
+	Background
+};
+
+/**
+ * @brief CPUs grouped by cluster, as bit masks indexed by CPU number
+ *        Both masks are 0 on homogeneous CPUs or if the platform cannot tell
+ */
+struct CpuClusters
+{
+	/// CPUs faster than the slowest cluster, the big cores on big.LITTLE CPUs
+	uint64_t performance_mask{0};
+
+	/// CPUs with the lowest maximum frequency, the little cores on big.LITTLE CPUs
+	uint64_t efficiency_mask{0};
+};
+
+/**
+ * @brief Groups the CPUs by their maximum frequency, read from cpufreq in sysfs on Linux and Android
+ *        Read once, as the clusters do not change while running
+ */
+const CpuClusters &get_cpu_clusters();
+
+/**
+ * @return The CPUs the threads of a role should run on, 0 to let them run anywhere
+ */
+uint64_t get_cpu_mask(ThreadRole role);
+
+/**
+ * @brief Restricts a thread to a set of CPUs
+ * @param thread The thread to restrict
+ * @param cpu_mask Bit mask of the CPUs the thread may run on, 0 to allow all of them
+ * @return False if the platform does not support it, or the mask was rejected
+ */
+bool set_thread_affinity(std::thread &thread, uint64_t cpu_mask);
+
+/**
+ * @brief Places the calling thread on the CPUs suiting its role, and lowers the priority of background threads
+ *        Does nothing on homogeneous CPUs, other than the priority
+ * @return False if the affinity or priority could not be set
+ */
+bool set_current_thread_role(ThreadRole role);
+
+/**
+ * @return The operating system id of the calling thread, the kernel thread id on Linux and Android, 0 if unknown
+ */
+int32_t get_current_thread_id();
+}        // namespace vkb
@@ -20,6 +20,11 @@
 
 #include "unix_platform.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
 #include "common/error.h"
 
 VKBP_DISABLE_WARNINGS()
@@ -64,6 +69,43 @@ void create_directory(const std::string &path)
 		mkdir(path.c_str(), 0777);
 	}
 }
+
+MappedFile map_file(const std::string &path)
+{
+	int file = open(path.c_str(), O_RDONLY);
+
+	if (file < 0)
+	{
+		throw std::runtime_error("Failed to open file: " + path);
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0)
+	{
+		close(file);
+		throw std::runtime_error("Failed to get the size of file: " + path);
+	}
+
+	auto size = static_cast<size_t>(info.st_size);
+
+	if (size == 0)
+	{
+		close(file);
+		return {};
+	}
+
+	void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+
+	// The mapping keeps its own reference to the file
+	close(file);
+
+	if (data == MAP_FAILED)
+	{
+		throw std::runtime_error("Failed to map file: " + path);
+	}
+
+	return {static_cast<const uint8_t *>(data), size, [data, size]() { munmap(data, size); }};
+}
 }        // namespace fs
 
 UnixPlatform::UnixPlatform(const UnixType &type, int argc, char **argv) :
@@ -83,4 +125,17 @@ const char *UnixPlatform::get_surface_extension()
 		return VK_KHR_XCB_SURFACE_EXTENSION_NAME;
 	}
 }
+
+size_t UnixPlatform::get_peak_resident_memory()
+{
+	rusage usage{};
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+	{
+		return 0;
+	}
+
+	// Reported in bytes on macOS and in kilobytes on Linux
+	auto peak = static_cast<size_t>(usage.ru_maxrss);
+	return type == UnixType::Mac ? peak : peak * 1024;
+}
 }        // namespace vkb
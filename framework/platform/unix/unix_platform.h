@@ -39,6 +39,8 @@ class UnixPlatform : public DesktopPlatform
 
 	virtual const char *get_surface_extension() override;
 
+	virtual size_t get_peak_resident_memory() override;
+
   private:
 	UnixType type;
 };
@@ -22,6 +22,7 @@
 
 #include <Windows.h>
 #include <iostream>
+#include <psapi.h>
 #include <shellapi.h>
 #include <stdexcept>
 
@@ -105,6 +106,49 @@ void create_directory(const std::string &path)
 		CreateDirectory(path.c_str(), NULL);
 	}
 }
+
+MappedFile map_file(const std::string &path)
+{
+	HANDLE file = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error("Failed to open file: " + path);
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		throw std::runtime_error("Failed to get the size of file: " + path);
+	}
+
+	if (size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return {};
+	}
+
+	HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+
+	if (mapping == NULL)
+	{
+		throw std::runtime_error("Failed to map file: " + path);
+	}
+
+	void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+	// The view keeps its own reference to the mapping
+	CloseHandle(mapping);
+
+	if (data == NULL)
+	{
+		throw std::runtime_error("Failed to map file: " + path);
+	}
+
+	return {static_cast<const uint8_t *>(data), static_cast<size_t>(size.QuadPart), [data]() { UnmapViewOfFile(data); }};
+}
 }        // namespace fs
 
 WindowsPlatform::WindowsPlatform(HINSTANCE hInstance, HINSTANCE hPrevInstance,
@@ -139,4 +183,15 @@ const char *WindowsPlatform::get_surface_extension()
 {
 	return VK_KHR_WIN32_SURFACE_EXTENSION_NAME;
 }
+
+size_t WindowsPlatform::get_peak_resident_memory()
+{
+	PROCESS_MEMORY_COUNTERS counters{};
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return 0;
+	}
+
+	return counters.PeakWorkingSetSize;
+}
 }        // namespace vkb
@@ -35,5 +35,7 @@ class WindowsPlatform : public DesktopPlatform
 	virtual void terminate(ExitCode code) override;
 
 	virtual const char *get_surface_extension() override;
+
+	virtual size_t get_peak_resident_memory() override;
 };
 }        // namespace vkb
@@ -0,0 +1,141 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "rendering/bloom_pass.h"
+
+#include "common/glm_common.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+
+namespace vkb
+{
+namespace
+{
+/// Bloom texel, rgb as half floats
+struct BloomTexel
+{
+	uint32_t red_green;
+
+	uint32_t blue;
+};
+
+struct BloomParameters
+{
+	VkExtent2D extent;
+
+	glm::vec2 inv_extent;
+
+	glm::vec2 threshold;
+};
+
+uint32_t get_downsampled_size(uint32_t size, uint32_t downsampling)
+{
+	return (size + downsampling - 1) / downsampling;
+}
+}        // namespace
+
+constexpr uint32_t BloomPass::GROUP_SIZE;
+
+constexpr uint32_t BloomPass::MIN_DOWNSAMPLING;
+
+BloomPass::BloomPass(RenderContext &render_context, ShaderSource &&compute_shader, uint32_t hdr_attachment) :
+    ComputePass{render_context, std::move(compute_shader)},
+    hdr_attachment{hdr_attachment}
+{
+	// The render graph records barriers against this buffer, so it is created once for the surface size
+	auto surface_extent = render_context.get_surface_extent();
+
+	capacity = get_downsampled_size(surface_extent.width, MIN_DOWNSAMPLING) * get_downsampled_size(surface_extent.height, MIN_DOWNSAMPLING);
+
+	buffer = std::make_unique<core::Buffer>(render_context.get_device(), capacity * sizeof(BloomTexel), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+
+	set_debug_name("bloom");
+}
+
+void BloomPass::prepare()
+{
+	ComputePass::prepare();
+
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.maxAnisotropy = 1.0f;
+	sampler_info.magFilter     = VK_FILTER_LINEAR;
+	sampler_info.minFilter     = VK_FILTER_LINEAR;
+	sampler_info.mipmapMode    = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+	sampler = std::make_unique<core::Sampler>(get_render_context().get_device(), sampler_info);
+}
+
+void BloomPass::dispatch(CommandBuffer &command_buffer)
+{
+	auto &render_target = get_render_context().get_active_frame().get_render_target();
+
+	const auto &target_extent = render_target.get_extent();
+
+	uint32_t downsampling = MIN_DOWNSAMPLING;
+
+	do
+	{
+		extent = {get_downsampled_size(target_extent.width, downsampling), get_downsampled_size(target_extent.height, downsampling)};
+
+		downsampling *= 2;
+	} while (extent.width * extent.height > capacity);
+
+	// The previous frame may still be reading the buffer
+	BufferMemoryBarrier barrier{};
+	barrier.src_stage_mask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	barrier.dst_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+	command_buffer.buffer_memory_barrier(*buffer, 0, VK_WHOLE_SIZE, barrier);
+
+	bind_pipeline(command_buffer);
+
+	bind_image(command_buffer, "hdr_color", render_target.get_views().at(hdr_attachment), *sampler);
+
+	bind_buffer(command_buffer, "Bloom", *buffer, 0, buffer->get_size());
+
+	BloomParameters parameters;
+	parameters.extent     = extent;
+	parameters.inv_extent = {1.0f / extent.width, 1.0f / extent.height};
+	parameters.threshold  = {threshold, knee};
+
+	command_buffer.push_constants(0, parameters);
+
+	command_buffer.dispatch(get_group_count(extent.width, GROUP_SIZE), get_group_count(extent.height, GROUP_SIZE), 1);
+}
+
+const core::Buffer &BloomPass::get_buffer() const
+{
+	return *buffer;
+}
+
+const VkExtent2D &BloomPass::get_extent() const
+{
+	return extent;
+}
+
+void BloomPass::set_threshold(float threshold_, float knee_)
+{
+	threshold = threshold_;
+	knee      = knee_;
+}
+}        // namespace vkb
@@ -0,0 +1,80 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "core/buffer.h"
+#include "core/sampler.h"
+#include "rendering/compute_pass.h"
+
+namespace vkb
+{
+/**
+ * @brief Blurs the bright pixels of an HDR color attachment at a reduced resolution in a compute shader
+ *        Bloom needs the neighborhood of each pixel, which cannot be read from tile memory, so it samples
+ *        the stored attachment and writes a small storage buffer the tonemapping subpass adds back
+ */
+class BloomPass : public ComputePass
+{
+  public:
+	BloomPass(RenderContext &render_context, ShaderSource &&compute_shader, uint32_t hdr_attachment);
+
+	virtual void prepare() override;
+
+	virtual void dispatch(CommandBuffer &command_buffer) override;
+
+	/**
+	 * @return The buffer of bloom texels, to declare to the render graph
+	 */
+	const core::Buffer &get_buffer() const;
+
+	/**
+	 * @return Resolution of the bloom in the last dispatch
+	 */
+	const VkExtent2D &get_extent() const;
+
+	/**
+	 * @param threshold Brightness above which pixels bloom
+	 * @param knee Width of the transition around the threshold
+	 */
+	void set_threshold(float threshold, float knee);
+
+  private:
+	static constexpr uint32_t GROUP_SIZE{8};
+
+	/// Bloom resolution divider, increased when the render target outgrows the buffer
+	static constexpr uint32_t MIN_DOWNSAMPLING{4};
+
+	uint32_t hdr_attachment;
+
+	/// Texels the buffer can hold
+	uint32_t capacity;
+
+	std::unique_ptr<core::Buffer> buffer;
+
+	std::unique_ptr<core::Sampler> sampler;
+
+	VkExtent2D extent{};
+
+	float threshold{1.0f};
+
+	float knee{0.5f};
+};
+}        // namespace vkb
@@ -0,0 +1,351 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "rendering/cascaded_shadow_map.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+VKBP_DISABLE_WARNINGS()
+#include <glm/gtc/matrix_transform.hpp>
+VKBP_ENABLE_WARNINGS()
+
+#include "core/command_buffer.h"
+#include "rendering/render_context.h"
+#include "rendering/subpasses/shadow_subpass.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "scene_graph/components/skin.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/frustum.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace
+{
+/// Fraction of its radius a cascade is padded by, so that it can be reused while the camera moves
+constexpr float CASCADE_PADDING = 0.15f;
+
+/// Format of the atlas, which every device supports as a sampled depth attachment
+constexpr VkFormat SHADOW_ATLAS_FORMAT = VK_FORMAT_D16_UNORM;
+}        // namespace
+
+CascadedShadowMap::CascadedShadowMap(RenderContext &render_context, sg::Scene &scene, sg::Light &light) :
+    render_context{render_context},
+    scene{scene},
+    light{light}
+{
+	auto &device     = render_context.get_device();
+	auto &properties = light.get_shadow_properties();
+
+	uint32_t cascade_count = std::max(1u, std::min(properties.cascade_count, static_cast<uint32_t>(MAX_SHADOW_CASCADES)));
+
+	// The cascades are laid out side by side in the atlas
+	resolution = std::max(1u, std::min(properties.resolution, device.get_properties().limits.maxImageDimension2D / cascade_count));
+
+	cascades.resize(cascade_count);
+
+	std::vector<core::Image> images;
+	images.emplace_back(device,
+	                    VkExtent3D{resolution * cascade_count, resolution, 1},
+	                    SHADOW_ATLAS_FORMAT,
+	                    VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+	                    VMA_MEMORY_USAGE_GPU_ONLY);
+
+	atlas = std::make_unique<RenderTarget>(std::move(images));
+
+	// The reused cascades are kept by beginning the render pass in the layout they were drawn with
+	atlas->set_layout(0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+
+	// Filtering the comparisons gives a 2x2 percentage closer filter for each tap
+	bool linear = (device.get_format_properties(SHADOW_ATLAS_FORMAT).optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0;
+
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.magFilter     = linear ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+	sampler_info.minFilter     = sampler_info.magFilter;
+	sampler_info.mipmapMode    = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.maxAnisotropy = 1.0f;
+	sampler_info.compareEnable = VK_TRUE;
+	// Reversed depth, a fragment is lit if it is at least as close to the light as the caster
+	sampler_info.compareOp   = VK_COMPARE_OP_GREATER_OR_EQUAL;
+	sampler_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+
+	sampler = std::make_unique<core::Sampler>(device, sampler_info);
+
+	subpasses.push_back(std::make_unique<ShadowSubpass>(render_context, *this));
+	subpasses.back()->prepare();
+
+	auto &lights      = scene.get_components<sg::Light>();
+	auto  light_index = std::find(lights.begin(), lights.end(), &light) - lights.begin();
+
+	uniform.cascade_info = glm::vec4{static_cast<float>(cascade_count), static_cast<float>(light_index), 1.0f / static_cast<float>(resolution), 0.0f};
+}
+
+void CascadedShadowMap::update(sg::PerspectiveCamera &camera)
+{
+	const auto &properties = light.get_shadow_properties();
+
+	glm::vec3 direction = glm::normalize(light.get_node()->get_transform().get_rotation() * light.get_properties().direction);
+	glm::vec3 up        = std::abs(direction.y) > 0.99f ? glm::vec3{1.0f, 0.0f, 0.0f} : glm::vec3{0.0f, 1.0f, 0.0f};
+
+	// Light space only rotates the world, so that cascade centers can be snapped to texels
+	glm::mat4 light_view = glm::lookAt(glm::vec3{0.0f}, direction, up);
+
+	// Casters between the light and a cascade must be kept, down to the nearest point of the scene
+	float scene_near = std::numeric_limits<float>::max();
+
+	for (auto mesh : scene.get_components<sg::Mesh>())
+	{
+		mesh->update_world_bounds();
+
+		for (size_t node_index = 0; node_index < mesh->get_nodes().size(); ++node_index)
+		{
+			const sg::AABB &bounds = mesh->get_world_bounds(node_index);
+
+			for (uint32_t corner = 0; corner < 8; ++corner)
+			{
+				glm::vec3 position{corner & 1 ? bounds.get_max().x : bounds.get_min().x,
+				                   corner & 2 ? bounds.get_max().y : bounds.get_min().y,
+				                   corner & 4 ? bounds.get_max().z : bounds.get_min().z};
+
+				scene_near = std::min(scene_near, -(light_view * glm::vec4(position, 1.0f)).z);
+			}
+		}
+	}
+
+	glm::mat4 camera_world = camera.get_node()->get_transform().get_world_matrix();
+
+	float near_plane = camera.get_near_plane();
+	float far_plane  = std::max(near_plane, std::min(camera.get_far_plane(), properties.max_distance));
+
+	// Squared distance from the view axis to the frustum corners, for a unit depth
+	float tan_half_height = std::tan(camera.get_field_of_view() * 0.5f);
+	float tan_half_width  = tan_half_height * camera.get_aspect_ratio();
+	float corner_spread   = tan_half_width * tan_half_width + tan_half_height * tan_half_height;
+
+	const glm::mat4 texture_bias = glm::translate(glm::mat4{1.0f}, glm::vec3{0.5f, 0.5f, 0.0f}) * glm::scale(glm::mat4{1.0f}, glm::vec3{0.5f, 0.5f, 1.0f});
+
+	float split_near = near_plane;
+
+	for (size_t i = 0; i < cascades.size(); ++i)
+	{
+		auto &cascade = cascades[i];
+
+		float fraction      = static_cast<float>(i + 1) / static_cast<float>(cascades.size());
+		float log_split     = near_plane * std::pow(far_plane / near_plane, fraction);
+		float uniform_split = near_plane + (far_plane - near_plane) * fraction;
+		float split_far     = properties.split_lambda * log_split + (1.0f - properties.split_lambda) * uniform_split;
+
+		// Smallest sphere through the corners of the slice, its center is on the view axis
+		float center_depth = std::min(0.5f * (split_near + split_far) * (1.0f + corner_spread), split_far);
+		float radius       = std::sqrt((split_far - center_depth) * (split_far - center_depth) + split_far * split_far * corner_spread);
+
+		split_near = split_far;
+
+		glm::vec3 center        = glm::vec3(light_view * camera_world * glm::vec4(0.0f, 0.0f, -center_depth, 1.0f));
+		float     padded_radius = radius * (1.0f + CASCADE_PADDING);
+
+		// Keep the cascade where it is as long as it covers the slice and is not much larger than needed
+		bool covered = cascade.radius > 0.0f &&
+		               glm::distance(center, cascade.center) + radius <= cascade.radius &&
+		               cascade.radius <= padded_radius * (1.0f + CASCADE_PADDING);
+
+		if (!covered)
+		{
+			float texel_size = 2.0f * padded_radius / static_cast<float>(resolution);
+
+			cascade.center = glm::vec3{glm::floor(glm::vec2{center} / texel_size) * texel_size, center.z};
+			cascade.radius = padded_radius;
+		}
+
+		float sphere_distance = -cascade.center.z;
+
+		cascade.near_distance = std::min(scene_near, sphere_distance - cascade.radius);
+
+		// Reversed depth as for the camera, the near plane is mapped to 1
+		glm::mat4 projection = glm::ortho(cascade.center.x - cascade.radius, cascade.center.x + cascade.radius,
+		                                  cascade.center.y - cascade.radius, cascade.center.y + cascade.radius,
+		                                  sphere_distance + cascade.radius, cascade.near_distance);
+
+		glm::mat4 view_proj = vulkan_style_projection(projection) * light_view;
+
+		if (view_proj != cascade.view_proj)
+		{
+			cascade.view_proj = view_proj;
+			cascade.dirty     = true;
+		}
+
+		update_casters(cascade);
+
+		uniform.light_matrices[i] = texture_bias * cascade.view_proj;
+	}
+}
+
+void CascadedShadowMap::update_casters(Cascade &cascade)
+{
+	sg::Frustum frustum{cascade.view_proj};
+
+	cascade.casters.clear();
+
+	if (scene.has_component<sg::BVH>())
+	{
+		auto &bvh = *scene.get_components<sg::BVH>().front();
+		bvh.update();
+
+		bvh.query(frustum, cascade.casters);
+	}
+	else
+	{
+		for (auto mesh : scene.get_components<sg::Mesh>())
+		{
+			for (size_t node_index = 0; node_index < mesh->get_nodes().size(); ++node_index)
+			{
+				if (frustum.intersects(mesh->get_world_bounds(node_index)))
+				{
+					cascade.casters.push_back({mesh, node_index});
+				}
+			}
+		}
+	}
+
+	// Skinned vertices are moved by the joints, which the depth only vertex shader does not apply
+	cascade.casters.erase(std::remove_if(cascade.casters.begin(), cascade.casters.end(),
+	                                     [](const sg::BVHItem &item) { return item.mesh->get_nodes()[item.node_index]->has_component<sg::Skin>(); }),
+	                      cascade.casters.end());
+
+	size_t signature{0};
+
+	for (auto &item : cascade.casters)
+	{
+		hash_combine(signature, item.mesh);
+		hash_combine(signature, item.node_index);
+		hash_combine(signature, item.mesh->get_nodes()[item.node_index]->get_transform().get_world_matrix_revision());
+	}
+
+	if (signature != cascade.caster_signature)
+	{
+		cascade.caster_signature = signature;
+		cascade.dirty            = true;
+	}
+}
+
+void CascadedShadowMap::draw(CommandBuffer &command_buffer)
+{
+	redrawn_cascade_count = to_u32(std::count_if(cascades.begin(), cascades.end(), [](const Cascade &cascade) { return cascade.dirty; }));
+
+	if (redrawn_cascade_count == 0)
+	{
+		return;
+	}
+
+	auto &atlas_view = atlas->get_views().at(0);
+
+	{
+		// Wait for the previous frames to be done sampling the atlas
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = atlas_layout;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		command_buffer.image_memory_barrier(atlas_view, memory_barrier);
+	}
+
+	// Loading the atlas is only needed to keep the reused cascades, the dirty ones are cleared by the subpass
+	LoadStoreInfo load_store{};
+	load_store.load_op  = redrawn_cascade_count == cascades.size() ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+	load_store.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+
+	VkClearValue clear_value{};
+	clear_value.depthStencil = {0.0f, ~0U};
+
+	command_buffer.begin_debug_label("Shadow map");
+
+	command_buffer.begin_render_pass(*atlas, {load_store}, {clear_value}, subpasses);
+
+	subpasses.front()->draw(command_buffer);
+
+	command_buffer.end_render_pass();
+
+	command_buffer.end_debug_label();
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		memory_barrier.src_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+
+		command_buffer.image_memory_barrier(atlas_view, memory_barrier);
+	}
+
+	atlas_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	for (auto &cascade : cascades)
+	{
+		cascade.dirty = false;
+	}
+}
+
+sg::Light &CascadedShadowMap::get_light()
+{
+	return light;
+}
+
+uint32_t CascadedShadowMap::get_resolution() const
+{
+	return resolution;
+}
+
+const std::vector<CascadedShadowMap::Cascade> &CascadedShadowMap::get_cascades() const
+{
+	return cascades;
+}
+
+const ShadowUniform &CascadedShadowMap::get_uniform() const
+{
+	return uniform;
+}
+
+const core::ImageView &CascadedShadowMap::get_atlas_view() const
+{
+	return atlas->get_views().at(0);
+}
+
+const core::Sampler &CascadedShadowMap::get_sampler() const
+{
+	return *sampler;
+}
+
+uint32_t CascadedShadowMap::get_redrawn_cascade_count() const
+{
+	return redrawn_cascade_count;
+}
+}        // namespace vkb
@@ -0,0 +1,163 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/sampler.h"
+#include "rendering/render_target.h"
+#include "rendering/subpass.h"
+#include "scene_graph/components/bvh.h"
+
+#define MAX_SHADOW_CASCADES 4
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+namespace sg
+{
+class Light;
+class PerspectiveCamera;
+class Scene;
+}        // namespace sg
+
+struct alignas(16) ShadowUniform
+{
+	/// Transforms from world space to the texture coordinates (xy) and depth (z) of each cascade
+	glm::mat4 light_matrices[MAX_SHADOW_CASCADES];
+
+	glm::vec4 cascade_info;        // x represents cascade count, y represents the index of the light, z represents the size of a texel
+};
+
+/**
+ * @brief Cascaded shadow map of a directional light
+ *
+ * The view frustum of the camera is split in slices, distributed between uniform and logarithmic
+ * splits, and each slice is covered by a cascade whose orthographic projection bounds a sphere around it.
+ * Spheres keep the size of a cascade constant as the camera rotates, and their centers are snapped to
+ * texels, so that shadow edges do not shimmer. The cascades are tiles of a single depth atlas.
+ *
+ * Cascades are only redrawn when needed: the sphere of a cascade is padded so that it keeps covering
+ * its slice while the camera moves a little, and a cascade is reused until its projection changes or
+ * the world matrices of the casters under it do. A scene whose light and casters do not move only
+ * redraws the cascades the camera moved out of.
+ */
+class CascadedShadowMap
+{
+  public:
+	struct Cascade
+	{
+		/// Transforms from world space to the clip space of the cascade
+		glm::mat4 view_proj{1.0f};
+
+		/// Center of the padded sphere covered by the cascade, in light space
+		glm::vec3 center{0.0f};
+
+		/// Radius of the padded sphere
+		float radius{0.0f};
+
+		/// Distance from the origin of light space along the light direction to the near plane
+		float near_distance{0.0f};
+
+		/// Opaque casters whose bounds intersect the cascade
+		std::vector<sg::BVHItem> casters;
+
+		/// Hash of the casters and of their world matrix revisions
+		size_t caster_signature{0};
+
+		/// Whether the cascade must be redrawn by the next draw()
+		bool dirty{true};
+	};
+
+	/**
+	 * @brief Creates the atlas and the subpass drawing the cascades
+	 * @param render_context Render context
+	 * @param scene Scene casting the shadows
+	 * @param light Directional light, its shadow properties give the cascade count and resolution
+	 */
+	CascadedShadowMap(RenderContext &render_context, sg::Scene &scene, sg::Light &light);
+
+	/**
+	 * @brief Fits the cascades to the view frustum of the camera and finds the ones to redraw
+	 * @param camera Camera the shadows are seen from
+	 */
+	void update(sg::PerspectiveCamera &camera);
+
+	/**
+	 * @brief Records the render pass which redraws the dirty cascades, if there are any
+	 *        It must be recorded outside of a render pass, and leaves the atlas ready to be sampled by fragment shaders
+	 * @param command_buffer Command buffer to record to
+	 */
+	void draw(CommandBuffer &command_buffer);
+
+	sg::Light &get_light();
+
+	uint32_t get_resolution() const;
+
+	const std::vector<Cascade> &get_cascades() const;
+
+	const ShadowUniform &get_uniform() const;
+
+	const core::ImageView &get_atlas_view() const;
+
+	/**
+	 * @return Sampler comparing depths against the atlas
+	 */
+	const core::Sampler &get_sampler() const;
+
+	/**
+	 * @return Number of cascades redrawn by the last draw()
+	 */
+	uint32_t get_redrawn_cascade_count() const;
+
+  private:
+	void update_casters(Cascade &cascade);
+
+	RenderContext &render_context;
+
+	sg::Scene &scene;
+
+	sg::Light &light;
+
+	uint32_t resolution{0};
+
+	std::vector<Cascade> cascades;
+
+	ShadowUniform uniform{};
+
+	std::unique_ptr<RenderTarget> atlas;
+
+	VkImageLayout atlas_layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+	std::unique_ptr<core::Sampler> sampler;
+
+	/// Depth only subpass, in a vector as render passes are begun from a list of subpasses
+	std::vector<std::unique_ptr<Subpass>> subpasses;
+
+	uint32_t redrawn_cascade_count{0};
+};
+}        // namespace vkb
@@ -0,0 +1,107 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "rendering/compute_pass.h"
+
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "core/pipeline_layout.h"
+
+namespace vkb
+{
+ComputePass::ComputePass(RenderContext &render_context, ShaderSource &&compute_source) :
+    render_context{render_context},
+    compute_shader{std::move(compute_source)},
+    debug_name{compute_shader.get_filename()}
+{
+}
+
+void ComputePass::prepare()
+{
+	render_context.get_device().get_resource_cache().request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, compute_shader);
+}
+
+RenderContext &ComputePass::get_render_context()
+{
+	return render_context;
+}
+
+const ShaderSource &ComputePass::get_compute_shader() const
+{
+	return compute_shader;
+}
+
+const std::string &ComputePass::get_debug_name() const
+{
+	return debug_name;
+}
+
+void ComputePass::set_debug_name(const std::string &name)
+{
+	debug_name = name;
+}
+
+uint32_t ComputePass::get_group_count(uint32_t invocation_count, uint32_t group_size)
+{
+	return (invocation_count + group_size - 1) / group_size;
+}
+
+const PipelineLayout &ComputePass::bind_pipeline(CommandBuffer &command_buffer, const ShaderVariant &shader_variant)
+{
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	auto &shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, compute_shader, shader_variant);
+	auto &layout        = resource_cache.request_pipeline_layout({&shader_module}, false);
+
+	command_buffer.bind_pipeline_layout(layout);
+
+	pipeline_layout = &layout;
+
+	return layout;
+}
+
+void ComputePass::bind_buffer(CommandBuffer &command_buffer, const std::string &name, const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t array_element)
+{
+	if (auto resource = find_resource(name))
+	{
+		command_buffer.bind_buffer(buffer, offset, range, resource->set, resource->binding, array_element);
+	}
+}
+
+void ComputePass::bind_image(CommandBuffer &command_buffer, const std::string &name, const core::ImageView &image_view, const core::Sampler &sampler, uint32_t array_element)
+{
+	if (auto resource = find_resource(name))
+	{
+		command_buffer.bind_image(image_view, sampler, resource->set, resource->binding, array_element);
+	}
+}
+
+const core::ImageView &ComputePass::get_attachment(uint32_t attachment)
+{
+	return render_context.get_active_frame().get_render_target().get_views().at(attachment);
+}
+
+const ShaderResource *ComputePass::find_resource(const std::string &name) const
+{
+	assert(pipeline_layout && "The pipeline must be bound before its resources");
+
+	return pipeline_layout->get_shader_program().find_resource(name);
+}
+}        // namespace vkb
@@ -0,0 +1,117 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/shader_module.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class PipelineLayout;
+
+/**
+ * @brief A pass dispatching a compute shader outside of the render passes, sequenced by a RenderGraph
+ *        before, between or after the passes drawing to its attachments.
+ *        The resources of the shader are bound by their names, as reflected from its source,
+ *        and the RenderGraph records the barriers of the buffers and attachments the pass declares.
+ */
+class ComputePass
+{
+  public:
+	ComputePass(RenderContext &render_context, ShaderSource &&compute_shader);
+
+	ComputePass(const ComputePass &) = delete;
+
+	ComputePass(ComputePass &&) = default;
+
+	virtual ~ComputePass() = default;
+
+	ComputePass &operator=(const ComputePass &) = delete;
+
+	ComputePass &operator=(ComputePass &&) = delete;
+
+	/**
+	 * @brief Prepares the shaders and resources of the pass, by default compiles the shader without defines
+	 */
+	virtual void prepare();
+
+	/**
+	 * @brief Records the dispatches of the pass
+	 * @param command_buffer Command buffer to record to, outside of any render pass
+	 */
+	virtual void dispatch(CommandBuffer &command_buffer) = 0;
+
+	RenderContext &get_render_context();
+
+	const ShaderSource &get_compute_shader() const;
+
+	/**
+	 * @return The name of the pass in debug labels, by default the shader filename
+	 */
+	const std::string &get_debug_name() const;
+
+	void set_debug_name(const std::string &name);
+
+	/**
+	 * @return Number of work groups of a given size covering a number of invocations
+	 */
+	static uint32_t get_group_count(uint32_t invocation_count, uint32_t group_size);
+
+  protected:
+	/**
+	 * @brief Binds the pipeline of the compute shader compiled with a variant
+	 *        The resources bound afterwards by name are looked up in its shader
+	 */
+	const PipelineLayout &bind_pipeline(CommandBuffer &command_buffer, const ShaderVariant &shader_variant = {});
+
+	/**
+	 * @brief Binds a uniform or storage buffer to the shader resource with the given name
+	 *        It is ignored if the shader does not use the resource, e.g. once optimized out
+	 */
+	void bind_buffer(CommandBuffer &command_buffer, const std::string &name, const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t array_element = 0);
+
+	/**
+	 * @brief Binds a sampled image to the shader resource with the given name
+	 *        It is ignored if the shader does not use the resource, e.g. once optimized out
+	 */
+	void bind_image(CommandBuffer &command_buffer, const std::string &name, const core::ImageView &image_view, const core::Sampler &sampler, uint32_t array_element = 0);
+
+	/**
+	 * @return The view of an attachment of the active frame render target, e.g. one the pass samples
+	 */
+	const core::ImageView &get_attachment(uint32_t attachment);
+
+  private:
+	RenderContext &render_context;
+
+	ShaderSource compute_shader;
+
+	std::string debug_name;
+
+	/// Pipeline layout last bound by bind_pipeline()
+	const PipelineLayout *pipeline_layout{nullptr};
+
+	const ShaderResource *find_resource(const std::string &name) const;
+};
+}        // namespace vkb
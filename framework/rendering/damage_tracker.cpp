@@ -0,0 +1,139 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "damage_tracker.h"
+
+#include <cmath>
+#include <limits>
+
+#include "scene_graph/components/camera.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+VkRect2D DamageTracker::update(sg::Scene &scene, sg::Camera &camera, const VkExtent2D &new_extent)
+{
+	glm::mat4 new_view_projection = camera.get_projection() * camera.get_view();
+
+	std::vector<glm::mat4> new_light_matrices;
+	for (auto light : scene.get_components<sg::Light>())
+	{
+		new_light_matrices.push_back(light->get_node()->get_transform().get_world_matrix());
+	}
+
+	bool full_damage = new_view_projection != view_projection || new_light_matrices != light_matrices ||
+	                   new_extent.width != extent.width || new_extent.height != extent.height;
+
+	view_projection = new_view_projection;
+	light_matrices  = std::move(new_light_matrices);
+	extent          = new_extent;
+
+	VkRect2D damage{};
+
+	for (auto mesh : scene.get_components<sg::Mesh>())
+	{
+		auto &nodes = mesh->get_nodes();
+
+		for (size_t i = 0; i < nodes.size(); ++i)
+		{
+			auto &instance = instances[{mesh, i}];
+
+			uint32_t revision = nodes[i]->get_transform().get_world_matrix_revision();
+
+			// The projected regions are all outdated once the camera changed
+			if (revision == instance.world_matrix_revision && !full_damage)
+			{
+				continue;
+			}
+
+			auto &bounds = mesh->get_world_bounds(i);
+
+			bool moved = bounds.get_min() != instance.min || bounds.get_max() != instance.max;
+
+			VkRect2D region = project(bounds.get_min(), bounds.get_max());
+
+			// Both where the mesh was and where it is now are redrawn
+			if (moved)
+			{
+				damage = merge_rects(damage, merge_rects(instance.region, region));
+			}
+
+			instance.world_matrix_revision = revision;
+			instance.min                   = bounds.get_min();
+			instance.max                   = bounds.get_max();
+			instance.region                = region;
+		}
+	}
+
+	if (full_damage)
+	{
+		return {{0, 0}, extent};
+	}
+
+	return damage;
+}
+
+VkRect2D DamageTracker::project(const glm::vec3 &min, const glm::vec3 &max) const
+{
+	VkRect2D full_area{{0, 0}, extent};
+
+	glm::vec2 screen_min{std::numeric_limits<float>::max()};
+	glm::vec2 screen_max{std::numeric_limits<float>::lowest()};
+
+	for (uint32_t corner = 0; corner < 8; ++corner)
+	{
+		glm::vec4 position{(corner & 1) ? max.x : min.x, (corner & 2) ? max.y : min.y, (corner & 4) ? max.z : min.z, 1.0f};
+
+		glm::vec4 clip = view_projection * position;
+
+		// Behind the camera the projection wraps around
+		if (clip.w <= 0.0f)
+		{
+			return full_area;
+		}
+
+		glm::vec2 ndc{clip.x / clip.w, clip.y / clip.w};
+
+		screen_min = glm::min(screen_min, ndc);
+		screen_max = glm::max(screen_max, ndc);
+	}
+
+	// One pixel of margin covers the pixels the rasterization of the edges touches
+	float min_x = std::floor((screen_min.x * 0.5f + 0.5f) * extent.width) - 1.0f;
+	float min_y = std::floor((screen_min.y * 0.5f + 0.5f) * extent.height) - 1.0f;
+	float max_x = std::ceil((screen_max.x * 0.5f + 0.5f) * extent.width) + 1.0f;
+	float max_y = std::ceil((screen_max.y * 0.5f + 0.5f) * extent.height) + 1.0f;
+
+	min_x = std::max(min_x, 0.0f);
+	min_y = std::max(min_y, 0.0f);
+	max_x = std::min(max_x, static_cast<float>(extent.width));
+	max_y = std::min(max_y, static_cast<float>(extent.height));
+
+	if (max_x <= min_x || max_y <= min_y)
+	{
+		return {};
+	}
+
+	return {{static_cast<int32_t>(min_x), static_cast<int32_t>(min_y)}, {static_cast<uint32_t>(max_x - min_x), static_cast<uint32_t>(max_y - min_y)}};
+}
+}        // namespace vkb
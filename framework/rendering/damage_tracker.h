@@ -0,0 +1,88 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+namespace sg
+{
+class Camera;
+class Mesh;
+class Scene;
+}        // namespace sg
+
+/**
+ * @brief Finds the region of the frame that changed since the previous frame, for incremental rendering
+ *
+ * The world bounds of the meshes whose node moved are projected to the frame, both where they were
+ * and where they are now. Any change of the camera or of a light, which may change the shading of
+ * every pixel, damages the whole frame. The bounds are only compared after the world matrix of a
+ * node is invalidated, so a static scene costs a walk over its mesh nodes.
+ */
+class DamageTracker
+{
+  public:
+	/**
+	 * @brief Compares the scene with its state at the previous call
+	 * @param scene The scene rendered
+	 * @param camera The camera the frame is rendered with
+	 * @param extent Size of the frame, in pixels
+	 * @return The damaged region, empty if nothing visible changed
+	 */
+	VkRect2D update(sg::Scene &scene, sg::Camera &camera, const VkExtent2D &extent);
+
+  private:
+	struct Instance
+	{
+		uint32_t world_matrix_revision{~0U};
+
+		glm::vec3 min{0.0f};
+
+		glm::vec3 max{0.0f};
+
+		/// Region covered by the bounds when they were last projected
+		VkRect2D region{};
+	};
+
+	/// Instances of the meshes, by mesh and node index
+	std::map<std::pair<const sg::Mesh *, size_t>, Instance> instances;
+
+	glm::mat4 view_projection{0.0f};
+
+	std::vector<glm::mat4> light_matrices;
+
+	VkExtent2D extent{};
+
+	/**
+	 * @return The region of the frame covered by world space bounds, the whole frame if they cross the near plane
+	 */
+	VkRect2D project(const glm::vec3 &min, const glm::vec3 &max) const;
+};
+}        // namespace vkb
@@ -0,0 +1,272 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "draw_list.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+
+#include "common/helpers.h"
+#include "job_system.h"
+
+namespace vkb
+{
+namespace
+{
+constexpr uint32_t RADIX_BITS = 8;
+
+constexpr uint32_t RADIX_SIZE = 1 << RADIX_BITS;
+
+constexpr uint64_t RADIX_MASK = RADIX_SIZE - 1;
+
+constexpr uint64_t TRANSPARENT_BIT = 1ULL << 63;
+
+constexpr uint32_t DEPTH_SHIFT = 31;
+
+constexpr uint64_t STATE_ID_MASK = (1ULL << DEPTH_SHIFT) - 1;
+
+/// Bits of the state ID above the depth with the State policy
+constexpr uint32_t STATE_SHIFT = 32;
+
+/// Bits of a positive float kept for its depth bin: the exponent and the highest bit of the mantissa
+constexpr uint32_t DEPTH_BIN_BITS = 9;
+
+constexpr uint32_t DEPTH_BIN_SHIFT = 63 - DEPTH_BIN_BITS;
+
+/// The state ID sits between the depth bin and the remaining depth bits with the Hybrid policy
+constexpr uint32_t HYBRID_STATE_SHIFT = DEPTH_BIN_SHIFT - DEPTH_SHIFT;
+
+static_assert(HYBRID_STATE_SHIFT >= 31 - DEPTH_BIN_BITS, "The depth bits left out of the bin must fit below the state ID");
+
+/// Entries sorted by each task of the parallel sort, smaller lists are sorted on the calling thread
+constexpr size_t PARALLEL_SORT_CHUNK_SIZE = 4096;
+}        // namespace
+
+uint64_t DrawList::make_sort_key(float depth, uint32_t state_id, bool transparent, DrawSortPolicy policy)
+{
+	assert(depth >= 0.0f && "Draw depth must not be negative");
+
+	// The bits of a positive float compare in the same order as its value
+	uint32_t depth_bits;
+	std::memcpy(&depth_bits, &depth, sizeof(depth_bits));
+
+	uint64_t state = state_id & STATE_ID_MASK;
+
+	if (transparent)
+	{
+		// Invert the depth so that farther draws come first
+		return TRANSPARENT_BIT | (static_cast<uint64_t>(~depth_bits) << DEPTH_SHIFT) | state;
+	}
+
+	switch (policy)
+	{
+		case DrawSortPolicy::State:
+			return (state << STATE_SHIFT) | depth_bits;
+		case DrawSortPolicy::Hybrid:
+		{
+			// The sign bit of the depth is always clear, the bin is made of the next bits
+			uint64_t depth_bin = depth_bits >> (31 - DEPTH_BIN_BITS);
+			uint64_t fine      = depth_bits & ((1U << (31 - DEPTH_BIN_BITS)) - 1);
+
+			return (depth_bin << DEPTH_BIN_SHIFT) | (state << HYBRID_STATE_SHIFT) | fine;
+		}
+		case DrawSortPolicy::Unsorted:
+			// Equal keys keep the insertion order in the stable sort
+			return 0;
+		default:
+			return (static_cast<uint64_t>(depth_bits) << DEPTH_SHIFT) | state;
+	}
+}
+
+void DrawList::set_sort_policy(DrawSortPolicy policy)
+{
+	sort_policy = policy;
+}
+
+DrawSortPolicy DrawList::get_sort_policy() const
+{
+	return sort_policy;
+}
+
+void DrawList::clear()
+{
+	items.clear();
+	entries.clear();
+	opaque_count = 0;
+}
+
+void DrawList::add(sg::Node &node, sg::SubMesh &sub_mesh, float depth, uint32_t state_id, bool transparent, uint32_t lod)
+{
+	entries.push_back({make_sort_key(depth, state_id, transparent, sort_policy), to_u32(items.size())});
+	items.push_back({&node, &sub_mesh, lod});
+
+	if (!transparent)
+	{
+		opaque_count++;
+	}
+}
+
+void DrawList::append(const DrawList &other)
+{
+	auto item_offset = to_u32(items.size());
+
+	items.insert(items.end(), other.items.begin(), other.items.end());
+
+	entries.reserve(entries.size() + other.entries.size());
+	for (auto &entry : other.entries)
+	{
+		entries.push_back({entry.key, entry.item_index + item_offset});
+	}
+
+	opaque_count += other.opaque_count;
+}
+
+void DrawList::sort()
+{
+	sort_buffer.resize(entries.size());
+
+	// Least significant digit first, each pass is stable
+	for (uint32_t shift = 0; shift < 64; shift += RADIX_BITS)
+	{
+		std::array<size_t, RADIX_SIZE> offsets{};
+
+		for (auto &entry : entries)
+		{
+			offsets[(entry.key >> shift) & RADIX_MASK]++;
+		}
+
+		// Skip the pass if all the keys share the same digit
+		if (std::find(offsets.begin(), offsets.end(), entries.size()) != offsets.end())
+		{
+			continue;
+		}
+
+		size_t offset = 0;
+		for (auto &digit_offset : offsets)
+		{
+			auto count   = digit_offset;
+			digit_offset = offset;
+			offset += count;
+		}
+
+		for (auto &entry : entries)
+		{
+			sort_buffer[offsets[(entry.key >> shift) & RADIX_MASK]++] = entry;
+		}
+
+		std::swap(entries, sort_buffer);
+	}
+}
+
+void DrawList::sort(JobSystem &job_system)
+{
+	size_t chunk_count = std::min<size_t>(entries.size() / PARALLEL_SORT_CHUNK_SIZE, job_system.get_thread_count() + 1);
+
+	if (chunk_count < 2)
+	{
+		sort();
+		return;
+	}
+
+	sort_buffer.resize(entries.size());
+
+	// Each chunk counts the digits of its range, then scatters it after the same digits of the previous chunks,
+	// which keeps every pass stable as a single threaded pass would
+	std::vector<std::array<size_t, RADIX_SIZE>> chunk_offsets(chunk_count);
+
+	auto chunk_begin = [this, chunk_count](size_t chunk) { return entries.size() * chunk / chunk_count; };
+
+	for (uint32_t shift = 0; shift < 64; shift += RADIX_BITS)
+	{
+		job_system.run_parallel(JobPriority::Frame, chunk_count, chunk_count, [&](size_t chunk, size_t) {
+			auto &offsets = chunk_offsets[chunk];
+			offsets.fill(0);
+
+			for (size_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); ++i)
+			{
+				offsets[(entries[i].key >> shift) & RADIX_MASK]++;
+			}
+		});
+
+		// Skip the pass if all the keys share the same digit
+		bool single_digit = false;
+
+		for (size_t digit = 0; digit < RADIX_SIZE && !single_digit; ++digit)
+		{
+			size_t count = 0;
+			for (auto &offsets : chunk_offsets)
+			{
+				count += offsets[digit];
+			}
+
+			single_digit = count == entries.size();
+		}
+
+		if (single_digit)
+		{
+			continue;
+		}
+
+		size_t offset = 0;
+		for (size_t digit = 0; digit < RADIX_SIZE; ++digit)
+		{
+			for (auto &offsets : chunk_offsets)
+			{
+				auto count     = offsets[digit];
+				offsets[digit] = offset;
+				offset += count;
+			}
+		}
+
+		job_system.run_parallel(JobPriority::Frame, chunk_count, chunk_count, [&](size_t chunk, size_t) {
+			auto &offsets = chunk_offsets[chunk];
+
+			for (size_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); ++i)
+			{
+				sort_buffer[offsets[(entries[i].key >> shift) & RADIX_MASK]++] = entries[i];
+			}
+		});
+
+		std::swap(entries, sort_buffer);
+	}
+}
+
+size_t DrawList::size() const
+{
+	return entries.size();
+}
+
+bool DrawList::empty() const
+{
+	return entries.empty();
+}
+
+size_t DrawList::get_opaque_count() const
+{
+	return opaque_count;
+}
+
+const DrawItem &DrawList::get(size_t index) const
+{
+	return items[entries[index].item_index];
+}
+}        // namespace vkb
@@ -0,0 +1,157 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vkb
+{
+class JobSystem;
+
+namespace sg
+{
+class Node;
+class SubMesh;
+}        // namespace sg
+
+/**
+ * @brief A submesh drawn with the transform of a node
+ */
+struct DrawItem
+{
+	sg::Node *node;
+
+	sg::SubMesh *sub_mesh;
+
+	/// Level of detail of the submesh, 0 being the full detail
+	uint32_t lod;
+};
+
+/**
+ * @brief Order of the opaque draws of a DrawList
+ */
+enum class DrawSortPolicy
+{
+	/// Front-to-back, draws at equal depth are grouped by state
+	Depth,
+
+	/// Grouped by state, front-to-back within a state
+	State,
+
+	/// Grouped by state within coarse depth bins, two per power of two of the depth
+	Hybrid,
+
+	/// In the order the draws are added, i.e. the order the scene is traversed, to measure the cost of not sorting
+	Unsorted
+};
+
+/**
+ * @brief A flat list of draws ordered by 64-bit sort keys
+ *
+ * Each key packs, from the most significant bit, the transparency of the draw,
+ * then its depth and a state ID (e.g. the pipeline and material) in the order of the sort policy.
+ * Opaque draws sort before transparent ones; opaque draws are ordered by the sort policy
+ * and transparent draws back-to-front.
+ *
+ * Keys are radix-sorted, and the storage is kept across calls to clear(),
+ * so that a list reused every frame does not allocate once it has grown.
+ */
+class DrawList
+{
+  public:
+	/**
+	 * @brief Packs the sort key of a draw
+	 * @param depth Distance of the draw from the camera, must not be negative
+	 * @param state_id Identifier of the state used by the draw, only the lower 31 bits are kept
+	 * @param transparent Whether the draw is blended with the background
+	 * @param policy Order of the opaque draws, transparent draws are always sorted by depth
+	 * @return The sort key
+	 */
+	static uint64_t make_sort_key(float depth, uint32_t state_id, bool transparent, DrawSortPolicy policy = DrawSortPolicy::Depth);
+
+	/**
+	 * @brief Sets the order of the opaque draws added afterwards
+	 */
+	void set_sort_policy(DrawSortPolicy policy);
+
+	DrawSortPolicy get_sort_policy() const;
+
+	/**
+	 * @brief Removes all draws while keeping the allocated storage
+	 */
+	void clear();
+
+	void add(sg::Node &node, sg::SubMesh &sub_mesh, float depth, uint32_t state_id, bool transparent, uint32_t lod = 0);
+
+	/**
+	 * @brief Adds the draws of another list after those of this one, e.g. to merge lists built by several threads
+	 *        in the order of the draws they would have been added in by a single thread. Both lists must be unsorted.
+	 */
+	void append(const DrawList &other);
+
+	/**
+	 * @brief Sorts the draws by their keys, draws with equal keys keep their insertion order
+	 */
+	void sort();
+
+	/**
+	 * @brief Sorts the draws like sort(), splitting each radix pass over the workers of a job system
+	 *        when the list is large enough to benefit from it
+	 */
+	void sort(JobSystem &job_system);
+
+	size_t size() const;
+
+	bool empty() const;
+
+	/**
+	 * @return The number of opaque draws, which are placed before the transparent ones after sorting
+	 */
+	size_t get_opaque_count() const;
+
+	/**
+	 * @param index Position of the draw in sorted order
+	 * @return The draw at the given position
+	 */
+	const DrawItem &get(size_t index) const;
+
+  private:
+	struct SortEntry
+	{
+		uint64_t key;
+
+		uint32_t item_index;
+	};
+
+	std::vector<DrawItem> items;
+
+	std::vector<SortEntry> entries;
+
+	/// Destination buffer of the radix sort passes
+	std::vector<SortEntry> sort_buffer;
+
+	size_t opaque_count{0};
+
+	DrawSortPolicy sort_policy{DrawSortPolicy::Depth};
+};
+}        // namespace vkb
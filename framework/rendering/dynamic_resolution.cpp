@@ -0,0 +1,133 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "rendering/dynamic_resolution.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace vkb
+{
+constexpr float DynamicResolution::SCALE_STEP;
+
+constexpr float DynamicResolution::HEADROOM_RATIO;
+
+DynamicResolution::DynamicResolution(float min_scale, float max_scale) :
+    min_scale{min_scale},
+    max_scale{max_scale},
+    scale{max_scale}
+{
+	set_bounds(min_scale, max_scale);
+}
+
+void DynamicResolution::set_bounds(float new_min_scale, float new_max_scale)
+{
+	assert(new_min_scale > 0.0f && new_min_scale <= new_max_scale && new_max_scale <= 1.0f && "Invalid render scale bounds");
+
+	min_scale = new_min_scale;
+	max_scale = new_max_scale;
+	scale     = clamp_scale(scale);
+}
+
+float DynamicResolution::get_min_scale() const
+{
+	return min_scale;
+}
+
+float DynamicResolution::get_max_scale() const
+{
+	return max_scale;
+}
+
+void DynamicResolution::set_target_frame_time(float seconds)
+{
+	assert(seconds > 0.0f && "Target frame time must be positive");
+
+	target_frame_time = seconds;
+}
+
+float DynamicResolution::get_target_frame_time() const
+{
+	return target_frame_time;
+}
+
+void DynamicResolution::set_adjust_interval(uint32_t new_frame_count)
+{
+	adjust_interval = std::max(new_frame_count, 1u);
+}
+
+bool DynamicResolution::update(float gpu_frame_time)
+{
+	accumulated_time += gpu_frame_time;
+
+	if (++frame_count < adjust_interval)
+	{
+		return false;
+	}
+
+	float average_time = accumulated_time / frame_count;
+
+	frame_count      = 0;
+	accumulated_time = 0.0f;
+
+	if (average_time <= 0.0f)
+	{
+		return false;
+	}
+
+	float new_scale = scale;
+
+	// The pixel count goes with the square of the scale
+	float ideal_scale = scale * std::sqrt(target_frame_time / average_time);
+
+	if (average_time > target_frame_time)
+	{
+		new_scale = std::floor(ideal_scale / SCALE_STEP) * SCALE_STEP;
+	}
+	else if (average_time < target_frame_time * HEADROOM_RATIO)
+	{
+		new_scale = std::min(scale + SCALE_STEP, ideal_scale);
+	}
+
+	new_scale = clamp_scale(new_scale);
+
+	if (std::abs(new_scale - scale) < SCALE_STEP * 0.5f)
+	{
+		return false;
+	}
+
+	scale = new_scale;
+
+	return true;
+}
+
+float DynamicResolution::get_scale() const
+{
+	return scale;
+}
+
+float DynamicResolution::clamp_scale(float value) const
+{
+	value = std::round(value / SCALE_STEP) * SCALE_STEP;
+
+	return std::min(std::max(value, min_scale), max_scale);
+}
+}        // namespace vkb
@@ -0,0 +1,93 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace vkb
+{
+/**
+ * @brief Picks the render scale that keeps the GPU frame time under a target
+ *
+ * Frame times are averaged over a number of frames before the scale is adjusted, as each change
+ * recreates the render targets. The cost of a frame is assumed to be proportional to the number of
+ * pixels rendered, so the scale jumps to the one expected to meet the target when over budget, and
+ * only grows by small steps while there is headroom to avoid bouncing between two scales.
+ * Scales are rounded to multiples of SCALE_STEP.
+ */
+class DynamicResolution
+{
+  public:
+	static constexpr float SCALE_STEP{0.05f};
+
+	DynamicResolution(float min_scale = 0.5f, float max_scale = 1.0f);
+
+	/**
+	 * @brief Sets the range the scale is kept in, the scale being clamped to it
+	 */
+	void set_bounds(float min_scale, float max_scale);
+
+	float get_min_scale() const;
+
+	float get_max_scale() const;
+
+	/**
+	 * @param seconds GPU time to aim for, typically a bit under the display refresh cycle
+	 */
+	void set_target_frame_time(float seconds);
+
+	float get_target_frame_time() const;
+
+	/**
+	 * @param frame_count Number of frames averaged before each adjustment
+	 */
+	void set_adjust_interval(uint32_t frame_count);
+
+	/**
+	 * @brief Accumulates the GPU time of a frame, adjusting the scale every adjust interval
+	 * @param gpu_frame_time GPU time of the frame in seconds
+	 * @return Whether the scale changed
+	 */
+	bool update(float gpu_frame_time);
+
+	float get_scale() const;
+
+  private:
+	/// Fraction of the target under which the frame time leaves room to increase the scale
+	static constexpr float HEADROOM_RATIO{0.85f};
+
+	float min_scale;
+
+	float max_scale;
+
+	float scale;
+
+	float target_frame_time{1.0f / 60.0f};
+
+	uint32_t adjust_interval{30};
+
+	uint32_t frame_count{0};
+
+	float accumulated_time{0.0f};
+
+	float clamp_scale(float value) const;
+};
+}        // namespace vkb
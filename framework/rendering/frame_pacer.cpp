@@ -0,0 +1,269 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "frame_pacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "common/logging.h"
+#include "core/device.h"
+#include "core/swapchain.h"
+
+namespace vkb
+{
+namespace
+{
+/// Weight of the latest measurement in the smoothed latency
+constexpr float LATENCY_SMOOTHING = 0.1f;
+
+/// Time in seconds kept between the expected end of a frame and its deadline, to absorb variations in latency
+constexpr float DEADLINE_MARGIN = 0.002f;
+}        // namespace
+
+FramePacer::FramePacer(Device &device) :
+    device{device}
+{
+}
+
+void FramePacer::set_target_frame_time(float seconds)
+{
+	target_frame_time = std::max(seconds, 0.0f);
+
+	next_frame_time = Clock::now();
+}
+
+float FramePacer::get_target_frame_time() const
+{
+	return target_frame_time;
+}
+
+void FramePacer::set_spin_time(float seconds)
+{
+	spin_time = std::max(seconds, 0.0f);
+}
+
+float FramePacer::get_paced_frame_time() const
+{
+	float refresh = get_refresh_duration();
+
+	if (target_frame_time <= 0.0f || refresh <= 0.0f)
+	{
+		return target_frame_time;
+	}
+
+	// Tolerate a small error in the target so that 1/60 s does not become two refresh cycles
+	float cycles = std::ceil(target_frame_time / refresh - 0.05f);
+
+	return std::max(cycles, 1.0f) * refresh;
+}
+
+void FramePacer::wait_for_next_frame()
+{
+	if (has_frame_deadline)
+	{
+		has_frame_deadline = false;
+		current_deadline   = frame_deadline;
+
+		// Start as late as the deadline allows, so that the frame reflects the latest input
+		auto lead_time  = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(latency + DEADLINE_MARGIN));
+		auto start_time = frame_deadline - lead_time;
+
+		if (Clock::now() < start_time)
+		{
+			std::this_thread::sleep_until(start_time);
+		}
+
+		next_frame_time = Clock::now();
+		acquire_time    = next_frame_time;
+		return;
+	}
+
+	current_deadline = Clock::time_point{};
+
+	float paced_frame_time = get_paced_frame_time();
+
+	if (paced_frame_time > 0.0f)
+	{
+		auto frame_duration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(paced_frame_time));
+		auto spin_duration  = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(spin_time));
+
+		auto now = Clock::now();
+
+		if (now + spin_duration < next_frame_time)
+		{
+			std::this_thread::sleep_until(next_frame_time - spin_duration);
+		}
+
+		while (Clock::now() < next_frame_time)
+		{
+			std::this_thread::yield();
+		}
+
+		now = Clock::now();
+
+		// Falling behind by more than a frame restarts the cadence, rather than rushing frames to catch up
+		if (now - next_frame_time > frame_duration)
+		{
+			next_frame_time = now;
+		}
+
+		next_frame_time += frame_duration;
+	}
+
+	acquire_time = Clock::now();
+}
+
+const void *FramePacer::prepare_present(const Swapchain &swapchain)
+{
+	if (!device.is_display_timing_enabled())
+	{
+		return nullptr;
+	}
+
+	if (timing_swapchain != swapchain.get_handle())
+	{
+		timing_swapchain    = swapchain.get_handle();
+		present_id          = 0;
+		last_displayed_id   = 0;
+		last_displayed_time = 0;
+		present_interval    = 0;
+
+		VkRefreshCycleDurationGOOGLE refresh_cycle{};
+
+		if (vkGetRefreshCycleDurationGOOGLE(device.get_handle(), timing_swapchain, &refresh_cycle) == VK_SUCCESS)
+		{
+			refresh_duration = refresh_cycle.refreshDuration;
+		}
+		else
+		{
+			LOGW("Could not query the refresh cycle duration");
+			refresh_duration = 0;
+		}
+	}
+	else
+	{
+		update_past_presentation_timing();
+	}
+
+	++present_id;
+
+	present_time.presentID          = present_id;
+	present_time.desiredPresentTime = 0;
+
+	float paced_frame_time = get_paced_frame_time();
+
+	if (last_displayed_time != 0 && paced_frame_time > 0.0f)
+	{
+		uint64_t frame_duration = static_cast<uint64_t>(paced_frame_time * 1e9f);
+
+		// Ask for half a refresh cycle early, so that the image is not held back a whole cycle by rounding
+		present_time.desiredPresentTime = last_displayed_time + (present_id - last_displayed_id) * frame_duration - refresh_duration / 2;
+	}
+
+	present_times_info.swapchainCount = 1;
+	present_times_info.pTimes         = &present_time;
+
+	return &present_times_info;
+}
+
+void FramePacer::on_present()
+{
+	float present_latency = std::chrono::duration<float>(Clock::now() - acquire_time).count();
+
+	latency += (present_latency - latency) * LATENCY_SMOOTHING;
+
+	work_time = present_latency;
+
+	if (current_deadline != Clock::time_point{} && Clock::now() > current_deadline)
+	{
+		++missed_deadline_count;
+	}
+}
+
+void FramePacer::set_frame_deadline(Clock::time_point deadline)
+{
+	frame_deadline     = deadline;
+	has_frame_deadline = true;
+}
+
+uint32_t FramePacer::get_missed_deadline_count() const
+{
+	return missed_deadline_count;
+}
+
+float FramePacer::get_latency() const
+{
+	return latency;
+}
+
+float FramePacer::get_work_time() const
+{
+	return work_time;
+}
+
+float FramePacer::get_refresh_duration() const
+{
+	return static_cast<float>(refresh_duration) * 1e-9f;
+}
+
+float FramePacer::get_present_interval() const
+{
+	return static_cast<float>(present_interval) * 1e-9f;
+}
+
+void FramePacer::update_past_presentation_timing()
+{
+	uint32_t timing_count{0};
+
+	if (vkGetPastPresentationTimingGOOGLE(device.get_handle(), timing_swapchain, &timing_count, nullptr) != VK_SUCCESS || timing_count == 0)
+	{
+		return;
+	}
+
+	std::vector<VkPastPresentationTimingGOOGLE> timings(timing_count);
+
+	VkResult result = vkGetPastPresentationTimingGOOGLE(device.get_handle(), timing_swapchain, &timing_count, timings.data());
+
+	if (result != VK_SUCCESS && result != VK_INCOMPLETE)
+	{
+		return;
+	}
+
+	for (uint32_t i = 0; i < timing_count; ++i)
+	{
+		auto &timing = timings[i];
+
+		if (timing.presentID <= last_displayed_id)
+		{
+			continue;
+		}
+
+		if (last_displayed_time != 0)
+		{
+			present_interval = (timing.actualPresentTime - last_displayed_time) / (timing.presentID - last_displayed_id);
+		}
+
+		last_displayed_id   = timing.presentID;
+		last_displayed_time = timing.actualPresentTime;
+	}
+}
+}        // namespace vkb
@@ -0,0 +1,171 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class Device;
+class Swapchain;
+
+/**
+ * @brief Paces the frames of a RenderContext so that they are delivered at an even cadence
+ *
+ * The CPU sleeps before acquiring a new image until the next frame is due, spinning for the
+ * last part of the wait to wake up on time. The target frame time is rounded up to a multiple
+ * of the display refresh cycle when it is known, as presenting between refresh cycles is what
+ * produces uneven 16/33 ms cadences on 60 Hz panels.
+ *
+ * If VK_GOOGLE_display_timing is enabled, each present also requests a present time based on
+ * when the previous images were actually displayed.
+ *
+ * When the frames are driven by a vsync source which provides deadlines, such as the Android
+ * Choreographer, the CPU instead sleeps until the deadline minus the expected frame latency, so
+ * that the frame is built from input as recent as possible.
+ */
+class FramePacer
+{
+  public:
+	using Clock = std::chrono::steady_clock;
+
+	FramePacer(Device &device);
+
+	/**
+	 * @brief Sets the frame time to aim for
+	 * @param seconds Time between frames, 0 to present as fast as acquire allows
+	 */
+	void set_target_frame_time(float seconds);
+
+	float get_target_frame_time() const;
+
+	/**
+	 * @brief Sets how long before the next frame is due the CPU stops sleeping and spins
+	 *        Sleeping is cheaper on power but wakes up late by up to a scheduler quantum
+	 */
+	void set_spin_time(float seconds);
+
+	/**
+	 * @return The time between frames actually aimed for, the target rounded up to the refresh cycle
+	 */
+	float get_paced_frame_time() const;
+
+	/**
+	 * @brief Blocks until the next frame is due. To be called before acquiring a swapchain image
+	 */
+	void wait_for_next_frame();
+
+	/**
+	 * @brief Sets the deadline of the next frame, used instead of the target frame time for that frame
+	 * @param deadline Time by which the frame must be presented to be displayed at the next refresh
+	 */
+	void set_frame_deadline(Clock::time_point deadline);
+
+	/**
+	 * @return The number of frames presented after their deadline
+	 */
+	uint32_t get_missed_deadline_count() const;
+
+	/**
+	 * @brief Prepares the present of the current frame
+	 * @param swapchain The swapchain the frame is presented to
+	 * @return A structure to be chained to VkPresentInfoKHR, or nullptr if display timing is disabled
+	 */
+	const void *prepare_present(const Swapchain &swapchain);
+
+	/**
+	 * @brief Records that the current frame has been presented
+	 */
+	void on_present();
+
+	/**
+	 * @return The smoothed CPU time in seconds from acquiring an image to presenting it
+	 */
+	float get_latency() const;
+
+	/**
+	 * @return The CPU time in seconds the last frame took from acquiring an image to presenting it, not smoothed
+	 */
+	float get_work_time() const;
+
+	/**
+	 * @return The duration in seconds of a display refresh cycle, 0 if unknown
+	 */
+	float get_refresh_duration() const;
+
+	/**
+	 * @return The time in seconds between the last two images displayed, 0 if display timing is disabled
+	 */
+	float get_present_interval() const;
+
+  private:
+	Device &device;
+
+	float target_frame_time{0.0f};
+
+	float spin_time{0.002f};
+
+	Clock::time_point next_frame_time{};
+
+	Clock::time_point acquire_time{};
+
+	/// Deadline of the next frame, if one was given
+	Clock::time_point frame_deadline{};
+
+	bool has_frame_deadline{false};
+
+	/// Deadline of the frame being recorded, checked at present
+	Clock::time_point current_deadline{};
+
+	uint32_t missed_deadline_count{0};
+
+	float latency{0.0f};
+
+	float work_time{0.0f};
+
+	/// Swapchain the present timings refer to, they are reset when it is recreated
+	VkSwapchainKHR timing_swapchain{VK_NULL_HANDLE};
+
+	/// Refresh cycle duration in nanoseconds
+	uint64_t refresh_duration{0};
+
+	uint32_t present_id{0};
+
+	/// Most recent present known to have been displayed
+	uint32_t last_displayed_id{0};
+
+	uint64_t last_displayed_time{0};
+
+	uint64_t present_interval{0};
+
+	VkPresentTimeGOOGLE present_time{};
+
+	VkPresentTimesInfoGOOGLE present_times_info{VK_STRUCTURE_TYPE_PRESENT_TIMES_INFO_GOOGLE};
+
+	/**
+	 * @brief Fetches the times at which the previous presents were displayed
+	 */
+	void update_past_presentation_timing();
+};
+}        // namespace vkb
@@ -0,0 +1,174 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "frame_readback.h"
+
+#include <algorithm>
+
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "core/image_view.h"
+
+namespace vkb
+{
+FrameReadback::FrameReadback(Device &device, size_t frame_count) :
+    device{device},
+    frame_buffers(frame_count)
+{
+}
+
+void FrameReadback::record(CommandBuffer &command_buffer, uint32_t frame_index, const core::ImageView &image_view, VkImageLayout layout, Callback callback)
+{
+	assert(callback && "A readback callback is required");
+
+	auto &frame_buffer = frame_buffers.at(frame_index);
+
+	assert(!frame_buffer.pending && "The previous copy of the frame has not been delivered");
+
+	const auto &image  = image_view.get_image();
+	const auto &extent = image.get_extent();
+
+	int32_t bits_per_pixel = get_bits_per_pixel(image.get_format());
+	assert(bits_per_pixel > 0 && bits_per_pixel % 8 == 0 && "Unsupported readback format");
+
+	size_t size = static_cast<size_t>(extent.width) * extent.height * (bits_per_pixel / 8);
+
+	// The buffers are only reallocated when the extent grows
+	if (!frame_buffer.buffer || frame_buffer.buffer->get_size() < size)
+	{
+		frame_buffer.buffer = std::make_unique<core::Buffer>(device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
+	}
+
+	auto subresource_range = image_view.get_subresource_range();
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = layout;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		command_buffer.image_memory_barrier(image_view, memory_barrier);
+	}
+
+	VkBufferImageCopy copy_region{};
+	copy_region.imageSubresource.aspectMask     = subresource_range.aspectMask;
+	copy_region.imageSubresource.mipLevel       = subresource_range.baseMipLevel;
+	copy_region.imageSubresource.baseArrayLayer = subresource_range.baseArrayLayer;
+	copy_region.imageSubresource.layerCount     = 1;
+	copy_region.imageExtent                     = {extent.width, extent.height, 1};
+
+	command_buffer.copy_image_to_buffer(image, *frame_buffer.buffer, {copy_region});
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		memory_barrier.new_layout      = layout;
+		memory_barrier.src_access_mask = VK_ACCESS_TRANSFER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+		command_buffer.image_memory_barrier(image_view, memory_barrier);
+	}
+
+	// Makes the transfer writes visible to the host once the frame fence is signaled
+	BufferMemoryBarrier host_barrier{};
+	host_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	host_barrier.dst_access_mask = VK_ACCESS_HOST_READ_BIT;
+	host_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	host_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_HOST_BIT;
+
+	command_buffer.buffer_memory_barrier(*frame_buffer.buffer, 0, size, host_barrier);
+
+	frame_buffer.callback     = std::move(callback);
+	frame_buffer.pending      = true;
+	frame_buffer.frame_number = next_frame_number++;
+	frame_buffer.extent       = {extent.width, extent.height};
+	frame_buffer.format       = image.get_format();
+	frame_buffer.size         = size;
+}
+
+void FrameReadback::deliver(uint32_t frame_index)
+{
+	auto &frame_buffer = frame_buffers.at(frame_index);
+
+	if (!frame_buffer.pending)
+	{
+		return;
+	}
+
+	frame_buffer.pending = false;
+
+	auto &buffer = *frame_buffer.buffer;
+
+	buffer.invalidate();
+
+	ReadbackFrame frame;
+	frame.frame_number = frame_buffer.frame_number;
+	frame.extent       = frame_buffer.extent;
+	frame.format       = frame_buffer.format;
+	frame.data         = buffer.map();
+	frame.size         = frame_buffer.size;
+
+	auto callback = std::move(frame_buffer.callback);
+
+	callback(frame);
+
+	buffer.unmap();
+}
+
+void FrameReadback::flush()
+{
+	if (!is_pending())
+	{
+		return;
+	}
+
+	device.wait_idle();
+
+	std::vector<uint32_t> pending_frames;
+
+	for (uint32_t i = 0; i < to_u32(frame_buffers.size()); ++i)
+	{
+		if (frame_buffers[i].pending)
+		{
+			pending_frames.push_back(i);
+		}
+	}
+
+	std::sort(pending_frames.begin(), pending_frames.end(), [this](uint32_t a, uint32_t b) {
+		return frame_buffers[a].frame_number < frame_buffers[b].frame_number;
+	});
+
+	for (auto frame_index : pending_frames)
+	{
+		deliver(frame_index);
+	}
+}
+
+bool FrameReadback::is_pending() const
+{
+	return std::any_of(frame_buffers.begin(), frame_buffers.end(), [](const FrameBuffer &frame_buffer) {
+		return frame_buffer.pending;
+	});
+}
+}        // namespace vkb
@@ -0,0 +1,132 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/buffer.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+
+namespace core
+{
+class ImageView;
+}
+
+/**
+ * @brief A frame rendered offscreen and copied back to host memory
+ */
+struct ReadbackFrame
+{
+	/// Number of the frame since the readback started, in rendering order
+	uint64_t frame_number{0};
+
+	VkExtent2D extent{};
+
+	VkFormat format{VK_FORMAT_UNDEFINED};
+
+	/// Tightly packed rows of pixels, only valid for the duration of the callback
+	const uint8_t *data{nullptr};
+
+	size_t size{0};
+};
+
+/**
+ * @brief Copies the images a RenderContext renders to back to host visible buffers
+ *
+ * Each frame in flight has its own buffer, so that the copy of a frame is recorded into its
+ * submission and only read once the frame fence is waited on, the next time the frame is used.
+ * The CPU never stalls on the GPU to fetch the pixels, at the cost of a few frames of latency.
+ *
+ * The pixels are handed to a callback, e.g. to encode the frames to a video stream or to a file.
+ */
+class FrameReadback
+{
+  public:
+	using Callback = std::function<void(const ReadbackFrame &)>;
+
+	FrameReadback(Device &device, size_t frame_count);
+
+	FrameReadback(const FrameReadback &) = delete;
+
+	FrameReadback(FrameReadback &&) = delete;
+
+	FrameReadback &operator=(const FrameReadback &) = delete;
+
+	FrameReadback &operator=(FrameReadback &&) = delete;
+
+	/**
+	 * @brief Records the copy of an image to the buffer of a frame
+	 * @param command_buffer Command buffer submitted with the frame
+	 * @param frame_index Index of the frame the image was rendered by
+	 * @param image_view View of the rendered image
+	 * @param layout Layout of the image, which it is left in after the copy
+	 * @param callback Function receiving the pixels once the frame has completed
+	 */
+	void record(CommandBuffer &command_buffer, uint32_t frame_index, const core::ImageView &image_view, VkImageLayout layout, Callback callback);
+
+	/**
+	 * @brief Hands the pixels of a frame to the callback, if a copy is pending
+	 *        The commands of the frame must have completed
+	 */
+	void deliver(uint32_t frame_index);
+
+	/**
+	 * @brief Waits for the device and delivers every pending frame, in rendering order
+	 */
+	void flush();
+
+	/**
+	 * @return Whether a copy is waiting to be delivered
+	 */
+	bool is_pending() const;
+
+  private:
+	struct FrameBuffer
+	{
+		std::unique_ptr<core::Buffer> buffer;
+
+		Callback callback;
+
+		bool pending{false};
+
+		uint64_t frame_number{0};
+
+		VkExtent2D extent{};
+
+		VkFormat format{VK_FORMAT_UNDEFINED};
+
+		size_t size{0};
+	};
+
+	Device &device;
+
+	std::vector<FrameBuffer> frame_buffers;
+
+	uint64_t next_frame_number{0};
+};
+}        // namespace vkb
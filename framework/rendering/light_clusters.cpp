@@ -0,0 +1,251 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "rendering/light_clusters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "scene_graph/components/light.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace
+{
+Light to_shader_light(sg::Light &light)
+{
+	const auto &properties = light.get_properties();
+	auto &      transform  = light.get_node()->get_transform();
+
+	return {{transform.get_translation(), static_cast<float>(light.get_light_type())},
+	        {properties.color, properties.intensity},
+	        {transform.get_rotation() * properties.direction, properties.range},
+	        {properties.inner_cone_angle, properties.outer_cone_angle}};
+}
+
+/**
+ * @brief Distance at which a point light contributes less than 1/256 of its color,
+ *        used when the light does not specify a range
+ */
+float get_light_radius(const sg::LightProperties &properties, float distance_scale)
+{
+	if (properties.range > 0.0f)
+	{
+		return properties.range;
+	}
+
+	float max_component = std::max(properties.color.r, std::max(properties.color.g, properties.color.b));
+
+	return std::sqrt(std::max(properties.intensity * max_component, 0.0f) * 256.0f) / distance_scale;
+}
+}        // namespace
+
+LightClusters::LightClusters(const glm::uvec3 &grid_size, float distance_scale) :
+    grid_size{grid_size},
+    distance_scale{distance_scale},
+    cluster_bounds(grid_size.x * grid_size.y * grid_size.z),
+    cluster_ranges(grid_size.x * grid_size.y * grid_size.z)
+{
+	assert(grid_size.x > 0 && grid_size.y > 0 && grid_size.z > 0 && "Cluster grid must not be empty");
+	assert(distance_scale > 0.0f && "Distance scale must be positive");
+}
+
+void LightClusters::update(const std::vector<sg::Light *> &scene_lights, sg::PerspectiveCamera &camera, const VkExtent2D &extent)
+{
+	const float near_plane = camera.get_near_plane();
+	const float far_plane  = camera.get_far_plane();
+	const auto  projection = vulkan_style_projection(camera.get_projection());
+	const auto  view       = camera.get_view();
+
+	if (projection != bounds_projection || near_plane != bounds_near_plane || far_plane != bounds_far_plane)
+	{
+		update_cluster_bounds(projection, near_plane, far_plane);
+	}
+
+	float slice_scale = grid_size.z / std::log(far_plane / near_plane);
+
+	uniform.view          = view;
+	uniform.cluster_scale = glm::vec4{static_cast<float>(grid_size.x) / extent.width,
+	                                  static_cast<float>(grid_size.y) / extent.height,
+	                                  slice_scale,
+	                                  -std::log(near_plane) * slice_scale};
+
+	lights.clear();
+
+	for (auto light : scene_lights)
+	{
+		if (light->get_light_type() == sg::LightType::Directional)
+		{
+			lights.push_back(to_shader_light(*light));
+		}
+	}
+
+	uniform.grid = glm::uvec4{grid_size, to_u32(lights.size())};
+
+	overlaps.clear();
+
+	for (auto light : scene_lights)
+	{
+		// Spot lights are not shaded by the forward shaders
+		if (light->get_light_type() != sg::LightType::Point)
+		{
+			continue;
+		}
+
+		auto  light_index  = to_u32(lights.size());
+		auto  shader_light = to_shader_light(*light);
+		float radius       = get_light_radius(light->get_properties(), distance_scale);
+
+		glm::vec3 center{view * glm::vec4{glm::vec3{shader_light.position}, 1.0f}};
+		float     depth  = -center.z;
+
+		if (depth + radius < near_plane || depth - radius > far_plane)
+		{
+			continue;
+		}
+
+		lights.push_back(shader_light);
+
+		// Only the slices the sphere reaches need testing
+		auto first_slice = static_cast<uint32_t>(std::max(std::log(std::max(depth - radius, near_plane)) * uniform.cluster_scale.z + uniform.cluster_scale.w, 0.0f));
+		auto last_slice  = static_cast<uint32_t>(std::max(std::log(std::min(depth + radius, far_plane)) * uniform.cluster_scale.z + uniform.cluster_scale.w, 0.0f));
+
+		last_slice = std::min(last_slice, grid_size.z - 1);
+
+		for (uint32_t z = first_slice; z <= last_slice; ++z)
+		{
+			for (uint32_t y = 0; y < grid_size.y; ++y)
+			{
+				for (uint32_t x = 0; x < grid_size.x; ++x)
+				{
+					uint32_t cluster_index = (z * grid_size.y + y) * grid_size.x + x;
+
+					const auto &bounds  = cluster_bounds[cluster_index];
+					glm::vec3   closest = glm::clamp(center, bounds.min, bounds.max);
+					glm::vec3   offset  = center - closest;
+
+					if (glm::dot(offset, offset) <= radius * radius)
+					{
+						overlaps.emplace_back(cluster_index, light_index);
+					}
+				}
+			}
+		}
+	}
+
+	// Count the lights of each cluster, then turn the counts into offsets
+	std::fill(cluster_ranges.begin(), cluster_ranges.end(), glm::uvec2{0, 0});
+
+	for (auto &overlap : overlaps)
+	{
+		cluster_ranges[overlap.first].y++;
+	}
+
+	uint32_t offset = 0;
+	for (auto &range : cluster_ranges)
+	{
+		range.x = offset;
+		offset += range.y;
+		range.y = 0;
+	}
+
+	light_indices.resize(overlaps.size());
+
+	for (auto &overlap : overlaps)
+	{
+		auto &range = cluster_ranges[overlap.first];
+
+		light_indices[range.x + range.y++] = overlap.second;
+	}
+}
+
+void LightClusters::update_cluster_bounds(const glm::mat4 &projection, float near_plane, float far_plane)
+{
+	bounds_projection = projection;
+	bounds_near_plane = near_plane;
+	bounds_far_plane  = far_plane;
+
+	// A view-space point at depth d projects to ndc (x * P00 / d, y * P11 / d)
+	float ndc_to_view_x = 1.0f / projection[0][0];
+	float ndc_to_view_y = 1.0f / projection[1][1];
+
+	for (uint32_t z = 0; z < grid_size.z; ++z)
+	{
+		float near_depth = near_plane * std::pow(far_plane / near_plane, static_cast<float>(z) / grid_size.z);
+		float far_depth  = near_plane * std::pow(far_plane / near_plane, static_cast<float>(z + 1) / grid_size.z);
+
+		for (uint32_t y = 0; y < grid_size.y; ++y)
+		{
+			float ndc_y0 = 2.0f * y / grid_size.y - 1.0f;
+			float ndc_y1 = 2.0f * (y + 1) / grid_size.y - 1.0f;
+
+			for (uint32_t x = 0; x < grid_size.x; ++x)
+			{
+				float ndc_x0 = 2.0f * x / grid_size.x - 1.0f;
+				float ndc_x1 = 2.0f * (x + 1) / grid_size.x - 1.0f;
+
+				auto &bounds = cluster_bounds[(z * grid_size.y + y) * grid_size.x + x];
+
+				bounds.min = glm::vec3{std::numeric_limits<float>::max()};
+				bounds.max = glm::vec3{std::numeric_limits<float>::lowest()};
+
+				// The cluster lies between the corners of its tile at the near and far depth of the slice
+				for (float depth : {near_depth, far_depth})
+				{
+					for (float ndc_x : {ndc_x0, ndc_x1})
+					{
+						for (float ndc_y : {ndc_y0, ndc_y1})
+						{
+							glm::vec3 corner{ndc_x * depth * ndc_to_view_x, ndc_y * depth * ndc_to_view_y, -depth};
+
+							bounds.min = glm::min(bounds.min, corner);
+							bounds.max = glm::max(bounds.max, corner);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+const ClusterUniform &LightClusters::get_uniform() const
+{
+	return uniform;
+}
+
+const std::vector<Light> &LightClusters::get_lights() const
+{
+	return lights;
+}
+
+const std::vector<glm::uvec2> &LightClusters::get_cluster_ranges() const
+{
+	return cluster_ranges;
+}
+
+const std::vector<uint32_t> &LightClusters::get_light_indices() const
+{
+	return light_indices;
+}
+}        // namespace vkb
@@ -0,0 +1,122 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "rendering/subpass.h"
+
+namespace vkb
+{
+namespace sg
+{
+class Light;
+class PerspectiveCamera;
+}        // namespace sg
+
+struct alignas(16) ClusterUniform
+{
+	glm::mat4  view;
+	glm::uvec4 grid;                 // grid.xyz represents cluster counts, grid.w represents directional light count
+	glm::vec4  cluster_scale;        // xy represents clusters per pixel, z represents slice scale, w represents slice bias
+};
+
+/**
+ * @brief Bins the lights of a scene into a grid of clusters of the view frustum
+ *
+ * The frustum is divided in screen-space tiles and exponential depth slices, so that a
+ * fragment finds its cluster from gl_FragCoord and its view depth alone:
+ *     slice = log(depth) * cluster_scale.z + cluster_scale.w
+ *
+ * Point lights are tested as spheres against the view-space bounds of each cluster, and
+ * every cluster gets a range of indices into the light list. Directional lights affect
+ * all clusters, so they are stored at the start of the list instead of being binned.
+ */
+class LightClusters
+{
+  public:
+	/**
+	 * @brief Constructs the cluster grid
+	 * @param grid_size Number of clusters along x, y and depth. A single slice gives screen-tile culling
+	 * @param distance_scale Scale the shader applies to light distances before attenuating them
+	 */
+	LightClusters(const glm::uvec3 &grid_size = {16, 9, 24}, float distance_scale = 1.0f);
+
+	/**
+	 * @brief Bins the lights for the current camera
+	 * @param lights Lights of the scene
+	 * @param camera Camera looking at the scene
+	 * @param extent Size in pixels of the render target
+	 */
+	void update(const std::vector<sg::Light *> &lights, sg::PerspectiveCamera &camera, const VkExtent2D &extent);
+
+	const ClusterUniform &get_uniform() const;
+
+	/**
+	 * @return Directional lights followed by the point lights
+	 */
+	const std::vector<Light> &get_lights() const;
+
+	/**
+	 * @return Offset and count of light indices for each cluster, x fastest then y then z
+	 */
+	const std::vector<glm::uvec2> &get_cluster_ranges() const;
+
+	const std::vector<uint32_t> &get_light_indices() const;
+
+  private:
+	struct Bounds
+	{
+		glm::vec3 min;
+
+		glm::vec3 max;
+	};
+
+	void update_cluster_bounds(const glm::mat4 &projection, float near_plane, float far_plane);
+
+	glm::uvec3 grid_size;
+
+	float distance_scale;
+
+	ClusterUniform uniform{};
+
+	std::vector<Bounds> cluster_bounds;
+
+	/// Projection the cluster bounds were computed for
+	glm::mat4 bounds_projection{0.0f};
+
+	float bounds_near_plane{0.0f};
+
+	float bounds_far_plane{0.0f};
+
+	std::vector<Light> lights;
+
+	std::vector<glm::uvec2> cluster_ranges;
+
+	std::vector<uint32_t> light_indices;
+
+	/// Cluster and light index of each light-cluster overlap, reused across frames
+	std::vector<std::pair<uint32_t, uint32_t>> overlaps;
+};
+}        // namespace vkb
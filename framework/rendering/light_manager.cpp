@@ -0,0 +1,111 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "rendering/light_manager.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/helpers.h"
+#include "rendering/render_frame.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+const std::vector<Light> &LightManager::update(const std::vector<sg::Light *> &scene_lights)
+{
+	bool changed = lights.size() != scene_lights.size();
+
+	lights.resize(scene_lights.size());
+
+	for (size_t i = 0; i < scene_lights.size(); ++i)
+	{
+		auto        scene_light = scene_lights[i];
+		const auto &properties  = scene_light->get_properties();
+		auto &      transform   = scene_light->get_node()->get_transform();
+
+		Light light{{transform.get_translation(), static_cast<float>(scene_light->get_light_type())},
+		            {properties.color, properties.intensity},
+		            {transform.get_rotation() * properties.direction, properties.range},
+		            {properties.inner_cone_angle, properties.outer_cone_angle}};
+
+		// Converting is cheaper than uploading, so only the lights that changed are uploaded
+		if (changed || std::memcmp(&lights[i], &light, sizeof(Light)) != 0)
+		{
+			lights[i] = light;
+			changed   = true;
+		}
+	}
+
+	if (changed)
+	{
+		++version;
+	}
+
+	return lights;
+}
+
+BufferAllocation LightManager::request_buffer(RenderFrame &render_frame, const std::vector<sg::Light *> &scene_lights, size_t size)
+{
+	buffer_size = std::max(buffer_size, size);
+
+	auto &frame_buffer = frame_buffers[&render_frame];
+
+	bool used = frame_buffer.buffer && frame_buffer.reset_count == render_frame.get_reset_count();
+
+	if (used && frame_buffer.scene_lights == scene_lights && frame_buffer.buffer->get_size() >= size)
+	{
+		return {*frame_buffer.buffer, frame_buffer.buffer->get_size(), 0};
+	}
+
+	update(scene_lights);
+
+	assert(LIGHTS_OFFSET + lights.size() * sizeof(Light) <= buffer_size && "Exceeding Max Light Capacity");
+
+	// Commands of the frame may already use the buffer, otherwise they completed before the frame was reset
+	if (used || !frame_buffer.buffer || frame_buffer.buffer->get_size() < buffer_size)
+	{
+		if (frame_buffer.buffer)
+		{
+			render_frame.release_deferred(std::move(frame_buffer.buffer));
+		}
+
+		frame_buffer.buffer  = std::make_unique<core::Buffer>(render_frame.get_device(), buffer_size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+		frame_buffer.version = version - 1;
+	}
+
+	if (frame_buffer.version != version)
+	{
+		uint32_t count = to_u32(lights.size());
+
+		frame_buffer.buffer->update(count);
+		frame_buffer.buffer->update(reinterpret_cast<const uint8_t *>(lights.data()), lights.size() * sizeof(Light), LIGHTS_OFFSET);
+
+		frame_buffer.version = version;
+	}
+
+	frame_buffer.reset_count  = render_frame.get_reset_count();
+	frame_buffer.scene_lights = scene_lights;
+
+	return {*frame_buffer.buffer, frame_buffer.buffer->get_size(), 0};
+}
+}        // namespace vkb
@@ -0,0 +1,116 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer_pool.h"
+#include "common/error.h"
+#include "core/buffer.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+namespace sg
+{
+class Light;
+}
+
+class RenderFrame;
+
+struct alignas(16) Light
+{
+	glm::vec4 position;         // position.w represents type of light
+	glm::vec4 color;            // color.w represents light intensity
+	glm::vec4 direction;        // direction.w represents range
+	glm::vec2 info;             // (only used for spot lights) info.x represents light inner cone angle, info.y represents light outer cone angle
+};
+
+/**
+ * @brief Gathers the lights of a scene for the shaders once per frame, for all the subpasses drawing it
+ *
+ * The light buffers hold a light count followed by the lights, which is the layout of the
+ * ForwardLights and DeferredLights uniform blocks, so the buffer of a frame is bound by every
+ * subpass of the frame. Each render frame keeps its buffer, which is only written again once
+ * the lights changed, so static lights are not uploaded every frame.
+ */
+class LightManager
+{
+  public:
+	/// Offset in bytes of the lights in a light buffer, after the light count
+	static constexpr uint32_t LIGHTS_OFFSET = sizeof(glm::vec4);
+
+	LightManager() = default;
+
+	LightManager(const LightManager &) = delete;
+
+	LightManager(LightManager &&) = default;
+
+	LightManager &operator=(const LightManager &) = delete;
+
+	LightManager &operator=(LightManager &&) = default;
+
+	/**
+	 * @brief Converts the lights for the shaders
+	 * @return The lights, in the order of the scene lights
+	 */
+	const std::vector<Light> &update(const std::vector<sg::Light *> &scene_lights);
+
+	/**
+	 * @brief Requests the light buffer of a frame, only gathering the lights on the first request of the frame
+	 *        The buffer is only written if the lights changed since it was last written
+	 * @param render_frame Frame the buffer is used by
+	 * @param scene_lights Lights of the scene
+	 * @param size Minimum size in bytes of the buffer, the size of the uniform block of the shader
+	 * @return A view of the buffer, valid until the frame is reset
+	 */
+	BufferAllocation request_buffer(RenderFrame &render_frame, const std::vector<sg::Light *> &scene_lights, size_t size);
+
+  private:
+	struct FrameBuffer
+	{
+		std::unique_ptr<core::Buffer> buffer;
+
+		/// Version of the lights written in the buffer
+		uint32_t version{0};
+
+		/// Number of resets of the frame when the buffer was last requested
+		uint32_t reset_count{0};
+
+		std::vector<sg::Light *> scene_lights;
+	};
+
+	std::vector<Light> lights;
+
+	/// Incremented each time the converted lights change
+	uint32_t version{0};
+
+	std::unordered_map<const RenderFrame *, FrameBuffer> frame_buffers;
+
+	/// Largest size requested, so that the buffer of a frame fits every subpass
+	size_t buffer_size{0};
+};
+}        // namespace vkb
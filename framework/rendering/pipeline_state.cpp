@@ -20,6 +20,11 @@
 
 #include "pipeline_state.h"
 
+#include <algorithm>
+
+#include "common/logging.h"
+#include "common/resource_caching.h"
+
 bool operator==(const VkVertexInputAttributeDescription &lhs, const VkVertexInputAttributeDescription &rhs)
 {
 	return std::tie(lhs.binding, lhs.format, lhs.location, lhs.offset) == std::tie(rhs.binding, rhs.format, rhs.location, rhs.offset);
@@ -87,11 +92,13 @@ bool operator!=(const vkb::ColorBlendState &lhs, const vkb::ColorBlendState &rhs
 
 namespace vkb
 {
+constexpr size_t SpecializationConstantState::MAX_CONSTANTS;
+
 void SpecializationConstantState::reset()
 {
 	if (dirty)
 	{
-		specialization_constant_state.clear();
+		constant_count = 0;
 	}
 
 	dirty = false;
@@ -109,26 +116,68 @@ void SpecializationConstantState::clear_dirty()
 
 void SpecializationConstantState::set_constant(uint32_t constant_id, const std::vector<uint8_t> &value)
 {
-	auto data = specialization_constant_state.find(constant_id);
+	set_constant(constant_id, value.data(), to_u32(value.size()));
+}
+
+void SpecializationConstantState::set_constant(uint32_t constant_id, const uint8_t *data, uint32_t size)
+{
+	auto it = std::lower_bound(constants.begin(), constants.begin() + constant_count, constant_id,
+	                           [](const SpecializationConstant &constant, uint32_t id) { return constant.constant_id < id; });
+
+	bool found = it != constants.begin() + constant_count && it->constant_id == constant_id;
 
-	if (data != specialization_constant_state.end() && data->second == value)
+	if (found && it->size == size && std::equal(data, data + size, it->data.begin()))
 	{
 		return;
 	}
 
+	if (size > sizeof(SpecializationConstant::data))
+	{
+		LOGE("Ignore specialization constant {} of {} bytes", constant_id, size);
+		return;
+	}
+
+	if (!found)
+	{
+		if (constant_count == MAX_CONSTANTS)
+		{
+			LOGE("Ignore specialization constant {}, more than {} constants are set", constant_id, MAX_CONSTANTS);
+			return;
+		}
+
+		// Shift the following constants to keep them sorted
+		std::move_backward(it, constants.begin() + constant_count, constants.begin() + constant_count + 1);
+
+		it->constant_id = constant_id;
+
+		constant_count++;
+	}
+
 	dirty = true;
 
-	specialization_constant_state[constant_id] = value;
+	it->size = size;
+	it->data.fill(0);
+	std::copy(data, data + size, it->data.begin());
 }
 
-void SpecializationConstantState::set_specialization_constant_state(const std::map<uint32_t, std::vector<uint8_t>> &state)
+const SpecializationConstant *SpecializationConstantState::begin() const
 {
-	specialization_constant_state = state;
+	return constants.data();
 }
 
-const std::map<uint32_t, std::vector<uint8_t>> &SpecializationConstantState::get_specialization_constant_state() const
+const SpecializationConstant *SpecializationConstantState::end() const
 {
-	return specialization_constant_state;
+	return constants.data() + constant_count;
+}
+
+size_t SpecializationConstantState::size() const
+{
+	return constant_count;
+}
+
+PipelineState::PipelineState()
+{
+	reset();
 }
 
 void PipelineState::reset()
@@ -154,52 +203,95 @@ void PipelineState::reset()
 	color_blend_state = {};
 
 	subpass_index = {0U};
+
+	hashes = {};
+
+	hashes.specialization_constants = std::hash<SpecializationConstantState>{}(specialization_constant_state);
+	hashes.vertex_input             = std::hash<VertexInputState>{}(vertex_input_sate);
+	hashes.input_assembly           = std::hash<InputAssemblyState>{}(input_assembly_state);
+	hashes.viewport                 = std::hash<ViewportState>{}(viewport_state);
+	hashes.multisample              = std::hash<MultisampleState>{}(multisample_state);
+	hashes.color_blend              = std::hash<ColorBlendState>{}(color_blend_state);
+
+	update_rasterization_hash();
+	update_depth_stencil_hash();
 }
 
-void PipelineState::set_pipeline_layout(PipelineLayout &new_pipeline_layout)
+void PipelineState::set_extended_dynamic_state(bool enable)
 {
-	if (pipeline_layout)
+	if (extended_dynamic_state != enable)
 	{
-		if (pipeline_layout->get_handle() != new_pipeline_layout.get_handle())
-		{
-			pipeline_layout = &new_pipeline_layout;
+		extended_dynamic_state = enable;
 
-			dirty = true;
-		}
-	}
-	else
-	{
-		pipeline_layout = &new_pipeline_layout;
+		update_rasterization_hash();
+		update_depth_stencil_hash();
 
 		dirty = true;
 	}
 }
 
-void PipelineState::set_render_pass(const RenderPass &new_render_pass)
+bool PipelineState::is_extended_dynamic_state() const
 {
-	if (render_pass)
+	return extended_dynamic_state;
+}
+
+void PipelineState::set_pipeline_layout(PipelineLayout &new_pipeline_layout)
+{
+	if (pipeline_layout && pipeline_layout->get_id() == new_pipeline_layout.get_id())
 	{
-		if (render_pass->get_handle() != new_render_pass.get_handle())
-		{
-			render_pass = &new_render_pass;
+		return;
+	}
 
-			dirty = true;
-		}
+	pipeline_layout = &new_pipeline_layout;
+
+	hashes.pipeline_layout = 0U;
+	hash_combine(hashes.pipeline_layout, pipeline_layout->get_id());
+
+	for (auto stage : pipeline_layout->get_shader_program().get_shader_modules())
+	{
+		hash_combine(hashes.pipeline_layout, stage->get_id());
 	}
-	else
+
+	dirty = true;
+}
+
+void PipelineState::set_render_pass(const RenderPass &new_render_pass)
+{
+	if (render_pass && render_pass->get_id() == new_render_pass.get_id())
 	{
-		render_pass = &new_render_pass;
+		return;
+	}
 
-		dirty = true;
+	// Compatible render passes share their pipelines, so that changing load and store operations or layouts
+	// does not create new ones. The pipeline state still refers to the render pass last set on it
+	bool compatible = render_pass && render_pass->get_compatibility_hash() == new_render_pass.get_compatibility_hash();
+
+	render_pass = &new_render_pass;
+
+	if (compatible)
+	{
+		return;
 	}
+
+	hashes.render_pass = 0U;
+	hash_combine(hashes.render_pass, render_pass->get_compatibility_hash());
+
+	dirty = true;
 }
 
 void PipelineState::set_specialization_constant(uint32_t constant_id, const std::vector<uint8_t> &data)
 {
-	specialization_constant_state.set_constant(constant_id, data);
+	set_specialization_constant(constant_id, data.data(), to_u32(data.size()));
+}
+
+void PipelineState::set_specialization_constant(uint32_t constant_id, const uint8_t *data, uint32_t size)
+{
+	specialization_constant_state.set_constant(constant_id, data, size);
 
 	if (specialization_constant_state.is_dirty())
 	{
+		hashes.specialization_constants = std::hash<SpecializationConstantState>{}(specialization_constant_state);
+
 		dirty = true;
 	}
 }
@@ -210,6 +302,8 @@ void PipelineState::set_vertex_input_state(const VertexInputState &new_vertex_in
 	{
 		vertex_input_sate = new_vertex_input_sate;
 
+		hashes.vertex_input = std::hash<VertexInputState>{}(vertex_input_sate);
+
 		dirty = true;
 	}
 }
@@ -220,6 +314,8 @@ void PipelineState::set_input_assembly_state(const InputAssemblyState &new_input
 	{
 		input_assembly_state = new_input_assembly_state;
 
+		hashes.input_assembly = std::hash<InputAssemblyState>{}(input_assembly_state);
+
 		dirty = true;
 	}
 }
@@ -230,6 +326,8 @@ void PipelineState::set_rasterization_state(const RasterizationState &new_raster
 	{
 		rasterization_state = new_rasterization_state;
 
+		update_rasterization_hash();
+
 		dirty = true;
 	}
 }
@@ -240,6 +338,8 @@ void PipelineState::set_viewport_state(const ViewportState &new_viewport_state)
 	{
 		viewport_state = new_viewport_state;
 
+		hashes.viewport = std::hash<ViewportState>{}(viewport_state);
+
 		dirty = true;
 	}
 }
@@ -250,6 +350,8 @@ void PipelineState::set_multisample_state(const MultisampleState &new_multisampl
 	{
 		multisample_state = new_multisample_state;
 
+		hashes.multisample = std::hash<MultisampleState>{}(multisample_state);
+
 		dirty = true;
 	}
 }
@@ -260,6 +362,8 @@ void PipelineState::set_depth_stencil_state(const DepthStencilState &new_depth_s
 	{
 		depth_stencil_state = new_depth_stencil_state;
 
+		update_depth_stencil_hash();
+
 		dirty = true;
 	}
 }
@@ -270,6 +374,8 @@ void PipelineState::set_color_blend_state(const ColorBlendState &new_color_blend
 	{
 		color_blend_state = new_color_blend_state;
 
+		hashes.color_blend = std::hash<ColorBlendState>{}(color_blend_state);
+
 		dirty = true;
 	}
 }
@@ -350,4 +456,81 @@ void PipelineState::clear_dirty()
 	dirty = false;
 	specialization_constant_state.clear_dirty();
 }
+
+std::size_t PipelineState::get_hash() const
+{
+	std::size_t result = 0;
+
+	hash_combine(result, hashes.pipeline_layout);
+
+	// For graphics only
+	if (render_pass)
+	{
+		hash_combine(result, hashes.render_pass);
+	}
+
+	hash_combine(result, hashes.specialization_constants);
+	hash_combine(result, subpass_index);
+	hash_combine(result, hashes.vertex_input);
+	hash_combine(result, hashes.input_assembly);
+	hash_combine(result, hashes.viewport);
+	hash_combine(result, hashes.rasterization);
+	hash_combine(result, hashes.multisample);
+	hash_combine(result, hashes.depth_stencil);
+	hash_combine(result, hashes.color_blend);
+
+	return result;
+}
+
+void PipelineState::update_rasterization_hash()
+{
+	if (!extended_dynamic_state)
+	{
+		hashes.rasterization = std::hash<RasterizationState>{}(rasterization_state);
+		return;
+	}
+
+	RasterizationState static_state = rasterization_state;
+	static_state.cull_mode          = VK_CULL_MODE_NONE;
+	static_state.front_face         = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+	hashes.rasterization = std::hash<RasterizationState>{}(static_state);
+}
+
+void PipelineState::update_depth_stencil_hash()
+{
+	if (!extended_dynamic_state)
+	{
+		hashes.depth_stencil = std::hash<DepthStencilState>{}(depth_stencil_state);
+		return;
+	}
+
+	DepthStencilState static_state  = depth_stencil_state;
+	static_state.depth_test_enable  = VK_FALSE;
+	static_state.depth_write_enable = VK_FALSE;
+	static_state.depth_compare_op   = VK_COMPARE_OP_NEVER;
+
+	hashes.depth_stencil = std::hash<DepthStencilState>{}(static_state);
+}
+
+std::size_t PipelineState::get_derivative_hash() const
+{
+	std::size_t result = 0;
+
+	hash_combine(result, hashes.pipeline_layout);
+
+	if (render_pass)
+	{
+		hash_combine(result, hashes.render_pass);
+	}
+
+	hash_combine(result, hashes.specialization_constants);
+	hash_combine(result, subpass_index);
+	hash_combine(result, hashes.vertex_input);
+	hash_combine(result, hashes.input_assembly);
+	hash_combine(result, hashes.viewport);
+	hash_combine(result, hashes.multisample);
+
+	return result;
+}
 }        // namespace vkb
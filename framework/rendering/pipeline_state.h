@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include <array>
 #include <vector>
 
 #include "common/vk_common.h"
@@ -136,10 +137,23 @@ struct ColorBlendState
 	std::vector<ColorBlendAttachmentState> attachments;
 };
 
+/// Value of a specialization constant, stored inline as constants are scalars of at most 64 bits
+struct SpecializationConstant
+{
+	uint32_t constant_id{0};
+
+	uint32_t size{0};
+
+	std::array<uint8_t, 8> data{};
+};
+
 /// Helper class to create specialization constants for a Vulkan pipeline. The state tracks a pipeline globally, and not per shader. Two shaders using the same constant_id will have the same data.
+/// Constants are kept sorted by id in fixed size storage, so that setting them does not allocate.
 class SpecializationConstantState
 {
   public:
+	static constexpr size_t MAX_CONSTANTS = 16;
+
 	void reset();
 
 	bool is_dirty() const;
@@ -151,14 +165,21 @@ class SpecializationConstantState
 
 	void set_constant(uint32_t constant_id, const std::vector<uint8_t> &data);
 
-	void set_specialization_constant_state(const std::map<uint32_t, std::vector<uint8_t>> &state);
+	void set_constant(uint32_t constant_id, const uint8_t *data, uint32_t size);
+
+	const SpecializationConstant *begin() const;
 
-	const std::map<uint32_t, std::vector<uint8_t>> &get_specialization_constant_state() const;
+	const SpecializationConstant *end() const;
+
+	size_t size() const;
 
   private:
 	bool dirty{false};
-	// Map tracking state of the Specialization Constants
-	std::map<uint32_t, std::vector<uint8_t>> specialization_constant_state;
+
+	// State of the Specialization Constants, sorted by constant id
+	std::array<SpecializationConstant, MAX_CONSTANTS> constants{};
+
+	size_t constant_count{0};
 };
 
 template <class T>
@@ -166,9 +187,7 @@ inline void SpecializationConstantState::set_constant(std::uint32_t constant_id,
 {
 	std::uint32_t value = static_cast<std::uint32_t>(data);
 
-	set_constant(constant_id,
-	             {reinterpret_cast<const uint8_t *>(&value),
-	              reinterpret_cast<const uint8_t *>(&value) + sizeof(T)});
+	set_constant(constant_id, reinterpret_cast<const uint8_t *>(&value), to_u32(sizeof(T)));
 }
 
 template <>
@@ -176,22 +195,36 @@ inline void SpecializationConstantState::set_constant<bool>(std::uint32_t consta
 {
 	std::uint32_t value = static_cast<std::uint32_t>(data_);
 
-	set_constant(constant_id,
-	             {reinterpret_cast<const uint8_t *>(&value),
-	              reinterpret_cast<const uint8_t *>(&value) + sizeof(std::uint32_t)});
+	set_constant(constant_id, reinterpret_cast<const uint8_t *>(&value), to_u32(sizeof(std::uint32_t)));
 }
 
+/// State of a pipeline, tracked by command buffers to create pipelines when it changes.
+/// The hash of each sub-state is updated when a setter changes it, so that hashing the
+/// whole state only combines them.
 class PipelineState
 {
   public:
+	PipelineState();
+
 	void reset();
 
+	/**
+	 * @brief Makes the cull mode, front face, depth test, depth write and depth compare op dynamic states
+	 *        of the graphics pipelines, which are then left out of the hash. Kept on reset()
+	 * @param enable True if VK_EXT_extended_dynamic_state is enabled on the device
+	 */
+	void set_extended_dynamic_state(bool enable);
+
+	bool is_extended_dynamic_state() const;
+
 	void set_pipeline_layout(PipelineLayout &pipeline_layout);
 
 	void set_render_pass(const RenderPass &render_pass);
 
 	void set_specialization_constant(uint32_t constant_id, const std::vector<uint8_t> &data);
 
+	void set_specialization_constant(uint32_t constant_id, const uint8_t *data, uint32_t size);
+
 	void set_vertex_input_state(const VertexInputState &vertex_input_sate);
 
 	void set_input_assembly_state(const InputAssemblyState &input_assembly_state);
@@ -234,9 +267,45 @@ class PipelineState
 
 	void clear_dirty();
 
+	/**
+	 * @return Hash of the whole state, combined from the hashes of the sub-states
+	 */
+	std::size_t get_hash() const;
+
+	/**
+	 * @return Hash of the sub-states shared by the pipelines that can derive from each other,
+	 *         which may only differ by their rasterization, depth stencil and color blend states
+	 */
+	std::size_t get_derivative_hash() const;
+
   private:
 	bool dirty{false};
 
+	bool extended_dynamic_state{false};
+
+	/// Hashes the rasterization state, without the dynamic states if extended_dynamic_state is set
+	void update_rasterization_hash();
+
+	/// Hashes the depth stencil state, without the dynamic states if extended_dynamic_state is set
+	void update_depth_stencil_hash();
+
+	/**
+	 * @brief Hashes of the sub-states, updated when their value changes
+	 */
+	struct
+	{
+		std::size_t pipeline_layout{0U};
+		std::size_t render_pass{0U};
+		std::size_t specialization_constants{0U};
+		std::size_t vertex_input{0U};
+		std::size_t input_assembly{0U};
+		std::size_t rasterization{0U};
+		std::size_t viewport{0U};
+		std::size_t multisample{0U};
+		std::size_t depth_stencil{0U};
+		std::size_t color_blend{0U};
+	} hashes;
+
 	PipelineLayout *pipeline_layout{nullptr};
 
 	const RenderPass *render_pass{nullptr};
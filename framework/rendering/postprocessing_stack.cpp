@@ -0,0 +1,133 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "rendering/postprocessing_stack.h"
+
+#include "core/device.h"
+
+namespace vkb
+{
+PostProcessingStack::PostProcessingStack(RenderContext &render_context) :
+    render_context{render_context}
+{
+}
+
+void PostProcessingStack::set_bloom(bool enable, float intensity)
+{
+	bloom_enabled   = enable;
+	bloom_intensity = intensity;
+}
+
+void PostProcessingStack::set_fxaa(bool enable)
+{
+	fxaa_enabled = enable;
+}
+
+void PostProcessingStack::set_color_grading(const ColorGrading &color_grading_)
+{
+	color_grading         = color_grading_;
+	color_grading_enabled = true;
+}
+
+uint32_t PostProcessingStack::add_hdr_attachment(RenderGraph &render_graph, uint32_t max_bits_per_pixel)
+{
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+
+	if (bloom_enabled)
+	{
+		usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+	}
+
+	VkFormat format = render_context.get_device().choose_attachment_format({VK_FORMAT_R16G16B16A16_SFLOAT, VK_FORMAT_B10G11R11_UFLOAT_PACK32}, usage, max_bits_per_pixel);
+
+	LOGI("Post-processing HDR color format: {}", convert_format_to_string(format));
+
+	return render_graph.add_attachment("hdr_color", format);
+}
+
+void PostProcessingStack::add_passes(RenderGraph &render_graph, uint32_t hdr_attachment, uint32_t output_attachment)
+{
+	assert(!tonemapping_subpass && "Post-processing passes already added");
+
+	if (bloom_enabled)
+	{
+		auto bloom = std::make_unique<BloomPass>(render_context, ShaderSource{"postprocessing/bloom.comp"}, hdr_attachment);
+		bloom_pass = bloom.get();
+
+		render_graph.add_compute_pass(std::move(bloom))
+		    .read_sampled(hdr_attachment, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT)
+		    .write_buffer(bloom_pass->get_buffer(), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+	}
+
+	uint32_t tonemapped_attachment = output_attachment;
+
+	if (fxaa_enabled)
+	{
+		tonemapped_attachment = render_graph.add_attachment("tonemapped_color", VK_FORMAT_R8G8B8A8_SRGB);
+	}
+
+	auto tonemapping    = std::make_unique<TonemappingSubpass>(render_context, ShaderSource{"postprocessing/postprocessing.vert"}, ShaderSource{"postprocessing/tonemapping.frag"}, hdr_attachment);
+	tonemapping_subpass = tonemapping.get();
+
+	tonemapping->set_debug_name("tonemapping");
+
+	if (color_grading_enabled)
+	{
+		tonemapping->set_color_grading(color_grading);
+	}
+
+	if (bloom_pass)
+	{
+		tonemapping->set_bloom(*bloom_pass, bloom_intensity);
+	}
+
+	auto &tonemapping_pass = render_graph.add_pass(std::move(tonemapping))
+	                             .read_input(hdr_attachment)
+	                             .write(tonemapped_attachment, true);
+
+	if (bloom_pass)
+	{
+		tonemapping_pass.read_buffer(bloom_pass->get_buffer(), VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+	}
+
+	if (fxaa_enabled)
+	{
+		auto fxaa = std::make_unique<FxaaSubpass>(render_context, ShaderSource{"postprocessing/postprocessing.vert"}, ShaderSource{"postprocessing/fxaa.frag"}, tonemapped_attachment);
+
+		fxaa->set_debug_name("fxaa");
+
+		render_graph.add_pass(std::move(fxaa))
+		    .read_sampled(tonemapped_attachment)
+		    .write(output_attachment, true);
+	}
+}
+
+TonemappingSubpass &PostProcessingStack::get_tonemapping_subpass()
+{
+	assert(tonemapping_subpass && "Post-processing passes not added");
+
+	return *tonemapping_subpass;
+}
+
+BloomPass *PostProcessingStack::get_bloom_pass()
+{
+	return bloom_pass;
+}
+}        // namespace vkb
@@ -0,0 +1,95 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "rendering/bloom_pass.h"
+#include "rendering/render_graph.h"
+#include "rendering/subpasses/fxaa_subpass.h"
+#include "rendering/subpasses/tonemapping_subpass.h"
+
+namespace vkb
+{
+/**
+ * @brief Adds post-processing passes to a RenderGraph, after the passes rendering an HDR color attachment
+ *
+ * Effects are placed where they cost the least bandwidth:
+ * - tonemapping and color grading are per pixel, so they read the HDR color as an input attachment
+ *   and the render graph merges them into the render pass writing it, keeping the HDR color on-tile
+ * - bloom needs wide neighborhoods, so it is a compute pass at reduced resolution sampling the stored
+ *   HDR color, which then splits the render pass before tonemapping
+ * - FXAA needs the neighbors of the tonemapped color, so it samples it in a final render pass
+ */
+class PostProcessingStack
+{
+  public:
+	PostProcessingStack(RenderContext &render_context);
+
+	void set_bloom(bool enable, float intensity = 0.5f);
+
+	void set_fxaa(bool enable);
+
+	void set_color_grading(const ColorGrading &color_grading);
+
+	/**
+	 * @brief Adds an HDR color attachment for the passes to render to, after the effects are set
+	 *        B10G11R11 halves the bandwidth of RGBA16F, and is used when the device can render to it
+	 * @param render_graph Render graph to add the attachment to
+	 * @param max_bits_per_pixel Bandwidth budget of the attachment
+	 * @return Attachment reference number
+	 */
+	uint32_t add_hdr_attachment(RenderGraph &render_graph, uint32_t max_bits_per_pixel = 32);
+
+	/**
+	 * @brief Adds the passes of the enabled effects, which must be set before
+	 * @param render_graph Render graph to add the passes to, before it is compiled
+	 * @param hdr_attachment Attachment holding the HDR color, written by the previous passes
+	 * @param output_attachment Attachment the processed color is written to
+	 */
+	void add_passes(RenderGraph &render_graph, uint32_t hdr_attachment, uint32_t output_attachment = RenderGraph::SWAPCHAIN_ATTACHMENT);
+
+	/**
+	 * @return The tonemapping subpass, owned by the render graph, for instance to change the exposure
+	 */
+	TonemappingSubpass &get_tonemapping_subpass();
+
+	/**
+	 * @return The bloom pass, or nullptr if bloom is disabled
+	 */
+	BloomPass *get_bloom_pass();
+
+  private:
+	RenderContext &render_context;
+
+	bool bloom_enabled{false};
+
+	float bloom_intensity{0.5f};
+
+	bool fxaa_enabled{false};
+
+	bool color_grading_enabled{false};
+
+	ColorGrading color_grading;
+
+	TonemappingSubpass *tonemapping_subpass{nullptr};
+
+	BloomPass *bloom_pass{nullptr};
+};
+}        // namespace vkb
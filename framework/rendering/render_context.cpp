@@ -20,16 +20,33 @@
 
 #include "render_context.h"
 
+#include <algorithm>
+
+VKBP_DISABLE_WARNINGS()
+#include <glm/gtc/matrix_transform.hpp>
+VKBP_ENABLE_WARNINGS()
+
 namespace vkb
 {
 RenderContext::RenderContext(Device &d, VkSurfaceKHR surface, uint32_t window_width, uint32_t window_height) :
     device{d},
-    queue{device.get_suitable_graphics_queue()}
+    queue{device.get_queue_by_role(QueueRole::Graphics)},
+    frame_pacer{d},
+    compute_queue{&device.get_queue_by_role(QueueRole::AsyncCompute)}
 {
 	if (surface != VK_NULL_HANDLE)
 	{
 		swapchain      = std::make_unique<Swapchain>(device, surface);
 		surface_extent = swapchain->get_extent();
+
+		VkSurfaceCapabilitiesKHR surface_properties;
+		VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device.get_physical_device(), surface, &surface_properties));
+
+		if (surface_properties.currentTransform != VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR)
+		{
+			// Nothing is in flight yet, so the swapchain can be replaced right away
+			update_swapchain(surface_extent, surface_properties.currentTransform);
+		}
 	}
 	else
 	{
@@ -41,39 +58,28 @@ void RenderContext::prepare(size_t thread_count, RenderTarget::CreateFunc create
 {
 	device.wait_idle();
 
-	// If swapchain exists, create our RenderFrames from the swapchain (one for each image)
-	if (swapchain)
-	{
-		VkExtent3D extent{surface_extent.width, surface_extent.height, 1};
+	this->create_render_target_func = create_render_target_func;
 
-		for (auto &image_handle : swapchain->get_images())
-		{
-			auto swapchain_image = core::Image{
-			    device, image_handle,
-			    extent,
-			    swapchain->get_format(),
-			    swapchain->get_usage()};
-			auto render_target = create_render_target_func(std::move(swapchain_image));
-			frames.emplace_back(RenderFrame{device, std::move(render_target), thread_count});
-		}
+	uint32_t frame_count = frames_in_flight;
+
+	if (frame_count == 0)
+	{
+		// One frame for each image
+		frame_count = swapchain ? to_u32(swapchain->get_images().size()) : headless_frame_count;
 	}
-	else
+
+	for (uint32_t i = 0; i < frame_count; ++i)
 	{
-		// Otherwise, create a single RenderFrame
-		swapchain = nullptr;
+		frames.emplace_back(RenderFrame{device, thread_count});
+	}
 
-		auto color_image = core::Image{device,
-		                               VkExtent3D{surface_extent.width, surface_extent.height, 1},
-		                               VK_FORMAT_R8G8B8A8_SRGB,        // We can use any format here that we like
-		                               VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
-		                               VMA_MEMORY_USAGE_GPU_ONLY};
+	create_render_targets();
 
-		auto render_target = create_render_target_func(std::move(color_image));
-		frames.emplace_back(RenderFrame{device, std::move(render_target), thread_count});
-	}
+	update_device_masks();
 
-	this->prepared                  = true;
-	this->create_render_target_func = create_render_target_func;
+	frame_readback = std::make_unique<FrameReadback>(device, frames.size());
+
+	this->prepared = true;
 }
 
 void RenderContext::update_swapchain(const VkExtent2D &extent)
@@ -84,11 +90,7 @@ void RenderContext::update_swapchain(const VkExtent2D &extent)
 		return;
 	}
 
-	device.get_resource_cache().clear_framebuffers();
-
-	swapchain = std::make_unique<Swapchain>(*swapchain, extent);
-
-	recreate();
+	replace_swapchain(std::make_unique<Swapchain>(*swapchain, extent));
 }
 
 void RenderContext::update_swapchain(const uint32_t image_count)
@@ -99,11 +101,7 @@ void RenderContext::update_swapchain(const uint32_t image_count)
 		return;
 	}
 
-	device.get_resource_cache().clear_framebuffers();
-
-	swapchain = std::make_unique<Swapchain>(*swapchain, image_count);
-
-	recreate();
+	replace_swapchain(std::make_unique<Swapchain>(*swapchain, image_count));
 }
 
 void RenderContext::update_swapchain(const std::set<VkImageUsageFlagBits> &image_usage_flags)
@@ -114,11 +112,7 @@ void RenderContext::update_swapchain(const std::set<VkImageUsageFlagBits> &image
 		return;
 	}
 
-	device.get_resource_cache().clear_framebuffers();
-
-	swapchain = std::make_unique<Swapchain>(*swapchain, image_usage_flags);
-
-	recreate();
+	replace_swapchain(std::make_unique<Swapchain>(*swapchain, image_usage_flags));
 }
 
 void RenderContext::update_swapchain(const VkExtent2D &extent, const VkSurfaceTransformFlagBitsKHR transform)
@@ -129,8 +123,6 @@ void RenderContext::update_swapchain(const VkExtent2D &extent, const VkSurfaceTr
 		return;
 	}
 
-	device.get_resource_cache().clear_framebuffers();
-
 	auto width  = extent.width;
 	auto height = extent.height;
 	if (transform == VK_SURFACE_TRANSFORM_ROTATE_90_BIT_KHR || transform == VK_SURFACE_TRANSFORM_ROTATE_270_BIT_KHR)
@@ -139,35 +131,332 @@ void RenderContext::update_swapchain(const VkExtent2D &extent, const VkSurfaceTr
 		std::swap(width, height);
 	}
 
-	swapchain = std::make_unique<Swapchain>(*swapchain, VkExtent2D{width, height}, transform);
-
 	// Save the preTransform attribute for future rotations
 	pre_transform = transform;
 
-	recreate();
+	replace_swapchain(std::make_unique<Swapchain>(*swapchain, VkExtent2D{width, height}, transform));
 }
 
-void RenderContext::recreate()
+void RenderContext::replace_swapchain(std::unique_ptr<Swapchain> &&new_swapchain)
 {
+	auto previous_swapchain = std::move(swapchain);
+
+	swapchain = std::move(new_swapchain);
+
+	if (!prepared)
+	{
+		// The render targets are created from the new swapchain
+		return;
+	}
+
+	// The frames in flight keep using the previous images until they are waited for
+	retire_render_targets(std::move(previous_swapchain));
+
+	create_render_targets();
+
 	LOGI("Recreated swapchain");
+}
+
+void RenderContext::retire_render_targets(std::unique_ptr<Swapchain> &&retired_swapchain)
+{
+	auto retired = std::make_shared<RetiredImages>();
+
+	retired->swapchain = std::move(retired_swapchain);
+
+	for (auto &render_target : render_targets)
+	{
+		retired->render_targets.push_back(std::move(render_target));
+	}
+
+	for (auto &present_render_target : present_render_targets)
+	{
+		if (present_render_target)
+		{
+			retired->render_targets.push_back(std::move(present_render_target));
+		}
+	}
+
+	render_targets.clear();
+	present_render_targets.clear();
+
+	auto resource_cache = &device.get_resource_cache();
+
+	release_deferred([retired, resource_cache]() mutable {
+		for (auto &render_target : retired->render_targets)
+		{
+			resource_cache->clear_framebuffers(render_target->get_views());
+		}
+
+		retired.reset();
+	});
+}
+
+void RenderContext::release_deferred(std::function<void()> &&release)
+{
+	if (frames.empty())
+	{
+		// Nothing was submitted through the context yet
+		release();
+		return;
+	}
+
+	// The active frame, or between frames the last one submitted, is the last one which may use the resources
+	frames.at(active_frame_index).release_deferred(std::move(release));
+}
+
+void RenderContext::create_render_targets()
+{
+	std::vector<core::Image> images;
+
+	if (swapchain)
+	{
+		VkExtent2D swapchain_extent = swapchain->get_extent();
+		VkExtent3D extent{swapchain_extent.width, swapchain_extent.height, 1};
+
+		for (auto &image_handle : swapchain->get_images())
+		{
+			images.emplace_back(device, image_handle,
+			                    extent,
+			                    swapchain->get_format(),
+			                    swapchain->get_usage());
+		}
+	}
+	else
+	{
+		for (uint32_t i = 0; i < headless_frame_count; ++i)
+		{
+			images.push_back(create_headless_image());
+		}
+	}
+
+	for (auto &image : images)
+	{
+		std::unique_ptr<RenderTarget> present_render_target;
+
+		render_targets.push_back(std::make_unique<RenderTarget>(create_frame_render_targets(std::move(image), present_render_target)));
+		present_render_targets.push_back(std::move(present_render_target));
+	}
+
+	// Until the frames acquire an image, so that their render targets are always valid
+	for (size_t i = 0; i < frames.size(); ++i)
+	{
+		size_t image_index = i % render_targets.size();
+
+		frames[i].set_render_targets(*render_targets[image_index], present_render_targets[image_index].get());
+	}
+
+	active_image_index = active_image_index % to_u32(render_targets.size());
+
+	// The new images have no contents yet
+	image_damage.assign(render_targets.size(), VkRect2D{{0, 0}, render_targets.front()->get_extent()});
+}
+
+void RenderContext::recreate()
+{
+	retire_render_targets(nullptr);
+
+	create_render_targets();
+
+	LOGI("Recreated render targets");
+}
+
+void RenderContext::update_render_targets(RenderTarget::CreateFunc create_render_target_func)
+{
+	this->create_render_target_func = create_render_target_func;
+
+	if (!prepared)
+	{
+		return;
+	}
+
+	// The previous render targets are released once the frames in flight complete
+	recreate();
+}
+
+void RenderContext::set_frames_in_flight(uint32_t frame_count)
+{
+	if (prepared)
+	{
+		LOGW("Can't change the number of frames in flight after the render context is prepared, skipping.");
+		return;
+	}
+
+	frames_in_flight = frame_count;
+}
+
+void RenderContext::set_render_scale(float scale)
+{
+	assert(scale >= 0.0f && scale <= 1.0f && "Render scale must be in [0, 1]");
+
+	if (scale == render_scale)
+	{
+		return;
+	}
+
+	render_scale = scale;
+
+	// Recreates the render targets of the frames
+	update_render_targets(create_render_target_func);
+}
+
+float RenderContext::get_render_scale() const
+{
+	return render_scale;
+}
+
+VkExtent2D RenderContext::get_render_extent() const
+{
+	if (render_scale == 0.0f)
+	{
+		return surface_extent;
+	}
+
+	return {std::max(1u, static_cast<uint32_t>(surface_extent.width * render_scale + 0.5f)),
+	        std::max(1u, static_cast<uint32_t>(surface_extent.height * render_scale + 0.5f))};
+}
+
+RenderTarget RenderContext::create_frame_render_targets(core::Image &&swapchain_image, std::unique_ptr<RenderTarget> &present_render_target)
+{
+	if (render_scale == 0.0f)
+	{
+		present_render_target = nullptr;
+
+		return create_render_target_func(std::move(swapchain_image));
+	}
+
+	const auto &extent = swapchain_image.get_extent();
+
+	// Sampled by the pass upscaling it to the swapchain image
+	core::Image scaled_image{device,
+	                         VkExtent3D{std::max(1u, static_cast<uint32_t>(extent.width * render_scale + 0.5f)),
+	                                    std::max(1u, static_cast<uint32_t>(extent.height * render_scale + 0.5f)),
+	                                    1},
+	                         swapchain_image.get_format(),
+	                         VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+	                         VMA_MEMORY_USAGE_GPU_ONLY};
+
+	std::vector<core::Image> present_images;
+	present_images.push_back(std::move(swapchain_image));
+
+	present_render_target = std::make_unique<RenderTarget>(std::move(present_images));
+
+	return create_render_target_func(std::move(scaled_image));
+}
+
+core::Image RenderContext::create_headless_image()
+{
+	return core::Image{device,
+	                   VkExtent3D{surface_extent.width, surface_extent.height, 1},
+	                   VK_FORMAT_R8G8B8A8_SRGB,        // We can use any format here that we like
+	                   VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+	                   VMA_MEMORY_USAGE_GPU_ONLY};
+}
+
+void RenderContext::set_headless_frame_count(uint32_t frame_count)
+{
+	assert(frame_count > 0 && "At least one headless frame is required");
+
+	if (prepared)
+	{
+		LOGW("Can't change the headless frame count after the render context is prepared, skipping.");
+		return;
+	}
+
+	headless_frame_count = frame_count;
+}
+
+void RenderContext::set_readback_callback(FrameReadback::Callback callback)
+{
+	readback_callback = std::move(callback);
+}
+
+void RenderContext::request_readback(FrameReadback::Callback callback)
+{
+	readback_requests.push_back(std::move(callback));
+}
+
+void RenderContext::readback_last_frame(FrameReadback::Callback callback)
+{
+	// The copies pending in the buffers of the frames are delivered first, as the copy reuses the buffer of the last frame
+	flush_readback();
+
+	auto &frame = get_last_rendered_frame();
+
+	auto &command_buffer = device.request_command_buffer();
+
+	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+	frame_readback->record(command_buffer, active_frame_index, frame.get_present_render_target().get_views().at(0), VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, std::move(callback));
+	command_buffer.end();
+
+	queue.submit(command_buffer, VK_NULL_HANDLE);
+
+	queue.wait_idle();
+
+	frame_readback->deliver(active_frame_index);
+}
+
+void RenderContext::flush_readback()
+{
+	if (frame_readback)
+	{
+		frame_readback->flush();
+	}
+}
+
+void RenderContext::set_pre_rotation_enabled(bool enabled)
+{
+	if (enabled == pre_rotation_enabled)
+	{
+		return;
+	}
+
+	pre_rotation_enabled = enabled;
+
+	if (!swapchain)
+	{
+		return;
+	}
+
+	VkSurfaceCapabilitiesKHR surface_properties;
+	VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device.get_physical_device(),
+	                                                   swapchain->get_surface(),
+	                                                   &surface_properties));
+
+	update_swapchain(surface_extent, enabled ? surface_properties.currentTransform : VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR);
+}
 
-	VkExtent2D swapchain_extent = swapchain->get_extent();
-	VkExtent3D extent{swapchain_extent.width, swapchain_extent.height, 1};
+bool RenderContext::is_pre_rotation_enabled() const
+{
+	return pre_rotation_enabled;
+}
 
-	auto frame_it = frames.begin();
+glm::mat4 RenderContext::get_pre_rotation() const
+{
+	glm::mat4 pre_rotation{1.0f};
 
-	for (auto &image_handle : swapchain->get_images())
+	if (!swapchain)
 	{
-		core::Image swapchain_image{device, image_handle,
-		                            extent,
-		                            swapchain->get_format(),
-		                            swapchain->get_usage()};
+		return pre_rotation;
+	}
 
-		auto render_target = create_render_target_func(std::move(swapchain_image));
-		frame_it->update_render_target(std::move(render_target));
+	glm::vec3 rotation_axis{0.0f, 0.0f, -1.0f};
 
-		++frame_it;
+	auto transform = swapchain->get_transform();
+
+	if (transform & VK_SURFACE_TRANSFORM_ROTATE_90_BIT_KHR)
+	{
+		pre_rotation = glm::rotate(pre_rotation, glm::radians(90.0f), rotation_axis);
+	}
+	else if (transform & VK_SURFACE_TRANSFORM_ROTATE_270_BIT_KHR)
+	{
+		pre_rotation = glm::rotate(pre_rotation, glm::radians(270.0f), rotation_axis);
+	}
+	else if (transform & VK_SURFACE_TRANSFORM_ROTATE_180_BIT_KHR)
+	{
+		pre_rotation = glm::rotate(pre_rotation, glm::radians(180.0f), rotation_axis);
 	}
+
+	return pre_rotation;
 }
 
 bool RenderContext::has_swapchain()
@@ -188,16 +477,38 @@ void RenderContext::handle_surface_changes()
 	                                                   swapchain->get_surface(),
 	                                                   &surface_properties));
 
-	if (surface_properties.currentExtent.width != surface_extent.width ||
-	    surface_properties.currentExtent.height != surface_extent.height)
+	// 180 degree rotations don't change the extent, so the transform is checked as well
+	auto transform = pre_rotation_enabled ? surface_properties.currentTransform : pre_transform;
+
+	bool extent_changed = surface_properties.currentExtent.width != surface_extent.width ||
+	                      surface_properties.currentExtent.height != surface_extent.height;
+
+	if (!extent_changed && transform == pre_transform)
+	{
+		swapchain_out_of_date = false;
+		return;
+	}
+
+	auto now = FramePacer::Clock::now();
+
+	// While the window is dragged, the previous swapchain is presented scaled until the size settles
+	if (transform == pre_transform && !swapchain_out_of_date &&
+	    std::chrono::duration<float>(now - last_resize).count() < resize_debounce_time)
 	{
-		// Recreate swapchain
-		device.wait_idle();
+		return;
+	}
 
-		update_swapchain(surface_properties.currentExtent, pre_transform);
+	// Recreate swapchain, the frames in flight keep using the previous one
+	update_swapchain(surface_properties.currentExtent, transform);
 
-		surface_extent = surface_properties.currentExtent;
+	surface_extent = surface_properties.currentExtent;
+
+	if (extent_changed)
+	{
+		last_resize = now;
 	}
+
+	swapchain_out_of_date = false;
 }
 
 CommandBuffer &RenderContext::begin(CommandBuffer::ResetMode reset_mode)
@@ -211,25 +522,63 @@ CommandBuffer &RenderContext::begin(CommandBuffer::ResetMode reset_mode)
 		throw std::runtime_error("Couldn't begin frame");
 	}
 
-	const auto &queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
 	return get_active_frame().request_command_buffer(queue, reset_mode);
 }
 
 void RenderContext::submit(CommandBuffer &command_buffer)
+{
+	submit(std::vector<CommandBuffer *>{&command_buffer});
+}
+
+void RenderContext::submit(const std::vector<CommandBuffer *> &command_buffers)
 {
 	assert(frame_active && "RenderContext is inactive, cannot submit command buffer. Please call begin()");
 
-	VkSemaphore render_semaphore = VK_NULL_HANDLE;
+	QueueSubmitBatch batch;
 
-	if (swapchain)
+	batch.command_buffers.assign(command_buffers.begin(), command_buffers.end());
+
+	if (readback_callback || !readback_requests.empty())
 	{
-		render_semaphore = submit(queue, command_buffer, acquired_semaphore, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		// The copy runs after the frame, in the same submission
+		auto &frame = get_active_frame();
+
+		auto callbacks = std::move(readback_requests);
+		readback_requests.clear();
+
+		if (readback_callback)
+		{
+			callbacks.push_back(readback_callback);
+		}
+
+		auto &readback_command_buffer = frame.request_command_buffer(queue);
+
+		readback_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+		frame_readback->record(readback_command_buffer, active_frame_index, frame.get_present_render_target().get_views().at(0), VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+		                       [callbacks](const ReadbackFrame &readback_frame) {
+			                       for (auto &callback : callbacks)
+			                       {
+				                       callback(readback_frame);
+			                       }
+		                       });
+		readback_command_buffer.end();
+
+		batch.command_buffers.push_back(&readback_command_buffer);
 	}
-	else
+
+	VkSemaphore render_semaphore = VK_NULL_HANDLE;
+
+	if (swapchain)
 	{
-		submit(queue, command_buffer);
+		render_semaphore = get_active_frame().request_semaphore();
+
+		batch.wait_semaphores   = {acquired_semaphore};
+		batch.wait_stages       = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+		batch.signal_semaphores = {render_semaphore};
 	}
 
+	submit(queue, {batch});
+
 	end_frame(render_semaphore);
 
 	acquired_semaphore = VK_NULL_HANDLE;
@@ -237,6 +586,14 @@ void RenderContext::submit(CommandBuffer &command_buffer)
 
 VkSemaphore RenderContext::begin_frame()
 {
+	if (low_latency_enabled)
+	{
+		// The active frame index still refers to the last frame submitted
+		frames.at(active_frame_index).wait();
+	}
+
+	frame_pacer.wait_for_next_frame();
+
 	// Only handle surface changes if a swapchain exists
 	if (swapchain)
 	{
@@ -245,78 +602,564 @@ VkSemaphore RenderContext::begin_frame()
 
 	assert(!frame_active && "Frame is still active, please call end_frame");
 
-	auto &prev_frame = frames.at(active_frame_index);
+	// The frames are used in turn, whichever image they render to
+	active_frame_index = (active_frame_index + 1) % to_u32(frames.size());
 
-	auto aquired_semaphore = prev_frame.request_semaphore();
+	// Now the frame is active again
+	frame_active = true;
 
-	if (swapchain)
+	wait_frame();
+
+	device.get_resource_cache().update(to_u32(frames.size()));
+
+	if (frame_readback)
 	{
-		auto fence = prev_frame.request_fence();
+		// The frame completed its previous rendering, so its pixels can be read
+		frame_readback->deliver(active_frame_index);
+	}
 
-		auto result = swapchain->acquire_next_image(active_frame_index, aquired_semaphore, fence);
+	auto &frame = get_active_frame();
+
+	auto aquired_semaphore = frame.request_semaphore();
+
+	if (swapchain)
+	{
+		// The submissions of the frame wait for the acquire semaphore, so their fences cover the acquire too
+		auto result = swapchain->acquire_next_image(active_image_index, aquired_semaphore, VK_NULL_HANDLE, frame.get_device_mask());
 
 		if (result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR)
 		{
+			auto previous_swapchain = swapchain.get();
+
+			swapchain_out_of_date = result == VK_ERROR_OUT_OF_DATE_KHR;
+
 			handle_surface_changes();
 
-			result = swapchain->acquire_next_image(active_frame_index, aquired_semaphore, fence);
+			if (result == VK_ERROR_OUT_OF_DATE_KHR || swapchain.get() != previous_swapchain)
+			{
+				result = swapchain->acquire_next_image(active_image_index, aquired_semaphore, VK_NULL_HANDLE, frame.get_device_mask());
+			}
+			else
+			{
+				// The recreation is deferred, the image acquired is presented scaled meanwhile
+				result = VK_SUCCESS;
+			}
 		}
 
 		if (result != VK_SUCCESS)
 		{
-			prev_frame.reset();
+			frame.reset();
+
+			frame_active = false;
 
 			return VK_NULL_HANDLE;
 		}
+
+		pending_acquire_semaphore = aquired_semaphore;
+	}
+	else
+	{
+		// The headless images are rendered to in turn, as swapchain images would be
+		active_image_index = (active_image_index + 1) % to_u32(render_targets.size());
 	}
 
-	// Now the frame is active again
-	frame_active = true;
+	frame.set_render_targets(*render_targets.at(active_image_index), present_render_targets.at(active_image_index).get());
 
-	wait_frame();
+	update_render_area();
 
 	return aquired_semaphore;
 }
 
-VkSemaphore RenderContext::submit(const Queue &queue, const CommandBuffer &command_buffer, VkSemaphore wait_semaphore, VkPipelineStageFlags wait_pipeline_stage)
+void RenderContext::update_render_area()
 {
-	RenderFrame &frame = get_active_frame();
+	auto &render_target = *render_targets.at(active_image_index);
+
+	VkRect2D full_area{{0, 0}, render_target.get_extent()};
+
+	bool pre_rotated = swapchain && swapchain->get_transform() != VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+
+	// The damage is tracked in the pixels of the images, which the render targets of offscreen rendering do not match
+	if (!incremental_rendering_enabled || pre_rotated || present_render_targets.at(active_image_index))
+	{
+		render_target.set_render_area(full_area);
+		return;
+	}
+
+	VkRect2D area = intersect_rects(image_damage.at(active_image_index), full_area);
 
-	VkSemaphore signal_semaphore = frame.request_semaphore();
+	// A render pass needs a render area, redrawing a single unchanged pixel is the cheapest frame
+	if (area.extent.width == 0 || area.extent.height == 0)
+	{
+		area = {{0, 0}, {1, 1}};
+	}
 
-	VkCommandBuffer cmd_buf = command_buffer.get_handle();
+	render_target.set_render_area(area);
+
+	image_damage.at(active_image_index) = {};
+}
 
-	VkSubmitInfo submit_info{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+VkSemaphore RenderContext::submit(const Queue &queue, const CommandBuffer &command_buffer, VkSemaphore wait_semaphore, VkPipelineStageFlags wait_pipeline_stage)
+{
+	VkSemaphore signal_semaphore = get_active_frame().request_semaphore();
 
-	submit_info.commandBufferCount   = 1;
-	submit_info.pCommandBuffers      = &cmd_buf;
-	submit_info.waitSemaphoreCount   = 1;
-	submit_info.pWaitSemaphores      = &wait_semaphore;
-	submit_info.pWaitDstStageMask    = &wait_pipeline_stage;
-	submit_info.signalSemaphoreCount = 1;
-	submit_info.pSignalSemaphores    = &signal_semaphore;
+	QueueSubmitBatch batch;
 
-	VkFence fence = frame.request_fence();
+	batch.command_buffers   = {&command_buffer};
+	batch.wait_semaphores   = {wait_semaphore};
+	batch.wait_stages       = {wait_pipeline_stage};
+	batch.signal_semaphores = {signal_semaphore};
 
-	queue.submit({submit_info}, fence);
+	submit(queue, {batch});
 
 	return signal_semaphore;
 }
 
 void RenderContext::submit(const Queue &queue, const CommandBuffer &command_buffer)
 {
+	QueueSubmitBatch batch;
+
+	batch.command_buffers = {&command_buffer};
+
+	submit(queue, {batch});
+}
+
+void RenderContext::submit(const Queue &queue, const std::vector<QueueSubmitBatch> &batches)
+{
+	assert(frame_active && "RenderContext is inactive, cannot submit command buffer. Please call begin()");
+
+	if (compute_semaphores.empty())
+	{
+		submit_to_queue(queue, batches);
+		return;
+	}
+
+	// The first batch waits for the results of the compute submissions
+	std::vector<QueueSubmitBatch> graphics_batches = batches;
+
+	auto &first_batch = graphics_batches.front();
+
+	first_batch.wait_semaphores.insert(first_batch.wait_semaphores.end(), compute_semaphores.begin(), compute_semaphores.end());
+	first_batch.wait_stages.insert(first_batch.wait_stages.end(), compute_wait_stages.begin(), compute_wait_stages.end());
+
+	compute_semaphores.clear();
+	compute_wait_stages.clear();
+
+	submit_to_queue(queue, graphics_batches);
+}
+
+void RenderContext::submit_to_queue(const Queue &queue, const std::vector<QueueSubmitBatch> &batches)
+{
+	assert(!batches.empty() && "At least one batch is required to submit to a queue");
+
 	RenderFrame &frame = get_active_frame();
 
-	VkCommandBuffer cmd_buf = command_buffer.get_handle();
+	// The data written to the buffer pools since the last submission is made visible at once
+	frame.flush_buffers();
+
+	size_t batch_count = batches.size();
+
+	std::vector<std::vector<VkCommandBuffer>> command_buffers(batch_count);
+	std::vector<std::vector<VkSemaphore>>     signal_semaphores(batch_count);
+	std::vector<std::vector<uint64_t>>        wait_values(batch_count);
+	std::vector<std::vector<uint64_t>>        signal_values(batch_count);
+
+	for (size_t i = 0; i < batch_count; ++i)
+	{
+		auto &batch = batches[i];
+
+		assert(batch.wait_semaphores.size() == batch.wait_stages.size() && "Every wait semaphore requires a wait stage");
+
+		if (std::find(batch.wait_semaphores.begin(), batch.wait_semaphores.end(), pending_acquire_semaphore) != batch.wait_semaphores.end())
+		{
+			pending_acquire_semaphore = VK_NULL_HANDLE;
+		}
+
+		for (auto command_buffer : batch.command_buffers)
+		{
+			command_buffers[i].push_back(command_buffer->get_handle());
+		}
+
+		signal_semaphores[i] = batch.signal_semaphores;
+
+		// The binary semaphores ignore their values
+		wait_values[i].resize(batch.wait_semaphores.size(), 0);
+		signal_values[i].resize(signal_semaphores[i].size(), 0);
+	}
+
+	if (submission_profiling_enabled && frame.get_submission_profiler().is_supported(queue))
+	{
+		auto &submission_profiler = frame.get_submission_profiler();
+
+		for (auto &batch_command_buffers : command_buffers)
+		{
+			auto &begin_command_buffer = frame.request_command_buffer(queue);
+
+			begin_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+			bool measured = submission_profiler.begin_submission(begin_command_buffer, queue);
+			begin_command_buffer.end();
+
+			if (!measured)
+			{
+				break;
+			}
+
+			auto &end_command_buffer = frame.request_command_buffer(queue);
+
+			end_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+			submission_profiler.end_submission(end_command_buffer);
+			end_command_buffer.end();
+
+			batch_command_buffers.insert(batch_command_buffers.begin(), begin_command_buffer.get_handle());
+			batch_command_buffers.push_back(end_command_buffer.get_handle());
+		}
+	}
+
+	if (timeline_semaphores_enabled)
+	{
+		// Signaled by the last batch, after the commands of all previous batches have completed
+		auto &timeline = device.get_queue_timeline(queue);
+
+		signal_semaphores.back().push_back(timeline.get_handle());
+		signal_values.back().push_back(timeline.request_value());
+
+		frame.add_timeline_wait(timeline, signal_values.back().back());
+	}
+	else
+	{
+		// A single fence per queue is signaled when the frame ends
+		frame.add_queue_submission(queue);
+	}
+
+	std::vector<VkTimelineSemaphoreSubmitInfoKHR> timeline_infos(batch_count, {VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR});
+	std::vector<VkDeviceGroupSubmitInfoKHR>       device_group_infos(batch_count, {VK_STRUCTURE_TYPE_DEVICE_GROUP_SUBMIT_INFO_KHR});
+	std::vector<VkSubmitInfo>                     submit_infos(batch_count, {VK_STRUCTURE_TYPE_SUBMIT_INFO});
+
+	// With a device group, the semaphores are waited and signaled by the first GPU rendering the frame
+	uint32_t device_mask  = frame.get_device_mask();
+	uint32_t device_index = 0;
+	while (device_mask != 0 && (device_mask & (1u << device_index)) == 0)
+	{
+		device_index++;
+	}
+
+	std::vector<std::vector<uint32_t>> command_buffer_device_masks(batch_count);
+	std::vector<std::vector<uint32_t>> wait_device_indices(batch_count);
+	std::vector<std::vector<uint32_t>> signal_device_indices(batch_count);
+
+	for (size_t i = 0; i < batch_count; ++i)
+	{
+		auto &batch       = batches[i];
+		auto &submit_info = submit_infos[i];
+
+		submit_info.commandBufferCount   = to_u32(command_buffers[i].size());
+		submit_info.pCommandBuffers      = command_buffers[i].data();
+		submit_info.waitSemaphoreCount   = to_u32(batch.wait_semaphores.size());
+		submit_info.pWaitSemaphores      = batch.wait_semaphores.data();
+		submit_info.pWaitDstStageMask    = batch.wait_stages.data();
+		submit_info.signalSemaphoreCount = to_u32(signal_semaphores[i].size());
+		submit_info.pSignalSemaphores    = signal_semaphores[i].data();
+
+		if (timeline_semaphores_enabled)
+		{
+			auto &timeline_info = timeline_infos[i];
+
+			timeline_info.waitSemaphoreValueCount   = to_u32(wait_values[i].size());
+			timeline_info.pWaitSemaphoreValues      = wait_values[i].data();
+			timeline_info.signalSemaphoreValueCount = to_u32(signal_values[i].size());
+			timeline_info.pSignalSemaphoreValues    = signal_values[i].data();
+
+			submit_info.pNext = &timeline_info;
+		}
+
+		if (device_mask != 0)
+		{
+			auto &device_group_info = device_group_infos[i];
+
+			command_buffer_device_masks[i].resize(command_buffers[i].size(), device_mask);
+			wait_device_indices[i].resize(batch.wait_semaphores.size(), device_index);
+			signal_device_indices[i].resize(signal_semaphores[i].size(), device_index);
+
+			device_group_info.commandBufferCount            = to_u32(command_buffer_device_masks[i].size());
+			device_group_info.pCommandBufferDeviceMasks     = command_buffer_device_masks[i].data();
+			device_group_info.waitSemaphoreCount            = to_u32(wait_device_indices[i].size());
+			device_group_info.pWaitSemaphoreDeviceIndices   = wait_device_indices[i].data();
+			device_group_info.signalSemaphoreCount          = to_u32(signal_device_indices[i].size());
+			device_group_info.pSignalSemaphoreDeviceIndices = signal_device_indices[i].data();
+
+			device_group_info.pNext = submit_info.pNext;
+			submit_info.pNext       = &device_group_info;
+		}
+	}
+
+	queue.submit(submit_infos, VK_NULL_HANDLE);
+}
+
+void RenderContext::set_low_latency_enabled(bool enabled)
+{
+	low_latency_enabled = enabled;
+}
+
+bool RenderContext::is_low_latency_enabled() const
+{
+	return low_latency_enabled;
+}
+
+void RenderContext::set_device_group_mode(DeviceGroupMode mode)
+{
+	if (mode != DeviceGroupMode::None && !device.is_device_group_enabled())
+	{
+		LOGW("Device group mode ignored, the device has a single GPU");
+		mode = DeviceGroupMode::None;
+	}
+
+	if (mode != DeviceGroupMode::None && swapchain)
+	{
+		VkDeviceGroupPresentCapabilitiesKHR capabilities{VK_STRUCTURE_TYPE_DEVICE_GROUP_PRESENT_CAPABILITIES_KHR};
+		VK_CHECK(vkGetDeviceGroupPresentCapabilitiesKHR(device.get_handle(), &capabilities));
+
+		// In the local modes, each GPU presents the instance of the image it rendered
+		bool self_present = true;
+		for (uint32_t i = 0; i < device.get_device_group_size(); i++)
+		{
+			self_present &= (capabilities.presentMask[i] & (1u << i)) != 0;
+		}
+
+		auto present_modes = swapchain->get_device_group_present_modes();
+
+		if (mode == DeviceGroupMode::SplitFrame && (!self_present || !(present_modes & VK_DEVICE_GROUP_PRESENT_MODE_LOCAL_MULTI_DEVICE_BIT_KHR)))
+		{
+			LOGW("Split frame rendering disabled, the GPUs cannot present together, alternating the frames instead");
+			mode = DeviceGroupMode::AlternateFrame;
+		}
+
+		if (mode == DeviceGroupMode::AlternateFrame && (!self_present || !(present_modes & VK_DEVICE_GROUP_PRESENT_MODE_LOCAL_BIT_KHR)))
+		{
+			LOGW("Alternate frame rendering disabled, the GPUs cannot present on their own");
+			mode = DeviceGroupMode::None;
+		}
+	}
+	else if (mode == DeviceGroupMode::SplitFrame)
+	{
+		// Without presentation, the bands rendered by the other GPUs would have to be copied to a single instance
+		LOGW("Split frame rendering disabled without a swapchain, alternating the frames instead");
+		mode = DeviceGroupMode::AlternateFrame;
+	}
+
+	device_group_mode = mode;
+
+	update_device_masks();
+}
+
+DeviceGroupMode RenderContext::get_device_group_mode() const
+{
+	return device_group_mode;
+}
+
+void RenderContext::update_device_masks()
+{
+	uint32_t device_count = device.get_device_group_size();
+
+	if (device_group_mode == DeviceGroupMode::AlternateFrame && frames.size() % device_count != 0)
+	{
+		LOGW("{} frames alternate between {} GPUs, some GPUs render more frames than others", frames.size(), device_count);
+	}
+
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		switch (device_group_mode)
+		{
+			case DeviceGroupMode::AlternateFrame:
+				frames[i].set_device_mask(1u << (i % device_count));
+				break;
+			case DeviceGroupMode::SplitFrame:
+				frames[i].set_device_mask(device.get_device_group_mask(), true);
+				break;
+			default:
+				frames[i].set_device_mask(0);
+				break;
+		}
+	}
+}
+
+void RenderContext::set_resize_debounce_time(float seconds)
+{
+	resize_debounce_time = std::max(seconds, 0.0f);
+}
+
+float RenderContext::get_resize_debounce_time() const
+{
+	return resize_debounce_time;
+}
+
+FramePacer &RenderContext::get_frame_pacer()
+{
+	return frame_pacer;
+}
+
+LightManager &RenderContext::get_light_manager()
+{
+	return light_manager;
+}
+
+const Queue &RenderContext::get_compute_queue() const
+{
+	return *compute_queue;
+}
+
+bool RenderContext::has_async_compute() const
+{
+	return compute_queue != &queue;
+}
+
+CommandBuffer &RenderContext::request_compute_command_buffer(CommandBuffer::ResetMode reset_mode)
+{
+	assert(frame_active && "RenderContext is inactive, cannot request a compute command buffer. Please call begin()");
+
+	return get_active_frame().request_command_buffer(*compute_queue, reset_mode);
+}
+
+void RenderContext::submit_compute(const CommandBuffer &command_buffer, VkPipelineStageFlags dst_stage_mask)
+{
+	assert(frame_active && "RenderContext is inactive, cannot submit command buffer. Please call begin()");
+
+	VkSemaphore signal_semaphore = get_active_frame().request_semaphore();
+
+	QueueSubmitBatch batch;
+
+	batch.command_buffers   = {&command_buffer};
+	batch.signal_semaphores = {signal_semaphore};
+
+	submit_to_queue(*compute_queue, {batch});
+
+	compute_semaphores.push_back(signal_semaphore);
+	compute_wait_stages.push_back(dst_stage_mask);
+}
+
+void RenderContext::transfer_to_graphics(CommandBuffer &compute_command_buffer, CommandBuffer &graphics_command_buffer, const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size, const BufferMemoryBarrier &memory_barrier)
+{
+	uint32_t compute_family  = compute_queue->get_family_index();
+	uint32_t graphics_family = queue.get_family_index();
+
+	if (compute_family == graphics_family)
+	{
+		// The semaphore orders the submissions, the barrier makes the writes visible
+		compute_command_buffer.buffer_memory_barrier(buffer, offset, size, memory_barrier);
+		return;
+	}
+
+	BufferMemoryBarrier release_barrier = memory_barrier;
+	release_barrier.dst_stage_mask      = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+	release_barrier.dst_access_mask     = 0;
+	release_barrier.old_queue_family    = compute_family;
+	release_barrier.new_queue_family    = graphics_family;
+
+	compute_command_buffer.buffer_memory_barrier(buffer, offset, size, release_barrier);
+
+	BufferMemoryBarrier acquire_barrier = memory_barrier;
+	acquire_barrier.src_stage_mask      = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	acquire_barrier.src_access_mask     = 0;
+	acquire_barrier.old_queue_family    = compute_family;
+	acquire_barrier.new_queue_family    = graphics_family;
+
+	graphics_command_buffer.buffer_memory_barrier(buffer, offset, size, acquire_barrier);
+}
+
+void RenderContext::transfer_to_graphics(CommandBuffer &compute_command_buffer, CommandBuffer &graphics_command_buffer, const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier)
+{
+	uint32_t compute_family  = compute_queue->get_family_index();
+	uint32_t graphics_family = queue.get_family_index();
+
+	if (compute_family == graphics_family)
+	{
+		compute_command_buffer.image_memory_barrier(image_view, memory_barrier);
+		return;
+	}
+
+	// Both halves of the transfer perform the same layout transition
+	ImageMemoryBarrier release_barrier = memory_barrier;
+	release_barrier.dst_stage_mask     = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+	release_barrier.dst_access_mask    = 0;
+	release_barrier.old_queue_family   = compute_family;
+	release_barrier.new_queue_family   = graphics_family;
 
-	VkSubmitInfo submit_info{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+	compute_command_buffer.image_memory_barrier(image_view, release_barrier);
 
-	submit_info.commandBufferCount = 1;
-	submit_info.pCommandBuffers    = &cmd_buf;
+	ImageMemoryBarrier acquire_barrier = memory_barrier;
+	acquire_barrier.src_stage_mask     = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	acquire_barrier.src_access_mask    = 0;
+	acquire_barrier.old_queue_family   = compute_family;
+	acquire_barrier.new_queue_family   = graphics_family;
 
-	VkFence fence = frame.request_fence();
+	graphics_command_buffer.image_memory_barrier(image_view, acquire_barrier);
+}
+
+void RenderContext::set_timeline_semaphores_enabled(bool enabled)
+{
+	if (enabled && !device.is_timeline_semaphore_enabled())
+	{
+		LOGW("VK_KHR_timeline_semaphore is not enabled, frames are synchronized with fences");
+		enabled = false;
+	}
+
+	timeline_semaphores_enabled = enabled;
+}
+
+bool RenderContext::is_timeline_semaphores_enabled() const
+{
+	return timeline_semaphores_enabled;
+}
+
+void RenderContext::set_submission_profiling_enabled(bool enabled)
+{
+	submission_profiling_enabled = enabled;
+}
+
+bool RenderContext::is_submission_profiling_enabled() const
+{
+	return submission_profiling_enabled;
+}
 
-	queue.submit({submit_info}, fence);
+const Queue &RenderContext::get_queue() const
+{
+	return queue;
+}
+
+void RenderContext::set_incremental_rendering_enabled(bool enabled)
+{
+	if (enabled && !incremental_rendering_enabled)
+	{
+		// The images were last rendered without tracking what changed since
+		add_full_damage();
+	}
+
+	incremental_rendering_enabled = enabled;
+}
+
+bool RenderContext::is_incremental_rendering_enabled() const
+{
+	return incremental_rendering_enabled;
+}
+
+void RenderContext::add_damage(const VkRect2D &region)
+{
+	for (auto &damage : image_damage)
+	{
+		damage = merge_rects(damage, region);
+	}
+}
+
+void RenderContext::add_full_damage()
+{
+	for (size_t i = 0; i < image_damage.size(); ++i)
+	{
+		image_damage[i] = {{0, 0}, render_targets.at(i)->get_extent()};
+	}
+}
+
+bool RenderContext::has_damage() const
+{
+	return !incremental_rendering_enabled ||
+	       std::find_if(image_damage.begin(), image_damage.end(), [](const VkRect2D &damage) { return damage.extent.width > 0 && damage.extent.height > 0; }) != image_damage.end();
 }
 
 void RenderContext::wait_frame()
@@ -329,6 +1172,20 @@ void RenderContext::end_frame(VkSemaphore semaphore)
 {
 	assert(frame_active && "Frame is not active, please call begin_frame");
 
+	// The acquire semaphore must be unsignaled before it is reused, and covered by the fences of the frame,
+	// so an empty submission waits on it if none of the frame did
+	if (pending_acquire_semaphore != VK_NULL_HANDLE)
+	{
+		QueueSubmitBatch batch;
+
+		batch.wait_semaphores = {pending_acquire_semaphore};
+		batch.wait_stages     = {VK_PIPELINE_STAGE_ALL_COMMANDS_BIT};
+
+		submit_to_queue(queue, {batch});
+	}
+
+	get_active_frame().signal_fences();
+
 	if (swapchain)
 	{
 		VkSwapchainKHR vk_swapchain = swapchain->get_handle();
@@ -339,12 +1196,53 @@ void RenderContext::end_frame(VkSemaphore semaphore)
 		present_info.pWaitSemaphores    = &semaphore;
 		present_info.swapchainCount     = 1;
 		present_info.pSwapchains        = &vk_swapchain;
-		present_info.pImageIndices      = &active_frame_index;
+		present_info.pImageIndices      = &active_image_index;
+		present_info.pNext              = frame_pacer.prepare_present(*swapchain);
+
+		const RenderTarget &render_target = *render_targets.at(active_image_index);
+
+		VkRectLayerKHR      present_rect{};
+		VkPresentRegionKHR  present_region{};
+		VkPresentRegionsKHR present_regions{VK_STRUCTURE_TYPE_PRESENT_REGIONS_KHR};
+
+		// Only the render area changed since the image was last presented
+		if (device.is_incremental_present_enabled() && render_target.is_partial_render_area())
+		{
+			present_rect.offset = render_target.get_render_area().offset;
+			present_rect.extent = render_target.get_render_area().extent;
+
+			present_region.rectangleCount = 1;
+			present_region.pRectangles    = &present_rect;
+
+			present_regions.pNext          = present_info.pNext;
+			present_regions.swapchainCount = 1;
+			present_regions.pRegions       = &present_region;
+
+			present_info.pNext = &present_regions;
+		}
+
+		// The GPUs which rendered the frame present their instance of the image
+		uint32_t                    present_device_mask = get_active_frame().get_device_mask();
+		VkDeviceGroupPresentInfoKHR device_group_present{VK_STRUCTURE_TYPE_DEVICE_GROUP_PRESENT_INFO_KHR};
+
+		if (present_device_mask != 0)
+		{
+			device_group_present.swapchainCount = 1;
+			device_group_present.pDeviceMasks   = &present_device_mask;
+			device_group_present.mode           = get_active_frame().is_split_frame() ? VK_DEVICE_GROUP_PRESENT_MODE_LOCAL_MULTI_DEVICE_BIT_KHR : VK_DEVICE_GROUP_PRESENT_MODE_LOCAL_BIT_KHR;
+
+			device_group_present.pNext = present_info.pNext;
+			present_info.pNext         = &device_group_present;
+		}
 
 		VkResult result = queue.present(present_info);
 
+		frame_pacer.on_present();
+
 		if (result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR)
 		{
+			swapchain_out_of_date = result == VK_ERROR_OUT_OF_DATE_KHR;
+
 			handle_surface_changes();
 		}
 	}
@@ -398,6 +1296,11 @@ uint32_t RenderContext::get_active_frame_index() const
 	return active_frame_index;
 }
 
+uint32_t RenderContext::get_active_image_index() const
+{
+	return active_image_index;
+}
+
 std::vector<RenderFrame> &RenderContext::get_render_frames()
 {
 	return frames;
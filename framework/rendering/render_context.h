@@ -20,6 +20,12 @@
 
 #pragma once
 
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
 #include "common/helpers.h"
 #include "common/vk_common.h"
 #include "core/command_buffer.h"
@@ -33,6 +39,9 @@
 #include "core/render_pass.h"
 #include "core/shader_module.h"
 #include "core/swapchain.h"
+#include "rendering/frame_pacer.h"
+#include "rendering/frame_readback.h"
+#include "rendering/light_manager.h"
 #include "rendering/pipeline_state.h"
 #include "rendering/render_frame.h"
 #include "rendering/render_target.h"
@@ -40,6 +49,36 @@
 
 namespace vkb
 {
+/**
+ * @brief A group of command buffers submitted together, waiting on and signaling the same semaphores
+ */
+struct QueueSubmitBatch
+{
+	std::vector<const CommandBuffer *> command_buffers;
+
+	std::vector<VkSemaphore> wait_semaphores;
+
+	/// One stage mask for each wait semaphore
+	std::vector<VkPipelineStageFlags> wait_stages;
+
+	std::vector<VkSemaphore> signal_semaphores;
+};
+
+/**
+ * @brief How the GPUs of a device group share the frames, see RenderContext::set_device_group_mode()
+ */
+enum class DeviceGroupMode
+{
+	/// The frames do not select GPUs, every GPU executes every command buffer
+	None,
+
+	/// Each frame is rendered and presented by a single GPU, the frames use the GPUs in turn
+	AlternateFrame,
+
+	/// Every GPU renders a horizontal band of each render pass, and they present their bands together
+	SplitFrame
+};
+
 /**
  * @brief RenderContext acts as a frame manager for the sample, with a lifetime that is the
  * same as that of the Application itself. It acts as a container for RenderFrame objects,
@@ -50,10 +89,16 @@ namespace vkb
  * It requires a Device to be valid on creation, and will take control of a given Swapchain.
  *
  * For normal rendering (using a swapchain), the RenderContext can be created by passing in a
- * swapchain. A RenderFrame will then be created for each Swapchain image.
+ * swapchain. A RenderTarget is then created for each Swapchain image, and by default a RenderFrame
+ * as well. The number of frames in flight can be set apart from the number of images, as the
+ * RenderFrames are used in turn, each rendering to the render target of the image it acquired.
+ * Unless disabled, the swapchain is pre-rotated to match the current transform of the surface,
+ * sparing the compositor a rotation pass, and the cameras are to apply @ref get_pre_rotation.
  *
  * For headless rendering (no swapchain), the RenderContext can be given a valid Device, and
- * a width and height. A single RenderFrame will then be created.
+ * a width and height. A ring of offscreen images then stands in for the swapchain images.
+ *
+ * In both modes, the rendered images can be read back asynchronously.
  */
 class RenderContext
 {
@@ -76,6 +121,9 @@ class RenderContext
 	RenderContext &operator=(const RenderContext &) = delete;
 
 	RenderContext &operator=(RenderContext &&) = delete;
+	/// Number of images rendered to in headless mode, unless set otherwise
+	static constexpr uint32_t DEFAULT_HEADLESS_FRAME_COUNT{3};
+
 	/**
 	 * @brief Prepares the RenderFrames for rendering
 	 * @param thread_count The number of threads in the application, necessary to allocate this many resource pools for each RenderFrame
@@ -109,10 +157,91 @@ class RenderContext
 	void update_swapchain(const VkExtent2D &extent, const VkSurfaceTransformFlagBitsKHR transform);
 
 	/**
-	 * @brief Recreates the RenderFrames, called after every update
+	 * @brief Recreates the render targets of the swapchain images, called after every update
+	 *        The previous ones are destroyed once no frame in flight uses them
 	 */
 	void recreate();
 
+	/**
+	 * @brief Replaces the function used to create the RenderTarget of each image,
+	 *        recreating the render targets if the RenderFrames are already prepared
+	 * @param create_render_target_func A function delegate, used to create a RenderTarget
+	 */
+	void update_render_targets(RenderTarget::CreateFunc create_render_target_func);
+
+	/**
+	 * @brief Sets how many frames can be in flight, each with its own command buffers, descriptor sets and
+	 *        buffer pools, independently of the number of swapchain images. Fewer frames than images saves
+	 *        per-frame memory and bounds the latency, while the images still let the presentation queue up.
+	 *        It is to be called before prepare()
+	 * @param frame_count The number of frames, or 0 for one frame per swapchain image
+	 */
+	void set_frames_in_flight(uint32_t frame_count);
+
+	/**
+	 * @brief Renders the frames to offscreen render targets of a scaled extent, which are then to be
+	 *        upscaled to the swapchain images held by the present render targets of the frames.
+	 *        The render targets are recreated if the RenderFrames are already prepared.
+	 * @param scale Scale applied to the swapchain extent, in (0, 1], or 0 to render directly to the swapchain images
+	 */
+	void set_render_scale(float scale);
+
+	float get_render_scale() const;
+
+	/**
+	 * @return The extent of the render targets of the frames, the surface extent scaled by the render scale
+	 */
+	VkExtent2D get_render_extent() const;
+
+	/**
+	 * @brief Sets how many offscreen images are rendered to in turn in headless mode
+	 *        It is to be called before prepare()
+	 */
+	void set_headless_frame_count(uint32_t frame_count);
+
+	/**
+	 * @brief Copies the image of each frame rendered back to host memory
+	 *        The pixels of a frame are handed to the callback once its rendering has completed,
+	 *        without stalling the frames in flight.
+	 * @param callback Function receiving the pixels of the frames, or an empty function to stop the readback
+	 */
+	void set_readback_callback(FrameReadback::Callback callback);
+
+	/**
+	 * @brief Copies the image of the next frame submitted back to host memory, once
+	 *        The callback is called when the frame is used again, a few frames later
+	 * @param callback Function receiving the pixels of the frame
+	 */
+	void request_readback(FrameReadback::Callback callback);
+
+	/**
+	 * @brief Copies the image of the last frame rendered back to host memory, and hands it to the callback before returning
+	 *        It waits for the device to be idle, so it is meant for one-off captures, e.g. right before exiting
+	 * @param callback Function receiving the pixels of the frame
+	 */
+	void readback_last_frame(FrameReadback::Callback callback);
+
+	/**
+	 * @brief Waits for the frames in flight and hands their pixels to the readback callback
+	 */
+	void flush_readback();
+
+	/**
+	 * @brief Selects whether the swapchain images follow the current transform of the surface
+	 *        With pre-rotation, the images keep the native orientation of the display and the application
+	 *        rotates its rendering, otherwise the compositor rotates the images when presenting them.
+	 *        The swapchain is recreated if the setting changes.
+	 */
+	void set_pre_rotation_enabled(bool enabled);
+
+	bool is_pre_rotation_enabled() const;
+
+	/**
+	 * @return The rotation the view space is to be transformed by for the transform of the swapchain,
+	 *         the identity if there is no swapchain
+	 */
+	glm::mat4 get_pre_rotation() const;
+
 	/**
 	 * @returns True if a valid swapchain exists in the RenderContext
 	 */
@@ -131,6 +260,13 @@ class RenderContext
 	 */
 	void submit(CommandBuffer &command_buffer);
 
+	/**
+	 * @brief Submits the command buffers of the frame to the right queue with a single vkQueueSubmit,
+	 *        executing them in order
+	 * @param command_buffers Command buffers containing recorded commands
+	 */
+	void submit(const std::vector<CommandBuffer *> &command_buffers);
+
 	/**
 	 * @brief begin_frame
 	 *
@@ -145,6 +281,145 @@ class RenderContext
 	 */
 	void submit(const Queue &queue, const CommandBuffer &command_buffer);
 
+	/**
+	 * @brief Submits several batches of command buffers related to a frame to a queue with a single vkQueueSubmit
+	 *        Completion is tracked by the fence of the queue signaled at the end of the frame, or by one queue timeline signal
+	 * @param batches Command buffers grouped by the semaphores they wait on and signal, in submission order
+	 */
+	void submit(const Queue &queue, const std::vector<QueueSubmitBatch> &batches);
+
+	/**
+	 * @brief Enables the low latency mode, in which begin_frame() waits for the previous frame to complete
+	 *        before acquiring the next image. Only one frame is in flight, so the CPU work of a frame starts
+	 *        as late as possible, at the cost of the CPU and the GPU no longer overlapping.
+	 */
+	void set_low_latency_enabled(bool enabled);
+
+	bool is_low_latency_enabled() const;
+
+	/**
+	 * @brief Sets how the GPUs of a device group render the frames, see Device::is_device_group_enabled()
+	 *        With alternate frames, frame i is rendered by GPU i modulo the number of GPUs, so the resources of
+	 *        each frame are only used by one GPU, and the frame count should be a multiple of the GPU count.
+	 *        Split frames need the GPUs to present together to the surface, otherwise the frames alternate instead.
+	 *        Alternate frames need each GPU to present on its own, otherwise the mode is ignored, and without a
+	 *        swapchain the frames are read back from the GPU which rendered them.
+	 *        It is ignored if the device has a single GPU.
+	 */
+	void set_device_group_mode(DeviceGroupMode mode);
+
+	DeviceGroupMode get_device_group_mode() const;
+
+	/**
+	 * @brief Sets the minimum time between two recreations of the swapchain for a change of the surface extent.
+	 *        While a window is resized, the previous swapchain is presented until the time has passed, so that
+	 *        a single recreation happens for the many sizes of a drag. A swapchain out of date is always
+	 *        recreated, as it can no longer be presented.
+	 * @param seconds The minimum time, 0 to recreate the swapchain on every change
+	 */
+	void set_resize_debounce_time(float seconds);
+
+	float get_resize_debounce_time() const;
+
+	/**
+	 * @brief Enables incremental rendering, in which each frame only renders the regions of its image damaged
+	 *        since the image was last rendered, and presents them with VK_KHR_incremental_present if enabled.
+	 *        The render targets of the images keep their contents between frames, so the render pipeline must
+	 *        only write the pixels it shades, without effects sampling neighbouring pixels of other passes.
+	 *        It is ignored while rendering offscreen and while the surface is pre-rotated.
+	 */
+	void set_incremental_rendering_enabled(bool enabled);
+
+	bool is_incremental_rendering_enabled() const;
+
+	/**
+	 * @brief Marks a region of the frames as changed, so that every image renders it again
+	 * @param region The damaged region, in pixels of the render targets
+	 */
+	void add_damage(const VkRect2D &region);
+
+	/**
+	 * @brief Marks the whole frames as changed
+	 */
+	void add_full_damage();
+
+	/**
+	 * @return Whether any image has a damaged region left to render
+	 */
+	bool has_damage() const;
+
+	/**
+	 * @return The frame pacing of the context, through which a target frame time can be set
+	 */
+	FramePacer &get_frame_pacer();
+
+	/**
+	 * @return The lights of the frames, uploaded once per frame for all the subpasses
+	 */
+	LightManager &get_light_manager();
+
+	/**
+	 * @return The queue compute work is submitted to, which is a queue distinct from the graphics one
+	 *         if the device has any, so that compute work can overlap the graphics work
+	 */
+	const Queue &get_compute_queue() const;
+
+	/**
+	 * @return Whether compute submissions go to a queue other than the graphics queue
+	 */
+	bool has_async_compute() const;
+
+	/**
+	 * @brief Requests a command buffer for the compute queue from the active frame
+	 */
+	CommandBuffer &request_compute_command_buffer(CommandBuffer::ResetMode reset_mode = CommandBuffer::ResetMode::ResetPool);
+
+	/**
+	 * @brief Submits a command buffer to the compute queue
+	 *        The next graphics submission of the frame waits for it with a semaphore
+	 * @param command_buffer A command buffer requested with request_compute_command_buffer()
+	 * @param dst_stage_mask Stages of the graphics submission consuming the results of the compute work
+	 */
+	void submit_compute(const CommandBuffer &command_buffer, VkPipelineStageFlags dst_stage_mask);
+
+	/**
+	 * @brief Records the barriers handing a buffer written by compute work over to the graphics work
+	 *        If the queues belong to different families, the release half of the ownership transfer is
+	 *        recorded to the compute command buffer and the acquire half to the graphics command buffer.
+	 *        Otherwise the barrier is only recorded to the compute command buffer.
+	 * @param memory_barrier Stages and accesses of the compute writes and of the graphics reads
+	 */
+	void transfer_to_graphics(CommandBuffer &compute_command_buffer, CommandBuffer &graphics_command_buffer, const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size, const BufferMemoryBarrier &memory_barrier);
+
+	/**
+	 * @brief Records the barriers handing an image written by compute work over to the graphics work
+	 * @param memory_barrier Stages, accesses and layouts of the compute writes and of the graphics reads
+	 */
+	void transfer_to_graphics(CommandBuffer &compute_command_buffer, CommandBuffer &graphics_command_buffer, const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier);
+
+	/**
+	 * @brief Selects how the completion of the frames is tracked
+	 *        With timeline semaphores, each submission signals the next value of its queue timeline
+	 *        and frames wait for the last value they were tagged with, instead of a fence per queue.
+	 *        It is ignored if VK_KHR_timeline_semaphore is not enabled on the device.
+	 */
+	void set_timeline_semaphores_enabled(bool enabled);
+
+	bool is_timeline_semaphores_enabled() const;
+
+	/**
+	 * @brief Selects whether the submissions are measured by the submission profiler of the frame
+	 *        Each measured batch is submitted between two command buffers writing timestamps.
+	 */
+	void set_submission_profiling_enabled(bool enabled);
+
+	bool is_submission_profiling_enabled() const;
+
+	/**
+	 * @return The queue the graphics work of the frames is submitted to
+	 */
+	const Queue &get_queue() const;
+
 	/**
 	 * @brief Waits a frame to finish its rendering
 	 */
@@ -166,6 +441,11 @@ class RenderContext
 	 */
 	uint32_t get_active_frame_index();
 
+	/**
+	 * @return The index of the swapchain image (or headless image) the active frame renders to
+	 */
+	uint32_t get_active_image_index() const;
+
 	/**
 	 * @brief An error should be raised if a frame is active.
 	 *        A frame is active after @ref begin_frame has been called.
@@ -173,6 +453,23 @@ class RenderContext
 	 */
 	RenderFrame &get_last_rendered_frame();
 
+	/**
+	 * @brief Defers a release until the work submitted so far has completed, which is known when the last
+	 *        frame submitting work is next waited for, so resources can be freed without waiting for the device
+	 */
+	void release_deferred(std::function<void()> &&release);
+
+	/**
+	 * @brief Keeps an object alive until the work submitted so far has completed
+	 */
+	template <typename T>
+	void release_deferred(std::unique_ptr<T> &&object)
+	{
+		std::shared_ptr<T> shared{std::move(object)};
+
+		release_deferred([shared]() mutable { shared.reset(); });
+	}
+
 	VkSemaphore request_semaphore();
 
 	Device &get_device();
@@ -199,23 +496,143 @@ class RenderContext
 	/// If swapchain exists, then this will be a present supported queue, else a graphics queue
 	const Queue &queue;
 
+	FramePacer frame_pacer;
+
+	LightManager light_manager;
+
+	bool low_latency_enabled{false};
+
+	bool incremental_rendering_enabled{false};
+
+	/// Regions changed since each image was last rendered, indexed by image index
+	std::vector<VkRect2D> image_damage;
+
+	/**
+	 * @brief Restricts the render area of the render target of the acquired image to its damaged region
+	 */
+	void update_render_area();
+
+	DeviceGroupMode device_group_mode{DeviceGroupMode::None};
+
+	/**
+	 * @brief Assigns the GPUs of the device group to the frames, for the device group mode
+	 */
+	void update_device_masks();
+
+	/// Queue of the compute submissions, the graphics queue if the device has no other compute queue
+	const Queue *compute_queue{nullptr};
+
+	/// Semaphores signaled by the compute submissions, waited for by the next graphics submission
+	std::vector<VkSemaphore> compute_semaphores;
+
+	std::vector<VkPipelineStageFlags> compute_wait_stages;
+
+	/**
+	 * @brief Submits the batches, signaling the queue timeline when they complete, or recording the queue
+	 *        for the fences signaled when the frame ends
+	 */
+	void submit_to_queue(const Queue &queue, const std::vector<QueueSubmitBatch> &batches);
+
+	/**
+	 * @brief Creates the image standing in for a swapchain image in headless mode
+	 */
+	core::Image create_headless_image();
+
+	/**
+	 * @brief Creates the render targets of the swapchain images, or of the headless images,
+	 *        and has each frame refer to those of an image until it acquires one
+	 */
+	void create_render_targets();
+
+	/**
+	 * @brief Creates the render target of a swapchain image
+	 *        When rendering offscreen, the render target is created from a scaled image instead,
+	 *        and the swapchain image goes to the present render target
+	 */
+	RenderTarget create_frame_render_targets(core::Image &&swapchain_image, std::unique_ptr<RenderTarget> &present_render_target);
+
 	std::unique_ptr<Swapchain> swapchain;
 
+	/// Render targets of the images, indexed by image index
+	std::vector<std::unique_ptr<RenderTarget>> render_targets;
+
+	/// Render targets holding the swapchain images when rendering offscreen, null otherwise
+	std::vector<std::unique_ptr<RenderTarget>> present_render_targets;
+
+	/**
+	 * @brief Replaced render targets, and the swapchain of their images if it was replaced as well,
+	 *        which may still be used by frames in flight
+	 */
+	struct RetiredImages
+	{
+		std::unique_ptr<Swapchain> swapchain;
+
+		std::vector<std::unique_ptr<RenderTarget>> render_targets;
+	};
+
+	/**
+	 * @brief Replaces the swapchain with one created from it, and recreates the render targets of the images
+	 *        The previous swapchain is destroyed once every frame has been waited for, instead of waiting for the device
+	 */
+	void replace_swapchain(std::unique_ptr<Swapchain> &&new_swapchain);
+
+	/**
+	 * @brief Retires the render targets of the images, to be destroyed with the given swapchain once the frames
+	 *        using them have completed
+	 */
+	void retire_render_targets(std::unique_ptr<Swapchain> &&retired_swapchain);
+
 	std::vector<RenderFrame> frames;
 
+	/// Number of frames, 0 for one per image
+	uint32_t frames_in_flight{0};
+
 	VkSemaphore acquired_semaphore;
 
+	/// Semaphore the image of the active frame was acquired with, until a submission waits on it
+	VkSemaphore pending_acquire_semaphore{VK_NULL_HANDLE};
+
 	bool prepared{false};
 
+	uint32_t headless_frame_count{DEFAULT_HEADLESS_FRAME_COUNT};
+
+	std::unique_ptr<FrameReadback> frame_readback;
+
+	/// Called with the pixels of every frame, if set
+	FrameReadback::Callback readback_callback;
+
+	/// Called with the pixels of the next frame submitted only
+	std::vector<FrameReadback::Callback> readback_requests;
+
 	/// Current active frame index
 	uint32_t active_frame_index{0};
 
+	/// Image the active frame renders to
+	uint32_t active_image_index{0};
+
 	/// Whether a frame is active or not
 	bool frame_active{false};
 
+	bool timeline_semaphores_enabled{false};
+
+	bool submission_profiling_enabled{false};
+
 	RenderTarget::CreateFunc create_render_target_func = RenderTarget::DEFAULT_CREATE_FUNC;
 
+	/// Scale of the offscreen render targets, 0 when rendering directly to the swapchain images
+	float render_scale{0.0f};
+
 	VkSurfaceTransformFlagBitsKHR pre_transform{VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR};
+
+	bool pre_rotation_enabled{true};
+
+	float resize_debounce_time{0.1f};
+
+	/// When the swapchain was last recreated for a change of the surface extent
+	FramePacer::Clock::time_point last_resize{};
+
+	/// Whether the swapchain was reported out of date, so that it has to be recreated whatever the time since the last one
+	bool swapchain_out_of_date{false};
 };
 
 }        // namespace vkb
@@ -25,20 +25,23 @@
 
 namespace vkb
 {
-RenderFrame::RenderFrame(Device &device, RenderTarget &&render_target, size_t thread_count) :
+RenderFrame::RenderFrame(Device &device, size_t thread_count) :
     device{device},
     fence_pool{device},
     semaphore_pool{device},
-    swapchain_render_target{std::move(render_target)},
+    gpu_profiler{device},
+    submission_profiler{device},
+    performance_query_profiler{device},
     thread_count{thread_count}
 {
-	const std::vector<VkBufferUsageFlags> supported_usages = {VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_BUFFER_USAGE_INDEX_BUFFER_BIT};
+	const std::vector<VkBufferUsageFlags> supported_usages = {VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_BUFFER_USAGE_INDEX_BUFFER_BIT};
 	for (auto &usage : supported_usages)
 	{
 		std::vector<std::pair<BufferPool, BufferBlock *>> usage_buffer_pools;
 		for (size_t i = 0; i < thread_count; i++)
 		{
 			usage_buffer_pools.push_back(std::make_pair(BufferPool{device, BUFFER_POOL_BLOCK_SIZE * 1024, usage}, nullptr));
+			usage_buffer_pools.back().first.set_adaptive_block_size(true);
 		}
 
 		auto res_ins_it = buffer_pools.emplace(usage, std::move(usage_buffer_pools));
@@ -54,6 +57,20 @@ RenderFrame::RenderFrame(Device &device, RenderTarget &&render_target, size_t th
 		descriptor_pools.push_back(std::make_unique<std::unordered_map<std::size_t, DescriptorPool>>());
 		descriptor_sets.push_back(std::make_unique<std::unordered_map<std::size_t, DescriptorSet>>());
 	}
+
+	thread_command_pools.resize(thread_count);
+	arenas.resize(thread_count);
+
+	// Read by the host, so the memory is cached
+	for (size_t i = 0; i < thread_count; i++)
+	{
+		readback_pools.push_back(std::make_pair(BufferPool{device, BUFFER_POOL_BLOCK_SIZE * 1024, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU}, nullptr));
+	}
+
+	readbacks.resize(thread_count);
+
+	descriptor_set_last_use.resize(thread_count);
+	retained_descriptor_sets.resize(thread_count);
 }
 
 Device &RenderFrame::get_device()
@@ -61,9 +78,119 @@ Device &RenderFrame::get_device()
 	return device;
 }
 
-void RenderFrame::update_render_target(RenderTarget &&render_target)
+size_t RenderFrame::get_thread_count() const
+{
+	return thread_count;
+}
+
+size_t RenderFrame::get_buffer_block_count() const
+{
+	size_t block_count = 0;
+
+	for (auto &usage_pools : buffer_pools)
+	{
+		for (auto &pool : usage_pools.second)
+		{
+			block_count += pool.first.get_block_count();
+		}
+	}
+
+	return block_count;
+}
+
+VkDeviceSize RenderFrame::get_buffer_high_water_mark() const
+{
+	VkDeviceSize high_water_mark = 0;
+
+	for (auto &usage_pools : buffer_pools)
+	{
+		for (auto &pool : usage_pools.second)
+		{
+			high_water_mark += pool.first.get_high_water_mark();
+		}
+	}
+
+	return high_water_mark;
+}
+
+void RenderFrame::set_adaptive_buffer_pools(bool enabled)
 {
-	swapchain_render_target = std::move(render_target);
+	for (auto &usage_pools : buffer_pools)
+	{
+		for (auto &pool : usage_pools.second)
+		{
+			pool.first.set_adaptive_block_size(enabled);
+		}
+	}
+}
+
+void RenderFrame::adapt_buffer_pools()
+{
+	// Each allocation has a buffer of its own with this strategy, there is nothing to coalesce
+	if (buffer_allocation_strategy == BufferAllocationStrategy::OneAllocationPerBuffer)
+	{
+		return;
+	}
+
+	bool resized = false;
+
+	for (auto &usage_pools : buffer_pools)
+	{
+		for (auto &pool : usage_pools.second)
+		{
+			resized |= pool.first.adapt_block_size();
+		}
+	}
+
+	// The cached sets may reference the destroyed blocks, whose handles can be reused by new buffers
+	if (resized)
+	{
+		clear_descriptors();
+	}
+}
+
+void RenderFrame::set_render_targets(RenderTarget &render_target, RenderTarget *present_render_target)
+{
+	this->render_target         = &render_target;
+	this->present_render_target = present_render_target;
+}
+
+bool RenderFrame::has_present_render_target() const
+{
+	return present_render_target != nullptr;
+}
+
+RenderTarget &RenderFrame::get_present_render_target()
+{
+	return present_render_target ? *present_render_target : get_render_target();
+}
+
+GpuProfiler &RenderFrame::get_gpu_profiler()
+{
+	return gpu_profiler;
+}
+
+SubmissionProfiler &RenderFrame::get_submission_profiler()
+{
+	return submission_profiler;
+}
+
+PerformanceQueryProfiler &RenderFrame::get_performance_query_profiler()
+{
+	return performance_query_profiler;
+}
+
+void RenderFrame::wait()
+{
+	VK_CHECK(fence_pool.wait());
+
+	for (auto &timeline_wait : timeline_waits)
+	{
+		if (!timeline_wait.first->is_complete(timeline_wait.second))
+		{
+			VK_CHECK(timeline_wait.first->wait(timeline_wait.second));
+		}
+	}
 }
 
 void RenderFrame::reset(bool wait_with_fence)
@@ -75,14 +202,60 @@ void RenderFrame::reset(bool wait_with_fence)
 		fence_pool.reset();
 	}
 
-	for (auto &command_pools_per_queue : command_pools)
+	// Checking the last known value of the timelines is cheap, the device is only asked if needed
+	for (auto &timeline_wait : timeline_waits)
 	{
-		for (auto &command_pool : command_pools_per_queue.second)
+		if (wait_with_fence && !timeline_wait.first->is_complete(timeline_wait.second))
 		{
-			command_pool->reset_pool();
+			VK_CHECK(timeline_wait.first->wait(timeline_wait.second));
 		}
 	}
 
+	timeline_waits.clear();
+
+	submitted_queues.clear();
+
+	for (auto &release : deferred_releases)
+	{
+		release();
+	}
+
+	deferred_releases.clear();
+
+	if (wait_with_fence)
+	{
+		gpu_profiler.resolve();
+		submission_profiler.resolve();
+		performance_query_profiler.resolve();
+	}
+	else
+	{
+		// The work of the frame may still be running, its timestamps cannot be read
+		submission_profiler.clear();
+	}
+
+	resolve_readbacks(wait_with_fence);
+
+	for (auto &thread_pools : thread_command_pools)
+	{
+		for (auto &pools_per_mode : thread_pools.pools)
+		{
+			for (auto &command_pool : pools_per_mode)
+			{
+				if (command_pool)
+				{
+					command_pool->reset_pool();
+				}
+			}
+		}
+	}
+
+	// Blocks can only be destroyed once the device no longer reads them
+	if (wait_with_fence)
+	{
+		adapt_buffer_pools();
+	}
+
 	for (auto &buffer_pools_per_usage : buffer_pools)
 	{
 		for (auto &buffer_pool : buffer_pools_per_usage.second)
@@ -93,43 +266,61 @@ void RenderFrame::reset(bool wait_with_fence)
 	}
 
 	semaphore_pool.reset();
+
+	for (auto &arena : arenas)
+	{
+		arena.reset();
+	}
+
+	// The work of the frame is complete, so its idle descriptor sets can be released
+	++reset_count;
+
+	evict_descriptor_sets();
 }
 
-std::vector<std::unique_ptr<CommandPool>> &RenderFrame::get_command_pools(const Queue &queue, CommandBuffer::ResetMode reset_mode)
+void RenderFrame::resolve_readbacks(bool complete)
 {
-	auto command_pool_it = command_pools.find(queue.get_family_index());
-
-	if (command_pool_it != command_pools.end())
+	for (size_t i = 0; i < thread_count; i++)
 	{
-		if (command_pool_it->second.at(0)->get_reset_mode() != reset_mode)
-		{
-			device.wait_idle();
+		auto &readback_pool = readback_pools[i];
 
-			// Delete pools
-			command_pools.erase(command_pool_it);
-		}
-		else
+		if (complete && !readbacks[i].empty())
 		{
-			return command_pool_it->second;
+			readback_pool.first.invalidate();
+
+			for (auto &readback : readbacks[i])
+			{
+				VkDeviceSize size = readback.allocation.get_size();
+				readback.callback(readback.allocation.map<uint8_t>(static_cast<size_t>(size)), size);
+			}
 		}
+
+		readbacks[i].clear();
+
+		readback_pool.first.reset();
+		readback_pool.second = nullptr;
 	}
+}
 
-	std::vector<std::unique_ptr<CommandPool>> queue_command_pools;
-	for (size_t i = 0; i < thread_count; i++)
+CommandPool &RenderFrame::get_command_pool(const Queue &queue, CommandBuffer::ResetMode reset_mode, size_t thread_index)
+{
+	auto &pools = thread_command_pools[thread_index].pools[static_cast<size_t>(reset_mode)];
+
+	uint32_t family_index = queue.get_family_index();
+
+	if (family_index >= pools.size())
 	{
-		queue_command_pools.push_back(std::make_unique<CommandPool>(device, queue.get_family_index(), this, i, reset_mode));
+		pools.resize(family_index + 1);
 	}
 
-	auto res_ins_it = command_pools.emplace(queue.get_family_index(), std::move(queue_command_pools));
+	auto &command_pool = pools[family_index];
 
-	if (!res_ins_it.second)
+	if (!command_pool)
 	{
-		throw std::runtime_error("Failed to insert command pool");
+		command_pool = std::make_unique<CommandPool>(device, family_index, this, thread_index, reset_mode);
 	}
 
-	command_pool_it = res_ins_it.first;
-
-	return command_pool_it->second;
+	return *command_pool;
 }
 
 const FencePool &RenderFrame::get_fence_pool() const
@@ -142,6 +333,45 @@ VkFence RenderFrame::request_fence()
 	return fence_pool.request_fence();
 }
 
+void RenderFrame::add_queue_submission(const Queue &queue)
+{
+	if (std::find(submitted_queues.begin(), submitted_queues.end(), &queue) == submitted_queues.end())
+	{
+		submitted_queues.push_back(&queue);
+	}
+}
+
+void RenderFrame::signal_fences()
+{
+	for (auto queue : submitted_queues)
+	{
+		// An empty submission signals its fence after the previous submissions of the queue
+		VK_CHECK(queue->submit({}, fence_pool.request_fence()));
+	}
+
+	submitted_queues.clear();
+}
+
+void RenderFrame::release_deferred(std::function<void()> &&release)
+{
+	deferred_releases.push_back(std::move(release));
+}
+
+void RenderFrame::add_timeline_wait(TimelineSemaphore &timeline, uint64_t value)
+{
+	// Values of a timeline only grow, so only the last one needs waiting for
+	for (auto &timeline_wait : timeline_waits)
+	{
+		if (timeline_wait.first == &timeline)
+		{
+			timeline_wait.second = std::max(timeline_wait.second, value);
+			return;
+		}
+	}
+
+	timeline_waits.emplace_back(&timeline, value);
+}
+
 const SemaphorePool &RenderFrame::get_semaphore_pool() const
 {
 	return semaphore_pool;
@@ -154,30 +384,39 @@ VkSemaphore RenderFrame::request_semaphore()
 
 RenderTarget &RenderFrame::get_render_target()
 {
-	return swapchain_render_target;
+	assert(render_target && "The frame has no render target");
+	return *render_target;
 }
 
 const RenderTarget &RenderFrame::get_render_target_const() const
 {
-	return swapchain_render_target;
+	assert(render_target && "The frame has no render target");
+	return *render_target;
 }
 
 CommandBuffer &RenderFrame::request_command_buffer(const Queue &queue, CommandBuffer::ResetMode reset_mode, VkCommandBufferLevel level, size_t thread_index)
 {
 	assert(thread_index < thread_count && "Thread index is out of bounds");
 
-	auto &command_pools = get_command_pools(queue, reset_mode);
-
-	auto command_pool_it = std::find_if(command_pools.begin(), command_pools.end(), [&thread_index](std::unique_ptr<CommandPool> &cmd_pool) { return cmd_pool->get_thread_index() == thread_index; });
-
-	return (*command_pool_it)->request_command_buffer(level);
+	return get_command_pool(queue, reset_mode, thread_index).request_command_buffer(level);
 }
 
-DescriptorSet &RenderFrame::request_descriptor_set(DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos, size_t thread_index)
+DescriptorSet &RenderFrame::request_descriptor_set(DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos, size_t thread_index, bool retain)
 {
 	assert(thread_index < thread_count && "Thread index is out of bounds");
 
 	auto &descriptor_pool = request_resource(device, nullptr, *descriptor_pools.at(thread_index), descriptor_set_layout);
+
+	std::size_t hash{0U};
+	hash_param(hash, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+
+	descriptor_set_last_use[thread_index][hash] = reset_count;
+
+	if (retain)
+	{
+		retained_descriptor_sets[thread_index].insert(hash);
+	}
+
 	return request_resource(device, nullptr, *descriptor_sets.at(thread_index), descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
 }
 
@@ -188,6 +427,18 @@ void RenderFrame::clear_descriptors()
 		desc_sets_per_thread->clear();
 	}
 
+	for (auto &last_use_per_thread : descriptor_set_last_use)
+	{
+		last_use_per_thread.clear();
+	}
+
+	for (auto &retained_per_thread : retained_descriptor_sets)
+	{
+		retained_per_thread.clear();
+	}
+
+	++descriptor_generation;
+
 	for (auto &desc_pools_per_thread : descriptor_pools)
 	{
 		for (auto &desc_pool : *desc_pools_per_thread)
@@ -197,11 +448,112 @@ void RenderFrame::clear_descriptors()
 	}
 }
 
+uint32_t RenderFrame::get_descriptor_generation() const
+{
+	return descriptor_generation;
+}
+
+uint32_t RenderFrame::get_reset_count() const
+{
+	return reset_count;
+}
+
+void RenderFrame::set_device_mask(uint32_t mask, bool split)
+{
+	device_mask = mask;
+	split_frame = split && mask != 0;
+}
+
+uint32_t RenderFrame::get_device_mask() const
+{
+	return device_mask;
+}
+
+bool RenderFrame::is_split_frame() const
+{
+	return split_frame;
+}
+
+void RenderFrame::set_descriptor_set_cache_limits(size_t capacity, uint32_t max_idle_frames)
+{
+	descriptor_set_cache_capacity  = capacity;
+	descriptor_set_max_idle_frames = max_idle_frames;
+}
+
+void RenderFrame::evict_descriptor_sets()
+{
+	for (size_t thread_index = 0; thread_index < thread_count; ++thread_index)
+	{
+		auto &desc_sets = *descriptor_sets[thread_index];
+		auto &last_use  = descriptor_set_last_use[thread_index];
+		auto &retained  = retained_descriptor_sets[thread_index];
+
+		// Sort the cached sets from the least to the most recently used
+		std::vector<std::pair<uint32_t, std::size_t>> usage;
+		usage.reserve(last_use.size());
+
+		for (auto &it : last_use)
+		{
+			if (retained.find(it.first) == retained.end())
+			{
+				usage.emplace_back(it.second, it.first);
+			}
+		}
+
+		std::sort(usage.begin(), usage.end());
+
+		size_t remaining = usage.size();
+
+		for (auto &it : usage)
+		{
+			bool idle = descriptor_set_max_idle_frames > 0 && reset_count - it.first > descriptor_set_max_idle_frames;
+
+			if (!idle && remaining <= descriptor_set_cache_capacity)
+			{
+				break;
+			}
+
+			auto desc_set_it = desc_sets.find(it.second);
+
+			if (desc_set_it != desc_sets.end())
+			{
+				auto &desc_set = desc_set_it->second;
+
+				desc_set.get_descriptor_pool().free(desc_set.get_handle());
+
+				desc_sets.erase(desc_set_it);
+			}
+
+			last_use.erase(it.second);
+
+			--remaining;
+		}
+	}
+}
+
 void RenderFrame::set_buffer_allocation_strategy(BufferAllocationStrategy new_strategy)
 {
 	buffer_allocation_strategy = new_strategy;
 }
 
+FrameArena &RenderFrame::get_arena(size_t thread_index)
+{
+	assert(thread_index < arenas.size() && "Thread index is out of bounds");
+
+	return arenas[thread_index];
+}
+
+void RenderFrame::flush_buffers()
+{
+	for (auto &buffer_pools_per_usage : buffer_pools)
+	{
+		for (auto &buffer_pool : buffer_pools_per_usage.second)
+		{
+			buffer_pool.first.flush();
+		}
+	}
+}
+
 BufferAllocation RenderFrame::allocate_buffer(const VkBufferUsageFlags usage, const VkDeviceSize size, size_t thread_index)
 {
 	assert(thread_index < thread_count && "Thread index is out of bounds");
@@ -236,4 +588,31 @@ BufferAllocation RenderFrame::allocate_buffer(const VkBufferUsageFlags usage, co
 
 	return data;
 }
+
+BufferAllocation RenderFrame::request_readback(VkDeviceSize size, ReadbackCallback &&callback, size_t thread_index)
+{
+	assert(thread_index < thread_count && "Thread index is out of bounds");
+
+	auto &buffer_pool  = readback_pools[thread_index].first;
+	auto &buffer_block = readback_pools[thread_index].second;
+
+	if (!buffer_block)
+	{
+		buffer_block = &buffer_pool.request_buffer_block(to_u32(size));
+	}
+
+	auto data = buffer_block->allocate(to_u32(size));
+
+	if (data.empty())
+	{
+		buffer_block = &buffer_pool.request_buffer_block(to_u32(size));
+
+		data = buffer_block->allocate(to_u32(size));
+	}
+
+	// The callback reads the memory in place, which stays valid until the frame is reset
+	readbacks[thread_index].push_back({BufferAllocation{data.get_buffer(), data.get_size(), data.get_offset()}, std::move(callback)});
+
+	return data;
+}
 }        // namespace vkb
@@ -20,6 +20,9 @@
 
 #pragma once
 
+#include <array>
+#include <functional>
+
 #include "buffer_pool.h"
 #include "common/helpers.h"
 #include "common/resource_caching.h"
@@ -31,8 +34,12 @@
 #include "core/image.h"
 #include "core/queue.h"
 #include "fence_pool.h"
+#include "frame_arena.h"
+#include "gpu_profiler.h"
+#include "performance_query_profiler.h"
 #include "rendering/render_target.h"
 #include "semaphore_pool.h"
+#include "submission_profiler.h"
 
 namespace vkb
 {
@@ -42,28 +49,41 @@ enum BufferAllocationStrategy
 	MultipleAllocationsPerBuffer
 };
 
+/**
+ * @brief Called with the data the GPU wrote to a readback allocation, once the work writing it is complete
+ */
+using ReadbackCallback = std::function<void(const uint8_t *data, VkDeviceSize size)>;
+
 /**
  * @brief RenderFrame is a container for per-frame data, including BufferPool objects,
- * synchronization primitives (semaphores, fences) and the swapchain RenderTarget.
+ * synchronization primitives (semaphores, fences) and the RenderTarget being rendered to.
  *
- * When creating a RenderTarget, we need to provide images that will be used as attachments
- * within a RenderPass. The RenderFrame is responsible for creating a RenderTarget using
- * RenderTarget::CreateFunc. A custom RenderTarget::CreateFunc can be provided if a different
- * render target is required.
+ * The render targets are owned by the RenderContext, one for each swapchain image, which
+ * creates them using RenderTarget::CreateFunc. The RenderFrame only refers to the render targets
+ * of the image it is currently rendering to, as there may be fewer frames in flight than images.
  *
  * A RenderFrame cannot be destroyed individually since frames are managed by the RenderContext,
- * the whole context must be destroyed. This is because each RenderFrame holds Vulkan objects
- * such as the swapchain image.
+ * the whole context must be destroyed.
  */
 class RenderFrame
 {
   public:
 	/**
-	 * @brief Block size of a buffer pool in kilobytes
+	 * @brief Initial block size of a buffer pool in kilobytes, adaptive pools then resize their blocks
 	 */
 	static constexpr uint32_t BUFFER_POOL_BLOCK_SIZE = 256;
 
-	RenderFrame(Device &device, RenderTarget &&render_target, size_t thread_count = 1);
+	/**
+	 * @brief Default number of descriptor sets each thread of the frame keeps cached
+	 */
+	static constexpr size_t DESCRIPTOR_SET_CACHE_CAPACITY = 1024;
+
+	/**
+	 * @brief Default number of resets of the frame a descriptor set can stay unused before it is freed
+	 */
+	static constexpr uint32_t DESCRIPTOR_SET_MAX_IDLE_FRAMES = 120;
+
+	RenderFrame(Device &device, size_t thread_count = 1);
 
 	RenderFrame(const RenderFrame &) = delete;
 
@@ -75,26 +95,102 @@ class RenderFrame
 
 	void reset(bool wait_with_fence = true);
 
+	/**
+	 * @brief Waits for the work submitted in the frame to complete, without resetting it
+	 */
+	void wait();
+
 	Device &get_device();
 
+	/**
+	 * @return The number of threads the frame holds resource pools for
+	 */
+	size_t get_thread_count() const;
+
+	/**
+	 * @return The number of blocks created by the buffer pools of all the threads
+	 */
+	size_t get_buffer_block_count() const;
+
+	/**
+	 * @return The sum over the buffer pools of the largest number of bytes a use of the frame allocated, see BufferPool::get_high_water_mark()
+	 */
+	VkDeviceSize get_buffer_high_water_mark() const;
+
+	/**
+	 * @brief Enables resizing the blocks of the buffer pools from the high-water marks of their allocations,
+	 *        so that each pool ends up with a single block fitting the frames, see BufferPool::set_adaptive_block_size().
+	 *        It is enabled by default, and ignored with the OneAllocationPerBuffer strategy.
+	 */
+	void set_adaptive_buffer_pools(bool enabled);
+
 	const FencePool &get_fence_pool() const;
 
 	VkFence request_fence();
 
+	/**
+	 * @brief Records that work of the frame was submitted to a queue without a fence
+	 */
+	void add_queue_submission(const Queue &queue);
+
+	/**
+	 * @brief Signals a single fence on each queue the frame submitted to, once all the work submitted so far
+	 *        is complete. Queues complete their submissions in order, so the fence covers the whole frame.
+	 */
+	void signal_fences();
+
+	/**
+	 * @brief Defers a release until the frame is next reset, once the work submitted so far has completed
+	 *        Queues complete their submissions in order, so resources used by the previous frames are safe
+	 *        to release as well.
+	 */
+	void release_deferred(std::function<void()> &&release);
+
+	/**
+	 * @brief Keeps an object alive until the frame is next reset
+	 */
+	template <typename T>
+	void release_deferred(std::unique_ptr<T> &&object)
+	{
+		std::shared_ptr<T> shared{std::move(object)};
+
+		release_deferred([shared]() mutable { shared.reset(); });
+	}
+
+	/**
+	 * @brief Tags the frame with a timeline value signaled by its submitted work,
+	 *        which reset() waits for instead of fences
+	 */
+	void add_timeline_wait(TimelineSemaphore &timeline, uint64_t value);
+
 	const SemaphorePool &get_semaphore_pool() const;
 
 	VkSemaphore request_semaphore();
 
 	/**
-	 * @brief Called when the swapchain changes
-	 * @param render_target A new render target with updated images
+	 * @brief Called by the RenderContext when the frame starts rendering to a swapchain image
+	 *        The render targets are owned by the context, which keeps them alive while the frame uses them
+	 * @param render_target The render target of the image
+	 * @param present_render_target The render target holding the swapchain image, when the frame is
+	 *        rendered to an offscreen render target which is then copied to it, nullptr otherwise
 	 */
-	void update_render_target(RenderTarget &&render_target);
+	void set_render_targets(RenderTarget &render_target, RenderTarget *present_render_target);
 
 	RenderTarget &get_render_target();
 
 	const RenderTarget &get_render_target_const() const;
 
+	/**
+	 * @return Whether the frame is rendered offscreen, the swapchain image being in the present render target
+	 */
+	bool has_present_render_target() const;
+
+	/**
+	 * @return The render target holding the swapchain image, which is the render target of the frame
+	 *         unless the frame is rendered offscreen
+	 */
+	RenderTarget &get_present_render_target();
+
 	/**
 	 * @brief Requests a command buffer to the command pool of the active frame
 	 *        A frame should be active at the moment of requesting it
@@ -110,19 +206,77 @@ class RenderFrame
 	                                      VkCommandBufferLevel     level        = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
 	                                      size_t                   thread_index = 0);
 
+	/**
+	 * @brief Requests a descriptor set to the cache of the thread
+	 * @param retain Whether the set is referenced by a persistent command buffer, in which case it is never
+	 *        evicted from the cache until the descriptors of the frame are cleared
+	 */
 	DescriptorSet &request_descriptor_set(DescriptorSetLayout &                     descriptor_set_layout,
 	                                      const BindingMap<VkDescriptorBufferInfo> &buffer_infos,
 	                                      const BindingMap<VkDescriptorImageInfo> & image_infos,
-	                                      size_t                                    thread_index = 0);
+	                                      size_t                                    thread_index = 0,
+	                                      bool                                      retain       = false);
 
 	void clear_descriptors();
 
+	/**
+	 * @return A counter incremented each time the descriptors of the frame are cleared, invalidating
+	 *         the persistent command buffers recorded with them
+	 */
+	uint32_t get_descriptor_generation() const;
+
+	/**
+	 * @return The number of times the frame was reset, which identifies the current use of the frame
+	 */
+	uint32_t get_reset_count() const;
+
+	/**
+	 * @brief Sets the GPUs of a device group which execute the command buffers of the frame
+	 * @param device_mask Device mask of the GPUs, 0 to use all of them without device group structures
+	 * @param split Whether the GPUs of the mask share each render pass, each rendering a horizontal band of its render area
+	 */
+	void set_device_mask(uint32_t device_mask, bool split = false);
+
+	/**
+	 * @return The GPUs executing the command buffers of the frame, 0 if the frame does not select them
+	 */
+	uint32_t get_device_mask() const;
+
+	bool is_split_frame() const;
+
+	/**
+	 * @brief Bounds the descriptor set caches of the frame. On each reset, the sets that were not
+	 *        requested during the last max_idle_frames uses of the frame are freed back to their pool,
+	 *        then the least recently used ones until each thread caches at most capacity sets
+	 * @param capacity Maximum number of descriptor sets cached per thread
+	 * @param max_idle_frames Number of frame resets after which an unused set is freed, 0 to disable
+	 */
+	void set_descriptor_set_cache_limits(size_t capacity, uint32_t max_idle_frames);
+
 	/**
 	 * @brief Sets a new buffer allocation strategy
 	 * @param new_strategy The new buffer allocation strategy
 	 */
 	void set_buffer_allocation_strategy(BufferAllocationStrategy new_strategy);
 
+	/**
+	 * @return The profiler measuring the GPU time of the frame, its times are those of the previous
+	 *         use of the frame once it has been reset
+	 */
+	GpuProfiler &get_gpu_profiler();
+
+	/**
+	 * @return The profiler measuring when the submissions of the frame executed on each queue, its
+	 *         submissions are those of the previous use of the frame once it has been reset
+	 */
+	SubmissionProfiler &get_submission_profiler();
+
+	/**
+	 * @return The profiler reading the hardware counters of the GPU with performance queries, its values are
+	 *         those of the previous use of the frame once it has been reset
+	 */
+	PerformanceQueryProfiler &get_performance_query_profiler();
+
 	/**
 	 * @param usage Usage of the buffer
 	 * @param size Amount of memory required
@@ -131,20 +285,73 @@ class RenderFrame
 	 */
 	BufferAllocation allocate_buffer(VkBufferUsageFlags usage, VkDeviceSize size, size_t thread_index = 0);
 
+	/**
+	 * @brief Retrieves the arena of a thread for the transient CPU data of the frame, such as containers
+	 *        local to a draw or a pass, which must not outlive the frame. It is reset with the frame.
+	 * @param thread_index Index of the thread, which is the only one to use the arena
+	 */
+	FrameArena &get_arena(size_t thread_index = 0);
+
+	/**
+	 * @brief Allocates host visible memory for the GPU to write during the frame, from shaders or with copies,
+	 *        which is read back without stalling: the callback is called when the frame is reset for its next use,
+	 *        after waiting for the fences of the frame, which have signaled by then unless the GPU is late by more
+	 *        than the frames in flight. Readbacks of a frame reset without waiting for its fences are dropped.
+	 * @param size Size in bytes of the data
+	 * @param callback Called with the data written by the GPU, on the thread resetting the frame
+	 * @param thread_index Index of the thread requesting the readback
+	 * @return The allocation the GPU writes to, usable as a storage buffer or a transfer destination
+	 */
+	BufferAllocation request_readback(VkDeviceSize size, ReadbackCallback &&callback, size_t thread_index = 0);
+
+	/**
+	 * @brief Allocates host visible memory for the GPU to write an array of T, read back like request_readback()
+	 * @param count Number of elements written by the GPU
+	 * @param callback Called with the elements written by the GPU and their count
+	 */
+	template <typename T>
+	BufferAllocation request_readback(size_t count, std::function<void(const T *data, size_t count)> &&callback, size_t thread_index = 0)
+	{
+		return request_readback(
+		    count * sizeof(T), [callback](const uint8_t *data, VkDeviceSize size) { callback(reinterpret_cast<const T *>(data), static_cast<size_t>(size / sizeof(T))); }, thread_index);
+	}
+
+	/**
+	 * @brief Flushes the memory allocated from the buffer pools of all threads since the last flush,
+	 *        one range per block. Called by the RenderContext before submitting the work of the frame.
+	 */
+	void flush_buffers();
+
   private:
 	Device &device;
 
+	static constexpr size_t RESET_MODE_COUNT{static_cast<size_t>(CommandBuffer::ResetMode::Persistent) + 1};
+
+	/**
+	 * @brief Command pools of a thread of the frame, only ever accessed by that thread
+	 *        The pools are indexed by reset mode, then by queue family index. Each reset mode has pools of
+	 *        its own, so that requesting another mode never destroys the pools of command buffers in use.
+	 *        The pools of persistent command buffers are kept across resets of the frame.
+	 */
+	struct ThreadCommandPools
+	{
+		std::array<std::vector<std::unique_ptr<CommandPool>>, RESET_MODE_COUNT> pools;
+	};
+
 	/**
-	 * @brief Retrieve the frame's command pool(s)
+	 * @brief Retrieve the command pool of a thread of the frame, creating it on first use
 	 * @param queue The queue command buffers will be submitted on
-	 * @param reset_mode Indicate how the command buffers will be reset after execution,
-	 *        may trigger a pool re-creation to set necessary flags
-	 * @return The frame's command pool(s)
+	 * @param reset_mode Indicate how the command buffers will be reset after execution
+	 * @param thread_index Index of the thread requesting the pool
+	 * @return The command pool
 	 */
-	std::vector<std::unique_ptr<CommandPool>> &get_command_pools(const Queue &queue, CommandBuffer::ResetMode reset_mode);
+	CommandPool &get_command_pool(const Queue &queue, CommandBuffer::ResetMode reset_mode, size_t thread_index);
 
-	/// Commands pools associated to the frame
-	std::map<uint32_t, std::vector<std::unique_ptr<CommandPool>>> command_pools;
+	/// Commands pools associated to the frame, one set per thread
+	std::vector<ThreadCommandPools> thread_command_pools;
+
+	/// Arenas of transient CPU data, one per thread
+	std::vector<FrameArena> arenas;
 
 	/// Descriptor pools for the frame
 	std::vector<std::unique_ptr<std::unordered_map<std::size_t, DescriptorPool>>> descriptor_pools;
@@ -152,16 +359,80 @@ class RenderFrame
 	/// Descriptor sets for the frame
 	std::vector<std::unique_ptr<std::unordered_map<std::size_t, DescriptorSet>>> descriptor_sets;
 
+	/// Last use of each cached descriptor set, in number of frame resets
+	std::vector<std::unordered_map<std::size_t, uint32_t>> descriptor_set_last_use;
+
+	/// Descriptor sets referenced by persistent command buffers, which are never evicted
+	std::vector<std::unordered_set<std::size_t>> retained_descriptor_sets;
+
+	uint32_t descriptor_generation{0};
+
+	/// Number of times the frame was reset
+	uint32_t reset_count{0};
+
+	uint32_t device_mask{0};
+
+	bool split_frame{false};
+
+	size_t descriptor_set_cache_capacity{DESCRIPTOR_SET_CACHE_CAPACITY};
+
+	uint32_t descriptor_set_max_idle_frames{DESCRIPTOR_SET_MAX_IDLE_FRAMES};
+
+	/// Frees the descriptor sets that are idle or over the cache capacity
+	void evict_descriptor_sets();
+
 	FencePool fence_pool;
 
+	/// Queues submitted to since the fences of the frame were last signaled
+	std::vector<const Queue *> submitted_queues;
+
+	/// Releases run when the frame is next reset, in the order they were deferred
+	std::vector<std::function<void()>> deferred_releases;
+
+	/// Timeline values signaled once the work of the frame is complete
+	std::vector<std::pair<TimelineSemaphore *, uint64_t>> timeline_waits;
+
 	SemaphorePool semaphore_pool;
 
+	GpuProfiler gpu_profiler;
+
+	SubmissionProfiler submission_profiler;
+
+	PerformanceQueryProfiler performance_query_profiler;
+
 	size_t thread_count;
 
-	RenderTarget swapchain_render_target;
+	RenderTarget *render_target{nullptr};
+
+	RenderTarget *present_render_target{nullptr};
 
 	BufferAllocationStrategy buffer_allocation_strategy{BufferAllocationStrategy::MultipleAllocationsPerBuffer};
 
+	/**
+	 * @brief Lets the buffer pools resize their blocks once the frame is complete,
+	 *        releasing the descriptor sets if a pool destroyed the blocks they reference
+	 */
+	void adapt_buffer_pools();
+
 	std::map<VkBufferUsageFlags, std::vector<std::pair<BufferPool, BufferBlock *>>> buffer_pools;
+
+	/**
+	 * @brief Allocation written by the GPU during the frame, read back when the frame is reset
+	 */
+	struct Readback
+	{
+		BufferAllocation allocation;
+
+		ReadbackCallback callback;
+	};
+
+	/// Host visible pools the readbacks are allocated from, one per thread
+	std::vector<std::pair<BufferPool, BufferBlock *>> readback_pools;
+
+	/// Pending readbacks of the frame, one list per thread
+	std::vector<std::vector<Readback>> readbacks;
+
+	/// Calls the callbacks of the pending readbacks, or drops them if the work of the frame may not be complete
+	void resolve_readbacks(bool complete);
 };
 }        // namespace vkb
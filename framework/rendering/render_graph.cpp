@@ -0,0 +1,929 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "rendering/render_graph.h"
+
+#include "core/device.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+namespace
+{
+bool contains(const std::vector<uint32_t> &attachments, uint32_t attachment)
+{
+	return std::find(attachments.begin(), attachments.end(), attachment) != attachments.end();
+}
+
+bool contains(const std::vector<RenderGraphPass::BufferAccess> &accesses, const core::Buffer *buffer)
+{
+	return std::find_if(accesses.begin(), accesses.end(), [buffer](const RenderGraphPass::BufferAccess &access) { return access.buffer == buffer; }) != accesses.end();
+}
+
+/**
+ * @brief Gets the stages and accesses of an attachment used by a subpass in a given layout
+ */
+void get_layout_access(VkImageLayout layout, VkPipelineStageFlags &stage_mask, VkAccessFlags &access_mask)
+{
+	switch (layout)
+	{
+		case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+			stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			access_mask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			break;
+		case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+			stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			break;
+		case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+		case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+			stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			access_mask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+			break;
+		case VK_IMAGE_LAYOUT_GENERAL:
+			// Color attachment read back by the fragments writing it
+			stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			access_mask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+			break;
+		default:
+			stage_mask  = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			access_mask = 0;
+			break;
+	}
+}
+
+/// Accesses which need to be made available before another access
+const VkAccessFlags WRITE_ACCESS_MASK = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+}        // namespace
+
+RenderGraphPass::RenderGraphPass(std::unique_ptr<Subpass> &&subpass) :
+    subpass{std::move(subpass)}
+{
+}
+
+RenderGraphPass::RenderGraphPass(std::unique_ptr<ComputePass> &&compute_pass) :
+    compute_pass{std::move(compute_pass)},
+    compute{true}
+{
+}
+
+RenderGraphPass &RenderGraphPass::write(uint32_t attachment, bool overwrite)
+{
+	assert(!compute && "Compute passes cannot render to attachments");
+
+	if (!contains(attachment_writes, attachment))
+	{
+		attachment_writes.push_back(attachment);
+	}
+
+	if (overwrite && !contains(attachment_overwrites, attachment))
+	{
+		attachment_overwrites.push_back(attachment);
+	}
+
+	return *this;
+}
+
+RenderGraphPass &RenderGraphPass::read_input(uint32_t attachment)
+{
+	assert(!compute && "Compute passes cannot read input attachments, sample them instead");
+
+	if (!contains(input_reads, attachment))
+	{
+		input_reads.push_back(attachment);
+	}
+
+	return *this;
+}
+
+RenderGraphPass &RenderGraphPass::read_sampled(uint32_t attachment, VkPipelineStageFlags stage_mask)
+{
+	if (!contains(sampled_reads, attachment))
+	{
+		sampled_reads.push_back(attachment);
+	}
+
+	sampled_stage_mask |= stage_mask;
+
+	return *this;
+}
+
+RenderGraphPass &RenderGraphPass::read_buffer(const core::Buffer &buffer, VkPipelineStageFlags stage_mask, VkAccessFlags access_mask)
+{
+	buffer_reads.push_back({&buffer, stage_mask, access_mask});
+
+	return *this;
+}
+
+RenderGraphPass &RenderGraphPass::write_buffer(const core::Buffer &buffer, VkPipelineStageFlags stage_mask, VkAccessFlags access_mask)
+{
+	buffer_writes.push_back({&buffer, stage_mask, access_mask});
+
+	return *this;
+}
+
+std::unique_ptr<Subpass> &RenderGraphPass::get_subpass()
+{
+	return subpass;
+}
+
+std::unique_ptr<ComputePass> &RenderGraphPass::get_compute_pass()
+{
+	return compute_pass;
+}
+
+bool RenderGraphPass::is_compute() const
+{
+	return compute;
+}
+
+const std::vector<uint32_t> &RenderGraphPass::get_writes() const
+{
+	return attachment_writes;
+}
+
+const std::vector<uint32_t> &RenderGraphPass::get_input_reads() const
+{
+	return input_reads;
+}
+
+const std::vector<uint32_t> &RenderGraphPass::get_sampled_reads() const
+{
+	return sampled_reads;
+}
+
+const std::vector<RenderGraphPass::BufferAccess> &RenderGraphPass::get_buffer_reads() const
+{
+	return buffer_reads;
+}
+
+const std::vector<RenderGraphPass::BufferAccess> &RenderGraphPass::get_buffer_writes() const
+{
+	return buffer_writes;
+}
+
+bool RenderGraphPass::overwrites(uint32_t attachment) const
+{
+	return contains(attachment_overwrites, attachment);
+}
+
+bool RenderGraphPass::writes(uint32_t attachment) const
+{
+	return contains(attachment_writes, attachment);
+}
+
+bool RenderGraphPass::reads(uint32_t attachment) const
+{
+	return contains(input_reads, attachment) || contains(sampled_reads, attachment);
+}
+
+VkPipelineStageFlags RenderGraphPass::get_sampled_stage_mask() const
+{
+	return sampled_stage_mask;
+}
+
+constexpr uint32_t RenderGraph::SWAPCHAIN_ATTACHMENT;
+
+RenderGraph::RenderGraph(RenderContext &render_context) :
+    render_context{render_context}
+{
+	// The swapchain format is only known once the render targets are created
+	AttachmentInfo swapchain{"swapchain", VK_FORMAT_UNDEFINED};
+	swapchain.clear_value.color = {0.0f, 0.0f, 0.0f, 1.0f};
+
+	attachments.push_back(swapchain);
+}
+
+uint32_t RenderGraph::add_attachment(const std::string &name, VkFormat format, uint32_t layers)
+{
+	assert(!compiled && "Attachments cannot be added to a compiled render graph");
+	assert(layers > 0 && "Attachments should have at least one layer");
+
+	uint32_t attachment = to_u32(attachments.size());
+
+	AttachmentInfo info{name, format};
+	info.layers = layers;
+
+	if (is_depth_stencil_format(format))
+	{
+		if (depth_attachment != VK_ATTACHMENT_UNUSED)
+		{
+			throw std::runtime_error("Render graph supports a single depth attachment, cannot add " + name);
+		}
+
+		depth_attachment = attachment;
+
+		info.clear_value.depthStencil = {0.0f, ~0U};
+		info.usage                    = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	}
+	else
+	{
+		info.clear_value.color = {0.0f, 0.0f, 0.0f, 1.0f};
+		info.usage             = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	}
+
+	attachments.push_back(info);
+
+	return attachment;
+}
+
+void RenderGraph::set_clear_value(uint32_t attachment, const VkClearValue &clear_value)
+{
+	attachments.at(attachment).clear_value = clear_value;
+
+	for (auto &render_pass : render_passes)
+	{
+		if (render_pass.compute_pass)
+		{
+			continue;
+		}
+
+		auto clear_values = render_pass.pipeline.get_clear_value();
+
+		clear_values.at(attachment) = clear_value;
+
+		render_pass.pipeline.set_clear_value(clear_values);
+	}
+}
+
+RenderGraphPass &RenderGraph::add_pass(std::unique_ptr<Subpass> &&subpass)
+{
+	assert(!compiled && "Passes cannot be added to a compiled render graph");
+
+	passes.push_back(std::make_unique<RenderGraphPass>(std::move(subpass)));
+
+	return *passes.back();
+}
+
+RenderGraphPass &RenderGraph::add_compute_pass(std::unique_ptr<ComputePass> &&compute_pass)
+{
+	assert(!compiled && "Passes cannot be added to a compiled render graph");
+
+	passes.push_back(std::make_unique<RenderGraphPass>(std::move(compute_pass)));
+
+	return *passes.back();
+}
+
+void RenderGraph::set_pass_merging(bool enabled)
+{
+	assert(!compiled && "Passes of a compiled render graph are already merged");
+
+	pass_merging = enabled;
+}
+
+void RenderGraph::set_transient_attachments(bool enabled)
+{
+	assert(!compiled && "Attachments of a compiled render graph are already created");
+
+	transient_attachments = enabled;
+}
+
+void RenderGraph::set_concurrent_recording(bool enabled)
+{
+	concurrent_recording = enabled;
+
+	for (auto &render_pass : render_passes)
+	{
+		if (!render_pass.compute_pass)
+		{
+			render_pass.pipeline.set_concurrent_recording(enabled);
+		}
+	}
+}
+
+bool RenderGraph::is_concurrent_recording() const
+{
+	return concurrent_recording;
+}
+
+std::vector<std::vector<size_t>> RenderGraph::group_passes() const
+{
+	std::vector<std::vector<size_t>> groups;
+
+	for (size_t i = 0; i < passes.size(); ++i)
+	{
+		auto &pass = *passes[i];
+
+		// Compute passes are dispatched outside of the render passes
+		bool merge = pass_merging && !groups.empty() && !pass.is_compute() && !passes[groups.back().back()]->is_compute();
+
+		if (merge)
+		{
+			// Either every subpass of a render pass renders with multiview or none does
+			merge = (pass.get_subpass()->get_view_mask() == 0) == (passes[groups.back().back()]->get_subpass()->get_view_mask() == 0);
+		}
+
+		if (merge && depth_attachment != VK_ATTACHMENT_UNUSED)
+		{
+			// Depth can only be read as an input attachment in the last subpass, where it is not bound for depth testing
+			merge = !contains(passes[groups.back().back()]->get_input_reads(), depth_attachment);
+		}
+
+		for (size_t k = 0; merge && k < groups.back().size(); ++k)
+		{
+			size_t index = groups.back()[k];
+			auto & other = *passes[index];
+
+			bool previous = k + 1 == groups.back().size();
+
+			for (auto attachment : pass.get_sampled_reads())
+			{
+				// Sampled images have to be written by a previous render pass
+				merge = merge && !other.writes(attachment);
+			}
+
+			for (auto attachment : pass.get_input_reads())
+			{
+				// Subpass dependencies only make writes visible to the input attachments of the next subpass
+				merge = merge && (previous || !other.writes(attachment));
+			}
+
+			for (auto attachment : pass.get_writes())
+			{
+				// Subpass dependencies do not order writes after writes or reads of the same attachment
+				merge = merge && !other.writes(attachment) && !other.reads(attachment);
+			}
+
+			for (auto &access : pass.get_buffer_reads())
+			{
+				merge = merge && !contains(other.get_buffer_writes(), access.buffer);
+			}
+
+			for (auto &access : pass.get_buffer_writes())
+			{
+				merge = merge && !contains(other.get_buffer_writes(), access.buffer) && !contains(other.get_buffer_reads(), access.buffer);
+			}
+		}
+
+		if (merge)
+		{
+			groups.back().push_back(i);
+		}
+		else
+		{
+			groups.push_back({i});
+		}
+	}
+
+	return groups;
+}
+
+VkImageLayout RenderGraph::get_subpass_layout(uint32_t attachment, const RenderGraphPass &pass) const
+{
+	if (attachment == depth_attachment)
+	{
+		if (contains(pass.get_input_reads(), attachment))
+		{
+			return VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		}
+
+		// The depth attachment is bound to every subpass
+		return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	}
+
+	if (pass.writes(attachment))
+	{
+		// Like core::RenderPass, an attachment read by the subpass writing it is in the general layout
+		return contains(pass.get_input_reads(), attachment) ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	}
+
+	if (contains(pass.get_input_reads(), attachment))
+	{
+		return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	}
+
+	return VK_IMAGE_LAYOUT_UNDEFINED;
+}
+
+bool RenderGraph::is_needed_after(uint32_t attachment, const std::vector<std::vector<size_t>> &groups, size_t group_index) const
+{
+	// The swapchain image is presented
+	if (attachment == SWAPCHAIN_ATTACHMENT)
+	{
+		return true;
+	}
+
+	for (size_t i = group_index + 1; i < groups.size(); ++i)
+	{
+		for (auto index : groups[i])
+		{
+			auto &pass = *passes[index];
+
+			if (pass.reads(attachment))
+			{
+				return true;
+			}
+
+			if (pass.writes(attachment))
+			{
+				return !pass.overwrites(attachment);
+			}
+		}
+	}
+
+	return false;
+}
+
+void RenderGraph::compile()
+{
+	assert(!compiled && "Render graph already compiled");
+	assert(!passes.empty() && "Render graph should contain at least one pass");
+
+	/// State of an attachment between render passes
+	struct AttachmentState
+	{
+		VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+		/// Whether the contents have been stored
+		bool valid{false};
+
+		/// Stages and write accesses of the last use, to wait for
+		VkPipelineStageFlags stage_mask{0};
+
+		VkAccessFlags write_mask{0};
+	};
+
+	/// State of a buffer between render passes
+	struct BufferState
+	{
+		VkPipelineStageFlags write_stage_mask{0};
+
+		VkAccessFlags write_access_mask{0};
+
+		VkPipelineStageFlags read_stage_mask{0};
+	};
+
+	auto groups = group_passes();
+
+	std::vector<AttachmentState> states(attachments.size());
+
+	std::vector<bool> stored(attachments.size(), false);
+
+	std::map<const core::Buffer *, BufferState> buffer_states;
+
+	for (size_t g = 0; g < groups.size(); ++g)
+	{
+		auto &group = groups[g];
+
+		RenderPassInfo info;
+		info.passes = group;
+
+		bool compute = passes[group.front()]->is_compute();
+
+		if (!compute)
+		{
+			info.initial_layouts.resize(attachments.size());
+		}
+
+		std::vector<LoadStoreInfo> load_store(attachments.size());
+		std::vector<VkClearValue>  clear_values(attachments.size());
+
+		// Sampled attachments leave their attachment layout before the render pass
+		for (auto index : group)
+		{
+			auto &pass = *passes[index];
+
+			for (auto attachment : pass.get_sampled_reads())
+			{
+				auto &state = states[attachment];
+
+				if (attachment == depth_attachment)
+				{
+					throw std::runtime_error("Render graph cannot sample the depth attachment, read it as an input attachment");
+				}
+
+				if (!state.valid)
+				{
+					throw std::runtime_error("Render graph attachment " + attachments[attachment].name + " is sampled before it is written");
+				}
+
+				attachments[attachment].usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+
+				if (state.layout != VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL || state.write_mask != 0)
+				{
+					ImageMemoryBarrier barrier{};
+					barrier.old_layout      = state.layout;
+					barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+					barrier.src_stage_mask  = state.stage_mask;
+					barrier.src_access_mask = state.write_mask;
+					barrier.dst_stage_mask  = pass.get_sampled_stage_mask();
+					barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+
+					info.image_barriers.push_back({attachment, barrier});
+				}
+
+				state.layout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				state.stage_mask = pass.get_sampled_stage_mask();
+				state.write_mask = 0;
+			}
+		}
+
+		// Compute passes do not use attachments other than the sampled ones
+		for (uint32_t attachment = 0; !compute && attachment < attachments.size(); ++attachment)
+		{
+			auto &state = states[attachment];
+
+			// Layouts of the first and last subpass using the attachment
+			VkImageLayout initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkImageLayout final_layout   = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			VkPipelineStageFlags stage_mask{0};
+			VkAccessFlags        write_mask{0};
+
+			// First declared use, deciding whether previous contents are needed
+			const RenderGraphPass *first_pass{nullptr};
+
+			for (auto index : group)
+			{
+				auto &pass = *passes[index];
+
+				VkImageLayout layout = get_subpass_layout(attachment, pass);
+
+				if (layout != VK_IMAGE_LAYOUT_UNDEFINED && initial_layout == VK_IMAGE_LAYOUT_UNDEFINED)
+				{
+					initial_layout = layout;
+				}
+
+				final_layout = layout;
+
+				if (layout != VK_IMAGE_LAYOUT_UNDEFINED)
+				{
+					VkPipelineStageFlags layout_stage_mask{0};
+					VkAccessFlags        layout_access_mask{0};
+
+					get_layout_access(layout, layout_stage_mask, layout_access_mask);
+
+					stage_mask |= layout_stage_mask;
+					write_mask |= layout_access_mask & WRITE_ACCESS_MASK;
+				}
+
+				if (!first_pass && (pass.writes(attachment) || contains(pass.get_input_reads(), attachment)))
+				{
+					first_pass = &pass;
+				}
+
+				if (contains(pass.get_input_reads(), attachment))
+				{
+					attachments[attachment].usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+				}
+			}
+
+			clear_values[attachment] = attachments[attachment].clear_value;
+
+			if (initial_layout == VK_IMAGE_LAYOUT_UNDEFINED)
+			{
+				// Not used by the render pass, load and store operations are ignored
+				load_store[attachment] = {VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE};
+
+				info.initial_layouts[attachment] = state.layout;
+
+				if (state.layout == VK_IMAGE_LAYOUT_UNDEFINED)
+				{
+					// core::RenderPass transitions an attachment without a defined layout to the attachment layout
+					state.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+				}
+
+				continue;
+			}
+
+			if (final_layout == VK_IMAGE_LAYOUT_UNDEFINED)
+			{
+				// Not used by the last subpass, core::RenderPass leaves it in the attachment layout
+				final_layout = attachment == depth_attachment ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			}
+
+			bool needed_after = is_needed_after(attachment, groups, g);
+
+			LoadStoreInfo load_store_info{};
+
+			bool load = false;
+
+			if (first_pass)
+			{
+				bool needs_contents = contains(first_pass->get_input_reads(), attachment) || !first_pass->overwrites(attachment);
+
+				if (contains(first_pass->get_input_reads(), attachment) && !state.valid)
+				{
+					throw std::runtime_error("Render graph attachment " + attachments[attachment].name + " is read before it is written");
+				}
+
+				load = needs_contents && state.valid;
+
+				load_store_info.load_op = load ? VK_ATTACHMENT_LOAD_OP_LOAD : (needs_contents ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+			}
+			else
+			{
+				// Bound as depth attachment but not declared by any pass, keep the contents if a later pass needs them
+				load = state.valid && needed_after;
+
+				load_store_info.load_op = load ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+			}
+
+			load_store_info.store_op = needed_after ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+			load_store[attachment] = load_store_info;
+
+			// Barrier into the first layout of the render pass
+			ImageMemoryBarrier barrier{};
+			barrier.new_layout = initial_layout;
+
+			get_layout_access(initial_layout, barrier.dst_stage_mask, barrier.dst_access_mask);
+
+			if (state.stage_mask != 0)
+			{
+				// Wait for the previous render pass using the attachment
+				barrier.src_stage_mask  = state.stage_mask;
+				barrier.src_access_mask = state.write_mask;
+			}
+			else if (attachment == SWAPCHAIN_ATTACHMENT)
+			{
+				// First use in the frame, the swapchain image is acquired by the color attachment output stage
+				barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				barrier.src_access_mask = 0;
+			}
+			else
+			{
+				// First use in the frame, transient attachments alias the memory of the previous frames
+				barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+				barrier.src_access_mask = WRITE_ACCESS_MASK;
+			}
+
+			// Contents which are not loaded can be discarded by the transition
+			barrier.old_layout = load ? state.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+
+			// Reads after reads in the same layout do not need a barrier
+			bool read_after_read = load && state.layout == initial_layout && state.write_mask == 0 && (barrier.dst_access_mask & WRITE_ACCESS_MASK) == 0;
+
+			if (!read_after_read)
+			{
+				info.image_barriers.push_back({attachment, barrier});
+			}
+
+			info.initial_layouts[attachment] = initial_layout;
+
+			state.layout     = final_layout;
+			state.valid      = needed_after;
+			state.stage_mask = stage_mask;
+			state.write_mask = write_mask;
+
+			stored[attachment] = stored[attachment] || needed_after;
+		}
+
+		// Buffer barriers against the previous render passes
+		std::map<const core::Buffer *, BufferMemoryBarrier> buffer_barriers;
+
+		auto add_buffer_barrier = [&buffer_barriers](const RenderGraphPass::BufferAccess &access, VkPipelineStageFlags src_stage_mask, VkAccessFlags src_access_mask) {
+			auto it = buffer_barriers.find(access.buffer);
+
+			if (it == buffer_barriers.end())
+			{
+				BufferMemoryBarrier barrier{};
+				barrier.src_stage_mask = 0;
+				barrier.dst_stage_mask = 0;
+
+				it = buffer_barriers.emplace(access.buffer, barrier).first;
+			}
+
+			it->second.src_stage_mask |= src_stage_mask;
+			it->second.src_access_mask |= src_access_mask;
+			it->second.dst_stage_mask |= access.stage_mask;
+			it->second.dst_access_mask |= access.access_mask;
+		};
+
+		for (auto index : group)
+		{
+			auto &pass = *passes[index];
+
+			for (auto &access : pass.get_buffer_reads())
+			{
+				auto &state = buffer_states[access.buffer];
+
+				if (state.write_stage_mask != 0)
+				{
+					add_buffer_barrier(access, state.write_stage_mask, state.write_access_mask);
+				}
+			}
+
+			for (auto &access : pass.get_buffer_writes())
+			{
+				auto &state = buffer_states[access.buffer];
+
+				if (state.write_stage_mask != 0 || state.read_stage_mask != 0)
+				{
+					add_buffer_barrier(access, state.write_stage_mask | state.read_stage_mask, state.write_access_mask);
+				}
+			}
+		}
+
+		for (auto &buffer_barrier : buffer_barriers)
+		{
+			info.buffer_barriers.push_back({buffer_barrier.first, buffer_barrier.second});
+		}
+
+		for (auto index : group)
+		{
+			auto &pass = *passes[index];
+
+			for (auto &access : pass.get_buffer_reads())
+			{
+				buffer_states[access.buffer].read_stage_mask |= access.stage_mask;
+			}
+
+			for (auto &access : pass.get_buffer_writes())
+			{
+				buffer_states[access.buffer] = {access.stage_mask, access.access_mask, 0};
+			}
+		}
+
+		if (compute)
+		{
+			info.compute_pass = std::move(passes[group.front()]->get_compute_pass());
+			info.compute_pass->prepare();
+
+			render_passes.push_back(std::move(info));
+
+			continue;
+		}
+
+		// Passes become the subpasses of the render pass
+		std::vector<std::unique_ptr<Subpass>> subpasses;
+
+		for (auto index : group)
+		{
+			auto &pass = *passes[index];
+
+			pass.get_subpass()->set_output_attachments(pass.get_writes());
+			pass.get_subpass()->set_input_attachments(pass.get_input_reads());
+			pass.get_subpass()->set_sampled_attachments(pass.get_sampled_reads());
+
+			subpasses.push_back(std::move(pass.get_subpass()));
+		}
+
+		info.pipeline = RenderPipeline{std::move(subpasses)};
+		info.pipeline.set_load_store(load_store);
+		info.pipeline.set_clear_value(clear_values);
+		info.pipeline.set_concurrent_recording(concurrent_recording);
+
+		render_passes.push_back(std::move(info));
+	}
+
+	swapchain_final_layout = states[SWAPCHAIN_ATTACHMENT].layout;
+
+	if (!stored[SWAPCHAIN_ATTACHMENT])
+	{
+		LOGW("Render graph does not write the swapchain image");
+	}
+
+	// Attachments whose contents are never stored can live in tile memory only
+	for (size_t attachment = 1; attachment < attachments.size(); ++attachment)
+	{
+		if (!stored[attachment] && transient_attachments)
+		{
+			attachments[attachment].usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		}
+	}
+
+	compiled = true;
+
+	LOGI("Render graph merged {} passes into {} render passes", passes.size(), get_render_pass_count());
+
+	render_context.update_render_targets([this](core::Image &&swapchain_image) { return create_render_target(std::move(swapchain_image)); });
+}
+
+RenderTarget RenderGraph::create_render_target(core::Image &&swapchain_image)
+{
+	assert(compiled && "Render graph should be compiled before creating its render targets");
+
+	auto &device = swapchain_image.get_device();
+
+	VkExtent3D extent = swapchain_image.get_extent();
+
+	std::vector<core::Image> images;
+	images.reserve(attachments.size());
+
+	images.push_back(std::move(swapchain_image));
+
+	for (size_t attachment = 1; attachment < attachments.size(); ++attachment)
+	{
+		auto &info = attachments[attachment];
+
+		if (info.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)
+		{
+			// Never stored, so the memory is shared with the same attachment of the other frames
+			images.emplace_back(device, extent, info.format, info.usage, info.name, VK_SAMPLE_COUNT_1_BIT, info.layers);
+		}
+		else
+		{
+			images.emplace_back(device, extent, info.format, info.usage, VMA_MEMORY_USAGE_GPU_ONLY, VK_SAMPLE_COUNT_1_BIT, 1, info.layers);
+		}
+
+		device.set_debug_name(VK_OBJECT_TYPE_IMAGE, reinterpret_cast<uint64_t>(images.back().get_handle()), info.name);
+	}
+
+	return RenderTarget{std::move(images)};
+}
+
+void RenderGraph::execute(CommandBuffer &command_buffer, RenderTarget &render_target, const std::function<void(CommandBuffer &)> &last_subpass_func)
+{
+	assert(compiled && "Render graph should be compiled before being executed");
+
+	auto &views = render_target.get_views();
+
+	auto &extent = render_target.get_extent();
+
+	VkViewport viewport{};
+	viewport.width    = static_cast<float>(extent.width);
+	viewport.height   = static_cast<float>(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	command_buffer.set_viewport(0, {viewport});
+
+	VkRect2D scissor{};
+	scissor.extent = extent;
+	command_buffer.set_scissor(0, {scissor});
+
+	// The gui is drawn in the last render pass, even if compute passes follow it
+	size_t last_render_pass = render_passes.size();
+
+	for (size_t i = 0; i < render_passes.size(); ++i)
+	{
+		if (!render_passes[i].compute_pass)
+		{
+			last_render_pass = i;
+		}
+	}
+
+	for (size_t i = 0; i < render_passes.size(); ++i)
+	{
+		auto &render_pass = render_passes[i];
+
+		for (auto &buffer_barrier : render_pass.buffer_barriers)
+		{
+			command_buffer.buffer_memory_barrier(*buffer_barrier.buffer, 0, VK_WHOLE_SIZE, buffer_barrier.barrier);
+		}
+
+		for (auto &image_barrier : render_pass.image_barriers)
+		{
+			command_buffer.image_memory_barrier(views.at(image_barrier.attachment), image_barrier.barrier);
+		}
+
+		if (render_pass.compute_pass)
+		{
+			command_buffer.begin_debug_label(render_pass.compute_pass->get_debug_name());
+
+			render_pass.compute_pass->dispatch(command_buffer);
+
+			command_buffer.end_debug_label();
+
+			continue;
+		}
+
+		for (uint32_t attachment = 0; attachment < render_pass.initial_layouts.size(); ++attachment)
+		{
+			render_target.set_layout(attachment, render_pass.initial_layouts[attachment]);
+		}
+
+		render_pass.pipeline.draw(command_buffer, render_target);
+
+		if (i == last_render_pass && last_subpass_func)
+		{
+			last_subpass_func(command_buffer);
+		}
+
+		command_buffer.end_render_pass();
+	}
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = swapchain_final_layout;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		memory_barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+		command_buffer.image_memory_barrier(views.at(SWAPCHAIN_ATTACHMENT), memory_barrier);
+	}
+}
+
+size_t RenderGraph::get_render_pass_count() const
+{
+	return static_cast<size_t>(std::count_if(render_passes.begin(), render_passes.end(), [](const RenderPassInfo &render_pass) { return !render_pass.compute_pass; }));
+}
+}        // namespace vkb
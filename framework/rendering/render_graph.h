@@ -0,0 +1,314 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/buffer.h"
+#include "rendering/compute_pass.h"
+#include "rendering/render_pipeline.h"
+#include "rendering/render_target.h"
+#include "rendering/subpass.h"
+
+namespace vkb
+{
+class RenderContext;
+
+/**
+ * @brief A pass of a RenderGraph, a Subpass or a ComputePass together with the resources it reads and writes
+ *        A compute pass only samples attachments and accesses buffers, it cannot render to attachments
+ */
+class RenderGraphPass
+{
+  public:
+	struct BufferAccess
+	{
+		const core::Buffer *buffer;
+
+		VkPipelineStageFlags stage_mask;
+
+		VkAccessFlags access_mask;
+	};
+
+	RenderGraphPass(std::unique_ptr<Subpass> &&subpass);
+
+	RenderGraphPass(std::unique_ptr<ComputePass> &&compute_pass);
+
+	/**
+	 * @brief Declares that the pass renders to an attachment
+	 * @param attachment Attachment reference number
+	 * @param overwrite True if the pass writes every pixel, so that previous contents need not be loaded
+	 */
+	RenderGraphPass &write(uint32_t attachment, bool overwrite = false);
+
+	/**
+	 * @brief Declares that the pass reads an attachment as an input attachment
+	 */
+	RenderGraphPass &read_input(uint32_t attachment);
+
+	/**
+	 * @brief Declares that the pass samples an attachment written by a previous pass,
+	 *        which is bound by the Subpass itself
+	 * @param attachment Attachment reference number
+	 * @param stage_mask Shader stages sampling the attachment
+	 */
+	RenderGraphPass &read_sampled(uint32_t attachment, VkPipelineStageFlags stage_mask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+	RenderGraphPass &read_buffer(const core::Buffer &buffer, VkPipelineStageFlags stage_mask, VkAccessFlags access_mask);
+
+	RenderGraphPass &write_buffer(const core::Buffer &buffer, VkPipelineStageFlags stage_mask, VkAccessFlags access_mask);
+
+	std::unique_ptr<Subpass> &get_subpass();
+
+	std::unique_ptr<ComputePass> &get_compute_pass();
+
+	bool is_compute() const;
+
+	const std::vector<uint32_t> &get_writes() const;
+
+	const std::vector<uint32_t> &get_input_reads() const;
+
+	const std::vector<uint32_t> &get_sampled_reads() const;
+
+	const std::vector<BufferAccess> &get_buffer_reads() const;
+
+	const std::vector<BufferAccess> &get_buffer_writes() const;
+
+	bool overwrites(uint32_t attachment) const;
+
+	bool writes(uint32_t attachment) const;
+
+	bool reads(uint32_t attachment) const;
+
+	VkPipelineStageFlags get_sampled_stage_mask() const;
+
+  private:
+	std::unique_ptr<Subpass> subpass;
+
+	std::unique_ptr<ComputePass> compute_pass;
+
+	bool compute{false};
+
+	std::vector<uint32_t> attachment_writes;
+
+	std::vector<uint32_t> attachment_overwrites;
+
+	std::vector<uint32_t> input_reads;
+
+	std::vector<uint32_t> sampled_reads;
+
+	VkPipelineStageFlags sampled_stage_mask{0};
+
+	std::vector<BufferAccess> buffer_reads;
+
+	std::vector<BufferAccess> buffer_writes;
+};
+
+/**
+ * @brief A RenderGraph is a sequence of passes declaring the attachments and buffers they use.
+ * Once compiled the graph:
+ * - merges consecutive passes into the subpasses of a single render pass, unless a pass samples
+ *   an attachment or accesses a buffer another pass of the render pass interacts with
+ * - chooses load and store operations, clearing or discarding contents which are not needed
+ * - records the barriers between render passes with the stages actually producing and consuming
+ *   each resource, and transitions the swapchain image for presentation
+ * - dispatches the compute passes outside of the render passes, each splitting the render passes
+ *   around it, with barriers against the passes producing or consuming what it reads and writes
+ * - creates the render targets, with transient attachments for images never stored
+ *
+ * Attachment 0 is the swapchain image, other attachments are added with add_attachment().
+ * A sample using a render graph compiles it once its passes are added and hands it to
+ * VulkanSample::set_render_graph(), whose draw() calls execute(). The graph must outlive the
+ * RenderContext, which keeps using it to create the render targets when the swapchain changes.
+ */
+class RenderGraph
+{
+  public:
+	static constexpr uint32_t SWAPCHAIN_ATTACHMENT{0};
+
+	RenderGraph(RenderContext &render_context);
+
+	RenderGraph(const RenderGraph &) = delete;
+
+	RenderGraph(RenderGraph &&) = delete;
+
+	RenderGraph &operator=(const RenderGraph &) = delete;
+
+	RenderGraph &operator=(RenderGraph &&) = delete;
+
+	/**
+	 * @brief Adds an attachment the size of the swapchain
+	 * @param name Name of the attachment image, for debugging
+	 * @param format Format of the attachment, at most one attachment may have a depth format
+	 * @param layers Number of layers of the attachment, one for each view of the passes rendering to it with multiview
+	 * @return Attachment reference number
+	 */
+	uint32_t add_attachment(const std::string &name, VkFormat format, uint32_t layers = 1);
+
+	/**
+	 * @brief Sets the value an attachment is cleared to when its contents are not loaded
+	 */
+	void set_clear_value(uint32_t attachment, const VkClearValue &clear_value);
+
+	/**
+	 * @brief Appends a pass to the graph
+	 * @return The pass, to declare the resources it uses
+	 */
+	RenderGraphPass &add_pass(std::unique_ptr<Subpass> &&subpass);
+
+	/**
+	 * @brief Appends a compute pass to the graph, dispatched between the render passes
+	 *        of the passes added before and after it
+	 * @return The pass, to declare the attachments it samples and the buffers it uses,
+	 *         with compute shader stages
+	 */
+	RenderGraphPass &add_compute_pass(std::unique_ptr<ComputePass> &&compute_pass);
+
+	/**
+	 * @brief Sets whether consecutive passes may be merged into the subpasses of a render pass, true by default
+	 *        Without merging each pass is recorded in a render pass of its own, e.g. to compare the bandwidth it costs
+	 */
+	void set_pass_merging(bool enabled);
+
+	/**
+	 * @brief Sets whether the attachments which are never stored are created transient, true by default
+	 */
+	void set_transient_attachments(bool enabled);
+
+	/**
+	 * @brief Records the subpasses of each render pass concurrently into secondary command buffers,
+	 *        see RenderPipeline::set_concurrent_recording(), false by default
+	 */
+	void set_concurrent_recording(bool enabled);
+
+	bool is_concurrent_recording() const;
+
+	/**
+	 * @brief Groups the passes into render passes, derives their load/store operations
+	 *        and barriers, and recreates the render targets of the RenderContext
+	 * @throws std::runtime_error if a pass reads a resource before it is written
+	 */
+	void compile();
+
+	/**
+	 * @brief Creates the RenderTarget of a frame, used as the RenderTarget::CreateFunc of the RenderContext
+	 */
+	RenderTarget create_render_target(core::Image &&swapchain_image);
+
+	/**
+	 * @brief Records the passes, render passes and compute passes in order into a single primary command buffer
+	 *        Render passes are not split into primary command buffers of their own, as they share the render
+	 *        target of the frame, whose attachment layouts are set for each render pass before it begins.
+	 *        Only the subpasses within a render pass may be recorded concurrently, see set_concurrent_recording().
+	 * @param command_buffer Command buffer to record to
+	 * @param render_target Render target of the active frame
+	 * @param last_subpass_func Called at the end of the last subpass of the last render pass, e.g. to draw the gui
+	 */
+	void execute(CommandBuffer &command_buffer, RenderTarget &render_target, const std::function<void(CommandBuffer &)> &last_subpass_func = {});
+
+	/**
+	 * @return Number of render passes the passes were merged into, not counting compute passes
+	 */
+	size_t get_render_pass_count() const;
+
+  private:
+	struct AttachmentInfo
+	{
+		std::string name;
+
+		VkFormat format;
+
+		VkClearValue clear_value;
+
+		VkImageUsageFlags usage{0};
+
+		uint32_t layers{1};
+	};
+
+	struct ImageBarrier
+	{
+		uint32_t attachment;
+
+		ImageMemoryBarrier barrier;
+	};
+
+	struct BufferBarrier
+	{
+		const core::Buffer *buffer;
+
+		BufferMemoryBarrier barrier;
+	};
+
+	/**
+	 * @brief A group of passes recorded as the subpasses of one render pass,
+	 *        or a single compute pass dispatched outside of the render passes
+	 */
+	struct RenderPassInfo
+	{
+		std::vector<size_t> passes;
+
+		RenderPipeline pipeline;
+
+		std::unique_ptr<ComputePass> compute_pass;
+
+		/// Layout of each attachment when the render pass begins
+		std::vector<VkImageLayout> initial_layouts;
+
+		std::vector<ImageBarrier> image_barriers;
+
+		std::vector<BufferBarrier> buffer_barriers;
+	};
+
+	RenderContext &render_context;
+
+	std::vector<AttachmentInfo> attachments;
+
+	uint32_t depth_attachment{VK_ATTACHMENT_UNUSED};
+
+	std::vector<std::unique_ptr<RenderGraphPass>> passes;
+
+	std::vector<RenderPassInfo> render_passes;
+
+	/// Layout the swapchain image is left in after the last render pass
+	VkImageLayout swapchain_final_layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+	bool compiled{false};
+
+	bool pass_merging{true};
+
+	bool transient_attachments{true};
+
+	bool concurrent_recording{false};
+
+	std::vector<std::vector<size_t>> group_passes() const;
+
+	/**
+	 * @return Layout of an attachment in a pass of a render pass, mirroring core::RenderPass,
+	 *         or VK_IMAGE_LAYOUT_UNDEFINED if the pass does not use the attachment
+	 */
+	VkImageLayout get_subpass_layout(uint32_t attachment, const RenderGraphPass &pass) const;
+
+	/**
+	 * @return True if an attachment's contents are needed by a pass recorded after the given render pass
+	 */
+	bool is_needed_after(uint32_t attachment, const std::vector<std::vector<size_t>> &groups, size_t group_index) const;
+};
+}        // namespace vkb
@@ -20,6 +20,8 @@
 
 #include "render_pipeline.h"
 
+#include "cpu_profiler.h"
+#include "rendering/render_context.h"
 #include "scene_graph/components/camera.h"
 #include "scene_graph/components/image.h"
 #include "scene_graph/components/material.h"
@@ -29,9 +31,21 @@
 #include "scene_graph/components/sub_mesh.h"
 #include "scene_graph/components/texture.h"
 #include "scene_graph/node.h"
+#include "stats.h"
 
 namespace vkb
 {
+namespace
+{
+/// Stats the GPU time of the first subpasses is reported as
+const std::vector<StatIndex> SUBPASS_TIME_STATS = {StatIndex::gpu_subpass_0_time, StatIndex::gpu_subpass_1_time};
+
+/// Stats the pipeline statistics of the first subpasses are reported as
+const std::vector<GpuProfiler::PipelineStatisticsStats> SUBPASS_PIPELINE_STATS = {
+    {StatIndex::subpass_0_vertex_invocations, StatIndex::subpass_0_clipping_primitives, StatIndex::subpass_0_fragment_invocations},
+    {StatIndex::subpass_1_vertex_invocations, StatIndex::subpass_1_clipping_primitives, StatIndex::subpass_1_fragment_invocations}};
+}        // namespace
+
 RenderPipeline::RenderPipeline(std::vector<std::unique_ptr<Subpass>> &&subpasses_) :
     subpasses{std::move(subpasses_)}
 {
@@ -58,6 +72,110 @@ std::vector<std::unique_ptr<Subpass>> &RenderPipeline::get_subpasses()
 	return subpasses;
 }
 
+bool RenderPipeline::can_merge(const RenderPipeline &next, const std::vector<Attachment> &attachments) const
+{
+	if (subpasses.empty() || next.subpasses.empty())
+	{
+		return false;
+	}
+
+	// Depth is only unbound from the last subpass reading it as an input attachment
+	for (auto i_attachment : subpasses.back()->get_input_attachments())
+	{
+		if (i_attachment < attachments.size() && is_depth_stencil_format(attachments[i_attachment].format))
+		{
+			return false;
+		}
+	}
+
+	for (auto &subpass : subpasses)
+	{
+		auto &outputs = subpass->get_output_attachments();
+		auto &inputs  = subpass->get_input_attachments();
+
+		for (auto &next_subpass : next.subpasses)
+		{
+			// Sampled images have to be written by a previous render pass
+			for (auto s_attachment : next_subpass->get_sampled_attachments())
+			{
+				if (std::find(outputs.begin(), outputs.end(), s_attachment) != outputs.end())
+				{
+					return false;
+				}
+			}
+
+			// Writes after input attachment reads are not ordered by the subpass dependencies
+			for (auto o_attachment : next_subpass->get_output_attachments())
+			{
+				if (std::find(inputs.begin(), inputs.end(), o_attachment) != inputs.end())
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+void RenderPipeline::merge(RenderPipeline &&next)
+{
+	auto uses_attachment = [](const std::vector<std::unique_ptr<Subpass>> &subpasses, uint32_t attachment) {
+		for (auto &subpass : subpasses)
+		{
+			auto &inputs  = subpass->get_input_attachments();
+			auto &outputs = subpass->get_output_attachments();
+
+			if (std::find(inputs.begin(), inputs.end(), attachment) != inputs.end() ||
+			    std::find(outputs.begin(), outputs.end(), attachment) != outputs.end())
+			{
+				return true;
+			}
+		}
+
+		return false;
+	};
+
+	size_t attachment_count = std::max(load_store.size(), next.load_store.size());
+
+	std::vector<LoadStoreInfo> merged_load_store(attachment_count);
+	std::vector<VkClearValue>  merged_clear_value(std::max(clear_value.size(), next.clear_value.size()));
+
+	for (uint32_t i = 0; i < attachment_count; ++i)
+	{
+		LoadStoreInfo first  = i < load_store.size() ? load_store[i] : LoadStoreInfo{};
+		LoadStoreInfo second = i < next.load_store.size() ? next.load_store[i] : LoadStoreInfo{};
+
+		bool used_first  = uses_attachment(subpasses, i);
+		bool used_second = uses_attachment(next.subpasses, i);
+
+		// Attachments used by neither pipeline, such as an implicit depth attachment, are loaded first and stored last
+		merged_load_store[i].load_op  = used_first || !used_second ? first.load_op : second.load_op;
+		merged_load_store[i].store_op = used_second || !used_first ? second.store_op : first.store_op;
+	}
+
+	for (uint32_t i = 0; i < merged_clear_value.size(); ++i)
+	{
+		bool prefer_first = uses_attachment(subpasses, i) || !uses_attachment(next.subpasses, i);
+		bool from_first   = prefer_first ? i < clear_value.size() : i >= next.clear_value.size();
+
+		merged_clear_value[i] = from_first ? clear_value[i] : next.clear_value[i];
+	}
+
+	load_store  = merged_load_store;
+	clear_value = merged_clear_value;
+
+	// The subpasses were prepared by the other pipeline
+	for (auto &subpass : next.subpasses)
+	{
+		subpasses.push_back(std::move(subpass));
+	}
+
+	next.subpasses.clear();
+
+	pipeline_statistics_enabled = pipeline_statistics_enabled || next.pipeline_statistics_enabled;
+}
+
 const std::vector<LoadStoreInfo> &RenderPipeline::get_load_store() const
 {
 	return load_store;
@@ -80,6 +198,8 @@ void RenderPipeline::set_clear_value(const std::vector<VkClearValue> &cv)
 
 void RenderPipeline::draw(CommandBuffer &command_buffer, RenderTarget &render_target, VkSubpassContents contents)
 {
+	VKB_PROFILE_SCOPE("RenderPipeline::draw");
+
 	assert(!subpasses.empty() && "Render pipeline should contain at least one sub-pass");
 
 	// Pad clear values if they're less than render target attachments
@@ -88,6 +208,18 @@ void RenderPipeline::draw(CommandBuffer &command_buffer, RenderTarget &render_ta
 		clear_value.push_back({0.0f, 0.0f, 0.0f, 1.0f});
 	}
 
+	// Commands which are not allowed within a render pass
+	for (auto &subpass : subpasses)
+	{
+		subpass->pre_draw(command_buffer);
+	}
+
+	if (concurrent_recording)
+	{
+		draw_concurrent(command_buffer, render_target);
+		return;
+	}
+
 	for (size_t i = 0; i < subpasses.size(); ++i)
 	{
 		active_subpass_index = i;
@@ -96,21 +228,80 @@ void RenderPipeline::draw(CommandBuffer &command_buffer, RenderTarget &render_ta
 
 		subpass->update_render_target_attachments();
 
+		VkSubpassContents subpass_contents = subpass->get_contents();
+
 		if (i == 0)
 		{
-			command_buffer.begin_render_pass(render_target, load_store, clear_value, subpasses, contents);
+			// Subpasses recording into secondary command buffers override the requested contents
+			subpass_contents = subpass_contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS ? subpass_contents : contents;
+
+			command_buffer.begin_render_pass(render_target, load_store, clear_value, subpasses, subpass_contents);
 		}
 		else
 		{
-			command_buffer.next_subpass();
+			command_buffer.next_subpass(subpass_contents);
+		}
+
+		// Queries can only be written in subpasses recording inline
+		bool timed   = i < SUBPASS_TIME_STATS.size() && subpass_contents == VK_SUBPASS_CONTENTS_INLINE;
+		bool counted = pipeline_statistics_enabled && i < SUBPASS_PIPELINE_STATS.size() && subpass_contents == VK_SUBPASS_CONTENTS_INLINE;
+
+		auto &gpu_profiler = subpass->get_render_context().get_active_frame().get_gpu_profiler();
+
+		if (timed)
+		{
+			gpu_profiler.begin_scope(command_buffer, SUBPASS_TIME_STATS[i]);
+		}
+
+		if (counted)
+		{
+			gpu_profiler.begin_statistics_scope(command_buffer, SUBPASS_PIPELINE_STATS[i]);
+		}
+
+		// Labels can only be recorded in subpasses recording inline, secondary command buffers label their own commands
+		bool labelled = subpass_contents == VK_SUBPASS_CONTENTS_INLINE;
+
+		if (labelled)
+		{
+			command_buffer.begin_debug_label(subpass->get_debug_name());
 		}
 
-		subpass->draw(command_buffer);
+		// Secondary command buffers set the shading rates of their own draws
+		if (subpass_contents == VK_SUBPASS_CONTENTS_INLINE)
+		{
+			command_buffer.set_fragment_shading_rate(subpass->get_shading_rate());
+		}
+
+		{
+			VKB_PROFILE_SCOPE("Subpass::draw");
+
+			subpass->draw(command_buffer);
+		}
+
+		if (labelled)
+		{
+			command_buffer.end_debug_label();
+		}
+
+		if (counted)
+		{
+			gpu_profiler.end_statistics_scope(command_buffer);
+		}
+
+		if (timed)
+		{
+			gpu_profiler.end_scope(command_buffer, SUBPASS_TIME_STATS[i]);
+		}
 	}
 
 	active_subpass_index = 0;
 }
 
+void RenderPipeline::set_pipeline_statistics_enabled(bool enabled)
+{
+	pipeline_statistics_enabled = enabled;
+}
+
 void RenderPipeline::set_use_dynamic_resources(bool dynamic)
 {
 	for (auto &subpass : subpasses)
@@ -119,6 +310,110 @@ void RenderPipeline::set_use_dynamic_resources(bool dynamic)
 	}
 }
 
+void RenderPipeline::set_concurrent_recording(bool enabled)
+{
+	concurrent_recording = enabled;
+}
+
+bool RenderPipeline::is_concurrent_recording() const
+{
+	return concurrent_recording;
+}
+
+void RenderPipeline::draw_concurrent(CommandBuffer &command_buffer, RenderTarget &render_target)
+{
+	auto &render_frame = subpasses[0]->get_render_context().get_active_frame();
+	auto &device       = command_buffer.get_device();
+	auto &queue        = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+
+	// Attachments are only read by the subpasses themselves, the render target is left as after a sequential draw
+	for (auto &subpass : subpasses)
+	{
+		subpass->update_render_target_attachments();
+	}
+
+	command_buffer.begin_render_pass(render_target, load_store, clear_value, subpasses, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+	std::vector<size_t> inline_subpasses;
+	for (size_t i = 0; i < subpasses.size(); ++i)
+	{
+		if (subpasses[i]->get_contents() == VK_SUBPASS_CONTENTS_INLINE)
+		{
+			inline_subpasses.push_back(i);
+		}
+	}
+
+	// Dynamic state is not inherited from the primary command buffer
+	auto &extent = render_target.get_extent();
+
+	VkViewport viewport{};
+	viewport.width    = static_cast<float>(extent.width);
+	viewport.height   = static_cast<float>(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor{};
+	scissor.extent = extent;
+
+	std::vector<CommandBuffer *> secondary_command_buffers(subpasses.size(), nullptr);
+
+	{
+		VKB_PROFILE_SCOPE("Subpass::draw");
+
+		// Secondary command buffers know their subpass, so they do not wait for the primary one to reach it
+		device.get_job_system().run_parallel(JobPriority::Frame, inline_subpasses.size(), render_frame.get_thread_count(), [&](size_t task, size_t thread_index) {
+			auto  subpass_index = inline_subpasses[task];
+			auto &subpass       = subpasses[subpass_index];
+
+			auto &secondary_command_buffer = render_frame.request_command_buffer(queue, CommandBuffer::ResetMode::ResetPool, VK_COMMAND_BUFFER_LEVEL_SECONDARY, thread_index);
+
+			secondary_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &command_buffer, to_u32(subpass_index));
+
+			secondary_command_buffer.set_viewport(0, {viewport});
+			secondary_command_buffer.set_scissor(0, {scissor});
+
+			secondary_command_buffer.begin_debug_label(subpass->get_debug_name());
+
+			secondary_command_buffer.set_fragment_shading_rate(subpass->get_shading_rate());
+
+			subpass->set_recording_thread_index(thread_index);
+
+			subpass->draw(secondary_command_buffer);
+
+			subpass->set_recording_thread_index(0);
+
+			secondary_command_buffer.end_debug_label();
+
+			secondary_command_buffer.end();
+
+			secondary_command_buffers[subpass_index] = &secondary_command_buffer;
+		});
+	}
+
+	for (size_t i = 0; i < subpasses.size(); ++i)
+	{
+		active_subpass_index = i;
+
+		if (i > 0)
+		{
+			command_buffer.next_subpass(VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		}
+
+		if (secondary_command_buffers[i])
+		{
+			command_buffer.execute_commands(*secondary_command_buffers[i]);
+		}
+		else
+		{
+			VKB_PROFILE_SCOPE("Subpass::draw");
+
+			subpasses[i]->draw(command_buffer);
+		}
+	}
+
+	active_subpass_index = 0;
+}
+
 std::unique_ptr<Subpass> &RenderPipeline::get_active_subpass()
 {
 	return subpasses[active_subpass_index];
@@ -82,8 +82,31 @@ class RenderPipeline
 
 	std::vector<std::unique_ptr<Subpass>> &get_subpasses();
 
+	/**
+	 * @brief Checks whether the subpasses of another pipeline, drawn right after this one,
+	 *        can become subpasses of this render pass. That is the case if they consume the
+	 *        outputs of this pipeline only at the same pixel, through input attachments, so
+	 *        those outputs never have to leave tile memory
+	 * @param next Pipeline drawn after this one
+	 * @param attachments Attachments of the render target both pipelines draw to
+	 */
+	bool can_merge(const RenderPipeline &next, const std::vector<Attachment> &attachments) const;
+
+	/**
+	 * @brief Appends the subpasses of another pipeline, which should pass can_merge().
+	 *        Each attachment is loaded as by the first pipeline using it and stored as by
+	 *        the last one, so intermediate attachments are no longer stored and loaded back
+	 * @param next Pipeline drawn after this one
+	 */
+	void merge(RenderPipeline &&next);
+
 	/**
 	 * @brief Record draw commands for each Subpass
+	 * @param command_buffer Command buffer to record to
+	 * @param render_target Render target to draw to
+	 * @param contents Contents of the first subpass; each Subpass may also request
+	 *        secondary command buffers through Subpass::get_contents()
+	 *        Ignored when recording concurrently, as all subpasses then use secondary command buffers
 	 */
 	void draw(CommandBuffer &command_buffer, RenderTarget &render_target, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 
@@ -95,7 +118,32 @@ class RenderPipeline
 
 	void set_use_dynamic_resources(bool dynamic);
 
+	/**
+	 * @brief Enables counting the vertex and fragment shader invocations and the clipped primitives
+	 *        of the first subpasses, reported through Stats. Subpasses recording into secondary
+	 *        command buffers are not counted.
+	 */
+	void set_pipeline_statistics_enabled(bool enabled);
+
+	/**
+	 * @brief Records the subpasses recording inline concurrently on the job system, each into its own
+	 *        secondary command buffer, which the primary command buffer executes in order. Subpasses
+	 *        requesting secondary command buffers still record them in turn, as they use the threads themselves.
+	 *        Subpasses must allocate from the frame with their recording thread index, see
+	 *        Subpass::get_recording_thread_index(), and the render frames need a thread per concurrent subpass.
+	 *        The subpasses are neither timed nor counted by the GPU profiler, and commands recorded after
+	 *        draw() in the last subpass must be in secondary command buffers too.
+	 */
+	void set_concurrent_recording(bool enabled);
+
+	bool is_concurrent_recording() const;
+
   private:
+	/**
+	 * @brief Records the subpasses while concurrent recording is enabled
+	 */
+	void draw_concurrent(CommandBuffer &command_buffer, RenderTarget &render_target);
+
 	std::vector<std::unique_ptr<Subpass>> subpasses;
 
 	/// Default to two load store
@@ -105,5 +153,9 @@ class RenderPipeline
 	std::vector<VkClearValue> clear_value = std::vector<VkClearValue>(2);
 
 	size_t active_subpass_index{0};
+
+	bool pipeline_statistics_enabled{false};
+
+	bool concurrent_recording{false};
 };
 }        // namespace vkb
@@ -26,6 +26,9 @@ namespace vkb
 {
 namespace
 {
+/// Depth formats in order of preference, D16 is the only one every device supports
+const std::vector<VkFormat> DEPTH_FORMATS = {VK_FORMAT_D32_SFLOAT, VK_FORMAT_X8_D24_UNORM_PACK32, VK_FORMAT_D16_UNORM};
+
 struct CompareExtent2D
 {
 	bool operator()(const VkExtent2D &lhs, const VkExtent2D &rhs) const
@@ -42,10 +45,15 @@ Attachment::Attachment(VkFormat format, VkSampleCountFlagBits samples, VkImageUs
 {
 }
 const RenderTarget::CreateFunc RenderTarget::DEFAULT_CREATE_FUNC = [](core::Image &&swapchain_image) -> RenderTarget {
-	core::Image depth_image{swapchain_image.get_device(), swapchain_image.get_extent(),
-	                        VK_FORMAT_D32_SFLOAT,
-	                        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
-	                        VMA_MEMORY_USAGE_GPU_ONLY};
+	auto &device = swapchain_image.get_device();
+
+	VkImageUsageFlags depth_usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+	// The depth attachment of every frame aliases the same transient memory
+	core::Image depth_image{device, swapchain_image.get_extent(),
+	                        device.choose_attachment_format(DEPTH_FORMATS, depth_usage),
+	                        depth_usage,
+	                        "depth"};
 
 	std::vector<core::Image> images;
 	images.push_back(std::move(swapchain_image));
@@ -54,6 +62,38 @@ const RenderTarget::CreateFunc RenderTarget::DEFAULT_CREATE_FUNC = [](core::Imag
 	return RenderTarget{std::move(images)};
 };
 
+RenderTarget::CreateFunc RenderTarget::multisampled_create_func(VkSampleCountFlagBits samples)
+{
+	return [samples](core::Image &&swapchain_image) -> RenderTarget {
+		auto &device = swapchain_image.get_device();
+
+		VkImageUsageFlags depth_usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+		// Attachment 1 stays the depth attachment, so that the default load store operations apply
+		core::Image depth_image{device, swapchain_image.get_extent(),
+		                        device.choose_attachment_format(DEPTH_FORMATS, depth_usage),
+		                        depth_usage,
+		                        "multisampled_depth",
+		                        samples};
+
+		core::Image color_image{device, swapchain_image.get_extent(),
+		                        swapchain_image.get_format(),
+		                        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+		                        "multisampled_color",
+		                        samples};
+
+		std::vector<core::Image> images;
+		images.push_back(std::move(swapchain_image));
+		images.push_back(std::move(depth_image));
+		images.push_back(std::move(color_image));
+
+		RenderTarget render_target{std::move(images)};
+		render_target.set_multisampled_attachment(0, 2);
+
+		return render_target;
+	};
+}
+
 RenderTarget &RenderTarget::operator=(RenderTarget &&other) noexcept
 {
 	if (this != &other)
@@ -67,10 +107,12 @@ RenderTarget &RenderTarget::operator=(RenderTarget &&other) noexcept
 		}
 
 		std::swap(extent, other.extent);
+		std::swap(render_area, other.render_area);
 		std::swap(images, other.images);
 		std::swap(views, other.views);
 		std::swap(attachments, other.attachments);
 		std::swap(output_attachments, other.output_attachments);
+		std::swap(multisampled_attachments, other.multisampled_attachments);
 	}
 	return *this;
 }
@@ -97,6 +139,8 @@ vkb::RenderTarget::RenderTarget(std::vector<core::Image> &&images) :
 
 	extent = *unique_extent.begin();
 
+	render_area.extent = extent;
+
 	for (auto &image : this->images)
 	{
 		if (image.get_type() != VK_IMAGE_TYPE_2D)
@@ -104,10 +148,13 @@ vkb::RenderTarget::RenderTarget(std::vector<core::Image> &&images) :
 			throw VulkanException{VK_ERROR_INITIALIZATION_FAILED, "Image type is not 2D"};
 		}
 
-		views.emplace_back(image, VK_IMAGE_VIEW_TYPE_2D);
+		// Layered images are rendered with multiview, each view to one layer
+		views.emplace_back(image, image.get_subresource().arrayLayer > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D);
 
 		attachments.emplace_back(Attachment{image.get_format(), image.get_sample_count(), image.get_usage()});
 	}
+
+	multisampled_attachments.resize(attachments.size(), VK_ATTACHMENT_UNUSED);
 }
 
 const VkExtent2D &RenderTarget::get_extent() const
@@ -115,6 +162,24 @@ const VkExtent2D &RenderTarget::get_extent() const
 	return extent;
 }
 
+void RenderTarget::set_render_area(const VkRect2D &area)
+{
+	assert(area.offset.x >= 0 && area.offset.y >= 0 && area.offset.x + area.extent.width <= extent.width && area.offset.y + area.extent.height <= extent.height &&
+	       "The render area must be within the extent of the render target");
+
+	render_area = area;
+}
+
+const VkRect2D &RenderTarget::get_render_area() const
+{
+	return render_area;
+}
+
+bool RenderTarget::is_partial_render_area() const
+{
+	return render_area.extent.width != extent.width || render_area.extent.height != extent.height;
+}
+
 const std::vector<core::ImageView> &RenderTarget::get_views() const
 {
 	return views;
@@ -145,4 +210,27 @@ const std::vector<uint32_t> &RenderTarget::get_output_attachments() const
 	return output_attachments;
 }
 
+void RenderTarget::set_layout(uint32_t attachment, VkImageLayout layout)
+{
+	attachments.at(attachment).initial_layout = layout;
+}
+
+void RenderTarget::set_multisampled_attachment(uint32_t attachment, uint32_t multisampled_attachment)
+{
+	assert(attachments.at(attachment).samples == VK_SAMPLE_COUNT_1_BIT && "Can only resolve into a single sampled attachment");
+	assert(attachments.at(multisampled_attachment).samples != VK_SAMPLE_COUNT_1_BIT && "Resolved attachment is not multisampled");
+
+	if (is_depth_stencil_format(attachments[attachment].format))
+	{
+		throw VulkanException{VK_ERROR_FORMAT_NOT_SUPPORTED, "Resolving depth stencil attachments is not supported"};
+	}
+
+	multisampled_attachments.at(attachment) = multisampled_attachment;
+}
+
+const std::vector<uint32_t> &RenderTarget::get_multisampled_attachments() const
+{
+	return multisampled_attachments;
+}
+
 }        // namespace vkb
@@ -41,6 +41,9 @@ struct Attachment
 
 	VkImageUsageFlags usage{VK_IMAGE_USAGE_SAMPLED_BIT};
 
+	/// Layout the attachment is in when a render pass begins, if undefined the layout of the first subpass using it
+	VkImageLayout initial_layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
 	Attachment() = default;
 
 	Attachment(VkFormat format, VkSampleCountFlagBits samples, VkImageUsageFlags usage);
@@ -62,6 +65,14 @@ class RenderTarget
 
 	static const CreateFunc DEFAULT_CREATE_FUNC;
 
+	/**
+	 * @brief Creates a render target with a multisampled color and depth attachment
+	 *        The color attachment is resolved into the swapchain image at the end of the subpasses writing it,
+	 *        so neither multisampled image needs to leave tile memory
+	 * @param samples Sample count of the multisampled attachments
+	 */
+	static CreateFunc multisampled_create_func(VkSampleCountFlagBits samples);
+
 	RenderTarget(std::vector<core::Image> &&images);
 
 	RenderTarget(const RenderTarget &) = delete;
@@ -74,6 +85,21 @@ class RenderTarget
 
 	const VkExtent2D &get_extent() const;
 
+	/**
+	 * @brief Restricts the render passes begun with the render target to a region of its attachments
+	 *        The attachments keep their contents outside of it, as long as they are not transitioned
+	 *        from an undefined layout. Defaults to the whole extent.
+	 */
+	void set_render_area(const VkRect2D &area);
+
+	const VkRect2D &get_render_area() const;
+
+	/**
+	 * @return Whether the render area is smaller than the extent, in which case the contents of the
+	 *         attachments outside of it must be preserved
+	 */
+	bool is_partial_render_area() const;
+
 	const std::vector<core::ImageView> &get_views() const;
 
 	const std::vector<Attachment> &get_attachments() const;
@@ -96,11 +122,34 @@ class RenderTarget
 
 	const std::vector<uint32_t> &get_output_attachments() const;
 
+	/**
+	 * @brief Sets the layout an attachment is in when the next render pass begins
+	 *        Attachments not used by any subpass keep this layout through the render pass
+	 * @param attachment Attachment reference number
+	 * @param layout Current layout of the attachment image
+	 */
+	void set_layout(uint32_t attachment, VkImageLayout layout);
+
+	/**
+	 * @brief Renders an attachment through a multisampled attachment, which is resolved into it
+	 *        Subpasses keep referring to the resolved attachment, the render pass remaps its outputs
+	 * @param attachment Attachment reference number of the single sampled attachment
+	 * @param multisampled_attachment Attachment reference number of the multisampled attachment
+	 */
+	void set_multisampled_attachment(uint32_t attachment, uint32_t multisampled_attachment);
+
+	/**
+	 * @return The multisampled attachment of each attachment, VK_ATTACHMENT_UNUSED if it is not multisampled
+	 */
+	const std::vector<uint32_t> &get_multisampled_attachments() const;
+
   private:
 	Device &device;
 
 	VkExtent2D extent{};
 
+	VkRect2D render_area{};
+
 	std::vector<core::Image> images;
 
 	std::vector<core::ImageView> views;
@@ -112,5 +161,7 @@ class RenderTarget
 
 	/// By default the output attachments is attachment 0
 	std::vector<uint32_t> output_attachments = {0};
+
+	std::vector<uint32_t> multisampled_attachments;
 };
 }        // namespace vkb
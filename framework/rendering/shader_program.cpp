@@ -106,4 +106,11 @@ const std::unordered_map<uint32_t, std::vector<ShaderResource>> &ShaderProgram::
 	return sets;
 }
 
+const ShaderResource *ShaderProgram::find_resource(const std::string &name) const
+{
+	auto it = resources.find(name);
+
+	return it != resources.end() ? &it->second : nullptr;
+}
+
 }        // namespace vkb
@@ -55,6 +55,11 @@ class ShaderProgram
 
 	const std::unordered_map<uint32_t, std::vector<ShaderResource>> &get_shader_sets() const;
 
+	/**
+	 * @return The resource with the given name in the shaders, or nullptr if they do not use it
+	 */
+	const ShaderResource *find_resource(const std::string &name) const;
+
   private:
 	// The shader modules that this program uses
 	std::vector<ShaderModule *> shader_modules;
@@ -41,7 +41,8 @@ glm::mat4 vulkan_style_projection(const glm::mat4 &proj)
 Subpass::Subpass(RenderContext &render_context, ShaderSource &&vertex_source, ShaderSource &&fragment_source) :
     render_context{render_context},
     vertex_shader{std::move(vertex_source)},
-    fragment_shader{std::move(fragment_source)}
+    fragment_shader{std::move(fragment_source)},
+    debug_name{vertex_shader.get_filename() + " / " + fragment_shader.get_filename()}
 {
 }
 
@@ -68,11 +69,51 @@ const ShaderSource &Subpass::get_fragment_shader() const
 	return fragment_shader;
 }
 
+const std::string &Subpass::get_debug_name() const
+{
+	return debug_name;
+}
+
+void Subpass::set_debug_name(const std::string &name)
+{
+	debug_name = name;
+}
+
 DepthStencilState &Subpass::get_depth_stencil_state()
 {
 	return depth_stencil_state;
 }
 
+void Subpass::set_shading_rate(const VkExtent2D &fragment_size)
+{
+	shading_rate = fragment_size;
+}
+
+const VkExtent2D &Subpass::get_shading_rate() const
+{
+	return shading_rate;
+}
+
+void Subpass::set_view_mask(uint32_t mask)
+{
+	view_mask = mask;
+}
+
+uint32_t Subpass::get_view_mask() const
+{
+	return view_mask;
+}
+
+void Subpass::set_rasterization_order_access(bool enable)
+{
+	rasterization_order_access = enable;
+}
+
+bool Subpass::is_rasterization_order_access() const
+{
+	return rasterization_order_access;
+}
+
 const std::vector<uint32_t> &Subpass::get_input_attachments() const
 {
 	return input_attachments;
@@ -93,11 +134,40 @@ void Subpass::set_output_attachments(std::vector<uint32_t> output)
 	output_attachments = output;
 }
 
+void Subpass::set_recording_thread_index(size_t thread_index)
+{
+	recording_thread_index = thread_index;
+}
+
+size_t Subpass::get_recording_thread_index() const
+{
+	return recording_thread_index;
+}
+
+const std::vector<uint32_t> &Subpass::get_sampled_attachments() const
+{
+	return sampled_attachments;
+}
+
+void Subpass::set_sampled_attachments(std::vector<uint32_t> sampled)
+{
+	sampled_attachments = sampled;
+}
+
+void Subpass::pre_draw(CommandBuffer &command_buffer)
+{
+}
+
 void Subpass::set_use_dynamic_resources(bool b)
 {
 	use_dynamic_resources = b;
 }
 
+VkSubpassContents Subpass::get_contents() const
+{
+	return contents;
+}
+
 void Subpass::add_definitions(ShaderVariant &variant, const std::vector<std::string> &definitions)
 {
 	for (auto &definition : definitions)
@@ -20,9 +20,12 @@
 
 #pragma once
 
+#include <cstddef>
+
 #include "buffer_pool.h"
 #include "common/helpers.h"
 #include "core/shader_module.h"
+#include "rendering/light_manager.h"
 #include "rendering/pipeline_state.h"
 #include "rendering/render_context.h"
 #include "rendering/render_frame.h"
@@ -37,14 +40,6 @@ namespace vkb
 {
 class CommandBuffer;
 
-struct alignas(16) Light
-{
-	glm::vec4 position;         // position.w represents type of light
-	glm::vec4 color;            // color.w represents light intensity
-	glm::vec4 direction;        // direction.w represents range
-	glm::vec2 info;             // (only used for spot lights) info.x represents light inner cone angle, info.y represents light outer cone angle
-};
-
 /**
  * @brief Calculates the vulkan style projection matrix
  * @param proj The projection matrix
@@ -83,6 +78,14 @@ class Subpass
 	 */
 	void update_render_target_attachments();
 
+	/**
+	 * @brief Records the commands which cannot be recorded inside a render pass,
+	 *        such as compute dispatches and the barriers protecting their results.
+	 *        The RenderPipeline calls it for every subpass before beginning the render pass.
+	 * @param command_buffer Command buffer to use to record the commands
+	 */
+	virtual void pre_draw(CommandBuffer &command_buffer);
+
 	/**
 	 * @brief Draw virtual function
 	 * @param command_buffer Command buffer to use to record draw commands
@@ -95,8 +98,43 @@ class Subpass
 
 	const ShaderSource &get_fragment_shader() const;
 
+	/**
+	 * @return The name of the subpass in debug labels, by default made of its shader filenames
+	 */
+	const std::string &get_debug_name() const;
+
+	void set_debug_name(const std::string &name);
+
 	DepthStencilState &get_depth_stencil_state();
 
+	/**
+	 * @brief Sets the size of the blocks of pixels shaded by a single fragment shader invocation,
+	 *        when the device supports fragment shading rates, otherwise the subpass shades at full rate
+	 * @param fragment_size Width and height of the blocks, up to 2x2
+	 */
+	void set_shading_rate(const VkExtent2D &fragment_size);
+
+	const VkExtent2D &get_shading_rate() const;
+
+	/**
+	 * @brief Renders the subpass once for every view in the mask, each view to the matching layer
+	 *        of the attachments, which requires multiview to be enabled on the device
+	 *        All subpasses of a render pass must either use a view mask or none
+	 * @param mask Bit mask of the views, 0 to render a single view
+	 */
+	void set_view_mask(uint32_t mask);
+
+	uint32_t get_view_mask() const;
+
+	/**
+	 * @brief Lets the subpass read the color attachments it writes, listed as both input and output attachments,
+	 *        in rasterization order if the device supports it, as programmable blending on tile. Otherwise
+	 *        the draws reading the writes of the previous ones must be separated by attachment feedback barriers.
+	 */
+	void set_rasterization_order_access(bool enable);
+
+	bool is_rasterization_order_access() const;
+
 	const std::vector<uint32_t> &get_input_attachments() const;
 
 	void set_input_attachments(std::vector<uint32_t> input);
@@ -105,8 +143,32 @@ class Subpass
 
 	void set_output_attachments(std::vector<uint32_t> output);
 
+	const std::vector<uint32_t> &get_sampled_attachments() const;
+
+	/**
+	 * @brief Declares the render target attachments this subpass binds as sampled images,
+	 *        which have to be written by a previous render pass
+	 * @param sampled Set of attachment reference number sampled by the subpass
+	 */
+	void set_sampled_attachments(std::vector<uint32_t> sampled);
+
 	void set_use_dynamic_resources(bool dynamic);
 
+	/**
+	 * @return Whether the commands of this subpass are recorded inline in the primary
+	 *         command buffer or provided through secondary command buffers
+	 */
+	VkSubpassContents get_contents() const;
+
+	/**
+	 * @brief Sets the thread recording the subpass, whose frame buffer pools hold its allocations
+	 *        The RenderPipeline sets it when recording subpasses concurrently, otherwise it is 0
+	 * @param thread_index Index of the recording thread, lower than the thread count of the render frames
+	 */
+	void set_recording_thread_index(size_t thread_index);
+
+	size_t get_recording_thread_index() const;
+
 	/**
 	 * @brief Add definitions to shader variant within a subpass
 	 * 
@@ -116,36 +178,25 @@ class Subpass
 	void add_definitions(ShaderVariant &variant, const std::vector<std::string> &definitions);
 
 	/**
-	 * @brief Create a buffer allocation from scene graph lights to be bound to shaders
+	 * @brief Request the buffer of the scene graph lights to be bound to shaders
+	 *        The lights are gathered once per frame by the light manager of the render context,
+	 *        and uploaded only when they changed, see LightManager.
 	 * 
 	 * @tparam T ForwardLights / DeferredLights
 	 * @param scene_lights  Lights from the scene graph
 	 * @param max_lights MAX_FORWARD_LIGHT_COUNT / MAX_DEFERRED_LIGHT_COUNT
-	 * @return BufferAllocation A buffer allocation created for use in shaders
+	 * @return BufferAllocation A view of the light buffer of the frame, shared by the subpasses
 	 */
 	template <typename T>
 	BufferAllocation allocate_lights(const std::vector<sg::Light *> &scene_lights, size_t max_lights)
 	{
 		assert(scene_lights.size() <= max_lights && "Exceeding Max Light Capacity");
 
-		T light_info;
-		light_info.count = to_u32(scene_lights.size());
+		static_assert(offsetof(T, lights) == LightManager::LIGHTS_OFFSET, "The lights must follow the light count");
 
-		std::transform(scene_lights.begin(), scene_lights.end(), light_info.lights, [](sg::Light *light) -> Light {
-			const auto &properties = light->get_properties();
-			auto &      transform  = light->get_node()->get_transform();
-
-			return {{transform.get_translation(), static_cast<float>(light->get_light_type())},
-			        {properties.color, properties.intensity},
-			        {transform.get_rotation() * properties.direction, properties.range},
-			        {properties.inner_cone_angle, properties.outer_cone_angle}};
-		});
-
-		auto &           render_frame = get_render_context().get_active_frame();
-		BufferAllocation light_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(T));
-		light_buffer.update(light_info);
-
-		return light_buffer;
+		// Shared by the subpasses of the frame
+		auto &render_context = get_render_context();
+		return render_context.get_light_manager().request_buffer(render_context.get_active_frame(), scene_lights, sizeof(T));
 	}
 
 	/**
@@ -163,45 +214,81 @@ class Subpass
 		T light_info;
 		light_info.count = to_u32(num_lights);
 
-		std::vector<Light> lights_vector;
+		// Written in place, without an intermediate vector
 		for (uint32_t i = 0U; i < num_lights; ++i)
 		{
 			auto        light      = i < scene_lights.size() ? scene_lights.at(i) : scene_lights.back();
 			const auto &properties = light->get_properties();
 			auto &      transform  = light->get_node()->get_transform();
 
-			lights_vector.push_back(Light({{transform.get_translation(), static_cast<float>(light->get_light_type())},
-			                               {properties.color, properties.intensity},
-			                               {transform.get_rotation() * properties.direction, properties.range},
-			                               {properties.inner_cone_angle, properties.outer_cone_angle}}));
+			light_info.lights[i] = Light({{transform.get_translation(), static_cast<float>(light->get_light_type())},
+			                              {properties.color, properties.intensity},
+			                              {transform.get_rotation() * properties.direction, properties.range},
+			                              {properties.inner_cone_angle, properties.outer_cone_angle}});
 		}
 
-		std::copy(lights_vector.begin(), lights_vector.end(), light_info.lights);
-
 		auto &           render_frame = get_render_context().get_active_frame();
-		BufferAllocation light_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(T));
+		BufferAllocation light_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(T), recording_thread_index);
 		light_buffer.update(light_info);
 
 		return light_buffer;
 	}
 
+	/**
+	 * @brief Create a storage buffer allocation holding the elements of a vector
+	 *        Holds at least one element, as storage buffers can not be empty
+	 *
+	 * @param data Elements to copy to the buffer
+	 * @return BufferAllocation A buffer allocation created for use in shaders
+	 */
+	template <typename T>
+	BufferAllocation allocate_storage(const std::vector<T> &data)
+	{
+		auto &           render_frame = get_render_context().get_active_frame();
+		BufferAllocation allocation   = render_frame.allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, std::max<size_t>(data.size(), 1) * sizeof(T), recording_thread_index);
+
+		if (!data.empty())
+		{
+			allocation.update(reinterpret_cast<const uint8_t *>(data.data()), data.size() * sizeof(T));
+		}
+
+		return allocation;
+	}
+
   protected:
 	RenderContext &render_context;
 
 	bool use_dynamic_resources{false};
 
+	VkSubpassContents contents{VK_SUBPASS_CONTENTS_INLINE};
+
   private:
 	ShaderSource vertex_shader;
 
 	ShaderSource fragment_shader;
 
+	std::string debug_name;
+
 	DepthStencilState depth_stencil_state{};
 
+	/// Default to full rate shading
+	VkExtent2D shading_rate{1, 1};
+
+	/// Default to a single view, without multiview
+	uint32_t view_mask{0};
+
+	bool rasterization_order_access{false};
+
+	size_t recording_thread_index{0};
+
 	/// Default to no input attachments
 	std::vector<uint32_t> input_attachments = {};
 
 	/// Default to swapchain output attachment
 	std::vector<uint32_t> output_attachments = {0};
+
+	/// Default to no sampled attachments
+	std::vector<uint32_t> sampled_attachments = {};
 };
 
 }        // namespace vkb
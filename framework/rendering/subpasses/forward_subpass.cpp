@@ -20,14 +20,20 @@
 
 #include "rendering/subpasses/forward_subpass.h"
 
+#include <algorithm>
+#include <cstddef>
+
 #include "common/utils.h"
 #include "common/vk_common.h"
 #include "rendering/render_context.h"
+#include "rendering/subpasses/shader_layout.h"
 #include "scene_graph/components/camera.h"
 #include "scene_graph/components/image.h"
+#include "scene_graph/components/light.h"
 #include "scene_graph/components/material.h"
 #include "scene_graph/components/mesh.h"
 #include "scene_graph/components/pbr_material.h"
+#include "scene_graph/components/perspective_camera.h"
 #include "scene_graph/components/sub_mesh.h"
 #include "scene_graph/components/texture.h"
 #include "scene_graph/node.h"
@@ -35,6 +41,11 @@
 
 namespace vkb
 {
+// The light buffer is copied as it is to the lights block of base.frag, whose layout the shader_precompiler generates
+static_assert(offsetof(ForwardLights, count) == shader_layout::LightsInfo::count_offset, "ForwardLights::count does not match base.frag");
+static_assert(offsetof(ForwardLights, lights) == shader_layout::LightsInfo::light_offset, "ForwardLights::lights does not match base.frag");
+static_assert(sizeof(ForwardLights) == shader_layout::LightsInfo::size, "ForwardLights does not match base.frag");
+
 ForwardSubpass::ForwardSubpass(RenderContext &render_context, ShaderSource &&vertex_source, ShaderSource &&fragment_source, sg::Scene &scene_, sg::Camera &camera) :
     GeometrySubpass{render_context, std::move(vertex_source), std::move(fragment_source), scene_, camera}
 {
@@ -42,31 +53,164 @@ ForwardSubpass::ForwardSubpass(RenderContext &render_context, ShaderSource &&ver
 
 void ForwardSubpass::prepare()
 {
-	// By default use dynamic resources
-	use_dynamic_resources = true;
-
-	auto &device = render_context.get_device();
-	for (auto &mesh : meshes)
+	if (clustered_lighting || scene.get_components<sg::Light>().size() > MAX_FORWARD_LIGHT_COUNT)
 	{
-		for (auto &sub_mesh : mesh->get_submeshes())
+		cluster_camera     = dynamic_cast<sg::PerspectiveCamera *>(&camera);
+		clustered_lighting = cluster_camera != nullptr;
+
+		if (!clustered_lighting)
 		{
-			auto &variant = sub_mesh->get_mut_shader_variant();
+			LOGW("Clustered lighting requires a perspective camera, lights are limited to {}", MAX_FORWARD_LIGHT_COUNT);
+		}
+	}
+
+	if (shadows_enabled)
+	{
+		shadow_camera = dynamic_cast<sg::PerspectiveCamera *>(&camera);
 
-			// Same as Geometry except adds lighting definitions to sub mesh variants.
-			add_definitions(variant, {"MAX_FORWARD_LIGHT_COUNT " + std::to_string(MAX_FORWARD_LIGHT_COUNT)});
-			add_definitions(variant, light_type_definitions);
+		auto &lights = scene.get_components<sg::Light>();
 
-			auto &vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
-			auto &frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
+		auto shadow_light = std::find_if(lights.begin(), lights.end(), [](sg::Light *light) {
+			return light->get_light_type() == sg::LightType::Directional && light->get_shadow_properties().cast_shadows;
+		});
+
+		if (!shadow_camera)
+		{
+			LOGW("Shadows require a perspective camera, they are disabled");
 		}
+		else if (shadow_light != lights.end())
+		{
+			shadow_map = std::make_unique<CascadedShadowMap>(render_context, scene, **shadow_light);
+		}
+		else
+		{
+			LOGW("No directional light of the scene casts shadows, they are disabled");
+		}
+
+		shadows_enabled = shadow_map != nullptr;
+	}
+
+	GeometrySubpass::prepare();
+}
+
+void ForwardSubpass::add_subpass_definitions(ShaderVariant &variant)
+{
+	// Same as Geometry except adds lighting definitions to sub mesh variants.
+	add_definitions(variant, {"MAX_FORWARD_LIGHT_COUNT " + std::to_string(MAX_FORWARD_LIGHT_COUNT)});
+	add_definitions(variant, light_type_definitions);
+
+	if (clustered_lighting)
+	{
+		add_definitions(variant, {"CLUSTERED_LIGHTING"});
+	}
+
+	if (shadows_enabled)
+	{
+		add_definitions(variant, {"SHADOWS", "MAX_SHADOW_CASCADES " + std::to_string(MAX_SHADOW_CASCADES)});
 	}
 }
 
+void ForwardSubpass::pre_draw(CommandBuffer &command_buffer)
+{
+	if (shadows_enabled)
+	{
+		shadow_map->update(*shadow_camera);
+		shadow_map->draw(command_buffer);
+	}
+
+	GeometrySubpass::pre_draw(command_buffer);
+}
+
 void ForwardSubpass::draw(CommandBuffer &command_buffer)
 {
-	auto lights_buffer = allocate_lights<ForwardLights>(scene.get_components<sg::Light>(), MAX_FORWARD_LIGHT_COUNT);
-	command_buffer.bind_buffer(lights_buffer.get_buffer(), lights_buffer.get_offset(), lights_buffer.get_size(), 0, 4, 0);
+	if (clustered_lighting)
+	{
+		auto &render_frame = render_context.get_active_frame();
+
+		light_clusters.update(scene.get_components<sg::Light>(), *cluster_camera, render_frame.get_render_target().get_extent());
+
+		lights_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(ClusterUniform), get_recording_thread_index());
+		lights_buffer.update(light_clusters.get_uniform());
+
+		cluster_lights_buffer  = allocate_storage(light_clusters.get_lights());
+		cluster_ranges_buffer  = allocate_storage(light_clusters.get_cluster_ranges());
+		cluster_indices_buffer = allocate_storage(light_clusters.get_light_indices());
+	}
+	else
+	{
+		lights_buffer = allocate_lights<ForwardLights>(scene.get_components<sg::Light>(), MAX_FORWARD_LIGHT_COUNT);
+	}
+
+	if (shadows_enabled)
+	{
+		shadow_buffer = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(ShadowUniform), get_recording_thread_index());
+		shadow_buffer.update(shadow_map->get_uniform());
+	}
 
 	GeometrySubpass::draw(command_buffer);
 }
+
+void ForwardSubpass::set_clustered_lighting(bool enable)
+{
+	clustered_lighting = enable;
+}
+
+bool ForwardSubpass::is_clustered_lighting() const
+{
+	return clustered_lighting;
+}
+
+void ForwardSubpass::set_shadows_enabled(bool enable)
+{
+	shadows_enabled = enable;
+}
+
+bool ForwardSubpass::is_shadows_enabled() const
+{
+	return shadows_enabled;
+}
+
+CascadedShadowMap *ForwardSubpass::get_shadow_map()
+{
+	return shadow_map.get();
+}
+
+void ForwardSubpass::bind_common_resources(CommandBuffer &command_buffer)
+{
+	GeometrySubpass::bind_common_resources(command_buffer);
+
+	uint32_t frame_set = get_descriptor_set(DescriptorSetFrequency::Frame);
+
+	command_buffer.bind_buffer(lights_buffer.get_buffer(), lights_buffer.get_offset(), lights_buffer.get_size(), frame_set, 4, 0);
+
+	if (clustered_lighting)
+	{
+		command_buffer.bind_buffer(cluster_lights_buffer.get_buffer(), cluster_lights_buffer.get_offset(), cluster_lights_buffer.get_size(), frame_set, 6, 0);
+		command_buffer.bind_buffer(cluster_ranges_buffer.get_buffer(), cluster_ranges_buffer.get_offset(), cluster_ranges_buffer.get_size(), frame_set, 7, 0);
+		command_buffer.bind_buffer(cluster_indices_buffer.get_buffer(), cluster_indices_buffer.get_offset(), cluster_indices_buffer.get_size(), frame_set, 8, 0);
+	}
+
+	if (shadows_enabled)
+	{
+		command_buffer.bind_image(shadow_map->get_atlas_view(), shadow_map->get_sampler(), frame_set, 10, 0);
+		command_buffer.bind_buffer(shadow_buffer.get_buffer(), shadow_buffer.get_offset(), shadow_buffer.get_size(), frame_set, 11, 0);
+	}
+}
+
+std::size_t ForwardSubpass::get_common_resources_signature()
+{
+	std::size_t signature = GeometrySubpass::get_common_resources_signature();
+
+	for (auto buffer : {&lights_buffer, &cluster_lights_buffer, &cluster_ranges_buffer, &cluster_indices_buffer, &shadow_buffer})
+	{
+		if (!buffer->empty())
+		{
+			hash_combine(signature, buffer->get_buffer().get_handle());
+			hash_combine(signature, buffer->get_offset());
+			hash_combine(signature, buffer->get_size());
+		}
+	}
+
+	return signature;
+}
 }        // namespace vkb
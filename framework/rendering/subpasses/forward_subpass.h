@@ -23,6 +23,8 @@
 #include "common/error.h"
 
 #include "buffer_pool.h"
+#include "rendering/cascaded_shadow_map.h"
+#include "rendering/light_clusters.h"
 #include "rendering/subpasses/geometry_subpass.h"
 
 #define MAX_FORWARD_LIGHT_COUNT 16
@@ -36,6 +38,7 @@ class Node;
 class Mesh;
 class SubMesh;
 class Camera;
+class PerspectiveCamera;
 }        // namespace sg
 
 struct alignas(16) ForwardLights
@@ -64,10 +67,79 @@ class ForwardSubpass : public GeometrySubpass
 
 	virtual void prepare() override;
 
+	/**
+	 * @brief Redraws the shadow map if shadows are enabled, then prepares the geometry draws
+	 */
+	virtual void pre_draw(CommandBuffer &command_buffer) override;
+
 	/**
 	 * @brief Record draw commands
 	 */
 	virtual void draw(CommandBuffer &command_buffer) override;
+
+	/**
+	 * @brief Bins the lights into clusters of the view frustum, so that each fragment only
+	 *        loops over the lights reaching it and the scene is not limited to MAX_FORWARD_LIGHT_COUNT.
+	 *        Enabled automatically when the scene has more lights than that.
+	 *        Requires a perspective camera and must be set before the subpass is prepared.
+	 */
+	void set_clustered_lighting(bool enable);
+
+	bool is_clustered_lighting() const;
+
+	/**
+	 * @brief Shadows the first directional light of the scene which casts shadows with a CascadedShadowMap.
+	 *        Requires a perspective camera, the fragment shader must support the SHADOWS define,
+	 *        and this must be set before the subpass is prepared.
+	 */
+	void set_shadows_enabled(bool enable);
+
+	bool is_shadows_enabled() const;
+
+	/**
+	 * @return The shadow map of the subpass, or nullptr if shadows are disabled
+	 */
+	CascadedShadowMap *get_shadow_map();
+
+  protected:
+	/**
+	 * @brief Adds the light definitions, and those of clustered lighting and shadows when they are enabled
+	 */
+	virtual void add_subpass_definitions(ShaderVariant &variant) override;
+
+	/**
+	 * @brief Binds the lights buffer of the frame
+	 */
+	virtual void bind_common_resources(CommandBuffer &command_buffer) override;
+
+	/**
+	 * @brief Hashes the location of the light buffers, which are allocated from the frame every draw
+	 */
+	virtual std::size_t get_common_resources_signature() override;
+
+	/// Lights of the frame, allocated by draw() before the common resources are bound
+	BufferAllocation lights_buffer;
+
+  private:
+	bool clustered_lighting{false};
+
+	sg::PerspectiveCamera *cluster_camera{nullptr};
+
+	LightClusters light_clusters;
+
+	BufferAllocation cluster_lights_buffer;
+
+	BufferAllocation cluster_ranges_buffer;
+
+	BufferAllocation cluster_indices_buffer;
+
+	bool shadows_enabled{false};
+
+	sg::PerspectiveCamera *shadow_camera{nullptr};
+
+	std::unique_ptr<CascadedShadowMap> shadow_map;
+
+	BufferAllocation shadow_buffer;
 };
 
 }        // namespace vkb
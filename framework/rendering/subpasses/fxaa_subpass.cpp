@@ -0,0 +1,84 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "rendering/subpasses/fxaa_subpass.h"
+
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+FxaaSubpass::FxaaSubpass(RenderContext &render_context, ShaderSource &&vertex_shader, ShaderSource &&fragment_shader, uint32_t ldr_attachment) :
+    Subpass{render_context, std::move(vertex_shader), std::move(fragment_shader)},
+    ldr_attachment{ldr_attachment}
+{
+}
+
+void FxaaSubpass::prepare()
+{
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+	resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), {});
+	resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), {});
+
+	// Bilinear taps blend the pixels along the edges
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.maxAnisotropy = 1.0f;
+	sampler_info.magFilter     = VK_FILTER_LINEAR;
+	sampler_info.minFilter     = VK_FILTER_LINEAR;
+	sampler_info.mipmapMode    = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+	sampler = std::make_unique<core::Sampler>(render_context.get_device(), sampler_info);
+}
+
+void FxaaSubpass::draw(CommandBuffer &command_buffer)
+{
+	auto &resource_cache     = command_buffer.get_device().get_resource_cache();
+	auto &vert_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), {});
+	auto &frag_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), {});
+
+	std::vector<ShaderModule *> shader_modules{&vert_shader_module, &frag_shader_module};
+
+	auto &pipeline_layout = resource_cache.request_pipeline_layout(shader_modules, use_dynamic_resources);
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	RasterizationState rasterization_state;
+	rasterization_state.cull_mode = VK_CULL_MODE_NONE;
+	command_buffer.set_rasterization_state(rasterization_state);
+
+	DepthStencilState depth_stencil_state;
+	depth_stencil_state.depth_test_enable  = VK_FALSE;
+	depth_stencil_state.depth_write_enable = VK_FALSE;
+	command_buffer.set_depth_stencil_state(depth_stencil_state);
+
+	auto &render_target = render_context.get_active_frame().get_render_target();
+
+	command_buffer.bind_image(render_target.get_views().at(ldr_attachment), *sampler, 0, 0, 0);
+
+	const auto &extent = render_target.get_extent();
+
+	glm::vec2 inv_resolution{1.0f / extent.width, 1.0f / extent.height};
+	command_buffer.push_constants(0, inv_resolution);
+
+	// Draw full screen triangle
+	command_buffer.draw(3, 1, 0, 0);
+}
+}        // namespace vkb
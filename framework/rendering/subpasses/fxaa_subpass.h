@@ -0,0 +1,47 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "core/sampler.h"
+#include "rendering/subpass.h"
+
+namespace vkb
+{
+/**
+ * @brief Smooths the edges of a tonemapped color attachment with FXAA
+ *        FXAA reads the neighbors of each pixel, so the attachment is sampled
+ *        from memory after the render pass writing it
+ */
+class FxaaSubpass : public Subpass
+{
+  public:
+	FxaaSubpass(RenderContext &render_context, ShaderSource &&vertex_shader, ShaderSource &&fragment_shader, uint32_t ldr_attachment);
+
+	virtual void prepare() override;
+
+	virtual void draw(CommandBuffer &command_buffer) override;
+
+  private:
+	uint32_t ldr_attachment;
+
+	std::unique_ptr<core::Sampler> sampler;
+};
+}        // namespace vkb
@@ -19,251 +19,2946 @@
  */
 
 #include "rendering/subpasses/geometry_subpass.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+
+#include "common/helpers.h"
+#include "common/logging.h"
 #include "common/utils.h"
 #include "common/vk_common.h"
+#include "cpu_profiler.h"
 #include "rendering/render_context.h"
+#include "rendering/subpasses/shader_layout.h"
+#include "scene_graph/components/bvh.h"
 #include "scene_graph/components/camera.h"
 #include "scene_graph/components/image.h"
 #include "scene_graph/components/material.h"
 #include "scene_graph/components/mesh.h"
 #include "scene_graph/components/pbr_material.h"
+#include "scene_graph/components/skin.h"
 #include "scene_graph/components/texture.h"
+#include "scene_graph/components/texture_array.h"
+#include "scene_graph/frustum.h"
 #include "scene_graph/node.h"
 #include "scene_graph/scene.h"
+#include "stats.h"
+#include "texture_streamer.h"
+#include "timer.h"
 
 namespace vkb
 {
+// The uniforms are copied as they are to the blocks of the base shaders, whose layout the shader_precompiler generates
+static_assert(offsetof(GlobalUniform, model) == shader_layout::GlobalUniform::model_offset, "GlobalUniform::model does not match the base shaders");
+static_assert(offsetof(GlobalUniform, camera_view_proj) == shader_layout::GlobalUniform::view_proj_offset, "GlobalUniform::camera_view_proj does not match the base shaders");
+static_assert(offsetof(GlobalUniform, camera_position) == shader_layout::GlobalUniform::camera_position_offset, "GlobalUniform::camera_position does not match the base shaders");
+static_assert(sizeof(GlobalUniform) >= shader_layout::GlobalUniform::size, "GlobalUniform is smaller than in the base shaders");
+
+static_assert(offsetof(PBRMaterialUniform, base_color_factor) == shader_layout::PBRMaterialUniform::base_color_factor_offset, "PBRMaterialUniform::base_color_factor does not match base.frag");
+static_assert(offsetof(PBRMaterialUniform, metallic_factor) == shader_layout::PBRMaterialUniform::metallic_factor_offset, "PBRMaterialUniform::metallic_factor does not match base.frag");
+static_assert(offsetof(PBRMaterialUniform, roughness_factor) == shader_layout::PBRMaterialUniform::roughness_factor_offset, "PBRMaterialUniform::roughness_factor does not match base.frag");
+static_assert(sizeof(PBRMaterialUniform) == shader_layout::PBRMaterialUniform::size, "PBRMaterialUniform does not match base.frag");
+
+namespace
+{
+/**
+ * @brief Input of the culling shader for every GPU driven draw
+ */
+struct alignas(16) IndirectDrawRecord
+{
+	glm::vec4 bounds_min;
+
+	glm::vec4 bounds_max;
+
+	uint32_t index_count;
+
+	uint32_t first_index;
+
+	uint32_t padding[2];
+};
+
+/**
+ * @brief Uniform of the culling shader
+ */
+struct alignas(16) CullingUniform
+{
+	std::array<glm::vec4, 6> frustum_planes;
+
+	uint32_t draw_count;
+};
+
+/**
+ * @brief Bounds of a meshlet read by the meshlet culling shader, see sg::Meshlet
+ */
+struct alignas(16) MeshletBounds
+{
+	glm::vec4 bounding_sphere;
+
+	glm::vec4 normal_cone;
+
+	/// First index within the whole index buffer of the submesh
+	uint32_t first_index;
+
+	uint32_t index_count;
+
+	uint32_t padding[2];
+};
+
+/**
+ * @brief Input of the meshlet culling shader for every GPU driven draw of a submesh split into meshlets
+ */
+struct alignas(16) MeshletDrawRecord
+{
+	glm::mat4 model;
+
+	uint32_t first_meshlet;
+
+	uint32_t meshlet_count;
+
+	uint32_t first_command;
+
+	/// Whether back facing meshlets can be skipped, which double sided materials do not allow
+	uint32_t cone_culling;
+};
+
+/**
+ * @brief Uniform of the meshlet culling shader
+ */
+struct alignas(16) MeshletCullingUniform
+{
+	std::array<glm::vec4, 6> frustum_planes;
+
+	glm::vec4 camera_position;
+
+	uint32_t draw_count;
+};
+
+/// Work group size of the culling shader
+constexpr uint32_t CULLING_GROUP_SIZE = 64;
+
+/// Binding of the texture array of the fragment shader when textures are bindless
+constexpr uint32_t BINDLESS_TEXTURE_BINDING = 5;
+
+/// Material textures selected at run time by specialized materials and uber shaders, with their specialization constant identifiers,
+/// in the order of their bits in the texture mask of the uber shaders
+const std::array<std::pair<const char *, uint32_t>, 3> SELECTED_MATERIAL_TEXTURES{{{"base_color_texture", 10},
+                                                                                   {"normal_texture", 11},
+                                                                                   {"metallic_roughness_texture", 12}}};
+
+/**
+ * @return The processes of a variant without the defines of the material textures selected at run time
+ */
+std::vector<std::string> get_processes_without_material_textures(const ShaderVariant &variant)
+{
+	std::vector<std::string> texture_processes{"DSPECIALIZED_MATERIAL"};
+	for (auto &texture : SELECTED_MATERIAL_TEXTURES)
+	{
+		std::string texture_name = texture.first;
+		std::transform(texture_name.begin(), texture_name.end(), texture_name.begin(), ::toupper);
+
+		texture_processes.push_back("DHAS_" + texture_name);
+	}
+
+	std::vector<std::string> processes;
+	for (auto &process : variant.get_processes())
+	{
+		if (std::find(texture_processes.begin(), texture_processes.end(), process) == texture_processes.end())
+		{
+			processes.push_back(process);
+		}
+	}
+
+	return processes;
+}
+
+/// Binding of the view uniform of the vertex and fragment shaders with view uniforms
+constexpr uint32_t VIEW_UNIFORM_BINDING = 12;
+
+/// Binding of the joint matrices of the vertex shader when drawing skinned meshes
+constexpr uint32_t JOINT_MATRICES_BINDING = 9;
+
+/**
+ * @brief Push constants of the occlusion box shader
+ */
+struct alignas(16) OcclusionBox
+{
+	glm::mat4 view_proj;
+
+	glm::vec4 bounds_min;
+
+	glm::vec4 bounds_max;
+};
+
+/// Margin around the bounds of a node, relative to their size, within which the camera never culls the node
+constexpr float OCCLUSION_CAMERA_MARGIN = 0.05f;
+
+/// Distance below which nodes are considered at the camera when selecting their texture levels
+constexpr float MIN_TEXTURE_DISTANCE = 0.01f;
+
+/// Largest error in pixels of the level of detail selected for a submesh
+constexpr float LOD_PIXEL_ERROR = 1.0f;
+
+/// Fraction of LOD_PIXEL_ERROR the error must cross beyond the threshold to switch levels
+constexpr float LOD_HYSTERESIS = 0.25f;
+
+/// Block size in bytes of the buffer pools of a cached command buffer
+constexpr VkDeviceSize CACHED_BUFFER_BLOCK_SIZE = 64 * 1024;
+
+/// Bits of the draw sort state IDs below the pipeline ID, which hold the material ID
+constexpr uint32_t SORT_MATERIAL_BITS = 19;
+
+constexpr uint32_t SORT_MATERIAL_MASK = (1U << SORT_MATERIAL_BITS) - 1;
+
+/**
+ * @return A color blend state which writes none of the color attachments
+ */
+ColorBlendState get_depth_only_blend_state(size_t attachment_count)
+{
+	ColorBlendState color_blend_state{};
+	color_blend_state.attachments.resize(attachment_count);
+
+	for (auto &attachment : color_blend_state.attachments)
+	{
+		attachment.color_write_mask = 0;
+	}
+
+	return color_blend_state;
+}
+}        // namespace
+
 GeometrySubpass::GeometrySubpass(RenderContext &render_context, ShaderSource &&vertex_source, ShaderSource &&fragment_source, sg::Scene &scene_, sg::Camera &camera) :
     Subpass{render_context, std::move(vertex_source), std::move(fragment_source)},
     meshes{scene_.get_components<sg::Mesh>()},
     camera{camera},
     scene{scene_}
 {
+	std::unordered_map<const sg::Material *, uint32_t> material_ids;
+	std::unordered_map<std::size_t, uint32_t>          pipeline_ids;
+
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			auto material = sub_mesh->get_material();
+
+			uint32_t material_id = material_ids.emplace(material, to_u32(material_ids.size())).first->second;
+
+			// Draws of the same shader variant, culling and blending share a pipeline
+			std::size_t pipeline_key = sub_mesh->get_shader_variant().get_id();
+			hash_combine(pipeline_key, material->double_sided);
+			hash_combine(pipeline_key, static_cast<uint32_t>(material->alpha_mode));
+
+			uint32_t pipeline_id = pipeline_ids.emplace(pipeline_key, to_u32(pipeline_ids.size())).first->second;
+
+			sort_state_ids.emplace(sub_mesh, (pipeline_id << SORT_MATERIAL_BITS) | (material_id & SORT_MATERIAL_MASK));
+		}
+
+		occlusion_query_offsets.emplace(mesh, occlusion_query_count);
+		occlusion_query_count += to_u32(mesh->get_nodes().size());
+	}
+
+	occluded_nodes.resize(occlusion_query_count, false);
 }
 
 void GeometrySubpass::prepare()
 {
+	// Queries in a multiview render pass use one query per view
+	assert((view_cameras.empty() || !occlusion_culling_enabled) && "Occlusion culling is not supported with multiview");
+
 	// By default use dynamic resources
 	use_dynamic_resources = true;
 
+	prepare_bindless_textures();
+
+	prepare_fallback_material_texture();
+
+	prepare_texture_arrays();
+
+	if (push_descriptors_enabled && !partitioned_descriptor_sets_enabled)
+	{
+		LOGW("Push descriptors disabled, they require partitioned descriptor sets");
+		push_descriptors_enabled = false;
+	}
+	else if (push_descriptors_enabled && !render_context.get_device().is_push_descriptor_enabled())
+	{
+		LOGW("Push descriptors disabled, the device does not support VK_KHR_push_descriptor");
+		push_descriptors_enabled = false;
+	}
+
+	uber_variants.clear();
+
+	prepare_meshlets();
+
 	// Build all shader variance upfront
 	auto &device = render_context.get_device();
 	for (auto &mesh : meshes)
 	{
 		for (auto &sub_mesh : mesh->get_submeshes())
 		{
-			auto &variant     = sub_mesh->get_shader_variant();
+			auto &variant = variants[sub_mesh];
+			variant       = sub_mesh->get_shader_variant();
+
+			add_subpass_definitions(variant);
+
+			add_specialized_material_definitions(variant);
+
+			add_bindless_definitions(variant);
+
+			add_texture_array_definitions(*sub_mesh, variant);
+
+			if (!view_cameras.empty())
+			{
+				variant.add_define("MULTIVIEW");
+			}
+
+			if (view_uniform_enabled)
+			{
+				variant.add_define("VIEW_UNIFORM");
+			}
+
+			if (partitioned_descriptor_sets_enabled)
+			{
+				variant.add_define("PARTITIONED_SETS");
+			}
+
 			auto &vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
 			auto &frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
 
-			vert_module.set_resource_dynamic("GlobalUniform");
-			frag_module.set_resource_dynamic("GlobalUniform");
+			set_global_uniform_mode(vert_module);
+			set_global_uniform_mode(frag_module);
+
+			if (uber_shader_fallback_enabled)
+			{
+				add_uber_variant(variant);
+			}
+
+			if (instancing_enabled || gpu_driven)
+			{
+				auto &instanced_variant = add_instanced_variant(*sub_mesh);
+
+				auto &instanced_vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), instanced_variant);
+				auto &instanced_frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), instanced_variant);
+
+				set_global_uniform_mode(instanced_vert_module);
+				set_global_uniform_mode(instanced_frag_module);
+
+				if (uber_shader_fallback_enabled && instancing_enabled)
+				{
+					add_uber_variant(instanced_variant);
+				}
+			}
+
+			if (depth_prepass_enabled)
+			{
+				// The pre-pass only runs the vertex shader
+				ShaderVariant depth_only_variant = variant;
+				depth_only_variant.add_define("DEPTH_ONLY");
+
+				auto &depth_only_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), depth_only_variant);
+				set_global_uniform_mode(depth_only_module);
+
+				depth_only_variants[sub_mesh] = std::move(depth_only_variant);
+
+				if (instancing_enabled)
+				{
+					ShaderVariant depth_only_instanced_variant = instanced_variants.at(sub_mesh);
+					depth_only_instanced_variant.add_define("DEPTH_ONLY");
+
+					auto &depth_only_instanced_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), depth_only_instanced_variant);
+					set_global_uniform_mode(depth_only_instanced_module);
+
+					depth_only_instanced_variants[sub_mesh] = std::move(depth_only_instanced_variant);
+				}
+			}
 		}
 	}
 }
 
-void GeometrySubpass::get_sorted_nodes(std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes, std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes)
+void GeometrySubpass::pre_draw(CommandBuffer &command_buffer)
 {
-	auto camera_transform = camera.get_node()->get_transform().get_world_matrix();
+	prepare_occlusion_queries(command_buffer);
+
+	indirect_draws.clear();
+	indirect_buffer = nullptr;
+
+	if (!gpu_driven)
+	{
+		return;
+	}
+
+	// Transient data of the frame
+	auto &arena = render_context.get_active_frame().get_arena();
+
+	ArenaVector<glm::mat4>          transforms{&arena};
+	ArenaVector<IndirectDrawRecord> records{&arena};
+	ArenaVector<MeshletDrawRecord>  meshlet_records{&arena};
+
+	uint32_t meshlet_command_count = 0;
 
 	for (auto &mesh : meshes)
 	{
-		for (auto &node : mesh->get_nodes())
-		{
-			auto node_transform = node->get_transform().get_world_matrix();
+		auto &nodes = mesh->get_nodes();
 
-			const sg::AABB &mesh_bounds = mesh->get_bounds();
+		mesh->update_world_bounds();
 
-			sg::AABB world_bounds{mesh_bounds.get_min(), mesh_bounds.get_max()};
-			world_bounds.transform(node_transform);
+		for (size_t node_index = 0; node_index < nodes.size(); ++node_index)
+		{
+			const sg::AABB &bounds = mesh->get_world_bounds(node_index);
 
-			float distance = glm::length(glm::vec3(camera_transform[3]) - world_bounds.get_center());
+			uint32_t transform_index = to_u32(transforms.size());
+			transforms.push_back(nodes[node_index]->get_transform().get_world_matrix());
 
 			for (auto &sub_mesh : mesh->get_submeshes())
 			{
-				if (sub_mesh->get_material()->alpha_mode == sg::AlphaMode::Blend)
+				if (!is_indirect_draw(*nodes[node_index], *sub_mesh))
 				{
-					transparent_nodes.emplace(distance, std::make_pair(node, sub_mesh));
+					continue;
 				}
-				else
+
+				auto meshlet_it = meshlet_offsets.find(sub_mesh);
+
+				if (meshlet_it != meshlet_offsets.end())
 				{
-					opaque_nodes.emplace(distance, std::make_pair(node, sub_mesh));
+					// Commands of the meshlets follow the commands of the other draws, see below
+					MeshletDrawRecord meshlet_record{};
+					meshlet_record.model         = transforms.back();
+					meshlet_record.first_meshlet = meshlet_it->second;
+					meshlet_record.meshlet_count = to_u32(sub_mesh->meshlets.size());
+					meshlet_record.first_command = meshlet_command_count;
+					meshlet_record.cone_culling  = !sub_mesh->get_material()->double_sided;
+					meshlet_records.push_back(meshlet_record);
+
+					indirect_draws.push_back({nodes[node_index], sub_mesh, transform_index, meshlet_command_count, meshlet_record.meshlet_count});
+
+					meshlet_command_count += meshlet_record.meshlet_count;
+					continue;
 				}
+
+				IndirectDrawRecord record{};
+				record.bounds_min  = glm::vec4(bounds.get_min(), 0.0f);
+				record.bounds_max  = glm::vec4(bounds.get_max(), 0.0f);
+				record.index_count = sub_mesh->vertex_indices;
+				record.first_index = sub_mesh->get_first_index();
+				records.push_back(record);
+
+				indirect_draws.push_back({nodes[node_index], sub_mesh, transform_index, to_u32(records.size() - 1), 1});
 			}
 		}
 	}
-}
 
-void GeometrySubpass::draw(CommandBuffer &command_buffer)
-{
-	std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> opaque_nodes;
-	std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> transparent_nodes;
+	if (indirect_draws.empty())
+	{
+		return;
+	}
 
-	get_sorted_nodes(opaque_nodes, transparent_nodes);
+	auto draw_command_count = to_u32(records.size());
 
-	// Draw opaque objects in front-to-back order
-	for (auto node_it = opaque_nodes.begin(); node_it != opaque_nodes.end(); node_it++)
+	for (auto &draw : indirect_draws)
 	{
-		update_uniform(command_buffer, *node_it->second.first);
+		if (meshlet_offsets.count(draw.sub_mesh) > 0)
+		{
+			draw.first_command += draw_command_count;
+		}
+	}
 
-		// Invert the front face if the mesh was flipped
-		const auto &scale      = node_it->second.first->get_transform().get_scale();
-		bool        flipped    = scale.x * scale.y * scale.z < 0;
-		VkFrontFace front_face = flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	for (auto &meshlet_record : meshlet_records)
+	{
+		meshlet_record.first_command += draw_command_count;
+	}
+
+	auto &render_frame = render_context.get_active_frame();
+
+	transform_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, transforms.size() * sizeof(glm::mat4));
+	transform_buffer.update(reinterpret_cast<const uint8_t *>(transforms.data()), transforms.size() * sizeof(glm::mat4));
+
+	auto frustum_planes = sg::Frustum{vulkan_style_projection(camera.get_projection()) * camera.get_view()}.get_planes();
 
-		draw_submesh(command_buffer, *node_it->second.second, front_face);
+	// The commands of a frame are only overwritten once the frame is reused
+	auto frame_index = render_context.get_active_frame_index();
+	if (frame_index >= indirect_buffers.size())
+	{
+		indirect_buffers.resize(frame_index + 1);
 	}
 
-	// Enable alpha blending
-	ColorBlendAttachmentState color_blend_attachment{};
-	color_blend_attachment.blend_enable           = VK_TRUE;
-	color_blend_attachment.src_color_blend_factor = VK_BLEND_FACTOR_SRC_ALPHA;
-	color_blend_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	VkDeviceSize commands_size = (draw_command_count + meshlet_command_count) * sizeof(VkDrawIndexedIndirectCommand);
 
-	ColorBlendState color_blend_state{};
-	color_blend_state.attachments.resize(get_output_attachments().size());
-	color_blend_state.attachments[0] = color_blend_attachment;
-	command_buffer.set_color_blend_state(color_blend_state);
+	auto &frame_indirect_buffer = indirect_buffers[frame_index];
+	if (!frame_indirect_buffer || frame_indirect_buffer->get_size() < commands_size)
+	{
+		frame_indirect_buffer = std::make_unique<core::Buffer>(render_context.get_device(),
+		                                                       commands_size,
+		                                                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		                                                       VMA_MEMORY_USAGE_GPU_ONLY);
+	}
 
-	command_buffer.set_depth_stencil_state(get_depth_stencil_state());
+	indirect_buffer = frame_indirect_buffer.get();
+
+	auto &resource_cache = render_context.get_device().get_resource_cache();
 
-	// Draw transparent objects in back-to-front order
-	for (auto node_it = transparent_nodes.rbegin(); node_it != transparent_nodes.rend(); node_it++)
+	if (!records.empty())
 	{
-		update_uniform(command_buffer, *node_it->second.first);
+		auto record_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, records.size() * sizeof(IndirectDrawRecord));
+		record_buffer.update(reinterpret_cast<const uint8_t *>(records.data()), records.size() * sizeof(IndirectDrawRecord));
+
+		CullingUniform culling_uniform{};
+		culling_uniform.frustum_planes = frustum_planes;
+		culling_uniform.draw_count     = draw_command_count;
+
+		auto culling_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(CullingUniform));
+		culling_buffer.update(culling_uniform);
+
+		if (!culling_shader)
+		{
+			culling_shader = std::make_unique<ShaderSource>("indirect_culling.comp");
+		}
+
+		auto &culling_module  = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, *culling_shader);
+		auto &pipeline_layout = resource_cache.request_pipeline_layout({&culling_module}, false);
 
-		draw_submesh(command_buffer, *node_it->second.second);
+		command_buffer.bind_pipeline_layout(pipeline_layout);
+
+		command_buffer.bind_buffer(record_buffer.get_buffer(), record_buffer.get_offset(), record_buffer.get_size(), 0, 0, 0);
+		command_buffer.bind_buffer(*indirect_buffer, 0, commands_size, 0, 1, 0);
+		command_buffer.bind_buffer(culling_buffer.get_buffer(), culling_buffer.get_offset(), culling_buffer.get_size(), 0, 2, 0);
+
+		command_buffer.dispatch((culling_uniform.draw_count + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE, 1, 1);
 	}
-}
 
-void GeometrySubpass::update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index)
-{
-	GlobalUniform global_uniform;
+	if (!meshlet_records.empty())
+	{
+		auto meshlet_record_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, meshlet_records.size() * sizeof(MeshletDrawRecord));
+		meshlet_record_buffer.update(reinterpret_cast<const uint8_t *>(meshlet_records.data()), meshlet_records.size() * sizeof(MeshletDrawRecord));
 
-	global_uniform.camera_view_proj = vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
+		MeshletCullingUniform culling_uniform{};
+		culling_uniform.frustum_planes  = frustum_planes;
+		culling_uniform.camera_position = camera.get_node()->get_transform().get_world_matrix()[3];
+		culling_uniform.draw_count      = to_u32(meshlet_records.size());
 
-	auto &render_frame = get_render_context().get_active_frame();
+		auto culling_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(MeshletCullingUniform));
+		culling_buffer.update(culling_uniform);
+
+		if (!meshlet_culling_shader)
+		{
+			meshlet_culling_shader = std::make_unique<ShaderSource>("meshlet_culling.comp");
+		}
 
-	auto &transform = node.get_transform();
+		auto &culling_module  = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, *meshlet_culling_shader);
+		auto &pipeline_layout = resource_cache.request_pipeline_layout({&culling_module}, false);
 
-	auto allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(GlobalUniform), thread_index);
+		command_buffer.bind_pipeline_layout(pipeline_layout);
 
-	global_uniform.model = transform.get_world_matrix();
+		command_buffer.bind_buffer(*meshlet_buffer, 0, meshlet_buffer->get_size(), 0, 0, 0);
+		command_buffer.bind_buffer(meshlet_record_buffer.get_buffer(), meshlet_record_buffer.get_offset(), meshlet_record_buffer.get_size(), 0, 1, 0);
+		command_buffer.bind_buffer(*indirect_buffer, 0, commands_size, 0, 2, 0);
+		command_buffer.bind_buffer(culling_buffer.get_buffer(), culling_buffer.get_offset(), culling_buffer.get_size(), 0, 3, 0);
 
-	global_uniform.camera_position = glm::vec3(glm::inverse(camera.get_view())[3]);
+		// One work group per draw, looping over its meshlets
+		command_buffer.dispatch(culling_uniform.draw_count, 1, 1);
+	}
 
-	allocation.update(global_uniform);
+	// Make the commands visible to the indirect draws of the render pass
+	BufferMemoryBarrier barrier{};
+	barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	barrier.dst_stage_mask  = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+	barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dst_access_mask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
 
-	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 1, 0);
+	command_buffer.buffer_memory_barrier(*indirect_buffer, 0, commands_size, barrier);
 }
 
-void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face)
+const ShaderVariant &GeometrySubpass::add_instanced_variant(sg::SubMesh &sub_mesh)
 {
-	auto &device = command_buffer.get_device();
+	ShaderVariant instanced_variant = get_shader_variant(sub_mesh);
+	instanced_variant.add_define("INSTANCING");
 
-	RasterizationState rasterization_state{};
-	rasterization_state.front_face = front_face;
+	return instanced_variants[&sub_mesh] = std::move(instanced_variant);
+}
 
-	if (sub_mesh.get_material()->double_sided)
+const ShaderVariant &GeometrySubpass::get_shader_variant(const sg::SubMesh &sub_mesh) const
+{
+	auto variant_it = variants.find(&sub_mesh);
+
+	if (variant_it == variants.end())
 	{
-		rasterization_state.cull_mode = VK_CULL_MODE_NONE;
+		return sub_mesh.get_shader_variant();
 	}
 
-	command_buffer.set_rasterization_state(rasterization_state);
-
-	auto &vert_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), sub_mesh.get_shader_variant());
-	auto &frag_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), sub_mesh.get_shader_variant());
+	return variant_it->second;
+}
 
-	std::vector<ShaderModule *> shader_modules{&vert_shader_module, &frag_shader_module};
+void GeometrySubpass::add_subpass_definitions(ShaderVariant &variant)
+{
+}
 
-	auto &pipeline_layout = device.get_resource_cache().request_pipeline_layout(shader_modules, use_dynamic_resources);
+void GeometrySubpass::prepare_meshlets()
+{
+	meshlet_offsets.clear();
+	meshlet_buffer.reset();
 
-	command_buffer.bind_pipeline_layout(pipeline_layout);
+	if (!gpu_driven)
+	{
+		return;
+	}
 
-	auto pbr_material = dynamic_cast<const sg::PBRMaterial *>(sub_mesh.get_material());
+	std::vector<MeshletBounds> bounds;
 
-	PBRMaterialUniform pbr_material_uniform{};
-	pbr_material_uniform.base_color_factor = pbr_material->base_color_factor;
-	pbr_material_uniform.metallic_factor   = pbr_material->metallic_factor;
-	pbr_material_uniform.roughness_factor  = pbr_material->roughness_factor;
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			if (sub_mesh->meshlets.empty() || meshlet_offsets.count(sub_mesh) > 0)
+			{
+				continue;
+			}
 
-	command_buffer.push_constants_accumulated(pbr_material_uniform);
+			meshlet_offsets[sub_mesh] = to_u32(bounds.size());
 
-	auto &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(0);
+			for (auto &meshlet : sub_mesh->meshlets)
+			{
+				MeshletBounds meshlet_bounds{};
+				meshlet_bounds.bounding_sphere = meshlet.bounding_sphere;
+				meshlet_bounds.normal_cone     = meshlet.normal_cone;
+				meshlet_bounds.first_index     = sub_mesh->get_first_index() + meshlet.first_index;
+				meshlet_bounds.index_count     = meshlet.index_count;
+				bounds.push_back(meshlet_bounds);
+			}
+		}
+	}
 
-	for (auto &texture : sub_mesh.get_material()->textures)
+	if (bounds.empty())
 	{
-		if (auto layout_binding = descriptor_set_layout.get_layout_binding(texture.first))
-		{
-			command_buffer.bind_image(texture.second->get_image()->get_vk_image_view(),
-			                          texture.second->get_sampler()->vk_sampler,
-			                          0, layout_binding->binding, 0);
-		}
+		return;
 	}
 
-	auto vertex_input_resources = pipeline_layout.get_shader_program().get_resources(ShaderResourceType::Input, VK_SHADER_STAGE_VERTEX_BIT);
+	VkDeviceSize size = bounds.size() * sizeof(MeshletBounds);
 
-	VertexInputState vertex_input_state;
+	meshlet_buffer = std::make_unique<core::Buffer>(render_context.get_device(), size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	meshlet_buffer->update(reinterpret_cast<const uint8_t *>(bounds.data()), size);
+}
 
-	for (auto &input_resource : vertex_input_resources)
+void GeometrySubpass::prepare_bindless_textures()
+{
+	bindless_textures.clear();
+	bindless_texture_indices.clear();
+
+	if (!bindless_textures_enabled)
 	{
-		sg::VertexAttribute attribute;
+		return;
+	}
 
-		if (!sub_mesh.get_attribute(input_resource.name, attribute))
+	for (auto texture : scene.get_components<sg::Texture>())
+	{
+		if (texture->get_image() && texture->get_sampler())
 		{
-			continue;
+			bindless_texture_indices.emplace(texture, to_u32(bindless_textures.size()));
+			bindless_textures.push_back(texture);
 		}
+	}
 
-		VkVertexInputAttributeDescription vertex_attribute{};
-		vertex_attribute.binding  = input_resource.location;
-		vertex_attribute.format   = attribute.format;
-		vertex_attribute.location = input_resource.location;
-		vertex_attribute.offset   = attribute.offset;
-
-		vertex_input_state.attributes.push_back(vertex_attribute);
+	auto &device = render_context.get_device();
+	auto &limits = device.get_properties().limits;
 
-		VkVertexInputBindingDescription vertex_binding{};
-		vertex_binding.binding = input_resource.location;
-		vertex_binding.stride  = attribute.stride;
+	uint32_t max_texture_count = std::min({limits.maxPerStageDescriptorSamplers,
+	                                       limits.maxPerStageDescriptorSampledImages,
+	                                       limits.maxDescriptorSetSamplers,
+	                                       limits.maxDescriptorSetSampledImages});
 
-		vertex_input_state.bindings.push_back(vertex_binding);
+	if (!device.get_features().shaderSampledImageArrayDynamicIndexing)
+	{
+		LOGW("Bindless textures disabled, the device cannot index sampler arrays dynamically");
+		bindless_textures_enabled = false;
 	}
-
-	command_buffer.set_vertex_input_state(vertex_input_state);
-
-	// Find submesh vertex buffers matching the shader input attribute names
-	for (auto &input_resource : vertex_input_resources)
+	else if (bindless_textures.empty() || bindless_textures.size() > max_texture_count)
 	{
-		const auto &buffer_iter = sub_mesh.vertex_buffers.find(input_resource.name);
-
-		if (buffer_iter != sub_mesh.vertex_buffers.end())
-		{
-			std::vector<std::reference_wrapper<const core::Buffer>> buffers;
-			buffers.emplace_back(std::ref(buffer_iter->second));
+		LOGW("Bindless textures disabled, the scene has {} textures for a limit of {}", bindless_textures.size(), max_texture_count);
+		bindless_textures_enabled = false;
+	}
 
-			// Bind vertex buffers only for the attribute locations defined
-			command_buffer.bind_vertex_buffers(input_resource.location, std::move(buffers), {0});
-		}
+	if (!bindless_textures_enabled)
+	{
+		bindless_textures.clear();
+		bindless_texture_indices.clear();
 	}
+}
 
-	draw_submesh_command(command_buffer, sub_mesh);
+void GeometrySubpass::add_bindless_definitions(ShaderVariant &variant)
+{
+	if (bindless_textures_enabled)
+	{
+		add_definitions(variant, {"BINDLESS_TEXTURES", "BINDLESS_TEXTURE_COUNT " + std::to_string(bindless_textures.size())});
+	}
 }
 
-void GeometrySubpass::draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh)
+void GeometrySubpass::prepare_fallback_material_texture()
 {
+	fallback_material_texture = nullptr;
+
+	if (!specialized_materials_enabled && !uber_shader_fallback_enabled)
+	{
+		return;
+	}
+
+	if (bindless_textures_enabled)
+	{
+		// Bindless materials already share their shader modules
+		LOGW("Specialized materials and uber shader fallbacks disabled, they are not used with bindless textures");
+		specialized_materials_enabled = false;
+		uber_shader_fallback_enabled  = false;
+		return;
+	}
+
+	for (auto texture : scene.get_components<sg::Texture>())
+	{
+		if (texture->get_image() && texture->get_sampler())
+		{
+			fallback_material_texture = texture;
+			break;
+		}
+	}
+
+	if (!fallback_material_texture)
+	{
+		LOGW("Specialized materials and uber shader fallbacks disabled, the scene has no textures");
+		specialized_materials_enabled = false;
+		uber_shader_fallback_enabled  = false;
+	}
+}
+
+void GeometrySubpass::prepare_texture_arrays()
+{
+	if (!texture_arrays_enabled)
+	{
+		return;
+	}
+
+	if (bindless_textures_enabled || specialized_materials_enabled || uber_shader_fallback_enabled)
+	{
+		// Those modes already share the descriptor sets or shader modules of the materials in their own way
+		LOGW("Texture arrays disabled, they are not used with bindless textures, specialized materials or uber shader fallbacks");
+		texture_arrays_enabled = false;
+	}
+	else if (scene.get_components<sg::TextureArray>().empty())
+	{
+		LOGW("Texture arrays disabled, the scene has no texture arrays");
+		texture_arrays_enabled = false;
+	}
+}
+
+void GeometrySubpass::add_texture_array_definitions(const sg::SubMesh &sub_mesh, ShaderVariant &variant)
+{
+	if (texture_arrays_enabled && get_array_texture(*sub_mesh.get_material()))
+	{
+		variant.add_define("TEXTURE_ARRAYS");
+	}
+}
+
+sg::Texture *GeometrySubpass::get_array_texture(const sg::Material &material) const
+{
+	if (!texture_arrays_enabled)
+	{
+		return nullptr;
+	}
+
+	// Only the base color texture is sampled from an array by the shaders
+	auto texture_it = material.textures.find("base_color_texture");
+
+	if (texture_it == material.textures.end() || !texture_it->second->get_array())
+	{
+		return nullptr;
+	}
+
+	return texture_it->second;
+}
+
+void GeometrySubpass::add_specialized_material_definitions(ShaderVariant &variant)
+{
+	if (!specialized_materials_enabled)
+	{
+		return;
+	}
+
+	ShaderVariant specialized_variant{get_processes_without_material_textures(variant)};
+	specialized_variant.set_runtime_array_sizes(variant.get_runtime_array_sizes());
+	specialized_variant.add_define("SPECIALIZED_MATERIAL");
+
+	variant = std::move(specialized_variant);
+}
+
+void GeometrySubpass::add_uber_variant(const ShaderVariant &variant)
+{
+	ShaderVariant uber_variant{get_processes_without_material_textures(variant)};
+	uber_variant.set_runtime_array_sizes(variant.get_runtime_array_sizes());
+	uber_variant.add_define("UBER_MATERIAL");
+
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	auto &vert_module = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), uber_variant);
+	auto &frag_module = resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), uber_variant);
+
+	set_global_uniform_mode(vert_module);
+	set_global_uniform_mode(frag_module);
+
+	uber_variants[&variant] = std::move(uber_variant);
+}
+
+void GeometrySubpass::set_global_uniform_mode(ShaderModule &shader_module)
+{
+	shader_module.set_resource_dynamic("GlobalUniform");
+
+	// The joint matrices share the per-draw set, so they are pushed along with the global uniform
+	if (push_descriptors_enabled)
+	{
+		shader_module.set_resource_push("GlobalUniform");
+	}
+}
+
+uint32_t GeometrySubpass::get_bindless_texture_index(const sg::Material &material, const std::string &name) const
+{
+	auto texture_it = material.textures.find(name);
+
+	if (texture_it == material.textures.end())
+	{
+		return 0;
+	}
+
+	auto index_it = bindless_texture_indices.find(texture_it->second);
+
+	return index_it != bindless_texture_indices.end() ? index_it->second : 0;
+}
+
+void GeometrySubpass::get_sorted_nodes(DrawList &sorted_draws)
+{
+	sorted_draws.clear();
+
+	culled_draw_count   = 0;
+	occluded_draw_count = 0;
+
+	occlusion_candidates.clear();
+
+	joint_buffers.clear();
+
+	auto camera_position = glm::vec3(camera.get_node()->get_transform().get_world_matrix()[3]);
+
+	sg::Frustum frustum{vulkan_style_projection(camera.get_projection()) * camera.get_view()};
+
+	// The projection scales heights by 1 / tan(fov / 2), over the half height of the screen
+	texture_projection_scale = 0.5f * camera.get_projection()[1][1] * static_cast<float>(render_context.get_surface_extent().height);
+
+	bool use_bvh = culling_enabled && scene.has_component<sg::BVH>();
+
+	if (use_bvh)
+	{
+		// Let the hierarchy skip whole branches of the scene outside the frustum
+		auto &bvh = *scene.get_components<sg::BVH>().front();
+		bvh.update();
+
+		visible_items.clear();
+		bvh.query(frustum, visible_items);
+	}
+	else
+	{
+		culling_items.clear();
+
+		for (auto &mesh : meshes)
+		{
+			for (size_t node_index = 0; node_index < mesh->get_nodes().size(); ++node_index)
+			{
+				culling_items.push_back({mesh, node_index});
+			}
+		}
+	}
+
+	// Resolves the world matrices and bounds on this thread, so that the culling tasks only read them
+	for (auto &mesh : meshes)
+	{
+		mesh->update_world_bounds();
+	}
+
+	auto &items = use_bvh ? visible_items : culling_items;
+
+	auto &job_system = render_context.get_device().get_job_system();
+
+	size_t chunk_count = std::max<size_t>(1, std::min<size_t>((items.size() + CULLING_CHUNK_SIZE - 1) / CULLING_CHUNK_SIZE, job_system.get_thread_count() + 1));
+
+	if (culling_chunks.size() < chunk_count)
+	{
+		culling_chunks.resize(chunk_count);
+	}
+
+	auto cull_chunk = [&](size_t chunk_index, size_t) {
+		VKB_PROFILE_SCOPE("GeometrySubpass::cull_chunk");
+
+		auto &chunk = culling_chunks[chunk_index];
+
+		chunk.draws.clear();
+		chunk.draws.set_sort_policy(sorted_draws.get_sort_policy());
+		chunk.occlusion_candidates.clear();
+		chunk.skinned_nodes.clear();
+		chunk.texture_requests.clear();
+		chunk.culled_draw_count   = 0;
+		chunk.occluded_draw_count = 0;
+
+		size_t item_end = items.size() * (chunk_index + 1) / chunk_count;
+
+		for (size_t i = items.size() * chunk_index / chunk_count; i < item_end; ++i)
+		{
+			auto &mesh = *items[i].mesh;
+
+			// The hierarchy only returns the nodes in the frustum
+			if (culling_enabled && !use_bvh && !frustum.intersects(mesh.get_world_bounds(items[i].node_index)))
+			{
+				chunk.culled_draw_count += to_u32(mesh.get_submeshes().size());
+				continue;
+			}
+
+			add_draws(chunk, mesh, items[i].node_index, camera_position);
+		}
+	};
+
+	if (chunk_count > 1)
+	{
+		job_system.run_parallel(JobPriority::Frame, chunk_count, chunk_count, cull_chunk);
+	}
+	else
+	{
+		cull_chunk(0, 0);
+	}
+
+	// Merged in the order of the nodes, as if the nodes had been culled on a single thread
+	for (size_t chunk_index = 0; chunk_index < chunk_count; ++chunk_index)
+	{
+		auto &chunk = culling_chunks[chunk_index];
+
+		sorted_draws.append(chunk.draws);
+
+		occlusion_candidates.insert(occlusion_candidates.end(), chunk.occlusion_candidates.begin(), chunk.occlusion_candidates.end());
+
+		for (auto node : chunk.skinned_nodes)
+		{
+			allocate_joint_buffer(*node);
+		}
+
+		for (auto &request : chunk.texture_requests)
+		{
+			request_texture_levels(*request.first, request.second);
+		}
+
+		culled_draw_count += chunk.culled_draw_count;
+		occluded_draw_count += chunk.occluded_draw_count;
+	}
+
+	if (use_bvh)
+	{
+		uint32_t draw_count = 0;
+		for (auto &mesh : meshes)
+		{
+			draw_count += to_u32(mesh->get_nodes().size() * mesh->get_submeshes().size());
+		}
+
+		culled_draw_count = draw_count - to_u32(sorted_draws.size()) - occluded_draw_count;
+	}
+
+	sorted_draws.sort(job_system);
+
+	if (stats)
+	{
+		stats->set_value(StatIndex::culled_draws, static_cast<float>(culled_draw_count));
+		stats->set_value(StatIndex::occluded_draws, static_cast<float>(occluded_draw_count));
+	}
+}
+
+void GeometrySubpass::request_texture_levels(const sg::Material &material, float projected_size)
+{
+	for (auto &it : material.textures)
+	{
+		auto image = it.second->get_image();
+
+		if (!image)
+		{
+			continue;
+		}
+
+		// One texel per pixel along the largest side of the texture
+		auto &extent = image->get_extent();
+		float texels = static_cast<float>(std::max(extent.width, extent.height));
+
+		texture_streamer->request(*image, std::log2(std::max(1.0f, texels / projected_size)));
+	}
+}
+
+void GeometrySubpass::add_draws(CullingChunk &chunk, sg::Mesh &mesh, size_t node_index, const glm::vec3 &camera_position)
+{
+	auto &node = *mesh.get_nodes()[node_index];
+
+	const sg::AABB &bounds = mesh.get_world_bounds(node_index);
+
+	if (active_occlusion_queries)
+	{
+		uint32_t query = occlusion_query_offsets.at(&mesh) + to_u32(node_index);
+
+		chunk.occlusion_candidates.push_back({&mesh, node_index, query});
+
+		// The box of a node around the camera is clipped by the near plane, so its result cannot be trusted
+		glm::vec3 margin        = (bounds.get_max() - bounds.get_min()) * OCCLUSION_CAMERA_MARGIN;
+		bool      camera_inside = glm::all(glm::greaterThanEqual(camera_position, bounds.get_min() - margin)) &&
+		                     glm::all(glm::lessThanEqual(camera_position, bounds.get_max() + margin));
+
+		if (occluded_nodes[query] && !camera_inside)
+		{
+			chunk.occluded_draw_count += to_u32(mesh.get_submeshes().size());
+			return;
+		}
+	}
+
+	if (node.has_component<sg::Skin>())
+	{
+		chunk.skinned_nodes.push_back(&node);
+	}
+
+	float distance = glm::length(camera_position - bounds.get_center());
+
+	// Size in pixels of the node on screen, to select the mip levels its textures need
+	float projected_size = 0.0f;
+	if (texture_streamer && !bindless_textures_enabled)
+	{
+		projected_size = glm::length(bounds.get_max() - bounds.get_min()) * texture_projection_scale / std::max(distance, MIN_TEXTURE_DISTANCE);
+	}
+
+	// The error of the levels of detail is in the units of the submesh, scaled by the largest axis of the node
+	auto &world_matrix    = node.get_transform().get_world_matrix();
+	float world_scale     = std::max({glm::length(glm::vec3(world_matrix[0])), glm::length(glm::vec3(world_matrix[1])), glm::length(glm::vec3(world_matrix[2]))});
+	float pixels_per_unit = world_scale * texture_projection_scale / std::max(distance, MIN_TEXTURE_DISTANCE);
+
+	auto &sub_meshes = mesh.get_submeshes();
+
+	for (size_t sub_mesh_index = 0; sub_mesh_index < sub_meshes.size(); sub_mesh_index++)
+	{
+		auto &sub_mesh = *sub_meshes[sub_mesh_index];
+
+		// Drawn by the GPU driven path instead
+		if (is_indirect_draw(node, sub_mesh))
+		{
+			continue;
+		}
+
+		if (projected_size > 0.0f)
+		{
+			chunk.texture_requests.emplace_back(sub_mesh.get_material(), projected_size);
+		}
+
+		bool transparent = sub_mesh.get_material()->alpha_mode == sg::AlphaMode::Blend;
+
+		uint32_t lod = select_lod(node, sub_mesh_index, sub_mesh, pixels_per_unit);
+
+		chunk.draws.add(node, sub_mesh, distance, sort_state_ids.at(&sub_mesh), transparent, lod);
+	}
+}
+
+uint32_t GeometrySubpass::select_lod(sg::Node &node, size_t sub_mesh_index, const sg::SubMesh &sub_mesh, float pixels_per_unit)
+{
+	if (sub_mesh.lods.empty())
+	{
+		return 0;
+	}
+
+	std::lock_guard<std::mutex> guard{lod_mutex};
+
+	auto &levels = lod_levels[&node];
+	if (levels.size() <= sub_mesh_index)
+	{
+		levels.resize(sub_mesh_index + 1, 0);
+	}
+
+	uint32_t lod = levels[sub_mesh_index];
+
+	// Coarser levels are taken once their error is clearly below the threshold, and finer ones once it is clearly above
+	while (lod + 1 < sub_mesh.get_lod_count() && sub_mesh.get_lod_error(lod + 1) * pixels_per_unit < LOD_PIXEL_ERROR * (1.0f - LOD_HYSTERESIS))
+	{
+		lod++;
+	}
+
+	while (lod > 0 && sub_mesh.get_lod_error(lod) * pixels_per_unit > LOD_PIXEL_ERROR * (1.0f + LOD_HYSTERESIS))
+	{
+		lod--;
+	}
+
+	levels[sub_mesh_index] = lod;
+
+	return lod;
+}
+
+void GeometrySubpass::allocate_joint_buffer(sg::Node &node)
+{
+	auto &skin = node.get_component<sg::Skin>();
+
+	size_t joint_count = skin.get_joints().size();
+
+	// Recording threads only look the buffers up, they are all written before recording
+	auto joint_buffer = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, joint_count * sizeof(glm::mat4), get_recording_thread_index());
+
+	skin.compute_joint_matrices(node.get_transform().get_world_matrix(), joint_buffer.map<glm::mat4>(joint_count));
+
+	joint_buffers[&node] = joint_buffer;
+}
+
+void GeometrySubpass::draw(CommandBuffer &command_buffer)
+{
+	// Pipeline layouts do not survive clears of the resource cache
+	if (!materials_compiled || materials_generation != render_context.get_device().get_resource_cache().get_generation())
+	{
+		compile_materials();
+	}
+
+	update_view();
+
+	Timer timer;
+	timer.start();
+
+	get_sorted_nodes(draw_list);
+
+	if (instancing_enabled)
+	{
+		build_instance_groups();
+	}
+
+	culling_time = timer.elapsed<Timer::Milliseconds>();
+	timer.lap();
+
+	if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+	{
+		draw_secondary(command_buffer);
+	}
+	else
+	{
+		auto thread_index = get_recording_thread_index();
+
+		bind_common_resources(command_buffer);
+
+		if (depth_prepass_enabled)
+		{
+			// Lay down the depth of the opaque objects before shading them
+			record_depth_prepass(command_buffer, 0, get_opaque_batch_count(), thread_index);
+		}
+
+		record_indirect_draws(command_buffer, thread_index);
+
+		// Draw opaque objects in front-to-back order
+		record_opaque_batches(command_buffer, 0, get_opaque_batch_count(), thread_index);
+
+		record_occlusion_queries(command_buffer);
+
+		// Draw transparent objects in back-to-front order
+		record_transparent_draws(command_buffer, thread_index);
+	}
+
+	// Culling is measured separately, only the time since the lap is attributed to recording
+	recording_time = timer.elapsed<Timer::Milliseconds>();
+	timer.stop();
+
+	if (contents != VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+	{
+		thread_recording_times.assign(1, recording_time);
+	}
+
+	active_occlusion_queries = nullptr;
+}
+
+void GeometrySubpass::set_thread_count(uint32_t count)
+{
+	assert(count > 0 && "At least one recording thread is required");
+
+	thread_count = count;
+
+	// A single thread records inline in the primary command buffer
+	if (thread_count > 1)
+	{
+		contents = VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS;
+	}
+	else
+	{
+		contents = VK_SUBPASS_CONTENTS_INLINE;
+	}
+}
+
+uint32_t GeometrySubpass::get_thread_count() const
+{
+	return thread_count;
+}
+
+void GeometrySubpass::set_culling_enabled(bool enabled)
+{
+	culling_enabled = enabled;
+}
+
+bool GeometrySubpass::is_culling_enabled() const
+{
+	return culling_enabled;
+}
+
+double GeometrySubpass::get_culling_time() const
+{
+	return culling_time;
+}
+
+double GeometrySubpass::get_recording_time() const
+{
+	return recording_time;
+}
+
+const std::vector<double> &GeometrySubpass::get_thread_recording_times() const
+{
+	return thread_recording_times;
+}
+
+uint32_t GeometrySubpass::get_culled_draw_count() const
+{
+	return culled_draw_count;
+}
+
+void GeometrySubpass::set_stats(Stats *new_stats)
+{
+	stats = new_stats;
+}
+
+void GeometrySubpass::set_instancing_enabled(bool enabled)
+{
+	instancing_enabled = enabled;
+}
+
+bool GeometrySubpass::is_instancing_enabled() const
+{
+	return instancing_enabled;
+}
+
+void GeometrySubpass::set_gpu_driven(bool enabled)
+{
+	gpu_driven = enabled;
+}
+
+bool GeometrySubpass::is_gpu_driven() const
+{
+	return gpu_driven;
+}
+
+void GeometrySubpass::set_bindless_textures_enabled(bool enabled)
+{
+	bindless_textures_enabled = enabled;
+}
+
+bool GeometrySubpass::is_bindless_textures_enabled() const
+{
+	return bindless_textures_enabled;
+}
+
+void GeometrySubpass::set_texture_arrays_enabled(bool enabled)
+{
+	texture_arrays_enabled = enabled;
+}
+
+bool GeometrySubpass::is_texture_arrays_enabled() const
+{
+	return texture_arrays_enabled;
+}
+
+void GeometrySubpass::set_specialized_materials_enabled(bool enabled)
+{
+	specialized_materials_enabled = enabled;
+}
+
+bool GeometrySubpass::is_specialized_materials_enabled() const
+{
+	return specialized_materials_enabled;
+}
+
+void GeometrySubpass::set_uber_shader_fallback_enabled(bool enabled)
+{
+	uber_shader_fallback_enabled = enabled;
+}
+
+bool GeometrySubpass::is_uber_shader_fallback_enabled() const
+{
+	return uber_shader_fallback_enabled;
+}
+
+void GeometrySubpass::set_view_uniform_enabled(bool enabled)
+{
+	view_uniform_enabled = enabled;
+}
+
+bool GeometrySubpass::is_view_uniform_enabled() const
+{
+	return view_uniform_enabled;
+}
+
+void GeometrySubpass::set_partitioned_descriptor_sets_enabled(bool enabled)
+{
+	partitioned_descriptor_sets_enabled = enabled;
+}
+
+bool GeometrySubpass::is_partitioned_descriptor_sets_enabled() const
+{
+	return partitioned_descriptor_sets_enabled;
+}
+
+uint32_t GeometrySubpass::get_descriptor_set(DescriptorSetFrequency frequency) const
+{
+	return partitioned_descriptor_sets_enabled ? static_cast<uint32_t>(frequency) : 0;
+}
+
+void GeometrySubpass::set_push_descriptors_enabled(bool enabled)
+{
+	push_descriptors_enabled = enabled;
+}
+
+bool GeometrySubpass::is_push_descriptors_enabled() const
+{
+	return push_descriptors_enabled;
+}
+
+void GeometrySubpass::set_depth_prepass_enabled(bool enabled)
+{
+	depth_prepass_enabled = enabled;
+}
+
+bool GeometrySubpass::is_depth_prepass_enabled() const
+{
+	return depth_prepass_enabled;
+}
+
+void GeometrySubpass::set_opaque_sort_policy(DrawSortPolicy policy)
+{
+	draw_list.set_sort_policy(policy);
+}
+
+DrawSortPolicy GeometrySubpass::get_opaque_sort_policy() const
+{
+	return draw_list.get_sort_policy();
+}
+
+void GeometrySubpass::set_coarse_shading(uint32_t min_lod, const VkExtent2D &fragment_size)
+{
+	coarse_shading_lod  = min_lod;
+	coarse_shading_rate = fragment_size;
+
+	// The rates are recorded in the command buffers
+	invalidate_cached_command_buffers();
+}
+
+void GeometrySubpass::set_material_shading_rate(const sg::Material &material, const VkExtent2D &fragment_size)
+{
+	material_shading_rates[&material] = fragment_size;
+
+	invalidate_cached_command_buffers();
+}
+
+void GeometrySubpass::set_view_cameras(const std::vector<sg::Camera *> &cameras)
+{
+	assert(cameras.size() <= MAX_VIEW_COUNT && "Too many multiview cameras");
+
+	view_cameras = cameras;
+
+	// One view per camera, in the order of the layers
+	set_view_mask((1U << to_u32(view_cameras.size())) - 1U);
+}
+
+VkExtent2D GeometrySubpass::get_draw_shading_rate(const sg::SubMesh &sub_mesh, uint32_t lod) const
+{
+	VkExtent2D rate = get_shading_rate();
+
+	auto coarsen = [&rate](const VkExtent2D &other) {
+		rate.width  = std::max(rate.width, other.width);
+		rate.height = std::max(rate.height, other.height);
+	};
+
+	if (lod >= coarse_shading_lod)
+	{
+		coarsen(coarse_shading_rate);
+	}
+
+	auto it = material_shading_rates.find(sub_mesh.get_material());
+	if (it != material_shading_rates.end())
+	{
+		coarsen(it->second);
+	}
+
+	return rate;
+}
+
+void GeometrySubpass::set_occlusion_culling_enabled(bool enabled)
+{
+	occlusion_culling_enabled = enabled;
+
+	if (!occlusion_culling_enabled)
+	{
+		// Queries recorded before are ignored, so they do not hide nodes once enabled again
+		std::fill(occluded_nodes.begin(), occluded_nodes.end(), false);
+
+		for (auto &frame_queries : occlusion_queries)
+		{
+			frame_queries.queries.clear();
+		}
+	}
+}
+
+bool GeometrySubpass::is_occlusion_culling_enabled() const
+{
+	return occlusion_culling_enabled;
+}
+
+uint32_t GeometrySubpass::get_occluded_draw_count() const
+{
+	return occluded_draw_count;
+}
+
+void GeometrySubpass::set_texture_streamer(TextureStreamer *new_texture_streamer)
+{
+	texture_streamer = new_texture_streamer;
+}
+
+void GeometrySubpass::set_command_buffer_caching(bool enabled)
+{
+	command_buffer_caching = enabled;
+
+	if (!enabled)
+	{
+		invalidate_cached_command_buffers();
+	}
+}
+
+bool GeometrySubpass::is_command_buffer_caching() const
+{
+	return command_buffer_caching;
+}
+
+void GeometrySubpass::invalidate_cached_command_buffers()
+{
+	// The command buffers are kept, to be recorded again instead of allocating new ones
+	for (auto &frame_caches : cached_command_buffers)
+	{
+		for (auto &cache : frame_caches)
+		{
+			cache.recorded  = nullptr;
+			cache.signature = 0;
+		}
+	}
+}
+
+uint32_t GeometrySubpass::get_replayed_command_buffer_count() const
+{
+	return replayed_command_buffer_count;
+}
+
+void GeometrySubpass::get_node_costs(std::unordered_map<const sg::Node *, NodeCost> &node_costs) const
+{
+	auto triangle_count = [](const sg::SubMesh &sub_mesh, uint32_t lod) {
+		return sub_mesh.vertex_indices != 0 ? sub_mesh.get_vertex_indices(lod) / 3 : sub_mesh.vertices_count / 3;
+	};
+
+	size_t draw_count = draw_list.size() + indirect_draws.size();
+
+	for (size_t i = 0; i < draw_list.size(); i++)
+	{
+		auto &draw = draw_list.get(i);
+		auto &cost = node_costs[draw.node];
+
+		cost.draw_count++;
+		cost.triangle_count += triangle_count(*draw.sub_mesh, draw.lod);
+		cost.recording_time += recording_time / draw_count;
+	}
+
+	for (auto &indirect_draw : indirect_draws)
+	{
+		auto &cost = node_costs[indirect_draw.node];
+
+		// Triangles the culling shader may still discard are counted, as the draw is issued
+		cost.draw_count++;
+		cost.triangle_count += triangle_count(*indirect_draw.sub_mesh, 0);
+		cost.recording_time += recording_time / draw_count;
+	}
+
+	size_t node_count = 0;
+	for (auto mesh : meshes)
+	{
+		node_count += mesh->get_nodes().size();
+	}
+
+	for (auto mesh : meshes)
+	{
+		for (auto node : mesh->get_nodes())
+		{
+			node_costs[node].culling_time += culling_time / node_count;
+		}
+	}
+}
+
+void GeometrySubpass::prepare_occlusion_queries(CommandBuffer &command_buffer)
+{
+	active_occlusion_queries = nullptr;
+
+	if (!occlusion_culling_enabled || occlusion_query_count == 0)
+	{
+		return;
+	}
+
+	auto frame_index = render_context.get_active_frame_index();
+	if (frame_index >= occlusion_queries.size())
+	{
+		occlusion_queries.resize(frame_index + 1);
+	}
+
+	auto &frame_queries = occlusion_queries[frame_index];
+
+	if (!frame_queries.query_pool)
+	{
+		VkQueryPoolCreateInfo query_pool_info{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+		query_pool_info.queryType  = VK_QUERY_TYPE_OCCLUSION;
+		query_pool_info.queryCount = occlusion_query_count;
+
+		frame_queries.query_pool = std::make_unique<core::QueryPool>(render_context.get_device(), query_pool_info);
+	}
+	else if (!frame_queries.queries.empty())
+	{
+		// The fence of the frame was waited for, so the queries it recorded are available
+		std::vector<uint32_t> results(occlusion_query_count * 2);
+
+		frame_queries.query_pool->get_results(0, occlusion_query_count,
+		                                      results.size() * sizeof(uint32_t), results.data(), 2 * sizeof(uint32_t),
+		                                      VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+		for (auto query : frame_queries.queries)
+		{
+			// Nodes whose result is not available stay as they were
+			if (results[2 * query + 1] != 0)
+			{
+				occluded_nodes[query] = results[2 * query] == 0;
+			}
+		}
+	}
+
+	frame_queries.queries.clear();
+
+	command_buffer.reset_query_pool(*frame_queries.query_pool, 0, occlusion_query_count);
+
+	active_occlusion_queries = &frame_queries;
+}
+
+void GeometrySubpass::record_occlusion_queries(CommandBuffer &command_buffer)
+{
+	if (!active_occlusion_queries || occlusion_candidates.empty())
+	{
+		return;
+	}
+
+	if (!occlusion_shader)
+	{
+		occlusion_shader = std::make_unique<ShaderSource>("occlusion_box.vert");
+	}
+
+	auto &resource_cache   = render_context.get_device().get_resource_cache();
+	auto &occlusion_module = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, *occlusion_shader);
+	auto &pipeline_layout  = resource_cache.request_pipeline_layout({&occlusion_module}, false);
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	// The box corners are generated by the vertex shader
+	command_buffer.set_vertex_input_state({});
+
+	// The boxes are tested from both sides and write neither color nor depth
+	RasterizationState rasterization_state{};
+	rasterization_state.cull_mode = VK_CULL_MODE_NONE;
+	command_buffer.set_rasterization_state(rasterization_state);
+
+	command_buffer.set_color_blend_state(get_depth_only_blend_state(get_output_attachments().size()));
+
+	DepthStencilState depth_stencil_state  = get_depth_stencil_state();
+	depth_stencil_state.depth_write_enable = VK_FALSE;
+	command_buffer.set_depth_stencil_state(depth_stencil_state);
+
+	OcclusionBox box{};
+	box.view_proj = vulkan_style_projection(camera.get_projection()) * camera.get_view();
+
+	auto &query_pool = *active_occlusion_queries->query_pool;
+
+	for (auto &candidate : occlusion_candidates)
+	{
+		const sg::AABB &bounds = candidate.mesh->get_world_bounds(candidate.node_index);
+
+		box.bounds_min = glm::vec4(bounds.get_min(), 1.0f);
+		box.bounds_max = glm::vec4(bounds.get_max(), 1.0f);
+
+		command_buffer.push_constants(0, box);
+
+		command_buffer.begin_query(query_pool, candidate.query, 0);
+
+		command_buffer.draw(36, 1, 0, 0);
+
+		command_buffer.end_query(query_pool, candidate.query);
+
+		active_occlusion_queries->queries.push_back(candidate.query);
+	}
+
+	// Restore the state of the draws which follow
+	command_buffer.set_rasterization_state({});
+
+	ColorBlendState color_blend_state{};
+	color_blend_state.attachments.resize(get_output_attachments().size());
+	command_buffer.set_color_blend_state(color_blend_state);
+
+	command_buffer.set_depth_stencil_state(get_depth_stencil_state());
+}
+
+bool GeometrySubpass::is_depth_prepass_draw(const sg::SubMesh &sub_mesh) const
+{
+	// Submeshes without a depth only variant are shaded with the usual depth test instead
+	return depth_prepass_enabled && sub_mesh.get_material()->alpha_mode == sg::AlphaMode::Opaque && get_depth_only_variant(sub_mesh) != nullptr;
+}
+
+const ShaderVariant *GeometrySubpass::get_depth_only_variant(const sg::SubMesh &sub_mesh) const
+{
+	auto &prepass_variants = instancing_enabled ? depth_only_instanced_variants : depth_only_variants;
+
+	auto variant_it = prepass_variants.find(&sub_mesh);
+
+	return variant_it != prepass_variants.end() ? &variant_it->second : nullptr;
+}
+
+DepthStencilState GeometrySubpass::get_opaque_depth_stencil_state(const sg::SubMesh &sub_mesh)
+{
+	DepthStencilState depth_stencil_state = get_depth_stencil_state();
+
+	// Only the fragments which won the depth pre-pass are shaded
+	if (is_depth_prepass_draw(sub_mesh))
+	{
+		depth_stencil_state.depth_compare_op   = VK_COMPARE_OP_EQUAL;
+		depth_stencil_state.depth_write_enable = VK_FALSE;
+	}
+
+	return depth_stencil_state;
+}
+
+void GeometrySubpass::record_depth_prepass(CommandBuffer &command_buffer, size_t batch_start, size_t batch_end, size_t thread_index)
+{
+	command_buffer.set_color_blend_state(get_depth_only_blend_state(get_output_attachments().size()));
+
+	command_buffer.set_depth_stencil_state(get_depth_stencil_state());
+
+	for (size_t i = batch_start; i < batch_end; i++)
+	{
+		if (instancing_enabled)
+		{
+			auto &group = instance_groups[i];
+
+			if (!is_depth_prepass_draw(*group.sub_mesh))
+			{
+				continue;
+			}
+
+			update_uniform(command_buffer, *instance_nodes[group.first], thread_index);
+
+			auto instance_buffer = allocate_instance_buffer(group, thread_index);
+
+			bind_depth_only_submesh(command_buffer, *group.sub_mesh, group.front_face, *get_depth_only_variant(*group.sub_mesh), &instance_buffer);
+
+			draw_submesh_command(command_buffer, *group.sub_mesh, to_u32(group.count), group.lod);
+		}
+		else
+		{
+			auto &draw     = draw_list.get(i);
+			auto &node     = *draw.node;
+			auto &sub_mesh = *draw.sub_mesh;
+
+			if (!is_depth_prepass_draw(sub_mesh))
+			{
+				continue;
+			}
+
+			uint32_t first_instance = update_uniform(command_buffer, node, thread_index);
+
+			const auto &scale      = node.get_transform().get_scale();
+			bool        flipped    = scale.x * scale.y * scale.z < 0;
+			VkFrontFace front_face = flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+			bind_depth_only_submesh(command_buffer, sub_mesh, front_face, *get_depth_only_variant(sub_mesh), nullptr);
+
+			draw_submesh_command(command_buffer, sub_mesh, 1, draw.lod, first_instance);
+		}
+	}
+
+	// Restore color writes for the shading draws
+	ColorBlendState shading_color_blend_state{};
+	shading_color_blend_state.attachments.resize(get_output_attachments().size());
+	command_buffer.set_color_blend_state(shading_color_blend_state);
+}
+
+bool GeometrySubpass::is_indirect_draw(sg::Node &node, const sg::SubMesh &sub_mesh) const
+{
+	// Skinned meshes need the joint matrices of their node
+	return gpu_driven && !node.has_component<sg::Skin>() && sub_mesh.vertex_indices != 0 && sub_mesh.get_material()->alpha_mode != sg::AlphaMode::Blend;
+}
+
+void GeometrySubpass::record_indirect_draws(CommandBuffer &command_buffer, size_t thread_index)
+{
+	if (indirect_draws.empty())
+	{
+		return;
+	}
+
+	// Only the view projection of the uniform is used, model matrices come from the transform buffer
+	update_global_uniform(command_buffer, glm::mat4{1.0f}, thread_index);
+
+	const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+	// Without multi draw indirect, the commands of the meshlets of a draw are recorded one by one
+	bool multi_draw_indirect = command_buffer.get_device().get_features().multiDrawIndirect;
+
+	for (auto &draw : indirect_draws)
+	{
+		const auto &scale      = draw.node->get_transform().get_scale();
+		bool        flipped    = scale.x * scale.y * scale.z < 0;
+		VkFrontFace front_face = flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+		bind_submesh(command_buffer, *draw.sub_mesh, front_face, instanced_variants.at(draw.sub_mesh), &transform_buffer, draw.transform_index * sizeof(glm::mat4));
+
+		command_buffer.bind_index_buffer(draw.sub_mesh->index_buffer.get_buffer(), 0, draw.sub_mesh->index_type);
+
+		if (multi_draw_indirect || draw.command_count == 1)
+		{
+			command_buffer.draw_indexed_indirect(*indirect_buffer, draw.first_command * stride, draw.command_count, stride);
+		}
+		else
+		{
+			for (uint32_t j = 0; j < draw.command_count; j++)
+			{
+				command_buffer.draw_indexed_indirect(*indirect_buffer, (draw.first_command + j) * stride, 1, stride);
+			}
+		}
+	}
+}
+
+void GeometrySubpass::bind_common_resources(CommandBuffer &command_buffer)
+{
+	// The texture array is the same for every draw, so draws only change push constants
+	for (size_t i = 0; i < bindless_textures.size(); i++)
+	{
+		command_buffer.bind_image(bindless_textures[i]->get_image()->get_vk_image_view(),
+		                          bindless_textures[i]->get_sampler()->vk_sampler,
+		                          get_descriptor_set(DescriptorSetFrequency::Frame), BINDLESS_TEXTURE_BINDING, to_u32(i));
+	}
+}
+
+void GeometrySubpass::record_opaque_draws(CommandBuffer &command_buffer, size_t draw_start, size_t draw_end, size_t thread_index)
+{
+	for (size_t i = draw_start; i < draw_end; i++)
+	{
+		auto &draw     = draw_list.get(i);
+		auto &node     = *draw.node;
+		auto &sub_mesh = *draw.sub_mesh;
+
+		uint32_t first_instance = update_uniform(command_buffer, node, thread_index);
+
+		// Invert the front face if the mesh was flipped
+		const auto &scale      = node.get_transform().get_scale();
+		bool        flipped    = scale.x * scale.y * scale.z < 0;
+		VkFrontFace front_face = flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+		if (depth_prepass_enabled)
+		{
+			command_buffer.set_depth_stencil_state(get_opaque_depth_stencil_state(sub_mesh));
+		}
+
+		draw_submesh(command_buffer, sub_mesh, front_face, draw.lod, first_instance);
+	}
+}
+
+void GeometrySubpass::build_instance_groups()
+{
+	instance_groups.clear();
+	instance_group_lookup.clear();
+
+	const size_t no_group = std::numeric_limits<size_t>::max();
+
+	size_t opaque_count = draw_list.get_opaque_count();
+
+	// Group of each draw
+	ArenaVector<size_t> draw_groups(opaque_count, 0, &render_context.get_active_frame().get_arena());
+
+	// Count the instances of each group, the first draw of a group decides its position
+	for (size_t i = 0; i < opaque_count; i++)
+	{
+		auto &draw = draw_list.get(i);
+
+		const auto &scale      = draw.node->get_transform().get_scale();
+		bool        flipped    = scale.x * scale.y * scale.z < 0;
+		VkFrontFace front_face = flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+		// Skinned nodes bind their own joint matrices, so they are not instanced
+		if (joint_buffers.count(draw.node) > 0)
+		{
+			draw_groups[i] = instance_groups.size();
+			instance_groups.push_back({draw.sub_mesh, front_face, draw.lod, 0, 1});
+			continue;
+		}
+
+		// Instances of a group share a level of detail
+		auto it = instance_group_lookup.find(draw.sub_mesh);
+		if (it == instance_group_lookup.end())
+		{
+			it = instance_group_lookup.emplace(draw.sub_mesh, std::vector<size_t>(draw.sub_mesh->get_lod_count() * 2, no_group)).first;
+		}
+
+		size_t &group_index = it->second[draw.lod * 2 + (flipped ? 1 : 0)];
+		if (group_index == no_group)
+		{
+			group_index = instance_groups.size();
+
+			instance_groups.push_back({draw.sub_mesh, front_face, draw.lod, 0, 0});
+		}
+
+		draw_groups[i] = group_index;
+
+		instance_groups[group_index].count++;
+	}
+
+	size_t first = 0;
+	for (auto &group : instance_groups)
+	{
+		group.first = first;
+		first += group.count;
+		group.count = 0;
+	}
+
+	// Store the nodes of each group contiguously, in front-to-back order
+	instance_nodes.resize(opaque_count);
+
+	for (size_t i = 0; i < opaque_count; i++)
+	{
+		auto &group = instance_groups[draw_groups[i]];
+
+		instance_nodes[group.first + group.count++] = draw_list.get(i).node;
+	}
+}
+
+BufferAllocation GeometrySubpass::allocate_instance_buffer(const InstanceGroup &group, size_t thread_index)
+{
+	auto instance_buffer = allocate_draw_buffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, group.count * sizeof(glm::mat4), thread_index);
+
+	// Write the matrices straight into the mapped frame buffer
+	auto models = instance_buffer.map<glm::mat4>(group.count);
+	for (size_t j = 0; j < group.count; j++)
+	{
+		models[j] = instance_nodes[group.first + j]->get_transform().get_world_matrix();
+	}
+
+	auto cache = thread_index < recording_caches.size() ? recording_caches[thread_index] : nullptr;
+
+	if (cache)
+	{
+		// The cache keeps its own handle on the buffer, the draw only reads its location
+		CachedAllocation cached{BufferAllocation{instance_buffer.get_buffer(), instance_buffer.get_size(), instance_buffer.get_offset()}, {}, {}, false};
+
+		for (size_t j = 0; j < group.count; j++)
+		{
+			auto node = instance_nodes[group.first + j];
+
+			cached.nodes.push_back(node);
+			cached.revisions.push_back(node->get_transform().get_world_matrix_revision());
+		}
+
+		cache->allocations.push_back(std::move(cached));
+	}
+
+	return instance_buffer;
+}
+
+void GeometrySubpass::record_instanced_draws(CommandBuffer &command_buffer, size_t group_start, size_t group_end, size_t thread_index)
+{
+	for (size_t i = group_start; i < group_end; i++)
+	{
+		auto &group = instance_groups[i];
+
+		// The model matrix of the uniform is not used by instanced draws
+		update_uniform(command_buffer, *instance_nodes[group.first], thread_index);
+
+		auto instance_buffer = allocate_instance_buffer(group, thread_index);
+
+		if (depth_prepass_enabled)
+		{
+			command_buffer.set_depth_stencil_state(get_opaque_depth_stencil_state(*group.sub_mesh));
+		}
+
+		draw_submesh_instanced(command_buffer, *group.sub_mesh, group.front_face, instance_buffer, to_u32(group.count), group.lod);
+	}
+}
+
+size_t GeometrySubpass::get_opaque_batch_count() const
+{
+	return instancing_enabled ? instance_groups.size() : draw_list.get_opaque_count();
+}
+
+void GeometrySubpass::record_opaque_batches(CommandBuffer &command_buffer, size_t batch_start, size_t batch_end, size_t thread_index)
+{
+	if (instancing_enabled)
+	{
+		record_instanced_draws(command_buffer, batch_start, batch_end, thread_index);
+	}
+	else
+	{
+		record_opaque_draws(command_buffer, batch_start, batch_end, thread_index);
+	}
+}
+
+void GeometrySubpass::record_transparent_draws(CommandBuffer &command_buffer, size_t thread_index)
+{
+	// Enable alpha blending
+	ColorBlendAttachmentState color_blend_attachment{};
+	color_blend_attachment.blend_enable           = VK_TRUE;
+	color_blend_attachment.src_color_blend_factor = VK_BLEND_FACTOR_SRC_ALPHA;
+	color_blend_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+	ColorBlendState color_blend_state{};
+	color_blend_state.attachments.resize(get_output_attachments().size());
+	color_blend_state.attachments[0] = color_blend_attachment;
+	command_buffer.set_color_blend_state(color_blend_state);
+
+	command_buffer.set_depth_stencil_state(get_depth_stencil_state());
+
+	for (size_t i = draw_list.get_opaque_count(); i < draw_list.size(); i++)
+	{
+		auto &draw = draw_list.get(i);
+
+		uint32_t first_instance = update_uniform(command_buffer, *draw.node, thread_index);
+
+		draw_submesh(command_buffer, *draw.sub_mesh, VK_FRONT_FACE_COUNTER_CLOCKWISE, draw.lod, first_instance);
+	}
+}
+
+CommandBuffer &GeometrySubpass::begin_secondary_command_buffer(CommandBuffer &primary_command_buffer, size_t thread_index)
+{
+	const auto &queue = render_context.get_device().get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+
+	auto &render_frame = render_context.get_active_frame();
+
+	// Secondary command buffers come from the same kind of pool as the primary one requested by RenderContext::begin
+	auto &secondary_command_buffer = render_frame.request_command_buffer(queue, CommandBuffer::ResetMode::ResetPool, VK_COMMAND_BUFFER_LEVEL_SECONDARY, thread_index);
+
+	begin_secondary(secondary_command_buffer, primary_command_buffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
+
+	return secondary_command_buffer;
+}
+
+void GeometrySubpass::begin_secondary(CommandBuffer &secondary_command_buffer, CommandBuffer &primary_command_buffer, VkCommandBufferUsageFlags flags)
+{
+	secondary_command_buffer.begin(flags, &primary_command_buffer);
+
+	// Dynamic state is not inherited from the primary command buffer
+	auto &extent = render_context.get_active_frame().get_render_target().get_extent();
+
+	VkViewport viewport{};
+	viewport.width    = static_cast<float>(extent.width);
+	viewport.height   = static_cast<float>(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	secondary_command_buffer.set_viewport(0, 1, &viewport);
+
+	VkRect2D scissor{};
+	scissor.extent = extent;
+	secondary_command_buffer.set_scissor(0, 1, &scissor);
+
+	bind_common_resources(secondary_command_buffer);
+}
+
+CommandBuffer &GeometrySubpass::begin_cached_command_buffer(CommandBuffer &primary_command_buffer, CachedCommandBuffer &cache, size_t thread_index)
+{
+	auto &render_frame = render_context.get_active_frame();
+
+	if (cache.command_buffers.size() < render_frame.get_thread_count())
+	{
+		cache.command_buffers.resize(render_frame.get_thread_count(), nullptr);
+	}
+
+	auto &command_buffer = cache.command_buffers[thread_index];
+
+	// Only this thread records from the pool of its command buffer, and the last execution of the frame is complete
+	if (!command_buffer)
+	{
+		const auto &queue = render_context.get_device().get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+
+		command_buffer = &render_frame.request_command_buffer(queue, CommandBuffer::ResetMode::Persistent, VK_COMMAND_BUFFER_LEVEL_SECONDARY, thread_index);
+	}
+	else
+	{
+		command_buffer->reset(CommandBuffer::ResetMode::Persistent);
+	}
+
+	if (!cache.uniform_pool)
+	{
+		cache.uniform_pool  = std::make_unique<BufferPool>(render_context.get_device(), CACHED_BUFFER_BLOCK_SIZE, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+		cache.instance_pool = std::make_unique<BufferPool>(render_context.get_device(), CACHED_BUFFER_BLOCK_SIZE, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+	}
+
+	cache.allocations.clear();
+	cache.view_allocation = {};
+	cache.uniform_pool->reset();
+	cache.uniform_block = nullptr;
+	cache.instance_pool->reset();
+	cache.instance_block = nullptr;
+	cache.recorded       = nullptr;
+
+	recording_caches[thread_index] = &cache;
+
+	// Without the one time submit flag, the command buffer can be executed again in later frames
+	begin_secondary(*command_buffer, primary_command_buffer, VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
+
+	return *command_buffer;
+}
+
+void GeometrySubpass::update_cached_allocations(CachedCommandBuffer &cache)
+{
+	bool camera_moved = frame_view_proj != cache.camera_view_proj || frame_camera_position != cache.camera_position || frame_view_projs != cache.view_projs;
+
+	if (camera_moved && !cache.view_allocation.empty())
+	{
+		write_view_uniform(cache.view_allocation);
+		cache.view_allocation.flush();
+	}
+
+	for (auto &cached : cache.allocations)
+	{
+		bool moved = false;
+
+		for (size_t i = 0; i < cached.nodes.size(); i++)
+		{
+			uint32_t revision = cached.nodes[i]->get_transform().get_world_matrix_revision();
+
+			if (revision != cached.revisions[i])
+			{
+				cached.revisions[i] = revision;
+				moved               = true;
+			}
+		}
+
+		if (cached.global_uniform)
+		{
+			// With view uniforms, the global uniforms do not depend on the camera
+			if (moved || (camera_moved && !view_uniform_enabled))
+			{
+				write_global_uniform(cached.allocation, cached.nodes[0]->get_transform().get_world_matrix());
+				cached.allocation.flush();
+			}
+		}
+		else if (moved)
+		{
+			auto models = cached.allocation.map<glm::mat4>(cached.nodes.size());
+			for (size_t i = 0; i < cached.nodes.size(); i++)
+			{
+				models[i] = cached.nodes[i]->get_transform().get_world_matrix();
+			}
+
+			cached.allocation.flush();
+		}
+	}
+
+	cache.camera_view_proj = frame_view_proj;
+	cache.camera_position  = frame_camera_position;
+	cache.view_projs       = frame_view_projs;
+}
+
+std::vector<glm::mat4> GeometrySubpass::get_view_projections() const
+{
+	std::vector<glm::mat4> view_projs;
+	view_projs.reserve(view_cameras.size());
+
+	for (auto view_camera : view_cameras)
+	{
+		view_projs.push_back(vkb::vulkan_style_projection(view_camera->get_projection()) * view_camera->get_view());
+	}
+
+	return view_projs;
+}
+
+void GeometrySubpass::update_view()
+{
+	frame_view_proj       = vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
+	frame_camera_position = glm::vec3(glm::inverse(camera.get_view())[3]);
+	frame_view_projs      = get_view_projections();
+
+	view_allocation = {};
+
+	if (view_uniform_enabled)
+	{
+		auto size = view_cameras.empty() ? sizeof(ViewUniform) : sizeof(MultiviewViewUniform);
+
+		view_allocation = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, size, get_recording_thread_index());
+		write_view_uniform(view_allocation);
+	}
+}
+
+void GeometrySubpass::write_global_uniform(BufferAllocation &allocation, const glm::mat4 &model) const
+{
+	if (view_uniform_enabled)
+	{
+		allocation.update(model);
+		return;
+	}
+
+	GlobalUniform global_uniform;
+	global_uniform.model            = model;
+	global_uniform.camera_view_proj = frame_view_proj;
+	global_uniform.camera_position  = frame_camera_position;
+
+	if (frame_view_projs.empty())
+	{
+		allocation.update(global_uniform);
+		return;
+	}
+
+	MultiviewGlobalUniform multiview_uniform;
+
+	static_cast<GlobalUniform &>(multiview_uniform) = global_uniform;
+
+	std::copy(frame_view_projs.begin(), frame_view_projs.end(), multiview_uniform.view_proj);
+
+	allocation.update(multiview_uniform);
+}
+
+void GeometrySubpass::write_view_uniform(BufferAllocation &allocation) const
+{
+	ViewUniform view_uniform;
+	view_uniform.camera_view_proj = frame_view_proj;
+	view_uniform.camera_position  = frame_camera_position;
+
+	if (frame_view_projs.empty())
+	{
+		allocation.update(view_uniform);
+		return;
+	}
+
+	MultiviewViewUniform multiview_uniform;
+
+	static_cast<ViewUniform &>(multiview_uniform) = view_uniform;
+
+	std::copy(frame_view_projs.begin(), frame_view_projs.end(), multiview_uniform.view_proj);
+
+	allocation.update(multiview_uniform);
+}
+
+VkDeviceSize GeometrySubpass::get_global_uniform_size() const
+{
+	if (view_uniform_enabled)
+	{
+		return sizeof(glm::mat4);
+	}
+
+	// The multiview variants read the matrices of the views following the global uniform
+	return view_cameras.empty() ? sizeof(GlobalUniform) : sizeof(MultiviewGlobalUniform);
+}
+
+void GeometrySubpass::bind_view_uniform(CommandBuffer &command_buffer, CachedCommandBuffer *cache, size_t thread_index)
+{
+	auto allocation = &view_allocation;
+
+	// Cached command buffers are executed again in later frames, after the allocations of the frame are reset
+	if (cache)
+	{
+		if (cache->view_allocation.empty())
+		{
+			cache->view_allocation = allocate_draw_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, view_allocation.get_size(), thread_index);
+			write_view_uniform(cache->view_allocation);
+		}
+
+		allocation = &cache->view_allocation;
+	}
+
+	command_buffer.bind_buffer(allocation->get_buffer(), allocation->get_offset(), allocation->get_size(), get_descriptor_set(DescriptorSetFrequency::Frame), VIEW_UNIFORM_BINDING, 0);
+}
+
+std::size_t GeometrySubpass::get_chunk_signature(CommandBuffer &primary_command_buffer, size_t batch_start, size_t batch_end, bool depth_only)
+{
+	// Texture levels may be streamed in or out, changing the image views bound by the draws
+	if (texture_streamer && !bindless_textures_enabled)
+	{
+		return 0;
+	}
+
+	auto &render_pass = primary_command_buffer.get_current_render_pass();
+
+	std::size_t signature{0};
+	hash_combine(signature, render_context.get_device().get_resource_cache().get_generation());
+	hash_combine(signature, render_context.get_active_frame().get_descriptor_generation());
+	hash_combine(signature, render_pass.render_pass->get_id());
+	hash_combine(signature, render_pass.framebuffer->get_id());
+	hash_combine(signature, primary_command_buffer.get_current_subpass_index());
+	hash_combine(signature, get_common_resources_signature());
+	hash_combine(signature, depth_only);
+
+	for (size_t i = batch_start; i < batch_end; i++)
+	{
+		if (instancing_enabled)
+		{
+			auto &group = instance_groups[i];
+
+			hash_combine(signature, group.sub_mesh);
+			hash_combine(signature, group.front_face);
+			hash_combine(signature, group.lod);
+
+			for (size_t j = group.first; j < group.first + group.count; j++)
+			{
+				// Joint matrices are written every frame
+				if (joint_buffers.count(instance_nodes[j]) > 0)
+				{
+					return 0;
+				}
+
+				hash_combine(signature, instance_nodes[j]);
+			}
+		}
+		else
+		{
+			auto &draw = draw_list.get(i);
+
+			if (joint_buffers.count(draw.node) > 0)
+			{
+				return 0;
+			}
+
+			const auto &scale = draw.node->get_transform().get_scale();
+
+			hash_combine(signature, draw.node);
+			hash_combine(signature, draw.sub_mesh);
+			hash_combine(signature, draw.lod);
+			hash_combine(signature, scale.x * scale.y * scale.z < 0);
+		}
+	}
+
+	// A valid signature is never 0, which tells that the chunk is not cached
+	return signature != 0 ? signature : 1;
+}
+
+std::size_t GeometrySubpass::get_common_resources_signature()
+{
+	// The bindless texture array does not change after prepare()
+	return 0;
+}
+
+void GeometrySubpass::draw_secondary(CommandBuffer &primary_command_buffer)
+{
+	assert(thread_count <= render_context.get_active_frame().get_thread_count() && "Recording thread count exceeds the thread count of the frame");
+
+	// World matrices were resolved while sorting the nodes on this thread,
+	// so the jobs only read the scene graph transforms
+	using RecordTask = std::function<CommandBuffer *(size_t thread_index)>;
+
+	std::vector<RecordTask> tasks;
+
+	// Split the opaque draws evenly, the first chunks take the draws left over
+	size_t opaque_count = get_opaque_batch_count();
+	size_t chunk_count  = std::min(static_cast<size_t>(thread_count), opaque_count);
+
+	replayed_command_buffer_count = 0;
+
+	std::vector<CachedCommandBuffer> *frame_caches = nullptr;
+
+	if (command_buffer_caching)
+	{
+		auto &render_frame = render_context.get_active_frame();
+
+		cached_command_buffers.resize(render_context.get_render_frames().size());
+
+		// Chunks of the depth pre-pass and the opaque draws have their own slot
+		frame_caches = &cached_command_buffers[render_context.get_active_frame_index()];
+		if (frame_caches->size() < thread_count * 2)
+		{
+			frame_caches->resize(thread_count * 2);
+		}
+
+		recording_caches.assign(render_frame.get_thread_count(), nullptr);
+	}
+
+	auto push_opaque_chunks = [&](bool depth_only) {
+		size_t draw_start = 0;
+
+		for (size_t chunk = 0; chunk < chunk_count; chunk++)
+		{
+			size_t draw_end = draw_start + opaque_count / chunk_count;
+			if (chunk < opaque_count % chunk_count)
+			{
+				draw_end++;
+			}
+
+			CachedCommandBuffer *cache     = nullptr;
+			std::size_t          signature = 0;
+
+			if (frame_caches)
+			{
+				signature = get_chunk_signature(primary_command_buffer, draw_start, draw_end, depth_only);
+
+				if (signature != 0)
+				{
+					cache = &(*frame_caches)[(depth_only ? 0 : thread_count) + chunk];
+				}
+			}
+
+			if (cache && cache->recorded && cache->signature == signature)
+			{
+				replayed_command_buffer_count++;
+
+				tasks.push_back(
+				    [this, cache](size_t thread_index) {
+					    VKB_PROFILE_SCOPE("GeometrySubpass::update_cached_allocations");
+
+					    update_cached_allocations(*cache);
+
+					    return cache->recorded;
+				    });
+			}
+			else
+			{
+				tasks.push_back(
+				    [this, &primary_command_buffer, draw_start, draw_end, depth_only, cache, signature](size_t thread_index) {
+					    VKB_PROFILE_SCOPE("GeometrySubpass::record_opaque_batches");
+
+					    auto &secondary_command_buffer = cache ? begin_cached_command_buffer(primary_command_buffer, *cache, thread_index) : begin_secondary_command_buffer(primary_command_buffer, thread_index);
+
+					    if (depth_only)
+					    {
+						    record_depth_prepass(secondary_command_buffer, draw_start, draw_end, thread_index);
+					    }
+					    else
+					    {
+						    record_opaque_batches(secondary_command_buffer, draw_start, draw_end, thread_index);
+					    }
+
+					    secondary_command_buffer.end();
+
+					    if (cache)
+					    {
+						    recording_caches[thread_index] = nullptr;
+
+						    // The pools of the cache are not flushed with those of the frame
+						    cache->uniform_pool->flush();
+						    cache->instance_pool->flush();
+
+						    // Draws skipped or drawn with a fallback while their pipeline compiles must be recorded again
+						    if (secondary_command_buffer.get_skipped_draw_count() == 0 && secondary_command_buffer.get_pending_pipeline_count() == 0)
+						    {
+							    cache->recorded  = &secondary_command_buffer;
+							    cache->signature = signature;
+						    }
+					    }
+
+					    return &secondary_command_buffer;
+				    });
+			}
+
+			draw_start = draw_end;
+		}
+	};
+
+	// The depth pre-pass is executed before any shading draw
+	if (depth_prepass_enabled)
+	{
+		push_opaque_chunks(true);
+	}
+
+	// GPU driven draws come first, like in the inline path
+	if (!indirect_draws.empty())
+	{
+		tasks.push_back(
+		    [this, &primary_command_buffer](size_t thread_index) {
+			    VKB_PROFILE_SCOPE("GeometrySubpass::record_indirect_draws");
+
+			    auto &secondary_command_buffer = begin_secondary_command_buffer(primary_command_buffer, thread_index);
+
+			    record_indirect_draws(secondary_command_buffer, thread_index);
+
+			    secondary_command_buffer.end();
+
+			    return &secondary_command_buffer;
+		    });
+	}
+
+	push_opaque_chunks(false);
+
+	// Boxes are tested once the opaque draws wrote their depth, queries begin and end in the same command buffer
+	if (active_occlusion_queries && !occlusion_candidates.empty())
+	{
+		tasks.push_back(
+		    [this, &primary_command_buffer](size_t thread_index) {
+			    VKB_PROFILE_SCOPE("GeometrySubpass::record_occlusion_queries");
+
+			    auto &secondary_command_buffer = begin_secondary_command_buffer(primary_command_buffer, thread_index);
+
+			    record_occlusion_queries(secondary_command_buffer);
+
+			    secondary_command_buffer.end();
+
+			    return &secondary_command_buffer;
+		    });
+	}
+
+	// Transparent draws go to a single command buffer to preserve their order
+	if (draw_list.get_opaque_count() < draw_list.size())
+	{
+		tasks.push_back(
+		    [this, &primary_command_buffer](size_t thread_index) {
+			    VKB_PROFILE_SCOPE("GeometrySubpass::record_transparent_draws");
+
+			    auto &secondary_command_buffer = begin_secondary_command_buffer(primary_command_buffer, thread_index);
+
+			    record_transparent_draws(secondary_command_buffer, thread_index);
+
+			    secondary_command_buffer.end();
+
+			    return &secondary_command_buffer;
+		    });
+	}
+
+	// This thread records too, the slots index the per thread command pools and buffers of the frame
+	std::vector<CommandBuffer *> secondary_command_buffers(tasks.size());
+
+	auto &job_system = render_context.get_device().get_job_system();
+
+	// Each slot is only written by the thread running it
+	thread_recording_times.assign(thread_count, 0.0);
+
+	job_system.run_parallel(JobPriority::Frame, tasks.size(), thread_count, [&](size_t task, size_t thread_index) {
+		Timer task_timer;
+		task_timer.start();
+
+		secondary_command_buffers[task] = tasks[task](thread_index);
+
+		thread_recording_times[thread_index] += task_timer.stop<Timer::Milliseconds>();
+	});
+
+	if (!secondary_command_buffers.empty())
+	{
+		primary_command_buffer.execute_commands(secondary_command_buffers);
+	}
+}
+
+uint32_t GeometrySubpass::update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index)
+{
+	update_global_uniform(command_buffer, node.get_transform().get_world_matrix(), thread_index, &node);
+
+	auto joint_it = joint_buffers.find(&node);
+
+	if (joint_it != joint_buffers.end())
+	{
+		auto &joint_buffer = joint_it->second;
+
+		command_buffer.bind_buffer(joint_buffer.get_buffer(), joint_buffer.get_offset(), joint_buffer.get_size(), get_descriptor_set(DescriptorSetFrequency::Draw), JOINT_MATRICES_BINDING, 0);
+	}
+
+	return 0;
+}
+
+void GeometrySubpass::update_global_uniform(CommandBuffer &command_buffer, const glm::mat4 &model, size_t thread_index, sg::Node *node)
+{
+	auto cache = thread_index < recording_caches.size() ? recording_caches[thread_index] : nullptr;
+
+	if (view_uniform_enabled)
+	{
+		bind_view_uniform(command_buffer, cache, thread_index);
+	}
+
+	auto allocation = allocate_draw_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, get_global_uniform_size(), thread_index);
+
+	write_global_uniform(allocation, model);
+
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), get_descriptor_set(DescriptorSetFrequency::Draw), 1, 0);
+
+	if (cache && node)
+	{
+		cache->camera_view_proj = frame_view_proj;
+		cache->camera_position  = frame_camera_position;
+		cache->view_projs       = frame_view_projs;
+
+		cache->allocations.push_back({std::move(allocation), {node}, {node->get_transform().get_world_matrix_revision()}, true});
+	}
+}
+
+BufferAllocation GeometrySubpass::allocate_draw_buffer(VkBufferUsageFlags usage, VkDeviceSize size, size_t thread_index)
+{
+	auto cache = thread_index < recording_caches.size() ? recording_caches[thread_index] : nullptr;
+
+	if (!cache)
+	{
+		return get_render_context().get_active_frame().allocate_buffer(usage, size, thread_index);
+	}
+
+	bool uniform = usage == VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+
+	auto &buffer_pool  = uniform ? *cache->uniform_pool : *cache->instance_pool;
+	auto &buffer_block = uniform ? cache->uniform_block : cache->instance_block;
+
+	if (!buffer_block)
+	{
+		buffer_block = &buffer_pool.request_buffer_block(size);
+	}
+
+	auto data = buffer_block->allocate(to_u32(size));
+
+	if (data.empty())
+	{
+		buffer_block = &buffer_pool.request_buffer_block(size);
+
+		data = buffer_block->allocate(to_u32(size));
+	}
+
+	return data;
+}
+
+void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, uint32_t lod, uint32_t first_instance)
+{
+	auto &variant = get_shader_variant(sub_mesh);
+
+	bind_submesh(command_buffer, sub_mesh, front_face, variant, nullptr);
+
+	bind_uber_fallback(command_buffer, sub_mesh, front_face, variant, nullptr);
+
+	draw_submesh_command(command_buffer, sub_mesh, 1, lod, first_instance);
+}
+
+void GeometrySubpass::draw_submesh_instanced(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, BufferAllocation &instance_buffer, uint32_t instance_count, uint32_t lod)
+{
+	assert(instanced_variants.count(&sub_mesh) > 0 && "Instancing must be enabled before preparing the subpass");
+
+	auto &instanced_variant = instanced_variants.at(&sub_mesh);
+
+	bind_submesh(command_buffer, sub_mesh, front_face, instanced_variant, &instance_buffer);
+
+	bind_uber_fallback(command_buffer, sub_mesh, front_face, instanced_variant, &instance_buffer);
+
+	draw_submesh_command(command_buffer, sub_mesh, instance_count, lod);
+}
+
+void GeometrySubpass::compile_materials()
+{
+	material_bindings.clear();
+
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			auto &variant = get_shader_variant(*sub_mesh);
+
+			material_bindings[&variant] = compile_material(*sub_mesh, variant, false);
+
+			auto instanced_it = instanced_variants.find(sub_mesh);
+			if (instanced_it != instanced_variants.end())
+			{
+				material_bindings[&instanced_it->second] = compile_material(*sub_mesh, instanced_it->second, false);
+
+				auto instanced_uber_it = uber_variants.find(&instanced_it->second);
+				if (instanced_uber_it != uber_variants.end())
+				{
+					material_bindings[&instanced_uber_it->second] = compile_uber_material(*sub_mesh, instanced_uber_it->second);
+				}
+			}
+
+			auto uber_it = uber_variants.find(&variant);
+			if (uber_it != uber_variants.end())
+			{
+				material_bindings[&uber_it->second] = compile_uber_material(*sub_mesh, uber_it->second);
+			}
+
+			auto depth_only_it = depth_only_variants.find(sub_mesh);
+			if (depth_only_it != depth_only_variants.end())
+			{
+				material_bindings[&depth_only_it->second] = compile_material(*sub_mesh, depth_only_it->second, true);
+			}
+
+			auto depth_only_instanced_it = depth_only_instanced_variants.find(sub_mesh);
+			if (depth_only_instanced_it != depth_only_instanced_variants.end())
+			{
+				material_bindings[&depth_only_instanced_it->second] = compile_material(*sub_mesh, depth_only_instanced_it->second, true);
+			}
+		}
+	}
+
+	materials_compiled   = true;
+	materials_generation = render_context.get_device().get_resource_cache().get_generation();
+}
+
+GeometrySubpass::MaterialBinding GeometrySubpass::compile_material(sg::SubMesh &sub_mesh, const ShaderVariant &shader_variant, bool depth_only)
+{
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	MaterialBinding binding;
+	binding.variant_id = shader_variant.get_id();
+
+	auto &vert_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), shader_variant);
+
+	if (depth_only)
+	{
+		// Without a fragment shader, no material resources are needed
+		binding.pipeline_layout = &resource_cache.request_pipeline_layout({&vert_shader_module}, use_dynamic_resources);
+
+		return binding;
+	}
+
+	auto &frag_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), shader_variant);
+
+	binding.pipeline_layout = &resource_cache.request_pipeline_layout({&vert_shader_module, &frag_shader_module}, use_dynamic_resources);
+
+	auto pbr_material = dynamic_cast<const sg::PBRMaterial *>(sub_mesh.get_material());
+
+	if (bindless_textures_enabled)
+	{
+		// The textures were bound with the common resources
+		BindlessMaterialUniform bindless_material_uniform{};
+		bindless_material_uniform.base_color_factor                = pbr_material->base_color_factor;
+		bindless_material_uniform.metallic_factor                  = pbr_material->metallic_factor;
+		bindless_material_uniform.roughness_factor                 = pbr_material->roughness_factor;
+		bindless_material_uniform.base_color_texture_index         = get_bindless_texture_index(*pbr_material, "base_color_texture");
+		bindless_material_uniform.normal_texture_index             = get_bindless_texture_index(*pbr_material, "normal_texture");
+		bindless_material_uniform.metallic_roughness_texture_index = get_bindless_texture_index(*pbr_material, "metallic_roughness_texture");
+
+		auto data = reinterpret_cast<const uint8_t *>(&bindless_material_uniform);
+		binding.material_uniform.assign(data, data + sizeof(bindless_material_uniform));
+	}
+	else
+	{
+		auto array_texture = get_array_texture(*pbr_material);
+
+		if (array_texture)
+		{
+			TextureArrayMaterialUniform array_material_uniform{};
+			array_material_uniform.base_color_factor        = pbr_material->base_color_factor;
+			array_material_uniform.metallic_factor          = pbr_material->metallic_factor;
+			array_material_uniform.roughness_factor         = pbr_material->roughness_factor;
+			array_material_uniform.base_color_texture_layer = array_texture->get_array_layer();
+
+			auto data = reinterpret_cast<const uint8_t *>(&array_material_uniform);
+			binding.material_uniform.assign(data, data + sizeof(array_material_uniform));
+		}
+		else
+		{
+			PBRMaterialUniform pbr_material_uniform{};
+			pbr_material_uniform.base_color_factor = pbr_material->base_color_factor;
+			pbr_material_uniform.metallic_factor   = pbr_material->metallic_factor;
+			pbr_material_uniform.roughness_factor  = pbr_material->roughness_factor;
+
+			auto data = reinterpret_cast<const uint8_t *>(&pbr_material_uniform);
+			binding.material_uniform.assign(data, data + sizeof(pbr_material_uniform));
+		}
+
+		auto &descriptor_set_layout = binding.pipeline_layout->get_descriptor_set_layout(get_descriptor_set(DescriptorSetFrequency::Material));
+
+		for (auto &texture : sub_mesh.get_material()->textures)
+		{
+			if (auto layout_binding = descriptor_set_layout.get_layout_binding(texture.first))
+			{
+				auto &textures = texture.second == array_texture ? binding.array_textures : binding.textures;
+				textures.emplace_back(layout_binding->binding, texture.second);
+			}
+		}
+
+		if (specialized_materials_enabled)
+		{
+			auto &material_textures = sub_mesh.get_material()->textures;
+
+			for (auto &texture : SELECTED_MATERIAL_TEXTURES)
+			{
+				bool has_texture = material_textures.find(texture.first) != material_textures.end();
+
+				binding.specialization_constants.emplace_back(texture.second, has_texture);
+
+				// The sampler is declared even if the material lacks the texture, so it needs a valid image
+				auto layout_binding = descriptor_set_layout.get_layout_binding(texture.first);
+				if (!has_texture && layout_binding)
+				{
+					binding.textures.emplace_back(layout_binding->binding, fallback_material_texture);
+				}
+			}
+		}
+	}
+
+	return binding;
+}
+
+GeometrySubpass::MaterialBinding GeometrySubpass::compile_uber_material(sg::SubMesh &sub_mesh, const ShaderVariant &uber_variant)
+{
+	auto binding = compile_material(sub_mesh, uber_variant, false);
+
+	auto  pbr_material          = dynamic_cast<const sg::PBRMaterial *>(sub_mesh.get_material());
+	auto &descriptor_set_layout = binding.pipeline_layout->get_descriptor_set_layout(get_descriptor_set(DescriptorSetFrequency::Material));
+
+	UberMaterialUniform uber_material_uniform{};
+	uber_material_uniform.base_color_factor = pbr_material->base_color_factor;
+	uber_material_uniform.metallic_factor   = pbr_material->metallic_factor;
+	uber_material_uniform.roughness_factor  = pbr_material->roughness_factor;
+
+	// Specialized materials already bound the fallback texture
+	binding.specialization_constants.clear();
+
+	for (size_t i = 0; i < SELECTED_MATERIAL_TEXTURES.size(); i++)
+	{
+		auto &texture = SELECTED_MATERIAL_TEXTURES[i];
+
+		if (pbr_material->textures.find(texture.first) != pbr_material->textures.end())
+		{
+			uber_material_uniform.texture_mask |= 1u << i;
+		}
+		else if (!specialized_materials_enabled)
+		{
+			if (auto layout_binding = descriptor_set_layout.get_layout_binding(texture.first))
+			{
+				binding.textures.emplace_back(layout_binding->binding, fallback_material_texture);
+			}
+		}
+
+		// The uber shader declares no constants, set them all the same so that every uber draw shares its pipelines
+		if (specialized_materials_enabled)
+		{
+			binding.specialization_constants.emplace_back(texture.second, false);
+		}
+	}
+
+	auto data = reinterpret_cast<const uint8_t *>(&uber_material_uniform);
+	binding.material_uniform.assign(data, data + sizeof(uber_material_uniform));
+
+	return binding;
+}
+
+const GeometrySubpass::MaterialBinding &GeometrySubpass::get_material_binding(sg::SubMesh &sub_mesh, const ShaderVariant &shader_variant, bool depth_only, MaterialBinding &scratch)
+{
+	auto it = material_bindings.find(&shader_variant);
+
+	if (it != material_bindings.end() && it->second.variant_id == shader_variant.get_id())
+	{
+		return it->second;
+	}
+
+	// Uber variants are only drawn while the pipelines of other variants compile, so finding them is not worth an index
+	bool uber = std::any_of(uber_variants.begin(), uber_variants.end(), [&shader_variant](const std::pair<const ShaderVariant *const, ShaderVariant> &entry) {
+		return &entry.second == &shader_variant;
+	});
+
+	scratch = uber ? compile_uber_material(sub_mesh, shader_variant) : compile_material(sub_mesh, shader_variant, depth_only);
+
+	return scratch;
+}
+
+void GeometrySubpass::bind_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, const ShaderVariant &shader_variant, BufferAllocation *instance_buffer, VkDeviceSize instance_offset)
+{
+	RasterizationState rasterization_state{};
+	rasterization_state.front_face = front_face;
+
+	if (sub_mesh.get_material()->double_sided)
+	{
+		rasterization_state.cull_mode = VK_CULL_MODE_NONE;
+	}
+
+	command_buffer.set_rasterization_state(rasterization_state);
+
+	MaterialBinding scratch;
+	auto &          binding = get_material_binding(sub_mesh, shader_variant, false, scratch);
+
+	command_buffer.bind_pipeline_layout(*binding.pipeline_layout);
+
+	command_buffer.push_constants_accumulated(binding.material_uniform);
+
+	for (auto &constant : binding.specialization_constants)
+	{
+		command_buffer.set_specialization_constant(constant.first, constant.second);
+	}
+
+	for (auto &texture : binding.textures)
+	{
+		command_buffer.bind_image(texture.second->get_image()->get_vk_image_view(),
+		                          texture.second->get_sampler()->vk_sampler,
+		                          get_descriptor_set(DescriptorSetFrequency::Material), texture.first, 0);
+	}
+
+	for (auto &texture : binding.array_textures)
+	{
+		command_buffer.bind_image(texture.second->get_array()->get_vk_image_view(),
+		                          texture.second->get_sampler()->vk_sampler,
+		                          get_descriptor_set(DescriptorSetFrequency::Material), texture.first, 0);
+	}
+
+	bind_vertex_input(command_buffer, sub_mesh, *binding.pipeline_layout, instance_buffer, instance_offset);
+}
+
+void GeometrySubpass::bind_uber_fallback(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, const ShaderVariant &shader_variant, BufferAllocation *instance_buffer)
+{
+	if (!uber_shader_fallback_enabled)
+	{
+		return;
+	}
+
+	auto uber_it = uber_variants.find(&shader_variant);
+
+	// Requesting the pipeline queues it on the compile threads, and the draws switch back to it once it is ready
+	if (uber_it == uber_variants.end() || command_buffer.prepare_graphics_pipeline(false))
+	{
+		return;
+	}
+
+	bind_submesh(command_buffer, sub_mesh, front_face, uber_it->second, instance_buffer);
+
+	command_buffer.prepare_graphics_pipeline(true);
+}
+
+void GeometrySubpass::bind_depth_only_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, const ShaderVariant &shader_variant, BufferAllocation *instance_buffer)
+{
+	RasterizationState rasterization_state{};
+	rasterization_state.front_face = front_face;
+
+	if (sub_mesh.get_material()->double_sided)
+	{
+		rasterization_state.cull_mode = VK_CULL_MODE_NONE;
+	}
+
+	command_buffer.set_rasterization_state(rasterization_state);
+
+	MaterialBinding scratch;
+	auto &          binding = get_material_binding(sub_mesh, shader_variant, true, scratch);
+
+	command_buffer.bind_pipeline_layout(*binding.pipeline_layout);
+
+	bind_vertex_input(command_buffer, sub_mesh, *binding.pipeline_layout, instance_buffer, 0);
+}
+
+void GeometrySubpass::bind_vertex_input(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, const PipelineLayout &pipeline_layout, BufferAllocation *instance_buffer, VkDeviceSize instance_offset)
+{
+	auto &vertex_input = request_vertex_input(sub_mesh, pipeline_layout, instance_buffer != nullptr);
+
+	command_buffer.set_vertex_input_state(vertex_input.state);
+
+	for (auto &binding : vertex_input.bindings)
+	{
+		// Bind vertex buffers only for the attribute locations defined
+		command_buffer.bind_vertex_buffers(binding.location, 1, &binding.buffer, &binding.offset);
+	}
+
+	if (instance_buffer)
+	{
+		command_buffer.bind_vertex_buffer(vertex_input.instance_location, instance_buffer->get_buffer(), instance_buffer->get_offset() + instance_offset);
+	}
+}
+
+const GeometrySubpass::VertexInput &GeometrySubpass::request_vertex_input(sg::SubMesh &sub_mesh, const PipelineLayout &pipeline_layout, bool instanced)
+{
+	std::size_t key{0U};
+	hash_combine(key, &sub_mesh);
+	hash_combine(key, &pipeline_layout);
+	hash_combine(key, instanced);
+
+	std::lock_guard<std::mutex> guard(vertex_input_mutex);
+
+	auto it = vertex_inputs.find(key);
+	if (it != vertex_inputs.end())
+	{
+		return it->second;
+	}
+
+	VertexInput vertex_input;
+
+	auto vertex_input_resources = pipeline_layout.get_shader_program().get_resources(ShaderResourceType::Input, VK_SHADER_STAGE_VERTEX_BIT);
+
+	// Attributes interleaved in the same buffer share the binding of the first of them, so that their stream is bound once
+	std::unordered_map<const BufferAllocation *, uint32_t> buffer_bindings;
+
+	for (auto &input_resource : vertex_input_resources)
+	{
+		sg::VertexAttribute attribute;
+
+		if (!sub_mesh.get_attribute(input_resource.name, attribute))
+		{
+			continue;
+		}
+
+		auto vertex_buffer = sub_mesh.find_vertex_buffer(input_resource.name);
+		auto binding_it    = buffer_bindings.emplace(vertex_buffer, input_resource.location);
+
+		VkVertexInputAttributeDescription vertex_attribute{};
+		vertex_attribute.binding  = binding_it.first->second;
+		vertex_attribute.format   = attribute.format;
+		vertex_attribute.location = input_resource.location;
+		vertex_attribute.offset   = attribute.offset;
+
+		vertex_input.state.attributes.push_back(vertex_attribute);
+
+		if (!binding_it.second)
+		{
+			continue;
+		}
+
+		VkVertexInputBindingDescription vertex_binding{};
+		vertex_binding.binding = input_resource.location;
+		vertex_binding.stride  = attribute.stride;
+
+		vertex_input.state.bindings.push_back(vertex_binding);
+
+		if (vertex_buffer)
+		{
+			VertexInput::Binding binding;
+			binding.location = input_resource.location;
+			binding.buffer   = vertex_buffer->get_buffer().get_handle();
+			binding.offset   = vertex_buffer->get_offset();
+
+			vertex_input.bindings.push_back(std::move(binding));
+		}
+	}
+
+	if (instanced)
+	{
+		auto instance_input = std::find_if(vertex_input_resources.begin(), vertex_input_resources.end(),
+		                                   [](const ShaderResource &resource) { return resource.name == "instance_model"; });
+
+		if (instance_input == vertex_input_resources.end())
+		{
+			throw std::runtime_error{"Vertex shader has no instance_model input for instanced draws"};
+		}
+
+		vertex_input.instance_location = instance_input->location;
+
+		// One binding per instance, the matrix takes one location per column
+		VkVertexInputBindingDescription instance_binding{};
+		instance_binding.binding   = vertex_input.instance_location;
+		instance_binding.stride    = sizeof(glm::mat4);
+		instance_binding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+		vertex_input.state.bindings.push_back(instance_binding);
+
+		for (uint32_t column = 0; column < 4; column++)
+		{
+			VkVertexInputAttributeDescription instance_attribute{};
+			instance_attribute.binding  = vertex_input.instance_location;
+			instance_attribute.format   = VK_FORMAT_R32G32B32A32_SFLOAT;
+			instance_attribute.location = vertex_input.instance_location + column;
+			instance_attribute.offset   = column * sizeof(glm::vec4);
+
+			vertex_input.state.attributes.push_back(instance_attribute);
+		}
+	}
+
+	return vertex_inputs.emplace(key, std::move(vertex_input)).first->second;
+}
+
+void GeometrySubpass::draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, uint32_t instance_count, uint32_t lod, uint32_t first_instance)
+{
+	// Redundant sets are skipped by the command buffer
+	command_buffer.set_fragment_shading_rate(get_draw_shading_rate(sub_mesh, lod));
+
 	// Draw submesh indexed if indices exists
 	if (sub_mesh.vertex_indices != 0)
 	{
-		// Bind index buffer of submesh
-		command_buffer.bind_index_buffer(*sub_mesh.index_buffer, sub_mesh.index_offset, sub_mesh.index_type);
+		// Bind the whole shared index buffer, so that submeshes packed in the same buffer
+		// do not need a rebind and are addressed through their first index instead
+		command_buffer.bind_index_buffer(sub_mesh.get_index_buffer(lod).get_buffer(), 0, sub_mesh.index_type);
 
 		// Draw submesh using indexed data
-		command_buffer.draw_indexed(sub_mesh.vertex_indices, 1, 0, 0, 0);
+		command_buffer.draw_indexed(sub_mesh.get_vertex_indices(lod), instance_count, sub_mesh.get_first_index(lod), 0, first_instance);
 	}
 	else
 	{
 		// Draw submesh using vertices only
-		command_buffer.draw(sub_mesh.vertices_count, 1, 0, 0);
+		command_buffer.draw(sub_mesh.vertices_count, instance_count, 0, first_instance);
 	}
 }
 }        // namespace vkb
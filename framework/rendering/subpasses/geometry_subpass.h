@@ -20,16 +20,25 @@
 
 #pragma once
 
+#include <array>
+#include <mutex>
+
 #include "common/error.h"
+#include "core/query_pool.h"
 
 VKBP_DISABLE_WARNINGS()
 #include "common/glm_common.h"
 VKBP_ENABLE_WARNINGS()
 
+#include "rendering/draw_list.h"
 #include "rendering/subpass.h"
+#include "scene_graph/components/bvh.h"
 
 namespace vkb
 {
+class Stats;
+class TextureStreamer;
+
 namespace sg
 {
 class Scene;
@@ -37,6 +46,9 @@ class Node;
 class Mesh;
 class SubMesh;
 class Camera;
+class Material;
+class Texture;
+class TextureArray;
 }        // namespace sg
 
 /**
@@ -51,6 +63,37 @@ struct alignas(16) GlobalUniform
 	glm::vec3 camera_position;
 };
 
+/// Most views rendered in a single pass by the multiview variants of the base shaders, a stereo pair
+#define MAX_VIEW_COUNT 2
+
+/**
+ * @brief Global uniform structure for the MULTIVIEW variants of the base shader,
+ *        which transform the vertices with the matrix of the view given by gl_ViewIndex
+ */
+struct alignas(16) MultiviewGlobalUniform : GlobalUniform
+{
+	glm::mat4 view_proj[MAX_VIEW_COUNT];
+};
+
+/**
+ * @brief View uniform structure for the VIEW_UNIFORM variants of the base shader,
+ *        written once per frame while the global uniform of each draw only holds its model matrix
+ */
+struct alignas(16) ViewUniform
+{
+	glm::mat4 camera_view_proj;
+
+	glm::vec3 camera_position;
+};
+
+/**
+ * @brief View uniform structure for the variants of the base shader with both the MULTIVIEW and VIEW_UNIFORM defines
+ */
+struct alignas(16) MultiviewViewUniform : ViewUniform
+{
+	glm::mat4 view_proj[MAX_VIEW_COUNT];
+};
+
 /**
  * @brief PBR material uniform for base shader
  */
@@ -63,12 +106,78 @@ struct PBRMaterialUniform
 	float roughness_factor;
 };
 
+/**
+ * @brief PBR material uniform for base shader when the textures are bindless,
+ *        the material textures are indices into the texture array of the scene
+ */
+struct BindlessMaterialUniform
+{
+	glm::vec4 base_color_factor;
+
+	float metallic_factor;
+
+	float roughness_factor;
+
+	uint32_t base_color_texture_index;
+
+	uint32_t normal_texture_index;
+
+	uint32_t metallic_roughness_texture_index;
+};
+
+/**
+ * @brief PBR material uniform for base shader when the base color texture is a layer of a texture array,
+ *        see TextureArrayBatcher
+ */
+struct TextureArrayMaterialUniform
+{
+	glm::vec4 base_color_factor;
+
+	float metallic_factor;
+
+	float roughness_factor;
+
+	uint32_t base_color_texture_layer;
+};
+
+/**
+ * @brief PBR material uniform for the uber shader drawn while the pipeline of a material compiles,
+ *        the textures of the material are selected by a mask instead of by defines
+ */
+struct UberMaterialUniform
+{
+	glm::vec4 base_color_factor;
+
+	float metallic_factor;
+
+	float roughness_factor;
+
+	/// Bit of each material texture present, base color, normal then metallic roughness
+	uint32_t texture_mask;
+};
+
 /**
  * @brief This subpass is responsible for rendering a Scene
  */
 class GeometrySubpass : public Subpass
 {
   public:
+	/**
+	 * @brief Work of the subpass attributed to a scene node
+	 */
+	struct NodeCost
+	{
+		uint32_t draw_count{0};
+
+		uint32_t triangle_count{0};
+
+		/// Share of the CPU time spent culling and sorting the nodes, in milliseconds
+		double culling_time{0.0};
+
+		/// Share of the CPU time spent recording the draws, in milliseconds
+		double recording_time{0.0};
+	};
+
 	/**
 	 * @brief Constructs a subpass for the geometry pass of Deferred rendering
 	 * @param render_context Render context
@@ -83,22 +192,434 @@ class GeometrySubpass : public Subpass
 
 	virtual void prepare() override;
 
+	/**
+	 * @brief Culls the GPU driven draws with a compute shader, writing their indirect draw commands
+	 */
+	virtual void pre_draw(CommandBuffer &command_buffer) override;
+
 	/**
 	 * @brief Record draw commands
 	 */
 	virtual void draw(CommandBuffer &command_buffer) override;
 
-	void update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index = 0);
+	/**
+	 * @brief Binds the global uniform of a node, and the joint matrices of skinned nodes
+	 *        Subclasses can override it to provide the transform of the node another way
+	 * @return First instance of the draws of the node, so that shaders can index per node data
+	 *         with gl_InstanceIndex. It is 0 for the global uniform.
+	 */
+	virtual uint32_t update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index = 0);
+
+	/**
+	 * @brief Draws a submesh at a level of detail, see sg::SubMesh::lods
+	 *        Subclasses can override it to set state between binding the submesh and drawing it
+	 */
+	virtual void draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE, uint32_t lod = 0, uint32_t first_instance = 0);
+
+	/**
+	 * @brief Draws several instances of a submesh with a single draw call
+	 *        The vertex shader is compiled with INSTANCING defined, and reads the
+	 *        model matrix of each instance from the instance_model input attribute
+	 * @param command_buffer Command buffer to record the draw to
+	 * @param sub_mesh Submesh to draw
+	 * @param front_face Front face shared by all the instances
+	 * @param instance_buffer Vertex buffer with one model matrix per instance
+	 * @param instance_count Number of instances to draw
+	 * @param lod Level of detail of the submesh shared by all the instances
+	 */
+	void draw_submesh_instanced(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, BufferAllocation &instance_buffer, uint32_t instance_count, uint32_t lod = 0);
+
+	/**
+	 * @brief Sets the number of threads used to record the draw commands
+	 *        With more than one thread, the sorted opaque draws are split into chunks which are
+	 *        recorded into secondary command buffers by jobs of the device job system, and then
+	 *        executed in the primary command buffer. Transparent draws are recorded into one
+	 *        additional secondary command buffer to keep their back-to-front order.
+	 * @param thread_count Number of recording threads, 1 to record inline in the primary command buffer.
+	 *        It must not exceed the thread count the RenderContext was prepared with.
+	 */
+	void set_thread_count(uint32_t thread_count);
+
+	uint32_t get_thread_count() const;
+
+	/**
+	 * @brief Enables or disables frustum culling of the scene nodes against the camera
+	 */
+	void set_culling_enabled(bool enabled);
+
+	bool is_culling_enabled() const;
+
+	/**
+	 * @return Number of submesh draws skipped by frustum culling during the last draw
+	 */
+	uint32_t get_culled_draw_count() const;
+
+	/**
+	 * @return CPU time of the last draw spent culling and sorting the nodes, in milliseconds
+	 */
+	double get_culling_time() const;
+
+	/**
+	 * @return CPU time of the last draw spent recording the draw commands, in milliseconds
+	 */
+	double get_recording_time() const;
+
+	/**
+	 * @return CPU time each recording thread spent on the jobs of the last draw, in milliseconds
+	 *         The gap between their sum and thread count times get_recording_time() is the time the
+	 *         threads were idle, e.g. waiting for a lock or for the last chunk to be recorded
+	 */
+	const std::vector<double> &get_thread_recording_times() const;
+
+	/**
+	 * @brief Sets the stats which the number of culled draws is reported to
+	 * @param stats Stats object, or nullptr to stop reporting
+	 */
+	void set_stats(Stats *stats);
+
+	/**
+	 * @brief Enables or disables instancing of the opaque draws
+	 *        Opaque draws of the same submesh and front face are merged into one instanced draw.
+	 *        The vertex shader must support the INSTANCING define, and this must be set before prepare().
+	 */
+	void set_instancing_enabled(bool enabled);
+
+	bool is_instancing_enabled() const;
+
+	/**
+	 * @brief Enables or disables GPU driven rendering of the opaque indexed draws
+	 *        A compute shader culls them against the camera frustum and writes their indirect
+	 *        draw commands. They are then recorded with draw_indexed_indirect, reading their
+	 *        model matrix from a vertex buffer shared by all the draws instead of a uniform per draw.
+	 *        Submeshes split into meshlets are culled per meshlet instead, against the frustum and by
+	 *        their normal cone, and write one indirect command per meshlet.
+	 *        The vertex shader must support the INSTANCING define, and this must be set before prepare().
+	 */
+	void set_gpu_driven(bool enabled);
+
+	bool is_gpu_driven() const;
+
+	/**
+	 * @brief Enables or disables bindless textures
+	 *        All the textures of the scene are bound once per command buffer as a single sampled image
+	 *        array, and each draw pushes the indices of its material textures as push constants instead
+	 *        of binding them, so draws with different materials share the same descriptor set.
+	 *        The fragment shader must support the BINDLESS_TEXTURES define, and this must be set before prepare().
+	 *        It is ignored if the device cannot index sampler arrays dynamically or the scene has too many textures.
+	 */
+	void set_bindless_textures_enabled(bool enabled);
+
+	bool is_bindless_textures_enabled() const;
 
-	void draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE);
+	/**
+	 * @brief Enables or disables texture arrays
+	 *        Materials whose base color image was batched into a sg::TextureArray bind the array and push their layer,
+	 *        so that materials differing only by their images share descriptor sets, see TextureArrayBatcher.
+	 *        The fragment shader must support the TEXTURE_ARRAYS define, and this must be set before prepare().
+	 *        It is ignored with bindless textures, specialized materials and uber shader fallbacks, or if the scene has no texture arrays.
+	 */
+	void set_texture_arrays_enabled(bool enabled);
+
+	bool is_texture_arrays_enabled() const;
+
+	/**
+	 * @brief Enables or disables specialized materials
+	 *        The material texture defines are removed from the shader variants, so that submeshes with the same
+	 *        vertex attributes share shader modules, and each draw selects its textures with specialization constants.
+	 *        Samplers of textures a material lacks are bound to another texture of the scene, which the shader does not sample.
+	 *        The fragment shader must support the SPECIALIZED_MATERIAL define, and this must be set before prepare().
+	 *        It is ignored with bindless textures or if the scene has no textures.
+	 */
+	void set_specialized_materials_enabled(bool enabled);
+
+	bool is_specialized_materials_enabled() const;
+
+	/**
+	 * @brief Enables or disables uber shader fallbacks
+	 *        While the pipeline of a submesh compiles asynchronously, see ResourceCache::set_async_pipeline_compilation(),
+	 *        its draws use an uber variant selecting the material textures from push constants instead of being skipped.
+	 *        The uber variants only depend on the vertex attributes, so their few pipelines are compiled on the recording thread.
+	 *        The fragment shader must support the UBER_MATERIAL define, and this must be set before prepare().
+	 *        It is ignored with bindless textures, if the scene has no textures, and for GPU driven and depth only draws.
+	 */
+	void set_uber_shader_fallback_enabled(bool enabled);
+
+	bool is_uber_shader_fallback_enabled() const;
+
+	/**
+	 * @brief Enables or disables the depth pre-pass
+	 *        Opaque draws are first recorded with a position only vertex shader and no color writes,
+	 *        then shaded with an EQUAL depth test and depth writes disabled, so that each pixel is shaded once.
+	 *        Alpha masked draws are not part of the pre-pass, as their depth depends on the fragment shader.
+	 *        The vertex shader must support the DEPTH_ONLY define, and this must be set before prepare().
+	 */
+	void set_depth_prepass_enabled(bool enabled);
+
+	bool is_depth_prepass_enabled() const;
+
+	/**
+	 * @brief Enables or disables the view uniform
+	 *        The view projection and the position of the camera are written once per frame into a ViewUniform,
+	 *        and the global uniform of each draw only holds its model matrix, less than half of its full size.
+	 *        The shaders must support the VIEW_UNIFORM define, and this must be set before prepare().
+	 */
+	void set_view_uniform_enabled(bool enabled);
+
+	bool is_view_uniform_enabled() const;
+
+	/**
+	 * @brief Update frequency of the resources of the base shaders, which is their descriptor set when sets are partitioned
+	 */
+	enum class DescriptorSetFrequency : uint32_t
+	{
+		Frame    = 0,
+		Material = 1,
+		Draw     = 2
+	};
+
+	/**
+	 * @brief Enables or disables descriptor sets partitioned by update frequency
+	 *        The resources of the frame, such as lights and shadows, are bound in set 0, the material textures in set 1
+	 *        and the global uniform and joint matrices of each draw in set 2, so that a draw only writes and binds the sets
+	 *        that changed, while the sets of lower frequency stay bound. Otherwise all of them are bound in set 0.
+	 *        The shaders must support the PARTITIONED_SETS define, and this must be set before prepare().
+	 */
+	void set_partitioned_descriptor_sets_enabled(bool enabled);
+
+	bool is_partitioned_descriptor_sets_enabled() const;
+
+	/**
+	 * @return The descriptor set of the resources updated at the given frequency, 0 unless sets are partitioned
+	 */
+	uint32_t get_descriptor_set(DescriptorSetFrequency frequency) const;
+
+	/**
+	 * @brief Enables or disables push descriptors for the per-draw set
+	 *        The global uniform and joint matrices changing on every draw are then written into the command buffer
+	 *        with VK_KHR_push_descriptor, instead of looking up and allocating a descriptor set for each draw.
+	 *        It requires partitioned descriptor sets, and is ignored if the device does not support push descriptors.
+	 *        This must be set before prepare().
+	 */
+	void set_push_descriptors_enabled(bool enabled);
+
+	bool is_push_descriptors_enabled() const;
+
+	/**
+	 * @brief Sets the order of the opaque draws
+	 *        Depth draws them front-to-back to reject hidden fragments early, State groups them by pipeline
+	 *        then material to minimize the state changes, and Hybrid groups them within coarse depth bins.
+	 *        Unsorted keeps the order the scene is traversed in, as a baseline for the others.
+	 *        Instanced draws keep the order of the first draw of each group.
+	 */
+	void set_opaque_sort_policy(DrawSortPolicy policy);
+
+	DrawSortPolicy get_opaque_sort_policy() const;
+
+	/**
+	 * @brief Shades the distant draws at a coarser rate, on devices supporting fragment shading rates
+	 * @param min_lod Level of detail from which draws are shaded coarsely, ~0U to shade every draw at the subpass rate
+	 * @param fragment_size Size of the blocks of pixels shaded by one invocation
+	 */
+	void set_coarse_shading(uint32_t min_lod, const VkExtent2D &fragment_size = {2, 2});
+
+	/**
+	 * @brief Shades the draws of a low importance material at a coarser rate, on devices supporting
+	 *        fragment shading rates. The coarsest of the material and level of detail rates is used.
+	 */
+	void set_material_shading_rate(const sg::Material &material, const VkExtent2D &fragment_size);
+
+	/**
+	 * @brief Renders the scene from several cameras in a single pass with multiview, each camera to
+	 *        the matching layer of the attachments, instead of drawing the scene once per view.
+	 *        The camera of the subpass keeps culling and sorting the draws and lighting the fragments,
+	 *        so its frustum should contain the ones of the views, like a camera between the eyes.
+	 *        The vertex shader must support the MULTIVIEW define, and this must be set before prepare().
+	 *        Occlusion culling is not supported with multiview.
+	 * @param cameras Camera of each view, at most MAX_VIEW_COUNT, empty to render the subpass camera only
+	 */
+	void set_view_cameras(const std::vector<sg::Camera *> &cameras);
+
+	/**
+	 * @brief Enables or disables occlusion culling of the scene nodes
+	 *        After the opaque draws, the bounding box of every node in the frustum is tested against the depth
+	 *        buffer with an occlusion query. The queries of a render frame are read back when the frame is reused,
+	 *        once its previous submission completed, so nodes whose box was hidden are skipped without waiting
+	 *        for the GPU. Hidden nodes keep being tested, and are drawn again as soon as their box passes.
+	 *        The queries are reset in pre_draw(), so the subpass must be drawn by a RenderPipeline.
+	 */
+	void set_occlusion_culling_enabled(bool enabled);
+
+	bool is_occlusion_culling_enabled() const;
+
+	/**
+	 * @return Number of submesh draws skipped by occlusion culling during the last draw
+	 */
+	uint32_t get_occluded_draw_count() const;
+
+	/**
+	 * @brief Sets the texture streamer which the images of the drawn materials are requested from
+	 *        Each draw requests the finest mip level its textures need, from the screen size of its node bounds,
+	 *        assuming the texture coordinates span the bounds once. It is ignored with bindless textures,
+	 *        as the texture array keeps the image views it was written with.
+	 * @param texture_streamer Texture streamer, or nullptr to stop requesting levels
+	 */
+	void set_texture_streamer(TextureStreamer *texture_streamer);
+
+	/**
+	 * @brief Enables or disables caching of the opaque command buffers
+	 *        With more than one recording thread, the secondary command buffers of the depth pre-pass and
+	 *        opaque chunks of each render frame are kept, and executed again in later frames while their chunk
+	 *        draws the same submeshes. Their uniforms are rewritten in place when the camera or the transform
+	 *        of a node moves. They are recorded again when the pipelines, framebuffers or descriptor sets they
+	 *        use are cleared, or when the common resources of the subpass change. Chunks with skinned nodes are
+	 *        always recorded, and nothing is cached while a texture streamer is set. Changes to the materials
+	 *        are not tracked, invalidate_cached_command_buffers() must be called after them.
+	 */
+	void set_command_buffer_caching(bool enabled);
+
+	bool is_command_buffer_caching() const;
+
+	/**
+	 * @brief Records every cached command buffer again the next time it is used
+	 */
+	void invalidate_cached_command_buffers();
+
+	/**
+	 * @return Number of cached command buffers executed again without being recorded during the last draw
+	 */
+	uint32_t get_replayed_command_buffer_count() const;
+
+	/**
+	 * @brief Attributes the work of the last draw to the scene nodes
+	 *        Draws and triangles are those issued for each node, at the levels of detail selected. The CPU times
+	 *        are only measured for the whole subpass, the culling time is split evenly between the nodes with
+	 *        a mesh and the recording time between the draws.
+	 * @param node_costs Costs the work of the subpass is added to
+	 */
+	void get_node_costs(std::unordered_map<const sg::Node *, NodeCost> &node_costs) const;
+
+	/**
+	 * @brief Resolves the pipeline layout, material uniform and texture bindings of every shader variant of the submeshes
+	 *        Draws then bind what was resolved instead of requesting it from the resource cache. It is called by draw()
+	 *        the first time and whenever the resource cache is cleared, and must be called again after changing the
+	 *        materials of the scene. Draws of variants changed since they were resolved fall back to requesting them.
+	 */
+	void compile_materials();
 
   protected:
 	/**
-	 * @brief Sorts objects based on distance from camera and classifies them
-	 *        into opaque and transparent in the arrays provided
+	 * @brief Sets the rasterization state, pipeline layout and resources of a submesh
+	 *        If an instance buffer is given, it is bound as a per instance vertex buffer
+	 */
+	void bind_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, const ShaderVariant &shader_variant, BufferAllocation *instance_buffer, VkDeviceSize instance_offset = 0);
+
+	/**
+	 * @brief Records the draw command of a submesh bound by bind_submesh()
+	 */
+	void draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, uint32_t instance_count = 1, uint32_t lod = 0, uint32_t first_instance = 0);
+
+	/**
+	 * @brief Binds the resources shared by all the draws of the subpass
+	 *        It is called once for every command buffer the draws are recorded to
+	 * @param command_buffer Command buffer to bind the resources to
+	 */
+	virtual void bind_common_resources(CommandBuffer &command_buffer);
+
+	/**
+	 * @return A hash of the resources bound by bind_common_resources(), the cached command buffers
+	 *         are recorded again when it changes
+	 */
+	virtual std::size_t get_common_resources_signature();
+
+	/**
+	 * @brief Fills the draw list with the scene submeshes, sorted based on distance
+	 *        from camera and classified into opaque and transparent
+	 *        Nodes whose world space bounds are outside the camera frustum are skipped,
+	 *        using the sg::BVH component of the scene to find them if there is one
+	 *        The nodes are culled, and their levels of detail and sort keys computed, in ranges
+	 *        split over the workers of the job system, then the draws are sorted in parallel
+	 * @param sorted_draws Draw list to fill, its previous content is cleared
+	 */
+	void get_sorted_nodes(DrawList &sorted_draws);
+
+	/**
+	 * @brief Creates the shader variant used by the instanced draws of a submesh,
+	 *        from the variant of the submesh prepared by the subpass with INSTANCING defined
+	 * @return The instanced variant, which is kept by the subpass
+	 */
+	const ShaderVariant &add_instanced_variant(sg::SubMesh &sub_mesh);
+
+	/**
+	 * @return The shader variant of a submesh with the definitions of the subpass,
+	 *         or the variant of the submesh itself if it was not prepared by the subpass
+	 */
+	const ShaderVariant &get_shader_variant(const sg::SubMesh &sub_mesh) const;
+
+	/**
+	 * @brief Adds the definitions of a derived subpass to the shader variant of a submesh,
+	 *        before prepare() adds the definitions of the enabled modes and requests the shader modules
+	 */
+	virtual void add_subpass_definitions(ShaderVariant &variant);
+
+	/**
+	 * @brief Gathers the textures of the scene for bindless rendering, disabling it if the device does not support it
+	 *        It is called at the start of prepare()
+	 */
+	void prepare_bindless_textures();
+
+	/**
+	 * @brief Chooses the texture bound in place of missing material textures,
+	 *        disabling specialized materials and uber shader fallbacks if there is none
+	 *        It is called after prepare_bindless_textures()
+	 */
+	void prepare_fallback_material_texture();
+
+	/**
+	 * @brief Disables texture arrays if the scene has none or another material mode is enabled
+	 *        It is called after prepare_fallback_material_texture()
+	 */
+	void prepare_texture_arrays();
+
+	/**
+	 * @brief Adds the TEXTURE_ARRAYS define to a variant if the base color texture of the submesh is a texture array layer
+	 */
+	void add_texture_array_definitions(const sg::SubMesh &sub_mesh, ShaderVariant &variant);
+
+	/**
+	 * @return The base color texture of a material if it is sampled from its texture array, nullptr otherwise
+	 */
+	sg::Texture *get_array_texture(const sg::Material &material) const;
+
+	/**
+	 * @brief Replaces the material texture defines of a variant by the SPECIALIZED_MATERIAL define, with specialized materials
+	 */
+	void add_specialized_material_definitions(ShaderVariant &variant);
+
+	/**
+	 * @brief Creates the uber variant drawn in place of a variant while its pipeline compiles, with uber shader fallbacks
+	 */
+	void add_uber_variant(const ShaderVariant &variant);
+
+	/**
+	 * @brief Makes the global uniform of a shader module dynamic, and pushed with push descriptors
+	 */
+	void set_global_uniform_mode(ShaderModule &shader_module);
+
+	/**
+	 * @brief Binds the uber variant of a submesh variant instead if the pipeline of the variant is still compiling
+	 *        It is called after bind_submesh() with the same arguments
+	 */
+	void bind_uber_fallback(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, const ShaderVariant &shader_variant, BufferAllocation *instance_buffer);
+
+	/**
+	 * @brief Uploads the bounds of the meshlets of the scene for the meshlet culling shader, when GPU driven
+	 */
+	void prepare_meshlets();
+
+	/**
+	 * @brief Adds the bindless texture definitions to a variant if bindless textures are enabled
 	 */
-	void get_sorted_nodes(std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes,
-	                      std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes);
+	void add_bindless_definitions(ShaderVariant &variant);
 
 	sg::Camera &camera;
 
@@ -106,8 +627,598 @@ class GeometrySubpass : public Subpass
 
 	sg::Scene &scene;
 
+	/// Sorted draws of the current frame, its storage is reused across frames
+	DrawList draw_list;
+
   private:
-	void draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh);
+	/**
+	 * @brief Opaque draws of a submesh which can be recorded with a single instanced draw
+	 */
+	struct InstanceGroup
+	{
+		sg::SubMesh *sub_mesh;
+
+		VkFrontFace front_face;
+
+		uint32_t lod;
+
+		/// First node of the group in instance_nodes
+		size_t first;
+
+		size_t count;
+	};
+
+	/**
+	 * @brief Vertex input of a submesh for a pipeline layout, built on the first draw
+	 *        so later draws do not match the shader inputs against the submesh attributes
+	 */
+	struct VertexInput
+	{
+		/// Attributes and bindings, including the per instance ones for instanced draws
+		VertexInputState state;
+
+		/// Vertex buffer bound at each attribute location found in the submesh
+		struct Binding
+		{
+			uint32_t location;
+
+			VkBuffer buffer;
+
+			VkDeviceSize offset;
+		};
+
+		std::vector<Binding> bindings;
+
+		/// Location of the instance_model input, only used by instanced draws
+		uint32_t instance_location{0};
+	};
+
+	/**
+	 * @brief Returns the vertex input of a submesh for the given pipeline layout, building it if needed
+	 * @param instanced Whether the per instance model matrix input is added
+	 */
+	const VertexInput &request_vertex_input(sg::SubMesh &sub_mesh, const PipelineLayout &pipeline_layout, bool instanced);
+
+	/**
+	 * @brief Resources of a submesh shader variant, resolved once so that its draws do not look them up
+	 */
+	struct MaterialBinding
+	{
+		/// Identifier of the variant when it was resolved
+		size_t variant_id{0};
+
+		PipelineLayout *pipeline_layout{nullptr};
+
+		/// Push constants of the material, a PBRMaterialUniform, BindlessMaterialUniform or TextureArrayMaterialUniform
+		std::vector<uint8_t> material_uniform;
+
+		/// Binding of each material texture, empty with bindless textures
+		std::vector<std::pair<uint32_t, sg::Texture *>> textures;
+
+		/// Binding of each material texture sampled from its texture array instead of its image, with texture arrays
+		std::vector<std::pair<uint32_t, sg::Texture *>> array_textures;
+
+		/// Identifier and value of the specialization constants selecting the material textures, with specialized materials
+		std::vector<std::pair<uint32_t, bool>> specialization_constants;
+	};
+
+	/**
+	 * @brief Requests the resources the draws of a submesh variant bind
+	 * @param depth_only Whether the variant only has a vertex shader
+	 */
+	MaterialBinding compile_material(sg::SubMesh &sub_mesh, const ShaderVariant &shader_variant, bool depth_only);
+
+	/**
+	 * @brief Requests the resources the draws of the uber variant of a submesh bind, with the mask of its material textures
+	 */
+	MaterialBinding compile_uber_material(sg::SubMesh &sub_mesh, const ShaderVariant &uber_variant);
+
+	/**
+	 * @return The resources resolved for a submesh variant, or the ones requested into scratch if it was not resolved
+	 */
+	const MaterialBinding &get_material_binding(sg::SubMesh &sub_mesh, const ShaderVariant &shader_variant, bool depth_only, MaterialBinding &scratch);
+
+	/**
+	 * @brief Binds the global uniform with the given model matrix
+	 * @param node Node the model matrix is the world matrix of, tracked when recording a cached command buffer
+	 */
+	void update_global_uniform(CommandBuffer &command_buffer, const glm::mat4 &model, size_t thread_index, sg::Node *node = nullptr);
+
+	/**
+	 * @return Whether the submesh drawn by a node is drawn by the GPU driven path
+	 */
+	bool is_indirect_draw(sg::Node &node, const sg::SubMesh &sub_mesh) const;
+
+	/**
+	 * @brief Writes the joint matrices of a skinned node into a buffer of the frame, bound by update_uniform()
+	 */
+	void allocate_joint_buffer(sg::Node &node);
+
+	/**
+	 * @brief Records the GPU driven draws, using the commands written by pre_draw()
+	 */
+	void record_indirect_draws(CommandBuffer &command_buffer, size_t thread_index = 0);
+
+	/**
+	 * @brief Sets the vertex input state of a submesh and binds its vertex buffers, and the instance buffer if given
+	 */
+	void bind_vertex_input(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, const PipelineLayout &pipeline_layout, BufferAllocation *instance_buffer, VkDeviceSize instance_offset);
+
+	/**
+	 * @brief Sets the rasterization state, pipeline layout and vertex input of a submesh for the depth pre-pass
+	 */
+	void bind_depth_only_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, const ShaderVariant &shader_variant, BufferAllocation *instance_buffer);
+
+	/**
+	 * @return Shading rate of a submesh drawn at a level of detail
+	 */
+	VkExtent2D get_draw_shading_rate(const sg::SubMesh &sub_mesh, uint32_t lod) const;
+
+	/**
+	 * @brief Selects the level of detail of a submesh from the error it would show on screen
+	 *        A level is kept until its error crosses the threshold by a margin, so that nodes moving
+	 *        around the threshold do not switch back and forth between two levels every frame
+	 * @param pixels_per_unit Size in pixels of a unit of the submesh positions at the distance of the node
+	 */
+	uint32_t select_lod(sg::Node &node, size_t sub_mesh_index, const sg::SubMesh &sub_mesh, float pixels_per_unit);
+
+	/**
+	 * @return Whether the submesh depth is written by the depth pre-pass
+	 */
+	bool is_depth_prepass_draw(const sg::SubMesh &sub_mesh) const;
+
+	/**
+	 * @return The variant drawing a submesh in the depth pre-pass, or nullptr if the subpass did not prepare one
+	 */
+	const ShaderVariant *get_depth_only_variant(const sg::SubMesh &sub_mesh) const;
+
+	/**
+	 * @return The depth stencil state an opaque submesh is shaded with
+	 */
+	DepthStencilState get_opaque_depth_stencil_state(const sg::SubMesh &sub_mesh);
+
+	/**
+	 * @brief Records the depth of the opaque units of work in the range [batch_start, batch_end)
+	 */
+	void record_depth_prepass(CommandBuffer &command_buffer, size_t batch_start, size_t batch_end, size_t thread_index = 0);
+
+	/**
+	 * @brief Reads back the occlusion queries of the active frame and resets them for this frame
+	 */
+	void prepare_occlusion_queries(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Tests the bounding boxes of the nodes in the frustum against the depth of the opaque draws
+	 */
+	void record_occlusion_queries(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Allocates the instance buffer of an instance group and writes the model matrices of its nodes
+	 */
+	BufferAllocation allocate_instance_buffer(const InstanceGroup &group, size_t thread_index);
+
+	/**
+	 * @brief Groups the opaque draws of the draw list by submesh and front face, keeping the order of their first draw
+	 */
+	void build_instance_groups();
+
+	/**
+	 * @brief Records the instance groups in the range [group_start, group_end)
+	 */
+	void record_instanced_draws(CommandBuffer &command_buffer, size_t group_start, size_t group_end, size_t thread_index = 0);
+
+	/**
+	 * @return Number of opaque units of work, either draws or instance groups
+	 */
+	size_t get_opaque_batch_count() const;
+
+	/**
+	 * @brief Records the opaque units of work in the range [batch_start, batch_end)
+	 */
+	void record_opaque_batches(CommandBuffer &command_buffer, size_t batch_start, size_t batch_end, size_t thread_index = 0);
+
+	struct CullingChunk;
+
+	/**
+	 * @brief Adds the submeshes of a mesh placed by one of its nodes to the draw list of a chunk,
+	 *        called concurrently for the nodes of different chunks
+	 */
+	void add_draws(CullingChunk &chunk, sg::Mesh &mesh, size_t node_index, const glm::vec3 &camera_position);
+
+	/**
+	 * @brief Requests from the texture streamer the mip levels of the material textures for a node
+	 * @param projected_size Size in pixels of the node bounds on screen
+	 */
+	void request_texture_levels(const sg::Material &material, float projected_size);
+
+	/**
+	 * @brief Records the opaque draws in the range [draw_start, draw_end) of the draw list
+	 */
+	void record_opaque_draws(CommandBuffer &command_buffer, size_t draw_start, size_t draw_end, size_t thread_index = 0);
+
+	/**
+	 * @brief Records the transparent draws of the sorted nodes in back-to-front order
+	 */
+	void record_transparent_draws(CommandBuffer &command_buffer, size_t thread_index = 0);
+
+	/**
+	 * @brief Requests and begins a secondary command buffer inheriting from the primary one
+	 *        The secondary command buffer is ready to record draws for this subpass
+	 */
+	CommandBuffer &begin_secondary_command_buffer(CommandBuffer &primary_command_buffer, size_t thread_index);
+
+	/**
+	 * @brief Begins a secondary command buffer inheriting from the primary one, ready to record draws for this subpass
+	 */
+	void begin_secondary(CommandBuffer &secondary_command_buffer, CommandBuffer &primary_command_buffer, VkCommandBufferUsageFlags flags);
+
+	/**
+	 * @brief Records the sorted draws into secondary command buffers using the worker threads
+	 */
+	void draw_secondary(CommandBuffer &primary_command_buffer);
+
+	/**
+	 * @brief Buffer written with the world matrices of nodes, which a cached command buffer reads
+	 */
+	struct CachedAllocation
+	{
+		BufferAllocation allocation;
+
+		/// Nodes written in the buffer, in order, a single one for a global uniform
+		std::vector<sg::Node *> nodes;
+
+		/// World matrix revision of each node when it was written
+		std::vector<uint32_t> revisions;
+
+		/// Whether the buffer is a global uniform, otherwise it holds instance matrices
+		bool global_uniform;
+	};
+
+	/**
+	 * @brief Secondary command buffer of an opaque chunk kept across frames
+	 */
+	struct CachedCommandBuffer
+	{
+		/// Persistent command buffer of each recording thread, requested on first use
+		std::vector<CommandBuffer *> command_buffers;
+
+		/// Command buffer holding the last recording, null if it must be recorded again
+		CommandBuffer *recorded{nullptr};
+
+		/// Signature of the draws of the last recording
+		std::size_t signature{0};
+
+		/// Buffers read by the recording, which must outlive the resets of the render frame
+		std::unique_ptr<BufferPool> uniform_pool;
+
+		BufferBlock *uniform_block{nullptr};
+
+		std::unique_ptr<BufferPool> instance_pool;
+
+		BufferBlock *instance_block{nullptr};
+
+		std::vector<CachedAllocation> allocations;
+
+		/// Camera the global uniforms were written with
+		glm::mat4 camera_view_proj{1.0f};
+
+		glm::vec3 camera_position{0.0f};
+
+		/// Matrices of the views the global uniforms were written with
+		std::vector<glm::mat4> view_projs;
+
+		/// View uniform read by the recording, with view uniforms
+		BufferAllocation view_allocation;
+	};
+
+	/**
+	 * @return The signature of the opaque units of work in the range [batch_start, batch_end), or 0
+	 *         if their command buffer cannot be cached
+	 */
+	std::size_t get_chunk_signature(CommandBuffer &primary_command_buffer, size_t batch_start, size_t batch_end, bool depth_only);
+
+	/**
+	 * @brief Resets a cached command buffer and begins its persistent command buffer for the recording thread
+	 */
+	CommandBuffer &begin_cached_command_buffer(CommandBuffer &primary_command_buffer, CachedCommandBuffer &cache, size_t thread_index);
+
+	/**
+	 * @brief Rewrites the buffers of a cached command buffer whose nodes or camera moved since they were written
+	 */
+	void update_cached_allocations(CachedCommandBuffer &cache);
+
+	/**
+	 * @return The view projection matrix of every camera rendered with multiview
+	 */
+	std::vector<glm::mat4> get_view_projections() const;
+
+	/**
+	 * @brief Computes the matrices of the camera and of the views for all the draws of the frame,
+	 *        and writes the view uniform of the frame with view uniforms
+	 *        It is called at the start of draw()
+	 */
+	void update_view();
+
+	/**
+	 * @brief Writes the global uniform of a draw with the view of the frame, or only the model matrix with view uniforms
+	 *        The matrices of the views follow the view data with multiview.
+	 */
+	void write_global_uniform(BufferAllocation &allocation, const glm::mat4 &model) const;
+
+	/**
+	 * @brief Writes the view uniform with the view of the frame, followed by the matrices of the views with multiview
+	 */
+	void write_view_uniform(BufferAllocation &allocation) const;
+
+	/**
+	 * @return The size of the global uniform of a draw
+	 */
+	VkDeviceSize get_global_uniform_size() const;
+
+	/**
+	 * @brief Binds the view uniform of the frame, or the one of the cached command buffer being recorded
+	 */
+	void bind_view_uniform(CommandBuffer &command_buffer, CachedCommandBuffer *cache, size_t thread_index);
+
+	/**
+	 * @brief Allocates a buffer read by a draw, from the cached command buffer being recorded by the thread if any
+	 */
+	BufferAllocation allocate_draw_buffer(VkBufferUsageFlags usage, VkDeviceSize size, size_t thread_index);
+
+	uint32_t thread_count{1};
+
+	bool culling_enabled{true};
+
+	uint32_t culled_draw_count{0};
+
+	Stats *stats{nullptr};
+
+	/// Items found visible by the scene hierarchy, its storage is reused across frames
+	std::vector<sg::BVHItem> visible_items;
+
+	/// Shader variants of the submeshes with the definitions of the subpass, copied from the submeshes shared with other subpasses
+	std::unordered_map<const sg::SubMesh *, ShaderVariant> variants;
+
+	bool instancing_enabled{false};
+
+	/// Shader variants of the submeshes with INSTANCING defined
+	std::unordered_map<const sg::SubMesh *, ShaderVariant> instanced_variants;
+
+	/// Instance groups of the current frame, in front-to-back order of their first draw
+	std::vector<InstanceGroup> instance_groups;
+
+	/// Nodes of the instance groups, stored contiguously for each group
+	std::vector<sg::Node *> instance_nodes;
+
+	/// Index of the instance group of each submesh, for each level of detail and both front faces
+	std::unordered_map<const sg::SubMesh *, std::vector<size_t>> instance_group_lookup;
+
+	/**
+	 * @brief Opaque indexed draw recorded with an indirect command
+	 */
+	struct IndirectDraw
+	{
+		sg::Node *node;
+
+		sg::SubMesh *sub_mesh;
+
+		/// Index of the model matrix of the node in the transform buffer
+		uint32_t transform_index;
+
+		/// Indirect commands of the draw, one per meshlet for submeshes split into meshlets
+		uint32_t first_command;
+
+		uint32_t command_count;
+	};
+
+	bool gpu_driven{false};
+
+	std::unique_ptr<ShaderSource> culling_shader;
+
+	std::unique_ptr<ShaderSource> meshlet_culling_shader;
+
+	/// Bounds of the meshlets of all the scene submeshes, which do not change between frames
+	std::unique_ptr<core::Buffer> meshlet_buffer;
+
+	/// Index of the first meshlet of each submesh in meshlet_buffer
+	std::unordered_map<const sg::SubMesh *, uint32_t> meshlet_offsets;
+
+	/// GPU driven draws of the current frame, in the order of their indirect commands
+	std::vector<IndirectDraw> indirect_draws;
+
+	/// Model matrices of the GPU driven draws
+	BufferAllocation transform_buffer;
+
+	/// Indirect commands written by the culling shader, one buffer per render frame
+	std::vector<std::unique_ptr<core::Buffer>> indirect_buffers;
+
+	core::Buffer *indirect_buffer{nullptr};
+
+	bool bindless_textures_enabled{false};
+
+	bool specialized_materials_enabled{false};
+
+	bool uber_shader_fallback_enabled{false};
+
+	/// Texture bound to the samplers of the textures a material lacks, with specialized materials and uber shader fallbacks
+	sg::Texture *fallback_material_texture{nullptr};
+
+	/// Uber variant of each submesh variant, drawn while the pipeline of the variant compiles
+	std::unordered_map<const ShaderVariant *, ShaderVariant> uber_variants;
+
+	/// Textures of the scene, in the order of the bindless texture array
+	std::vector<sg::Texture *> bindless_textures;
+
+	/// Index of each texture in the bindless texture array
+	std::unordered_map<const sg::Texture *, uint32_t> bindless_texture_indices;
+
+	/**
+	 * @return The index of a material texture in the bindless texture array, 0 if the material has none
+	 */
+	uint32_t get_bindless_texture_index(const sg::Material &material, const std::string &name) const;
+
+	bool texture_arrays_enabled{false};
+
+	bool depth_prepass_enabled{false};
+
+	/// Shader variants of the submeshes with DEPTH_ONLY defined
+	std::unordered_map<const sg::SubMesh *, ShaderVariant> depth_only_variants;
+
+	/// Shader variants of the submeshes with DEPTH_ONLY and INSTANCING defined
+	std::unordered_map<const sg::SubMesh *, ShaderVariant> depth_only_instanced_variants;
+
+	bool occlusion_culling_enabled{false};
+
+	uint32_t occluded_draw_count{0};
+
+	std::unique_ptr<ShaderSource> occlusion_shader;
+
+	/// Each node of the scene has its own query, the nodes of a mesh follow its offset
+	std::unordered_map<const sg::Mesh *, uint32_t> occlusion_query_offsets;
+
+	uint32_t occlusion_query_count{0};
+
+	/// Whether the box of each node was hidden when it was last tested
+	std::vector<bool> occluded_nodes;
+
+	/**
+	 * @brief Node in the frustum whose bounding box is tested
+	 */
+	struct OcclusionCandidate
+	{
+		sg::Mesh *mesh;
+
+		size_t node_index;
+
+		uint32_t query;
+	};
+
+	/// Nodes in the frustum of the current frame
+	std::vector<OcclusionCandidate> occlusion_candidates;
+
+	/**
+	 * @brief Output of culling a range of nodes, merged in the order of the ranges so that
+	 *        the draw list is the same whatever the number of threads culling the nodes
+	 */
+	struct CullingChunk
+	{
+		DrawList draws;
+
+		std::vector<OcclusionCandidate> occlusion_candidates;
+
+		/// Skinned nodes drawn, whose joint buffers are allocated after the merge
+		std::vector<sg::Node *> skinned_nodes;
+
+		/// Mip levels the materials drawn need, requested from the texture streamer after the merge
+		std::vector<std::pair<const sg::Material *, float>> texture_requests;
+
+		uint32_t culled_draw_count{0};
+
+		uint32_t occluded_draw_count{0};
+	};
+
+	/// Nodes culled by each task of the parallel culling, fewer nodes are culled on the calling thread
+	static constexpr size_t CULLING_CHUNK_SIZE = 256;
+
+	/// Nodes to cull in the current frame, all those of the scene unless the hierarchy already culled them
+	std::vector<sg::BVHItem> culling_items;
+
+	/// Storage reused across frames
+	std::vector<CullingChunk> culling_chunks;
+
+	/// Guards the levels of detail, whose map gains entries for the nodes seen for the first time
+	std::mutex lod_mutex;
+
+	/// Joint matrices of the skinned nodes drawn in the current frame
+	std::unordered_map<const sg::Node *, BufferAllocation> joint_buffers;
+
+	/**
+	 * @brief Occlusion queries of a render frame
+	 */
+	struct OcclusionQueries
+	{
+		std::unique_ptr<core::QueryPool> query_pool;
+
+		/// Queries recorded the last time the frame was used
+		std::vector<uint32_t> queries;
+	};
+
+	/// Occlusion queries of each render frame
+	std::vector<OcclusionQueries> occlusion_queries;
+
+	/// Queries of the active frame, only set between pre_draw() and the end of draw()
+	OcclusionQueries *active_occlusion_queries{nullptr};
+
+	/// Vertex inputs of the submeshes, keyed by submesh, pipeline layout and instancing
+	std::unordered_map<std::size_t, VertexInput> vertex_inputs;
+
+	/// Guards vertex_inputs, as draws are recorded by the worker threads
+	std::mutex vertex_input_mutex;
+
+	/// Pipeline and material identifiers of the scene submeshes, used to group draws in the sort keys
+	std::unordered_map<const sg::SubMesh *, uint32_t> sort_state_ids;
+
+	/// Level of detail from which draws are shaded at the coarse rate
+	uint32_t coarse_shading_lod{~0U};
+
+	VkExtent2D coarse_shading_rate{2, 2};
+
+	std::unordered_map<const sg::Material *, VkExtent2D> material_shading_rates;
+
+	/// Camera of each view rendered with multiview, empty without multiview
+	std::vector<sg::Camera *> view_cameras;
+
+	bool view_uniform_enabled{false};
+
+	bool partitioned_descriptor_sets_enabled{false};
+
+	bool push_descriptors_enabled{false};
+
+	/// View projection and position of the camera, computed once per frame for all the draws
+	glm::mat4 frame_view_proj{1.0f};
+
+	glm::vec3 frame_camera_position{0.0f};
+
+	/// Matrices of the views of the frame, empty without multiview
+	std::vector<glm::mat4> frame_view_projs;
+
+	/// View uniform of the frame, with view uniforms
+	BufferAllocation view_allocation;
+
+	TextureStreamer *texture_streamer{nullptr};
+
+	/// Screen height in pixels of an object of unit size at unit distance, updated every frame
+	float texture_projection_scale{0.0f};
+
+	/// Level of detail last selected for the submeshes of each node, indexed like the submeshes of its mesh
+	std::unordered_map<const sg::Node *, std::vector<uint32_t>> lod_levels;
+
+	bool command_buffer_caching{false};
+
+	uint32_t replayed_command_buffer_count{0};
+
+	/// Cached command buffers of each render frame, the depth pre-pass chunks followed by the opaque chunks
+	std::vector<std::vector<CachedCommandBuffer>> cached_command_buffers;
+
+	/// Cached command buffer each thread is recording, which the buffers of its draws are allocated from
+	std::vector<CachedCommandBuffer *> recording_caches;
+
+	/// Resolved resources of the shader variants, keyed by variant as each submesh has its own ones
+	std::unordered_map<const ShaderVariant *, MaterialBinding> material_bindings;
+
+	bool materials_compiled{false};
+
+	/// Generation of the resource cache the materials were resolved with
+	uint32_t materials_generation{0};
+
+	/// CPU time of the last draw spent culling and sorting the nodes, in milliseconds
+	double culling_time{0.0};
+
+	/// CPU time of the last draw spent recording, in milliseconds
+	double recording_time{0.0};
+
+	/// CPU time of the last draw spent by each recording thread, in milliseconds
+	std::vector<double> thread_recording_times;
 };
 
 }        // namespace vkb
@@ -23,6 +23,7 @@
 #include "buffer_pool.h"
 #include "rendering/render_context.h"
 #include "scene_graph/components/camera.h"
+#include "scene_graph/components/perspective_camera.h"
 #include "scene_graph/scene.h"
 
 namespace vkb
@@ -36,6 +37,21 @@ LightingSubpass::LightingSubpass(RenderContext &render_context, ShaderSource &&v
 
 void LightingSubpass::prepare()
 {
+	if (tiled_lighting || scene.get_components<sg::Light>().size() > MAX_DEFERRED_LIGHT_COUNT)
+	{
+		tile_camera    = dynamic_cast<sg::PerspectiveCamera *>(&camera);
+		tiled_lighting = tile_camera != nullptr;
+
+		if (tiled_lighting)
+		{
+			add_definitions(lighting_variant, {"TILED_LIGHTING"});
+		}
+		else
+		{
+			LOGW("Tiled lighting requires a perspective camera, lights are limited to {}", MAX_DEFERRED_LIGHT_COUNT);
+		}
+	}
+
 	add_definitions(lighting_variant, {"MAX_DEFERRED_LIGHT_COUNT " + std::to_string(MAX_DEFERRED_LIGHT_COUNT)});
 	add_definitions(lighting_variant, light_type_definitions);
 	// Build all shaders upfront
@@ -46,8 +62,15 @@ void LightingSubpass::prepare()
 
 void LightingSubpass::draw(CommandBuffer &command_buffer)
 {
-	auto light_buffer = allocate_lights<DeferredLights>(scene.get_components<sg::Light>(), MAX_DEFERRED_LIGHT_COUNT);
-	command_buffer.bind_buffer(light_buffer.get_buffer(), light_buffer.get_offset(), light_buffer.get_size(), 0, 4, 0);
+	if (tiled_lighting)
+	{
+		bind_tiled_lights(command_buffer);
+	}
+	else
+	{
+		auto light_buffer = allocate_lights<DeferredLights>(scene.get_components<sg::Light>(), MAX_DEFERRED_LIGHT_COUNT);
+		command_buffer.bind_buffer(light_buffer.get_buffer(), light_buffer.get_offset(), light_buffer.get_size(), 0, 4, 0);
+	}
 
 	// Get shaders from cache
 	auto &resource_cache     = command_buffer.get_device().get_resource_cache();
@@ -91,11 +114,41 @@ void LightingSubpass::draw(CommandBuffer &command_buffer)
 
 	// Allocate a buffer using the buffer pool from the active frame to store uniform values and bind it
 	auto &render_frame = get_render_context().get_active_frame();
-	auto  allocation   = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(LightUniform));
+	auto  allocation   = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(LightUniform), get_recording_thread_index());
 	allocation.update(light_uniform);
 	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 3, 0);
 
 	// Draw full screen triangle triangle
 	command_buffer.draw(3, 1, 0, 0);
 }
+
+void LightingSubpass::set_tiled_lighting(bool enable)
+{
+	tiled_lighting = enable;
+}
+
+bool LightingSubpass::is_tiled_lighting() const
+{
+	return tiled_lighting;
+}
+
+void LightingSubpass::bind_tiled_lights(CommandBuffer &command_buffer)
+{
+	auto &render_frame = get_render_context().get_active_frame();
+
+	light_tiles.update(scene.get_components<sg::Light>(), *tile_camera, render_frame.get_render_target().get_extent());
+
+	auto tile_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(ClusterUniform), get_recording_thread_index());
+	tile_buffer.update(light_tiles.get_uniform());
+	command_buffer.bind_buffer(tile_buffer.get_buffer(), tile_buffer.get_offset(), tile_buffer.get_size(), 0, 4, 0);
+
+	auto lights_buffer = allocate_storage(light_tiles.get_lights());
+	command_buffer.bind_buffer(lights_buffer.get_buffer(), lights_buffer.get_offset(), lights_buffer.get_size(), 0, 6, 0);
+
+	auto ranges_buffer = allocate_storage(light_tiles.get_cluster_ranges());
+	command_buffer.bind_buffer(ranges_buffer.get_buffer(), ranges_buffer.get_offset(), ranges_buffer.get_size(), 0, 7, 0);
+
+	auto indices_buffer = allocate_storage(light_tiles.get_light_indices());
+	command_buffer.bind_buffer(indices_buffer.get_buffer(), indices_buffer.get_offset(), indices_buffer.get_size(), 0, 8, 0);
+}
 }        // namespace vkb
\ No newline at end of file
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "buffer_pool.h"
+#include "rendering/light_clusters.h"
 #include "rendering/subpass.h"
 
 VKBP_DISABLE_WARNINGS()
@@ -35,6 +36,7 @@ namespace sg
 {
 class Camera;
 class Light;
+class PerspectiveCamera;
 class Scene;
 }        // namespace sg
 
@@ -67,12 +69,34 @@ class LightingSubpass : public Subpass
 
 	void draw(CommandBuffer &command_buffer) override;
 
+	/**
+	 * @brief Culls the point lights against screen tiles, so that each pixel only evaluates
+	 *        the lights reaching its tile and the scene is not limited to MAX_DEFERRED_LIGHT_COUNT.
+	 *        Enabled automatically when the scene has more lights than that.
+	 *        Requires a perspective camera and must be set before the subpass is prepared.
+	 */
+	void set_tiled_lighting(bool enable);
+
+	bool is_tiled_lighting() const;
+
   private:
+	/**
+	 * @brief Bins the lights into tiles and binds the resulting buffers
+	 */
+	void bind_tiled_lights(CommandBuffer &command_buffer);
+
 	sg::Camera &camera;
 
 	sg::Scene &scene;
 
 	ShaderVariant lighting_variant;
+
+	bool tiled_lighting{false};
+
+	sg::PerspectiveCamera *tile_camera{nullptr};
+
+	/// Single depth slice tiles, matching the distance scale lighting.frag attenuates with
+	LightClusters light_tiles{{16, 9, 1}, 0.005f};
 };
 
 }        // namespace vkb
@@ -0,0 +1,45 @@
+/* Generated by shader_precompiler from the layout_header of shaders/precompile.json, do not edit */
+
+#pragma once
+
+#include <cstdint>
+
+namespace vkb
+{
+namespace shader_layout
+{
+constexpr uint32_t GlobalUniform_binding = 1;
+constexpr uint32_t GlobalUniform_set = 0;
+constexpr uint32_t LightsInfo_binding = 4;
+constexpr uint32_t LightsInfo_set = 0;
+constexpr uint32_t base_color_texture_binding = 0;
+constexpr uint32_t base_color_texture_set = 0;
+constexpr uint32_t instance_model_location = 3;
+constexpr uint32_t normal_location = 2;
+constexpr uint32_t position_location = 0;
+constexpr uint32_t texcoord_0_location = 1;
+
+namespace GlobalUniform
+{
+constexpr uint32_t camera_position_offset = 128;
+constexpr uint32_t model_offset = 0;
+constexpr uint32_t size = 140;
+constexpr uint32_t view_proj_offset = 64;
+}        // namespace GlobalUniform
+
+namespace LightsInfo
+{
+constexpr uint32_t count_offset = 0;
+constexpr uint32_t light_offset = 16;
+constexpr uint32_t size = 1040;
+}        // namespace LightsInfo
+
+namespace PBRMaterialUniform
+{
+constexpr uint32_t base_color_factor_offset = 0;
+constexpr uint32_t metallic_factor_offset = 16;
+constexpr uint32_t roughness_factor_offset = 20;
+constexpr uint32_t size = 24;
+}        // namespace PBRMaterialUniform
+}        // namespace shader_layout
+}        // namespace vkb
@@ -0,0 +1,167 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "rendering/subpasses/shadow_subpass.h"
+
+#include "common/utils.h"
+#include "common/vk_common.h"
+#include "rendering/cascaded_shadow_map.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/material.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace
+{
+/// Depth bias pushing the casters away from the light, negative as depth is reversed
+constexpr float SHADOW_DEPTH_BIAS_CONSTANT = -1.25f;
+
+constexpr float SHADOW_DEPTH_BIAS_SLOPE = -1.75f;
+}        // namespace
+
+ShadowSubpass::ShadowSubpass(RenderContext &render_context, CascadedShadowMap &shadow_map) :
+    Subpass{render_context, ShaderSource{"shadow.vert"}, ShaderSource{}},
+    shadow_map{shadow_map}
+{
+	set_debug_name("Shadow");
+
+	// The atlas is the depth attachment of the subpass, it has no color output
+	set_output_attachments({});
+}
+
+void ShadowSubpass::prepare()
+{
+	render_context.get_device().get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader());
+}
+
+void ShadowSubpass::draw(CommandBuffer &command_buffer)
+{
+	auto &resource_cache  = render_context.get_device().get_resource_cache();
+	auto &vert_module     = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader());
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&vert_module}, false);
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	command_buffer.set_color_blend_state({});
+
+	command_buffer.set_depth_stencil_state(get_depth_stencil_state());
+
+	command_buffer.set_depth_bias(SHADOW_DEPTH_BIAS_CONSTANT, 0.0f, SHADOW_DEPTH_BIAS_SLOPE);
+
+	uint32_t resolution = shadow_map.get_resolution();
+
+	auto &cascades = shadow_map.get_cascades();
+
+	for (uint32_t i = 0; i < to_u32(cascades.size()); ++i)
+	{
+		auto &cascade = cascades[i];
+
+		if (!cascade.dirty)
+		{
+			continue;
+		}
+
+		VkRect2D tile{};
+		tile.offset = {static_cast<int32_t>(i * resolution), 0};
+		tile.extent = {resolution, resolution};
+
+		VkViewport viewport{};
+		viewport.x        = static_cast<float>(tile.offset.x);
+		viewport.width    = static_cast<float>(resolution);
+		viewport.height   = static_cast<float>(resolution);
+		viewport.maxDepth = 1.0f;
+
+		command_buffer.set_viewport(0, {viewport});
+		command_buffer.set_scissor(0, {tile});
+
+		VkClearAttachment clear_attachment{};
+		clear_attachment.aspectMask              = VK_IMAGE_ASPECT_DEPTH_BIT;
+		clear_attachment.clearValue.depthStencil = {0.0f, ~0U};
+
+		VkClearRect clear_rect{};
+		clear_rect.rect       = tile;
+		clear_rect.layerCount = 1;
+
+		command_buffer.clear(clear_attachment, clear_rect);
+
+		for (auto &caster : cascade.casters)
+		{
+			auto &node = *caster.mesh->get_nodes()[caster.node_index];
+
+			ShadowCasterUniform caster_uniform{};
+			caster_uniform.model_view_proj = cascade.view_proj * node.get_transform().get_world_matrix();
+
+			command_buffer.push_constants(0, caster_uniform);
+
+			const auto &scale   = node.get_transform().get_scale();
+			bool        flipped = scale.x * scale.y * scale.z < 0;
+
+			for (auto sub_mesh : caster.mesh->get_submeshes())
+			{
+				auto material = sub_mesh->get_material();
+
+				sg::VertexAttribute position;
+
+				if (material->alpha_mode == sg::AlphaMode::Blend || !sub_mesh->get_attribute("position", position))
+				{
+					continue;
+				}
+
+				RasterizationState rasterization_state{};
+				rasterization_state.front_face        = flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+				rasterization_state.depth_bias_enable = VK_TRUE;
+
+				if (material->double_sided)
+				{
+					rasterization_state.cull_mode = VK_CULL_MODE_NONE;
+				}
+
+				command_buffer.set_rasterization_state(rasterization_state);
+
+				VertexInputState vertex_input_state{};
+				vertex_input_state.bindings.push_back({0, position.stride, VK_VERTEX_INPUT_RATE_VERTEX});
+				vertex_input_state.attributes.push_back({0, 0, position.format, position.offset});
+
+				command_buffer.set_vertex_input_state(vertex_input_state);
+
+				// With interleaved vertices, the positions are the only stream fetched
+				auto vertex_buffer = sub_mesh->find_vertex_buffer("position");
+
+				command_buffer.bind_vertex_buffer(0, vertex_buffer->get_buffer(), vertex_buffer->get_offset());
+
+				if (sub_mesh->vertex_indices != 0)
+				{
+					command_buffer.bind_index_buffer(sub_mesh->get_index_buffer().get_buffer(), 0, sub_mesh->index_type);
+
+					command_buffer.draw_indexed(sub_mesh->get_vertex_indices(), 1, sub_mesh->get_first_index(), 0, 0);
+				}
+				else
+				{
+					command_buffer.draw(sub_mesh->vertices_count, 1, 0, 0);
+				}
+			}
+		}
+	}
+}
+}        // namespace vkb
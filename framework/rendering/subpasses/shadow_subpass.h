@@ -0,0 +1,59 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "rendering/subpass.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+class CascadedShadowMap;
+
+/**
+ * @brief Push constant structure for the shadow vertex shader
+ */
+struct ShadowCasterUniform
+{
+	glm::mat4 model_view_proj;
+};
+
+/**
+ * @brief Depth only subpass drawing the dirty cascades of a CascadedShadowMap
+ *        Each cascade is drawn to its tile of the atlas, with the casters found for it.
+ *        Only positions are fetched and no fragment shader runs: alpha masked materials cast
+ *        shadows as if they were opaque, and blended materials do not cast shadows.
+ */
+class ShadowSubpass : public Subpass
+{
+  public:
+	ShadowSubpass(RenderContext &render_context, CascadedShadowMap &shadow_map);
+
+	virtual void prepare() override;
+
+	virtual void draw(CommandBuffer &command_buffer) override;
+
+  private:
+	CascadedShadowMap &shadow_map;
+};
+}        // namespace vkb
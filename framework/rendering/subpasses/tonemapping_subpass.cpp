@@ -0,0 +1,137 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "rendering/subpasses/tonemapping_subpass.h"
+
+#include "rendering/bloom_pass.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+namespace
+{
+struct PostProcessingUniform
+{
+	glm::vec4 tint;
+
+	glm::vec4 grading;
+
+	VkExtent2D bloom_extent;
+
+	glm::vec2 bloom_scale;
+};
+}        // namespace
+
+TonemappingSubpass::TonemappingSubpass(RenderContext &render_context, ShaderSource &&vertex_shader, ShaderSource &&fragment_shader, uint32_t hdr_attachment) :
+    Subpass{render_context, std::move(vertex_shader), std::move(fragment_shader)},
+    hdr_attachment{hdr_attachment}
+{
+}
+
+void TonemappingSubpass::prepare()
+{
+	if (color_grading_enabled)
+	{
+		variant.add_define("COLOR_GRADING");
+	}
+
+	if (bloom_pass)
+	{
+		variant.add_define("BLOOM");
+	}
+
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+	resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
+	resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
+}
+
+void TonemappingSubpass::draw(CommandBuffer &command_buffer)
+{
+	auto &resource_cache     = command_buffer.get_device().get_resource_cache();
+	auto &vert_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
+	auto &frag_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
+
+	std::vector<ShaderModule *> shader_modules{&vert_shader_module, &frag_shader_module};
+
+	auto &pipeline_layout = resource_cache.request_pipeline_layout(shader_modules, use_dynamic_resources);
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	RasterizationState rasterization_state;
+	rasterization_state.cull_mode = VK_CULL_MODE_NONE;
+	command_buffer.set_rasterization_state(rasterization_state);
+
+	// Full screen pass, the depth attachment (if any) is not needed
+	DepthStencilState depth_stencil_state;
+	depth_stencil_state.depth_test_enable  = VK_FALSE;
+	depth_stencil_state.depth_write_enable = VK_FALSE;
+	command_buffer.set_depth_stencil_state(depth_stencil_state);
+
+	auto &render_target = render_context.get_active_frame().get_render_target();
+
+	command_buffer.bind_input(render_target.get_views().at(hdr_attachment), 0, 0, 0);
+
+	PostProcessingUniform uniform{};
+	uniform.tint    = {color_grading.tint, exposure};
+	uniform.grading = {color_grading.contrast, color_grading.saturation, bloom_intensity, 0.0f};
+
+	if (bloom_pass)
+	{
+		auto &bloom_buffer = bloom_pass->get_buffer();
+		command_buffer.bind_buffer(bloom_buffer, 0, bloom_buffer.get_size(), 0, 1, 0);
+
+		const auto &extent = render_target.get_extent();
+
+		uniform.bloom_extent = bloom_pass->get_extent();
+		uniform.bloom_scale  = {static_cast<float>(uniform.bloom_extent.width) / extent.width, static_cast<float>(uniform.bloom_extent.height) / extent.height};
+	}
+
+	command_buffer.push_constants(0, uniform);
+
+	// Draw full screen triangle
+	command_buffer.draw(3, 1, 0, 0);
+}
+
+void TonemappingSubpass::set_exposure(float exposure_)
+{
+	exposure = exposure_;
+}
+
+float TonemappingSubpass::get_exposure() const
+{
+	return exposure;
+}
+
+void TonemappingSubpass::set_color_grading(const ColorGrading &color_grading_)
+{
+	color_grading         = color_grading_;
+	color_grading_enabled = true;
+}
+
+void TonemappingSubpass::set_bloom(const BloomPass &bloom, float intensity)
+{
+	bloom_pass      = &bloom;
+	bloom_intensity = intensity;
+}
+
+void TonemappingSubpass::set_bloom_intensity(float intensity)
+{
+	bloom_intensity = intensity;
+}
+}        // namespace vkb
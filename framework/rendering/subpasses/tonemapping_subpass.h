@@ -0,0 +1,88 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "rendering/subpass.h"
+
+namespace vkb
+{
+class BloomPass;
+
+/**
+ * @brief Color adjustments applied to the HDR color before tonemapping
+ */
+struct ColorGrading
+{
+	glm::vec3 tint{1.0f};
+
+	/// Contrast around middle grey, 1 leaves the color unchanged
+	float contrast{1.0f};
+
+	/// 0 for grayscale, 1 leaves the color unchanged
+	float saturation{1.0f};
+};
+
+/**
+ * @brief Tonemaps an HDR color attachment, after optional bloom and color grading
+ *        The color is read per pixel as an input attachment, so when the subpass rendering it
+ *        belongs to the same render pass, the HDR color never leaves tile memory
+ */
+class TonemappingSubpass : public Subpass
+{
+  public:
+	TonemappingSubpass(RenderContext &render_context, ShaderSource &&vertex_shader, ShaderSource &&fragment_shader, uint32_t hdr_attachment);
+
+	virtual void prepare() override;
+
+	virtual void draw(CommandBuffer &command_buffer) override;
+
+	void set_exposure(float exposure);
+
+	float get_exposure() const;
+
+	/**
+	 * @brief Enables color grading, which must be done before the subpass is prepared
+	 */
+	void set_color_grading(const ColorGrading &color_grading);
+
+	/**
+	 * @brief Adds the bloom of a pass dispatched before the render pass, must be set before the subpass is prepared
+	 */
+	void set_bloom(const BloomPass &bloom_pass, float intensity);
+
+	void set_bloom_intensity(float intensity);
+
+  private:
+	uint32_t hdr_attachment;
+
+	float exposure{1.0f};
+
+	bool color_grading_enabled{false};
+
+	ColorGrading color_grading;
+
+	const BloomPass *bloom_pass{nullptr};
+
+	float bloom_intensity{0.0f};
+
+	ShaderVariant variant;
+};
+}        // namespace vkb
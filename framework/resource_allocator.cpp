@@ -0,0 +1,222 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "resource_allocator.h"
+
+#include <algorithm>
+
+#include "common/error.h"
+#include "core/device.h"
+
+namespace vkb
+{
+ResourceAllocator::ResourceAllocator(Device &device) :
+    device{device}
+{
+}
+
+ResourceAllocator::~ResourceAllocator()
+{
+	assert(alias_blocks.empty() && "Aliased resources should be destroyed before their allocator");
+
+	for (auto &block : alias_blocks)
+	{
+		vmaFreeMemory(device.get_memory_allocator(), block.allocation);
+		device.remove_memory_usage(block.category, block.size);
+	}
+}
+
+VmaAllocation ResourceAllocator::allocate(VkBuffer buffer, VmaMemoryUsage memory_usage, VmaAllocationCreateFlags flags, const AllocationHints &hints,
+                                          MemoryCategory category, VmaAllocationInfo &allocation_info)
+{
+	auto create_info = get_create_info(memory_usage, flags, hints);
+
+	VmaAllocation allocation{VK_NULL_HANDLE};
+
+	if (hints.alias_group.empty())
+	{
+		// VMA queries whether the driver prefers a dedicated allocation for the buffer
+		auto result = vmaAllocateMemoryForBuffer(device.get_memory_allocator(), buffer, &create_info, &allocation, &allocation_info);
+
+		if (result != VK_SUCCESS)
+		{
+			throw VulkanException{result, "Cannot allocate Buffer memory"};
+		}
+
+		device.add_memory_usage(category, allocation_info.size);
+	}
+	else
+	{
+		VkMemoryRequirements requirements{};
+		vkGetBufferMemoryRequirements(device.get_handle(), buffer, &requirements);
+
+		allocation = request_alias_block(hints, requirements, create_info, category, allocation_info);
+	}
+
+	auto result = vmaBindBufferMemory(device.get_memory_allocator(), allocation, buffer);
+
+	if (result != VK_SUCCESS)
+	{
+		free(allocation, category);
+		throw VulkanException{result, "Cannot bind Buffer memory"};
+	}
+
+	return allocation;
+}
+
+VmaAllocation ResourceAllocator::allocate(VkImage image, VmaMemoryUsage memory_usage, VmaAllocationCreateFlags flags, const AllocationHints &hints,
+                                          MemoryCategory category, VmaAllocationInfo &allocation_info)
+{
+	auto create_info = get_create_info(memory_usage, flags, hints);
+
+	VmaAllocation allocation{VK_NULL_HANDLE};
+
+	if (hints.alias_group.empty())
+	{
+		// VMA queries whether the driver prefers a dedicated allocation for the image
+		auto result = vmaAllocateMemoryForImage(device.get_memory_allocator(), image, &create_info, &allocation, &allocation_info);
+
+		if (result != VK_SUCCESS)
+		{
+			throw VulkanException{result, "Cannot allocate Image memory"};
+		}
+
+		device.add_memory_usage(category, allocation_info.size);
+	}
+	else
+	{
+		VkMemoryRequirements requirements{};
+		vkGetImageMemoryRequirements(device.get_handle(), image, &requirements);
+
+		allocation = request_alias_block(hints, requirements, create_info, category, allocation_info);
+	}
+
+	auto result = vmaBindImageMemory(device.get_memory_allocator(), allocation, image);
+
+	if (result != VK_SUCCESS)
+	{
+		free(allocation, category);
+		throw VulkanException{result, "Cannot bind Image memory"};
+	}
+
+	return allocation;
+}
+
+void ResourceAllocator::free(VmaAllocation allocation, MemoryCategory category)
+{
+	{
+		std::lock_guard<std::mutex> guard{alias_mutex};
+
+		auto it = std::find_if(alias_blocks.begin(), alias_blocks.end(), [allocation](const AliasBlock &block) { return block.allocation == allocation; });
+
+		if (it != alias_blocks.end())
+		{
+			if (--it->users == 0)
+			{
+				vmaFreeMemory(device.get_memory_allocator(), it->allocation);
+				device.remove_memory_usage(it->category, it->size);
+
+				alias_blocks.erase(it);
+			}
+
+			return;
+		}
+	}
+
+	VmaAllocationInfo allocation_info{};
+	vmaGetAllocationInfo(device.get_memory_allocator(), allocation, &allocation_info);
+
+	vmaFreeMemory(device.get_memory_allocator(), allocation);
+	device.remove_memory_usage(category, allocation_info.size);
+}
+
+VkDeviceSize ResourceAllocator::get_aliased_size() const
+{
+	std::lock_guard<std::mutex> guard{alias_mutex};
+
+	VkDeviceSize size{0};
+
+	for (auto &block : alias_blocks)
+	{
+		size += block.size;
+	}
+
+	return size;
+}
+
+VmaAllocationCreateInfo ResourceAllocator::get_create_info(VmaMemoryUsage memory_usage, VmaAllocationCreateFlags flags, const AllocationHints &hints) const
+{
+	VmaAllocationCreateInfo create_info{};
+	create_info.usage = memory_usage;
+	create_info.flags = flags;
+
+	if (hints.dedicated)
+	{
+		create_info.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+	}
+
+	// On tile-based GPUs lazily allocated memory is never backed if the attachment stays on-chip
+	if (hints.lazily_allocated)
+	{
+		create_info.preferredFlags = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+	}
+
+	return create_info;
+}
+
+VmaAllocation ResourceAllocator::request_alias_block(const AllocationHints &hints, const VkMemoryRequirements &requirements, const VmaAllocationCreateInfo &create_info,
+                                                     MemoryCategory category, VmaAllocationInfo &allocation_info)
+{
+	assert(!(create_info.flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) && "Aliased memory cannot be persistently mapped");
+
+	std::lock_guard<std::mutex> guard{alias_mutex};
+
+	for (auto &block : alias_blocks)
+	{
+		// Resources are bound at the beginning of the block, which has to be aligned for them
+		if (block.alias_group == hints.alias_group &&
+		    block.size >= requirements.size &&
+		    (requirements.memoryTypeBits & (1u << block.memory_type)) != 0 &&
+		    block.alignment % requirements.alignment == 0)
+		{
+			++block.users;
+
+			vmaGetAllocationInfo(device.get_memory_allocator(), block.allocation, &allocation_info);
+
+			return block.allocation;
+		}
+	}
+
+	VmaAllocation allocation{VK_NULL_HANDLE};
+
+	auto result = vmaAllocateMemory(device.get_memory_allocator(), &requirements, &create_info, &allocation, &allocation_info);
+
+	if (result != VK_SUCCESS)
+	{
+		throw VulkanException{result, "Cannot allocate aliased memory"};
+	}
+
+	alias_blocks.push_back({hints.alias_group, allocation, allocation_info.size, requirements.alignment, allocation_info.memoryType, category, 1});
+
+	device.add_memory_usage(category, allocation_info.size);
+
+	return allocation;
+}
+}        // namespace vkb
@@ -0,0 +1,139 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class Device;
+
+enum class MemoryCategory;
+
+/**
+ * @brief Placement hints for the memory of a buffer or an image
+ */
+struct AllocationHints
+{
+	/// Gives the resource its own device memory, e.g. for large render targets and streaming pools.
+	/// VMA already does so for the resources the driver prefers dedicated, and those larger than half a block
+	bool dedicated{false};
+
+	/// Prefers lazily allocated memory, which tile-based GPUs never back for attachments staying on-chip.
+	/// Only images with VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT can use it
+	bool lazily_allocated{false};
+
+	/// Resources with the same alias group share their memory when it fits, so their contents must never
+	/// live at the same time. Empty for memory of their own
+	std::string alias_group;
+};
+
+/**
+ * @brief Allocates the memory of the buffers and images on top of VMA, following their placement hints,
+ *        and accounts it to the memory categories of the device
+ *
+ * Resources of an alias group are bound at the beginning of a shared allocation, which is accounted once
+ * and freed with its last resource. Aliased resources must be transitioned from VK_IMAGE_LAYOUT_UNDEFINED,
+ * or written entirely, after a barrier waiting for the previous use of any resource aliasing the same memory.
+ */
+class ResourceAllocator
+{
+  public:
+	ResourceAllocator(Device &device);
+
+	ResourceAllocator(const ResourceAllocator &) = delete;
+
+	ResourceAllocator(ResourceAllocator &&) = delete;
+
+	~ResourceAllocator();
+
+	ResourceAllocator &operator=(const ResourceAllocator &) = delete;
+
+	ResourceAllocator &operator=(ResourceAllocator &&) = delete;
+
+	/**
+	 * @brief Allocates memory for a buffer and binds it
+	 * @param category Category the memory is accounted to
+	 * @param allocation_info Filled with the information of the allocation, e.g. its mapped data
+	 * @return Allocation to release with free(), the buffer has to be destroyed first
+	 */
+	VmaAllocation allocate(VkBuffer buffer, VmaMemoryUsage memory_usage, VmaAllocationCreateFlags flags, const AllocationHints &hints,
+	                       MemoryCategory category, VmaAllocationInfo &allocation_info);
+
+	/**
+	 * @brief Allocates memory for an image and binds it
+	 * @param category Category the memory is accounted to
+	 * @param allocation_info Filled with the information of the allocation
+	 * @return Allocation to release with free(), the image has to be destroyed first
+	 */
+	VmaAllocation allocate(VkImage image, VmaMemoryUsage memory_usage, VmaAllocationCreateFlags flags, const AllocationHints &hints,
+	                       MemoryCategory category, VmaAllocationInfo &allocation_info);
+
+	/**
+	 * @brief Releases an allocation, the memory of an alias group is freed once no resource is bound to it
+	 */
+	void free(VmaAllocation allocation, MemoryCategory category);
+
+	/**
+	 * @return Size of the memory shared by the alias groups
+	 */
+	VkDeviceSize get_aliased_size() const;
+
+  private:
+	struct AliasBlock
+	{
+		std::string alias_group;
+
+		VmaAllocation allocation;
+
+		VkDeviceSize size;
+
+		VkDeviceSize alignment;
+
+		uint32_t memory_type;
+
+		MemoryCategory category;
+
+		/// Number of resources bound to the block
+		uint32_t users;
+	};
+
+	VmaAllocationCreateInfo get_create_info(VmaMemoryUsage memory_usage, VmaAllocationCreateFlags flags, const AllocationHints &hints) const;
+
+	/**
+	 * @brief Finds a block of the alias group the resource fits in, or allocates one
+	 */
+	VmaAllocation request_alias_block(const AllocationHints &hints, const VkMemoryRequirements &requirements, const VmaAllocationCreateInfo &create_info,
+	                                  MemoryCategory category, VmaAllocationInfo &allocation_info);
+
+	Device &device;
+
+	std::vector<AliasBlock> alias_blocks;
+
+	/// Resources are created from the loading threads too
+	mutable std::mutex alias_mutex;
+};
+}        // namespace vkb
@@ -22,106 +22,191 @@
 
 namespace vkb
 {
-void ResourceBindingState::reset()
-{
-	clear_dirty();
+constexpr uint32_t ResourceSet::MAX_BINDINGS;
 
-	resource_sets.clear();
-}
+constexpr uint32_t ResourceBindingState::MAX_SETS;
 
-bool ResourceBindingState::is_dirty()
+void ResourceBindingState::reset()
 {
-	return dirty;
+	for (uint32_t mask = set_mask; mask != 0; mask &= mask - 1)
+	{
+		resource_sets[lowest_bit_index(mask)].reset();
+	}
+
+	set_mask       = 0;
+	dirty_set_mask = 0;
 }
 
-void ResourceBindingState::clear_dirty()
+bool ResourceBindingState::is_dirty() const
 {
-	dirty = false;
+	return dirty_set_mask != 0;
 }
 
 void ResourceBindingState::clear_dirty(uint32_t set)
 {
 	resource_sets[set].clear_dirty();
+
+	dirty_set_mask &= ~(1u << set);
 }
 
 void ResourceBindingState::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element)
 {
-	resource_sets[set].bind_buffer(buffer, offset, range, binding, array_element);
+	request_resource_set(set).bind_buffer(buffer, offset, range, binding, array_element);
 
-	dirty = true;
+	update_dirty(set);
 }
 
 void ResourceBindingState::bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t set, uint32_t binding, uint32_t array_element)
 {
-	resource_sets[set].bind_image(image_view, sampler, binding, array_element);
+	request_resource_set(set).bind_image(image_view, sampler, binding, array_element);
 
-	dirty = true;
+	update_dirty(set);
 }
 
 void ResourceBindingState::bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element)
 {
-	resource_sets[set].bind_input(image_view, binding, array_element);
+	request_resource_set(set).bind_input(image_view, binding, array_element);
+
+	update_dirty(set);
+}
+
+uint32_t ResourceBindingState::get_set_mask() const
+{
+	return set_mask;
+}
+
+uint32_t ResourceBindingState::get_dirty_set_mask() const
+{
+	return dirty_set_mask;
+}
+
+const ResourceSet &ResourceBindingState::get_resource_set(uint32_t set) const
+{
+	assert(set < MAX_SETS && "Descriptor set index is out of bounds");
+
+	return resource_sets[set];
+}
+
+ResourceSet &ResourceBindingState::request_resource_set(uint32_t set)
+{
+	assert(set < MAX_SETS && "Descriptor set index is out of bounds");
 
-	dirty = true;
+	set_mask |= 1u << set;
+
+	return resource_sets[set];
 }
 
-const std::unordered_map<uint32_t, ResourceSet> &ResourceBindingState::get_resource_sets()
+void ResourceBindingState::update_dirty(uint32_t set)
 {
-	return resource_sets;
+	// Binding the same resources again doesn't need a flush
+	auto &resource_set = resource_sets[set];
+
+	if (resource_set.is_dirty() || resource_set.is_offset_dirty())
+	{
+		dirty_set_mask |= 1u << set;
+	}
 }
 
 void ResourceSet::reset()
 {
-	clear_dirty();
+	for (uint32_t mask = binding_mask; mask != 0; mask &= mask - 1)
+	{
+		resource_bindings[lowest_bit_index(mask)].clear();
+	}
 
-	resource_bindings.clear();
+	binding_mask = 0;
+
+	clear_dirty();
 }
 
 bool ResourceSet::is_dirty() const
 {
-	return dirty;
+	return dirty_mask != 0;
 }
 
-void ResourceSet::clear_dirty()
+bool ResourceSet::is_offset_dirty() const
 {
-	dirty = false;
+	return offset_dirty_mask != 0;
 }
 
-void ResourceSet::clear_dirty(uint32_t binding, uint32_t array_element)
+void ResourceSet::clear_dirty()
 {
-	resource_bindings[binding][array_element].dirty = false;
+	dirty_mask        = 0;
+	offset_dirty_mask = 0;
 }
 
 void ResourceSet::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding, uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty  = true;
-	resource_bindings[binding][array_element].buffer = &buffer;
-	resource_bindings[binding][array_element].offset = offset;
-	resource_bindings[binding][array_element].range  = range;
+	auto &resource_info = get_resource_info(binding, array_element);
+
+	if (resource_info.buffer == &buffer && resource_info.range == range)
+	{
+		// A new offset into the same buffer only needs a new dynamic offset, if the descriptor is dynamic
+		if (resource_info.offset != offset)
+		{
+			resource_info.offset = offset;
+
+			offset_dirty_mask |= 1u << binding;
+		}
 
-	dirty = true;
+		return;
+	}
+
+	resource_info.buffer = &buffer;
+	resource_info.offset = offset;
+	resource_info.range  = range;
+
+	dirty_mask |= 1u << binding;
 }
 
 void ResourceSet::bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t binding, uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty      = true;
-	resource_bindings[binding][array_element].image_view = &image_view;
-	resource_bindings[binding][array_element].sampler    = &sampler;
+	auto &resource_info = get_resource_info(binding, array_element);
+
+	resource_info.image_view = &image_view;
+	resource_info.sampler    = &sampler;
 
-	dirty = true;
+	dirty_mask |= 1u << binding;
 }
 
 void ResourceSet::bind_input(const core::ImageView &image_view, const uint32_t binding, const uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty      = true;
-	resource_bindings[binding][array_element].image_view = &image_view;
+	get_resource_info(binding, array_element).image_view = &image_view;
 
-	dirty = true;
+	dirty_mask |= 1u << binding;
+}
+
+uint32_t ResourceSet::get_binding_mask() const
+{
+	return binding_mask;
 }
 
-const BindingMap<ResourceInfo> &ResourceSet::get_resource_bindings() const
+uint32_t ResourceSet::get_offset_dirty_mask() const
 {
-	return resource_bindings;
+	return offset_dirty_mask;
+}
+
+const std::vector<ResourceInfo> &ResourceSet::get_binding(uint32_t binding) const
+{
+	assert(binding < MAX_BINDINGS && "Binding index is out of bounds");
+
+	return resource_bindings[binding];
+}
+
+ResourceInfo &ResourceSet::get_resource_info(uint32_t binding, uint32_t array_element)
+{
+	assert(binding < MAX_BINDINGS && "Binding index is out of bounds");
+
+	auto &binding_resources = resource_bindings[binding];
+
+	if (array_element >= binding_resources.size())
+	{
+		binding_resources.resize(array_element + 1);
+	}
+
+	binding_mask |= 1u << binding;
+
+	return binding_resources[array_element];
 }
 
 }        // namespace vkb
@@ -20,6 +20,9 @@
 
 #pragma once
 
+#include <array>
+
+#include "common/helpers.h"
 #include "common/vk_common.h"
 #include "core/buffer.h"
 #include "core/image_view.h"
@@ -31,11 +34,10 @@ namespace vkb
  * @brief A resource info is a struct containing the actual resource data.
  *
  * This will be referenced by a buffer info or image info descriptor inside a descriptor set.
+ * An array element without a buffer or image view isn't bound.
  */
 struct ResourceInfo
 {
-	bool dirty{false};
-
 	const core::Buffer *buffer{nullptr};
 
 	VkDeviceSize offset{0};
@@ -51,18 +53,27 @@ struct ResourceInfo
  * @brief A resource set is a set of bindings containing resources that were bound 
  *        by a command buffer.
  *
- * The ResourceSet has a one to one mapping with a DescriptorSet.
+ * The ResourceSet has a one to one mapping with a DescriptorSet. Bindings are stored in a
+ * fixed-size table indexed by binding, with one bit per binding in the bound and dirty masks,
+ * so that flushing only visits the bindings in use.
  */
 class ResourceSet
 {
   public:
+	/// Number of bindings a set can hold, one bit each in the masks
+	static constexpr uint32_t MAX_BINDINGS = 32;
+
 	void reset();
 
 	bool is_dirty() const;
 
-	void clear_dirty();
+	/**
+	 * @return Whether buffers were rebound at a different offset into the same buffer
+	 *         and with the same range, which dynamic descriptors handle without a new descriptor set
+	 */
+	bool is_offset_dirty() const;
 
-	void clear_dirty(uint32_t binding, uint32_t array_element);
+	void clear_dirty();
 
 	void bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding, uint32_t array_element);
 
@@ -70,12 +81,31 @@ class ResourceSet
 
 	void bind_input(const core::ImageView &image_view, uint32_t binding, uint32_t array_element);
 
-	const BindingMap<ResourceInfo> &get_resource_bindings() const;
+	/**
+	 * @return Mask of the bindings with resources bound
+	 */
+	uint32_t get_binding_mask() const;
+
+	/**
+	 * @return Mask of the bindings with a buffer rebound at a different offset since the last flush
+	 */
+	uint32_t get_offset_dirty_mask() const;
+
+	/**
+	 * @return The resources bound to the array elements of a binding
+	 */
+	const std::vector<ResourceInfo> &get_binding(uint32_t binding) const;
 
   private:
-	bool dirty{false};
+	ResourceInfo &get_resource_info(uint32_t binding, uint32_t array_element);
+
+	uint32_t binding_mask{0};
+
+	uint32_t dirty_mask{0};
+
+	uint32_t offset_dirty_mask{0};
 
-	BindingMap<ResourceInfo> resource_bindings;
+	std::array<std::vector<ResourceInfo>, MAX_BINDINGS> resource_bindings;
 };
 
 /**
@@ -87,11 +117,12 @@ class ResourceSet
 class ResourceBindingState
 {
   public:
-	void reset();
+	/// Number of descriptor sets that can be bound, one bit each in the masks
+	static constexpr uint32_t MAX_SETS = 8;
 
-	bool is_dirty();
+	void reset();
 
-	void clear_dirty();
+	bool is_dirty() const;
 
 	void clear_dirty(uint32_t set);
 
@@ -101,11 +132,27 @@ class ResourceBindingState
 
 	void bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element);
 
-	const std::unordered_map<uint32_t, ResourceSet> &get_resource_sets();
+	/**
+	 * @return Mask of the sets with resources bound
+	 */
+	uint32_t get_set_mask() const;
+
+	/**
+	 * @return Mask of the sets with resources or offsets changed since their last flush
+	 */
+	uint32_t get_dirty_set_mask() const;
+
+	const ResourceSet &get_resource_set(uint32_t set) const;
 
   private:
-	bool dirty{false};
+	ResourceSet &request_resource_set(uint32_t set);
+
+	void update_dirty(uint32_t set);
+
+	uint32_t set_mask{0};
+
+	uint32_t dirty_set_mask{0};
 
-	std::unordered_map<uint32_t, ResourceSet> resource_sets;
+	std::array<ResourceSet, MAX_SETS> resource_sets;
 };
 }        // namespace vkb
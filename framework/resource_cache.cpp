@@ -22,29 +22,187 @@
 
 #include "common/resource_caching.h"
 #include "core/device.h"
+#include "cpu_profiler.h"
+#include "timer.h"
 
 namespace vkb
 {
 namespace
 {
+/**
+ * @brief Locks a mutex of the cache, counting a contention when it has to wait for another thread
+ */
+template <class Lock>
+Lock lock_counted(typename Lock::mutex_type &resource_mutex, ResourceCacheCounters &counters)
+{
+	Lock lock(resource_mutex, std::try_to_lock);
+
+	if (!lock.owns_lock())
+	{
+		counters.record_contention();
+		lock.lock();
+	}
+
+	return lock;
+}
+
 template <class T, class... A>
-T &request_resource(Device &device, ResourceRecord &recorder, std::mutex &resource_mutex, std::unordered_map<std::size_t, T> &resources, A &... args)
+T &request_resource(Device &device, ResourceRecord &recorder, std::shared_timed_mutex &resource_mutex, std::unordered_map<std::size_t, T> &resources, ResourceCacheCounters &counters, A &... args)
 {
-	std::lock_guard<std::mutex> guard(resource_mutex);
+	std::size_t hash{0U};
+	hash_param(hash, args...);
+
+	{
+		auto guard = lock_counted<std::shared_lock<std::shared_timed_mutex>>(resource_mutex, counters);
+
+		auto res_it = resources.find(hash);
+
+		if (res_it != resources.end())
+		{
+			counters.record_hit();
+
+			return res_it->second;
+		}
+	}
+
+	// Another thread may have created the resource before the exclusive lock is taken,
+	// in which case it is found again by the request
+	auto guard = lock_counted<std::unique_lock<std::shared_timed_mutex>>(resource_mutex, counters);
+
+	size_t resource_count = resources.size();
+
+	Timer timer;
+	timer.start();
 
 	auto &res = request_resource(device, &recorder, resources, args...);
 
+	if (resources.size() > resource_count)
+	{
+		counters.record_creation(timer.stop<Timer::Milliseconds>());
+	}
+	else
+	{
+		counters.record_hit();
+	}
+
 	return res;
 }
+
+template <class T>
+size_t get_resource_count(std::shared_timed_mutex &resource_mutex, const std::unordered_map<std::size_t, T> &resources)
+{
+	std::shared_lock<std::shared_timed_mutex> guard(resource_mutex);
+
+	return resources.size();
+}
+
+/**
+ * @brief Requests a pipeline, which is created outside of the exclusive lock
+ *        Creating pipelines only reads the state and the internally synchronized pipeline cache,
+ *        so that threads creating different pipelines do not wait on each other.
+ */
+template <class T, class... A>
+T &request_pipeline(Device &device, ResourceRecord &recorder, std::shared_timed_mutex &resource_mutex, std::unordered_map<std::size_t, T> &resources, ResourceCacheCounters &counters,
+                    std::size_t hash, VkPipelineCache pipeline_cache, PipelineState &pipeline_state, A &&... args)
+{
+	{
+		auto guard = lock_counted<std::shared_lock<std::shared_timed_mutex>>(resource_mutex, counters);
+
+		auto res_it = resources.find(hash);
+
+		if (res_it != resources.end())
+		{
+			counters.record_hit();
+
+			return res_it->second;
+		}
+	}
+
+	LOGD("Building cache object ({})", typeid(T).name());
+
+	Timer timer;
+	timer.start();
+
+	T pipeline(device, pipeline_cache, pipeline_state, std::forward<A>(args)...);
+
+	// Also counted if another thread published the same pipeline first, as the time was spent anyway
+	counters.record_creation(timer.stop<Timer::Milliseconds>());
+
+	auto guard = lock_counted<std::unique_lock<std::shared_timed_mutex>>(resource_mutex, counters);
+
+	auto res_ins_it = resources.emplace(hash, std::move(pipeline));
+
+	// The pipeline created by another thread in the meantime is kept instead
+	if (res_ins_it.second)
+	{
+		RecordHelper<T, VkPipelineCache, PipelineState> record_helper;
+
+		size_t index = record_helper.record(recorder, pipeline_cache, pipeline_state);
+		record_helper.index(recorder, index, res_ins_it.first->second);
+	}
+
+	return res_ins_it.first->second;
+}
 }        // namespace
 
+constexpr size_t ResourceCacheStats::CREATION_TIME_BUCKETS;
+
+void ResourceCacheCounters::record_hit()
+{
+	hits.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ResourceCacheCounters::record_contention()
+{
+	contentions.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ResourceCacheCounters::record_creation(double milliseconds)
+{
+	misses.fetch_add(1, std::memory_order_relaxed);
+	creation_time.fetch_add(static_cast<uint64_t>(milliseconds * 1000.0), std::memory_order_relaxed);
+
+	// Buckets grow by factors of 10 from 0.1 ms
+	size_t bucket      = 0;
+	double upper_bound = 0.1;
+
+	while (bucket + 1 < ResourceCacheStats::CREATION_TIME_BUCKETS && milliseconds >= upper_bound)
+	{
+		++bucket;
+		upper_bound *= 10.0;
+	}
+
+	creation_time_histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
 ResourceCache::ResourceCache(Device &device) :
     device{device}
 {
 }
 
+ResourceCache::~ResourceCache()
+{
+	wait_pipeline_compilations();
+}
+
+Device &ResourceCache::get_device() const
+{
+	return device;
+}
+
 void ResourceCache::warmup(const std::vector<uint8_t> &data)
 {
+	if (data.empty())
+	{
+		return;
+	}
+
+	if (!ResourceRecord::is_compatible(data))
+	{
+		LOGW("Discard resource data of another format version than {}", RESOURCE_RECORD_VERSION);
+		return;
+	}
+
 	recorder.set_data(data);
 
 	replayer.play(*this, recorder);
@@ -55,6 +213,11 @@ std::vector<uint8_t> ResourceCache::serialize()
 	return recorder.get_data();
 }
 
+size_t ResourceCache::get_pipeline_layout_index(const PipelineLayout &pipeline_layout)
+{
+	return recorder.get_pipeline_layout_index(pipeline_layout);
+}
+
 void ResourceCache::set_pipeline_cache(VkPipelineCache new_pipeline_cache)
 {
 	pipeline_cache = new_pipeline_cache;
@@ -62,54 +225,563 @@ void ResourceCache::set_pipeline_cache(VkPipelineCache new_pipeline_cache)
 
 ShaderModule &ResourceCache::request_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant)
 {
+	VKB_PROFILE_SCOPE("ResourceCache::request_shader_module");
+
 	std::string entry_point{"main"};
-	return request_resource(device, recorder, shader_module_mutex, state.shader_modules, stage, glsl_source, entry_point, shader_variant);
+
+	std::shared_ptr<ShaderSource> reloaded_source;
+
+	if (!glsl_source.get_filename().empty())
+	{
+		std::shared_lock<std::shared_timed_mutex> guard(shader_module_mutex);
+
+		auto it = reloaded_shader_sources.find(glsl_source.get_filename());
+
+		if (it != reloaded_shader_sources.end())
+		{
+			reloaded_source = it->second;
+		}
+	}
+
+	// Sources edited while running are compiled from their latest version
+	const ShaderSource &source = reloaded_source ? *reloaded_source : glsl_source;
+
+	return request_resource(device, recorder, shader_module_mutex, state.shader_modules, get_counters(ResourceCacheType::ShaderModule), stage, source, entry_point, shader_variant);
 }
 
 PipelineLayout &ResourceCache::request_pipeline_layout(const std::vector<ShaderModule *> &shader_modules, bool use_dynamic_resources)
 {
-	return request_resource(device, recorder, pipeline_layout_mutex, state.pipeline_layouts, shader_modules, use_dynamic_resources);
+	VKB_PROFILE_SCOPE("ResourceCache::request_pipeline_layout");
+
+	return request_resource(device, recorder, pipeline_layout_mutex, state.pipeline_layouts, get_counters(ResourceCacheType::PipelineLayout), shader_modules, use_dynamic_resources);
 }
 
 DescriptorSetLayout &ResourceCache::request_descriptor_set_layout(const std::vector<ShaderResource> &set_resources, bool use_dynamic_resources)
 {
-	return request_resource(device, recorder, descriptor_set_layout_mutex, state.descriptor_set_layouts, set_resources, use_dynamic_resources);
+	VKB_PROFILE_SCOPE("ResourceCache::request_descriptor_set_layout");
+
+	return request_resource(device, recorder, descriptor_set_layout_mutex, state.descriptor_set_layouts, get_counters(ResourceCacheType::DescriptorSetLayout), set_resources, use_dynamic_resources);
 }
 
 GraphicsPipeline &ResourceCache::request_graphics_pipeline(PipelineState &pipeline_state)
 {
-	return request_resource(device, recorder, graphics_pipeline_mutex, state.graphics_pipelines, pipeline_cache, pipeline_state);
+	VKB_PROFILE_SCOPE("ResourceCache::request_graphics_pipeline");
+
+	std::size_t hash{0U};
+	hash_param(hash, pipeline_cache, pipeline_state);
+
+	touch_graphics_pipeline(hash);
+
+	if (!pipeline_derivatives)
+	{
+		return request_pipeline(device, recorder, graphics_pipeline_mutex, state.graphics_pipelines, get_counters(ResourceCacheType::GraphicsPipeline), hash, pipeline_cache, pipeline_state);
+	}
+
+	std::size_t derivative_hash = pipeline_state.get_derivative_hash();
+
+	VkPipeline base_pipeline{VK_NULL_HANDLE};
+
+	{
+		std::shared_lock<std::shared_timed_mutex> guard(graphics_pipeline_mutex);
+
+		auto base_it = derivative_bases.find(derivative_hash);
+
+		if (base_it != derivative_bases.end())
+		{
+			base_pipeline = base_it->second;
+		}
+	}
+
+	auto &pipeline = request_pipeline(device, recorder, graphics_pipeline_mutex, state.graphics_pipelines, get_counters(ResourceCacheType::GraphicsPipeline), hash, pipeline_cache, pipeline_state, base_pipeline);
+
+	if (base_pipeline == VK_NULL_HANDLE && pipeline.allows_derivatives())
+	{
+		std::lock_guard<std::shared_timed_mutex> guard(graphics_pipeline_mutex);
+
+		// Keeps the base published first if another thread created one meanwhile
+		derivative_bases.emplace(derivative_hash, pipeline.get_handle());
+	}
+
+	return pipeline;
+}
+
+GraphicsPipeline *ResourceCache::request_graphics_pipeline_async(PipelineState &pipeline_state)
+{
+	VKB_PROFILE_SCOPE("ResourceCache::request_graphics_pipeline_async");
+
+	if (!is_async_pipeline_compilation())
+	{
+		return &request_graphics_pipeline(pipeline_state);
+	}
+
+	std::size_t hash{0U};
+	hash_param(hash, pipeline_cache, pipeline_state);
+
+	touch_graphics_pipeline(hash);
+
+	auto &pipeline_counters = get_counters(ResourceCacheType::GraphicsPipeline);
+
+	{
+		auto guard = lock_counted<std::shared_lock<std::shared_timed_mutex>>(graphics_pipeline_mutex, pipeline_counters);
+
+		auto res_it = state.graphics_pipelines.find(hash);
+
+		if (res_it != state.graphics_pipelines.end())
+		{
+			pipeline_counters.record_hit();
+
+			return &res_it->second;
+		}
+
+		// A pipeline which failed to compile is not queued again, as it would fail every frame
+		if (pending_graphics_pipelines.count(hash) > 0 || failed_graphics_pipelines.count(hash) > 0)
+		{
+			return nullptr;
+		}
+	}
+
+	auto guard = lock_counted<std::unique_lock<std::shared_timed_mutex>>(graphics_pipeline_mutex, pipeline_counters);
+
+	// Another thread may have published or queued the pipeline before the exclusive lock is taken
+	auto res_it = state.graphics_pipelines.find(hash);
+
+	if (res_it != state.graphics_pipelines.end())
+	{
+		return &res_it->second;
+	}
+
+	if (failed_graphics_pipelines.count(hash) > 0)
+	{
+		return nullptr;
+	}
+
+	if (pending_graphics_pipelines.insert(hash).second)
+	{
+		LOGD("Queue graphics pipeline for compilation");
+
+		// The state is copied, as the one of the command buffer keeps changing
+		device.get_job_system().push(JobPriority::Background, [this, hash, pipeline_state](size_t) mutable {
+			compile_graphics_pipeline(hash, pipeline_state);
+		});
+	}
+
+	return nullptr;
+}
+
+void ResourceCache::compile_graphics_pipeline(std::size_t hash, PipelineState &pipeline_state)
+{
+	bool failed = false;
+
+	try
+	{
+		request_graphics_pipeline(pipeline_state);
+	}
+	catch (const std::exception &e)
+	{
+		LOGE("Failed to compile graphics pipeline: {}", e.what());
+
+		failed = true;
+	}
+
+	std::lock_guard<std::shared_timed_mutex> guard(graphics_pipeline_mutex);
+
+	pending_graphics_pipelines.erase(hash);
+
+	if (failed)
+	{
+		failed_graphics_pipelines.insert(hash);
+	}
+
+	// Notified under the lock, as the cache may be destroyed as soon as a waiter sees no pending pipeline
+	pipeline_compiled.notify_all();
 }
 
 ComputePipeline &ResourceCache::request_compute_pipeline(PipelineState &pipeline_state)
 {
-	return request_resource(device, recorder, compute_pipeline_mutex, state.compute_pipelines, pipeline_cache, pipeline_state);
+	VKB_PROFILE_SCOPE("ResourceCache::request_compute_pipeline");
+
+	std::size_t hash{0U};
+	hash_param(hash, pipeline_cache, pipeline_state);
+
+	return request_pipeline(device, recorder, compute_pipeline_mutex, state.compute_pipelines, get_counters(ResourceCacheType::ComputePipeline), hash, pipeline_cache, pipeline_state);
 }
 
 DescriptorSet &ResourceCache::request_descriptor_set(DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos)
 {
-	auto &descriptor_pool = request_resource(device, recorder, descriptor_set_mutex, state.descriptor_pools, descriptor_set_layout);
-	return request_resource(device, recorder, descriptor_set_mutex, state.descriptor_sets, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+	VKB_PROFILE_SCOPE("ResourceCache::request_descriptor_set");
+
+	auto &descriptor_pool = request_resource(device, recorder, descriptor_set_mutex, state.descriptor_pools, get_counters(ResourceCacheType::DescriptorPool), descriptor_set_layout);
+	return request_resource(device, recorder, descriptor_set_mutex, state.descriptor_sets, get_counters(ResourceCacheType::DescriptorSet), descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
 }
 
 RenderPass &ResourceCache::request_render_pass(const std::vector<Attachment> &attachments, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<SubpassInfo> &subpasses)
 {
-	return request_resource(device, recorder, render_pass_mutex, state.render_passes, attachments, load_store_infos, subpasses);
+	VKB_PROFILE_SCOPE("ResourceCache::request_render_pass");
+
+	return request_resource(device, recorder, render_pass_mutex, state.render_passes, get_counters(ResourceCacheType::RenderPass), attachments, load_store_infos, subpasses);
 }
 
 Framebuffer &ResourceCache::request_framebuffer(const RenderTarget &render_target, const RenderPass &render_pass)
 {
-	return request_resource(device, recorder, framebuffer_mutex, state.framebuffers, render_target, render_pass);
+	VKB_PROFILE_SCOPE("ResourceCache::request_framebuffer");
+
+	return request_resource(device, recorder, framebuffer_mutex, state.framebuffers, get_counters(ResourceCacheType::Framebuffer), render_target, render_pass);
+}
+
+const core::Sampler &ResourceCache::request_sampler(const VkSamplerCreateInfo &sampler_info)
+{
+	assert(!sampler_info.pNext && "Cached samplers are only hashed by their creation info");
+
+	return request_resource(device, recorder, sampler_mutex, state.samplers, get_counters(ResourceCacheType::Sampler), sampler_info);
+}
+
+void ResourceCache::set_pipeline_derivatives(bool enable)
+{
+	pipeline_derivatives = enable;
+}
+
+bool ResourceCache::is_pipeline_derivatives() const
+{
+	return pipeline_derivatives;
+}
+
+void ResourceCache::remove_derivative_base(VkPipeline handle)
+{
+	for (auto it = derivative_bases.begin(); it != derivative_bases.end();)
+	{
+		if (it->second == handle)
+		{
+			it = derivative_bases.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void ResourceCache::set_async_pipeline_compilation(bool enable)
+{
+	async_pipeline_compilation = enable;
+}
+
+bool ResourceCache::is_async_pipeline_compilation() const
+{
+	return async_pipeline_compilation;
+}
+
+void ResourceCache::wait_pipeline_compilations()
+{
+	std::unique_lock<std::shared_timed_mutex> lock(graphics_pipeline_mutex);
+
+	pipeline_compiled.wait(lock, [this]() { return pending_graphics_pipelines.empty(); });
 }
 
 void ResourceCache::clear_pipelines()
 {
+	wait_pipeline_compilations();
+
+	std::lock_guard<std::shared_timed_mutex> graphics_guard(graphics_pipeline_mutex);
+	std::lock_guard<std::shared_timed_mutex> compute_guard(compute_pipeline_mutex);
+
 	state.graphics_pipelines.clear();
 	state.compute_pipelines.clear();
+	derivative_bases.clear();
+	failed_graphics_pipelines.clear();
+
+	{
+		std::lock_guard<std::mutex> use_guard(graphics_pipeline_use_mutex);
+
+		graphics_pipeline_last_use.clear();
+	}
+
+	++generation;
+}
+
+std::vector<const ShaderModule *> ResourceCache::get_shader_modules(const std::string &filename)
+{
+	std::shared_lock<std::shared_timed_mutex> guard(shader_module_mutex);
+
+	std::vector<const ShaderModule *> shader_modules;
+
+	for (auto &it : state.shader_modules)
+	{
+		if (it.second.get_debug_name() == filename)
+		{
+			shader_modules.push_back(&it.second);
+		}
+	}
+
+	return shader_modules;
+}
+
+std::vector<std::string> ResourceCache::get_shader_filenames()
+{
+	std::shared_lock<std::shared_timed_mutex> guard(shader_module_mutex);
+
+	std::unordered_set<std::string> filenames;
+
+	for (auto &it : state.shader_modules)
+	{
+		if (!it.second.get_debug_name().empty())
+		{
+			filenames.insert(it.second.get_debug_name());
+		}
+	}
+
+	return {filenames.begin(), filenames.end()};
+}
+
+std::vector<std::unique_ptr<Pipeline>> ResourceCache::reload_shader_source(const ShaderSource &source, std::vector<std::pair<const ShaderModule *, std::vector<uint32_t>>> &&binaries)
+{
+	// Pipelines being compiled read the code of the modules
+	wait_pipeline_compilations();
+
+	std::unordered_set<const ShaderModule *> reloaded_modules;
+
+	{
+		std::lock_guard<std::shared_timed_mutex> guard(shader_module_mutex);
+
+		reloaded_shader_sources[source.get_filename()] = std::make_shared<ShaderSource>(source);
+
+		for (auto &binary : binaries)
+		{
+			for (auto &it : state.shader_modules)
+			{
+				if (&it.second == binary.first)
+				{
+					it.second.set_binary(std::move(binary.second));
+					reloaded_modules.insert(binary.first);
+				}
+			}
+		}
+	}
+
+	auto uses_reloaded_module = [&reloaded_modules](const Pipeline &pipeline) {
+		for (auto shader_module : pipeline.get_state().get_pipeline_layout().get_shader_program().get_shader_modules())
+		{
+			if (reloaded_modules.count(shader_module) > 0)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	};
+
+	std::vector<std::unique_ptr<Pipeline>> evicted_pipelines;
+
+	{
+		std::lock_guard<std::shared_timed_mutex> guard(graphics_pipeline_mutex);
+		std::lock_guard<std::mutex>              use_guard(graphics_pipeline_use_mutex);
+
+		for (auto it = state.graphics_pipelines.begin(); it != state.graphics_pipelines.end();)
+		{
+			if (!uses_reloaded_module(it->second))
+			{
+				++it;
+				continue;
+			}
+
+			if (it->second.allows_derivatives())
+			{
+				remove_derivative_base(it->second.get_handle());
+			}
+
+			graphics_pipeline_last_use.erase(it->first);
+
+			evicted_pipelines.push_back(std::make_unique<GraphicsPipeline>(std::move(it->second)));
+
+			it = state.graphics_pipelines.erase(it);
+
+			get_counters(ResourceCacheType::GraphicsPipeline).evictions.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	{
+		std::lock_guard<std::shared_timed_mutex> guard(compute_pipeline_mutex);
+
+		for (auto it = state.compute_pipelines.begin(); it != state.compute_pipelines.end();)
+		{
+			if (!uses_reloaded_module(it->second))
+			{
+				++it;
+				continue;
+			}
+
+			evicted_pipelines.push_back(std::make_unique<ComputePipeline>(std::move(it->second)));
+
+			it = state.compute_pipelines.erase(it);
+
+			get_counters(ResourceCacheType::ComputePipeline).evictions.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	// The command buffers recorded with the evicted pipelines must be recorded again
+	++generation;
+
+	return evicted_pipelines;
+}
+
+void ResourceCache::set_graphics_pipeline_cache_limits(size_t capacity, uint32_t max_idle_frames)
+{
+	graphics_pipeline_cache_capacity  = capacity;
+	graphics_pipeline_max_idle_frames = max_idle_frames;
+}
+
+void ResourceCache::update(uint32_t frames_in_flight)
+{
+	uint64_t frame = ++frame_count;
+
+	// The frame about to be recorded was waited for, so the ones evicted before the frames in flight are unused
+	while (!retired_graphics_pipelines.empty() && frame - retired_graphics_pipelines.front().first >= frames_in_flight)
+	{
+		retired_graphics_pipelines.pop_front();
+	}
+
+	if (graphics_pipeline_cache_capacity == 0 && graphics_pipeline_max_idle_frames == 0)
+	{
+		return;
+	}
+
+	std::lock_guard<std::shared_timed_mutex> guard(graphics_pipeline_mutex);
+	std::lock_guard<std::mutex>              use_guard(graphics_pipeline_use_mutex);
+
+	if (graphics_pipeline_max_idle_frames == 0 && state.graphics_pipelines.size() <= graphics_pipeline_cache_capacity)
+	{
+		return;
+	}
+
+	// Sort the cached pipelines from the least to the most recently used
+	std::vector<std::pair<uint64_t, std::size_t>> usage;
+	usage.reserve(state.graphics_pipelines.size());
+
+	for (auto &it : state.graphics_pipelines)
+	{
+		auto last_use_it = graphics_pipeline_last_use.find(it.first);
+
+		usage.emplace_back(last_use_it != graphics_pipeline_last_use.end() ? last_use_it->second : 0, it.first);
+	}
+
+	std::sort(usage.begin(), usage.end());
+
+	size_t remaining = usage.size();
+
+	auto &pipeline_counters = get_counters(ResourceCacheType::GraphicsPipeline);
+
+	for (auto &it : usage)
+	{
+		bool idle = graphics_pipeline_max_idle_frames > 0 && frame - it.first > graphics_pipeline_max_idle_frames;
+
+		if (!idle && (graphics_pipeline_cache_capacity == 0 || remaining <= graphics_pipeline_cache_capacity))
+		{
+			break;
+		}
+
+		auto pipeline_it = state.graphics_pipelines.find(it.second);
+
+		if (pipeline_it->second.allows_derivatives())
+		{
+			remove_derivative_base(pipeline_it->second.get_handle());
+		}
+
+		// Command buffers of the frames in flight may still use it
+		retired_graphics_pipelines.emplace_back(frame, std::move(pipeline_it->second));
+
+		state.graphics_pipelines.erase(pipeline_it);
+		graphics_pipeline_last_use.erase(it.second);
+
+		pipeline_counters.evictions.fetch_add(1, std::memory_order_relaxed);
+
+		--remaining;
+	}
+
+	// The command buffers recorded with the evicted pipelines must be recorded again
+	if (remaining < usage.size())
+	{
+		++generation;
+	}
+}
+
+ResourceCacheStats ResourceCache::get_stats(ResourceCacheType type)
+{
+	auto &type_counters = get_counters(type);
+
+	ResourceCacheStats stats;
+
+	stats.hits          = type_counters.hits.load(std::memory_order_relaxed);
+	stats.misses        = type_counters.misses.load(std::memory_order_relaxed);
+	stats.evictions     = type_counters.evictions.load(std::memory_order_relaxed);
+	stats.contentions   = type_counters.contentions.load(std::memory_order_relaxed);
+	stats.creation_time = type_counters.creation_time.load(std::memory_order_relaxed) / 1000.0;
+
+	for (size_t i = 0; i < ResourceCacheStats::CREATION_TIME_BUCKETS; ++i)
+	{
+		stats.creation_time_histogram[i] = type_counters.creation_time_histogram[i].load(std::memory_order_relaxed);
+	}
+
+	switch (type)
+	{
+		case ResourceCacheType::ShaderModule:
+			stats.count = get_resource_count(shader_module_mutex, state.shader_modules);
+			break;
+		case ResourceCacheType::PipelineLayout:
+			stats.count = get_resource_count(pipeline_layout_mutex, state.pipeline_layouts);
+			break;
+		case ResourceCacheType::DescriptorSetLayout:
+			stats.count = get_resource_count(descriptor_set_layout_mutex, state.descriptor_set_layouts);
+			break;
+		case ResourceCacheType::DescriptorPool:
+			stats.count = get_resource_count(descriptor_set_mutex, state.descriptor_pools);
+			break;
+		case ResourceCacheType::RenderPass:
+			stats.count = get_resource_count(render_pass_mutex, state.render_passes);
+			break;
+		case ResourceCacheType::GraphicsPipeline:
+			stats.count = get_resource_count(graphics_pipeline_mutex, state.graphics_pipelines);
+			break;
+		case ResourceCacheType::ComputePipeline:
+			stats.count = get_resource_count(compute_pipeline_mutex, state.compute_pipelines);
+			break;
+		case ResourceCacheType::DescriptorSet:
+			stats.count = get_resource_count(descriptor_set_mutex, state.descriptor_sets);
+			break;
+		case ResourceCacheType::Framebuffer:
+			stats.count = get_resource_count(framebuffer_mutex, state.framebuffers);
+			break;
+		case ResourceCacheType::Sampler:
+			stats.count = get_resource_count(sampler_mutex, state.samplers);
+			break;
+		default:
+			break;
+	}
+
+	return stats;
+}
+
+ResourceCacheCounters &ResourceCache::get_counters(ResourceCacheType type)
+{
+	return counters[static_cast<size_t>(type)];
+}
+
+void ResourceCache::touch_graphics_pipeline(std::size_t hash)
+{
+	if (graphics_pipeline_cache_capacity == 0 && graphics_pipeline_max_idle_frames == 0)
+	{
+		return;
+	}
+
+	auto guard = lock_counted<std::unique_lock<std::mutex>>(graphics_pipeline_use_mutex, get_counters(ResourceCacheType::GraphicsPipeline));
+
+	graphics_pipeline_last_use[hash] = frame_count.load(std::memory_order_relaxed);
 }
 
 void ResourceCache::update_descriptor_sets(const std::vector<core::ImageView> &old_views, const std::vector<core::ImageView> &new_views)
 {
+	std::lock_guard<std::shared_timed_mutex> guard(descriptor_set_mutex);
+
+	++generation;
+
 	// Find descriptor sets referring to the old image view
 	std::vector<VkWriteDescriptorSet> set_updates;
 	std::set<size_t>                  matches;
@@ -195,20 +867,63 @@ void ResourceCache::update_descriptor_sets(const std::vector<core::ImageView> &o
 
 void ResourceCache::clear_framebuffers()
 {
+	std::lock_guard<std::shared_timed_mutex> guard(framebuffer_mutex);
+
 	state.framebuffers.clear();
+
+	++generation;
+}
+
+void ResourceCache::clear_framebuffers(const std::vector<core::ImageView> &views)
+{
+	std::lock_guard<std::shared_timed_mutex> guard(framebuffer_mutex);
+
+	// Framebuffers are keyed and identified by resource ids, never reused, so evicting the ones of
+	// destroyed views can't affect the other framebuffers nor what was recorded with them
+	for (auto it = state.framebuffers.begin(); it != state.framebuffers.end();)
+	{
+		if (it->second.references_any(views))
+		{
+			it = state.framebuffers.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void ResourceCache::clear_descriptor_sets()
+{
+	std::lock_guard<std::shared_timed_mutex> guard(descriptor_set_mutex);
+
+	// The sets are freed with their pools
+	state.descriptor_sets.clear();
+	state.descriptor_pools.clear();
+
+	++generation;
 }
 
 void ResourceCache::clear()
 {
+	// Pending compilations use the shader modules and pipeline layouts
+	wait_pipeline_compilations();
+
 	state.shader_modules.clear();
 	state.pipeline_layouts.clear();
 	state.descriptor_sets.clear();
 	state.descriptor_set_layouts.clear();
 	state.render_passes.clear();
 	clear_pipelines();
+	retired_graphics_pipelines.clear();
 	clear_framebuffers();
 }
 
+uint32_t ResourceCache::get_generation() const
+{
+	return generation;
+}
+
 const ResourceCacheState &ResourceCache::get_internal_state() const
 {
 	return state;
@@ -20,7 +20,15 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "common/helpers.h"
@@ -29,6 +37,7 @@
 #include "core/descriptor_set_layout.h"
 #include "core/framebuffer.h"
 #include "core/pipeline.h"
+#include "core/sampler.h"
 #include "resource_record.h"
 #include "resource_replay.h"
 
@@ -64,6 +73,81 @@ struct ResourceCacheState
 	std::unordered_map<std::size_t, DescriptorSet> descriptor_sets;
 
 	std::unordered_map<std::size_t, Framebuffer> framebuffers;
+
+	std::unordered_map<std::size_t, core::Sampler> samplers;
+};
+
+/**
+ * @brief Types of the resources held by the Resource Cache
+ */
+enum class ResourceCacheType
+{
+	ShaderModule,
+	PipelineLayout,
+	DescriptorSetLayout,
+	DescriptorPool,
+	RenderPass,
+	GraphicsPipeline,
+	ComputePipeline,
+	DescriptorSet,
+	Framebuffer,
+	Sampler,
+	Count
+};
+
+/**
+ * @brief Statistics of the requests to one type of cached resource
+ */
+struct ResourceCacheStats
+{
+	/// Number of buckets of the creation time histogram
+	static constexpr size_t CREATION_TIME_BUCKETS = 5;
+
+	/// Requests which found the resource in the cache
+	uint64_t hits{0};
+
+	/// Requests which created the resource
+	uint64_t misses{0};
+
+	/// Resources evicted by the cache limits
+	uint64_t evictions{0};
+
+	/// Requests which found the lock of the type held by another thread and had to wait for it
+	uint64_t contentions{0};
+
+	/// Resources currently cached
+	size_t count{0};
+
+	/// Total time spent creating the resources, in milliseconds
+	double creation_time{0.0};
+
+	/// Number of resources created in under 0.1 ms, 1 ms, 10 ms, 100 ms, and in more
+	std::array<uint64_t, CREATION_TIME_BUCKETS> creation_time_histogram{};
+};
+
+/**
+ * @brief Counters behind the ResourceCacheStats of a type, updated by the requests of any thread
+ */
+struct ResourceCacheCounters
+{
+	std::atomic<uint64_t> hits{0};
+
+	std::atomic<uint64_t> misses{0};
+
+	std::atomic<uint64_t> evictions{0};
+
+	std::atomic<uint64_t> contentions{0};
+
+	/// In microseconds
+	std::atomic<uint64_t> creation_time{0};
+
+	std::array<std::atomic<uint64_t>, ResourceCacheStats::CREATION_TIME_BUCKETS> creation_time_histogram{};
+
+	void record_hit();
+
+	void record_creation(double milliseconds);
+
+	void record_contention();
 };
 
 /**
@@ -76,25 +160,43 @@ struct ResourceCacheState
  * The resource cache is also linked with ResourceRecord and ResourceReplay. Replay can warm-up
  * the cache on app startup by creating all necessary objects.
  * The cache holds pointers to objects and has a mapping from such pointers to hashes.
- * It can only be destroyed in bulk, single elements cannot be removed.
+ * It is destroyed in bulk, except for the framebuffers of destroyed views and the graphics pipelines
+ * evicted by the optional cache limits, see set_graphics_pipeline_cache_limits().
+ *
+ * Graphics pipelines can be compiled on background threads, see set_async_pipeline_compilation(),
+ * and derived from each other, see set_pipeline_derivatives().
+ *
+ * Each object type is guarded by a reader-writer lock. Requests finding an existing object only take
+ * it in shared mode, so that threads recording command buffers in parallel do not serialize on hits.
+ * Requests which have to wait for a lock are counted in the contentions of the type.
  */
 class ResourceCache
 {
   public:
 	ResourceCache(Device &device);
 
+	/// Waits for the pipelines still compiling on the job system
+	~ResourceCache();
+
 	ResourceCache(const ResourceCache &) = delete;
 
 	ResourceCache(ResourceCache &&) = delete;
 
 	ResourceCache &operator=(const ResourceCache &) = delete;
 
+	Device &get_device() const;
+
 	ResourceCache &operator=(ResourceCache &&) = delete;
 
 	void warmup(const std::vector<uint8_t> &data);
 
 	std::vector<uint8_t> serialize();
 
+	/**
+	 * @return The index of a pipeline layout of the cache in the stream returned by serialize()
+	 */
+	size_t get_pipeline_layout_index(const PipelineLayout &pipeline_layout);
+
 	void set_pipeline_cache(VkPipelineCache pipeline_cache);
 
 	ShaderModule &request_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant = {});
@@ -105,6 +207,15 @@ class ResourceCache
 
 	GraphicsPipeline &request_graphics_pipeline(PipelineState &pipeline_state);
 
+	/**
+	 * @brief Requests a graphics pipeline without waiting for it to be compiled
+	 *        If asynchronous compilation is enabled, a missing pipeline is queued on the compile threads
+	 *        and published into the cache once it is created; if it fails to compile, it is not queued again until the pipelines are cleared.
+	 *        Otherwise it is compiled synchronously, as with request_graphics_pipeline().
+	 * @return The pipeline, or nullptr if it is still being compiled
+	 */
+	GraphicsPipeline *request_graphics_pipeline_async(PipelineState &pipeline_state);
+
 	ComputePipeline &request_compute_pipeline(PipelineState &pipeline_state);
 
 	DescriptorSet &request_descriptor_set(DescriptorSetLayout &                     descriptor_set_layout,
@@ -118,8 +229,85 @@ class ResourceCache
 	Framebuffer &request_framebuffer(const RenderTarget &render_target,
 	                                 const RenderPass &  render_pass);
 
+	/**
+	 * @brief Requests a sampler shared by all the requests with the same creation info, so that identical
+	 *        samplers count once against maxSamplerAllocationCount and give the same descriptor set keys.
+	 *        Samplers are kept until the cache is destroyed, as scenes refer to them, even through clear()
+	 * @param sampler_info Creation info of the sampler, without extension structures
+	 */
+	const core::Sampler &request_sampler(const VkSamplerCreateInfo &sampler_info);
+
+	/**
+	 * @brief Enables compiling the missing graphics pipelines as background jobs of the device job system
+	 *        Command buffers skip the draws whose pipeline is not ready yet.
+	 * @param enable False makes the missing pipelines compile on the requesting thread
+	 */
+	void set_async_pipeline_compilation(bool enable);
+
+	bool is_async_pipeline_compilation() const;
+
+	/**
+	 * @brief Enables creating the graphics pipelines as derivatives of a cached pipeline with the same shaders,
+	 *        layout, render pass, vertex input, input assembly, viewport and multisample states, so that only
+	 *        their rasterization, depth stencil and color blend states are compiled. Enabled by default
+	 * @param enable False creates all graphics pipelines independently
+	 */
+	void set_pipeline_derivatives(bool enable);
+
+	bool is_pipeline_derivatives() const;
+
+	/**
+	 * @brief Waits for the graphics pipelines queued for compilation to be published
+	 */
+	void wait_pipeline_compilations();
+
 	void clear_pipelines();
 
+	/**
+	 * @return The cached shader modules compiled from a source file
+	 */
+	std::vector<const ShaderModule *> get_shader_modules(const std::string &filename);
+
+	/**
+	 * @return The source files of the cached shader modules
+	 */
+	std::vector<std::string> get_shader_filenames();
+
+	/**
+	 * @brief Swaps in the code recompiled from an edited shader source. The cached modules are updated in place,
+	 *        keeping their ids, and only the pipelines using them are evicted, so that they are created again when
+	 *        next requested. Variants requested later are compiled from the edited source.
+	 *        To be called between frames, as the modules are not guarded while command buffers are recorded.
+	 * @param source The edited source
+	 * @param binaries New code of the modules compiled from the source, which must keep their resources
+	 * @return The evicted pipelines, which the command buffers of the frames in flight may still use
+	 */
+	std::vector<std::unique_ptr<Pipeline>> reload_shader_source(const ShaderSource &                                                source,
+	                                                            std::vector<std::pair<const ShaderModule *, std::vector<uint32_t>>> &&binaries);
+
+	/**
+	 * @brief Bounds the graphics pipelines cached. On each update(), the pipelines that were not requested
+	 *        during the last max_idle_frames frames are evicted, then the least recently used ones until
+	 *        at most capacity pipelines are cached. Evicting increments the generation, so that the command
+	 *        buffers recorded with the pipelines are recorded again. To be set before recording
+	 * @param capacity Maximum number of graphics pipelines cached, 0 for no limit
+	 * @param max_idle_frames Number of frames after which an unused pipeline is evicted, 0 to disable
+	 */
+	void set_graphics_pipeline_cache_limits(size_t capacity, uint32_t max_idle_frames);
+
+	/**
+	 * @brief Advances the frame of the cache, to be called before recording each frame
+	 *        Destroys the pipelines evicted at least frames_in_flight frames ago, then evicts the pipelines
+	 *        beyond the cache limits, which are kept alive until no frame in flight can use them
+	 * @param frames_in_flight Number of frames whose command buffers may still be executing
+	 */
+	void update(uint32_t frames_in_flight);
+
+	/**
+	 * @return The request counters and the number of cached resources of a type
+	 */
+	ResourceCacheStats get_stats(ResourceCacheType type);
+
 	/// @brief Update those descriptor sets referring to old views
 	/// @param old_views Old image views referred by descriptor sets
 	/// @param new_views New image views to be referred
@@ -127,8 +315,26 @@ class ResourceCache
 
 	void clear_framebuffers();
 
+	/**
+	 * @brief Destroys the descriptor sets and the pools they were allocated from
+	 *        To be called once the commands using them have completed
+	 */
+	void clear_descriptor_sets();
+
+	/**
+	 * @brief Destroys the framebuffers having one of the views as attachment
+	 *        To be called once the commands using the views have completed, before the views are destroyed
+	 */
+	void clear_framebuffers(const std::vector<core::ImageView> &views);
+
 	void clear();
 
+	/**
+	 * @return A counter incremented each time cached resources are cleared or updated, so that
+	 *         command buffers recorded with them can tell they must be recorded again
+	 */
+	uint32_t get_generation() const;
+
 	const ResourceCacheState &get_internal_state() const;
 
   private:
@@ -142,20 +348,71 @@ class ResourceCache
 
 	ResourceCacheState state;
 
-	std::mutex descriptor_set_mutex;
+	std::atomic<uint32_t> generation{0};
+
+	std::shared_timed_mutex descriptor_set_mutex;
+
+	std::shared_timed_mutex pipeline_layout_mutex;
+
+	std::shared_timed_mutex shader_module_mutex;
+
+	std::shared_timed_mutex descriptor_set_layout_mutex;
+
+	std::shared_timed_mutex graphics_pipeline_mutex;
+
+	std::shared_timed_mutex render_pass_mutex;
+
+	std::shared_timed_mutex compute_pipeline_mutex;
+
+	std::shared_timed_mutex framebuffer_mutex;
+
+	std::shared_timed_mutex sampler_mutex;
+
+	/// Hashes of the graphics pipelines being compiled, guarded by graphics_pipeline_mutex
+	std::unordered_set<std::size_t> pending_graphics_pipelines;
+
+	/// Hashes of the graphics pipelines which failed to compile, guarded by graphics_pipeline_mutex
+	std::unordered_set<std::size_t> failed_graphics_pipelines;
+
+	/// Notified when a pending graphics pipeline is done compiling
+	std::condition_variable_any pipeline_compiled;
+
+	/// Creates a graphics pipeline on a job system worker and publishes it into the cache
+	void compile_graphics_pipeline(std::size_t hash, PipelineState &pipeline_state);
+
+	bool async_pipeline_compilation{false};
+
+	bool pipeline_derivatives{true};
+
+	/// Base pipeline of each derivative hash, guarded by graphics_pipeline_mutex
+	std::unordered_map<std::size_t, VkPipeline> derivative_bases;
+
+	/// Stops deriving from a pipeline about to be evicted, with graphics_pipeline_mutex locked
+	void remove_derivative_base(VkPipeline handle);
+
+	std::array<ResourceCacheCounters, static_cast<size_t>(ResourceCacheType::Count)> counters;
+
+	ResourceCacheCounters &get_counters(ResourceCacheType type);
+
+	size_t graphics_pipeline_cache_capacity{0};
 
-	std::mutex pipeline_layout_mutex;
+	uint32_t graphics_pipeline_max_idle_frames{0};
 
-	std::mutex shader_module_mutex;
+	/// Frames counted by update()
+	std::atomic<uint64_t> frame_count{0};
 
-	std::mutex descriptor_set_layout_mutex;
+	/// Frame each graphics pipeline was last requested, only tracked if the cache is bounded
+	std::unordered_map<std::size_t, uint64_t> graphics_pipeline_last_use;
 
-	std::mutex graphics_pipeline_mutex;
+	std::mutex graphics_pipeline_use_mutex;
 
-	std::mutex render_pass_mutex;
+	/// Evicted graphics pipelines, with the frame they were evicted
+	std::deque<std::pair<uint64_t, GraphicsPipeline>> retired_graphics_pipelines;
 
-	std::mutex compute_pipeline_mutex;
+	/// Latest version of the sources edited while running, by filename, guarded by shader_module_mutex
+	std::unordered_map<std::string, std::shared_ptr<ShaderSource>> reloaded_shader_sources;
 
-	std::mutex framebuffer_mutex;
+	/// Records the use of a graphics pipeline for the cache limits
+	void touch_graphics_pipeline(std::size_t hash);
 };
 }        // namespace vkb
@@ -20,6 +20,8 @@
 
 #include "resource_record.h"
 
+#include <cstring>
+
 #include "core/pipeline.h"
 #include "core/pipeline_layout.h"
 #include "core/render_pass.h"
@@ -37,6 +39,9 @@ inline void write_subpass_info(std::ostringstream &os, const std::vector<Subpass
 	{
 		write(os, item.input_attachments);
 		write(os, item.output_attachments);
+		write(os, item.color_resolve_attachments);
+		write(os, item.view_mask);
+		write(os, item.rasterization_order_access);
 	}
 }
 
@@ -48,15 +53,66 @@ inline void write_processes(std::ostringstream &os, const std::vector<std::strin
 		write(os, item);
 	}
 }
+
+inline void write_shader_resources(std::ostringstream &os, const std::vector<ShaderResource> &value)
+{
+	write(os, value.size());
+	for (const ShaderResource &item : value)
+	{
+		write(os, item.stages, item.type, item.set, item.binding, item.location, item.input_attachment_index);
+		write(os, item.vec_size, item.columns, item.array_size, item.offset, item.size, item.constant_id);
+		write(os, item.dynamic, item.push, item.name);
+	}
+}
+
+inline void write_specialization_constants(std::ostringstream &os, PipelineState &pipeline_state)
+{
+	auto &specialization_constant_state = pipeline_state.get_specialization_constant_state();
+
+	std::vector<SpecializationConstant> specialization_constants{specialization_constant_state.begin(), specialization_constant_state.end()};
+
+	write(os, specialization_constants);
+}
 }        // namespace
 
+ResourceRecord::ResourceRecord()
+{
+	write(stream, RESOURCE_RECORD_VERSION);
+}
+
+bool ResourceRecord::is_compatible(const std::vector<uint8_t> &data)
+{
+	if (data.empty())
+	{
+		return true;
+	}
+
+	uint32_t version{0};
+
+	if (data.size() < sizeof(version))
+	{
+		return false;
+	}
+
+	std::memcpy(&version, data.data(), sizeof(version));
+
+	return version == RESOURCE_RECORD_VERSION;
+}
+
 void ResourceRecord::set_data(const std::vector<uint8_t> &data)
 {
+	std::lock_guard<std::mutex> guard(stream_mutex);
+
 	stream.str(std::string{data.begin(), data.end()});
+
+	// Moves past the version, which an empty stream is given
+	write(stream, RESOURCE_RECORD_VERSION);
 }
 
 std::vector<uint8_t> ResourceRecord::get_data()
 {
+	std::lock_guard<std::mutex> guard(stream_mutex);
+
 	std::string str = stream.str();
 
 	return std::vector<uint8_t>{str.begin(), str.end()};
@@ -69,6 +125,8 @@ const std::ostringstream &ResourceRecord::get_stream()
 
 size_t ResourceRecord::register_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant)
 {
+	std::lock_guard<std::mutex> guard(stream_mutex);
+
 	shader_module_indices.push_back(shader_module_indices.size());
 
 	write(stream, ResourceType::ShaderModule, stage, glsl_source.get_data(), entry_point, shader_variant.get_preamble());
@@ -80,6 +138,8 @@ size_t ResourceRecord::register_shader_module(VkShaderStageFlagBits stage, const
 
 size_t ResourceRecord::register_pipeline_layout(const std::vector<ShaderModule *> &shader_modules, bool use_dynamic_resources)
 {
+	std::lock_guard<std::mutex> guard(stream_mutex);
+
 	pipeline_layout_indices.push_back(pipeline_layout_indices.size());
 
 	std::vector<size_t> shader_indices(shader_modules.size());
@@ -95,6 +155,8 @@ size_t ResourceRecord::register_pipeline_layout(const std::vector<ShaderModule *
 
 size_t ResourceRecord::register_render_pass(const std::vector<Attachment> &attachments, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<SubpassInfo> &subpasses)
 {
+	std::lock_guard<std::mutex> guard(stream_mutex);
+
 	render_pass_indices.push_back(render_pass_indices.size());
 
 	write(stream,
@@ -109,6 +171,8 @@ size_t ResourceRecord::register_render_pass(const std::vector<Attachment> &attac
 
 size_t ResourceRecord::register_graphics_pipeline(VkPipelineCache /*pipeline_cache*/, PipelineState &pipeline_state)
 {
+	std::lock_guard<std::mutex> guard(stream_mutex);
+
 	graphics_pipeline_indices.push_back(graphics_pipeline_indices.size());
 
 	auto &pipeline_layout = pipeline_state.get_pipeline_layout();
@@ -120,10 +184,7 @@ size_t ResourceRecord::register_graphics_pipeline(VkPipelineCache /*pipeline_cac
 	      render_pass_to_index.at(render_pass),
 	      pipeline_state.get_subpass_index());
 
-	auto &specialization_constant_state = pipeline_state.get_specialization_constant_state().get_specialization_constant_state();
-
-	write(stream,
-	      specialization_constant_state);
+	write_specialization_constants(stream, pipeline_state);
 
 	auto &vertex_input_state = pipeline_state.get_vertex_input_state();
 
@@ -148,24 +209,83 @@ size_t ResourceRecord::register_graphics_pipeline(VkPipelineCache /*pipeline_cac
 	return graphics_pipeline_indices.back();
 }
 
+size_t ResourceRecord::register_descriptor_set_layout(const std::vector<ShaderResource> &set_resources, bool use_dynamic_resources)
+{
+	std::lock_guard<std::mutex> guard(stream_mutex);
+
+	descriptor_set_layout_indices.push_back(descriptor_set_layout_indices.size());
+
+	write(stream, ResourceType::DescriptorSetLayout);
+
+	write_shader_resources(stream, set_resources);
+
+	write(stream, use_dynamic_resources);
+
+	return descriptor_set_layout_indices.back();
+}
+
+size_t ResourceRecord::register_compute_pipeline(VkPipelineCache /*pipeline_cache*/, PipelineState &pipeline_state)
+{
+	std::lock_guard<std::mutex> guard(stream_mutex);
+
+	compute_pipeline_indices.push_back(compute_pipeline_indices.size());
+
+	write(stream,
+	      ResourceType::ComputePipeline,
+	      pipeline_layout_to_index.at(&pipeline_state.get_pipeline_layout()));
+
+	write_specialization_constants(stream, pipeline_state);
+
+	return compute_pipeline_indices.back();
+}
+
+size_t ResourceRecord::register_sampler(const VkSamplerCreateInfo &sampler_info)
+{
+	std::lock_guard<std::mutex> guard(stream_mutex);
+
+	sampler_indices.push_back(sampler_indices.size());
+
+	// The chain is not written, cached samplers have none
+	write(stream,
+	      ResourceType::Sampler,
+	      sampler_info);
+
+	return sampler_indices.back();
+}
+
 void ResourceRecord::set_shader_module(size_t index, const ShaderModule &shader_module)
 {
+	std::lock_guard<std::mutex> guard(stream_mutex);
+
 	shader_module_to_index[&shader_module] = index;
 }
 
 void ResourceRecord::set_pipeline_layout(size_t index, const PipelineLayout &pipeline_layout)
 {
+	std::lock_guard<std::mutex> guard(stream_mutex);
+
 	pipeline_layout_to_index[&pipeline_layout] = index;
 }
 
 void ResourceRecord::set_render_pass(size_t index, const RenderPass &render_pass)
 {
+	std::lock_guard<std::mutex> guard(stream_mutex);
+
 	render_pass_to_index[&render_pass] = index;
 }
 
 void ResourceRecord::set_graphics_pipeline(size_t index, const GraphicsPipeline &graphics_pipeline)
 {
+	std::lock_guard<std::mutex> guard(stream_mutex);
+
 	graphics_pipeline_to_index[&graphics_pipeline] = index;
 }
 
+size_t ResourceRecord::get_pipeline_layout_index(const PipelineLayout &pipeline_layout)
+{
+	std::lock_guard<std::mutex> guard(stream_mutex);
+
+	return pipeline_layout_to_index.at(&pipeline_layout);
+}
+
 }        // namespace vkb
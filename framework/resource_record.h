@@ -20,31 +20,52 @@
 
 #pragma once
 
+#include <mutex>
 #include <vector>
 
 #include "rendering/pipeline_state.h"
 
 namespace vkb
 {
+class ComputePipeline;
+class DescriptorSetLayout;
 class GraphicsPipeline;
 class PipelineLayout;
 class RenderPass;
 class ShaderModule;
 
+/// Version the stream starts with, increased when the format of an entry changes
+constexpr uint32_t RESOURCE_RECORD_VERSION = 2;
+
 enum class ResourceType
 {
 	ShaderModule,
 	PipelineLayout,
 	RenderPass,
-	GraphicsPipeline
+	GraphicsPipeline,
+	DescriptorSetLayout,
+	ComputePipeline,
+	Sampler
 };
 
 /**
  * @brief Writes Vulkan objects in a memory stream.
+ *        Objects can be registered from multiple threads, the stream is guarded by a mutex.
  */
 class ResourceRecord
 {
   public:
+	ResourceRecord();
+
+	/**
+	 * @return Whether the data is a stream of the current version, or empty
+	 */
+	static bool is_compatible(const std::vector<uint8_t> &data);
+
+	/**
+	 * @brief Replaces the stream, which should be compatible. Objects registered afterwards
+	 *        overwrite it from the start, as replaying it registers the same objects in order
+	 */
 	void set_data(const std::vector<uint8_t> &data);
 
 	std::vector<uint8_t> get_data();
@@ -63,6 +84,13 @@ class ResourceRecord
 	size_t register_graphics_pipeline(VkPipelineCache pipeline_cache,
 	                                  PipelineState & pipeline_state);
 
+	size_t register_descriptor_set_layout(const std::vector<ShaderResource> &set_resources, bool use_dynamic_resources);
+
+	size_t register_compute_pipeline(VkPipelineCache pipeline_cache,
+	                                 PipelineState & pipeline_state);
+
+	size_t register_sampler(const VkSamplerCreateInfo &sampler_info);
+
 	void set_shader_module(size_t index, const ShaderModule &shader_module);
 
 	void set_pipeline_layout(size_t index, const PipelineLayout &pipeline_layout);
@@ -71,7 +99,14 @@ class ResourceRecord
 
 	void set_graphics_pipeline(size_t index, const GraphicsPipeline &graphics_pipeline);
 
+	/**
+	 * @return The index of a registered pipeline layout in the stream
+	 */
+	size_t get_pipeline_layout_index(const PipelineLayout &pipeline_layout);
+
   private:
+	std::mutex stream_mutex;
+
 	std::ostringstream stream;
 
 	std::vector<size_t> shader_module_indices;
@@ -82,6 +117,12 @@ class ResourceRecord
 
 	std::vector<size_t> graphics_pipeline_indices;
 
+	std::vector<size_t> descriptor_set_layout_indices;
+
+	std::vector<size_t> compute_pipeline_indices;
+
+	std::vector<size_t> sampler_indices;
+
 	std::unordered_map<const ShaderModule *, size_t> shader_module_to_index;
 
 	std::unordered_map<const PipelineLayout *, size_t> pipeline_layout_to_index;
@@ -22,6 +22,7 @@
 
 #include "common/logging.h"
 #include "common/vk_common.h"
+#include "core/device.h"
 #include "rendering/pipeline_state.h"
 #include "resource_cache.h"
 
@@ -38,6 +39,9 @@ inline void read_subpass_info(std::istringstream &is, std::vector<SubpassInfo> &
 	{
 		read(is, subpass.input_attachments);
 		read(is, subpass.output_attachments);
+		read(is, subpass.color_resolve_attachments);
+		read(is, subpass.view_mask);
+		read(is, subpass.rasterization_order_access);
 	}
 }
 
@@ -51,6 +55,19 @@ inline void read_processes(std::istringstream &is, std::vector<std::string> &val
 		read(is, item);
 	}
 }
+
+inline void read_shader_resources(std::istringstream &is, std::vector<ShaderResource> &value)
+{
+	std::size_t size;
+	read(is, size);
+	value.resize(size);
+	for (ShaderResource &item : value)
+	{
+		read(is, item.stages, item.type, item.set, item.binding, item.location, item.input_attachment_index);
+		read(is, item.vec_size, item.columns, item.array_size, item.offset, item.size, item.constant_id);
+		read(is, item.dynamic, item.push, item.name);
+	}
+}
 }        // namespace
 
 ResourceReplay::ResourceReplay()
@@ -59,12 +76,24 @@ ResourceReplay::ResourceReplay()
 	stream_resources[ResourceType::PipelineLayout]   = std::bind(&ResourceReplay::create_pipeline_layout, this, std::placeholders::_1, std::placeholders::_2);
 	stream_resources[ResourceType::RenderPass]       = std::bind(&ResourceReplay::create_render_pass, this, std::placeholders::_1, std::placeholders::_2);
 	stream_resources[ResourceType::GraphicsPipeline] = std::bind(&ResourceReplay::create_graphics_pipeline, this, std::placeholders::_1, std::placeholders::_2);
+
+	stream_resources[ResourceType::DescriptorSetLayout] = std::bind(&ResourceReplay::create_descriptor_set_layout, this, std::placeholders::_1, std::placeholders::_2);
+	stream_resources[ResourceType::ComputePipeline]     = std::bind(&ResourceReplay::create_compute_pipeline, this, std::placeholders::_1, std::placeholders::_2);
+	stream_resources[ResourceType::Sampler]             = std::bind(&ResourceReplay::create_sampler, this, std::placeholders::_1, std::placeholders::_2);
 }
 
 void ResourceReplay::play(ResourceCache &resource_cache, ResourceRecord &recorder)
 {
 	std::istringstream stream{recorder.get_stream().str()};
 
+	uint32_t version{0};
+	read(stream, version);
+
+	if (!stream || version != RESOURCE_RECORD_VERSION)
+	{
+		throw std::runtime_error("The data is not a resource record of version " + std::to_string(RESOURCE_RECORD_VERSION));
+	}
+
 	while (true)
 	{
 		// Read command id
@@ -90,6 +119,36 @@ void ResourceReplay::play(ResourceCache &resource_cache, ResourceRecord &recorde
 			LOGE("Replay command not supported.");
 		}
 	}
+
+	// Wait for all the pipelines before reporting the first creation error
+	std::exception_ptr error;
+
+	for (auto &future : graphics_pipeline_futures)
+	{
+		try
+		{
+			graphics_pipelines.push_back(future.get());
+		}
+		catch (...)
+		{
+			if (!error)
+			{
+				error = std::current_exception();
+			}
+		}
+	}
+
+	graphics_pipeline_futures.clear();
+
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+PipelineLayout &ResourceReplay::get_pipeline_layout(size_t index)
+{
+	return *pipeline_layouts.at(index);
 }
 
 void ResourceReplay::create_shader_module(ResourceCache &resource_cache, std::istringstream &stream)
@@ -109,7 +168,8 @@ void ResourceReplay::create_shader_module(ResourceCache &resource_cache, std::is
 	read_processes(stream, processes);
 
 	ShaderSource  shader_source(std::move(glsl_code));
-	ShaderVariant shader_variant(std::move(preamble), std::move(processes));
+	// The preamble is generated again from the processes
+	ShaderVariant shader_variant(processes);
 
 	auto &shader_module = resource_cache.request_shader_module(stage, shader_source, shader_variant);
 
@@ -161,9 +221,9 @@ void ResourceReplay::create_graphics_pipeline(ResourceCache &resource_cache, std
 	     render_pass_index,
 	     subpass_index);
 
-	std::map<uint32_t, std::vector<uint8_t>> specialization_constant_state{};
+	std::vector<SpecializationConstant> specialization_constants{};
 	read(stream,
-	     specialization_constant_state);
+	     specialization_constants);
 
 	VertexInputState vertex_input_sate{};
 
@@ -192,12 +252,13 @@ void ResourceReplay::create_graphics_pipeline(ResourceCache &resource_cache, std
 	     color_blend_state.attachments);
 
 	PipelineState pipeline_state{};
+	pipeline_state.set_extended_dynamic_state(resource_cache.get_device().is_extended_dynamic_state_enabled());
 	pipeline_state.set_pipeline_layout(*pipeline_layouts.at(pipeline_layout_index));
 	pipeline_state.set_render_pass(*render_passes.at(render_pass_index));
 
-	for (auto &item : specialization_constant_state)
+	for (auto &constant : specialization_constants)
 	{
-		pipeline_state.set_specialization_constant(item.first, item.second);
+		pipeline_state.set_specialization_constant(constant.constant_id, constant.data.data(), constant.size);
 	}
 
 	pipeline_state.set_subpass_index(subpass_index);
@@ -209,8 +270,58 @@ void ResourceReplay::create_graphics_pipeline(ResourceCache &resource_cache, std
 	pipeline_state.set_depth_stencil_state(depth_stencil_state);
 	pipeline_state.set_color_blend_state(color_blend_state);
 
-	auto &graphics_pipeline = resource_cache.request_graphics_pipeline(pipeline_state);
+	// Created concurrently, as its dependencies were created by the previous entries of the stream
+	auto &job_system = resource_cache.get_device().get_job_system();
+
+	auto future = job_system.push(JobPriority::Background, [&resource_cache, pipeline_state](size_t) mutable -> const GraphicsPipeline * {
+		return &resource_cache.request_graphics_pipeline(pipeline_state);
+	});
+
+	graphics_pipeline_futures.push_back(std::move(future));
+}
+
+void ResourceReplay::create_descriptor_set_layout(ResourceCache &resource_cache, std::istringstream &stream)
+{
+	std::vector<ShaderResource> set_resources;
+	bool                        use_dynamic_resources;
+
+	read_shader_resources(stream, set_resources);
+
+	read(stream, use_dynamic_resources);
+
+	resource_cache.request_descriptor_set_layout(set_resources, use_dynamic_resources);
+}
+
+void ResourceReplay::create_compute_pipeline(ResourceCache &resource_cache, std::istringstream &stream)
+{
+	size_t pipeline_layout_index{};
+
+	read(stream, pipeline_layout_index);
+
+	std::vector<SpecializationConstant> specialization_constants{};
+	read(stream,
+	     specialization_constants);
+
+	PipelineState pipeline_state{};
+	pipeline_state.set_pipeline_layout(*pipeline_layouts.at(pipeline_layout_index));
+
+	for (auto &constant : specialization_constants)
+	{
+		pipeline_state.set_specialization_constant(constant.constant_id, constant.data.data(), constant.size);
+	}
+
+	resource_cache.request_compute_pipeline(pipeline_state);
+}
+
+void ResourceReplay::create_sampler(ResourceCache &resource_cache, std::istringstream &stream)
+{
+	VkSamplerCreateInfo sampler_info{};
+
+	read(stream, sampler_info);
+
+	sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	sampler_info.pNext = nullptr;
 
-	graphics_pipelines.push_back(&graphics_pipeline);
+	resource_cache.request_sampler(sampler_info);
 }
 }        // namespace vkb
@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <future>
+
 #include "resource_record.h"
 
 namespace vkb
@@ -28,6 +30,9 @@ class ResourceCache;
 
 /**
  * @brief Reads Vulkan objects from a memory stream and creates them in the resource cache.
+ *        Objects are created in the order of the stream, except for the graphics pipelines which nothing depends on:
+ *        they are created on worker threads as soon as their pipeline layout and render pass exist.
+ *        The stream holds every type the cache records, so that playing it builds all the objects a sample requested.
  */
 class ResourceReplay
 {
@@ -36,6 +41,11 @@ class ResourceReplay
 
 	void play(ResourceCache &resource_cache, ResourceRecord &recorder);
 
+	/**
+	 * @return The pipeline layout created for an index of the played stream
+	 */
+	PipelineLayout &get_pipeline_layout(size_t index);
+
   protected:
 	void create_shader_module(ResourceCache &resource_cache, std::istringstream &stream);
 
@@ -45,6 +55,12 @@ class ResourceReplay
 
 	void create_graphics_pipeline(ResourceCache &resource_cache, std::istringstream &stream);
 
+	void create_descriptor_set_layout(ResourceCache &resource_cache, std::istringstream &stream);
+
+	void create_compute_pipeline(ResourceCache &resource_cache, std::istringstream &stream);
+
+	void create_sampler(ResourceCache &resource_cache, std::istringstream &stream);
+
   private:
 	using ResourceFunc = std::function<void(ResourceCache &, std::istringstream &)>;
 
@@ -57,5 +73,8 @@ class ResourceReplay
 	std::vector<const RenderPass *> render_passes;
 
 	std::vector<const GraphicsPipeline *> graphics_pipelines;
+
+	/// Graphics pipelines being created on the job system, in the order of the stream
+	std::vector<std::future<const GraphicsPipeline *>> graphics_pipeline_futures;
 };
 }        // namespace vkb
@@ -0,0 +1,239 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "scene_cache.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "core/device.h"
+
+namespace vkb
+{
+namespace
+{
+/// Identifies the files written by SceneCacheWriter
+constexpr uint32_t SCENE_CACHE_MAGIC = 0x564B4253;        // 'VKBS'
+
+/// Increased when the content of the files changes
+constexpr uint32_t SCENE_CACHE_VERSION = 5;
+
+/**
+ * @brief Header of the cache files, so that files of another format version or device are discarded
+ */
+struct SceneCacheHeader
+{
+	uint32_t magic;
+
+	uint32_t version;
+
+	uint32_t vendor_id;
+
+	uint32_t device_id;
+
+	uint32_t driver_version;
+
+	uint32_t reserved;
+
+	/// Size of the dependencies and the scene description following the header
+	uint64_t description_size;
+};
+
+SceneCacheHeader get_scene_cache_header(const Device &device)
+{
+	auto &properties = device.get_properties();
+
+	SceneCacheHeader header{};
+	header.magic          = SCENE_CACHE_MAGIC;
+	header.version        = SCENE_CACHE_VERSION;
+	header.vendor_id      = properties.vendorID;
+	header.device_id      = properties.deviceID;
+	header.driver_version = properties.driverVersion;
+
+	return header;
+}
+
+uint64_t align_blob_offset(uint64_t offset)
+{
+	return (offset + SceneCacheWriter::BLOB_ALIGNMENT - 1) / SceneCacheWriter::BLOB_ALIGNMENT * SceneCacheWriter::BLOB_ALIGNMENT;
+}
+}        // namespace
+
+SceneCacheWriter::SceneCacheWriter(const Device &device) :
+    device{device}
+{
+}
+
+void SceneCacheWriter::add_dependency(const std::string &filename)
+{
+	Dependency dependency{filename, 0, 0};
+
+	if (!fs::get_file_stamp(fs::path::get(fs::path::Type::Assets) + filename, dependency.size, dependency.modification_time))
+	{
+		throw std::runtime_error("Cannot find the scene asset " + filename);
+	}
+
+	dependencies.push_back(std::move(dependency));
+}
+
+std::ostringstream &SceneCacheWriter::get_stream()
+{
+	return stream;
+}
+
+void SceneCacheWriter::write_blob(const uint8_t *data, size_t size)
+{
+	uint64_t offset = align_blob_offset(blobs.size());
+
+	blobs.resize(static_cast<size_t>(offset));
+	blobs.insert(blobs.end(), data, data + size);
+
+	write(stream, offset, static_cast<uint64_t>(size));
+}
+
+void SceneCacheWriter::write_blob(const std::vector<uint8_t> &data)
+{
+	write_blob(data.data(), data.size());
+}
+
+void SceneCacheWriter::save(const std::string &filename)
+{
+	std::ostringstream dependency_stream;
+
+	write(dependency_stream, dependencies.size());
+
+	for (auto &dependency : dependencies)
+	{
+		write(dependency_stream, dependency.filename, dependency.size, dependency.modification_time);
+	}
+
+	auto description = dependency_stream.str() + stream.str();
+
+	auto header             = get_scene_cache_header(device);
+	header.description_size = description.size();
+
+	auto path = fs::path::get(fs::path::Type::Temp) + filename;
+
+	std::ofstream file{path, std::ios::out | std::ios::binary | std::ios::trunc};
+
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open file: " + path);
+	}
+
+	file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	file.write(description.data(), description.size());
+
+	// Blobs start aligned in the file, as their offsets are aligned relative to it
+	std::vector<char> padding(static_cast<size_t>(align_blob_offset(sizeof(header) + description.size()) - sizeof(header) - description.size()));
+	file.write(padding.data(), padding.size());
+
+	file.write(reinterpret_cast<const char *>(blobs.data()), blobs.size());
+
+	if (!file.good())
+	{
+		throw std::runtime_error("Failed to write file: " + path);
+	}
+}
+
+SceneCacheReader::SceneCacheReader(const Device &device, const std::string &filename) :
+    file{fs::map_file(fs::path::get(fs::path::Type::Temp) + filename)}
+{
+	auto expected_header = get_scene_cache_header(device);
+
+	SceneCacheHeader header{};
+
+	if (file.size() >= sizeof(header))
+	{
+		std::memcpy(&header, file.data(), sizeof(header));
+	}
+
+	header.description_size = 0;
+
+	if (file.size() < sizeof(header) || std::memcmp(&header, &expected_header, sizeof(header)) != 0)
+	{
+		throw std::runtime_error("Scene cache was written for another device, driver or format version");
+	}
+
+	std::memcpy(&header, file.data(), sizeof(header));
+
+	auto blobs_offset = align_blob_offset(sizeof(header) + header.description_size);
+
+	if (blobs_offset > file.size())
+	{
+		throw std::runtime_error("Scene cache is truncated");
+	}
+
+	stream.str(std::string{reinterpret_cast<const char *>(file.data()) + sizeof(header), static_cast<size_t>(header.description_size)});
+
+	blobs      = file.data() + blobs_offset;
+	blobs_size = file.size() - static_cast<size_t>(blobs_offset);
+
+	size_t dependency_count{0};
+	read(stream, dependency_count);
+
+	for (size_t i = 0; i < dependency_count; ++i)
+	{
+		std::string dependency;
+		uint64_t    size{0};
+		int64_t     modification_time{0};
+
+		read(stream, dependency, size, modification_time);
+
+		uint64_t current_size{0};
+		int64_t  current_modification_time{0};
+
+		if (!fs::get_file_stamp(fs::path::get(fs::path::Type::Assets) + dependency, current_size, current_modification_time) ||
+		    current_size != size || current_modification_time != modification_time)
+		{
+			LOGI("Scene cache is stale, {} changed", dependency);
+			fresh = false;
+		}
+	}
+}
+
+bool SceneCacheReader::is_fresh() const
+{
+	return fresh;
+}
+
+std::istringstream &SceneCacheReader::get_stream()
+{
+	return stream;
+}
+
+std::pair<const uint8_t *, size_t> SceneCacheReader::read_blob()
+{
+	uint64_t offset{0};
+	uint64_t size{0};
+
+	read(stream, offset, size);
+
+	if (!stream || offset > blobs_size || size > blobs_size - offset)
+	{
+		throw std::runtime_error("Scene cache blob is outside the file");
+	}
+
+	return {blobs + offset, static_cast<size_t>(size)};
+}
+}        // namespace vkb
@@ -0,0 +1,137 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+class Device;
+
+/**
+ * @brief Writes a cooked scene file, which reloads a scene without parsing or decoding its sources
+ *
+ * The file starts with a header identifying the format version and the device, since images are
+ * stored in the format the device samples. The assets the scene was cooked from follow with their
+ * size and modification time, then the serialized scene description, and finally the blobs of
+ * GPU ready data: vertex and index data, and images with their mip chains. Blobs are aligned,
+ * so that the reader copies them straight from the memory mapped file.
+ */
+class SceneCacheWriter
+{
+  public:
+	/// Alignment of the blobs in the file
+	static constexpr uint64_t BLOB_ALIGNMENT{16};
+
+	SceneCacheWriter(const Device &device);
+
+	/**
+	 * @brief Records an asset the scene is cooked from, the cache is stale once one of them changes
+	 * @param filename The path to the asset (relative to the assets directory)
+	 */
+	void add_dependency(const std::string &filename);
+
+	/**
+	 * @return The stream of the scene description
+	 */
+	std::ostringstream &get_stream();
+
+	/**
+	 * @brief Appends data to the blobs, and writes its location to the scene description
+	 */
+	void write_blob(const uint8_t *data, size_t size);
+
+	void write_blob(const std::vector<uint8_t> &data);
+
+	/**
+	 * @brief Writes the cache file
+	 * @param filename The path to the file (relative to the temporary storage directory)
+	 * @throws runtime_error if the file could not be written
+	 */
+	void save(const std::string &filename);
+
+  private:
+	struct Dependency
+	{
+		std::string filename;
+
+		uint64_t size;
+
+		int64_t modification_time;
+	};
+
+	const Device &device;
+
+	std::vector<Dependency> dependencies;
+
+	std::ostringstream stream;
+
+	std::vector<uint8_t> blobs;
+};
+
+/**
+ * @brief Reads a cooked scene file written by SceneCacheWriter, which is mapped in memory
+ */
+class SceneCacheReader
+{
+  public:
+	/**
+	 * @param device Device the scene is loaded on
+	 * @param filename The path to the file (relative to the temporary storage directory)
+	 * @throws runtime_error if the file could not be read, or was written with another format version or device
+	 */
+	SceneCacheReader(const Device &device, const std::string &filename);
+
+	/**
+	 * @return True if none of the assets the scene was cooked from changed since
+	 */
+	bool is_fresh() const;
+
+	/**
+	 * @return The stream of the scene description
+	 */
+	std::istringstream &get_stream();
+
+	/**
+	 * @brief Reads the location of a blob from the scene description
+	 * @throws runtime_error if the blob is outside the file
+	 * @return The blob inside the mapped file, and its size
+	 */
+	std::pair<const uint8_t *, size_t> read_blob();
+
+  private:
+	fs::MappedFile file;
+
+	bool fresh{true};
+
+	std::istringstream stream;
+
+	const uint8_t *blobs{nullptr};
+
+	size_t blobs_size{0};
+};
+}        // namespace vkb
@@ -20,6 +20,9 @@
 
 #include "aabb.h"
 
+#include <limits>
+
+#include "common/bounds_kernels.h"
 #include "common/logging.h"
 
 namespace vkb
@@ -60,42 +63,33 @@ void AABB::update(SubMesh &submesh)
 		return;
 	}
 
+	VertexAttribute position_attribute;
+	submesh.get_attribute("position", position_attribute);
+
 	// Get buffer data of the vertex position
-	const glm::vec3 *vertices = reinterpret_cast<const glm::vec3 *>(position_buffer->second.map());
+	auto &position_allocation = position_buffer->second;
 
-	// Check if submesh is indexed
-	if (submesh.vertex_indices > 0)
-	{
-		const uint16_t *indices = reinterpret_cast<const uint16_t *>(submesh.index_buffer->map());
+	const uint8_t *position_data = position_allocation.get_buffer().map() + position_allocation.get_offset() + position_attribute.offset;
 
-		// Update bounding box for each indexed vertex
-		for (uint32_t vertex_id = 0; vertex_id < submesh.vertex_indices; vertex_id++)
-		{
-			update(vertices[indices[vertex_id]]);
-		}
-	}
-	else
+	const uint8_t *index_data = nullptr;
+
+	if (submesh.vertex_indices > 0)
 	{
-		// Update bounding box for each vertex
-		for (uint32_t vertex_id = 0; vertex_id < submesh.vertices_count; vertex_id++)
-		{
-			update(vertices[vertex_id]);
-		}
+		index_data = submesh.index_buffer.get_buffer().map() + submesh.index_buffer.get_offset() + submesh.index_offset;
 	}
+
+	update(position_data, position_attribute.stride, submesh.vertices_count, index_data, submesh.vertex_indices, submesh.index_type);
+}
+
+void AABB::update(const uint8_t *position_data, uint32_t stride, uint32_t vertex_count, const uint8_t *index_data, uint32_t index_count, VkIndexType index_type)
+{
+	grow_position_bounds(position_data, stride, vertex_count, index_data, index_count, index_type, min, max);
 }
 
 void AABB::transform(glm::mat4 &transform)
 {
-	min = max = glm::vec4(min, 1.0f) * transform;
-
-	// Update bounding box for the remaining 7 corners of the box
-	update(glm::vec4(min.x, min.y, max.z, 1.0f) * transform);
-	update(glm::vec4(min.x, max.y, min.z, 1.0f) * transform);
-	update(glm::vec4(min.x, max.y, max.z, 1.0f) * transform);
-	update(glm::vec4(max.x, min.y, min.z, 1.0f) * transform);
-	update(glm::vec4(max.x, min.y, max.z, 1.0f) * transform);
-	update(glm::vec4(max.x, max.y, min.z, 1.0f) * transform);
-	update(glm::vec4(max, 1.0f) * transform);
+	// Transforming the center and half extent gives the same box as transforming the 8 corners
+	transform_bounds(glm::vec3{min}, glm::vec3{max}, &transform, 1, &min, &max);
 }
 
 glm::vec3 AABB::get_scale() const
@@ -120,9 +114,9 @@ glm::vec3 AABB::get_max() const
 
 void AABB::reset()
 {
-	min = std::numeric_limits<glm::vec3>::max();
+	min = glm::vec3(std::numeric_limits<float>::max());
 
-	max = std::numeric_limits<glm::vec3>::min();
+	max = glm::vec3(std::numeric_limits<float>::lowest());
 }
 
 }        // namespace sg
@@ -64,6 +64,18 @@ class AABB : public Component
 	 */
 	void update(SubMesh &submesh);
 
+	/**
+	 * @brief Update the bounding box based on vertex data in host memory,
+	 *        for geometry whose buffers cannot be mapped
+	 * @param position_data Vertex positions, stored as three floats
+	 * @param stride Distance in bytes between two positions, zero if tightly packed
+	 * @param vertex_count Number of vertices, used if there are no indices
+	 * @param index_data Index data, or nullptr if the vertices are not indexed
+	 * @param index_count Number of indices
+	 * @param index_type Type of the indices
+	 */
+	void update(const uint8_t *position_data, uint32_t stride, uint32_t vertex_count, const uint8_t *index_data = nullptr, uint32_t index_count = 0, VkIndexType index_type = VK_INDEX_TYPE_UINT16);
+
 	/**
 	 * @brief Apply a given matrix transformation to the bounding box
 	 * @param transform The matrix transform to apply
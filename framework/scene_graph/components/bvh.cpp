@@ -0,0 +1,430 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "bvh.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <unordered_set>
+
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/frustum.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace sg
+{
+namespace
+{
+/// Maximum number of items stored in a leaf node of the tree
+constexpr uint32_t MAX_LEAF_ITEMS = 4;
+
+bool intersects_sphere(const glm::vec3 &min, const glm::vec3 &max, const glm::vec3 &center, float radius)
+{
+	glm::vec3 closest = glm::clamp(center, min, max);
+
+	glm::vec3 offset = closest - center;
+
+	return glm::dot(offset, offset) <= radius * radius;
+}
+
+bool intersects_ray(const glm::vec3 &min, const glm::vec3 &max, const glm::vec3 &origin, const glm::vec3 &inv_direction, float max_distance, float &distance)
+{
+	glm::vec3 t0 = (min - origin) * inv_direction;
+	glm::vec3 t1 = (max - origin) * inv_direction;
+
+	glm::vec3 t_min = glm::min(t0, t1);
+	glm::vec3 t_max = glm::max(t0, t1);
+
+	float t_near = std::max(std::max(t_min.x, t_min.y), std::max(t_min.z, 0.0f));
+	float t_far  = std::min(std::min(t_max.x, t_max.y), std::min(t_max.z, max_distance));
+
+	if (t_near > t_far)
+	{
+		return false;
+	}
+
+	distance = t_near;
+
+	return true;
+}
+}        // namespace
+
+BVH::BVH(Scene &scene) :
+    scene{scene}
+{
+}
+
+std::type_index BVH::get_type()
+{
+	return typeid(BVH);
+}
+
+void BVH::update()
+{
+	if (!needs_rebuild)
+	{
+		// Rebuild if meshes were attached to new nodes since the last build
+		size_t item_count = 0;
+
+		for (auto mesh : scene.get_components<Mesh>())
+		{
+			item_count += mesh->get_nodes().size();
+		}
+
+		needs_rebuild = item_count != leaves.size();
+	}
+
+	if (needs_rebuild)
+	{
+		build();
+	}
+	else
+	{
+		refit();
+	}
+}
+
+void BVH::invalidate()
+{
+	needs_rebuild = true;
+}
+
+size_t BVH::get_item_count() const
+{
+	return leaves.size();
+}
+
+void BVH::build()
+{
+	leaves.clear();
+	nodes.clear();
+	dirty_nodes.clear();
+
+	for (auto mesh : scene.get_components<Mesh>())
+	{
+		for (size_t node_index = 0; node_index < mesh->get_nodes().size(); ++node_index)
+		{
+			Leaf leaf;
+			leaf.item = {mesh, node_index};
+			update_leaf(leaf);
+
+			leaves.push_back(leaf);
+		}
+	}
+
+	if (!leaves.empty())
+	{
+		nodes.reserve(2 * (leaves.size() / MAX_LEAF_ITEMS + 1));
+
+		build_node(0, static_cast<uint32_t>(leaves.size()), 0);
+	}
+
+	needs_rebuild = false;
+}
+
+uint32_t BVH::build_node(uint32_t first, uint32_t count, uint32_t parent)
+{
+	uint32_t index = static_cast<uint32_t>(nodes.size());
+
+	nodes.emplace_back();
+	nodes[index].parent = parent;
+
+	auto begin = leaves.begin() + first;
+	auto end   = begin + count;
+
+	if (count <= MAX_LEAF_ITEMS)
+	{
+		nodes[index].first = first;
+		nodes[index].count = count;
+
+		std::for_each(begin, end, [index](Leaf &leaf) { leaf.node = index; });
+
+		compute_bounds(nodes[index]);
+
+		return index;
+	}
+
+	// Split at the median of the centers along the axis where they are the most spread
+	glm::vec3 center_min{std::numeric_limits<float>::max()};
+	glm::vec3 center_max{std::numeric_limits<float>::lowest()};
+
+	std::for_each(begin, end, [&](const Leaf &leaf) {
+		center_min = glm::min(center_min, leaf.center);
+		center_max = glm::max(center_max, leaf.center);
+	});
+
+	glm::vec3 extent = center_max - center_min;
+
+	int axis = 0;
+	if (extent.y > extent[axis])
+	{
+		axis = 1;
+	}
+	if (extent.z > extent[axis])
+	{
+		axis = 2;
+	}
+
+	uint32_t left_count = count / 2;
+
+	std::nth_element(begin, begin + left_count, end, [axis](const Leaf &a, const Leaf &b) {
+		return a.center[axis] < b.center[axis];
+	});
+
+	// The left child is always built right after its parent
+	build_node(first, left_count, index);
+
+	uint32_t right = build_node(first + left_count, count - left_count, index);
+
+	nodes[index].right = right;
+
+	compute_bounds(nodes[index]);
+
+	return index;
+}
+
+void BVH::refit()
+{
+	// Recompute the world bounds of the moved nodes in one batch per mesh
+	std::unordered_set<Mesh *> moved_meshes;
+
+	for (auto &leaf : leaves)
+	{
+		auto &transform = leaf.item.mesh->get_nodes()[leaf.item.node_index]->get_transform();
+
+		if (leaf.world_matrix_revision != transform.get_world_matrix_revision() && moved_meshes.insert(leaf.item.mesh).second)
+		{
+			leaf.item.mesh->update_world_bounds();
+		}
+	}
+
+	// Find the leaves which moved since the last update
+	for (auto &leaf : leaves)
+	{
+		auto &transform = leaf.item.mesh->get_nodes()[leaf.item.node_index]->get_transform();
+
+		if (leaf.world_matrix_revision == transform.get_world_matrix_revision())
+		{
+			continue;
+		}
+
+		update_leaf(leaf);
+
+		// Flag the branch up to the root, stopping at the first node already flagged
+		uint32_t index = leaf.node;
+
+		while (!nodes[index].dirty)
+		{
+			nodes[index].dirty = true;
+			dirty_nodes.push_back(index);
+
+			if (index == 0)
+			{
+				break;
+			}
+
+			index = nodes[index].parent;
+		}
+	}
+
+	if (dirty_nodes.empty())
+	{
+		return;
+	}
+
+	// Children always have a greater index than their parent, so refit in decreasing order
+	std::sort(dirty_nodes.begin(), dirty_nodes.end(), std::greater<uint32_t>());
+
+	for (auto index : dirty_nodes)
+	{
+		compute_bounds(nodes[index]);
+		nodes[index].dirty = false;
+	}
+
+	dirty_nodes.clear();
+}
+
+void BVH::update_leaf(Leaf &leaf)
+{
+	auto &transform = leaf.item.mesh->get_nodes()[leaf.item.node_index]->get_transform();
+
+	const AABB &bounds = leaf.item.mesh->get_world_bounds(leaf.item.node_index);
+
+	leaf.min                   = bounds.get_min();
+	leaf.max                   = bounds.get_max();
+	leaf.center                = bounds.get_center();
+	leaf.world_matrix_revision = transform.get_world_matrix_revision();
+}
+
+void BVH::compute_bounds(Node &node)
+{
+	if (node.count > 0)
+	{
+		node.min = glm::vec3{std::numeric_limits<float>::max()};
+		node.max = glm::vec3{std::numeric_limits<float>::lowest()};
+
+		for (uint32_t i = node.first; i < node.first + node.count; ++i)
+		{
+			node.min = glm::min(node.min, leaves[i].min);
+			node.max = glm::max(node.max, leaves[i].max);
+		}
+	}
+	else
+	{
+		auto &left  = *(&node + 1);
+		auto &right = nodes[node.right];
+
+		node.min = glm::min(left.min, right.min);
+		node.max = glm::max(left.max, right.max);
+	}
+}
+
+void BVH::query(const Frustum &frustum, std::vector<BVHItem> &items) const
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	std::vector<uint32_t> stack{0};
+
+	while (!stack.empty())
+	{
+		auto &node = nodes[stack.back()];
+		stack.pop_back();
+
+		if (!frustum.intersects(node.min, node.max))
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (uint32_t i = node.first; i < node.first + node.count; ++i)
+			{
+				if (frustum.intersects(leaves[i].min, leaves[i].max))
+				{
+					items.push_back(leaves[i].item);
+				}
+			}
+		}
+		else
+		{
+			stack.push_back(node.right);
+			stack.push_back(static_cast<uint32_t>(&node - nodes.data()) + 1);
+		}
+	}
+}
+
+void BVH::query(const glm::vec3 &center, float radius, std::vector<BVHItem> &items) const
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	std::vector<uint32_t> stack{0};
+
+	while (!stack.empty())
+	{
+		auto &node = nodes[stack.back()];
+		stack.pop_back();
+
+		if (!intersects_sphere(node.min, node.max, center, radius))
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (uint32_t i = node.first; i < node.first + node.count; ++i)
+			{
+				if (intersects_sphere(leaves[i].min, leaves[i].max, center, radius))
+				{
+					items.push_back(leaves[i].item);
+				}
+			}
+		}
+		else
+		{
+			stack.push_back(node.right);
+			stack.push_back(static_cast<uint32_t>(&node - nodes.data()) + 1);
+		}
+	}
+}
+
+bool BVH::raycast(const glm::vec3 &origin, const glm::vec3 &direction, BVHItem &hit, float &distance) const
+{
+	if (nodes.empty())
+	{
+		return false;
+	}
+
+	glm::vec3 inv_direction = 1.0f / direction;
+
+	float closest = std::numeric_limits<float>::max();
+	bool  found   = false;
+
+	std::vector<uint32_t> stack{0};
+
+	while (!stack.empty())
+	{
+		auto &node = nodes[stack.back()];
+		stack.pop_back();
+
+		float node_distance;
+		if (!intersects_ray(node.min, node.max, origin, inv_direction, closest, node_distance))
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (uint32_t i = node.first; i < node.first + node.count; ++i)
+			{
+				float leaf_distance;
+				if (intersects_ray(leaves[i].min, leaves[i].max, origin, inv_direction, closest, leaf_distance))
+				{
+					closest = leaf_distance;
+					hit     = leaves[i].item;
+					found   = true;
+				}
+			}
+		}
+		else
+		{
+			stack.push_back(node.right);
+			stack.push_back(static_cast<uint32_t>(&node - nodes.data()) + 1);
+		}
+	}
+
+	if (found)
+	{
+		distance = closest;
+	}
+
+	return found;
+}
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,171 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "scene_graph/component.h"
+
+namespace vkb
+{
+namespace sg
+{
+class Frustum;
+class Mesh;
+class Scene;
+
+/**
+ * @brief A mesh placed in the scene by one of its nodes
+ */
+struct BVHItem
+{
+	Mesh *mesh{nullptr};
+
+	/// Index of the node in the node list of the mesh
+	size_t node_index{0};
+};
+
+/**
+ * @brief Bounding volume hierarchy over the world space bounds of the scene meshes
+ *
+ * The hierarchy is built lazily on the first update, and rebuilt when meshes
+ * are attached to new nodes. When nodes move, only the branches containing
+ * them are refitted, the structure of the tree is kept.
+ */
+class BVH : public Component
+{
+  public:
+	BVH(Scene &scene);
+
+	virtual ~BVH() = default;
+
+	virtual std::type_index get_type() override;
+
+	/**
+	 * @brief Brings the hierarchy up to date with the scene
+	 *        It must be called before querying the hierarchy if the scene changed
+	 */
+	void update();
+
+	/**
+	 * @brief Forces a full rebuild of the hierarchy on the next update
+	 */
+	void invalidate();
+
+	/**
+	 * @brief Collects the items whose bounds intersect a frustum
+	 * @param frustum The world space frustum
+	 * @param items Vector the visible items are appended to
+	 */
+	void query(const Frustum &frustum, std::vector<BVHItem> &items) const;
+
+	/**
+	 * @brief Collects the items whose bounds intersect a sphere, e.g. the range of a light
+	 * @param center Center of the sphere in world space
+	 * @param radius Radius of the sphere
+	 * @param items Vector the intersected items are appended to
+	 */
+	void query(const glm::vec3 &center, float radius, std::vector<BVHItem> &items) const;
+
+	/**
+	 * @brief Finds the closest item whose bounds are hit by a ray
+	 * @param origin Origin of the ray in world space
+	 * @param direction Direction of the ray
+	 * @param hit The closest item hit by the ray
+	 * @param distance Distance along the ray to the bounds of the item hit, in units of direction
+	 * @return True if an item was hit
+	 */
+	bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, BVHItem &hit, float &distance) const;
+
+	/**
+	 * @return Number of items in the hierarchy
+	 */
+	size_t get_item_count() const;
+
+  private:
+	struct Node
+	{
+		glm::vec3 min;
+
+		glm::vec3 max;
+
+		uint32_t parent{0};
+
+		/// Index of the second child, the first child always follows the node
+		uint32_t right{0};
+
+		/// First leaf of the node, only used if count is not zero
+		uint32_t first{0};
+
+		/// Number of leaves of the node, zero for internal nodes
+		uint32_t count{0};
+
+		bool dirty{false};
+	};
+
+	struct Leaf
+	{
+		BVHItem item;
+
+		glm::vec3 min;
+
+		glm::vec3 max;
+
+		glm::vec3 center;
+
+		uint32_t world_matrix_revision{0};
+
+		/// Tree node containing the leaf
+		uint32_t node{0};
+	};
+
+	void build();
+
+	uint32_t build_node(uint32_t first, uint32_t count, uint32_t parent);
+
+	void refit();
+
+	void update_leaf(Leaf &leaf);
+
+	void compute_bounds(Node &node);
+
+	Scene &scene;
+
+	bool needs_rebuild{true};
+
+	std::vector<Node> nodes;
+
+	std::vector<Leaf> leaves;
+
+	/// Tree nodes whose bounds need to be recomputed
+	std::vector<uint32_t> dirty_nodes;
+};
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,171 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "geometry_arena.h"
+
+#include <algorithm>
+
+#include "common/logging.h"
+#include "core/device.h"
+#include "upload_manager.h"
+
+namespace vkb
+{
+namespace sg
+{
+namespace
+{
+/// Alignment of the allocations, suitable for any vertex format and index type
+constexpr VkDeviceSize ALLOCATION_ALIGNMENT = 16;
+}        // namespace
+
+GeometryArena::GeometryArena(Device &device, VkDeviceSize block_size, VmaMemoryUsage memory_usage) :
+    device{device},
+    block_size{block_size},
+    memory_usage{memory_usage}
+{
+}
+
+std::type_index GeometryArena::get_type()
+{
+	return typeid(GeometryArena);
+}
+
+BufferAllocation GeometryArena::allocate_vertices(VkDeviceSize size)
+{
+	return allocate(vertex_blocks, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, size);
+}
+
+BufferAllocation GeometryArena::allocate_indices(VkDeviceSize size)
+{
+	return allocate(index_blocks, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, size);
+}
+
+size_t GeometryArena::get_buffer_count() const
+{
+	return vertex_blocks.size() + index_blocks.size();
+}
+
+void GeometryArena::update(BufferAllocation &allocation, const std::vector<uint8_t> &data)
+{
+	update(allocation, data.data(), data.size());
+}
+
+void GeometryArena::update(BufferAllocation &allocation, const uint8_t *data, size_t size)
+{
+	assert(size <= allocation.get_size() && "Data is bigger than the allocation");
+
+	if (is_host_visible())
+	{
+		allocation.update(data, size);
+		return;
+	}
+
+	auto &block = find_block(allocation.get_buffer());
+
+	assert(allocation.get_offset() >= block.flushed_offset && "Allocation was already flushed");
+
+	// Keep a host copy of the block, uploaded at once when flushed
+	auto pending_offset = static_cast<size_t>(allocation.get_offset() - block.flushed_offset);
+
+	if (block.pending_data.size() < pending_offset + size)
+	{
+		block.pending_data.resize(pending_offset + size);
+	}
+
+	std::copy(data, data + size, block.pending_data.begin() + pending_offset);
+}
+
+void GeometryArena::flush(UploadManager &upload_manager)
+{
+	for (auto blocks : {&vertex_blocks, &index_blocks})
+	{
+		for (auto &block : *blocks)
+		{
+			if (!block.pending_data.empty())
+			{
+				upload_manager.upload(*block.buffer, block.flushed_offset, block.pending_data.data(), block.pending_data.size(),
+				                      VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT);
+
+				block.pending_data.clear();
+				block.pending_data.shrink_to_fit();
+			}
+
+			block.flushed_offset = block.offset;
+		}
+	}
+}
+
+bool GeometryArena::is_host_visible() const
+{
+	return memory_usage != VMA_MEMORY_USAGE_GPU_ONLY;
+}
+
+VmaMemoryUsage GeometryArena::get_memory_usage() const
+{
+	return memory_usage;
+}
+
+GeometryArena::Block &GeometryArena::find_block(const core::Buffer &buffer)
+{
+	for (auto blocks : {&vertex_blocks, &index_blocks})
+	{
+		for (auto &block : *blocks)
+		{
+			if (block.buffer.get() == &buffer)
+			{
+				return block;
+			}
+		}
+	}
+
+	throw std::runtime_error("Allocation does not belong to the geometry arena");
+}
+
+BufferAllocation GeometryArena::allocate(std::vector<Block> &blocks, VkBufferUsageFlags usage, VkDeviceSize size)
+{
+	assert(size > 0 && "Allocation size must be greater than zero");
+
+	// Allocations are linear, only the last block can have space left
+	if (!blocks.empty())
+	{
+		auto &block = blocks.back();
+
+		auto aligned_offset = (block.offset + ALLOCATION_ALIGNMENT - 1) & ~(ALLOCATION_ALIGNMENT - 1);
+
+		if (aligned_offset + size <= block.buffer->get_size())
+		{
+			block.offset = aligned_offset + size;
+			return BufferAllocation{*block.buffer, size, aligned_offset};
+		}
+	}
+
+	LOGD("Building #{} geometry buffer ({})", blocks.size(), usage);
+
+	Block block;
+	block.buffer = std::make_unique<core::Buffer>(device, std::max(block_size, size), usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, memory_usage);
+	block.offset = size;
+
+	blocks.push_back(std::move(block));
+
+	return BufferAllocation{*blocks.back().buffer, size, 0};
+}
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,145 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "buffer_pool.h"
+#include "common/vk_common.h"
+#include "core/buffer.h"
+#include "scene_graph/component.h"
+
+namespace vkb
+{
+class Device;
+class UploadManager;
+
+namespace sg
+{
+/**
+ * @brief Owner of the vertex and index data of the scene submeshes
+ *
+ * The data is suballocated linearly from a few large buffers, so that the scene
+ * needs one memory allocation per block instead of one per attribute and submesh,
+ * and consecutive draws can share the same buffer bindings.
+ * The allocations live as long as the arena, there is no way to free them.
+ * If the memory is not host visible, writes are kept in host memory and uploaded
+ * block by block when flushed.
+ */
+class GeometryArena : public Component
+{
+  public:
+	/**
+	 * @brief Constructs an empty arena
+	 * @param device Device to create the buffers with
+	 * @param block_size Minimum size of the buffers, bigger allocations get a dedicated buffer
+	 * @param memory_usage Memory usage of the buffers
+	 */
+	GeometryArena(Device &device, VkDeviceSize block_size, VmaMemoryUsage memory_usage);
+
+	virtual ~GeometryArena() = default;
+
+	virtual std::type_index get_type() override;
+
+	/**
+	 * @brief Suballocates memory for vertex data
+	 * @param size Size in bytes of the data
+	 * @return A view on a vertex buffer owned by the arena
+	 */
+	BufferAllocation allocate_vertices(VkDeviceSize size);
+
+	/**
+	 * @brief Suballocates memory for index data
+	 *        The offset of the allocation is aligned to the size of any index type
+	 * @param size Size in bytes of the data
+	 * @return A view on an index buffer owned by the arena
+	 */
+	BufferAllocation allocate_indices(VkDeviceSize size);
+
+	/**
+	 * @brief Writes data to an allocation of the arena
+	 *        Host visible memory is written directly, otherwise the data is queued until the next flush
+	 * @param allocation Allocation returned by the arena
+	 * @param data Data to write, at most the size of the allocation
+	 */
+	void update(BufferAllocation &allocation, const std::vector<uint8_t> &data);
+
+	/**
+	 * @brief Writes data to an allocation of the arena, e.g. straight from a memory mapped file
+	 * @param allocation Allocation returned by the arena
+	 * @param data Data to write
+	 * @param size Size in bytes of the data, at most the size of the allocation
+	 */
+	void update(BufferAllocation &allocation, const uint8_t *data, size_t size);
+
+	/**
+	 * @brief Uploads all the queued writes, for the vertex input stage
+	 *        Allocations cannot be written once flushed
+	 * @param upload_manager Manager recording the uploads
+	 */
+	void flush(UploadManager &upload_manager);
+
+	/**
+	 * @return True if the buffers of the arena can be mapped
+	 */
+	bool is_host_visible() const;
+
+	/**
+	 * @return Number of buffers created by the arena
+	 */
+	size_t get_buffer_count() const;
+
+	VmaMemoryUsage get_memory_usage() const;
+
+  private:
+	struct Block
+	{
+		std::unique_ptr<core::Buffer> buffer;
+
+		/// Start of the unused part of the buffer
+		VkDeviceSize offset{0};
+
+		/// End of the part of the buffer already uploaded
+		VkDeviceSize flushed_offset{0};
+
+		/// Host copy of the data written after flushed_offset
+		std::vector<uint8_t> pending_data;
+	};
+
+	Block &find_block(const core::Buffer &buffer);
+
+	BufferAllocation allocate(std::vector<Block> &blocks, VkBufferUsageFlags usage, VkDeviceSize size);
+
+	Device &device;
+
+	VkDeviceSize block_size;
+
+	VmaMemoryUsage memory_usage;
+
+	std::vector<Block> vertex_blocks;
+
+	std::vector<Block> index_blocks;
+};
+}        // namespace sg
+}        // namespace vkb
@@ -30,15 +30,37 @@ VKBP_DISABLE_WARNINGS()
 VKBP_ENABLE_WARNINGS()
 
 #include "common/utils.h"
+#include "core/device.h"
 #include "platform/filesystem.h"
 #include "scene_graph/components/image/astc.h"
 #include "scene_graph/components/image/ktx.h"
+#include "scene_graph/components/image/ktx2.h"
 #include "scene_graph/components/image/stb.h"
 
 namespace vkb
 {
 namespace sg
 {
+namespace
+{
+uint32_t get_full_mip_level_count(const VkExtent3D &extent)
+{
+	uint32_t level_count = 1;
+
+	for (auto size = std::max(extent.width, extent.height); size > 1; size /= 2)
+	{
+		++level_count;
+	}
+
+	return level_count;
+}
+
+VkExtent3D get_mip_extent(const VkExtent3D &extent, uint32_t level)
+{
+	return {std::max(1u, extent.width >> level), std::max(1u, extent.height >> level), 1u};
+}
+}        // namespace
+
 bool is_astc(const VkFormat format)
 {
 	return (format == VK_FORMAT_ASTC_4x4_UNORM_BLOCK ||
@@ -114,14 +136,20 @@ void Image::create_vk_image(Device &device)
 {
 	assert(!vk_image && !vk_image_view && "Vulkan image already constructed");
 
+	// Levels are copied out of the image when the texture streaming evicts the finest ones,
+	// and they are the source of the blits generating the next level with GPU mipmaps
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
 	vk_image = std::make_unique<core::Image>(device,
 	                                         get_extent(),
 	                                         format,
-	                                         VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	                                         usage,
 	                                         VMA_MEMORY_USAGE_GPU_ONLY, VK_SAMPLE_COUNT_1_BIT,
-	                                         to_u32(mipmaps.size()));
+	                                         get_mip_level_count());
 
 	vk_image_view = std::make_unique<core::ImageView>(*vk_image, VK_IMAGE_VIEW_TYPE_2D);
+
+	device.set_debug_name(VK_OBJECT_TYPE_IMAGE, reinterpret_cast<uint64_t>(vk_image->get_handle()), get_name());
 }
 
 const core::Image &Image::get_vk_image() const
@@ -130,12 +158,52 @@ const core::Image &Image::get_vk_image() const
 	return *vk_image;
 }
 
+core::Image &Image::get_mut_vk_image()
+{
+	assert(vk_image && "Vulkan image was not created");
+	return *vk_image;
+}
+
 const core::ImageView &Image::get_vk_image_view() const
 {
 	assert(vk_image_view && "Vulkan image view was not created");
 	return *vk_image_view;
 }
 
+std::pair<std::unique_ptr<core::Image>, std::unique_ptr<core::ImageView>> Image::replace_vk_image(std::unique_ptr<core::Image> &&image, uint32_t base_level)
+{
+	std::pair<std::unique_ptr<core::Image>, std::unique_ptr<core::ImageView>> previous{std::move(vk_image), std::move(vk_image_view)};
+
+	vk_image       = std::move(image);
+	base_mip_level = base_level;
+
+	if (vk_image)
+	{
+		vk_image_view = std::make_unique<core::ImageView>(*vk_image, VK_IMAGE_VIEW_TYPE_2D);
+
+		vk_image->get_device().set_debug_name(VK_OBJECT_TYPE_IMAGE, reinterpret_cast<uint64_t>(vk_image->get_handle()), get_name());
+	}
+
+	return previous;
+}
+
+std::unique_ptr<core::ImageView> Image::set_base_mip_level(uint32_t base_level)
+{
+	assert(vk_image && vk_image->get_subresource().mipLevel == get_mip_level_count() && "Vulkan image does not hold the full chain");
+
+	auto previous = std::move(vk_image_view);
+
+	vk_image_view  = std::make_unique<core::ImageView>(*vk_image, VK_IMAGE_VIEW_TYPE_2D, VK_FORMAT_UNDEFINED, base_level);
+	base_mip_level = base_level;
+
+	return previous;
+}
+
+uint32_t Image::get_base_mip_level() const
+{
+	return base_mip_level;
+}
+
 Mipmap &Image::get_mipmap(const size_t index)
 {
 	return mipmaps.at(index);
@@ -151,40 +219,85 @@ void Image::generate_mipmaps()
 	}
 
 	auto extent      = get_extent();
-	auto next_width  = std::max<uint32_t>(1u, extent.width / 2);
-	auto next_height = std::max<uint32_t>(1u, extent.height / 2);
-	auto channels    = 4;
-	auto next_size   = next_width * next_height * channels;
+	auto level_count = get_full_mip_level_count(extent);
+	auto channels    = 4u;
 
-	while (true)
+	// Size the data for the whole chain at once instead of growing it level by level
+	size_t chain_size = data.size();
+	for (uint32_t level = 1; level < level_count; ++level)
 	{
-		// Make space for next mipmap
-		auto old_size = to_u32(data.size());
-		data.resize(old_size + next_size);
+		auto level_extent = get_mip_extent(extent, level);
+		chain_size += level_extent.width * level_extent.height * channels;
+	}
+	data.resize(chain_size);
+	mipmaps.reserve(level_count);
+
+	for (uint32_t level = 1; level < level_count; ++level)
+	{
+		auto prev_mipmap = mipmaps.back();
 
-		auto &prev_mipmap = mipmaps.back();
-		// Update mipmaps
 		Mipmap next_mipmap{};
-		next_mipmap.level  = prev_mipmap.level + 1;
-		next_mipmap.offset = old_size;
-		next_mipmap.extent = {next_width, next_height, 1u};
+		next_mipmap.level  = level;
+		next_mipmap.offset = prev_mipmap.offset + prev_mipmap.extent.width * prev_mipmap.extent.height * channels;
+		next_mipmap.extent = get_mip_extent(extent, level);
 
 		// Fill next mipmap memory
 		stbir_resize_uint8(data.data() + prev_mipmap.offset, prev_mipmap.extent.width, prev_mipmap.extent.height, 0,
 		                   data.data() + next_mipmap.offset, next_mipmap.extent.width, next_mipmap.extent.height, 0, channels);
 
 		mipmaps.emplace_back(std::move(next_mipmap));
+	}
+}
+
+bool Image::request_gpu_mipmaps(Device &device)
+{
+	assert(!vk_image && "Mipmaps must be requested before creating the Vulkan image");
+	assert(mipmaps.size() == 1 && "Mipmaps already generated");
 
-		// Next mipmap values
-		next_width  = std::max<uint32_t>(1u, next_width / 2);
-		next_height = std::max<uint32_t>(1u, next_height / 2);
-		next_size   = next_width * next_height * channels;
+	// Levels are produced by blitting each one from the previous, with a linear filter
+	const VkFormatFeatureFlags required_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+	                                               VK_FORMAT_FEATURE_BLIT_DST_BIT |
+	                                               VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
 
-		if (next_width == 1 && next_height == 1)
-		{
-			break;
-		}
+	auto format_properties = device.get_format_properties(format);
+
+	if ((format_properties.optimalTilingFeatures & required_features) != required_features)
+	{
+		LOGW("Format of image {} cannot be blitted with a linear filter, generating mipmaps on the CPU", get_name());
+		generate_mipmaps();
+		return false;
 	}
+
+	gpu_mipmaps = true;
+
+	return true;
+}
+
+uint32_t Image::get_mip_level_count() const
+{
+	return gpu_mipmaps ? get_full_mip_level_count(get_extent()) : to_u32(mipmaps.size());
+}
+
+void Image::remove_mip_levels(uint32_t count)
+{
+	assert(!vk_image && "Levels must be removed before creating the Vulkan image");
+	assert(count < mipmaps.size() && "At least one level must remain");
+
+	auto offset = mipmaps.at(count).offset;
+
+	data.erase(data.begin(), data.begin() + offset);
+	mipmaps.erase(mipmaps.begin(), mipmaps.begin() + count);
+
+	for (auto &mipmap : mipmaps)
+	{
+		mipmap.level -= count;
+		mipmap.offset -= offset;
+	}
+}
+
+const std::string &Image::get_uri() const
+{
+	return uri;
 }
 
 std::vector<Mipmap> &Image::get_mut_mipmaps()
@@ -223,26 +336,41 @@ void Image::set_depth(const uint32_t depth)
 	mipmaps.at(0).extent.depth = depth;
 }
 
+void Image::set_uri(const std::string &new_uri)
+{
+	uri = new_uri;
+}
+
 std::unique_ptr<Image> Image::load(const std::string &name, const std::string &uri)
 {
 	std::unique_ptr<Image> image{nullptr};
 
-	auto data = fs::read_asset(uri);
+	// Decoders read the mapped file directly, instead of a copy of it
+	auto file = fs::map_asset(uri);
 
 	// Get extension
 	auto extension = get_extension(uri);
 
 	if (extension == "png" || extension == "jpg")
 	{
-		image = std::make_unique<Stb>(name, data);
+		image = std::make_unique<Stb>(name, file.data(), file.size());
 	}
 	else if (extension == "astc")
 	{
-		image = std::make_unique<Astc>(name, data);
+		image = std::make_unique<Astc>(name, file.data(), file.size());
 	}
 	else if (extension == "ktx")
 	{
-		image = std::make_unique<Ktx>(name, data);
+		image = std::make_unique<Ktx>(name, file.data(), file.size());
+	}
+	else if (extension == "ktx2")
+	{
+		image = std::make_unique<Ktx2>(name, file.data(), file.size());
+	}
+
+	if (image)
+	{
+		image->set_uri(uri);
 	}
 
 	return image;
@@ -23,6 +23,7 @@
 #include <memory>
 #include <string>
 #include <typeinfo>
+#include <utility>
 #include <vector>
 
 #include <volk.h>
@@ -77,14 +78,65 @@ class Image : public Component
 
 	const std::vector<Mipmap> &get_mipmaps() const;
 
+	/**
+	 * @brief Generates the full mip chain on the CPU, from the first level down to 1x1
+	 */
 	void generate_mipmaps();
 
+	/**
+	 * @brief Requests the mip chain to be generated on the GPU with linear blits when the image is uploaded,
+	 *        so only the first level is stored and transferred. Falls back to generate_mipmaps()
+	 *        if the format cannot be blitted with a linear filter on this device.
+	 *        Must be called before create_vk_image()
+	 * @return Whether the mip levels will be generated on the GPU
+	 */
+	bool request_gpu_mipmaps(Device &device);
+
+	/**
+	 * @return The number of mip levels of the full chain, including those generated on the GPU
+	 */
+	uint32_t get_mip_level_count() const;
+
+	/**
+	 * @brief Removes the finest levels of the data, so that the Vulkan image created afterwards only holds the others
+	 * @param count Number of levels to remove, the first remaining one becomes level 0
+	 */
+	void remove_mip_levels(uint32_t count);
+
+	/**
+	 * @return Path of the file the image was loaded from, relative to the assets, empty if it was not loaded from a file
+	 */
+	const std::string &get_uri() const;
+
 	void create_vk_image(Device &device);
 
 	const core::Image &get_vk_image() const;
 
+	core::Image &get_mut_vk_image();
+
 	const core::ImageView &get_vk_image_view() const;
 
+	/**
+	 * @brief Replaces the Vulkan image and its view, e.g. by an image holding fewer levels while streaming
+	 * @param image New image, may be null to take the current one out
+	 * @param base_level Level of the full chain stored in the first level of the new image
+	 * @return The previous image and view, to keep alive while frames in flight may still sample them
+	 */
+	std::pair<std::unique_ptr<core::Image>, std::unique_ptr<core::ImageView>> replace_vk_image(std::unique_ptr<core::Image> &&image, uint32_t base_level = 0);
+
+	/**
+	 * @brief Replaces the view of a Vulkan image holding the full chain by one starting at another level,
+	 *        e.g. when the levels of a partially resident image are committed or decommitted while streaming
+	 * @param base_level First level of the full chain seen by the new view
+	 * @return The previous view, to keep alive while frames in flight may still sample it
+	 */
+	std::unique_ptr<core::ImageView> set_base_mip_level(uint32_t base_level);
+
+	/**
+	 * @return First level of the full chain seen by the view of the Vulkan image
+	 */
+	uint32_t get_base_mip_level() const;
+
   protected:
 	std::vector<uint8_t> &get_mut_data();
 
@@ -98,6 +150,8 @@ class Image : public Component
 
 	void set_depth(uint32_t depth);
 
+	void set_uri(const std::string &uri);
+
 	Mipmap &get_mipmap(size_t index);
 
 	std::vector<Mipmap> &get_mut_mipmaps();
@@ -109,9 +163,16 @@ class Image : public Component
 
 	std::vector<Mipmap> mipmaps{{}};
 
+	std::string uri;
+
+	/// Whether the levels after the first are filled by blits at upload time
+	bool gpu_mipmaps{false};
+
 	std::unique_ptr<core::Image> vk_image;
 
 	std::unique_ptr<core::ImageView> vk_image_view;
+
+	uint32_t base_mip_level{0};
 };
 
 }        // namespace sg
@@ -20,7 +20,9 @@
 
 #include "scene_graph/components/image/astc.h"
 
+#include <algorithm>
 #include <mutex>
+#include <thread>
 
 #include "common/error.h"
 
@@ -34,6 +36,9 @@ VKBP_ENABLE_WARNINGS()
 
 #define MAGIC_FILE_CONSTANT 0x5CA1AB13
 
+/// Minimum number of block rows worth starting a decoding thread for
+#define MIN_DECODE_ROWS_PER_THREAD 32
+
 namespace vkb
 {
 namespace sg
@@ -146,14 +151,28 @@ void Astc::decode(BlockDim blockdim, VkExtent3D extent, const uint8_t *data_)
 	int yblocks = (ysize + ydim - 1) / ydim;
 	int zblocks = (zsize + zdim - 1) / zdim;
 
+	{
+		// The library builds its block tables lazily, build them before any thread decodes with them
+		static std::mutex           tables;
+		std::lock_guard<std::mutex> lock{tables};
+		get_block_size_descriptor(xdim, ydim, zdim);
+		for (int partition_count = 1; partition_count <= 4; partition_count++)
+		{
+			get_partition_table(xdim, ydim, zdim, partition_count);
+		}
+	}
+
 	auto astc_image = allocate_image(bitness, xsize, ysize, zsize, 0);
 	initialize_image(astc_image);
 
-	imageblock pb;
-	for (int z = 0; z < zblocks; z++)
-	{
-		for (int y = 0; y < yblocks; y++)
+	// Decodes the block rows in [first_row, end_row), rows of all the z slices are numbered consecutively
+	auto decode_rows = [&](int first_row, int end_row) {
+		imageblock pb;
+		for (int row = first_row; row < end_row; row++)
 		{
+			int z = row / yblocks;
+			int y = row % yblocks;
+
 			for (int x = 0; x < xblocks; x++)
 			{
 				int            offset = (((z * yblocks + y) * xblocks) + x) * 16;
@@ -167,6 +186,25 @@ void Astc::decode(BlockDim blockdim, VkExtent3D extent, const uint8_t *data_)
 				write_imageblock(astc_image, &pb, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, swz_decode);
 			}
 		}
+	};
+
+	// Split the block rows in bands decoded in parallel, each band writes a disjoint part of the image.
+	// Small images are decoded on the calling thread, as images are already loaded in parallel
+	int row_count    = yblocks * zblocks;
+	int thread_count = std::max(1, std::min(row_count / MIN_DECODE_ROWS_PER_THREAD, static_cast<int>(std::thread::hardware_concurrency())));
+	int band_size    = (row_count + thread_count - 1) / thread_count;
+
+	std::vector<std::thread> workers;
+	for (int first_row = band_size; first_row < row_count; first_row += band_size)
+	{
+		workers.emplace_back(decode_rows, first_row, std::min(row_count, first_row + band_size));
+	}
+
+	decode_rows(0, std::min(row_count, band_size));
+
+	for (auto &worker : workers)
+	{
+		worker.join();
 	}
 
 	set_data(astc_image->imagedata8[0][0], astc_image->xsize * astc_image->ysize * astc_image->zsize * 4);
@@ -181,22 +219,24 @@ void Astc::decode(BlockDim blockdim, VkExtent3D extent, const uint8_t *data_)
 Astc::Astc(const Image &image) :
     Image{image.get_name()}
 {
+	set_uri(image.get_uri());
+
 	init();
 	decode(to_blockdim(image.get_format()), image.get_extent(), image.get_data().data());
 }
 
-Astc::Astc(const std::string &name, const std::vector<uint8_t> &data) :
+Astc::Astc(const std::string &name, const uint8_t *data, size_t size) :
     Image{name}
 {
 	init();
 
 	// Read header
-	if (data.size() < sizeof(AstcHeader))
+	if (size < sizeof(AstcHeader))
 	{
 		throw std::runtime_error{"Error reading astc: invalid memory"};
 	}
 	AstcHeader header{};
-	std::memcpy(&header, data.data(), sizeof(AstcHeader));
+	std::memcpy(&header, data, sizeof(AstcHeader));
 	uint32_t magicval = header.magic[0] + 256 * static_cast<uint32_t>(header.magic[1]) + 65536 * static_cast<uint32_t>(header.magic[2]) + 16777216 * static_cast<uint32_t>(header.magic[3]);
 	if (magicval != MAGIC_FILE_CONSTANT)
 	{
@@ -213,7 +253,7 @@ Astc::Astc(const std::string &name, const std::vector<uint8_t> &data) :
 	    /* height = */ static_cast<uint32_t>(header.ysize[0] + 256 * header.ysize[1] + 65536 * header.ysize[2]),
 	    /* depth  = */ static_cast<uint32_t>(header.zsize[0] + 256 * header.zsize[1] + 65536 * header.zsize[2])};
 
-	decode(blockdim, extent, data.data() + sizeof(AstcHeader));
+	decode(blockdim, extent, data + sizeof(AstcHeader));
 }
 
 }        // namespace sg
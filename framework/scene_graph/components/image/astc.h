@@ -47,8 +47,9 @@ class Astc : public Image
 	 * @brief Decodes ASTC data with an ASTC header
 	 * @param name Name of the component
 	 * @param data ASTC data with header
+	 * @param size Size of the data in bytes
 	 */
-	Astc(const std::string &name, const std::vector<uint8_t> &data);
+	Astc(const std::string &name, const uint8_t *data, size_t size);
 
 	virtual ~Astc() = default;
 
@@ -63,11 +63,11 @@ static KTX_error_code KTXAPIENTRY optimal_tiling_callback(int mip_level,
 	return KTX_SUCCESS;
 }
 
-Ktx::Ktx(const std::string &name, const std::vector<uint8_t> &data) :
+Ktx::Ktx(const std::string &name, const uint8_t *data, size_t size) :
     Image{name}
 {
-	auto data_buffer = reinterpret_cast<const ktx_uint8_t *>(data.data());
-	auto data_size   = static_cast<ktx_size_t>(data.size());
+	auto data_buffer = reinterpret_cast<const ktx_uint8_t *>(data);
+	auto data_size   = static_cast<ktx_size_t>(size);
 
 	ktxTexture *texture;
 	auto        load_ktx_result = ktxTexture_CreateFromMemory(data_buffer,
@@ -88,9 +88,9 @@ Ktx::Ktx(const std::string &name, const std::vector<uint8_t> &data) :
 	{
 		// Load
 		auto &mut_data = get_mut_data();
-		auto  size     = ktxTexture_GetSize(texture);
-		mut_data.resize(size);
-		auto load_data_result = ktxTexture_LoadImageData(texture, mut_data.data(), size);
+		auto  texture_size = ktxTexture_GetSize(texture);
+		mut_data.resize(texture_size);
+		auto load_data_result = ktxTexture_LoadImageData(texture, mut_data.data(), texture_size);
 		if (load_data_result != KTX_SUCCESS)
 		{
 			throw std::runtime_error{"Error loading KTX image data: " + name};
@@ -103,7 +103,7 @@ Ktx::Ktx(const std::string &name, const std::vector<uint8_t> &data) :
 	set_depth(texture->baseDepth);
 
 	// Update format
-	auto updated_format = vkGetFormatFromOpenGLInternalFormat(texture->glInternalformat);
+	auto updated_format = vkGetFormatFromOpenGLInternalFormat(reinterpret_cast<ktxTexture1 *>(texture)->glInternalformat);
 	set_format(updated_format);
 
 	// Update mip levels
@@ -0,0 +1,178 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "scene_graph/components/image/ktx2.h"
+
+#include <algorithm>
+
+#include "common/error.h"
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "core/device.h"
+
+VKBP_DISABLE_WARNINGS()
+#include <ktx.h>
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+namespace sg
+{
+namespace
+{
+struct TranscodeTarget
+{
+	ktx_transcode_fmt_e ktx_format;
+
+	VkFormat unorm_format;
+
+	VkFormat srgb_format;
+};
+
+/// Block compressed targets in order of preference, ASTC being the native format of most mobile GPUs
+const TranscodeTarget transcode_targets[] = {
+    {KTX_TTF_ASTC_4x4_RGBA, VK_FORMAT_ASTC_4x4_UNORM_BLOCK, VK_FORMAT_ASTC_4x4_SRGB_BLOCK},
+    {KTX_TTF_ETC2_RGBA, VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK},
+    {KTX_TTF_BC7_RGBA, VK_FORMAT_BC7_UNORM_BLOCK, VK_FORMAT_BC7_SRGB_BLOCK}};
+
+ktxTexture2 *create_texture(const std::string &name, const uint8_t *data, size_t size)
+{
+	ktxTexture2 *texture;
+	auto         result = ktxTexture2_CreateFromMemory(reinterpret_cast<const ktx_uint8_t *>(data),
+                                                static_cast<ktx_size_t>(size),
+                                                KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                                &texture);
+	if (result != KTX_SUCCESS)
+	{
+		throw std::runtime_error{"Error loading KTX2 texture: " + name};
+	}
+
+	return texture;
+}
+}        // namespace
+
+Ktx2::Ktx2(const std::string &name, const uint8_t *data, size_t size) :
+    Image{name}
+{
+	auto texture = create_texture(name, data, size);
+
+	set_width(texture->baseWidth);
+	set_height(texture->baseHeight);
+	set_depth(texture->baseDepth);
+
+	if (ktxTexture2_NeedsTranscoding(texture))
+	{
+		// The target format depends on the device, keep the file until transcode()
+		set_data(data, size);
+		transcoding_needed = true;
+	}
+	else
+	{
+		load_levels(texture);
+	}
+
+	ktxTexture_Destroy(ktxTexture(texture));
+}
+
+bool Ktx2::needs_transcoding() const
+{
+	return transcoding_needed;
+}
+
+void Ktx2::transcode(Device &device)
+{
+	assert(transcoding_needed && "Image is not supercompressed");
+
+	std::vector<uint8_t> file_data;
+	std::swap(file_data, get_mut_data());
+
+	auto texture = create_texture(get_name(), file_data.data(), file_data.size());
+
+	bool srgb = ktxTexture2_GetOETF(texture) == KHR_DF_TRANSFER_SRGB;
+
+	// Uncompressed RGBA quadruples the memory and bandwidth, it is only used when no block format is supported
+	ktx_transcode_fmt_e ktx_format = KTX_TTF_RGBA32;
+
+	for (auto &target : transcode_targets)
+	{
+		auto format = srgb ? target.srgb_format : target.unorm_format;
+
+		if (device.get_format_properties(format).optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)
+		{
+			ktx_format = target.ktx_format;
+			break;
+		}
+	}
+
+	if (ktx_format == KTX_TTF_RGBA32)
+	{
+		LOGW("No block compressed format supported: transcoding {} to RGBA", get_name());
+	}
+
+	auto result = ktxTexture2_TranscodeBasis(texture, ktx_format, 0);
+	if (result != KTX_SUCCESS)
+	{
+		ktxTexture_Destroy(ktxTexture(texture));
+		throw std::runtime_error{"Error transcoding KTX2 texture: " + get_name()};
+	}
+
+	// Transcoding updates the Vulkan format of the texture
+	load_levels(texture);
+
+	ktxTexture_Destroy(ktxTexture(texture));
+
+	transcoding_needed = false;
+}
+
+void Ktx2::load_levels(ktxTexture2 *texture)
+{
+	set_format(static_cast<VkFormat>(texture->vkFormat));
+
+	auto &mut_data    = get_mut_data();
+	auto &mut_mipmaps = get_mut_mipmaps();
+
+	mut_data.clear();
+	mut_mipmaps.clear();
+
+	// KTX2 stores the smallest level first, while the levels are uploaded in increasing order
+	for (uint32_t level = 0; level < texture->numLevels; ++level)
+	{
+		ktx_size_t offset;
+		if (ktxTexture_GetImageOffset(ktxTexture(texture), level, 0, 0, &offset) != KTX_SUCCESS)
+		{
+			throw std::runtime_error{"Error loading KTX2 image data: " + get_name()};
+		}
+
+		auto size = ktxTexture_GetImageSize(ktxTexture(texture), level);
+
+		Mipmap mipmap{};
+		mipmap.level  = level;
+		mipmap.offset = to_u32(mut_data.size());
+		mipmap.extent = {std::max(1u, texture->baseWidth >> level),
+		                 std::max(1u, texture->baseHeight >> level),
+		                 std::max(1u, texture->baseDepth >> level)};
+
+		mut_data.insert(mut_data.end(), texture->pData + offset, texture->pData + offset + size);
+		mut_mipmaps.push_back(mipmap);
+	}
+}
+
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,66 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "common/error.h"
+#include "scene_graph/components/image.h"
+
+struct ktxTexture2;
+
+namespace vkb
+{
+class Device;
+
+namespace sg
+{
+/**
+ * @brief KTX2 image, optionally supercompressed with Basis Universal (ETC1S or UASTC)
+ *        Supercompressed images keep their file data until transcode() converts them
+ *        to the best block compressed format sampled by the device, or to RGBA as a last resort
+ */
+class Ktx2 : public Image
+{
+  public:
+	Ktx2(const std::string &name, const uint8_t *data, size_t size);
+
+	virtual ~Ktx2() = default;
+
+	/**
+	 * @return Whether the image holds Basis Universal data, which must be transcoded before creating the Vulkan image
+	 */
+	bool needs_transcoding() const;
+
+	/**
+	 * @brief Transcodes the image to ASTC, ETC2 or BC7, picking the first one the device can sample
+	 */
+	void transcode(Device &device);
+
+  private:
+	/**
+	 * @brief Copies the levels of a texture which is not supercompressed, in increasing order
+	 */
+	void load_levels(ktxTexture2 *texture);
+
+	bool transcoding_needed{false};
+};
+
+}        // namespace sg
+}        // namespace vkb
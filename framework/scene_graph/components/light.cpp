@@ -63,5 +63,15 @@ const LightProperties &Light::get_properties()
 	return properties;
 }
 
+void Light::set_shadow_properties(const ShadowProperties &shadow_properties)
+{
+	this->shadow_properties = shadow_properties;
+}
+
+const ShadowProperties &Light::get_shadow_properties()
+{
+	return shadow_properties;
+}
+
 }        // namespace sg
 }        // namespace vkb
@@ -60,6 +60,24 @@ struct LightProperties
 	float outer_cone_angle{0.0f};
 };
 
+struct ShadowProperties
+{
+	/// Whether the light casts shadows when the subpass drawing the scene supports them
+	bool cast_shadows{true};
+
+	/// Number of cascades splitting the view frustum, at most MAX_SHADOW_CASCADES
+	uint32_t cascade_count{4};
+
+	/// Blend between a uniform (0) and a logarithmic (1) distribution of the cascade splits
+	float split_lambda{0.75f};
+
+	/// Distance from the camera beyond which no shadows are drawn, if it is closer than the far plane
+	float max_distance{50.0f};
+
+	/// Size in texels of each cascade
+	uint32_t resolution{1024};
+};
+
 class Light : public Component
 {
   public:
@@ -83,12 +101,18 @@ class Light : public Component
 
 	const LightProperties &get_properties();
 
+	void set_shadow_properties(const ShadowProperties &shadow_properties);
+
+	const ShadowProperties &get_shadow_properties();
+
   private:
 	Node *node{nullptr};
 
 	LightType light_type;
 
 	LightProperties properties;
+
+	ShadowProperties shadow_properties;
 };
 
 }        // namespace sg
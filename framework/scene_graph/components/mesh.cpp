@@ -20,6 +20,9 @@
 
 #include "mesh.h"
 
+#include "common/bounds_kernels.h"
+#include "scene_graph/node.h"
+
 namespace vkb
 {
 namespace sg
@@ -43,6 +46,25 @@ void Mesh::add_submesh(SubMesh &submesh)
 	submeshes.push_back(&submesh);
 
 	bounds.update(submesh);
+
+	// Local bounds changed, so all the world bounds are outdated
+	for (auto &node_bounds : world_bounds)
+	{
+		node_bounds.valid = false;
+	}
+}
+
+void Mesh::add_submesh(SubMesh &submesh, const AABB &submesh_bounds)
+{
+	submeshes.push_back(&submesh);
+
+	bounds.update(submesh_bounds.get_min());
+	bounds.update(submesh_bounds.get_max());
+
+	for (auto &node_bounds : world_bounds)
+	{
+		node_bounds.valid = false;
+	}
 }
 
 const std::vector<SubMesh *> &Mesh::get_submeshes() const
@@ -53,11 +75,78 @@ const std::vector<SubMesh *> &Mesh::get_submeshes() const
 void Mesh::add_node(Node &node)
 {
 	nodes.push_back(&node);
+
+	world_bounds.emplace_back();
 }
 
 const std::vector<Node *> &Mesh::get_nodes() const
 {
 	return nodes;
 }
+
+const AABB &Mesh::get_world_bounds(size_t node_index)
+{
+	assert(node_index < nodes.size() && "Node index out of range");
+
+	auto &transform   = nodes[node_index]->get_transform();
+	auto &node_bounds = world_bounds[node_index];
+
+	if (!node_bounds.valid || node_bounds.world_matrix_revision != transform.get_world_matrix_revision())
+	{
+		auto world_matrix = transform.get_world_matrix();
+
+		auto &node_aabb = *node_bounds.bounds;
+		node_aabb.reset();
+		node_aabb.update(bounds.get_min());
+		node_aabb.update(bounds.get_max());
+		node_aabb.transform(world_matrix);
+
+		node_bounds.world_matrix_revision = transform.get_world_matrix_revision();
+		node_bounds.valid                 = true;
+	}
+
+	return *node_bounds.bounds;
+}
+
+void Mesh::update_world_bounds()
+{
+	std::vector<size_t>    outdated_nodes;
+	std::vector<glm::mat4> world_matrices;
+
+	for (size_t node_index = 0; node_index < nodes.size(); ++node_index)
+	{
+		auto &transform   = nodes[node_index]->get_transform();
+		auto &node_bounds = world_bounds[node_index];
+
+		if (!node_bounds.valid || node_bounds.world_matrix_revision != transform.get_world_matrix_revision())
+		{
+			outdated_nodes.push_back(node_index);
+			world_matrices.push_back(transform.get_world_matrix());
+		}
+	}
+
+	if (outdated_nodes.empty())
+	{
+		return;
+	}
+
+	std::vector<glm::vec3> world_min(outdated_nodes.size());
+	std::vector<glm::vec3> world_max(outdated_nodes.size());
+
+	transform_bounds(bounds.get_min(), bounds.get_max(), world_matrices.data(), world_matrices.size(), world_min.data(), world_max.data());
+
+	for (size_t i = 0; i < outdated_nodes.size(); ++i)
+	{
+		auto &transform   = nodes[outdated_nodes[i]]->get_transform();
+		auto &node_bounds = world_bounds[outdated_nodes[i]];
+
+		node_bounds.bounds->reset();
+		node_bounds.bounds->update(world_min[i]);
+		node_bounds.bounds->update(world_max[i]);
+
+		node_bounds.world_matrix_revision = transform.get_world_matrix_revision();
+		node_bounds.valid                 = true;
+	}
+}
 }        // namespace sg
 }        // namespace vkb
@@ -47,18 +47,51 @@ class Mesh : public Component
 
 	void add_submesh(SubMesh &submesh);
 
+	/**
+	 * @brief Adds a submesh whose bounds are already known, so that its buffers are not read back
+	 * @param submesh The submesh to add
+	 * @param submesh_bounds Bounds of the submesh vertices
+	 */
+	void add_submesh(SubMesh &submesh, const AABB &submesh_bounds);
+
 	const std::vector<SubMesh *> &get_submeshes() const;
 
 	void add_node(Node &node);
 
 	const std::vector<Node *> &get_nodes() const;
 
+	/**
+	 * @brief Bounds of the mesh in world space for one of its nodes,
+	 *        only recomputed after the world matrix of the node is invalidated
+	 * @param node_index Index of the node in the list returned by get_nodes()
+	 * @return The world space bounding box
+	 */
+	const AABB &get_world_bounds(size_t node_index);
+
+	/**
+	 * @brief Recomputes the outdated world bounds of all the nodes in one batch,
+	 *        to be called before querying the bounds of many nodes, such as when culling
+	 */
+	void update_world_bounds();
+
   private:
+	struct WorldBounds
+	{
+		std::unique_ptr<AABB> bounds{std::make_unique<AABB>()};
+
+		uint32_t world_matrix_revision{0};
+
+		bool valid{false};
+	};
+
 	AABB bounds;
 
 	std::vector<SubMesh *> submeshes;
 
 	std::vector<Node *> nodes;
+
+	/// Cached world space bounds, one per node
+	std::vector<WorldBounds> world_bounds;
 };
 }        // namespace sg
 }        // namespace vkb
@@ -60,6 +60,16 @@ float PerspectiveCamera::get_field_of_view()
 	return aspect_ratio > 1.0f ? fov : vfov;
 }
 
+float PerspectiveCamera::get_far_plane() const
+{
+	return far_plane;
+}
+
+float PerspectiveCamera::get_near_plane() const
+{
+	return near_plane;
+}
+
 float PerspectiveCamera::get_aspect_ratio()
 {
 	return aspect_ratio;
@@ -57,6 +57,10 @@ class PerspectiveCamera : public Camera
 
 	float get_field_of_view();
 
+	float get_far_plane() const;
+
+	float get_near_plane() const;
+
 	virtual glm::mat4 get_projection() override;
 
   private:
@@ -35,7 +35,10 @@ namespace sg
 class Sampler : public Component
 {
   public:
-	Sampler(const std::string &name, core::Sampler &&vk_sampler);
+	/**
+	 * @param vk_sampler Sampler outliving the component, usually shared through the ResourceCache
+	 */
+	Sampler(const std::string &name, const core::Sampler &vk_sampler);
 
 	Sampler(Sampler &&other) = default;
 
@@ -43,7 +46,7 @@ class Sampler : public Component
 
 	virtual std::type_index get_type() override;
 
-	core::Sampler vk_sampler;
+	const core::Sampler &vk_sampler;
 };
 }        // namespace sg
 }        // namespace vkb
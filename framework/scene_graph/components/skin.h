@@ -0,0 +1,75 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "scene_graph/component.h"
+
+namespace vkb
+{
+namespace sg
+{
+class Node;
+
+/**
+ * @brief Joints deforming a skinned mesh, shared by the nodes drawing the mesh
+ *        The vertices reference the joints by their index, and are weighted by the weights_0 attribute.
+ */
+class Skin : public Component
+{
+  public:
+	/**
+	 * @param name Name of the skin
+	 * @param joints Nodes of the joints
+	 * @param inverse_bind_matrices Matrices moving the vertices from model space to the space of each joint, in the bind pose
+	 */
+	Skin(const std::string &name, std::vector<Node *> &&joints, std::vector<glm::mat4> &&inverse_bind_matrices);
+
+	virtual ~Skin() = default;
+
+	virtual std::type_index get_type() override;
+
+	const std::vector<Node *> &get_joints() const;
+
+	/**
+	 * @brief Computes the matrices moving the vertices from the bind pose to the current pose of the joints
+	 * @param mesh_world_matrix World matrix of the node drawing the mesh, which the vertex shader applies after skinning
+	 * @param joint_matrices Destination of one matrix per joint
+	 */
+	void compute_joint_matrices(const glm::mat4 &mesh_world_matrix, glm::mat4 *joint_matrices) const;
+
+  private:
+	std::vector<Node *> joints;
+
+	std::vector<glm::mat4> inverse_bind_matrices;
+};
+}        // namespace sg
+}        // namespace vkb
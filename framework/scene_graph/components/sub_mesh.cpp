@@ -39,6 +39,38 @@ void SubMesh::set_attribute(const std::string &attribute_name, const VertexAttri
 	compute_shader_variant();
 }
 
+std::uint32_t SubMesh::get_first_index(std::uint32_t lod) const
+{
+	VkDeviceSize index_size = index_type == VK_INDEX_TYPE_UINT32 ? sizeof(uint32_t) : sizeof(uint16_t);
+
+	if (lod == 0)
+	{
+		return static_cast<std::uint32_t>((index_buffer.get_offset() + index_offset) / index_size);
+	}
+
+	return static_cast<std::uint32_t>(lods.at(lod - 1).index_buffer.get_offset() / index_size);
+}
+
+std::uint32_t SubMesh::get_lod_count() const
+{
+	return static_cast<std::uint32_t>(lods.size() + 1);
+}
+
+const BufferAllocation &SubMesh::get_index_buffer(std::uint32_t lod) const
+{
+	return lod == 0 ? index_buffer : lods.at(lod - 1).index_buffer;
+}
+
+std::uint32_t SubMesh::get_vertex_indices(std::uint32_t lod) const
+{
+	return lod == 0 ? vertex_indices : lods.at(lod - 1).vertex_indices;
+}
+
+float SubMesh::get_lod_error(std::uint32_t lod) const
+{
+	return lod == 0 ? 0.0f : lods.at(lod - 1).error;
+}
+
 bool SubMesh::get_attribute(const std::string &attribute_name, VertexAttribute &attribute) const
 {
 	auto attrib_it = vertex_attributes.find(attribute_name);
@@ -53,6 +85,17 @@ bool SubMesh::get_attribute(const std::string &attribute_name, VertexAttribute &
 	return true;
 }
 
+const BufferAllocation *SubMesh::find_vertex_buffer(const std::string &attribute_name) const
+{
+	auto attrib_it = vertex_attributes.find(attribute_name);
+
+	const std::string &buffer_name = attrib_it != vertex_attributes.end() && !attrib_it->second.stream.empty() ? attrib_it->second.stream : attribute_name;
+
+	auto buffer_it = vertex_buffers.find(buffer_name);
+
+	return buffer_it != vertex_buffers.end() ? &buffer_it->second : nullptr;
+}
+
 void SubMesh::set_material(const Material &new_material)
 {
 	material = &new_material;
@@ -91,6 +134,14 @@ void SubMesh::compute_shader_variant()
 		std::transform(attrib_name.begin(), attrib_name.end(), attrib_name.begin(), ::toupper);
 		shader_variant.add_define("HAS_" + attrib_name);
 	}
+
+	// Quantized normals are decoded by the vertex shader
+	auto normal_it = vertex_attributes.find("normal");
+
+	if (normal_it != vertex_attributes.end() && normal_it->second.format == VK_FORMAT_R16G16_SNORM)
+	{
+		shader_variant.add_define("HAS_OCTAHEDRAL_NORMAL");
+	}
 }
 
 ShaderVariant &SubMesh::get_mut_shader_variant()
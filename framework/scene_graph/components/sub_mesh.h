@@ -26,6 +26,13 @@
 #include <unordered_map>
 #include <vector>
 
+#include "buffer_pool.h"
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
 #include "common/vk_common.h"
 #include "core/buffer.h"
 #include "core/shader_module.h"
@@ -44,6 +51,46 @@ struct VertexAttribute
 	std::uint32_t stride = 0;
 
 	std::uint32_t offset = 0;
+
+	/// Name of the vertex buffer holding the attribute interleaved with others, empty if it has a buffer of its own
+	std::string stream;
+};
+
+/**
+ * @brief Simplified index data of a submesh, drawing a subset of its vertices
+ */
+struct SubMeshLod
+{
+	/// Index data, suballocated from the GeometryArena of the scene
+	BufferAllocation index_buffer;
+
+	std::uint32_t vertex_indices = 0;
+
+	/// Largest displacement of the surface from the full detail submesh, in the units of its positions
+	float error = 0.0f;
+};
+
+/**
+ * @brief Cluster of at most MAX_VERTICES vertices and MAX_TRIANGLES triangles of a submesh,
+ *        drawn from a contiguous range of its indices and culled on its own by GPU driven draws
+ */
+struct Meshlet
+{
+	static constexpr std::uint32_t MAX_VERTICES = 64;
+
+	static constexpr std::uint32_t MAX_TRIANGLES = 124;
+
+	/// Center and radius of a sphere bounding the triangles, in the space of the positions
+	glm::vec4 bounding_sphere;
+
+	/// Axis of a cone containing the normals of the triangles and the sine of its half angle,
+	/// a sine of 1 meaning that the triangles face too many directions to be culled as a whole
+	glm::vec4 normal_cone;
+
+	/// First index of the meshlet, relative to the first index of the submesh
+	std::uint32_t first_index = 0;
+
+	std::uint32_t index_count = 0;
 };
 
 class SubMesh : public Component
@@ -55,20 +102,60 @@ class SubMesh : public Component
 
 	VkIndexType index_type{};
 
+	/// Offset in bytes of the first index, relative to the index buffer allocation
 	std::uint32_t index_offset = 0;
 
 	std::uint32_t vertices_count = 0;
 
 	std::uint32_t vertex_indices = 0;
 
-	std::unordered_map<std::string, core::Buffer> vertex_buffers;
+	/// Vertex data of each attribute, suballocated from the GeometryArena of the scene
+	std::unordered_map<std::string, BufferAllocation> vertex_buffers;
+
+	/// Index data, suballocated from the GeometryArena of the scene
+	BufferAllocation index_buffer;
+
+	/// Clusters of the triangles of the full detail level, covering all its indices in order
+	std::vector<Meshlet> meshlets;
 
-	std::unique_ptr<core::Buffer> index_buffer;
+	/// Coarser levels of detail sharing the vertex buffers, ordered from the finest. The submesh itself is level 0
+	std::vector<SubMeshLod> lods;
+
+	/**
+	 * @return Index of the first index of a level of detail within its whole index buffer,
+	 *         which lets draws share the binding of the buffer
+	 */
+	std::uint32_t get_first_index(std::uint32_t lod = 0) const;
+
+	/**
+	 * @return Number of levels of detail, including the full detail submesh
+	 */
+	std::uint32_t get_lod_count() const;
+
+	/**
+	 * @return Index buffer allocation of a level of detail
+	 */
+	const BufferAllocation &get_index_buffer(std::uint32_t lod = 0) const;
+
+	/**
+	 * @return Number of indices drawn by a level of detail
+	 */
+	std::uint32_t get_vertex_indices(std::uint32_t lod = 0) const;
+
+	/**
+	 * @return Geometric error of a level of detail, zero for the full detail submesh
+	 */
+	float get_lod_error(std::uint32_t lod) const;
 
 	void set_attribute(const std::string &name, const VertexAttribute &attribute);
 
 	bool get_attribute(const std::string &name, VertexAttribute &attribute) const;
 
+	/**
+	 * @return The vertex buffer holding an attribute, shared by the attributes of an interleaved stream, nullptr if none
+	 */
+	const BufferAllocation *find_vertex_buffer(const std::string &name) const;
+
 	void set_material(const Material &material);
 
 	const Material *get_material() const;
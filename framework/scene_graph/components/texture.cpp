@@ -53,5 +53,21 @@ Sampler *Texture::get_sampler()
 	assert(sampler && "Texture has no sampler");
 	return sampler;
 }
+
+void Texture::set_array(const TextureArray *a, uint32_t layer)
+{
+	array       = a;
+	array_layer = layer;
+}
+
+const TextureArray *Texture::get_array() const
+{
+	return array;
+}
+
+uint32_t Texture::get_array_layer() const
+{
+	return array_layer;
+}
 }        // namespace sg
 }        // namespace vkb
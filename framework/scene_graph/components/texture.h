@@ -33,6 +33,7 @@ namespace vkb
 namespace sg
 {
 class Image;
+class TextureArray;
 
 class Texture : public Component
 {
@@ -53,10 +54,28 @@ class Texture : public Component
 
 	Sampler *get_sampler();
 
+	/**
+	 * @brief Sets the texture array holding a copy of the image of the texture
+	 * @param array Texture array the image was copied into, nullptr if none
+	 * @param layer Layer of the array holding the image
+	 */
+	void set_array(const TextureArray *array, uint32_t layer);
+
+	/**
+	 * @return The texture array holding a copy of the image, nullptr if the image was not batched into one
+	 */
+	const TextureArray *get_array() const;
+
+	uint32_t get_array_layer() const;
+
   private:
 	Image *image{nullptr};
 
 	Sampler *sampler{nullptr};
+
+	const TextureArray *array{nullptr};
+
+	uint32_t array_layer{0};
 };
 }        // namespace sg
 }        // namespace vkb
@@ -0,0 +1,54 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "texture_array.h"
+
+namespace vkb
+{
+namespace sg
+{
+TextureArray::TextureArray(const std::string &name, std::unique_ptr<core::Image> &&image) :
+    Component{name},
+    vk_image{std::move(image)}
+{
+	vk_image_view = std::make_unique<core::ImageView>(*vk_image, VK_IMAGE_VIEW_TYPE_2D_ARRAY);
+}
+
+std::type_index TextureArray::get_type()
+{
+	return typeid(TextureArray);
+}
+
+const core::Image &TextureArray::get_vk_image() const
+{
+	return *vk_image;
+}
+
+const core::ImageView &TextureArray::get_vk_image_view() const
+{
+	return *vk_image_view;
+}
+
+uint32_t TextureArray::get_layer_count() const
+{
+	return vk_image->get_subresource().arrayLayer;
+}
+}        // namespace sg
+}        // namespace vkb
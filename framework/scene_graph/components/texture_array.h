@@ -0,0 +1,66 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <typeinfo>
+
+#include "common/vk_common.h"
+#include "core/image.h"
+#include "core/image_view.h"
+#include "scene_graph/component.h"
+
+namespace vkb
+{
+namespace sg
+{
+/**
+ * @brief 2D image array holding copies of scene images of the same format, size and mip levels
+ *
+ * Materials whose textures are layers of the same array bind the same image view, so their draws
+ * share descriptor sets and only differ by the layer they push, see sg::Texture::get_array().
+ */
+class TextureArray : public Component
+{
+  public:
+	/**
+	 * @brief Takes ownership of an image with one layer per batched image, and creates its array view
+	 */
+	TextureArray(const std::string &name, std::unique_ptr<core::Image> &&image);
+
+	virtual ~TextureArray() = default;
+
+	virtual std::type_index get_type() override;
+
+	const core::Image &get_vk_image() const;
+
+	const core::ImageView &get_vk_image_view() const;
+
+	uint32_t get_layer_count() const;
+
+  private:
+	std::unique_ptr<core::Image> vk_image;
+
+	std::unique_ptr<core::ImageView> vk_image_view;
+};
+}        // namespace sg
+}        // namespace vkb
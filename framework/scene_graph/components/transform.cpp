@@ -25,6 +25,7 @@ VKBP_DISABLE_WARNINGS()
 VKBP_ENABLE_WARNINGS()
 
 #include "scene_graph/node.h"
+#include "scene_graph/transform_system.h"
 
 namespace vkb
 {
@@ -49,21 +50,21 @@ void Transform::set_translation(const glm::vec3 &new_translation)
 {
 	translation = new_translation;
 
-	invalidate_world_matrix();
+	invalidate_local_matrix();
 }
 
 void Transform::set_rotation(const glm::quat &new_rotation)
 {
 	rotation = new_rotation;
 
-	invalidate_world_matrix();
+	invalidate_local_matrix();
 }
 
 void Transform::set_scale(const glm::vec3 &new_scale)
 {
 	scale = new_scale;
 
-	invalidate_world_matrix();
+	invalidate_local_matrix();
 }
 
 const glm::vec3 &Transform::get_translation() const
@@ -88,7 +89,7 @@ void Transform::set_matrix(const glm::mat4 &matrix)
 	glm::decompose(matrix, scale, rotation, translation, skew, perspective);
 	rotation = glm::conjugate(rotation);
 
-	invalidate_world_matrix();
+	invalidate_local_matrix();
 }
 
 glm::mat4 Transform::get_matrix() const
@@ -102,16 +103,71 @@ glm::mat4 Transform::get_world_matrix()
 {
 	update_world_transform();
 
-	return world_matrix;
+	return system ? system->world_matrices[index] : world_matrix;
+}
+
+void Transform::invalidate_local_matrix()
+{
+	if (system)
+	{
+		system->dirty[index] |= TransformSystem::LOCAL_DIRTY;
+	}
+
+	invalidate_world_matrix();
 }
 
 void Transform::invalidate_world_matrix()
 {
-	update_world_matrix = true;
+	// Children can only be valid if their parent is, so there is nothing left to do
+	if (is_world_matrix_invalid())
+	{
+		return;
+	}
+
+	if (system)
+	{
+		system->dirty[index] |= TransformSystem::WORLD_DIRTY;
+	}
+	else
+	{
+		update_world_matrix = true;
+	}
+
+	world_matrix_revision++;
+
+	for (auto child : node.get_children())
+	{
+		child->get_transform().invalidate_world_matrix();
+	}
+}
+
+uint32_t Transform::get_world_matrix_revision() const
+{
+	return world_matrix_revision;
+}
+
+void Transform::invalidate_hierarchy()
+{
+	if (system)
+	{
+		system->invalidate_hierarchy();
+	}
+}
+
+bool Transform::is_world_matrix_invalid() const
+{
+	return system ? (system->dirty[index] & TransformSystem::WORLD_DIRTY) != 0 : update_world_matrix;
 }
 
 void Transform::update_world_transform()
 {
+	if (system)
+	{
+		system->resolve(index);
+
+		return;
+	}
+
 	if (!update_world_matrix)
 	{
 		return;
@@ -124,7 +180,7 @@ void Transform::update_world_transform()
 	if (parent)
 	{
 		auto &transform = parent->get_component<Transform>();
-		world_matrix    = world_matrix * transform.get_world_matrix();
+		world_matrix    = transform.get_world_matrix() * world_matrix;
 	}
 
 	update_world_matrix = false;
@@ -39,7 +39,13 @@ namespace vkb
 namespace sg
 {
 class Node;
+class TransformSystem;
 
+/**
+ * @brief Local transform of a node, and the cache of its world transform
+ *        Once registered by the TransformSystem of the scene, the matrices live in the
+ *        arrays of the system, and the transform only keeps its translation, rotation and scale.
+ */
 class Transform : public Component
 {
   public:
@@ -73,10 +79,26 @@ class Transform : public Component
 	 * @brief Marks the world transform invalid if any of
 	 *        the local transform are changed or the parent
 	 *        world transform has changed.
+	 *        The invalidation is propagated to the children
+	 *        of the node, as their world transform depends on it.
 	 */
 	void invalidate_world_matrix();
 
+	/**
+	 * @brief Counter incremented every time the world transform is invalidated,
+	 *        it allows data derived from the world matrix to be cached
+	 * @return The current revision of the world transform
+	 */
+	uint32_t get_world_matrix_revision() const;
+
+	/**
+	 * @brief Notifies the transform system that the node was attached or moved in the hierarchy
+	 */
+	void invalidate_hierarchy();
+
   private:
+	friend class TransformSystem;
+
 	Node &node;
 
 	glm::vec3 translation = glm::vec3(0.0, 0.0, 0.0);
@@ -85,10 +107,27 @@ class Transform : public Component
 
 	glm::vec3 scale = glm::vec3(1.0, 1.0, 1.0);
 
+	/// World matrix while not registered by a system
 	glm::mat4 world_matrix = glm::mat4(1.0);
 
+	/// Whether the world matrix is invalid, while not registered by a system
 	bool update_world_matrix = false;
 
+	uint32_t world_matrix_revision = 0;
+
+	/// System storing the matrices, null until it registers the transform
+	TransformSystem *system{nullptr};
+
+	/// Index of the matrices in the arrays of the system
+	uint32_t index{0};
+
+	/**
+	 * @brief Marks the local matrix invalid, before invalidating the world matrix
+	 */
+	void invalidate_local_matrix();
+
+	bool is_world_matrix_invalid() const;
+
 	void update_world_transform();
 };
 
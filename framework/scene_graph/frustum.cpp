@@ -0,0 +1,78 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "frustum.h"
+
+#include "scene_graph/components/aabb.h"
+
+namespace vkb
+{
+namespace sg
+{
+Frustum::Frustum(const glm::mat4 &view_proj)
+{
+	// Rows of the matrix, glm stores matrices in column-major order
+	glm::vec4 row_x{view_proj[0][0], view_proj[1][0], view_proj[2][0], view_proj[3][0]};
+	glm::vec4 row_y{view_proj[0][1], view_proj[1][1], view_proj[2][1], view_proj[3][1]};
+	glm::vec4 row_z{view_proj[0][2], view_proj[1][2], view_proj[2][2], view_proj[3][2]};
+	glm::vec4 row_w{view_proj[0][3], view_proj[1][3], view_proj[2][3], view_proj[3][3]};
+
+	planes[0] = row_w + row_x;        // Left
+	planes[1] = row_w - row_x;        // Right
+	planes[2] = row_w + row_y;        // Bottom
+	planes[3] = row_w - row_y;        // Top
+	planes[4] = row_z;                // Near
+	planes[5] = row_w - row_z;        // Far
+
+	for (auto &plane : planes)
+	{
+		plane /= glm::length(glm::vec3(plane));
+	}
+}
+
+bool Frustum::intersects(const AABB &bounds) const
+{
+	return intersects(bounds.get_min(), bounds.get_max());
+}
+
+bool Frustum::intersects(const glm::vec3 &min, const glm::vec3 &max) const
+{
+	for (auto &plane : planes)
+	{
+		// Corner of the box which is the furthest along the plane normal
+		glm::vec3 corner{plane.x >= 0.0f ? max.x : min.x,
+		                 plane.y >= 0.0f ? max.y : min.y,
+		                 plane.z >= 0.0f ? max.z : min.z};
+
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+const std::array<glm::vec4, 6> &Frustum::get_planes() const
+{
+	return planes;
+}
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,76 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+namespace sg
+{
+class AABB;
+
+/**
+ * @brief View frustum described by six planes in world space
+ */
+class Frustum
+{
+  public:
+	/**
+	 * @brief Extracts the planes of the frustum from a view projection matrix
+	 * @param view_proj Matrix transforming world space to clip space,
+	 *        with a depth range of [0, 1] as used by Vulkan
+	 */
+	Frustum(const glm::mat4 &view_proj);
+
+	/**
+	 * @brief Checks whether a bounding box is at least partially inside the frustum
+	 *        The test is conservative, boxes close to the corners of the frustum
+	 *        may be reported as visible even if they are outside
+	 * @param bounds The world space bounding box
+	 * @return False if the box is fully outside the frustum
+	 */
+	bool intersects(const AABB &bounds) const;
+
+	/**
+	 * @brief Checks whether a bounding box given by its corners is at least partially inside the frustum
+	 * @param min Minimum corner of the world space box
+	 * @param max Maximum corner of the world space box
+	 * @return False if the box is fully outside the frustum
+	 */
+	bool intersects(const glm::vec3 &min, const glm::vec3 &max) const;
+
+	/**
+	 * @return The planes of the frustum, stored as (normal, distance) with normals pointing inwards
+	 */
+	const std::array<glm::vec4, 6> &get_planes() const;
+
+  private:
+	std::array<glm::vec4, 6> planes;
+};
+}        // namespace sg
+}        // namespace vkb
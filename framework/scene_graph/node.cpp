@@ -43,6 +43,10 @@ void Node::set_parent(Node &p)
 {
 	parent = &p;
 
+	// Either node may be laid out by a transform system
+	transform.invalidate_hierarchy();
+	p.get_transform().invalidate_hierarchy();
+
 	transform.invalidate_world_matrix();
 }
 
@@ -54,6 +58,8 @@ Node *Node::get_parent() const
 void Node::add_child(Node &child)
 {
 	children.push_back(&child);
+
+	transform.invalidate_hierarchy();
 }
 
 const std::vector<Node *> &Node::get_children() const
@@ -20,8 +20,6 @@
 
 #include "scene.h"
 
-#include <queue>
-
 #include "common/error.h"
 #include "component.h"
 #include "node.h"
@@ -48,10 +46,17 @@ void Scene::set_nodes(std::vector<std::unique_ptr<Node>> &&n)
 {
 	assert(nodes.empty() && "Scene nodes were already set");
 	nodes = std::move(n);
+
+	for (auto &node : nodes)
+	{
+		node_index.emplace(node->get_name(), node.get());
+	}
 }
 
 void Scene::add_node(std::unique_ptr<Node> &&n)
 {
+	node_index.emplace(n->get_name(), n.get());
+
 	nodes.emplace_back(std::move(n));
 }
 
@@ -64,23 +69,37 @@ void Scene::add_component(std::unique_ptr<Component> &&component, Node &node)
 {
 	node.set_component(*component);
 
-	if (component)
-	{
-		components[component->get_type()].push_back(std::move(component));
-	}
+	add_component(std::move(component));
 }
 
 void Scene::add_component(std::unique_ptr<Component> &&component)
 {
 	if (component)
 	{
+		std::lock_guard<std::mutex> lock{*component_lists_mutex};
+
+		auto component_list = component_lists.find(component->get_type());
+		if (component_list != component_lists.end())
+		{
+			component_list->second->add(*component);
+		}
+
 		components[component->get_type()].push_back(std::move(component));
 	}
 }
 
 void Scene::set_components(const std::type_index &type_info, std::vector<std::unique_ptr<Component>> &&new_components)
 {
-	components[type_info] = std::move(new_components);
+	std::lock_guard<std::mutex> lock{*component_lists_mutex};
+
+	auto &scene_components = components[type_info];
+	scene_components       = std::move(new_components);
+
+	auto component_list = component_lists.find(type_info);
+	if (component_list != component_lists.end())
+	{
+		component_list->second->assign(scene_components);
+	}
 }
 
 const std::vector<std::unique_ptr<Component>> &Scene::get_components(const std::type_index &type_info) const
@@ -96,39 +115,31 @@ bool Scene::has_component(const std::type_index &type_info) const
 
 Node *Scene::find_node(const std::string &node_name)
 {
-	for (auto root_node : root->get_children())
-	{
-		std::queue<sg::Node *> traverse_nodes{};
-		traverse_nodes.push(root_node);
-
-		while (!traverse_nodes.empty())
-		{
-			auto node = traverse_nodes.front();
-			traverse_nodes.pop();
-
-			if (node->get_name() == node_name)
-			{
-				return node;
-			}
-
-			for (auto child_node : node->get_children())
-			{
-				traverse_nodes.push(child_node);
-			}
-		}
-	}
+	auto node_it = node_index.find(node_name);
 
-	return nullptr;
+	return node_it != node_index.end() ? node_it->second : nullptr;
 }
 
 void Scene::set_root_node(Node &node)
 {
 	root = &node;
+
+	transform_system->set_root_node(node);
 }
 
 Node &Scene::get_root_node()
 {
 	return *root;
 }
+
+void Scene::update_transforms()
+{
+	transform_system->update();
+}
+
+TransformSystem &Scene::get_transform_system()
+{
+	return *transform_system;
+}
 }        // namespace sg
 }        // namespace vkb
@@ -22,6 +22,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <typeindex>
 #include <unordered_map>
@@ -29,6 +30,7 @@
 
 #include "scene_graph/components/light.h"
 #include "scene_graph/components/texture.h"
+#include "scene_graph/transform_system.h"
 
 namespace vkb
 {
@@ -92,23 +94,32 @@ class Scene
 
 	/**
 	 * @return List of pointers to components casted to the given template type
+	 *
+	 * The list is built the first time a type is queried, then kept up to date as components of that type are
+	 * added, so that the queries made every frame neither allocate nor cast. The reference stays valid for the
+	 * lifetime of the scene, and its contents change when components of the type are added or set.
 	 */
 	template <class T>
-	std::vector<T *> get_components() const
+	const std::vector<T *> &get_components() const
 	{
-		std::vector<T *> result;
-		if (has_component(typeid(T)))
+		std::lock_guard<std::mutex> lock{*component_lists_mutex};
+
+		auto &component_list = component_lists[typeid(T)];
+
+		if (!component_list)
 		{
-			auto &scene_components = get_components(typeid(T));
+			auto typed_component_list = std::make_unique<TypedComponentList<T>>();
 
-			result.resize(scene_components.size());
-			std::transform(scene_components.begin(), scene_components.end(), result.begin(),
-			               [](const std::unique_ptr<Component> &component) -> T * {
-				               return dynamic_cast<T *>(component.get());
-			               });
+			auto components_it = components.find(typeid(T));
+			if (components_it != components.end())
+			{
+				typed_component_list->assign(components_it->second);
+			}
+
+			component_list = std::move(typed_component_list);
 		}
 
-		return result;
+		return static_cast<TypedComponentList<T> &>(*component_list).components;
 	}
 
 	/**
@@ -124,21 +135,76 @@ class Scene
 
 	bool has_component(const std::type_index &type_info) const;
 
+	/**
+	 * @return The first node added to the scene with the given name, or nullptr if there is none
+	 */
 	Node *find_node(const std::string &name);
 
 	void set_root_node(Node &node);
 
 	Node &get_root_node();
 
+	/**
+	 * @brief Updates the world matrices of the nodes below the root node in one pass,
+	 *        to be called once per frame after the nodes were moved and before rendering
+	 */
+	void update_transforms();
+
+	TransformSystem &get_transform_system();
+
   private:
+	/**
+	 * @brief Components of a type casted to that type, of which only the template knows the type
+	 */
+	struct ComponentList
+	{
+		virtual ~ComponentList() = default;
+
+		virtual void assign(const std::vector<std::unique_ptr<Component>> &scene_components) = 0;
+
+		virtual void add(Component &component) = 0;
+	};
+
+	template <class T>
+	struct TypedComponentList : ComponentList
+	{
+		std::vector<T *> components;
+
+		void assign(const std::vector<std::unique_ptr<Component>> &scene_components) override
+		{
+			// Components are stored by their type, so no dynamic cast is needed
+			components.resize(scene_components.size());
+			std::transform(scene_components.begin(), scene_components.end(), components.begin(),
+			               [](const std::unique_ptr<Component> &component) { return static_cast<T *>(component.get()); });
+		}
+
+		void add(Component &component) override
+		{
+			components.push_back(static_cast<T *>(&component));
+		}
+	};
+
 	std::string name;
 
 	/// List of all the nodes
 	std::vector<std::unique_ptr<Node>> nodes;
 
+	/// Nodes by name, the first node added with a name being kept
+	std::unordered_map<std::string, Node *> node_index;
+
 	Node *root{nullptr};
 
 	std::unordered_map<std::type_index, std::vector<std::unique_ptr<Component>>> components;
+
+	/// Casted lists of the component types queried so far
+	mutable std::unordered_map<std::type_index, std::unique_ptr<ComponentList>> component_lists;
+
+	/// Guards the creation of the casted lists by queries from several threads, allocated so that the scene can be moved
+	std::unique_ptr<std::mutex> component_lists_mutex{std::make_unique<std::mutex>()};
+
+	/// Declared after the nodes, as it hands the matrices back to their transforms when destroyed.
+	/// It is allocated so that its address, which the transforms refer to, survives moving the scene
+	std::unique_ptr<TransformSystem> transform_system{std::make_unique<TransformSystem>()};
 };
 }        // namespace sg
 }        // namespace vkb
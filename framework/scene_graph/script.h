@@ -50,6 +50,13 @@ class Script : public Component
 	 */
 	virtual void update(float delta_time) = 0;
 
+	/**
+	 * @brief Whether update() may run on a worker thread, concurrently with the scripts of other subtrees
+	 *        It must then only modify its node and the nodes below it, and only read those and their ancestors.
+	 * @return False by default, scripts are updated on the main thread
+	 */
+	virtual bool is_parallel_safe() const;
+
 	virtual void input_event(const InputEvent &input_event);
 
 	virtual void resize(uint32_t width, uint32_t height);
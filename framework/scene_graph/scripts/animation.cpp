@@ -0,0 +1,147 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "animation.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace sg
+{
+namespace
+{
+glm::quat to_quat(const glm::vec4 &value)
+{
+	return glm::normalize(glm::quat{value.w, value.x, value.y, value.z});
+}
+}        // namespace
+
+Animation::Animation(Node &node, const std::string &name) :
+    Script{node, name}
+{
+}
+
+void Animation::add_channel(AnimationChannel &&channel)
+{
+	assert(channel.node && !channel.times.empty() && "Animation channels need a node and keyframes");
+	assert(channel.values.size() == channel.times.size() * (channel.interpolation == AnimationInterpolation::CubicSpline ? 3 : 1) && "Animation channel values do not match its keyframes");
+
+	duration = std::max(duration, channel.times.back());
+
+	channels.push_back(std::move(channel));
+}
+
+void Animation::update(float delta_time)
+{
+	time += delta_time;
+
+	if (time > duration)
+	{
+		time = duration > 0.0f ? std::fmod(time, duration) : 0.0f;
+	}
+
+	for (auto &channel : channels)
+	{
+		sample(channel);
+	}
+}
+
+float Animation::get_duration() const
+{
+	return duration;
+}
+
+void Animation::sample(AnimationChannel &channel) const
+{
+	auto &times = channel.times;
+
+	// Only wrapping around the loop moves the cursor back
+	if (time < times[channel.cursor])
+	{
+		channel.cursor = 0;
+	}
+
+	while (channel.cursor + 1 < times.size() && time >= times[channel.cursor + 1])
+	{
+		channel.cursor++;
+	}
+
+	size_t key = channel.cursor;
+
+	bool cubic = channel.interpolation == AnimationInterpolation::CubicSpline;
+
+	auto key_value = [&channel, cubic](size_t index) { return cubic ? channel.values[index * 3 + 1] : channel.values[index]; };
+
+	glm::vec4 value;
+
+	if (key + 1 == times.size() || time <= times[key] || channel.interpolation == AnimationInterpolation::Step)
+	{
+		value = key_value(key);
+	}
+	else
+	{
+		float key_duration = times[key + 1] - times[key];
+		float t            = (time - times[key]) / key_duration;
+
+		if (cubic)
+		{
+			float t2 = t * t;
+			float t3 = t2 * t;
+
+			// Hermite spline between the values, with the out tangent of the key and the in tangent of the next one
+			value = (2.0f * t3 - 3.0f * t2 + 1.0f) * channel.values[key * 3 + 1] +
+			        (t3 - 2.0f * t2 + t) * key_duration * channel.values[key * 3 + 2] +
+			        (-2.0f * t3 + 3.0f * t2) * channel.values[key * 3 + 4] +
+			        (t3 - t2) * key_duration * channel.values[key * 3 + 3];
+		}
+		else if (channel.target == AnimationTarget::Rotation)
+		{
+			glm::quat rotation = glm::slerp(to_quat(key_value(key)), to_quat(key_value(key + 1)), t);
+
+			value = glm::vec4{rotation.x, rotation.y, rotation.z, rotation.w};
+		}
+		else
+		{
+			value = glm::mix(key_value(key), key_value(key + 1), t);
+		}
+	}
+
+	auto &transform = channel.node->get_transform();
+
+	switch (channel.target)
+	{
+		case AnimationTarget::Translation:
+			transform.set_translation(glm::vec3{value});
+			break;
+		case AnimationTarget::Rotation:
+			transform.set_rotation(to_quat(value));
+			break;
+		case AnimationTarget::Scale:
+			transform.set_scale(glm::vec3{value});
+			break;
+	}
+}
+}        // namespace sg
+}        // namespace vkb
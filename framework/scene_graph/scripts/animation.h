@@ -0,0 +1,106 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "scene_graph/script.h"
+
+namespace vkb
+{
+namespace sg
+{
+enum class AnimationTarget
+{
+	Translation,
+	Rotation,
+	Scale
+};
+
+enum class AnimationInterpolation
+{
+	Linear,
+	Step,
+	CubicSpline
+};
+
+/**
+ * @brief Keyframes animating one property of a node
+ */
+struct AnimationChannel
+{
+	Node *node{nullptr};
+
+	AnimationTarget target{AnimationTarget::Translation};
+
+	AnimationInterpolation interpolation{AnimationInterpolation::Linear};
+
+	/// Times of the keyframes in seconds, in increasing order
+	std::vector<float> times;
+
+	/// Values of the keyframes, rotations as (x, y, z, w) quaternions.
+	/// Cubic splines store three values per keyframe: the in tangent, the value and the out tangent
+	std::vector<glm::vec4> values;
+
+	/// Keyframe the last sample was taken from, so that playing forward never searches the keyframes
+	size_t cursor{0};
+};
+
+/**
+ * @brief Plays keyframe animations in a loop, e.g. the animations of a glTF file
+ */
+class Animation : public Script
+{
+  public:
+	Animation(Node &node, const std::string &name = "");
+
+	virtual ~Animation() = default;
+
+	void add_channel(AnimationChannel &&channel);
+
+	virtual void update(float delta_time) override;
+
+	/**
+	 * @return Time of the last keyframe of the channels, in seconds
+	 */
+	float get_duration() const;
+
+  private:
+	/**
+	 * @brief Moves the cursor of a channel forward to the current time, and applies its value
+	 */
+	void sample(AnimationChannel &channel) const;
+
+	std::vector<AnimationChannel> channels;
+
+	float duration{0.0f};
+
+	float time{0.0f};
+};
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,152 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "camera_path.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <json.hpp>
+
+#include "common/logging.h"
+#include "platform/filesystem.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace sg
+{
+CameraPath::CameraPath(Node &node, Mode mode, const std::string &filename) :
+    Script{node, "CameraPath"},
+    mode{mode},
+    filename{filename}
+{
+	if (mode != Mode::Playback)
+	{
+		return;
+	}
+
+	auto data = fs::read_temp(filename);
+
+	auto path = nlohmann::json::parse(data.begin(), data.end(), nullptr, false);
+	if (path.is_discarded() || !path.contains("keyframes"))
+	{
+		throw std::runtime_error("Invalid camera path file: " + filename);
+	}
+
+	for (auto &entry : path["keyframes"])
+	{
+		Keyframe keyframe;
+		keyframe.time        = entry["time"].get<float>();
+		keyframe.translation = {entry["translation"][0].get<float>(), entry["translation"][1].get<float>(), entry["translation"][2].get<float>()};
+		keyframe.rotation    = {entry["rotation"][3].get<float>(), entry["rotation"][0].get<float>(), entry["rotation"][1].get<float>(), entry["rotation"][2].get<float>()};
+
+		keyframes.push_back(keyframe);
+	}
+
+	if (keyframes.empty())
+	{
+		throw std::runtime_error("Camera path file without keyframes: " + filename);
+	}
+
+	LOGI("Playing back {} camera keyframes from {}", keyframes.size(), filename);
+}
+
+void CameraPath::update(float delta_time)
+{
+	auto &transform = get_node().get_component<Transform>();
+
+	if (mode == Mode::Record)
+	{
+		keyframes.push_back({time, transform.get_translation(), transform.get_rotation()});
+
+		time += delta_time;
+
+		return;
+	}
+
+	float duration = keyframes.back().time;
+	if (duration > 0.0f)
+	{
+		time = std::fmod(time, duration);
+	}
+
+	// First keyframe after the current time, the path is sorted by time
+	auto next = std::upper_bound(keyframes.begin(), keyframes.end(), time,
+	                             [](float time, const Keyframe &keyframe) { return time < keyframe.time; });
+
+	if (next == keyframes.begin() || next == keyframes.end())
+	{
+		auto &keyframe = next == keyframes.end() ? keyframes.back() : keyframes.front();
+
+		transform.set_translation(keyframe.translation);
+		transform.set_rotation(keyframe.rotation);
+	}
+	else
+	{
+		auto &previous = *(next - 1);
+
+		float factor = (time - previous.time) / (next->time - previous.time);
+
+		transform.set_translation(glm::mix(previous.translation, next->translation, factor));
+		transform.set_rotation(glm::slerp(previous.rotation, next->rotation, factor));
+	}
+
+	time += delta_time;
+}
+
+void CameraPath::save() const
+{
+	if (mode != Mode::Record)
+	{
+		return;
+	}
+
+	nlohmann::json entries = nlohmann::json::array();
+
+	for (auto &keyframe : keyframes)
+	{
+		entries.push_back({{"time", keyframe.time},
+		                   {"translation", {keyframe.translation.x, keyframe.translation.y, keyframe.translation.z}},
+		                   {"rotation", {keyframe.rotation.x, keyframe.rotation.y, keyframe.rotation.z, keyframe.rotation.w}}});
+	}
+
+	nlohmann::json path;
+	path["keyframes"] = entries;
+
+	auto text = path.dump(1, '\t');
+
+	fs::write_temp({text.begin(), text.end()}, filename);
+
+	LOGI("Recorded {} camera keyframes to {}", keyframes.size(), filename);
+}
+
+CameraPath::Mode CameraPath::get_mode() const
+{
+	return mode;
+}
+
+const std::vector<CameraPath::Keyframe> &CameraPath::get_keyframes() const
+{
+	return keyframes;
+}
+}        // namespace sg
+}        // namespace vkb
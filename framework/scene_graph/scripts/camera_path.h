@@ -0,0 +1,91 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "scene_graph/script.h"
+
+namespace vkb
+{
+namespace sg
+{
+/**
+ * @brief Records the transform of a camera node over time, or plays a recorded path back on it.
+ *        With the fixed time step of --benchmark, a path played back frames the same views on every run.
+ *        It is updated after the scripts moving the camera from the input, overriding them while playing back.
+ */
+class CameraPath : public Script
+{
+  public:
+	enum class Mode
+	{
+		Record,
+		Playback
+	};
+
+	struct Keyframe
+	{
+		float time{0.0f};
+
+		glm::vec3 translation{0.0f};
+
+		glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
+	};
+
+	/**
+	 * @brief Creates the script, reading the keyframes of the file when playing back
+	 * @param filename The path file, relative to the temporary storage directory
+	 */
+	CameraPath(Node &node, Mode mode, const std::string &filename);
+
+	virtual ~CameraPath() = default;
+
+	virtual void update(float delta_time) override;
+
+	/**
+	 * @brief Writes the recorded keyframes to the path file, does nothing when playing back
+	 */
+	void save() const;
+
+	Mode get_mode() const;
+
+	const std::vector<Keyframe> &get_keyframes() const;
+
+  private:
+	Mode mode;
+
+	std::string filename;
+
+	std::vector<Keyframe> keyframes;
+
+	/// Time since the start of the path, wrapping around to loop it while playing back
+	float time{0.0f};
+};
+}        // namespace sg
+}        // namespace vkb
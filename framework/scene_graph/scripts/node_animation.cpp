@@ -44,6 +44,11 @@ void NodeAnimation::update(float delta_time)
 	}
 }
 
+bool NodeAnimation::is_parallel_safe() const
+{
+	return true;
+}
+
 void NodeAnimation::set_animation(TransformAnimFn handle)
 {
 	animation_fn = handle;
@@ -48,6 +48,11 @@ class NodeAnimation : public Script
 
 	virtual void update(float delta_time) override;
 
+	/**
+	 * @return True, the animation function must only modify the transform it is given
+	 */
+	virtual bool is_parallel_safe() const override;
+
 	void set_animation(TransformAnimFn handle);
 
 	void clear_animation();
@@ -0,0 +1,177 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "transform_system.h"
+
+#include <queue>
+
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace sg
+{
+constexpr uint32_t TransformSystem::NO_PARENT;
+
+TransformSystem::~TransformSystem()
+{
+	detach();
+}
+
+void TransformSystem::set_root_node(Node &node)
+{
+	root = &node;
+
+	invalidate_hierarchy();
+}
+
+void TransformSystem::invalidate_hierarchy()
+{
+	hierarchy_changed = true;
+}
+
+void TransformSystem::update()
+{
+	if (hierarchy_changed)
+	{
+		rebuild();
+	}
+
+	// Invalidations were propagated to the children, and parents come first,
+	// so each matrix only reads the already updated world matrix of its parent
+	for (size_t i = 0; i < dirty.size(); ++i)
+	{
+		if (dirty[i] == 0)
+		{
+			continue;
+		}
+
+		if (dirty[i] & LOCAL_DIRTY)
+		{
+			local_matrices[i] = transforms[i]->get_matrix();
+		}
+
+		if (parents[i] == NO_PARENT)
+		{
+			world_matrices[i] = local_matrices[i];
+		}
+		else
+		{
+			world_matrices[i] = world_matrices[parents[i]] * local_matrices[i];
+		}
+
+		dirty[i] = 0;
+	}
+}
+
+size_t TransformSystem::get_transform_count() const
+{
+	return transforms.size();
+}
+
+void TransformSystem::rebuild()
+{
+	hierarchy_changed = false;
+
+	detach();
+
+	if (!root)
+	{
+		return;
+	}
+
+	std::queue<std::pair<Node *, uint32_t>> traverse_nodes;
+	traverse_nodes.push(std::make_pair(root, NO_PARENT));
+
+	while (!traverse_nodes.empty())
+	{
+		auto node   = traverse_nodes.front().first;
+		auto parent = traverse_nodes.front().second;
+		traverse_nodes.pop();
+
+		auto &transform = node->get_transform();
+		auto  index     = static_cast<uint32_t>(transforms.size());
+
+		transforms.push_back(&transform);
+		parents.push_back(parent);
+
+		// The local matrix is not kept by detached transforms, so it is composed again along with an invalid world matrix
+		dirty.push_back(transform.update_world_matrix ? LOCAL_DIRTY | WORLD_DIRTY : 0);
+		local_matrices.push_back(transform.update_world_matrix ? glm::mat4(1.0f) : transform.get_matrix());
+		world_matrices.push_back(transform.world_matrix);
+
+		transform.system = this;
+		transform.index  = index;
+
+		for (auto child : node->get_children())
+		{
+			traverse_nodes.push(std::make_pair(child, index));
+		}
+	}
+}
+
+void TransformSystem::detach()
+{
+	for (size_t i = 0; i < transforms.size(); ++i)
+	{
+		auto &transform = *transforms[i];
+
+		transform.world_matrix        = world_matrices[i];
+		transform.update_world_matrix = dirty[i] != 0;
+		transform.system              = nullptr;
+	}
+
+	transforms.clear();
+	parents.clear();
+	dirty.clear();
+	local_matrices.clear();
+	world_matrices.clear();
+}
+
+void TransformSystem::resolve(uint32_t index)
+{
+	if (dirty[index] == 0)
+	{
+		return;
+	}
+
+	if (dirty[index] & LOCAL_DIRTY)
+	{
+		local_matrices[index] = transforms[index]->get_matrix();
+	}
+
+	auto parent = parents[index];
+
+	if (parent == NO_PARENT)
+	{
+		world_matrices[index] = local_matrices[index];
+	}
+	else
+	{
+		resolve(parent);
+
+		world_matrices[index] = world_matrices[parent] * local_matrices[index];
+	}
+
+	dirty[index] = 0;
+}
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,125 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+namespace sg
+{
+class Node;
+class Transform;
+
+/**
+ * @brief Stores the matrices of the transforms of a scene in contiguous arrays
+ *
+ * The transforms reachable from the root node are laid out in breadth-first order, so that
+ * parents always come before their children. update() then resolves all the invalid world
+ * matrices in a single linear pass, and the transforms act as handles into the arrays.
+ * Transforms keep resolving their world matrix on demand, e.g. when read after being
+ * changed by a script, before the next update.
+ */
+class TransformSystem
+{
+  public:
+	TransformSystem() = default;
+
+	/**
+	 * @brief Hands the matrices back to the transforms, which then resolve them on their own
+	 */
+	~TransformSystem();
+
+	TransformSystem(const TransformSystem &) = delete;
+
+	TransformSystem(TransformSystem &&) = delete;
+
+	TransformSystem &operator=(const TransformSystem &) = delete;
+
+	TransformSystem &operator=(TransformSystem &&) = delete;
+
+	/**
+	 * @brief Sets the node whose hierarchy is stored, the layout is built on the next update
+	 */
+	void set_root_node(Node &root);
+
+	/**
+	 * @brief Notifies that nodes were attached or moved, the layout is rebuilt on the next update
+	 */
+	void invalidate_hierarchy();
+
+	/**
+	 * @brief Updates the world matrices invalidated since the last update, parents before children
+	 */
+	void update();
+
+	size_t get_transform_count() const;
+
+  private:
+	friend class Transform;
+
+	/// Flags of the matrices which need to be computed again
+	enum DirtyFlags : uint8_t
+	{
+		LOCAL_DIRTY = 1,
+		WORLD_DIRTY = 2
+	};
+
+	static constexpr uint32_t NO_PARENT = ~0u;
+
+	/**
+	 * @brief Lays out the transforms below the root in breadth-first order
+	 */
+	void rebuild();
+
+	/**
+	 * @brief Hands the matrices back to the transforms and empties the arrays
+	 */
+	void detach();
+
+	/**
+	 * @brief Computes the world matrix of a transform and of its invalid ancestors
+	 */
+	void resolve(uint32_t index);
+
+	Node *root{nullptr};
+
+	bool hierarchy_changed{true};
+
+	std::vector<Transform *> transforms;
+
+	std::vector<uint32_t> parents;
+
+	std::vector<uint8_t> dirty;
+
+	std::vector<glm::mat4> local_matrices;
+
+	std::vector<glm::mat4> world_matrices;
+};
+}        // namespace sg
+}        // namespace vkb
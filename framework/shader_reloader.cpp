@@ -0,0 +1,200 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "shader_reloader.h"
+
+#include "common/logging.h"
+#include "core/device.h"
+#include "glsl_compiler.h"
+#include "platform/filesystem.h"
+#include "rendering/render_context.h"
+#include "spirv_reflection.h"
+
+namespace vkb
+{
+constexpr double ShaderReloader::POLL_INTERVAL;
+
+ShaderReloader::ShaderReloader(Device &device) :
+    device{device}
+{
+	poll_timer.start();
+}
+
+ShaderReloader::~ShaderReloader()
+{
+	// The job refers to the modules of the resource cache
+	if (pending_recompilations.valid())
+	{
+		pending_recompilations.wait();
+	}
+}
+
+void ShaderReloader::update(RenderContext &render_context)
+{
+	if (pending_recompilations.valid())
+	{
+		if (pending_recompilations.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			return;
+		}
+
+		auto recompilations = pending_recompilations.get();
+
+		for (auto &recompilation : recompilations)
+		{
+			apply(recompilation, render_context);
+		}
+	}
+
+	if (poll_timer.elapsed() >= POLL_INTERVAL)
+	{
+		poll_timer.lap();
+
+		poll();
+	}
+}
+
+uint32_t ShaderReloader::get_reload_count() const
+{
+	return reload_count;
+}
+
+void ShaderReloader::poll()
+{
+	auto &resource_cache = device.get_resource_cache();
+
+	std::vector<Recompilation> recompilations;
+
+	for (auto &filename : resource_cache.get_shader_filenames())
+	{
+		std::pair<uint64_t, int64_t> stamp;
+
+		if (!fs::get_file_stamp(fs::path::get(fs::path::Type::Shaders) + filename, stamp.first, stamp.second))
+		{
+			continue;
+		}
+
+		auto it = file_stamps.find(filename);
+
+		if (it == file_stamps.end())
+		{
+			// First seen, the modules were compiled from this version
+			file_stamps.emplace(filename, stamp);
+			continue;
+		}
+
+		if (it->second == stamp)
+		{
+			continue;
+		}
+
+		it->second = stamp;
+
+		try
+		{
+			Recompilation recompilation{ShaderSource{filename}};
+
+			recompilation.shader_modules = resource_cache.get_shader_modules(filename);
+
+			recompilations.push_back(std::move(recompilation));
+		}
+		catch (const std::runtime_error &ex)
+		{
+			// The file may be in the middle of being saved, it is read again on its next change
+			LOGW("Failed to read the edited shader {}: {}", filename, ex.what());
+		}
+	}
+
+	if (recompilations.empty())
+	{
+		return;
+	}
+
+	for (auto &recompilation : recompilations)
+	{
+		LOGI("Shader {} edited, recompiling {} variants", recompilation.source.get_filename(), recompilation.shader_modules.size());
+	}
+
+	pending_recompilations = device.get_job_system().push(JobPriority::Background, [recompilations = std::move(recompilations)](size_t) mutable {
+		for (auto &recompilation : recompilations)
+		{
+			recompile(recompilation);
+		}
+
+		return std::move(recompilations);
+	});
+}
+
+void ShaderReloader::recompile(Recompilation &recompilation)
+{
+	GLSLCompiler glsl_compiler;
+
+	for (auto shader_module : recompilation.shader_modules)
+	{
+		std::vector<uint32_t> spirv;
+		std::string           info_log;
+
+		if (!glsl_compiler.compile_to_spirv(shader_module->get_stage(), recompilation.source.get_data(), shader_module->get_entry_point(), shader_module->get_variant(), spirv, info_log))
+		{
+			recompilation.error = info_log;
+			return;
+		}
+
+		std::vector<ShaderResource> resources;
+
+		SPIRVReflection spirv_reflection;
+
+		if (!spirv_reflection.reflect_shader_resources(shader_module->get_stage(), spirv, resources, shader_module->get_variant()) ||
+		    !shader_module->has_same_resources(resources))
+		{
+			recompilation.error = "The resources of the shader changed, which requires restarting the sample";
+			return;
+		}
+
+		recompilation.binaries.push_back(std::move(spirv));
+	}
+}
+
+void ShaderReloader::apply(Recompilation &recompilation, RenderContext &render_context)
+{
+	auto &filename = recompilation.source.get_filename();
+
+	if (!recompilation.error.empty())
+	{
+		LOGE("Failed to reload shader {}, keeping its previous version:\n{}", filename, recompilation.error);
+		return;
+	}
+
+	std::vector<std::pair<const ShaderModule *, std::vector<uint32_t>>> binaries;
+
+	for (size_t i = 0; i < recompilation.shader_modules.size(); ++i)
+	{
+		binaries.emplace_back(recompilation.shader_modules[i], std::move(recompilation.binaries[i]));
+	}
+
+	auto evicted_pipelines = device.get_resource_cache().reload_shader_source(recompilation.source, std::move(binaries));
+
+	LOGI("Reloaded shader {}, {} pipelines to rebuild", filename, evicted_pipelines.size());
+
+	render_context.release_deferred(std::make_unique<std::vector<std::unique_ptr<Pipeline>>>(std::move(evicted_pipelines)));
+
+	++reload_count;
+}
+}        // namespace vkb
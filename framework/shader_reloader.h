@@ -0,0 +1,118 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/shader_module.h"
+#include "timer.h"
+
+namespace vkb
+{
+class Device;
+class RenderContext;
+
+/**
+ * @brief Recompiles the shaders edited in the shaders directory while a sample runs
+ *
+ * The source files of the cached shader modules are polled for changes. The modules compiled from
+ * an edited file are recompiled as a background job of the device job system, for the variants
+ * they were compiled with. Once the job is done the new code is swapped in between two frames,
+ * and only the pipelines using the modules are evicted from the resource cache, to be created
+ * again on their next request. The evicted pipelines are released once the frames using them
+ * have completed.
+ *
+ * An edit which does not compile, or which changes the resources of a shader, is reported and
+ * the previous code is kept, as the layouts created from the resources are not recreated.
+ */
+class ShaderReloader
+{
+  public:
+	/// Interval in seconds between two checks of the shader files
+	static constexpr double POLL_INTERVAL{0.5};
+
+	ShaderReloader(Device &device);
+
+	ShaderReloader(const ShaderReloader &) = delete;
+
+	ShaderReloader(ShaderReloader &&) = delete;
+
+	/// Waits for the recompilation in progress
+	~ShaderReloader();
+
+	ShaderReloader &operator=(const ShaderReloader &) = delete;
+
+	ShaderReloader &operator=(ShaderReloader &&) = delete;
+
+	/**
+	 * @brief Swaps in the shaders recompiled since the last call, then checks the shader files for changes
+	 *        To be called between frames
+	 * @param render_context Context releasing the evicted pipelines once the frames in flight have completed
+	 */
+	void update(RenderContext &render_context);
+
+	/**
+	 * @return The number of times a source was reloaded
+	 */
+	uint32_t get_reload_count() const;
+
+  private:
+	/**
+	 * @brief Recompilation of the modules of an edited source
+	 */
+	struct Recompilation
+	{
+		ShaderSource source;
+
+		std::vector<const ShaderModule *> shader_modules;
+
+		/// New code of each module
+		std::vector<std::vector<uint32_t>> binaries;
+
+		/// Compilation errors, empty if all the modules were recompiled
+		std::string error;
+	};
+
+	/// Recompiles the modules on a job system worker
+	static void recompile(Recompilation &recompilation);
+
+	/// Swaps in the code of a finished recompilation
+	void apply(Recompilation &recompilation, RenderContext &render_context);
+
+	/// Starts recompiling the edited sources, if any
+	void poll();
+
+	Device &device;
+
+	Timer poll_timer;
+
+	/// Size and modification time of the source files, by filename
+	std::unordered_map<std::string, std::pair<uint64_t, int64_t>> file_stamps;
+
+	std::future<std::vector<Recompilation>> pending_recompilations;
+
+	uint32_t reload_count{0};
+};
+}        // namespace vkb
@@ -0,0 +1,177 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "soak_monitor.h"
+
+#include <fstream>
+
+#if defined(_WIN32)
+#	ifndef NOMINMAX
+#		define NOMINMAX
+#	endif
+#	include <Windows.h>
+#	include <psapi.h>
+#elif defined(__linux__)
+#	include <unistd.h>
+#endif
+
+#include "common/logging.h"
+
+namespace vkb
+{
+SoakMonitor::SoakMonitor() :
+    start_time{Clock::now()},
+    thresholds{{"resident_memory", {0.10, 64.0 * 1024 * 1024}},
+               {"heap_usage", {0.10, 32.0 * 1024 * 1024}},
+               {"textures", {0.05, 16.0 * 1024 * 1024}},
+               {"buffer_pools", {0.10, 16.0 * 1024 * 1024}},
+               {"descriptor_sets", {0.10, 64.0}},
+               {"descriptor_pools", {0.10, 4.0}},
+               {"graphics_pipelines", {0.10, 16.0}},
+               {"pipeline_cache", {0.25, 1024.0 * 1024}},
+               {"frame_time_p50", {0.20, 1.0}},
+               {"frame_time_p99", {0.50, 4.0}}}
+{
+}
+
+void SoakMonitor::set_threshold(const std::string &metric, const Threshold &threshold)
+{
+	thresholds[metric] = threshold;
+}
+
+bool SoakMonitor::add_run(const std::string &key, const nlohmann::json &report)
+{
+	auto metrics = get_metrics(report);
+
+	float elapsed_time = get_elapsed_time();
+
+	runs.push_back({{"key", key}, {"elapsed_time", elapsed_time}, {"metrics", metrics}});
+
+	auto baseline = baselines.find(key);
+
+	if (baseline == baselines.end())
+	{
+		baselines.emplace(key, std::move(metrics));
+		return false;
+	}
+
+	bool drifted = false;
+
+	for (auto &metric : metrics)
+	{
+		auto baseline_value = baseline->second.find(metric.first);
+		auto threshold      = thresholds.find(metric.first);
+
+		if (baseline_value == baseline->second.end() || threshold == thresholds.end())
+		{
+			continue;
+		}
+
+		double limit = baseline_value->second * (1.0 + threshold->second.relative) + threshold->second.absolute;
+
+		if (metric.second > limit)
+		{
+			LOGE("Soak: {} of {} drifted from {} to {} after {:.0f} s", metric.first, key, baseline_value->second, metric.second, elapsed_time);
+
+			drifts.push_back({{"key", key},
+			                  {"metric", metric.first},
+			                  {"baseline", baseline_value->second},
+			                  {"value", metric.second},
+			                  {"elapsed_time", elapsed_time}});
+
+			drifted = true;
+		}
+	}
+
+	return drifted;
+}
+
+bool SoakMonitor::has_drifted() const
+{
+	return !drifts.empty();
+}
+
+float SoakMonitor::get_elapsed_time() const
+{
+	return std::chrono::duration<float>(Clock::now() - start_time).count();
+}
+
+nlohmann::json SoakMonitor::to_json() const
+{
+	return {{"passed", drifts.empty()},
+	        {"duration", get_elapsed_time()},
+	        {"runs", runs},
+	        {"drifts", drifts}};
+}
+
+size_t SoakMonitor::get_resident_memory()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters{};
+
+	if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return counters.WorkingSetSize;
+	}
+#elif defined(__linux__)
+	// The second field is the resident size in pages
+	std::ifstream statm{"/proc/self/statm"};
+
+	size_t total_pages    = 0;
+	size_t resident_pages = 0;
+
+	if (statm >> total_pages >> resident_pages)
+	{
+		return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	}
+#endif
+
+	return 0;
+}
+
+std::map<std::string, double> SoakMonitor::get_metrics(const nlohmann::json &report)
+{
+	std::map<std::string, double> metrics;
+
+	if (size_t resident_memory = get_resident_memory())
+	{
+		metrics["resident_memory"] = static_cast<double>(resident_memory);
+	}
+
+	auto memory = report.find("memory");
+
+	if (memory != report.end())
+	{
+		for (auto it = memory->begin(); it != memory->end(); ++it)
+		{
+			metrics[it.key()] = it.value().get<double>();
+		}
+	}
+
+	auto frame_time = report.find("frame_time_ms");
+
+	if (frame_time != report.end())
+	{
+		metrics["frame_time_p50"] = frame_time->at("p50").get<double>();
+		metrics["frame_time_p99"] = frame_time->at("p99").get<double>();
+	}
+
+	return metrics;
+}
+}        // namespace vkb
@@ -0,0 +1,111 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include <json.hpp>
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+/**
+ * @brief Watches the benchmark reports of the runs of a long soak for slow leaks and slow degradation
+ *
+ * The runs are identified by a key, e.g. the sample and its configuration, as the metrics of different
+ * samples are not comparable. The first run of a key is its baseline, once its caches and pools are warm,
+ * and every later run of the key fails the soak if one of its metrics exceeds the baseline by more than
+ * the threshold of the metric. The resident memory of the process is sampled along with each report.
+ */
+class SoakMonitor
+{
+  public:
+	/**
+	 * @brief Growth allowed over the baseline, the sum of a fraction of the baseline and of an absolute amount
+	 */
+	struct Threshold
+	{
+		double relative;
+
+		double absolute;
+	};
+
+	SoakMonitor();
+
+	/**
+	 * @brief Sets the growth allowed for a metric
+	 * @param metric The name of the metric, e.g. "resident_memory" or "frame_time_p99"
+	 */
+	void set_threshold(const std::string &metric, const Threshold &threshold);
+
+	/**
+	 * @brief Adds the metrics of a run
+	 * @param key Identifies the runs with comparable metrics
+	 * @param report The benchmark report of the run
+	 * @return Whether a metric of the run drifted beyond its threshold
+	 */
+	bool add_run(const std::string &key, const nlohmann::json &report);
+
+	/**
+	 * @return Whether a metric of any run drifted beyond its threshold
+	 */
+	bool has_drifted() const;
+
+	/**
+	 * @return The time since the monitor was created, in seconds
+	 */
+	float get_elapsed_time() const;
+
+	/**
+	 * @return The metrics of every run and the drifts found, to be written as the soak report
+	 */
+	nlohmann::json to_json() const;
+
+	/**
+	 * @return The resident set size of the process in bytes, 0 if it cannot be queried on the platform
+	 */
+	static size_t get_resident_memory();
+
+  private:
+	using Clock = std::chrono::steady_clock;
+
+	Clock::time_point start_time;
+
+	std::map<std::string, Threshold> thresholds;
+
+	/// Metrics of the first run of each key
+	std::map<std::string, std::map<std::string, double>> baselines;
+
+	std::vector<nlohmann::json> runs;
+
+	std::vector<nlohmann::json> drifts;
+
+	/**
+	 * @return The metrics watched, found in a benchmark report
+	 */
+	static std::map<std::string, double> get_metrics(const nlohmann::json &report);
+};
+}        // namespace vkb
@@ -20,10 +20,82 @@
 
 #include "spirv_reflection.h"
 
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
 namespace vkb
 {
 namespace
 {
+/// Identifies the reflection cache files, increased when their format or the reflection changes
+constexpr uint32_t REFLECTION_CACHE_MAGIC = 0x53505652;        // 'SPVR'
+
+constexpr uint32_t REFLECTION_CACHE_VERSION = 1;
+
+/**
+ * @brief Header of a reflection cache file, followed by the shader resources
+ */
+struct ReflectionCacheHeader
+{
+	uint32_t magic;
+
+	uint32_t version;
+
+	uint64_t key;
+
+	uint32_t resource_count;
+};
+
+/**
+ * @brief Fixed size fields of a shader resource in a reflection cache file, followed by its name
+ */
+struct CachedShaderResource
+{
+	uint32_t stages;
+
+	uint32_t type;
+
+	uint32_t set;
+
+	uint32_t binding;
+
+	uint32_t location;
+
+	uint32_t input_attachment_index;
+
+	uint32_t vec_size;
+
+	uint32_t columns;
+
+	uint32_t array_size;
+
+	uint32_t offset;
+
+	uint32_t size;
+
+	uint32_t constant_id;
+
+	uint32_t dynamic;
+
+	uint32_t name_size;
+};
+
+/**
+ * @brief FNV-1a hash, as the key of the cache must be the same across runs and platforms
+ */
+inline void hash_bytes(uint64_t &hash, const void *data, size_t size)
+{
+	auto bytes = reinterpret_cast<const uint8_t *>(data);
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+}
+
 template <ShaderResourceType T>
 inline void read_shader_resource(const spirv_cross::Compiler &compiler,
                                  VkShaderStageFlagBits        stage,
@@ -454,4 +526,147 @@ void SPIRVReflection::parse_specialization_constants(const spirv_cross::Compiler
 		resources.push_back(shader_resource);
 	}
 }
+
+uint64_t SPIRVReflection::get_reflection_key(uint64_t spirv_key, const ShaderVariant &variant)
+{
+	uint64_t key = 0xcbf29ce484222325ULL;
+
+	hash_bytes(key, &spirv_key, sizeof(spirv_key));
+	hash_bytes(key, &REFLECTION_CACHE_VERSION, sizeof(REFLECTION_CACHE_VERSION));
+
+	// Sorted, as the sizes are iterated in the order of an unordered container
+	std::vector<std::pair<std::string, uint64_t>> runtime_array_sizes;
+
+	for (auto &runtime_array_size : variant.get_runtime_array_sizes())
+	{
+		runtime_array_sizes.emplace_back(runtime_array_size.first, runtime_array_size.second);
+	}
+
+	std::sort(runtime_array_sizes.begin(), runtime_array_sizes.end());
+
+	for (auto &runtime_array_size : runtime_array_sizes)
+	{
+		uint64_t name_size = runtime_array_size.first.size();
+		hash_bytes(key, &name_size, sizeof(name_size));
+		hash_bytes(key, runtime_array_size.first.data(), runtime_array_size.first.size());
+		hash_bytes(key, &runtime_array_size.second, sizeof(runtime_array_size.second));
+	}
+
+	return key;
+}
+
+std::string SPIRVReflection::get_reflection_filename(uint64_t key)
+{
+	std::stringstream filename;
+	filename << "reflection_" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+	return filename.str();
+}
+
+std::vector<uint8_t> SPIRVReflection::encode_reflection_file(uint64_t key, const std::vector<ShaderResource> &resources)
+{
+	ReflectionCacheHeader header{};
+	header.magic          = REFLECTION_CACHE_MAGIC;
+	header.version        = REFLECTION_CACHE_VERSION;
+	header.key            = key;
+	header.resource_count = to_u32(resources.size());
+
+	std::vector<uint8_t> data(sizeof(header));
+	std::memcpy(data.data(), &header, sizeof(header));
+
+	for (auto &resource : resources)
+	{
+		CachedShaderResource cached{};
+		cached.stages                 = resource.stages;
+		cached.type                   = static_cast<uint32_t>(resource.type);
+		cached.set                    = resource.set;
+		cached.binding                = resource.binding;
+		cached.location               = resource.location;
+		cached.input_attachment_index = resource.input_attachment_index;
+		cached.vec_size               = resource.vec_size;
+		cached.columns                = resource.columns;
+		cached.array_size             = resource.array_size;
+		cached.offset                 = resource.offset;
+		cached.size                   = resource.size;
+		cached.constant_id            = resource.constant_id;
+		cached.dynamic                = resource.dynamic ? 1 : 0;
+		cached.name_size              = to_u32(resource.name.size());
+
+		size_t position = data.size();
+		data.resize(position + sizeof(cached) + resource.name.size());
+
+		std::memcpy(data.data() + position, &cached, sizeof(cached));
+		std::memcpy(data.data() + position + sizeof(cached), resource.name.data(), resource.name.size());
+	}
+
+	return data;
+}
+
+bool SPIRVReflection::decode_reflection_file(uint64_t key, const std::vector<uint8_t> &data, std::vector<ShaderResource> &resources)
+{
+	ReflectionCacheHeader header{};
+
+	if (data.size() < sizeof(header))
+	{
+		return false;
+	}
+
+	std::memcpy(&header, data.data(), sizeof(header));
+
+	if (header.magic != REFLECTION_CACHE_MAGIC || header.version != REFLECTION_CACHE_VERSION || header.key != key)
+	{
+		return false;
+	}
+
+	std::vector<ShaderResource> cached_resources;
+	cached_resources.reserve(header.resource_count);
+
+	size_t position = sizeof(header);
+
+	for (uint32_t i = 0; i < header.resource_count; i++)
+	{
+		CachedShaderResource cached{};
+
+		if (position + sizeof(cached) > data.size())
+		{
+			return false;
+		}
+
+		std::memcpy(&cached, data.data() + position, sizeof(cached));
+		position += sizeof(cached);
+
+		if (position + cached.name_size > data.size() || cached.type >= static_cast<uint32_t>(ShaderResourceType::All))
+		{
+			return false;
+		}
+
+		ShaderResource resource{};
+		resource.stages                 = cached.stages;
+		resource.type                   = static_cast<ShaderResourceType>(cached.type);
+		resource.set                    = cached.set;
+		resource.binding                = cached.binding;
+		resource.location               = cached.location;
+		resource.input_attachment_index = cached.input_attachment_index;
+		resource.vec_size               = cached.vec_size;
+		resource.columns                = cached.columns;
+		resource.array_size             = cached.array_size;
+		resource.offset                 = cached.offset;
+		resource.size                   = cached.size;
+		resource.constant_id            = cached.constant_id;
+		resource.dynamic                = cached.dynamic != 0;
+		resource.name.assign(reinterpret_cast<const char *>(data.data() + position), cached.name_size);
+
+		position += cached.name_size;
+
+		cached_resources.push_back(std::move(resource));
+	}
+
+	if (position != data.size())
+	{
+		return false;
+	}
+
+	resources = std::move(cached_resources);
+
+	return true;
+}
 }        // namespace vkb
@@ -49,6 +49,21 @@ class SPIRVReflection
 	                              std::vector<ShaderResource> &resources,
 	                              const ShaderVariant &        variant);
 
+	/// @brief Computes the key of the resources reflected from a SPIRV code, for the reflection cache
+	/// @param spirv_key Key of the SPIRV code, see GLSLCompiler::get_spirv_key()
+	/// @param variant ShaderVariant whose runtime array sizes are part of the reflection
+	static uint64_t get_reflection_key(uint64_t spirv_key, const ShaderVariant &variant);
+
+	/// @return Name of the cache file holding the resources of a key
+	static std::string get_reflection_filename(uint64_t key);
+
+	/// @brief Builds the content of a reflection cache file, made of a header identifying the key followed by the resources
+	static std::vector<uint8_t> encode_reflection_file(uint64_t key, const std::vector<ShaderResource> &resources);
+
+	/// @brief Reads the resources of a reflection cache file
+	/// @return False if the file is not a valid reflection file for the key, in which case resources is left unchanged
+	static bool decode_reflection_file(uint64_t key, const std::vector<uint8_t> &data, std::vector<ShaderResource> &resources);
+
   private:
 	void parse_shader_resources(const spirv_cross::Compiler &compiler,
 	                            VkShaderStageFlagBits        stage,
@@ -0,0 +1,129 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "startup_timeline.h"
+
+#include <algorithm>
+
+#include "common/logging.h"
+
+namespace vkb
+{
+StartupTimeline::Scope::Scope(StartupTimeline &timeline, const std::string &name) :
+    timeline{timeline},
+    name{name},
+    begin{Clock::now()}
+{
+}
+
+StartupTimeline::Scope::~Scope()
+{
+	timeline.record(name, begin, Clock::now());
+}
+
+void StartupTimeline::start()
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	start_time = Clock::now();
+	stages.clear();
+	time_to_first_frame = 0.0;
+}
+
+void StartupTimeline::record(const std::string &name, Clock::time_point begin, Clock::time_point end)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	// Subsystems created again later, e.g. when the swapchain is recreated, are not part of the startup
+	if (time_to_first_frame > 0.0)
+	{
+		return;
+	}
+
+	Stage stage;
+	stage.name     = name;
+	stage.begin    = std::chrono::duration<double>(begin - start_time).count();
+	stage.duration = std::chrono::duration<double>(end - begin).count();
+
+	stages.push_back(std::move(stage));
+}
+
+void StartupTimeline::finish()
+{
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+
+		time_to_first_frame = std::chrono::duration<double>(Clock::now() - start_time).count();
+	}
+
+	LOGI("Startup timeline ({:.1f} ms to the first frame):", time_to_first_frame * 1000.0);
+
+	for (auto &stage : get_stages())
+	{
+		LOGI("    {:>8.1f} ms {:>8.1f} ms  {}", stage.begin * 1000.0, stage.duration * 1000.0, stage.name);
+	}
+}
+
+bool StartupTimeline::is_finished() const
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	return time_to_first_frame > 0.0;
+}
+
+std::vector<StartupTimeline::Stage> StartupTimeline::get_stages() const
+{
+	std::vector<Stage> sorted;
+
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		sorted = stages;
+	}
+
+	// Nested stages are recorded when they end, before the stage containing them
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Stage &a, const Stage &b) { return a.begin < b.begin; });
+
+	return sorted;
+}
+
+double StartupTimeline::get_time_to_first_frame() const
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	return time_to_first_frame;
+}
+
+nlohmann::json StartupTimeline::to_json() const
+{
+	nlohmann::json report;
+
+	report["time_to_first_frame"] = get_time_to_first_frame();
+
+	auto &stages_report = report["stages"];
+	stages_report       = nlohmann::json::array();
+
+	for (auto &stage : get_stages())
+	{
+		stages_report.push_back({{"name", stage.name}, {"begin", stage.begin}, {"duration", stage.duration}});
+	}
+
+	return report;
+}
+}        // namespace vkb
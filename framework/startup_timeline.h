@@ -0,0 +1,113 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include <json.hpp>
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+/**
+ * @brief Records the stages of the start of a sample up to its first frame, relative to when it started
+ *
+ * Stages may be recorded from any thread, e.g. by subsystems initialized in the background,
+ * so they can overlap.
+ */
+class StartupTimeline
+{
+  public:
+	using Clock = std::chrono::steady_clock;
+
+	struct Stage
+	{
+		std::string name;
+
+		/// Seconds from the start of the timeline
+		double begin{0.0};
+
+		double duration{0.0};
+	};
+
+	/**
+	 * @brief Times a stage from its construction to its destruction
+	 */
+	class Scope
+	{
+	  public:
+		Scope(StartupTimeline &timeline, const std::string &name);
+
+		~Scope();
+
+	  private:
+		StartupTimeline &timeline;
+
+		std::string name;
+
+		Clock::time_point begin;
+	};
+
+	/**
+	 * @brief Clears the stages and restarts the timeline
+	 */
+	void start();
+
+	/**
+	 * @brief Records a stage, ignored once the timeline is finished
+	 */
+	void record(const std::string &name, Clock::time_point begin, Clock::time_point end);
+
+	/**
+	 * @brief Records the time to the first frame, and logs the stages
+	 */
+	void finish();
+
+	bool is_finished() const;
+
+	/**
+	 * @return The stages in the order they began
+	 */
+	std::vector<Stage> get_stages() const;
+
+	/**
+	 * @return Seconds from the start of the timeline to the end of the first frame, 0 until finished
+	 */
+	double get_time_to_first_frame() const;
+
+	nlohmann::json to_json() const;
+
+  private:
+	mutable std::mutex mutex;
+
+	Clock::time_point start_time{Clock::now()};
+
+	std::vector<Stage> stages;
+
+	double time_to_first_frame{0.0};
+};
+}        // namespace vkb
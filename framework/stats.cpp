@@ -21,9 +21,12 @@
 #include "stats.h"
 
 #include "common/error.h"
+#include "platform/thread_affinity.h"
 
 namespace vkb
 {
+constexpr size_t Stats::CONTINUOUS_SAMPLES_CAPACITY;
+
 Stats::Stats(const std::set<StatIndex> &enabled_stats, CounterSamplingConfig sampling_config,
              const size_t buffer_size) :
     enabled_stats(enabled_stats),
@@ -58,6 +61,64 @@ Stats::Stats(const std::set<StatIndex> &enabled_stats, CounterSamplingConfig sam
 	    {StatIndex::l2_ext_read_bytes, {hwcpipe::GpuCounter::ExternalMemoryReadBytes}},
 	    {StatIndex::l2_ext_write_bytes, {hwcpipe::GpuCounter::ExternalMemoryWriteBytes}},
 	    {StatIndex::tex_cycles, {hwcpipe::GpuCounter::ShaderTextureCycles}},
+	    {StatIndex::culled_draws, {StatScaling::None}},
+	    {StatIndex::occluded_draws, {StatScaling::None}},
+	    {StatIndex::input_latency, {StatScaling::None}},
+	    {StatIndex::gpu_frame_time, {StatScaling::None}},
+	    {StatIndex::gpu_render_pass_time, {StatScaling::None}},
+	    {StatIndex::gpu_subpass_0_time, {StatScaling::None}},
+	    {StatIndex::gpu_subpass_1_time, {StatScaling::None}},
+	    {StatIndex::subpass_0_vertex_invocations, {StatScaling::None}},
+	    {StatIndex::subpass_0_clipping_primitives, {StatScaling::None}},
+	    {StatIndex::subpass_0_fragment_invocations, {StatScaling::None}},
+	    {StatIndex::subpass_1_vertex_invocations, {StatScaling::None}},
+	    {StatIndex::subpass_1_clipping_primitives, {StatScaling::None}},
+	    {StatIndex::subpass_1_fragment_invocations, {StatScaling::None}},
+	    {StatIndex::shader_cycles, {hwcpipe::GpuCounter::ShaderCycles}},
+	    {StatIndex::shader_arithmetic_cycles, {hwcpipe::GpuCounter::ShaderArithmeticCycles}},
+	    {StatIndex::shader_load_store_cycles, {hwcpipe::GpuCounter::ShaderLoadStoreCycles}},
+	    {StatIndex::tiler_cycles, {hwcpipe::GpuCounter::TilerCycles}},
+	    {StatIndex::pixels, {hwcpipe::GpuCounter::Pixels}},
+	    {StatIndex::early_z_tests, {hwcpipe::GpuCounter::EarlyZTests}},
+	    {StatIndex::early_z_killed, {hwcpipe::GpuCounter::EarlyZKilled}},
+	    {StatIndex::late_z_tests, {hwcpipe::GpuCounter::LateZTests}},
+	    {StatIndex::late_z_killed, {hwcpipe::GpuCounter::LateZKilled}},
+	    {StatIndex::input_primitives, {hwcpipe::GpuCounter::InputPrimitives}},
+	    {StatIndex::culled_primitives, {hwcpipe::GpuCounter::CulledPrimitives}},
+	    {StatIndex::visible_primitives, {hwcpipe::GpuCounter::VisiblePrimitives}},
+	    {StatIndex::l2_ext_read_bytes_per_pixel, {hwcpipe::GpuCounter::ExternalMemoryReadBytes, StatScaling::ByCounter, hwcpipe::GpuCounter::Pixels}},
+	    {StatIndex::l2_ext_write_bytes_per_pixel, {hwcpipe::GpuCounter::ExternalMemoryWriteBytes, StatScaling::ByCounter, hwcpipe::GpuCounter::Pixels}},
+	    // Early ZS tests are counted per 2x2 quad, the view scales them to pixels
+	    {StatIndex::overdraw, {hwcpipe::GpuCounter::EarlyZTests, StatScaling::ByCounter, hwcpipe::GpuCounter::Pixels}},
+	    {StatIndex::device_memory_usage, {StatScaling::None}},
+	    {StatIndex::device_memory_budget, {StatScaling::None}},
+	    {StatIndex::memory_buffer_pools, {StatScaling::None}},
+	    {StatIndex::memory_textures, {StatScaling::None}},
+	    {StatIndex::memory_geometry, {StatScaling::None}},
+	    {StatIndex::memory_render_targets, {StatScaling::None}},
+	    {StatIndex::memory_staging, {StatScaling::None}},
+	    {StatIndex::render_scale, {StatScaling::None}},
+	    {StatIndex::thermal_headroom, {StatScaling::None}},
+	    {StatIndex::temperature, {StatScaling::None}},
+	    {StatIndex::resource_cache_misses, {StatScaling::None}},
+	    {StatIndex::cached_graphics_pipelines, {StatScaling::None}},
+	    {StatIndex::pipeline_binds, {StatScaling::None}},
+	    {StatIndex::descriptor_set_binds, {StatScaling::None}},
+	    {StatIndex::vertex_buffer_binds, {StatScaling::None}},
+	    {StatIndex::render_target_bytes_per_pixel, {StatScaling::None}},
+	    {StatIndex::resource_cache_contentions, {StatScaling::None}},
+	    {StatIndex::cpu_recording_time, {StatScaling::None}},
+	    {StatIndex::draw_calls, {StatScaling::None}},
+	    {StatIndex::descriptor_set_allocations, {StatScaling::None}},
+	    {StatIndex::uploaded_bytes, {StatScaling::None}},
+	    {StatIndex::buffer_pool_blocks, {StatScaling::None}},
+	    {StatIndex::buffer_pool_high_water, {StatScaling::None}},
+	    {StatIndex::attachment_read_bytes, {StatScaling::None}},
+	    {StatIndex::attachment_write_bytes, {StatScaling::None}},
+	    {StatIndex::gpu_busy, {StatScaling::None}},
+	    {StatIndex::gpu_idle_time, {StatScaling::None}},
+	    {StatIndex::compute_queue_busy, {StatScaling::None}},
+	    {StatIndex::gpu_starved, {StatScaling::None}},
 	};
 
 	hwcpipe::CpuCounterSet enabled_cpu_counters{};
@@ -92,12 +153,20 @@ Stats::Stats(const std::set<StatIndex> &enabled_stats, CounterSamplingConfig sam
 		}
 	}
 
+	// The counters stay on the constructing thread, as the CPU counters are opened for the calling thread
+	setup_begin = std::chrono::steady_clock::now();
+
 	hwcpipe = std::make_unique<hwcpipe::HWCPipe>(enabled_cpu_counters, enabled_gpu_counters);
 	hwcpipe->run();
 
+	setup_end = std::chrono::steady_clock::now();
+
 	if (sampling_config.mode == CounterSamplingMode::Continuous)
 	{
 		worker_thread = std::thread([this] {
+			// Sampling is not latency critical, so it stays off the cores running the frames
+			set_current_thread_role(ThreadRole::Background);
+
 			continuous_sampling_worker(stop_worker->get_future());
 		});
 
@@ -169,6 +238,81 @@ bool Stats::is_available(const StatIndex index) const
 	return false;
 }
 
+std::string Stats::get_counter_name(const StatIndex index) const
+{
+	const auto &data = stat_data.find(index);
+	if (data == stat_data.end())
+	{
+		return {};
+	}
+
+	switch (data->second.type)
+	{
+		case StatType::Cpu:
+		{
+			for (const auto &counter_name : hwcpipe::cpu_counter_names)
+			{
+				if (counter_name.second == data->second.cpu_counter)
+				{
+					return counter_name.first;
+				}
+			}
+			break;
+		}
+		case StatType::Gpu:
+		{
+			for (const auto &counter_name : hwcpipe::gpu_counter_names)
+			{
+				if (counter_name.second == data->second.gpu_counter)
+				{
+					return counter_name.first;
+				}
+			}
+			break;
+		}
+		case StatType::Other:
+		{
+			break;
+		}
+	}
+
+	return {};
+}
+
+void Stats::get_setup_time(std::chrono::steady_clock::time_point &begin, std::chrono::steady_clock::time_point &end) const
+{
+	begin = setup_begin;
+	end   = setup_end;
+}
+
+const std::vector<CounterSample> &Stats::get_samples(StatIndex index) const
+{
+	static const std::vector<CounterSample> no_samples;
+
+	auto samples = counter_samples.find(index);
+
+	return samples != counter_samples.end() ? samples->second : no_samples;
+}
+
+void Stats::set_value(const StatIndex index, float value)
+{
+	application_values[index] = value;
+}
+
+bool Stats::replace_gpu_counter(StatIndex index)
+{
+	auto data = stat_data.find(index);
+	if (data == stat_data.end() || data->second.type != StatType::Gpu || data->second.scaling == StatScaling::ByCounter || is_available(index))
+	{
+		return false;
+	}
+
+	// The stat is no longer sampled from hwcpipe, its scaling is kept for the values of the application
+	data->second.type = StatType::Other;
+
+	return true;
+}
+
 void add_smoothed_value(std::vector<float> &values, float value, float alpha)
 {
 	assert(values.size() >= 2 && "Buffers size should be greater than 2");
@@ -194,35 +338,30 @@ void Stats::update()
 			auto m          = hwcpipe->sample();
 			pending_samples = {{m.cpu ? *m.cpu : hwcpipe::CpuMeasurements{},
 			                    m.gpu ? *m.gpu : hwcpipe::GpuMeasurements{},
-			                    delta_time}};
+			                    delta_time,
+			                    std::chrono::steady_clock::now()}};
+
+			record_counter_samples(pending_samples);
 			break;
 		}
 		case CounterSamplingMode::Continuous:
 		{
-			// Check that we have no pending samples to be shown
-			if (pending_samples.size() == 0)
+			std::vector<MeasurementSample> samples;
+
+			MeasurementSample sample;
+			while (continuous_samples.pop(sample))
 			{
-				std::unique_lock<std::mutex> lock(continuous_sampling_mutex);
-				if (!should_add_to_continuous_samples)
-				{
-					// If we have no pending samples, we let the worker thread
-					// capture samples for the next frame
-					should_add_to_continuous_samples = true;
-				}
-				else
-				{
-					// The worker thread has captured a frame, so we stop it
-					// and read the samples
-					should_add_to_continuous_samples = false;
-					pending_samples                  = continuous_samples;
-					continuous_samples.clear();
-				}
+				samples.push_back(std::move(sample));
 			}
 
-			// Ensure the number of pending samples is capped at a reasonable value
+			record_counter_samples(samples);
+
+			pending_samples.insert(pending_samples.end(), std::make_move_iterator(samples.begin()), std::make_move_iterator(samples.end()));
+
+			// Ensure the number of pending samples is capped at a reasonable value, keeping the latest
 			if (pending_samples.size() > 100)
 			{
-				pending_samples.resize(100);
+				pending_samples.erase(pending_samples.begin(), pending_samples.end() - 100);
 			}
 			break;
 		}
@@ -235,6 +374,26 @@ void Stats::update()
 		add_smoothed_value(delta_time_counter->second, delta_time, alpha_smoothing);
 	}
 
+	// Handle stats provided by the application
+	for (const auto &value : application_values)
+	{
+		auto counter = counters.find(value.first);
+		if (counter == counters.end())
+		{
+			continue;
+		}
+
+		auto data = stat_data.find(value.first);
+		if (data != stat_data.end() && data->second.scaling == StatScaling::ByDeltaTime && delta_time > 0.0f)
+		{
+			add_smoothed_value(counter->second, value.second / delta_time, alpha_smoothing);
+		}
+		else
+		{
+			add_smoothed_value(counter->second, value.second, alpha_smoothing);
+		}
+	}
+
 	if (pending_samples.size() == 0)
 	{
 		return;
@@ -258,103 +417,146 @@ void Stats::continuous_sampling_worker(std::future<void> should_terminate)
 	worker_timer.tick();
 	hwcpipe->sample();
 
+	auto next_sample_time = std::chrono::steady_clock::now();
+
 	while (should_terminate.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
 	{
-		auto delta_time = static_cast<float>(worker_timer.tick());
-		auto interval   = std::chrono::duration_cast<std::chrono::duration<float>>(sampling_config.interval).count();
+		// Wait for the interval specified in config, scheduled from the previous sample so that it does not drift
+		next_sample_time += sampling_config.interval;
+		std::this_thread::sleep_until(next_sample_time);
 
-		// Ensure we wait for the interval specified in config
-		if (delta_time < interval)
+		auto now = std::chrono::steady_clock::now();
+		if (now > next_sample_time + sampling_config.interval)
 		{
-			std::this_thread::sleep_for(std::chrono::duration<float>(interval - delta_time));
-			delta_time += static_cast<float>(worker_timer.tick());
+			// Do not try to catch up after falling behind
+			next_sample_time = now;
+		}
+
+		// If the main thread has not read the previous samples yet, keep accumulating the
+		// counters into the next sample rather than losing their values
+		if (continuous_samples.full())
+		{
+			continue;
 		}
 
 		// Sample counters
 		const auto measurements = hwcpipe->sample();
 
-		// Add the new sample to the vector of continuous samples
-		{
-			std::unique_lock<std::mutex> lock(continuous_sampling_mutex);
-			continuous_samples.push_back({measurements.cpu ? *measurements.cpu : hwcpipe::CpuMeasurements{},
-			                              measurements.gpu ? *measurements.gpu : hwcpipe::GpuMeasurements{},
-			                              delta_time});
-		}
+		MeasurementSample sample{measurements.cpu ? *measurements.cpu : hwcpipe::CpuMeasurements{},
+		                         measurements.gpu ? *measurements.gpu : hwcpipe::GpuMeasurements{},
+		                         static_cast<float>(worker_timer.tick()),
+		                         now};
+
+		// Add the new sample to the queue of continuous samples, without blocking the main thread
+		continuous_samples.push(std::move(sample));
 	}
 }
 
-void Stats::push_sample(const MeasurementSample &sample)
+void Stats::record_counter_samples(const std::vector<MeasurementSample> &samples)
 {
 	for (auto &c : counters)
 	{
-		auto &values = c.second;
-
 		const auto data = stat_data.find(c.first);
 		if (data == stat_data.end())
 		{
 			continue;
 		}
 
-		float measurement = 0;
-		switch (data->second.type)
+		auto &values = counter_samples[c.first];
+		values.clear();
+
+		for (const auto &sample : samples)
+		{
+			float measurement = 0;
+			if (get_measurement(data->second, sample, measurement))
+			{
+				values.push_back({sample.timestamp, measurement});
+			}
+		}
+	}
+}
+
+bool Stats::get_measurement(const StatData &data, const MeasurementSample &sample, float &measurement) const
+{
+	measurement = 0;
+	switch (data.type)
+	{
+		case StatType::Cpu:
 		{
-			case StatType::Cpu:
+			const auto &cpu_res = sample.cpu.find(data.cpu_counter);
+			if (cpu_res != sample.cpu.end())
+			{
+				measurement = cpu_res->second.get<float>();
+			}
+
+			if (data.scaling == StatScaling::ByCounter)
 			{
-				const auto &cpu_res = sample.cpu.find(data->second.cpu_counter);
-				if (cpu_res != sample.cpu.end())
+				const auto &divisor_cpu_res = sample.cpu.find(data.divisor_cpu_counter);
+				if (divisor_cpu_res != sample.cpu.end())
 				{
-					measurement = cpu_res->second.get<float>();
+					measurement /= divisor_cpu_res->second.get<float>();
 				}
-
-				if (data->second.scaling == StatScaling::ByCounter)
+				else
 				{
-					const auto &divisor_cpu_res = sample.cpu.find(data->second.divisor_cpu_counter);
-					if (divisor_cpu_res != sample.cpu.end())
-					{
-						measurement /= divisor_cpu_res->second.get<float>();
-					}
-					else
-					{
-						measurement = 0;
-					}
+					measurement = 0;
 				}
-				break;
 			}
-			case StatType::Gpu:
+			break;
+		}
+		case StatType::Gpu:
+		{
+			const auto &gpu_res = sample.gpu.find(data.gpu_counter);
+			if (gpu_res != sample.gpu.end())
 			{
-				const auto &gpu_res = sample.gpu.find(data->second.gpu_counter);
-				if (gpu_res != sample.gpu.end())
+				measurement = gpu_res->second.get<float>();
+			}
+
+			if (data.scaling == StatScaling::ByCounter)
+			{
+				const auto &divisor_gpu_res = sample.gpu.find(data.divisor_gpu_counter);
+				if (divisor_gpu_res != sample.gpu.end())
 				{
-					measurement = gpu_res->second.get<float>();
+					measurement /= divisor_gpu_res->second.get<float>();
 				}
-
-				if (data->second.scaling == StatScaling::ByCounter)
+				else
 				{
-					const auto &divisor_gpu_res = sample.gpu.find(data->second.divisor_gpu_counter);
-					if (divisor_gpu_res != sample.gpu.end())
-					{
-						measurement /= divisor_gpu_res->second.get<float>();
-					}
-					else
-					{
-						measurement = 0;
-					}
+					measurement = 0;
 				}
-				break;
-			}
-			default:
-			{
-				// Skip to next counter
-				continue;
 			}
+			break;
+		}
+		default:
+		{
+			return false;
 		}
+	}
 
-		if (data->second.scaling == StatScaling::ByDeltaTime)
+	if (data.scaling == StatScaling::ByDeltaTime)
+	{
+		measurement /= sample.delta_time;
+	}
+
+	return true;
+}
+
+void Stats::push_sample(const MeasurementSample &sample)
+{
+	for (auto &c : counters)
+	{
+		const auto data = stat_data.find(c.first);
+		if (data == stat_data.end())
+		{
+			continue;
+		}
+
+		float measurement = 0;
+		if (!get_measurement(data->second, sample, measurement))
 		{
-			measurement /= sample.delta_time;
+			// Skip to next counter
+			continue;
 		}
 
-		add_smoothed_value(values, measurement, alpha_smoothing);
+		add_smoothed_value(c.second, measurement, alpha_smoothing);
 	}
 }
 
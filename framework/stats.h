@@ -20,14 +20,17 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <ctime>
 #include <future>
 #include <map>
 #include <set>
+#include <string>
 #include <vector>
 
 #include "common/error.h"
+#include "common/spsc_ring_buffer.h"
 
 VKBP_DISABLE_WARNINGS()
 #include <hwcpipe.h>
@@ -61,7 +64,64 @@ enum class StatIndex
 	l2_ext_write_stalls,
 	l2_ext_read_bytes,
 	l2_ext_write_bytes,
-	tex_cycles
+	tex_cycles,
+	culled_draws,
+	occluded_draws,
+	input_latency,
+	gpu_frame_time,
+	gpu_render_pass_time,
+	gpu_subpass_0_time,
+	gpu_subpass_1_time,
+	subpass_0_vertex_invocations,
+	subpass_0_clipping_primitives,
+	subpass_0_fragment_invocations,
+	subpass_1_vertex_invocations,
+	subpass_1_clipping_primitives,
+	subpass_1_fragment_invocations,
+	shader_cycles,
+	shader_arithmetic_cycles,
+	shader_load_store_cycles,
+	tiler_cycles,
+	pixels,
+	early_z_tests,
+	early_z_killed,
+	late_z_tests,
+	late_z_killed,
+	input_primitives,
+	culled_primitives,
+	visible_primitives,
+	l2_ext_read_bytes_per_pixel,
+	l2_ext_write_bytes_per_pixel,
+	overdraw,
+	device_memory_usage,
+	device_memory_budget,
+	memory_buffer_pools,
+	memory_textures,
+	memory_geometry,
+	memory_render_targets,
+	memory_staging,
+	render_scale,
+	thermal_headroom,
+	temperature,
+	resource_cache_misses,
+	cached_graphics_pipelines,
+	pipeline_binds,
+	descriptor_set_binds,
+	vertex_buffer_binds,
+	render_target_bytes_per_pixel,
+	resource_cache_contentions,
+	cpu_recording_time,
+	draw_calls,
+	descriptor_set_allocations,
+	uploaded_bytes,
+	buffer_pool_blocks,
+	buffer_pool_high_water,
+	attachment_read_bytes,
+	attachment_write_bytes,
+	gpu_busy,
+	gpu_idle_time,
+	compute_queue_busy,
+	gpu_starved
 };
 
 struct StatIndexHash
@@ -154,14 +214,25 @@ struct CounterSamplingConfig
 	/// Sampling mode (polling or continuous)
 	CounterSamplingMode mode;
 
-	/// Sampling interval in continuous mode
-	std::chrono::milliseconds interval{1};
+	/// Sampling interval in continuous mode, which can be shorter than a frame
+	std::chrono::microseconds interval{1000};
 
 	/// Speed of circular buffer updates in continuous mode;
 	/// at speed = 1.0f a new sample is displayed over 1 second.
 	float speed{0.5f};
 };
 
+/**
+ * @brief A value of a stat, as measured by a single counter sample
+ */
+struct CounterSample
+{
+	/// Time the sample was read, on the same clock as the CPU profiler scopes
+	std::chrono::steady_clock::time_point timestamp;
+
+	float value;
+};
+
 /*
  * @brief Helper class for querying statistics about the CPU and the GPU
  */
@@ -196,6 +267,13 @@ class Stats
 	 */
 	bool is_available(StatIndex index) const;
 
+	/**
+	 * @param index The stat index
+	 * @return Name of the hwcpipe counter the stat samples, as in hwcpipe::cpu_counter_names and
+	 *         hwcpipe::gpu_counter_names, or an empty string if the stat is not a counter
+	 */
+	std::string get_counter_name(StatIndex index) const;
+
 	/**
 	 * @param index The stat index of the data requested
 	 * @return The data of the specified stat
@@ -205,6 +283,14 @@ class Stats
 		return counters.at(index);
 	};
 
+	/**
+	 * @brief Gets the unsmoothed samples of a hardware counter stat read since the previous update,
+	 *        in continuous mode there can be several per frame
+	 * @param index The stat index
+	 * @return The timestamped values of the stat, empty if it is not sampled from a counter
+	 */
+	const std::vector<CounterSample> &get_samples(StatIndex index) const;
+
 	/**
 	 * @return The enabled stats
 	 */
@@ -213,19 +299,46 @@ class Stats
 		return enabled_stats;
 	}
 
+	/**
+	 * @brief Sets the value of a stat which is measured by the application
+	 *        rather than by a hardware counter, such as the number of culled draws
+	 * @param index The stat index
+	 * @param value The value measured for the last frame
+	 */
+	void set_value(StatIndex index, float value);
+
+	/**
+	 * @brief Makes a GPU counter stat which hwcpipe cannot read on this GPU take the values given to set_value()
+	 *        instead, such as those of a PerformanceQueryProfiler. The values are counts of a frame, scaled like
+	 *        the values of the counter they replace.
+	 * @param index The stat index
+	 * @return False if hwcpipe reads the stat, or if the stat is a ratio of two counters
+	 */
+	bool replace_gpu_counter(StatIndex index);
+
 	/**
 	 * @brief Update statistics, must be called after every frame
 	 */
 	void update();
 
+	/**
+	 * @brief Gets when the counters were opened, as part of the construction
+	 */
+	void get_setup_time(std::chrono::steady_clock::time_point &begin, std::chrono::steady_clock::time_point &end) const;
+
   private:
 	struct MeasurementSample
 	{
 		hwcpipe::CpuMeasurements cpu{};
 		hwcpipe::GpuMeasurements gpu{};
 		float                    delta_time{0.0f};
+
+		std::chrono::steady_clock::time_point timestamp{};
 	};
 
+	/// Number of samples the worker thread can read ahead of the main thread in continuous mode
+	static constexpr size_t CONTINUOUS_SAMPLES_CAPACITY = 1024;
+
 	/// Stats to be enabled
 	std::set<StatIndex> enabled_stats;
 
@@ -247,31 +360,44 @@ class Stats
 	/// Circular buffers for counter data
 	std::map<StatIndex, std::vector<float>> counters{};
 
+	/// Latest values of the stats measured by the application
+	std::map<StatIndex, float> application_values{};
+
 	/// Profiler to gather CPU and GPU performance data
 	std::unique_ptr<hwcpipe::HWCPipe> hwcpipe{};
 
+	std::chrono::steady_clock::time_point setup_begin{};
+
+	std::chrono::steady_clock::time_point setup_end{};
+
 	/// Worker thread for continuous sampling
 	std::thread worker_thread;
 
 	/// Promise to stop the worker thread
 	std::unique_ptr<std::promise<void>> stop_worker;
 
-	/// A mutex for accessing measurements during continuous sampling
-	std::mutex continuous_sampling_mutex;
-
-	/// The samples read during continuous sampling
-	std::vector<MeasurementSample> continuous_samples;
-
-	/// A flag specifying if the worker thread should add entries to continuous_samples
-	bool should_add_to_continuous_samples{false};
+	/// The samples read during continuous sampling, handed from the worker thread to the main thread
+	SpscRingBuffer<MeasurementSample> continuous_samples{CONTINUOUS_SAMPLES_CAPACITY};
 
 	/// The samples waiting to be displayed
 	std::vector<MeasurementSample> pending_samples;
 
+	/// The unsmoothed counter values of the samples read since the previous update
+	std::map<StatIndex, std::vector<CounterSample>> counter_samples{};
+
 	/// The worker thread function for continuous sampling;
 	/// it adds a new entry to continuous_samples at every interval
 	void continuous_sampling_worker(std::future<void> should_terminate);
 
+	/// Records the timestamped values of the samples read since the previous update
+	void record_counter_samples(const std::vector<MeasurementSample> &samples);
+
+	/**
+	 * @brief Computes the value of a hardware counter stat from a sample
+	 * @return False if the stat is not read from a counter
+	 */
+	bool get_measurement(const StatData &data, const MeasurementSample &sample, float &measurement) const;
+
 	/// Updates circular buffers for CPU and GPU counters
 	void push_sample(const MeasurementSample &sample);
 };
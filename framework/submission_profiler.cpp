@@ -0,0 +1,215 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "submission_profiler.h"
+
+#include <algorithm>
+
+#include "common/logging.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+
+namespace vkb
+{
+constexpr uint32_t SubmissionProfiler::MAX_SUBMISSIONS;
+constexpr double   QueueActivity::STARVED_IDLE_FRACTION;
+constexpr double   QueueActivity::MAX_IDLE_GAP;
+
+namespace
+{
+uint64_t get_timestamp_mask(const Queue &queue)
+{
+	uint32_t valid_bits = queue.get_properties().timestampValidBits;
+
+	return valid_bits >= 64 ? ~0ULL : (1ULL << valid_bits) - 1;
+}
+}        // namespace
+
+SubmissionProfiler::SubmissionProfiler(Device &device) :
+    device{device}
+{
+	timestamp_period = device.get_properties().limits.timestampPeriod;
+
+	VkQueryPoolCreateInfo info{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+	info.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+	info.queryCount = MAX_SUBMISSIONS * 2;
+
+	query_pool = std::make_unique<core::QueryPool>(device, info);
+}
+
+bool SubmissionProfiler::is_supported(const Queue &queue) const
+{
+	return queue.get_properties().timestampValidBits > 0;
+}
+
+bool SubmissionProfiler::begin_submission(CommandBuffer &command_buffer, const Queue &queue)
+{
+	assert((pending_submissions.empty() || pending_submissions.back().ended) && "The last submission was not ended");
+
+	if (!is_supported(queue))
+	{
+		return false;
+	}
+
+	if (pending_submissions.size() >= MAX_SUBMISSIONS)
+	{
+		LOGW("Too many submissions in the frame, increase SubmissionProfiler::MAX_SUBMISSIONS");
+		return false;
+	}
+
+	uint32_t begin_query = to_u32(pending_submissions.size() * 2);
+
+	// The queries of a submission are reset by the submission itself, as they may be written by any queue
+	command_buffer.reset_query_pool(*query_pool, begin_query, 2);
+	command_buffer.write_timestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, *query_pool, begin_query);
+
+	pending_submissions.push_back({&queue, begin_query, false});
+
+	return true;
+}
+
+void SubmissionProfiler::end_submission(CommandBuffer &command_buffer)
+{
+	assert(!pending_submissions.empty() && !pending_submissions.back().ended && "No submission was begun");
+
+	auto &submission = pending_submissions.back();
+
+	command_buffer.write_timestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, *query_pool, submission.begin_query + 1);
+
+	submission.ended = true;
+}
+
+void SubmissionProfiler::resolve()
+{
+	submissions.clear();
+
+	if (pending_submissions.empty())
+	{
+		return;
+	}
+
+	std::vector<uint64_t> timestamps(pending_submissions.size() * 2);
+
+	VkResult result = query_pool->get_results(0, to_u32(timestamps.size()),
+	                                          timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t),
+	                                          VK_QUERY_RESULT_64_BIT);
+
+	if (result != VK_SUCCESS && result != VK_NOT_READY)
+	{
+		LOGW("Failed to read back the submission timestamps: {}", to_string(result));
+	}
+	else
+	{
+		for (auto &pending : pending_submissions)
+		{
+			if (!pending.ended)
+			{
+				continue;
+			}
+
+			uint64_t mask = get_timestamp_mask(*pending.queue);
+
+			double begin = static_cast<double>(timestamps[pending.begin_query] & mask) * timestamp_period;
+			double end   = static_cast<double>(timestamps[pending.begin_query + 1] & mask) * timestamp_period;
+
+			submissions.push_back({pending.queue, begin, end});
+		}
+	}
+
+	pending_submissions.clear();
+}
+
+void SubmissionProfiler::clear()
+{
+	submissions.clear();
+	pending_submissions.clear();
+}
+
+const std::vector<SubmissionProfiler::Submission> &SubmissionProfiler::get_submissions() const
+{
+	return submissions;
+}
+
+float QueueActivity::Activity::get_busy_fraction() const
+{
+	float total_time = busy_time + idle_time;
+
+	return total_time > 0.0f ? busy_time / total_time : 0.0f;
+}
+
+const std::map<const Queue *, QueueActivity::Activity> &QueueActivity::update(const std::vector<SubmissionProfiler::Submission> &submissions)
+{
+	activities.clear();
+
+	// Idle time before the first submission of the frame on each queue
+	std::map<const Queue *, double> first_gaps;
+
+	for (auto &submission : submissions)
+	{
+		bool first = activities.find(submission.queue) == activities.end();
+
+		auto &activity = activities[submission.queue];
+
+		double begin = submission.begin;
+		double end   = submission.end;
+
+		auto last_end = last_ends.find(submission.queue);
+
+		if (last_end != last_ends.end())
+		{
+			double gap = begin - last_end->second;
+
+			if (gap > 0.0 && gap < MAX_IDLE_GAP)
+			{
+				activity.idle_time += static_cast<float>(gap * 1e-9);
+
+				if (first)
+				{
+					first_gaps[submission.queue] = gap;
+				}
+			}
+
+			// Submissions to a queue may overlap, the time they overlap is only counted once
+			if (gap < 0.0 && gap > -MAX_IDLE_GAP)
+			{
+				begin = last_end->second;
+				end   = std::max(end, last_end->second);
+			}
+		}
+
+		if (end > begin)
+		{
+			activity.busy_time += static_cast<float>((end - begin) * 1e-9);
+		}
+
+		last_ends[submission.queue] = end;
+	}
+
+	for (auto &first_gap : first_gaps)
+	{
+		auto &activity = activities[first_gap.first];
+
+		double frame_time = static_cast<double>(activity.busy_time) + activity.idle_time;
+
+		activity.starved = first_gap.second * 1e-9 > STARVED_IDLE_FRACTION * frame_time;
+	}
+
+	return activities;
+}
+}        // namespace vkb
@@ -0,0 +1,179 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/query_pool.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+class Queue;
+
+/**
+ * @brief Measures when the GPU executes each submission of a frame, on every queue
+ *
+ * A timestamp is written at the top of the pipe before the command buffers of a submission and
+ * at the bottom of the pipe after them. Like the GpuProfiler, each RenderFrame owns a profiler and
+ * reads its timestamps back once the frame is reused, so that reading them never stalls.
+ */
+class SubmissionProfiler
+{
+  public:
+	/**
+	 * @brief Maximum number of submissions measured in a frame, each uses two timestamps
+	 */
+	static constexpr uint32_t MAX_SUBMISSIONS = 32;
+
+	/**
+	 * @brief When the GPU began and finished the work of a submission, in nanoseconds
+	 */
+	struct Submission
+	{
+		const Queue *queue;
+
+		double begin;
+
+		double end;
+	};
+
+	SubmissionProfiler(Device &device);
+
+	SubmissionProfiler(const SubmissionProfiler &) = delete;
+
+	SubmissionProfiler(SubmissionProfiler &&) = default;
+
+	SubmissionProfiler &operator=(const SubmissionProfiler &) = delete;
+
+	SubmissionProfiler &operator=(SubmissionProfiler &&) = delete;
+
+	/**
+	 * @return Whether the queue supports timestamps
+	 */
+	bool is_supported(const Queue &queue) const;
+
+	/**
+	 * @brief Writes the timestamp beginning a submission
+	 * @param command_buffer A command buffer submitted to the queue before those of the submission
+	 * @return Whether the submission is measured, in which case end_submission() must be recorded
+	 */
+	bool begin_submission(CommandBuffer &command_buffer, const Queue &queue);
+
+	/**
+	 * @brief Writes the timestamp ending the submission last begun
+	 * @param command_buffer A command buffer submitted to the queue after those of the submission
+	 */
+	void end_submission(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Reads back the timestamps written in the frame. The work of the frame must be complete.
+	 */
+	void resolve();
+
+	/**
+	 * @brief Forgets the submissions of the frame without reading their timestamps
+	 */
+	void clear();
+
+	/**
+	 * @return The submissions of the frame when it was last resolved, in the order they were submitted
+	 */
+	const std::vector<Submission> &get_submissions() const;
+
+  private:
+	struct PendingSubmission
+	{
+		const Queue *queue;
+
+		uint32_t begin_query;
+
+		bool ended;
+	};
+
+	Device &device;
+
+	/// Nanoseconds per timestamp tick
+	float timestamp_period{1.0f};
+
+	std::unique_ptr<core::QueryPool> query_pool;
+
+	std::vector<PendingSubmission> pending_submissions;
+
+	std::vector<Submission> submissions;
+};
+
+/**
+ * @brief Reconstructs how busy each queue was from the submissions of consecutive frames
+ *
+ * The time between the end of the work of a queue and the beginning of its next submission is
+ * idle time. If the queue waited a large part of a frame for its first submission, the GPU was
+ * starved waiting for the CPU to submit work. With a FIFO present mode, the CPU waiting for the
+ * swapchain also starves the GPU, which is expected once the frame rate reaches the refresh rate.
+ */
+class QueueActivity
+{
+  public:
+	/**
+	 * @brief Fraction of a frame the queue must wait for its first submission to be starved
+	 */
+	static constexpr double STARVED_IDLE_FRACTION = 0.1;
+
+	/**
+	 * @brief Longer gaps, after a pause or a wrap of the timestamps, are not counted as idle time
+	 */
+	static constexpr double MAX_IDLE_GAP = 1e9;
+
+	/**
+	 * @brief Activity of a queue during a frame, in seconds
+	 */
+	struct Activity
+	{
+		float busy_time{0.0f};
+
+		float idle_time{0.0f};
+
+		/// Whether the queue was idle for long before the first submission of the frame
+		bool starved{false};
+
+		/**
+		 * @return The fraction of the frame the queue was executing work
+		 */
+		float get_busy_fraction() const;
+	};
+
+	/**
+	 * @brief Adds the submissions of the next frame
+	 * @return The activity of each queue submitted to during the frame
+	 */
+	const std::map<const Queue *, Activity> &update(const std::vector<SubmissionProfiler::Submission> &submissions);
+
+  private:
+	/// When each queue finished its last submission, in nanoseconds
+	std::map<const Queue *, double> last_ends;
+
+	std::map<const Queue *, Activity> activities;
+};
+}        // namespace vkb
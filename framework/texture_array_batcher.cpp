@@ -0,0 +1,202 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "texture_array_batcher.h"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "common/logging.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "scene_graph/components/image.h"
+#include "scene_graph/components/texture.h"
+#include "scene_graph/components/texture_array.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace
+{
+/// Format, width, height and mip level count the images of an array share
+using ArrayKey = std::tuple<VkFormat, uint32_t, uint32_t, uint32_t>;
+
+VkImageSubresourceRange get_color_range(uint32_t level_count, uint32_t base_layer, uint32_t layer_count)
+{
+	return {VK_IMAGE_ASPECT_COLOR_BIT, 0, level_count, base_layer, layer_count};
+}
+
+void barrier(CommandBuffer &command_buffer, const core::Image &image, const VkImageSubresourceRange &range,
+             VkImageLayout old_layout, VkImageLayout new_layout, VkAccessFlags src_access, VkAccessFlags dst_access,
+             VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage)
+{
+	ImageMemoryBarrier memory_barrier{};
+	memory_barrier.old_layout      = old_layout;
+	memory_barrier.new_layout      = new_layout;
+	memory_barrier.src_access_mask = src_access;
+	memory_barrier.dst_access_mask = dst_access;
+	memory_barrier.src_stage_mask  = src_stage;
+	memory_barrier.dst_stage_mask  = dst_stage;
+
+	command_buffer.image_memory_barrier(image, range, memory_barrier);
+}
+}        // namespace
+
+TextureArrayBatcher::TextureArrayBatcher(Device &device, uint32_t max_extent) :
+    device{device},
+    max_extent{max_extent}
+{
+}
+
+size_t TextureArrayBatcher::batch(sg::Scene &scene)
+{
+	// Textures sampling each image, several textures may share an image with different samplers
+	std::unordered_map<const sg::Image *, std::vector<sg::Texture *>> image_textures;
+
+	// Ordered so that the arrays and their layers do not depend on the addresses of the images
+	std::map<ArrayKey, std::vector<sg::Image *>> groups;
+
+	for (auto texture : scene.get_components<sg::Texture>())
+	{
+		auto image = texture->get_image();
+
+		if (!image || image->get_base_mip_level() != 0)
+		{
+			continue;
+		}
+
+		auto &extent = image->get_extent();
+
+		if (extent.depth != 1 || extent.width > max_extent || extent.height > max_extent)
+		{
+			continue;
+		}
+
+		auto &textures = image_textures[image];
+
+		if (textures.empty())
+		{
+			groups[ArrayKey{image->get_format(), extent.width, extent.height, image->get_mip_level_count()}].push_back(image);
+		}
+
+		textures.push_back(texture);
+	}
+
+	uint32_t max_layer_count = device.get_properties().limits.maxImageArrayLayers;
+
+	auto &command_buffer = device.request_command_buffer();
+	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, 0);
+
+	size_t batched_count = 0;
+
+	for (auto &group : groups)
+	{
+		auto &images      = group.second;
+		auto  level_count = std::get<3>(group.first);
+
+		for (size_t first = 0; first + MIN_LAYER_COUNT <= images.size(); first += max_layer_count)
+		{
+			auto layer_count = to_u32(std::min<size_t>(images.size() - first, max_layer_count));
+
+			auto array_image = std::make_unique<core::Image>(device,
+			                                                 images[first]->get_extent(),
+			                                                 std::get<0>(group.first),
+			                                                 VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+			                                                 VMA_MEMORY_USAGE_GPU_ONLY,
+			                                                 VK_SAMPLE_COUNT_1_BIT,
+			                                                 level_count,
+			                                                 layer_count);
+
+			barrier(command_buffer, *array_image, get_color_range(level_count, 0, layer_count),
+			        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			        0, VK_ACCESS_TRANSFER_WRITE_BIT,
+			        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+			auto texture_array = std::make_unique<sg::TextureArray>("texture_array_" + std::to_string(scene.get_components<sg::TextureArray>().size()),
+			                                                        std::move(array_image));
+
+			device.set_debug_name(VK_OBJECT_TYPE_IMAGE, reinterpret_cast<uint64_t>(texture_array->get_vk_image().get_handle()), texture_array->get_name());
+
+			for (uint32_t layer = 0; layer < layer_count; layer++)
+			{
+				auto &image = *images[first + layer];
+				auto &src   = image.get_vk_image();
+
+				barrier(command_buffer, src, get_color_range(level_count, 0, 1),
+				        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				        VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+				        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+				std::vector<VkImageCopy> regions(level_count);
+
+				for (uint32_t level = 0; level < level_count; level++)
+				{
+					// Compressed levels smaller than a block still copy their whole extent, which reaches the edge of the image
+					auto &region          = regions[level];
+					region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+					region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, layer, 1};
+					region.extent.width   = std::max(1u, image.get_extent().width >> level);
+					region.extent.height  = std::max(1u, image.get_extent().height >> level);
+					region.extent.depth   = 1;
+				}
+
+				command_buffer.copy_image(src, texture_array->get_vk_image(), regions);
+
+				barrier(command_buffer, src, get_color_range(level_count, 0, 1),
+				        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				        0, VK_ACCESS_SHADER_READ_BIT,
+				        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+				for (auto texture : image_textures[&image])
+				{
+					texture->set_array(texture_array.get(), layer);
+				}
+			}
+
+			barrier(command_buffer, texture_array->get_vk_image(), get_color_range(level_count, 0, layer_count),
+			        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			        VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+			        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+			batched_count += layer_count;
+
+			scene.add_component(std::move(texture_array));
+		}
+	}
+
+	command_buffer.end();
+
+	auto &queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+
+	queue.submit(command_buffer, device.request_fence());
+
+	// The copies must be complete before the first frame samples the arrays
+	device.get_fence_pool().wait();
+	device.get_fence_pool().reset();
+	device.get_command_pool().reset_pool();
+
+	LOGI("Batched {} images into {} texture arrays", batched_count, scene.get_components<sg::TextureArray>().size());
+
+	return batched_count;
+}
+}        // namespace vkb
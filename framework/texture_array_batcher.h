@@ -0,0 +1,73 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class Device;
+
+namespace sg
+{
+class Scene;
+}        // namespace sg
+
+/**
+ * @brief Copies the small material images of a scene into 2D image arrays, once loaded
+ *
+ * Images with the same format, extent and mip level count are grouped, and each group of at
+ * least MIN_LAYER_COUNT images gets a sg::TextureArray with one layer per image. The textures
+ * of the scene remember the array and layer of their image, so that materials differing only by
+ * their images bind the same array view and push their layer instead, see GeometrySubpass::set_texture_arrays_enabled().
+ *
+ * The original images are kept for passes which do not sample the arrays, so the batched images use
+ * twice their memory. Images must not be replaced after batching, it is not compatible with texture
+ * streaming and progressive loading.
+ */
+class TextureArrayBatcher
+{
+  public:
+	/// Largest width and height of the images batched by default, bigger images rarely share a size
+	static constexpr uint32_t DEFAULT_MAX_EXTENT{512};
+
+	/// Fewest images sharing an array, a single image gains nothing from it
+	static constexpr uint32_t MIN_LAYER_COUNT{2};
+
+	/**
+	 * @param device Device the scene images were created on
+	 * @param max_extent Largest width and height of the images batched
+	 */
+	TextureArrayBatcher(Device &device, uint32_t max_extent = DEFAULT_MAX_EXTENT);
+
+	/**
+	 * @brief Creates the texture arrays of a scene and waits for the images to be copied
+	 *        The images must have been uploaded and be in the shader read only layout.
+	 * @return Number of images copied into an array
+	 */
+	size_t batch(sg::Scene &scene);
+
+  private:
+	Device &device;
+
+	uint32_t max_extent;
+};
+}        // namespace vkb
@@ -0,0 +1,574 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "texture_streamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include "common/error.h"
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "common/utils.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "core/image.h"
+#include "core/image_view.h"
+#include "core/queue.h"
+#include "scene_graph/components/image.h"
+#include "scene_graph/components/image/astc.h"
+#include "scene_graph/components/image/ktx2.h"
+
+namespace vkb
+{
+namespace
+{
+/// Requested level of the images which were not requested since the last update
+constexpr float NOT_REQUESTED = std::numeric_limits<float>::max();
+
+VkExtent3D get_mip_extent(const VkExtent3D &extent, uint32_t level)
+{
+	return {std::max(1u, extent.width >> level), std::max(1u, extent.height >> level), 1u};
+}
+}        // namespace
+
+TextureStreamer::TextureStreamer(Device &device, VkDeviceSize budget, uint32_t frames_in_flight, bool sparse_residency) :
+    device{device},
+    budget{budget},
+    frames_in_flight{frames_in_flight},
+    upload_manager{device}
+{
+	if (sparse_residency)
+	{
+		if (device.is_sparse_residency_enabled())
+		{
+			sparse_queue = &device.get_queue_by_flags(VK_QUEUE_SPARSE_BINDING_BIT, 0);
+		}
+		else
+		{
+			LOGW("Texture streaming: sparse residency is not supported, images are streamed by copies");
+		}
+	}
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	// Finish the files being decoded, which create their image on the device
+	for (auto &it : streamed_images)
+	{
+		if (it.second.pending_load.valid())
+		{
+			it.second.pending_load.wait();
+		}
+
+		destroy_fence(it.second);
+	}
+}
+
+void TextureStreamer::set_budget(VkDeviceSize new_budget)
+{
+	budget = new_budget;
+}
+
+VkDeviceSize TextureStreamer::get_budget() const
+{
+	return budget;
+}
+
+VkDeviceSize TextureStreamer::get_resident_size() const
+{
+	VkDeviceSize size = 0;
+
+	for (auto &it : streamed_images)
+	{
+		size += it.second.image->get_vk_image().get_allocation_size();
+	}
+
+	return size;
+}
+
+void TextureStreamer::request(sg::Image &image, float mip_level)
+{
+	auto it = streamed_images.find(&image);
+
+	if (it == streamed_images.end())
+	{
+		if (ignored_images.count(&image) > 0)
+		{
+			return;
+		}
+
+		// The finer levels of an image can only be restored from its file
+		if (image.get_uri().empty() || image.get_mip_level_count() < 2)
+		{
+			ignored_images.insert(&image);
+			return;
+		}
+
+		StreamedImage streamed{};
+		streamed.image           = &image;
+		streamed.requested_level = NOT_REQUESTED;
+		streamed.target_level    = image.get_base_mip_level();
+		streamed.sparse          = sparse_queue != nullptr;
+
+		it = streamed_images.emplace(&image, std::move(streamed)).first;
+	}
+
+	it->second.requested_level = std::min(it->second.requested_level, std::max(0.0f, mip_level));
+}
+
+void TextureStreamer::update(CommandBuffer &command_buffer)
+{
+	frame_index++;
+
+	// Release the images no frame in flight samples any more
+	retired_images.erase(std::remove_if(retired_images.begin(), retired_images.end(),
+	                                    [this](const RetiredImage &retired) { return retired.release_frame <= frame_index; }),
+	                     retired_images.end());
+
+	select_target_levels();
+
+	size_t pending_loads = std::count_if(streamed_images.begin(), streamed_images.end(),
+	                                     [this](const std::pair<const sg::Image *const, StreamedImage> &it) { return is_loading(it.second); });
+
+	for (auto it = streamed_images.begin(); it != streamed_images.end();)
+	{
+		auto &streamed = it->second;
+
+		bool was_loading = is_loading(streamed);
+
+		if (streamed.converting)
+		{
+			update_conversion(command_buffer, streamed);
+		}
+
+		if (!update_load(streamed))
+		{
+			destroy_fence(streamed);
+			ignored_images.insert(it->first);
+			it = streamed_images.erase(it);
+			continue;
+		}
+
+		auto base_level = streamed.image->get_base_mip_level();
+
+		// An image swapped in this frame is only acquired at the end of the update
+		if (!was_loading && streamed.sparse && !streamed.image->get_vk_image().is_sparse())
+		{
+			convert(streamed);
+		}
+		else if (!was_loading)
+		{
+			if (streamed.sparse)
+			{
+				decommit(streamed);
+			}
+
+			// Levels still sampled by frames in flight cannot be committed again until they are decommitted
+			bool can_load = !streamed.sparse || (streamed.decommit_frame == 0 && is_bound(streamed));
+
+			// Evict one level more than needed only when over budget, so requests moving by a level do not reallocate the image
+			if (streamed.target_level > base_level + 1 ||
+			    (streamed.target_level > base_level && get_resident_size() > budget))
+			{
+				evict(command_buffer, streamed, streamed.target_level);
+			}
+			else if (streamed.target_level < base_level && pending_loads < MAX_PENDING_LOADS && can_load)
+			{
+				load(streamed, streamed.target_level);
+				pending_loads++;
+			}
+		}
+
+		streamed.unused_frames   = streamed.requested_level == NOT_REQUESTED ? streamed.unused_frames + 1 : 0;
+		streamed.requested_level = NOT_REQUESTED;
+
+		++it;
+	}
+
+	// Record the acquires of the uploads completed so far, including the images swapped in above
+	upload_manager.acquire(command_buffer);
+}
+
+VkDeviceSize TextureStreamer::get_size(const StreamedImage &streamed, uint32_t base_level) const
+{
+	// Each level is about a quarter of the previous one
+	auto resident_size = static_cast<double>(streamed.image->get_vk_image().get_allocation_size());
+	auto level_offset  = static_cast<int>(streamed.image->get_base_mip_level()) - static_cast<int>(base_level);
+
+	return static_cast<VkDeviceSize>(resident_size * std::pow(4.0, level_offset));
+}
+
+void TextureStreamer::select_target_levels()
+{
+	VkDeviceSize total_size = 0;
+
+	for (auto &it : streamed_images)
+	{
+		auto &streamed = it.second;
+		auto &image    = *streamed.image;
+
+		uint32_t coarsest_level = image.get_mip_level_count() - 1;
+
+		if (streamed.requested_level != NOT_REQUESTED)
+		{
+			streamed.target_level = std::min(coarsest_level, static_cast<uint32_t>(std::floor(streamed.requested_level)));
+		}
+		else if (streamed.unused_frames >= UNUSED_FRAMES)
+		{
+			uint32_t unused_level = 0;
+			while (unused_level < coarsest_level && std::max(image.get_extent().width, image.get_extent().height) >> unused_level > UNUSED_EXTENT)
+			{
+				unused_level++;
+			}
+
+			streamed.target_level = std::max(streamed.target_level, unused_level);
+		}
+
+		total_size += get_size(streamed, streamed.target_level);
+	}
+
+	// Drop the finest level of the largest image until the requests fit in the budget
+	while (total_size > budget)
+	{
+		StreamedImage *largest      = nullptr;
+		VkDeviceSize   largest_size = 0;
+
+		for (auto &it : streamed_images)
+		{
+			auto &streamed = it.second;
+			auto  size     = get_size(streamed, streamed.target_level);
+
+			if (streamed.target_level + 1 < streamed.image->get_mip_level_count() && size > largest_size)
+			{
+				largest      = &streamed;
+				largest_size = size;
+			}
+		}
+
+		if (!largest)
+		{
+			break;
+		}
+
+		largest->target_level++;
+
+		total_size = total_size - largest_size + get_size(*largest, largest->target_level);
+	}
+}
+
+void TextureStreamer::evict(CommandBuffer &command_buffer, StreamedImage &streamed, uint32_t level)
+{
+	auto &image = *streamed.image;
+
+	if (streamed.sparse)
+	{
+		LOGD("Texture streaming: evicted image {} to level {}, decommitting the finer levels", image.get_name(), level);
+
+		// The finer levels are decommitted once the frames in flight no longer sample them through the previous view
+		retire({nullptr, image.set_base_mip_level(level)});
+
+		streamed.decommit_frame = frame_index + frames_in_flight;
+
+		return;
+	}
+
+	auto &current = image.get_vk_image();
+
+	uint32_t base_level  = image.get_base_mip_level();
+	uint32_t level_count = image.get_mip_level_count() - level;
+
+	auto evicted = std::make_unique<core::Image>(device,
+	                                             get_mip_extent(image.get_extent(), level),
+	                                             current.get_format(),
+	                                             current.get_usage(),
+	                                             VMA_MEMORY_USAGE_GPU_ONLY,
+	                                             VK_SAMPLE_COUNT_1_BIT,
+	                                             level_count);
+
+	copy_sampled_levels(command_buffer, current, level - base_level, *evicted, 0, level_count);
+
+	LOGD("Texture streaming: evicted image {} to level {}", image.get_name(), level);
+
+	retire(image.replace_vk_image(std::move(evicted), level));
+}
+
+void TextureStreamer::load(StreamedImage &streamed, uint32_t level)
+{
+	auto &image = *streamed.image;
+
+	auto     name        = image.get_name();
+	auto     uri         = image.get_uri();
+	auto     format      = image.get_vk_image().get_format();
+	uint32_t level_count = image.get_mip_level_count();
+	bool     sparse      = streamed.sparse;
+
+	streamed.loading_level = level;
+
+	if (sparse)
+	{
+		auto &vk_image = image.get_mut_vk_image();
+
+		// The memory of the levels is bound while the file is decoded
+		for (uint32_t mip_level = level; mip_level < image.get_base_mip_level(); ++mip_level)
+		{
+			vk_image.commit_level(mip_level);
+		}
+
+		bind(streamed, vk_image);
+	}
+
+	streamed.pending_load = device.get_job_system().push(JobPriority::Background, [this, name, uri, format, level, level_count, sparse](size_t) -> std::unique_ptr<sg::Image> {
+		try
+		{
+			auto loaded = sg::Image::load(name, uri);
+
+			// Convert the file like the scene loader did
+			if (auto ktx2 = dynamic_cast<sg::Ktx2 *>(loaded.get()))
+			{
+				if (ktx2->needs_transcoding())
+				{
+					ktx2->transcode(device);
+				}
+			}
+
+			if (sg::is_astc(loaded->get_format()) && !sg::is_astc(format))
+			{
+				loaded = std::make_unique<sg::Astc>(*loaded);
+			}
+
+			if (loaded->get_mipmaps().size() == 1 && level_count > 1)
+			{
+				loaded->generate_mipmaps();
+			}
+
+			if (loaded->get_format() != format || loaded->get_mipmaps().size() != level_count)
+			{
+				LOGW("Texture streaming: image {} does not match its file {}, it will not be streamed", name, uri);
+				return nullptr;
+			}
+
+			loaded->remove_mip_levels(level);
+
+			// Partially resident images are uploaded in place
+			if (!sparse)
+			{
+				loaded->create_vk_image(device);
+			}
+
+			return loaded;
+		}
+		catch (const std::exception &e)
+		{
+			LOGE("Texture streaming: cannot load image {}: {}", uri, e.what());
+			return nullptr;
+		}
+	});
+}
+
+bool TextureStreamer::update_load(StreamedImage &streamed)
+{
+	if (streamed.pending_load.valid() && (!streamed.sparse || is_bound(streamed)) &&
+	    streamed.pending_load.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		streamed.uploading = streamed.pending_load.get();
+
+		if (!streamed.uploading)
+		{
+			return false;
+		}
+
+		if (streamed.sparse)
+		{
+			// Only the committed levels are uploaded, the coarser ones are resident already
+			auto level_count = streamed.image->get_base_mip_level() - streamed.loading_level;
+
+			streamed.upload_view = std::make_unique<core::ImageView>(streamed.image->get_mut_vk_image(), VK_IMAGE_VIEW_TYPE_2D, VK_FORMAT_UNDEFINED, streamed.loading_level, level_count);
+
+			upload_manager.upload(*streamed.uploading, *streamed.upload_view);
+		}
+		else
+		{
+			upload_manager.upload(*streamed.uploading);
+		}
+
+		// Clean up the image data, as they are copied in the staging ring
+		streamed.uploading->clear_data();
+
+		streamed.upload_batch_id = upload_manager.submit();
+	}
+
+	if (streamed.uploading && streamed.sparse && upload_manager.is_complete(streamed.upload_batch_id))
+	{
+		LOGD("Texture streaming: loaded image {} from level {} in place", streamed.image->get_name(), streamed.loading_level);
+
+		retire({nullptr, streamed.image->set_base_mip_level(streamed.loading_level)});
+
+		// The acquire recorded at the end of the update refers to the view of the upload
+		retire({nullptr, std::move(streamed.upload_view)});
+
+		streamed.uploading.reset();
+		streamed.upload_batch_id = 0;
+	}
+	else if (streamed.uploading && upload_manager.is_complete(streamed.upload_batch_id))
+	{
+		auto uploaded = streamed.uploading->replace_vk_image(nullptr);
+
+		LOGD("Texture streaming: loaded image {} from level {}", streamed.image->get_name(), streamed.loading_level);
+
+		retire(streamed.image->replace_vk_image(std::move(uploaded.first), streamed.loading_level));
+
+		// The acquire recorded at the end of the update refers to the view of the upload
+		retire({nullptr, std::move(uploaded.second)});
+
+		streamed.uploading.reset();
+		streamed.upload_batch_id = 0;
+	}
+
+	return true;
+}
+
+bool TextureStreamer::is_loading(const StreamedImage &streamed) const
+{
+	return streamed.pending_load.valid() || streamed.uploading || streamed.converting;
+}
+
+void TextureStreamer::convert(StreamedImage &streamed)
+{
+	auto &image   = *streamed.image;
+	auto &current = image.get_vk_image();
+
+	try
+	{
+		streamed.converting = std::make_unique<core::Image>(device, image.get_extent(), current.get_format(), current.get_usage(), image.get_mip_level_count(), 0);
+	}
+	catch (const VulkanException &e)
+	{
+		LOGW("Texture streaming: image {} cannot be partially resident, it is streamed by copies: {}", image.get_name(), e.what());
+
+		streamed.sparse = false;
+		return;
+	}
+
+	for (uint32_t level = image.get_base_mip_level(); level < image.get_mip_level_count(); ++level)
+	{
+		streamed.converting->commit_level(level);
+	}
+
+	bind(streamed, *streamed.converting);
+}
+
+void TextureStreamer::update_conversion(CommandBuffer &command_buffer, StreamedImage &streamed)
+{
+	if (!is_bound(streamed))
+	{
+		return;
+	}
+
+	auto &image = *streamed.image;
+
+	uint32_t base_level = image.get_base_mip_level();
+
+	copy_sampled_levels(command_buffer, image.get_vk_image(), 0, *streamed.converting, base_level, image.get_mip_level_count() - base_level);
+
+	LOGD("Texture streaming: converted image {} to a partially resident image", image.get_name());
+
+	retire(image.replace_vk_image(std::move(streamed.converting)));
+
+	retire({nullptr, image.set_base_mip_level(base_level)});
+}
+
+void TextureStreamer::decommit(StreamedImage &streamed)
+{
+	if (streamed.decommit_frame == 0 || frame_index < streamed.decommit_frame || !is_bound(streamed))
+	{
+		return;
+	}
+
+	auto &vk_image = streamed.image->get_mut_vk_image();
+
+	// The mip tail also holds the levels seen by the view
+	uint32_t level_count = std::min(streamed.image->get_base_mip_level(), vk_image.get_mip_tail_level());
+
+	for (uint32_t level = 0; level < level_count; ++level)
+	{
+		vk_image.decommit_level(level);
+	}
+
+	bind(streamed, vk_image);
+
+	streamed.decommit_frame = 0;
+}
+
+void TextureStreamer::bind(StreamedImage &streamed, core::Image &image)
+{
+	assert(!streamed.binding && "Sparse binds of the image are still pending");
+
+	if (streamed.bind_fence == VK_NULL_HANDLE)
+	{
+		VkFenceCreateInfo create_info{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+
+		VK_CHECK(vkCreateFence(device.get_handle(), &create_info, nullptr, &streamed.bind_fence));
+	}
+	else
+	{
+		VK_CHECK(vkResetFences(device.get_handle(), 1, &streamed.bind_fence));
+	}
+
+	VK_CHECK(image.bind_sparse_memory(*sparse_queue, streamed.bind_fence));
+
+	streamed.binding = true;
+}
+
+bool TextureStreamer::is_bound(StreamedImage &streamed)
+{
+	if (streamed.binding && vkGetFenceStatus(device.get_handle(), streamed.bind_fence) == VK_SUCCESS)
+	{
+		streamed.binding = false;
+	}
+
+	return !streamed.binding;
+}
+
+void TextureStreamer::destroy_fence(StreamedImage &streamed)
+{
+	if (streamed.bind_fence == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	if (streamed.binding)
+	{
+		vkWaitForFences(device.get_handle(), 1, &streamed.bind_fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+	}
+
+	vkDestroyFence(device.get_handle(), streamed.bind_fence, nullptr);
+
+	streamed.bind_fence = VK_NULL_HANDLE;
+	streamed.binding    = false;
+}
+
+void TextureStreamer::retire(std::pair<std::unique_ptr<core::Image>, std::unique_ptr<core::ImageView>> &&resources)
+{
+	retired_images.push_back({std::move(resources.first), std::move(resources.second), frame_index + frames_in_flight});
+}
+}        // namespace vkb
@@ -0,0 +1,253 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <future>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "common/vk_common.h"
+#include "upload_manager.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+class Queue;
+
+namespace core
+{
+class Image;
+class ImageView;
+}        // namespace core
+
+namespace sg
+{
+class Image;
+}
+
+/**
+ * @brief Keeps the resident mip levels of the scene images within a memory budget
+ *
+ * Subpasses request the finest level each image needs from the screen size of the meshes using it.
+ * Once per frame update() moves the resident levels of the images towards their requests:
+ * finest levels no longer needed are evicted by copying the others to a smaller image, and
+ * finer levels are decoded again from the image file in the background then uploaded.
+ * When the requests do not fit in the budget, the largest images give up levels first.
+ *
+ * Images which are not requested for UNUSED_FRAMES frames keep only the levels up to
+ * UNUSED_EXTENT texels. Images not loaded from a file are never streamed.
+ *
+ * With sparse residency the images are converted once to partially resident images holding the
+ * full chain. Levels are then evicted by moving the view to a coarser level and decommitting the
+ * finer ones, and loaded by committing them before uploading them in place, without any copy.
+ */
+class TextureStreamer
+{
+  public:
+	/// Frames after which an image without request keeps only its coarse levels
+	static constexpr uint32_t UNUSED_FRAMES{120};
+
+	/// Largest extent of the levels kept by images without request
+	static constexpr uint32_t UNUSED_EXTENT{64};
+
+	/// Maximum number of images decoded in the background at once
+	static constexpr size_t MAX_PENDING_LOADS{2};
+
+	/**
+	 * @param device Device the images are created on
+	 * @param budget Memory in bytes the streamed images may use
+	 * @param frames_in_flight Number of frames which may sample an image after it is replaced
+	 * @param sparse_residency Streams the images as partially resident images, ignored if the device does not support it
+	 */
+	TextureStreamer(Device &device, VkDeviceSize budget, uint32_t frames_in_flight, bool sparse_residency = false);
+
+	TextureStreamer(const TextureStreamer &) = delete;
+
+	TextureStreamer(TextureStreamer &&) = delete;
+
+	~TextureStreamer();
+
+	TextureStreamer &operator=(const TextureStreamer &) = delete;
+
+	TextureStreamer &operator=(TextureStreamer &&) = delete;
+
+	void set_budget(VkDeviceSize budget);
+
+	VkDeviceSize get_budget() const;
+
+	/**
+	 * @return Memory in bytes used by the streamed images
+	 */
+	VkDeviceSize get_resident_size() const;
+
+	/**
+	 * @brief Requests the levels of an image needed for the current frame, the finest request of a frame is kept
+	 * @param image Image sampled by a draw, registered for streaming on its first request
+	 * @param mip_level Finest level of the full chain the draw samples
+	 */
+	void request(sg::Image &image, float mip_level);
+
+	/**
+	 * @brief Applies the requests made since the last call, to be called once per frame
+	 * @param command_buffer Graphics command buffer of the frame, recorded before any draw. It receives
+	 *        the copies of the evicted images and the ownership acquires of the uploaded ones
+	 */
+	void update(CommandBuffer &command_buffer);
+
+  private:
+	struct StreamedImage
+	{
+		sg::Image *image;
+
+		/// Finest level requested since the last update
+		float requested_level;
+
+		/// Frames since the image was last requested
+		uint32_t unused_frames;
+
+		/// Level the resident levels are moving to
+		uint32_t target_level;
+
+		/// Level of the full chain the levels being loaded start from
+		uint32_t loading_level;
+
+		/// Image file decoded in the background, holding the levels from loading_level
+		std::future<std::unique_ptr<sg::Image>> pending_load;
+
+		/// Decoded levels being uploaded
+		std::unique_ptr<sg::Image> uploading;
+
+		uint64_t upload_batch_id;
+
+		/// Whether the image is streamed as a partially resident image
+		bool sparse;
+
+		/// Partially resident image waiting for its memory, before the resident levels are copied to it
+		std::unique_ptr<core::Image> converting;
+
+		/// View of the levels uploaded to the partially resident image
+		std::unique_ptr<core::ImageView> upload_view;
+
+		/// Signaled once the last sparse binds of the image are applied
+		VkFence bind_fence;
+
+		/// Whether sparse binds were submitted since the fence was last seen signaled
+		bool binding;
+
+		/// Frame from which the levels finer than the view are no longer sampled and can be decommitted, 0 if none
+		uint64_t decommit_frame;
+	};
+
+	struct RetiredImage
+	{
+		std::unique_ptr<core::Image> image;
+
+		std::unique_ptr<core::ImageView> image_view;
+
+		/// Frame from which no frame in flight samples the image any more
+		uint64_t release_frame;
+	};
+
+	/**
+	 * @return Estimated size in bytes of the levels from base_level of the image
+	 */
+	VkDeviceSize get_size(const StreamedImage &streamed, uint32_t base_level) const;
+
+	/**
+	 * @brief Selects the target level of every image from the requests and the budget
+	 */
+	void select_target_levels();
+
+	/**
+	 * @brief Copies the levels from level to a new image, releasing the finer ones
+	 */
+	void evict(CommandBuffer &command_buffer, StreamedImage &streamed, uint32_t level);
+
+	/**
+	 * @brief Starts decoding the image file in the background, to upload the levels from level
+	 */
+	void load(StreamedImage &streamed, uint32_t level);
+
+	/**
+	 * @brief Uploads the decoded levels, and swaps their image in once they are uploaded
+	 * @return False if the image file could not be loaded again, so the image cannot be streamed
+	 */
+	bool update_load(StreamedImage &streamed);
+
+	bool is_loading(const StreamedImage &streamed) const;
+
+	/**
+	 * @brief Starts converting the image to a partially resident image, committing its resident levels
+	 *        Falls back to streaming by copies if the image cannot be partially resident
+	 */
+	void convert(StreamedImage &streamed);
+
+	/**
+	 * @brief Copies the resident levels to the partially resident image once its memory is bound, and swaps it in
+	 */
+	void update_conversion(CommandBuffer &command_buffer, StreamedImage &streamed);
+
+	/**
+	 * @brief Decommits the levels finer than the view of a partially resident image, once no frame in flight samples them
+	 */
+	void decommit(StreamedImage &streamed);
+
+	/**
+	 * @brief Submits the pending sparse binds of an image, signaling the fence of the streamed image
+	 */
+	void bind(StreamedImage &streamed, core::Image &image);
+
+	/**
+	 * @return Whether the last sparse binds of the image were applied, so new ones can be submitted
+	 */
+	bool is_bound(StreamedImage &streamed);
+
+	/**
+	 * @brief Waits for the last sparse binds of the image and destroys its fence
+	 */
+	void destroy_fence(StreamedImage &streamed);
+
+	void retire(std::pair<std::unique_ptr<core::Image>, std::unique_ptr<core::ImageView>> &&resources);
+
+	Device &device;
+
+	VkDeviceSize budget;
+
+	uint32_t frames_in_flight;
+
+	uint64_t frame_index{0};
+
+	/// Queue the sparse binds are submitted to, null if the images are streamed by copies
+	const Queue *sparse_queue{nullptr};
+
+	std::unordered_map<const sg::Image *, StreamedImage> streamed_images;
+
+	/// Images which cannot be streamed, e.g. not loaded from a file
+	std::unordered_set<const sg::Image *> ignored_images;
+
+	std::vector<RetiredImage> retired_images;
+
+	UploadManager upload_manager;
+};
+}        // namespace vkb
@@ -0,0 +1,154 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "thermal_governor.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "common/logging.h"
+#include "platform/platform.h"
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @brief Approximates the thermal headroom from the status, for platforms only reporting the latter
+ */
+float get_status_pressure(ThermalStatus status)
+{
+	switch (status)
+	{
+		case ThermalStatus::None:
+			return 0.5f;
+		case ThermalStatus::Light:
+			return 0.8f;
+		case ThermalStatus::Moderate:
+			return 0.9f;
+		case ThermalStatus::Severe:
+			return 1.0f;
+		case ThermalStatus::Critical:
+		case ThermalStatus::Emergency:
+		case ThermalStatus::Shutdown:
+			return 1.2f;
+		default:
+			return std::numeric_limits<float>::quiet_NaN();
+	}
+}
+}        // namespace
+
+constexpr float ThermalGovernor::POLL_INTERVAL;
+
+constexpr float ThermalGovernor::HYSTERESIS;
+
+constexpr float ThermalGovernor::MIN_APPLIED_TIME;
+
+ThermalGovernor::ThermalGovernor(Platform &platform) :
+    platform{platform},
+    pressure{std::numeric_limits<float>::quiet_NaN()}
+{
+}
+
+void ThermalGovernor::add_policy(const std::string &name, float threshold, Action apply, Action revert)
+{
+	Policy policy{name, threshold, std::move(apply), std::move(revert)};
+
+	// Keep the policies sorted by threshold, so that they are applied from the cheapest degradation
+	auto it = std::upper_bound(policies.begin(), policies.end(), threshold, [](float value, const Policy &other) { return value < other.threshold; });
+
+	policies.insert(it, std::move(policy));
+}
+
+void ThermalGovernor::update(float delta_time)
+{
+	for (auto &policy : policies)
+	{
+		if (policy.applied)
+		{
+			policy.applied_time += delta_time;
+		}
+	}
+
+	poll_time += delta_time;
+
+	if (poll_time < POLL_INTERVAL)
+	{
+		return;
+	}
+
+	poll_time = 0.0f;
+
+	thermal_state = platform.get_thermal_state();
+
+	pressure = std::isnan(thermal_state.headroom) ? get_status_pressure(thermal_state.status) : thermal_state.headroom;
+
+	if (std::isnan(pressure))
+	{
+		return;
+	}
+
+	for (auto &policy : policies)
+	{
+		if (!policy.applied && pressure >= policy.threshold)
+		{
+			LOGI("Thermal pressure {:.2f}, applying policy: {}", pressure, policy.name);
+
+			policy.apply();
+			policy.applied      = true;
+			policy.applied_time = 0.0f;
+		}
+	}
+
+	// Revert from the most expensive degradation
+	for (auto it = policies.rbegin(); it != policies.rend(); ++it)
+	{
+		if (it->applied && pressure < it->threshold - HYSTERESIS && it->applied_time >= MIN_APPLIED_TIME)
+		{
+			LOGI("Thermal pressure {:.2f}, reverting policy: {}", pressure, it->name);
+
+			it->revert();
+			it->applied = false;
+		}
+	}
+}
+
+const ThermalState &ThermalGovernor::get_thermal_state() const
+{
+	return thermal_state;
+}
+
+float ThermalGovernor::get_pressure() const
+{
+	return pressure;
+}
+
+void ThermalGovernor::reset()
+{
+	for (auto it = policies.rbegin(); it != policies.rend(); ++it)
+	{
+		if (it->applied)
+		{
+			it->revert();
+			it->applied = false;
+		}
+	}
+}
+}        // namespace vkb
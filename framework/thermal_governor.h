@@ -0,0 +1,114 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "platform/thermal.h"
+
+namespace vkb
+{
+class Platform;
+
+/**
+ * @brief Applies degradation policies as the device heats up, before the OS throttles the clocks
+ *
+ * The thermal state of the platform is polled every POLL_INTERVAL. Each policy is applied once
+ * the thermal pressure reaches its threshold, and reverted once the pressure falls back under the
+ * threshold by HYSTERESIS and the policy was applied for at least MIN_APPLIED_TIME. Over long
+ * sessions this settles on the quality the device can sustain instead of oscillating around it.
+ *
+ * The pressure is the thermal headroom when the platform reports it, 1.0 being the severe
+ * throttling threshold, otherwise it is derived from the thermal status.
+ */
+class ThermalGovernor
+{
+  public:
+	using Action = std::function<void()>;
+
+	static constexpr float POLL_INTERVAL{1.0f};
+
+	static constexpr float HYSTERESIS{0.1f};
+
+	static constexpr float MIN_APPLIED_TIME{30.0f};
+
+	ThermalGovernor(Platform &platform);
+
+	/**
+	 * @brief Registers a degradation policy, policies with the same threshold being applied in registration order
+	 * @param name Name of the policy, logged when it is applied and reverted
+	 * @param threshold Thermal pressure at which the policy is applied
+	 * @param apply Lowers the cost of the frames
+	 * @param revert Restores what apply changed
+	 */
+	void add_policy(const std::string &name, float threshold, Action apply, Action revert);
+
+	/**
+	 * @brief Polls the thermal state and applies or reverts the policies
+	 * @param delta_time Time since the last update in seconds
+	 */
+	void update(float delta_time);
+
+	/**
+	 * @return The thermal state when it was last polled
+	 */
+	const ThermalState &get_thermal_state() const;
+
+	/**
+	 * @return The thermal pressure when it was last polled, NaN if the platform reports no thermal state
+	 */
+	float get_pressure() const;
+
+	/**
+	 * @brief Reverts all the applied policies
+	 */
+	void reset();
+
+  private:
+	struct Policy
+	{
+		std::string name;
+
+		float threshold;
+
+		Action apply;
+
+		Action revert;
+
+		bool applied{false};
+
+		/// Time since the policy was applied
+		float applied_time{0.0f};
+	};
+
+	Platform &platform;
+
+	std::vector<Policy> policies;
+
+	ThermalState thermal_state;
+
+	float pressure;
+
+	float poll_time{POLL_INTERVAL};
+};
+}        // namespace vkb
@@ -0,0 +1,132 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "timeline_semaphore.h"
+
+#include "common/error.h"
+#include "core/device.h"
+
+namespace vkb
+{
+TimelineSemaphore::TimelineSemaphore(Device &device, uint64_t initial_value) :
+    device{device},
+    last_value{initial_value},
+    completed_value{initial_value}
+{
+	assert(device.is_timeline_semaphore_enabled() && "VK_KHR_timeline_semaphore is not enabled");
+
+	VkSemaphoreTypeCreateInfoKHR type_create_info{VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR};
+
+	type_create_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+	type_create_info.initialValue  = initial_value;
+
+	VkSemaphoreCreateInfo create_info{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+
+	create_info.pNext = &type_create_info;
+
+	VkResult result = vkCreateSemaphore(device.get_handle(), &create_info, nullptr, &handle);
+
+	if (result != VK_SUCCESS)
+	{
+		throw VulkanException{result, "Cannot create timeline semaphore"};
+	}
+}
+
+TimelineSemaphore::TimelineSemaphore(TimelineSemaphore &&other) :
+    device{other.device},
+    handle{other.handle},
+    last_value{other.last_value.load()},
+    completed_value{other.completed_value.load()}
+{
+	other.handle = VK_NULL_HANDLE;
+}
+
+TimelineSemaphore::~TimelineSemaphore()
+{
+	if (handle != VK_NULL_HANDLE)
+	{
+		vkDestroySemaphore(device.get_handle(), handle, nullptr);
+	}
+}
+
+VkSemaphore TimelineSemaphore::get_handle() const
+{
+	return handle;
+}
+
+uint64_t TimelineSemaphore::request_value()
+{
+	return ++last_value;
+}
+
+uint64_t TimelineSemaphore::get_last_value() const
+{
+	return last_value;
+}
+
+uint64_t TimelineSemaphore::get_completed_value()
+{
+	uint64_t value{0};
+
+	VK_CHECK(vkGetSemaphoreCounterValueKHR(device.get_handle(), handle, &value));
+
+	update_completed_value(value);
+
+	return value;
+}
+
+bool TimelineSemaphore::is_complete(uint64_t value)
+{
+	return completed_value >= value || get_completed_value() >= value;
+}
+
+VkResult TimelineSemaphore::wait(uint64_t value, uint64_t timeout)
+{
+	if (completed_value >= value)
+	{
+		return VK_SUCCESS;
+	}
+
+	VkSemaphoreWaitInfoKHR wait_info{VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR};
+
+	wait_info.semaphoreCount = 1;
+	wait_info.pSemaphores    = &handle;
+	wait_info.pValues        = &value;
+
+	VkResult result = vkWaitSemaphoresKHR(device.get_handle(), &wait_info, timeout);
+
+	if (result == VK_SUCCESS)
+	{
+		update_completed_value(value);
+	}
+
+	return result;
+}
+
+void TimelineSemaphore::update_completed_value(uint64_t value)
+{
+	// Several threads may query the semaphore, only move the known value forward
+	uint64_t known = completed_value;
+
+	while (known < value && !completed_value.compare_exchange_weak(known, value))
+	{
+	}
+}
+}        // namespace vkb
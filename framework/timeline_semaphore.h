@@ -0,0 +1,92 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class Device;
+
+/**
+ * @brief A VK_KHR_timeline_semaphore semaphore tracking the progress of a queue.
+ *        Every submission signals the next value of the timeline, so work can be waited
+ *        on by value instead of with a fence per submission.
+ */
+class TimelineSemaphore
+{
+  public:
+	TimelineSemaphore(Device &device, uint64_t initial_value = 0);
+
+	TimelineSemaphore(const TimelineSemaphore &) = delete;
+
+	TimelineSemaphore(TimelineSemaphore &&other);
+
+	~TimelineSemaphore();
+
+	TimelineSemaphore &operator=(const TimelineSemaphore &) = delete;
+
+	TimelineSemaphore &operator=(TimelineSemaphore &&) = delete;
+
+	VkSemaphore get_handle() const;
+
+	/**
+	 * @brief Reserves the value signaled by the next submission
+	 *        Values must be signaled in the order they were requested
+	 */
+	uint64_t request_value();
+
+	/**
+	 * @return The last value requested, which all the submitted work signals once complete
+	 */
+	uint64_t get_last_value() const;
+
+	/**
+	 * @return The last value signaled by the device
+	 */
+	uint64_t get_completed_value();
+
+	/**
+	 * @return Whether a value was signaled, only querying the device if the last known value is lower
+	 */
+	bool is_complete(uint64_t value);
+
+	/**
+	 * @brief Waits for a value to be signaled
+	 */
+	VkResult wait(uint64_t value, uint64_t timeout = std::numeric_limits<uint64_t>::max());
+
+  private:
+	Device &device;
+
+	VkSemaphore handle{VK_NULL_HANDLE};
+
+	std::atomic<uint64_t> last_value;
+
+	/// Last value known to be signaled
+	std::atomic<uint64_t> completed_value;
+
+	void update_completed_value(uint64_t value);
+};
+}        // namespace vkb
@@ -0,0 +1,588 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer_pool.h"
+#include "common/resource_caching.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "core/instance.h"
+#include "rendering/draw_list.h"
+#include "rendering/pipeline_state.h"
+#include "rendering/render_context.h"
+#include "rendering/render_frame.h"
+#include "rendering/subpasses/geometry_subpass.h"
+#include "resource_cache.h"
+#include "scene_graph/components/aabb.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/pbr_material.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+#include "scene_graph/transform_system.h"
+#include "timer.h"
+
+/**
+ * @brief Measures the framework code run for every draw or every frame, so that changes to it
+ *        can be compared from one build to another
+ *
+ * The host benchmarks always run, those needing a device run on a headless device and are
+ * skipped if none can be created. Each benchmark repeats its operation until it runs for at
+ * least the minimum time, then takes the median of a few such runs. Results are written as JSON,
+ * in the layout of Google Benchmark so that its comparison tools can read them.
+ *
+ * Usage: framework_benchmark [--filter substring] [--min-time milliseconds] [--out file.json]
+ */
+namespace
+{
+struct Options
+{
+	std::string filter;
+
+	double min_time_ms{50.0};
+
+	std::string out;
+};
+
+struct Result
+{
+	std::string name;
+
+	uint64_t iterations;
+
+	double ns_per_iteration;
+};
+
+/// Runs of each benchmark whose median is reported
+const size_t REPETITIONS = 5;
+
+class Runner
+{
+  public:
+	explicit Runner(const Options &options) :
+	    options{options}
+	{}
+
+	/**
+	 * @brief Measures a benchmark, unless filtered out
+	 * @param name Name of the benchmark in the results
+	 * @param body Runs the operation the given number of times, returning a value accumulated so that
+	 *        the work isn't optimized away
+	 */
+	void run(const std::string &name, const std::function<uint64_t(uint64_t)> &body)
+	{
+		if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+		{
+			return;
+		}
+
+		// Doubles the iterations until a run lasts long enough to be measured reliably
+		uint64_t iterations = 1;
+		while (measure(body, iterations) < options.min_time_ms * 1e6 && iterations < (1ull << 40))
+		{
+			iterations *= 2;
+		}
+
+		std::vector<double> times;
+		for (size_t repetition = 0; repetition < REPETITIONS; ++repetition)
+		{
+			times.push_back(measure(body, iterations) / iterations);
+		}
+
+		std::nth_element(times.begin(), times.begin() + REPETITIONS / 2, times.end());
+
+		results.push_back({name, iterations, times[REPETITIONS / 2]});
+
+		std::cerr << name << ": " << results.back().ns_per_iteration << " ns (" << iterations << " iterations)" << std::endl;
+	}
+
+	/**
+	 * @brief Writes the results in the JSON layout of Google Benchmark
+	 */
+	void write(std::ostream &os, const std::string &device_name) const
+	{
+		os << "{\n"
+		   << "  \"context\": {\n"
+		   << "    \"executable\": \"framework_benchmark\",\n"
+		   << "    \"device\": \"" << device_name << "\",\n"
+		   << "    \"repetitions\": " << REPETITIONS << "\n"
+		   << "  },\n"
+		   << "  \"benchmarks\": [";
+
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			auto &result = results[i];
+
+			os << (i == 0 ? "\n" : ",\n")
+			   << "    {\n"
+			   << "      \"name\": \"" << result.name << "\",\n"
+			   << "      \"run_type\": \"iteration\",\n"
+			   << "      \"iterations\": " << result.iterations << ",\n"
+			   << "      \"real_time\": " << result.ns_per_iteration << ",\n"
+			   << "      \"cpu_time\": " << result.ns_per_iteration << ",\n"
+			   << "      \"time_unit\": \"ns\"\n"
+			   << "    }";
+		}
+
+		os << "\n  ]\n}\n";
+	}
+
+  private:
+	/// @return The duration in nanoseconds of a run
+	double measure(const std::function<uint64_t(uint64_t)> &body, uint64_t iterations)
+	{
+		vkb::Timer timer;
+		timer.start();
+
+		checksum += body(iterations);
+
+		return timer.stop<vkb::Timer::Nanoseconds>();
+	}
+
+	const Options &options;
+
+	std::vector<Result> results;
+
+	uint64_t checksum{0};
+};
+
+vkb::ShaderSource make_source(const char *glsl)
+{
+	return vkb::ShaderSource{std::vector<uint8_t>{glsl, glsl + std::strlen(glsl)}};
+}
+
+const char *VERTEX_SHADER = R"(#version 320 es
+void main()
+{
+	gl_Position = vec4(float(gl_VertexIndex), 0.0, 0.0, 1.0);
+}
+)";
+
+const char *FRAGMENT_SHADER = R"(#version 320 es
+precision mediump float;
+layout(location = 0) out vec4 o_color;
+void main()
+{
+	o_color = vec4(1.0);
+}
+)";
+
+const char *COMPUTE_SHADER = R"(#version 320 es
+layout(local_size_x = 1) in;
+layout(set = 0, binding = 0) uniform Params
+{
+	vec4 value;
+}
+params;
+layout(set = 0, binding = 1) buffer Result
+{
+	vec4 value;
+}
+result;
+void main()
+{
+	result.value = params.value;
+}
+)";
+
+/**
+ * @brief Scene of nodes laid out on a grid in front of a camera, sharing a mesh of one submesh,
+ *        about a third of them outside the frustum
+ */
+struct SyntheticScene
+{
+	explicit SyntheticScene(size_t node_count)
+	{
+		auto root = std::make_unique<vkb::sg::Node>("root");
+		scene.set_root_node(*root);
+
+		auto material = std::make_unique<vkb::sg::PBRMaterial>("material");
+		auto sub_mesh = std::make_unique<vkb::sg::SubMesh>();
+		sub_mesh->set_material(*material);
+
+		// A unit cube, only its bounds are needed to cull and sort the nodes
+		auto mesh = std::make_unique<vkb::sg::Mesh>("mesh");
+		mesh->add_submesh(*sub_mesh, vkb::sg::AABB{glm::vec3{-0.5f}, glm::vec3{0.5f}});
+
+		size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(node_count))));
+
+		for (size_t i = 0; i < node_count; ++i)
+		{
+			auto node = std::make_unique<vkb::sg::Node>("node");
+
+			float x = static_cast<float>(i % side) - 0.5f * side;
+			float z = -static_cast<float>(i / side) * 2.0f;
+			node->get_transform().set_translation({x * 2.0f, 0.0f, z});
+
+			node->set_component(*mesh);
+			mesh->add_node(*node);
+
+			root->add_child(*node);
+			node->set_parent(*root);
+			scene.add_node(std::move(node));
+		}
+
+		auto camera_node = std::make_unique<vkb::sg::Node>("camera");
+
+		auto perspective_camera = std::make_unique<vkb::sg::PerspectiveCamera>("camera");
+		perspective_camera->set_aspect_ratio(16.0f / 9.0f);
+		perspective_camera->set_field_of_view(glm::radians(60.0f));
+		perspective_camera->set_near_plane(0.1f);
+		perspective_camera->set_far_plane(static_cast<float>(side) * 2.0f);
+		perspective_camera->set_node(*camera_node);
+		camera_node->set_component(*perspective_camera);
+		camera = perspective_camera.get();
+
+		root->add_child(*camera_node);
+		camera_node->set_parent(*root);
+		scene.add_node(std::move(camera_node));
+
+		scene.add_component(std::move(perspective_camera));
+		scene.add_component(std::move(material));
+		scene.add_component(std::move(sub_mesh));
+		scene.add_component(std::move(mesh));
+		scene.add_node(std::move(root));
+	}
+
+	vkb::sg::Scene scene;
+
+	vkb::sg::Camera *camera{nullptr};
+};
+
+/**
+ * @brief Exposes the draw list building of the geometry subpass, which is otherwise only run by draw()
+ */
+class SortedNodesSubpass : public vkb::GeometrySubpass
+{
+  public:
+	using GeometrySubpass::GeometrySubpass;
+
+	void sort(vkb::DrawList &draw_list)
+	{
+		get_sorted_nodes(draw_list);
+	}
+};
+
+/**
+ * @brief Builds a chain of nodes, each the parent of the next
+ * @return The leaf of the chain
+ */
+vkb::sg::Node &build_chain(std::vector<std::unique_ptr<vkb::sg::Node>> &nodes, size_t depth)
+{
+	for (size_t i = 0; i < depth; ++i)
+	{
+		nodes.push_back(std::make_unique<vkb::sg::Node>("chain"));
+		nodes.back()->get_transform().set_translation({1.0f, 0.0f, 0.0f});
+
+		if (i > 0)
+		{
+			nodes.back()->set_parent(*nodes[i - 1]);
+			nodes[i - 1]->add_child(*nodes.back());
+		}
+	}
+
+	return *nodes.back();
+}
+
+void run_host_benchmarks(Runner &runner)
+{
+	// Setting a state updates its hash and the pipeline hash is combined from the sub-state hashes
+	runner.run("PipelineState/hash", [](uint64_t iterations) {
+		vkb::PipelineState pipeline_state;
+
+		vkb::ColorBlendState color_blend_state;
+		color_blend_state.attachments.resize(4);
+		pipeline_state.set_color_blend_state(color_blend_state);
+
+		uint64_t checksum = 0;
+		for (uint64_t i = 0; i < iterations; ++i)
+		{
+			checksum += std::hash<vkb::PipelineState>{}(pipeline_state);
+		}
+		return checksum;
+	});
+
+	runner.run("PipelineState/set_state_and_hash", [](uint64_t iterations) {
+		vkb::PipelineState pipeline_state;
+
+		vkb::RasterizationState rasterization_states[2];
+		rasterization_states[1].cull_mode = VK_CULL_MODE_NONE;
+
+		uint64_t checksum = 0;
+		for (uint64_t i = 0; i < iterations; ++i)
+		{
+			pipeline_state.set_rasterization_state(rasterization_states[i & 1]);
+			checksum += std::hash<vkb::PipelineState>{}(pipeline_state);
+		}
+		return checksum;
+	});
+
+	for (size_t depth : {16, 256})
+	{
+		std::string suffix = "/depth:" + std::to_string(depth);
+
+		// Moving the root invalidates the whole chain, which the leaf resolves up to the root
+		runner.run("Transform/get_world_matrix/dirty" + suffix, [depth](uint64_t iterations) {
+			std::vector<std::unique_ptr<vkb::sg::Node>> nodes;
+			auto &                                      leaf = build_chain(nodes, depth);
+
+			auto &root = nodes.front()->get_transform();
+
+			float checksum = 0.0f;
+			for (uint64_t i = 0; i < iterations; ++i)
+			{
+				root.set_translation({static_cast<float>(i & 1), 0.0f, 0.0f});
+				checksum += leaf.get_transform().get_world_matrix()[3][0];
+			}
+			return static_cast<uint64_t>(checksum);
+		});
+
+		runner.run("Transform/get_world_matrix/clean" + suffix, [depth](uint64_t iterations) {
+			std::vector<std::unique_ptr<vkb::sg::Node>> nodes;
+			auto &                                      leaf = build_chain(nodes, depth);
+
+			float checksum = 0.0f;
+			for (uint64_t i = 0; i < iterations; ++i)
+			{
+				checksum += leaf.get_transform().get_world_matrix()[3][0];
+			}
+			return static_cast<uint64_t>(checksum);
+		});
+
+		// With the matrices kept by a transform system, which updates the chain in one pass
+		runner.run("Transform/get_world_matrix/system" + suffix, [depth](uint64_t iterations) {
+			std::vector<std::unique_ptr<vkb::sg::Node>> nodes;
+			auto &                                      leaf = build_chain(nodes, depth);
+
+			vkb::sg::TransformSystem system;
+			system.set_root_node(*nodes.front());
+
+			auto &root = nodes.front()->get_transform();
+
+			float checksum = 0.0f;
+			for (uint64_t i = 0; i < iterations; ++i)
+			{
+				root.set_translation({static_cast<float>(i & 1), 0.0f, 0.0f});
+				system.update();
+				checksum += leaf.get_transform().get_world_matrix()[3][0];
+			}
+			return static_cast<uint64_t>(checksum);
+		});
+	}
+}
+
+void run_device_benchmarks(Runner &runner, vkb::Device &device)
+{
+	auto &resource_cache = device.get_resource_cache();
+
+	auto &vertex_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, make_source(VERTEX_SHADER));
+	auto &fragment_module = resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, make_source(FRAGMENT_SHADER));
+	auto &compute_module  = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, make_source(COMPUTE_SHADER));
+
+	auto &graphics_layout = resource_cache.request_pipeline_layout({&vertex_module, &fragment_module}, false);
+	auto &compute_layout  = resource_cache.request_pipeline_layout({&compute_module}, false);
+
+	vkb::SubpassInfo subpass_info;
+	subpass_info.output_attachments = {0};
+
+	auto &render_pass = resource_cache.request_render_pass({vkb::Attachment{VK_FORMAT_R8G8B8A8_UNORM, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT}},
+	                                                       {vkb::LoadStoreInfo{}}, {subpass_info});
+
+	// The pipeline is compiled by the first request, the benchmark measures the lookups that follow
+	runner.run("ResourceCache/request_graphics_pipeline/hit", [&](uint64_t iterations) {
+		vkb::PipelineState pipeline_state;
+		pipeline_state.set_pipeline_layout(graphics_layout);
+		pipeline_state.set_render_pass(render_pass);
+
+		vkb::ColorBlendState color_blend_state;
+		color_blend_state.attachments.resize(1);
+		pipeline_state.set_color_blend_state(color_blend_state);
+
+		uint64_t checksum = 0;
+		for (uint64_t i = 0; i < iterations; ++i)
+		{
+			checksum += reinterpret_cast<uintptr_t>(resource_cache.request_graphics_pipeline(pipeline_state).get_handle());
+		}
+		return checksum;
+	});
+
+	vkb::RenderFrame render_frame{device};
+
+	// The buffer pools are reset as at the start of a frame, after as many allocations as a busy frame makes
+	const uint64_t allocations_per_frame = 4096;
+
+	runner.run("RenderFrame/allocate_buffer/256B", [&](uint64_t iterations) {
+		uint64_t checksum = 0;
+		for (uint64_t i = 0; i < iterations; ++i)
+		{
+			if (i % allocations_per_frame == 0)
+			{
+				render_frame.reset(false);
+			}
+
+			checksum += render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 256).get_offset();
+		}
+		return checksum;
+	});
+
+	runner.run("BufferAllocation/update/mat4", [&](uint64_t iterations) {
+		render_frame.reset(false);
+
+		auto allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(glm::mat4));
+
+		glm::mat4 matrix{1.0f};
+		for (uint64_t i = 0; i < iterations; ++i)
+		{
+			matrix[3][0] = static_cast<float>(i);
+			allocation.update(matrix);
+		}
+		return allocation.get_offset();
+	});
+
+	// The descriptor state is flushed by every dispatch, rebinding a uniform buffer at a different offset
+	// makes it look the descriptor set up again in the cache of the frame
+	runner.run("CommandBuffer/flush_descriptor_state/dispatch", [&](uint64_t iterations) {
+		render_frame.reset(false);
+
+		auto storage = render_frame.allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, sizeof(glm::vec4));
+
+		std::vector<vkb::BufferAllocation> uniforms;
+		for (size_t i = 0; i < 64; ++i)
+		{
+			uniforms.push_back(render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(glm::vec4)));
+		}
+
+		auto &queue = device.get_queue_by_flags(VK_QUEUE_COMPUTE_BIT, 0);
+
+		auto *command_buffer = &render_frame.request_command_buffer(queue);
+		command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+		command_buffer->bind_pipeline_layout(compute_layout);
+		command_buffer->bind_buffer(storage.get_buffer(), storage.get_offset(), storage.get_size(), 0, 1, 0);
+
+		for (uint64_t i = 0; i < iterations; ++i)
+		{
+			auto &uniform = uniforms[i % uniforms.size()];
+			command_buffer->bind_buffer(uniform.get_buffer(), uniform.get_offset(), uniform.get_size(), 0, 0, 0);
+			command_buffer->dispatch(1, 1, 1);
+		}
+
+		command_buffer->end();
+		return iterations;
+	});
+
+	vkb::RenderContext render_context{device, VK_NULL_HANDLE, 1920, 1080};
+
+	for (size_t node_count : {1000, 10000, 100000})
+	{
+		SyntheticScene synthetic_scene{node_count};
+
+		SortedNodesSubpass subpass{render_context, make_source(VERTEX_SHADER), make_source(FRAGMENT_SHADER), synthetic_scene.scene, *synthetic_scene.camera};
+
+		runner.run("GeometrySubpass/get_sorted_nodes/nodes:" + std::to_string(node_count), [&](uint64_t iterations) {
+			vkb::DrawList draw_list;
+
+			uint64_t checksum = 0;
+			for (uint64_t i = 0; i < iterations; ++i)
+			{
+				subpass.sort(draw_list);
+				checksum += draw_list.size();
+			}
+			return checksum;
+		});
+	}
+
+	render_frame.reset();
+}
+}        // namespace
+
+int main(int argc, char *argv[])
+{
+	Options options;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "--filter")
+		{
+			options.filter = argv[i + 1];
+		}
+		else if (arg == "--min-time")
+		{
+			options.min_time_ms = std::stod(argv[i + 1]);
+		}
+		else if (arg == "--out")
+		{
+			options.out = argv[i + 1];
+		}
+		else
+		{
+			std::cerr << "Unknown argument " << arg << std::endl;
+			return 1;
+		}
+	}
+
+	Runner runner{options};
+
+	run_host_benchmarks(runner);
+
+	std::string device_name = "none";
+
+	try
+	{
+		vkb::Instance instance{"framework_benchmark", {}, {}, true};
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(instance.get_gpu(), &properties);
+		device_name = properties.deviceName;
+
+		vkb::Device device{instance.get_gpu(), VK_NULL_HANDLE};
+
+		run_device_benchmarks(runner, device);
+
+		device.wait_idle();
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << "Skipping the device benchmarks: " << e.what() << std::endl;
+	}
+
+	if (options.out.empty())
+	{
+		runner.write(std::cout, device_name);
+	}
+	else
+	{
+		std::ofstream file{options.out};
+		runner.write(file, device_name);
+	}
+
+	return 0;
+}
@@ -0,0 +1,174 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "common/resource_caching.h"
+#include "timer.h"
+
+/**
+ * @brief Compares the hashing of the resource cache keys with the field by field hash_combine scheme
+ *        it replaced, for speed and for collisions among distinct keys
+ *
+ * Usage: hash_benchmark [key count]
+ */
+namespace
+{
+/// Field by field hashing, as resource_caching.h did before hashing in bulk
+struct LegacyHash
+{
+	std::size_t operator()(const VkVertexInputAttributeDescription &vertex_attrib) const
+	{
+		std::size_t result = 0;
+
+		vkb::hash_combine(result, vertex_attrib.binding);
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkFormat>::type>(vertex_attrib.format));
+		vkb::hash_combine(result, vertex_attrib.location);
+		vkb::hash_combine(result, vertex_attrib.offset);
+
+		return result;
+	}
+
+	std::size_t operator()(const vkb::ColorBlendAttachmentState &color_blend_attachment) const
+	{
+		std::size_t result = 0;
+
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkBlendOp>::type>(color_blend_attachment.alpha_blend_op));
+		vkb::hash_combine(result, color_blend_attachment.blend_enable);
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkBlendOp>::type>(color_blend_attachment.color_blend_op));
+		vkb::hash_combine(result, color_blend_attachment.color_write_mask);
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkBlendFactor>::type>(color_blend_attachment.dst_alpha_blend_factor));
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkBlendFactor>::type>(color_blend_attachment.dst_color_blend_factor));
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkBlendFactor>::type>(color_blend_attachment.src_alpha_blend_factor));
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkBlendFactor>::type>(color_blend_attachment.src_color_blend_factor));
+
+		return result;
+	}
+
+	std::size_t operator()(const vkb::StencilOpState &stencil) const
+	{
+		std::size_t result = 0;
+
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkCompareOp>::type>(stencil.compare_op));
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkStencilOp>::type>(stencil.depth_fail_op));
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkStencilOp>::type>(stencil.fail_op));
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkStencilOp>::type>(stencil.pass_op));
+
+		return result;
+	}
+
+	std::size_t operator()(const VkDescriptorBufferInfo &descriptor_buffer_info) const
+	{
+		std::size_t result = 0;
+
+		vkb::hash_combine(result, descriptor_buffer_info.buffer);
+		vkb::hash_combine(result, descriptor_buffer_info.range);
+		vkb::hash_combine(result, descriptor_buffer_info.offset);
+
+		return result;
+	}
+};
+
+template <class T>
+void run(const std::string &name, const std::vector<T> &keys, size_t distinct_keys)
+{
+	const size_t repeats = 16;
+
+	auto measure = [&](const char *scheme, auto hasher) {
+		vkb::Timer timer;
+		timer.start();
+
+		// Accumulated so that the hashing isn't optimized away
+		std::size_t checksum = 0;
+		for (size_t repeat = 0; repeat < repeats; ++repeat)
+		{
+			for (auto &key : keys)
+			{
+				checksum += hasher(key);
+			}
+		}
+
+		double nanoseconds = timer.stop<vkb::Timer::Nanoseconds>() / (repeats * keys.size());
+
+		std::unordered_set<std::size_t> hashes;
+		for (auto &key : keys)
+		{
+			hashes.insert(hasher(key));
+		}
+
+		std::cout << name << " " << scheme << ": " << nanoseconds << " ns per hash, "
+		          << distinct_keys - hashes.size() << " collisions in " << distinct_keys << " keys (checksum " << checksum << ")" << std::endl;
+	};
+
+	measure("hash_combine", LegacyHash{});
+	measure("Hasher", std::hash<T>{});
+}
+}        // namespace
+
+int main(int argc, char *argv[])
+{
+	size_t key_count = argc > 1 ? std::stoul(argv[1]) : 1 << 20;
+
+	// Keys are generated from consecutive indices, which are distinct and
+	// close to each other like the values of real states
+	std::vector<VkVertexInputAttributeDescription> attributes(key_count);
+	std::vector<vkb::ColorBlendAttachmentState>    blend_attachments(key_count);
+	std::vector<vkb::StencilOpState>               stencil_states(key_count);
+	std::vector<VkDescriptorBufferInfo>            buffer_infos(key_count);
+
+	std::mt19937_64 random_engine;
+
+	for (size_t i = 0; i < key_count; ++i)
+	{
+		uint32_t index = static_cast<uint32_t>(i);
+
+		attributes[i].location = index & 0xF;
+		attributes[i].binding  = (index >> 4) & 0xF;
+		attributes[i].format   = static_cast<VkFormat>((index >> 8) & 0x7F);
+		attributes[i].offset   = (index >> 15) * 4;
+
+		blend_attachments[i].blend_enable           = index & 1;
+		blend_attachments[i].src_color_blend_factor = static_cast<VkBlendFactor>((index >> 1) & 0xF);
+		blend_attachments[i].dst_color_blend_factor = static_cast<VkBlendFactor>((index >> 5) & 0xF);
+		blend_attachments[i].src_alpha_blend_factor = static_cast<VkBlendFactor>((index >> 9) & 0xF);
+		blend_attachments[i].dst_alpha_blend_factor = static_cast<VkBlendFactor>((index >> 13) & 0xF);
+		blend_attachments[i].color_write_mask       = index >> 17;
+
+		stencil_states[i].fail_op       = static_cast<VkStencilOp>(index & 0xFF);
+		stencil_states[i].pass_op       = static_cast<VkStencilOp>((index >> 8) & 0xFF);
+		stencil_states[i].depth_fail_op = static_cast<VkStencilOp>((index >> 16) & 0xFF);
+		stencil_states[i].compare_op    = static_cast<VkCompareOp>(index >> 24);
+
+		// Buffers are a few handles with many aligned offsets
+		buffer_infos[i].buffer = reinterpret_cast<VkBuffer>(static_cast<uintptr_t>(0x1000 + (random_engine() % 8) * 0x100));
+		buffer_infos[i].offset = i * 256;
+		buffer_infos[i].range  = 256;
+	}
+
+	run("VkVertexInputAttributeDescription", attributes, key_count);
+	run("ColorBlendAttachmentState", blend_attachments, key_count);
+	run("StencilOpState", stencil_states, key_count);
+	run("VkDescriptorBufferInfo", buffer_infos, key_count);
+
+	return 0;
+}
@@ -0,0 +1,384 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include <json.hpp>
+#include <spirv_glsl.hpp>
+VKBP_ENABLE_WARNINGS()
+
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "glsl_compiler.h"
+#include "job_system.h"
+#include "platform/filesystem.h"
+#include "platform/platform.h"
+
+/**
+ * @brief Compiles the shader variants listed in a manifest to the SPIRV files read by GLSLCompiler
+ *
+ * Usage: shader_precompiler <root directory> <manifest>
+ *
+ * The shaders are read from the shaders folder of the root directory, and the SPIRV is written
+ * to its spirv folder, which is packaged with the shaders. Variants already compiled are skipped.
+ * The manifest lists the shaders with the defines their variants use:
+ * {
+ *     "shaders": [
+ *         {
+ *             "file": "base.frag",
+ *             "defines": ["MAX_FORWARD_LIGHT_COUNT 16"],
+ *             "optional_defines": ["HAS_BASE_COLOR_TEXTURE", "HAS_NORMAL_TEXTURE"]
+ *         }
+ *     ]
+ * }
+ * A variant is compiled for every combination of the optional defines, each with all the defines.
+ * The variants of all the shaders are compiled in parallel.
+ *
+ * The manifest can also list the variants whose layout the C++ code relies on, written to a header:
+ *     "layout_header": {
+ *         "file": "framework/rendering/subpasses/shader_layout.h",
+ *         "shaders": [{"file": "base.vert", "defines": ["HAS_POSITION"]}]
+ *     }
+ * The header holds constexpr sets, bindings and vertex input locations named after the resources,
+ * and the sizes and member offsets of the uniform and push constant blocks, so that static_asserts
+ * catch the C++ structures which no longer match the shaders at compile time. A name given
+ * different values by two of the variants fails the precompilation.
+ */
+namespace
+{
+bool get_shader_stage(const std::string &filename, VkShaderStageFlagBits &stage)
+{
+	static const std::vector<std::pair<std::string, VkShaderStageFlagBits>> extensions = {
+	    {".vert", VK_SHADER_STAGE_VERTEX_BIT},
+	    {".tesc", VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT},
+	    {".tese", VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT},
+	    {".geom", VK_SHADER_STAGE_GEOMETRY_BIT},
+	    {".frag", VK_SHADER_STAGE_FRAGMENT_BIT},
+	    {".comp", VK_SHADER_STAGE_COMPUTE_BIT}};
+
+	for (auto &extension : extensions)
+	{
+		if (filename.size() > extension.first.size() &&
+		    filename.compare(filename.size() - extension.first.size(), extension.first.size(), extension.first) == 0)
+		{
+			stage = extension.second;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief Adds a compile task for each variant of a shader
+ * @param shader The manifest entry of the shader
+ * @param sources Holds the sources of the shaders, read by the tasks
+ * @param tasks The compile tasks
+ * @return False if the shader cannot be compiled
+ */
+bool add_shader_tasks(const nlohmann::json &shader, std::deque<std::vector<uint8_t>> &sources, std::vector<vkb::GLSLCompiler::CompileTask> &tasks)
+{
+	auto filename = shader.at("file").get<std::string>();
+
+	VkShaderStageFlagBits stage;
+	if (!get_shader_stage(filename, stage))
+	{
+		LOGE("Unknown shader stage for {}", filename);
+		return false;
+	}
+
+	sources.push_back(vkb::fs::read_shader(filename));
+
+	std::vector<std::string> defines;
+	if (shader.count("defines") > 0)
+	{
+		defines = shader.at("defines").get<std::vector<std::string>>();
+	}
+
+	std::vector<std::string> optional_defines;
+	if (shader.count("optional_defines") > 0)
+	{
+		optional_defines = shader.at("optional_defines").get<std::vector<std::string>>();
+	}
+
+	if (optional_defines.size() >= 16)
+	{
+		LOGE("Too many optional defines for {}", filename);
+		return false;
+	}
+
+	// Each bit of the mask selects an optional define
+	for (uint32_t mask = 0; mask < (1U << optional_defines.size()); mask++)
+	{
+		vkb::GLSLCompiler::CompileTask task;
+		task.stage       = stage;
+		task.glsl_source = &sources.back();
+
+		for (auto &define : defines)
+		{
+			task.shader_variant.add_define(define);
+		}
+
+		for (size_t i = 0; i < optional_defines.size(); i++)
+		{
+			if (mask & (1U << i))
+			{
+				task.shader_variant.add_define(optional_defines[i]);
+			}
+		}
+
+		tasks.push_back(std::move(task));
+	}
+
+	LOGI("Compiling {} variants of {}", 1U << optional_defines.size(), filename);
+
+	return true;
+}
+
+/**
+ * @brief Layout of the resources of the shader variants listed for the layout header
+ */
+struct LayoutConstants
+{
+	/// Sets, bindings and vertex input locations, by name
+	std::map<std::string, uint32_t> resources;
+
+	/// Sizes and member offsets of the uniform and push constant blocks, by block and by name
+	std::map<std::string, std::map<std::string, uint32_t>> blocks;
+};
+
+bool add_constant(std::map<std::string, uint32_t> &constants, const std::string &name, uint32_t value)
+{
+	auto result = constants.emplace(name, value);
+
+	if (!result.second && result.first->second != value)
+	{
+		LOGE("Shader layout constant {} is {} in a variant and {} in another", name, result.first->second, value);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Adds the layout of the resources of a compiled variant to the constants
+ * @return False if a constant has another value in a previous variant
+ */
+bool reflect_layout(const vkb::GLSLCompiler::CompileTask &task, LayoutConstants &constants)
+{
+	spirv_cross::Compiler compiler{task.spirv};
+
+	auto resources = compiler.get_shader_resources();
+
+	bool success = true;
+
+	// The outputs of a stage are matched by location with the inputs of the next, only the vertex inputs are set by the C++ code
+	if (task.stage == VK_SHADER_STAGE_VERTEX_BIT)
+	{
+		for (auto &input : resources.stage_inputs)
+		{
+			success = add_constant(constants.resources, input.name + "_location", compiler.get_decoration(input.id, spv::DecorationLocation)) && success;
+		}
+	}
+
+	for (auto list : {&resources.uniform_buffers, &resources.storage_buffers, &resources.sampled_images, &resources.separate_images,
+	                  &resources.separate_samplers, &resources.storage_images, &resources.subpass_inputs})
+	{
+		for (auto &resource : *list)
+		{
+			success = add_constant(constants.resources, resource.name + "_set", compiler.get_decoration(resource.id, spv::DecorationDescriptorSet)) && success;
+			success = add_constant(constants.resources, resource.name + "_binding", compiler.get_decoration(resource.id, spv::DecorationBinding)) && success;
+		}
+	}
+
+	for (auto list : {&resources.uniform_buffers, &resources.push_constant_buffers})
+	{
+		for (auto &resource : *list)
+		{
+			auto &type  = compiler.get_type(resource.base_type_id);
+			auto &block = constants.blocks[resource.name];
+
+			success = add_constant(block, "size", vkb::to_u32(compiler.get_declared_struct_size(type))) && success;
+
+			for (uint32_t i = 0; i < vkb::to_u32(type.member_types.size()); i++)
+			{
+				success = add_constant(block, compiler.get_member_name(type.self, i) + "_offset", compiler.type_struct_member_offset(type, i)) && success;
+			}
+		}
+	}
+
+	return success;
+}
+
+bool write_layout_header(const std::string &path, const LayoutConstants &constants)
+{
+	std::ofstream header{path};
+
+	header << "/* Generated by shader_precompiler from the layout_header of shaders/precompile.json, do not edit */\n"
+	       << "\n"
+	       << "#pragma once\n"
+	       << "\n"
+	       << "#include <cstdint>\n"
+	       << "\n"
+	       << "namespace vkb\n"
+	       << "{\n"
+	       << "namespace shader_layout\n"
+	       << "{\n";
+
+	for (auto &constant : constants.resources)
+	{
+		header << "constexpr uint32_t " << constant.first << " = " << constant.second << ";\n";
+	}
+
+	for (auto &block : constants.blocks)
+	{
+		header << "\n"
+		       << "namespace " << block.first << "\n"
+		       << "{\n";
+
+		for (auto &constant : block.second)
+		{
+			header << "constexpr uint32_t " << constant.first << " = " << constant.second << ";\n";
+		}
+
+		header << "}        // namespace " << block.first << "\n";
+	}
+
+	header << "}        // namespace shader_layout\n"
+	       << "}        // namespace vkb\n";
+
+	return header.good();
+}
+}        // namespace
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3)
+	{
+		std::cerr << "Usage: shader_precompiler <root directory> <manifest>" << std::endl;
+		return 1;
+	}
+
+	std::string root = std::string{argv[1]} + "/";
+
+	// The compiler writes its SPIRV cache to the temporary directory, which is pointed at the precompiled folder
+	vkb::Platform::set_external_storage_directory(root);
+	vkb::Platform::set_temp_directory(root + "shaders/spirv/");
+	vkb::fs::create_path(root, "shaders/spirv/");
+
+	nlohmann::json manifest;
+
+	try
+	{
+		std::ifstream manifest_file{argv[2]};
+		manifest_file >> manifest;
+	}
+	catch (std::exception &e)
+	{
+		LOGE("Failed to read manifest {}: {}", argv[2], e.what());
+		return 1;
+	}
+
+	size_t failure_count = 0;
+
+	try
+	{
+		std::deque<std::vector<uint8_t>>            sources;
+		std::vector<vkb::GLSLCompiler::CompileTask> tasks;
+		std::vector<std::string>                    filenames;
+
+		for (auto &shader : manifest.at("shaders"))
+		{
+			if (!add_shader_tasks(shader, sources, tasks))
+			{
+				failure_count++;
+			}
+
+			filenames.resize(tasks.size(), shader.at("file").get<std::string>());
+		}
+
+		// The variants of the layout header are compiled last, each entry has a single variant as it lists no optional defines
+		size_t layout_task_begin = tasks.size();
+
+		if (manifest.count("layout_header") > 0)
+		{
+			for (auto &shader : manifest.at("layout_header").at("shaders"))
+			{
+				if (shader.count("optional_defines") > 0 || !add_shader_tasks(shader, sources, tasks))
+				{
+					LOGE("Invalid layout header shader {}", shader.at("file").get<std::string>());
+					failure_count++;
+				}
+
+				filenames.resize(tasks.size(), shader.at("file").get<std::string>());
+			}
+		}
+
+		vkb::JobSystem    job_system;
+		vkb::GLSLCompiler glsl_compiler;
+
+		failure_count += glsl_compiler.compile_to_spirv(tasks, job_system, vkb::JobPriority::Frame);
+
+		for (size_t i = 0; i < tasks.size(); i++)
+		{
+			if (!tasks[i].success)
+			{
+				LOGE("Compilation failed for shader \"{}\" with preamble:\n{}{}", filenames[i], tasks[i].shader_variant.get_preamble(), tasks[i].info_log);
+			}
+		}
+
+		if (manifest.count("layout_header") > 0 && failure_count == 0)
+		{
+			LayoutConstants constants;
+
+			for (size_t i = layout_task_begin; i < tasks.size(); i++)
+			{
+				if (!reflect_layout(tasks[i], constants))
+				{
+					LOGE("Conflicting layout in shader \"{}\"", filenames[i]);
+					failure_count++;
+				}
+			}
+
+			auto header_file = manifest.at("layout_header").at("file").get<std::string>();
+
+			if (failure_count == 0 && !write_layout_header(root + header_file, constants))
+			{
+				LOGE("Failed to write the shader layout header {}", header_file);
+				failure_count++;
+			}
+		}
+	}
+	catch (std::exception &e)
+	{
+		LOGE("Shader precompilation failed: {}", e.what());
+		return 1;
+	}
+
+	return failure_count == 0 ? 0 : 1;
+}
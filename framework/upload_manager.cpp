@@ -0,0 +1,599 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "upload_manager.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#include "common/error.h"
+#include "common/logging.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "core/queue.h"
+#include "scene_graph/components/image.h"
+#include "timer.h"
+
+namespace vkb
+{
+namespace
+{
+/// Alignment of image data in the ring, a multiple of the texel block size of the supported formats
+constexpr VkDeviceSize IMAGE_ALIGNMENT = 16;
+
+/// Alignment of buffer data in the ring
+constexpr VkDeviceSize BUFFER_ALIGNMENT = 4;
+}        // namespace
+
+constexpr VkDeviceSize UploadManager::DEFAULT_STAGING_SIZE;
+
+UploadManager::UploadManager(Device &device, VkDeviceSize staging_size) :
+    device{device}
+{
+	graphics_queue_family = device.get_queue_by_role(QueueRole::Graphics).get_family_index();
+
+	// A transfer only family, otherwise a low priority queue of the graphics family, so uploads do not delay the frames
+	queue = &device.get_queue_by_role(QueueRole::Transfer);
+
+	LOGI("Uploading through {} queue family {}", has_dedicated_queue() ? "transfer" : "graphics", queue->get_family_index());
+
+	// The ring lives as long as the manager, so it gets memory of its own instead of pinning a shared block
+	AllocationHints hints{};
+	hints.dedicated = true;
+
+	staging_buffer = std::make_unique<core::Buffer>(device, staging_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, 0, hints);
+
+	// The ring stays mapped for the lifetime of the manager
+	staging_data = staging_buffer->map();
+}
+
+UploadManager::~UploadManager()
+{
+	// Recorded but not submitted uploads are dropped
+	if (recording_batch)
+	{
+		free_batches.push_back(std::move(recording_batch));
+	}
+
+	while (!submitted_batches.empty())
+	{
+		VK_CHECK(vkWaitForFences(device.get_handle(), 1, &submitted_batches.front()->fence, VK_TRUE, UINT64_MAX));
+		retire_oldest_batch();
+	}
+
+	for (auto &batch : free_batches)
+	{
+		vkDestroyFence(device.get_handle(), batch->fence, nullptr);
+	}
+
+	staging_buffer->unmap();
+}
+
+bool UploadManager::has_dedicated_queue() const
+{
+	return queue->get_family_index() != graphics_queue_family;
+}
+
+const Queue &UploadManager::get_queue() const
+{
+	return *queue;
+}
+
+void UploadManager::upload(core::Buffer &buffer, VkDeviceSize offset, const uint8_t *data, VkDeviceSize size,
+                           VkPipelineStageFlags dst_stage_mask, VkAccessFlags dst_access_mask)
+{
+	// Data bigger than the ring is streamed in chunks, possibly across several batches
+	const VkDeviceSize chunk_size = staging_buffer->get_size();
+
+	for (VkDeviceSize chunk_offset = 0; chunk_offset < size; chunk_offset += chunk_size)
+	{
+		VkBufferCopy region{};
+		region.size      = std::min(chunk_size, size - chunk_offset);
+		region.srcOffset = allocate_staging(region.size, BUFFER_ALIGNMENT);
+		region.dstOffset = offset + chunk_offset;
+
+		std::memcpy(staging_data + region.srcOffset, data + chunk_offset, static_cast<size_t>(region.size));
+
+		auto &batch = get_recording_batch();
+
+		batch.command_buffer->insert_debug_label("Buffer upload");
+
+		batch.command_buffer->copy_buffer(*staging_buffer, buffer, {region});
+
+		BufferMemoryBarrier barrier{};
+		barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dst_stage_mask  = dst_stage_mask;
+		barrier.dst_access_mask = dst_access_mask;
+
+		if (has_dedicated_queue())
+		{
+			// Release on the transfer queue, the acquire on the graphics queue makes the data visible
+			barrier.old_queue_family = queue->get_family_index();
+			barrier.new_queue_family = graphics_queue_family;
+
+			BufferMemoryBarrier release = barrier;
+			release.dst_stage_mask      = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+			release.dst_access_mask     = 0;
+
+			batch.command_buffer->buffer_memory_barrier(buffer, region.dstOffset, region.size, release);
+
+			barrier.src_stage_mask  = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			barrier.src_access_mask = 0;
+
+			batch.buffer_acquires.push_back({&buffer, region.dstOffset, region.size, barrier});
+		}
+		else
+		{
+			batch.command_buffer->buffer_memory_barrier(buffer, region.dstOffset, region.size, barrier);
+		}
+	}
+}
+
+void UploadManager::upload(sg::Image &image)
+{
+	uint32_t level_count = image.get_vk_image().get_subresource().mipLevel;
+
+	// Transfer only queues cannot blit, so the requested levels are generated on the CPU before staging
+	if (has_dedicated_queue() && level_count > image.get_mipmaps().size())
+	{
+		Timer timer;
+		timer.start();
+
+		image.generate_mipmaps();
+
+		statistics.mip_generation_time += timer.stop();
+	}
+
+	auto &image_view = image.get_vk_image_view();
+
+	stage_image(image, image_view);
+
+	bool blit_mipmaps = level_count > image.get_mipmaps().size();
+
+	if (blit_mipmaps)
+	{
+		// Leaves all the levels in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+		blit_mip_levels(*get_recording_batch().command_buffer, image, to_u32(image.get_mipmaps().size()), level_count);
+	}
+
+	release_image(image_view, blit_mipmaps);
+}
+
+void UploadManager::upload(const sg::Image &source, const core::ImageView &destination)
+{
+	assert(source.get_mipmaps().size() >= destination.get_subresource_range().levelCount && "Source image does not hold all the levels of the destination view");
+
+	stage_image(source, destination);
+
+	release_image(destination, false);
+}
+
+void UploadManager::stage_image(const sg::Image &source, const core::ImageView &destination)
+{
+	auto &data    = source.get_data();
+	auto &mipmaps = source.get_mipmaps();
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		memory_barrier.src_access_mask = 0;
+		memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_HOST_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		// Uploads are labelled with the name of the image from the scene
+		get_recording_batch().command_buffer->insert_debug_label(source.get_name());
+
+		get_recording_batch().command_buffer->image_memory_barrier(destination, memory_barrier);
+	}
+
+	const VkDeviceSize capacity = staging_buffer->get_size();
+
+	// Stream the mip levels one by one, so that only a single level needs to fit in the ring.
+	// Mip levels are stored in order in the image data.
+	for (size_t i = 0; i < mipmaps.size(); ++i)
+	{
+		auto &mipmap = mipmaps[i];
+
+		if (mipmap.level >= destination.get_subresource_range().levelCount)
+		{
+			break;
+		}
+
+		VkDeviceSize mipmap_end  = i + 1 < mipmaps.size() ? mipmaps[i + 1].offset : data.size();
+		VkDeviceSize mipmap_size = mipmap_end - mipmap.offset;
+
+		VkBufferImageCopy copy_region{};
+		copy_region.imageSubresource          = destination.get_subresource_layers();
+		copy_region.imageSubresource.mipLevel = destination.get_subresource_range().baseMipLevel + mipmap.level;
+		copy_region.imageExtent               = mipmap.extent;
+
+		if (mipmap_size <= capacity)
+		{
+			copy_region.bufferOffset = allocate_staging(mipmap_size, IMAGE_ALIGNMENT);
+
+			std::memcpy(staging_data + copy_region.bufferOffset, data.data() + mipmap.offset, static_cast<size_t>(mipmap_size));
+
+			get_recording_batch().command_buffer->copy_buffer_to_image(*staging_buffer, destination.get_image(), {copy_region});
+
+			continue;
+		}
+
+		// Size of a row of texels, zero for compressed formats which cannot be split by rows here
+		auto         bits_per_pixel = get_bits_per_pixel(source.get_format());
+		VkDeviceSize row_size       = bits_per_pixel > 0 ? VkDeviceSize{mipmap.extent.width} * to_u32(bits_per_pixel) / 8 : 0;
+
+		if (row_size > 0 && row_size <= capacity && mipmap.extent.depth == 1)
+		{
+			// Split the level in bands of rows
+			uint32_t band = to_u32(capacity / row_size);
+
+			for (uint32_t row = 0; row < mipmap.extent.height; row += band)
+			{
+				uint32_t row_count = std::min(band, mipmap.extent.height - row);
+
+				copy_region.bufferOffset       = allocate_staging(row_count * row_size, IMAGE_ALIGNMENT);
+				copy_region.imageOffset.y      = static_cast<int32_t>(row);
+				copy_region.imageExtent.height = row_count;
+
+				std::memcpy(staging_data + copy_region.bufferOffset, data.data() + mipmap.offset + row * row_size, static_cast<size_t>(row_count * row_size));
+
+				get_recording_batch().command_buffer->copy_buffer_to_image(*staging_buffer, destination.get_image(), {copy_region});
+			}
+
+			continue;
+		}
+
+		// Stage the level separately
+		LOGW("Mip level {} of image {} does not fit in the staging ring, using a dedicated staging buffer", mipmap.level, source.get_name());
+
+		auto dedicated_buffer = std::make_unique<core::Buffer>(device, mipmap_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+		dedicated_buffer->update(data.data() + mipmap.offset, static_cast<size_t>(mipmap_size));
+
+		auto &batch = get_recording_batch();
+
+		batch.command_buffer->copy_buffer_to_image(*dedicated_buffer, destination.get_image(), {copy_region});
+
+		dedicated_staging_size += dedicated_buffer->get_size();
+		update_peak_staging_usage();
+
+		batch.dedicated_buffers.push_back(std::move(dedicated_buffer));
+	}
+}
+
+void UploadManager::release_image(const core::ImageView &destination, bool blitted)
+{
+	auto &batch = get_recording_batch();
+
+	ImageMemoryBarrier memory_barrier{};
+	memory_barrier.old_layout      = blitted ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	memory_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+	memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+	if (has_dedicated_queue())
+	{
+		// Both halves of an ownership transfer must perform the same layout transition
+		memory_barrier.old_queue_family = queue->get_family_index();
+		memory_barrier.new_queue_family = graphics_queue_family;
+
+		ImageMemoryBarrier release = memory_barrier;
+		release.dst_stage_mask     = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+		release.dst_access_mask    = 0;
+
+		batch.command_buffer->image_memory_barrier(destination, release);
+
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		memory_barrier.src_access_mask = 0;
+
+		batch.image_acquires.push_back({&destination, memory_barrier});
+	}
+	else
+	{
+		batch.command_buffer->image_memory_barrier(destination, memory_barrier);
+	}
+}
+
+void UploadManager::blit_mip_levels(CommandBuffer &command_buffer, const sg::Image &image, uint32_t first_level, uint32_t level_count)
+{
+	auto &vk_image    = image.get_vk_image();
+	auto  subresource = image.get_vk_image_view().get_subresource_range();
+	auto  extent      = image.get_extent();
+
+	auto get_level_offset = [&extent](uint32_t level) {
+		return VkOffset3D{static_cast<int32_t>(std::max(1u, extent.width >> level)),
+		                  static_cast<int32_t>(std::max(1u, extent.height >> level)),
+		                  1};
+	};
+
+	// Turns the last written level into the source of the next blit
+	ImageMemoryBarrier memory_barrier{};
+	memory_barrier.old_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	memory_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_READ_BIT;
+	memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+	subresource.levelCount = 1;
+
+	for (uint32_t level = first_level; level < level_count; ++level)
+	{
+		subresource.baseMipLevel = level - 1;
+		command_buffer.image_memory_barrier(vk_image, subresource, memory_barrier);
+
+		VkImageBlit blit{};
+		blit.srcSubresource          = image.get_vk_image_view().get_subresource_layers();
+		blit.srcSubresource.mipLevel = level - 1;
+		blit.srcOffsets[1]           = get_level_offset(level - 1);
+		blit.dstSubresource          = blit.srcSubresource;
+		blit.dstSubresource.mipLevel = level;
+		blit.dstOffsets[1]           = get_level_offset(level);
+
+		command_buffer.blit_image(vk_image, vk_image, {blit}, VK_FILTER_LINEAR);
+	}
+
+	subresource.baseMipLevel = level_count - 1;
+	command_buffer.image_memory_barrier(vk_image, subresource, memory_barrier);
+}
+
+uint64_t UploadManager::submit()
+{
+	if (!recording_batch)
+	{
+		// Nothing recorded, the last submitted batch covers all the uploads
+		return next_batch_id - 1;
+	}
+
+	auto &batch = *recording_batch;
+
+	staging_buffer->flush();
+
+	batch.command_buffer->end();
+
+	batch.ring_end = ring_head;
+
+	VkResult result = queue->submit(*batch.command_buffer, batch.fence);
+
+	if (result != VK_SUCCESS)
+	{
+		throw VulkanException{result, "Failed to submit uploads"};
+	}
+
+	auto batch_id = batch.id;
+
+	submitted_batches.push_back(std::move(recording_batch));
+
+	return batch_id;
+}
+
+bool UploadManager::is_complete(uint64_t batch_id)
+{
+	poll();
+
+	return batch_id <= completed_batch_id;
+}
+
+void UploadManager::wait(uint64_t batch_id)
+{
+	if (recording_batch && recording_batch->id <= batch_id)
+	{
+		submit();
+	}
+
+	while (completed_batch_id < batch_id && !submitted_batches.empty())
+	{
+		wait_oldest_batch();
+	}
+}
+
+void UploadManager::acquire(CommandBuffer &command_buffer)
+{
+	poll();
+
+	for (auto &acquire : pending_buffer_acquires)
+	{
+		command_buffer.buffer_memory_barrier(*acquire.buffer, acquire.offset, acquire.size, acquire.barrier);
+	}
+
+	for (auto &acquire : pending_image_acquires)
+	{
+		command_buffer.image_memory_barrier(*acquire.image_view, acquire.barrier);
+	}
+
+	pending_buffer_acquires.clear();
+	pending_image_acquires.clear();
+}
+
+const UploadManager::Statistics &UploadManager::get_statistics() const
+{
+	return statistics;
+}
+
+void UploadManager::flush()
+{
+	wait(submit());
+
+	if (pending_buffer_acquires.empty() && pending_image_acquires.empty())
+	{
+		return;
+	}
+
+	auto &command_buffer = device.request_command_buffer();
+
+	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+	acquire(command_buffer);
+
+	command_buffer.end();
+
+	auto &graphics_queue = device.get_queue_by_role(QueueRole::Graphics);
+
+	graphics_queue.submit(command_buffer, device.request_fence());
+
+	Timer timer;
+	timer.start();
+
+	device.get_fence_pool().wait();
+
+	statistics.fence_wait_time += timer.stop();
+
+	device.get_fence_pool().reset();
+	device.get_command_pool().reset_pool();
+}
+
+UploadManager::Batch &UploadManager::get_recording_batch()
+{
+	if (recording_batch)
+	{
+		return *recording_batch;
+	}
+
+	if (!free_batches.empty())
+	{
+		recording_batch = std::move(free_batches.back());
+		free_batches.pop_back();
+	}
+	else
+	{
+		recording_batch = std::make_unique<Batch>();
+
+		recording_batch->command_pool = std::make_unique<CommandPool>(device, queue->get_family_index());
+
+		VkFenceCreateInfo create_info{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+
+		VkResult result = vkCreateFence(device.get_handle(), &create_info, nullptr, &recording_batch->fence);
+
+		if (result != VK_SUCCESS)
+		{
+			throw VulkanException{result, "Failed to create upload fence"};
+		}
+	}
+
+	recording_batch->id             = next_batch_id++;
+	recording_batch->command_buffer = &recording_batch->command_pool->request_command_buffer();
+	recording_batch->command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+	return *recording_batch;
+}
+
+VkDeviceSize UploadManager::allocate_staging(VkDeviceSize size, VkDeviceSize alignment)
+{
+	const VkDeviceSize capacity = staging_buffer->get_size();
+
+	assert(size <= capacity && "Allocation is bigger than the staging ring");
+
+	while (true)
+	{
+		if (ring_head == ring_tail)
+		{
+			// The ring is empty, restart from the beginning of the buffer
+			ring_head = ring_tail = (ring_head + capacity - 1) / capacity * capacity;
+		}
+
+		uint64_t position = (ring_head + alignment - 1) / alignment * alignment;
+
+		// Allocations are contiguous, skip the end of the buffer if it is too small
+		if (position % capacity + size > capacity)
+		{
+			position = (position / capacity + 1) * capacity;
+		}
+
+		if (position + size - ring_tail <= capacity)
+		{
+			ring_head = position + size;
+
+			update_peak_staging_usage();
+
+			return position % capacity;
+		}
+
+		if (!submitted_batches.empty())
+		{
+			// Free the space used by the oldest batch
+			wait_oldest_batch();
+		}
+		else
+		{
+			// The batch being recorded uses the whole ring
+			submit();
+		}
+	}
+}
+
+void UploadManager::retire_oldest_batch()
+{
+	auto batch = std::move(submitted_batches.front());
+	submitted_batches.pop_front();
+
+	ring_tail          = batch->ring_end;
+	completed_batch_id = batch->id;
+
+	std::move(batch->buffer_acquires.begin(), batch->buffer_acquires.end(), std::back_inserter(pending_buffer_acquires));
+	std::move(batch->image_acquires.begin(), batch->image_acquires.end(), std::back_inserter(pending_image_acquires));
+
+	batch->buffer_acquires.clear();
+	batch->image_acquires.clear();
+
+	for (auto &dedicated_buffer : batch->dedicated_buffers)
+	{
+		dedicated_staging_size -= dedicated_buffer->get_size();
+	}
+
+	batch->dedicated_buffers.clear();
+
+	VK_CHECK(vkResetFences(device.get_handle(), 1, &batch->fence));
+	VK_CHECK(batch->command_pool->reset_pool());
+
+	batch->command_buffer = nullptr;
+
+	free_batches.push_back(std::move(batch));
+}
+
+void UploadManager::wait_oldest_batch()
+{
+	Timer timer;
+	timer.start();
+
+	VK_CHECK(vkWaitForFences(device.get_handle(), 1, &submitted_batches.front()->fence, VK_TRUE, UINT64_MAX));
+
+	statistics.fence_wait_time += timer.stop();
+
+	retire_oldest_batch();
+}
+
+void UploadManager::update_peak_staging_usage()
+{
+	statistics.peak_staging_usage = std::max(statistics.peak_staging_usage, ring_head - ring_tail + dedicated_staging_size);
+}
+
+void UploadManager::poll()
+{
+	while (!submitted_batches.empty() && vkGetFenceStatus(device.get_handle(), submitted_batches.front()->fence) == VK_SUCCESS)
+	{
+		retire_oldest_batch();
+	}
+}
+}        // namespace vkb
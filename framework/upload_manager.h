@@ -0,0 +1,293 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/buffer.h"
+#include "core/command_pool.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+class Queue;
+
+namespace core
+{
+class ImageView;
+}
+
+namespace sg
+{
+class Image;
+}
+
+/**
+ * @brief Uploads buffer and image data to device local memory without stalling rendering
+ *
+ * Data is written to a persistently mapped staging ring and copied on a transfer only
+ * queue if the device has one, otherwise on a low priority queue of the graphics family,
+ * and on the graphics queue itself as a last resort. Uploads are recorded in
+ * batches, each guarded by a fence, and the space of the ring is reused once the batch
+ * using it has completed.
+ *
+ * With a dedicated transfer queue the ownership of the resources is released at the end
+ * of each batch, and must be acquired on the graphics queue with acquire() before they
+ * can be used there.
+ */
+class UploadManager
+{
+  public:
+	/**
+	 * @brief Creates the staging ring and selects the upload queue
+	 * @param device Device to upload the data to
+	 * @param staging_size Size in bytes of the staging ring
+	 */
+	UploadManager(Device &device, VkDeviceSize staging_size = DEFAULT_STAGING_SIZE);
+
+	UploadManager(const UploadManager &) = delete;
+
+	UploadManager(UploadManager &&) = delete;
+
+	~UploadManager();
+
+	UploadManager &operator=(const UploadManager &) = delete;
+
+	UploadManager &operator=(UploadManager &&) = delete;
+
+	/**
+	 * @return True if uploads run on a transfer only queue family
+	 */
+	bool has_dedicated_queue() const;
+
+	const Queue &get_queue() const;
+
+	/**
+	 * @brief Records the upload of data into a buffer
+	 * @param buffer Destination buffer, created with VK_BUFFER_USAGE_TRANSFER_DST_BIT
+	 * @param offset Offset in bytes in the destination buffer
+	 * @param data Data to upload, copied to the staging ring before returning
+	 * @param size Size in bytes of the data
+	 * @param dst_stage_mask Pipeline stages reading the buffer after the upload
+	 * @param dst_access_mask Accesses of the buffer after the upload
+	 */
+	void upload(core::Buffer &buffer, VkDeviceSize offset, const uint8_t *data, VkDeviceSize size,
+	            VkPipelineStageFlags dst_stage_mask, VkAccessFlags dst_access_mask);
+
+	/**
+	 * @brief Records the upload of all the mip levels of an image
+	 *        The levels are streamed through the ring one at a time, and split in bands of rows
+	 *        if they do not fit. The image ends in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL for fragment shaders
+	 *        Levels requested with sg::Image::request_gpu_mipmaps() are blitted from the first one,
+	 *        or generated on the CPU when uploading on a transfer only queue which cannot blit
+	 * @param image Image whose data is uploaded, the data is copied before returning
+	 */
+	void upload(sg::Image &image);
+
+	/**
+	 * @brief Records the upload of the mip levels of an image to a range of levels of another one,
+	 *        e.g. to fill the levels committed to a partially resident image
+	 *        The destination levels end in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL for fragment shaders
+	 * @param source Image whose levels are uploaded from its first one, the data is copied before returning
+	 * @param destination View of the levels to fill, which must be kept alive until acquired
+	 */
+	void upload(const sg::Image &source, const core::ImageView &destination);
+
+	/**
+	 * @brief Submits the uploads recorded since the last submit
+	 * @return Identifier of the submitted batch
+	 */
+	uint64_t submit();
+
+	/**
+	 * @brief Checks without blocking whether a batch has finished executing
+	 * @param batch_id Identifier returned by submit()
+	 */
+	bool is_complete(uint64_t batch_id);
+
+	/**
+	 * @brief Blocks until a batch has finished executing
+	 * @param batch_id Identifier returned by submit()
+	 */
+	void wait(uint64_t batch_id);
+
+	/**
+	 * @brief Records the ownership acquire barriers of the resources of all the completed batches
+	 *        It does nothing if the uploads do not use a dedicated queue
+	 * @param command_buffer Command buffer of the graphics queue family, which must be submitted
+	 *        before any command buffer using the resources
+	 */
+	void acquire(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Submits the pending uploads and blocks until all the resources can be used on the graphics queue
+	 *        Meant for loading screens, where stalling does not matter
+	 */
+	void flush();
+
+	/**
+	 * @brief Measurements of the uploads since the manager was created
+	 */
+	struct Statistics
+	{
+		/// Time spent generating mip levels on the CPU because the queue cannot blit, in seconds
+		double mip_generation_time{0.0};
+
+		/// Time spent blocked on the fences of the batches, in seconds
+		double fence_wait_time{0.0};
+
+		/// Most bytes of staging memory in use at once, in the ring and in dedicated staging buffers
+		VkDeviceSize peak_staging_usage{0};
+	};
+
+	const Statistics &get_statistics() const;
+
+	static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 32 * 1024 * 1024;
+
+  private:
+	struct BufferAcquire
+	{
+		const core::Buffer *buffer;
+
+		VkDeviceSize offset;
+
+		VkDeviceSize size;
+
+		BufferMemoryBarrier barrier;
+	};
+
+	struct ImageAcquire
+	{
+		const core::ImageView *image_view;
+
+		ImageMemoryBarrier barrier;
+	};
+
+	struct Batch
+	{
+		uint64_t id{0};
+
+		std::unique_ptr<CommandPool> command_pool;
+
+		CommandBuffer *command_buffer{nullptr};
+
+		VkFence fence{VK_NULL_HANDLE};
+
+		/// Position of the ring head when the batch was submitted, the space before it is freed on completion
+		uint64_t ring_end{0};
+
+		/// Staging buffers for compressed mip levels too big for the ring
+		std::vector<std::unique_ptr<core::Buffer>> dedicated_buffers;
+
+		std::vector<BufferAcquire> buffer_acquires;
+
+		std::vector<ImageAcquire> image_acquires;
+	};
+
+	/**
+	 * @return The batch being recorded, starting a new one if needed
+	 */
+	Batch &get_recording_batch();
+
+	/**
+	 * @brief Reserves space in the staging ring, waiting for older batches if it is full
+	 * @return Offset of the space in the staging buffer
+	 */
+	VkDeviceSize allocate_staging(VkDeviceSize size, VkDeviceSize alignment);
+
+	/**
+	 * @brief Records the copies of the mip levels of an image from the staging ring, to the levels of a view
+	 *        The levels are left in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+	 */
+	void stage_image(const sg::Image &source, const core::ImageView &destination);
+
+	/**
+	 * @brief Transitions the levels of a view after their upload, releasing them to the graphics queue family if needed
+	 * @param blitted Whether the levels were left in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL by blit_mip_levels()
+	 */
+	void release_image(const core::ImageView &destination, bool blitted);
+
+	/**
+	 * @brief Records linear blits filling each level from the previous one, the levels before
+	 *        first_level must hold data in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+	 */
+	void blit_mip_levels(CommandBuffer &command_buffer, const sg::Image &image, uint32_t first_level, uint32_t level_count);
+
+	/**
+	 * @brief Frees the resources of the oldest submitted batch, which must have completed
+	 */
+	void retire_oldest_batch();
+
+	/**
+	 * @brief Blocks until the oldest submitted batch completes, then retires it
+	 */
+	void wait_oldest_batch();
+
+	void update_peak_staging_usage();
+
+	/**
+	 * @brief Retires all the completed batches, in submission order
+	 */
+	void poll();
+
+	Device &device;
+
+	const Queue *queue{nullptr};
+
+	uint32_t graphics_queue_family{0};
+
+	std::unique_ptr<core::Buffer> staging_buffer;
+
+	uint8_t *staging_data{nullptr};
+
+	/// Monotonic positions in the ring, the offset in the buffer is the position modulo its size
+	uint64_t ring_head{0};
+
+	uint64_t ring_tail{0};
+
+	/// Size of the dedicated staging buffers of the batches not retired yet
+	VkDeviceSize dedicated_staging_size{0};
+
+	Statistics statistics;
+
+	uint64_t next_batch_id{1};
+
+	/// Identifier of the newest completed batch
+	uint64_t completed_batch_id{0};
+
+	std::unique_ptr<Batch> recording_batch;
+
+	std::deque<std::unique_ptr<Batch>> submitted_batches;
+
+	/// Batches kept for reuse of their command pool and fence
+	std::vector<std::unique_ptr<Batch>> free_batches;
+
+	/// Barriers of completed batches waiting for acquire()
+	std::vector<BufferAcquire> pending_buffer_acquires;
+
+	std::vector<ImageAcquire> pending_image_acquires;
+};
+}        // namespace vkb
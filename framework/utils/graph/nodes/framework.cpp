@@ -396,13 +396,11 @@ FrameworkNode::FrameworkNode(size_t id, const SpecializationConstantState &speci
 
 	nlohmann::json data = {};
 
-	const auto &state = specialization_constant_state.get_specialization_constant_state();
-	auto        it    = state.begin();
-	while (it != state.end())
+	for (const auto &constant : specialization_constant_state)
 	{
 		std::stringstream str;
-		str << it->first;
-		data.push_back({str.str(), it->second});
+		str << constant.constant_id;
+		data.push_back({str.str(), std::vector<uint8_t>{constant.data.begin(), constant.data.begin() + constant.size}});
 	}
 	attributes["data"]  = data;
 	attributes["group"] = "Core";
@@ -83,20 +83,21 @@ SceneNode::SceneNode(size_t id, std::string text)
 	attributes["label"] = text;
 }
 
-SceneNode::SceneNode(size_t id, const sg::Scene &scene)
+SceneNode::SceneNode(size_t id, const sg::Scene &scene, nlohmann::json cost)
 {
 	attributes["id"]    = id;
 	attributes["type"]  = SceneNode::get_type_str(SceneNodeType::Scene);
 	attributes["label"] = label(SceneNodeType::Scene, scene);
-	attributes["data"]  = nlohmann::json{};
+	attributes["data"]  = nlohmann::json{{"cost", cost}};
 	attributes["group"] = "Scene";
 }
 
-SceneNode::SceneNode(size_t id, const sg::Node &node)
+SceneNode::SceneNode(size_t id, const sg::Node &node, nlohmann::json cost)
 {
 	attributes["id"]    = id;
 	attributes["type"]  = SceneNode::get_type_str(SceneNodeType::Node);
 	attributes["label"] = label(SceneNodeType::Node, node);
+	attributes["data"]  = nlohmann::json{{"cost", cost}};
 	attributes["group"] = "Node";
 }
 
@@ -121,11 +122,15 @@ SceneNode::SceneNode(size_t id, const sg::Transform &transform)
 	attributes["group"] = "Component";
 }
 
-SceneNode::SceneNode(size_t id, const sg::Mesh &mesh)
+SceneNode::SceneNode(size_t id, const sg::Mesh &mesh, nlohmann::json cost)
 {
 	attributes["id"]    = id;
 	attributes["type"]  = SceneNode::get_type_str(SceneNodeType::Mesh);
 	attributes["label"] = label(SceneNodeType::Mesh, mesh);
+	attributes["data"]  = nlohmann::json{
+        {"submeshes", mesh.get_submeshes().size()},
+        {"nodes", mesh.get_nodes().size()},
+        {"cost", cost}};
 	attributes["group"] = "Component";
 }
 
@@ -134,18 +139,36 @@ SceneNode::SceneNode(size_t id, const sg::SubMesh &submesh)
 	attributes["id"]    = id;
 	attributes["type"]  = SceneNode::get_type_str(SceneNodeType::SubMesh);
 	attributes["label"] = label(SceneNodeType::SubMesh, submesh);
+
+	// Triangles of each level of detail, the pipeline is selected by the shader variant
+	auto lods = nlohmann::json::array();
+	for (uint32_t lod = 0; lod < submesh.get_lod_count(); lod++)
+	{
+		lods.push_back(submesh.vertex_indices != 0 ? submesh.get_vertex_indices(lod) / 3 : submesh.vertices_count / 3);
+	}
+
+	attributes["data"] = nlohmann::json{
+	    {"vertices", submesh.vertices_count},
+	    {"triangles", lods},
+	    {"meshlets", submesh.meshlets.size()},
+	    {"shader_variant", submesh.get_shader_variant().get_id()},
+	    {"shader_defines", submesh.get_shader_variant().get_preamble()}};
+
 	attributes["group"] = "Component";
 }
 
-SceneNode::SceneNode(size_t id, const sg::Texture &texture, std::string name)
+SceneNode::SceneNode(size_t id, const sg::Texture &texture, std::string name, VkDeviceSize memory_size)
 {
 	attributes["id"]    = id;
 	attributes["type"]  = SceneNode::get_type_str(SceneNodeType::Texture);
 	attributes["label"] = label(SceneNodeType::Texture, texture);
+	attributes["data"]  = nlohmann::json{
+        {"name", name},
+        {"memory_size", memory_size}};
 	attributes["group"] = "Component";
 }
 
-SceneNode::SceneNode(size_t id, const sg::Material &mat)
+SceneNode::SceneNode(size_t id, const sg::Material &mat, nlohmann::json cost)
 {
 	attributes["id"]    = id;
 	attributes["type"]  = SceneNode::get_type_str(SceneNodeType::Material);
@@ -154,7 +177,8 @@ SceneNode::SceneNode(size_t id, const sg::Material &mat)
         {"AlphaMode", utils::to_string(mat.alpha_mode)},
         {"emissive", glm::to_string(mat.emissive)},
         {"double_sided", utils::to_string(mat.double_sided)},
-        {"alpha_cutoff", mat.alpha_cutoff}};
+        {"alpha_cutoff", mat.alpha_cutoff},
+        {"cost", cost}};
 
 	attributes["group"] = "Component";
 }
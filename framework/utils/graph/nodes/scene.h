@@ -77,14 +77,33 @@ class SceneNode : public Node
 
 	SceneNode(size_t id, std::string text);
 
-	SceneNode(size_t id, const sg::Scene &scene);
-	SceneNode(size_t id, const sg::Node &node);
+	/**
+	 * @param cost Work and memory attributed to the whole scene
+	 */
+	SceneNode(size_t id, const sg::Scene &scene, nlohmann::json cost = {});
+
+	/**
+	 * @param cost Work and memory attributed to the node and to its subtree
+	 */
+	SceneNode(size_t id, const sg::Node &node, nlohmann::json cost = {});
 	SceneNode(size_t id, const sg::Component &component);
 	SceneNode(size_t id, const sg::Transform &transform);
-	SceneNode(size_t id, const sg::Mesh &mesh);
+
+	/**
+	 * @param cost Memory of the buffers of the mesh
+	 */
+	SceneNode(size_t id, const sg::Mesh &mesh, nlohmann::json cost = {});
 	SceneNode(size_t id, const sg::SubMesh &submesh);
-	SceneNode(size_t id, const sg::Texture &texture, std::string name);
-	SceneNode(size_t id, const sg::Material &mat);
+
+	/**
+	 * @param memory_size Size in bytes of the device memory of the texture image
+	 */
+	SceneNode(size_t id, const sg::Texture &texture, std::string name, VkDeviceSize memory_size = 0);
+
+	/**
+	 * @param cost Memory of the textures of the material
+	 */
+	SceneNode(size_t id, const sg::Material &mat, nlohmann::json cost = {});
 
 	template <typename T>
 	static std::string get_id(SceneNodeType type, T value);
@@ -21,9 +21,12 @@
 #include "utils/graphs.h"
 
 #include <iostream>
+#include <unordered_map>
 #include <vector>
 
 #include "common/logging.h"
+#include "rendering/subpasses/geometry_subpass.h"
+#include "scene_graph/components/image.h"
 #include "scene_graph/node.h"
 #include "utils/graph/graph.h"
 #include "utils/graph/nodes/framework.h"
@@ -33,11 +36,157 @@ namespace vkb
 {
 namespace utils
 {
-void get_node(Graph &graph, const std::vector<sg::Node *> &children, size_t owner)
+namespace
+{
+/**
+ * @brief Work and memory attributed to a scene node, or to a subtree of the scene
+ */
+struct SceneCost
+{
+	uint32_t draw_count{0};
+
+	uint32_t triangle_count{0};
+
+	double culling_time{0.0};
+
+	double recording_time{0.0};
+
+	VkDeviceSize buffer_memory{0};
+
+	VkDeviceSize texture_memory{0};
+
+	void add(const SceneCost &other)
+	{
+		draw_count += other.draw_count;
+		triangle_count += other.triangle_count;
+		culling_time += other.culling_time;
+		recording_time += other.recording_time;
+		buffer_memory += other.buffer_memory;
+		texture_memory += other.texture_memory;
+	}
+
+	nlohmann::json to_json() const
+	{
+		return nlohmann::json{
+		    {"draws", draw_count},
+		    {"triangles", triangle_count},
+		    {"culling_ms", culling_time},
+		    {"recording_ms", recording_time},
+		    {"buffer_memory", buffer_memory},
+		    {"texture_memory", texture_memory}};
+	}
+};
+
+using NodeCosts = std::unordered_map<const sg::Node *, GeometrySubpass::NodeCost>;
+
+VkDeviceSize get_texture_memory(Device &device, sg::Texture &texture)
+{
+	auto image = texture.get_image();
+	if (!image)
+	{
+		return 0;
+	}
+
+	VmaAllocationInfo allocation_info{};
+	vmaGetAllocationInfo(device.get_memory_allocator(), image->get_vk_image().get_memory(), &allocation_info);
+
+	return allocation_info.size;
+}
+
+VkDeviceSize get_buffer_memory(const sg::Mesh &mesh)
+{
+	VkDeviceSize memory = 0;
+
+	for (auto sub_mesh : mesh.get_submeshes())
+	{
+		for (auto &vertex_buffer : sub_mesh->vertex_buffers)
+		{
+			memory += vertex_buffer.second.get_size();
+		}
+
+		for (uint32_t lod = 0; lod < sub_mesh->get_lod_count(); lod++)
+		{
+			memory += sub_mesh->get_index_buffer(lod).get_size();
+		}
+	}
+
+	return memory;
+}
+
+VkDeviceSize get_texture_memory(Device &device, const sg::Material &material)
+{
+	VkDeviceSize memory = 0;
+
+	for (auto &texture : material.textures)
+	{
+		memory += get_texture_memory(device, *texture.second);
+	}
+
+	return memory;
+}
+
+/**
+ * @brief Computes the cost of a node itself, from the work attributed to it by the subpasses and the resources it references
+ */
+SceneCost get_node_cost(Device &device, sg::Node &node, const NodeCosts &node_costs)
+{
+	SceneCost cost;
+
+	auto it = node_costs.find(&node);
+	if (it != node_costs.end())
+	{
+		cost.draw_count     = it->second.draw_count;
+		cost.triangle_count = it->second.triangle_count;
+		cost.culling_time   = it->second.culling_time;
+		cost.recording_time = it->second.recording_time;
+	}
+
+	if (node.has_component<sg::Mesh>())
+	{
+		auto &mesh = node.get_component<sg::Mesh>();
+
+		cost.buffer_memory = get_buffer_memory(mesh);
+
+		for (auto sub_mesh : mesh.get_submeshes())
+		{
+			cost.texture_memory += get_texture_memory(device, *sub_mesh->get_material());
+		}
+	}
+
+	return cost;
+}
+
+/**
+ * @brief Adds the cost of every node of a subtree to the total of the subtree
+ */
+SceneCost get_subtree_cost(Device &device, const std::vector<sg::Node *> &children, const NodeCosts &node_costs, std::unordered_map<const sg::Node *, SceneCost> &subtree_costs)
+{
+	SceneCost total;
+
+	for (const auto &child : children)
+	{
+		auto subtree_cost = get_node_cost(device, *child, node_costs);
+
+		subtree_cost.add(get_subtree_cost(device, child->get_children(), node_costs, subtree_costs));
+
+		subtree_costs[child] = subtree_cost;
+
+		total.add(subtree_cost);
+	}
+
+	return total;
+}
+}        // namespace
+
+void get_node(Graph &graph, Device &device, const std::vector<sg::Node *> &children, size_t owner, const NodeCosts &node_costs, const std::unordered_map<const sg::Node *, SceneCost> &subtree_costs)
 {
 	for (const auto &child : children)
 	{
-		size_t child_id = graph.create_node<SceneNode>(*child);
+		nlohmann::json cost{
+		    {"node", get_node_cost(device, *child, node_costs).to_json()},
+		    {"subtree", subtree_costs.at(child).to_json()}};
+
+		size_t child_id = graph.create_node<SceneNode>(*child, cost);
 		graph.add_edge(owner, child_id);
 
 		if (child->has_component<sg::Transform>())
@@ -49,7 +198,7 @@ void get_node(Graph &graph, const std::vector<sg::Node *> &children, size_t owne
 		if (child->has_component<sg::Mesh>())
 		{
 			auto & mesh    = child->get_component<sg::Mesh>();
-			size_t mesh_id = graph.create_node<SceneNode>(mesh);
+			size_t mesh_id = graph.create_node<SceneNode>(mesh, nlohmann::json{{"buffer_memory", get_buffer_memory(mesh)}});
 			graph.add_edge(child_id, mesh_id);
 
 			for (const auto &sub_mesh : mesh.get_submeshes())
@@ -58,24 +207,24 @@ void get_node(Graph &graph, const std::vector<sg::Node *> &children, size_t owne
 				graph.add_edge(mesh_id, sub_mesh_id);
 
 				const auto &material    = sub_mesh->get_material();
-				size_t      material_id = graph.create_node<SceneNode>(*material);
+				size_t      material_id = graph.create_node<SceneNode>(*material, nlohmann::json{{"texture_memory", get_texture_memory(device, *material)}});
 				graph.add_edge(sub_mesh_id, material_id);
 
 				auto it = material->textures.begin();
 				while (it != material->textures.end())
 				{
-					size_t texture_id = graph.create_node<SceneNode>(*it->second, it->first);
+					size_t texture_id = graph.create_node<SceneNode>(*it->second, it->first, get_texture_memory(device, *it->second));
 					graph.add_edge(material_id, texture_id);
 					it++;
 				}
 			}
 		}
 
-		get_node(graph, child->get_children(), child_id);
+		get_node(graph, device, child->get_children(), child_id, node_costs, subtree_costs);
 	}
 }
 
-bool debug_graphs(RenderContext &context, sg::Scene &scene)
+bool debug_graphs(RenderContext &context, sg::Scene &scene, RenderPipeline *render_pipeline)
 {
 	Graph  framework_graph("Framework");
 	size_t device_id = framework_graph.create_node<FrameworkNode>(context.get_device());
@@ -227,11 +376,29 @@ bool debug_graphs(RenderContext &context, sg::Scene &scene)
 		frame_it++;
 	}
 
+	// Work of the last frame, attributed to the scene nodes by the subpasses drawing them
+	NodeCosts node_costs;
+
+	if (render_pipeline)
+	{
+		for (auto &subpass : render_pipeline->get_subpasses())
+		{
+			if (auto geometry_subpass = dynamic_cast<GeometrySubpass *>(subpass.get()))
+			{
+				geometry_subpass->get_node_costs(node_costs);
+			}
+		}
+	}
+
+	std::unordered_map<const sg::Node *, SceneCost> subtree_costs;
+
+	auto scene_cost = get_subtree_cost(device, scene.get_root_node().get_children(), node_costs, subtree_costs);
+
 	Graph scene_graph("Scene");
 
-	size_t scene_id = scene_graph.create_node<SceneNode>(scene);
+	size_t scene_id = scene_graph.create_node<SceneNode>(scene, scene_cost.to_json());
 
-	get_node(scene_graph, scene.get_root_node().get_children(), scene_id);
+	get_node(scene_graph, device, scene.get_root_node().get_children(), scene_id, node_costs, subtree_costs);
 
 	return framework_graph.dump_to_file("framework.json") && scene_graph.dump_to_file("scene.json");
 }
@@ -21,12 +21,21 @@
 #pragma once
 
 #include "rendering/render_context.h"
+#include "rendering/render_pipeline.h"
 #include "scene_graph/scene.h"
 
 namespace vkb
 {
 namespace utils
 {
-bool debug_graphs(RenderContext &context, sg::Scene &scene);
+/**
+ * @brief Dumps the framework and scene graphs to JSON files
+ *        Scene nodes are annotated with the memory of the resources they reference, and with the draws,
+ *        triangles and CPU time the geometry subpasses of the render pipeline attributed to them in the last frame,
+ *        both for the node itself and summed over its subtree.
+ * @param render_pipeline Render pipeline drawing the scene, or nullptr to only export the memory of the nodes
+ * @return Whether both files were written
+ */
+bool debug_graphs(RenderContext &context, sg::Scene &scene, RenderPipeline *render_pipeline = nullptr);
 }        // namespace utils
 }        // namespace vkb
\ No newline at end of file
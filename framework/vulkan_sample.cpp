@@ -20,6 +20,14 @@
 
 #include "vulkan_sample.h"
 
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "common/error.h"
 
 VKBP_DISABLE_WARNINGS()
@@ -30,10 +38,23 @@ VKBP_ENABLE_WARNINGS()
 #include "common/helpers.h"
 #include "common/logging.h"
 #include "common/vk_common.h"
+#include "cpu_profiler.h"
+#include "draw_list_record.h"
 #include "gltf_loader.h"
+#include "platform/filesystem.h"
 #include "platform/platform.h"
+#include "platform/thread_affinity.h"
 #include "platform/window.h"
+#include "rendering/subpasses/upscale_subpass.h"
 #include "scene_graph/components/camera.h"
+#include "scene_graph/components/image.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "scene_graph/script.h"
+#include "scene_graph/scripts/free_camera.h"
+#include "memory_defragmenter.h"
+#include "shader_reloader.h"
+#include "texture_array_batcher.h"
+#include "texture_streamer.h"
 #include "utils/graphs.h"
 #include "utils/strings.h"
 
@@ -43,19 +64,240 @@ VKBP_ENABLE_WARNINGS()
 
 namespace vkb
 {
+namespace
+{
+/// Identifies the resource cache data written by save_pipeline_cache, increased when its format changes
+constexpr uint32_t RESOURCE_CACHE_MAGIC = 0x564B4252;        // 'VKBR'
+
+constexpr uint32_t RESOURCE_CACHE_VERSION = 3;
+
+/**
+ * @brief Header written before the resource cache data, so that data from another device or driver is discarded
+ */
+struct ResourceCacheHeader
+{
+	uint32_t magic;
+
+	uint32_t version;
+
+	uint32_t vendor_id;
+
+	uint32_t device_id;
+
+	uint32_t driver_version;
+
+	uint8_t uuid[VK_UUID_SIZE];
+};
+
+ResourceCacheHeader get_resource_cache_header(const Device &device)
+{
+	auto &properties = device.get_properties();
+
+	ResourceCacheHeader header{};
+	header.magic          = RESOURCE_CACHE_MAGIC;
+	header.version        = RESOURCE_CACHE_VERSION;
+	header.vendor_id      = properties.vendorID;
+	header.device_id      = properties.deviceID;
+	header.driver_version = properties.driverVersion;
+	std::memcpy(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+	return header;
+}
+
+/**
+ * @return Suffix of the cache file names, made of the pipeline cache UUID and the driver version of the device
+ */
+std::string get_cache_file_suffix(const Device &device)
+{
+	std::stringstream suffix;
+
+	for (auto byte : device.get_properties().pipelineCacheUUID)
+	{
+		suffix << std::hex << std::setw(2) << std::setfill('0') << static_cast<uint32_t>(byte);
+	}
+
+	auto driver_version = device.get_driver_version();
+	suffix << std::dec << "_" << driver_version.major << "." << driver_version.minor << "." << driver_version.patch;
+
+	return suffix.str();
+}
+
+/**
+ * @return Whether the data starts with a valid pipeline cache header for the device
+ */
+bool is_pipeline_cache_valid(const Device &device, const std::vector<uint8_t> &data)
+{
+	// Header of version VK_PIPELINE_CACHE_HEADER_VERSION_ONE, as defined by the specification
+	struct
+	{
+		uint32_t header_length;
+		uint32_t header_version;
+		uint32_t vendor_id;
+		uint32_t device_id;
+		uint8_t  uuid[VK_UUID_SIZE];
+	} header;
+
+	if (data.size() < sizeof(header))
+	{
+		return false;
+	}
+
+	std::memcpy(&header, data.data(), sizeof(header));
+
+	auto &properties = device.get_properties();
+
+	return header.header_length >= sizeof(header) &&
+	       header.header_version == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+	       header.vendor_id == properties.vendorID &&
+	       header.device_id == properties.deviceID &&
+	       std::memcmp(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+/**
+ * @brief Groups scripts so that no two groups touch the same nodes
+ *        Scripts go to the group of their topmost scripted ancestor, so groups cover disjoint subtrees,
+ *        and no script of another group modifies the ancestors they read.
+ */
+std::vector<std::vector<sg::Script *>> group_scripts_by_subtree(const std::vector<sg::Script *> &scripts)
+{
+	std::unordered_set<const sg::Node *> scripted_nodes;
+
+	for (auto script : scripts)
+	{
+		scripted_nodes.insert(&script->get_node());
+	}
+
+	std::vector<std::vector<sg::Script *>> groups;
+
+	std::unordered_map<const sg::Node *, size_t> group_indices;
+
+	for (auto script : scripts)
+	{
+		const sg::Node *subtree_root = &script->get_node();
+
+		for (auto node = subtree_root->get_parent(); node; node = node->get_parent())
+		{
+			if (scripted_nodes.count(node) > 0)
+			{
+				subtree_root = node;
+			}
+		}
+
+		auto it = group_indices.find(subtree_root);
+
+		if (it == group_indices.end())
+		{
+			it = group_indices.emplace(subtree_root, groups.size()).first;
+			groups.emplace_back();
+		}
+
+		groups[it->second].push_back(script);
+	}
+
+	return groups;
+}
+/**
+ * @brief Identifies what an instance and device were created for, so that they are only shared between samples needing the same
+ */
+std::string get_device_context_key(const std::vector<const char *> &instance_extensions,
+                                   const std::vector<const char *> &validation_layers,
+                                   const std::vector<const char *> &device_extensions,
+                                   bool                             headless)
+{
+	std::string key = headless ? "headless" : "windowed";
+
+	for (auto names : {&instance_extensions, &validation_layers, &device_extensions})
+	{
+		key += "|";
+
+		for (auto name : *names)
+		{
+			key += std::string{name} + ",";
+		}
+	}
+
+	return key;
+}
+}        // namespace
+
 VulkanSample::VulkanSample()
 {
 }
 
+DeviceContext::~DeviceContext()
+{
+	if (device)
+	{
+		device->wait_idle();
+	}
+
+	device.reset();
+
+	if (surface != VK_NULL_HANDLE)
+	{
+		vkDestroySurfaceKHR(instance->get_handle(), surface, nullptr);
+	}
+
+	instance.reset();
+}
+
 VulkanSample::~VulkanSample()
 {
 	device->wait_idle();
 
+	if (pipeline_cache != VK_NULL_HANDLE)
+	{
+		save_pipeline_cache();
+	}
+
+	// Stops streaming before the scene it adds images to
+	scene_loader.reset();
+
+	texture_streamer.reset();
+
+	memory_defragmenter.reset();
+
+	shader_reloader.reset();
+
+	if (camera_path)
+	{
+		camera_path->save();
+	}
+
 	scene.reset();
 
 	stats.reset();
 	gui.reset();
+	upscale_subpasses.clear();
 	render_context.reset();
+
+	// Only released once the render context no longer creates render targets with it
+	render_graph.reset();
+
+	if (shared_device_context)
+	{
+		auto &resource_cache = device->get_resource_cache();
+
+		// Descriptor sets and framebuffers refer to the resources of the sample, the rest is kept for the next one
+		resource_cache.wait_pipeline_compilations();
+		resource_cache.clear_descriptor_sets();
+		resource_cache.clear_framebuffers();
+
+		// A pipeline cache set by the sample is destroyed with it
+		resource_cache.set_pipeline_cache(VK_NULL_HANDLE);
+
+		auto context      = std::make_unique<DeviceContext>();
+		context->instance = std::move(instance);
+		context->surface  = surface;
+		context->device   = std::move(device);
+		context->key      = device_context_key;
+
+		surface = VK_NULL_HANDLE;
+
+		*shared_device_context = std::move(context);
+		return;
+	}
+
 	device.reset();
 
 	if (surface != VK_NULL_HANDLE)
@@ -75,116 +317,1135 @@ bool VulkanSample::prepare(Platform &platform)
 
 	LOGI("Initializing Vulkan sample");
 
-	// Creating the vulkan instance
+	startup_timeline.start();
+
+	thermal_governor = std::make_unique<ThermalGovernor>(platform);
+
 	std::vector<const char *> instance_extensions = get_instance_extensions();
 	instance_extensions.push_back(platform.get_surface_extension());
-	instance = std::make_unique<Instance>(get_name(), instance_extensions, get_validation_layers(), is_headless());
 
-	// Getting a valid vulkan surface from the platform
-	surface = platform.get_window().create_surface(instance->get_handle());
-
-	// Creating vulkan device, specifying the swapchain
+	std::vector<const char *> validation_layers = get_validation_layers();
 	std::vector<const char *> device_extensions = get_device_extensions();
-	if (!is_headless() || instance->is_enabled(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME))
+
+	device_context_key = get_device_context_key(instance_extensions, validation_layers, device_extensions, is_headless());
+
+	if (device_group_mode != DeviceGroupMode::None)
+	{
+		// A device created over a device group cannot be shared with samples expecting a single GPU
+		device_context_key += "|device_group";
+	}
+
+	if (shared_device_context && *shared_device_context && (*shared_device_context)->key != device_context_key)
+	{
+		LOGI("The device of the previous sample was created for other extensions, creating another");
+		shared_device_context->reset();
+	}
+
+	if (shared_device_context && *shared_device_context)
+	{
+		LOGI("Reusing the device of the previous sample");
+
+		auto &context = **shared_device_context;
+
+		instance = std::move(context.instance);
+		surface  = context.surface;
+		device   = std::move(context.device);
+
+		context.surface = VK_NULL_HANDLE;
+		shared_device_context->reset();
+	}
+	else
+	{
+		// Creating the vulkan instance
+		{
+			StartupTimeline::Scope stage{startup_timeline, validation_layers.empty() ? "Instance" : "Instance with validation layers"};
+			instance = std::make_unique<Instance>(get_name(), instance_extensions, validation_layers, is_headless());
+		}
+
+		// Getting a valid vulkan surface from the platform
+		{
+			StartupTimeline::Scope stage{startup_timeline, "Surface"};
+			surface = platform.get_window().create_surface(instance->get_handle());
+		}
+
+		StartupTimeline::Scope stage{startup_timeline, "Device"};
+
+		// Creating vulkan device, specifying the swapchain
+		if (!is_headless() || instance->is_enabled(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME))
+		{
+			device_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+		}
+		bool extended_features = instance->is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+		bool debug_utils       = instance->is_enabled(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+
+		instance->set_preferred_gpu(preferred_gpu);
+
+		auto gpu = instance->get_gpu(surface, device_extensions);
+
+		std::vector<VkPhysicalDevice> device_group;
+		if (device_group_mode != DeviceGroupMode::None)
+		{
+			device_group = instance->get_device_group(gpu);
+		}
+
+		device = std::make_unique<vkb::Device>(gpu, surface, device_extensions, VkPhysicalDeviceFeatures{}, extended_features, debug_utils, QueueConfiguration{}, device_group);
+
+		// On big.LITTLE CPUs, frame jobs run on the big cores with the render thread and background jobs on the little ones
+		if (get_cpu_mask(ThreadRole::Background) != 0)
+		{
+			device->get_job_system().set_affinity(get_cpu_mask(ThreadRole::Frame), get_cpu_mask(ThreadRole::Background));
+		}
+	}
+
+	if (pipeline_cache_persistence)
 	{
-		device_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+		StartupTimeline::Scope stage{startup_timeline, "Pipeline cache load"};
+		load_pipeline_cache();
 	}
-	device = std::make_unique<vkb::Device>(instance->get_gpu(), surface, device_extensions);
 
 	// Preparing render context for rendering
-	render_context = std::make_unique<vkb::RenderContext>(*device, surface, platform.get_window().get_width(), platform.get_window().get_height());
-	prepare_render_context();
+	{
+		StartupTimeline::Scope stage{startup_timeline, "Render context"};
+		render_context = std::make_unique<vkb::RenderContext>(*device, surface, platform.get_window().get_width(), platform.get_window().get_height());
+		render_context->set_low_latency_enabled(low_latency_enabled);
+		render_context->set_incremental_rendering_enabled(incremental_rendering && !low_latency_enabled);
+		prepare_render_context();
+		render_context->set_device_group_mode(device_group_mode);
+	}
+
+#if !defined(VK_USE_PLATFORM_ANDROID_KHR)
+	// The shaders are packaged in the APK on Android, so they cannot be edited while running
+	if (shader_hot_reload)
+	{
+		shader_reloader = std::make_unique<ShaderReloader>(*device);
+	}
+#endif
+
+	framework_prepare_end = StartupTimeline::Clock::now();
 
 	return true;
 }
 
-void VulkanSample::prepare_render_context()
+void VulkanSample::set_pipeline_cache_persistence(bool enabled)
 {
-	render_context->prepare();
+	pipeline_cache_persistence = enabled;
 }
 
-void VulkanSample::update_scene(float delta_time)
+void VulkanSample::set_device_group_mode(DeviceGroupMode mode)
 {
-	if (scene)
+	device_group_mode = mode;
+}
+
+StartupTimeline &VulkanSample::get_startup_timeline()
+{
+	return startup_timeline;
+}
+
+void VulkanSample::set_shared_device_context(std::unique_ptr<DeviceContext> &slot)
+{
+	shared_device_context = &slot;
+}
+
+void VulkanSample::set_progressive_scene_loading(bool enabled)
+{
+	progressive_scene_loading = enabled;
+}
+
+void VulkanSample::set_scene_cache_enabled(bool enabled)
+{
+	scene_cache_enabled = enabled;
+}
+
+void VulkanSample::set_vertex_quantization(bool enabled)
+{
+	vertex_quantization = enabled;
+}
+
+void VulkanSample::set_lod_generation(bool enabled)
+{
+	lod_generation = enabled;
+}
+
+void VulkanSample::set_mesh_optimization(bool enabled)
+{
+	mesh_optimization = enabled;
+}
+
+void VulkanSample::set_meshlet_generation(bool enabled)
+{
+	meshlet_generation = enabled;
+}
+
+void VulkanSample::set_interleaved_vertices(bool enabled)
+{
+	interleaved_vertices = enabled;
+}
+
+void VulkanSample::set_primitive_merging(bool enabled)
+{
+	primitive_merging = enabled;
+}
+
+void VulkanSample::set_texture_array_batching(bool enabled)
+{
+	texture_array_batching = enabled;
+}
+
+void VulkanSample::set_image_variant(const std::string &variant)
+{
+	image_variant = variant;
+}
+
+void VulkanSample::set_texture_streaming_budget(VkDeviceSize budget)
+{
+	texture_streaming_budget = budget;
+
+	if (texture_streamer)
 	{
-		//Update scripts
-		if (scene->has_component<sg::Script>())
+		texture_streamer->set_budget(budget);
+	}
+}
+
+void VulkanSample::set_texture_streaming_sparse_residency(bool enabled)
+{
+	texture_streaming_sparse_residency = enabled;
+}
+
+TextureStreamer *VulkanSample::get_texture_streamer()
+{
+	return texture_streamer.get();
+}
+
+void VulkanSample::set_memory_defragmentation(bool enabled)
+{
+	memory_defragmentation = enabled;
+}
+
+void VulkanSample::set_shader_hot_reload(bool enabled)
+{
+	shader_hot_reload = enabled;
+}
+
+void VulkanSample::set_camera_path(sg::CameraPath::Mode mode, const std::string &filename)
+{
+	camera_path_mode = mode;
+	camera_path_file = filename;
+}
+
+void VulkanSample::set_draw_list_capture(const std::string &filename, uint32_t frame)
+{
+	draw_list_capture_file      = filename;
+	draw_list_capture_countdown = frame;
+}
+
+void VulkanSample::attach_camera_path()
+{
+	if (camera_path_file.empty() || camera_path || !scene || !scene->has_component<sg::Script>())
+	{
+		return;
+	}
+
+	for (auto script : scene->get_components<sg::Script>())
+	{
+		if (auto free_camera = dynamic_cast<sg::FreeCamera *>(script))
 		{
-			auto scripts = scene->get_components<sg::Script>();
+			auto path = std::make_unique<sg::CameraPath>(free_camera->get_node(), camera_path_mode, camera_path_file);
 
-			for (auto script : scripts)
-			{
-				script->update(delta_time);
-			}
+			camera_path = path.get();
+
+			// Not set on the node, whose script stays the free camera, and updated after it to override its input
+			scene->add_component(std::move(path));
+
+			return;
 		}
 	}
 }
 
-void VulkanSample::update_stats(float delta_time)
+void VulkanSample::set_low_latency_enabled(bool enabled)
 {
-	if (stats)
-	{
-		stats->update();
+	low_latency_enabled = enabled;
 
-		static float stats_view_count = 0.0f;
-		stats_view_count += delta_time;
+	if (render_context)
+	{
+		render_context->set_low_latency_enabled(enabled);
 
-		// Reset every STATS_VIEW_RESET_TIME seconds
-		if (stats_view_count > STATS_VIEW_RESET_TIME)
-		{
-			reset_stats_view();
-			stats_view_count = 0.0f;
-		}
+		// The scene is updated after the image is acquired, too late for its damage
+		render_context->set_incremental_rendering_enabled(incremental_rendering && !enabled);
 	}
 }
 
-void VulkanSample::update_gui(float delta_time)
+void VulkanSample::set_preferred_gpu(const std::string &gpu)
 {
-	if (gui)
+	preferred_gpu = gpu;
+}
+
+void VulkanSample::set_concurrent_subpass_recording(bool enabled)
+{
+	concurrent_subpass_recording = enabled;
+}
+
+void VulkanSample::set_incremental_rendering(bool enabled)
+{
+	incremental_rendering = enabled;
+
+	if (render_context)
 	{
-		if (gui->is_debug_view_active())
-		{
-			update_debug_window();
-		}
+		render_context->set_incremental_rendering_enabled(enabled && !low_latency_enabled);
+	}
+}
 
-		gui->new_frame();
+void VulkanSample::update_damage()
+{
+	VKB_PROFILE_SCOPE("VulkanSample::update_damage");
 
-		gui->show_top_window(get_name(), stats.get(), &get_debug_info());
+	sg::Camera *camera = nullptr;
+
+	if (scene && scene->has_component<sg::Script>())
+	{
+		for (auto script : scene->get_components<sg::Script>())
+		{
+			if (dynamic_cast<sg::FreeCamera *>(script) && script->get_node().has_component<sg::Camera>())
+			{
+				camera = &script->get_node().get_component<sg::Camera>();
+				break;
+			}
+		}
+	}
+
+	if (!camera && scene && scene->get_components<sg::Camera>().size() == 1)
+	{
+		camera = scene->get_components<sg::Camera>().front();
+	}
+
+	VkExtent2D extent = render_context->get_surface_extent();
+
+	if (camera)
+	{
+		render_context->add_damage(damage_tracker.update(*scene, *camera, extent));
+	}
+
+	// Without the camera of the frame, what the scene changed is unknown
+	if (!camera || gui_input_damage)
+	{
+		render_context->add_full_damage();
+	}
+
+	gui_input_damage = false;
+
+	if (gui)
+	{
+		render_context->add_damage(gui->take_damage());
+	}
+}
+
+void VulkanSample::add_benchmark_report(nlohmann::json &report)
+{
+	Application::add_benchmark_report(report);
+
+	auto &properties     = device->get_properties();
+	auto  driver_version = device->get_driver_version();
+
+	report["device"] = {
+	    {"name", properties.deviceName},
+	    {"vendor_id", properties.vendorID},
+	    {"device_id", properties.deviceID},
+	    {"api_version", to_string(VK_VERSION_MAJOR(properties.apiVersion)) + "." +
+	                        to_string(VK_VERSION_MINOR(properties.apiVersion)) + "." +
+	                        to_string(VK_VERSION_PATCH(properties.apiVersion))},
+	    {"driver_version", to_string(driver_version.major) + "." +
+	                           to_string(driver_version.minor) + "." +
+	                           to_string(driver_version.patch)}};
+
+	if (startup_timeline.is_finished())
+	{
+		report["startup"] = startup_timeline.to_json();
+	}
+
+	if (stats)
+	{
+		auto &stats_report    = report["stats"];
+		auto &counters_report = report["counters"];
+
+		for (auto index : stats->get_enabled_stats())
+		{
+			if (!stats->is_available(index))
+			{
+				continue;
+			}
+
+			// Stats are named as in the stats view, values are not scaled for display
+			std::string stat_name = to_string(static_cast<int>(index));
+
+			if (gui)
+			{
+				auto &graph_map = gui->get_stats_view().graph_map;
+				auto  graph     = graph_map.find(index);
+
+				if (graph != graph_map.end())
+				{
+					stat_name = graph->second.name;
+				}
+			}
+
+			stats_report[stat_name] = stats->get_data(index);
+
+			// Tools find the stats sampling a counter by its hwcpipe name, which does not depend on the gui
+			auto counter_name = stats->get_counter_name(index);
+
+			if (!counter_name.empty())
+			{
+				counters_report[counter_name] = stat_name;
+			}
+		}
+	}
+
+	// Sizes which only grow with a leak once the caches and pools are warm, watched by soak runs
+	auto &memory_report = report["memory"];
+
+	VkDeviceSize heap_usage = 0;
+	for (auto &heap : device->get_memory_budget())
+	{
+		heap_usage += heap.usage;
+	}
+
+	memory_report["heap_usage"]   = heap_usage;
+	memory_report["textures"]     = device->get_memory_usage(MemoryCategory::Textures);
+	memory_report["buffer_pools"] = device->get_memory_usage(MemoryCategory::BufferPools);
+
+	auto &resource_cache = device->get_resource_cache();
+
+	memory_report["descriptor_sets"]    = resource_cache.get_stats(ResourceCacheType::DescriptorSet).count;
+	memory_report["descriptor_pools"]   = resource_cache.get_stats(ResourceCacheType::DescriptorPool).count;
+	memory_report["graphics_pipelines"] = resource_cache.get_stats(ResourceCacheType::GraphicsPipeline).count;
+
+	if (pipeline_cache != VK_NULL_HANDLE)
+	{
+		size_t pipeline_cache_size = 0;
+		VK_CHECK(vkGetPipelineCacheData(device->get_handle(), pipeline_cache, &pipeline_cache_size, nullptr));
+
+		memory_report["pipeline_cache"] = pipeline_cache_size;
+	}
+
+	auto &configuration_report = report["configuration"];
+
+	configuration_report["headless"] = is_headless();
+
+	if (render_context)
+	{
+		auto extent = render_context->get_surface_extent();
+
+		configuration_report["width"]  = extent.width;
+		configuration_report["height"] = extent.height;
+	}
+
+	if (!configuration.empty())
+	{
+		configuration_report["index"] = configuration.get_current_index();
+	}
+}
+
+void VulkanSample::load_pipeline_cache()
+{
+	auto suffix = get_cache_file_suffix(*device);
+
+	std::vector<uint8_t> pipeline_data;
+
+	try
+	{
+		pipeline_data = fs::read_temp("pipeline_cache_" + suffix + ".data");
+	}
+	catch (std::runtime_error &ex)
+	{
+		LOGW("No pipeline cache found. {}", ex.what());
+	}
+
+	if (!pipeline_data.empty() && !is_pipeline_cache_valid(*device, pipeline_data))
+	{
+		LOGW("Discard pipeline cache written for another device or driver");
+		pipeline_data.clear();
+	}
+
+	VkPipelineCacheCreateInfo create_info{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+	create_info.initialDataSize = pipeline_data.size();
+	create_info.pInitialData    = pipeline_data.data();
+
+	VK_CHECK(vkCreatePipelineCache(device->get_handle(), &create_info, nullptr, &pipeline_cache));
+
+	auto &resource_cache = device->get_resource_cache();
+
+	resource_cache.set_pipeline_cache(pipeline_cache);
+
+	std::vector<uint8_t> resource_data;
+
+	try
+	{
+		resource_data = fs::read_temp("resource_cache_" + suffix + ".data");
+	}
+	catch (std::runtime_error &ex)
+	{
+		LOGW("No resource cache found. {}", ex.what());
+		return;
+	}
+
+	auto expected_header = get_resource_cache_header(*device);
+
+	if (resource_data.size() < sizeof(ResourceCacheHeader) ||
+	    std::memcmp(resource_data.data(), &expected_header, sizeof(ResourceCacheHeader)) != 0)
+	{
+		LOGW("Discard resource cache written for another device, driver or format version");
+		return;
+	}
+
+	resource_data.erase(resource_data.begin(), resource_data.begin() + sizeof(ResourceCacheHeader));
+
+	try
+	{
+		// Build all the resources from a previous run
+		resource_cache.warmup(resource_data);
+	}
+	catch (std::exception &ex)
+	{
+		LOGW("Failed to warm up the resource cache. {}", ex.what());
+	}
+}
+
+void VulkanSample::save_pipeline_cache()
+{
+	auto &resource_cache = device->get_resource_cache();
+
+	// Pipelines compiled in the background are recorded once they are published
+	resource_cache.wait_pipeline_compilations();
+
+	auto suffix = get_cache_file_suffix(*device);
+
+	try
+	{
+		size_t size{};
+		VK_CHECK(vkGetPipelineCacheData(device->get_handle(), pipeline_cache, &size, nullptr));
+
+		std::vector<uint8_t> pipeline_data(size);
+		VK_CHECK(vkGetPipelineCacheData(device->get_handle(), pipeline_cache, &size, pipeline_data.data()));
+
+		fs::write_temp(pipeline_data, "pipeline_cache_" + suffix + ".data");
+
+		auto header = get_resource_cache_header(*device);
+
+		std::vector<uint8_t> resource_data(sizeof(ResourceCacheHeader));
+		std::memcpy(resource_data.data(), &header, sizeof(ResourceCacheHeader));
+
+		auto record_data = resource_cache.serialize();
+		resource_data.insert(resource_data.end(), record_data.begin(), record_data.end());
+
+		fs::write_temp(resource_data, "resource_cache_" + suffix + ".data");
+	}
+	catch (std::exception &ex)
+	{
+		LOGE("Failed to save the pipeline cache. {}", ex.what());
+	}
+
+	resource_cache.set_pipeline_cache(VK_NULL_HANDLE);
+
+	vkDestroyPipelineCache(device->get_handle(), pipeline_cache, nullptr);
+
+	pipeline_cache = VK_NULL_HANDLE;
+}
+
+void VulkanSample::prepare_render_context()
+{
+	render_context->prepare(concurrent_subpass_recording ? CONCURRENT_RECORDING_THREAD_COUNT : 1);
+}
+
+void VulkanSample::update_scene(float delta_time)
+{
+	VKB_PROFILE_SCOPE("VulkanSample::update_scene");
+
+	update_pre_rotation();
+
+	if (scene)
+	{
+		//Update scripts
+		if (scene->has_component<sg::Script>())
+		{
+			auto scripts = scene->get_components<sg::Script>();
+
+			std::vector<sg::Script *> parallel_scripts;
+
+			for (auto script : scripts)
+			{
+				if (script->is_parallel_safe())
+				{
+					parallel_scripts.push_back(script);
+				}
+				else
+				{
+					script->update(delta_time);
+				}
+			}
+
+			if (!parallel_scripts.empty())
+			{
+				// The parallel scripts read the world matrices of the ancestors of their subtree, which must not be resolved concurrently
+				scene->update_transforms();
+
+				auto groups = group_scripts_by_subtree(parallel_scripts);
+
+				auto &job_system = device->get_job_system();
+
+				job_system.run_parallel(JobPriority::Frame, groups.size(), job_system.get_thread_count() + 1, [&groups, delta_time](size_t group, size_t) {
+					for (auto script : groups[group])
+					{
+						script->update(delta_time);
+					}
+				});
+			}
+		}
+
+		// Scripts moved the nodes, the world matrices are resolved once before recording the frame
+		scene->update_transforms();
+	}
+}
+
+void VulkanSample::update_stats(float delta_time)
+{
+	update_memory_budget(delta_time);
+
+	if (thermal_governor)
+	{
+		thermal_governor->update(delta_time);
+
+		const auto &thermal_state = thermal_governor->get_thermal_state();
+
+		if (stats && !std::isnan(thermal_state.headroom))
+		{
+			stats->set_value(StatIndex::thermal_headroom, thermal_state.headroom);
+		}
+
+		if (stats && !std::isnan(thermal_state.temperature))
+		{
+			stats->set_value(StatIndex::temperature, thermal_state.temperature);
+		}
+	}
+
+	if (stats)
+	{
+		auto &resource_cache = device->get_resource_cache();
+
+		uint64_t misses      = 0;
+		uint64_t contentions = 0;
+		for (size_t i = 0; i < static_cast<size_t>(ResourceCacheType::Count); ++i)
+		{
+			auto type_stats = resource_cache.get_stats(static_cast<ResourceCacheType>(i));
+
+			misses += type_stats.misses;
+			contentions += type_stats.contentions;
+		}
+
+		stats->set_value(StatIndex::resource_cache_misses, static_cast<float>(misses - resource_cache_misses));
+		stats->set_value(StatIndex::resource_cache_contentions, static_cast<float>(contentions - resource_cache_contentions));
+		stats->set_value(StatIndex::cached_graphics_pipelines, static_cast<float>(resource_cache.get_stats(ResourceCacheType::GraphicsPipeline).count));
+
+		resource_cache_misses      = misses;
+		resource_cache_contentions = contentions;
+
+		// Binds recorded since the previous update, which covers the command buffers of the last frame
+		auto binds = device->get_command_buffer_counters();
+
+		stats->set_value(StatIndex::pipeline_binds, static_cast<float>(binds.pipeline_binds - command_buffer_counters.pipeline_binds));
+		stats->set_value(StatIndex::descriptor_set_binds, static_cast<float>(binds.descriptor_set_binds - command_buffer_counters.descriptor_set_binds));
+		stats->set_value(StatIndex::vertex_buffer_binds, static_cast<float>(binds.vertex_buffer_binds - command_buffer_counters.vertex_buffer_binds));
+		stats->set_value(StatIndex::draw_calls, static_cast<float>(binds.draw_calls - command_buffer_counters.draw_calls));
+
+		// Estimated from the load and store operations, per second to compare with the external memory counters
+		if (delta_time > 0.0f)
+		{
+			stats->set_value(StatIndex::attachment_read_bytes, (binds.attachment_read_bytes - command_buffer_counters.attachment_read_bytes) / delta_time);
+			stats->set_value(StatIndex::attachment_write_bytes, (binds.attachment_write_bytes - command_buffer_counters.attachment_write_bytes) / delta_time);
+		}
+
+		command_buffer_counters = binds;
+
+		auto allocations = device->get_descriptor_set_allocations();
+		auto uploaded    = device->get_uploaded_bytes();
+
+		stats->set_value(StatIndex::descriptor_set_allocations, static_cast<float>(allocations - descriptor_set_allocations));
+		stats->set_value(StatIndex::uploaded_bytes, static_cast<float>(uploaded - uploaded_bytes));
+
+		descriptor_set_allocations = allocations;
+		uploaded_bytes             = uploaded;
+
+		if (render_context && !render_context->get_render_frames().empty())
+		{
+			// Bytes written per pixel by the attachments of the render targets, the main factor of their bandwidth
+			uint32_t bits_per_pixel = 0;
+
+			for (auto &attachment : render_context->get_render_frames().front().get_render_target().get_attachments())
+			{
+				bits_per_pixel += to_u32(std::max(get_bits_per_pixel(attachment.format), 0)) * attachment.samples;
+			}
+
+			stats->set_value(StatIndex::render_target_bytes_per_pixel, bits_per_pixel / 8.0f);
+
+			// Each block is a buffer the descriptor sets of the frames are written with
+			size_t       buffer_block_count     = 0;
+			VkDeviceSize buffer_high_water_mark = 0;
+
+			for (auto &frame : render_context->get_render_frames())
+			{
+				buffer_block_count += frame.get_buffer_block_count();
+				buffer_high_water_mark = std::max(buffer_high_water_mark, frame.get_buffer_high_water_mark());
+			}
+
+			stats->set_value(StatIndex::buffer_pool_blocks, static_cast<float>(buffer_block_count));
+			stats->set_value(StatIndex::buffer_pool_high_water, static_cast<float>(buffer_high_water_mark));
+		}
+
+		stats->update();
+
+		// Show the counter samples in the CPU trace, where they line up with the scopes of the frame
+		auto &profiler = CpuProfiler::get();
+		if (profiler.is_enabled())
+		{
+			for (auto index : stats->get_enabled_stats())
+			{
+				const auto &samples = stats->get_samples(index);
+				if (samples.empty())
+				{
+					continue;
+				}
+
+				std::string stat_name = "Stat " + to_string(static_cast<int>(index));
+				if (gui)
+				{
+					auto &graph_map = gui->get_stats_view().graph_map;
+					auto  graph     = graph_map.find(index);
+
+					if (graph != graph_map.end())
+					{
+						stat_name = graph->second.name;
+					}
+				}
+
+				for (const auto &sample : samples)
+				{
+					profiler.record_counter(stat_name, sample.timestamp, sample.value);
+				}
+			}
+		}
+
+		static float stats_view_count = 0.0f;
+		stats_view_count += delta_time;
+
+		// Reset every STATS_VIEW_RESET_TIME seconds
+		if (stats_view_count > STATS_VIEW_RESET_TIME)
+		{
+			reset_stats_view();
+			stats_view_count = 0.0f;
+		}
+	}
+}
+
+void VulkanSample::enable_performance_queries()
+{
+	std::set<StatIndex> unavailable;
+	if (stats && device->is_performance_query_enabled())
+	{
+		for (auto index : stats->get_enabled_stats())
+		{
+			if (!stats->is_available(index))
+			{
+				unavailable.insert(index);
+			}
+		}
+	}
+
+	auto &frames = render_context->get_render_frames();
+
+	// The query pools of the frames still in flight are replaced
+	if (std::any_of(frames.begin(), frames.end(), [](RenderFrame &frame) { return frame.get_performance_query_profiler().is_enabled(); }))
+	{
+		device->wait_idle();
+	}
+
+	// Every frame selects the same counters, which the stats then take from the profiler of the frame rendered
+	std::set<StatIndex> measured;
+	for (auto &frame : frames)
+	{
+		measured = frame.get_performance_query_profiler().enable(unavailable);
+	}
+
+	for (auto index : measured)
+	{
+		stats->replace_gpu_counter(index);
+	}
+}
+
+void VulkanSample::update_queue_activity()
+{
+	auto &profiler = CpuProfiler::get();
+
+	bool show_stats = stats && (stats->get_enabled_stats().count(StatIndex::gpu_busy) ||
+	                            stats->get_enabled_stats().count(StatIndex::gpu_idle_time) ||
+	                            stats->get_enabled_stats().count(StatIndex::compute_queue_busy) ||
+	                            stats->get_enabled_stats().count(StatIndex::gpu_starved));
+
+	render_context->set_submission_profiling_enabled(show_stats || profiler.is_enabled());
+
+	const auto &submissions = render_context->get_active_frame().get_submission_profiler().get_submissions();
+	if (submissions.empty())
+	{
+		return;
+	}
+
+	const auto &activities = queue_activity.update(submissions);
+
+	if (show_stats)
+	{
+		auto graphics = activities.find(&render_context->get_queue());
+		if (graphics != activities.end())
+		{
+			stats->set_value(StatIndex::gpu_busy, graphics->second.get_busy_fraction());
+			stats->set_value(StatIndex::gpu_idle_time, graphics->second.idle_time);
+			stats->set_value(StatIndex::gpu_starved, graphics->second.starved ? 1.0f : 0.0f);
+		}
+
+		auto compute = activities.find(&render_context->get_compute_queue());
+		if (render_context->has_async_compute() && compute != activities.end())
+		{
+			stats->set_value(StatIndex::compute_queue_busy, compute->second.get_busy_fraction());
+		}
+	}
+
+	// Every queue is shown in the trace, where the starved frames line up with the CPU scopes delaying them
+	if (profiler.is_enabled())
+	{
+		auto now = CpuProfiler::Clock::now();
+
+		for (auto &activity : activities)
+		{
+			std::string queue_name = "Queue " + to_string(activity.first->get_family_index()) + "." + to_string(activity.first->get_index());
+
+			profiler.record_counter(queue_name + " busy", now, activity.second.get_busy_fraction());
+			profiler.record_counter(queue_name + " starved", now, activity.second.starved ? 1.0 : 0.0);
+		}
+	}
+}
+
+void VulkanSample::update_memory_budget(float delta_time)
+{
+	// Without VK_EXT_memory_budget the usage is computed by walking the VMA blocks, so it is not queried every frame
+	memory_budget_check_count += delta_time;
+	if (memory_budget_check_count < MEMORY_BUDGET_CHECK_TIME)
+	{
+		return;
+	}
+	memory_budget_check_count = 0.0f;
+
+	VkDeviceSize device_usage  = 0;
+	VkDeviceSize device_budget = 0;
+	bool         above_warning = false;
+
+	auto heaps = device->get_memory_budget();
+	for (size_t i = 0; i < heaps.size(); ++i)
+	{
+		auto &heap = heaps[i];
+		if (heap.device_local)
+		{
+			device_usage += heap.usage;
+			device_budget += heap.budget;
+		}
+
+		if (heap.budget > 0 && heap.usage > heap.budget * MEMORY_BUDGET_WARNING_RATIO)
+		{
+			if (!memory_budget_warning)
+			{
+				LOGW("Memory heap {} is close to its budget: {} of {} MiB used", i, heap.usage >> 20, heap.budget >> 20);
+			}
+			above_warning = true;
+		}
+	}
+	memory_budget_warning = above_warning;
+
+	if (stats)
+	{
+		stats->set_value(StatIndex::device_memory_usage, static_cast<float>(device_usage));
+		stats->set_value(StatIndex::device_memory_budget, static_cast<float>(device_budget));
+		stats->set_value(StatIndex::memory_buffer_pools, static_cast<float>(device->get_memory_usage(MemoryCategory::BufferPools)));
+		stats->set_value(StatIndex::memory_textures, static_cast<float>(device->get_memory_usage(MemoryCategory::Textures)));
+		stats->set_value(StatIndex::memory_geometry, static_cast<float>(device->get_memory_usage(MemoryCategory::Geometry)));
+		stats->set_value(StatIndex::memory_render_targets, static_cast<float>(device->get_memory_usage(MemoryCategory::RenderTargets)));
+		stats->set_value(StatIndex::memory_staging, static_cast<float>(device->get_memory_usage(MemoryCategory::Staging)));
+	}
+}
+
+void VulkanSample::update_gui(float delta_time)
+{
+	if (gui)
+	{
+		// The cached overlay is only rebuilt at its refresh rate
+		if (!gui->advance_overlay(delta_time))
+		{
+			return;
+		}
+
+		if (gui->is_debug_view_active())
+		{
+			update_debug_window();
+		}
+
+		gui->new_frame();
+
+		gui->show_top_window(get_name(), stats.get(), &get_debug_info());
 
 		// Samples can override this
 		draw_gui();
 
-		gui->update(delta_time);
+		gui->update(delta_time);
+	}
+}
+
+void VulkanSample::update(float delta_time)
+{
+	VKB_PROFILE_SCOPE("VulkanSample::update");
+
+	bool first_frame = !startup_timeline.is_finished();
+	auto frame_begin = StartupTimeline::Clock::now();
+
+	if (shader_reloader)
+	{
+		// Between frames, so no command buffer is being recorded with the modules swapped in
+		shader_reloader->update(*render_context);
+	}
+
+	attach_camera_path();
+
+#if defined(VKB_DEBUG)
+	report_barrier_summary();
+#endif
+
+	if (low_latency_enabled)
+	{
+		// Wait for the previous frame first, so that the scene is updated with the latest input
+		auto &command_buffer = render_context->begin();
+
+		update_scene(delta_time);
+
+		update_stats(delta_time);
+
+		update_gui(delta_time);
+
+		record_and_submit(command_buffer);
+	}
+	else
+	{
+		update_scene(delta_time);
+
+		update_stats(delta_time);
+
+		update_gui(delta_time);
+
+		if (render_context->is_incremental_rendering_enabled())
+		{
+			update_damage();
+
+			// Every image shows the current frame already
+			if (!render_context->has_damage())
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(16));
+				return;
+			}
+		}
+
+		record_and_submit(render_context->begin());
+	}
+
+	if (first_frame)
+	{
+		// The rest of the prepare() of the sample, e.g. its scene and GUI which are recorded as stages of their own
+		startup_timeline.record("Sample prepare", framework_prepare_end, frame_begin);
+
+		// Includes the pipelines created on first use
+		startup_timeline.record("First frame", frame_begin, StartupTimeline::Clock::now());
+
+		if (stats)
+		{
+			StartupTimeline::Clock::time_point begin, end;
+			stats->get_setup_time(begin, end);
+			startup_timeline.record("Counter profiler", begin, end);
+		}
+
+		startup_timeline.finish();
+	}
+}
+
+void VulkanSample::update_pre_rotation()
+{
+	if (!scene || !render_context->has_swapchain() || !scene->has_component<sg::Camera>())
+	{
+		return;
+	}
+
+	auto &swapchain = render_context->get_swapchain();
+	auto  transform = swapchain.get_transform();
+
+	// Without rotation the cameras are left as the scripts set them, unless the rotation just stopped
+	if (transform == VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR && applied_pre_transform == transform)
+	{
+		return;
+	}
+
+	applied_pre_transform = transform;
+
+	auto pre_rotation = render_context->get_pre_rotation();
+
+	// The window is resized to the rotated extent, while the swapchain images keep the native orientation
+	VkExtent2D extent = swapchain.get_extent();
+
+	for (auto camera : scene->get_components<sg::Camera>())
+	{
+		camera->set_pre_rotation(pre_rotation);
+
+		if (auto perspective_camera = dynamic_cast<sg::PerspectiveCamera *>(camera))
+		{
+			perspective_camera->set_aspect_ratio(static_cast<float>(extent.width) / extent.height);
+		}
+	}
+}
+
+void VulkanSample::record_and_submit(CommandBuffer &command_buffer)
+{
+	auto &gpu_profiler = render_context->get_active_frame().get_gpu_profiler();
+
+	// Samples create their stats once prepared
+	if (stats.get() != performance_query_stats)
+	{
+		performance_query_stats = stats.get();
+		enable_performance_queries();
+	}
+
+	auto &performance_query_profiler = render_context->get_active_frame().get_performance_query_profiler();
+
+	// The times of the last use of the frame are available now that it has been reset
+	if (stats)
+	{
+		for (auto &time : gpu_profiler.get_times())
+		{
+			stats->set_value(time.first, time.second);
+		}
+
+		for (auto &count : gpu_profiler.get_statistics())
+		{
+			stats->set_value(count.first, count.second);
+		}
+
+		for (auto &value : performance_query_profiler.get_values())
+		{
+			stats->set_value(value.first, value.second);
+		}
+	}
+
+	update_queue_activity();
+
+	if (dynamic_resolution_enabled)
+	{
+		update_dynamic_resolution();
+	}
+
+	// The query counting the frame must be the first command of its command buffer, so it is reset by another one
+	CommandBuffer *reset_command_buffer = nullptr;
+	if (performance_query_profiler.is_enabled())
+	{
+		reset_command_buffer = &render_context->get_active_frame().request_command_buffer(render_context->get_queue());
+		reset_command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+		performance_query_profiler.reset(*reset_command_buffer);
+		reset_command_buffer->end();
+	}
+
+	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+	performance_query_profiler.begin_frame(command_buffer);
+
+	// Patch in the images streamed since the last frame
+	if (scene_loader && !scene_loader->update_streaming(command_buffer))
+	{
+		scene_loader.reset();
+	}
+
+	// Apply the mip levels requested by the previous frame
+	if (texture_streamer)
+	{
+		texture_streamer->update(command_buffer);
+	}
+
+	// Images still being streamed by the loader are not uploaded yet
+	if (memory_defragmenter && !scene_loader)
+	{
+		memory_defragmenter->update(command_buffer, *scene);
+	}
+
+	gpu_profiler.begin_frame(command_buffer);
+
+	std::unique_ptr<DrawListRecord> draw_list_record;
+
+	if (!draw_list_capture_file.empty() && draw_list_capture_countdown-- == 0)
+	{
+		draw_list_record = std::make_unique<DrawListRecord>(device->get_resource_cache());
+		command_buffer.set_draw_list_record(draw_list_record.get());
 	}
-}
 
-void VulkanSample::update(float delta_time)
-{
-	update_scene(delta_time);
+	draw(command_buffer, render_context->get_active_frame().get_render_target());
 
-	update_stats(delta_time);
+	if (draw_list_record)
+	{
+		command_buffer.set_draw_list_record(nullptr);
 
-	update_gui(delta_time);
+		fs::write_temp(draw_list_record->get_data(), draw_list_capture_file);
 
-	auto &command_buffer = render_context->begin();
+		LOGI("Captured {} commands to the draw list {}", draw_list_record->get_command_count(), draw_list_capture_file);
 
-	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+		draw_list_capture_file.clear();
+	}
 
-	draw(command_buffer, render_context->get_active_frame().get_render_target());
+	gpu_profiler.end_frame(command_buffer);
+
+	performance_query_profiler.end_frame(command_buffer);
 
 	command_buffer.end();
 
-	render_context->submit(command_buffer);
+	if (reset_command_buffer)
+	{
+		render_context->submit({reset_command_buffer, &command_buffer});
+	}
+	else
+	{
+		render_context->submit(command_buffer);
+	}
+
+	if (input_pending)
+	{
+		if (stats)
+		{
+			float latency = std::chrono::duration<float>(std::chrono::steady_clock::now() - input_time).count();
+			stats->set_value(StatIndex::input_latency, latency);
+		}
+
+		input_pending = false;
+	}
 }
 
 void VulkanSample::draw(CommandBuffer &command_buffer, RenderTarget &render_target)
 {
+	if (render_graph)
+	{
+		draw_render_graph(command_buffer, render_target);
+		return;
+	}
+
 	auto &views = render_target.get_views();
 
 	{
-		// Image 0 is the swapchain
+		// Image 0 is the swapchain, whose contents outside of a partial render area are kept from its last frame
 		ImageMemoryBarrier memory_barrier{};
-		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		memory_barrier.old_layout      = render_target.is_partial_render_area() ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_UNDEFINED;
 		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 		memory_barrier.src_access_mask = 0;
 		memory_barrier.dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
@@ -193,6 +1454,10 @@ void VulkanSample::draw(CommandBuffer &command_buffer, RenderTarget &render_targ
 
 		command_buffer.image_memory_barrier(views.at(0), memory_barrier);
 
+		// Other attachments may alias the memory of the previous frames, wait for their writes and input reads
+		memory_barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
 		// Skip 1 as it is handled later as a depth-stencil attachment
 		for (size_t i = 2; i < views.size(); ++i)
 		{
@@ -201,19 +1466,32 @@ void VulkanSample::draw(CommandBuffer &command_buffer, RenderTarget &render_targ
 	}
 
 	{
+		// The depth attachment may alias the memory of the previous frames
 		ImageMemoryBarrier memory_barrier{};
 		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
 		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-		memory_barrier.src_access_mask = 0;
+		memory_barrier.src_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 		memory_barrier.dst_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
 		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
 
 		command_buffer.image_memory_barrier(views.at(1), memory_barrier);
 	}
 
+	if (gui)
+	{
+		gui->update_overlay_cache(command_buffer);
+	}
+
 	draw_renderpass(command_buffer, render_target);
 
+	auto &render_frame = render_context->get_active_frame();
+
+	if (render_frame.has_present_render_target())
+	{
+		draw_upscale(command_buffer, render_target, render_frame.get_present_render_target());
+	}
+
 	{
 		ImageMemoryBarrier memory_barrier{};
 		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
@@ -222,10 +1500,223 @@ void VulkanSample::draw(CommandBuffer &command_buffer, RenderTarget &render_targ
 		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
 
-		command_buffer.image_memory_barrier(views.at(0), memory_barrier);
+		command_buffer.image_memory_barrier(render_frame.get_present_render_target().get_views().at(0), memory_barrier);
+	}
+}
+
+void VulkanSample::draw_render_graph(CommandBuffer &command_buffer, RenderTarget &render_target)
+{
+	if (gui)
+	{
+		gui->update_overlay_cache(command_buffer);
+	}
+
+	auto &gpu_profiler = render_context->get_active_frame().get_gpu_profiler();
+
+	gpu_profiler.begin_scope(command_buffer, StatIndex::gpu_render_pass_time);
+
+	render_graph->set_concurrent_recording(concurrent_subpass_recording);
+
+	render_graph->execute(command_buffer, render_target, [this, &render_target](CommandBuffer &command_buffer) {
+		if (!gui)
+		{
+			return;
+		}
+
+		// Concurrent subpasses leave the last subpass accepting secondary command buffers only
+		if (render_graph->is_concurrent_recording())
+		{
+			draw_gui_secondary(command_buffer, render_target.get_extent());
+		}
+		else
+		{
+			gui->draw(command_buffer);
+		}
+	});
+
+	gpu_profiler.end_scope(command_buffer, StatIndex::gpu_render_pass_time);
+}
+
+void VulkanSample::draw_gui_secondary(CommandBuffer &command_buffer, const VkExtent2D &extent)
+{
+	const auto &queue = device->get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+
+	auto &secondary_command_buffer = render_context->get_active_frame().request_command_buffer(queue, CommandBuffer::ResetMode::ResetPool, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+	secondary_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &command_buffer);
+
+	// Dynamic state is not inherited from the primary command buffer
+	VkViewport viewport{};
+	viewport.width    = static_cast<float>(extent.width);
+	viewport.height   = static_cast<float>(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	secondary_command_buffer.set_viewport(0, {viewport});
+
+	VkRect2D scissor{};
+	scissor.extent = extent;
+	secondary_command_buffer.set_scissor(0, {scissor});
+
+	gui->draw(secondary_command_buffer);
+
+	secondary_command_buffer.end();
+
+	command_buffer.execute_commands(secondary_command_buffer);
+}
+
+void VulkanSample::draw_upscale(CommandBuffer &command_buffer, RenderTarget &render_target, RenderTarget &present_render_target)
+{
+	{
+		// The scaled image is sampled by the upscale pass
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+		command_buffer.image_memory_barrier(render_target.get_views().at(0), memory_barrier);
+	}
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		memory_barrier.src_access_mask = 0;
+		memory_barrier.dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+		command_buffer.image_memory_barrier(present_render_target.get_views().at(0), memory_barrier);
+	}
+
+	if (upscale_subpasses.empty())
+	{
+		upscale_subpasses.push_back(std::make_unique<UpscaleSubpass>(*render_context, ShaderSource{"upscale.vert"}, ShaderSource{"upscale.frag"}));
+		upscale_subpasses.back()->prepare();
+	}
+
+	auto &extent = present_render_target.get_extent();
+
+	VkViewport viewport{};
+	viewport.width    = static_cast<float>(extent.width);
+	viewport.height   = static_cast<float>(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	command_buffer.set_viewport(0, {viewport});
+
+	VkRect2D scissor{};
+	scissor.extent = extent;
+	command_buffer.set_scissor(0, {scissor});
+
+	// Every pixel is overwritten by the upscale
+	std::vector<LoadStoreInfo> load_store(1);
+	load_store[0].load_op  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	load_store[0].store_op = VK_ATTACHMENT_STORE_OP_STORE;
+
+	std::vector<VkClearValue> clear_value(1);
+	clear_value[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+
+	command_buffer.begin_debug_label("Upscale");
+
+	command_buffer.begin_render_pass(present_render_target, load_store, clear_value, upscale_subpasses);
+
+	upscale_subpasses[0]->draw(command_buffer);
+
+	if (gui)
+	{
+		gui->draw(command_buffer);
+	}
+
+	command_buffer.end_render_pass();
+
+	command_buffer.end_debug_label();
+}
+
+void VulkanSample::update_dynamic_resolution()
+{
+	const auto &times = render_context->get_active_frame().get_gpu_profiler().get_times();
+
+	auto frame_time = times.find(StatIndex::gpu_frame_time);
+
+	// Without timestamps the scale stays at its initial value
+	bool changed = frame_time != times.end() && dynamic_resolution.update(frame_time->second);
+
+	if (changed || render_context->get_render_scale() == 0.0f)
+	{
+		render_context->set_render_scale(dynamic_resolution.get_scale());
+	}
+
+	if (stats)
+	{
+		stats->set_value(StatIndex::render_scale, dynamic_resolution.get_scale());
+	}
+}
+
+void VulkanSample::set_dynamic_resolution_enabled(bool enabled)
+{
+	dynamic_resolution_enabled = enabled;
+
+	// Enabling it is deferred to the next frame, as the render context may not be prepared yet
+	if (!enabled && render_context)
+	{
+		render_context->set_render_scale(0.0f);
 	}
 }
 
+DynamicResolution &VulkanSample::get_dynamic_resolution()
+{
+	return dynamic_resolution;
+}
+
+ThermalGovernor &VulkanSample::get_thermal_governor()
+{
+	assert(thermal_governor && "Thermal governor is created in prepare");
+	return *thermal_governor;
+}
+
+void VulkanSample::add_default_thermal_policies()
+{
+	auto &governor = get_thermal_governor();
+
+	// State changed by the policies, restored when they are reverted
+	struct SavedState
+	{
+		bool  dynamic_resolution_enabled{false};
+		float max_scale{1.0f};
+		float target_frame_time{0.0f};
+	};
+	auto saved = std::make_shared<SavedState>();
+
+	governor.add_policy(
+	    "lower render scale", 0.75f,
+	    [this, saved]() {
+		    saved->dynamic_resolution_enabled = dynamic_resolution_enabled;
+		    saved->max_scale                  = dynamic_resolution.get_max_scale();
+
+		    float max_scale = std::max(dynamic_resolution.get_min_scale(), std::min(saved->max_scale, 0.75f));
+		    dynamic_resolution.set_bounds(dynamic_resolution.get_min_scale(), max_scale);
+		    set_dynamic_resolution_enabled(true);
+	    },
+	    [this, saved]() {
+		    dynamic_resolution.set_bounds(dynamic_resolution.get_min_scale(), saved->max_scale);
+		    set_dynamic_resolution_enabled(saved->dynamic_resolution_enabled);
+	    });
+
+	governor.add_policy(
+	    "cap frame rate to 30 fps", 0.9f,
+	    [this, saved]() {
+		    auto &frame_pacer        = render_context->get_frame_pacer();
+		    saved->target_frame_time = frame_pacer.get_target_frame_time();
+
+		    frame_pacer.set_target_frame_time(std::max(saved->target_frame_time, 1.0f / 30.0f));
+	    },
+	    [this, saved]() {
+		    render_context->get_frame_pacer().set_target_frame_time(saved->target_frame_time);
+	    });
+}
+
 void VulkanSample::draw_renderpass(CommandBuffer &command_buffer, RenderTarget &render_target)
 {
 	auto &extent = render_target.get_extent();
@@ -241,14 +1732,34 @@ void VulkanSample::draw_renderpass(CommandBuffer &command_buffer, RenderTarget &
 	scissor.extent = extent;
 	command_buffer.set_scissor(0, {scissor});
 
+	auto &gpu_profiler = render_context->get_active_frame().get_gpu_profiler();
+
+	gpu_profiler.begin_scope(command_buffer, StatIndex::gpu_render_pass_time);
+
+	if (render_pipeline && concurrent_subpass_recording)
+	{
+		render_pipeline->set_concurrent_recording(true);
+	}
+
 	render(command_buffer);
 
-	if (gui)
+	// When rendering at a scaled resolution, the gui is drawn at native resolution by the upscale pass
+	if (gui && !render_context->get_active_frame().has_present_render_target())
 	{
-		gui->draw(command_buffer);
+		// The gui is drawn in the last subpass, which may only accept secondary command buffers
+		if (render_pipeline && (render_pipeline->is_concurrent_recording() || render_pipeline->get_subpasses().back()->get_contents() == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS))
+		{
+			draw_gui_secondary(command_buffer, extent);
+		}
+		else
+		{
+			gui->draw(command_buffer);
+		}
 	}
 
 	command_buffer.end_render_pass();
+
+	gpu_profiler.end_scope(command_buffer, StatIndex::gpu_render_pass_time);
 }
 
 void VulkanSample::render(CommandBuffer &command_buffer)
@@ -259,6 +1770,40 @@ void VulkanSample::render(CommandBuffer &command_buffer)
 	}
 }
 
+void VulkanSample::set_frame_deadline(std::chrono::steady_clock::time_point deadline)
+{
+	if (render_context)
+	{
+		render_context->get_frame_pacer().set_frame_deadline(deadline);
+	}
+}
+
+FrameWorkload VulkanSample::get_frame_workload()
+{
+	FrameWorkload workload;
+
+	if (render_context)
+	{
+		auto &frame_pacer = render_context->get_frame_pacer();
+
+		// Unpaced frames are still expected once per refresh cycle
+		workload.target_time = frame_pacer.get_paced_frame_time();
+		if (workload.target_time <= 0.0f)
+		{
+			workload.target_time = frame_pacer.get_refresh_duration();
+		}
+
+		workload.work_time = frame_pacer.get_work_time();
+	}
+
+	if (device)
+	{
+		workload.thread_ids = device->get_job_system().get_frame_thread_ids();
+	}
+
+	return workload;
+}
+
 void VulkanSample::resize(uint32_t width, uint32_t height)
 {
 	Application::resize(width, height);
@@ -288,11 +1833,25 @@ void VulkanSample::input_event(const InputEvent &input_event)
 {
 	Application::input_event(input_event);
 
+	if (!input_pending)
+	{
+		input_pending = true;
+		input_time    = std::chrono::steady_clock::now();
+	}
+
 	bool gui_captures_event = false;
 
 	if (gui)
 	{
 		gui_captures_event = gui->input_event(input_event);
+
+		if (gui_captures_event)
+		{
+			bool mouse_move = input_event.get_source() == EventSource::Mouse &&
+			                  static_cast<const MouseButtonInputEvent &>(input_event).get_action() == MouseAction::Move;
+
+			gui_input_damage = gui_input_damage || !mouse_move;
+		}
 	}
 
 	if (!gui_captures_event)
@@ -318,7 +1877,7 @@ void VulkanSample::input_event(const InputEvent &input_event)
 
 		if (key_event.get_code() == KeyCode::F6 && key_event.get_action() == KeyAction::Down)
 		{
-			utils::debug_graphs(get_render_context(), *scene.get());
+			save_debug_graphs();
 		}
 	}
 }
@@ -326,6 +1885,13 @@ void VulkanSample::input_event(const InputEvent &input_event)
 void VulkanSample::finish()
 {
 	Application::finish();
+
+	if (render_context)
+	{
+		// Frames still in flight are handed to the readback callback, if any
+		render_context->flush_readback();
+	}
+
 	device->wait_idle();
 }
 
@@ -360,6 +1926,55 @@ void VulkanSample::update_debug_window()
 
 	get_debug_info().insert<field::Static, uint32_t>("texture_count", to_u32(scene->get_components<sg::Texture>().size()));
 
+	auto heaps = device->get_memory_budget();
+	for (size_t i = 0; i < heaps.size(); ++i)
+	{
+		get_debug_info().insert<field::Static, std::string>("memory_heap_" + to_string(i),
+		                                                    fmt::format("{} / {} MiB{}", heaps[i].usage >> 20, heaps[i].budget >> 20,
+		                                                                heaps[i].device_local ? " (device local)" : ""));
+	}
+
+	const std::vector<std::pair<const char *, MemoryCategory>> memory_categories{{"memory_buffer_pools", MemoryCategory::BufferPools},
+	                                                                              {"memory_textures", MemoryCategory::Textures},
+	                                                                              {"memory_geometry", MemoryCategory::Geometry},
+	                                                                              {"memory_render_targets", MemoryCategory::RenderTargets},
+	                                                                              {"memory_staging", MemoryCategory::Staging}};
+
+	for (auto &category : memory_categories)
+	{
+		get_debug_info().insert<field::Static, std::string>(category.first, fmt::format("{:.1f} MiB", device->get_memory_usage(category.second) / (1024.0f * 1024.0f)));
+	}
+
+	// Images release their host copy once uploaded, unless the loader was asked to keep it
+	size_t resident_image_data = 0;
+
+	for (auto image : scene->get_components<sg::Image>())
+	{
+		resident_image_data += image->get_data().size();
+	}
+
+	get_debug_info().insert<field::Static, std::string>("memory_resident_image_data", fmt::format("{:.1f} MiB", resident_image_data / (1024.0f * 1024.0f)));
+
+	const std::vector<std::pair<const char *, ResourceCacheType>> cache_types{{"cache_shader_modules", ResourceCacheType::ShaderModule},
+	                                                                          {"cache_pipeline_layouts", ResourceCacheType::PipelineLayout},
+	                                                                          {"cache_descriptor_set_layouts", ResourceCacheType::DescriptorSetLayout},
+	                                                                          {"cache_render_passes", ResourceCacheType::RenderPass},
+	                                                                          {"cache_graphics_pipelines", ResourceCacheType::GraphicsPipeline},
+	                                                                          {"cache_compute_pipelines", ResourceCacheType::ComputePipeline},
+	                                                                          {"cache_framebuffers", ResourceCacheType::Framebuffer},
+	                                                                          {"cache_samplers", ResourceCacheType::Sampler}};
+
+	for (auto &cache_type : cache_types)
+	{
+		auto  cache_stats = device->get_resource_cache().get_stats(cache_type.second);
+		auto &histogram   = cache_stats.creation_time_histogram;
+
+		get_debug_info().insert<field::Static, std::string>(cache_type.first,
+		                                                    fmt::format("{} cached, {} hits, {} misses, {} evicted, created in <0.1/1/10/100/+ ms: {}/{}/{}/{}/{}",
+		                                                                cache_stats.count, cache_stats.hits, cache_stats.misses, cache_stats.evictions,
+		                                                                histogram[0], histogram[1], histogram[2], histogram[3], histogram[4]));
+	}
+
 	if (auto camera = scene->get_components<vkb::sg::Camera>().at(0))
 	{
 		if (auto camera_node = camera->get_node())
@@ -370,17 +1985,86 @@ void VulkanSample::update_debug_window()
 	}
 }
 
+#if defined(VKB_DEBUG)
+void VulkanSample::report_barrier_summary()
+{
+	auto counters = device->get_command_buffer_counters();
+
+	uint64_t early_destination = counters.early_destination_barriers - barrier_counters.early_destination_barriers;
+	uint64_t late_source       = counters.late_source_barriers - barrier_counters.late_source_barriers;
+	uint64_t redundant         = counters.redundant_barriers - barrier_counters.redundant_barriers;
+
+	auto summary = fmt::format("{} barriers, {} with earlier destination stages than the uses after them, {} with later source stages than the uses before them, {} redundant",
+	                           counters.pipeline_barriers - barrier_counters.pipeline_barriers, early_destination, late_source, redundant);
+
+	// Most frames record the same barriers, so that the summary is only logged when it changes
+	if (early_destination + late_source + redundant > 0 && summary != barrier_summary)
+	{
+		LOGW("Barriers of the last frame: {}", summary);
+	}
+
+	barrier_counters = counters;
+	barrier_summary  = summary;
+}
+#endif
+
 void VulkanSample::load_scene(const std::string &path)
 {
-	GLTFLoader loader{*device};
+	scene_loader = std::make_unique<GLTFLoader>(*device);
+
+	scene_loader->set_progressive_loading(progressive_scene_loading);
+
+	scene_loader->set_scene_cache_enabled(scene_cache_enabled);
+
+	scene_loader->set_vertex_quantization(vertex_quantization);
+
+	scene_loader->set_lod_generation(lod_generation);
+
+	scene_loader->set_mesh_optimization(mesh_optimization);
 
-	scene = loader.read_scene_from_file(path);
+	scene_loader->set_meshlet_generation(meshlet_generation);
+
+	scene_loader->set_interleaved_vertices(interleaved_vertices);
+
+	scene_loader->set_primitive_merging(primitive_merging);
+
+	scene_loader->set_image_variant(image_variant);
+
+	{
+		StartupTimeline::Scope stage{startup_timeline, "Scene load"};
+		scene = scene_loader->read_scene_from_file(path);
+	}
+
+	if (!progressive_scene_loading)
+	{
+		scene_loader.reset();
+	}
 
 	if (!scene)
 	{
 		LOGE("Cannot load scene: {}", path.c_str());
 		throw std::runtime_error("Cannot load scene: " + path);
 	}
+
+	if (texture_array_batching && (progressive_scene_loading || texture_streaming_budget > 0))
+	{
+		LOGW("Texture array batching disabled, it is not compatible with progressive loading and texture streaming");
+	}
+	else if (texture_array_batching)
+	{
+		StartupTimeline::Scope stage{startup_timeline, "Texture array batching"};
+		TextureArrayBatcher{*device}.batch(*scene);
+	}
+
+	if (texture_streaming_budget > 0)
+	{
+		texture_streamer = std::make_unique<TextureStreamer>(*device, texture_streaming_budget, to_u32(render_context->get_render_frames().size()), texture_streaming_sparse_residency);
+	}
+
+	if (memory_defragmentation)
+	{
+		memory_defragmenter = std::make_unique<MemoryDefragmenter>(*device, to_u32(render_context->get_render_frames().size()));
+	}
 }
 
 VkSurfaceKHR VulkanSample::get_surface()
@@ -406,6 +2090,29 @@ RenderPipeline &VulkanSample::get_render_pipeline()
 	return *render_pipeline;
 }
 
+void VulkanSample::set_render_graph(std::unique_ptr<RenderGraph> &&rg)
+{
+	if (render_graph)
+	{
+		// The frames in flight may still use the resources of the passes of the replaced graph
+		device->wait_idle();
+	}
+
+	// The render targets are already created with the new graph, which is compiled
+	render_graph = std::move(rg);
+}
+
+RenderGraph &VulkanSample::get_render_graph()
+{
+	assert(render_graph && "Render graph was not created");
+	return *render_graph;
+}
+
+bool VulkanSample::save_debug_graphs()
+{
+	return utils::debug_graphs(get_render_context(), *scene, render_pipeline.get());
+}
+
 std::vector<const char *> VulkanSample::get_validation_layers()
 {
 	return {};
@@ -20,20 +20,51 @@
 
 #pragma once
 
+#include <chrono>
+
 #include "common/error.h"
 #include "common/utils.h"
 #include "common/vk_common.h"
 #include "gui.h"
 #include "platform/application.h"
+#include "rendering/damage_tracker.h"
+#include "rendering/dynamic_resolution.h"
 #include "rendering/render_context.h"
+#include "rendering/render_graph.h"
 #include "rendering/render_pipeline.h"
 #include "scene_graph/node.h"
 #include "scene_graph/scene.h"
+#include "scene_graph/scripts/camera_path.h"
 #include "scene_graph/scripts/node_animation.h"
+#include "startup_timeline.h"
 #include "stats.h"
+#include "thermal_governor.h"
 
 namespace vkb
 {
+class GLTFLoader;
+class MemoryDefragmenter;
+class ShaderReloader;
+class TextureStreamer;
+
+/**
+ * @brief The instance, surface and device handed from a sample to the next one, e.g. in batch mode,
+ *        so that the next sample neither recreates them nor the caches of the device
+ */
+struct DeviceContext
+{
+	~DeviceContext();
+
+	std::unique_ptr<Instance> instance;
+
+	VkSurfaceKHR surface{VK_NULL_HANDLE};
+
+	std::unique_ptr<Device> device;
+
+	/// Identifies the extensions, layers and mode the context was created for, a sample reuses it only if they match
+	std::string key;
+};
+
 /**
  * @mainpage Overview of the framework
  *
@@ -123,6 +154,16 @@ class VulkanSample : public Application
 
 	virtual void input_event(const InputEvent &input_event) override;
 
+	/**
+	 * @brief Passes the deadline to the frame pacer of the render context
+	 */
+	virtual void set_frame_deadline(std::chrono::steady_clock::time_point deadline) override;
+
+	/**
+	 * @brief Reports the paced frame time, the CPU time from acquire to present and the frame workers of the job system
+	 */
+	virtual FrameWorkload get_frame_workload() override;
+
 	virtual void finish() override;
 
 	/**
@@ -132,6 +173,122 @@ class VulkanSample : public Application
 	 */
 	void load_scene(const std::string &path);
 
+	/**
+	 * @brief Enables progressive scene loading: load_scene() returns once the geometry is loaded,
+	 *        and the images are streamed in over the next frames, textures sampling a placeholder
+	 *        until theirs is uploaded. It must be set before load_scene().
+	 */
+	void set_progressive_scene_loading(bool enabled);
+
+	/**
+	 * @brief Enables the scene cache: load_scene() loads a binary file cooked on the first load,
+	 *        as long as the assets of the scene do not change. It must be set before load_scene().
+	 */
+	void set_scene_cache_enabled(bool enabled);
+
+	/**
+	 * @brief Enables the quantization of the vertex attributes of the scene, reducing the vertex fetch bandwidth.
+	 *        It must be set before load_scene(), and the vertex shaders must handle HAS_OCTAHEDRAL_NORMAL.
+	 */
+	void set_vertex_quantization(bool enabled);
+
+	/**
+	 * @brief Enables the generation of levels of detail for the meshes of the scene, which the geometry
+	 *        subpasses select from the projected size of the nodes. It must be set before load_scene().
+	 */
+	void set_lod_generation(bool enabled);
+
+	/**
+	 * @brief Enables the optimization of the index and vertex order of the scene meshes for the vertex cache
+	 *        and overdraw. It must be set before load_scene().
+	 */
+	void set_mesh_optimization(bool enabled);
+
+	/**
+	 * @brief Enables splitting the meshes of the scene into meshlets, which GPU driven geometry subpasses
+	 *        cull against the frustum and by their normal cone. It must be set before load_scene().
+	 */
+	void set_meshlet_generation(bool enabled);
+
+	/**
+	 * @brief Enables a vertex layout with the positions in a stream of their own, for depth only passes,
+	 *        and the other attributes interleaved in a second stream. It must be set before load_scene().
+	 */
+	void set_interleaved_vertices(bool enabled);
+
+	/**
+	 * @brief Enables merging the triangle lists of each mesh that share a material into a single submesh,
+	 *        so that they are drawn at once. It must be set before load_scene().
+	 */
+	void set_primitive_merging(bool enabled);
+
+	/**
+	 * @brief Enables copying the small images of the scene with the same format and size into texture arrays,
+	 *        see TextureArrayBatcher. It must be set before load_scene(), and is ignored with progressive loading
+	 *        and texture streaming.
+	 */
+	void set_texture_array_batching(bool enabled);
+
+	/**
+	 * @brief Sets the directory next to the scene holding variants of its images in another format,
+	 *        e.g. compressed offline to ASTC or ETC2, see GLTFLoader::set_image_variant(). It must be set before load_scene().
+	 */
+	void set_image_variant(const std::string &variant);
+
+	/**
+	 * @brief Enables texture streaming: the mip levels of the scene images are kept resident
+	 *        within a memory budget, from the levels the subpasses request. It must be set before load_scene(),
+	 *        and the subpasses must be given get_texture_streamer() to request levels.
+	 * @param budget Memory in bytes the streamed images may use, 0 to disable streaming
+	 */
+	void set_texture_streaming_budget(VkDeviceSize budget);
+
+	/**
+	 * @brief Streams the textures as partially resident images when the device supports sparse residency,
+	 *        committing and decommitting their levels in place. It must be set before load_scene()
+	 */
+	void set_texture_streaming_sparse_residency(bool enabled);
+
+	/**
+	 * @return The texture streamer of the scene, or nullptr if texture streaming is disabled
+	 */
+	TextureStreamer *get_texture_streamer();
+
+	/**
+	 * @brief Enables the defragmentation of the memory of the scene images, for long running sessions
+	 *        where loading scenes and streaming textures fragment the memory blocks. It must be set before load_scene()
+	 */
+	void set_memory_defragmentation(bool enabled);
+
+	/**
+	 * @brief Recompiles the shaders edited in the shaders directory while the sample runs, rebuilding only
+	 *        the pipelines using them. It must be set before prepare(), and is ignored on Android
+	 */
+	void set_shader_hot_reload(bool enabled);
+
+	/**
+	 * @brief Selects the GPU the device is created on instead of the GPU with the highest score, if it is suitable.
+	 *        It must be set before prepare()
+	 * @param gpu The index of the physical device in the order they are enumerated, or a part of its name
+	 */
+	void set_preferred_gpu(const std::string &gpu);
+
+	/**
+	 * @brief Records the path of the free camera of the scene to a file in temporary storage, written when the sample
+	 *        is destroyed, or plays a recorded path back on it, e.g. for deterministic --benchmark runs
+	 * @param mode Whether to record or play back the path
+	 * @param filename The path file, relative to the temporary storage directory
+	 */
+	void set_camera_path(sg::CameraPath::Mode mode, const std::string &filename);
+
+	/**
+	 * @brief Captures the render passes, binds, state sets and draws of a frame into a draw list, written to
+	 *        a file in temporary storage, to be replayed by DrawListBenchmark
+	 * @param filename The draw list file, relative to the temporary storage directory
+	 * @param frame Number of frames rendered before the captured one, for the scene to be fully loaded
+	 */
+	void set_draw_list_capture(const std::string &filename, uint32_t frame);
+
 	VkSurfaceKHR get_surface();
 
 	Device &get_device();
@@ -142,10 +299,103 @@ class VulkanSample : public Application
 
 	RenderPipeline &get_render_pipeline();
 
+	/**
+	 * @brief Sets a compiled render graph, which draw() executes instead of the render pipeline
+	 *        It is kept until the render context is destroyed, as the render context creates its render targets with it.
+	 *        Rendering at a scaled resolution is not supported with a render graph.
+	 */
+	void set_render_graph(std::unique_ptr<RenderGraph> &&render_graph);
+
+	RenderGraph &get_render_graph();
+
+	/**
+	 * @brief Dumps the framework and scene graphs, with the cost of the scene nodes drawn by the render pipeline
+	 * @return Whether the graphs were written
+	 */
+	bool save_debug_graphs();
+
 	Configuration &get_configuration();
 
 	sg::Scene &get_scene();
 
+	/**
+	 * @brief Enables saving the pipeline cache and the resource cache to the temporary directory on shutdown,
+	 *        and loading them back in prepare() on the next run. Data written for another device or driver
+	 *        version is discarded. It must be set before prepare().
+	 */
+	void set_pipeline_cache_persistence(bool enabled);
+
+	/**
+	 * @brief Creates the device over the linked GPUs of the selected one, if any, and sets how they share
+	 *        the frames, see RenderContext::set_device_group_mode(). It must be set before prepare().
+	 */
+	void set_device_group_mode(DeviceGroupMode mode);
+
+	/**
+	 * @brief Shares the instance, surface and device with the samples run after this one. prepare() takes the
+	 *        context from the slot if it was created for the same extensions, otherwise creates its own, and the
+	 *        destructor puts the context back in the slot once the resources of the sample are destroyed.
+	 *        The resource cache keeps its shader modules, layouts, render passes and pipelines across samples.
+	 *        It must be set before prepare()
+	 * @param slot Holds the context between samples, it must outlive the sample
+	 */
+	void set_shared_device_context(std::unique_ptr<DeviceContext> &slot);
+
+	/**
+	 * @brief The stages of the start of the sample, logged and added to the benchmark report after its first frame
+	 */
+	StartupTimeline &get_startup_timeline();
+
+	/**
+	 * @brief Enables the low latency mode: a single frame is in flight, and input is applied to the scene
+	 *        just before recording a frame rather than before waiting for the previous one
+	 */
+	void set_low_latency_enabled(bool enabled);
+
+	/**
+	 * @brief Enables incremental rendering: each frame only renders and presents the region changed by the moved
+	 *        meshes and the gui, and no frame is rendered while nothing changed. Any change of the camera or
+	 *        of a light redraws the whole frame. It is ignored in low latency mode and with dynamic resolution.
+	 */
+	void set_incremental_rendering(bool enabled);
+
+	/**
+	 * @brief Records the subpasses of the render pipeline concurrently into secondary command buffers,
+	 *        see RenderPipeline::set_concurrent_recording(), including the render passes of a render graph.
+	 *        Must be set before prepare(), as the render frames are then created with
+	 *        CONCURRENT_RECORDING_THREAD_COUNT threads.
+	 */
+	void set_concurrent_subpass_recording(bool enabled);
+
+	/**
+	 * @brief Enables dynamic resolution: the scene is rendered offscreen at a scale of the swapchain extent,
+	 *        adjusted every few frames to keep the GPU frame time under the target of the DynamicResolution,
+	 *        then upscaled to the swapchain image, over which the gui is drawn at native resolution
+	 */
+	void set_dynamic_resolution_enabled(bool enabled);
+
+	/**
+	 * @return The controller of the render scale, through which the target frame time and scale bounds are set
+	 */
+	DynamicResolution &get_dynamic_resolution();
+
+	/**
+	 * @return The governor applying degradation policies as the device heats up, to which samples can add their own
+	 *         such as reducing the light count. It is created in prepare().
+	 */
+	ThermalGovernor &get_thermal_governor();
+
+	/**
+	 * @brief Adds the framework degradation policies to the thermal governor: lowering the render scale
+	 *        through dynamic resolution, then capping the frame rate to 30 fps
+	 */
+	void add_default_thermal_policies();
+
+	/**
+	 * @brief Adds the device, the series of the enabled stats and the configuration to the benchmark report
+	 */
+	virtual void add_benchmark_report(nlohmann::json &report) override;
+
   protected:
 	/**
 	 * @brief The Vulkan device
@@ -157,6 +407,11 @@ class VulkanSample : public Application
 	 */
 	std::unique_ptr<RenderPipeline> render_pipeline{nullptr};
 
+	/**
+	 * @brief Graph used for rendering instead of the render pipeline, if the concrete sample sets one
+	 */
+	std::unique_ptr<RenderGraph> render_graph{nullptr};
+
 	/**
 	 * @brief Holds all scene information
 	 */
@@ -183,6 +438,19 @@ class VulkanSample : public Application
 	 */
 	void update_stats(float delta_time);
 
+	/**
+	 * @brief Attaches the camera path script to the node of the free camera, once the scene has one
+	 */
+	void attach_camera_path();
+
+#if defined(VKB_DEBUG)
+	/**
+	 * @brief Logs the barriers flagged by the barrier analyzer in the command buffers of the previous frame,
+	 *        whenever their numbers change
+	 */
+	void report_barrier_summary();
+#endif
+
 	/**
 	 * @brief Update GUI
 	 * @param delta_time
@@ -196,6 +464,20 @@ class VulkanSample : public Application
 	 */
 	virtual void draw(CommandBuffer &command_buffer, RenderTarget &render_target);
 
+	/**
+	 * @brief Executes the render graph, which records its own barriers, and draws the gui in its last render pass
+	 * @param command_buffer The command buffer to record the commands to
+	 * @param render_target The render target that is being drawn to
+	 */
+	void draw_render_graph(CommandBuffer &command_buffer, RenderTarget &render_target);
+
+	/**
+	 * @brief Draws the gui into a secondary command buffer executed in the current subpass
+	 * @param command_buffer The primary command buffer, in a subpass accepting secondary command buffers
+	 * @param extent Extent of the render target, for the dynamic state the secondary command buffer does not inherit
+	 */
+	void draw_gui_secondary(CommandBuffer &command_buffer, const VkExtent2D &extent);
+
 	/**
 	 * @brief Starts the render pass, executes the render pipeline, and then ends the render pass
 	 * @param command_buffer The command buffer to record the commands to
@@ -255,6 +537,14 @@ class VulkanSample : public Application
   private:
 	static constexpr float STATS_VIEW_RESET_TIME{10.0f};        // 10 seconds
 
+	static constexpr float MEMORY_BUDGET_CHECK_TIME{0.5f};        // 0.5 seconds
+
+	/// Threads of the render frames recording subpasses concurrently, enough for the subpasses of a deferred pipeline
+	static constexpr size_t CONCURRENT_RECORDING_THREAD_COUNT{4};
+
+	/// Fraction of the budget of a heap above which memory pressure is reported
+	static constexpr float MEMORY_BUDGET_WARNING_RATIO{0.9f};
+
 	/**
 	 * @brief The Vulkan instance
 	 */
@@ -269,5 +559,198 @@ class VulkanSample : public Application
 	 * @brief The configuration of the sample
 	 */
 	Configuration configuration{};
+
+	bool pipeline_cache_persistence{false};
+
+	DeviceGroupMode device_group_mode{DeviceGroupMode::None};
+
+	/// Slot the device context is taken from and put back in, if shared
+	std::unique_ptr<DeviceContext> *shared_device_context{nullptr};
+
+	std::string device_context_key;
+
+	StartupTimeline startup_timeline;
+
+	/// End of VulkanSample::prepare(), the rest of the prepare() of the sample follows
+	StartupTimeline::Clock::time_point framework_prepare_end{};
+
+	bool low_latency_enabled{false};
+
+	bool incremental_rendering{false};
+
+	bool concurrent_subpass_recording{false};
+
+	DamageTracker damage_tracker;
+
+	/// Whether an input event captured by the gui may have changed the configuration rendered since the last frame
+	bool gui_input_damage{false};
+
+	/**
+	 * @brief Passes the region changed by the last update of the scene and the gui to the render context
+	 */
+	void update_damage();
+
+	bool progressive_scene_loading{false};
+
+	bool scene_cache_enabled{false};
+
+	bool vertex_quantization{false};
+
+	bool lod_generation{false};
+
+	bool mesh_optimization{false};
+
+	bool meshlet_generation{false};
+
+	bool interleaved_vertices{false};
+
+	bool primitive_merging{false};
+
+	bool texture_array_batching{false};
+
+	std::string image_variant;
+
+	/// Loader streaming the images of the scene, kept until they are all uploaded
+	std::unique_ptr<GLTFLoader> scene_loader;
+
+	VkDeviceSize texture_streaming_budget{0};
+
+	bool texture_streaming_sparse_residency{false};
+
+	std::unique_ptr<TextureStreamer> texture_streamer;
+
+	bool memory_defragmentation{false};
+
+	std::unique_ptr<MemoryDefragmenter> memory_defragmenter;
+
+	bool shader_hot_reload{false};
+
+	/// GPU set with set_preferred_gpu(), empty to select the GPU with the highest score
+	std::string preferred_gpu;
+
+	std::unique_ptr<ShaderReloader> shader_reloader;
+
+	sg::CameraPath::Mode camera_path_mode{sg::CameraPath::Mode::Playback};
+
+	/// Path file set with set_camera_path(), empty if the camera is not recorded nor played back
+	std::string camera_path_file;
+
+	/// Owned by the scene, null until attach_camera_path() finds the free camera
+	sg::CameraPath *camera_path{nullptr};
+
+	/// Draw list file set with set_draw_list_capture(), emptied once the frame is captured
+	std::string draw_list_capture_file;
+
+	/// Frames left to render before the captured one
+	uint32_t draw_list_capture_countdown{0};
+
+	/// Whether an input event arrived since the last submission
+	bool input_pending{false};
+
+	/// Time of the oldest input event not yet submitted, reported as StatIndex::input_latency
+	std::chrono::steady_clock::time_point input_time{};
+
+	/// Time since the memory budget was last checked
+	float memory_budget_check_count{MEMORY_BUDGET_CHECK_TIME};
+
+	/// Whether a heap is above MEMORY_BUDGET_WARNING_RATIO of its budget, to only warn once per crossing
+	bool memory_budget_warning{false};
+
+	/// Resource cache misses counted until the previous frame, to show those of each frame
+	uint64_t resource_cache_misses{0};
+
+	/// Resource cache lock contentions counted until the previous frame
+	uint64_t resource_cache_contentions{0};
+
+	/// Command buffer binds counted until the previous frame, to show those of each frame
+	CommandBufferCounters command_buffer_counters;
+
+	/// Busy and idle time of the queues, reconstructed from the submissions of the frames
+	QueueActivity queue_activity;
+
+	/// Descriptor sets allocated until the previous frame
+	uint64_t descriptor_set_allocations{0};
+
+	/// Bytes written into buffers by the host until the previous frame
+	uint64_t uploaded_bytes{0};
+
+#if defined(VKB_DEBUG)
+	/// Barriers counted until the previous frame, and the summary of the barriers last reported
+	CommandBufferCounters barrier_counters;
+
+	std::string barrier_summary;
+#endif
+
+	std::unique_ptr<ThermalGovernor> thermal_governor;
+
+	/// Transform of the swapchain the cameras of the scene were last pre-rotated for
+	VkSurfaceTransformFlagBitsKHR applied_pre_transform{VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR};
+
+	/**
+	 * @brief Pre-rotates the cameras of the scene for the transform of the swapchain,
+	 *        so that they project to the swapchain images in the native orientation of the display
+	 */
+	void update_pre_rotation();
+
+	bool dynamic_resolution_enabled{false};
+
+	DynamicResolution dynamic_resolution;
+
+	/// Subpass drawing the scaled render target to the swapchain image, created on first use
+	std::vector<std::unique_ptr<Subpass>> upscale_subpasses;
+
+	/**
+	 * @brief Feeds the GPU time of the last use of the active frame to the dynamic resolution,
+	 *        recreating the render targets when the scale changes
+	 */
+	void update_dynamic_resolution();
+
+	/**
+	 * @brief Upscales the scaled render target of the frame to its present render target and draws the gui over it
+	 * @param command_buffer The command buffer to record the commands to
+	 * @param render_target The scaled render target the scene was drawn to
+	 * @param present_render_target The render target holding the swapchain image
+	 */
+	void draw_upscale(CommandBuffer &command_buffer, RenderTarget &render_target, RenderTarget &present_render_target);
+
+	/**
+	 * @brief Records the frame of the active command buffer and submits it
+	 */
+	void record_and_submit(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Reports how busy the queues were during the last use of the active frame to the stats and
+	 *        to the CPU trace, and measures the submissions only while either of them shows the results
+	 */
+	void update_queue_activity();
+
+	/// Stats the performance queries of the frames were enabled for
+	Stats *performance_query_stats{nullptr};
+
+	/**
+	 * @brief Measures the enabled GPU counter stats which hwcpipe cannot read with performance queries, if the device supports them
+	 */
+	void enable_performance_queries();
+
+	/**
+	 * @brief Periodically checks the memory budget, warns when it is close to be exceeded
+	 *        and updates the memory stats
+	 */
+	void update_memory_budget(float delta_time);
+
+	/**
+	 * @brief Pipeline cache used by the resource cache when persistence is enabled
+	 */
+	VkPipelineCache pipeline_cache{VK_NULL_HANDLE};
+
+	/**
+	 * @brief Creates the pipeline cache from the data of a previous run and warms up the resource cache
+	 */
+	void load_pipeline_cache();
+
+	/**
+	 * @brief Writes the pipeline cache and resource cache data, then destroys the pipeline cache
+	 */
+	void save_pipeline_cache();
 };
 }        // namespace vkb
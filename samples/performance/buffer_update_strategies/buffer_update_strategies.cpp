@@ -0,0 +1,328 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "buffer_update_strategies.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "common/utils.h"
+#include "core/device.h"
+#include "gui.h"
+#include "platform/filesystem.h"
+#include "platform/platform.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/node.h"
+#include "stats.h"
+#include "timer.h"
+
+namespace
+{
+const char *STRATEGY_NAMES[] = {"Uniform per draw", "Dynamic offsets", "Push constants", "Storage buffer"};
+
+/// Offset of the model matrix in the push constants, after the material of the fragment shader
+constexpr uint32_t MODEL_PUSH_CONSTANT_OFFSET = 32;
+
+/// Binding of the transforms of the nodes in the vertex shader
+constexpr uint32_t NODE_TRANSFORMS_BINDING = 10;
+
+/**
+ * @brief Loads the vertex shader with the define choosing where it reads the model matrix from
+ */
+vkb::ShaderSource load_vertex_source(BufferUpdateStrategies::Strategy strategy)
+{
+	auto source = vkb::fs::read_shader("buffer_update_strategies/buffer_update.vert");
+
+	std::string define;
+
+	switch (strategy)
+	{
+		case BufferUpdateStrategies::Strategy::PushConstants:
+			define = "#define MODEL_PUSH_CONSTANT\n";
+			break;
+		case BufferUpdateStrategies::Strategy::StorageBuffer:
+			define = "#define MODEL_STORAGE_BUFFER\n";
+			break;
+		default:
+			break;
+	}
+
+	// The version directive must stay the first line
+	auto version_end = std::find(source.begin(), source.end(), '\n');
+
+	if (version_end == source.end())
+	{
+		throw std::runtime_error("The vertex shader has no version directive");
+	}
+
+	source.insert(version_end + 1, define.begin(), define.end());
+
+	return vkb::ShaderSource{std::move(source)};
+}
+}        // namespace
+
+BufferUpdateStrategies::BufferUpdateStrategies()
+{
+	auto &config = get_configuration();
+
+	config.insert<vkb::IntSetting>(0, gui_strategy, static_cast<int>(Strategy::PerDrawUniform));
+	config.insert<vkb::IntSetting>(1, gui_strategy, static_cast<int>(Strategy::DynamicOffsets));
+	config.insert<vkb::IntSetting>(2, gui_strategy, static_cast<int>(Strategy::PushConstants));
+	config.insert<vkb::IntSetting>(3, gui_strategy, static_cast<int>(Strategy::StorageBuffer));
+}
+
+BufferUpdateStrategies::StrategySubpass::StrategySubpass(vkb::RenderContext &render_context,
+                                                         vkb::ShaderSource &&vertex_shader, vkb::ShaderSource &&fragment_shader,
+                                                         vkb::sg::Scene &scene_, vkb::sg::Camera &camera, Strategy strategy) :
+    vkb::ForwardSubpass{render_context, std::move(vertex_shader), std::move(fragment_shader), scene_, camera},
+    strategy{strategy}
+{
+}
+
+void BufferUpdateStrategies::StrategySubpass::draw(vkb::CommandBuffer &command_buffer)
+{
+	vkb::Timer timer;
+	timer.start();
+
+	draw_count = 0;
+
+	auto &render_frame = get_render_context().get_active_frame();
+
+	if (strategy == Strategy::PushConstants || strategy == Strategy::StorageBuffer)
+	{
+		// Only the camera is read from the global uniform, so it is written once for all the draws
+		vkb::GlobalUniform global_uniform;
+		global_uniform.model            = glm::mat4{1.0f};
+		global_uniform.camera_view_proj = vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
+		global_uniform.camera_position  = glm::vec3(glm::inverse(camera.get_view())[3]);
+
+		global_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(vkb::GlobalUniform), get_recording_thread_index());
+		global_buffer.update(global_uniform);
+	}
+
+	if (strategy == Strategy::StorageBuffer)
+	{
+		node_indices.clear();
+
+		std::vector<glm::mat4> transforms;
+
+		for (auto mesh : meshes)
+		{
+			for (auto node : mesh->get_nodes())
+			{
+				if (node_indices.emplace(node, vkb::to_u32(transforms.size())).second)
+				{
+					transforms.push_back(node->get_transform().get_world_matrix());
+				}
+			}
+		}
+
+		if (!transforms.empty())
+		{
+			transforms_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, transforms.size() * sizeof(glm::mat4), get_recording_thread_index());
+			transforms_buffer.update(reinterpret_cast<const uint8_t *>(transforms.data()), transforms.size() * sizeof(glm::mat4));
+		}
+	}
+
+	vkb::ForwardSubpass::draw(command_buffer);
+
+	draw_time = timer.stop<vkb::Timer::Milliseconds>();
+}
+
+double BufferUpdateStrategies::StrategySubpass::get_draw_time() const
+{
+	return draw_time;
+}
+
+uint32_t BufferUpdateStrategies::StrategySubpass::get_draw_count() const
+{
+	return draw_count;
+}
+
+void BufferUpdateStrategies::StrategySubpass::bind_common_resources(vkb::CommandBuffer &command_buffer)
+{
+	vkb::ForwardSubpass::bind_common_resources(command_buffer);
+
+	if (strategy == Strategy::PushConstants || strategy == Strategy::StorageBuffer)
+	{
+		command_buffer.bind_buffer(global_buffer.get_buffer(), global_buffer.get_offset(), global_buffer.get_size(), 0, 1, 0);
+	}
+
+	if (strategy == Strategy::StorageBuffer && !transforms_buffer.empty())
+	{
+		command_buffer.bind_buffer(transforms_buffer.get_buffer(), transforms_buffer.get_offset(), transforms_buffer.get_size(), 0, NODE_TRANSFORMS_BINDING, 0);
+	}
+}
+
+uint32_t BufferUpdateStrategies::StrategySubpass::update_uniform(vkb::CommandBuffer &command_buffer, vkb::sg::Node &node, size_t thread_index)
+{
+	// POI
+	//
+	// The uniform strategies allocate and write a global uniform per draw, binding it at a new offset.
+	// Push constants are recorded into the command buffer instead, and the storage buffer strategy
+	// only picks the transform of the node written by draw(), through the first instance of the draw.
+	switch (strategy)
+	{
+		case Strategy::PushConstants:
+			draw_model = node.get_transform().get_world_matrix();
+			return 0;
+		case Strategy::StorageBuffer:
+			return node_indices.at(&node);
+		default:
+			return vkb::ForwardSubpass::update_uniform(command_buffer, node, thread_index);
+	}
+}
+
+void BufferUpdateStrategies::StrategySubpass::draw_submesh(vkb::CommandBuffer &command_buffer, vkb::sg::SubMesh &sub_mesh, VkFrontFace front_face, uint32_t lod, uint32_t first_instance)
+{
+	++draw_count;
+
+	if (strategy != Strategy::PushConstants)
+	{
+		vkb::ForwardSubpass::draw_submesh(command_buffer, sub_mesh, front_face, lod, first_instance);
+		return;
+	}
+
+	// The push constants are pushed with the pipeline layout of the submesh, which binding it sets
+	bind_submesh(command_buffer, sub_mesh, front_face, get_shader_variant(sub_mesh), nullptr);
+
+	command_buffer.push_constants(MODEL_PUSH_CONSTANT_OFFSET, draw_model);
+
+	draw_submesh_command(command_buffer, sub_mesh, 1, lod, first_instance);
+}
+
+bool BufferUpdateStrategies::prepare(vkb::Platform &platform)
+{
+	if (!VulkanSample::prepare(platform))
+	{
+		return false;
+	}
+
+	load_scene("scenes/sponza/Sponza01.gltf");
+
+	auto &camera_node = vkb::add_free_camera(*scene, "main_camera", get_render_context().get_surface_extent());
+	camera            = dynamic_cast<vkb::sg::PerspectiveCamera *>(&camera_node.get_component<vkb::sg::Camera>());
+
+	for (size_t strategy = 0; strategy < static_cast<size_t>(Strategy::Count); ++strategy)
+	{
+		render_pipelines.push_back(create_render_pipeline(static_cast<Strategy>(strategy)));
+	}
+
+	stats = std::make_unique<vkb::Stats>(std::set<vkb::StatIndex>{vkb::StatIndex::frame_times,
+	                                                              vkb::StatIndex::cpu_recording_time,
+	                                                              vkb::StatIndex::descriptor_set_allocations,
+	                                                              vkb::StatIndex::descriptor_set_binds,
+	                                                              vkb::StatIndex::uploaded_bytes});
+	gui   = std::make_unique<vkb::Gui>(*this, platform.get_window().get_dpi_factor());
+
+	descriptor_set_allocations = device->get_descriptor_set_allocations();
+	uploaded_bytes             = device->get_uploaded_bytes();
+
+	return true;
+}
+
+std::unique_ptr<vkb::RenderPipeline> BufferUpdateStrategies::create_render_pipeline(Strategy strategy)
+{
+	vkb::ShaderSource frag_shader("base.frag");
+	auto              scene_subpass = std::make_unique<StrategySubpass>(get_render_context(), load_vertex_source(strategy), std::move(frag_shader), *scene, *camera, strategy);
+
+	strategy_subpasses.push_back(scene_subpass.get());
+
+	std::vector<std::unique_ptr<vkb::Subpass>> scene_subpasses{};
+	scene_subpasses.push_back(std::move(scene_subpass));
+
+	return std::make_unique<vkb::RenderPipeline>(std::move(scene_subpasses));
+}
+
+void BufferUpdateStrategies::update(float delta_time)
+{
+	auto allocations                 = device->get_descriptor_set_allocations();
+	frame_descriptor_set_allocations = allocations - descriptor_set_allocations;
+	descriptor_set_allocations       = allocations;
+
+	auto uploaded        = device->get_uploaded_bytes();
+	frame_uploaded_bytes = uploaded - uploaded_bytes;
+	uploaded_bytes       = uploaded;
+
+	if (stats)
+	{
+		stats->set_value(vkb::StatIndex::cpu_recording_time, static_cast<float>(strategy_subpasses[gui_strategy]->get_draw_time()));
+	}
+
+	VulkanSample::update(delta_time);
+}
+
+void BufferUpdateStrategies::render(vkb::CommandBuffer &command_buffer)
+{
+	auto strategy = static_cast<Strategy>(gui_strategy);
+
+	auto &render_frame = get_render_context().get_active_frame();
+
+	// POI
+	//
+	// With one allocation per buffer, each draw writes its uniform into a buffer of its own, and so needs a descriptor set of its own.
+	// The descriptor sets are cleared every frame, as a renderer allocating the buffer and descriptor set of each draw would.
+	// The other strategies share the blocks of the buffer pools, which dynamic offsets address without new descriptor sets.
+	if (strategy == Strategy::PerDrawUniform)
+	{
+		render_frame.set_buffer_allocation_strategy(vkb::BufferAllocationStrategy::OneAllocationPerBuffer);
+		render_frame.clear_descriptors();
+	}
+	else
+	{
+		render_frame.set_buffer_allocation_strategy(vkb::BufferAllocationStrategy::MultipleAllocationsPerBuffer);
+	}
+
+	render_pipelines[gui_strategy]->draw(command_buffer, render_frame.get_render_target());
+}
+
+void BufferUpdateStrategies::draw_gui()
+{
+	bool     landscape = camera->get_aspect_ratio() > 1.0f;
+	uint32_t lines     = landscape ? 4 : 6;
+
+	gui->show_options_window(
+	    /* body = */ [&]() {
+		    for (int strategy = 0; strategy < static_cast<int>(Strategy::Count); ++strategy)
+		    {
+			    if (strategy % 2 == 1 && landscape)
+			    {
+				    ImGui::SameLine();
+			    }
+			    ImGui::RadioButton(STRATEGY_NAMES[strategy], &gui_strategy, strategy);
+		    }
+
+		    auto subpass = strategy_subpasses[gui_strategy];
+
+		    // Push constants are part of the command buffer, they are not written into buffers
+		    uint32_t pushed_bytes = gui_strategy == static_cast<int>(Strategy::PushConstants) ? subpass->get_draw_count() * vkb::to_u32(sizeof(glm::mat4)) : 0;
+
+		    ImGui::Text("Recording %.2f ms, %u draws, %llu descriptor sets allocated", subpass->get_draw_time(), subpass->get_draw_count(),
+		                static_cast<unsigned long long>(frame_descriptor_set_allocations));
+		    ImGui::Text("Uploaded %.1f KiB to buffers, pushed %.1f KiB", frame_uploaded_bytes / 1024.0f, pushed_bytes / 1024.0f);
+	    },
+	    /* lines = */ lines);
+}
+
+std::unique_ptr<vkb::VulkanSample> create_buffer_update_strategies()
+{
+	return std::make_unique<BufferUpdateStrategies>();
+}
@@ -0,0 +1,139 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <unordered_map>
+
+#include "buffer_pool.h"
+#include "rendering/render_pipeline.h"
+#include "rendering/subpasses/forward_subpass.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "vulkan_sample.h"
+
+/**
+ * @brief Sample comparing ways of giving the model matrix of each draw to the vertex shader:
+ *        a uniform buffer allocated per draw, dynamic offsets into a shared uniform buffer,
+ *        push constants, and a storage buffer of all the transforms indexed by instance
+ */
+class BufferUpdateStrategies : public vkb::VulkanSample
+{
+  public:
+	BufferUpdateStrategies();
+
+	virtual ~BufferUpdateStrategies() = default;
+
+	virtual bool prepare(vkb::Platform &platform) override;
+
+	virtual void update(float delta_time) override;
+
+	/**
+	 * @brief Where the model matrix of a draw comes from
+	 */
+	enum class Strategy
+	{
+		PerDrawUniform,
+		DynamicOffsets,
+		PushConstants,
+		StorageBuffer,
+		Count
+	};
+
+	/**
+	 * @brief Forward subpass providing the model matrices of the draws with one of the strategies
+	 */
+	class StrategySubpass : public vkb::ForwardSubpass
+	{
+	  public:
+		StrategySubpass(vkb::RenderContext &render_context,
+		                vkb::ShaderSource &&vertex_source, vkb::ShaderSource &&fragment_source,
+		                vkb::sg::Scene &scene, vkb::sg::Camera &camera, Strategy strategy);
+
+		/**
+		 * @brief Writes the buffers shared by the draws of the frame, then records the draws
+		 */
+		virtual void draw(vkb::CommandBuffer &command_buffer) override;
+
+		/**
+		 * @return CPU time of the last draw, including writing the shared buffers, in milliseconds
+		 */
+		double get_draw_time() const;
+
+		/**
+		 * @return Number of submesh draws recorded during the last draw
+		 */
+		uint32_t get_draw_count() const;
+
+	  protected:
+		virtual void bind_common_resources(vkb::CommandBuffer &command_buffer) override;
+
+		virtual uint32_t update_uniform(vkb::CommandBuffer &command_buffer, vkb::sg::Node &node, size_t thread_index) override;
+
+		virtual void draw_submesh(vkb::CommandBuffer &command_buffer, vkb::sg::SubMesh &sub_mesh, VkFrontFace front_face, uint32_t lod, uint32_t first_instance) override;
+
+	  private:
+		Strategy strategy;
+
+		/// Global uniform bound once per command buffer, when the model matrices are given per draw another way
+		vkb::BufferAllocation global_buffer;
+
+		/// Transforms of all the nodes of the frame for Strategy::StorageBuffer
+		vkb::BufferAllocation transforms_buffer;
+
+		/// Index of the transform of each node in transforms_buffer
+		std::unordered_map<const vkb::sg::Node *, uint32_t> node_indices;
+
+		/// Model matrix of the node being drawn, pushed by draw_submesh()
+		glm::mat4 draw_model{1.0f};
+
+		uint32_t draw_count{0};
+
+		double draw_time{0.0};
+	};
+
+  private:
+	virtual void draw_gui() override;
+
+	virtual void render(vkb::CommandBuffer &command_buffer) override;
+
+	std::unique_ptr<vkb::RenderPipeline> create_render_pipeline(Strategy strategy);
+
+	vkb::sg::PerspectiveCamera *camera{nullptr};
+
+	std::vector<std::unique_ptr<vkb::RenderPipeline>> render_pipelines;
+
+	std::vector<StrategySubpass *> strategy_subpasses;
+
+	int gui_strategy{static_cast<int>(Strategy::DynamicOffsets)};
+
+	/// Descriptor sets allocated until the previous frame
+	uint64_t descriptor_set_allocations{0};
+
+	/// Descriptor sets allocated in the last frame
+	uint64_t frame_descriptor_set_allocations{0};
+
+	/// Bytes written into buffers until the previous frame
+	uint64_t uploaded_bytes{0};
+
+	/// Bytes written into buffers in the last frame
+	uint64_t frame_uploaded_bytes{0};
+};
+
+std::unique_ptr<vkb::VulkanSample> create_buffer_update_strategies();
@@ -22,6 +22,7 @@
 
 #include <algorithm>
 #include <numeric>
+#include <thread>
 
 #include "core/device.h"
 #include "core/pipeline_layout.h"
@@ -246,9 +247,7 @@ CommandBufferUsage::ForwardSubpassSecondary::ForwardSubpassSecondary(vkb::Render
 {
 }
 
-void CommandBufferUsage::ForwardSubpassSecondary::record_draw(vkb::CommandBuffer &                                               command_buffer,
-                                                              const std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> &nodes,
-                                                              uint32_t mesh_start, uint32_t mesh_end, size_t thread_index)
+void CommandBufferUsage::ForwardSubpassSecondary::record_draw(vkb::CommandBuffer &command_buffer, uint32_t mesh_start, uint32_t mesh_end, size_t thread_index)
 {
 	command_buffer.set_color_blend_state(color_blend_state);
 
@@ -258,15 +257,15 @@ void CommandBufferUsage::ForwardSubpassSecondary::record_draw(vkb::CommandBuffer
 
 	for (uint32_t i = mesh_start; i < mesh_end; i++)
 	{
-		update_uniform(command_buffer, *nodes.at(i).first, thread_index);
+		update_uniform(command_buffer, *draw_list.get(i).node, thread_index);
 
-		draw_submesh(command_buffer, *nodes.at(i).second);
+		auto &draw = draw_list.get(i);
+
+		draw_submesh(command_buffer, *draw.sub_mesh, VK_FRONT_FACE_COUNTER_CLOCKWISE, draw.lod);
 	}
 }
 
-vkb::CommandBuffer *CommandBufferUsage::ForwardSubpassSecondary::record_draw_secondary(vkb::CommandBuffer &                                               primary_command_buffer,
-                                                                                       const std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> &nodes,
-                                                                                       uint32_t mesh_start, uint32_t mesh_end, size_t thread_index)
+vkb::CommandBuffer *CommandBufferUsage::ForwardSubpassSecondary::record_draw_secondary(vkb::CommandBuffer &primary_command_buffer, uint32_t mesh_start, uint32_t mesh_end, size_t thread_index)
 {
 	const auto &queue = render_context.get_device().get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
 
@@ -278,7 +277,7 @@ vkb::CommandBuffer *CommandBufferUsage::ForwardSubpassSecondary::record_draw_sec
 
 	secondary_command_buffer.set_scissor(0, {scissor});
 
-	record_draw(secondary_command_buffer, nodes, mesh_start, mesh_end, thread_index);
+	record_draw(secondary_command_buffer, mesh_start, mesh_end, thread_index);
 
 	secondary_command_buffer.end();
 
@@ -286,27 +285,12 @@ vkb::CommandBuffer *CommandBufferUsage::ForwardSubpassSecondary::record_draw_sec
 }
 void CommandBufferUsage::ForwardSubpassSecondary::draw(vkb::CommandBuffer &primary_command_buffer)
 {
-	std::multimap<float, std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> opaque_nodes;
-
-	std::multimap<float, std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> transparent_nodes;
+	// Opaque objects are sorted front-to-back, followed by transparent objects sorted back-to-front
+	get_sorted_nodes(draw_list);
 
-	get_sorted_nodes(opaque_nodes, transparent_nodes);
-
-	// Sort opaque objects in front-to-back order
-	std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> sorted_opaque_nodes;
-	for (auto node_it = opaque_nodes.begin(); node_it != opaque_nodes.end(); node_it++)
-	{
-		sorted_opaque_nodes.push_back(node_it->second);
-	}
-	const auto opaque_submeshes = vkb::to_u32(sorted_opaque_nodes.size());
+	const auto opaque_submeshes = vkb::to_u32(draw_list.get_opaque_count());
 
-	// Sort transparent objects in back-to-front order
-	std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> sorted_transparent_nodes;
-	for (auto node_it = transparent_nodes.rbegin(); node_it != transparent_nodes.rend(); node_it++)
-	{
-		sorted_transparent_nodes.push_back(node_it->second);
-	}
-	const auto transparent_submeshes = vkb::to_u32(sorted_transparent_nodes.size());
+	const auto transparent_submeshes = vkb::to_u32(draw_list.size()) - opaque_submeshes;
 
 	light_buffer = allocate_lights<vkb::ForwardLights>(scene.get_components<vkb::sg::Light>(), MAX_FORWARD_LIGHT_COUNT);
 
@@ -320,14 +304,10 @@ void CommandBufferUsage::ForwardSubpassSecondary::draw(vkb::CommandBuffer &prima
 	std::vector<vkb::CommandBuffer *> secondary_command_buffers;
 	avg_draws_per_buffer = (state.secondary_cmd_buf_count > 0) ? static_cast<float>(opaque_submeshes) / state.secondary_cmd_buf_count : 0;
 
-	if (state.thread_count != thread_pool.size())
-	{
-		thread_pool.resize(state.thread_count);
-	}
-
 	if (use_secondary_command_buffers)
 	{
-		std::vector<std::future<vkb::CommandBuffer *>> secondary_cmd_buf_futures;
+		// Draw ranges of the command buffers recorded by the job system
+		std::vector<std::pair<uint32_t, uint32_t>> mesh_ranges;
 
 		// Save the number of draws left over, these will be distributed among the first buffers
 		uint32_t draws_per_buffer = vkb::to_u32(std::floor(avg_draws_per_buffer));
@@ -346,16 +326,11 @@ void CommandBufferUsage::ForwardSubpassSecondary::draw(vkb::CommandBuffer &prima
 
 			if (state.multi_threading)
 			{
-				auto fut = thread_pool.push(
-				    [this, cb_count, &primary_command_buffer, &sorted_opaque_nodes, mesh_start, mesh_end](size_t thread_id) {
-					    return record_draw_secondary(primary_command_buffer, sorted_opaque_nodes, mesh_start, mesh_end, thread_id);
-				    });
-
-				secondary_cmd_buf_futures.push_back(std::move(fut));
+				mesh_ranges.emplace_back(mesh_start, mesh_end);
 			}
 			else
 			{
-				secondary_command_buffers.push_back(record_draw_secondary(primary_command_buffer, sorted_opaque_nodes, mesh_start, mesh_end));
+				secondary_command_buffers.push_back(record_draw_secondary(primary_command_buffer, mesh_start, mesh_end));
 			}
 
 			mesh_start = mesh_end;
@@ -363,15 +338,19 @@ void CommandBufferUsage::ForwardSubpassSecondary::draw(vkb::CommandBuffer &prima
 
 		if (state.multi_threading)
 		{
-			for (auto &fut : secondary_cmd_buf_futures)
-			{
-				secondary_command_buffers.push_back(fut.get());
-			}
+			secondary_command_buffers.resize(mesh_ranges.size());
+
+			// This thread records too, at most thread_count threads record at the same time
+			auto &job_system = get_render_context().get_device().get_job_system();
+
+			job_system.run_parallel(vkb::JobPriority::Frame, mesh_ranges.size(), state.thread_count, [&](size_t range, size_t thread_index) {
+				secondary_command_buffers[range] = record_draw_secondary(primary_command_buffer, mesh_ranges[range].first, mesh_ranges[range].second, thread_index);
+			});
 		}
 	}
 	else
 	{
-		record_draw(primary_command_buffer, sorted_opaque_nodes, 0, opaque_submeshes);
+		record_draw(primary_command_buffer, 0, opaque_submeshes);
 	}
 
 	// Enable alpha blending
@@ -387,11 +366,11 @@ void CommandBufferUsage::ForwardSubpassSecondary::draw(vkb::CommandBuffer &prima
 	{
 		if (use_secondary_command_buffers)
 		{
-			secondary_command_buffers.push_back(record_draw_secondary(primary_command_buffer, sorted_transparent_nodes, 0, transparent_submeshes));
+			secondary_command_buffers.push_back(record_draw_secondary(primary_command_buffer, opaque_submeshes, opaque_submeshes + transparent_submeshes));
 		}
 		else
 		{
-			record_draw(primary_command_buffer, sorted_transparent_nodes, 0, transparent_submeshes);
+			record_draw(primary_command_buffer, opaque_submeshes, opaque_submeshes + transparent_submeshes);
 		}
 	}
 
@@ -20,8 +20,6 @@
 
 #pragma once
 
-#include <ctpl_stl.h>
-
 #include "buffer_pool.h"
 #include "common/utils.h"
 #include "rendering/render_pipeline.h"
@@ -85,29 +83,25 @@ class CommandBufferUsage : public vkb::VulkanSample
 
 	  private:
 		/**
-		 * @brief Records the necessary commands to draw the specified range of scene meshes
+		 * @brief Records the necessary commands to draw the specified range of the sorted draw list
 		 * @param command_buffer The primary command buffer to record
-		 * @param nodes The meshes to draw
 		 * @param mesh_start Index to the first mesh to draw
 		 * @param mesh_end Index to the mesh where recording will stop (not included)
 		 * @param thread_index Identifies the resources allocated for this thread
 		 */
-		void record_draw(vkb::CommandBuffer &command_buffer, const std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> &nodes,
-		                 uint32_t mesh_start, uint32_t mesh_end, size_t thread_index = 0);
+		void record_draw(vkb::CommandBuffer &command_buffer, uint32_t mesh_start, uint32_t mesh_end, size_t thread_index = 0);
 
 		/**
-		 * @brief Records the necessary commands to draw the specified range of scene meshes
+		 * @brief Records the necessary commands to draw the specified range of the sorted draw list
 		 *        The primary command buffer provided is used to initialize, record, end and return a
 		 *        pointer to a new secondary command buffer.
 		 * @param primary_command_buffer The primary command buffer used to inherit a secondary
-		 * @param nodes The meshes to draw
 		 * @param mesh_start Index to the first mesh to draw
 		 * @param mesh_end Index to the mesh where recording will stop (not included)
 		 * @param thread_index Identifies the resources allocated for this thread
 		 * @return a pointer to the recorded secondary command buffer
 		 */
-		vkb::CommandBuffer *record_draw_secondary(vkb::CommandBuffer &primary_command_buffer, const std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> &nodes,
-		                                          uint32_t mesh_start, uint32_t mesh_end, size_t thread_index = 0);
+		vkb::CommandBuffer *record_draw_secondary(vkb::CommandBuffer &primary_command_buffer, uint32_t mesh_start, uint32_t mesh_end, size_t thread_index = 0);
 
 		VkViewport viewport{};
 
@@ -121,8 +115,6 @@ class CommandBufferUsage : public vkb::VulkanSample
 
 		float avg_draws_per_buffer{0};
 
-		ctpl::thread_pool thread_pool;
-
 		vkb::BufferAllocation light_buffer;
 	};
 
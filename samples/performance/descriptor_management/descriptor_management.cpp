@@ -32,11 +32,8 @@ DescriptorManagement::DescriptorManagement()
 {
 	auto &config = get_configuration();
 
-	config.insert<vkb::IntSetting>(0, descriptor_caching.value, 0);
-	config.insert<vkb::IntSetting>(0, buffer_allocation.value, 0);
-
-	config.insert<vkb::IntSetting>(1, descriptor_caching.value, 1);
-	config.insert<vkb::IntSetting>(1, buffer_allocation.value, 1);
+	config.add_axis(descriptor_caching.value, {0, 1});
+	config.add_axis(buffer_allocation.value, {0, 1});
 }
 
 bool DescriptorManagement::prepare(vkb::Platform &platform)
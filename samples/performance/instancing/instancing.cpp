@@ -0,0 +1,236 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "instancing.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "common/logging.h"
+#include "core/device.h"
+#include "gui.h"
+#include "platform/platform.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/node.h"
+#include "stats.h"
+
+constexpr uint32_t Instancing::GRID_SIZE;
+
+namespace
+{
+const char *DRAW_MODE_NAMES[] = {"Individual draws", "Instanced draws", "Indirect draws"};
+}        // namespace
+
+Instancing::Instancing()
+{
+	auto &config = get_configuration();
+
+	config.insert<vkb::IntSetting>(0, gui_draw_mode, static_cast<int>(DrawMode::Individual));
+	config.insert<vkb::IntSetting>(1, gui_draw_mode, static_cast<int>(DrawMode::Instanced));
+	config.insert<vkb::IntSetting>(2, gui_draw_mode, static_cast<int>(DrawMode::Indirect));
+}
+
+Instancing::GridSubpass::GridSubpass(vkb::RenderContext &render_context,
+                                     vkb::ShaderSource &&vertex_shader, vkb::ShaderSource &&fragment_shader,
+                                     vkb::sg::Scene &scene_, vkb::sg::Camera &camera, vkb::sg::Mesh &grid_mesh) :
+    vkb::ForwardSubpass{render_context, std::move(vertex_shader), std::move(fragment_shader), scene_, camera}
+{
+	// The rest of the scene only provides the lights, prepare() then only builds the resources of the grid
+	meshes = {&grid_mesh};
+}
+
+bool Instancing::prepare(vkb::Platform &platform)
+{
+	if (!VulkanSample::prepare(platform))
+	{
+		return false;
+	}
+
+	load_scene("scenes/sponza/Sponza01.gltf");
+
+	auto &camera_node = vkb::add_free_camera(*scene, "main_camera", get_render_context().get_surface_extent());
+	camera            = dynamic_cast<vkb::sg::PerspectiveCamera *>(&camera_node.get_component<vkb::sg::Camera>());
+
+	auto &grid_mesh = select_grid_mesh();
+
+	build_grid(grid_mesh, camera_node);
+
+	// The instancing and GPU driven paths are chosen when the subpass is prepared, so each mode has its own pipeline
+	for (size_t mode = 0; mode < static_cast<size_t>(DrawMode::Count); ++mode)
+	{
+		render_pipelines.push_back(create_render_pipeline(grid_mesh, static_cast<DrawMode>(mode)));
+	}
+
+	stats = std::make_unique<vkb::Stats>(std::set<vkb::StatIndex>{vkb::StatIndex::frame_times,
+	                                                              vkb::StatIndex::cpu_recording_time,
+	                                                              vkb::StatIndex::draw_calls,
+	                                                              vkb::StatIndex::gpu_render_pass_time,
+	                                                              vkb::StatIndex::vertex_compute_cycles});
+	gui   = std::make_unique<vkb::Gui>(*this, platform.get_window().get_dpi_factor());
+
+	draw_call_count = device->get_command_buffer_counters().draw_calls;
+
+	return true;
+}
+
+vkb::sg::Mesh &Instancing::select_grid_mesh()
+{
+	auto meshes = scene->get_components<vkb::sg::Mesh>();
+
+	if (meshes.empty())
+	{
+		throw std::runtime_error("The scene has no mesh to build the grid with");
+	}
+
+	// Meshes which are blended or not indexed cannot be drawn indirectly, ties go to the smallest mesh
+	auto is_drawable = [](const vkb::sg::Mesh *mesh) {
+		return std::all_of(mesh->get_submeshes().begin(), mesh->get_submeshes().end(), [](const vkb::sg::SubMesh *sub_mesh) {
+			return sub_mesh->vertex_indices != 0 && sub_mesh->get_material()->alpha_mode != vkb::sg::AlphaMode::Blend;
+		});
+	};
+
+	auto index_count = [](const vkb::sg::Mesh *mesh) {
+		uint32_t count = 0;
+		for (auto sub_mesh : mesh->get_submeshes())
+		{
+			count += sub_mesh->vertex_indices;
+		}
+		return count;
+	};
+
+	auto selected = std::max_element(meshes.begin(), meshes.end(), [&](const vkb::sg::Mesh *a, const vkb::sg::Mesh *b) {
+		if (is_drawable(a) != is_drawable(b))
+		{
+			return !is_drawable(a);
+		}
+		if (a->get_nodes().size() != b->get_nodes().size())
+		{
+			return a->get_nodes().size() < b->get_nodes().size();
+		}
+		return index_count(a) > index_count(b);
+	});
+
+	LOGI("Building a grid of {} nodes of mesh `{}`", GRID_SIZE * GRID_SIZE, (*selected)->get_name());
+
+	return **selected;
+}
+
+void Instancing::build_grid(vkb::sg::Mesh &mesh, vkb::sg::Node &camera_node)
+{
+	const auto &bounds  = mesh.get_bounds();
+	glm::vec3   extent  = bounds.get_max() - bounds.get_min();
+	float       spacing = std::max(std::max(extent.x, extent.z), 0.01f) * 1.5f;
+
+	glm::mat4 camera_matrix   = camera_node.get_transform().get_world_matrix();
+	glm::vec3 camera_position = glm::vec3(camera_matrix[3]);
+	glm::vec3 forward         = -glm::normalize(glm::vec3(camera_matrix[2]));
+
+	// The grid lies on the horizontal plane, centered ahead of the camera so that part of it is culled
+	float     half_size = 0.5f * GRID_SIZE * spacing;
+	glm::vec3 origin    = camera_position + forward * half_size - glm::vec3{half_size, 0.0f, half_size} - bounds.get_center();
+
+	auto &root = scene->get_root_node();
+
+	for (uint32_t z = 0; z < GRID_SIZE; ++z)
+	{
+		for (uint32_t x = 0; x < GRID_SIZE; ++x)
+		{
+			auto node = std::make_unique<vkb::sg::Node>("grid_" + std::to_string(z * GRID_SIZE + x));
+
+			node->get_transform().set_translation(origin + glm::vec3{x * spacing, 0.0f, z * spacing});
+
+			node->set_component(mesh);
+			mesh.add_node(*node);
+
+			root.add_child(*node);
+			node->set_parent(root);
+			scene->add_node(std::move(node));
+		}
+	}
+}
+
+std::unique_ptr<vkb::RenderPipeline> Instancing::create_render_pipeline(vkb::sg::Mesh &grid_mesh, DrawMode mode)
+{
+	vkb::ShaderSource vert_shader("base.vert");
+	vkb::ShaderSource frag_shader("base.frag");
+	auto              scene_subpass = std::make_unique<GridSubpass>(get_render_context(), std::move(vert_shader), std::move(frag_shader), *scene, *camera, grid_mesh);
+
+	// POI
+	//
+	// Instancing merges the draws of the same submesh into one draw, reading the model matrices from a vertex buffer.
+	// GPU driven rendering also culls the nodes in a compute shader, which writes the commands of a single indirect draw.
+	scene_subpass->set_instancing_enabled(mode == DrawMode::Instanced);
+	scene_subpass->set_gpu_driven(mode == DrawMode::Indirect);
+
+	grid_subpasses.push_back(scene_subpass.get());
+
+	std::vector<std::unique_ptr<vkb::Subpass>> scene_subpasses{};
+	scene_subpasses.push_back(std::move(scene_subpass));
+
+	return std::make_unique<vkb::RenderPipeline>(std::move(scene_subpasses));
+}
+
+void Instancing::update(float delta_time)
+{
+	auto draw_calls  = device->get_command_buffer_counters().draw_calls;
+	frame_draw_calls = draw_calls - draw_call_count;
+	draw_call_count  = draw_calls;
+
+	if (stats)
+	{
+		stats->set_value(vkb::StatIndex::cpu_recording_time, static_cast<float>(grid_subpasses[gui_draw_mode]->get_recording_time()));
+	}
+
+	VulkanSample::update(delta_time);
+}
+
+void Instancing::render(vkb::CommandBuffer &command_buffer)
+{
+	render_pipelines[gui_draw_mode]->draw(command_buffer, get_render_context().get_active_frame().get_render_target());
+}
+
+void Instancing::draw_gui()
+{
+	bool     landscape = camera->get_aspect_ratio() > 1.0f;
+	uint32_t lines     = landscape ? 2 : 4;
+
+	gui->show_options_window(
+	    /* body = */ [&]() {
+		    for (int mode = 0; mode < static_cast<int>(DrawMode::Count); ++mode)
+		    {
+			    if (mode > 0 && landscape)
+			    {
+				    ImGui::SameLine();
+			    }
+			    ImGui::RadioButton(DRAW_MODE_NAMES[mode], &gui_draw_mode, mode);
+		    }
+
+		    auto subpass = grid_subpasses[gui_draw_mode];
+
+		    ImGui::Text("Recording %.2f ms, %llu draw calls, %u culled", subpass->get_recording_time(),
+		                static_cast<unsigned long long>(frame_draw_calls), subpass->get_culled_draw_count());
+	    },
+	    /* lines = */ lines);
+}
+
+std::unique_ptr<vkb::VulkanSample> create_instancing()
+{
+	return std::make_unique<Instancing>();
+}
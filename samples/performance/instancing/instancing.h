@@ -0,0 +1,102 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "rendering/render_pipeline.h"
+#include "rendering/subpasses/forward_subpass.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "vulkan_sample.h"
+
+/**
+ * @brief Sample comparing three ways of submitting the draws of a grid of identical meshes:
+ *        one draw per node, instanced draws, and GPU driven indirect draws
+ */
+class Instancing : public vkb::VulkanSample
+{
+  public:
+	Instancing();
+
+	virtual ~Instancing() = default;
+
+	virtual bool prepare(vkb::Platform &platform) override;
+
+	virtual void update(float delta_time) override;
+
+	/**
+	 * @brief Ways the draws of the grid are submitted
+	 */
+	enum class DrawMode
+	{
+		Individual,
+		Instanced,
+		Indirect,
+		Count
+	};
+
+	/**
+	 * @brief Forward subpass which only draws the mesh of the grid
+	 */
+	class GridSubpass : public vkb::ForwardSubpass
+	{
+	  public:
+		GridSubpass(vkb::RenderContext &render_context,
+		            vkb::ShaderSource &&vertex_source, vkb::ShaderSource &&fragment_source,
+		            vkb::sg::Scene &scene, vkb::sg::Camera &camera, vkb::sg::Mesh &grid_mesh);
+	};
+
+  private:
+	virtual void draw_gui() override;
+
+	virtual void render(vkb::CommandBuffer &command_buffer) override;
+
+	/**
+	 * @brief Chooses the mesh the grid is made of, the one with the most nodes in the scene,
+	 *        i.e. the one the scene itself instances the most
+	 */
+	vkb::sg::Mesh &select_grid_mesh();
+
+	/**
+	 * @brief Adds the nodes of the grid in front of the camera
+	 */
+	void build_grid(vkb::sg::Mesh &mesh, vkb::sg::Node &camera_node);
+
+	std::unique_ptr<vkb::RenderPipeline> create_render_pipeline(vkb::sg::Mesh &grid_mesh, DrawMode mode);
+
+	/// Nodes along each side of the grid
+	static constexpr uint32_t GRID_SIZE{48};
+
+	vkb::sg::PerspectiveCamera *camera{nullptr};
+
+	std::vector<std::unique_ptr<vkb::RenderPipeline>> render_pipelines;
+
+	std::vector<GridSubpass *> grid_subpasses;
+
+	int gui_draw_mode{static_cast<int>(DrawMode::Individual)};
+
+	/// Draw calls recorded until the previous frame
+	uint64_t draw_call_count{0};
+
+	/// Draw calls recorded in the last frame
+	uint64_t frame_draw_calls{0};
+};
+
+std::unique_ptr<vkb::VulkanSample> create_instancing();
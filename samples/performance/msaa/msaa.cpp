@@ -0,0 +1,226 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "msaa.h"
+
+#include "common/vk_common.h"
+#include "gltf_loader.h"
+#include "gui.h"
+#include "platform/filesystem.h"
+#include "platform/platform.h"
+#include "rendering/subpasses/forward_subpass.h"
+#include "stats.h"
+
+#if defined(VK_USE_PLATFORM_ANDROID_KHR)
+#	include "platform/android/android_platform.h"
+#endif
+
+namespace
+{
+/**
+ * @brief Creates a render target whose multisampled color attachment is stored to memory,
+ *        so that it can be resolved into the swapchain image after the render pass
+ */
+vkb::RenderTarget::CreateFunc separate_resolve_create_func(VkSampleCountFlagBits samples)
+{
+	return [samples](vkb::core::Image &&swapchain_image) -> vkb::RenderTarget {
+		auto &device = swapchain_image.get_device();
+
+		vkb::core::Image depth_image{device, swapchain_image.get_extent(),
+		                             VK_FORMAT_D32_SFLOAT,
+		                             VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+		                             "multisampled_depth",
+		                             samples};
+
+		vkb::core::Image color_image{device, swapchain_image.get_extent(),
+		                             swapchain_image.get_format(),
+		                             VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+		                             VMA_MEMORY_USAGE_GPU_ONLY,
+		                             samples};
+
+		std::vector<vkb::core::Image> images;
+		images.push_back(std::move(swapchain_image));
+		images.push_back(std::move(depth_image));
+		images.push_back(std::move(color_image));
+
+		return vkb::RenderTarget{std::move(images)};
+	};
+}
+}        // namespace
+
+MSAASample::MSAASample()
+{
+	auto &config = get_configuration();
+
+	config.add_axis(resolve_mode, {Disabled, OnTile, Separate});
+}
+
+bool MSAASample::prepare(vkb::Platform &platform)
+{
+	if (!VulkanSample::prepare(platform))
+	{
+		return false;
+	}
+
+	// The swapchain images are the destination of the separate resolve
+	get_render_context().update_swapchain(std::set<VkImageUsageFlagBits>{VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_IMAGE_USAGE_TRANSFER_DST_BIT});
+
+	load_scene("scenes/sponza/Sponza01.gltf");
+
+	auto &camera_node = vkb::add_free_camera(*scene, "main_camera", get_render_context().get_surface_extent());
+	camera            = &camera_node.get_component<vkb::sg::Camera>();
+
+	vkb::ShaderSource vert_shader("base.vert");
+	vkb::ShaderSource frag_shader("base.frag");
+	auto              scene_subpass = std::make_unique<vkb::ForwardSubpass>(get_render_context(), std::move(vert_shader), std::move(frag_shader), *scene, *camera);
+
+	auto render_pipeline = vkb::RenderPipeline();
+	render_pipeline.add_subpass(std::move(scene_subpass));
+
+	set_render_pipeline(std::move(render_pipeline));
+
+	update_resolve_mode();
+	last_resolve_mode = resolve_mode;
+
+	stats = std::make_unique<vkb::Stats>(std::set<vkb::StatIndex>{vkb::StatIndex::fragment_cycles,
+	                                                              vkb::StatIndex::l2_ext_read_bytes,
+	                                                              vkb::StatIndex::l2_ext_write_bytes});
+	gui   = std::make_unique<vkb::Gui>(*this, platform.get_window().get_dpi_factor());
+
+	return true;
+}
+
+void MSAASample::update(float delta_time)
+{
+	if (resolve_mode != last_resolve_mode)
+	{
+		update_resolve_mode();
+
+		last_resolve_mode = resolve_mode;
+	}
+
+	VulkanSample::update(delta_time);
+}
+
+void MSAASample::update_resolve_mode()
+{
+	auto &subpass = *get_render_pipeline().get_subpasses().at(0);
+
+	// Color is stored, depth is discarded
+	std::vector<vkb::LoadStoreInfo> load_store{2};
+	load_store[1].store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+	switch (resolve_mode)
+	{
+		case Disabled:
+			subpass.set_output_attachments({0});
+			get_render_context().update_render_targets(vkb::RenderTarget::DEFAULT_CREATE_FUNC);
+			break;
+		case OnTile:
+			// The render pass renders to the multisampled attachment and resolves it into attachment 0
+			subpass.set_output_attachments({0});
+			get_render_context().update_render_targets(vkb::RenderTarget::multisampled_create_func(sample_count));
+			break;
+		case Separate:
+			// The swapchain image is only written by the resolve after the render pass
+			subpass.set_output_attachments({2});
+			load_store.resize(3);
+			load_store[0].load_op  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			load_store[0].store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			get_render_context().update_render_targets(separate_resolve_create_func(sample_count));
+			break;
+		default:
+			assert(false && "Unknown resolve mode");
+			break;
+	}
+
+	get_render_pipeline().set_load_store(load_store);
+}
+
+void MSAASample::draw_renderpass(vkb::CommandBuffer &command_buffer, vkb::RenderTarget &render_target)
+{
+	VulkanSample::draw_renderpass(command_buffer, render_target);
+
+	if (resolve_mode != Separate)
+	{
+		return;
+	}
+
+	auto &views = render_target.get_views();
+
+	{
+		vkb::ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		command_buffer.image_memory_barrier(views.at(2), memory_barrier);
+
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		memory_barrier.src_access_mask = 0;
+		memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		command_buffer.image_memory_barrier(views.at(0), memory_barrier);
+	}
+
+	auto &extent = render_target.get_extent();
+
+	VkImageResolve region{};
+	region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+	region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+	region.extent         = {extent.width, extent.height, 1};
+
+	command_buffer.resolve_image(views.at(2).get_image(), views.at(0).get_image(), {region});
+
+	{
+		// Return the swapchain image to the layout the present barrier expects
+		vkb::ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+		command_buffer.image_memory_barrier(views.at(0), memory_barrier);
+	}
+}
+
+void MSAASample::draw_gui()
+{
+	gui->show_options_window(
+	    /* body = */ [this]() {
+		    ImGui::Text("4x MSAA resolve:");
+		    ImGui::RadioButton("Disabled", &resolve_mode, Disabled);
+		    ImGui::SameLine();
+		    ImGui::RadioButton("On tile", &resolve_mode, OnTile);
+		    ImGui::SameLine();
+		    ImGui::RadioButton("Separate", &resolve_mode, Separate);
+	    },
+	    /* lines = */ 2);
+}
+
+std::unique_ptr<vkb::VulkanSample> create_msaa()
+{
+	return std::make_unique<MSAASample>();
+}
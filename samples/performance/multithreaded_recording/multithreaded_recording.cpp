@@ -0,0 +1,263 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "multithreaded_recording.h"
+
+#include <algorithm>
+#include <numeric>
+#include <thread>
+
+#include "common/logging.h"
+#include "core/device.h"
+#include "gui.h"
+#include "platform/platform.h"
+#include "stats.h"
+
+constexpr uint32_t MultithreadedRecording::SWEEP_FRAME_COUNT;
+constexpr uint32_t MultithreadedRecording::WARMUP_FRAME_COUNT;
+
+MultithreadedRecording::MultithreadedRecording() :
+    max_thread_count{std::max(std::thread::hardware_concurrency(), MIN_THREAD_COUNT)}
+{
+	auto &config = get_configuration();
+
+	config.insert<vkb::IntSetting>(0, gui_thread_count, 1);
+	config.insert<vkb::IntSetting>(1, gui_thread_count, 2);
+	config.insert<vkb::IntSetting>(2, gui_thread_count, 4);
+	config.insert<vkb::IntSetting>(3, gui_thread_count, static_cast<int>(max_thread_count));
+}
+
+bool MultithreadedRecording::prepare(vkb::Platform &platform)
+{
+	if (!VulkanSample::prepare(platform))
+	{
+		return false;
+	}
+
+	load_scene("scenes/bonza/Bonza4X.gltf");
+
+	auto &camera_node = vkb::add_free_camera(*scene, "main_camera", get_render_context().get_surface_extent());
+	camera            = dynamic_cast<vkb::sg::PerspectiveCamera *>(&camera_node.get_component<vkb::sg::Camera>());
+
+	vkb::ShaderSource vert_shader("base.vert");
+	vkb::ShaderSource frag_shader("base.frag");
+	auto              scene_subpass = std::make_unique<vkb::ForwardSubpass>(get_render_context(), std::move(vert_shader), std::move(frag_shader), *scene, *camera);
+
+	forward_subpass = scene_subpass.get();
+
+	auto render_pipeline = vkb::RenderPipeline();
+	render_pipeline.add_subpass(std::move(scene_subpass));
+
+	set_render_pipeline(std::move(render_pipeline));
+
+	stats = std::make_unique<vkb::Stats>(std::set<vkb::StatIndex>{vkb::StatIndex::frame_times,
+	                                                              vkb::StatIndex::cpu_recording_time,
+	                                                              vkb::StatIndex::resource_cache_contentions});
+	gui   = std::make_unique<vkb::Gui>(*this, platform.get_window().get_dpi_factor());
+
+	results.resize(max_thread_count);
+
+	contention_count = get_contention_count();
+
+	return true;
+}
+
+void MultithreadedRecording::prepare_render_context()
+{
+	// Every frame holds the pools of the largest thread count, which the slider can select at any time
+	get_render_context().prepare(max_thread_count);
+}
+
+void MultithreadedRecording::update(float delta_time)
+{
+	record_frame();
+
+	if (gui_sweep != sweep_running)
+	{
+		sweep_running = gui_sweep;
+
+		if (sweep_running)
+		{
+			// The sweep starts over with fresh results from a single thread
+			results.assign(max_thread_count, ThreadCountResult{});
+
+			gui_thread_count = 1;
+		}
+	}
+
+	if (sweep_running)
+	{
+		update_sweep();
+	}
+
+	gui_thread_count = std::min(std::max(gui_thread_count, 1), static_cast<int>(max_thread_count));
+
+	forward_subpass->set_thread_count(vkb::to_u32(gui_thread_count));
+
+	VulkanSample::update(delta_time);
+}
+
+void MultithreadedRecording::record_frame()
+{
+	// Contentions since the previous frame, which covers the recording of the last frame
+	uint64_t contentions       = get_contention_count();
+	uint64_t frame_contentions = contentions - contention_count;
+	contention_count           = contentions;
+
+	uint32_t thread_count = forward_subpass->get_thread_count();
+
+	if (stats)
+	{
+		stats->set_value(vkb::StatIndex::cpu_recording_time, static_cast<float>(forward_subpass->get_recording_time()));
+	}
+
+	// The first frames with new threads include the creation of their buffer blocks and command buffers
+	if (thread_count != measured_thread_count)
+	{
+		measured_thread_count = thread_count;
+		warmup_frames         = WARMUP_FRAME_COUNT;
+	}
+
+	if (warmup_frames > 0)
+	{
+		warmup_frames--;
+		return;
+	}
+
+	const auto &thread_times = forward_subpass->get_thread_recording_times();
+
+	auto &result = results[thread_count - 1];
+
+	result.frame_count++;
+	result.recording_time += forward_subpass->get_recording_time();
+	result.busy_time += std::accumulate(thread_times.begin(), thread_times.end(), 0.0);
+	result.contentions += frame_contentions;
+
+	result.buffer_block_count = 0;
+	for (auto &render_frame : get_render_context().get_render_frames())
+	{
+		result.buffer_block_count += render_frame.get_buffer_block_count();
+	}
+}
+
+void MultithreadedRecording::update_sweep()
+{
+	if (results[gui_thread_count - 1].frame_count < SWEEP_FRAME_COUNT)
+	{
+		return;
+	}
+
+	if (vkb::to_u32(gui_thread_count) < max_thread_count)
+	{
+		gui_thread_count++;
+		return;
+	}
+
+	log_results();
+
+	gui_sweep     = false;
+	sweep_running = false;
+}
+
+void MultithreadedRecording::log_results() const
+{
+	double single_thread_time = results[0].get_mean_recording_time();
+
+	LOGI("Recording scaling of {} threads", max_thread_count);
+
+	for (uint32_t thread_count = 1; thread_count <= max_thread_count; thread_count++)
+	{
+		const auto &result = results[thread_count - 1];
+
+		if (result.frame_count == 0)
+		{
+			continue;
+		}
+
+		double recording_time = result.get_mean_recording_time();
+		double speedup        = recording_time > 0.0 ? single_thread_time / recording_time : 0.0;
+
+		LOGI("{:3} threads: {:7.3f} ms, speedup {:5.2f}, efficiency {:3.0f}%, {:6.1f} contentions/frame, {} buffer blocks",
+		     thread_count, recording_time, speedup, result.get_efficiency(thread_count) * 100.0,
+		     static_cast<double>(result.contentions) / result.frame_count, result.buffer_block_count);
+	}
+}
+
+uint64_t MultithreadedRecording::get_contention_count()
+{
+	auto &resource_cache = device->get_resource_cache();
+
+	uint64_t contentions = 0;
+	for (size_t i = 0; i < static_cast<size_t>(vkb::ResourceCacheType::Count); ++i)
+	{
+		contentions += resource_cache.get_stats(static_cast<vkb::ResourceCacheType>(i)).contentions;
+	}
+
+	return contentions;
+}
+
+void MultithreadedRecording::draw_gui()
+{
+	const uint32_t lines = 6;
+
+	gui->show_options_window(
+	    /* body = */ [this]() {
+		    ImGui::PushItemWidth(ImGui::GetWindowWidth() * 0.55f);
+		    ImGui::SliderInt("", &gui_thread_count, 1, static_cast<int>(max_thread_count), "Threads: %d");
+		    ImGui::PopItemWidth();
+		    ImGui::SameLine();
+		    ImGui::Checkbox("Sweep", &gui_sweep);
+
+		    // Mean recording time of each thread count, those not measured yet are left empty
+		    std::vector<float> recording_times(max_thread_count, 0.0f);
+		    std::transform(results.begin(), results.end(), recording_times.begin(),
+		                   [](const ThreadCountResult &result) { return static_cast<float>(result.get_mean_recording_time()); });
+
+		    float max_time = *std::max_element(recording_times.begin(), recording_times.end());
+
+		    ImGui::PlotHistogram("", recording_times.data(), static_cast<int>(recording_times.size()), 0, "Recording time per thread count",
+		                         0.0f, max_time * 1.1f, ImVec2(ImGui::GetWindowWidth() * 0.95f, ImGui::GetTextLineHeight() * 3.0f));
+
+		    const auto &result       = results[gui_thread_count - 1];
+		    double      single_time  = results[0].get_mean_recording_time();
+		    double      current_time = result.get_mean_recording_time();
+		    double      speedup      = current_time > 0.0 ? single_time / current_time : 0.0;
+		    double      contentions  = result.frame_count > 0 ? static_cast<double>(result.contentions) / result.frame_count : 0.0;
+
+		    ImGui::Text("%.3f ms, speedup x%.2f, efficiency %.0f%%", current_time, speedup, result.get_efficiency(vkb::to_u32(gui_thread_count)) * 100.0);
+		    ImGui::Text("Contentions/frame: %.1f, buffer blocks: %zu", contentions, result.buffer_block_count);
+	    },
+	    /* lines = */ lines);
+}
+
+double MultithreadedRecording::ThreadCountResult::get_mean_recording_time() const
+{
+	return frame_count > 0 ? recording_time / frame_count : 0.0;
+}
+
+double MultithreadedRecording::ThreadCountResult::get_efficiency(uint32_t thread_count) const
+{
+	return recording_time > 0.0 ? busy_time / (recording_time * thread_count) : 0.0;
+}
+
+std::unique_ptr<vkb::VulkanSample> create_multithreaded_recording()
+{
+	return std::make_unique<MultithreadedRecording>();
+}
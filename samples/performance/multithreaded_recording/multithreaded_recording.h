@@ -0,0 +1,125 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "rendering/subpasses/forward_subpass.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "vulkan_sample.h"
+
+/**
+ * @brief Sample measuring how the recording of the scene scales from one to many threads
+ *        The draws of the forward subpass are split among the recording threads, each with its
+ *        own command pools and buffer pools in the render frames. The results of each thread count
+ *        show how much of the added threads is lost to the contention of the resource cache locks
+ *        and to the allocation of the buffer blocks of new threads.
+ */
+class MultithreadedRecording : public vkb::VulkanSample
+{
+  public:
+	MultithreadedRecording();
+
+	virtual ~MultithreadedRecording() = default;
+
+	virtual bool prepare(vkb::Platform &platform) override;
+
+	virtual void update(float delta_time) override;
+
+	/**
+	 * @brief Measurements of the frames recorded with one thread count
+	 */
+	struct ThreadCountResult
+	{
+		uint32_t frame_count{0};
+
+		/// Total CPU time spent recording, in milliseconds
+		double recording_time{0.0};
+
+		/// Total CPU time the threads spent on recording jobs, in milliseconds
+		double busy_time{0.0};
+
+		/// Total resource cache requests which waited for a lock
+		uint64_t contentions{0};
+
+		/// Blocks of the buffer pools of all the render frames, once measured
+		size_t buffer_block_count{0};
+
+		double get_mean_recording_time() const;
+
+		/**
+		 * @return Share of the time of the threads spent on recording jobs, from 0 to 1
+		 */
+		double get_efficiency(uint32_t thread_count) const;
+	};
+
+  private:
+	virtual void prepare_render_context() override;
+
+	virtual void draw_gui() override;
+
+	/**
+	 * @brief Adds the measurements of the last frame to the results of its thread count
+	 */
+	void record_frame();
+
+	/**
+	 * @brief Moves the sweep to the next thread count once the current one has enough frames
+	 */
+	void update_sweep();
+
+	/**
+	 * @brief Logs the results of the thread counts measured so far
+	 */
+	void log_results() const;
+
+	uint64_t get_contention_count();
+
+	vkb::sg::PerspectiveCamera *camera{nullptr};
+
+	vkb::ForwardSubpass *forward_subpass{nullptr};
+
+	/// Frames measured per thread count by a sweep
+	static constexpr uint32_t SWEEP_FRAME_COUNT{120};
+
+	/// Frames skipped after changing the thread count, while the pools of new threads grow
+	static constexpr uint32_t WARMUP_FRAME_COUNT{10};
+
+	const uint32_t MIN_THREAD_COUNT{4};
+
+	uint32_t max_thread_count{0};
+
+	int gui_thread_count{1};
+
+	bool gui_sweep{false};
+
+	bool sweep_running{false};
+
+	/// Results indexed by thread count minus one
+	std::vector<ThreadCountResult> results;
+
+	/// Thread count of the frames being measured
+	uint32_t measured_thread_count{0};
+
+	uint32_t warmup_frames{0};
+
+	uint64_t contention_count{0};
+};
+
+std::unique_ptr<vkb::VulkanSample> create_multithreaded_recording();
@@ -0,0 +1,168 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "overdraw.h"
+
+#include "gui.h"
+#include "platform/platform.h"
+#include "stats.h"
+
+namespace
+{
+const char *MODE_NAMES[] = {"Sorted", "Unsorted", "Depth pre-pass"};
+}        // namespace
+
+Overdraw::Overdraw()
+{
+	auto &config = get_configuration();
+
+	config.insert<vkb::IntSetting>(0, gui_mode, static_cast<int>(Mode::Sorted));
+	config.insert<vkb::BoolSetting>(0, gui_visualize, false);
+	config.insert<vkb::IntSetting>(1, gui_mode, static_cast<int>(Mode::Unsorted));
+	config.insert<vkb::BoolSetting>(1, gui_visualize, false);
+	config.insert<vkb::IntSetting>(2, gui_mode, static_cast<int>(Mode::DepthPrepass));
+	config.insert<vkb::BoolSetting>(2, gui_visualize, false);
+	config.insert<vkb::IntSetting>(3, gui_mode, static_cast<int>(Mode::Unsorted));
+	config.insert<vkb::BoolSetting>(3, gui_visualize, true);
+}
+
+Overdraw::OverdrawSubpass::OverdrawSubpass(vkb::RenderContext &render_context,
+                                           vkb::ShaderSource &&vertex_shader, vkb::ShaderSource &&fragment_shader,
+                                           vkb::sg::Scene &scene_, vkb::sg::Camera &camera) :
+    vkb::ForwardSubpass{render_context, std::move(vertex_shader), std::move(fragment_shader), scene_, camera}
+{
+	vkb::ColorBlendAttachmentState additive_attachment{};
+	additive_attachment.blend_enable           = VK_TRUE;
+	additive_attachment.src_color_blend_factor = VK_BLEND_FACTOR_ONE;
+	additive_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE;
+	additive_attachment.src_alpha_blend_factor = VK_BLEND_FACTOR_ONE;
+	additive_attachment.dst_alpha_blend_factor = VK_BLEND_FACTOR_ONE;
+
+	additive_blend_state.attachments.resize(get_output_attachments().size());
+	additive_blend_state.attachments[0] = additive_attachment;
+}
+
+void Overdraw::OverdrawSubpass::draw_submesh(vkb::CommandBuffer &command_buffer, vkb::sg::SubMesh &sub_mesh, VkFrontFace front_face, uint32_t lod, uint32_t first_instance)
+{
+	// POI
+	//
+	// Every fragment which passes the depth test adds to the color of its pixel, opaque and transparent draws alike.
+	// The depth pre-pass draws do not write colors and are not counted.
+	command_buffer.set_color_blend_state(additive_blend_state);
+
+	vkb::ForwardSubpass::draw_submesh(command_buffer, sub_mesh, front_face, lod, first_instance);
+}
+
+bool Overdraw::prepare(vkb::Platform &platform)
+{
+	if (!VulkanSample::prepare(platform))
+	{
+		return false;
+	}
+
+	load_scene("scenes/sponza/Sponza01.gltf");
+
+	auto &camera_node = vkb::add_free_camera(*scene, "main_camera", get_render_context().get_surface_extent());
+	camera            = dynamic_cast<vkb::sg::PerspectiveCamera *>(&camera_node.get_component<vkb::sg::Camera>());
+
+	// The pre-pass is set up when the subpass is prepared, so each combination has its own pipeline
+	for (bool depth_prepass : {false, true})
+	{
+		for (bool visualize : {false, true})
+		{
+			render_pipelines.push_back(create_render_pipeline(depth_prepass, visualize));
+		}
+	}
+
+	stats = std::make_unique<vkb::Stats>(std::set<vkb::StatIndex>{vkb::StatIndex::frame_times,
+	                                                              vkb::StatIndex::fragment_cycles,
+	                                                              vkb::StatIndex::killed_tiles,
+	                                                              vkb::StatIndex::overdraw,
+	                                                              vkb::StatIndex::early_z_killed});
+	gui   = std::make_unique<vkb::Gui>(*this, platform.get_window().get_dpi_factor());
+
+	return true;
+}
+
+std::unique_ptr<vkb::RenderPipeline> Overdraw::create_render_pipeline(bool depth_prepass, bool visualize)
+{
+	vkb::ShaderSource vert_shader("base.vert");
+
+	std::unique_ptr<vkb::ForwardSubpass> scene_subpass;
+
+	if (visualize)
+	{
+		scene_subpass = std::make_unique<OverdrawSubpass>(get_render_context(), std::move(vert_shader), vkb::ShaderSource{"overdraw/overdraw.frag"}, *scene, *camera);
+	}
+	else
+	{
+		scene_subpass = std::make_unique<vkb::ForwardSubpass>(get_render_context(), std::move(vert_shader), vkb::ShaderSource{"base.frag"}, *scene, *camera);
+	}
+
+	// POI
+	//
+	// The pre-pass lays down the depth of the opaque draws first, then shades them with an EQUAL depth test,
+	// so that each pixel is shaded once whatever the order of the draws.
+	scene_subpass->set_depth_prepass_enabled(depth_prepass);
+
+	scene_subpasses.push_back(scene_subpass.get());
+
+	std::vector<std::unique_ptr<vkb::Subpass>> subpasses{};
+	subpasses.push_back(std::move(scene_subpass));
+
+	return std::make_unique<vkb::RenderPipeline>(std::move(subpasses));
+}
+
+void Overdraw::render(vkb::CommandBuffer &command_buffer)
+{
+	bool   depth_prepass = gui_mode == static_cast<int>(Mode::DepthPrepass);
+	size_t index         = (depth_prepass ? 2 : 0) + (gui_visualize ? 1 : 0);
+
+	// Without a pre-pass, how many fragments are shaded depends on the order of the opaque draws
+	scene_subpasses[index]->set_opaque_sort_policy(gui_mode == static_cast<int>(Mode::Unsorted) ? vkb::DrawSortPolicy::Unsorted : vkb::DrawSortPolicy::Depth);
+
+	render_pipelines[index]->draw(command_buffer, get_render_context().get_active_frame().get_render_target());
+}
+
+void Overdraw::draw_gui()
+{
+	bool     landscape = camera->get_aspect_ratio() > 1.0f;
+	uint32_t lines     = landscape ? 2 : 4;
+
+	gui->show_options_window(
+	    /* body = */ [&]() {
+		    for (int mode = 0; mode < static_cast<int>(Mode::Count); ++mode)
+		    {
+			    if (mode > 0 && landscape)
+			    {
+				    ImGui::SameLine();
+			    }
+			    ImGui::RadioButton(MODE_NAMES[mode], &gui_mode, mode);
+		    }
+
+		    ImGui::Checkbox("Visualize overdraw", &gui_visualize);
+	    },
+	    /* lines = */ lines);
+}
+
+std::unique_ptr<vkb::VulkanSample> create_overdraw()
+{
+	return std::make_unique<Overdraw>();
+}
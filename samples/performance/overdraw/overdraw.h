@@ -0,0 +1,92 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "rendering/render_pipeline.h"
+#include "rendering/subpasses/forward_subpass.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "vulkan_sample.h"
+
+/**
+ * @brief Sample comparing the overdraw of unsorted, front-to-back sorted and depth pre-pass rendering,
+ *        which can show the number of fragments shaded per pixel instead of the shaded scene
+ */
+class Overdraw : public vkb::VulkanSample
+{
+  public:
+	Overdraw();
+
+	virtual ~Overdraw() = default;
+
+	virtual bool prepare(vkb::Platform &platform) override;
+
+	/**
+	 * @brief Ways the opaque draws are ordered
+	 */
+	enum class Mode
+	{
+		Sorted,
+		Unsorted,
+		DepthPrepass,
+		Count
+	};
+
+	/**
+	 * @brief Forward subpass counting the fragments of each pixel with additive blending
+	 */
+	class OverdrawSubpass : public vkb::ForwardSubpass
+	{
+	  public:
+		OverdrawSubpass(vkb::RenderContext &render_context,
+		                vkb::ShaderSource &&vertex_source, vkb::ShaderSource &&fragment_source,
+		                vkb::sg::Scene &scene, vkb::sg::Camera &camera);
+
+	  protected:
+		virtual void draw_submesh(vkb::CommandBuffer &command_buffer, vkb::sg::SubMesh &sub_mesh, VkFrontFace front_face, uint32_t lod, uint32_t first_instance) override;
+
+	  private:
+		vkb::ColorBlendState additive_blend_state;
+	};
+
+  private:
+	virtual void draw_gui() override;
+
+	virtual void render(vkb::CommandBuffer &command_buffer) override;
+
+	/**
+	 * @param depth_prepass Whether the opaque draws lay down their depth in a pre-pass
+	 * @param visualize Whether the subpass counts the fragments instead of shading them
+	 */
+	std::unique_ptr<vkb::RenderPipeline> create_render_pipeline(bool depth_prepass, bool visualize);
+
+	vkb::sg::PerspectiveCamera *camera{nullptr};
+
+	/// Pipelines indexed by depth pre-pass, then by visualization
+	std::vector<std::unique_ptr<vkb::RenderPipeline>> render_pipelines;
+
+	std::vector<vkb::GeometrySubpass *> scene_subpasses;
+
+	int gui_mode{static_cast<int>(Mode::Sorted)};
+
+	bool gui_visualize{false};
+};
+
+std::unique_ptr<vkb::VulkanSample> create_overdraw();
@@ -54,7 +54,8 @@ PipelineCache::~PipelineCache()
 		/* Write pipeline cache data to a file in binary format */
 		vkb::fs::write_temp(data, "pipeline_cache.data");
 
-		/* Destroy Vulkan pipeline cache */
+		/* Destroy Vulkan pipeline cache, which the resource cache may outlive */
+		device->get_resource_cache().set_pipeline_cache(VK_NULL_HANDLE);
 		vkDestroyPipelineCache(device->get_handle(), pipeline_cache, nullptr);
 	}
 
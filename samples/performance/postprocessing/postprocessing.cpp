@@ -0,0 +1,130 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "postprocessing.h"
+
+#include "gui.h"
+#include "platform/platform.h"
+#include "rendering/subpasses/forward_subpass.h"
+#include "stats.h"
+
+PostProcessing::PostProcessing()
+{
+	auto &config = get_configuration();
+
+	config.insert<vkb::BoolSetting>(0, fxaa_enabled, false);
+	config.insert<vkb::BoolSetting>(0, bloom_enabled, false);
+	config.insert<vkb::BoolSetting>(1, fxaa_enabled, true);
+	config.insert<vkb::BoolSetting>(1, bloom_enabled, true);
+}
+
+bool PostProcessing::prepare(vkb::Platform &platform)
+{
+	if (!VulkanSample::prepare(platform))
+	{
+		return false;
+	}
+
+	load_scene("scenes/sponza/Sponza01.gltf");
+
+	auto &camera_node = vkb::add_free_camera(*scene, "main_camera", get_render_context().get_surface_extent());
+	camera            = &camera_node.get_component<vkb::sg::Camera>();
+
+	create_render_graph();
+
+	stats = std::make_unique<vkb::Stats>(std::set<vkb::StatIndex>{vkb::StatIndex::l2_ext_read_bytes, vkb::StatIndex::l2_ext_write_bytes});
+	gui   = std::make_unique<vkb::Gui>(*this, platform.get_window().get_dpi_factor());
+
+	return true;
+}
+
+void PostProcessing::update(float delta_time)
+{
+	if (fxaa_enabled != fxaa_enabled_last_value || bloom_enabled != bloom_enabled_last_value)
+	{
+		create_render_graph();
+
+		fxaa_enabled_last_value  = fxaa_enabled;
+		bloom_enabled_last_value = bloom_enabled;
+	}
+
+	auto &tonemapping_subpass = postprocessing_stack->get_tonemapping_subpass();
+
+	tonemapping_subpass.set_exposure(exposure);
+
+	if (bloom_enabled)
+	{
+		tonemapping_subpass.set_bloom_intensity(bloom_intensity);
+	}
+
+	VulkanSample::update(delta_time);
+}
+
+void PostProcessing::create_render_graph()
+{
+	auto render_graph = std::make_unique<vkb::RenderGraph>(get_render_context());
+
+	// The effects are set before the HDR attachment, whose usage depends on them
+	auto stack = std::make_unique<vkb::PostProcessingStack>(get_render_context());
+	stack->set_fxaa(fxaa_enabled);
+	stack->set_bloom(bloom_enabled, bloom_intensity);
+
+	uint32_t hdr_color = stack->add_hdr_attachment(*render_graph);
+	uint32_t depth     = render_graph->add_attachment("depth", VK_FORMAT_D32_SFLOAT);
+
+	vkb::ShaderSource vert_shader("base.vert");
+	vkb::ShaderSource frag_shader("base.frag");
+	auto              scene_subpass = std::make_unique<vkb::ForwardSubpass>(get_render_context(), std::move(vert_shader), std::move(frag_shader), *scene, *camera);
+
+	render_graph->add_pass(std::move(scene_subpass))
+	    .write(hdr_color)
+	    .write(depth);
+
+	// Tonemapping only reads the HDR color at the pixel it shades, so it is merged into the render pass of the scene,
+	// unless the bloom compute pass samples the HDR color in between, which splits the render pass
+	stack->add_passes(*render_graph, hdr_color);
+
+	render_graph->compile();
+
+	set_render_graph(std::move(render_graph));
+
+	postprocessing_stack = std::move(stack);
+}
+
+void PostProcessing::draw_gui()
+{
+	gui->show_options_window(
+	    /* body = */ [this]() {
+		    ImGui::Checkbox("FXAA", &fxaa_enabled);
+		    ImGui::SameLine();
+		    ImGui::Checkbox("Bloom", &bloom_enabled);
+		    ImGui::SliderFloat("Exposure", &exposure, 0.25f, 4.0f);
+		    if (bloom_enabled)
+		    {
+			    ImGui::SliderFloat("Bloom intensity", &bloom_intensity, 0.0f, 2.0f);
+		    }
+	    },
+	    /* lines = */ bloom_enabled ? 3 : 2);
+}
+
+std::unique_ptr<vkb::VulkanSample> create_postprocessing()
+{
+	return std::make_unique<PostProcessing>();
+}
@@ -0,0 +1,72 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "rendering/postprocessing_stack.h"
+#include "scene_graph/components/camera.h"
+#include "vulkan_sample.h"
+
+/**
+ * @brief Post-processing of an HDR color with the framework post-processing stack
+ *        Tonemapping reads the HDR color as an input attachment, in a subpass of the render pass
+ *        drawing the scene, so that the HDR color never leaves tile memory. FXAA samples the
+ *        tonemapped color, which has to be stored first, in a render pass of its own. Bloom is
+ *        a compute pass of the render graph, which samples the stored HDR color.
+ */
+class PostProcessing : public vkb::VulkanSample
+{
+  public:
+	PostProcessing();
+
+	virtual ~PostProcessing() = default;
+
+	virtual bool prepare(vkb::Platform &platform) override;
+
+	virtual void update(float delta_time) override;
+
+  private:
+	virtual void draw_gui() override;
+
+	/**
+	 * @brief Creates the render graph of the scene and of the enabled effects
+	 */
+	void create_render_graph();
+
+	vkb::sg::Camera *camera{nullptr};
+
+	/// Effects of the render graph, which owns their passes
+	std::unique_ptr<vkb::PostProcessingStack> postprocessing_stack;
+
+	bool fxaa_enabled{false};
+
+	bool fxaa_enabled_last_value{false};
+
+	bool bloom_enabled{false};
+
+	bool bloom_enabled_last_value{false};
+
+	float bloom_intensity{0.5f};
+
+	/// Exposure of the tonemapping, which is changed without recreating the passes
+	float exposure{1.0f};
+};
+
+std::unique_ptr<vkb::VulkanSample> create_postprocessing();
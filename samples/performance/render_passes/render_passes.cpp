@@ -36,13 +36,10 @@ RenderPassesSample::RenderPassesSample()
 {
 	auto &config = get_configuration();
 
-	config.insert<vkb::BoolSetting>(0, cmd_clear, false);
-	config.insert<vkb::IntSetting>(0, load.value, 0);
-	config.insert<vkb::IntSetting>(0, store.value, 0);
-
-	config.insert<vkb::BoolSetting>(1, cmd_clear, true);
-	config.insert<vkb::IntSetting>(1, load.value, 1);
-	config.insert<vkb::IntSetting>(1, store.value, 1);
+	// Every combination of the operations
+	config.add_axis(load.value, {0, 1, 2});
+	config.add_axis(store.value, {0, 1});
+	config.add_axis(cmd_clear);
 }
 
 void RenderPassesSample::reset_stats_view()
@@ -50,11 +47,13 @@ void RenderPassesSample::reset_stats_view()
 	if (load.value == VK_ATTACHMENT_LOAD_OP_LOAD)
 	{
 		gui->get_stats_view().reset_max_value(vkb::StatIndex::l2_ext_read_bytes);
+		gui->get_stats_view().reset_max_value(vkb::StatIndex::attachment_read_bytes);
 	}
 
 	if (store.value == VK_ATTACHMENT_STORE_OP_STORE)
 	{
 		gui->get_stats_view().reset_max_value(vkb::StatIndex::l2_ext_write_bytes);
+		gui->get_stats_view().reset_max_value(vkb::StatIndex::attachment_write_bytes);
 	}
 }
 
@@ -114,7 +113,9 @@ bool RenderPassesSample::prepare(vkb::Platform &platform)
 
 	auto enabled_stats = {vkb::StatIndex::fragment_cycles,
 	                      vkb::StatIndex::l2_ext_read_bytes,
-	                      vkb::StatIndex::l2_ext_write_bytes};
+	                      vkb::StatIndex::l2_ext_write_bytes,
+	                      vkb::StatIndex::attachment_read_bytes,
+	                      vkb::StatIndex::attachment_write_bytes};
 
 	stats = std::make_unique<vkb::Stats>(enabled_stats);
 
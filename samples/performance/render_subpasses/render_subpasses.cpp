@@ -24,7 +24,7 @@
 #include "platform/platform.h"
 #include "rendering/pipeline_state.h"
 #include "rendering/render_context.h"
-#include "rendering/render_pipeline.h"
+#include "rendering/render_graph.h"
 #include "rendering/subpasses/geometry_subpass.h"
 #include "rendering/subpasses/lighting_subpass.h"
 #include "scene_graph/node.h"
@@ -54,55 +54,36 @@ RenderSubpasses::RenderSubpasses()
 	config.insert<vkb::IntSetting>(3, configs[Config::GBufferSize].value, 1);
 }
 
-vkb::RenderTarget RenderSubpasses::create_render_target(vkb::core::Image &&swapchain_image)
+void RenderSubpasses::choose_g_buffer_formats()
 {
-	auto &device = swapchain_image.get_device();
-	auto &extent = swapchain_image.get_extent();
-
-	// G-Buffer should fit 128-bit budget for buffer color storage
-	// in order to enable subpasses merging by the driver
-	// Light (swapchain_image) RGBA8_UNORM   (32-bit)
-	// Albedo                  RGBA8_UNORM   (32-bit)
-	// Normal                  RGB10A2_UNORM (32-bit)
-
-	vkb::core::Image depth_image{device,
-	                             extent,
-	                             VK_FORMAT_D32_SFLOAT,
-	                             VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | rt_usage_flags,
-	                             VMA_MEMORY_USAGE_GPU_ONLY};
-
-	vkb::core::Image albedo_image{device,
-	                              extent,
-	                              albedo_format,
-	                              VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | rt_usage_flags,
-	                              VMA_MEMORY_USAGE_GPU_ONLY};
-
-	vkb::core::Image normal_image{device,
-	                              extent,
-	                              normal_format,
-	                              VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | rt_usage_flags,
-	                              VMA_MEMORY_USAGE_GPU_ONLY};
-
-	std::vector<vkb::core::Image> images;
-
-	// Attachment 0
-	images.push_back(std::move(swapchain_image));
-
-	// Attachment 1
-	images.push_back(std::move(depth_image));
-
-	// Attachment 2
-	images.push_back(std::move(albedo_image));
-
-	// Attachment 3
-	images.push_back(std::move(normal_image));
-
-	return vkb::RenderTarget{std::move(images)};
+	// The 128-bit G-buffer gives each attachment 32 bits, otherwise 64 bits
+	uint32_t bits_per_pixel = configs[Config::GBufferSize].value == 0 ? 32 : 64;
+
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+
+	// Largest formats first, the first one the device can render to within the budget is chosen.
+	// Neither 16-bit UNORM nor 10-bit normals are required to be renderable.
+	albedo_format = get_device().choose_attachment_format({VK_FORMAT_R16G16B16A16_UNORM,
+	                                                       VK_FORMAT_R16G16B16A16_SFLOAT,
+	                                                       VK_FORMAT_R8G8B8A8_UNORM},
+	                                                      usage, bits_per_pixel);
+
+	normal_format = get_device().choose_attachment_format({VK_FORMAT_R16G16B16A16_UNORM,
+	                                                       VK_FORMAT_R16G16B16A16_SFLOAT,
+	                                                       VK_FORMAT_A2R10G10B10_UNORM_PACK32,
+	                                                       VK_FORMAT_A2B10G10R10_UNORM_PACK32,
+	                                                       VK_FORMAT_R8G8B8A8_UNORM},
+	                                                      usage, bits_per_pixel);
+
+	LOGI("G-buffer formats: albedo {}, normal {}", vkb::convert_format_to_string(albedo_format), vkb::convert_format_to_string(normal_format));
 }
 
 void RenderSubpasses::prepare_render_context()
 {
-	get_render_context().prepare(1, std::bind(&RenderSubpasses::create_render_target, this, std::placeholders::_1));
+	choose_g_buffer_formats();
+
+	// The render targets are created by the render graph once it is compiled
+	VulkanSample::prepare_render_context();
 }
 
 bool RenderSubpasses::prepare(vkb::Platform &platform)
@@ -152,10 +133,7 @@ bool RenderSubpasses::prepare(vkb::Platform &platform)
 	auto &camera_node = vkb::add_free_camera(*scene, "main_camera", get_render_context().get_surface_extent());
 	camera            = dynamic_cast<vkb::sg::PerspectiveCamera *>(&camera_node.get_component<vkb::sg::Camera>());
 
-	render_pipeline = create_one_renderpass_two_subpasses();
-
-	geometry_render_pipeline = create_geometry_renderpass();
-	lighting_render_pipeline = create_lighting_renderpass();
+	create_render_graph();
 
 	// Enable gui
 	gui = std::make_unique<vkb::Gui>(*this, platform.get_window().get_dpi_factor());
@@ -172,67 +150,29 @@ bool RenderSubpasses::prepare(vkb::Platform &platform)
 
 void RenderSubpasses::update(float delta_time)
 {
-	// Check whether the user changed the render technique
-	if (configs[Config::RenderTechnique].value != last_render_technique)
-	{
-		LOGI("Changing render technique");
-		last_render_technique = configs[Config::RenderTechnique].value;
-
-		// Reset frames, their synchronization objects and their command buffers
-		for (auto &frame : get_render_context().get_render_frames())
-		{
-			frame.reset();
-		}
-	}
-
-	// Check whether the user switched the attachment or the G-buffer option
-	if (configs[Config::TransientAttachments].value != last_transient_attachment ||
+	// Check whether the user changed the render technique, the attachment or the G-buffer option
+	if (configs[Config::RenderTechnique].value != last_render_technique ||
+	    configs[Config::TransientAttachments].value != last_transient_attachment ||
 	    configs[Config::GBufferSize].value != last_g_buffer_size)
 	{
-		// If attachment option has changed
-		if (configs[Config::TransientAttachments].value != last_transient_attachment)
-		{
-			rt_usage_flags = VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
-
-			// If attachment should be transient
-			if (configs[Config::TransientAttachments].value == 0)
-			{
-				rt_usage_flags |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
-			}
-			else
-			{
-				LOGI("Creating non transient attachments");
-			}
-			last_transient_attachment = configs[Config::TransientAttachments].value;
-		}
-
-		// It G-buffer option has changed
+		// If G-buffer option has changed
 		if (configs[Config::GBufferSize].value != last_g_buffer_size)
 		{
-			if (configs[Config::GBufferSize].value == 0)
-			{
-				// Use less bits
-				albedo_format = VK_FORMAT_R8G8B8A8_UNORM;                  // 32-bit
-				normal_format = VK_FORMAT_A2R10G10B10_UNORM_PACK32;        // 32-bit
-			}
-			else
-			{
-				// Use more bits
-				albedo_format = VK_FORMAT_R16G16B16A16_UNORM;        // 64-bit
-				normal_format = VK_FORMAT_R16G16B16A16_UNORM;        // 64-bit
-			}
-
-			last_g_buffer_size = configs[Config::GBufferSize].value;
+			choose_g_buffer_formats();
 		}
 
+		last_render_technique     = configs[Config::RenderTechnique].value;
+		last_transient_attachment = configs[Config::TransientAttachments].value;
+		last_g_buffer_size        = configs[Config::GBufferSize].value;
+
 		// Reset frames, their synchronization objects and their command buffers
 		for (auto &frame : get_render_context().get_render_frames())
 		{
 			frame.reset();
 		}
 
-		LOGI("Recreating render target");
-		get_render_context().recreate();
+		LOGI("Recreating render graph");
+		create_render_graph();
 	}
 
 	VulkanSample::update(delta_time);
@@ -283,164 +223,52 @@ void RenderSubpasses::draw_gui()
 	    /* lines = */ vkb::to_u32(lines));
 }
 
-std::unique_ptr<vkb::RenderPipeline> RenderSubpasses::create_one_renderpass_two_subpasses()
+void RenderSubpasses::create_render_graph()
 {
-	// Geometry subpass
-	auto geometry_vs   = vkb::ShaderSource{"deferred/geometry.vert"};
-	auto geometry_fs   = vkb::ShaderSource{"deferred/geometry.frag"};
-	auto scene_subpass = std::make_unique<vkb::GeometrySubpass>(get_render_context(), std::move(geometry_vs), std::move(geometry_fs), *scene, *camera);
-
-	// Outputs are depth, albedo, and normal
-	scene_subpass->set_output_attachments({1, 2, 3});
-
-	// Lighting subpass
-	auto lighting_vs      = vkb::ShaderSource{"deferred/lighting.vert"};
-	auto lighting_fs      = vkb::ShaderSource{"deferred/lighting.frag"};
-	auto lighting_subpass = std::make_unique<vkb::LightingSubpass>(get_render_context(), std::move(lighting_vs), std::move(lighting_fs), *camera, *scene);
-
-	// Inputs are depth, albedo, and normal from the geometry subpass
-	lighting_subpass->set_input_attachments({1, 2, 3});
-
-	// Create subpasses pipeline
-	std::vector<std::unique_ptr<vkb::Subpass>> subpasses{};
-	subpasses.push_back(std::move(scene_subpass));
-	subpasses.push_back(std::move(lighting_subpass));
-
-	auto render_pipeline = std::make_unique<vkb::RenderPipeline>(std::move(subpasses));
+	auto graph = std::make_unique<vkb::RenderGraph>(get_render_context());
 
-	render_pipeline->set_load_store(vkb::gbuffer::get_clear_all_store_swapchain());
+	// Attachment 0 is the light (swapchain image), followed by the G-buffer
+	uint32_t depth  = graph->add_attachment("depth", VK_FORMAT_D32_SFLOAT);
+	uint32_t albedo = graph->add_attachment("albedo", albedo_format);
+	uint32_t normal = graph->add_attachment("normal", normal_format);
 
-	render_pipeline->set_clear_value(vkb::gbuffer::get_clear_value());
-
-	return render_pipeline;
-}
-
-std::unique_ptr<vkb::RenderPipeline> RenderSubpasses::create_geometry_renderpass()
-{
 	// Geometry subpass
 	auto geometry_vs   = vkb::ShaderSource{"deferred/geometry.vert"};
 	auto geometry_fs   = vkb::ShaderSource{"deferred/geometry.frag"};
 	auto scene_subpass = std::make_unique<vkb::GeometrySubpass>(get_render_context(), std::move(geometry_vs), std::move(geometry_fs), *scene, *camera);
 
-	// Outputs are depth, albedo, and normal
-	scene_subpass->set_output_attachments({1, 2, 3});
-
-	// Create geomtry pipeline
-	std::vector<std::unique_ptr<vkb::Subpass>> scene_subpasses{};
-	scene_subpasses.push_back(std::move(scene_subpass));
-
-	auto geometry_render_pipeline = std::make_unique<vkb::RenderPipeline>(std::move(scene_subpasses));
+	// Outputs are depth, albedo, and normal, cleared first
+	graph->add_pass(std::move(scene_subpass))
+	    .write(depth)
+	    .write(albedo)
+	    .write(normal);
 
-	geometry_render_pipeline->set_load_store(vkb::gbuffer::get_clear_store_all());
-
-	geometry_render_pipeline->set_clear_value(vkb::gbuffer::get_clear_value());
-
-	return geometry_render_pipeline;
-}
-
-std::unique_ptr<vkb::RenderPipeline> RenderSubpasses::create_lighting_renderpass()
-{
 	// Lighting subpass
 	auto lighting_vs      = vkb::ShaderSource{"deferred/lighting.vert"};
 	auto lighting_fs      = vkb::ShaderSource{"deferred/lighting.frag"};
 	auto lighting_subpass = std::make_unique<vkb::LightingSubpass>(get_render_context(), std::move(lighting_vs), std::move(lighting_fs), *camera, *scene);
 
-	// Inputs are depth, albedo, and normal from the geometry subpass
-	lighting_subpass->set_input_attachments({1, 2, 3});
-	// Create lighting pipeline
-	std::vector<std::unique_ptr<vkb::Subpass>> lighting_subpasses{};
-	lighting_subpasses.push_back(std::move(lighting_subpass));
-
-	auto lighting_render_pipeline = std::make_unique<vkb::RenderPipeline>(std::move(lighting_subpasses));
+	// Inputs are depth, albedo, and normal from the geometry subpass, and every pixel of the light is shaded
+	graph->add_pass(std::move(lighting_subpass))
+	    .read_input(depth)
+	    .read_input(albedo)
+	    .read_input(normal)
+	    .write(vkb::RenderGraph::SWAPCHAIN_ATTACHMENT, true);
 
-	lighting_render_pipeline->set_load_store(vkb::gbuffer::get_load_all_store_swapchain());
+	// The lighting pass only reads the G-buffer at the pixel it shades, through input attachments,
+	// so the graph folds it into the render pass of the geometry pass, and the G-buffer is neither stored nor loaded back
+	graph->set_pass_merging(configs[Config::RenderTechnique].value == 0);
 
-	lighting_render_pipeline->set_clear_value(vkb::gbuffer::get_clear_value());
+	graph->set_transient_attachments(configs[Config::TransientAttachments].value == 0);
 
-	return lighting_render_pipeline;
-}
-
-void draw_pipeline(vkb::CommandBuffer &command_buffer, vkb::RenderTarget &render_target, vkb::RenderPipeline &render_pipeline, vkb::Gui *gui = nullptr)
-{
-	auto &extent = render_target.get_extent();
-
-	VkViewport viewport{};
-	viewport.width    = static_cast<float>(extent.width);
-	viewport.height   = static_cast<float>(extent.height);
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-	command_buffer.set_viewport(0, {viewport});
-
-	VkRect2D scissor{};
-	scissor.extent = extent;
-	command_buffer.set_scissor(0, {scissor});
-
-	render_pipeline.draw(command_buffer, render_target);
+	graph->compile();
 
-	if (gui)
-	{
-		gui->draw(command_buffer);
-	}
-
-	command_buffer.end_render_pass();
-}
-
-void RenderSubpasses::draw_render_subpasses(vkb::CommandBuffer &command_buffer, vkb::RenderTarget &render_target)
-{
-	draw_pipeline(command_buffer, render_target, *render_pipeline, gui.get());
-}
-
-void RenderSubpasses::draw_renderpasses(vkb::CommandBuffer &command_buffer, vkb::RenderTarget &render_target)
-{
-	// First render pass (no gui)
-	draw_pipeline(command_buffer, render_target, *geometry_render_pipeline);
-
-	// Memory barriers needed
-	for (size_t i = 1; i < render_target.get_views().size(); ++i)
-	{
-		auto &view = render_target.get_views().at(i);
-
-		vkb::ImageMemoryBarrier barrier;
-
-		if (i == 1)
-		{
-			barrier.old_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-			barrier.new_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
-
-			barrier.src_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-			barrier.src_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-		}
-		else
-		{
-			barrier.old_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-			barrier.new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-			barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-			barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		}
-
-		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		barrier.dst_access_mask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
-
-		command_buffer.image_memory_barrier(view, barrier);
-	}
-
-	// Second render pass
-	draw_pipeline(command_buffer, render_target, *lighting_render_pipeline, gui.get());
-}
-
-void RenderSubpasses::draw_renderpass(vkb::CommandBuffer &command_buffer, vkb::RenderTarget &render_target)
-{
 	if (configs[Config::RenderTechnique].value == 0)
 	{
-		// Efficient way
-		draw_render_subpasses(command_buffer, render_target);
-	}
-	else
-	{
-		// Inefficient way
-		draw_renderpasses(command_buffer, render_target);
+		assert(graph->get_render_pass_count() == 1 && "Lighting pass should merge into the geometry render pass");
 	}
+
+	set_render_graph(std::move(graph));
 }
 
 std::unique_ptr<vkb::VulkanSample> create_render_subpasses()
@@ -20,7 +20,7 @@
 
 #pragma once
 
-#include "rendering/render_pipeline.h"
+#include "rendering/render_graph.h"
 #include "scene_graph/components/perspective_camera.h"
 #include "vulkan_sample.h"
 
@@ -30,6 +30,8 @@
   *        of multiple render passes. In order to highlight the difference, it
   *        implements deferred rendering with and without sub-passes, giving the
   *        user the possibility to change some key settings.
+  *        The passes are declared in a render graph, which merges them into sub-passes
+  *        and creates transient attachments unless the settings disable it.
   */
 class RenderSubpasses : public vkb::VulkanSample
 {
@@ -48,42 +50,17 @@ class RenderSubpasses : public vkb::VulkanSample
 	virtual void prepare_render_context() override;
 
 	/**
-	 * @return A good pipeline
+	 * @brief Creates the render graph of the geometry and lighting passes, with the selected settings
 	 */
-	std::unique_ptr<vkb::RenderPipeline> create_one_renderpass_two_subpasses();
+	void create_render_graph();
 
 	/**
-	 * @return A geometry render pass which should run first
+	 * @brief Chooses the albedo and normal formats fitting the selected G-buffer size among the ones the device supports
 	 */
-	std::unique_ptr<vkb::RenderPipeline> create_geometry_renderpass();
+	void choose_g_buffer_formats();
 
-	/**
-	 * @return A lighting render pass which should run second
-	 */
-	std::unique_ptr<vkb::RenderPipeline> create_lighting_renderpass();
-
-	/**
-	 * @brief Draws using the good pipeline: one render pass with two sub-passes
-	 */
-	void draw_render_subpasses(vkb::CommandBuffer &command_buffer, vkb::RenderTarget &render_target);
-
-	/**
-	 * @brief Draws using the bad practice: two separate render passes
-	 */
-	void draw_renderpasses(vkb::CommandBuffer &command_buffer, vkb::RenderTarget &render_target);
-
-	void draw_renderpass(vkb::CommandBuffer &command_buffer, vkb::RenderTarget &render_target) override;
-
-	vkb::RenderTarget create_render_target(vkb::core::Image &&swapchain_image);
-
-	/// Good pipeline with two subpasses within one render pass
-	std::unique_ptr<vkb::RenderPipeline> render_pipeline{};
-
-	/// 1. Bad pipeline with a geometry subpass in the first render pass
-	std::unique_ptr<vkb::RenderPipeline> geometry_render_pipeline{};
-
-	/// 2. Bad pipeline with a lighting subpass in the second render pass
-	std::unique_ptr<vkb::RenderPipeline> lighting_render_pipeline{};
+	/// Geometry and lighting passes, merged into one render pass with two subpasses by the good settings
+	std::unique_ptr<vkb::RenderGraph> render_graph{};
 
 	vkb::sg::PerspectiveCamera *camera{};
 
@@ -117,9 +94,8 @@ class RenderSubpasses : public vkb::VulkanSample
 	uint16_t last_transient_attachment{0};
 	uint16_t last_g_buffer_size{0};
 
-	VkFormat          albedo_format{VK_FORMAT_R8G8B8A8_UNORM};
-	VkFormat          normal_format{VK_FORMAT_A2R10G10B10_UNORM_PACK32};
-	VkImageUsageFlags rt_usage_flags{VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT};
+	VkFormat albedo_format{VK_FORMAT_R8G8B8A8_UNORM};
+	VkFormat normal_format{VK_FORMAT_A2R10G10B10_UNORM_PACK32};
 
 	std::vector<Config> configs = {
 	    {/* config      = */ Config::RenderTechnique,
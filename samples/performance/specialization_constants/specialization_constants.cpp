@@ -62,26 +62,11 @@ bool SpecializationConstants::prepare(vkb::Platform &platform)
 	return true;
 }
 
-void SpecializationConstants::ForwardSubpassCustomLights::prepare()
+void SpecializationConstants::ForwardSubpassCustomLights::add_subpass_definitions(vkb::ShaderVariant &variant)
 {
-	auto &device = render_context.get_device();
-	for (auto &mesh : meshes)
-	{
-		for (auto &sub_mesh : mesh->get_submeshes())
-		{
-			auto &variant = sub_mesh->get_mut_shader_variant();
-
-			// Same as Geometry except adds lighting definitions to sub mesh variants.
-			add_definitions(variant, {"MAX_FORWARD_LIGHT_COUNT " + std::to_string(LIGHT_COUNT)});
-			add_definitions(variant, vkb::light_type_definitions);
-
-			auto &vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
-			auto &frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
-
-			vert_module.set_resource_dynamic("GlobalUniform");
-			frag_module.set_resource_dynamic("GlobalUniform");
-		}
-	}
+	// Same as Forward except the lights are limited to the custom light count
+	add_definitions(variant, {"MAX_FORWARD_LIGHT_COUNT " + std::to_string(LIGHT_COUNT)});
+	add_definitions(variant, vkb::light_type_definitions);
 }
 
 void SpecializationConstants::render(vkb::CommandBuffer &command_buffer)
@@ -140,8 +125,8 @@ std::unique_ptr<vkb::RenderPipeline> SpecializationConstants::create_standard_re
 void SpecializationConstants::ForwardSubpassCustomLights::draw(vkb::CommandBuffer &command_buffer)
 {
 	// Override forward light subpass draw function to provide a custom number of lights
-	auto lights_buffer = allocate_set_num_lights<CustomForwardLights>(scene.get_components<vkb::sg::Light>(), static_cast<size_t>(LIGHT_COUNT));
-	command_buffer.bind_buffer(lights_buffer.get_buffer(), lights_buffer.get_offset(), lights_buffer.get_size(), 0, 4, 0);
+	// The lights are bound with the common resources of the forward subpass
+	lights_buffer = allocate_set_num_lights<CustomForwardLights>(scene.get_components<vkb::sg::Light>(), static_cast<size_t>(LIGHT_COUNT));
 
 	vkb::GeometrySubpass::draw(command_buffer);
 }
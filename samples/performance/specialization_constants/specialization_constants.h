@@ -58,9 +58,10 @@ class SpecializationConstants : public vkb::VulkanSample
 		                           vkb::ShaderSource &&vertex_source, vkb::ShaderSource &&fragment_source,
 		                           vkb::sg::Scene &scene, vkb::sg::Camera &camera);
 
-		virtual void prepare() override;
-
 		virtual void draw(vkb::CommandBuffer &command_buffer) override;
+
+	  protected:
+		virtual void add_subpass_definitions(vkb::ShaderVariant &variant) override;
 	};
 
   private:
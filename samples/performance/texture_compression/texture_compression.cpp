@@ -0,0 +1,184 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "texture_compression.h"
+
+#include "common/logging.h"
+#include "core/device.h"
+#include "gui.h"
+#include "platform/platform.h"
+#include "rendering/subpasses/forward_subpass.h"
+#include "scene_graph/node.h"
+#include "stats.h"
+#include "timer.h"
+
+namespace
+{
+const std::vector<TextureCompression::TextureFormat> TEXTURE_FORMATS = {
+    {"RGBA8", "", VK_FORMAT_R8G8B8A8_UNORM, 32.0f},
+    {"ASTC 4x4", "astc_4x4", VK_FORMAT_ASTC_4x4_UNORM_BLOCK, 8.0f},
+    {"ASTC 6x6", "astc_6x6", VK_FORMAT_ASTC_6x6_UNORM_BLOCK, 128.0f / 36.0f},
+    {"ASTC 8x8", "astc_8x8", VK_FORMAT_ASTC_8x8_UNORM_BLOCK, 2.0f},
+    {"ETC2", "etc2", VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, 8.0f}};
+}        // namespace
+
+TextureCompression::TextureCompression()
+{
+	auto &config = get_configuration();
+
+	for (size_t i = 0; i < TEXTURE_FORMATS.size(); ++i)
+	{
+		config.insert<vkb::IntSetting>(vkb::to_u32(i), gui_format, static_cast<int>(i));
+	}
+}
+
+bool TextureCompression::prepare(vkb::Platform &platform)
+{
+	if (!VulkanSample::prepare(platform))
+	{
+		return false;
+	}
+
+	for (auto &texture_format : TEXTURE_FORMATS)
+	{
+		supported_formats.push_back(device->is_image_format_supported(texture_format.format));
+	}
+
+	stats = std::make_unique<vkb::Stats>(std::set<vkb::StatIndex>{vkb::StatIndex::frame_times,
+	                                                              vkb::StatIndex::l2_ext_read_bytes,
+	                                                              vkb::StatIndex::tex_cycles,
+	                                                              vkb::StatIndex::device_memory_usage});
+	gui   = std::make_unique<vkb::Gui>(*this, platform.get_window().get_dpi_factor());
+
+	load_format(supported_formats[gui_format] ? gui_format : 0);
+
+	return true;
+}
+
+void TextureCompression::load_format(int format_index)
+{
+	auto &texture_format = TEXTURE_FORMATS[format_index];
+
+	// Keep the view of the previous scene
+	bool      camera_moved = camera != nullptr;
+	glm::vec3 translation;
+	glm::quat rotation;
+
+	if (camera_moved)
+	{
+		auto &transform = camera->get_node()->get_transform();
+		translation     = transform.get_translation();
+		rotation        = transform.get_rotation();
+
+		// The images of the previous scene are destroyed with it, along with the descriptor sets referring to them
+		device->wait_idle();
+
+		for (auto &render_frame : get_render_context().get_render_frames())
+		{
+			render_frame.clear_descriptors();
+		}
+
+		render_pipeline.reset();
+		scene.reset();
+	}
+
+	vkb::Timer timer;
+	timer.start();
+
+	set_image_variant(texture_format.image_variant);
+
+	load_scene("scenes/sponza/Sponza01.gltf");
+
+	load_time = static_cast<float>(timer.stop());
+
+	LOGI("Loaded the {} textures in {:.2f} s", texture_format.name, load_time);
+
+	auto &camera_node = vkb::add_free_camera(*scene, "main_camera", get_render_context().get_surface_extent());
+	camera            = dynamic_cast<vkb::sg::PerspectiveCamera *>(&camera_node.get_component<vkb::sg::Camera>());
+
+	if (camera_moved)
+	{
+		camera_node.get_transform().set_translation(translation);
+		camera_node.get_transform().set_rotation(rotation);
+	}
+
+	vkb::ShaderSource vert_shader("base.vert");
+	vkb::ShaderSource frag_shader("base.frag");
+	auto              scene_subpass = std::make_unique<vkb::ForwardSubpass>(get_render_context(), std::move(vert_shader), std::move(frag_shader), *scene, *camera);
+
+	auto render_pipeline = vkb::RenderPipeline();
+	render_pipeline.add_subpass(std::move(scene_subpass));
+
+	set_render_pipeline(std::move(render_pipeline));
+
+	loaded_format = format_index;
+}
+
+void TextureCompression::update(float delta_time)
+{
+	if (gui_format != loaded_format)
+	{
+		if (supported_formats[gui_format])
+		{
+			load_format(gui_format);
+		}
+		else
+		{
+			LOGW("{} textures are not supported by the device", TEXTURE_FORMATS[gui_format].name);
+			gui_format = loaded_format;
+		}
+	}
+
+	VulkanSample::update(delta_time);
+}
+
+void TextureCompression::draw_gui()
+{
+	bool     landscape = camera->get_aspect_ratio() > 1.0f;
+	uint32_t lines     = landscape ? 2 : 4;
+
+	gui->show_options_window(
+	    /* body = */ [&]() {
+		    for (size_t i = 0; i < TEXTURE_FORMATS.size(); ++i)
+		    {
+			    if (i > 0 && (landscape || i % 2 == 1))
+			    {
+				    ImGui::SameLine();
+			    }
+
+			    // Formats the device cannot sample are shown but cannot be selected
+			    if (!supported_formats[i])
+			    {
+				    ImGui::TextDisabled("%s", TEXTURE_FORMATS[i].name);
+				    continue;
+			    }
+
+			    ImGui::RadioButton(TEXTURE_FORMATS[i].name, &gui_format, static_cast<int>(i));
+		    }
+
+		    ImGui::Text("%.2f bits per pixel, loaded in %.2f s", TEXTURE_FORMATS[loaded_format].bits_per_pixel, load_time);
+	    },
+	    /* lines = */ lines);
+}
+
+std::unique_ptr<vkb::VulkanSample> create_texture_compression()
+{
+	return std::make_unique<TextureCompression>();
+}
@@ -0,0 +1,80 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "rendering/render_pipeline.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "vulkan_sample.h"
+
+/**
+ * @brief Sample loading the same scene with its textures in RGBA8, ASTC and ETC2,
+ *        to compare the texture bandwidth and memory of each format
+ */
+class TextureCompression : public vkb::VulkanSample
+{
+  public:
+	TextureCompression();
+
+	virtual ~TextureCompression() = default;
+
+	virtual bool prepare(vkb::Platform &platform) override;
+
+	virtual void update(float delta_time) override;
+
+	/**
+	 * @brief Format of a variant of the textures of the scene
+	 */
+	struct TextureFormat
+	{
+		const char *name;
+
+		/// Directory of the variant next to the scene, empty for the images of the glTF file
+		const char *image_variant;
+
+		/// Format the device must sample for the variant to be used
+		VkFormat format;
+
+		float bits_per_pixel;
+	};
+
+  private:
+	virtual void draw_gui() override;
+
+	/**
+	 * @brief Loads the scene with the images of a format, keeping the camera where it was
+	 */
+	void load_format(int format_index);
+
+	vkb::sg::PerspectiveCamera *camera{nullptr};
+
+	/// Whether the device can sample each format
+	std::vector<bool> supported_formats;
+
+	int gui_format{0};
+
+	/// Format of the scene currently loaded, -1 before the first load
+	int loaded_format{-1};
+
+	/// Seconds the last load took
+	float load_time{0.0f};
+};
+
+std::unique_ptr<vkb::VulkanSample> create_texture_compression();
@@ -21,8 +21,30 @@
 
 precision highp float;
 
-#ifdef HAS_BASE_COLOR_TEXTURE
-layout(set = 0, binding = 0) uniform sampler2D base_color_texture;
+#ifdef PARTITIONED_SETS
+// Resources are grouped by how often they change, so that only the sets that changed are bound for each draw
+#define FRAME_SET 0
+#define MATERIAL_SET 1
+#define DRAW_SET 2
+#else
+#define FRAME_SET 0
+#define MATERIAL_SET 0
+#define DRAW_SET 0
+#endif
+
+#if defined(BINDLESS_TEXTURES)
+// All the textures of the scene, indexed by the material push constants
+layout(set = FRAME_SET, binding = 5) uniform sampler2D textures[BINDLESS_TEXTURE_COUNT];
+#elif defined(TEXTURE_ARRAYS)
+// Images of the same format and size share an array, the material pushes the layer of its image
+layout(set = MATERIAL_SET, binding = 0) uniform sampler2DArray base_color_texture;
+#elif defined(HAS_BASE_COLOR_TEXTURE) || defined(SPECIALIZED_MATERIAL)
+layout(set = MATERIAL_SET, binding = 0) uniform sampler2D base_color_texture;
+#endif
+
+#ifdef SPECIALIZED_MATERIAL
+// The materials share a single shader, their textures are selected when creating the pipelines
+layout(constant_id = 10) const bool has_base_color_texture = false;
 #endif
 
 layout(location = 0) in vec4 in_pos;
@@ -31,14 +53,28 @@ layout(location = 2) in vec3 in_normal;
 
 layout(location = 0) out vec4 o_color;
 
-layout(set = 0, binding = 1) uniform GlobalUniform
+layout(set = DRAW_SET, binding = 1) uniform GlobalUniform
 {
 	mat4 model;
+#ifndef VIEW_UNIFORM
 	mat4 view_proj;
 	vec3 camera_position;
+#endif
 }
 global_uniform;
 
+#ifdef VIEW_UNIFORM
+// Written once per frame, the global uniform of each draw only holds its model matrix
+layout(set = FRAME_SET, binding = 12) uniform ViewUniform
+{
+	mat4 view_proj;
+	vec3 camera_position;
+}
+view_uniform;
+#else
+#define view_uniform global_uniform
+#endif
+
 struct Light
 {
 	vec4 position;         // position.w represents type of light
@@ -47,12 +83,42 @@ struct Light
 	vec2 info;             // (only used for spot lights) info.x represents light inner cone angle, info.y represents light outer cone angle
 };
 
-layout(set = 0, binding = 4) uniform LightsInfo
+#ifdef CLUSTERED_LIGHTING
+layout(set = FRAME_SET, binding = 4) uniform ClusterInfo
+{
+	mat4  view;
+	uvec4 grid;                 // xyz represents cluster counts, w represents directional light count
+	vec4  cluster_scale;        // xy represents clusters per pixel, z represents slice scale, w represents slice bias
+}
+cluster_info;
+
+// Directional lights first, then point lights
+layout(set = FRAME_SET, binding = 6, std430) readonly buffer ClusterLights
+{
+	Light light[];
+}
+lights;
+
+// Offset and count of the light indices of each cluster
+layout(set = FRAME_SET, binding = 7, std430) readonly buffer ClusterRanges
+{
+	uvec2 range[];
+}
+cluster_ranges;
+
+layout(set = FRAME_SET, binding = 8, std430) readonly buffer ClusterIndices
+{
+	uint index[];
+}
+cluster_indices;
+#else
+layout(set = FRAME_SET, binding = 4) uniform LightsInfo
 {
 	uint  count;
 	Light light[MAX_FORWARD_LIGHT_COUNT];
 }
 lights;
+#endif
 
 // Push constants come with a limitation in the size of data.
 // The standard requires at least 128 bytes
@@ -61,23 +127,30 @@ layout(push_constant, std430) uniform PBRMaterialUniform
 	vec4  base_color_factor;
 	float metallic_factor;
 	float roughness_factor;
+#ifdef BINDLESS_TEXTURES
+	uint  base_color_texture_index;
+	uint  normal_texture_index;
+	uint  metallic_roughness_texture_index;
+#elif defined(TEXTURE_ARRAYS)
+	uint  base_color_texture_layer;
+#endif
 }
 pbr_material_uniform;
 
-vec3 apply_directional_light(uint index, vec3 normal)
+vec3 apply_directional_light(Light light, vec3 normal)
 {
-	vec3 world_to_light = -lights.light[index].direction.xyz;
+	vec3 world_to_light = -light.direction.xyz;
 
 	world_to_light = normalize(world_to_light);
 
 	float ndotl = clamp(dot(normal, world_to_light), 0.0, 1.0);
 
-	return ndotl * lights.light[index].color.w * lights.light[index].color.rgb;
+	return ndotl * light.color.w * light.color.rgb;
 }
 
-vec3 apply_point_light(uint index, vec3 normal)
+vec3 apply_point_light(Light light, vec3 normal)
 {
-	vec3 world_to_light = lights.light[index].position.xyz - in_pos.xyz;
+	vec3 world_to_light = light.position.xyz - in_pos.xyz;
 
 	float dist = length(world_to_light);
 
@@ -87,7 +160,7 @@ vec3 apply_point_light(uint index, vec3 normal)
 
 	float ndotl = clamp(dot(normal, world_to_light), 0.0, 1.0);
 
-	return ndotl * lights.light[index].color.w * atten * lights.light[index].color.rgb;
+	return ndotl * light.color.w * atten * light.color.rgb;
 }
 
 void main(void)
@@ -96,22 +169,48 @@ void main(void)
 
 	vec3 light_contribution = vec3(0.0);
 
+#ifdef CLUSTERED_LIGHTING
+	for (uint i = 0U; i < cluster_info.grid.w; i++)
+	{
+		light_contribution += apply_directional_light(lights.light[i], normal);
+	}
+
+	// Exponential depth slices, matching the binning done on the CPU
+	float view_depth = -(cluster_info.view * in_pos).z;
+	float slice      = log(max(view_depth, 1e-4)) * cluster_info.cluster_scale.z + cluster_info.cluster_scale.w;
+
+	uvec3 cluster = uvec3(clamp(vec3(gl_FragCoord.xy * cluster_info.cluster_scale.xy, slice), vec3(0.0), vec3(cluster_info.grid.xyz - 1U)));
+	uint  cluster_index = (cluster.z * cluster_info.grid.y + cluster.y) * cluster_info.grid.x + cluster.x;
+
+	uvec2 range = cluster_ranges.range[cluster_index];
+	for (uint i = 0U; i < range.y; i++)
+	{
+		light_contribution += apply_point_light(lights.light[cluster_indices.index[range.x + i]], normal);
+	}
+#else
 	for (uint i = 0U; i < lights.count; i++)
 	{
 		if (lights.light[i].position.w == DIRECTIONAL_LIGHT)
 		{
-			light_contribution += apply_directional_light(i, normal);
+			light_contribution += apply_directional_light(lights.light[i], normal);
 		}
 		if (lights.light[i].position.w == POINT_LIGHT)
 		{
-			light_contribution += apply_point_light(i, normal);
+			light_contribution += apply_point_light(lights.light[i], normal);
 		}
 	}
+#endif
 
 	vec4 base_color = vec4(1.0, 0.0, 0.0, 1.0);
 
-#ifdef HAS_BASE_COLOR_TEXTURE
+#if defined(HAS_BASE_COLOR_TEXTURE) && defined(BINDLESS_TEXTURES)
+	base_color = texture(textures[pbr_material_uniform.base_color_texture_index], in_uv);
+#elif defined(TEXTURE_ARRAYS)
+	base_color = texture(base_color_texture, vec3(in_uv, float(pbr_material_uniform.base_color_texture_layer)));
+#elif defined(HAS_BASE_COLOR_TEXTURE)
 	base_color = texture(base_color_texture, in_uv);
+#elif defined(SPECIALIZED_MATERIAL)
+	base_color = has_base_color_texture ? texture(base_color_texture, in_uv) : pbr_material_uniform.base_color_factor;
 #else
 	base_color = pbr_material_uniform.base_color_factor;
 #endif
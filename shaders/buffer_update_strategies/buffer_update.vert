@@ -0,0 +1,93 @@
+#version 320 es
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// The sample defines one of these after the version directive to choose where the model matrix of a draw comes from:
+// MODEL_PUSH_CONSTANT reads it from push constants, MODEL_STORAGE_BUFFER from a buffer of the transforms
+// of all the nodes, indexed by the first instance of the draw. Otherwise it is part of the global uniform.
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec2 texcoord_0;
+#ifdef HAS_OCTAHEDRAL_NORMAL
+layout(location = 2) in vec2 normal;
+#else
+layout(location = 2) in vec3 normal;
+#endif
+
+layout(set = 0, binding = 1) uniform GlobalUniform {
+    mat4 model;
+    mat4 view_proj;
+    vec3 camera_position;
+} global_uniform;
+
+#if defined(MODEL_PUSH_CONSTANT)
+// Placed after the material push constants of the fragment shader
+layout(push_constant, std430) uniform ModelPushConstant
+{
+    layout(offset = 32) mat4 model;
+} model_push_constant;
+#elif defined(MODEL_STORAGE_BUFFER)
+layout(set = 0, binding = 10, std430) readonly buffer NodeTransforms
+{
+    mat4 node_transforms[];
+};
+#endif
+
+layout (location = 0) out vec4 o_pos;
+layout (location = 1) out vec2 o_uv;
+layout (location = 2) out vec3 o_normal;
+
+#ifdef HAS_OCTAHEDRAL_NORMAL
+vec3 decode_octahedral(vec2 encoded)
+{
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+
+    // Unfold the lower hemisphere from the corners of the square
+    float t = max(-n.z, 0.0);
+    n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+
+    return normalize(n);
+}
+#endif
+
+void main(void)
+{
+#if defined(MODEL_PUSH_CONSTANT)
+    mat4 model = model_push_constant.model;
+#elif defined(MODEL_STORAGE_BUFFER)
+    mat4 model = node_transforms[gl_InstanceIndex];
+#else
+    mat4 model = global_uniform.model;
+#endif
+
+    vec4 pos = model * vec4(position, 1.0);
+
+    o_pos = pos;
+
+    o_uv = texcoord_0;
+
+#ifdef HAS_OCTAHEDRAL_NORMAL
+    o_normal = mat3(model) * decode_octahedral(normal);
+#else
+    o_normal = mat3(model) * normal;
+#endif
+
+    gl_Position = global_uniform.view_proj * pos;
+}
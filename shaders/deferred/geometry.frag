@@ -21,8 +21,30 @@
 
 precision highp float;
 
-#ifdef HAS_BASE_COLOR_TEXTURE
-layout (set=0, binding=0) uniform sampler2D base_color_texture;
+#ifdef PARTITIONED_SETS
+// Resources are grouped by how often they change, so that only the sets that changed are bound for each draw
+#define FRAME_SET 0
+#define MATERIAL_SET 1
+#define DRAW_SET 2
+#else
+#define FRAME_SET 0
+#define MATERIAL_SET 0
+#define DRAW_SET 0
+#endif
+
+#if defined(BINDLESS_TEXTURES)
+// All the textures of the scene, indexed by the material push constants
+layout (set=FRAME_SET, binding=5) uniform sampler2D textures[BINDLESS_TEXTURE_COUNT];
+#elif defined(TEXTURE_ARRAYS)
+// Images of the same format and size share an array, the material pushes the layer of its image
+layout (set=MATERIAL_SET, binding=0) uniform sampler2DArray base_color_texture;
+#elif defined(HAS_BASE_COLOR_TEXTURE) || defined(SPECIALIZED_MATERIAL)
+layout (set=MATERIAL_SET, binding=0) uniform sampler2D base_color_texture;
+#endif
+
+#ifdef SPECIALIZED_MATERIAL
+// The materials share a single shader, their textures are selected when creating the pipelines
+layout (constant_id = 10) const bool has_base_color_texture = false;
 #endif
 
 layout (location = 0) in vec4 in_pos;
@@ -32,16 +54,35 @@ layout (location = 2) in vec3 in_normal;
 layout (location = 0) out vec4 o_albedo;
 layout (location = 1) out vec4 o_normal;
 
-layout(set = 0, binding = 1) uniform GlobalUniform {
+layout(set = DRAW_SET, binding = 1) uniform GlobalUniform {
     mat4 model;
+#ifndef VIEW_UNIFORM
     mat4 view_proj;
     vec3 camera_position;
+#endif
 } global_uniform;
 
+#ifdef VIEW_UNIFORM
+// Written once per frame, the global uniform of each draw only holds its model matrix
+layout(set = FRAME_SET, binding = 12) uniform ViewUniform {
+    mat4 view_proj;
+    vec3 camera_position;
+} view_uniform;
+#else
+#define view_uniform global_uniform
+#endif
+
 layout(push_constant, std430) uniform PBRMaterialUniform {
     vec4 base_color_factor;
     float metallic_factor;
     float roughness_factor;
+#ifdef BINDLESS_TEXTURES
+    uint base_color_texture_index;
+    uint normal_texture_index;
+    uint metallic_roughness_texture_index;
+#elif defined(TEXTURE_ARRAYS)
+    uint base_color_texture_layer;
+#endif
 } pbr_material_uniform;
 
 void main(void)
@@ -52,8 +93,14 @@ void main(void)
 
     vec4 base_color = vec4(1.0, 0.0, 0.0, 1.0);
 
-#ifdef HAS_BASE_COLOR_TEXTURE
+#if defined(HAS_BASE_COLOR_TEXTURE) && defined(BINDLESS_TEXTURES)
+    base_color = texture(textures[pbr_material_uniform.base_color_texture_index], in_uv);
+#elif defined(TEXTURE_ARRAYS)
+    base_color = texture(base_color_texture, vec3(in_uv, float(pbr_material_uniform.base_color_texture_layer)));
+#elif defined(HAS_BASE_COLOR_TEXTURE)
     base_color = texture(base_color_texture, in_uv);
+#elif defined(SPECIALIZED_MATERIAL)
+    base_color = has_base_color_texture ? texture(base_color_texture, in_uv) : pbr_material_uniform.base_color_factor;
 #else
     base_color = pbr_material_uniform.base_color_factor;
 #endif
@@ -19,27 +19,116 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#ifdef PARTITIONED_SETS
+// Resources are grouped by how often they change, so that only the sets that changed are bound for each draw
+#define FRAME_SET 0
+#define MATERIAL_SET 1
+#define DRAW_SET 2
+#else
+#define FRAME_SET 0
+#define MATERIAL_SET 0
+#define DRAW_SET 0
+#endif
+
 layout(location = 0) in vec3 position;
+#ifndef DEPTH_ONLY
 layout(location = 1) in vec2 texcoord_0;
+#ifdef HAS_OCTAHEDRAL_NORMAL
+// Octahedron encoded at load time
+layout(location = 2) in vec2 normal;
+#else
 layout(location = 2) in vec3 normal;
+#endif
+#endif
+
+#ifdef INSTANCING
+layout(location = 3) in mat4 instance_model;
+#endif
+
+#if defined(HAS_JOINTS_0) && defined(HAS_WEIGHTS_0)
+#define SKINNING
+
+layout(location = 7) in uvec4 joints_0;
+layout(location = 8) in vec4 weights_0;
+
+// Written once per frame for each skinned node
+layout(set = DRAW_SET, binding = 9, std430) readonly buffer JointMatrices
+{
+    mat4 joint_matrices[];
+};
+#endif
 
-layout(set = 0, binding = 1) uniform GlobalUniform {
+layout(set = DRAW_SET, binding = 1) uniform GlobalUniform {
     mat4 model;
+#ifndef VIEW_UNIFORM
     mat4 view_proj;
     vec3 camera_position;
+#endif
 } global_uniform;
 
+#ifdef VIEW_UNIFORM
+// Written once per frame, the global uniform of each draw only holds its model matrix
+layout(set = FRAME_SET, binding = 12) uniform ViewUniform {
+    mat4 view_proj;
+    vec3 camera_position;
+} view_uniform;
+#else
+#define view_uniform global_uniform
+#endif
+
+#ifndef DEPTH_ONLY
 layout (location = 0) out vec4 o_pos;
 layout (location = 1) out vec2 o_uv;
 layout (location = 2) out vec3 o_normal;
+#endif
+
+// The depth pre-pass and the shading pass must compute the same depth to pass an EQUAL depth test
+invariant gl_Position;
+
+#ifdef HAS_OCTAHEDRAL_NORMAL
+vec3 decode_octahedral(vec2 encoded)
+{
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+
+    // Unfold the lower hemisphere from the corners of the square
+    float t = max(-n.z, 0.0);
+    n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+
+    return normalize(n);
+}
+#endif
 
 void main(void)
 {
-    o_pos = global_uniform.model * vec4(position, 1.0);
+#ifdef INSTANCING
+    mat4 model = instance_model;
+#else
+    mat4 model = global_uniform.model;
+#endif
+
+#ifdef SKINNING
+    mat4 skin = weights_0.x * joint_matrices[joints_0.x] +
+                weights_0.y * joint_matrices[joints_0.y] +
+                weights_0.z * joint_matrices[joints_0.z] +
+                weights_0.w * joint_matrices[joints_0.w];
+
+    // The joint matrices move the vertices within the space of the mesh
+    model = model * skin;
+#endif
+
+    vec4 pos = model * vec4(position, 1.0);
+
+#ifndef DEPTH_ONLY
+    o_pos = pos;
 
     o_uv = texcoord_0;
 
-    o_normal = mat3(global_uniform.model) * normal;
+#ifdef HAS_OCTAHEDRAL_NORMAL
+    o_normal = mat3(model) * decode_octahedral(normal);
+#else
+    o_normal = mat3(model) * normal;
+#endif
+#endif
 
-    gl_Position = global_uniform.view_proj * o_pos;
+    gl_Position = view_uniform.view_proj * pos;
 }
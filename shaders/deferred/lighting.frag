@@ -44,27 +44,57 @@ struct Light
 	vec2 info;             // (only used for spot lights) info.x represents light inner cone angle, info.y represents light outer cone angle
 };
 
+#ifdef TILED_LIGHTING
+layout(set = 0, binding = 4) uniform TileInfo
+{
+	mat4  view;
+	uvec4 grid;                 // xy represents tile counts, w represents directional light count
+	vec4  tile_scale;           // xy represents tiles per pixel
+}
+tile_info;
+
+// Directional lights first, then point lights
+layout(set = 0, binding = 6, std430) readonly buffer TileLights
+{
+	Light lights[];
+}
+lights;
+
+// Offset and count of the light indices of each tile
+layout(set = 0, binding = 7, std430) readonly buffer TileRanges
+{
+	uvec2 range[];
+}
+tile_ranges;
+
+layout(set = 0, binding = 8, std430) readonly buffer TileIndices
+{
+	uint index[];
+}
+tile_indices;
+#else
 layout(set = 0, binding = 4) uniform LightsInfo
 {
 	uint  count;
 	Light lights[MAX_DEFERRED_LIGHT_COUNT];
 }
 lights;
+#endif
 
-vec3 apply_directional_light(uint index, vec3 normal)
+vec3 apply_directional_light(Light light, vec3 normal)
 {
-	vec3 world_to_light = -lights.lights[index].direction.xyz;
+	vec3 world_to_light = -light.direction.xyz;
 
 	world_to_light = normalize(world_to_light);
 
 	float ndotl = clamp(dot(normal, world_to_light), 0.0, 1.0);
 
-	return ndotl * lights.lights[index].color.w * lights.lights[index].color.rgb;
+	return ndotl * light.color.w * light.color.rgb;
 }
 
-vec3 apply_point_light(uint index, vec3 pos, vec3 normal)
+vec3 apply_point_light(Light light, vec3 pos, vec3 normal)
 {
-	vec3 world_to_light = lights.lights[index].position.xyz - pos;
+	vec3 world_to_light = light.position.xyz - pos;
 
 	float dist = length(world_to_light) * 0.005;
 
@@ -74,7 +104,7 @@ vec3 apply_point_light(uint index, vec3 pos, vec3 normal)
 
 	float ndotl = clamp(dot(normal, world_to_light), 0.0, 1.0);
 
-	return ndotl * lights.lights[index].color.w * atten * lights.lights[index].color.rgb;
+	return ndotl * light.color.w * atten * light.color.rgb;
 }
 
 void main()
@@ -92,17 +122,32 @@ void main()
 	// Calculate lighting
 	vec3 L = vec3(0.0);
 
+#ifdef TILED_LIGHTING
+	for (uint i = 0U; i < tile_info.grid.w; i++)
+	{
+		L += apply_directional_light(lights.lights[i], normal);
+	}
+
+	uvec2 tile       = uvec2(clamp(gl_FragCoord.xy * tile_info.tile_scale.xy, vec2(0.0), vec2(tile_info.grid.xy - 1U)));
+	uvec2 tile_range = tile_ranges.range[tile.y * tile_info.grid.x + tile.x];
+
+	for (uint i = 0U; i < tile_range.y; i++)
+	{
+		L += apply_point_light(lights.lights[tile_indices.index[tile_range.x + i]], pos, normal);
+	}
+#else
 	for (uint i = 0U; i < lights.count; i++)
 	{
 		if (lights.lights[i].position.w == DIRECTIONAL_LIGHT)
 		{
-			L += apply_directional_light(i, normal);
+			L += apply_directional_light(lights.lights[i], normal);
 		}
 		if (lights.lights[i].position.w == POINT_LIGHT)
 		{
-			L += apply_point_light(i, pos, normal);
+			L += apply_point_light(lights.lights[i], pos, normal);
 		}
 	}
+#endif
 
 	vec3 ambient_color = vec3(0.2) * albedo.xyz;
 
@@ -0,0 +1,43 @@
+#version 320 es
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+layout(push_constant, std430) uniform OcclusionBox {
+    mat4 view_proj;
+    vec4 bounds_min;
+    vec4 bounds_max;
+} box;
+
+// Two triangles for each face of the box, the bits of each index select the maximum bound of x, y and z
+const int corners[36] = int[36](0, 2, 6, 0, 6, 4,
+                                1, 5, 7, 1, 7, 3,
+                                0, 4, 5, 0, 5, 1,
+                                2, 3, 7, 2, 7, 6,
+                                0, 1, 3, 0, 3, 2,
+                                4, 6, 7, 4, 7, 5);
+
+void main(void)
+{
+    int corner = corners[gl_VertexIndex];
+
+    vec3 weight = vec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1);
+
+    gl_Position = box.view_proj * vec4(mix(box.bounds_min.xyz, box.bounds_max.xyz, weight), 1.0);
+}
@@ -0,0 +1,41 @@
+#version 320 es
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+precision highp float;
+
+// Added by every fragment with additive blending, so that the red channel saturates after 16 layers
+#define OVERDRAW_INCREMENT vec3(1.0 / 16.0, 1.0 / 32.0, 1.0 / 64.0)
+
+layout(location = 0) out vec4 o_color;
+
+// Pushed by every draw of the geometry subpass, the material does not change the fragment count
+layout(push_constant, std430) uniform PBRMaterialUniform
+{
+	vec4  base_color_factor;
+	float metallic_factor;
+	float roughness_factor;
+}
+pbr_material_uniform;
+
+void main(void)
+{
+	o_color = vec4(OVERDRAW_INCREMENT, 1.0);
+}
@@ -32,16 +32,39 @@
 
 precision highp float;
 
-#ifdef HAS_BASE_COLOR_TEXTURE
-layout(set = 0, binding = 0) uniform sampler2D base_color_texture;
+#ifdef PARTITIONED_SETS
+// Resources are grouped by how often they change, so that only the sets that changed are bound for each draw
+#define FRAME_SET 0
+#define MATERIAL_SET 1
+#define DRAW_SET 2
+#else
+#define FRAME_SET 0
+#define MATERIAL_SET 0
+#define DRAW_SET 0
+#endif
+
+#if defined(SPECIALIZED_MATERIAL) || defined(UBER_MATERIAL)
+// The textures of the material are selected at run time instead of by defines
+#define SELECTED_MATERIAL_TEXTURES
+#endif
+
+#ifdef SPECIALIZED_MATERIAL
+// The materials share a single shader, their textures are selected when creating the pipelines
+layout(constant_id = 10) const bool has_base_color_texture         = false;
+layout(constant_id = 11) const bool has_normal_texture             = false;
+layout(constant_id = 12) const bool has_metallic_roughness_texture = false;
+#endif
+
+#if defined(HAS_BASE_COLOR_TEXTURE) || defined(SELECTED_MATERIAL_TEXTURES)
+layout(set = MATERIAL_SET, binding = 0) uniform sampler2D base_color_texture;
 #endif
 
-#ifdef HAS_NORMAL_TEXTURE
-layout(set = 0, binding = 2) uniform sampler2D normal_texture;
+#if defined(HAS_NORMAL_TEXTURE) || defined(SELECTED_MATERIAL_TEXTURES)
+layout(set = MATERIAL_SET, binding = 2) uniform sampler2D normal_texture;
 #endif
 
-#ifdef HAS_METALLIC_ROUGHNESS_TEXTURE
-layout(set = 0, binding = 3) uniform sampler2D metallic_roughness_texture;
+#if defined(HAS_METALLIC_ROUGHNESS_TEXTURE) || defined(SELECTED_MATERIAL_TEXTURES)
+layout(set = MATERIAL_SET, binding = 3) uniform sampler2D metallic_roughness_texture;
 #endif
 
 layout(location = 0) in vec3 in_pos;
@@ -50,14 +73,28 @@ layout(location = 2) in vec3 in_normal;
 
 layout(location = 0) out vec4 o_color;
 
-layout(set = 0, binding = 1) uniform GlobalUniform
+layout(set = DRAW_SET, binding = 1) uniform GlobalUniform
 {
 	mat4 model;
+#ifndef VIEW_UNIFORM
 	mat4 view_proj;
 	vec3 camera_position;
+#endif
 }
 global_uniform;
 
+#ifdef VIEW_UNIFORM
+// Written once per frame, the global uniform of each draw only holds its model matrix
+layout(set = FRAME_SET, binding = 12) uniform ViewUniform
+{
+	mat4 view_proj;
+	vec3 camera_position;
+}
+view_uniform;
+#else
+#define view_uniform global_uniform
+#endif
+
 struct Light
 {
 	vec4 position;         // position.w represents type of light
@@ -66,21 +103,42 @@ struct Light
 	vec2 info;             // (only used for spot lights) info.x represents light inner cone angle, info.y represents light outer cone angle
 };
 
-layout(set = 0, binding = 4) uniform LightsInfo
+layout(set = FRAME_SET, binding = 4) uniform LightsInfo
 {
 	uint  count;
 	Light lights[MAX_FORWARD_LIGHT_COUNT];
 }
 lights;
 
+#ifdef SHADOWS
+layout(set = FRAME_SET, binding = 10) uniform highp sampler2DShadow shadow_atlas;
+
+layout(set = FRAME_SET, binding = 11) uniform ShadowInfo
+{
+	mat4 light_matrices[MAX_SHADOW_CASCADES];
+	vec4 cascade_info;        // x represents cascade count, y represents the index of the light, z represents the size of a texel
+}
+shadow_info;
+#endif
+
 layout(push_constant, std430) uniform PBRMaterialUniform
 {
 	vec4  base_color_factor;
 	float metallic_factor;
 	float roughness_factor;
+#ifdef UBER_MATERIAL
+	uint texture_mask;
+#endif
 }
 pbr_material_uniform;
 
+#ifdef UBER_MATERIAL
+// The materials share a single shader, their textures are selected by the material push constants
+#define has_base_color_texture ((pbr_material_uniform.texture_mask & 1u) != 0u)
+#define has_normal_texture ((pbr_material_uniform.texture_mask & 2u) != 0u)
+#define has_metallic_roughness_texture ((pbr_material_uniform.texture_mask & 4u) != 0u)
+#endif
+
 const float PI = 3.14159265359;
 
 vec3 F0 = vec3(0.04);
@@ -145,9 +203,17 @@ vec3 normal()
 	vec3 B      = normalize(cross(N, T));
 	mat3 TBN    = mat3(T, B, N);
 
-#ifdef HAS_NORMAL_TEXTURE
+#if defined(HAS_NORMAL_TEXTURE)
 	vec3 n = texture(normal_texture, in_uv).rgb;
 	return normalize(TBN * (2.0 * n - 1.0));
+#elif defined(SELECTED_MATERIAL_TEXTURES)
+	if (has_normal_texture)
+	{
+		vec3 n = texture(normal_texture, in_uv).rgb;
+		return normalize(TBN * (2.0 * n - 1.0));
+	}
+
+	return normalize(TBN[2].xyz);
 #else
 	return normalize(TBN[2].xyz);
 #endif
@@ -194,6 +260,41 @@ vec3 apply_point_light(uint index, vec3 normal)
 	return ndotl * lights.lights[index].color.w * atten * lights.lights[index].color.rgb;
 }
 
+#ifdef SHADOWS
+// Fraction of the shadowed light reaching the fragment, from the finest cascade containing it
+float get_shadow()
+{
+	uint  cascade_count = uint(shadow_info.cascade_info.x);
+	float texel_size    = shadow_info.cascade_info.z;
+
+	for (uint i = 0U; i < cascade_count; ++i)
+	{
+		vec4 coord = shadow_info.light_matrices[i] * vec4(in_pos, 1.0);
+
+		// The filter taps must stay within the tile of the cascade in the atlas
+		if (any(lessThan(coord.xy, vec2(2.0 * texel_size))) || any(greaterThan(coord.xy, vec2(1.0 - 2.0 * texel_size))) || coord.z < 0.0)
+		{
+			continue;
+		}
+
+		vec2  uv     = vec2((float(i) + coord.x) / float(cascade_count), coord.y);
+		vec2  offset = 0.5 * vec2(texel_size / float(cascade_count), texel_size);
+		float depth  = min(coord.z, 1.0);
+
+		// Four filtered comparisons half a texel apart cover 3x3 texels
+		float lit = texture(shadow_atlas, vec3(uv + vec2(-offset.x, -offset.y), depth)) +
+		            texture(shadow_atlas, vec3(uv + vec2(offset.x, -offset.y), depth)) +
+		            texture(shadow_atlas, vec3(uv + vec2(-offset.x, offset.y), depth)) +
+		            texture(shadow_atlas, vec3(uv + vec2(offset.x, offset.y), depth));
+
+		return 0.25 * lit;
+	}
+
+	// Beyond the last cascade
+	return 1.0;
+}
+#endif
+
 vec3 get_light_direction(uint index)
 {
 	if (lights.lights[index].position.w == DIRECTIONAL_LIGHT)
@@ -213,22 +314,28 @@ void main(void)
 	float F90        = saturate(50.0 * F0.r);
 	vec4  base_color = vec4(1.0, 0.0, 0.0, 1.0);
 
-#ifdef HAS_BASE_COLOR_TEXTURE
+#if defined(HAS_BASE_COLOR_TEXTURE)
 	base_color = texture(base_color_texture, in_uv);
+#elif defined(SELECTED_MATERIAL_TEXTURES)
+	base_color = has_base_color_texture ? texture(base_color_texture, in_uv) : pbr_material_uniform.base_color_factor;
 #else
 	base_color      = pbr_material_uniform.base_color_factor;
 #endif
 
-#ifdef HAS_METALLIC_ROUGHNESS_TEXTURE
+#if defined(HAS_METALLIC_ROUGHNESS_TEXTURE)
 	float roughness = saturate(texture(metallic_roughness_texture, in_uv).g);
 	float metallic  = saturate(texture(metallic_roughness_texture, in_uv).b);
+#elif defined(SELECTED_MATERIAL_TEXTURES)
+	vec4  metallic_roughness = has_metallic_roughness_texture ? texture(metallic_roughness_texture, in_uv) : vec4(0.0, pbr_material_uniform.roughness_factor, pbr_material_uniform.metallic_factor, 0.0);
+	float roughness          = saturate(metallic_roughness.g);
+	float metallic           = saturate(metallic_roughness.b);
 #else
 	float roughness = pbr_material_uniform.roughness_factor;
 	float metallic  = pbr_material_uniform.metallic_factor;
 #endif
 
 	vec3  N     = normal();
-	vec3  V     = normalize(global_uniform.camera_position - in_pos);
+	vec3  V     = normalize(view_uniform.camera_position - in_pos);
 	float NdotV = saturate(dot(N, V));
 
 	vec3 LightContribution = vec3(0.0);
@@ -250,9 +357,17 @@ void main(void)
 
 		float Fd = Fr_DisneyDiffuse(NdotV, NdotL, LdotH, roughness);
 
+		float shadow = 1.0;
+#ifdef SHADOWS
+		if (i == uint(shadow_info.cascade_info.y))
+		{
+			shadow = get_shadow();
+		}
+#endif
+
 		if (lights.lights[i].position.w == DIRECTIONAL_LIGHT)
 		{
-			LightContribution += apply_directional_light(i, N) * (diffuse_color * (vec3(1.0) - F) * Fd + Fr);
+			LightContribution += shadow * apply_directional_light(i, N) * (diffuse_color * (vec3(1.0) - F) * Fd + Fr);
 		}
 		if (lights.lights[i].position.w == POINT_LIGHT)
 		{
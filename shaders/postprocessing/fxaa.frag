@@ -0,0 +1,89 @@
+#version 320 es
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+precision mediump float;
+
+layout(set = 0, binding = 0) uniform sampler2D ldr_color;
+
+layout(location = 0) in vec2 in_uv;
+
+layout(location = 0) out vec4 o_color;
+
+layout(push_constant, std430) uniform Fxaa
+{
+	vec2 inv_resolution;
+}
+fxaa;
+
+const float FXAA_EDGE_THRESHOLD     = 0.125;
+const float FXAA_EDGE_THRESHOLD_MIN = 0.0312;
+const float FXAA_REDUCE_MIN         = 1.0 / 128.0;
+const float FXAA_REDUCE_MUL         = 1.0 / 8.0;
+const float FXAA_SPAN_MAX           = 8.0;
+
+float get_luma(vec3 color)
+{
+	// Perceptual luma of the linear color
+	return sqrt(dot(color, vec3(0.299, 0.587, 0.114)));
+}
+
+void main()
+{
+	vec3 rgb_m  = texture(ldr_color, in_uv).rgb;
+	vec3 rgb_nw = textureOffset(ldr_color, in_uv, ivec2(-1, -1)).rgb;
+	vec3 rgb_ne = textureOffset(ldr_color, in_uv, ivec2(1, -1)).rgb;
+	vec3 rgb_sw = textureOffset(ldr_color, in_uv, ivec2(-1, 1)).rgb;
+	vec3 rgb_se = textureOffset(ldr_color, in_uv, ivec2(1, 1)).rgb;
+
+	float luma_m  = get_luma(rgb_m);
+	float luma_nw = get_luma(rgb_nw);
+	float luma_ne = get_luma(rgb_ne);
+	float luma_sw = get_luma(rgb_sw);
+	float luma_se = get_luma(rgb_se);
+
+	float luma_min = min(luma_m, min(min(luma_nw, luma_ne), min(luma_sw, luma_se)));
+	float luma_max = max(luma_m, max(max(luma_nw, luma_ne), max(luma_sw, luma_se)));
+
+	// Skip the pixels which are not on an edge
+	if (luma_max - luma_min < max(FXAA_EDGE_THRESHOLD_MIN, luma_max * FXAA_EDGE_THRESHOLD))
+	{
+		o_color = vec4(rgb_m, 1.0);
+		return;
+	}
+
+	// Blur along the edge
+	vec2 dir = vec2(-((luma_nw + luma_ne) - (luma_sw + luma_se)), (luma_nw + luma_sw) - (luma_ne + luma_se));
+
+	float dir_reduce  = max((luma_nw + luma_ne + luma_sw + luma_se) * (0.25 * FXAA_REDUCE_MUL), FXAA_REDUCE_MIN);
+	float rcp_dir_min = 1.0 / (min(abs(dir.x), abs(dir.y)) + dir_reduce);
+
+	dir = clamp(dir * rcp_dir_min, vec2(-FXAA_SPAN_MAX), vec2(FXAA_SPAN_MAX)) * fxaa.inv_resolution;
+
+	vec3 rgb_a = 0.5 * (texture(ldr_color, in_uv + dir * (1.0 / 3.0 - 0.5)).rgb +
+	                    texture(ldr_color, in_uv + dir * (2.0 / 3.0 - 0.5)).rgb);
+	vec3 rgb_b = rgb_a * 0.5 + 0.25 * (texture(ldr_color, in_uv - dir * 0.5).rgb +
+	                                   texture(ldr_color, in_uv + dir * 0.5).rgb);
+
+	float luma_b = get_luma(rgb_b);
+
+	// The wider blur crossed another edge
+	o_color = vec4((luma_b < luma_min || luma_b > luma_max) ? rgb_a : rgb_b, 1.0);
+}
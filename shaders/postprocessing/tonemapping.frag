@@ -0,0 +1,104 @@
+#version 320 es
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+precision mediump float;
+
+// Read in place from tile memory, the lighting subpass rendering the HDR color stays on-tile
+layout(input_attachment_index = 0, set = 0, binding = 0) uniform subpassInput i_hdr_color;
+
+#ifdef BLOOM
+// Bloom at reduced resolution, each texel holding rgb as half floats
+layout(std430, set = 0, binding = 1) readonly buffer Bloom
+{
+	uvec2 texels[];
+}
+bloom;
+#endif
+
+layout(location = 0) out vec4 o_color;
+
+layout(push_constant, std430) uniform PostProcessing
+{
+	vec4  tint;                    // tint.w represents exposure
+	vec4  grading;                 // grading.x represents contrast, grading.y saturation, grading.z bloom intensity
+	uvec2 bloom_extent;
+	vec2  bloom_scale;             // bloom texels per pixel
+}
+post_processing;
+
+#ifdef BLOOM
+vec3 load_bloom(ivec2 coord)
+{
+	coord = clamp(coord, ivec2(0), ivec2(post_processing.bloom_extent) - 1);
+
+	uvec2 texel = bloom.texels[uint(coord.y) * post_processing.bloom_extent.x + uint(coord.x)];
+
+	return vec3(unpackHalf2x16(texel.x), unpackHalf2x16(texel.y).x);
+}
+
+vec3 sample_bloom(vec2 position)
+{
+	// Bilinear filtering of the bloom texels
+	vec2  base   = floor(position);
+	vec2  weight = position - base;
+	ivec2 coord  = ivec2(base);
+
+	vec3 top    = mix(load_bloom(coord), load_bloom(coord + ivec2(1, 0)), weight.x);
+	vec3 bottom = mix(load_bloom(coord + ivec2(0, 1)), load_bloom(coord + ivec2(1, 1)), weight.x);
+
+	return mix(top, bottom, weight.y);
+}
+#endif
+
+// Fitted ACES filmic curve
+vec3 tonemap_aces(vec3 x)
+{
+	const float a = 2.51;
+	const float b = 0.03;
+	const float c = 2.43;
+	const float d = 0.59;
+	const float e = 0.14;
+
+	return clamp((x * (a * x + b)) / (x * (c * x + d) + e), 0.0, 1.0);
+}
+
+void main()
+{
+	highp vec3 color = subpassLoad(i_hdr_color).rgb;
+
+#ifdef BLOOM
+	color += sample_bloom(gl_FragCoord.xy * post_processing.bloom_scale - 0.5) * post_processing.grading.z;
+#endif
+
+	color *= post_processing.tint.w;
+
+#ifdef COLOR_GRADING
+	color *= post_processing.tint.rgb;
+
+	float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+	color           = max(mix(vec3(luminance), color, post_processing.grading.y), 0.0);
+
+	// Contrast around middle grey
+	color = pow(color / 0.18, vec3(post_processing.grading.x)) * 0.18;
+#endif
+
+	o_color = vec4(tonemap_aces(color), 1.0);
+}
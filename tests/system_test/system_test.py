@@ -19,7 +19,7 @@
  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 '''
 
-import sys, os, math, platform, threading, datetime, subprocess, zipfile, argparse, shutil, struct, imghdr
+import sys, os, math, platform, threading, datetime, subprocess, zipfile, argparse, shutil, struct, imghdr, json, re
 from time import sleep
 from threading import Thread
 
@@ -42,6 +42,23 @@ image_ext         = ".png"
 android_timeout   = 60 # How long in seconds should we wait before timing out on Android
 check_step        = 5
 threshold         = 0.999 # How similar the images are allowed to be before they pass
+benchmark_frames  = 0 # How many frames the tests are benchmarked for, 0 disables the performance test
+default_benchmark_frames = 500 # How many frames the tests are benchmarked for when --benchmark is passed without a count
+baselines_path    = os.path.join(script_path, "baselines/")
+report_name       = "benchmark_report.json"
+soak_minutes      = 0 # How many minutes each test is soaked for, 0 disables the soak test
+soak_report_name  = "soak_report.json"
+update_baselines  = False
+tolerances        = { "frame_time": 0.10, "counters": 0.05 } # How much slower than the baseline a metric is allowed to be before it fails
+
+# Metrics compared against the baselines, as (name, tolerance, hwcpipe counter name)
+performance_metrics = [
+    ("frame_time_p50",       "frame_time", None),
+    ("frame_time_p95",       "frame_time", None),
+    ("gpu_cycles",           "counters",   "GpuCycles"),
+    ("external_read_bytes",  "counters",   "ExternalMemoryReadBytes"),
+    ("external_write_bytes", "counters",   "ExternalMemoryWriteBytes")
+]
 
 class Subtest:
     result = False
@@ -52,12 +69,26 @@ class Subtest:
         self.test_name = test_name
         self.platform = platform
 
+    def get_report_path(self):
+        return os.path.join(tmp_path, self.platform, self.test_name) + os.sep
+
     def run(self, application_path):
         result = True
         path = root_path + application_path
         arguments = ["--test", "{}".format(self.test_name), "--headless"]
+        environment = os.environ.copy()
+        if benchmark_frames > 0:
+            arguments += ["--benchmark", "{}".format(benchmark_frames)]
+            if soak_minutes > 0:
+                arguments += ["--soak", "{}".format(soak_minutes)]
+            # The benchmark report is written to the temporary directory, so give each test its own
+            report_path = self.get_report_path()
+            if not os.path.exists(report_path):
+                os.makedirs(report_path)
+            for variable in ["TMPDIR", "TMP", "TEMP"]:
+                environment[variable] = report_path
         try:
-            subprocess.run([path] + arguments, cwd=root_path)
+            subprocess.run([path] + arguments, cwd=root_path, env=environment)
         except FileNotFoundError:
             print("\t\t\t(Error) Couldn't find application ({})".format(path))
             result = False
@@ -78,6 +109,11 @@ class Subtest:
             return
         if not test(self.test_name, screenshot_path):
             self.result = False
+        if soak_minutes > 0:
+            if not test_soak(self.get_report_path() + soak_report_name):
+                self.result = False
+        elif benchmark_frames > 0 and not test_performance(self.test_name, self.get_report_path() + report_name):
+            self.result = False
         if self.result:
             print("\t\t=== Passed! ===")
         else:
@@ -108,7 +144,10 @@ class AndroidSubtest(Subtest):
 
     def run(self):
         subprocess.run("adb shell am force-stop com.arm.vulkan_best_practice")
-        subprocess.run(["adb", "shell", "am", "start", "-W", "-n", "com.arm.vulkan_best_practice/com.arm.vulkan_best_practice.BPSampleActivity", "-e", "test", "{0}".format(self.test_name)], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        arguments = ["-e", "test", "{0}".format(self.test_name)]
+        if benchmark_frames > 0:
+            arguments += ["-e", "benchmark", "{0}".format(benchmark_frames)]
+        subprocess.run(["adb", "shell", "am", "start", "-W", "-n", "com.arm.vulkan_best_practice/com.arm.vulkan_best_practice.BPSampleActivity"] + arguments, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
         output = subprocess.check_output("adb shell dumpsys window windows | grep -E 'mCurrentFocus|mFocusedApp' | cut -d . -f 5 | cut -d ' ' -f 1")
         activity = "".join(output.decode("utf-8").split())
         timeout_counter = 0
@@ -119,6 +158,13 @@ class AndroidSubtest(Subtest):
             activity = "".join(output.decode("utf-8").split())
         if timeout_counter <= android_timeout:
             subprocess.run(["adb", "pull", "/sdcard/Android/data/com.arm.vulkan_best_practice/files/" + outputs_path + self.test_name + image_ext, os.path.join(root_path, outputs_path)], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+            if benchmark_frames > 0:
+                # The report is written to the app cache directory, which is only readable from the app itself
+                report_path = self.get_report_path()
+                if not os.path.exists(report_path):
+                    os.makedirs(report_path)
+                with open(report_path + report_name, "wb") as report_file:
+                    subprocess.run(["adb", "exec-out", "run-as", "com.arm.vulkan_best_practice", "cat", "cache/" + report_name], stdout=report_file, stderr=subprocess.DEVNULL)
             return True
         else:
             print("\t\t\t(Error) Timed out")
@@ -203,6 +249,87 @@ def test(test_name, screenshot_path):
         result = True
     return result
 
+def get_performance_metrics(report):
+    """
+    @brief   Gets the metrics compared against the baselines from a benchmark report
+    @param   report The benchmark report written by the application
+    @return  A dictionary of the metrics found in the report, stats not supported by the device are left out
+    """
+    metrics = {}
+    frame_time = report.get("frame_time_ms", {})
+    for percentile in ["p50", "p95"]:
+        if percentile in frame_time:
+            metrics["frame_time_" + percentile] = frame_time[percentile]
+    stats = report.get("stats", {})
+    # The report maps the hwcpipe name of each counter to the key of the stat sampling it
+    counters = report.get("counters", {})
+    for name, _, counter_name in performance_metrics:
+        if counter_name is None or counter_name not in counters:
+            continue
+        values = stats.get(counters[counter_name], [])
+        if len(values) > 0:
+            metrics[name] = sum(values) / len(values)
+    return metrics
+
+def test_performance(test_name, report_path):
+    """
+    @brief   Tests the benchmark report of a test against the baseline of the device it ran on
+    @param   test_name   The name of the test, used to retrieve the respective baseline
+    @param   report_path The path to the benchmark report
+    @return  True if no metric is slower than the baseline by more than its tolerance
+    """
+    try:
+        with open(report_path) as report_file:
+            report = json.load(report_file)
+    except (FileNotFoundError, ValueError):
+        print("\t\t\t(Error) Couldn't read benchmark report ({}), perhaps test crashed".format(report_path))
+        return False
+    device_name = re.sub(r"[^A-Za-z0-9_.-]+", "_", report.get("device", {}).get("name", "unknown"))
+    baseline_path = baselines_path + "{0}/{1}.json".format(device_name, test_name)
+    metrics = get_performance_metrics(report)
+    if update_baselines:
+        if not os.path.exists(os.path.dirname(baseline_path)):
+            os.makedirs(os.path.dirname(baseline_path))
+        with open(baseline_path, "w") as baseline_file:
+            json.dump(metrics, baseline_file, indent=4, sort_keys=True)
+        print("\t\t\t(Baseline updated) '{}'".format(baseline_path))
+        return True
+    if not os.path.isfile(baseline_path):
+        print("\t\t\t(Error) Baseline not found ({}), record it with --update-baselines".format(baseline_path))
+        return False
+    with open(baseline_path) as baseline_file:
+        baseline = json.load(baseline_file)
+    result = True
+    for name, tolerance, _ in performance_metrics:
+        if name not in baseline or name not in metrics:
+            continue
+        limit = baseline[name] * (1.0 + tolerances[tolerance])
+        change = 100 * (metrics[name] - baseline[name]) / baseline[name] if baseline[name] != 0 else 0.0
+        print("\t\t\t(Comparing {0}) {1:.3f} with baseline {2:.3f}: {3:+.2f}%".format(name, metrics[name], baseline[name], change), end = " ")
+        if metrics[name] > limit:
+            print("(Regression, tolerance {:.2f}%)".format(100 * tolerances[tolerance]))
+            result = False
+        else:
+            print("")
+    return result
+
+def test_soak(report_path):
+    """
+    @brief   Tests the soak report of a test for metrics which drifted from the first run of their configuration
+    @param   report_path The path to the soak report
+    @return  True if the application reported no drift
+    """
+    try:
+        with open(report_path) as report_file:
+            report = json.load(report_file)
+    except (FileNotFoundError, ValueError):
+        print("\t\t\t(Error) Couldn't read soak report ({}), perhaps test crashed".format(report_path))
+        return False
+    print("\t\t\t(Soak) {} runs in {:.0f} s".format(len(report.get("runs", [])), report.get("duration", 0.0)))
+    for drift in report.get("drifts", []):
+        print("\t\t\t(Drift) {0} of {1}: {2:.3f} with baseline {3:.3f} after {4:.0f} s".format(drift["metric"], drift["key"], drift["value"], drift["baseline"], drift["elapsed_time"]))
+    return report.get("passed", False)
+
 def execute(app):
     print("\t=== Running {} on {} ===".format(app.test_name, app.platform))
     if app.run():
@@ -273,6 +400,11 @@ if __name__ == "__main__":
     argparser.add_argument("-C", "--config", required=True, help="build configuration to use")
     argparser.add_argument("-S", "--subtests", default=os.listdir(os.path.join(script_path, "sub_tests")), nargs="+", help="if set the specified sub tests will be run instead")
     argparser.add_argument("-P", "--parallel", action='store_true', help="flag to deploy tests in parallel")
+    argparser.add_argument("--benchmark", type=int, nargs="?", default=benchmark_frames, const=default_benchmark_frames, help="flag to benchmark each test and compare it against the baseline of the device, optionally with the number of frames")
+    argparser.add_argument("--frame-time-tolerance", type=float, default=tolerances["frame_time"], help="fraction the frame time may exceed the baseline by")
+    argparser.add_argument("--counter-tolerance", type=float, default=tolerances["counters"], help="fraction the GPU cycles and bandwidth counters may exceed the baseline by")
+    argparser.add_argument("--soak", type=int, default=soak_minutes, help="number of minutes to soak each test for, cycling runs of the benchmark frames, 0 disables the soak test, implies --benchmark")
+    argparser.add_argument("--update-baselines", action='store_true', help="flag to store the benchmark results as the baselines of the device instead of testing them")
     build_group = argparser.add_mutually_exclusive_group()
     build_group.add_argument("-D", "--desktop", action='store_false', help="flag to only deploy tests on desktop")
     build_group.add_argument("-A", "--android", action='store_false', help="flag to only deploy tests on android")
@@ -284,6 +416,15 @@ if __name__ == "__main__":
     test_desktop  = args["android"]
     test_android  = args["desktop"]
     multithread   = args["parallel"]
+    benchmark_frames = args["benchmark"]
+    update_baselines = args["update_baselines"]
+    soak_minutes     = args["soak"]
+    tolerances["frame_time"] = args["frame_time_tolerance"]
+    tolerances["counters"]   = args["counter_tolerance"]
+
+    # Soak runs and baseline updates are made of benchmark runs
+    if benchmark_frames == 0 and (soak_minutes > 0 or update_baselines):
+        benchmark_frames = default_benchmark_frames
 
     if build_path[-1] != "/":
         build_path += "/"
@@ -39,6 +39,15 @@ bool VulkanTest::prepare(vkb::Platform &platform)
 
 	this->platform = &platform;
 
+	if (is_benchmark_mode())
+	{
+		// Counters compared by the system test against the device baselines
+		stats = std::make_unique<vkb::Stats>(std::set<vkb::StatIndex>{vkb::StatIndex::frame_times,
+		                                                              vkb::StatIndex::gpu_cycles,
+		                                                              vkb::StatIndex::l2_ext_read_bytes,
+		                                                              vkb::StatIndex::l2_ext_write_bytes});
+	}
+
 	return true;
 }
 
@@ -46,9 +55,19 @@ void VulkanTest::update(float delta_time)
 {
 	VulkanSample::update(delta_time);
 
-	screenshot(get_render_context(), get_name());
+	if (!screenshot_taken)
+	{
+		// The test exits right after, so the image is written before returning
+		screenshot_blocking(get_render_context(), get_name());
+
+		screenshot_taken = true;
+	}
 
-	end();
+	// In benchmark mode the platform closes the test once all frames are rendered
+	if (!is_benchmark_mode())
+	{
+		end();
+	}
 }
 
 void VulkanTest::end()
@@ -41,5 +41,7 @@ class VulkanTest : public vkb::VulkanSample
 
   private:
 	vkb::Platform *platform;
+
+	bool screenshot_taken{false};
 };
 }        // namespace vkbtest
@@ -21,6 +21,9 @@
 #include "vulkan_best_practice.h"
 
 #include "common/logging.h"
+#include "draw_list_benchmark.h"
+#include "load_benchmark.h"
+#include "platform/filesystem.h"
 #include "platform/platform.h"
 
 #if defined(VK_USE_PLATFORM_ANDROID_KHR)
@@ -113,7 +116,9 @@ VulkanBestPractice::VulkanBestPractice()
 	    R"(Vulkan Best Practice.
 	Usage:
 		vulkan_best_practice <sample>
-		vulkan_best_practice (--sample <arg> | --test <arg> | --batch <arg>) [--benchmark <frames>] [--width <arg>] [--height <arg>] [--headless] 
+		vulkan_best_practice (--sample <arg> | --test <arg> | --batch <arg>) [--benchmark <frames>] [--width <arg>] [--height <arg>] [--headless] [--trace] [--sweep | --soak <minutes>] [--shared-device] [--choreographer] [--hot-reload] [--record-camera <file> | --play-camera <file>] [--capture-draw-list <file> [--capture-frame <frame>]] [--incremental-present] [--concurrent-subpasses] [--gpu <arg>] [--device-group <mode>]
+		vulkan_best_practice --load-benchmark <arg> [--loads <arg>] [--headless] [--trace]
+		vulkan_best_practice --replay-draw-list <arg> [--replays <arg>] [--headless] [--trace]
 		vulkan_best_practice --help
 
 	Options:
@@ -125,6 +130,40 @@ VulkanBestPractice::VulkanBestPractice()
 		--width WIDTH             The width of the screen if visible [default: 1280].
 		--height HEIGHT           The height of the screen if visible [default: 720].
 		--headless                Renders directly to display, skipping window creation.
+		--trace                   Write a Chrome trace of the CPU scopes to the temporary directory on exit.
+		--sweep                   Benchmark every configuration of the samples for the --benchmark frames each,
+		                          writing their reports to sweep_report.json in the temporary directory.
+		--soak MINUTES            Cycle through the configurations of the samples, or through the runs of a test, for
+		                          the --benchmark frames each until the minutes have passed. The resident memory, GPU
+		                          memory, cache sizes and frame times of every run are compared to the first run of
+		                          the same configuration and written to soak_report.json in the temporary directory,
+		                          which fails the soak if any grew beyond its threshold.
+		--shared-device           Keep the instance, device and resource cache of a sample for the next ones in batch mode,
+		                          only recreating them for samples needing other extensions.
+		--choreographer           Drive the frames from the vsync callbacks of the Android Choreographer, and start the CPU
+		                          work of each frame as late as its deadline allows. Ignored on other platforms.
+		--hot-reload              Recompile the shaders edited in the shaders directory while the sample runs,
+		                          rebuilding only the pipelines using them. Ignored on Android.
+		--record-camera FILE      Record the path of the free camera to a file in the temporary directory on exit.
+		--play-camera FILE        Play back a camera path recorded with --record-camera, looping it. With --benchmark,
+		                          every run renders the same frames.
+		--capture-draw-list FILE  Capture the render passes, binds, state sets and draws of a frame of the sample
+		                          to a draw list file in the temporary directory.
+		--capture-frame FRAME     The number of frames rendered before the captured one [default: 10].
+		--incremental-present     Only render and present the regions of the frames changed by moving meshes and the gui,
+		                          skipping the frames in which nothing changed.
+		--concurrent-subpasses    Record the subpasses of a render pass concurrently into secondary command buffers.
+		--gpu GPU                 Create the device on a GPU given by its index in the logged list of GPUs, or a part of
+		                          its name, rather than on the suitable GPU with the highest score.
+		--device-group MODE       Create the device over the GPUs linked to the selected one, which render alternate
+		                          frames with afr, or a band of each frame with sfr.
+		--load-benchmark SCENE    Load a glTF scene of the assets repeatedly, writing the time of each loading stage
+		                          to load_benchmark_report.json in the temporary directory.
+		--loads LOADS             The number of loads of the --load-benchmark scene [default: 5].
+		--replay-draw-list FILE   Replay a draw list captured with --capture-draw-list once per frame, with stand-ins of
+		                          its buffers and images, writing the CPU time of recording each replay to
+		                          draw_list_benchmark_report.json in the temporary directory.
+		--replays REPLAYS         The number of replays of the --replay-draw-list draw list [default: 100].
 	)");
 }
 
@@ -141,6 +180,82 @@ bool VulkanBestPractice::prepare(Platform &platform)
 
 	auto result = false;
 
+	if (options.contains("--sweep"))
+	{
+		if (!options.contains("--benchmark"))
+		{
+			LOGE("--sweep requires the number of frames per configuration given by --benchmark");
+			return false;
+		}
+
+		sweep_mode                     = true;
+		sweep_frames_per_configuration = options.get_int("--benchmark");
+	}
+
+	if (options.contains("--soak"))
+	{
+		if (!options.contains("--benchmark"))
+		{
+			LOGE("--soak requires the number of frames per configuration given by --benchmark");
+			return false;
+		}
+
+		// A soak is a sweep repeated until its duration has passed
+		sweep_mode                     = true;
+		sweep_frames_per_configuration = options.get_int("--benchmark");
+		soak_duration                  = options.get_int("--soak") * 60.0f;
+		soak_monitor                   = std::make_unique<vkb::SoakMonitor>();
+	}
+
+	shared_device = options.contains("--shared-device");
+
+	shader_hot_reload = options.contains("--hot-reload");
+
+	incremental_present = options.contains("--incremental-present");
+
+	concurrent_subpasses = options.contains("--concurrent-subpasses");
+
+	if (options.contains("--gpu"))
+	{
+		preferred_gpu = options.get_string("--gpu");
+	}
+
+	if (options.contains("--device-group"))
+	{
+		auto mode = options.get_string("--device-group");
+
+		if (mode == "afr")
+		{
+			device_group_mode = vkb::DeviceGroupMode::AlternateFrame;
+		}
+		else if (mode == "sfr")
+		{
+			device_group_mode = vkb::DeviceGroupMode::SplitFrame;
+		}
+		else
+		{
+			LOGE("--device-group must be afr or sfr");
+			return false;
+		}
+	}
+
+	if (options.contains("--record-camera"))
+	{
+		camera_path_mode = vkb::sg::CameraPath::Mode::Record;
+		camera_path_file = options.get_string("--record-camera");
+	}
+	else if (options.contains("--play-camera"))
+	{
+		camera_path_mode = vkb::sg::CameraPath::Mode::Playback;
+		camera_path_file = options.get_string("--play-camera");
+	}
+
+	if (options.contains("--capture-draw-list"))
+	{
+		draw_list_capture_file  = options.get_string("--capture-draw-list");
+		draw_list_capture_frame = static_cast<uint32_t>(options.get_int("--capture-frame"));
+	}
+
 	if (options.contains("--batch"))
 	{
 		auto &category_arg = options.get_string("--batch");
@@ -189,6 +304,28 @@ bool VulkanBestPractice::prepare(Platform &platform)
 		    false,
 		    false);
 	}
+	else if (options.contains("--load-benchmark"))
+	{
+		auto scene_path = options.get_string("--load-benchmark");
+		auto load_count = static_cast<uint32_t>(options.get_int("--loads"));
+
+		result = prepare_active_app(
+		    [scene_path, load_count]() { return std::make_unique<LoadBenchmark>(scene_path, load_count); },
+		    "Load benchmark",
+		    true,
+		    false);
+	}
+	else if (options.contains("--replay-draw-list"))
+	{
+		auto draw_list_path = options.get_string("--replay-draw-list");
+		auto replay_count   = static_cast<uint32_t>(options.get_int("--replays"));
+
+		result = prepare_active_app(
+		    [draw_list_path, replay_count]() { return std::make_unique<DrawListBenchmark>(draw_list_path, replay_count); },
+		    "Draw list benchmark",
+		    true,
+		    false);
+	}
 	else if (options.contains("--test"))
 	{
 		const auto &test_arg = options.get_string("--test");
@@ -227,6 +364,9 @@ bool VulkanBestPractice::prepare_active_app(CreateAppFunc create_app_func, const
 	active_app = create_app_func();
 	active_app->set_name(name);
 
+	active_app_create_func = create_app_func;
+	active_app_test        = test;
+
 	skipped_first_frame = false;
 
 	if (!active_app)
@@ -241,6 +381,31 @@ bool VulkanBestPractice::prepare_active_app(CreateAppFunc create_app_func, const
 		if (auto *active_app = dynamic_cast<vkb::VulkanSample *>(app))
 		{
 			active_app->get_configuration().reset();
+
+			if (batch && shared_device)
+			{
+				active_app->set_shared_device_context(device_context);
+			}
+
+			active_app->set_shader_hot_reload(shader_hot_reload);
+
+			active_app->set_incremental_rendering(incremental_present);
+
+			active_app->set_concurrent_subpass_recording(concurrent_subpasses);
+
+			active_app->set_preferred_gpu(preferred_gpu);
+
+			active_app->set_device_group_mode(device_group_mode);
+
+			if (!camera_path_file.empty())
+			{
+				active_app->set_camera_path(camera_path_mode, camera_path_file);
+			}
+
+			if (!draw_list_capture_file.empty())
+			{
+				active_app->set_draw_list_capture(draw_list_capture_file, draw_list_capture_frame);
+			}
 		}
 	}
 
@@ -248,7 +413,8 @@ bool VulkanBestPractice::prepare_active_app(CreateAppFunc create_app_func, const
 	{
 		this->batch_mode = true;
 	}
-	else if (is_benchmark_mode())
+
+	if (is_benchmark_mode() && (!batch || sweep_mode))
 	{
 		active_app->set_benchmark_mode(true);
 	}
@@ -263,9 +429,150 @@ bool VulkanBestPractice::prepare_active_app(CreateAppFunc create_app_func, const
 		return result;
 	}
 
+	// Sweeps measure every configuration, starting from the first one
+	if (sweep_mode && !test)
+	{
+		if (auto *vulkan_app = dynamic_cast<vkb::VulkanSample *>(active_app.get()))
+		{
+			if (!vulkan_app->get_configuration().empty())
+			{
+				vulkan_app->get_configuration().set();
+			}
+		}
+	}
+
+	sweep_frame_count = 0;
+
 	return result;
 }
 
+void VulkanBestPractice::advance_sweep()
+{
+	nlohmann::json report;
+	active_app->add_benchmark_report(report);
+
+	if (soak_monitor)
+	{
+		std::string key = report["name"].get<std::string>();
+
+		if (report["configuration"].count("index"))
+		{
+			key += " configuration " + std::to_string(report["configuration"]["index"].get<size_t>());
+		}
+
+		soak_monitor->add_run(key, report);
+
+		if (soak_monitor->get_elapsed_time() >= soak_duration)
+		{
+			finish_soak();
+			return;
+		}
+	}
+	else
+	{
+		sweep_reports.push_back(report);
+	}
+
+	active_app->reset_benchmark_frame_times();
+
+	if (auto *vulkan_app = dynamic_cast<vkb::VulkanSample *>(active_app.get()))
+	{
+		auto &configuration = vulkan_app->get_configuration();
+
+		if (configuration.next())
+		{
+			configuration.set();
+			return;
+		}
+	}
+
+	if (batch_mode)
+	{
+		++batch_mode_sample_iter;
+
+		// A soak starts over from the first sample
+		if (batch_mode_sample_iter == batch_mode_sample_list.end() && soak_monitor)
+		{
+			batch_mode_sample_iter = batch_mode_sample_list.begin();
+		}
+
+		if (batch_mode_sample_iter != batch_mode_sample_list.end())
+		{
+			auto result = prepare_active_app(
+			    sample_create_functions.at(batch_mode_sample_iter->id),
+			    batch_mode_sample_iter->name,
+			    false,
+			    true);
+
+			if (result)
+			{
+				return;
+			}
+
+			LOGE("Failed to prepare vulkan sample.");
+		}
+	}
+	else if (soak_monitor)
+	{
+		// The app is created again, so that the soak cycles through the loading and unloading of its scene
+		auto name = active_app->get_name();
+
+		if (prepare_active_app(active_app_create_func, name, active_app_test, false))
+		{
+			return;
+		}
+
+		LOGE("Failed to prepare vulkan app.");
+	}
+
+	if (soak_monitor)
+	{
+		finish_soak();
+		return;
+	}
+
+	nlohmann::json sweep_report;
+	sweep_report["frames_per_configuration"] = sweep_frames_per_configuration;
+	sweep_report["reports"]                  = sweep_reports;
+
+	std::string report_string = sweep_report.dump(4);
+	fs::write_temp({report_string.begin(), report_string.end()}, "sweep_report.json");
+
+	LOGI("Sweep completed, {} configurations written to sweep_report.json", sweep_reports.size());
+
+	platform->close();
+}
+
+void VulkanBestPractice::finish_soak()
+{
+	std::string report_string = soak_monitor->to_json().dump(4);
+	fs::write_temp({report_string.begin(), report_string.end()}, "soak_report.json");
+
+	if (soak_monitor->has_drifted())
+	{
+		LOGE("Soak failed after {:.0f} s, the drifted metrics are listed in soak_report.json", soak_monitor->get_elapsed_time());
+	}
+	else
+	{
+		LOGI("Soak passed after {:.0f} s, written to soak_report.json", soak_monitor->get_elapsed_time());
+	}
+
+	platform->close();
+}
+
+void VulkanBestPractice::add_benchmark_report(nlohmann::json &report)
+{
+	// The report describes the sample rather than the launcher running it
+	if (active_app)
+	{
+		active_app->add_benchmark_report(report);
+	}
+	else
+	{
+		Application::add_benchmark_report(report);
+	}
+}
+
 void VulkanBestPractice::update(float delta_time)
 {
 	if (active_app)
@@ -273,6 +580,17 @@ void VulkanBestPractice::update(float delta_time)
 		active_app->step();
 	}
 
+	if (sweep_mode)
+	{
+		if (++sweep_frame_count >= sweep_frames_per_configuration)
+		{
+			sweep_frame_count = 0;
+			advance_sweep();
+		}
+
+		return;
+	}
+
 	elapsed_time += skipped_first_frame ? delta_time : 0.0f;
 	skipped_first_frame = true;
 
@@ -334,6 +652,14 @@ void VulkanBestPractice::resize(const uint32_t width, const uint32_t height)
 	}
 }
 
+void VulkanBestPractice::set_frame_deadline(std::chrono::steady_clock::time_point deadline)
+{
+	if (active_app)
+	{
+		active_app->set_frame_deadline(deadline);
+	}
+}
+
 void VulkanBestPractice::input_event(const InputEvent &input_event)
 {
 	if (active_app && !batch_mode && !is_benchmark_mode())
@@ -24,6 +24,7 @@
 
 #include "platform/application.h"
 #include "samples.h"
+#include "soak_monitor.h"
 #include "tests.h"
 #include "vulkan_sample.h"
 
@@ -48,6 +49,10 @@ class VulkanBestPractice : public Application
 
 	virtual void input_event(const InputEvent &input_event) override;
 
+	virtual void set_frame_deadline(std::chrono::steady_clock::time_point deadline) override;
+
+	virtual void add_benchmark_report(nlohmann::json &report) override;
+
 	/** 
 	 * @brief Prepares a sample or a test to be run under certain conditions
 	 * @param run_info A struct containing the information needed to run
@@ -59,6 +64,33 @@ class VulkanBestPractice : public Application
 	/// Platform pointer
 	Platform *platform;
 
+	/// Instance and device kept across the samples with --shared-device, declared first to outlive the active app
+	std::unique_ptr<DeviceContext> device_context;
+
+	bool shared_device{false};
+
+	bool shader_hot_reload{false};
+
+	bool incremental_present{false};
+
+	bool concurrent_subpasses{false};
+
+	/// GPU the samples create their device on, empty for the GPU with the highest score
+	std::string preferred_gpu;
+
+	/// How the linked GPUs of the selected one share the frames, None to create the device on the GPU alone
+	vkb::DeviceGroupMode device_group_mode{vkb::DeviceGroupMode::None};
+
+	vkb::sg::CameraPath::Mode camera_path_mode{vkb::sg::CameraPath::Mode::Playback};
+
+	/// Camera path recorded or played back by the samples, empty if none
+	std::string camera_path_file;
+
+	/// Draw list captured from the samples, empty if none
+	std::string draw_list_capture_file;
+
+	uint32_t draw_list_capture_frame{0};
+
 	/// The actual sample that the vulkan best practices controls
 	std::unique_ptr<Application> active_app{nullptr};
 
@@ -79,6 +111,39 @@ class VulkanBestPractice : public Application
 
 	/// Used to calculate when the sample has exceeded the sample_run_time_per_configuration
 	float elapsed_time{0.0f};
+
+	/// If every configuration of the samples is benchmarked
+	bool sweep_mode{false};
+
+	uint32_t sweep_frames_per_configuration{0};
+
+	/// Frames run with the current configuration
+	uint32_t sweep_frame_count{0};
+
+	/// Benchmark reports of the configurations already run
+	std::vector<nlohmann::json> sweep_reports;
+
+	/// Set during a soak, which compares the reports of the runs rather than collecting them
+	std::unique_ptr<SoakMonitor> soak_monitor;
+
+	/// Duration of the soak, in seconds
+	float soak_duration{0.0f};
+
+	/// Arguments of the last prepare_active_app(), to create the app again when a soak starts over
+	CreateAppFunc active_app_create_func;
+
+	bool active_app_test{false};
+
+	/**
+	 * @brief Reports the current configuration of the sweep, then moves to the next one,
+	 *        to the next sample in batch mode, or writes the sweep report and closes the platform
+	 */
+	void advance_sweep();
+
+	/**
+	 * @brief Writes the soak report and closes the platform
+	 */
+	void finish_soak();
 };
 
 }        // namespace vkb